@@ -3,31 +3,13 @@
 #include <stdarg.h>
 #include <stdint.h> // for intptr_t
 #include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>  // for sysconf
 #include <gmp.h>
 #include "pbc_utils.h"
 #include "pbc_field.h"
+#include "pbc_random.h"
 #include "pbc_memory.h"
-#include "misc/darray.h"
-
-struct snapshot_s {
-  element_t a;
-  element_t b;
-  element_t snark;
-};
-typedef struct snapshot_s *snapshot_ptr;
-
-static void record(element_t asum, element_t bsum, element_t snark,
-                   darray_t hole, mpz_t counter) {
-  snapshot_ptr ss = pbc_malloc(sizeof(struct snapshot_s));
-  element_init_same_as(ss->a, asum);
-  element_init_same_as(ss->b, bsum);
-  element_init_same_as(ss->snark, snark);
-  element_set(ss->a, asum);
-  element_set(ss->b, bsum);
-  element_set(ss->snark, snark);
-  darray_append(hole, ss);
-  element_printf("snark %Zd: %B\n", counter, snark);
-}
 
 // g, h in some group of order r
 // finds x such that g^x = h
@@ -52,136 +34,316 @@ void element_dlog_brute_force(element_t x, element_t g, element_t h) {
   element_clear(g0);
 }
 
-// x in Z_r, g, h in some group of order r
-// finds x such that g^x = h
-void element_dlog_pollard_rho(element_t x, element_t g, element_t h) {
-// see Blake, Seroussi and Smart
-// only one snark for this implementation
-  int i, s = 20;
-  field_ptr Zr = x->field, G = g->field;
-  element_t asum;
-  element_t bsum;
-  element_t a[s];
-  element_t b[s];
-  element_t m[s];
-  element_t g0, snark;
-  darray_t hole;
-  int interval = 5;
-  mpz_t counter;
+// Pollard rho with distinguished points, after van Oorschot and Wiener.
+// Every thread walks point -> point * m[i] through the same multipliers
+// m[i] = g^a[i] h^b[i], keeping point = g^asum h^bsum. Points whose hash has
+// its low bits clear are distinguished and go in a table shared by all
+// walks: two walks that meet stay together up to the next distinguished
+// point, where the later one finds the earlier in the table. Slots are
+// claimed by compare-and-swap, so walks only wait on each other to solve.
+
+#define RHO_MULTIPLIERS 20
+#define RHO_TABLE_BITS 16
+#define RHO_TABLE_SIZE (1 << RHO_TABLE_BITS)
+// Distinguished points are stored until the table is this full, after
+// which walks only look points up.
+#define RHO_TABLE_MAX (RHO_TABLE_SIZE / 4 * 3)
+
+struct rho_point_s {
+  uint64_t hash;
+  element_t a, b, point;
+};
+typedef struct rho_point_s *rho_point_ptr;
+
+struct rho_s {
+  element_ptr x, g, h;
+  element_t a[RHO_MULTIPLIERS];
+  element_t b[RHO_MULTIPLIERS];
+  element_t m[RHO_MULTIPLIERS];
+  uint64_t dmask;          // distinguished if hash & dmask == 0
+  unsigned long walk_max;  // steps after which a walk starts over
+  rho_point_ptr *table;
+  int stored;
+  int done;
+  pthread_mutex_t lock;
+};
+
+struct rho_worker_s {
+  struct rho_s *rho;
+  unsigned int seed;
+};
+
+static int dlog_threads;
+
+void element_dlog_set_threads(int n) {
+  dlog_threads = n;
+}
+
+static int dlog_thread_count(void) {
+  if (dlog_threads > 0) return dlog_threads;
+#ifdef _SC_NPROCESSORS_ONLN
+  {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return n;
+  }
+#endif
+  return 1;
+}
+
+// FNV-1a over the bytes of e, then a final mix so the low bits
+// depend on all of them.
+static uint64_t rho_hash(element_t e, unsigned char **buf, int *buflen) {
+  int i, len = element_length_in_bytes(e);
+  uint64_t hash = 14695981039346656037ULL;
+
+  if (len > *buflen) {
+    *buf = pbc_realloc(*buf, len);
+    *buflen = len;
+  }
+  element_to_bytes(*buf, e);
+  for (i = 0; i < len; i++) {
+    hash ^= (*buf)[i];
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Given g^a0 h^b0 = g^a1 h^b1, sets x such that g^x = h.
+// Returns 0 if the pair does not determine x.
+static int rho_solve(struct rho_s *rho, element_t a0, element_t b0,
+    element_t a1, element_t b1) {
+  field_ptr Zr = rho->x->field;
+  element_t asum, bsum;
   int found = 0;
 
-  mpz_init(counter);
-  element_init(g0, G);
-  element_init(snark, G);
   element_init(asum, Zr);
   element_init(bsum, Zr);
-  darray_init(hole);
-  //set up multipliers
-  for (i = 0; i < s; i++) {
-    element_init(a[i], Zr);
-    element_init(b[i], Zr);
-    element_init(m[i], G);
-    element_random(a[i]);
-    element_random(b[i]);
-    element_pow_zn(g0, g, a[i]);
-    element_pow_zn(m[i], h, b[i]);
-    element_mul(m[i], m[i], g0);
+  element_sub(bsum, b1, b0);
+  element_sub(asum, a0, a1);
+  //answer is x such that x * bsum = asum
+  //complications arise if gcd(bsum, r) > 1
+  //which can happen if r is not prime
+  if (element_is0(bsum)) {
+    // Both walks started from the same multiple of h.
+  } else if (!mpz_probab_prime_p(Zr->order, 10)) {
+    mpz_t za, zb, zd, zm;
+    element_t g0;
+
+    element_init_same_as(g0, rho->g);
+    mpz_init(za);
+    mpz_init(zb);
+    mpz_init(zd);
+    mpz_init(zm);
+
+    element_to_mpz(za, asum);
+    element_to_mpz(zb, bsum);
+    mpz_gcd(zd, zb, Zr->order);
+    mpz_divexact(zm, Zr->order, zd);
+    mpz_divexact(zb, zb, zd);
+    //if zd does not divide za there is no solution
+    mpz_divexact(za, za, zd);
+    mpz_invert(zb, zb, zm);
+    mpz_mul(zb, za, zb);
+    mpz_mod(zb, zb, zm);
+    do {
+      element_pow_mpz(g0, rho->g, zb);
+      if (!element_cmp(g0, rho->h)) {
+        element_set_mpz(rho->x, zb);
+        found = 1;
+        break;
+      }
+      mpz_add(zb, zb, zm);
+      mpz_sub_ui(zd, zd, 1);
+    } while (mpz_sgn(zd));
+    mpz_clear(zm);
+    mpz_clear(za);
+    mpz_clear(zb);
+    mpz_clear(zd);
+    element_clear(g0);
+  } else {
+    element_div(rho->x, asum, bsum);
+    found = 1;
   }
+  element_clear(asum);
+  element_clear(bsum);
+  return found;
+}
 
-  element_random(asum);
-  element_random(bsum);
-  element_pow_zn(g0, g, asum);
-  element_pow_zn(snark, h, bsum);
-  element_mul(snark, snark, g0);
+// Stores the distinguished point g^asum h^bsum, or solves for x if another
+// walk got there first. Returns 0 to carry on walking, 1 once x is found
+// and -1 if this walk merged with another without telling us x.
+static int rho_insert(struct rho_s *rho, uint64_t hash,
+    element_t asum, element_t bsum, element_t point) {
+  unsigned int i = (hash >> 24) & (RHO_TABLE_SIZE - 1);
+  int frozen = __atomic_load_n(&rho->stored, __ATOMIC_RELAXED) >= RHO_TABLE_MAX;
+  rho_point_ptr fresh = NULL;
 
-  record(asum, bsum, snark, hole, counter);
   for (;;) {
-    int len = element_length_in_bytes(snark);
-    unsigned char *buf = pbc_malloc(len);
-    unsigned char hash = 0;
-
-    element_to_bytes(buf, snark);
-    for (i = 0; i < len; i++) {
-      hash += buf[i];
+    rho_point_ptr p = __atomic_load_n(&rho->table[i], __ATOMIC_ACQUIRE);
+    if (!p) {
+      if (frozen) return 0;
+      if (!fresh) {
+        fresh = pbc_malloc(sizeof(struct rho_point_s));
+        fresh->hash = hash;
+        element_init_same_as(fresh->a, asum);
+        element_init_same_as(fresh->b, bsum);
+        element_init_same_as(fresh->point, point);
+        element_set(fresh->a, asum);
+        element_set(fresh->b, bsum);
+        element_set(fresh->point, point);
+      }
+      if (__atomic_compare_exchange_n(&rho->table[i], &p, fresh, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&rho->stored, 1, __ATOMIC_RELAXED);
+        return 0;
+      }
+      // Lost the slot: p is the point that won it.
     }
-    i = hash % s;
-    pbc_free(buf);
-
-    element_mul(snark, snark, m[i]);
-    element_add(asum, asum, a[i]);
-    element_add(bsum, bsum, b[i]);
-
-    for (i = 0; i < hole->count; i++) {
-      snapshot_ptr ss = hole->item[i];
-      if (!element_cmp(snark, ss->snark)) {
-        element_sub(bsum, bsum, ss->b);
-        element_sub(asum, ss->a, asum);
-        //answer is x such that x * bsum = asum
-        //complications arise if gcd(bsum, r) > 1
-        //which can happen if r is not prime
-        if (!mpz_probab_prime_p(Zr->order, 10)) {
-          mpz_t za, zb, zd, zm;
-
-          mpz_init(za);
-          mpz_init(zb);
-          mpz_init(zd);
-          mpz_init(zm);
-
-          element_to_mpz(za, asum);
-          element_to_mpz(zb, bsum);
-          mpz_gcd(zd, zb, Zr->order);
-          mpz_divexact(zm, Zr->order, zd);
-          mpz_divexact(zb, zb, zd);
-          //if zd does not divide za there is no solution
-          mpz_divexact(za, za, zd);
-          mpz_invert(zb, zb, zm);
-          mpz_mul(zb, za, zb);
-          mpz_mod(zb, zb, zm);
-          do {
-            element_pow_mpz(g0, g, zb);
-            if (!element_cmp(g0, h)) {
-              element_set_mpz(x, zb);
-              break;
-            }
-            mpz_add(zb, zb, zm);
-            mpz_sub_ui(zd, zd, 1);
-          } while (mpz_sgn(zd));
-          mpz_clear(zm);
-          mpz_clear(za);
-          mpz_clear(zb);
-          mpz_clear(zd);
-        } else {
-          element_div(x, asum, bsum);
-        }
-        found = 1;
-        break;
+    if (p->hash == hash && !element_cmp(p->point, point)) {
+      int solved;
+      if (fresh) {
+        element_clear(fresh->a);
+        element_clear(fresh->b);
+        element_clear(fresh->point);
+        pbc_free(fresh);
       }
+      pthread_mutex_lock(&rho->lock);
+      solved = rho->done || rho_solve(rho, p->a, p->b, asum, bsum);
+      if (solved) __atomic_store_n(&rho->done, 1, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&rho->lock);
+      return solved ? 1 : -1;
     }
-    if (found) break;
+    i = (i + 1) & (RHO_TABLE_SIZE - 1);
+  }
+}
 
-    mpz_add_ui(counter, counter, 1);
-    if (mpz_tstbit(counter, interval)) {
-      record(asum, bsum, snark, hole, counter);
-      interval++;
+static void *rho_worker(void *data) {
+  struct rho_worker_s *w = data;
+  struct rho_s *rho = w->rho;
+  field_ptr Zr = rho->x->field;
+  pbc_random_ctx_t ctx;
+  pbc_random_ctx_ptr old;
+  element_t asum, bsum, point;
+  unsigned char *buf = NULL;
+  int buflen = 0;
+  unsigned long steps = 0;
+
+  // Each walk starts from points of its own generator.
+  pbc_random_ctx_init_deterministic(ctx, w->seed);
+  old = pbc_random_ctx_bind(ctx);
+  element_init(asum, Zr);
+  element_init(bsum, Zr);
+  element_init_same_as(point, rho->g);
+
+  while (!__atomic_load_n(&rho->done, __ATOMIC_ACQUIRE)) {
+    uint64_t hash;
+    int i;
+
+    if (!steps) {
+      element_random(asum);
+      element_random(bsum);
+      element_pow2_zn(point, rho->g, asum, rho->h, bsum);
+    }
+    hash = rho_hash(point, &buf, &buflen);
+    if (!(hash & rho->dmask)) {
+      int res = rho_insert(rho, hash, asum, bsum, point);
+      if (res > 0) break;
+      if (res < 0) {
+        steps = 0;
+        continue;
+      }
     }
+    i = (hash >> 48) % RHO_MULTIPLIERS;
+    element_mul(point, point, rho->m[i]);
+    element_add(asum, asum, rho->a[i]);
+    element_add(bsum, bsum, rho->b[i]);
+    // A walk caught in a cycle without distinguished points starts over.
+    if (++steps >= rho->walk_max) steps = 0;
   }
 
-  for (i = 0; i < s; i++) {
-    element_clear(a[i]);
-    element_clear(b[i]);
-    element_clear(m[i]);
-  }
-  element_clear(g0);
-  element_clear(snark);
-  for (i = 0; i < hole->count; i++) {
-    snapshot_ptr ss = hole->item[i];
-    element_clear(ss->a);
-    element_clear(ss->b);
-    element_clear(ss->snark);
-    pbc_free(ss);
-  }
-  darray_clear(hole);
+  pbc_free(buf);
   element_clear(asum);
   element_clear(bsum);
-  mpz_clear(counter);
+  element_clear(point);
+  pbc_random_ctx_bind(old);
+  pbc_random_ctx_clear(ctx);
+  return NULL;
+}
+
+// x in Z_r, g, h in some group of order r
+// finds x such that g^x = h
+// will hang if no such x exists
+void element_dlog_pollard_rho(element_t x, element_t g, element_t h) {
+// see Blake, Seroussi and Smart
+  struct rho_s rho;
+  struct rho_worker_s *w;
+  pthread_t *tid;
+  field_ptr Zr = x->field;
+  int i, dbits, started, threads = dlog_thread_count();
+  mpz_t seed_limit, seed;
+
+  // About 2^10 distinguished points are expected among the sqrt(r) steps.
+  dbits = (int) mpz_sizeinbase(Zr->order, 2) / 2 - 10;
+  if (dbits < 0) dbits = 0;
+  if (dbits > 24) dbits = 24;
+  rho.dmask = ((uint64_t) 1 << dbits) - 1;
+  rho.walk_max = 20UL << dbits;
+  rho.x = x;
+  rho.g = g;
+  rho.h = h;
+  rho.stored = 0;
+  rho.done = 0;
+  pthread_mutex_init(&rho.lock, NULL);
+  rho.table = pbc_malloc(sizeof(rho_point_ptr) * RHO_TABLE_SIZE);
+  for (i = 0; i < RHO_TABLE_SIZE; i++) rho.table[i] = NULL;
+
+  //set up multipliers
+  for (i = 0; i < RHO_MULTIPLIERS; i++) {
+    element_init(rho.a[i], Zr);
+    element_init(rho.b[i], Zr);
+    element_init_same_as(rho.m[i], g);
+    element_random(rho.a[i]);
+    element_random(rho.b[i]);
+    element_pow2_zn(rho.m[i], g, rho.a[i], h, rho.b[i]);
+  }
+
+  mpz_init(seed);
+  mpz_init(seed_limit);
+  mpz_setbit(seed_limit, 32);
+  w = pbc_malloc(sizeof(struct rho_worker_s) * threads);
+  for (i = 0; i < threads; i++) {
+    pbc_mpz_random(seed, seed_limit);
+    w[i].rho = &rho;
+    w[i].seed = mpz_get_ui(seed);
+  }
+  tid = pbc_malloc(sizeof(pthread_t) * threads);
+  // Walks beyond the first that fail to start are simply not needed.
+  for (started = 0; started < threads - 1; started++) {
+    if (pthread_create(&tid[started], NULL, rho_worker, &w[started + 1])) break;
+  }
+  rho_worker(&w[0]);
+  for (i = 0; i < started; i++) pthread_join(tid[i], NULL);
+  pbc_free(tid);
+  pbc_free(w);
+  mpz_clear(seed);
+  mpz_clear(seed_limit);
+
+  for (i = 0; i < RHO_TABLE_SIZE; i++) {
+    rho_point_ptr p = rho.table[i];
+    if (!p) continue;
+    element_clear(p->a);
+    element_clear(p->b);
+    element_clear(p->point);
+    pbc_free(p);
+  }
+  pbc_free(rho.table);
+  for (i = 0; i < RHO_MULTIPLIERS; i++) {
+    element_clear(rho.a[i]);
+    element_clear(rho.b[i]);
+    element_clear(rho.m[i]);
+  }
+  pthread_mutex_destroy(&rho.lock);
 }
@@ -45,6 +45,13 @@ static void fp_init(element_ptr e) {
   dp->d = pbc_malloc(p->bytes);
 }
 
+// The limbs follow the per-element data.
+static void fp_init_packed(element_ptr e, void *mem) {
+  dataptr dp = e->data = mem;
+  dp->flag = 0;
+  dp->d = (mp_limb_t *) (dp + 1);
+}
+
 static void fp_clear(element_ptr e) {
   dataptr dp = e->data;
   pbc_free(dp->d);
@@ -504,6 +511,7 @@ void field_init_faster_fp(field_ptr f, mpz_t prime) {
   field_init(f);
   f->init = fp_init;
   f->clear = fp_clear;
+  f->init_packed = fp_init_packed;
   f->set_si = fp_set_si;
   f->set_mpz = fp_set_mpz;
   f->out_str = fp_out_str;
@@ -540,6 +548,7 @@ void field_init_faster_fp(field_ptr f, mpz_t prime) {
   p->bytes = p->limbs * sizeof(mp_limb_t);
   p->primelimbs = pbc_malloc(p->bytes);
   mpz_export(p->primelimbs, &p->limbs, -1, sizeof(mp_limb_t), 0, 0, prime);
+  f->packed_size = sizeof(struct data_s) + p->bytes;
 
   mpz_set(f->order, prime);
   f->fixed_length_in_bytes = (mpz_sizeinbase(prime, 2) + 7) / 8;
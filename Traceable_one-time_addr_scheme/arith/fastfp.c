@@ -37,6 +37,12 @@ static void fp_clear(element_ptr e) {
   pbc_free(e->data);
 }
 
+static void fp_init_packed(element_ptr e, void *mem) {
+  fp_field_data_ptr p = e->field->data;
+  e->data = mem;
+  memset(e->data, 0, p->bytes);
+}
+
 static inline void from_mpz(element_ptr e, mpz_ptr z) {
   fp_field_data_ptr p = e->field->data;
   size_t count;
@@ -342,6 +348,7 @@ void field_init_fast_fp(field_ptr f, mpz_t prime) {
   field_init(f);
   f->init = fp_init;
   f->clear = fp_clear;
+  f->init_packed = fp_init_packed;
   f->set_si = fp_set_si;
   f->set_mpz = fp_set_mpz;
   f->out_str = fp_out_str;
@@ -376,6 +383,7 @@ void field_init_fast_fp(field_ptr f, mpz_t prime) {
   p->bytes = p->limbs * sizeof(mp_limb_t);
   p->primelimbs = pbc_malloc(p->bytes);
   mpz_export(p->primelimbs, &p->limbs, -1, sizeof(mp_limb_t), 0, 0, prime);
+  f->packed_size = p->bytes;
 
   mpz_set(f->order, prime);
   f->fixed_length_in_bytes = (mpz_sizeinbase(prime, 2) + 7) / 8;
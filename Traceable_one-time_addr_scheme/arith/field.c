@@ -125,6 +125,62 @@ static void generic_pow_mpz(element_ptr x, element_ptr a, mpz_ptr n) {
   clear_pow_window(k, a_lookup);
 }
 
+static void generic_cmov(element_ptr x, element_ptr a, int bit) {
+  // Without access to the representation, a branch is all we can do.
+  if (bit) element_set(x, a);
+}
+
+static void generic_invert_ct(element_ptr x, element_ptr a) {
+  element_invert(x, a);
+}
+
+#define POW_CT_WINDOW 4
+
+// Fixed window for secret exponents: each window of the exponent, zero or
+// not, costs POW_CT_WINDOW squarings and one multiplication by a^d, where
+// a^d is found by a masked scan of the whole table.
+static void generic_pow_mpz_ct(element_ptr x, element_ptr a, mpz_ptr n) {
+  const int size = 1 << POW_CT_WINDOW;
+  element_t tab[1 << POW_CT_WINDOW], acc, t;
+  int bits, m, i, j, d;
+  mpz_t e;
+
+  mpz_init(e);
+  mpz_abs(e, n);
+  bits = mpz_sizeinbase(e, 2);
+  if (mpz_sgn(x->field->order) &&
+      (int) mpz_sizeinbase(x->field->order, 2) > bits) {
+    bits = mpz_sizeinbase(x->field->order, 2);
+  }
+  m = (bits + POW_CT_WINDOW - 1) / POW_CT_WINDOW;
+
+  for (i = 0; i < size; i++) element_init_same_as(tab[i], a);
+  element_init_same_as(acc, a);
+  element_init_same_as(t, a);
+  element_set1(tab[0]);
+  element_set(tab[1], a);
+  for (i = 2; i < size; i++) element_mul(tab[i], tab[i - 1], a);
+
+  element_set1(acc);
+  for (i = m - 1; i >= 0; i--) {
+    for (j = 0; j < POW_CT_WINDOW; j++) element_square(acc, acc);
+    d = 0;
+    for (j = 0; j < POW_CT_WINDOW; j++) {
+      d |= mpz_tstbit(e, i * POW_CT_WINDOW + j) << j;
+    }
+    element_set(t, tab[0]);
+    for (j = 1; j < size; j++) element_cmov(t, tab[j], pbc_ct_eq(j, d));
+    element_mul(acc, acc, t);
+  }
+  if (mpz_sgn(n) < 0) element_invert(acc, acc);
+  element_set(x, acc);
+
+  for (i = 0; i < size; i++) element_clear(tab[i]);
+  element_clear(acc);
+  element_clear(t);
+  mpz_clear(e);
+}
+
 /* TODO: Allow fields to choose this exponentiation routine so we can compare.
 static void naive_generic_pow_mpz(element_ptr x, element_ptr a, mpz_ptr n) {
   int s;
@@ -150,176 +206,475 @@ static void naive_generic_pow_mpz(element_ptr x, element_ptr a, mpz_ptr n) {
 }
 */
 
-void element_pow2_mpz(element_ptr x, element_ptr a1, mpz_ptr n1,
-                      element_ptr a2, mpz_ptr n2) {
-  int s, s1, s2;
-  int b1, b2;
+// Window of the interleaved sliding-window method for an exponent of
+// 'bits' bits: minimizes the 2^(k-1) odd powers of the table plus the
+// bits/(k+1) windows.
+static int multi_pow_window_size(int bits) {
+  return bits > 672 ? 6 : bits > 240 ? 5 : bits > 80 ? 4 : bits > 24 ? 3 : 2;
+}
 
-  element_t result, a1a2;
+// x = a[0]^n[0] ... a[m-1]^n[m-1] by interleaved sliding windows: one
+// chain of squarings for all bases, and for each base a table of its odd
+// powers a, a^3, ..., a^(2^k - 1). Every window of an exponent starts and
+// ends with a 1 bit and spans at most k bits, and costs one
+// multiplication, made at the position of its last bit. A negative
+// exponent runs against the inverse of its base. x may be one of the a[i].
+static void generic_multi_pow_mpz(element_ptr x, element_ptr a[],
+                                  mpz_ptr n[], int m) {
+  int bits = 0, k, size, i, s, l, started = 0;
+  unsigned char *digit;
+  element_t *tab, sq;
+  mpz_t e;
 
-  if (mpz_is0(n1) && mpz_is0(n2)) {
+  for (i = 0; i < m; i++) {
+    if (mpz_sgn(n[i]) && (s = mpz_sizeinbase(n[i], 2)) > bits) bits = s;
+  }
+  if (!bits) {
     element_set1(x);
     return;
   }
+  k = multi_pow_window_size(bits);
+  size = 1 << (k - 1);
+
+  // digit[i * bits + l] is the odd window of n[i] whose last bit is l.
+  digit = pbc_malloc(m * bits);
+  memset(digit, 0, m * bits);
+  tab = pbc_malloc(sizeof(element_t) * m * size);
+  element_init(sq, x->field);
+  mpz_init(e);
+  for (i = 0; i < m; i++) {
+    element_t *row = tab + i * size;
+    int j;
+    for (j = 0; j < size; j++) element_init(row[j], x->field);
+    if (!mpz_sgn(n[i])) continue;
+    if (mpz_sgn(n[i]) < 0) element_invert(row[0], a[i]);
+    else element_set(row[0], a[i]);
+    if (size > 1) {
+      element_square(sq, row[0]);
+      for (j = 1; j < size; j++) element_mul(row[j], row[j - 1], sq);
+    }
+    mpz_abs(e, n[i]);
+    for (s = mpz_sizeinbase(e, 2) - 1; s >= 0; s = l - 1) {
+      int v = 0;
+      if (!mpz_tstbit(e, s)) {
+        l = s;
+        continue;
+      }
+      l = s - k + 1 > 0 ? s - k + 1 : 0;
+      while (!mpz_tstbit(e, l)) l++;
+      for (j = s; j >= l; j--) v = v << 1 | mpz_tstbit(e, j);
+      digit[i * bits + l] = v;
+    }
+  }
 
-  element_init(result, x->field);
-  element_set1(result);
-
-  element_init(a1a2, x->field);
-  element_mul(a1a2, a1, a2);
-
-  s1 = mpz_sizeinbase(n1, 2) - 1;
-  s2 = mpz_sizeinbase(n2, 2) - 1;
-  for (s = (s1 > s2) ? s1 : s2; s >= 0; s--) {
-    element_mul(result, result, result);
-    b1 = mpz_tstbit(n1, s);
-    b2 = mpz_tstbit(n2, s);
-    if (b1 && b2) {
-      element_mul(result, result, a1a2);
-    } else if (b1) {
-      element_mul(result, result, a1);
-    } else if (b2) {
-      element_mul(result, result, a2);
+  // sq holds the result.
+  for (s = bits - 1; s >= 0; s--) {
+    if (started) element_square(sq, sq);
+    for (i = 0; i < m; i++) {
+      int v = digit[i * bits + s];
+      if (!v) continue;
+      if (started) element_mul(sq, sq, tab[i * size + (v >> 1)]);
+      else element_set(sq, tab[i * size + (v >> 1)]);
+      started = 1;
     }
   }
+  element_set(x, sq);
 
-  element_set(x, result);
-  element_clear(result);
-  element_clear(a1a2);
+  for (i = 0; i < m * size; i++) element_clear(tab[i]);
+  element_clear(sq);
+  mpz_clear(e);
+  pbc_free(tab);
+  pbc_free(digit);
+}
+
+void element_pow2_mpz(element_ptr x, element_ptr a1, mpz_ptr n1,
+                      element_ptr a2, mpz_ptr n2) {
+  element_ptr a[2] = { a1, a2 };
+  mpz_ptr n[2] = { n1, n2 };
+  x->field->multi_pow_mpz(x, a, n, 2);
 }
 
 void element_pow3_mpz(element_ptr x, element_ptr a1, mpz_ptr n1,
                       element_ptr a2, mpz_ptr n2,
                       element_ptr a3, mpz_ptr n3) {
-  int s, s1, s2, s3;
-  int b;
-  int i;
+  element_ptr a[3] = { a1, a2, a3 };
+  mpz_ptr n[3] = { n1, n2, n3 };
+  x->field->multi_pow_mpz(x, a, n, 3);
+}
+
+// From this many bases on, element_multi_pow_mpz() switches from Straus'
+// method to Pippenger's. Where multi_mul is a batched addition of curve
+// points, Pippenger's is faster from two bases on.
+#define MULTI_POW_PIPPENGER_MIN 64
+
+// Bits pos .. pos + c - 1 of n, for c < GMP_NUMB_BITS.
+static inline int exp_window(mpz_ptr n, int pos, int c) {
+  size_t limb = pos / GMP_NUMB_BITS;
+  int off = pos % GMP_NUMB_BITS;
+  mp_limb_t v = mpz_getlimbn(n, limb) >> off;
+  if (off + c > GMP_NUMB_BITS) {
+    v |= mpz_getlimbn(n, limb + 1) << (GMP_NUMB_BITS - off);
+  }
+  return (int) (v & (((mp_limb_t) 1 << c) - 1));
+}
 
+// Straus: one shared chain of squarings, with a table of a_i^1 ..
+// a_i^(2^k - 1) for each base. Each table row is built for all bases with
+// one multi_mul call.
+static void multi_pow_straus(element_ptr x, element_t a[], mpz_t n[], int m,
+                             int bits) {
+  field_ptr f = x->field;
+  int k = bits > 157 ? 4 : bits > 47 ? 3 : 2;
+  int size = 1 << k;
+  int i, j, s;
+  element_t *lookup = pbc_malloc(sizeof(element_t) * m * size);
+  element_ptr *dst = pbc_malloc(sizeof(element_ptr) * 3 * m);
+  element_ptr *src1 = dst + m, *src2 = dst + 2 * m;
   element_t result;
-  element_t lookup[8];
 
-  if (mpz_is0(n1) && mpz_is0(n2) && mpz_is0(n3)) {
+  for (i = 0; i < m; i++) {
+    element_t *row = lookup + i * size;
+    for (j = 0; j < size; j++) element_init(row[j], f);
+    element_set(row[1], a[i]);
+  }
+  for (j = 2; j < size; j++) {
+    for (i = 0; i < m; i++) {
+      dst[i] = lookup[i * size + j];
+      src1[i] = lookup[i * size + j - 1];
+      src2[i] = a[i];
+    }
+    f->multi_mul(dst, src1, src2, m);
+  }
+
+  element_init(result, f);
+  element_set1(result);
+  for (s = (bits - 1) / k * k; s >= 0; s -= k) {
+    for (j = 0; j < k; j++) element_square(result, result);
+    for (i = 0; i < m; i++) {
+      int d = exp_window(n[i], s, k);
+      if (d) element_mul(result, result, lookup[i * size + d]);
+    }
+  }
+  element_set(x, result);
+  element_clear(result);
+
+  for (i = 0; i < m * size; i++) element_clear(lookup[i]);
+  pbc_free(lookup);
+  pbc_free(dst);
+}
+
+// Pippenger: exponents are cut into c-bit windows, and for every window w
+// and digit d a bucket collects the product of the bases whose digit in
+// w is d. All buckets fill at once through multi_mul, which on curves is
+// affine addition sharing one inversion per call. Within a call each
+// bucket appears at most once; bases that collide wait for the next call.
+// Then, for all windows in lockstep, the running products give
+// T_w = prod_d B_{w,d}^d, and x = prod_w T_w^(2^(cw)).
+static void multi_pow_pippenger(element_ptr x, element_t a[], mpz_t n[],
+                                int m, int bits) {
+  field_ptr f = x->field;
+  int c, best = 1, nwin, nb, w, d, i, count, next, round;
+  double cost, best_cost = 0;
+  element_t *bucket, *sum, *acc;
+  element_ptr *dst, *src;
+  int *item, *wait, *stamp;
+
+  // Minimize the number of group operations, windows times the bases
+  // plus twice the buckets, while keeping the buckets under 2^16.
+  for (c = 1; c <= 12; c++) {
+    cost = (double) ((bits + c - 1) / c) * (m + (2 << c));
+    if (c == 1 || cost < best_cost) {
+      best = c;
+      best_cost = cost;
+    }
+  }
+  c = best;
+  nwin = (bits + c - 1) / c;
+  nb = (1 << c) - 1;
+
+  bucket = pbc_malloc(sizeof(element_t) * nwin * nb);
+  for (i = 0; i < nwin * nb; i++) {
+    element_init(bucket[i], f);
+    element_set1(bucket[i]);
+  }
+  item = pbc_malloc(sizeof(int) * m * nwin);
+  wait = pbc_malloc(sizeof(int) * m * nwin);
+  stamp = pbc_malloc(sizeof(int) * nwin * nb);
+  dst = pbc_malloc(sizeof(element_ptr) * 2 * m * nwin);
+  src = dst + m * nwin;
+  for (i = 0; i < nwin * nb; i++) stamp[i] = -1;
+
+  // Items are base i, window w with a nonzero digit, as i * nwin + w.
+  count = 0;
+  for (i = 0; i < m; i++) {
+    for (w = 0; w < nwin; w++) {
+      if (exp_window(n[i], w * c, c)) item[count++] = i * nwin + w;
+    }
+  }
+  for (round = 0; count; round++) {
+    int *t;
+    int batch = 0;
+    next = 0;
+    for (i = 0; i < count; i++) {
+      int base = item[i] / nwin;
+      w = item[i] % nwin;
+      int b = w * nb + exp_window(n[base], w * c, c) - 1;
+      if (stamp[b] == round) {
+        wait[next++] = item[i];
+        continue;
+      }
+      stamp[b] = round;
+      dst[batch] = bucket[b];
+      src[batch] = a[base];
+      batch++;
+    }
+    f->multi_mul(dst, dst, src, batch);
+    t = item; item = wait; wait = t;
+    count = next;
+  }
+
+  // sum_w runs over B_{w,nb}, ..., B_{w,d}; acc_w multiplies the sums.
+  sum = pbc_malloc(sizeof(element_t) * 2 * nwin);
+  acc = sum + nwin;
+  for (w = 0; w < nwin; w++) {
+    element_init(sum[w], f);
+    element_init(acc[w], f);
+    element_set(sum[w], bucket[w * nb + nb - 1]);
+    element_set(acc[w], sum[w]);
+  }
+  for (d = nb - 2; d >= 0; d--) {
+    for (w = 0; w < nwin; w++) {
+      dst[w] = sum[w];
+      src[w] = bucket[w * nb + d];
+    }
+    f->multi_mul(dst, dst, src, nwin);
+    for (w = 0; w < nwin; w++) src[w] = acc[w];
+    f->multi_mul(src, src, dst, nwin);
+  }
+
+  for (w = nwin - 2; w >= 0; w--) {
+    for (i = 0; i < c; i++) element_square(acc[nwin - 1], acc[nwin - 1]);
+    element_mul(acc[nwin - 1], acc[nwin - 1], acc[w]);
+  }
+  element_set(x, acc[nwin - 1]);
+
+  for (w = 0; w < nwin; w++) {
+    element_clear(sum[w]);
+    element_clear(acc[w]);
+  }
+  pbc_free(sum);
+  for (i = 0; i < nwin * nb; i++) element_clear(bucket[i]);
+  pbc_free(bucket);
+  pbc_free(item);
+  pbc_free(wait);
+  pbc_free(stamp);
+  pbc_free(dst);
+}
+
+void element_multi_pow_mpz(element_t x, element_t a[], mpz_t n[], int m) {
+  int i, s, bits = 0;
+
+  for (i = 0; i < m; i++) {
+    PBC_ASSERT_MATCH2(x, a[i]);
+    PBC_ASSERT(mpz_sgn(n[i]) >= 0, "negative exponent");
+    if (mpz_sgn(n[i]) && (s = mpz_sizeinbase(n[i], 2)) > bits) bits = s;
+  }
+  if (!bits) {
     element_set1(x);
     return;
   }
+  if (m == 1) element_pow_mpz(x, a[0], n[0]);
+  else if (x->field->multi_mul == x->field->multi_add ||
+      m >= MULTI_POW_PIPPENGER_MIN) multi_pow_pippenger(x, a, n, m, bits);
+  else multi_pow_straus(x, a, n, m, bits);
+}
 
-  element_init(result, x->field);
-  element_set1(result);
+void element_multi_pow_zn(element_t x, element_t a[], element_t n[], int m) {
+  mpz_t *z = pbc_malloc(sizeof(mpz_t) * m);
+  int i;
+  for (i = 0; i < m; i++) {
+    mpz_init(z[i]);
+    element_to_mpz(z[i], n[i]);
+  }
+  element_multi_pow_mpz(x, a, z, m);
+  for (i = 0; i < m; i++) mpz_clear(z[i]);
+  pbc_free(z);
+}
 
-  for (i = 0; i < 8; i++)
-    element_init(lookup[i], x->field);
+void element_pow_mpz_batch(element_t x[], element_t a[], mpz_t n[], int m) {
+  element_ptr *xp, *ap;
+  mpz_ptr *np;
+  int i;
 
-  // build lookup table.
-  element_set1(lookup[0]);
-  element_set(lookup[1], a1);
-  element_set(lookup[2], a2);
-  element_set(lookup[4], a3);
-  element_mul(lookup[3], a1, a2);
-  element_mul(lookup[5], a1, a3);
-  element_mul(lookup[6], a2, a3);
-  element_mul(lookup[7], lookup[6], a1);
-
-  // calculate largest exponent bitsize
-  s1 = mpz_sizeinbase(n1, 2) - 1;
-  s2 = mpz_sizeinbase(n2, 2) - 1;
-  s3 = mpz_sizeinbase(n3, 2) - 1;
-  s = (s1 > s2) ? ((s1 > s3) ? s1 : s3)
-      : ((s2 > s3) ? s2 : s3);
-
-  for (; s >= 0; s--) {
-    element_mul(result, result, result);
-    b = (mpz_tstbit(n1, s))
-        + (mpz_tstbit(n2, s) << 1)
-        + (mpz_tstbit(n3, s) << 2);
-    element_mul(result, result, lookup[b]);
+  if (m <= 0) return;
+  for (i = 0; i < m; i++) {
+    PBC_ASSERT_MATCH2(x[i], a[i]);
+    PBC_ASSERT(mpz_sgn(n[i]) >= 0, "negative exponent");
   }
+  if (!x[0]->field->pow_mpz_batch) {
+    for (i = 0; i < m; i++) element_pow_mpz(x[i], a[i], n[i]);
+    return;
+  }
+  xp = pbc_malloc(sizeof(element_ptr) * 2 * m);
+  ap = xp + m;
+  np = pbc_malloc(sizeof(mpz_ptr) * m);
+  for (i = 0; i < m; i++) {
+    xp[i] = x[i];
+    ap[i] = a[i];
+    np[i] = n[i];
+  }
+  x[0]->field->pow_mpz_batch(xp, ap, np, m);
+  pbc_free(xp);
+  pbc_free(np);
+}
 
-  element_set(x, result);
-  element_clear(result);
-  for (i = 0; i < 8; i++)
-    element_clear(lookup[i]);
+void element_pow_zn_batch(element_t x[], element_t a[], element_t n[], int m) {
+  mpz_t *z = pbc_malloc(sizeof(mpz_t) * m);
+  int i;
+  for (i = 0; i < m; i++) {
+    mpz_init(z[i]);
+    element_to_mpz(z[i], n[i]);
+  }
+  element_pow_mpz_batch(x, a, z, m);
+  for (i = 0; i < m; i++) mpz_clear(z[i]);
+  pbc_free(z);
 }
 
-struct element_base_table {
-  int k;
-  int bits;
-  int num_lookups;
-  element_t **table;
-};
-
-/* build k-bit base table for n-bit exponentiation w/ base a */
-static void *element_build_base_table(element_ptr a, int bits, int k) {
-  struct element_base_table *base_table;
-  element_t multiplier;
-  int i, j;
-  int lookup_size;
+void element_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m) {
+  element_ptr *xp, *ap;
+  int i;
 
-  element_t *lookup;
+  if (m <= 0) return;
+  PBC_ASSERT(mpz_sgn(n) >= 0, "negative exponent");
+  for (i = 0; i < m; i++) PBC_ASSERT_MATCH2(x[i], a[i]);
+  if (!x[0]->field->pow_mpz_same) {
+    for (i = 0; i < m; i++) element_pow_mpz(x[i], a[i], n);
+    return;
+  }
+  xp = pbc_malloc(sizeof(element_ptr) * 2 * m);
+  ap = xp + m;
+  for (i = 0; i < m; i++) {
+    xp[i] = x[i];
+    ap[i] = a[i];
+  }
+  x[0]->field->pow_mpz_same(xp, ap, n, m);
+  pbc_free(xp);
+}
 
-  // pbc_info("building %d bits %d k", bits, k);
-  lookup_size = 1 << k;
+void element_pow_zn_same(element_t x[], element_t a[], element_t n, int m) {
+  mpz_t z;
+  mpz_init(z);
+  element_to_mpz(z, n);
+  element_pow_mpz_same(x, a, z, m);
+  mpz_clear(z);
+}
 
-  base_table = pbc_malloc(sizeof(struct element_base_table));
-  base_table->num_lookups = bits / k + 1;
-  base_table->k = k;
-  base_table->bits = bits;
-  base_table->table =
-      pbc_malloc(base_table->num_lookups * sizeof(element_t *));
-
-  element_init(multiplier, a->field);
-  element_set(multiplier, a);
-
-  for (i = 0; i < base_table->num_lookups; i++) {
-    lookup = pbc_malloc(lookup_size * sizeof(element_t));
-    element_init(lookup[0], a->field);
-    element_set1(lookup[0]);
-    for (j = 1; j < lookup_size; j++) {
-      element_init(lookup[j], a->field);
-      element_mul(lookup[j], multiplier, lookup[j - 1]);
+int element_is_in_subgroup_batch(char ok[], element_t a[], int m) {
+  element_ptr *ap;
+  int i, count = 0;
+
+  if (m <= 0) return 0;
+  for (i = 1; i < m; i++) PBC_ASSERT_MATCH2(a[0], a[i]);
+  if (!a[0]->field->in_subgroup_batch) {
+    for (i = 0; i < m; i++) {
+      int pass = element_is_in_subgroup(a[i]);
+      if (ok) ok[i] = pass;
+      count += pass;
     }
-    element_mul(multiplier, multiplier, lookup[lookup_size - 1]);
-    base_table->table[i] = lookup;
+    return count;
   }
+  ap = pbc_malloc(sizeof(element_ptr) * m);
+  for (i = 0; i < m; i++) ap[i] = a[i];
+  count = a[0]->field->in_subgroup_batch(ok, ap, m);
+  pbc_free(ap);
+  return count;
+}
 
-  element_clear(multiplier);
-  return base_table;
+static void *element_build_base_table(element_ptr a, int bits, int k,
+    int strategy) {
+  struct element_base_table *bt = pbc_malloc(sizeof(*bt));
+  int per = (1 << k) - 1;
+  int i, j, s, e;
+  element_ptr *row;
+  element_t t;
+
+  bt->k = k;
+  bt->strategy = strategy;
+  element_init_same_as(t, a);
+  element_set(t, a);
+  if (strategy == PBC_PP_WINDOW) {
+    bt->rows = bits / k + 1;
+    element_vec_init(bt->table, a->field, bt->rows * per);
+    for (i = 0; i < bt->rows; i++) {
+      row = bt->table->ptr + i * per;
+      element_set(row[0], t);
+      for (j = 1; j < per; j++) element_mul(row[j], row[j - 1], t);
+      element_mul(t, row[per - 1], t);
+    }
+  } else {
+    bt->rows = strategy == PBC_PP_COMB2 ? 2 : 1;
+    bt->spacing = (bits + k - 1) / k;
+    bt->span = (bt->spacing + bt->rows - 1) / bt->rows;
+    element_vec_init(bt->table, a->field, bt->rows * per);
+    // The powers a^(2^e) for the single teeth, in increasing e.
+    for (e = 0, i = 0; i < k; i++) {
+      for (s = 0; s < bt->rows; s++) {
+        for (; e < i * bt->spacing + s * bt->span; e++) element_square(t, t);
+        element_set(bt->table->item[s * per + (1 << i) - 1], t);
+      }
+    }
+    for (s = 0; s < bt->rows; s++) {
+      row = bt->table->ptr + s * per;
+      for (j = 3; j <= per; j++) {
+        if (j & (j - 1)) element_mul(row[j - 1], row[(j & (j - 1)) - 1], row[(j & -j) - 1]);
+      }
+    }
+  }
+  element_clear(t);
+  return bt;
 }
 
-/*
- * exponentiation using aggressive base lookup table
- * must have k >= 1.
- */
 static void element_pow_base_table(element_ptr x, mpz_ptr power,
-                                   struct element_base_table *base_table) {
-  int word;                     /* the word to look up. 0<word<base */
-  int row, s;                   /* row and col in base table */
-  int num_lookups;
-
+                                   struct element_base_table *bt) {
+  int per = (1 << bt->k) - 1;
+  int word, row, s, i, c, col;
   element_t result;
   mpz_t n;
-  mpz_init_set(n, power);
 
+  mpz_init_set(n, power);
+  if (mpz_sgn(n) < 0 || mpz_cmp(n, x->field->order) > 0) {
+    mpz_mod(n, n, x->field->order);
+  }
   // Early abort if raising to power 0.
   if (!mpz_sgn(n)) {
     element_set1(x);
+    mpz_clear(n);
     return;
   }
-  if (mpz_cmp(n, x->field->order) > 0) {
-    mpz_mod(n, n, x->field->order);
-  }
 
   element_init(result, x->field);
   element_set1(result);
-
-  num_lookups = mpz_sizeinbase(n, 2) / base_table->k + 1;
-
-  for (row = 0; row < num_lookups; row++) {
-    word = 0;
-    for (s = 0; s < base_table->k; s++) {
-      word |= mpz_tstbit(n, base_table->k * row + s) << s;
+  if (bt->strategy == PBC_PP_WINDOW) {
+    int rows = mpz_sizeinbase(n, 2) / bt->k + 1;
+    for (row = 0; row < rows; row++) {
+      word = 0;
+      for (s = 0; s < bt->k; s++) {
+        word |= mpz_tstbit(n, bt->k * row + s) << s;
+      }
+      if (word) element_mul(result, result, bt->table->item[row * per + word - 1]);
     }
-    if (word > 0) {
-      element_mul(result, result, base_table->table[row][word]);
+  } else {
+    for (c = bt->span - 1; c >= 0; c--) {
+      element_square(result, result);
+      for (s = 0; s < bt->rows; s++) {
+        col = s * bt->span + c;
+        if (col >= bt->spacing) continue;
+        word = 0;
+        for (i = 0; i < bt->k; i++) {
+          word |= mpz_tstbit(n, i * bt->spacing + col) << i;
+        }
+        if (word) element_mul(result, result, bt->table->item[s * per + word - 1]);
+      }
     }
   }
 
@@ -329,8 +684,8 @@ static void element_pow_base_table(element_ptr x, mpz_ptr power,
 }
 
 static void default_element_pp_init(element_pp_t p, element_t in) {
-  p->data =
-      element_build_base_table(in, mpz_sizeinbase(in->field->order, 2), 5);
+  p->data = element_build_base_table(in, mpz_sizeinbase(in->field->order, 2),
+      5, PBC_PP_WINDOW);
 }
 
 static void default_element_pp_pow(element_t out, mpz_ptr power, element_pp_t p) {
@@ -338,23 +693,119 @@ static void default_element_pp_pow(element_t out, mpz_ptr power, element_pp_t p)
 }
 
 static void default_element_pp_clear(element_pp_t p) {
-  struct element_base_table *base_table = p->data;
-  int lookup_size = 1 << base_table->k;
-  element_t *lookup;
-  int i, j;
+  struct element_base_table *bt = p->data;
+  element_vec_clear(bt->table);
+  pbc_free(bt);
+}
+
+void element_pp_wipe(element_pp_t p) {
+  struct element_base_table *bt;
+  int i;
+  if (p->field->pp_wipe) {
+    p->field->pp_wipe(p);
+    return;
+  }
+  if (p->field->pp_clear != default_element_pp_clear) return;
+  bt = p->data;
+  for (i = 0; i < bt->table->n; i++) element_wipe(bt->table->item[i]);
+}
 
-  element_t **epp = base_table->table;
+// Written tables: a version byte, k, the strategy, the number of rows,
+// then spacing and span in 4 bytes each, big-endian, then the elements.
+enum { BASE_TABLE_HEADER = 12 };
 
-  for (i = 0; i < base_table->num_lookups; i++) {
-    lookup = epp[i];
-    for (j = 0; j < lookup_size; j++) {
-      element_clear(lookup[j]);
-    }
-    pbc_free(lookup);
+int element_pp_length_in_bytes(element_pp_t p) {
+  struct element_base_table *bt = p->data;
+  if (!p->field->pp_is_base_table) return 0;
+  return BASE_TABLE_HEADER + element_vec_length_in_bytes(bt->table);
+}
+
+static void base_table_put32(unsigned char *data, int n) {
+  data[0] = n >> 24;
+  data[1] = n >> 16;
+  data[2] = n >> 8;
+  data[3] = n;
+}
+
+static int base_table_get32(unsigned char *data) {
+  return data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+int element_pp_to_bytes(unsigned char *data, element_pp_t p) {
+  struct element_base_table *bt = p->data;
+  if (!p->field->pp_is_base_table) return 0;
+  data[0] = 1;
+  data[1] = bt->k;
+  data[2] = bt->strategy;
+  data[3] = bt->rows;
+  base_table_put32(data + 4, bt->strategy == PBC_PP_WINDOW ? 0 : bt->spacing);
+  base_table_put32(data + 8, bt->strategy == PBC_PP_WINDOW ? 0 : bt->span);
+  return BASE_TABLE_HEADER +
+      element_vec_to_bytes(data + BASE_TABLE_HEADER, bt->table);
+}
+
+int element_pp_from_bytes(element_pp_t p, element_t in, unsigned char *data) {
+  struct element_base_table *bt;
+  int len, bits = mpz_sizeinbase(in->field->order, 2);
+  int k = data[1], strategy = data[2], rows = data[3];
+  int spacing = base_table_get32(data + 4), span = base_table_get32(data + 8);
+
+  if (!in->field->pp_is_base_table || data[0] != 1 || k < 1 || k > 16) {
+    return 0;
+  }
+  // Tables of element_pp_init_bits() may cover fewer bits than the order.
+  if (strategy == PBC_PP_WINDOW) {
+    if (rows < 1 || rows > bits / k + 1 || spacing || span) return 0;
+  } else if (strategy == PBC_PP_COMB || strategy == PBC_PP_COMB2) {
+    if (rows != (strategy == PBC_PP_COMB2 ? 2 : 1)) return 0;
+    if (spacing < 1 || spacing > (bits + k - 1) / k) return 0;
+    if (span != (spacing + rows - 1) / rows) return 0;
+  } else return 0;
+
+  bt = pbc_malloc(sizeof(*bt));
+  bt->k = k;
+  bt->strategy = strategy;
+  bt->rows = rows;
+  bt->spacing = spacing;
+  bt->span = span;
+  element_vec_init(bt->table, in->field, rows * ((1 << k) - 1));
+  len = element_vec_from_bytes(bt->table, data + BASE_TABLE_HEADER);
+  // Every layout starts with the base itself.
+  if (element_cmp(bt->table->item[0], in)) {
+    element_vec_clear(bt->table);
+    pbc_free(bt);
+    return 0;
   }
-  pbc_free(epp);
+  p->field = in->field;
+  p->data = bt;
+  return BASE_TABLE_HEADER + len;
+}
 
-  pbc_free(base_table);
+void element_pp_init_bits(element_pp_t p, element_t in, int bits, int k,
+    int strategy) {
+  p->field = in->field;
+  if (strategy != PBC_PP_COMB && strategy != PBC_PP_COMB2) {
+    strategy = PBC_PP_WINDOW;
+  }
+  if (in->field->pp_init_ex && k >= 1) {
+    in->field->pp_init_ex(p, in, bits, k, strategy);
+    return;
+  }
+  // Other fields with their own preprocessing ignore the table size.
+  if (in->field->pp_init != default_element_pp_init || k < 1) {
+    in->field->pp_init(p, in);
+    return;
+  }
+  p->data = element_build_base_table(in, bits, k, strategy);
+}
+
+void element_pp_init_ex(element_pp_t p, element_t in, int k, int strategy) {
+  element_pp_init_bits(p, in, mpz_sizeinbase(in->field->order, 2), k,
+      strategy);
+}
+
+void element_pp_init_k(element_pp_t p, element_t in, int k) {
+  element_pp_init_ex(p, in, k, PBC_PP_WINDOW);
 }
 
 void field_set_nqr(field_ptr f, element_t nqr) {
@@ -381,6 +832,52 @@ element_ptr field_get_nqr(field_ptr f) {
 static void generic_square(element_ptr r, element_ptr a) {
   element_mul(r, a, a);
 }
+static void generic_multi_mul(element_ptr *r, element_ptr *a, element_ptr *b,
+    int n) {
+  int i;
+  for (i = 0; i < n; i++) element_mul(r[i], a[i], b[i]);
+}
+
+// Montgomery's trick: t_i is the product of the nonzero a_j with j <= i,
+// and one inversion of t_(n-1) peels off every inverse in turn.
+static void generic_multi_invert(element_ptr *r, element_ptr *a, int n) {
+  element_t *t, inv, e0;
+  int *prev;  // Index of the previous nonzero a_j, or -1.
+  int i, last = -1;
+
+  if (n <= 0) return;
+  t = pbc_malloc(sizeof(element_t) * n);
+  prev = pbc_malloc(sizeof(int) * n);
+  for (i = 0; i < n; i++) {
+    element_init_same_as(t[i], a[i]);
+    prev[i] = last;
+    if (element_is0(a[i])) continue;
+    if (last < 0) element_set(t[i], a[i]);
+    else element_mul(t[i], t[last], a[i]);
+    last = i;
+  }
+  element_init_same_as(inv, a[0]);
+  element_init_same_as(e0, a[0]);
+  if (last >= 0) element_invert(inv, t[last]);
+  for (i = n - 1; i >= 0; i--) {
+    if (element_is0(a[i])) {
+      element_set0(r[i]);
+    } else if (prev[i] >= 0) {
+      // r[i] may be a[i].
+      element_mul(e0, inv, t[prev[i]]);
+      element_mul(inv, inv, a[i]);
+      element_set(r[i], e0);
+    } else {
+      element_set(r[i], inv);
+    }
+  }
+  for (i = 0; i < n; i++) element_clear(t[i]);
+  pbc_free(t);
+  pbc_free(prev);
+  element_clear(inv);
+  element_clear(e0);
+}
+
 static void generic_mul_mpz(element_ptr r, element_ptr a, mpz_ptr z) {
   element_t e0;
   element_init(e0, r->field);
@@ -505,6 +1002,20 @@ static int generic_is0(element_ptr a) {
   return result;
 }
 
+static int generic_in_subgroup(element_ptr a) {
+  UNUSED_VAR(a);
+  return 1;
+}
+
+static void generic_from_bytes_mod(element_ptr a, unsigned char *data,
+                                   int len) {
+  mpz_t z;
+  mpz_init(z);
+  mpz_import(z, len, 1, 1, 1, 0, data);
+  element_set_mpz(a, z);
+  mpz_clear(z);
+}
+
 static int generic_is1(element_ptr a) {
   int result;
   element_t b;
@@ -519,6 +1030,13 @@ static void generic_out_info(FILE * out, field_ptr f) {
   element_fprintf(out, "unknown field %p, order = %Zd", f, f->order);
 }
 
+// Components first; a field without any relies on its set0.
+static void generic_wipe(element_ptr e) {
+  int i, n = element_item_count(e);
+  for (i = 0; i < n; i++) element_wipe(element_item(e, i));
+  element_set0(e);
+}
+
 static int generic_item_count(element_ptr e) {
   UNUSED_VAR(e);
   return 0;
@@ -580,6 +1098,14 @@ void field_init(field_ptr f) {
   f->halve = generic_halve;
   f->doub = generic_double;
   f->square = generic_square;
+  f->multi_doub = NULL;
+  f->multi_add = NULL;
+  f->pow_mpz_batch = NULL;
+  f->pow_mpz_same = NULL;
+  f->in_subgroup = generic_in_subgroup;
+  f->in_subgroup_batch = NULL;
+  f->multi_mul = generic_multi_mul;
+  f->multi_invert = generic_multi_invert;
   f->mul_mpz = generic_mul_mpz;
   f->mul_si = generic_mul_si;
   f->cmp = generic_cmp;
@@ -594,6 +1120,9 @@ void field_init(field_ptr f) {
   f->set_mpz = zero_set_mpz;
   f->set_multiz = generic_set_multiz;
   f->random = zero_random;
+  // no hash unless the field provides one, e.g. none for eta_T_3 points
+  f->from_hash = NULL;
+  f->from_bytes_mod = generic_from_bytes_mod;
   f->set_si = generic_set_si;
   f->is1 = generic_is1;
   f->is0 = generic_is0;
@@ -603,12 +1132,22 @@ void field_init(field_ptr f) {
   f->item = generic_item;
   f->get_x = generic_get_x;
   f->get_y = generic_get_y;
+  f->wipe = generic_wipe;
 
   // these are fast, thanks to Hovav
   f->pow_mpz = generic_pow_mpz;
+  f->cmov = generic_cmov;
+  f->pow_mpz_ct = generic_pow_mpz_ct;
+  f->invert_ct = generic_invert_ct;
+  f->multi_pow_mpz = generic_multi_pow_mpz;
   f->pp_init = default_element_pp_init;
   f->pp_clear = default_element_pp_clear;
   f->pp_pow = default_element_pp_pow;
+  f->pp_init_ex = NULL;
+  f->pp_is_base_table = 1;
+  f->pp_wipe = NULL;
+  f->packed_size = 0;
+  f->init_packed = NULL;
 
   f->snprint = default_element_snprint;
   f->set_str = default_element_set_str;
@@ -703,12 +1242,8 @@ void element_tonelli(element_ptr x, element_ptr a) {
   mpz_tdiv_q_2exp(t, t, 1);
   mpz_tdiv_q_2exp(e, e, 1);
 
-  // (suggested by Hovav Shacham) replace next three lines with
-  //   element_pow2_mpz(x, e0, t, nqr, e);
-  // once sliding windows are implemented for pow2.
-  element_pow_mpz(e0, e0, t);
-  element_pow_mpz(x, nqr, e);
-  element_mul(x, x, e0);
+  // (suggested by Hovav Shacham) one chain of squarings for both powers
+  element_pow2_mpz(x, e0, t, nqr, e);
 
   mpz_clear(t);
   mpz_clear(e);
@@ -877,6 +1412,131 @@ void element_multi_add(element_t n[], element_t a[],element_t b[], int m) {
   pbc_free(temp3);
 }
 
+void element_multi_mul(element_t n[], element_t a[], element_t b[], int m) {
+  size_t size = sizeof(element_ptr)*m;
+  element_ptr *temp1 = pbc_malloc(size);
+  element_ptr *temp2 = pbc_malloc(size);
+  element_ptr *temp3 = pbc_malloc(size);
+
+  int i;
+  for(i=0; i<m; i++){
+    PBC_ASSERT_MATCH3(n[i], a[i], b[i]);
+    temp1[i] = n[i];
+    temp2[i] = a[i];
+    temp3[i] = b[i];
+  }
+
+  n[0]->field->multi_mul(temp1, temp2, temp3, m);
+  pbc_free(temp1);
+  pbc_free(temp2);
+  pbc_free(temp3);
+}
+
+void element_multi_invert(element_t n[], element_t a[], int m) {
+  size_t size = sizeof(element_ptr)*m;
+  element_ptr *temp1 = pbc_malloc(size);
+  element_ptr *temp2 = pbc_malloc(size);
+
+  int i;
+  for(i=0; i<m; i++){
+    PBC_ASSERT_MATCH2(n[i], a[i]);
+    temp1[i] = n[i];
+    temp2[i] = a[i];
+  }
+
+  if (m > 0) n[0]->field->multi_invert(temp1, temp2, m);
+  pbc_free(temp1);
+  pbc_free(temp2);
+}
+
+void element_vec_init(element_vec_t v, field_ptr f, int n) {
+  size_t head = n * (sizeof(element_t) + sizeof(element_ptr));
+  unsigned char *mem = pbc_malloc(head + n * f->packed_size);
+  unsigned char *data = mem + head;
+  int i;
+
+  v->field = f;
+  v->n = n;
+  v->item = (element_t *) mem;
+  v->ptr = (element_ptr *) (mem + n * sizeof(element_t));
+  for (i = 0; i < n; i++) {
+    if (f->packed_size) {
+      element_init_packed(v->item[i], f, data);
+      data += f->packed_size;
+    } else element_init(v->item[i], f);
+    v->ptr[i] = v->item[i];
+  }
+}
+
+void element_vec_clear(element_vec_t v) {
+  int i;
+  if (!v->field->packed_size) {
+    for (i = 0; i < v->n; i++) element_clear(v->item[i]);
+  }
+  pbc_free(v->item);
+}
+
+void element_vec_random(element_vec_t v) {
+  int i;
+  for (i = 0; i < v->n; i++) element_random(v->item[i]);
+}
+
+void element_vec_mul(element_vec_t out, element_vec_t a, element_vec_t b) {
+  PBC_ASSERT(out->field == a->field && out->field == b->field,
+      "field mismatch");
+  PBC_ASSERT(out->n == a->n && out->n == b->n, "length mismatch");
+  if (out->n > 0) out->field->multi_mul(out->ptr, a->ptr, b->ptr, out->n);
+}
+
+void element_vec_pow_zn(element_vec_t out, element_vec_t a, element_vec_t n) {
+  mpz_t z;
+  int i;
+  PBC_ASSERT(out->field == a->field, "field mismatch");
+  PBC_ASSERT(out->n == a->n && out->n == n->n, "length mismatch");
+  mpz_init(z);
+  for (i = 0; i < out->n; i++) {
+    element_to_mpz(z, n->item[i]);
+    element_pow_mpz(out->item[i], a->item[i], z);
+  }
+  mpz_clear(z);
+}
+
+void element_vec_pp_pow_zn(element_vec_t out, element_pp_t p, element_vec_t n) {
+  mpz_t z;
+  int i;
+  PBC_ASSERT(out->field == p->field, "field mismatch");
+  PBC_ASSERT(out->n == n->n, "length mismatch");
+  mpz_init(z);
+  for (i = 0; i < out->n; i++) {
+    element_to_mpz(z, n->item[i]);
+    element_pp_pow(out->item[i], z, p);
+  }
+  mpz_clear(z);
+}
+
+int element_vec_length_in_bytes(element_vec_t v) {
+  int i, len = 0;
+  if (v->field->fixed_length_in_bytes >= 0) {
+    return v->n * v->field->fixed_length_in_bytes;
+  }
+  for (i = 0; i < v->n; i++) len += element_length_in_bytes(v->item[i]);
+  return len;
+}
+
+int element_vec_to_bytes(unsigned char *data, element_vec_t v) {
+  int i, len = 0;
+  for (i = 0; i < v->n; i++) len += element_to_bytes(data + len, v->item[i]);
+  return len;
+}
+
+int element_vec_from_bytes(element_vec_t v, unsigned char *data) {
+  int i, len = 0;
+  for (i = 0; i < v->n; i++) {
+    len += element_from_bytes(v->item[i], data + len);
+  }
+  return len;
+}
+
 element_ptr element_new(field_ptr f) {
   element_ptr e = pbc_malloc(sizeof(*e));
   element_init(e, f);
@@ -17,6 +17,8 @@
 #include "pbc_multiz.h"
 #include "pbc_fieldquadratic.h"
 #include "pbc_memory.h"
+#include "arith/recode.h"
+#include "arith/montfp.h"
 
 // Per-element data.
 typedef struct {
@@ -49,6 +51,42 @@ static void fq_clear(element_ptr e) {
   pbc_free(e->data);
 }
 
+// The data of x and y follow the per-element data.
+static void fq_init_packed(element_ptr e, void *mem) {
+  eptr p = e->data = mem;
+  field_ptr f = e->field->data;
+  unsigned char *next = (unsigned char *) (p + 1);
+  element_init_packed(p->x, f, next);
+  element_init_packed(p->y, f, next + f->packed_size);
+}
+
+// Quadratic extensions pack their elements when the base field does.
+static void fq_set_packed(field_ptr f, field_ptr fbase) {
+  if (!fbase->packed_size) return;
+  f->packed_size = sizeof(*((eptr) 0)) + 2 * fbase->packed_size;
+  f->init_packed = fq_init_packed;
+}
+
+// Temporaries in the base field for a single operation, inline elements
+// on the caller's stack.
+#define FQ_TMP_MAX 3
+
+struct fq_tmp_s {
+  element_inline_t e[FQ_TMP_MAX];
+  int n;
+};
+
+static inline void fq_tmp_init(struct fq_tmp_s *t, field_ptr f, int n) {
+  int i;
+  t->n = n;
+  for (i = 0; i < n; i++) element_init_inline(t->e[i], f);
+}
+
+static inline void fq_tmp_clear(struct fq_tmp_s *t) {
+  int i;
+  for (i = 0; i < t->n; i++) element_clear_inline(t->e[i]);
+}
+
 static void fq_set_si(element_ptr e, signed long int i) {
   eptr p = e->data;
   element_set_si(p->x, i);
@@ -194,17 +232,23 @@ static void fq_set(element_ptr n, element_ptr a) {
   element_set(r->y, p->y);
 }
 
+static void fq_cmov(element_ptr n, element_ptr a, int bit) {
+  eptr p = a->data;
+  eptr r = n->data;
+  element_cmov(r->x, p->x, bit);
+  element_cmov(r->y, p->y, bit);
+}
+
 static void fq_mul(element_ptr n, element_ptr a, element_ptr b) {
   eptr p = a->data;
   eptr q = b->data;
   eptr r = n->data;
 
   element_ptr nqr = fq_nqr(n->field);
-  element_t e0, e1, e2;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e, e2 = t.e[2]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
-  element_init(e2, e0->field);
+  fq_tmp_init(&t, p->x->field, 3);
   /* naive:
   element_mul(e0, p->x, q->x);
   element_mul(e1, p->y, q->y);
@@ -227,9 +271,7 @@ static void fq_mul(element_ptr n, element_ptr a, element_ptr b) {
   element_sub(e2, e2, e0);
   element_sub(r->y, e2, e1);
 
-  element_clear(e0);
-  element_clear(e1);
-  element_clear(e2);
+  fq_tmp_clear(&t);
 }
 
 static void fq_mul_mpz(element_ptr n, element_ptr a, mpz_ptr z) {
@@ -250,10 +292,10 @@ static void fq_square(element_ptr n, element_ptr a) {
   eptr p = a->data;
   eptr r = n->data;
   element_ptr nqr = fq_nqr(n->field);
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_mul(e1, e1, nqr);
@@ -264,8 +306,7 @@ static void fq_square(element_ptr n, element_ptr a) {
   element_double(e1, e1);
   element_set(r->x, e0);
   element_set(r->y, e1);
-  element_clear(e0);
-  element_clear(e1);
+  fq_tmp_clear(&t);
 }
 
 static void fq_neg(element_ptr n, element_ptr a) {
@@ -291,10 +332,10 @@ static void fq_invert(element_ptr n, element_ptr a) {
   eptr p = a->data;
   eptr r = n->data;
   element_ptr nqr = fq_nqr(n->field);
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_mul(e1, e1, nqr);
@@ -304,8 +345,7 @@ static void fq_invert(element_ptr n, element_ptr a) {
   element_neg(e0, e0);
   element_mul(r->y, p->y, e0);
 
-  element_clear(e0);
-  element_clear(e1);
+  fq_tmp_clear(&t);
 }
 
 static void fq_from_hash(element_ptr n, void *data, int len) {
@@ -339,18 +379,17 @@ static int fq_from_bytes(element_t e, unsigned char *data) {
 static int fq_is_sqr(element_ptr e) {
   //x + y sqrt(nqr) is a square iff x^2 - nqr y^2 is (in the base field)
   eptr p = e->data;
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
   element_ptr nqr = fq_nqr(e->field);
   int result;
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_mul(e1, e1, nqr);
   element_sub(e0, e0, e1);
   result = element_is_sqr(e0);
-  element_clear(e0);
-  element_clear(e1);
+  fq_tmp_clear(&t);
   return result;
 }
 
@@ -358,15 +397,14 @@ static void fq_sqrt(element_ptr n, element_ptr e) {
   eptr p = e->data;
   eptr r = n->data;
   element_ptr nqr = fq_nqr(n->field);
-  element_t e0, e1, e2;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e, e2 = t.e[2]->e;
 
   //if (a+b sqrt(nqr))^2 = x+y sqrt(nqr) then
   //2a^2 = x +- sqrt(x^2 - nqr y^2)
   //(take the sign which allows a to exist)
   //and 2ab = y
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
-  element_init(e2, e0->field);
+  fq_tmp_init(&t, p->x->field, 3);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_mul(e1, e1, nqr);
@@ -387,9 +425,7 @@ static void fq_sqrt(element_ptr n, element_ptr e) {
   element_invert(e1, e1);
   element_mul(r->y, p->y, e1);
   element_set(r->x, e0);
-  element_clear(e0);
-  element_clear(e1);
-  element_clear(e2);
+  fq_tmp_clear(&t);
 }
 
 static int fq_item_count(element_ptr e) {
@@ -426,11 +462,10 @@ static void fi_mul(element_ptr n, element_ptr a, element_ptr b) {
   eptr p = a->data;
   eptr q = b->data;
   eptr r = n->data;
-  element_t e0, e1, e2;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e, e2 = t.e[2]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
-  element_init(e2, e0->field);
+  fq_tmp_init(&t, p->x->field, 3);
   /* Naive method:
   element_mul(e0, p->x, q->x);
   element_mul(e1, p->y, q->y);
@@ -451,18 +486,16 @@ static void fi_mul(element_ptr n, element_ptr a, element_ptr b) {
   element_sub(r->x, e0, e1);
   element_sub(r->y, e2, e1);
 
-  element_clear(e0);
-  element_clear(e1);
-  element_clear(e2);
+  fq_tmp_clear(&t);
 }
 
 static void fi_square(element_ptr n, element_ptr a) {
   eptr p = a->data;
   eptr r = n->data;
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   // Re(n) = x^2 - y^2 = (x+y)(x-y)
   element_add(e0, p->x, p->y);
   element_sub(e1, p->x, p->y);
@@ -472,17 +505,129 @@ static void fi_square(element_ptr n, element_ptr a) {
   element_add(e1, e1, e1);
   element_set(r->x, e0);
   element_set(r->y, e1);
-  element_clear(e0);
-  element_clear(e1);
+  fq_tmp_clear(&t);
+}
+
+#if MONT_DIRECT_LIMBS
+// fi_mul(), fi_square(), fq_mul() and fq_square() on the limbs, for the
+// direct path of montfp.h. The products making up a coefficient are
+// summed unreduced, on 2 DN limbs, and the sum takes one reduction.
+#define DN MONT_DIRECT_LIMBS
+
+// Adds p R to w, that is p to its upper half, to undo the borrow of
+// subtractions from w; the result lies in [0, p R).
+static inline void wide_settle(mp_limb_t *w, mp_limb_t borrow,
+                               const mp_limb_t *P) {
+  while (borrow) borrow -= fixed_add(w + DN, w + DN, P, DN);
+}
+
+// w += v for w, v < p R, less p R if the sum reaches it.
+static inline void wide_add(mp_limb_t *w, const mp_limb_t *v,
+                            const mp_limb_t *P) {
+  if (fixed_add(w, w, v, 2 * DN) || fixed_cmp(w + DN, P, DN) >= 0) {
+    fixed_sub(w + DN, w + DN, P, DN);
+  }
+}
+
+static void fi_mul_direct(element_ptr n, element_ptr a, element_ptr b) {
+  eptr p = a->data, q = b->data, r = n->data;
+  field_ptr f = p->x->field;
+  const mp_limb_t *P = mont_direct_modulus(f);
+  const mp_limb_t *px = mont_direct_get(p->x), *py = mont_direct_get(p->y);
+  const mp_limb_t *qx = mont_direct_get(q->x), *qy = mont_direct_get(q->y);
+  mp_limb_t e0[DN], e1[DN], w0[2 * DN], w1[2 * DN], w2[2 * DN];
+  mp_limb_t borrow;
+
+  // Karatsuba: x = px qx - py qy, y = (px + py)(qx + qy) - px qx - py qy.
+  mont_direct_add(e0, px, py, P);
+  mont_direct_add(e1, qx, qy, P);
+  mont_direct_mul_wide(w2, e0, e1, f);
+  mont_direct_mul_wide(w0, px, qx, f);
+  mont_direct_mul_wide(w1, py, qy, f);
+  borrow = fixed_sub(w2, w2, w0, 2 * DN);
+  borrow += fixed_sub(w2, w2, w1, 2 * DN);
+  wide_settle(w2, borrow, P);
+  wide_settle(w0, fixed_sub(w0, w0, w1, 2 * DN), P);
+  mont_direct_redc(e0, w0, f);
+  mont_direct_redc(e1, w2, f);
+  mont_direct_set(r->x, e0);
+  mont_direct_set(r->y, e1);
+}
+
+static void fi_square_direct(element_ptr n, element_ptr a) {
+  eptr p = a->data, r = n->data;
+  field_ptr f = p->x->field;
+  const mp_limb_t *P = mont_direct_modulus(f);
+  const mp_limb_t *x = mont_direct_get(p->x), *y = mont_direct_get(p->y);
+  mp_limb_t e0[DN], e1[DN];
+
+  mont_direct_add(e0, x, y, P);
+  mont_direct_sub(e1, x, y, P);
+  mont_direct_mul(e0, e0, e1, f);
+  mont_direct_mul(e1, x, y, f);
+  mont_direct_add(e1, e1, e1, P);
+  mont_direct_set(r->x, e0);
+  mont_direct_set(r->y, e1);
 }
 
+static void fq_mul_direct(element_ptr n, element_ptr a, element_ptr b) {
+  eptr p = a->data, q = b->data, r = n->data;
+  field_ptr f = p->x->field;
+  const mp_limb_t *P = mont_direct_modulus(f);
+  const mp_limb_t *nqr = mont_direct_get(fq_nqr(n->field));
+  const mp_limb_t *px = mont_direct_get(p->x), *py = mont_direct_get(p->y);
+  const mp_limb_t *qx = mont_direct_get(q->x), *qy = mont_direct_get(q->y);
+  mp_limb_t e0[DN], e1[DN], w0[2 * DN], w1[2 * DN], w2[2 * DN];
+  mp_limb_t borrow;
+
+  // As fi_mul_direct() with x = px qx + nqr py qy: py qy is reduced on
+  // its own to be multiplied by nqr.
+  mont_direct_add(e0, px, py, P);
+  mont_direct_add(e1, qx, qy, P);
+  mont_direct_mul_wide(w2, e0, e1, f);
+  mont_direct_mul_wide(w0, px, qx, f);
+  mont_direct_mul_wide(w1, py, qy, f);
+  borrow = fixed_sub(w2, w2, w0, 2 * DN);
+  borrow += fixed_sub(w2, w2, w1, 2 * DN);
+  wide_settle(w2, borrow, P);
+  mont_direct_redc(e0, w1, f);
+  mont_direct_mul_wide(w1, e0, nqr, f);
+  wide_add(w0, w1, P);
+  mont_direct_redc(e0, w0, f);
+  mont_direct_redc(e1, w2, f);
+  mont_direct_set(r->x, e0);
+  mont_direct_set(r->y, e1);
+}
+
+static void fq_square_direct(element_ptr n, element_ptr a) {
+  eptr p = a->data, r = n->data;
+  field_ptr f = p->x->field;
+  const mp_limb_t *P = mont_direct_modulus(f);
+  const mp_limb_t *nqr = mont_direct_get(fq_nqr(n->field));
+  const mp_limb_t *x = mont_direct_get(p->x), *y = mont_direct_get(p->y);
+  mp_limb_t e0[DN], e1[DN], w0[2 * DN], w1[2 * DN];
+
+  // x^2 + nqr y^2 and 2xy.
+  mont_direct_sqr_wide(w0, x, f);
+  mont_direct_sqr_wide(w1, y, f);
+  mont_direct_redc(e0, w1, f);
+  mont_direct_mul_wide(w1, e0, nqr, f);
+  wide_add(w0, w1, P);
+  mont_direct_redc(e0, w0, f);
+  mont_direct_mul(e1, x, y, f);
+  mont_direct_add(e1, e1, e1, P);
+  mont_direct_set(r->x, e0);
+  mont_direct_set(r->y, e1);
+}
+#endif
+
 static void fi_invert(element_ptr n, element_ptr a) {
   eptr p = a->data;
   eptr r = n->data;
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
 
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_add(e0, e0, e1);
@@ -491,8 +636,56 @@ static void fi_invert(element_ptr n, element_ptr a) {
   element_neg(e0, e0);
   element_mul(r->y, p->y, e0);
 
+  fq_tmp_clear(&t);
+}
+
+// 1/(x + ya) = (x - ya) / N(x + ya): the norms, which lie in the base
+// field, are inverted there all at once.
+static void quadratic_multi_invert(element_ptr *r, element_ptr *a, int n,
+    int is_fi) {
+  field_ptr fbase;
+  element_t *norm, e0;
+  element_ptr *np;
+  int i;
+
+  if (n <= 0) return;
+  fbase = r[0]->field->data;
+  norm = pbc_malloc(sizeof(element_t) * n);
+  np = pbc_malloc(sizeof(element_ptr) * n);
+  element_init(e0, fbase);
+  for (i = 0; i < n; i++) {
+    eptr p = a[i]->data;
+    element_init(norm[i], fbase);
+    element_square(norm[i], p->x);
+    element_square(e0, p->y);
+    if (is_fi) {
+      element_add(norm[i], norm[i], e0);
+    } else {
+      element_mul(e0, e0, fq_nqr(r[0]->field));
+      element_sub(norm[i], norm[i], e0);
+    }
+    np[i] = norm[i];
+  }
+  fbase->multi_invert(np, np, n);
+  for (i = 0; i < n; i++) {
+    eptr p = a[i]->data;
+    eptr q = r[i]->data;
+    element_mul(q->x, p->x, norm[i]);
+    element_neg(norm[i], norm[i]);
+    element_mul(q->y, p->y, norm[i]);
+    element_clear(norm[i]);
+  }
   element_clear(e0);
-  element_clear(e1);
+  pbc_free(norm);
+  pbc_free(np);
+}
+
+static void fq_multi_invert(element_ptr *r, element_ptr *a, int n) {
+  quadratic_multi_invert(r, a, n, 0);
+}
+
+static void fi_multi_invert(element_ptr *r, element_ptr *a, int n) {
+  quadratic_multi_invert(r, a, n, 1);
 }
 
 static int fi_is_sqr(element_ptr e) {
@@ -511,30 +704,28 @@ static int fi_is_sqr(element_ptr e) {
   // -y^2 is also a quadratic residue, but we know -1 is not a quadratic
   // residue. QED.
   eptr p = e->data;
-  element_t e0, e1;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e;
   int result;
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
+  fq_tmp_init(&t, p->x->field, 2);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_add(e0, e0, e1);
   result = element_is_sqr(e0);
-  element_clear(e0);
-  element_clear(e1);
+  fq_tmp_clear(&t);
   return result;
 }
 
 static void fi_sqrt(element_ptr n, element_ptr e) {
   eptr p = e->data;
   eptr r = n->data;
-  element_t e0, e1, e2;
+  struct fq_tmp_s t;
+  element_ptr e0 = t.e[0]->e, e1 = t.e[1]->e, e2 = t.e[2]->e;
 
   // If (a+bi)^2 = x+yi then 2a^2 = x +- sqrt(x^2 + y^2)
   // where we choose the sign so that a exists, and 2ab = y.
   // Thus 2b^2 = - (x -+ sqrt(x^2 + y^2)).
-  element_init(e0, p->x->field);
-  element_init(e1, e0->field);
-  element_init(e2, e0->field);
+  fq_tmp_init(&t, p->x->field, 3);
   element_square(e0, p->x);
   element_square(e1, p->y);
   element_add(e0, e0, e1);
@@ -554,9 +745,247 @@ static void fi_sqrt(element_ptr n, element_ptr e) {
   element_invert(e1, e1);
   element_mul(r->y, p->y, e1);
   element_set(r->x, e0);
-  element_clear(e0);
-  element_clear(e1);
-  element_clear(e2);
+  fq_tmp_clear(&t);
+}
+
+// Exponentiation in the subgroup of norm 1 of K[i], where x^2 + y^2 = 1.
+// There the inverse is the conjugate, and
+//   (x + yi)^2 = (2x^2 - 1) + ((x + y)^2 - 1)i
+// takes two squarings in K. Temporaries in K are kept for the whole
+// exponentiation.
+struct unitary_s {
+  element_t t0, t1, t2, one;
+  // The modulus if the base field allows the direct path, otherwise NULL.
+  const mp_limb_t *p;
+};
+
+static void unitary_init(struct unitary_s *u, field_ptr fbase) {
+  element_init(u->t0, fbase);
+  element_init(u->t1, fbase);
+  element_init(u->t2, fbase);
+  element_init(u->one, fbase);
+  element_set1(u->one);
+#if MONT_DIRECT_LIMBS
+  u->p = mont_direct_modulus(fbase);
+#else
+  u->p = NULL;
+#endif
+}
+
+static void unitary_clear(struct unitary_s *u) {
+  element_clear(u->t0);
+  element_clear(u->t1);
+  element_clear(u->t2);
+  element_clear(u->one);
+}
+
+#if MONT_DIRECT_LIMBS
+static void unitary_square_direct(eptr r, eptr p, struct unitary_s *u) {
+  const mp_limb_t *P = u->p, *one = mont_direct_get(u->one);
+  const mp_limb_t *x = mont_direct_get(p->x), *y = mont_direct_get(p->y);
+  field_ptr f = p->x->field;
+  mp_limb_t t0[DN], t1[DN];
+
+  mont_direct_add(t0, x, y, P);
+  mont_direct_mul(t0, t0, t0, f);
+  mont_direct_sub(t0, t0, one, P);
+  mont_direct_mul(t1, x, x, f);
+  mont_direct_add(t1, t1, t1, P);
+  mont_direct_sub(t1, t1, one, P);
+  mont_direct_set(r->x, t1);
+  mont_direct_set(r->y, t0);
+}
+
+static void unitary_mul_direct(eptr r, eptr p, eptr q, int conj,
+    struct unitary_s *u) {
+  const mp_limb_t *P = u->p;
+  const mp_limb_t *px = mont_direct_get(p->x), *py = mont_direct_get(p->y);
+  const mp_limb_t *qx = mont_direct_get(q->x), *qy = mont_direct_get(q->y);
+  field_ptr f = p->x->field;
+  mp_limb_t t0[DN], t1[DN], t2[DN];
+
+  mont_direct_add(t0, px, py, P);
+  if (conj) mont_direct_sub(t1, qx, qy, P);
+  else mont_direct_add(t1, qx, qy, P);
+  mont_direct_mul(t2, t0, t1, f);
+  mont_direct_mul(t0, px, qx, f);
+  mont_direct_mul(t1, py, qy, f);
+  mont_direct_sub(t2, t2, t0, P);
+  if (conj) {
+    mont_direct_add(t0, t0, t1, P);
+    mont_direct_add(t2, t2, t1, P);
+  } else {
+    mont_direct_sub(t0, t0, t1, P);
+    mont_direct_sub(t2, t2, t1, P);
+  }
+  mont_direct_set(r->x, t0);
+  mont_direct_set(r->y, t2);
+}
+#endif
+
+static void unitary_square(eptr r, eptr p, struct unitary_s *u) {
+#if MONT_DIRECT_LIMBS
+  if (u->p) {
+    unitary_square_direct(r, p, u);
+    return;
+  }
+#endif
+  element_add(u->t0, p->x, p->y);
+  element_square(u->t0, u->t0);
+  element_sub(r->y, u->t0, u->one);
+  element_square(u->t0, p->x);
+  element_double(u->t0, u->t0);
+  element_sub(r->x, u->t0, u->one);
+}
+
+// r = p q, or r = p q^-1 if conj, by Karatsuba. r may be p or q.
+static void unitary_mul(eptr r, eptr p, eptr q, int conj,
+    struct unitary_s *u) {
+#if MONT_DIRECT_LIMBS
+  if (u->p) {
+    unitary_mul_direct(r, p, q, conj, u);
+    return;
+  }
+#endif
+  element_add(u->t0, p->x, p->y);
+  if (conj) element_sub(u->t1, q->x, q->y);
+  else element_add(u->t1, q->x, q->y);
+  element_mul(u->t2, u->t0, u->t1);
+  element_mul(u->t0, p->x, q->x);
+  element_mul(u->t1, p->y, q->y);
+  element_sub(u->t2, u->t2, u->t0);
+  if (conj) {
+    element_add(r->x, u->t0, u->t1);
+    element_add(r->y, u->t2, u->t1);
+  } else {
+    element_sub(r->x, u->t0, u->t1);
+    element_sub(r->y, u->t2, u->t1);
+  }
+}
+
+// Left-to-right width-w NAF: negative digits multiply by the conjugate
+// of a table entry, so the table only holds a, a^3, ..., a^(2^(w-1)-1).
+void element_fi_unitary_pow_mpz(element_ptr x, element_ptr a, mpz_ptr n) {
+  struct unitary_s u;
+  int bits, w, size, len, neg, i;
+  element_t *tab;
+  signed char *d;
+  eptr r;
+  mpz_t e;
+
+  if (!mpz_sgn(n)) {
+    element_set1(x);
+    return;
+  }
+  mpz_init(e);
+  mpz_abs(e, n);
+  neg = mpz_sgn(n) < 0;
+  bits = mpz_sizeinbase(e, 2);
+  w = bits > 480 ? 6 : bits > 120 ? 5 : bits > 24 ? 4 : 2;
+  size = 1 << (w - 2);
+  d = pbc_malloc(bits + 1);
+  len = pbc_wnaf_recode(d, e, w);
+
+  unitary_init(&u, a->field->data);
+  tab = pbc_malloc(sizeof(element_t) * size);
+  for (i = 0; i < size; i++) element_init(tab[i], a->field);
+  element_set(tab[0], a);
+  if (size > 1) {
+    // x = a^2 for now; x may be a, which tab[0] holds.
+    unitary_square(x->data, tab[0]->data, &u);
+    for (i = 1; i < size; i++) {
+      unitary_mul(tab[i]->data, tab[i - 1]->data, x->data, 0, &u);
+    }
+  }
+
+  // The leading digit is positive.
+  r = x->data;
+  element_set(x, tab[d[len - 1] >> 1]);
+  if (neg) element_neg(r->y, r->y);
+  for (i = len - 2; i >= 0; i--) {
+    int v = d[i];
+    unitary_square(r, r, &u);
+    if (v) {
+      unitary_mul(r, r, tab[abs(v) >> 1]->data, (v < 0) != neg, &u);
+    }
+  }
+
+  for (i = 0; i < size; i++) element_clear(tab[i]);
+  pbc_free(tab);
+  pbc_free(d);
+  unitary_clear(&u);
+  mpz_clear(e);
+}
+
+#define UNITARY_POW_CT_WINDOW 4
+
+// The regular recoding of element_pow_mpz_ct() on curves: every window
+// costs w squarings and one multiplication by a table entry found by a
+// masked scan and conjugated under a mask. An even exponent runs as
+// n + 1, and the final multiplication by the conjugate of a is always
+// made and kept under a mask.
+void element_fi_unitary_pow_mpz_ct(element_ptr x, element_ptr a, mpz_ptr n,
+    mpz_ptr order) {
+  const int w = UNITARY_POW_CT_WINDOW, size = 1 << (w - 1);
+  element_t tab[1 << (UNITARY_POW_CT_WINDOW - 1)], t, acc, alt, negy;
+  struct unitary_s u;
+  int bits, m, even, i, k, *d;
+  eptr r, q;
+  mpz_t e;
+
+  mpz_init(e);
+  mpz_abs(e, n);
+  even = !mpz_odd_p(e);
+  mpz_add_ui(e, e, even);
+  bits = mpz_sizeinbase(e, 2);
+  if ((int) mpz_sizeinbase(order, 2) + 1 > bits) {
+    bits = mpz_sizeinbase(order, 2) + 1;
+  }
+  m = (bits + w) / w;
+  d = pbc_malloc(sizeof(*d) * m);
+  pbc_regular_recode(d, e, w, m);
+
+  unitary_init(&u, a->field->data);
+  for (i = 0; i < size; i++) element_init(tab[i], a->field);
+  element_init(t, a->field);
+  element_init(acc, a->field);
+  element_init(alt, a->field);
+  element_init(negy, u.one->field);
+  // Odd powers a, a^3, ..., a^(2^w - 1).
+  element_set(tab[0], a);
+  unitary_square(alt->data, tab[0]->data, &u);
+  for (i = 1; i < size; i++) {
+    unitary_mul(tab[i]->data, tab[i - 1]->data, alt->data, 0, &u);
+  }
+
+  q = t->data;
+  r = acc->data;
+  for (i = m - 1; i >= 0; i--) {
+    int s = -(d[i] < 0), idx = ((d[i] ^ s) - s) >> 1;
+    element_set(t, tab[0]);
+    for (k = 1; k < size; k++) element_cmov(t, tab[k], pbc_ct_eq(k, idx));
+    element_neg(negy, q->y);
+    element_cmov(q->y, negy, s & 1);
+    if (i == m - 1) {
+      element_set(acc, t);
+      continue;
+    }
+    for (k = 0; k < w; k++) unitary_square(r, r, &u);
+    unitary_mul(r, r, q, 0, &u);
+  }
+  unitary_mul(alt->data, r, tab[0]->data, 1, &u);
+  element_cmov(acc, alt, even);
+  if (mpz_sgn(n) < 0) element_neg(r->y, r->y);
+  element_set(x, acc);
+
+  for (i = 0; i < size; i++) element_clear(tab[i]);
+  element_clear(t);
+  element_clear(acc);
+  element_clear(alt);
+  element_clear(negy);
+  unitary_clear(&u);
+  pbc_free(d);
+  mpz_clear(e);
 }
 
 static void fi_out_info(FILE *out, field_ptr f) {
@@ -608,6 +1037,7 @@ void field_init_quadratic(field_ptr f, field_ptr fbase) {
   f->add = fq_add;
   f->sub = fq_sub;
   f->set = fq_set;
+  f->cmov = fq_cmov;
   f->mul = fq_mul;
   f->mul_mpz = fq_mul_mpz;
   f->mul_si = fq_mul_si;
@@ -616,6 +1046,7 @@ void field_init_quadratic(field_ptr f, field_ptr fbase) {
   f->neg = fq_neg;
   f->cmp = fq_cmp;
   f->invert = fq_invert;
+  f->multi_invert = fq_multi_invert;
   f->random = fq_random;
   f->from_hash = fq_from_hash;
   f->is1 = fq_is1;
@@ -631,6 +1062,12 @@ void field_init_quadratic(field_ptr f, field_ptr fbase) {
   f->item = fq_item;
   f->get_x = fq_get_x;
   f->get_y = fq_get_y;
+#if MONT_DIRECT_LIMBS
+  if (mont_direct_modulus(fbase)) {
+    f->mul = fq_mul_direct;
+    f->square = fq_square_direct;
+  }
+#endif
 
   mpz_mul(f->order, fbase->order, fbase->order);
   if (fbase->fixed_length_in_bytes < 0) {
@@ -639,6 +1076,7 @@ void field_init_quadratic(field_ptr f, field_ptr fbase) {
   } else {
     f->fixed_length_in_bytes = 2 * fbase->fixed_length_in_bytes;
   }
+  fq_set_packed(f, fbase);
 }
 
 void field_init_fi(field_ptr f, field_ptr fbase) {
@@ -658,6 +1096,7 @@ void field_init_fi(field_ptr f, field_ptr fbase) {
   f->add = fq_add;
   f->sub = fq_sub;
   f->set = fq_set;
+  f->cmov = fq_cmov;
   f->mul = fi_mul;
   f->mul_mpz = fq_mul_mpz;
   f->mul_si = fq_mul_si;
@@ -666,6 +1105,7 @@ void field_init_fi(field_ptr f, field_ptr fbase) {
   f->neg = fq_neg;
   f->cmp = fq_cmp;
   f->invert = fi_invert;
+  f->multi_invert = fi_multi_invert;
   f->random = fq_random;
   f->from_hash = fq_from_hash;
   f->is1 = fq_is1;
@@ -681,6 +1121,12 @@ void field_init_fi(field_ptr f, field_ptr fbase) {
   f->item = fq_item;
   f->get_x = fq_get_x;
   f->get_y = fq_get_y;
+#if MONT_DIRECT_LIMBS
+  if (mont_direct_modulus(fbase)) {
+    f->mul = fi_mul_direct;
+    f->square = fi_square_direct;
+  }
+#endif
 
   mpz_mul(f->order, fbase->order, fbase->order);
   if (fbase->fixed_length_in_bytes < 0) {
@@ -689,4 +1135,5 @@ void field_init_fi(field_ptr f, field_ptr fbase) {
   } else {
     f->fixed_length_in_bytes = 2 * fbase->fixed_length_in_bytes;
   }
+  fq_set_packed(f, fbase);
 }
@@ -14,13 +14,16 @@
 #include "pbc_field.h"
 #include "pbc_fp.h"
 
-// By default, use the montfp.c implementation of F_p. After
-// pbc_tweak_use_fp(), future field_init_fp calls will use the specified
-// implementation. This is useful for benchmarking and testing.
-static void (*option_fpinit) (field_ptr f, mpz_t prime) = field_init_mont_fp;
+// By default field_init_fp picks the implementation from the modulus,
+// see below. After pbc_tweak_use_fp(), future field_init_fp calls will use
+// the specified implementation instead. This is useful for benchmarking
+// and testing.
+static void (*option_fpinit) (field_ptr f, mpz_t prime) = NULL;
 
 void pbc_tweak_use_fp(char *s) {
-  if (!strcmp(s, "naive")) {
+  if (!strcmp(s, "auto")) {
+    option_fpinit = NULL;
+  } else if (!strcmp(s, "naive")) {
     option_fpinit = field_init_naive_fp;
   } else if (!strcmp(s, "fast")) {
     option_fpinit = field_init_fast_fp;
@@ -33,17 +36,19 @@ void pbc_tweak_use_fp(char *s) {
   }
 }
 
+// montfp.c beats the others at every size from 2 to 32 limbs (see
+// guru/timefp), and itself installs the fastest multiplication the CPU
+// supports (pbc_cpu_features()), so a single build adapts to each
+// machine. It needs an odd modulus of more than one word.
 void field_init_fp(field_ptr f, mpz_t modulus) {
   if (mpz_fits_ulong_p(modulus)) {
     // If this case mattered, I'd have written a F_p implementation specialized
     // for moduli that fits into machine words.
     field_init_naive_fp(f, modulus);
+  } else if (mpz_odd_p(modulus)) {
+    (option_fpinit ? option_fpinit : field_init_mont_fp)(f, modulus);
   } else {
-    if (mpz_odd_p(modulus)) {
-      option_fpinit(f, modulus);
-    } else {
-      // montfp.c only supports odd moduli.
-      field_init_faster_fp(f, modulus);
-    }
+    // montfp.c only supports odd moduli.
+    field_init_faster_fp(f, modulus);
   }
 }
@@ -6,13 +6,8 @@
 #include "pbc_random.h"
 
 void pbc_init_random(void) {
-  FILE *fp;
-  fp = fopen("/dev/urandom", "rb");
-  if (!fp) {
+  if (pbc_random_set_os()) {
     pbc_warn("could not open /dev/urandom, using deterministic random number generator");
     pbc_random_set_deterministic(0);
-  } else {
-    pbc_random_set_file("/dev/urandom");
-    fclose(fp);
   }
 }
@@ -21,6 +21,14 @@
 #include "pbc_random.h"
 #include "pbc_fp.h"
 #include "pbc_memory.h"
+#include "montfp_ifma.h"
+#include "montfp.h"
+
+// Inversion by Bernstein-Yang divsteps on 62-bit signed limbs, see
+// safegcd_invert().
+#if GMP_NAIL_BITS == 0 && GMP_LIMB_BITS == 64 && defined(__SIZEOF_INT128__)
+#define MONT_SAFEGCD
+#endif
 
 // Per-field data.
 typedef struct {
@@ -30,13 +38,19 @@ typedef struct {
   mp_limb_t negpinv;      // -p^-1 mod b
   mp_limb_t *R;           // R mod p
   mp_limb_t *R3;          // R^3 mod p
+  mont_ifma_t *ifma;      // Constants for multi_mul, NULL if unsupported.
+  const char *kernel;     // Multiplication routine, for out_info.
+  int adx;                // Nonzero if mul is the mulx/adx routine.
+#ifdef MONT_SAFEGCD
+  int64_t *p62;           // The modulus in 62-bit limbs.
+  uint64_t pinv62;        // p^-1 mod 2^62
+  int n62;                // Number of 62-bit limbs.
+  int rounds;             // Batches of 62 divsteps that always suffice.
+#endif
 } *fptr;
 
-// Per-element data.
-typedef struct {
-  char flag;     // flag == 0 means the element is zero.
-  mp_limb_t *d;  // Otherwise d points to an array holding the element.
-} *eptr;
+// Per-element data, see montfp.h.
+typedef struct mont_elem_s *eptr;
 
 // Copies limbs of z into dst and zeroes any leading limbs, where n is the
 // total number of limbs.
@@ -61,11 +75,26 @@ static void fp_clear(element_ptr e) {
   pbc_free(e->data);
 }
 
+// The limbs follow the per-element data.
+static void fp_init_packed(element_ptr e, void *mem) {
+  eptr ep = e->data = mem;
+  ep->flag = 0;
+  ep->d = (mp_limb_t *) (ep + 1);
+}
+
+static void set_wide(element_ptr e, mp_limb_t *y);
+
 static void fp_set_mpz(element_ptr e, mpz_ptr z) {
   fptr p = e->field->data;
   eptr ep = e->data;
   if (!mpz_sgn(z)) ep->flag = 0;
-  else {
+  else if (mpz_sgn(z) > 0 && mpz_size(z) <= 2 * p->limbs) {
+    size_t i, n = mpz_size(z);
+    mp_limb_t y[2 * p->limbs];
+    for (i = 0; i < n; i++) y[i] = mpz_getlimbn(z, i);
+    memset(&y[n], 0, (2 * p->limbs - n) * sizeof(mp_limb_t));
+    set_wide(e, y);
+  } else {
     mpz_t tmp;
     mpz_init(tmp);
     mpz_mul_2exp(tmp, z, p->bytes * 8);
@@ -137,11 +166,29 @@ static void fp_to_mpz(mpz_ptr z, element_ptr e) {
   }
 }
 
+// Masks every limb, and the flag, whichever way bit goes.
+static void fp_cmov(element_ptr c, element_ptr a, int bit) {
+  fptr p = c->field->data;
+  eptr ad = a->data;
+  eptr cd = c->data;
+  mp_limb_t mask = -(mp_limb_t) (bit & 1);
+  size_t i;
+  for (i = 0; i < p->limbs; i++) cd->d[i] ^= (cd->d[i] ^ ad->d[i]) & mask;
+  cd->flag ^= (cd->flag ^ ad->flag) & (char) mask;
+}
+
 static void fp_set0(element_ptr e) {
   eptr ep = e->data;
   ep->flag = 0;
 }
 
+static void fp_wipe(element_ptr e) {
+  fptr p = e->field->data;
+  eptr ep = e->data;
+  memset(ep->d, 0, p->bytes);
+  ep->flag = 0;
+}
+
 static void fp_set1(element_ptr e) {
   fptr p = e->field->data;
   eptr ep = e->data;
@@ -336,15 +383,22 @@ static inline void mont_mul(mp_limb_t *c, mp_limb_t *a, mp_limb_t *b,
   // I allocate more room for the z array.
   size_t i, t = p->limbs;
   mp_limb_t z[2 * t + 1];
-  mp_limb_t u = (a[0] * b[0]) * p->negpinv;
-  mp_limb_t v = z[t] = mpn_mul_1(z, b, t, a[0]);
-  z[t] += mpn_addmul_1(z, p->primelimbs, t, u);
-  z[t + 1] = z[t] < v;  // Handle overflow.
-  for (i = 1; i < t; i++) {
-    u = (z[i] + a[i] * b[0]) * p->negpinv;
-    v = z[t + i] += mpn_addmul_1(z + i, b, t, a[i]);
-    z[t + i] += mpn_addmul_1(z + i, p->primelimbs, t, u);
-    z[t + i + 1] = z[t + i] < v;
+  mp_limb_t u, v, s;
+  z[t] = mpn_mul_1(z, b, t, a[0]);
+  u = z[0] * p->negpinv;
+  z[t + 1] = 0;
+  for (i = 0;;) {
+    // Row i leaves at most 1 above z[t + i], so both of its carries,
+    // which may each overflow that limb, go into the limb above.
+    v = mpn_addmul_1(z + i, p->primelimbs, t, u);
+    s = z[t + i] += v;
+    z[t + i + 1] += s < v;
+    if (++i == t) break;
+    z[t + i + 1] = 0;
+    v = mpn_addmul_1(z + i, b, t, a[i]);
+    s = z[t + i] += v;
+    z[t + i + 1] += s < v;
+    u = z[i] * p->negpinv;
   }
   if (z[t * 2] || mpn_cmp(z + t, p->primelimbs, t) >= 0) {
     mpn_sub_n(c, z + t, p->primelimbs, t);
@@ -361,6 +415,30 @@ static inline void mont_mul(mp_limb_t *c, mp_limb_t *a, mp_limb_t *b,
   }
 }
 
+// Sets e to y mod p, where y has 2t limbs and y < R^2, without a
+// division: the reduction leaves some x = y R^-1 below R, and
+// multiplying x by R^3 brings it to y R mod p. Overwrites y.
+static void set_wide(element_ptr e, mp_limb_t *y) {
+  fptr p = e->field->data;
+  eptr ep = e->data;
+  mp_limb_t x[p->limbs];
+  mont_reduce(x, y, p);
+  mont_mul(ep->d, x, p->R3, p);
+  ep->flag = mpn_zero_p(ep->d, p->limbs) ? 0 : 2;
+}
+
+// Reads len big-endian bytes into the 2t limbs of y, len <= 2 p->bytes.
+static void set_wide_bytes(mp_limb_t *y, unsigned char *data, int len,
+                           fptr p) {
+  int i;
+  memset(y, 0, 2 * p->bytes);
+  for (i = 0; i < len; i++) {
+    int k = len - 1 - i;
+    y[k / sizeof(mp_limb_t)] |=
+        (mp_limb_t) data[i] << (8 * (k % sizeof(mp_limb_t)));
+  }
+}
+
 static void fp_mul(element_ptr c, element_ptr a, element_ptr b) {
   eptr ad = a->data, bd = b->data;
   eptr cd = c->data;
@@ -374,6 +452,201 @@ static void fp_mul(element_ptr c, element_ptr a, element_ptr b) {
   }
 }
 
+// c = w R^-1 mod p for w < p R on 2t limbs, as in mont_reduce() but
+// leaving w alone: each row's carry lands in the limb above it, which
+// the rows before have not reached yet.
+static void mont_redc(mp_limb_t *c, const mp_limb_t *w, fptr p) {
+  size_t i, t = p->limbs;
+  mp_limb_t z[2 * t + 1];
+  for (i = 0; i < t; i++) z[i] = w[i];
+  for (; i < 2 * t + 1; i++) z[i] = 0;
+  for (i = 0; i < t; i++) {
+    z[i + t] = mpn_addmul_1(z + i, p->primelimbs, t, z[i] * p->negpinv);
+  }
+  z[2 * t] = mpn_add_n(z + t, z + t, w + t, t);
+  if (z[2 * t] || mpn_cmp(z + t, p->primelimbs, t) >= 0) {
+    mpn_sub_n(c, z + t, p->primelimbs, t);
+  } else {
+    memcpy(c, z + t, t * sizeof(mp_limb_t));
+  }
+}
+
+// Squaring: GMP's mpn_sqr() forms each cross product once, then the
+// square is reduced.
+static void fp_square(element_ptr c, element_ptr a) {
+  eptr ad = a->data;
+  eptr cd = c->data;
+
+  if (!ad->flag) {
+    cd->flag = 0;
+  } else {
+    fptr p = c->field->data;
+    mp_limb_t w[2 * p->limbs];
+    mpn_sqr(w, ad->d, p->limbs);
+    mont_redc(cd->d, w, p);
+    cd->flag = 2;
+  }
+}
+
+// Fixed-width routines; the kernels are in montfp.h.
+#ifdef MONT_FIXED
+#ifdef MONT_ASM
+#define ADX_MUL(n) \
+static void fp_mul_adx_##n(element_ptr c, element_ptr a, element_ptr b) { \
+  eptr ad = a->data, bd = b->data, cd = c->data; \
+  if (!ad->flag || !bd->flag) { \
+    cd->flag = 0; \
+  } else { \
+    fptr p = c->field->data; \
+    fixed_mont_mul_adx(cd->d, ad->d, bd->d, p->primelimbs, p->negpinv, n); \
+    cd->flag = 2; \
+  } \
+}
+
+static int have_adx(void) {
+  unsigned int f = PBC_CPU_BMI2 | PBC_CPU_ADX;
+  return (pbc_cpu_features() & f) == f;
+}
+#else
+#define ADX_MUL(n)
+#endif
+
+#define FIXED_OPS(n) \
+static void fp_add_##n(element_ptr c, element_ptr a, element_ptr b) { \
+  eptr ad = a->data, bd = b->data, cd = c->data; \
+  if (!ad->flag) fp_set(c, b); \
+  else if (!bd->flag) fp_set(c, a); \
+  else { \
+    fptr p = c->field->data; \
+    cd->flag = fixed_add_mod(cd->d, ad->d, bd->d, p->primelimbs, n); \
+  } \
+} \
+static void fp_double_##n(element_ptr c, element_ptr a) { \
+  eptr ad = a->data, cd = c->data; \
+  if (!ad->flag) cd->flag = 0; \
+  else { \
+    fptr p = c->field->data; \
+    cd->flag = fixed_add_mod(cd->d, ad->d, ad->d, p->primelimbs, n); \
+  } \
+} \
+static void fp_sub_##n(element_ptr c, element_ptr a, element_ptr b) { \
+  eptr ad = a->data, bd = b->data, cd = c->data; \
+  fptr p = c->field->data; \
+  if (!bd->flag) fp_set(c, a); \
+  else if (!ad->flag) { \
+    fixed_sub(cd->d, p->primelimbs, bd->d, n); \
+    cd->flag = 2; \
+  } else { \
+    cd->flag = fixed_sub_mod(cd->d, ad->d, bd->d, p->primelimbs, n); \
+  } \
+} \
+static void fp_neg_##n(element_ptr c, element_ptr a) { \
+  eptr ad = a->data, cd = c->data; \
+  if (!ad->flag) cd->flag = 0; \
+  else { \
+    fptr p = c->field->data; \
+    fixed_sub(cd->d, p->primelimbs, ad->d, n); \
+    cd->flag = 2; \
+  } \
+} \
+static void fp_mul_##n(element_ptr c, element_ptr a, element_ptr b) { \
+  eptr ad = a->data, bd = b->data, cd = c->data; \
+  if (!ad->flag || !bd->flag) { \
+    cd->flag = 0; \
+  } else { \
+    fptr p = c->field->data; \
+    fixed_mont_mul(cd->d, ad->d, bd->d, p->primelimbs, p->negpinv, n); \
+    cd->flag = 2; \
+  } \
+} \
+ADX_MUL(n)
+
+FIXED_OPS(2)
+FIXED_OPS(3)
+FIXED_OPS(4)
+FIXED_OPS(5)
+FIXED_OPS(6)
+FIXED_OPS(7)
+FIXED_OPS(8)
+FIXED_OPS(9)
+FIXED_OPS(10)
+FIXED_OPS(11)
+FIXED_OPS(12)
+FIXED_OPS(13)
+FIXED_OPS(14)
+FIXED_OPS(15)
+FIXED_OPS(16)
+
+// Installs the routines for n limbs if there are any.
+static void fixed_init(field_ptr f, size_t n) {
+#ifdef MONT_ASM
+  int adx = have_adx();
+#define FIXED_MUL(n) adx ? fp_mul_adx_##n : \
+    n <= MONT_FIXED_C_MAX ? fp_mul_##n : fp_mul
+#else
+#define FIXED_MUL(n) n <= MONT_FIXED_C_MAX ? fp_mul_##n : fp_mul
+#endif
+#define FIXED_CASE(n) case n: \
+    f->add = fp_add_##n; f->doub = fp_double_##n; f->sub = fp_sub_##n; \
+    f->neg = fp_neg_##n; f->mul = FIXED_MUL(n); break;
+  switch (n) {
+    FIXED_CASE(2)
+    FIXED_CASE(3)
+    FIXED_CASE(4)
+    FIXED_CASE(5)
+    FIXED_CASE(6)
+    FIXED_CASE(7)
+    FIXED_CASE(8)
+    FIXED_CASE(9)
+    FIXED_CASE(10)
+    FIXED_CASE(11)
+    FIXED_CASE(12)
+    FIXED_CASE(13)
+    FIXED_CASE(14)
+    FIXED_CASE(15)
+    FIXED_CASE(16)
+  }
+  if (f->mul != fp_mul) {
+    fptr p = f->data;
+#ifdef MONT_ASM
+    p->kernel = adx ? "mulx/adx" : "unrolled";
+    p->adx = adx;
+#else
+    p->kernel = "unrolled";
+#endif
+  }
+#undef FIXED_MUL
+#undef FIXED_CASE
+}
+#endif
+
+// Batched multiplication, eight products at a time in AVX-512 lanes.
+// Products with a zero factor are settled here; the rest are gathered in
+// chunks so the lanes are kept full.
+static void fp_multi_mul(element_ptr *c, element_ptr *a, element_ptr *b,
+                         int n) {
+  enum { CHUNK = 64 };
+  fptr p = c[0]->field->data;
+  mp_limb_t *cl[CHUNK], *al[CHUNK], *bl[CHUNK];
+  int i, m = 0;
+  for (i = 0; i < n; i++) {
+    eptr ad = a[i]->data, bd = b[i]->data, cd = c[i]->data;
+    if (!ad->flag || !bd->flag) {
+      cd->flag = 0;
+      continue;
+    }
+    cl[m] = cd->d;
+    al[m] = ad->d;
+    bl[m] = bd->d;
+    cd->flag = 2;
+    if (++m == CHUNK) {
+      mont_ifma_mul(cl, al, bl, m, p->ifma);
+      m = 0;
+    }
+  }
+  if (m) mont_ifma_mul(cl, al, bl, m, p->ifma);
+}
+
 static void fp_pow_mpz(element_ptr c, element_ptr a, mpz_ptr op) {
   // Alternative: rewrite GMP mpz_powm().
   fptr p = a->field->data;
@@ -393,6 +666,261 @@ static void fp_pow_mpz(element_ptr c, element_ptr a, mpz_ptr op) {
   }
 }
 
+#ifdef MONT_SAFEGCD
+// Safegcd inversion: Bernstein and Yang, "Fast constant-time gcd computation
+// and modular inversion", following the layout of libsecp256k1's modinv64.
+// Numbers are held in n62 signed limbs of 62 bits, the top one carrying the
+// sign. Each batch of 62 divsteps is gathered into a matrix applied to the
+// full numbers at once. The constant-time version runs the bound on the
+// number of divsteps and branches on no data; the variable-time one skips
+// runs of zero bits and stops once g = 0.
+
+#define M62 ((uint64_t) -1 >> 2)
+
+typedef struct {
+  int64_t u, v, q, r;
+} divstep_t;
+
+static void limbs_to_s62(int64_t *out, const mp_limb_t *in, size_t n, int n62) {
+  unsigned __int128 acc = 0;
+  int bits = 0, i;
+  size_t j = 0;
+  for (i = 0; i < n62; i++) {
+    if (bits < 62 && j < n) {
+      acc |= (unsigned __int128) in[j++] << bits;
+      bits += 64;
+    }
+    out[i] = (int64_t) ((uint64_t) acc & M62);
+    acc >>= 62;
+    bits -= 62;
+  }
+}
+
+// Requires 0 <= in < 2^(64 n).
+static void s62_to_limbs(mp_limb_t *out, size_t n, const int64_t *in, int n62) {
+  unsigned __int128 acc = 0;
+  int bits = 0, i;
+  size_t j = 0;
+  for (i = 0; i < n62; i++) {
+    acc |= (unsigned __int128) (uint64_t) in[i] << bits;
+    bits += 62;
+    if (bits >= 64 && j < n) {
+      out[j++] = (mp_limb_t) acc;
+      acc >>= 64;
+      bits -= 64;
+    }
+  }
+  for (; j < n; j++) {
+    out[j] = (mp_limb_t) acc;
+    acc >>= 64;
+  }
+}
+
+// 62 divsteps on the low limbs of f and g, recording the transition matrix
+// scaled by 2^62. Returns the new delta.
+static int64_t divsteps_62(int64_t delta, uint64_t f, uint64_t g,
+                           divstep_t *t) {
+  uint64_t u = 1, v = 0, q = 0, r = 1, c0, c1, x, y, z;
+  int i;
+  for (i = 0; i < 62; i++) {
+    // With g odd: if delta > 0, (f, g) = (g, (g - f) / 2) and delta
+    // negates, else g = (g + f) / 2. With g even, g = g / 2.
+    c0 = -(g & 1);
+    c1 = c0 & (uint64_t) ((-delta) >> 63);
+    x = ((f ^ c1) - c1) & c0;
+    y = ((u ^ c1) - c1) & c0;
+    z = ((v ^ c1) - c1) & c0;
+    f ^= (f ^ g) & c1;
+    u ^= (u ^ q) & c1;
+    v ^= (v ^ r) & c1;
+    g = (g + x) >> 1;
+    q += y;
+    r += z;
+    u <<= 1;
+    v <<= 1;
+    delta = (delta ^ (int64_t) c1) - (int64_t) c1 + 1;
+  }
+  t->u = (int64_t) u;
+  t->v = (int64_t) v;
+  t->q = (int64_t) q;
+  t->r = (int64_t) r;
+  return delta;
+}
+
+// divsteps_62() with data-dependent shortcuts: each branch cancels several
+// low bits of g at once.
+static int64_t divsteps_62_var(int64_t delta, uint64_t f, uint64_t g,
+                               divstep_t *t) {
+  uint64_t u = 1, v = 0, q = 0, r = 1, m, w, x;
+  int i = 62, limit, zeros;
+  for (;;) {
+    // Even g: halve it up to i times, with a sentinel bit to stop there.
+    zeros = __builtin_ctzll(g | (~(uint64_t) 0 << i));
+    g >>= zeros;
+    u <<= zeros;
+    v <<= zeros;
+    delta += zeros;
+    i -= zeros;
+    if (!i) break;
+    // Odd g. Replace (f, g) by (g, -f) if delta > 0, then add the multiple
+    // w of f to g that clears as many low bits as delta and i allow: up to
+    // 6 after a swap, when delta is larger, otherwise up to 4.
+    if (delta > 0) {
+      delta = -delta;
+      x = f; f = g; g = -x;
+      x = u; u = q; q = -x;
+      x = v; v = r; r = -x;
+      limit = 1 - delta > i ? i : 1 - (int) delta;
+      m = (~(uint64_t) 0 >> (64 - limit)) & 63;
+      w = (f * g * (f * f - 2)) & m;
+    } else {
+      limit = 1 - delta > i ? i : 1 - (int) delta;
+      m = (~(uint64_t) 0 >> (64 - limit)) & 15;
+      w = f + (((f + 1) & 4) << 1);
+      w = (-w * g) & m;
+    }
+    g += f * w;
+    q += u * w;
+    r += v * w;
+  }
+  t->u = (int64_t) u;
+  t->v = (int64_t) v;
+  t->q = (int64_t) q;
+  t->r = (int64_t) r;
+  return delta;
+}
+
+// (f, g) = t (f, g) / 2^62, exact by construction of t.
+static void update_fg(int64_t *f, int64_t *g, const divstep_t *t, int n) {
+  __int128 cf, cg;
+  int i;
+  cf = (__int128) t->u * f[0] + (__int128) t->v * g[0];
+  cg = (__int128) t->q * f[0] + (__int128) t->r * g[0];
+  cf >>= 62;
+  cg >>= 62;
+  for (i = 1; i < n; i++) {
+    cf += (__int128) t->u * f[i] + (__int128) t->v * g[i];
+    cg += (__int128) t->q * f[i] + (__int128) t->r * g[i];
+    f[i - 1] = (int64_t) ((uint64_t) cf & M62);
+    g[i - 1] = (int64_t) ((uint64_t) cg & M62);
+    cf >>= 62;
+    cg >>= 62;
+  }
+  f[n - 1] = (int64_t) cf;
+  g[n - 1] = (int64_t) cg;
+}
+
+// (d, e) = t (d, e) / 2^62 mod p, adding multiples of p to make the
+// division exact. Keeps d and e in (-2p, p).
+static void update_de(int64_t *d, int64_t *e, const divstep_t *t, fptr p) {
+  const int64_t *m = p->p62;
+  int n = p->n62, i;
+  int64_t sd = d[n - 1] >> 63, se = e[n - 1] >> 63;
+  int64_t md = (t->u & sd) + (t->v & se);
+  int64_t me = (t->q & sd) + (t->r & se);
+  __int128 cd, ce;
+  cd = (__int128) t->u * d[0] + (__int128) t->v * e[0];
+  ce = (__int128) t->q * d[0] + (__int128) t->r * e[0];
+  md -= (int64_t) ((p->pinv62 * (uint64_t) cd + (uint64_t) md) & M62);
+  me -= (int64_t) ((p->pinv62 * (uint64_t) ce + (uint64_t) me) & M62);
+  cd += (__int128) m[0] * md;
+  ce += (__int128) m[0] * me;
+  cd >>= 62;
+  ce >>= 62;
+  for (i = 1; i < n; i++) {
+    cd += (__int128) t->u * d[i] + (__int128) t->v * e[i] +
+          (__int128) m[i] * md;
+    ce += (__int128) t->q * d[i] + (__int128) t->r * e[i] +
+          (__int128) m[i] * me;
+    d[i - 1] = (int64_t) ((uint64_t) cd & M62);
+    e[i - 1] = (int64_t) ((uint64_t) ce & M62);
+    cd >>= 62;
+    ce >>= 62;
+  }
+  d[n - 1] = (int64_t) cd;
+  e[n - 1] = (int64_t) ce;
+}
+
+// Adds p to d if mask is all ones, then propagates the carries.
+static void s62_add_p(int64_t *d, int64_t mask, fptr p) {
+  int i;
+  for (i = 0; i < p->n62; i++) d[i] += p->p62[i] & mask;
+  for (i = 0; i + 1 < p->n62; i++) {
+    d[i + 1] += d[i] >> 62;
+    d[i] &= (int64_t) M62;
+  }
+}
+
+// Negates d if mask is all ones.
+static void s62_cond_neg(int64_t *d, int64_t mask, int n) {
+  int i;
+  for (i = 0; i < n; i++) d[i] = (d[i] ^ mask) - mask;
+  for (i = 0; i + 1 < n; i++) {
+    d[i + 1] += d[i] >> 62;
+    d[i] &= (int64_t) M62;
+  }
+}
+
+// x = a^-1 mod p for 0 < a < p, and x = 0 for a = 0. With ct set, in
+// constant time.
+static void safegcd_invert(mp_limb_t *x, const mp_limb_t *a, fptr p,
+                           int ct) {
+  int n = p->n62, len = n, i;
+  int64_t d[n], e[n], f[n], g[n];
+  int64_t delta = 1, fn, gn, any;
+  divstep_t t;
+
+  memset(d, 0, sizeof(d));
+  memset(e, 0, sizeof(e));
+  e[0] = 1;
+  memcpy(f, p->p62, sizeof(f));
+  limbs_to_s62(g, a, p->limbs, n);
+  if (ct) {
+    for (i = 0; i < p->rounds; i++) {
+      delta = divsteps_62(delta, (uint64_t) f[0], (uint64_t) g[0], &t);
+      update_de(d, e, &t, p);
+      update_fg(f, g, &t, n);
+    }
+  } else {
+    for (;;) {
+      delta = divsteps_62_var(delta, (uint64_t) f[0], (uint64_t) g[0], &t);
+      update_de(d, e, &t, p);
+      update_fg(f, g, &t, len);
+      for (any = 0, i = 0; i < len; i++) any |= g[i];
+      if (!any) break;
+      // Drop the top limbs of f and g once both only hold their sign,
+      // moving it into the limb below.
+      fn = f[len - 1];
+      gn = g[len - 1];
+      if (len > 1 && !(fn ^ (fn >> 63)) && !(gn ^ (gn >> 63))) {
+        f[len - 2] |= (int64_t) ((uint64_t) fn << 62);
+        g[len - 2] |= (int64_t) ((uint64_t) gn << 62);
+        len--;
+      }
+    }
+  }
+  // Now g = 0 and f = +-1, so f d = a^-1 with d in (-2p, p).
+  s62_add_p(d, d[n - 1] >> 63, p);
+  s62_cond_neg(d, f[len - 1] >> 63, n);
+  s62_add_p(d, d[n - 1] >> 63, p);
+  s62_to_limbs(x, p->limbs, d, n);
+}
+
+static void safegcd_init(fptr p, mpz_t prime) {
+  size_t bits = mpz_sizeinbase(prime, 2);
+  // Theorem 11.2 of Bernstein and Yang bounds the divsteps for inputs
+  // of the given size.
+  size_t steps = bits < 46 ? (49 * bits + 80 + 16) / 17
+                           : (49 * bits + 57 + 16) / 17;
+  // Room for the sign and for values up to 2p in magnitude.
+  p->n62 = bits / 62 + 1;
+  p->rounds = (steps + 61) / 62;
+  p->p62 = pbc_malloc(p->n62 * sizeof(int64_t));
+  limbs_to_s62(p->p62, p->primelimbs, p->limbs, p->n62);
+  p->pinv62 = -p->negpinv & M62;
+}
+#endif
+
 // Inversion is slower than in a naive Fp implementation because of an extra
 // multiplication.
 // Requires nonzero a.
@@ -401,6 +929,10 @@ static void fp_invert(element_ptr c, element_ptr a) {
   eptr cd = c->data;
   fptr p = a->field->data;
   mp_limb_t tmp[p->limbs];
+#ifdef MONT_SAFEGCD
+  // a R -> a^-1 R^-1 with no allocation.
+  safegcd_invert(tmp, ad->d, p, 0);
+#else
   mpz_t z;
 
   mpz_init(z);
@@ -410,27 +942,32 @@ static void fp_invert(element_ptr c, element_ptr a) {
   mpz_import(z, p->limbs, -1, sizeof(mp_limb_t), 0, 0, ad->d);
   mpz_invert(z, z, a->field->order);
   set_limbs(tmp, z, p->limbs);
+  mpz_clear(z);
+#endif
 
   // Normalize.
   mont_mul(cd->d, tmp, p->R3, p);
   cd->flag = 2;
-  mpz_clear(z);
 }
 
-static void fp_random(element_ptr a) {
-  fptr p = a->field->data;
+#ifdef MONT_SAFEGCD
+static void fp_invert_ct(element_ptr c, element_ptr a) {
   eptr ad = a->data;
+  eptr cd = c->data;
+  fptr p = a->field->data;
+  mp_limb_t tmp[p->limbs];
+
+  safegcd_invert(tmp, ad->d, p, 1);
+  mont_mul(cd->d, tmp, p->R3, p);
+  cd->flag = 2;
+}
+#endif
+
+static void fp_random(element_ptr a) {
   mpz_t z;
   mpz_init(z);
   pbc_mpz_random(z, a->field->order);
-  if (mpz_sgn(z)) {
-    mpz_mul_2exp(z, z, p->bytes * 8);
-    mpz_mod(z, z, a->field->order);
-    set_limbs(ad->d, z, p->limbs);
-    ad->flag = 2;
-  } else {
-    ad->flag = 0;
-  }
+  fp_set_mpz(a, z);
   mpz_clear(z);
 }
 
@@ -443,6 +980,22 @@ static void fp_from_hash(element_ptr a, void *data, int len) {
   mpz_clear(z);
 }
 
+static void fp_from_bytes_mod(element_ptr a, unsigned char *data, int len) {
+  fptr p = a->field->data;
+  mp_limb_t y[2 * p->limbs];
+  mpz_t z;
+
+  if ((size_t) len <= 2 * p->bytes) {
+    set_wide_bytes(y, data, len, p);
+    set_wide(a, y);
+    return;
+  }
+  mpz_init(z);
+  mpz_import(z, len, 1, 1, 1, 0, data);
+  fp_set_mpz(a, z);
+  mpz_clear(z);
+}
+
 static int fp_cmp(element_ptr a, element_ptr b) {
   eptr ad = a->data, bd = b->data;
   if (!ad->flag) return bd->flag;
@@ -493,22 +1046,11 @@ static int fp_to_bytes(unsigned char *data, element_t a) {
 
 static int fp_from_bytes(element_t a, unsigned char *data) {
   fptr p = a->field->data;
-  eptr ad = a->data;
-  int n;
-  mpz_t z;
-
-  mpz_init(z);
+  mp_limb_t y[2 * p->limbs];
+  int n = a->field->fixed_length_in_bytes;
 
-  n = a->field->fixed_length_in_bytes;
-  mpz_import(z, n, 1, 1, 1, 0, data);
-  if (!mpz_sgn(z)) ad->flag = 0;
-  else {
-    ad->flag = 2;
-    mpz_mul_2exp(z, z, p->bytes * 8);
-    mpz_mod(z, z, a->field->order);
-    set_limbs(ad->d, z, p->limbs);
-  }
-  mpz_clear(z);
+  set_wide_bytes(y, data, n, p);
+  set_wide(a, y);
   return n;
 }
 
@@ -517,13 +1059,103 @@ static void fp_field_clear(field_t f) {
   pbc_free(p->primelimbs);
   pbc_free(p->R);
   pbc_free(p->R3);
+  pbc_free(p->ifma);
+#ifdef MONT_SAFEGCD
+  pbc_free(p->p62);
+#endif
   pbc_free(p);
 }
 
+#if MONT_DIRECT_LIMBS
+const mp_limb_t mont_direct_zero[MONT_DIRECT_LIMBS] = { 0 };
+
+const mp_limb_t *mont_direct_modulus(field_ptr f) {
+  fptr p = f->data;
+  if (f->field_clear != fp_field_clear || p->limbs != MONT_DIRECT_LIMBS) {
+    return NULL;
+  }
+  return p->primelimbs;
+}
+
+void mont_direct_mul(mp_limb_t *c, const mp_limb_t *a, const mp_limb_t *b,
+                     field_ptr f) {
+  fptr p = f->data;
+#ifdef MONT_ASM
+  if (p->adx) {
+    fixed_mont_mul_adx(c, a, b, p->primelimbs, p->negpinv, MONT_DIRECT_LIMBS);
+    return;
+  }
+#endif
+  mont_mul(c, (mp_limb_t *) a, (mp_limb_t *) b, p);
+}
+
+void mont_direct_mul_wide(mp_limb_t *w, const mp_limb_t *a,
+                          const mp_limb_t *b, field_ptr f) {
+#ifdef MONT_ASM
+  fptr p = f->data;
+  if (p->adx) {
+    // Row i leaves z[i + n + 1] zero, so adx_row() carries no further.
+    mp_limb_t z[2 * MONT_DIRECT_LIMBS + 1];
+    int i;
+    for (i = 0; i < 2 * MONT_DIRECT_LIMBS + 1; i++) z[i] = 0;
+    for (i = 0; i < MONT_DIRECT_LIMBS; i++) {
+      adx_row(z + i, b, a[i], MONT_DIRECT_LIMBS);
+    }
+    memcpy(w, z, 2 * MONT_DIRECT_LIMBS * sizeof(mp_limb_t));
+    return;
+  }
+#else
+  UNUSED_VAR(f);
+#endif
+  mpn_mul_n(w, a, b, MONT_DIRECT_LIMBS);
+}
+
+// The rows of the reduction clear the lower half of w as they would in
+// a product, with zeros above it, and the upper half is added at the
+// end: the sum is (w + m p) / R < 2p.
+void mont_direct_redc(mp_limb_t *c, const mp_limb_t *w, field_ptr f) {
+  fptr p = f->data;
+#ifdef MONT_ASM
+  if (p->adx) {
+    fixed_redc_adx(c, w, p->primelimbs, p->negpinv, MONT_DIRECT_LIMBS);
+    return;
+  }
+#endif
+  mont_redc(c, w, p);
+}
+
+// At this size mpn_sqr() beats the mulx rows of mont_direct_mul_wide(),
+// but a square reduced on its own does not beat the fused
+// fixed_mont_mul_adx(): squares pay where their reduction is shared.
+void mont_direct_sqr_wide(mp_limb_t *w, const mp_limb_t *a, field_ptr f) {
+  UNUSED_VAR(f);
+  mpn_sqr(w, a, MONT_DIRECT_LIMBS);
+}
+
+// Each product is below p R but their sum may not be, as 2p can exceed
+// R; then p R comes off it.
+void mont_direct_mul2_add(mp_limb_t *c, const mp_limb_t *a,
+                          const mp_limb_t *b, const mp_limb_t *x,
+                          const mp_limb_t *y, field_ptr f) {
+  fptr p = f->data;
+  mp_limb_t w[2 * MONT_DIRECT_LIMBS], v[2 * MONT_DIRECT_LIMBS];
+  mont_direct_mul_wide(w, a, b, f);
+  mont_direct_mul_wide(v, x, y, f);
+  if (fixed_add(w, w, v, 2 * MONT_DIRECT_LIMBS) ||
+      fixed_cmp(w + MONT_DIRECT_LIMBS, p->primelimbs, MONT_DIRECT_LIMBS) >= 0) {
+    fixed_sub(w + MONT_DIRECT_LIMBS, w + MONT_DIRECT_LIMBS, p->primelimbs,
+              MONT_DIRECT_LIMBS);
+  }
+  mont_direct_redc(c, w, f);
+}
+#endif
+
 // The only public functions. All the above should be static.
 
 static void fp_out_info(FILE * out, field_ptr f) {
-  element_fprintf(out, "GF(%Zd): Montgomery representation", f->order);
+  fptr p = f->data;
+  element_fprintf(out, "GF(%Zd): Montgomery representation, %s multiplication%s",
+                  f->order, p->kernel, p->ifma ? ", AVX-512 IFMA batches" : "");
 }
 
 void field_init_mont_fp(field_ptr f, mpz_t prime) {
@@ -532,6 +1164,7 @@ void field_init_mont_fp(field_ptr f, mpz_t prime) {
   field_init(f);
   f->init = fp_init;
   f->clear = fp_clear;
+  f->init_packed = fp_init_packed;
   f->set_si = fp_set_si;
   f->set_mpz = fp_set_mpz;
   f->out_str = fp_out_str;
@@ -540,6 +1173,7 @@ void field_init_mont_fp(field_ptr f, mpz_t prime) {
   f->add = fp_add;
   f->sub = fp_sub;
   f->set = fp_set;
+  f->cmov = fp_cmov;
   f->mul = fp_mul;
   f->doub = fp_double;
   f->halve = fp_halve;
@@ -548,12 +1182,17 @@ void field_init_mont_fp(field_ptr f, mpz_t prime) {
   f->sign = fp_sgn_odd;
   f->cmp = fp_cmp;
   f->invert = fp_invert;
+#ifdef MONT_SAFEGCD
+  f->invert_ct = fp_invert_ct;
+#endif
   f->random = fp_random;
   f->from_hash = fp_from_hash;
+  f->from_bytes_mod = fp_from_bytes_mod;
   f->is1 = fp_is1;
   f->is0 = fp_is0;
   f->set0 = fp_set0;
   f->set1 = fp_set1;
+  f->wipe = fp_wipe;
   f->is_sqr = fp_is_sqr;
   f->sqrt = element_tonelli;
   f->field_clear = fp_field_clear;
@@ -568,6 +1207,7 @@ void field_init_mont_fp(field_ptr f, mpz_t prime) {
   p->bytes = p->limbs * sizeof(mp_limb_t);
   p->primelimbs = pbc_malloc(p->bytes);
   mpz_export(p->primelimbs, &p->limbs, -1, sizeof(mp_limb_t), 0, 0, prime);
+  f->packed_size = sizeof(*((eptr) 0)) + p->bytes;
 
   mpz_set(f->order, prime);
   f->fixed_length_in_bytes = (mpz_sizeinbase(prime, 2) + 7) / 8;
@@ -593,4 +1233,22 @@ void field_init_mont_fp(field_ptr f, mpz_t prime) {
   mpz_invert(z, prime, z);
   p->negpinv = -mpz_get_ui(z);
   mpz_clear(z);
+#ifdef MONT_SAFEGCD
+  safegcd_init(p, prime);
+#endif
+
+  p->kernel = "mpn";
+  p->adx = 0;
+#ifdef MONT_FIXED
+  fixed_init(f, p->limbs);
+#endif
+  if (f->mul == fp_mul && p->limbs >= MONT_SQR_MIN) f->square = fp_square;
+
+  p->ifma = NULL;
+  // At 2 limbs the scalar routines win.
+  if (p->limbs >= 3 && p->limbs <= IFMA_MAX_LIMBS && mont_ifma_available()) {
+    p->ifma = pbc_malloc(sizeof(*p->ifma));
+    mont_ifma_init(p->ifma, p->primelimbs, p->limbs, p->negpinv);
+    f->multi_mul = fp_multi_mul;
+  }
 }
@@ -0,0 +1,348 @@
+// Montgomery F_p internals shared by montfp.c and the direct paths of
+// curve.c and fieldquadratic.c.
+
+// Requires:
+// * stdint.h
+// * gmp.h
+// * pbc_field.h
+#ifndef __PBC_MONTFP_H__
+#define __PBC_MONTFP_H__
+
+#pragma GCC visibility push(hidden)
+
+// Per-element data.
+struct mont_elem_s {
+  char flag;     // flag == 0 means the element is zero.
+  mp_limb_t *d;  // Otherwise d points to an array holding the element.
+};
+
+// Fixed-width arithmetic.
+//
+// For moduli of 2 to MONT_FIXED_MAX limbs, field_init_mont_fp
+// installs add, sub, double, neg and mul compiled for that limb count.
+// On x86-64 additions are unrolled add/adc chains, and when
+// pbc_cpu_features() reports BMI2 and ADX multiplication runs mulx with
+// two carry chains (adcx and adox). Elsewhere multiplication of up to
+// MONT_FIXED_C_MAX limbs uses unrolled double-width products; beyond that
+// GMP's mpn_addmul_1 is faster.
+//
+// Squaring is GMP's mpn_sqr(), which forms each cross product once,
+// followed by a separate reduction. It is installed from MONT_SQR_MIN
+// limbs where multiplication is the mpn one; the unrolled and mulx
+// multiplications interleave their reduction with the product and are as
+// fast as a square at every size they cover.
+#define MONT_SQR_MIN 9
+
+#if GMP_NAIL_BITS == 0 && GMP_LIMB_BITS == 64 && defined(__SIZEOF_INT128__)
+typedef unsigned __int128 dlimb_t;
+#define MONT_FIXED
+#elif GMP_NAIL_BITS == 0 && GMP_LIMB_BITS == 32
+typedef uint64_t dlimb_t;
+#define MONT_FIXED
+#endif
+
+#ifdef MONT_FIXED
+#define MONT_FIXED_MAX 16
+#define MONT_FIXED_C_MAX 4
+
+// The asm takes limb counts as constants, which needs inlining.
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__OPTIMIZE__) && \
+    GMP_LIMB_BITS == 64
+#define MONT_ASM
+#endif
+
+#if defined(__GNUC__)
+#define FIXED_INLINE static inline __attribute__((always_inline))
+#else
+#define FIXED_INLINE static inline
+#endif
+
+#ifdef MONT_ASM
+// Limb-by-limb add or sub with carry, unrolled by the assembler; leaves
+// the carry or borrow as -t.
+#define ADDSUB_ASM(op, opc) \
+    "movq (%[a]), %[t]\n\t" \
+    op "q (%[b]), %[t]\n\t" \
+    "movq %[t], (%[c])\n\t" \
+    ".set .Lmont_j, 1\n\t" \
+    ".rept %c[n] - 1\n\t" \
+    "movq 8*.Lmont_j(%[a]), %[t]\n\t" \
+    opc "q 8*.Lmont_j(%[b]), %[t]\n\t" \
+    "movq %[t], 8*.Lmont_j(%[c])\n\t" \
+    ".set .Lmont_j, .Lmont_j + 1\n\t" \
+    ".endr\n\t" \
+    "sbbq %[t], %[t]"
+#endif
+
+// c = a + b, returns the carry. n must be a constant.
+FIXED_INLINE mp_limb_t fixed_add(mp_limb_t *c, const mp_limb_t *a,
+                                 const mp_limb_t *b, const size_t n) {
+#ifdef MONT_ASM
+  mp_limb_t t;
+  __asm__ volatile(ADDSUB_ASM("add", "adc")
+      : [t] "=&r" (t)
+      : [c] "r" (c), [a] "r" (a), [b] "r" (b), [n] "i" (n)
+      : "cc", "memory");
+  return -t;
+#else
+  return mpn_add_n(c, a, b, n);
+#endif
+}
+
+// c = a - b, returns the borrow. n must be a constant.
+FIXED_INLINE mp_limb_t fixed_sub(mp_limb_t *c, const mp_limb_t *a,
+                                 const mp_limb_t *b, const size_t n) {
+#ifdef MONT_ASM
+  mp_limb_t t;
+  __asm__ volatile(ADDSUB_ASM("sub", "sbb")
+      : [t] "=&r" (t)
+      : [c] "r" (c), [a] "r" (a), [b] "r" (b), [n] "i" (n)
+      : "cc", "memory");
+  return -t;
+#else
+  return mpn_sub_n(c, a, b, n);
+#endif
+}
+
+FIXED_INLINE int fixed_cmp(const mp_limb_t *a, const mp_limb_t *b,
+                           const size_t n) {
+  size_t i = n;
+  while (i--) if (a[i] != b[i]) return a[i] > b[i] ? 1 : -1;
+  return 0;
+}
+
+// c = a + b mod p for nonzero a, b < p. Returns the element flag.
+FIXED_INLINE char fixed_add_mod(mp_limb_t *c, const mp_limb_t *a,
+                                const mp_limb_t *b, const mp_limb_t *p,
+                                const size_t n) {
+  int i;
+  if (fixed_add(c, a, b, n)) {
+    // As in fp_add, a carry means the result is not zero.
+    fixed_sub(c, c, p, n);
+    return 2;
+  }
+  i = fixed_cmp(c, p, n);
+  if (!i) return 0;
+  if (i > 0) fixed_sub(c, c, p, n);
+  return 2;
+}
+
+// c = a - b mod p for a, b < p. Returns the element flag.
+FIXED_INLINE char fixed_sub_mod(mp_limb_t *c, const mp_limb_t *a,
+                                const mp_limb_t *b, const mp_limb_t *p,
+                                const size_t n) {
+  // Compare the inputs rather than test the result for zero: reading
+  // back limbs just stored one at a time stalls if vectorized.
+  int i = fixed_cmp(a, b, n);
+  if (!i) return 0;
+  fixed_sub(c, a, b, n);
+  if (i < 0) fixed_add(c, c, p, n);
+  return 2;
+}
+
+// c = z mod p, where z has n + 1 limbs and is less than 2p.
+FIXED_INLINE void fixed_reduce(mp_limb_t *c, const mp_limb_t *z,
+                               const mp_limb_t *p, const size_t n) {
+  size_t i;
+  if (z[n] || fixed_cmp(z, p, n) >= 0) fixed_sub(c, z, p, n);
+  else for (i = 0; i < n; i++) c[i] = z[i];
+}
+
+// Montgomery multiplication, coarsely integrated operand scanning:
+// each row adds a[i] b, then a multiple of p that clears the low limb,
+// and shifts down one limb.
+FIXED_INLINE void fixed_mont_mul(mp_limb_t *c, const mp_limb_t *a,
+                                 const mp_limb_t *b, const mp_limb_t *p,
+                                 mp_limb_t negpinv, const size_t n) {
+  mp_limb_t z[MONT_FIXED_MAX + 2];
+  size_t i, j;
+  for (j = 0; j < n + 2; j++) z[j] = 0;
+  for (i = 0; i < n; i++) {
+    mp_limb_t carry = 0, u;
+    dlimb_t t;
+    for (j = 0; j < n; j++) {
+      t = (dlimb_t) a[i] * b[j] + z[j] + carry;
+      z[j] = (mp_limb_t) t;
+      carry = (mp_limb_t) (t >> GMP_LIMB_BITS);
+    }
+    t = (dlimb_t) z[n] + carry;
+    z[n] = (mp_limb_t) t;
+    z[n + 1] = (mp_limb_t) (t >> GMP_LIMB_BITS);
+
+    u = z[0] * negpinv;
+    t = (dlimb_t) u * p[0] + z[0];
+    carry = (mp_limb_t) (t >> GMP_LIMB_BITS);
+    for (j = 1; j < n; j++) {
+      t = (dlimb_t) u * p[j] + z[j] + carry;
+      z[j - 1] = (mp_limb_t) t;
+      carry = (mp_limb_t) (t >> GMP_LIMB_BITS);
+    }
+    t = (dlimb_t) z[n] + carry;
+    z[n - 1] = (mp_limb_t) t;
+    z[n] = z[n + 1] + (mp_limb_t) (t >> GMP_LIMB_BITS);
+  }
+  fixed_reduce(c, z, p, n);
+}
+
+#ifdef MONT_ASM
+
+// z[0..n+1] += x s[0..n-1]. The low halves of the products carry through
+// CF (adcx) and the high halves through OF (adox), so both chains run at
+// once; mov and mulx leave the flags alone. n must be a constant.
+FIXED_INLINE void adx_row(mp_limb_t *z, const mp_limb_t *s, mp_limb_t x,
+                          const size_t n) {
+  mp_limb_t lo, hi, hp;
+  __asm__ volatile(
+      "xorl %k[hp], %k[hp]\n\t"
+      ".set .Lmont_j, 0\n\t"
+      ".rept %c[n]\n\t"
+      "mulxq 8*.Lmont_j(%[s]), %[lo], %[hi]\n\t"
+      "adcxq 8*.Lmont_j(%[z]), %[lo]\n\t"
+      "adoxq %[hp], %[lo]\n\t"
+      "movq %[lo], 8*.Lmont_j(%[z])\n\t"
+      "movq %[hi], %[hp]\n\t"
+      ".set .Lmont_j, .Lmont_j + 1\n\t"
+      ".endr\n\t"
+      "movl $0, %k[hi]\n\t"
+      "movq 8*%c[n](%[z]), %[lo]\n\t"
+      "adcxq %[hi], %[lo]\n\t"
+      "adoxq %[hp], %[lo]\n\t"
+      "movq %[lo], 8*%c[n](%[z])\n\t"
+      "movq 8*%c[n]+8(%[z]), %[lo]\n\t"
+      "adcxq %[hi], %[lo]\n\t"
+      "adoxq %[hi], %[lo]\n\t"
+      "movq %[lo], 8*%c[n]+8(%[z])"
+      : [lo] "=&r" (lo), [hi] "=&r" (hi), [hp] "=&r" (hp)
+      : [z] "r" (z), [s] "r" (s), "d" (x), [n] "i" (n)
+      : "cc", "memory");
+}
+
+// Montgomery multiplication with the product and reduction rows in asm;
+// z holds the running sum unshifted, so row i works on z + i. Needs BMI2
+// and ADX.
+FIXED_INLINE void fixed_mont_mul_adx(mp_limb_t *c, const mp_limb_t *a,
+                                     const mp_limb_t *b, const mp_limb_t *p,
+                                     mp_limb_t negpinv, const size_t n) {
+  mp_limb_t z[2 * n + 1];
+  size_t i;
+  for (i = 0; i < 2 * n + 1; i++) z[i] = 0;
+  for (i = 0; i < n; i++) {
+    adx_row(z + i, b, a[i], n);
+    adx_row(z + i, p, z[i] * negpinv, n);
+  }
+  fixed_reduce(c, z + n, p, n);
+}
+
+// Montgomery reduction of a product w < p R on 2n limbs: c = w R^-1 mod p.
+// The rows clear the low half of w as they would in fixed_mont_mul_adx(),
+// with zeros above it where the carries cannot escape, and the upper half
+// is added at the end: the sum is (w + m p) / R < 2p.
+FIXED_INLINE void fixed_redc_adx(mp_limb_t *c, const mp_limb_t *w,
+                                 const mp_limb_t *p, mp_limb_t negpinv,
+                                 const size_t n) {
+  mp_limb_t z[2 * n + 1];
+  size_t i;
+  for (i = 0; i < n; i++) z[i] = w[i];
+  for (; i < 2 * n + 1; i++) z[i] = 0;
+  for (i = 0; i < n; i++) adx_row(z + i, p, z[i] * negpinv, n);
+  z[2 * n] += fixed_add(z + n, z + n, w + n, n);
+  fixed_reduce(c, z + n, p, n);
+}
+#endif
+
+#endif  // MONT_FIXED
+
+// The direct paths of curve.c and fieldquadratic.c run their formulas on
+// the limbs of a Montgomery field of MONT_DIRECT_LIMBS limbs rather than
+// through the field's function pointers: sums are inlined, products are
+// direct calls, and temporaries are limb arrays on the stack. The default
+// is the 512-bit prime of type A pairings; define it as 0 to leave the
+// paths out.
+#ifndef MONT_DIRECT_LIMBS
+#define MONT_DIRECT_LIMBS (512 / GMP_LIMB_BITS)
+#endif
+#if !defined(MONT_FIXED) || MONT_DIRECT_LIMBS > MONT_FIXED_MAX
+#undef MONT_DIRECT_LIMBS
+#define MONT_DIRECT_LIMBS 0
+#endif
+
+#if MONT_DIRECT_LIMBS
+
+// Returns the modulus of f if f is a Montgomery field of
+// MONT_DIRECT_LIMBS limbs, otherwise NULL.
+const mp_limb_t *mont_direct_modulus(field_ptr f);
+
+// c = a b in the field f, which must pass mont_direct_modulus(). c may be
+// a or b.
+void mont_direct_mul(mp_limb_t *c, const mp_limb_t *a, const mp_limb_t *b,
+                     field_ptr f);
+
+// Lazy reduction: sums of products are formed on the 2 MONT_DIRECT_LIMBS
+// limbs of the unreduced products and reduced once.
+
+// w = a b without reduction, 2 MONT_DIRECT_LIMBS limbs. w may not be a
+// or b.
+void mont_direct_mul_wide(mp_limb_t *w, const mp_limb_t *a,
+                          const mp_limb_t *b, field_ptr f);
+
+// w = a^2 without reduction, 2 MONT_DIRECT_LIMBS limbs. w may not be a.
+void mont_direct_sqr_wide(mp_limb_t *w, const mp_limb_t *a, field_ptr f);
+
+// c = w R^-1 mod p for w < p R, where w has 2 MONT_DIRECT_LIMBS limbs.
+void mont_direct_redc(mp_limb_t *c, const mp_limb_t *w, field_ptr f);
+
+// c = a b + x y with a single reduction. c may be any of the operands.
+void mont_direct_mul2_add(mp_limb_t *c, const mp_limb_t *a,
+                          const mp_limb_t *b, const mp_limb_t *x,
+                          const mp_limb_t *y, field_ptr f);
+
+extern const mp_limb_t mont_direct_zero[MONT_DIRECT_LIMBS];
+
+// The limbs of e, all zero when e is.
+static inline const mp_limb_t *mont_direct_get(element_ptr e) {
+  struct mont_elem_s *ep = e->data;
+  return ep->flag ? ep->d : mont_direct_zero;
+}
+
+FIXED_INLINE int mont_direct_is0(const mp_limb_t *a) {
+  mp_limb_t t = 0;
+  int i;
+  for (i = 0; i < MONT_DIRECT_LIMBS; i++) t |= a[i];
+  return !t;
+}
+
+static inline void mont_direct_set(element_ptr e, const mp_limb_t *d) {
+  struct mont_elem_s *ep = e->data;
+  int i;
+  for (i = 0; i < MONT_DIRECT_LIMBS; i++) ep->d[i] = d[i];
+  ep->flag = mont_direct_is0(d) ? 0 : 2;
+}
+
+// c = a + b mod p for a, b < p.
+FIXED_INLINE void mont_direct_add(mp_limb_t *c, const mp_limb_t *a,
+                                  const mp_limb_t *b, const mp_limb_t *p) {
+  if (fixed_add(c, a, b, MONT_DIRECT_LIMBS) ||
+      fixed_cmp(c, p, MONT_DIRECT_LIMBS) >= 0) {
+    fixed_sub(c, c, p, MONT_DIRECT_LIMBS);
+  }
+}
+
+// c = a - b mod p for a, b < p.
+FIXED_INLINE void mont_direct_sub(mp_limb_t *c, const mp_limb_t *a,
+                                  const mp_limb_t *b, const mp_limb_t *p) {
+  if (fixed_sub(c, a, b, MONT_DIRECT_LIMBS)) {
+    fixed_add(c, c, p, MONT_DIRECT_LIMBS);
+  }
+}
+
+// c = -a mod p for a < p.
+FIXED_INLINE void mont_direct_neg(mp_limb_t *c, const mp_limb_t *a,
+                                  const mp_limb_t *p) {
+  mont_direct_sub(c, mont_direct_zero, a, p);
+}
+
+#endif  // MONT_DIRECT_LIMBS
+
+#pragma GCC visibility pop
+
+#endif //__PBC_MONTFP_H__
@@ -0,0 +1,200 @@
+// Eight-lane Montgomery multiplication with AVX-512 IFMA.
+//
+// Each 64-bit lane of a zmm register holds one digit of a different
+// element, so eight independent products run in one instruction stream.
+// Elements are split into k digits of 52 bits, the width vpmadd52luq and
+// vpmadd52huq multiply, and the digit-serial Montgomery loop divides by
+// 2^(52k). montfp.c stores elements as xR with R = 2^(64t), so the
+// multiplier is first shifted left by 52k - 64t bits: it still fits in k
+// digits, and (a 2^(52k-64t)) b / 2^(52k) = ab / R. The result is less
+// than 2p and one subtraction per lane finishes it.
+//
+// Digits are not normalized between rows. Each position receives at most
+// four 52-bit terms per row, well within 64 bits for IFMA_MAX_DIGITS rows.
+
+#include <stdint.h> // for intptr_t
+#include <gmp.h>
+#include "pbc_utils.h"
+#include "montfp_ifma.h"
+
+#if defined(__x86_64__) && GMP_LIMB_BITS == 64 && GMP_NAIL_BITS == 0 && \
+    (__GNUC__ >= 6 || __clang_major__ >= 4)
+#include <immintrin.h>
+
+#define DIGIT_MASK ((1ULL << 52) - 1)
+
+// Digits of x, where x has t limbs.
+static void to_digits(mp_limb_t *d, const mp_limb_t *x, size_t t, int k) {
+  int i;
+  for (i = 0; i < k; i++) {
+    size_t l = 52 * i / 64;
+    int off = 52 * i % 64;
+    mp_limb_t v = l < t ? x[l] >> off : 0;
+    if (off > 12 && l + 1 < t) v |= x[l + 1] << (64 - off);
+    d[i] = v & DIGIT_MASK;
+  }
+}
+
+void mont_ifma_init(mont_ifma_t *m, const mp_limb_t *primelimbs,
+                    size_t limbs, mp_limb_t negpinv) {
+  m->limbs = limbs;
+  m->digits = (int) (limbs * 64 / 52 + 1);
+  m->ninv = negpinv & DIGIT_MASK;
+  to_digits(m->p, primelimbs, limbs, m->digits);
+}
+
+#define IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+int mont_ifma_available(void) {
+  return (pbc_cpu_features() & PBC_CPU_AVX512IFMA) != 0;
+}
+
+// Splits the t limbs in x, shifted left by s bits, into k digits. With t
+// constant after inlining, every shift is an immediate.
+static inline __attribute__((always_inline)) IFMA_TARGET
+void split(__m512i *d, const __m512i *x, const int t, const int k,
+           const int s) {
+  const __m512i mask = _mm512_set1_epi64(DIGIT_MASK);
+  int i, j;
+  for (i = 0; i < k; i++) {
+    __m512i v = _mm512_setzero_si512();
+    for (j = 0; j < t; j++) {
+      // Position of bit 0 of limb j within digit i.
+      int pos = 64 * j + s - 52 * i;
+      if (pos >= 52 || pos <= -64) continue;
+      v = _mm512_or_si512(v, pos >= 0 ? _mm512_slli_epi64(x[j], pos)
+                                      : _mm512_srli_epi64(x[j], -pos));
+    }
+    d[i] = _mm512_and_si512(v, mask);
+  }
+}
+
+// Inverse of split() with s = 0.
+static inline __attribute__((always_inline)) IFMA_TARGET
+void join(__m512i *x, const __m512i *d, const int t, const int k) {
+  int i, j;
+  for (j = 0; j < t; j++) {
+    __m512i v = _mm512_setzero_si512();
+    for (i = 0; i < k; i++) {
+      // Position of bit 0 of digit i within limb j.
+      int pos = 52 * i - 64 * j;
+      if (pos >= 64 || pos <= -52) continue;
+      v = _mm512_or_si512(v, pos >= 0 ? _mm512_slli_epi64(d[i], pos)
+                                      : _mm512_srli_epi64(d[i], -pos));
+    }
+    x[j] = v;
+  }
+}
+
+// Multiplies up to eight pairs of t-limb elements. z[0..2k] holds the
+// unshifted running sum: row i adds a_i b and u p at z + i, where u
+// clears digit i, and carries digit i into i + 1.
+static inline __attribute__((always_inline)) IFMA_TARGET
+void ifma_mul_t(mp_limb_t **c, mp_limb_t **a, mp_limb_t **b, int lanes,
+                const mont_ifma_t *m, const int t) {
+  const int k = t * 64 / 52 + 1;
+  const __m512i mask = _mm512_set1_epi64(DIGIT_MASK);
+  const __m512i ninv = _mm512_set1_epi64(m->ninv);
+  mp_limb_t buf[2][IFMA_MAX_LIMBS][8] __attribute__((aligned(64)));
+  __m512i x[IFMA_MAX_LIMBS], y[IFMA_MAX_LIMBS];
+  __m512i ad[IFMA_MAX_DIGITS], bd[IFMA_MAX_DIGITS], p[IFMA_MAX_DIGITS];
+  __m512i z[2 * IFMA_MAX_DIGITS + 1];
+  __m512i u, carry;
+  __mmask8 keep;
+  int i, j, l;
+
+  // Transpose, so limb j of lane l is at buf[.][j][l]. Unused lanes
+  // repeat the last element.
+  for (l = 0; l < 8; l++) {
+    int e = l < lanes ? l : lanes - 1;
+    for (j = 0; j < t; j++) {
+      buf[0][j][l] = a[e][j];
+      buf[1][j][l] = b[e][j];
+    }
+  }
+  for (j = 0; j < t; j++) {
+    x[j] = _mm512_load_si512(buf[0][j]);
+    y[j] = _mm512_load_si512(buf[1][j]);
+  }
+  split(ad, x, t, k, 52 * k - 64 * t);
+  split(bd, y, t, k, 0);
+  for (i = 0; i < k; i++) p[i] = _mm512_set1_epi64(m->p[i]);
+
+  for (i = 0; i <= 2 * k; i++) z[i] = _mm512_setzero_si512();
+  for (i = 0; i < k; i++) {
+    for (j = 0; j < k; j++) {
+      z[i + j] = _mm512_madd52lo_epu64(z[i + j], ad[i], bd[j]);
+      z[i + j + 1] = _mm512_madd52hi_epu64(z[i + j + 1], ad[i], bd[j]);
+    }
+    u = _mm512_madd52lo_epu64(_mm512_setzero_si512(), z[i], ninv);
+    for (j = 0; j < k; j++) {
+      z[i + j] = _mm512_madd52lo_epu64(z[i + j], u, p[j]);
+      z[i + j + 1] = _mm512_madd52hi_epu64(z[i + j + 1], u, p[j]);
+    }
+    z[i + 1] = _mm512_add_epi64(z[i + 1], _mm512_srli_epi64(z[i], 52));
+  }
+
+  // Normalize the upper half, which holds the result, into ad, and its
+  // difference with p into bd. Digits are 52 bits, so an arithmetic
+  // shift yields the borrow.
+  carry = _mm512_setzero_si512();
+  u = _mm512_setzero_si512();
+  for (i = 0; i < k; i++) {
+    __m512i v = _mm512_add_epi64(z[k + i], carry);
+    ad[i] = _mm512_and_si512(v, mask);
+    carry = _mm512_srli_epi64(v, 52);
+    v = _mm512_add_epi64(_mm512_sub_epi64(ad[i], p[i]), u);
+    bd[i] = _mm512_and_si512(v, mask);
+    u = _mm512_srai_epi64(v, 52);
+  }
+  // Keep the result where the subtraction borrowed, i.e. it was below p.
+  keep = _mm512_cmpneq_epi64_mask(u, _mm512_setzero_si512());
+  for (i = 0; i < k; i++) ad[i] = _mm512_mask_blend_epi64(keep, bd[i], ad[i]);
+
+  join(x, ad, t, k);
+  for (j = 0; j < t; j++) _mm512_store_si512(buf[0][j], x[j]);
+  for (l = 0; l < lanes; l++) {
+    for (j = 0; j < t; j++) c[l][j] = buf[0][j][l];
+  }
+}
+
+#define IFMA_MUL_CASE(t) \
+    case t: ifma_mul_t(c + i, a + i, b + i, lanes, m, t); break;
+
+// Limb counts up to 8 get unrolled code; larger ones share one loop.
+IFMA_TARGET
+void mont_ifma_mul(mp_limb_t *c[], mp_limb_t *a[], mp_limb_t *b[], int n,
+                   const mont_ifma_t *m) {
+  int i, lanes;
+  for (i = 0; i < n; i += 8) {
+    lanes = n - i < 8 ? n - i : 8;
+    switch (m->limbs) {
+      IFMA_MUL_CASE(2)
+      IFMA_MUL_CASE(3)
+      IFMA_MUL_CASE(4)
+      IFMA_MUL_CASE(5)
+      IFMA_MUL_CASE(6)
+      IFMA_MUL_CASE(7)
+      IFMA_MUL_CASE(8)
+      default: ifma_mul_t(c + i, a + i, b + i, lanes, m, (int) m->limbs);
+    }
+  }
+}
+
+#else
+
+int mont_ifma_available(void) {
+  return 0;
+}
+
+void mont_ifma_init(mont_ifma_t *m, const mp_limb_t *primelimbs,
+                    size_t limbs, mp_limb_t negpinv) {
+  (void) m, (void) primelimbs, (void) limbs, (void) negpinv;
+}
+
+void mont_ifma_mul(mp_limb_t *c[], mp_limb_t *a[], mp_limb_t *b[], int n,
+                   const mont_ifma_t *m) {
+  (void) c, (void) a, (void) b, (void) n, (void) m;
+}
+
+#endif
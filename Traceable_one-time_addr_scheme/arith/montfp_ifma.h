@@ -0,0 +1,40 @@
+// Eight-lane Montgomery multiplication with AVX-512 IFMA, for montfp.c.
+
+// Requires:
+// * gmp.h
+#ifndef __PBC_MONTFP_IFMA_H__
+#define __PBC_MONTFP_IFMA_H__
+
+#pragma GCC visibility push(hidden)
+
+// Lanes are 52-bit digits, so a modulus of up to IFMA_MAX_LIMBS 64-bit
+// limbs needs up to IFMA_MAX_DIGITS of them.
+#define IFMA_MAX_LIMBS 16
+#define IFMA_MAX_DIGITS (IFMA_MAX_LIMBS * 64 / 52 + 1)
+
+// Montgomery constants of one modulus, in 52-bit digits.
+typedef struct {
+  size_t limbs;                // 64-bit limbs t of the modulus
+  int digits;                  // k, the least with 52k > 64t
+  mp_limb_t ninv;              // -p^-1 mod 2^52
+  mp_limb_t p[IFMA_MAX_DIGITS];
+} mont_ifma_t;
+
+// Returns nonzero if pbc_cpu_features() reports AVX-512 IFMA. Always 0
+// when the compiler cannot target it.
+int mont_ifma_available(void);
+
+// Sets up the constants for an odd modulus of 2 to IFMA_MAX_LIMBS limbs.
+// negpinv is -p^-1 mod 2^64 as in montfp.c.
+void mont_ifma_init(mont_ifma_t *m, const mp_limb_t *primelimbs,
+                    size_t limbs, mp_limb_t negpinv);
+
+// c[i] = a[i] b[i] / 2^(64t) mod p for i < n, with a[i], b[i] < p. Each
+// group of eight lanes reads all its inputs before writing, so c[i] may
+// be a[i] or b[i].
+void mont_ifma_mul(mp_limb_t *c[], mp_limb_t *a[], mp_limb_t *b[], int n,
+                   const mont_ifma_t *m);
+
+#pragma GCC visibility pop
+
+#endif //__PBC_MONTFP_IFMA_H__
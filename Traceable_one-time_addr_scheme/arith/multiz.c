@@ -3,12 +3,18 @@
 // (1 + 2y) + 3 x + (4 + (5 + 6z)y)x^2
 // Convenient interchange format for different groups, rings, and fields.
 
+// A multinomial is stored flat: its nodes lie in one array in preorder,
+// each list followed by its items, so copying or freeing one is a single
+// allocation and a walk over the array rather than over a tree of darrays.
+// A multiz points to a node; only the first node of an array owns it.
+
 // TODO: Canonicalize, e.g. [[1]], 0, 0] --> 1.
 
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h> // for intptr_t
 #include <stdlib.h>
+#include <string.h>
 #include <gmp.h>
 #include "pbc_utils.h"
 #include "pbc_field.h"
@@ -16,15 +22,17 @@
 #include "pbc_random.h"
 #include "pbc_fp.h"
 #include "pbc_memory.h"
-#include "misc/darray.h"
 
-// Per-element data.
+// Per-node data.
 struct multiz_s {
-  // Either it's an mpz, or a list of mpzs.
+  // Either it's an mpz, or a list.
   char type;
+  // Number of nodes in the subtree rooted here, this one included.
+  int size;
   union {
     mpz_t z;
-    darray_t a;
+    // Number of items in a list.
+    int count;
   };
 };
 
@@ -33,21 +41,101 @@ enum {
   T_ARR,
 };
 
+// Item following x in its list.
+static inline multiz multiz_next(multiz x) {
+  return x + x->size;
+}
+
+// Item i of list x.
+static multiz multiz_item(multiz x, int i) {
+  multiz y = x + 1;
+  while (i--) y = multiz_next(y);
+  return y;
+}
+
+// Constant term: the first integer in x.
+static multiz multiz_first(multiz x) {
+  while (T_ARR == x->type) x++;
+  return x;
+}
+
+// Leading coefficient: the integer found by taking last items.
+static multiz multiz_lead(multiz x) {
+  while (T_ARR == x->type) x = multiz_item(x, x->count - 1);
+  return x;
+}
+
+// Growable array that a multinomial is built in. Nodes are referred to by
+// index as the array may move.
+struct mzbuf_s {
+  multiz node;
+  int len, max;
+};
+typedef struct mzbuf_s mzbuf_t[1];
+typedef struct mzbuf_s *mzbuf_ptr;
+
+static void mzbuf_init(mzbuf_ptr b, int max) {
+  b->node = pbc_malloc(sizeof(*b->node) * max);
+  b->len = 0;
+  b->max = max;
+}
+
+static void mzbuf_reserve(mzbuf_ptr b, int n) {
+  if (b->len + n <= b->max) return;
+  while (b->len + n > b->max) b->max *= 2;
+  b->node = pbc_realloc(b->node, sizeof(*b->node) * b->max);
+}
+
+// Appends a node, an integer 0 or an empty list, and returns its index.
+static int mzbuf_push(mzbuf_ptr b, char type) {
+  mzbuf_reserve(b, 1);
+  multiz x = b->node + b->len;
+  x->type = type;
+  x->size = 1;
+  if (T_MPZ == type) mpz_init(x->z);
+  else x->count = 0;
+  return b->len++;
+}
+
+// Ends the list at index i, whose items are the nodes appended since.
+static void mzbuf_close(mzbuf_ptr b, int i, int count) {
+  b->node[i].count = count;
+  b->node[i].size = b->len - i;
+}
+
+// Appends the multinomial m, taking over its nodes.
+static void mzbuf_take(mzbuf_ptr b, multiz m) {
+  mzbuf_reserve(b, m->size);
+  memcpy(b->node + b->len, m, sizeof(*m) * m->size);
+  b->len += m->size;
+  pbc_free(m);
+}
+
 static multiz multiz_new_empty_list(void) {
   multiz ep = pbc_malloc(sizeof(*ep));
   ep->type = T_ARR;
-  darray_init(ep->a);
+  ep->size = 1;
+  ep->count = 0;
   return ep;
 }
 
+// Takes over the data of e, which must not be cleared afterwards.
 void multiz_append(element_ptr x, element_ptr e) {
   multiz l = x->data;
-  darray_append(l->a, e->data);
+  multiz m = e->data;
+  int n = l->size;
+  l = pbc_realloc(l, sizeof(*l) * (n + m->size));
+  memcpy(l + n, m, sizeof(*m) * m->size);
+  l->count++;
+  l->size += m->size;
+  pbc_free(m);
+  x->data = l;
 }
 
 static multiz multiz_new(void) {
   multiz ep = pbc_malloc(sizeof(*ep));
   ep->type = T_MPZ;
+  ep->size = 1;
   mpz_init(ep->z);
   return ep;
 }
@@ -57,15 +145,9 @@ static void f_init(element_ptr e) {
 }
 
 static void multiz_free(multiz ep) {
-  switch(ep->type) {
-    case T_MPZ:
-      mpz_clear(ep->z);
-      break;
-    default:
-      PBC_ASSERT(T_ARR == ep->type, "no such type");
-      darray_forall(ep->a, (void(*)(void*))multiz_free);
-      darray_clear(ep->a);
-      break;
+  int i;
+  for (i = 0; i < ep->size; i++) {
+    if (T_MPZ == ep[i].type) mpz_clear(ep[i].z);
   }
   pbc_free(ep);
 }
@@ -83,30 +165,31 @@ element_ptr multiz_new_list(element_ptr e) {
   return x;
 }
 
-static void f_set_si(element_ptr e, signed long int op) {
-  multiz_free(e->data);
-  f_init(e);
+// Makes e an integer and returns it, reusing e if it is one already.
+static mpz_ptr f_set_z(element_ptr e) {
   multiz ep = e->data;
-  mpz_set_si(ep->z, op);
+  if (T_MPZ != ep->type) {
+    multiz_free(ep);
+    f_init(e);
+    ep = e->data;
+  }
+  return ep->z;
+}
+
+static void f_set_si(element_ptr e, signed long int op) {
+  mpz_set_si(f_set_z(e), op);
 }
 
 static void f_set_mpz(element_ptr e, mpz_ptr z) {
-  multiz_free(e->data);
-  f_init(e);
-  multiz ep = e->data;
-  mpz_set(ep->z, z);
+  mpz_set(f_set_z(e), z);
 }
 
 static void f_set0(element_ptr e) {
-  multiz_free(e->data);
-  f_init(e);
+  mpz_set_ui(f_set_z(e), 0);
 }
 
 static void f_set1(element_ptr e) {
-  multiz_free(e->data);
-  f_init(e);
-  multiz ep = e->data;
-  mpz_set_ui(ep->z, 1);
+  mpz_set_ui(f_set_z(e), 1);
 }
 
 static size_t multiz_out_str(FILE *stream, int base, multiz ep) {
@@ -117,11 +200,13 @@ static size_t multiz_out_str(FILE *stream, int base, multiz ep) {
       PBC_ASSERT(T_ARR == ep->type, "no such type");
       fputc('[', stream);
       size_t res = 1;
-      int n = darray_count(ep->a);
+      int n = ep->count;
       int i;
+      multiz x = ep + 1;
       for(i = 0; i < n; i++) {
         if (i) res += 2, fputs(", ", stream);
-        res += multiz_out_str(stream, base, darray_at(ep->a, i));
+        res += multiz_out_str(stream, base, x);
+        x = multiz_next(x);
       }
       fputc(']', stream);
       res++;
@@ -134,9 +219,7 @@ static size_t f_out_str(FILE *stream, int base, element_ptr e) {
 }
 
 void multiz_to_mpz(mpz_ptr z, multiz ep) {
-  while(ep->type == T_ARR) ep = darray_at(ep->a, 0);
-  PBC_ASSERT(T_MPZ == ep->type, "no such type");
-  mpz_set(z, ep->z);
+  mpz_set(z, multiz_first(ep)->z);
 }
 
 static void f_to_mpz(mpz_ptr z, element_ptr a) {
@@ -144,50 +227,29 @@ static void f_to_mpz(mpz_ptr z, element_ptr a) {
 }
 
 static int multiz_sgn(multiz ep) {
-  while(ep->type == T_ARR) ep = darray_at(ep->a, 0);
-  PBC_ASSERT(T_MPZ == ep->type, "no such type");
-  return mpz_sgn(ep->z);
+  return mpz_sgn(multiz_first(ep)->z);
 }
 
 static int f_sgn(element_ptr a) {
   return multiz_sgn(a->data);
 }
 
-static void add_to_x(void *data,
-                     multiz x,
-                     void (*fun)(mpz_t, const mpz_t, void *scope_ptr),
-                     void *scope_ptr);
-
+// Copies y with every integer c replaced by fun(c).
 static multiz multiz_new_unary(const multiz y,
     void (*fun)(mpz_t, const mpz_t, void *scope_ptr), void *scope_ptr) {
-  multiz x = pbc_malloc(sizeof(*x));
-  switch(y->type) {
-    case T_MPZ:
-      x->type = T_MPZ;
-      mpz_init(x->z);
-      fun(x->z, y->z, scope_ptr);
-      break;
-    default:
-      PBC_ASSERT(T_ARR == ep->type, "no such type");
-      x->type = T_ARR;
-      darray_init(x->a);
-      darray_forall4(y->a,
-                     (void(*)(void*,void*,void*,void*))add_to_x,
-                     x,
-                     fun,
-                     scope_ptr);
-      break;
+  int n = y->size;
+  int i;
+  multiz x = pbc_malloc(sizeof(*x) * n);
+  memcpy(x, y, sizeof(*x) * n);
+  for (i = 0; i < n; i++) {
+    if (T_MPZ == x[i].type) {
+      mpz_init(x[i].z);
+      fun(x[i].z, y[i].z, scope_ptr);
+    }
   }
   return x;
 }
 
-static void add_to_x(void *data,
-                     multiz x,
-                     void (*fun)(mpz_t, const mpz_t, void *scope_ptr),
-                     void *scope_ptr) {
-  darray_append(x->a, multiz_new_unary(data, fun, scope_ptr));
-}
-
 static void mpzset(mpz_t dst, const mpz_t src, void *scope_ptr) {
   UNUSED_VAR(scope_ptr);
   mpz_set(dst, src);
@@ -197,54 +259,41 @@ static multiz multiz_clone(multiz y) {
   return multiz_new_unary(y, (void(*)(mpz_t, const mpz_t, void *))mpzset, NULL);
 }
 
+// Appends fun(a, b) taken coefficient by coefficient. A NULL operand stands
+// for zero, and an integer facing a list for the list of that one item.
+static void multiz_zip(mzbuf_ptr out, multiz a, multiz b,
+    void (*fun)(mpz_t, const mpz_t, const mpz_t), mpz_ptr zero) {
+  int i, k;
+  if ((!a || T_MPZ == a->type) && (!b || T_MPZ == b->type)) {
+    i = mzbuf_push(out, T_MPZ);
+    fun(out->node[i].z, a ? a->z : zero, b ? b->z : zero);
+    return;
+  }
+  int m = !a ? 0 : T_ARR == a->type ? a->count : 1;
+  int n = !b ? 0 : T_ARR == b->type ? b->count : 1;
+  int max = m > n ? m : n;
+  multiz x = a && T_ARR == a->type ? a + 1 : a;
+  multiz y = b && T_ARR == b->type ? b + 1 : b;
+  i = mzbuf_push(out, T_ARR);
+  for (k = 0; k < max; k++) {
+    multiz_zip(out, k < m ? x : NULL, k < n ? y : NULL, fun, zero);
+    if (k + 1 < m) x = multiz_next(x);
+    if (k + 1 < n) y = multiz_next(y);
+  }
+  mzbuf_close(out, i, max);
+}
+
 static multiz multiz_new_bin(const multiz a, const multiz b,
     void (*fun)(mpz_t, const mpz_t, const mpz_t)) {
-  if (T_MPZ == a->type) {
-    if (T_MPZ == b->type) {
-      multiz x = multiz_new();
-      fun(x->z, a->z, b->z);
-      return x;
-    } else {
-      multiz x = multiz_clone(b);
-      multiz z = x;
-      PBC_ASSERT(T_ARR == z->type, "no such type");
-      while(z->type == T_ARR) z = darray_at(z->a, 0);
-      fun(z->z, a->z, z->z);
-      return x;
-    }
-  } else {
-    PBC_ASSERT(T_ARR == a->type, "no such type");
-    if (T_MPZ == b->type) {
-      multiz x = multiz_clone(a);
-      multiz z = x;
-      PBC_ASSERT(T_ARR == z->type, "no such type");
-      while(z->type == T_ARR) z = darray_at(z->a, 0);
-      fun(z->z, b->z, z->z);
-      return x;
-    } else {
-      PBC_ASSERT(T_ARR == b->type, "no such type");
-      int m = darray_count(a->a);
-      int n = darray_count(b->a);
-      int min = m < n ? m : n;
-      int max = m > n ? m : n;
-      multiz x = multiz_new_empty_list();
-      int i;
-      for(i = 0; i < min; i++) {
-        multiz z = multiz_new_bin(darray_at(a->a, i), darray_at(b->a, i), fun);
-        darray_append(x->a, z);
-      }
-      multiz zero = multiz_new();
-      for(; i < max; i++) {
-        multiz z = multiz_new_bin(m > n ? darray_at(a->a, i) : zero,
-                                  n > m ? darray_at(b->a, i) : zero,
-                                  fun);
-        darray_append(x->a, z);
-      }
-      multiz_free(zero);
-      return x;
-    }
-  }
+  mzbuf_t out;
+  mpz_t zero;
+  mpz_init(zero);
+  mzbuf_init(out, a->size > b->size ? a->size : b->size);
+  multiz_zip(out, a, b, fun, zero);
+  mpz_clear(zero);
+  return out->node;
 }
+
 static multiz multiz_new_add(const multiz a, const multiz b) {
   return multiz_new_bin(a, b, mpz_add);
 }
@@ -268,40 +317,73 @@ static void mpzmul(mpz_t x, const mpz_t y, const mpz_t z) {
   mpz_mul(x, y, z);
 }
 
-static multiz multiz_new_mul(const multiz a, const multiz b) {
-  if (T_MPZ == a->type) {
-    // Multiply each coefficient of b by a->z.
-    return multiz_new_unary(b, (void(*)(mpz_t, const mpz_t, void *))mpzmul, a->z);
-  } else {
-    PBC_ASSERT(T_ARR == a->type, "no such type");
-    if (T_MPZ == b->type) {
-      // Multiply each coefficient of a by b->z.
-      return multiz_new_unary(a, (void(*)(mpz_t, const mpz_t, void *))mpzmul, b->z);
-    } else {
-      PBC_ASSERT(T_ARR == b->type, "no such type");
-      int m = darray_count(a->a);
-      int n = darray_count(b->a);
-      int max = m + n - 1;
-      multiz x = multiz_new_empty_list();
-      int i;
-      multiz zero = multiz_new();
-      for(i = 0; i < max; i++) {
-        multiz z = multiz_new();
-        int j;
-        for (j = 0; j <= i; j++) {
-          multiz y = multiz_new_mul(j < m ? darray_at(a->a, j) : zero,
-                                    i - j < n ? darray_at(b->a, i - j) : zero);
-          multiz t = multiz_new_add(z, y);
-          multiz_free(y);
-          multiz_free(z);
-          z = t;
-        }
-        darray_append(x->a, z);
+// Appends the product of a and b.
+static void multiz_mul_into(mzbuf_ptr out, multiz a, multiz b, mpz_ptr zero) {
+  int i, j, k;
+  if (T_MPZ == a->type || T_MPZ == b->type) {
+    // Multiply each coefficient of one by the other.
+    multiz y = T_MPZ == a->type ? b : a;
+    mpz_ptr c = T_MPZ == a->type ? a->z : b->z;
+    multiz x;
+    mzbuf_reserve(out, y->size);
+    x = out->node + out->len;
+    memcpy(x, y, sizeof(*x) * y->size);
+    for (i = 0; i < y->size; i++) {
+      if (T_MPZ == x[i].type) {
+        mpz_init(x[i].z);
+        mpz_mul(x[i].z, y[i].z, c);
+      }
+    }
+    out->len += y->size;
+    return;
+  }
+  PBC_ASSERT(T_ARR == a->type && T_ARR == b->type, "no such type");
+  int m = a->count;
+  int n = b->count;
+  multiz *item = pbc_malloc(sizeof(multiz) * (m + n));
+  item[0] = a + 1;
+  for (j = 1; j < m; j++) item[j] = multiz_next(item[j - 1]);
+  item[m] = b + 1;
+  for (j = 1; j < n; j++) item[m + j] = multiz_next(item[m + j - 1]);
+  i = mzbuf_push(out, T_ARR);
+  for (k = 0; k < m + n - 1; k++) {
+    int lo = k < n ? 0 : k - n + 1;
+    int hi = k < m ? k : m - 1;
+    if (lo == hi) {
+      multiz_mul_into(out, item[lo], item[m + k - lo], zero);
+      continue;
+    }
+    // Sum the products a_j b_{k-j}.
+    multiz sum = NULL;
+    for (j = lo; j <= hi; j++) {
+      mzbuf_t t;
+      mzbuf_init(t, 8);
+      multiz_mul_into(t, item[j], item[m + k - j], zero);
+      if (sum) {
+        mzbuf_t s;
+        mzbuf_init(s, sum->size > t->len ? sum->size : t->len);
+        multiz_zip(s, sum, t->node, mpz_add, zero);
+        multiz_free(sum);
+        multiz_free(t->node);
+        sum = s->node;
+      } else {
+        sum = t->node;
       }
-      multiz_free(zero);
-      return x;
     }
+    mzbuf_take(out, sum);
   }
+  mzbuf_close(out, i, m + n - 1);
+  pbc_free(item);
+}
+
+static multiz multiz_new_mul(const multiz a, const multiz b) {
+  mzbuf_t out;
+  mpz_t zero;
+  mpz_init(zero);
+  mzbuf_init(out, a->size + b->size);
+  multiz_mul_into(out, a, b, zero);
+  mpz_clear(zero);
+  return out->node;
 }
 static void f_mul(element_ptr n, element_ptr a, element_ptr b) {
   multiz delme = n->data;
@@ -387,7 +469,7 @@ static int f_is0(element_ptr n) {
 static int f_item_count(element_ptr e) {
   multiz z = e->data;
   if (T_MPZ == z->type) return 0;
-  return darray_count(z->a);
+  return z->count;
 }
 
 // TODO: Redesign multiz so this doesn't leak.
@@ -396,7 +478,7 @@ static element_ptr f_item(element_ptr e, int i) {
   if (T_MPZ == z->type) return NULL;
   element_ptr r = malloc(sizeof(*r));
   r->field = e->field;
-  r->data = darray_at(z->a, i);
+  r->data = multiz_item(z, i);
   return r;
 }
 
@@ -409,37 +491,39 @@ static int multiz_cmp(multiz a, multiz b) {
       return mpz_cmp(a->z, b->z);
     }
     // Leading coefficient of b.
-    while(T_ARR == b->type) b = darray_last(b->a);
-    PBC_ASSERT(T_MPZ == b->type, "no such type");
-    return -mpz_sgn(b->z);
+    return -mpz_sgn(multiz_lead(b)->z);
   }
   PBC_ASSERT(T_ARR == a->type, "no such type");
   if (T_MPZ == b->type) {
     // Leading coefficient of a.
-    while(T_ARR == a->type) a = darray_last(a->a);
-    PBC_ASSERT(T_MPZ == a->type, "no such type");
-    return mpz_sgn(a->z);
+    return mpz_sgn(multiz_lead(a)->z);
   }
   PBC_ASSERT(T_ARR == b->type, "no such type");
-  int m = darray_count(a->a);
-  int n = darray_count(b->a);
+  int m = a->count;
+  int n = b->count;
   if (m > n) {
     // Leading coefficient of a.
-    while(T_ARR == a->type) a = darray_last(a->a);
-    PBC_ASSERT(T_MPZ == a->type, "no such type");
-    return mpz_sgn(a->z);
+    return mpz_sgn(multiz_lead(a)->z);
   }
   if (n > m) {
     // Leading coefficient of b.
-    while(T_ARR == b->type) b = darray_last(b->a);
-    PBC_ASSERT(T_MPZ == b->type, "no such type");
-    return -mpz_sgn(b->z);
+    return -mpz_sgn(multiz_lead(b)->z);
+  }
+  // Items from the last, gathered first as they are only linked forwards.
+  multiz *item = pbc_malloc(sizeof(multiz) * 2 * n);
+  multiz x = a + 1, y = b + 1;
+  int i = 0;
+  for(m = 0; m < n; m++) {
+    item[2 * m] = x;
+    item[2 * m + 1] = y;
+    x = multiz_next(x);
+    y = multiz_next(y);
   }
-  for(n--; n >= 0; n--) {
-    int i = multiz_cmp(darray_at(a->a, n), darray_at(b->a, n));
-    if (i) return i;
+  for(n--; n >= 0 && !i; n--) {
+    i = multiz_cmp(item[2 * n], item[2 * n + 1]);
   }
-  return 0;
+  pbc_free(item);
+  return i;
 }
 static int f_cmp(element_ptr x, element_ptr y) {
   return multiz_cmp(x->data, y->data);
@@ -453,7 +537,7 @@ static void f_field_clear(field_t f) { UNUSED_VAR (f); }
 //   (prepending null byte if necessary)
 // Positive numbers also the same as mpz_out_raw.
 static int z_to_bytes(unsigned char *data, element_t e) {
-  mpz_ptr z = e->data;
+  mpz_ptr z = multiz_first(e->data)->z;
   size_t msb = mpz_sizeinbase(z, 2);
   size_t n = 4;
   size_t i;
@@ -480,7 +564,7 @@ static int z_to_bytes(unsigned char *data, element_t e) {
 static int z_from_bytes(element_t e, unsigned char *data) {
   unsigned char *ptr;
   size_t i, n;
-  mpz_ptr z = e->data;
+  mpz_ptr z = f_set_z(e);
   mpz_t z1;
   int neg = 0;
 
@@ -509,7 +593,7 @@ static int z_from_bytes(element_t e, unsigned char *data) {
 }
 
 static int z_length_in_bytes(element_ptr a) {
-  return (mpz_sizeinbase(a->data, 2) + 7) / 8 + 4;
+  return (mpz_sizeinbase(multiz_first(a->data)->z, 2) + 7) / 8 + 4;
 }
 
 static void f_out_info(FILE *out, field_ptr f) {
@@ -579,11 +663,11 @@ int multiz_is_z(multiz m) {
 
 int multiz_count(multiz m) {
   if (T_ARR != m->type) return -1;
-  return darray_count(m->a);
+  return m->count;
 }
 
 multiz multiz_at(multiz m, int i) {
   PBC_ASSERT(T_ARR == m->type, "wrong type");
-  PBC_ASSERT(darray_count(m->a) > i, "out of bounds");
-  return darray_at(m->a, i);
+  PBC_ASSERT(m->count > i, "out of bounds");
+  return multiz_item(m, i);
 }
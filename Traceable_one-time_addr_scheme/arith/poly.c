@@ -37,6 +37,10 @@ typedef struct {
   int n;             // Degree of extension.
   element_t poly;    // Polynomial of degree n.
   element_t *xpwr;   // x^n,...,x^{2n-2} mod poly
+  // For n >= POLYMOD_BARRETT_MIN only: products are reduced by two
+  // multiplications instead of through xpwr (see polymod_reduce()).
+  element_vec_t rinv;  // 1 / reverse(poly) mod x^{n-1}.
+  element_vec_t low;   // Coefficients of 1, ..., x^{n-1} in poly.
 } *mfptr;
 // Per-element data: just a pointer to an array of element_t. This array always
 // has size n.
@@ -293,6 +297,85 @@ static void poly_mul_si(element_ptr f, element_ptr g, signed long int z) {
   }
 }
 
+// == Karatsuba multiplication ==
+//
+// Products of n coefficients with n >= KARATSUBA_THRESHOLD split each
+// factor in halves and recurse on three half-size products instead of four;
+// below it the schoolbook product is faster. Both thresholds come from
+// timings over 170 to 512-bit prime fields.
+#define KARATSUBA_THRESHOLD 4
+// Moduli of at least this degree are reduced by multiplication.
+#define POLYMOD_BARRETT_MIN 32
+
+// Number of scratch elements kar_poly_n() needs for n coefficients.
+static int kar_poly_n_scratch(int n) {
+  int count = 1;
+  while (n >= KARATSUBA_THRESHOLD) {
+    n = (n + 1) / 2;
+    count += 4 * n - 1;
+  }
+  return count;
+}
+
+// Sets dst[0..2n-2] to the product of the polynomials with coefficients
+// s1[0..n-1] and s2[0..n-1], squaring when s1 == s2. dst must not overlap
+// s1, s2 or scratch, which holds kar_poly_n_scratch(n) elements of the
+// coefficient field.
+static void kar_poly_n(element_t *dst, element_t *s1, element_t *s2, int n,
+    element_t *scratch) {
+  element_t *a, *b, *mid;
+  int h, l, i, j;
+
+  if (n < KARATSUBA_THRESHOLD) {
+    element_ptr e0 = scratch[0];
+    for (i=0; i<2*n-1; i++) element_set0(dst[i]);
+    if (s1 == s2) {
+      for (i=0; i<n; i++) {
+        for (j=i+1; j<n; j++) {
+          element_mul(e0, s1[i], s1[j]);
+          element_add(dst[i + j], dst[i + j], e0);
+        }
+      }
+      for (i=1; i<2*n-2; i++) element_double(dst[i], dst[i]);
+      for (i=0; i<n; i++) {
+        element_square(e0, s1[i]);
+        element_add(dst[2 * i], dst[2 * i], e0);
+      }
+      return;
+    }
+    for (i=0; i<n; i++) {
+      for (j=0; j<n; j++) {
+        element_mul(e0, s1[i], s2[j]);
+        element_add(dst[i + j], dst[i + j], e0);
+      }
+    }
+    return;
+  }
+
+  // s1 = a0 + x^h a1 with a0 of h coefficients and a1 of l <= h, and so
+  // on. The low and high products go straight into dst.
+  h = (n + 1) / 2;
+  l = n - h;
+  kar_poly_n(dst, s1, s2, h, scratch);
+  kar_poly_n(dst + 2 * h, s1 + h, s2 + h, l, scratch);
+  element_set0(dst[2 * h - 1]);
+
+  // (a0 + a1)(b0 + b1) - a0 b0 - a1 b1, added in at x^h.
+  a = scratch;
+  b = s1 == s2 ? a : scratch + h;
+  mid = scratch + 2 * h;
+  for (i=0; i<l; i++) element_add(a[i], s1[i], s1[h + i]);
+  if (l < h) element_set(a[h - 1], s1[h - 1]);
+  if (b != a) {
+    for (i=0; i<l; i++) element_add(b[i], s2[i], s2[h + i]);
+    if (l < h) element_set(b[h - 1], s2[h - 1]);
+  }
+  kar_poly_n(mid, a, b, h, mid + 2 * h - 1);
+  for (i=0; i<2*h-1; i++) element_sub(mid[i], mid[i], dst[i]);
+  for (i=0; i<2*l-1; i++) element_sub(mid[i], mid[i], dst[2 * h + i]);
+  for (i=0; i<2*h-1; i++) element_add(dst[h + i], dst[h + i], mid[i]);
+}
+
 static void poly_mul(element_ptr r, element_ptr f, element_ptr g) {
   peptr pprod;
   peptr pf = f->data;
@@ -308,24 +391,59 @@ static void poly_mul(element_ptr r, element_ptr f, element_ptr g) {
     element_set0(r);
     return;
   }
+  if (fcount < gcount) {
+    element_ptr t = f;
+    f = g;
+    g = t;
+    pf = f->data;
+    pg = g->data;
+    i = fcount;
+    fcount = gcount;
+    gcount = i;
+  }
   element_init(prod, r->field);
   pprod = prod->data;
   n = fcount + gcount - 1;
   poly_alloc(prod, n);
-  element_init(e0, pdp->field);
-  for (i=0; i<n; i++) {
-    element_ptr x = pprod->coeff->item[i];
-    element_set0(x);
-    for (j=0; j<=i; j++) {
-      if (j < fcount && i - j < gcount) {
-        element_mul(e0, pf->coeff->item[j], pg->coeff->item[i - j]);
-        element_add(x, x, e0);
+  if (gcount >= KARATSUBA_THRESHOLD) {
+    // Karatsuba on g times each gcount-coefficient block of f.
+    element_vec_t v;
+    element_t *a, *b, *c;
+    int k;
+    element_vec_init(v, pdp->field, 4 * gcount - 1 + kar_poly_n_scratch(gcount));
+    a = v->item;
+    b = a + gcount;
+    c = b + gcount;
+    for (i=0; i<n; i++) element_set0(pprod->coeff->item[i]);
+    for (j=0; j<gcount; j++) element_set(b[j], pg->coeff->item[j]);
+    for (k=0; k<fcount; k+=gcount) {
+      for (j=0; j<gcount; j++) {
+        if (k + j < fcount) element_set(a[j], pf->coeff->item[k + j]);
+        else element_set0(a[j]);
+      }
+      kar_poly_n(c, a, b, gcount, c + 2 * gcount - 1);
+      for (j=0; j<2*gcount-1 && k+j<n; j++) {
+        element_ptr x = pprod->coeff->item[k + j];
+        element_add(x, x, c[j]);
+      }
+    }
+    element_vec_clear(v);
+  } else {
+    element_init(e0, pdp->field);
+    for (i=0; i<n; i++) {
+      element_ptr x = pprod->coeff->item[i];
+      element_set0(x);
+      for (j=0; j<=i; j++) {
+        if (j < fcount && i - j < gcount) {
+          element_mul(e0, pf->coeff->item[j], pg->coeff->item[i - j]);
+          element_add(x, x, e0);
+        }
       }
     }
+    element_clear(e0);
   }
   poly_remove_leading_zeroes(prod);
   element_set(r, prod);
-  element_clear(e0);
   element_clear(prod);
 }
 
@@ -609,6 +727,10 @@ static void field_clear_polymod(field_ptr f) {
     element_clear(p->xpwr[i]);
   }
   pbc_free(p->xpwr);
+  if (n >= POLYMOD_BARRETT_MIN) {
+    element_vec_clear(p->rinv);
+    element_vec_clear(p->low);
+  }
 
   element_clear(p->poly);
   pbc_free(f->data);
@@ -802,6 +924,15 @@ static void polymod_set(element_t e, element_t f) {
   }
 }
 
+static void polymod_cmov(element_t e, element_t f, int bit) {
+  mfptr p = e->field->data;
+  element_t *dst = e->data, *src = f->data;
+  int i, n = p->n;
+  for (i=0; i<n; i++) {
+    element_cmov(dst[i], src[i], bit);
+  }
+}
+
 static void polymod_neg(element_t e, element_t f) {
   mfptr p = e->field->data;
   element_t *dst = e->data, *src = f->data;
@@ -1001,6 +1132,64 @@ static void polymod_mul_degree6(element_ptr res, element_ptr e, element_ptr f) {
   element_clear(p3);
 }
 
+// Scratch elements polymod_reduce() needs for a modulus of degree n.
+static int polymod_reduce_scratch(int n) {
+  if (n < POLYMOD_BARRETT_MIN) return 1;
+  return 3 * n - 1 + kar_poly_n_scratch(n);
+}
+
+// Sets res to the polynomial with coefficients c[0..2n-2] modulo poly.
+// scratch holds polymod_reduce_scratch(n) elements of the base field and
+// neither it nor c may overlap res.
+static void polymod_reduce(element_ptr res, element_t *c, element_t *scratch) {
+  mfptr p = res->field->data;
+  element_t *dst = res->data;
+  int n = p->n, k = n - 1;
+  int i, j;
+
+  if (n < POLYMOD_BARRETT_MIN) {
+    // Add c_{n+i} x^{n+i} mod poly for each high coefficient.
+    element_ptr e0 = scratch[0];
+    for (i=0; i<n; i++) element_set(dst[i], c[i]);
+    for (i=0; i<k; i++) {
+      element_t *x = p->xpwr[i]->data;
+      for (j=0; j<n; j++) {
+        element_mul(e0, c[n + i], x[j]);
+        element_add(dst[j], dst[j], e0);
+      }
+    }
+    return;
+  }
+
+  // c = q poly + r with deg q < k. Reversing the order of coefficients,
+  // reverse(q) = reverse(c) / reverse(poly) mod x^k, which needs only the
+  // high half of c; then r = c - q poly mod x^n. Two Karatsuba products
+  // instead of the k n multiplications above.
+  element_t *q = scratch, *t = q + n, *rest = t + 2 * n - 1;
+  for (i=0; i<k; i++) element_set(q[i], c[2 * n - 2 - i]);
+  kar_poly_n(t, q, p->rinv->item, k, rest);
+  for (i=0; i<k; i++) element_set(q[i], t[k - 1 - i]);
+  element_set0(q[k]);
+  kar_poly_n(t, q, p->low->item, n, rest);
+  for (i=0; i<n; i++) element_sub(dst[i], c[i], t[i]);
+}
+
+// Karatsuba product of e and f (or the square of e if f == e), then
+// reduction modulo poly.
+static void polymod_mul_kar(element_ptr res, element_ptr e, element_ptr f) {
+  mfptr p = res->field->data;
+  int n = p->n;
+  int rs = polymod_reduce_scratch(n), ks = kar_poly_n_scratch(n);
+  element_vec_t v;
+  element_t *c;
+
+  element_vec_init(v, p->field, 2 * n - 1 + (rs > ks ? rs : ks));
+  c = v->item;
+  kar_poly_n(c, e->data, f->data, n, c + 2 * n - 1);
+  polymod_reduce(res, c, c + 2 * n - 1);
+  element_vec_clear(v);
+}
+
 // General polynomial modulo ring multiplication.
 static void polymod_mul(element_ptr res, element_ptr e, element_ptr f) {
   mfptr p = res->field->data;
@@ -1011,6 +1200,10 @@ static void polymod_mul(element_ptr res, element_ptr e, element_ptr f) {
   int i, j;
   element_t *high;  // Coefficients of x^n, ..., x^{2n-2}.
 
+  if (n >= KARATSUBA_THRESHOLD) {
+    polymod_mul_kar(res, e, f);
+    return;
+  }
   high = pbc_malloc(sizeof(element_t) * (n - 1));
   for (i=0; i<n-1; i++) {
     element_init(high[i], p->field);
@@ -1097,6 +1290,10 @@ static void polymod_square(element_ptr res, element_ptr e) {
   int i, j;
   element_t *high; // Coefficients of x^n,...,x^{2n-2}.
 
+  if (n >= KARATSUBA_THRESHOLD) {
+    polymod_mul_kar(res, e, e);
+    return;
+  }
   high = pbc_malloc(sizeof(element_t) * (n - 1));
   for (i=0; i<n-1; i++) {
     element_init(high[i], p->field);
@@ -1332,6 +1529,33 @@ static void compute_x_powers(field_ptr field, element_ptr poly) {
   element_clear(p0);
 }
 
+// Set up rinv and low for polymod_reduce(). Since poly is monic its reverse
+// has constant term 1, and the coefficients g_i of its inverse follow from
+// g_0 = 1, g_i = -(m_{n-1} g_{i-1} + ... + m_{n-i} g_0). This runs once per
+// field, so the quadratic cost does not matter.
+static void compute_reverse_inverse(field_ptr field) {
+  mfptr p = field->data;
+  int n = p->n, k = n - 1;
+  element_t *g;
+  element_t e0;
+  int i, j;
+
+  element_vec_init(p->rinv, p->field, k);
+  element_vec_init(p->low, p->field, n);
+  for (i=0; i<n; i++) element_set(p->low->item[i], poly_coeff(p->poly, i));
+  g = p->rinv->item;
+  element_init(e0, p->field);
+  element_set1(g[0]);
+  for (i=1; i<k; i++) {
+    element_set0(g[i]);
+    for (j=1; j<=i; j++) {
+      element_mul(e0, poly_coeff(p->poly, n - j), g[i - j]);
+      element_sub(g[i], g[i], e0);
+    }
+  }
+  element_clear(e0);
+}
+
 static void polymod_out_info(FILE *str, field_ptr f) {
   mfptr p = f->data;
   element_fprintf(str, "Extension, poly = %B, base field = ", p->poly);
@@ -1492,6 +1716,7 @@ void field_init_polymod(field_ptr f, element_ptr poly) {
   f->set_multiz = polymod_set_multiz;
   f->set_str = polymod_set_str;
   f->set = polymod_set;
+  f->cmov = polymod_cmov;
   f->sign = polymod_sgn;
   f->add = polymod_add;
   f->doub = polymod_double;
@@ -1541,6 +1766,7 @@ void field_init_polymod(field_ptr f, element_ptr poly) {
 
   p->xpwr = pbc_malloc(sizeof(element_t) * n);
   compute_x_powers(f, poly);
+  if (n >= POLYMOD_BARRETT_MIN) compute_reverse_inverse(f);
 }
 
 field_ptr poly_base_field(element_t f) {
@@ -1,11 +1,22 @@
 #include <stdio.h>
 #include <stdint.h> // for intptr_t
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include <gmp.h>
 #include "pbc_random.h"
 #include "pbc_utils.h"
 #include "pbc_memory.h"
 
+// getrandom() avoids both the open() and the file descriptor.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <errno.h>
+#include <sys/random.h>
+#define PBC_HAVE_GETRANDOM 1
+#endif
+#endif
+
 void pbc_init_random(void);
 
 // Must use pointer due to lack of gmp_randstate_ptr.
@@ -24,23 +35,26 @@ static void deterministic_mpz_random(mpz_t z, mpz_t limit, void *data) {
   mpz_urandomm(z, *get_rs(), limit);
 }
 
-static void file_mpz_random(mpz_t r, mpz_t limit, void *data) {
-  char *filename = (char *) data;
-  FILE *fp;
+// Rejection sampling over a byte source: draw ceil(bits/8) bytes, mask the
+// top byte down to the bit length of 'limit', retry until below 'limit'.
+// Returns 0 on success, -1 if the source runs dry.
+static int bytes_mpz_random(mpz_t r, mpz_t limit,
+                            int (*get_bytes)(unsigned char *, size_t, void *),
+                            void *data) {
   int n, bytecount, leftover;
   unsigned char *bytes;
   mpz_t z;
-  mpz_init(z);
-  fp = fopen(filename, "rb");
-  if (!fp) return;
   n = mpz_sizeinbase(limit, 2);
   bytecount = (n + 7) / 8;
   leftover = n % 8;
   bytes = (unsigned char *) pbc_malloc(bytecount);
+  mpz_init(z);
   for (;;) {
-    if (!fread(bytes, 1, bytecount, fp)) {
+    if (get_bytes(bytes, bytecount, data)) {
       pbc_warn("error reading source of random bits");
-      return;
+      mpz_clear(z);
+      pbc_free(bytes);
+      return -1;
     }
     if (leftover) {
       *bytes = *bytes % (1 << leftover);
@@ -48,15 +62,124 @@ static void file_mpz_random(mpz_t r, mpz_t limit, void *data) {
     mpz_import(z, bytecount, 1, 1, 0, 0, bytes);
     if (mpz_cmp(z, limit) < 0) break;
   }
-  fclose(fp);
   mpz_set(r, z);
   mpz_clear(z);
   pbc_free(bytes);
+  return 0;
+}
+
+// Random bytes read in large chunks, either from a file kept open or,
+// when fp is NULL, from getrandom(). The global source is shared by every
+// thread without a bound context, so the lock guards pos, len and buf:
+// two threads must never be handed the same bytes.
+struct buffered_file_s {
+  FILE *fp;
+  pthread_mutex_t lock;
+  size_t pos, len;
+  unsigned char buf[4096];
+};
+
+static struct buffered_file_s *buffered_file_new(FILE *fp) {
+  struct buffered_file_s *bf = pbc_malloc(sizeof(*bf));
+  bf->fp = fp;
+  pthread_mutex_init(&bf->lock, NULL);
+  bf->pos = bf->len = 0;
+  return bf;
+}
+
+static size_t buffered_file_refill(struct buffered_file_s *bf) {
+#ifdef PBC_HAVE_GETRANDOM
+  if (!bf->fp) {
+    ssize_t got;
+    do {
+      got = getrandom(bf->buf, sizeof(bf->buf), 0);
+    } while (got < 0 && errno == EINTR);
+    return got > 0 ? (size_t) got : 0;
+  }
+#endif
+  return bf->fp ? fread(bf->buf, 1, sizeof(bf->buf), bf->fp) : 0;
 }
 
+static int buffered_file_read(unsigned char *out, size_t n, void *data) {
+  struct buffered_file_s *bf = data;
+  int result = 0;
+  pthread_mutex_lock(&bf->lock);
+  while (n) {
+    size_t k;
+    if (bf->pos == bf->len) {
+      bf->len = buffered_file_refill(bf);
+      bf->pos = 0;
+      if (!bf->len) {
+        result = -1;
+        break;
+      }
+    }
+    k = bf->len - bf->pos;
+    if (k > n) k = n;
+    memcpy(out, bf->buf + bf->pos, k);
+    bf->pos += k;
+    out += k;
+    n -= k;
+  }
+  pthread_mutex_unlock(&bf->lock);
+  return result;
+}
+
+static void buffered_file_mpz_random(mpz_t r, mpz_t limit, void *data) {
+  bytes_mpz_random(r, limit, buffered_file_read, data);
+}
+
+static void buffered_file_clear(void *data) {
+  struct buffered_file_s *bf = data;
+  if (bf->fp) fclose(bf->fp);
+  pthread_mutex_destroy(&bf->lock);
+  // Do not leave random bytes behind in freed memory.
+  memset(bf->buf, 0, sizeof(bf->buf));
+  pbc_free(bf);
+}
+
+static int file_read(unsigned char *out, size_t n, void *data) {
+  return fread(out, 1, n, (FILE *) data) == n ? 0 : -1;
+}
+
+static void file_mpz_random(mpz_t r, mpz_t limit, void *data) {
+  char *filename = (char *) data;
+  FILE *fp;
+  fp = fopen(filename, "rb");
+  if (!fp) return;
+  bytes_mpz_random(r, limit, file_read, fp);
+  fclose(fp);
+}
+
+static void deterministic_ctx_mpz_random(mpz_t z, mpz_t limit, void *data) {
+  mpz_urandomm(z, *(gmp_randstate_t *) data, limit);
+}
+
+static void deterministic_ctx_clear(void *data) {
+  gmp_randclear(*(gmp_randstate_t *) data);
+  pbc_free(data);
+}
+
+#if defined(__GNUC__)
+#define PBC_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define PBC_THREAD_LOCAL __declspec(thread)
+#else
+#define PBC_THREAD_LOCAL _Thread_local
+#endif
+
+// Context bound to the calling thread, overrides the global source.
+static PBC_THREAD_LOCAL pbc_random_ctx_ptr bound_ctx;
+
 static void (*current_mpz_random)(mpz_t, mpz_t, void *);
 static void *current_random_data;
 static int random_function_ready = 0;
+static pthread_once_t random_once = PTHREAD_ONCE_INIT;
+
+// The default source is picked once even when the first draws race.
+static void random_default_init(void) {
+  if (!random_function_ready) pbc_init_random();
+}
 
 void pbc_random_set_function(void (*fun)(mpz_t, mpz_t, void *), void *data) {
   current_mpz_random = fun;
@@ -65,7 +188,11 @@ void pbc_random_set_function(void (*fun)(mpz_t, mpz_t, void *), void *data) {
 }
 
 void pbc_mpz_random(mpz_t z, mpz_t limit) {
-  if (!random_function_ready) pbc_init_random();
+  if (bound_ctx) {
+    bound_ctx->fun(z, limit, bound_ctx->data);
+    return;
+  }
+  pthread_once(&random_once, random_default_init);
   current_mpz_random(z, limit, current_random_data);
 }
 
@@ -85,3 +212,81 @@ void pbc_random_set_deterministic(unsigned int seed) {
 void pbc_random_set_file(char *filename) {
   pbc_random_set_function(file_mpz_random, filename);
 }
+
+// Backing state for pbc_random_set_os(); replaced on each call.
+static pbc_random_ctx_t os_ctx;
+static int os_ctx_ready;
+
+int pbc_random_set_os(void) {
+  struct pbc_random_ctx_s old = *os_ctx;
+  int had_old = os_ctx_ready;
+  pbc_random_ctx_t ctx;
+  if (pbc_random_ctx_init_os(ctx)) return -1;
+  *os_ctx = *ctx;
+  os_ctx_ready = 1;
+  pbc_random_set_function(os_ctx->fun, os_ctx->data);
+  // Free the previous buffer only once nothing points at it.
+  if (had_old) pbc_random_ctx_clear(&old);
+  return 0;
+}
+
+void pbc_random_ctx_init_function(pbc_random_ctx_t ctx,
+    void (*fun)(mpz_t, mpz_t, void *), void *data) {
+  ctx->fun = fun;
+  ctx->data = data;
+  ctx->clear = NULL;
+}
+
+void pbc_random_ctx_init_deterministic(pbc_random_ctx_t ctx, unsigned int seed) {
+  gmp_randstate_t *rs = pbc_malloc(sizeof(gmp_randstate_t));
+  gmp_randinit_default(*rs);
+  gmp_randseed_ui(*rs, seed);
+  ctx->fun = deterministic_ctx_mpz_random;
+  ctx->data = rs;
+  ctx->clear = deterministic_ctx_clear;
+}
+
+int pbc_random_ctx_init_file(pbc_random_ctx_t ctx, const char *filename) {
+  struct buffered_file_s *bf;
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) return -1;
+  // We do our own buffering.
+  setvbuf(fp, NULL, _IONBF, 0);
+  bf = buffered_file_new(fp);
+  ctx->fun = buffered_file_mpz_random;
+  ctx->data = bf;
+  ctx->clear = buffered_file_clear;
+  return 0;
+}
+
+int pbc_random_ctx_init_os(pbc_random_ctx_t ctx) {
+#ifdef PBC_HAVE_GETRANDOM
+  unsigned char probe;
+  // Fails with ENOSYS on kernels older than 3.17.
+  if (getrandom(&probe, 1, GRND_NONBLOCK) == 1) {
+    ctx->fun = buffered_file_mpz_random;
+    ctx->data = buffered_file_new(NULL);
+    ctx->clear = buffered_file_clear;
+    return 0;
+  }
+#endif
+  return pbc_random_ctx_init_file(ctx, "/dev/urandom");
+}
+
+void pbc_random_ctx_clear(pbc_random_ctx_t ctx) {
+  if (bound_ctx == ctx) bound_ctx = NULL;
+  if (ctx->clear) ctx->clear(ctx->data);
+  ctx->fun = NULL;
+  ctx->data = NULL;
+  ctx->clear = NULL;
+}
+
+void pbc_random_ctx_mpz_random(pbc_random_ctx_t ctx, mpz_t z, mpz_t limit) {
+  ctx->fun(z, limit, ctx->data);
+}
+
+pbc_random_ctx_ptr pbc_random_ctx_bind(pbc_random_ctx_ptr ctx) {
+  pbc_random_ctx_ptr old = bound_ctx;
+  bound_ctx = ctx;
+  return old;
+}
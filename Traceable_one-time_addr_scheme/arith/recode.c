@@ -0,0 +1,39 @@
+// Signed-digit recodings of exponents.
+
+#include <gmp.h>
+#include "arith/recode.h"
+
+int pbc_wnaf_recode(signed char *d, mpz_t n, int w) {
+  mpz_t e;
+  int len = 0;
+  mpz_init_set(e, n);
+  while (mpz_sgn(e)) {
+    int v = 0;
+    if (mpz_odd_p(e)) {
+      v = (int) (mpz_getlimbn(e, 0) & ((1 << w) - 1));
+      if (v >= 1 << (w - 1)) v -= 1 << w;
+      if (v > 0) mpz_sub_ui(e, e, v);
+      else mpz_add_ui(e, e, -v);
+    }
+    d[len++] = v;
+    mpz_tdiv_q_2exp(e, e, 1);
+  }
+  mpz_clear(e);
+  return len;
+}
+
+void pbc_regular_recode(int *d, mpz_t e, int w, int m) {
+  mpz_t t;
+  int i;
+  mpz_init_set(t, e);
+  for (i = 0; i < m - 1; i++) {
+    // d = (t mod 2^(w+1)) - 2^w, and t = (t - d) / 2^w stays odd.
+    int low = (int) (mpz_getlimbn(t, 0) & ((2 << w) - 1));
+    d[i] = low - (1 << w);
+    mpz_sub_ui(t, t, low);
+    mpz_add_ui(t, t, 1 << w);
+    mpz_tdiv_q_2exp(t, t, w);
+  }
+  d[m - 1] = (int) mpz_get_ui(t);
+  mpz_clear(t);
+}
@@ -0,0 +1,25 @@
+// Signed-digit recodings of exponents, shared by the curve and field
+// exponentiations.
+
+// Requires:
+// * gmp.h
+#ifndef __PBC_RECODE_H__
+#define __PBC_RECODE_H__
+
+#pragma GCC visibility push(hidden)
+
+// Width-w NAF of n > 0: digits are 0 or odd with |d| < 2^(w-1), and any
+// nonzero digit is followed by w - 1 zeros. d needs room for one digit
+// more than n has bits. Returns the number of digits.
+int pbc_wnaf_recode(signed char *d, mpz_t n, int w);
+
+// Regular recoding of Joye and Tunstall of an odd e >= 0 into m digits,
+// least significant first, all odd and between -(2^w - 1) and 2^w - 1
+// except the last, which is nonnegative. With e < 2^(wm - 1) the last
+// digit stays below 2^(w - 1) + 2. The loop runs the same for every e of
+// a given m.
+void pbc_regular_recode(int *d, mpz_t e, int w, int m);
+
+#pragma GCC visibility pop
+
+#endif //__PBC_RECODE_H__
@@ -135,16 +135,6 @@ static unsigned gf3m_get(element_t e, unsigned pos) {
     return v1 ? 1 : (v2 ? 2 : 0);
 }
 
-/* set the coefficient of $x^pos$ as 1 */
-static void gf3m_set(element_t e, unsigned pos, unsigned value) {
-    unsigned long *a = DATA1(e);
-    /* assert value == 0, 1 or 2 */
-    if (value == 2)
-        a = DATA2(e);
-    if (value)
-        a[pos / W] |= 1ul << (pos % W);
-}
-
 /* $e <- a+b$ */
 static void gf3m_add(element_t e, element_t a, element_t b) {
     unsigned long *e1 = DATA1(e), *e2 = DATA2(e), *a1 = DATA1(a),
@@ -243,31 +233,105 @@ static void gf3m_neg(element_t y, element_t x) {
     }
 }
 
-/* doing reduction
- * The function returns the value of $a$ modulo $the irreducible trinomial$.
- * $degree$ equals the degree of $a$.
- * $2*len$ is the number of elements in $a$ */
-static void gf3m_reduct(element_t e, unsigned len, unsigned degree) {
-    // the $len$ argument exists because sometimes $len != p->len$
-    params *p = PARAM(e);
-    unsigned old = p->len;
-    p->len = len;
-    element_t px;
-    element_init(px, e->field);
-    gf3m_set(px, degree, 1);
-    gf3m_set(px, degree - p->m + p->t, 1);
-    gf3m_set(px, degree - p->m, 2);
+/* Products and cubes are formed unreduced in two planes of $n$ words
+ * each, as the elements: the bits of the coefficients equal to 1, then
+ * those equal to 2. Scratch space of up to GF3M_STACK_WORDS words lives on
+ * the stack. */
+#define GF3M_STACK_WORDS 256
+
+static unsigned long *scratch_get(unsigned long *stack, unsigned words) {
+    if (words <= GF3M_STACK_WORDS)
+        return stack;
+    return pbc_malloc(words * sizeof(unsigned long));
+}
+
+static void scratch_put(unsigned long *stack, unsigned long *s) {
+    if (s != stack)
+        pbc_free(s);
+}
+
+/* $c <- c + a$ over $n$ words of each plane */
+static inline void planes_add(unsigned long *c1, unsigned long *c2,
+        const unsigned long *a1, const unsigned long *a2, unsigned n) {
+    unsigned i;
+    for (i = 0; i < n; i++) {
+        unsigned long t = (c1[i] | c2[i]) & (a1[i] | a2[i]);
+        unsigned long s1 = t ^ (c1[i] | a1[i]), s2 = t ^ (c2[i] | a2[i]);
+        c1[i] = s1;
+        c2[i] = s2;
+    }
+}
+
+/* $c <- c + a x^s$, where $c$ has $n$ words and $a$ has $an$ words of
+ * each plane */
+static void planes_add_at(unsigned long *c1, unsigned long *c2, unsigned n,
+        const unsigned long *a1, const unsigned long *a2, unsigned an,
+        unsigned s) {
+    unsigned o = s / W, b = s % W, i;
+    unsigned long l1 = 0, l2 = 0;
+    for (i = 0; i <= an && o + i < n; i++) {
+        unsigned long w1 = i < an ? a1[i] : 0, w2 = i < an ? a2[i] : 0;
+        unsigned long x1 = w1 << b | l1, x2 = w2 << b | l2;
+        l1 = b ? w1 >> (W - b) : 0;
+        l2 = b ? w2 >> (W - b) : 0;
+        unsigned long *y1 = c1 + o + i, *y2 = c2 + o + i;
+        unsigned long t = (*y1 | *y2) & (x1 | x2);
+        unsigned long s1 = t ^ (*y1 | x1), s2 = t ^ (*y2 | x2);
+        *y1 = s1;
+        *y2 = s2;
+    }
+}
+
+/* $a <- a*x^2$, $n$ words of each plane */
+static void planes_shift_up2(unsigned long *a1, unsigned long *a2,
+        unsigned n) {
+    unsigned i;
+    for (i = n - 1; i > 0; i--) {
+        a1[i] = a1[i] << 2 | a1[i - 1] >> (W - 2);
+        a2[i] = a2[i] << 2 | a2[i - 1] >> (W - 2);
+    }
+    a1[0] <<= 2;
+    a2[0] <<= 2;
+}
+
+/* $h <-$ the $hn$ words of $a$ from bit $s$ on, $a$ having $n$ words */
+static void plane_bits_from(unsigned long *h, const unsigned long *a,
+        unsigned n, unsigned s, unsigned hn) {
+    unsigned o = s / W, b = s % W, i;
+    for (i = 0; i < hn; i++) {
+        unsigned long v = o + i < n ? a[o + i] >> b : 0;
+        if (b && o + i + 1 < n)
+            v |= a[o + i + 1] << (W - b);
+        h[i] = v;
+    }
+}
+
+/* clear the bits of $a$ from bit $s$ on, $a$ having $n$ words */
+static void plane_clear_from(unsigned long *a, unsigned n, unsigned s) {
+    unsigned o = s / W;
+    if (o >= n)
+        return;
+    a[o] &= (1ul << (s % W)) - 1;
+    memset(a + o + 1, 0, (n - o - 1) * sizeof(unsigned long));
+}
+
+/* $c <- c$ modulo $x^m + x^t + 2$, where $c$ has $n$ words of each plane
+ * and degree at most $degree$, and $h$ has room for $2n$ words.
+ * As $x^m = 2x^t + 1$, the part $H$ of degree $m$ and above folds back
+ * as $H - H x^t$, a whole word at a time. */
+static void planes_reduce(params *p, unsigned long *c1, unsigned long *c2,
+        unsigned n, unsigned degree, unsigned long *h) {
     while (degree >= p->m) {
-        unsigned v = gf3m_get(e, degree);
-        if (v == 1)
-            gf3m_sub(e, e, px);
-        else if (v == 2)
-            gf3m_add(e, e, px);
-        degree--;
-        gf3m_shift_down(px);
+        unsigned hn = (degree - p->m) / W + 1;
+        unsigned long *h1 = h, *h2 = h + hn;
+        plane_bits_from(h1, c1, n, p->m, hn);
+        plane_bits_from(h2, c2, n, p->m, hn);
+        plane_clear_from(c1, n, p->m);
+        plane_clear_from(c2, n, p->m);
+        planes_add_at(c1, c2, n, h1, h2, hn, 0);
+        planes_add_at(c1, c2, n, h2, h1, hn, p->t); /* $-H$ swaps the planes */
+        degree = degree - p->m + p->t;
     }
-    element_clear(px);
-    p->len = old;
 }
 
 /* doing multiplication of $n \in \{0,1,2\}$ and $a$ in $GF(3^m)$
@@ -295,50 +359,102 @@ static void gf3m_f2(element_t e) {
         gf3m_add(e, e, p->p);
 }
 
+/* the index $u_0 + 3u_1$ of the multiple $u_0 + u_1 x$ for the two-bit
+ * patterns of both planes, (bits of plane 1) | (bits of plane 2) << 2 */
+static const unsigned char comb_digit[16] = {
+    0, 1, 3, 4, 2, 0, 5, 0, 6, 7, 0, 0, 8, 0, 0, 0
+};
+
 /* doing multiplication in GF(3^m)
- * The function sets $e == a*b \in GF(3^m)$ */
+ * The function sets $e == a*b \in GF(3^m)$.
+ * A comb over the trits of $b$, two at a time: the multiples
+ * $(u_0 + u_1 x) a$ are tabulated, and the trits in the same two bit
+ * positions of every word of $b$ add them at that word's offset before
+ * the product shifts up by two. */
 static void gf3m_mult(element_t e, element_ptr a, element_t b) {
     params *p = PARAM(a);
-    element_t aa, t, c;
-    element_init(aa, a->field);
-    element_set(aa, a);
-    a = aa; // clone $a$
-    element_init(t, a->field);
-    element_init(c, a->field);
-    unsigned i;
-    for (i = 0; i < p->m; i++) {
-        unsigned v = gf3m_get(b, i);
-        gf3m_f1(t, v, a); /* t == b[i]*a in GF(3^m) */
-        gf3m_add(c, c, t); /* c += b[i]*a in GF(3^m) */
-        gf3m_f2(a); /* a == a*x in GF(3^m) */
+    unsigned len = p->len, la = len + 1, n = 2 * len + 1, i, k;
+    unsigned long stack[GF3M_STACK_WORDS];
+    unsigned long *s = scratch_get(stack, 18 * la + 4 * n);
+    unsigned long *c1 = s, *c2 = s + n, *u = s + 4 * n;
+    const unsigned long *b1 = DATA1(b), *b2 = DATA2(b);
+    int j;
+
+    memset(s, 0, (18 * la + 4 * n) * sizeof(unsigned long));
+#define MULTIPLE(i) (u + (i) * 2 * la)
+    /* 1: $a$, 3: $xa$, their negatives 2 and 6, and $u_0 + 3u_1$:
+     * $(u_0 + u_1 x) a$ */
+    memcpy(MULTIPLE(1), DATA1(a), len * sizeof(unsigned long));
+    memcpy(MULTIPLE(1) + la, DATA2(a), len * sizeof(unsigned long));
+    planes_add_at(MULTIPLE(3), MULTIPLE(3) + la, la, MULTIPLE(1),
+            MULTIPLE(1) + la, len, 1);
+    for (i = 1; i <= 3; i += 2) {
+        memcpy(MULTIPLE(2 * i), MULTIPLE(i) + la, la * sizeof(unsigned long));
+        memcpy(MULTIPLE(2 * i) + la, MULTIPLE(i), la * sizeof(unsigned long));
     }
-    element_set(e, c);
-    element_clear(t);
-    element_clear(c);
-    element_clear(aa);
-}
+    for (i = 1; i <= 2; i++)
+        for (k = 1; k <= 2; k++) {
+            unsigned long *x = MULTIPLE(i + 3 * k);
+            memcpy(x, MULTIPLE(3 * k), 2 * la * sizeof(unsigned long));
+            planes_add(x, x + la, MULTIPLE(i), MULTIPLE(i) + la, la);
+        }
 
-/* $e <- x^3$ */
+    for (j = W - 2; j >= 0; j -= 2) {
+        for (k = 0; k < len; k++) {
+            unsigned d = comb_digit[(b1[k] >> j & 3) | (b2[k] >> j & 3) << 2];
+            if (d)
+                planes_add(c1 + k, c2 + k, MULTIPLE(d), MULTIPLE(d) + la, la);
+        }
+        if (j)
+            planes_shift_up2(c1, c2, n);
+    }
+#undef MULTIPLE
+    planes_reduce(p, c1, c2, n, 2 * p->m - 2, s + 2 * n);
+    memcpy(DATA1(e), c1, len * sizeof(unsigned long));
+    memcpy(DATA2(e), c2, len * sizeof(unsigned long));
+    scratch_put(stack, s);
+}
+
+/* the bits of $v < 2^{21}$ spread three apart: bit $i$ moves to $3i$ */
+static uint64_t spread3(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+/* $e <- x^3$
+ * Cubing is linear in characteristic 3: the coefficient of $x^i$ moves
+ * to $x^{3i}$, so both planes are spread 21 bits at a time and the
+ * result reduced. */
 static void gf3m_cubic(element_t e, element_t x) {
-    /* TODO: faster algorithm */
     params *p = PARAM(x);
-    unsigned old = p->len;
-    unsigned len = (3 * p->m - 2 + W - 1) / W; /* length of $b1 */
-    p->len = len;
-    element_t a;
-    element_init(a, x->field);
-    unsigned i;
-    for (i = 0; i < p->m; i++) {
-        p->len = old;
-        unsigned v = gf3m_get(x, i);
-        p->len = len;
-        gf3m_set(a, 3 * i, v);
-    }
-    gf3m_reduct(a, len, 3 * p->m - 3);
-    p->len = old;
-    memcpy(DATA1(e), DATA1(a), SIZE(e) / 2);
-    memcpy(DATA2(e), DATA1(a) + len, SIZE(e) / 2);
-    element_clear(a);
+    unsigned len = p->len, n = (3 * p->m - 2 + W - 1) / W, i, k;
+    unsigned long stack[GF3M_STACK_WORDS];
+    unsigned long *s = scratch_get(stack, 4 * n);
+    unsigned long *c[2] = { s, s + n };
+    const unsigned long *a[2] = { DATA1(x), DATA2(x) };
+
+    memset(s, 0, 2 * n * sizeof(unsigned long));
+    for (k = 0; k < 2; k++)
+        for (i = 0; i < p->m; i += 21) {
+            unsigned o = i / W, b = i % W, pos = 3 * i;
+            uint64_t v = a[k][o] >> b;
+            if (b + 21 > W && o + 1 < len)
+                v |= (uint64_t) a[k][o + 1] << (W - b);
+            for (v = spread3(v); v && pos / W < n; pos += W - pos % W) {
+                unsigned r = pos % W;
+                c[k][pos / W] |= (unsigned long) (v << r);
+                v = W - r < 64 ? v >> (W - r) : 0;
+            }
+        }
+    planes_reduce(p, c[0], c[1], n, 3 * p->m - 3, s + 2 * n);
+    memcpy(DATA1(e), c[0], len * sizeof(unsigned long));
+    memcpy(DATA2(e), c[1], len * sizeof(unsigned long));
+    scratch_put(stack, s);
 }
 
 /* multiplication modulo 3 of two elements in GF(3)
@@ -653,6 +769,20 @@ static void gf32m_cubic(element_t e, element_t a) {
     element_clear(c1);
 }
 
+static int gf32m_to_bytes(unsigned char *d, element_t e) {
+    element_ptr e0 = GF32M(e)->_0, e1 = GF32M(e)->_1;
+    int len = element_to_bytes(d, e0);
+    len += element_to_bytes(d + len, e1);
+    return len;
+}
+
+static int gf32m_from_bytes(element_t e, unsigned char *d) {
+    element_ptr e0 = GF32M(e)->_0, e1 = GF32M(e)->_1;
+    int len = element_from_bytes(e0, d);
+    len += element_from_bytes(e1, d + len);
+    return len;
+}
+
 void field_clear_gf32m(field_t f) {
     UNUSED_VAR(f);
 }
@@ -677,6 +807,9 @@ void field_init_gf32m(field_t f, field_t b) {
     f->item_count = gf32m_item_count;
     f->item = gf32m_item;
     f->out_str = gf32m_out_str;
+    f->to_bytes = gf32m_to_bytes;
+    f->from_bytes = gf32m_from_bytes;
+    f->fixed_length_in_bytes = 2 * b->fixed_length_in_bytes;
     mpz_pow_ui(f->order, b->order, 2);
     f->name = "GF(3^{2*m})";
 }
@@ -920,6 +1053,22 @@ static void gf33m_invert(element_t e, element_t a) {
     element_clear(c3);
 }
 
+static int gf33m_to_bytes(unsigned char *d, element_t e) {
+    element_ptr e0 = GF33M(e)->_0, e1 = GF33M(e)->_1, e2 = GF33M(e)->_2;
+    int len = element_to_bytes(d, e0);
+    len += element_to_bytes(d + len, e1);
+    len += element_to_bytes(d + len, e2);
+    return len;
+}
+
+static int gf33m_from_bytes(element_t e, unsigned char *d) {
+    element_ptr e0 = GF33M(e)->_0, e1 = GF33M(e)->_1, e2 = GF33M(e)->_2;
+    int len = element_from_bytes(e0, d);
+    len += element_from_bytes(e1, d + len);
+    len += element_from_bytes(e2, d + len);
+    return len;
+}
+
 void field_clear_gf33m(field_t f) {
     UNUSED_VAR(f);
 }
@@ -944,6 +1093,9 @@ void field_init_gf33m(field_t f, field_t b) {
     f->item_count = gf33m_item_count;
     f->item = gf33m_item;
     f->out_str = gf33m_out_str;
+    f->to_bytes = gf33m_to_bytes;
+    f->from_bytes = gf33m_from_bytes;
+    f->fixed_length_in_bytes = 3 * b->fixed_length_in_bytes;
     mpz_pow_ui(f->order, b->order, 3);
     f->name = "GF(3^{3*m})";
 }
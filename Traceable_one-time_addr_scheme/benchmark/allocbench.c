@@ -0,0 +1,75 @@
+// Compares the pool allocator with the malloc the program is linked
+// against (tcmalloc when built with simple.make) on group operations.
+//
+// Usage: allocbench [param file]
+// The same workload runs first on the linked malloc, then again after
+// pbc_pool_enable(). Each iteration does a G1 and a GT exponentiation,
+// a pairing and a G1 multiplication, with fresh temporaries as the
+// scheme code does.
+
+#include "pbc.h"
+#include "pbc_test.h"
+
+static void workload(pairing_t pairing, element_t x, element_t y,
+    element_t n, int iterations, double *t_pow, double *t_pair) {
+  int i;
+  double t0, t1, t2;
+  *t_pow = *t_pair = 0;
+  for (i = 0; i < iterations; i++) {
+    element_t a, b, r, s;
+    element_init_G1(a, pairing);
+    element_init_G1(b, pairing);
+    element_init_GT(r, pairing);
+    element_init_GT(s, pairing);
+
+    t0 = pbc_get_time();
+    element_pow_zn(a, x, n);
+    element_mul(b, a, x);
+    t1 = pbc_get_time();
+    element_pairing(r, b, y);
+    t2 = pbc_get_time();
+    element_pow_zn(s, r, n);
+    *t_pow += t1 - t0 + pbc_get_time() - t2;
+    *t_pair += t2 - t1;
+
+    element_clear(a);
+    element_clear(b);
+    element_clear(r);
+    element_clear(s);
+  }
+}
+
+int main(int argc, char **argv) {
+  pairing_t pairing;
+  element_t x, y, n;
+  double t_pow, t_pair;
+  int iterations = 200;
+
+  pbc_demo_pairing_init(pairing, argc, argv);
+  element_init_G1(x, pairing);
+  element_init_G2(y, pairing);
+  element_init_Zr(n, pairing);
+  element_random(x);
+  element_random(y);
+  element_random(n);
+
+  // Warm up caches and the linked malloc.
+  workload(pairing, x, y, n, iterations / 10, &t_pow, &t_pair);
+
+  workload(pairing, x, y, n, iterations, &t_pow, &t_pair);
+  printf("malloc: pow+mul %f ms, pairing %f ms per iteration\n",
+      t_pow * 1000 / iterations, t_pair * 1000 / iterations);
+
+  pbc_pool_enable();
+  workload(pairing, x, y, n, iterations / 10, &t_pow, &t_pair);
+  workload(pairing, x, y, n, iterations, &t_pow, &t_pair);
+  printf("pool:   pow+mul %f ms, pairing %f ms per iteration\n",
+      t_pow * 1000 / iterations, t_pair * 1000 / iterations);
+  printf("pool reserved %zu KiB\n", pbc_pool_bytes() / 1024);
+
+  element_clear(x);
+  element_clear(y);
+  element_clear(n);
+  pairing_clear(pairing);
+  return 0;
+}
@@ -137,10 +137,110 @@ struct pp_coeff_s {
 typedef struct pp_coeff_s pp_coeff_t[1];
 typedef struct pp_coeff_s *pp_coeff_ptr;
 
-static void pp_coeff_set(pp_coeff_ptr p, element_t a, element_t b, element_t c) {
-  element_init(p->a, a->field);
-  element_init(p->b, b->field);
-  element_init(p->c, c->field);
+struct pp2_coeff_s {
+  element_t cx2;
+  element_t cy2;
+  element_t cxy;
+  element_t cx;
+  element_t cy;
+  element_t c;
+};
+typedef struct pp2_coeff_s pp2_coeff_t[1];
+typedef struct pp2_coeff_s *pp2_coeff_ptr;
+
+// Tables of a_pairing_pp_init() and a1_pairing_pp_init() list their
+// entries in Miller-loop order. When the base field supports
+// element_init_packed(), the entries and the data of their coefficients
+// share one block aligned to a cache line and filled in that order, so
+// the apply loops stream through memory rather than visit one heap
+// allocation per coefficient. Otherwise every entry and coefficient is
+// allocated on its own.
+#define PP_CACHE_LINE 64
+
+#if defined(__GNUC__)
+#define pp_prefetch(p) __builtin_prefetch(p)
+#else
+#define pp_prefetch(p) ((void) 0)
+#endif
+
+struct pp_table_s {
+  void *mem;              // the shared block, NULL when each part owns its memory
+  unsigned char *next;    // unused space of mem
+  field_ptr f;
+  void *entry[];          // NULL-terminated
+};
+typedef struct pp_table_s *pp_table_ptr;
+
+// A table of n entries, n2 of which hold six coefficients and the rest three.
+static pp_table_ptr pp_table_new(field_ptr f, int n, int n2) {
+  pp_table_ptr t = pbc_malloc(sizeof(*t) + sizeof(void *) * (n + 1));
+  t->f = f;
+  t->mem = NULL;
+  t->entry[n] = NULL;
+  if (f->packed_size) {
+    size_t size = (n - n2) * (sizeof(struct pp_coeff_s) + 3 * f->packed_size) +
+        n2 * (sizeof(struct pp2_coeff_s) + 6 * f->packed_size);
+    t->mem = pbc_malloc(size + PP_CACHE_LINE - 1);
+    t->next = (unsigned char *) t->mem +
+        (-(uintptr_t) t->mem & (PP_CACHE_LINE - 1));
+  }
+  return t;
+}
+
+static void *pp_table_alloc(pp_table_ptr t, size_t size) {
+  void *res;
+  if (!t->mem) return pbc_malloc(size);
+  res = t->next;
+  t->next += size;
+  return res;
+}
+
+static void pp_table_element_init(pp_table_ptr t, element_ptr e) {
+  if (!t->mem) {
+    element_init(e, t->f);
+    return;
+  }
+  element_init_packed(e, t->f, t->next);
+  t->next += t->f->packed_size;
+}
+
+// Frees an entry of three coefficients; packed ones go with the table.
+static void pp_table_free_coeff(pp_table_ptr t, pp_coeff_ptr pp) {
+  if (t->mem) return;
+  element_clear(pp->a);
+  element_clear(pp->b);
+  element_clear(pp->c);
+  pbc_free(pp);
+}
+
+static void pp_table_free_coeff2(pp_table_ptr t, pp2_coeff_ptr pp) {
+  if (t->mem) return;
+  element_clear(pp->cx2);
+  element_clear(pp->cy2);
+  element_clear(pp->cxy);
+  element_clear(pp->cx);
+  element_clear(pp->cy);
+  element_clear(pp->c);
+  pbc_free(pp);
+}
+
+static void pp_table_free(pp_table_ptr t) {
+  pbc_free(t->mem);
+  pbc_free(t);
+}
+
+// Adds an entry with coefficients a, b, c.
+static pp_coeff_ptr pp_coeff_new(pp_table_ptr t) {
+  pp_coeff_ptr p = pp_table_alloc(t, sizeof(*p));
+  pp_table_element_init(t, p->a);
+  pp_table_element_init(t, p->b);
+  pp_table_element_init(t, p->c);
+  return p;
+}
+
+static void pp_coeff_set(pp_table_ptr t, int i,
+    element_t a, element_t b, element_t c) {
+  pp_coeff_ptr p = t->entry[i] = pp_coeff_new(t);
   element_set(p->a, a);
   element_set(p->b, b);
   element_set(p->c, c);
@@ -149,8 +249,7 @@ static void pp_coeff_set(pp_coeff_ptr p, element_t a, element_t b, element_t c)
 static void a_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairing) {
   int i, n;
   a_pairing_data_ptr ainfo = pairing->data;
-  p->data = pbc_malloc(sizeof(pp_coeff_t) * (ainfo->exp2 + 1));
-  pp_coeff_t *coeff = (pp_coeff_t *) p->data;
+  pp_table_ptr coeff = p->data = pp_table_new(ainfo->Fq, ainfo->exp2 + 1, 0);
   element_t V, V1;
   element_t a, b, c;
   element_t e0;
@@ -159,11 +258,11 @@ static void a_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairing
 
   #define do_tangent()                        \
     compute_abc_tangent(a, b, c, Vx, Vy, e0); \
-    pp_coeff_set(coeff[i], a, b, c);
+    pp_coeff_set(coeff, i, a, b, c);
 
   #define do_line()                                  \
     compute_abc_line(a, b, c, Vx, Vy, V1x, V1y, e0); \
-    pp_coeff_set(coeff[i], a, b, c);
+    pp_coeff_set(coeff, i, a, b, c);
 
   element_init(V, ainfo->Eq);
   element_init(V1, ainfo->Eq);
@@ -207,25 +306,98 @@ static void a_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairing
 }
 
 static void a_pairing_pp_clear(pairing_pp_t p) {
+  pp_table_ptr coeff = p->data;
+  void **pp;
+  for (pp = coeff->entry; *pp; pp++) pp_table_free_coeff(coeff, *pp);
+  pp_table_free(coeff);
+}
+
+// Serialized tables start with a byte naming their layout and the number
+// of steps, four bytes big-endian, so that a table of another method or
+// pairing is refused where it can be told apart. The coefficients follow
+// as elements of the base field.
+enum {
+  PP_BYTES_COEFF = 1,  // a_pairing_pp_init()
+  PP_BYTES_ELLNET,     // a_pairing_ellnet_pp_init()
+  PP_BYTES_A1_COEFF,   // a1_pairing_pp_init()
+};
+
+#define PP_BYTES_HEADER 5
+
+static unsigned char *pp_bytes_header(unsigned char *data, int kind, int n) {
+  data[0] = kind;
+  data[1] = n >> 24;
+  data[2] = n >> 16;
+  data[3] = n >> 8;
+  data[4] = n;
+  return data + PP_BYTES_HEADER;
+}
+
+static int pp_bytes_header_ok(unsigned char *data, int kind, int n) {
+  return data[0] == kind && data[1] == ((n >> 24) & 0xff) &&
+      data[2] == ((n >> 16) & 0xff) && data[3] == ((n >> 8) & 0xff) &&
+      data[4] == (n & 0xff);
+}
+
+// Initializes e in f and reads it from data. Returns the bytes read.
+static int pp_element_from_bytes(element_ptr e, field_ptr f,
+    unsigned char *data) {
+  element_init(e, f);
+  return element_from_bytes(e, data);
+}
+
+static int pp_coeff_from_bytes(pp_table_ptr t, int i, unsigned char *data) {
+  pp_coeff_ptr p = t->entry[i] = pp_coeff_new(t);
+  int len = element_from_bytes(p->a, data);
+  len += element_from_bytes(p->b, data + len);
+  len += element_from_bytes(p->c, data + len);
+  return len;
+}
+
+static int pp_coeff_to_bytes(unsigned char *data, pp_coeff_ptr p) {
+  int len = element_to_bytes(data, p->a);
+  len += element_to_bytes(data + len, p->b);
+  len += element_to_bytes(data + len, p->c);
+  return len;
+}
+
+static int a_pairing_pp_length_in_bytes(pairing_t pairing) {
+  a_pairing_data_ptr ainfo = pairing->data;
+  return PP_BYTES_HEADER +
+      3 * (ainfo->exp2 + 1) * ainfo->Fq->fixed_length_in_bytes;
+}
+
+static void a_pairing_pp_to_bytes(unsigned char *data, pairing_pp_t p) {
   a_pairing_data_ptr ainfo = p->pairing->data;
-  pp_coeff_t *coeff = (pp_coeff_t *) p->data;
+  pp_table_ptr coeff = p->data;
   int i, n = ainfo->exp2 + 1;
-  for (i=0; i<n; i++) {
-    pp_coeff_ptr pp = coeff[i];
-    element_clear(pp->a);
-    element_clear(pp->b);
-    element_clear(pp->c);
-  }
-  pbc_free(p->data);
+  data = pp_bytes_header(data, PP_BYTES_COEFF, n);
+  for (i = 0; i < n; i++) data += pp_coeff_to_bytes(data, coeff->entry[i]);
+}
+
+static int a_pairing_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing) {
+  a_pairing_data_ptr ainfo = pairing->data;
+  pp_table_ptr coeff;
+  int i, n = ainfo->exp2 + 1;
+  if (!pp_bytes_header_ok(data, PP_BYTES_COEFF, n)) return 0;
+  data += PP_BYTES_HEADER;
+  coeff = p->data = pp_table_new(ainfo->Fq, n, 0);
+  for (i = 0; i < n; i++) data += pp_coeff_from_bytes(coeff, i, data);
+  return 1;
 }
 
 // Requires cofactor to be odd.
 // Overwrites in and temp, out != in.
 // Luckily this touchy routine is only used internally.
 // TODO: rewrite to allow (out == in)? would simplify a_finalpow()
-static void lucas_odd(element_ptr out, element_ptr in, element_ptr temp, mpz_t cofactor) {
+//
+// Stops short of the division in U_k: leaves its numerator in y(out) and
+// the denominator P^2 - 4 in y(temp), so that a batch can share the
+// inversions. lucas_odd_finish() completes out given y(out) divided.
+static void lucas_odd_ladder(element_ptr out, element_ptr in,
+    element_ptr temp, mpz_t cofactor) {
   element_ptr in0 = element_x(in);
-  element_ptr in1 = element_y(in);
   element_ptr v0 = element_x(out);
   element_ptr v1 = element_y(out);
   element_ptr t0 = element_x(temp);
@@ -276,10 +448,17 @@ static void lucas_odd(element_ptr out, element_ptr in, element_ptr temp, mpz_t c
   element_square(t1, t1);
   element_sub(t1, t1, t0);
   element_sub(t1, t1, t0);
-  element_div(v1, v1, t1);
+}
 
-  element_halve(v0, v0);
-  element_mul(v1, v1, in1);
+static void lucas_odd_finish(element_ptr out, element_ptr in) {
+  element_halve(element_x(out), element_x(out));
+  element_mul(element_y(out), element_y(out), element_y(in));
+}
+
+static void lucas_odd(element_ptr out, element_ptr in, element_ptr temp, mpz_t cofactor) {
+  lucas_odd_ladder(out, in, temp, cofactor);
+  element_div(element_y(out), element_y(out), element_y(temp));
+  lucas_odd_finish(out, in);
 }
 
 static inline void a_tateexp(element_ptr out, element_ptr in, element_ptr temp, mpz_t cofactor) {
@@ -302,6 +481,57 @@ static inline void a_tateexp(element_ptr out, element_ptr in, element_ptr temp,
   lucas_odd(out, in, temp, cofactor);
 }
 
+// Step 1 of a_tateexp() on n values at once, in place: f^(q-1) is
+// conj(f) / f, and the n inversions share one through
+// element_multi_invert().
+static void a_tateexp_q1_batch(element_ptr f[], int n) {
+  element_t *inv;
+  int i;
+
+  if (n <= 0) return;
+  inv = pbc_malloc(sizeof(element_t) * n);
+  for (i = 0; i < n; i++) {
+    element_init_same_as(inv[i], f[0]);
+    element_set(inv[i], f[i]);
+  }
+  element_multi_invert(inv, inv, n);
+  for (i = 0; i < n; i++) {
+    element_neg(element_y(f[i]), element_y(f[i]));
+    element_mul(f[i], f[i], inv[i]);
+    element_clear(inv[i]);
+  }
+  pbc_free(inv);
+}
+
+// a_tateexp() on n values at once. The inversions in both steps, one in
+// F_q^2 for q - 1 and one in F_q for the Lucas sequence, are batched.
+// Overwrites in[], out[i] != in[i].
+static void a_tateexp_batch(element_ptr out[], element_ptr in[], int n,
+    mpz_t cofactor) {
+  element_t *temp, *den;
+  int i;
+
+  if (n <= 0) return;
+  a_tateexp_q1_batch(in, n);
+  temp = pbc_malloc(sizeof(element_t) * n);
+  den = pbc_malloc(sizeof(element_t) * n);
+  for (i = 0; i < n; i++) {
+    element_init_same_as(temp[i], in[0]);
+    lucas_odd_ladder(out[i], in[i], temp[i], cofactor);
+    element_init_same_as(den[i], element_y(temp[i]));
+    element_set(den[i], element_y(temp[i]));
+  }
+  element_multi_invert(den, den, n);
+  for (i = 0; i < n; i++) {
+    element_mul(element_y(out[i]), element_y(out[i]), den[i]);
+    lucas_odd_finish(out[i], in[i]);
+    element_clear(temp[i]);
+    element_clear(den[i]);
+  }
+  pbc_free(temp);
+  pbc_free(den);
+}
+
 //computes a Qx + b Qy + c for type A pairing
 static inline void a_miller_evalfn(element_ptr out,
     element_ptr a, element_ptr b, element_ptr c,
@@ -314,14 +544,16 @@ static inline void a_miller_evalfn(element_ptr out,
   element_mul(element_y(out), b, Qy);
 }
 
-static void a_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p) {
+// The Miller loop of a_pairing_pp_apply(), before the final exponentiation.
+static void a_pairing_pp_miller(element_ptr out, element_ptr in2,
+    pairing_pp_t p) {
   //TODO: use proj coords here too to shave off a little time
   element_ptr Qx = curve_x_coord(in2);
   element_ptr Qy = curve_y_coord(in2);
   element_t f, f0;
   int i, n;
   a_pairing_data_ptr ainfo = p->pairing->data;
-  pp_coeff_t *coeff = p->data;
+  void **coeff = ((pp_table_ptr) p->data)->entry;
   element_init(f, ainfo->Fq2);
   element_init(f0, ainfo->Fq2);
 
@@ -329,6 +561,7 @@ static void a_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p)
   n = ainfo->exp1;
   for (i=0; i<n; i++) {
     pp_coeff_ptr pp = coeff[i];
+    pp_prefetch(coeff[i + 1]);
     element_square(f, f);
     a_miller_evalfn(f0, pp->a, pp->b, pp->c, Qx, Qy);
     element_mul(f, f, f0);
@@ -342,6 +575,7 @@ static void a_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p)
   for (; i<n; i++) {
     element_square(f, f);
     pp_coeff_ptr pp = coeff[i];
+    pp_prefetch(coeff[i + 1]);
     a_miller_evalfn(f0, pp->a, pp->b, pp->c, Qx, Qy);
     element_mul(f, f, f0);
   }
@@ -353,12 +587,22 @@ static void a_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p)
     element_mul(f, f, f0);
   }
 
-  a_tateexp(out, f, f0, p->pairing->phikonr);
+  element_set(out, f);
 
   element_clear(f);
   element_clear(f0);
 }
 
+static void a_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p) {
+  element_t f, f0;
+  element_init_same_as(f, out);
+  element_init_same_as(f0, out);
+  a_pairing_pp_miller(f, in2, p);
+  a_tateexp(out, f, f0, p->pairing->phikonr);
+  element_clear(f);
+  element_clear(f0);
+}
+
 // in1, in2 are from E(F_q), out from F_q^2.
 // Pairing via elliptic nets (see Stange).
 static void a_pairing_ellnet(element_ptr out, element_ptr in1, element_ptr in2,
@@ -928,6 +1172,65 @@ static void a_pairing_ellnet_pp_clear(pairing_pp_t p) {
   pbc_free(p->data);
 }
 
+static int ellnet_pp_length_in_bytes(pairing_t pairing, field_ptr f) {
+  int rbits = mpz_sizeinbase(pairing->r, 2);
+  return PP_BYTES_HEADER + (2 + 8 * rbits) * f->fixed_length_in_bytes;
+}
+
+static void a_pairing_ellnet_pp_to_bytes(unsigned char *data, pairing_pp_t p) {
+  ellnet_pp_ptr pp = p->data;
+  int i, rbits = mpz_sizeinbase(p->pairing->r, 2);
+  data = pp_bytes_header(data, PP_BYTES_ELLNET, rbits);
+  data += element_to_bytes(data, pp->x);
+  data += element_to_bytes(data, pp->y);
+  for (i=0; i<rbits; i++) {
+    ellnet_pp_st_ptr seq = pp->seq[i];
+    data += element_to_bytes(data, seq->sm1);
+    data += element_to_bytes(data, seq->s0);
+    data += element_to_bytes(data, seq->s1);
+    data += element_to_bytes(data, seq->s2);
+    data += element_to_bytes(data, seq->tm1);
+    data += element_to_bytes(data, seq->t0);
+    data += element_to_bytes(data, seq->t1);
+    data += element_to_bytes(data, seq->t2);
+  }
+}
+
+static int ellnet_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing, field_ptr f) {
+  int i, rbits = mpz_sizeinbase(pairing->r, 2);
+  ellnet_pp_ptr pp;
+  if (!pp_bytes_header_ok(data, PP_BYTES_ELLNET, rbits)) return 0;
+  data += PP_BYTES_HEADER;
+  pp = p->data = pbc_malloc(sizeof(ellnet_pp_t));
+  pp->seq = pbc_malloc(sizeof(ellnet_pp_st_t) * rbits);
+  data += pp_element_from_bytes(pp->x, f, data);
+  data += pp_element_from_bytes(pp->y, f, data);
+  for (i=0; i<rbits; i++) {
+    ellnet_pp_st_ptr seq = pp->seq[i];
+    data += pp_element_from_bytes(seq->sm1, f, data);
+    data += pp_element_from_bytes(seq->s0, f, data);
+    data += pp_element_from_bytes(seq->s1, f, data);
+    data += pp_element_from_bytes(seq->s2, f, data);
+    data += pp_element_from_bytes(seq->tm1, f, data);
+    data += pp_element_from_bytes(seq->t0, f, data);
+    data += pp_element_from_bytes(seq->t1, f, data);
+    data += pp_element_from_bytes(seq->t2, f, data);
+  }
+  return 1;
+}
+
+static int a_pairing_ellnet_pp_length_in_bytes(pairing_t pairing) {
+  a_pairing_data_ptr ainfo = pairing->data;
+  return ellnet_pp_length_in_bytes(pairing, ainfo->Fq);
+}
+
+static int a_pairing_ellnet_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing) {
+  a_pairing_data_ptr ainfo = pairing->data;
+  return ellnet_pp_from_bytes(p, data, pairing, ainfo->Fq);
+}
+
 static void a_pairing_ellnet_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p) {
   element_ptr x2 = curve_x_coord(in2);
   element_ptr y2 = curve_y_coord(in2);
@@ -1048,8 +1351,9 @@ static void a_pairing_ellnet_pp_apply(element_ptr out, element_ptr in2, pairing_
   element_clear(v);
 }
 
+// The Miller loop of a_pairing_proj(), before the final exponentiation.
 //in1, in2 are from E(F_q), out from F_q^2
-static void a_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
+static void a_miller_proj(element_ptr out, element_ptr in1, element_ptr in2,
     pairing_t pairing) {
   a_pairing_data_ptr p = pairing->data;
   element_t V, V1;
@@ -1177,7 +1481,7 @@ static void a_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
   point_to_affine();
   do_line();
 
-  a_tateexp(out, f, f0, pairing->phikonr);
+  element_set(out, f);
 
   element_clear(f);
   element_clear(f0);
@@ -1196,6 +1500,36 @@ static void a_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
   #undef do_line
 }
 
+//in1, in2 are from E(F_q), out from F_q^2
+static void a_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
+    pairing_t pairing) {
+  element_t f, f0;
+  element_init_same_as(f, out);
+  element_init_same_as(f0, out);
+  a_miller_proj(f, in1, in2, pairing);
+  a_tateexp(out, f, f0, pairing->phikonr);
+  element_clear(f);
+  element_clear(f0);
+}
+
+// n pairings whose final exponentiations run together.
+static void a_pairing_proj_batch(element_ptr out[], element_ptr in1[],
+    element_ptr in2[], int n, pairing_t pairing) {
+  element_t *f = pbc_malloc(sizeof(element_t) * n);
+  element_ptr *fp = pbc_malloc(sizeof(element_ptr) * n);
+  int i;
+
+  for (i = 0; i < n; i++) {
+    element_init_same_as(f[i], out[i]);
+    a_miller_proj(f[i], in1[i], in2[i], pairing);
+    fp[i] = f[i];
+  }
+  a_tateexp_batch(out, fp, n, pairing->phikonr);
+  for (i = 0; i < n; i++) element_clear(f[i]);
+  pbc_free(f);
+  pbc_free(fp);
+}
+
 //in1, in2 are from E(F_q), out from F_q^2
 static void a_pairing_affine(element_ptr out, element_ptr in1, element_ptr in2,
     pairing_t pairing) {
@@ -1402,16 +1736,29 @@ static void a_pairing_option_set(pairing_t pairing, char *key, char *value) {
       pairing->pp_init = a_pairing_pp_init;
       pairing->pp_clear = a_pairing_pp_clear;
       pairing->pp_apply = a_pairing_pp_apply;
+      pairing->pp_miller = a_pairing_pp_miller;
+      pairing->pp_length_in_bytes = a_pairing_pp_length_in_bytes;
+      pairing->pp_to_bytes = a_pairing_pp_to_bytes;
+      pairing->pp_from_bytes = a_pairing_pp_from_bytes;
     } else if (!strcmp(value, "miller-affine")) {
       pairing->map = a_pairing_affine;
       pairing->pp_init = a_pairing_pp_init;
       pairing->pp_clear = a_pairing_pp_clear;
       pairing->pp_apply = a_pairing_pp_apply;
+      pairing->pp_miller = a_pairing_pp_miller;
+      pairing->pp_length_in_bytes = a_pairing_pp_length_in_bytes;
+      pairing->pp_to_bytes = a_pairing_pp_to_bytes;
+      pairing->pp_from_bytes = a_pairing_pp_from_bytes;
     } else if (!strcmp(value, "shipsey-stange")) {
       pairing->map = a_pairing_ellnet;
       pairing->pp_init = a_pairing_ellnet_pp_init;
       pairing->pp_clear = a_pairing_ellnet_pp_clear;
       pairing->pp_apply = a_pairing_ellnet_pp_apply;
+      // Elliptic net precomputation has no separate Miller loop.
+      pairing->pp_miller = NULL;
+      pairing->pp_length_in_bytes = a_pairing_ellnet_pp_length_in_bytes;
+      pairing->pp_to_bytes = a_pairing_ellnet_pp_to_bytes;
+      pairing->pp_from_bytes = a_pairing_ellnet_pp_from_bytes;
     }
   }
 }
@@ -1427,6 +1774,26 @@ static void a_finalpow(element_t e) {
   element_clear(t1);
 }
 
+// a_finalpow() on n values of F_q^2 at once, through a_tateexp_batch().
+static void a_finalpow_batch(element_ptr v[], int n) {
+  pairing_ptr pairing = v[0]->field->pairing;
+  element_t *t = pbc_malloc(sizeof(element_t) * n);
+  element_ptr *tp = pbc_malloc(sizeof(element_ptr) * n);
+  int i;
+
+  for (i = 0; i < n; i++) {
+    element_init_same_as(t[i], v[i]);
+    tp[i] = t[i];
+  }
+  a_tateexp_batch(tp, v, n, pairing->phikonr);
+  for (i = 0; i < n; i++) {
+    element_set(v[i], t[i]);
+    element_clear(t[i]);
+  }
+  pbc_free(t);
+  pbc_free(tp);
+}
+
 static void a_init_pairing(pairing_ptr pairing, void *data) {
   a_param_ptr param = data;
   element_t a, b;
@@ -1440,6 +1807,8 @@ static void a_init_pairing(pairing_ptr pairing, void *data) {
   mpz_set(pairing->r, param->r);
   field_init_fp(pairing->Zr, pairing->r);
   pairing->map = a_pairing_proj;
+  pairing->map_batch = a_pairing_proj_batch;
+  pairing->miller = a_miller_proj;
   pairing->prod_pairings = a_pairings_affine;
 
   field_init_fp(p->Fq, param->q);
@@ -1462,12 +1831,20 @@ static void a_init_pairing(pairing_ptr pairing, void *data) {
   pairing->phi = phi_identity;
   pairing_GT_init(pairing, p->Fq2);
   pairing->finalpow = a_finalpow;
+  pairing->finalpow_batch = a_finalpow_batch;
+  // GT lies in the subgroup of norm 1 of F_q^2.
+  pairing->gt_pow_mpz = element_fi_unitary_pow_mpz;
+  pairing->gt_pow_mpz_ct = element_fi_unitary_pow_mpz_ct;
 
   pairing->clear_func = a_pairing_clear;
   pairing->option_set = a_pairing_option_set;
   pairing->pp_init = a_pairing_pp_init;
   pairing->pp_clear = a_pairing_pp_clear;
   pairing->pp_apply = a_pairing_pp_apply;
+  pairing->pp_miller = a_pairing_pp_miller;
+  pairing->pp_length_in_bytes = a_pairing_pp_length_in_bytes;
+  pairing->pp_to_bytes = a_pairing_pp_to_bytes;
+  pairing->pp_from_bytes = a_pairing_pp_from_bytes;
 }
 
 static void a_param_init(pbc_param_ptr par) {
@@ -1475,6 +1852,7 @@ static void a_param_init(pbc_param_ptr par) {
     a_clear,
     a_init_pairing,
     a_out_str,
+    NULL,
   }};
   par->api = interface;
   a_param_ptr p = par->data = pbc_malloc(sizeof(*p));
@@ -1591,26 +1969,21 @@ static void a1_out_str(FILE *stream, void *data) {
   param_out_int(stream, "l", p->l);
 }
 
-struct pp2_coeff_s {
-  element_t cx2;
-  element_t cy2;
-  element_t cxy;
-  element_t cx;
-  element_t cy;
-  element_t c;
-};
-typedef struct pp2_coeff_s pp2_coeff_t[1];
-typedef struct pp2_coeff_s *pp2_coeff_ptr;
+static pp2_coeff_ptr pp2_coeff_new(pp_table_ptr t) {
+  pp2_coeff_ptr p = pp_table_alloc(t, sizeof(*p));
+  pp_table_element_init(t, p->cx2);
+  pp_table_element_init(t, p->cy2);
+  pp_table_element_init(t, p->cxy);
+  pp_table_element_init(t, p->cx);
+  pp_table_element_init(t, p->cy);
+  pp_table_element_init(t, p->c);
+  return p;
+}
 
-static void pp2_coeff_set(pp2_coeff_ptr p,
+static void pp2_coeff_set(pp_table_ptr t, int i,
     element_t cx2, element_t cy2, element_t cxy,
     element_t cx, element_t cy, element_t c) {
-  element_init(p->cx2, cx2->field);
-  element_init(p->cy2, cy2->field);
-  element_init(p->cxy, cxy->field);
-  element_init(p->cx, cx->field);
-  element_init(p->cy, cy->field);
-  element_init(p->c, c->field);
+  pp2_coeff_ptr p = t->entry[i] = pp2_coeff_new(t);
   element_set(p->cx2, cx2);
   element_set(p->cy2, cy2);
   element_set(p->cxy, cxy);
@@ -1619,13 +1992,29 @@ static void pp2_coeff_set(pp2_coeff_ptr p,
   element_set(p->c, c);
 }
 
+// Entries hold six coefficients where bit m of r is set, three elsewhere
+// and in the last one, where m = 0.
 static void a1_pairing_pp_clear(pairing_pp_t p) {
-  void **pp = p->data;
+  pp_table_ptr t = p->data;
+  void **pp = t->entry;
+  int m = mpz_sizeinbase(p->pairing->r, 2) - 2;
   while (*pp) {
-    pbc_free(*pp);
+    if (m > 0 && mpz_tstbit(p->pairing->r, m)) pp_table_free_coeff2(t, *pp);
+    else pp_table_free_coeff(t, *pp);
     pp++;
+    m--;
   }
-  pbc_free(p->data);
+  pp_table_free(t);
+}
+
+// A table for the entries of a1_pairing_pp_init().
+static pp_table_ptr a1_pp_table_new(pairing_t pairing) {
+  a1_pairing_data_ptr a1info = pairing->data;
+  int m, n2 = 0;
+  for (m = mpz_sizeinbase(pairing->r, 2) - 2; m > 0; m--) {
+    n2 += mpz_tstbit(pairing->r, m);
+  }
+  return pp_table_new(a1info->Fp, mpz_sizeinbase(pairing->r, 2) - 1, n2);
 }
 
 static void a1_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairing) {
@@ -1633,8 +2022,8 @@ static void a1_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairin
   element_ptr Px = curve_x_coord(in1);
   element_ptr Py = curve_y_coord(in1);
   a1_pairing_data_ptr a1info = pairing->data;
-  p->data = pbc_malloc(sizeof(void *) * mpz_sizeinbase(pairing->r, 2));
-  void **pp = p->data;
+  pp_table_ptr t = p->data = a1_pp_table_new(pairing);
+  int i = 0;
   element_t V;
   element_t a, b, c;
   element_t a2, b2, c2;
@@ -1695,19 +2084,14 @@ static void a1_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairin
       //b = coeff of y^2
       element_mul(b, b, b2);
 
-      *pp = pbc_malloc(sizeof(pp2_coeff_t));
-      pp2_coeff_set(*pp, a, b, c2, e0, e1, c);
+      pp2_coeff_set(t, i, a, b, c2, e0, e1, c);
     } else {
-      *pp = pbc_malloc(sizeof(pp_coeff_t));
-      pp_coeff_set(*pp, a, b, c);
+      pp_coeff_set(t, i, a, b, c);
     }
-    pp++;
+    i++;
     m--;
   }
-  *pp = pbc_malloc(sizeof(pp_coeff_t));
-  pp_coeff_set(*pp, a, b, c);
-  pp++;
-  *pp = NULL;
+  pp_coeff_set(t, i, a, b, c);
 
   element_clear(a2);
   element_clear(b2);
@@ -1723,8 +2107,79 @@ static void a1_pairing_pp_init(pairing_pp_t p, element_ptr in1, pairing_t pairin
   #undef do_line
 }
 
+static int pp2_coeff_from_bytes(pp_table_ptr t, int i, unsigned char *data) {
+  pp2_coeff_ptr p = t->entry[i] = pp2_coeff_new(t);
+  int len = element_from_bytes(p->cx2, data);
+  len += element_from_bytes(p->cy2, data + len);
+  len += element_from_bytes(p->cxy, data + len);
+  len += element_from_bytes(p->cx, data + len);
+  len += element_from_bytes(p->cy, data + len);
+  len += element_from_bytes(p->c, data + len);
+  return len;
+}
+
+static int pp2_coeff_to_bytes(unsigned char *data, pp2_coeff_ptr p) {
+  int len = element_to_bytes(data, p->cx2);
+  len += element_to_bytes(data + len, p->cy2);
+  len += element_to_bytes(data + len, p->cxy);
+  len += element_to_bytes(data + len, p->cx);
+  len += element_to_bytes(data + len, p->cy);
+  len += element_to_bytes(data + len, p->c);
+  return len;
+}
+
+// The entries of a1_pairing_pp_init() as listed in a1_pairing_pp_clear():
+// a line and a tangent together for each set bit of r below the top one
+// but bit 0, a tangent alone for each clear one and for the last step.
+static int a1_pairing_pp_length_in_bytes(pairing_t pairing) {
+  a1_pairing_data_ptr a1info = pairing->data;
+  int m, count = 3;
+  for (m = mpz_sizeinbase(pairing->r, 2) - 2; m > 0; m--) {
+    count += mpz_tstbit(pairing->r, m) ? 6 : 3;
+  }
+  return PP_BYTES_HEADER + count * a1info->Fp->fixed_length_in_bytes;
+}
+
+static void a1_pairing_pp_to_bytes(unsigned char *data, pairing_pp_t p) {
+  void **pp = ((pp_table_ptr) p->data)->entry;
+  int m = mpz_sizeinbase(p->pairing->r, 2) - 2;
+  data = pp_bytes_header(data, PP_BYTES_A1_COEFF, m + 1);
+  for (; m > 0; m--, pp++) {
+    if (mpz_tstbit(p->pairing->r, m)) data += pp2_coeff_to_bytes(data, *pp);
+    else data += pp_coeff_to_bytes(data, *pp);
+  }
+  pp_coeff_to_bytes(data, *pp);
+}
+
+static int a1_pairing_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing) {
+  int m = mpz_sizeinbase(pairing->r, 2) - 2;
+  int i = 0;
+  pp_table_ptr t;
+  if (!pp_bytes_header_ok(data, PP_BYTES_A1_COEFF, m + 1)) return 0;
+  data += PP_BYTES_HEADER;
+  t = p->data = a1_pp_table_new(pairing);
+  for (; m > 0; m--, i++) {
+    if (mpz_tstbit(pairing->r, m)) data += pp2_coeff_from_bytes(t, i, data);
+    else data += pp_coeff_from_bytes(t, i, data);
+  }
+  pp_coeff_from_bytes(t, i, data);
+  return 1;
+}
+
+static int a1_pairing_ellnet_pp_length_in_bytes(pairing_t pairing) {
+  a1_pairing_data_ptr a1info = pairing->data;
+  return ellnet_pp_length_in_bytes(pairing, a1info->Fp);
+}
+
+static int a1_pairing_ellnet_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing) {
+  a1_pairing_data_ptr a1info = pairing->data;
+  return ellnet_pp_from_bytes(p, data, pairing, a1info->Fp);
+}
+
 static void a1_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p) {
-  void **pp = p->data;
+  void **pp = ((pp_table_ptr) p->data)->entry;
   a1_pairing_data_ptr a1info = p->pairing->data;
   element_t f, f0;
   element_t e0, e1;
@@ -1782,6 +2237,7 @@ static void a1_pairing_pp_apply(element_ptr out, element_ptr in2, pairing_pp_t p
     }
     element_mul(f, f, f0);
     pp++;
+    pp_prefetch(pp[1]);
     m--;
     element_square(f, f);
   }
@@ -1834,8 +2290,10 @@ static void compute_abc_line_proj(element_ptr a, element_ptr b, element_ptr c,
 }
 
 // in1, in2 are from E(F_q), out from F_q^2
-static void a1_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
-    pairing_t pairing) {
+// The Miller loop of a1_pairing_proj(), before the final exponentiation,
+// over 'order': r, or a factor of it that the order of in1 divides.
+static void a1_miller_proj_order(element_ptr out, element_ptr in1,
+    element_ptr in2, mpz_ptr order, pairing_t pairing) {
   a1_pairing_data_ptr p = pairing->data;
   element_t V;
   element_t z, z2;
@@ -1963,14 +2421,14 @@ static void a1_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
   element_set1(z);
   element_set1(z2);
 
-  m = mpz_sizeinbase(pairing->r, 2) - 2;
+  m = mpz_sizeinbase(order, 2) - 2;
   //TODO: sliding NAF
   for(;;) {
     do_tangent();
     if (!m) break;
 
     proj_double(); //V=2V
-    if (mpz_tstbit(pairing->r, m)) {
+    if (mpz_tstbit(order, m)) {
      // point_to_affine();
       do_line();
       proj_add(); //V=V+in1
@@ -1980,18 +2438,7 @@ static void a1_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
     element_square(f, f);
   }
 
-  // Tate exponentiation.
-  // Simpler but slower:
-  //   element_pow_mpz(out, f, p->tateexp);
-  // Use this trick instead:
-  element_invert(f0, f);
-  element_neg(element_y(f), element_y(f));
-  element_mul(f, f, f0);
-  element_pow_mpz(out, f, pairing->phikonr);
-
-  /* We could use this instead but p->h is small so this does not help much
-  a_tateexp(out, f, f0, p->h);
-  */
+  element_set(out, f);
 
   element_clear(f);
   element_clear(f0);
@@ -2009,6 +2456,69 @@ static void a1_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
   #undef do_line
 }
 
+static void a1_miller_proj(element_ptr out, element_ptr in1, element_ptr in2,
+    pairing_t pairing) {
+  a1_miller_proj_order(out, in1, in2, pairing->r, pairing);
+}
+
+static void a1_pairing_proj(element_ptr out, element_ptr in1, element_ptr in2,
+    pairing_t pairing) {
+  element_t f, f0;
+  element_init_same_as(f, out);
+  element_init_same_as(f0, out);
+  a1_miller_proj(f, in1, in2, pairing);
+
+  // Tate exponentiation.
+  // Simpler but slower:
+  //   element_pow_mpz(out, f, p->tateexp);
+  // Use this trick instead:
+  element_invert(f0, f);
+  element_neg(element_y(f), element_y(f));
+  element_mul(f, f, f0);
+  element_pow_mpz(out, f, pairing->phikonr);
+
+  /* We could use this instead but p->h is small so this does not help much
+  a_tateexp(out, f, f0, p->h);
+  */
+
+  element_clear(f);
+  element_clear(f0);
+}
+
+// For an in1 of order dividing 'order', a factor of r: the Miller function
+// of r is that of 'order' raised to r/order, up to a constant the final
+// exponentiation removes, so the loop only runs over the bits of 'order'
+// and the final exponent grows to (q^2 - 1)/order instead.
+static void a1_pairing_subgroup(element_ptr out, element_ptr in1,
+    element_ptr in2, mpz_ptr order, pairing_t pairing) {
+  element_t f, f0;
+  mpz_t e;
+  element_init_same_as(f, out);
+  element_init_same_as(f0, out);
+  mpz_init(e);
+  a1_miller_proj_order(f, in1, in2, order, pairing);
+
+  element_invert(f0, f);
+  element_neg(element_y(f), element_y(f));
+  element_mul(f, f, f0);
+  mpz_divexact(e, pairing->r, order);
+  mpz_mul(e, e, pairing->phikonr);
+  element_fi_unitary_pow_mpz(out, f, e);
+
+  mpz_clear(e);
+  element_clear(f);
+  element_clear(f0);
+}
+
+// n pairings sharing the inversion in the final exponentiation.
+static void a1_pairing_proj_batch(element_ptr out[], element_ptr in1[],
+    element_ptr in2[], int n, pairing_t pairing) {
+  int i;
+  for (i = 0; i < n; i++) a1_miller_proj(out[i], in1[i], in2[i], pairing);
+  a_tateexp_q1_batch(out, n);
+  for (i = 0; i < n; i++) element_pow_mpz(out[i], out[i], pairing->phikonr);
+}
+
 //in1, in2 are from E(F_q), out from F_q^2
 static void a1_pairing(element_ptr out, element_ptr in1, element_ptr in2,
     pairing_t pairing) {
@@ -2206,16 +2716,25 @@ static void a1_pairing_option_set(pairing_t pairing, char *key, char *value) {
       pairing->pp_init = a1_pairing_pp_init;
       pairing->pp_clear = a1_pairing_pp_clear;
       pairing->pp_apply = a1_pairing_pp_apply;
+      pairing->pp_length_in_bytes = a1_pairing_pp_length_in_bytes;
+      pairing->pp_to_bytes = a1_pairing_pp_to_bytes;
+      pairing->pp_from_bytes = a1_pairing_pp_from_bytes;
     } else if (!strcmp(value, "miller-affine")){
       pairing->map = a1_pairing;
       pairing->pp_init = a1_pairing_pp_init;
       pairing->pp_clear = a1_pairing_pp_clear;
       pairing->pp_apply = a1_pairing_pp_apply;
+      pairing->pp_length_in_bytes = a1_pairing_pp_length_in_bytes;
+      pairing->pp_to_bytes = a1_pairing_pp_to_bytes;
+      pairing->pp_from_bytes = a1_pairing_pp_from_bytes;
     } else if (!strcmp(value, "shipsey-stange")) {
       pairing->map = a_pairing_ellnet;
       pairing->pp_init = a_pairing_ellnet_pp_init;
       pairing->pp_clear = a_pairing_ellnet_pp_clear;
       pairing->pp_apply = a_pairing_ellnet_pp_apply;
+      pairing->pp_length_in_bytes = a1_pairing_ellnet_pp_length_in_bytes;
+      pairing->pp_to_bytes = a_pairing_ellnet_pp_to_bytes;
+      pairing->pp_from_bytes = a1_pairing_ellnet_pp_from_bytes;
     }
   }
 }
@@ -2250,11 +2769,17 @@ static void a1_init_pairing(pairing_t pairing, void *data) {
   field_init_fi(p->Fp2, p->Fp);
 
   pairing->finalpow = a_finalpow;
+  pairing->finalpow_batch = a_finalpow_batch;
   pairing->G1 = pbc_malloc(sizeof(field_t));
   pairing->G2 = pairing->G1 = p->Ep;
   pairing_GT_init(pairing, p->Fp2);
+  pairing->gt_pow_mpz = element_fi_unitary_pow_mpz;
+  pairing->gt_pow_mpz_ct = element_fi_unitary_pow_mpz_ct;
 
   pairing->map = a1_pairing_proj; //default uses projective coordinates.
+  pairing->map_batch = a1_pairing_proj_batch;
+  pairing->miller = a1_miller_proj;
+  pairing->subgroup_map = a1_pairing_subgroup;
   pairing->phi = phi_identity;
   pairing->prod_pairings = a1_pairings_affine;
 
@@ -2263,6 +2788,9 @@ static void a1_init_pairing(pairing_t pairing, void *data) {
   pairing->pp_init = a1_pairing_pp_init;
   pairing->pp_clear = a1_pairing_pp_clear;
   pairing->pp_apply = a1_pairing_pp_apply;
+  pairing->pp_length_in_bytes = a1_pairing_pp_length_in_bytes;
+  pairing->pp_to_bytes = a1_pairing_pp_to_bytes;
+  pairing->pp_from_bytes = a1_pairing_pp_from_bytes;
   pairing->option_set = a1_pairing_option_set;
 }
 
@@ -2271,6 +2799,7 @@ static void a1_init(pbc_param_t p) {
     a1_clear,
     a1_init_pairing,
     a1_out_str,
+    NULL,
   }};
   p->api = interface;
   a1_param_ptr param = p->data = pbc_malloc(sizeof(*param));
@@ -13,6 +13,8 @@
 #include "pbc_memory.h"
 #include "pbc_random.h"
 #include "misc/darray.h"
+#include "arith/recode.h"
+#include "arith/montfp.h"
 
 // Per-field data.
 typedef struct {
@@ -31,6 +33,8 @@ typedef struct {
   // representatives. Thus for a comparison, we must multiply by quotient_cmp
   // before comparing.
   mpz_ptr quotient_cmp;
+  // Non-NULL if curve_pow_mpz() may use an endomorphism, see glv_init().
+  struct glv_s *glv;
 } *curve_data_ptr;
 
 // Per-element data. Elements of this group are points on the elliptic curve.
@@ -54,6 +58,16 @@ static void curve_clear(element_ptr e) {
   pbc_free(e->data);
 }
 
+// The data of the coordinates follow the per-element data.
+static void curve_init_packed(element_ptr e, void *mem) {
+  curve_data_ptr cdp = e->field->data;
+  point_ptr p = e->data = mem;
+  unsigned char *next = (unsigned char *) (p + 1);
+  element_init_packed(p->x, cdp->field, next);
+  element_init_packed(p->y, cdp->field, next + cdp->field->packed_size);
+  p->inf_flag = 1;
+}
+
 static int curve_is_valid_point(element_ptr e) {
   element_t t0, t1;
   int result;
@@ -99,6 +113,16 @@ static void curve_set(element_ptr c, element_ptr a) {
   element_set(r->y, p->y);
 }
 
+static void point_cmov(point_ptr r, point_ptr p, int bit) {
+  element_cmov(r->x, p->x, bit);
+  element_cmov(r->y, p->y, bit);
+  r->inf_flag ^= (r->inf_flag ^ p->inf_flag) & -(bit & 1);
+}
+
+static void curve_cmov(element_ptr c, element_ptr a, int bit) {
+  point_cmov(c->data, a->data, bit);
+}
+
 static inline void double_no_check(point_ptr r, point_ptr p, element_ptr a) {
   element_t lambda, e0, e1;
   field_ptr f = r->x->field;
@@ -206,6 +230,12 @@ static void curve_mul(element_ptr c, element_ptr a, element_ptr b) {
   }
 }
 
+// Points that multi_double() maps to O: the identity and points of order
+// 2. They stay out of the shared inversion, as their 2y is zero.
+static inline int double_no_slope(point_ptr q) {
+  return q->inf_flag || element_is0(q->y);
+}
+
 //compute c_i=a_i+a_i at one time.
 static void multi_double(element_ptr c[], element_ptr a[], int n) {
   int i;
@@ -219,22 +249,15 @@ static void multi_double(element_ptr c[], element_ptr a[], int n) {
   element_init(e1,q->y->field);
   element_init(e2,q->y->field);
 
+  //to compute 1/2y multi. see Cohen's GTM139 Algorithm 10.3.4
   for(i=0; i<n; i++){
-    q=a[i]->data; r=c[i]->data;
+    q=a[i]->data;
     element_init(table[i],q->y->field);
-
-    if (q->inf_flag) {
-      r->inf_flag = 1;
-      continue;
-    }
-    if (element_is0(q->y)) {
-      r->inf_flag = 1;
+    if (double_no_slope(q)) {
+      if (i > 0) element_set(table[i], table[i-1]);
+      else element_set1(table[i]);
       continue;
     }
-  }
-  //to compute 1/2y multi. see Cohen's GTM139 Algorithm 10.3.4
-  for(i=0; i<n; i++){
-    q=a[i]->data;
     element_double(table[i],q->y);
     if(i>0) element_mul(table[i],table[i],table[i-1]);
   }
@@ -242,6 +265,7 @@ static void multi_double(element_ptr c[], element_ptr a[], int n) {
   for(i=n-1; i>0; i--){
     q=a[i]->data;
     element_mul(table[i],table[i-1],e2);
+    if (double_no_slope(q)) continue;
     element_mul(e2,e2,q->y);
     element_double(e2,e2); //e2=e2*2y_j
   }
@@ -250,11 +274,15 @@ static void multi_double(element_ptr c[], element_ptr a[], int n) {
   for(i=0; i<n; i++){
     q=a[i]->data;
     r=c[i]->data;
-    if(r->inf_flag) continue;
+    if (double_no_slope(q)) {
+      r->inf_flag = 1;
+      continue;
+    }
 
     //e2=lambda = (3x^2 + a) / 2y
     element_square(e2, q->x);
-    element_mul_si(e2, e2, 3);
+    element_double(e1, e2);
+    element_add(e2, e2, e1);
     element_add(e2, e2, cdp->a);
 
     element_mul(e2, e2, table[i]); //Recall that table[i]=1/2y_i
@@ -280,6 +308,13 @@ static void multi_double(element_ptr c[], element_ptr a[], int n) {
   pbc_free(table);
 }
 
+// Pairs that the final loop of multi_add() handles without a slope: the
+// identity, doubling and inverses. They must stay out of the shared
+// inversion, where a zero x2 - x1 would spoil every other slope.
+static inline int add_no_slope(point_ptr p, point_ptr q) {
+  return p->inf_flag || q->inf_flag || !element_cmp(p->x, q->x);
+}
+
 //compute c_i=a_i+b_i at one time.
 static void multi_add(element_ptr c[], element_ptr a[], element_ptr b[], int n){
   int i;
@@ -295,11 +330,16 @@ static void multi_add(element_ptr c[], element_ptr a[], element_ptr b[], int n){
   element_init(e2, p->x->field);
 
   element_init(table[0], p->x->field);
-  element_sub(table[0], q->x, p->x);
+  if (add_no_slope(p, q)) element_set1(table[0]);
+  else element_sub(table[0], q->x, p->x);
   for(i=1; i<n; i++){
     p = a[i]->data;
     q = b[i]->data;
     element_init(table[i], p->x->field);
+    if (add_no_slope(p, q)) {
+      element_set(table[i], table[i-1]);
+      continue;
+    }
     element_sub(table[i], q->x, p->x);
     element_mul(table[i], table[i], table[i-1]);
   }
@@ -308,6 +348,7 @@ static void multi_add(element_ptr c[], element_ptr a[], element_ptr b[], int n){
     p = a[i]->data;
     q = b[i]->data;
     element_mul(table[i], table[i-1], e2);
+    if (add_no_slope(p, q)) continue;
     element_sub(e1, q->x, p->x);
     element_mul(e2,e2,e1); //e2=e2*(x2_j-x1_j)
   }
@@ -365,6 +406,1192 @@ static void multi_add(element_ptr c[], element_ptr a[], element_ptr b[], int n){
 }
 
 
+// Jacobian coordinates: (X : Y : Z) stands for the affine point
+// (X / Z^2, Y / Z^3), and Z = 0 for O. Scalar multiplication works in them
+// and converts back once, instead of inverting on every group operation
+// as curve_mul() and double_no_check() do. Points outside these routines
+// stay affine.
+typedef struct {
+  element_t x, y, z;
+} jac_t;
+
+// Temporaries for the Jacobian routines, and the shape of a.
+typedef struct {
+  element_t t[7];
+  element_ptr a;
+  int a_kind;  // 0 if a = 0, 1 if a = 1, otherwise 2.
+  // The modulus if the field allows the direct path, otherwise NULL.
+  const mp_limb_t *p;
+  int ct;  // Nonzero if Z depends on a secret: invert it in constant time.
+} *jac_ctx_ptr;
+
+static jac_ctx_ptr jac_ctx_new(curve_data_ptr cdp) {
+  jac_ctx_ptr j = pbc_malloc(sizeof(*j));
+  int i;
+  for (i = 0; i < 7; i++) element_init(j->t[i], cdp->field);
+  j->a = cdp->a;
+  j->a_kind = element_is0(cdp->a) ? 0 : element_is1(cdp->a) ? 1 : 2;
+#if MONT_DIRECT_LIMBS
+  j->p = mont_direct_modulus(cdp->field);
+#else
+  j->p = NULL;
+#endif
+  j->ct = 0;
+  return j;
+}
+
+static void jac_ctx_free(jac_ctx_ptr j) {
+  int i;
+  for (i = 0; i < 7; i++) element_clear(j->t[i]);
+  pbc_free(j);
+}
+
+static void jac_init(jac_t *r, field_ptr f) {
+  element_init(r->x, f);
+  element_init(r->y, f);
+  element_init(r->z, f);
+}
+
+static void jac_clear(jac_t *r) {
+  element_clear(r->x);
+  element_clear(r->y);
+  element_clear(r->z);
+}
+
+static void jac_from_point(jac_t *r, point_ptr p) {
+  if (p->inf_flag) {
+    element_set0(r->z);
+    return;
+  }
+  element_set(r->x, p->x);
+  element_set(r->y, p->y);
+  element_set1(r->z);
+}
+
+#if MONT_DIRECT_LIMBS
+// jac_double() and jac_add_point() on the limbs of the coordinates, for
+// the direct path of montfp.h; p->z is nonzero, and so is q. A square
+// costs as much as a product there, so 2 Y Z, 4 X Y^2 and 2 Z1 H are
+// products rather than differences of squares, and the products making up
+// Y3 share one reduction.
+#define DN MONT_DIRECT_LIMBS
+#define ADD(c, a, b) mont_direct_add(c, a, b, P)
+#define SUB(c, a, b) mont_direct_sub(c, a, b, P)
+#define MUL(c, a, b) mont_direct_mul(c, a, b, f)
+
+static void jac_double_direct(jac_t *r, jac_t *p, jac_ctx_ptr j) {
+  const mp_limb_t *P = j->p;
+  field_ptr f = p->x->field;
+  const mp_limb_t *x = mont_direct_get(p->x), *y = mont_direct_get(p->y);
+  const mp_limb_t *z = mont_direct_get(p->z);
+  mp_limb_t xx[DN], yy[DN], t[DN], zz[DN], s[DN], m[DN];
+  mp_limb_t x3[DN], y3[DN], z3[DN];
+
+  MUL(xx, x, x);
+  MUL(yy, y, y);
+  MUL(zz, z, z);
+  MUL(z3, y, z);
+  ADD(z3, z3, z3);
+  MUL(s, x, yy);
+  ADD(s, s, s);
+  ADD(s, s, s);
+  ADD(m, xx, xx);
+  ADD(m, m, xx);
+  if (j->a_kind) {
+    MUL(zz, zz, zz);
+    if (j->a_kind == 2) MUL(zz, zz, mont_direct_get(j->a));
+    ADD(m, m, zz);
+  }
+  MUL(x3, m, m);
+  SUB(x3, x3, s);
+  SUB(x3, x3, s);
+  SUB(s, s, x3);
+  // Y3 = M (S - X3) - 8 Y^4.
+  ADD(t, yy, yy);
+  ADD(t, t, t);
+  ADD(t, t, t);
+  mont_direct_neg(t, t, P);
+  mont_direct_mul2_add(y3, s, m, t, yy, f);
+  mont_direct_set(r->x, x3);
+  mont_direct_set(r->y, y3);
+  mont_direct_set(r->z, z3);
+}
+
+static void jac_add_point_direct(jac_t *r, jac_t *p, point_ptr q, int neg,
+                                 jac_ctx_ptr j) {
+  const mp_limb_t *P = j->p;
+  field_ptr f = p->x->field;
+  const mp_limb_t *x1 = mont_direct_get(p->x), *y1 = mont_direct_get(p->y);
+  const mp_limb_t *z1 = mont_direct_get(p->z);
+  const mp_limb_t *x2 = mont_direct_get(q->x), *y2 = mont_direct_get(q->y);
+  mp_limb_t z1z1[DN], h[DN], s2[DN], rr[DN], hh[DN], v[DN], jj[DN];
+  mp_limb_t x3[DN], y3[DN], z3[DN];
+
+  MUL(z1z1, z1, z1);
+  MUL(h, x2, z1z1);
+  SUB(h, h, x1);
+  MUL(s2, z1, z1z1);
+  MUL(s2, s2, y2);
+  if (neg) mont_direct_neg(s2, s2, P);
+  SUB(rr, s2, y1);
+  if (mont_direct_is0(h)) {
+    if (mont_direct_is0(rr)) jac_double_direct(r, p, j);
+    else element_set0(r->z);
+    return;
+  }
+  ADD(rr, rr, rr);
+  MUL(hh, h, h);
+  ADD(v, hh, hh);
+  ADD(v, v, v);
+  MUL(jj, h, v);
+  MUL(v, v, x1);
+  MUL(z3, z1, h);
+  ADD(z3, z3, z3);
+  MUL(x3, rr, rr);
+  SUB(x3, x3, jj);
+  SUB(x3, x3, v);
+  SUB(x3, x3, v);
+  // Y3 = r (V - X3) - 2 Y1 J.
+  SUB(h, v, x3);
+  ADD(s2, y1, y1);
+  mont_direct_neg(s2, s2, P);
+  mont_direct_mul2_add(y3, h, rr, s2, jj, f);
+  mont_direct_set(r->x, x3);
+  mont_direct_set(r->y, y3);
+  mont_direct_set(r->z, z3);
+}
+
+#undef DN
+#undef ADD
+#undef SUB
+#undef MUL
+#endif
+
+// r = 2p, where r may be p. dbl-2007-bl from the Explicit-Formulas
+// Database: 1M + 8S with a = 0 or 1, 2M + 8S otherwise.
+static void jac_double(jac_t *r, jac_t *p, jac_ctx_ptr j) {
+  element_ptr xx = j->t[0], yy = j->t[1], yyyy = j->t[2], zz = j->t[3];
+  element_ptr s = j->t[4], m = j->t[5], z3 = j->t[6];
+
+  if (element_is0(p->z)) {
+    element_set0(r->z);
+    return;
+  }
+#if MONT_DIRECT_LIMBS
+  if (j->p) {
+    jac_double_direct(r, p, j);
+    return;
+  }
+#endif
+  element_square(xx, p->x);
+  element_square(yy, p->y);
+  element_square(yyyy, yy);
+  element_square(zz, p->z);
+  // Z3 = (Y + Z)^2 - YY - ZZ = 2YZ, which is 0 when Y is.
+  element_add(z3, p->y, p->z);
+  element_square(z3, z3);
+  element_sub(z3, z3, yy);
+  element_sub(z3, z3, zz);
+  // S = 2((X + YY)^2 - XX - YYYY) = 4 X YY
+  element_add(s, p->x, yy);
+  element_square(s, s);
+  element_sub(s, s, xx);
+  element_sub(s, s, yyyy);
+  element_double(s, s);
+  // M = 3 XX + a ZZ^2
+  element_double(m, xx);
+  element_add(m, m, xx);
+  if (j->a_kind) {
+    element_square(zz, zz);
+    if (j->a_kind == 2) element_mul(zz, zz, j->a);
+    element_add(m, m, zz);
+  }
+  // X3 = M^2 - 2S, Y3 = M(S - X3) - 8 YYYY
+  element_square(r->x, m);
+  element_sub(r->x, r->x, s);
+  element_sub(r->x, r->x, s);
+  element_sub(s, s, r->x);
+  element_mul(s, s, m);
+  element_double(yyyy, yyyy);
+  element_double(yyyy, yyyy);
+  element_double(yyyy, yyyy);
+  element_sub(r->y, s, yyyy);
+  element_set(r->z, z3);
+}
+
+// r = p + q, or p - q if neg, for affine q, where r may be p.
+// madd-2007-bl: 7M + 4S.
+static void jac_add_point(jac_t *r, jac_t *p, point_ptr q, int neg,
+                          jac_ctx_ptr j) {
+  element_ptr z1z1 = j->t[0], h = j->t[1], s2 = j->t[2], rr = j->t[3];
+  element_ptr hh = j->t[4], v = j->t[5], jj = j->t[6];
+
+  if (q->inf_flag) {
+    if (r != p) {
+      element_set(r->x, p->x);
+      element_set(r->y, p->y);
+      element_set(r->z, p->z);
+    }
+    return;
+  }
+  if (element_is0(p->z)) {
+    jac_from_point(r, q);
+    if (neg) element_neg(r->y, r->y);
+    return;
+  }
+#if MONT_DIRECT_LIMBS
+  if (j->p) {
+    jac_add_point_direct(r, p, q, neg, j);
+    return;
+  }
+#endif
+  element_square(z1z1, p->z);
+  // H = X2 Z1Z1 - X1, S2 = Y2 Z1 Z1Z1
+  element_mul(h, q->x, z1z1);
+  element_sub(h, h, p->x);
+  element_mul(s2, p->z, z1z1);
+  element_mul(s2, s2, q->y);
+  if (neg) element_neg(s2, s2);
+  element_sub(rr, s2, p->y);
+  if (element_is0(h)) {
+    // Same x: p = q doubles, p = -q gives O.
+    if (element_is0(rr)) jac_double(r, p, j);
+    else element_set0(r->z);
+    return;
+  }
+  element_double(rr, rr);
+  // I = 4 HH, J = H I, V = X1 I
+  element_square(hh, h);
+  element_double(v, hh);
+  element_double(v, v);
+  element_mul(jj, h, v);
+  element_mul(v, v, p->x);
+  // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+  element_add(s2, p->z, h);
+  element_square(s2, s2);
+  element_sub(s2, s2, z1z1);
+  element_sub(s2, s2, hh);
+  // X3 = r^2 - J - 2V, Y3 = r(V - X3) - 2 Y1 J
+  element_square(z1z1, rr);
+  element_sub(z1z1, z1z1, jj);
+  element_sub(z1z1, z1z1, v);
+  element_sub(z1z1, z1z1, v);
+  element_sub(h, v, z1z1);
+  element_mul(h, h, rr);
+  element_mul(jj, jj, p->y);
+  element_double(jj, jj);
+  element_sub(r->y, h, jj);
+  element_set(r->x, z1z1);
+  element_set(r->z, s2);
+}
+
+// Converts n Jacobian points to affine with one inversion, by
+// Montgomery's trick: the inverse of each Z comes from the inverse of the
+// product of all of them. r[i] may not overlap p.
+static void jac_to_points(point_ptr r[], jac_t *p[], int n, jac_ctx_ptr j) {
+  element_t *prod = pbc_malloc(sizeof(element_t) * n);
+  element_ptr inv = j->t[0], zi = j->t[1], zi2 = j->t[2];
+  int i, last = -1;
+
+  // prod[i] is the product of the nonzero Z up to i.
+  for (i = 0; i < n; i++) {
+    element_init(prod[i], inv->field);
+    if (last < 0) element_set1(prod[i]);
+    else element_set(prod[i], prod[last]);
+    if (!element_is0(p[i]->z)) {
+      element_mul(prod[i], prod[i], p[i]->z);
+      last = i;
+    }
+  }
+  if (last >= 0) {
+    if (j->ct) element_invert_ct(inv, prod[last]);
+    else element_invert(inv, prod[last]);
+  }
+  for (i = n - 1; i >= 0; i--) {
+    if (element_is0(p[i]->z)) {
+      r[i]->inf_flag = 1;
+      continue;
+    }
+    // Here inv is the inverse of prod[i].
+    if (i > 0) element_mul(zi, inv, prod[i - 1]);
+    else element_set(zi, inv);
+    element_mul(inv, inv, p[i]->z);
+    element_square(zi2, zi);
+    element_mul(r[i]->x, p[i]->x, zi2);
+    element_mul(zi2, zi2, zi);
+    element_mul(r[i]->y, p[i]->y, zi2);
+    r[i]->inf_flag = 0;
+  }
+  for (i = 0; i < n; i++) element_clear(prod[i]);
+  pbc_free(prod);
+}
+
+// An endomorphism phi(x, y) = (beta x, y) of a curve with a = 0, where
+// beta is a cube root of unity, acts on a group of prime order r as
+// multiplication by a cube root of unity lambda mod r. The pairs (u, v)
+// with u + v lambda = 0 mod r form a lattice with a basis (a1, b1),
+// (a2, b2) of vectors near sqrt(r) long, along which an exponent splits
+// into two halves (Gallant, Lambert and Vanstone).
+struct glv_s {
+  element_t beta;
+  mpz_t r, a1, b1, a2, b2;
+};
+
+// n = k1 + k2 lambda mod r with k1, k2 about sqrt(r), and possibly
+// negative. Algorithm 3.74 of Hankerson, Menezes and Vanstone.
+static void glv_split(mpz_t k1, mpz_t k2, mpz_t n, struct glv_s *g) {
+  mpz_t k, c1, c2, t;
+  mpz_init(k);
+  mpz_init(c1);
+  mpz_init(c2);
+  mpz_init(t);
+  mpz_mod(k, n, g->r);
+  // c1 = round(b2 k / r), c2 = round(-b1 k / r).
+  mpz_mul(c1, g->b2, k);
+  mpz_mul(c2, g->b1, k);
+  mpz_neg(c2, c2);
+  mpz_mul_2exp(t, g->r, 1);
+  mpz_mul_2exp(c1, c1, 1);
+  mpz_add(c1, c1, g->r);
+  mpz_fdiv_q(c1, c1, t);
+  mpz_mul_2exp(c2, c2, 1);
+  mpz_add(c2, c2, g->r);
+  mpz_fdiv_q(c2, c2, t);
+  // k1 = k - c1 a1 - c2 a2, k2 = -c1 b1 - c2 b2.
+  mpz_set(k1, k);
+  mpz_submul(k1, c1, g->a1);
+  mpz_submul(k1, c2, g->a2);
+  mpz_mul(k2, c1, g->b1);
+  mpz_addmul(k2, c2, g->b2);
+  mpz_neg(k2, k2);
+  mpz_clear(k);
+  mpz_clear(c1);
+  mpz_clear(c2);
+  mpz_clear(t);
+}
+
+// c = a[0]^n[0] ... a[m-1]^n[m-1] by interleaved left-to-right width-w
+// NAF in Jacobian coordinates: one chain of doublings for all bases, and
+// for each base a table of the odd multiples a, 3a, ..., (2^(w-1) - 1)a,
+// every table made affine in one batch. Negative digits and exponents
+// subtract, which costs no more than adding. With an endomorphism each
+// exponent splits into k1 + k2 lambda and the loop runs half the
+// doublings, k2 against phi of the table, which costs a multiplication per
+// entry. c may be one of the a[i].
+static void curve_multi_pow_mpz(element_ptr c, element_ptr a[], mpz_ptr n[],
+                                int m) {
+  curve_data_ptr cdp = c->field->data;
+  int split = cdp->glv ? 2 : 1;
+  int bits, w, size, count, nb, maxlen, i, s, b;
+  int *len, *neg;
+  signed char **d;
+  point_ptr tab, *out, p;
+  element_ptr *base;
+  jac_t acc, *dbl, *odd, **in;
+  jac_ctx_ptr j;
+  mpz_t *e;
+
+  // Scalar s belongs to base s / split; with an endomorphism odd s are k2.
+  e = pbc_malloc(sizeof(mpz_t) * split * m);
+  len = pbc_malloc(sizeof(int) * 2 * split * m);
+  neg = len + split * m;
+  base = pbc_malloc(sizeof(*base) * m);
+  for (i = 0; i < split * m; i++) mpz_init(e[i]);
+  nb = 0;
+  for (i = 0; i < m; i++) {
+    if (!mpz_sgn(n[i]) || ((point_ptr) a[i]->data)->inf_flag) continue;
+    if (cdp->glv) glv_split(e[2 * nb], e[2 * nb + 1], n[i], cdp->glv);
+    else mpz_set(e[nb], n[i]);
+    base[nb++] = a[i];
+  }
+  count = split * nb;
+  bits = 0;
+  for (s = 0; s < count; s++) {
+    neg[s] = mpz_sgn(e[s]) < 0;
+    mpz_abs(e[s], e[s]);
+    if (mpz_sgn(e[s]) && (int) mpz_sizeinbase(e[s], 2) > bits) {
+      bits = mpz_sizeinbase(e[s], 2);
+    }
+  }
+  if (!bits) {
+    // Every power is the identity, or n[i] is a multiple of r.
+    ((point_ptr) c->data)->inf_flag = 1;
+    for (i = 0; i < split * m; i++) mpz_clear(e[i]);
+    pbc_free(e);
+    pbc_free(len);
+    pbc_free(base);
+    return;
+  }
+  w = bits > 240 ? 5 : bits > 24 ? 4 : 2;
+  size = 1 << (w - 2);
+
+  j = jac_ctx_new(cdp);
+  tab = pbc_malloc(sizeof(*tab) * size * count);
+  out = pbc_malloc(sizeof(*out) * size * nb);
+  odd = pbc_malloc(sizeof(*odd) * (size + 1) * nb);
+  dbl = odd + size * nb;
+  in = pbc_malloc(sizeof(*in) * size * nb);
+  d = pbc_malloc(sizeof(*d) * count);
+  jac_init(&acc, cdp->field);
+  for (i = 0; i < size * count; i++) {
+    element_init(tab[i].x, cdp->field);
+    element_init(tab[i].y, cdp->field);
+  }
+  for (i = 0; i < (size + 1) * nb; i++) jac_init(&odd[i], cdp->field);
+  for (b = 0; b < nb; b++) jac_from_point(&odd[b * size], base[b]->data);
+  if (size > 1) {
+    // 2a in affine lets the rest of each table use mixed additions; the
+    // entries a 3a would overwrite hold it meanwhile.
+    for (b = 0; b < nb; b++) {
+      jac_double(&dbl[b], &odd[b * size], j);
+      out[b] = &tab[b * split * size + 1];
+      in[b] = &dbl[b];
+    }
+    jac_to_points(out, in, nb, j);
+    for (b = 0; b < nb; b++) {
+      point_ptr t = &tab[b * split * size + 1];
+      for (i = 1; i < size; i++) {
+        jac_add_point(&odd[b * size + i], &odd[b * size + i - 1], t, 0, j);
+      }
+    }
+  }
+  for (b = 0; b < nb; b++) {
+    for (i = 0; i < size; i++) {
+      out[b * size + i] = &tab[b * split * size + i];
+      in[b * size + i] = &odd[b * size + i];
+    }
+  }
+  jac_to_points(out, in, size * nb, j);
+  if (split == 2) {
+    for (b = 0; b < nb; b++) {
+      point_ptr t = &tab[2 * b * size], phi = t + size;
+      for (i = 0; i < size; i++) {
+        element_mul(phi[i].x, t[i].x, cdp->glv->beta);
+        element_set(phi[i].y, t[i].y);
+        phi[i].inf_flag = t[i].inf_flag;
+      }
+    }
+  }
+
+  maxlen = 0;
+  for (s = 0; s < count; s++) {
+    d[s] = pbc_malloc(bits + 1);
+    len[s] = mpz_sgn(e[s]) ? pbc_wnaf_recode(d[s], e[s], w) : 0;
+    if (len[s] > maxlen) maxlen = len[s];
+  }
+  element_set0(acc.z);
+  for (i = maxlen - 1; i >= 0; i--) {
+    jac_double(&acc, &acc, j);
+    for (s = 0; s < count; s++) {
+      int v = i < len[s] ? d[s][i] : 0;
+      if (v) {
+        jac_add_point(&acc, &acc, &tab[s * size + (abs(v) >> 1)],
+                      (v < 0) != neg[s], j);
+      }
+    }
+  }
+  p = c->data;
+  in[0] = &acc;
+  jac_to_points(&p, in, 1, j);
+
+  for (s = 0; s < count; s++) pbc_free(d[s]);
+  for (i = 0; i < size * count; i++) {
+    element_clear(tab[i].x);
+    element_clear(tab[i].y);
+  }
+  for (i = 0; i < (size + 1) * nb; i++) jac_clear(&odd[i]);
+  jac_clear(&acc);
+  pbc_free(d);
+  pbc_free(tab);
+  pbc_free(out);
+  pbc_free(odd);
+  pbc_free(in);
+  jac_ctx_free(j);
+  for (i = 0; i < split * m; i++) mpz_clear(e[i]);
+  pbc_free(e);
+  pbc_free(len);
+  pbc_free(base);
+}
+
+static void curve_pow_mpz(element_ptr c, element_ptr a, mpz_ptr n) {
+  curve_multi_pow_mpz(c, &a, &n, 1);
+}
+
+// Window width of curve_pow_mpz_batch(), and how many exponentiations
+// share each step. Past a few hundred points the one inversion per step is
+// already small next to the multiplications, so larger chunks only cost
+// memory for the tables.
+#define POW_BATCH_WINDOW 4
+#define POW_BATCH_CHUNK 256
+// Below this many exponentiations, separate ones in Jacobian coordinates
+// beat the batched affine steps.
+#define POW_BATCH_MIN 8
+
+// Signed fixed-window exponentiations in lockstep: every step doubles all
+// m accumulators with one multi_double() and adds the table entries picked
+// by the digits with one multi_add(), so each step costs one inversion in
+// the base field. Digits lie in [-2^(w-1), 2^(w-1)], so the tables hold
+// only a_i .. 2^(w-1) a_i and their negatives.
+static void pow_batch_chunk(element_ptr x[], element_ptr a[], mpz_ptr n[],
+    int m, int bits) {
+  field_ptr f = x[0]->field;
+  int w = POW_BATCH_WINDOW, h = 1 << (w - 1);
+  int digits = bits / w + 1;
+  // TAB(i, d) = d a_i for 0 < |d| <= h.
+  element_t *tab = pbc_malloc(sizeof(element_t) * m * (2 * h + 1));
+  element_t *acc = pbc_malloc(sizeof(element_t) * m);
+  element_ptr *c = pbc_malloc(sizeof(element_ptr) * 3 * m);
+  element_ptr *p = c + m, *q = p + m;
+  signed char *digit = pbc_malloc(m * digits);
+  int i, j, k, d, carry, count;
+
+#define TAB(i, d) tab[(i) * (2 * h + 1) + h + (d)]
+  for (i = 0; i < m; i++) {
+    for (d = -h; d <= h; d++) if (d) element_init(TAB(i, d), f);
+    element_init(acc[i], f);
+    curve_set(TAB(i, 1), a[i]);
+    // Recode n_i from the least significant window up.
+    carry = 0;
+    for (j = 0; j < digits; j++) {
+      d = carry;
+      for (k = 0; k < w; k++) d += mpz_tstbit(n[i], j * w + k) << k;
+      carry = d > h;
+      digit[i * digits + j] = carry ? d - 2 * h : d;
+    }
+  }
+  for (i = 0; i < m; i++) {
+    c[i] = TAB(i, 2);
+    p[i] = TAB(i, 1);
+  }
+  multi_double(c, p, m);
+  for (d = 3; d <= h; d++) {
+    for (i = 0; i < m; i++) {
+      c[i] = TAB(i, d);
+      p[i] = TAB(i, d - 1);
+      q[i] = TAB(i, 1);
+    }
+    multi_add(c, p, q, m);
+  }
+  for (i = 0; i < m; i++) {
+    for (d = 1; d <= h; d++) curve_invert(TAB(i, -d), TAB(i, d));
+  }
+
+  for (i = 0; i < m; i++) {
+    d = digit[i * digits + digits - 1];
+    if (d) curve_set(acc[i], TAB(i, d));
+    else element_set1(acc[i]);
+    c[i] = acc[i];
+  }
+  for (j = digits - 2; j >= 0; j--) {
+    for (k = 0; k < w; k++) multi_double(c, c, m);
+    count = 0;
+    for (i = 0; i < m; i++) {
+      d = digit[i * digits + j];
+      if (!d) continue;
+      p[count] = acc[i];
+      q[count] = TAB(i, d);
+      count++;
+    }
+    if (count) multi_add(p, p, q, count);
+  }
+
+  for (i = 0; i < m; i++) {
+    curve_set(x[i], acc[i]);
+    element_clear(acc[i]);
+    for (d = -h; d <= h; d++) if (d) element_clear(TAB(i, d));
+  }
+#undef TAB
+  pbc_free(digit);
+  pbc_free(c);
+  pbc_free(acc);
+  pbc_free(tab);
+}
+
+// An endomorphism halves the doublings of separate exponentiations, which
+// outweighs sharing inversions.
+static void curve_pow_mpz_batch(element_ptr x[], element_ptr a[],
+    mpz_ptr n[], int m) {
+  curve_data_ptr cdp = x[0]->field->data;
+  int i, s, bits = 1;
+
+  if (cdp->glv || m < POW_BATCH_MIN) {
+    for (i = 0; i < m; i++) curve_pow_mpz(x[i], a[i], n[i]);
+    return;
+  }
+  for (i = 0; i < m; i++) {
+    if ((s = mpz_sizeinbase(n[i], 2)) > bits) bits = s;
+  }
+  for (i = 0; i < m; i += POW_BATCH_CHUNK) {
+    pow_batch_chunk(x + i, a + i, n + i,
+        m - i < POW_BATCH_CHUNK ? m - i : POW_BATCH_CHUNK, bits);
+  }
+}
+
+// Window width of curve_pow_mpz_same(). One shared recoding leaves the
+// additions all-or-nothing, so a sparser width-w NAF replaces the fixed
+// window: an addition every w + 1 bits, against tables of 2^(w-2) odd
+// multiples and their negatives.
+#define POW_SAME_WINDOW 5
+
+// x[i] = a[i]^n for the width-w NAF d[0..len-1] of n, in lockstep like
+// pow_batch_chunk() but with the digits shared by every base.
+static void pow_same_chunk(element_ptr x[], element_ptr a[], int m,
+    signed char *d, int len, int w) {
+  field_ptr f = x[0]->field;
+  int h = 1 << (w - 2);
+  // TAB(i, k) = (2k + 1) a_i and TAB(i, h + k) = -(2k + 1) a_i for k < h.
+  element_t *tab = pbc_malloc(sizeof(element_t) * m * (2 * h + 1));
+  element_ptr *c = pbc_malloc(sizeof(element_ptr) * 3 * m);
+  element_ptr *p = c + m, *q = p + m;
+  int i, j, k, v;
+
+#define TAB(i, k) tab[(i) * (2 * h + 1) + (k)]
+#define TWICE(i) tab[(i) * (2 * h + 1) + 2 * h]
+  for (i = 0; i < m; i++) {
+    for (k = 0; k <= 2 * h; k++) element_init(TAB(i, k), f);
+    curve_set(TAB(i, 0), a[i]);
+    c[i] = TWICE(i);
+    p[i] = TAB(i, 0);
+  }
+  if (h > 1) multi_double(c, p, m);
+  for (k = 1; k < h; k++) {
+    for (i = 0; i < m; i++) {
+      c[i] = TAB(i, k);
+      p[i] = TAB(i, k - 1);
+      q[i] = TWICE(i);
+    }
+    multi_add(c, p, q, m);
+  }
+  for (i = 0; i < m; i++) {
+    for (k = 0; k < h; k++) curve_invert(TAB(i, h + k), TAB(i, k));
+  }
+
+  // The leading digit is positive.
+  v = d[len - 1];
+  for (i = 0; i < m; i++) {
+    curve_set(x[i], TAB(i, v >> 1));
+    c[i] = x[i];
+  }
+  for (j = len - 2; j >= 0; j--) {
+    multi_double(c, c, m);
+    if (!(v = d[j])) continue;
+    k = v > 0 ? v >> 1 : h + (-v >> 1);
+    for (i = 0; i < m; i++) q[i] = TAB(i, k);
+    multi_add(c, c, q, m);
+  }
+
+  for (i = 0; i < m; i++) {
+    for (k = 0; k <= 2 * h; k++) element_clear(TAB(i, k));
+  }
+#undef TWICE
+#undef TAB
+  pbc_free(c);
+  pbc_free(tab);
+}
+
+// Same exponent for every base: the recoding is done once, and the steps
+// run as in curve_pow_mpz_batch().
+static void curve_pow_mpz_same(element_ptr x[], element_ptr a[], mpz_ptr n,
+    int m) {
+  curve_data_ptr cdp = x[0]->field->data;
+  int i, len, w = POW_SAME_WINDOW;
+  signed char *d;
+
+  if (cdp->glv || m < POW_BATCH_MIN) {
+    for (i = 0; i < m; i++) curve_pow_mpz(x[i], a[i], n);
+    return;
+  }
+  if (!mpz_sgn(n)) {
+    for (i = 0; i < m; i++) element_set1(x[i]);
+    return;
+  }
+  d = pbc_malloc(mpz_sizeinbase(n, 2) + 1);
+  len = pbc_wnaf_recode(d, n, w);
+  for (i = 0; i < m; i += POW_BATCH_CHUNK) {
+    pow_same_chunk(x + i, a + i,
+        m - i < POW_BATCH_CHUNK ? m - i : POW_BATCH_CHUNK, d, len, w);
+  }
+  pbc_free(d);
+}
+
+// Points that need no multiplication by the order to be accepted: the
+// identity, and points on curves whose group of points is known to have
+// prime order (glv_init() checks it) or that stand for cosets.
+static int curve_in_subgroup_free(element_ptr a) {
+  curve_data_ptr cdp = a->field->data;
+  return ((point_ptr) a->data)->inf_flag || cdp->glv || cdp->quotient_cmp;
+}
+
+// r a = O. The endomorphism is never used here, as it only acts as lambda
+// on the subgroup: only curves without one get this far.
+static int curve_in_subgroup(element_ptr a) {
+  element_t t;
+  int result;
+  if (!curve_is_valid_point(a)) return 0;
+  if (curve_in_subgroup_free(a)) return 1;
+  element_init(t, a->field);
+  curve_pow_mpz(t, a, a->field->order);
+  result = ((point_ptr) t->data)->inf_flag;
+  element_clear(t);
+  return result;
+}
+
+// The points left after the free checks all get r a in lockstep.
+static int curve_in_subgroup_batch(char ok[], element_ptr a[], int m) {
+  field_ptr f = a[0]->field;
+  element_ptr *in = pbc_malloc(sizeof(element_ptr) * 2 * m);
+  element_ptr *out = in + m;
+  int *idx = pbc_malloc(sizeof(int) * m);
+  int i, k = 0, count = 0;
+
+  for (i = 0; i < m; i++) {
+    int pass = curve_is_valid_point(a[i]);
+    if (pass && !curve_in_subgroup_free(a[i])) {
+      idx[k] = i;
+      in[k] = a[i];
+      out[k] = pbc_malloc(sizeof(element_t));
+      element_init(out[k], f);
+      k++;
+      continue;
+    }
+    if (ok) ok[i] = pass;
+    count += pass;
+  }
+  if (k) curve_pow_mpz_same(out, in, f->order, k);
+  for (i = 0; i < k; i++) {
+    int pass = ((point_ptr) out[i]->data)->inf_flag;
+    if (ok) ok[idx[i]] = pass;
+    count += pass;
+    element_clear(out[i]);
+    pbc_free(out[i]);
+  }
+  pbc_free(idx);
+  pbc_free(in);
+  return count;
+}
+
+static void jac_cmov(jac_t *r, jac_t *p, int bit) {
+  element_cmov(r->x, p->x, bit);
+  element_cmov(r->y, p->y, bit);
+  element_cmov(r->z, p->z, bit);
+}
+
+#define CURVE_POW_CT_WINDOW 4
+
+// c = a^n for a secret n, by the regular recoding of Joye and Tunstall:
+// an odd exponent has a fixed number of digits, all odd and between
+// -(2^w - 1) and 2^w - 1, so every window costs w doublings and one mixed
+// addition. The table entry is read by a masked scan and negated by a
+// masked move. An even n runs as n + 1, and the subtraction of a that
+// corrects it is always made and kept under a mask.
+static void curve_pow_mpz_ct(element_ptr c, element_ptr a, mpz_ptr n) {
+  const int w = CURVE_POW_CT_WINDOW, size = 1 << (w - 1);
+  curve_data_ptr cdp = a->field->data;
+  point_ptr p = a->data;
+  point_ptr tab, t, out[1 << (CURVE_POW_CT_WINDOW - 1)];
+  jac_t acc, alt, odd[1 << (CURVE_POW_CT_WINDOW - 1)];
+  jac_t *in[1 << (CURVE_POW_CT_WINDOW - 1)];
+  jac_ctx_ptr j;
+  element_t negy;
+  int bits, m, even, i, k, *d;
+  mpz_t e;
+
+  if (p->inf_flag) {
+    ((point_ptr) c->data)->inf_flag = 1;
+    return;
+  }
+  mpz_init(e);
+  mpz_abs(e, n);
+  even = !mpz_odd_p(e);
+  mpz_add_ui(e, e, even);
+  // With e < 2^(wm - 1) the last digit stays below 2^(w - 1) + 2.
+  bits = mpz_sizeinbase(e, 2);
+  if ((int) mpz_sizeinbase(a->field->order, 2) + 1 > bits) {
+    bits = mpz_sizeinbase(a->field->order, 2) + 1;
+  }
+  m = (bits + w) / w;
+  d = pbc_malloc(sizeof(*d) * m);
+  pbc_regular_recode(d, e, w, m);
+
+  j = jac_ctx_new(cdp);
+  j->ct = 1;
+  jac_init(&acc, cdp->field);
+  jac_init(&alt, cdp->field);
+  element_init(negy, cdp->field);
+  // The table, and after it the entry selected.
+  tab = pbc_malloc(sizeof(*tab) * (size + 1));
+  t = &tab[size];
+  for (i = 0; i <= size; i++) {
+    element_init(tab[i].x, cdp->field);
+    element_init(tab[i].y, cdp->field);
+  }
+  for (i = 0; i < size; i++) {
+    jac_init(&odd[i], cdp->field);
+    out[i] = &tab[i];
+    in[i] = &odd[i];
+  }
+  // Odd multiples a, 3a, ..., (2^w - 1)a, with 2a affine for mixed
+  // additions, then all made affine at once.
+  jac_from_point(&odd[0], p);
+  jac_double(&alt, &odd[0], j);
+  in[1] = &alt;
+  jac_to_points(&out[1], &in[1], 1, j);
+  in[1] = &odd[1];
+  for (i = 1; i < size; i++) {
+    jac_add_point(&odd[i], &odd[i - 1], out[1], 0, j);
+  }
+  jac_to_points(out, in, size, j);
+
+  for (i = m - 1; i >= 0; i--) {
+    int s = -(d[i] < 0), idx = ((d[i] ^ s) - s) >> 1;
+    t->inf_flag = tab[0].inf_flag;
+    element_set(t->x, tab[0].x);
+    element_set(t->y, tab[0].y);
+    for (k = 1; k < size; k++) point_cmov(t, &tab[k], pbc_ct_eq(k, idx));
+    element_neg(negy, t->y);
+    element_cmov(t->y, negy, s & 1);
+    if (i == m - 1) {
+      jac_from_point(&acc, t);
+      continue;
+    }
+    for (k = 0; k < w; k++) jac_double(&acc, &acc, j);
+    jac_add_point(&acc, &acc, t, 0, j);
+  }
+  jac_add_point(&alt, &acc, p, 1, j);
+  jac_cmov(&acc, &alt, even);
+  p = c->data;
+  in[0] = &acc;
+  jac_to_points(&p, in, 1, j);
+  if (mpz_sgn(n) < 0) curve_invert(c, c);
+
+  for (i = 0; i <= size; i++) {
+    element_clear(tab[i].x);
+    element_clear(tab[i].y);
+  }
+  for (i = 0; i < size; i++) jac_clear(&odd[i]);
+  pbc_free(tab);
+  element_clear(negy);
+  jac_clear(&acc);
+  jac_clear(&alt);
+  jac_ctx_free(j);
+  pbc_free(d);
+  mpz_clear(e);
+}
+
+static void glv_clear(curve_data_ptr cdp) {
+  struct glv_s *g = cdp->glv;
+  if (!g) return;
+  element_clear(g->beta);
+  mpz_clear(g->r);
+  mpz_clear(g->a1);
+  mpz_clear(g->b1);
+  mpz_clear(g->a2);
+  mpz_clear(g->b2);
+  pbc_free(g);
+  cdp->glv = NULL;
+}
+
+// Returns a cube root of unity other than 1 mod the prime m = 1 mod 3.
+static void cube_root_of_unity(mpz_t z, mpz_t m) {
+  mpz_t e;
+  unsigned long g;
+  mpz_init(e);
+  mpz_sub_ui(e, m, 1);
+  mpz_divexact_ui(e, e, 3);
+  for (g = 2;; g++) {
+    mpz_set_ui(z, g);
+    mpz_powm(z, z, e, m);
+    if (mpz_cmp_ui(z, 1)) break;
+  }
+  mpz_clear(e);
+}
+
+// Sets up the endomorphism when the curve is Y^2 = X^3 + b over a prime
+// field F_q with q = 1 mod 3 and the group of points has prime order
+// r = 1 mod 3, as for the BN curves of type F. The order is checked
+// rather than trusted: if r is in the Hasse interval and kills a point
+// other than O, then it is #E, since r > 4 sqrt(q). Type A curves have
+// a = 1 and their map (x, y) -> (-x, iy) leaves E(F_q), so they keep the
+// plain NAF.
+static void glv_init(field_ptr f) {
+  curve_data_ptr cdp = f->data;
+  field_ptr fq = cdp->field;
+  struct glv_s *g;
+  element_t p, q;
+  mpz_t lambda, t, u, r0, r1, t0, t1, quot, s;
+  int i, ok = 0;
+
+  if (!element_is0(cdp->a) || cdp->cofac) return;
+  if (mpz_sizeinbase(f->order, 2) < 32) return;
+  if (mpz_fdiv_ui(f->order, 3) != 1 || mpz_fdiv_ui(fq->order, 3) != 1) return;
+  mpz_init(t);
+  // (q + 1 - r)^2 <= 4q.
+  mpz_add_ui(t, fq->order, 1);
+  mpz_sub(t, t, f->order);
+  mpz_mul(t, t, t);
+  mpz_submul_ui(t, fq->order, 4);
+  if (mpz_sgn(t) > 0 || !mpz_probab_prime_p(fq->order, 10) ||
+      !mpz_probab_prime_p(f->order, 10)) {
+    mpz_clear(t);
+    return;
+  }
+
+  element_init(p, f);
+  element_init(q, f);
+  mpz_init(lambda);
+  mpz_init(u);
+  g = pbc_malloc(sizeof(*g));
+  element_init(g->beta, fq);
+  cube_root_of_unity(t, fq->order);
+  element_set_mpz(g->beta, t);
+  cube_root_of_unity(lambda, f->order);
+  element_pow_mpz(p, cdp->gen, f->order);
+  if (!element_is0(cdp->gen) && element_is0(p)) {
+    // Of the two roots lambda, lambda^2, find the one phi matches.
+    point_ptr gp = cdp->gen->data, pp = p->data;
+    element_mul(pp->x, gp->x, g->beta);
+    element_set(pp->y, gp->y);
+    pp->inf_flag = 0;
+    for (i = 0; i < 2 && !ok; i++) {
+      element_pow_mpz(q, cdp->gen, lambda);
+      ok = !element_cmp(p, q);
+      if (!ok) {
+        mpz_mul(lambda, lambda, lambda);
+        mpz_mod(lambda, lambda, f->order);
+      }
+    }
+  }
+  element_clear(p);
+  element_clear(q);
+  if (!ok) {
+    element_clear(g->beta);
+    pbc_free(g);
+    mpz_clear(lambda);
+    mpz_clear(t);
+    mpz_clear(u);
+    return;
+  }
+
+  // The extended Euclidean algorithm on r and lambda gives remainders
+  // r_i = t_i lambda mod r. Stop at the first r_{l+1} below sqrt(r).
+  mpz_init_set(g->r, f->order);
+  mpz_init(g->a1);
+  mpz_init(g->b1);
+  mpz_init(g->a2);
+  mpz_init(g->b2);
+  mpz_init_set(r0, f->order);
+  mpz_init_set(r1, lambda);
+  mpz_init_set_ui(t0, 0);
+  mpz_init_set_ui(t1, 1);
+  mpz_init(quot);
+  mpz_init(s);
+  mpz_sqrt(s, f->order);
+  while (mpz_cmp(r1, s) > 0) {
+    mpz_fdiv_qr(quot, t, r0, r1);
+    mpz_swap(r0, r1);
+    mpz_swap(r1, t);
+    mpz_set(t, t0);
+    mpz_submul(t, quot, t1);
+    mpz_swap(t0, t1);
+    mpz_swap(t1, t);
+  }
+  // (a1, b1) = (r_{l+1}, -t_{l+1}); (a2, b2) is the shorter of
+  // (r_l, -t_l) and (r_{l+2}, -t_{l+2}).
+  mpz_set(g->a1, r1);
+  mpz_neg(g->b1, t1);
+  mpz_fdiv_qr(quot, t, r0, r1);
+  mpz_set(u, t0);
+  mpz_submul(u, quot, t1);
+  mpz_mul(s, r0, r0);
+  mpz_addmul(s, t0, t0);
+  mpz_mul(quot, t, t);
+  mpz_addmul(quot, u, u);
+  if (mpz_cmp(s, quot) <= 0) {
+    mpz_set(g->a2, r0);
+    mpz_neg(g->b2, t0);
+  } else {
+    mpz_set(g->a2, t);
+    mpz_neg(g->b2, u);
+  }
+  cdp->glv = g;
+
+  mpz_clear(r0);
+  mpz_clear(r1);
+  mpz_clear(t0);
+  mpz_clear(t1);
+  mpz_clear(quot);
+  mpz_clear(s);
+  mpz_clear(lambda);
+  mpz_clear(t);
+  mpz_clear(u);
+}
+
+// Fixed-base tables of element_pp_init_ex(): a struct element_base_table
+// with additions for multiplications, of affine points built in Jacobian
+// coordinates and converted with two inversions in all.
+
+static inline point_ptr curve_pp_point(struct element_base_table *pp, int i) {
+  return pp->table->item[i]->data;
+}
+
+static void curve_pp_init_ex(element_pp_t p, element_t in, int bits,
+    int k, int strategy) {
+  curve_data_ptr cdp = in->field->data;
+  struct element_base_table *pp = p->data = pbc_malloc(sizeof(*pp));
+  int per = (1 << k) - 1, nbase, n, i, m, s, b, e, last;
+  jac_ctx_ptr j = jac_ctx_new(cdp);
+  jac_t *jac, **in_ptr, *r;
+  point_ptr base, *out;
+  int *pos;
+
+  pp->k = k;
+  pp->strategy = strategy;
+  if (strategy == PBC_PP_WINDOW) {
+    pp->rows = bits / k + 1;
+    nbase = pp->rows;
+  } else {
+    pp->rows = strategy == PBC_PP_COMB2 ? 2 : 1;
+    pp->spacing = (bits + k - 1) / k;
+    pp->span = (pp->spacing + pp->rows - 1) / pp->rows;
+    nbase = pp->rows * k;
+  }
+  n = pp->rows * per;
+  element_vec_init(pp->table, in->field, n);
+  base = pbc_malloc(sizeof(*base) * nbase);
+  pos = pbc_malloc(sizeof(*pos) * nbase);
+  jac = pbc_malloc(sizeof(*jac) * n);
+  in_ptr = pbc_malloc(sizeof(*in_ptr) * n);
+  out = pbc_malloc(sizeof(*out) * n);
+  for (i = 0; i < n; i++) jac_init(&jac[i], cdp->field);
+
+  // The base points 2^e a: of each row, or of each tooth of each table,
+  // in increasing e, made affine together.
+  for (b = 0, last = 0; b < nbase; b++) {
+    if (strategy == PBC_PP_WINDOW) {
+      pos[b] = b * per;
+      e = b * k;
+    } else {
+      i = b / pp->rows;
+      s = b % pp->rows;
+      pos[b] = s * per + (1 << i) - 1;
+      e = i * pp->spacing + s * pp->span;
+    }
+    r = &jac[pos[b]];
+    if (!b) jac_from_point(r, in->data);
+    else if (e == last) {
+      element_set(r->x, jac[pos[b - 1]].x);
+      element_set(r->y, jac[pos[b - 1]].y);
+      element_set(r->z, jac[pos[b - 1]].z);
+    } else {
+      jac_double(r, &jac[pos[b - 1]], j);
+      for (last++; last < e; last++) jac_double(r, r, j);
+    }
+    element_init(base[b].x, cdp->field);
+    element_init(base[b].y, cdp->field);
+    out[b] = &base[b];
+    in_ptr[b] = r;
+  }
+  jac_to_points(out, in_ptr, nbase, j);
+
+  for (s = 0; s < pp->rows; s++) {
+    jac_t *row = &jac[s * per];
+    for (m = 1; m < per; m++) {
+      if (strategy == PBC_PP_WINDOW) {
+        jac_add_point(&row[m], &row[m - 1], &base[s], 0, j);
+        continue;
+      }
+      // Entry m + 1 = entry with its lowest bit i cleared, plus tooth i.
+      if (!(m & (m + 1))) continue;
+      for (i = 0; !((m + 1) >> i & 1); i++);
+      jac_add_point(&row[m], &row[m - (1 << i)], &base[i * pp->rows + s], 0, j);
+    }
+  }
+  for (i = 0; i < n; i++) {
+    out[i] = curve_pp_point(pp, i);
+    in_ptr[i] = &jac[i];
+  }
+  jac_to_points(out, in_ptr, n, j);
+
+  for (b = 0; b < nbase; b++) {
+    element_clear(base[b].x);
+    element_clear(base[b].y);
+  }
+  for (i = 0; i < n; i++) jac_clear(&jac[i]);
+  pbc_free(base);
+  pbc_free(pos);
+  pbc_free(jac);
+  pbc_free(in_ptr);
+  pbc_free(out);
+  jac_ctx_free(j);
+}
+
+static void curve_pp_init(element_pp_t p, element_t in) {
+  curve_pp_init_ex(p, in, mpz_sizeinbase(in->field->order, 2), 5,
+      PBC_PP_WINDOW);
+}
+
+static void curve_pp_pow(element_t out, mpz_ptr power, element_pp_t p) {
+  struct element_base_table *pp = p->data;
+  curve_data_ptr cdp = out->field->data;
+  int per = (1 << pp->k) - 1, rows, row, s, i, c, col, word;
+  point_ptr r = out->data;
+  jac_ctx_ptr j;
+  jac_t acc, *pa = &acc;
+  mpz_t n;
+
+  mpz_init_set(n, power);
+  if (mpz_sgn(n) < 0 || mpz_cmp(n, out->field->order) > 0) {
+    mpz_mod(n, n, out->field->order);
+  }
+  if (!mpz_sgn(n)) {
+    r->inf_flag = 1;
+    mpz_clear(n);
+    return;
+  }
+  j = jac_ctx_new(cdp);
+  jac_init(&acc, cdp->field);
+  element_set0(acc.z);
+  if (pp->strategy == PBC_PP_WINDOW) {
+    rows = mpz_sizeinbase(n, 2) / pp->k + 1;
+    for (row = 0; row < rows; row++) {
+      word = 0;
+      for (s = 0; s < pp->k; s++) {
+        word |= mpz_tstbit(n, pp->k * row + s) << s;
+      }
+      if (word) jac_add_point(&acc, &acc, curve_pp_point(pp, row * per + word - 1), 0, j);
+    }
+  } else {
+    for (c = pp->span - 1; c >= 0; c--) {
+      jac_double(&acc, &acc, j);
+      for (s = 0; s < pp->rows; s++) {
+        col = s * pp->span + c;
+        if (col >= pp->spacing) continue;
+        word = 0;
+        for (i = 0; i < pp->k; i++) {
+          word |= mpz_tstbit(n, i * pp->spacing + col) << i;
+        }
+        if (word) jac_add_point(&acc, &acc, curve_pp_point(pp, s * per + word - 1), 0, j);
+      }
+    }
+  }
+  jac_to_points(&r, &pa, 1, j);
+  jac_clear(&acc);
+  jac_ctx_free(j);
+  mpz_clear(n);
+}
+
+static void curve_pp_clear(element_pp_t p) {
+  struct element_base_table *pp = p->data;
+  element_vec_clear(pp->table);
+  pbc_free(pp);
+}
+
+static void curve_pp_wipe(element_pp_t p) {
+  struct element_base_table *pp = p->data;
+  int i;
+  for (i = 0; i < pp->table->n; i++) element_wipe(pp->table->item[i]);
+}
+
 static inline int point_cmp(point_ptr p, point_ptr q) {
   if (p->inf_flag || q->inf_flag) {
     return !(p->inf_flag && q->inf_flag);
@@ -397,6 +1624,14 @@ static void curve_set1(element_ptr x) {
   p->inf_flag = 1;
 }
 
+// The coordinates too, which set1 leaves as they are.
+static void curve_wipe(element_ptr x) {
+  point_ptr p = x->data;
+  element_wipe(p->x);
+  element_wipe(p->y);
+  p->inf_flag = 1;
+}
+
 static int curve_is1(element_ptr x) {
   point_ptr p = x->data;
   return p->inf_flag;
@@ -590,6 +1825,7 @@ static void field_clear_curve(field_t f) {
     mpz_clear(cdp->quotient_cmp);
     pbc_free(cdp->quotient_cmp);
   }
+  glv_clear(cdp);
   element_clear(cdp->a);
   element_clear(cdp->b);
   pbc_free(cdp);
@@ -685,7 +1921,20 @@ static element_ptr curve_get_y(element_ptr e) {
   return P->y;
 }
 
+// Sets 'a' to a saved generator, failing on a wrong length or a point that
+// is not on the curve.
+static int curve_gen_from_bytes(element_ptr a, const unsigned char *gen, int len) {
+  if (!gen || len != element_length_in_bytes(a)) return 0;
+  element_from_bytes(a, (unsigned char *) gen);
+  return !element_is0(a);
+}
+
 void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order, mpz_t cofac) {
+  field_init_curve_ab_gen(f, a, b, order, cofac, NULL, 0);
+}
+
+void field_init_curve_ab_gen(field_ptr f, element_ptr a, element_ptr b,
+    mpz_t order, mpz_t cofac, const unsigned char *gen, int gen_len) {
   /*
   if (element_is0(a)) {
     c->double_nocheck = cc_double_no_check_ais0;
@@ -698,6 +1947,7 @@ void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order,
   mpz_set(f->order, order);
   cdp = f->data = pbc_malloc(sizeof(*cdp));
   cdp->field = a->field;
+  cdp->glv = NULL;
   element_init(cdp->a, cdp->field);
   element_init(cdp->b, cdp->field);
   element_set(cdp->a, a);
@@ -709,10 +1959,25 @@ void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order,
   f->square = f->doub = curve_double;
   f->multi_doub = multi_double;
   f->add = f->mul = curve_mul;
-  f->multi_add = multi_add;
+  f->multi_add = f->multi_mul = multi_add;
   f->mul_mpz = element_pow_mpz;
+  f->pow_mpz = curve_pow_mpz;
+  f->multi_pow_mpz = curve_multi_pow_mpz;
+  f->pow_mpz_batch = curve_pow_mpz_batch;
+  f->pow_mpz_same = curve_pow_mpz_same;
+  f->in_subgroup = curve_in_subgroup;
+  f->in_subgroup_batch = curve_in_subgroup_batch;
+  f->cmov = curve_cmov;
+  f->pow_mpz_ct = curve_pow_mpz_ct;
+  f->pp_init = curve_pp_init;
+  f->pp_init_ex = curve_pp_init_ex;
+  f->pp_pow = curve_pp_pow;
+  f->pp_clear = curve_pp_clear;
+  f->pp_wipe = curve_pp_wipe;
+  f->pp_is_base_table = 1;
   f->cmp = curve_cmp;
   f->set0 = f->set1 = curve_set1;
+  f->wipe = curve_wipe;
   f->is0 = f->is1 = curve_is1;
   f->sign = curve_sign;
   f->set = curve_set;
@@ -736,6 +2001,10 @@ void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order,
   f->item = curve_item;
   f->get_x = curve_get_x;
   f->get_y = curve_get_y;
+  if (cdp->field->packed_size) {
+    f->packed_size = sizeof(*((point_ptr) 0)) + 2 * cdp->field->packed_size;
+    f->init_packed = curve_init_packed;
+  }
 
   if (mpz_odd_p(order)) {
     f->is_sqr = odd_curve_is_sqr;
@@ -745,7 +2014,9 @@ void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order,
 
   element_init(cdp->gen_no_cofac, f);
   element_init(cdp->gen, f);
-  curve_random_no_cofac_solvefory(cdp->gen_no_cofac);
+  if (!curve_gen_from_bytes(cdp->gen_no_cofac, gen, gen_len)) {
+    curve_random_no_cofac_solvefory(cdp->gen_no_cofac);
+  }
   if (cofac) {
     cdp->cofac = pbc_malloc(sizeof(mpz_t));
     mpz_init(cdp->cofac);
@@ -756,6 +2027,7 @@ void field_init_curve_ab(field_ptr f, element_ptr a, element_ptr b, mpz_t order,
     element_set(cdp->gen, cdp->gen_no_cofac);
   }
   cdp->quotient_cmp = NULL;
+  glv_init(f);
 }
 
 // Requires e to be a point on an elliptic curve.
@@ -817,6 +2089,60 @@ int element_length_in_bytes_compressed(element_ptr e) {
   return element_length_in_bytes(P->x) + 1;
 }
 
+// Requires every e[i] to be a point on the same elliptic curve.
+// Scratch is shared by the whole batch. If the base field order q is
+// 3 mod 4 the square root is the single power t^((q+1)/4), with the
+// exponent prepared once; this skips the inversion of the nonresidue
+// that element_tonelli repeats on every call. Other fields fall back to
+// element_sqrt. There is no batched inversion here: the affine right-hand
+// side X^3 + aX + b involves none.
+int element_from_bytes_compressed_batch(element_t e[], unsigned char *data, int n) {
+  curve_data_ptr cdp;
+  field_ptr fq;
+  element_t t;
+  mpz_t exp;
+  int i, fast, len = 0;
+
+  if (n <= 0) return 0;
+  cdp = e[0]->field->data;
+  fq = cdp->field;
+  fast = mpz_sgn(fq->order) > 0 && mpz_odd_p(fq->order) && mpz_tstbit(fq->order, 1);
+
+  element_init(t, fq);
+  mpz_init(exp);
+  if (fast) {
+    mpz_add_ui(exp, fq->order, 1);
+    mpz_tdiv_q_2exp(exp, exp, 2);
+  }
+
+  for (i = 0; i < n; i++) {
+    point_ptr P = e[i]->data;
+    unsigned char *p = data + len;
+    int k;
+    PBC_ASSERT(e[i]->field == e[0]->field, "field mismatch");
+
+    k = element_from_bytes(P->x, p);
+    P->inf_flag = 0;
+    element_square(t, P->x);
+    element_add(t, t, cdp->a);
+    element_mul(t, t, P->x);
+    element_add(t, t, cdp->b);
+    if (fast) element_pow_mpz(P->y, t, exp);
+    else element_sqrt(P->y, t);
+
+    if (p[k]) {
+      if (element_sign(P->y) < 0) element_neg(P->y, P->y);
+    } else if (element_sign(P->y) > 0) {
+      element_neg(P->y, P->y);
+    }
+    len += k + 1;
+  }
+
+  mpz_clear(exp);
+  element_clear(t);
+  return len;
+}
+
 // Requires e to be a point on an elliptic curve.
 int element_to_bytes_x_only(unsigned char *data, element_ptr e) {
   point_ptr P = e->data;
@@ -898,11 +2224,41 @@ void field_reinit_curve_twist(field_ptr c) {
   } else{
     element_set(cdp->gen, cdp->gen_no_cofac);
   }
+  glv_clear(cdp);
+  glv_init(c);
+}
+
+void field_init_curve_ab_map_twist(field_t cnew, field_t c,
+    fieldmap map, field_ptr mapdest, mpz_t ordernew,
+    const unsigned char *gen, int gen_len) {
+  if (!gen) {
+    field_init_curve_ab_map(cnew, c, map, mapdest, ordernew, NULL);
+    field_reinit_curve_twist(cnew);
+    return;
+  }
+  // Twist the coefficients up front, so the generator is set only once.
+  curve_data_ptr cdp = c->data;
+  element_ptr nqr = field_get_nqr(mapdest);
+  element_t a, b;
+  element_init(a, mapdest);
+  element_init(b, mapdest);
+  map(a, cdp->a);
+  map(b, cdp->b);
+  element_mul(a, a, nqr);
+  element_mul(a, a, nqr);
+  element_mul(b, b, nqr);
+  element_mul(b, b, nqr);
+  element_mul(b, b, nqr);
+  field_init_curve_ab_gen(cnew, a, b, ordernew, NULL, gen, gen_len);
+  element_clear(a);
+  element_clear(b);
 }
 
 // I could generalize this for all fields, but is there any point?
 void field_curve_set_quotient_cmp(field_ptr c, mpz_t quotient_cmp) {
   curve_data_ptr cdp = c->data;
+  // The points are coset representatives, not all of order r.
+  glv_clear(cdp);
   cdp->quotient_cmp = pbc_malloc(sizeof(mpz_t));
   mpz_init(cdp->quotient_cmp);
   mpz_set(cdp->quotient_cmp, quotient_cmp);
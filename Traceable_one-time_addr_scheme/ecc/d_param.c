@@ -31,6 +31,10 @@ struct d_param_s {
   mpz_t hk;      // hk * r^2 = nk
   mpz_t *coeff;  // coefficients of polynomial used to extend F_q by k/2
   mpz_t nqr;     // a quadratic nonresidue in F_q^d that lies in F_q
+  // Derived constants from a binary param file, see pbc_param_out_bin().
+  param_blob_t gen1, gen2;  // generators of E(F_q) and the twist
+  param_blob_t xpowq;       // x^q in F_q^d (k = 6 only)
+  param_blob_t fqnqr;       // a quadratic nonresidue of F_q
 };
 
 typedef struct d_param_s d_param_t[1];
@@ -48,6 +52,8 @@ typedef struct {
   int k;                      // The embedding degree, usually 6.
   // Let x be the element used to build Fqd from Fq, i.e. Fqd = Fq[x].
   element_t xpowq, xpowq2;    // x^q and x^{2q} in F_q^d.
+  // phikonr = hard[0] + hard[1] q with |hard[0]| <= q/2 (k = 6 only).
+  mpz_t hard[2];
 } *pptr;
 
 static void d_clear(void *data) {
@@ -67,6 +73,10 @@ static void d_clear(void *data) {
     mpz_clear(param->coeff[i]);
   }
   pbc_free(param->coeff);
+  param_blob_clear(param->gen1);
+  param_blob_clear(param->gen2);
+  param_blob_clear(param->xpowq);
+  param_blob_clear(param->fqnqr);
   pbc_free(data);
 }
 
@@ -281,7 +291,7 @@ static void cc_miller_no_denom_proj(element_t res, mpz_t q, element_t P,
 
   element_set(Z, P);
   Zx = curve_x_coord(Z);
-  Zy = curve_x_coord(Z);
+  Zy = curve_y_coord(Z);
 
   element_set1(v);
   m = mpz_sizeinbase(q, 2) - 2;
@@ -499,6 +509,65 @@ static void lucas_even(element_ptr out, element_ptr in, mpz_t cofactor) {
   element_clear(temp);
 }
 
+// out = in^q. The Frobenius map of F_q^d takes x^i to (x^q)^i, and that of
+// F_q^k negates sqrt(v), as v is a nonresidue in F_q. Requires in != out.
+static void cc_frobenius(element_ptr out, element_ptr in, pptr p) {
+  element_t e2;
+  int i;
+  element_init(e2, p->Fqd);
+  for (i = 0; i < 2; i++) {
+    element_t *c = element_item(in, i)->data;
+    element_ptr o = element_item(out, i);
+    polymod_const_mul(o, c[1], p->xpowq);
+    polymod_const_mul(e2, c[2], p->xpowq2);
+    element_add(o, o, e2);
+    element_add(((element_t *) o->data)[0], ((element_t *) o->data)[0], c[0]);
+  }
+  element_neg(element_y(out), element_y(out));
+  element_clear(e2);
+}
+
+// out = in^n for an in of norm 1 and any n: lucas_even() takes odd powers,
+// and the inverse is the conjugate. Requires in != out.
+static void cc_lucas(element_ptr out, element_ptr in, mpz_t n) {
+  element_t e0;
+  mpz_t m;
+  if (!mpz_sgn(n)) {
+    element_set1(out);
+    return;
+  }
+  element_init_same_as(e0, in);
+  element_set(e0, in);
+  mpz_init(m);
+  mpz_abs(m, n);
+  if (mpz_odd_p(m)) {
+    lucas_even(out, e0, m);
+  } else {
+    mpz_sub_ui(m, m, 1);
+    lucas_even(out, e0, m);
+    element_mul(out, out, in);
+  }
+  if (mpz_sgn(n) < 0) element_neg(element_y(out), element_y(out));
+  mpz_clear(m);
+  element_clear(e0);
+}
+
+// out = in^phikonr for an in of norm 1, as left by the first step of the
+// final powering: by Horner's rule in q, in^hard[1] sent through the
+// Frobenius, times in^hard[0]. As phikonr = h (q + t - 1) on MNT curves of
+// trace t, the Lucas sequences run over half the bits of phikonr.
+static void cc_hard_power(element_ptr out, element_ptr in, pptr p) {
+  element_t e0, e1;
+  element_init(e0, p->Fqk);
+  element_init(e1, p->Fqk);
+  cc_lucas(e0, in, p->hard[1]);
+  cc_frobenius(e1, e0, p);
+  cc_lucas(e0, in, p->hard[0]);
+  element_mul(out, e0, e1);
+  element_clear(e0);
+  element_clear(e1);
+}
+
 // The final powering, where we standardize the coset representative.
 static void cc_tatepower(element_ptr out, element_ptr in, pairing_t pairing) {
   pptr p = pairing->data;
@@ -548,9 +617,8 @@ static void cc_tatepower(element_ptr out, element_ptr in, pairing_t pairing) {
     element_invert(e0, e0);
     element_mul(in, e3, e0);
 
-    element_set(e0, in);
     // We use Lucas sequences to complete the final powering.
-    lucas_even(out, e0, pairing->phikonr);
+    cc_hard_power(out, in, p);
 
     element_clear(e0);
     element_clear(e2);
@@ -703,7 +771,7 @@ static void cc_millers_no_denom_affine(element_t res, mpz_t q, element_t P[],
 }
 
 
-void cc_pairings_affine(element_ptr out, element_t in1[], element_t in2[],
+static void cc_pairings_affine(element_ptr out, element_t in1[], element_t in2[],
         int n_prod, pairing_t pairing) {
   element_ptr Qbase;
   element_t* Qx = pbc_malloc(sizeof(element_t)*n_prod);
@@ -965,6 +1033,8 @@ static void d_pairing_clear(pairing_t pairing) {
   if (p->k == 6) {
     element_clear(p->xpowq);
     element_clear(p->xpowq2);
+    mpz_clear(p->hard[0]);
+    mpz_clear(p->hard[1]);
     mpz_clear(pairing->phikonr);
   } else {
     mpz_clear(p->tateexp);
@@ -1002,11 +1072,13 @@ static void d_init_pairing(pairing_ptr pairing, void *data) {
 
   p = pairing->data = pbc_malloc(sizeof(*p));
   field_init_fp(p->Fq, param->q);
+  param_blob_to_nqr(p->Fq, param->fqnqr);
   element_init(a, p->Fq);
   element_init(b, p->Fq);
   element_set_mpz(a, param->a);
   element_set_mpz(b, param->b);
-  field_init_curve_ab(p->Eq, a, b, pairing->r, param->h);
+  field_init_curve_ab_gen(p->Eq, a, b, pairing->r, param->h,
+      param->gen1->data, param->gen1->len);
 
   field_init_poly(p->Fqx, p->Fq);
   element_init(irred, p->Fqx);
@@ -1028,6 +1100,7 @@ static void d_init_pairing(pairing_ptr pairing, void *data) {
   if (param->k == 6) {
     mpz_ptr q = param->q;
     mpz_ptr z = pairing->phikonr;
+    mpz_t z0;
     mpz_init(z);
     mpz_mul(z, q, q);
     mpz_sub(z, z, q);
@@ -1036,19 +1109,33 @@ static void d_init_pairing(pairing_ptr pairing, void *data) {
 
     element_ptr e = p->xpowq;
     element_init(e, p->Fqd);
-    element_set1(((element_t *) e->data)[1]);
-    element_pow_mpz(e, e, q);
+    if (!param_blob_to_element(e, param->xpowq)) {
+      element_set1(((element_t *) e->data)[1]);
+      element_pow_mpz(e, e, q);
+    }
 
     element_init(p->xpowq2, p->Fqd);
     element_square(p->xpowq2, e);
+
+    // The balanced base q digits of phikonr.
+    mpz_init(p->hard[0]);
+    mpz_init(p->hard[1]);
+    mpz_fdiv_qr(p->hard[1], p->hard[0], z, q);
+    mpz_init(z0);
+    mpz_sub(z0, q, p->hard[0]);
+    if (mpz_cmp(p->hard[0], z0) > 0) {
+      mpz_neg(p->hard[0], z0);
+      mpz_add_ui(p->hard[1], p->hard[1], 1);
+    }
+    mpz_clear(z0);
   } else {
     mpz_init(p->tateexp);
     mpz_sub_ui(p->tateexp, p->Fqk->order, 1);
     mpz_divexact(p->tateexp, p->tateexp, pairing->r);
   }
 
-  field_init_curve_ab_map(p->Etwist, p->Eq, element_field_to_polymod, p->Fqd, pairing->r, NULL);
-  field_reinit_curve_twist(p->Etwist);
+  field_init_curve_ab_map_twist(p->Etwist, p->Eq, element_field_to_polymod, p->Fqd,
+      pairing->r, param->gen2->data, param->gen2->len);
 
   mpz_t ndonr;
   mpz_init(ndonr);
@@ -1166,11 +1253,27 @@ static void compute_cm_curve(d_param_ptr param, pbc_cm_ptr cm) {
   field_clear(fp);
 }
 
+static void d_out_precomp(FILE *stream, pairing_ptr pairing) {
+  pptr p = pairing->data;
+  element_t e;
+  element_init(e, p->Eq);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen1", e);
+  element_clear(e);
+  element_init(e, p->Etwist);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen2", e);
+  element_clear(e);
+  if (p->k == 6) param_out_bin_element(stream, "xpowq", p->xpowq);
+  param_out_bin_element(stream, "fqnqr", field_get_nqr(p->Fq));
+}
+
 static void d_param_init(pbc_param_ptr p) {
   static pbc_param_interface_t interface = {{
     d_clear,
     d_init_pairing,
     d_out_str,
+    d_out_precomp,
   }};
   p->api = interface;
   d_param_ptr param = p->data = pbc_malloc(sizeof(*param));
@@ -1185,6 +1288,10 @@ static void d_param_init(pbc_param_ptr p) {
   param->k = 0;
   param->coeff = NULL;
   mpz_init(param->nqr);
+  param_blob_init(param->gen1);
+  param_blob_init(param->gen2);
+  param_blob_init(param->xpowq);
+  param_blob_init(param->fqnqr);
 }
 
 // Public interface:
@@ -1214,6 +1321,10 @@ int pbc_param_init_d(pbc_param_ptr par, struct symtab_s *tab) {
     mpz_init(p->coeff[i]);
     err += lookup_mpz(p->coeff[i], tab, s);
   }
+  lookup_blob(p->gen1, tab, "gen1");
+  lookup_blob(p->gen2, tab, "gen2");
+  lookup_blob(p->xpowq, tab, "xpowq");
+  lookup_blob(p->fqnqr, tab, "fqnqr");
   return err;
 }
 
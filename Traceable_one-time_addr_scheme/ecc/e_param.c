@@ -481,6 +481,411 @@ static void e_pairing(element_ptr out, element_ptr in1, element_ptr in2,
   element_clear(QR);
 }
 
+// Tables of e_pairing_pp_init(): the lines of the Miller loop of
+// e_miller_affine() for a fixed first input, in the order the loop meets
+// them, in one vector of elements of Fq. A doubling step holds the tangent
+// a, b, c and the x-coordinate of the doubled point, the step after exp1
+// one more x-coordinate when sign1 < 0, and the end the line a, b, c, the
+// x-coordinate of the sum and, when sign0 > 0, that of the input.
+//
+// The loop evaluates every line at Q + R and at R, and R is fixed: the
+// half at R is done once here, leaving the quotient of its two products.
+struct e_pp_s {
+  element_vec_t coeff;
+  element_t atR;  // vd / v of the loop for lines evaluated at R only
+};
+typedef struct e_pp_s *e_pp_ptr;
+
+static int e_pp_count(e_pairing_data_ptr p) {
+  return 4 * p->exp2 + (p->sign1 < 0) + 4 + (p->sign0 > 0);
+}
+
+// The products e_miller_affine() accumulates in v and vd, for lines that
+// are only evaluated at (x, y).
+static void e_pp_eval(element_ptr v, element_ptr vd, element_t *coeff,
+    element_ptr x, element_ptr y, e_pairing_data_ptr p) {
+  int i, n;
+  element_t v1, vd1;
+  element_t e0, e1;
+
+  #define do_vertical(e) {      \
+    element_sub(e0, x, *coeff); \
+    element_mul(e, e, e0);      \
+    coeff++;                    \
+  }
+
+  #define do_line(e) {              \
+    element_mul(e0, coeff[0], x);   \
+    element_mul(e1, coeff[1], y);   \
+    element_add(e0, e0, e1);        \
+    element_add(e0, e0, coeff[2]);  \
+    element_mul(e, e, e0);          \
+    coeff += 3;                     \
+  }
+
+  element_init(v1, v->field);
+  element_init(vd1, v->field);
+  element_init(e0, v->field);
+  element_init(e1, v->field);
+
+  element_set1(v);
+  element_set1(vd);
+  n = p->exp1;
+  for (i=0; i<n; i++) {
+    element_square(v, v);
+    element_square(vd, vd);
+    do_line(v);
+    do_vertical(vd);
+  }
+  if (p->sign1 < 0) {
+    element_set(v1, vd);
+    element_set(vd1, v);
+    do_vertical(vd1);
+  } else {
+    element_set(v1, v);
+    element_set(vd1, vd);
+  }
+  n = p->exp2;
+  for (; i<n; i++) {
+    element_square(v, v);
+    element_square(vd, vd);
+    do_line(v);
+    do_vertical(vd);
+  }
+  element_mul(v, v, v1);
+  element_mul(vd, vd, vd1);
+  do_line(v);
+  do_vertical(vd);
+  if (p->sign0 > 0) {
+    do_vertical(v);
+  }
+
+  element_clear(v1);
+  element_clear(vd1);
+  element_clear(e0);
+  element_clear(e1);
+  #undef do_vertical
+  #undef do_line
+}
+
+static void e_pairing_pp_init(pairing_pp_t pp, element_ptr in1,
+    pairing_t pairing) {
+  e_pairing_data_ptr p = pairing->data;
+  e_pp_ptr info = pp->data = pbc_malloc(sizeof(*info));
+  element_t *coeff;
+  element_t Z, Z1;
+  element_t e0, vd;
+  element_ptr Zx, Zy;
+  const element_ptr cca = curve_a_coeff(in1);
+  int i, n;
+
+  #define do_vertical() {    \
+    element_set(*coeff, Zx); \
+    coeff++;                 \
+  }
+
+  // As in e_miller_affine(), scaled by 2 Zy.
+  #define do_tangent() {                     \
+    element_square(coeff[0], Zx);            \
+    element_mul_si(coeff[0], coeff[0], 3);   \
+    element_add(coeff[0], coeff[0], cca);    \
+    element_neg(coeff[0], coeff[0]);         \
+    element_add(coeff[1], Zy, Zy);           \
+    element_mul(e0, coeff[1], Zy);           \
+    element_mul(coeff[2], coeff[0], Zx);     \
+    element_add(coeff[2], coeff[2], e0);     \
+    element_neg(coeff[2], coeff[2]);         \
+    coeff += 3;                              \
+  }
+
+  #define do_line() {                    \
+    element_ptr Ax = curve_x_coord(Z);   \
+    element_ptr Ay = curve_y_coord(Z);   \
+    element_ptr Bx = curve_x_coord(Z1);  \
+    element_ptr By = curve_y_coord(Z1);  \
+    element_sub(coeff[1], Bx, Ax);       \
+    element_sub(coeff[0], Ay, By);       \
+    element_mul(coeff[2], Ax, By);       \
+    element_mul(e0, Ay, Bx);             \
+    element_sub(coeff[2], coeff[2], e0); \
+    coeff += 3;                          \
+  }
+
+  element_vec_init(info->coeff, p->Fq, e_pp_count(p));
+  coeff = info->coeff->item;
+  element_init(info->atR, p->Fq);
+  element_init(vd, p->Fq);
+  element_init(e0, p->Fq);
+  element_init(Z, p->Eq);
+  element_init(Z1, p->Eq);
+  element_set(Z, in1);
+  Zx = curve_x_coord(Z);
+  Zy = curve_y_coord(Z);
+
+  n = p->exp1;
+  for (i=0; i<n; i++) {
+    do_tangent();
+    element_double(Z, Z);
+    do_vertical();
+  }
+  if (p->sign1 < 0) {
+    do_vertical();
+    element_neg(Z1, Z);
+  } else {
+    element_set(Z1, Z);
+  }
+  n = p->exp2;
+  for (; i<n; i++) {
+    do_tangent();
+    element_double(Z, Z);
+    do_vertical();
+  }
+  do_line();
+  element_add(Z, Z, Z1);
+  do_vertical();
+  if (p->sign0 > 0) {
+    element_set(*coeff, curve_x_coord(in1));
+    coeff++;
+  }
+
+  e_pp_eval(info->atR, vd, info->coeff->item,
+      curve_x_coord(p->R), curve_y_coord(p->R), p);
+  element_invert(info->atR, info->atR);
+  element_mul(info->atR, info->atR, vd);
+
+  element_clear(vd);
+  element_clear(e0);
+  element_clear(Z);
+  element_clear(Z1);
+  #undef do_vertical
+  #undef do_tangent
+  #undef do_line
+}
+
+static void e_pairing_pp_clear(pairing_pp_t pp) {
+  e_pp_ptr info = pp->data;
+  element_vec_clear(info->coeff);
+  element_clear(info->atR);
+  pbc_free(info);
+}
+
+static void e_pairing_pp_apply(element_ptr out, element_ptr in2,
+    pairing_pp_t pp) {
+  e_pairing_data_ptr p = pp->pairing->data;
+  e_pp_ptr info = pp->data;
+  element_t QR, vd;
+
+  element_init(QR, p->Eq);
+  element_init(vd, p->Fq);
+  element_add(QR, in2, p->R);
+  e_pp_eval(out, vd, info->coeff->item,
+      curve_x_coord(QR), curve_y_coord(QR), p);
+  element_invert(vd, vd);
+  element_mul(out, out, vd);
+  element_mul(out, out, info->atR);
+  element_pow_mpz(out, out, pp->pairing->phikonr);
+  element_clear(QR);
+  element_clear(vd);
+}
+
+// The affine Miller loop of e_miller_affine() run over several pairs at
+// once: the squarings and final division are shared, and the points are
+// doubled together.
+static void e_millers_affine(element_t res, element_t P[],
+    element_t QR[], element_ptr R, int n_prod,
+    e_pairing_data_ptr p) {
+  int n;
+  element_t v, vd;
+  element_t v1, vd1;
+  element_t *Z = pbc_malloc(sizeof(element_t) * n_prod);
+  element_t *Z1 = pbc_malloc(sizeof(element_t) * n_prod);
+  element_t a, b, c;
+  element_t e0, e1;
+  const element_ptr cca = curve_a_coeff(P[0]);
+  element_ptr Zx, Zy;
+  element_ptr numx, numy;
+  int i, j;
+  const element_ptr denomx = curve_x_coord(R);
+  const element_ptr denomy = curve_y_coord(R);
+
+  #define pair_set(j) {                \
+    numx = curve_x_coord(QR[j]);       \
+    numy = curve_y_coord(QR[j]);       \
+    Zx = curve_x_coord(Z[j]);          \
+    Zy = curve_y_coord(Z[j]);          \
+  }
+
+  #define do_vertical(e, edenom, Ax) { \
+    element_sub(e0, numx, Ax);         \
+    element_mul(e, e, e0);             \
+                                       \
+    element_sub(e0, denomx, Ax);       \
+    element_mul(edenom, edenom, e0);   \
+  }
+
+  #define do_tangent(e, edenom) {      \
+    element_square(a, Zx);             \
+    element_mul_si(a, a, 3);           \
+    element_add(a, a, cca);            \
+    element_neg(a, a);                 \
+                                       \
+    element_add(b, Zy, Zy);            \
+                                       \
+    element_mul(e0, b, Zy);            \
+    element_mul(c, a, Zx);             \
+    element_add(c, c, e0);             \
+    element_neg(c, c);                 \
+                                       \
+    element_mul(e0, a, numx);          \
+    element_mul(e1, b, numy);          \
+    element_add(e0, e0, e1);           \
+    element_add(e0, e0, c);            \
+    element_mul(e, e, e0);             \
+                                       \
+    element_mul(e0, a, denomx);        \
+    element_mul(e1, b, denomy);        \
+    element_add(e0, e0, e1);           \
+    element_add(e0, e0, c);            \
+    element_mul(edenom, edenom, e0);   \
+  }
+
+  #define do_line(e, edenom, A, B) {   \
+    element_ptr Ax = curve_x_coord(A); \
+    element_ptr Ay = curve_y_coord(A); \
+    element_ptr Bx = curve_x_coord(B); \
+    element_ptr By = curve_y_coord(B); \
+                                       \
+    element_sub(b, Bx, Ax);            \
+    element_sub(a, Ay, By);            \
+    element_mul(c, Ax, By);            \
+    element_mul(e0, Ay, Bx);           \
+    element_sub(c, c, e0);             \
+                                       \
+    element_mul(e0, a, numx);          \
+    element_mul(e1, b, numy);          \
+    element_add(e0, e0, e1);           \
+    element_add(e0, e0, c);            \
+    element_mul(e, e, e0);             \
+                                       \
+    element_mul(e0, a, denomx);        \
+    element_mul(e1, b, denomy);        \
+    element_add(e0, e0, e1);           \
+    element_add(e0, e0, c);            \
+    element_mul(edenom, edenom, e0);   \
+  }
+
+  #define double_all(i) {                      \
+    for (; i<n; i++) {                         \
+      element_square(v, v);                    \
+      element_square(vd, vd);                  \
+      for (j = 0; j < n_prod; j++) {           \
+        pair_set(j);                           \
+        do_tangent(v, vd);                     \
+      }                                        \
+      element_multi_double(Z, Z, n_prod);      \
+      for (j = 0; j < n_prod; j++) {           \
+        pair_set(j);                           \
+        do_vertical(vd, v, Zx);                \
+      }                                        \
+    }                                          \
+  }
+
+  element_init(a, res->field);
+  element_init(b, res->field);
+  element_init(c, res->field);
+  element_init(e0, res->field);
+  element_init(e1, res->field);
+
+  element_init(v, res->field);
+  element_init(vd, res->field);
+  element_init(v1, res->field);
+  element_init(vd1, res->field);
+  for (j = 0; j < n_prod; j++) {
+    element_init(Z[j], P[j]->field);
+    element_init(Z1[j], P[j]->field);
+    element_set(Z[j], P[j]);
+  }
+
+  element_set1(v);
+  element_set1(vd);
+
+  i = 0;
+  n = p->exp1;
+  double_all(i);
+  if (p->sign1 < 0) {
+    element_set(v1, vd);
+    element_set(vd1, v);
+    for (j = 0; j < n_prod; j++) {
+      pair_set(j);
+      do_vertical(vd1, v1, Zx);
+      element_neg(Z1[j], Z[j]);
+    }
+  } else {
+    element_set(v1, v);
+    element_set(vd1, vd);
+    for (j = 0; j < n_prod; j++) {
+      element_set(Z1[j], Z[j]);
+    }
+  }
+  n = p->exp2;
+  double_all(i);
+  element_mul(v, v, v1);
+  element_mul(vd, vd, vd1);
+  for (j = 0; j < n_prod; j++) {
+    pair_set(j);
+    do_line(v, vd, Z[j], Z1[j]);
+  }
+  element_multi_add(Z, Z, Z1, n_prod);
+  for (j = 0; j < n_prod; j++) {
+    pair_set(j);
+    do_vertical(vd, v, Zx);
+    if (p->sign0 > 0) {
+      do_vertical(v, vd, curve_x_coord(P[j]));
+    }
+  }
+
+  element_invert(vd, vd);
+  element_mul(res, v, vd);
+
+  element_clear(v);
+  element_clear(vd);
+  element_clear(v1);
+  element_clear(vd1);
+  for (j = 0; j < n_prod; j++) {
+    element_clear(Z[j]);
+    element_clear(Z1[j]);
+  }
+  pbc_free(Z);
+  pbc_free(Z1);
+  element_clear(a);
+  element_clear(b);
+  element_clear(c);
+  element_clear(e0);
+  element_clear(e1);
+  #undef pair_set
+  #undef do_vertical
+  #undef do_tangent
+  #undef do_line
+  #undef double_all
+}
+
+static void e_pairings(element_ptr out, element_t in1[], element_t in2[],
+    int n_prod, pairing_t pairing) {
+  e_pairing_data_ptr p = pairing->data;
+  element_t *QR = pbc_malloc(sizeof(element_t) * n_prod);
+  int i;
+  for (i = 0; i < n_prod; i++) {
+    element_init(QR[i], p->Eq);
+    element_add(QR[i], in2[i], p->R);
+  }
+  e_millers_affine(out, in1, QR, p->R, n_prod, p);
+  element_pow_mpz(out, out, pairing->phikonr);
+  for (i = 0; i < n_prod; i++) {
+    element_clear(QR[i]);
+  }
+  pbc_free(QR);
+}
+
 // in1, in2 are from E(F_q), out from F_q^2.
 // Pairing via elliptic nets (see Stange).
 static void e_pairing_ellnet(element_ptr out, element_ptr in1, element_ptr in2,
@@ -837,6 +1242,7 @@ static void e_init_pairing(pairing_t pairing, void *data) {
   mpz_set(pairing->r, param->r);
   field_init_fp(pairing->Zr, pairing->r);
   pairing->map = e_pairing;
+  pairing->prod_pairings = e_pairings;
   e_miller_fn = e_miller_proj;
 
   p = pairing->data = pbc_malloc(sizeof(e_pairing_data_t));
@@ -862,6 +1268,9 @@ static void e_init_pairing(pairing_t pairing, void *data) {
   pairing->phi = phi_identity;
   pairing->option_set = e_pairing_option_set;
   pairing->clear_func = e_pairing_clear;
+  pairing->pp_init = e_pairing_pp_init;
+  pairing->pp_clear = e_pairing_pp_clear;
+  pairing->pp_apply = e_pairing_pp_apply;
 
   element_init(p->R, p->Eq);
   curve_set_gen_no_cofac(p->R);
@@ -875,6 +1284,7 @@ static void e_init(pbc_param_ptr p) {
     e_clear,
     e_init_pairing,
     e_out_str,
+    NULL,
   }};
   p->api = interface;
   e_param_ptr ep = p->data = pbc_malloc(sizeof(*ep));
@@ -1,6 +1,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <gmp.h>
 #include "pbc_utils.h"
 #include "pbc_field.h"
@@ -197,6 +198,45 @@ static size_t point_out_str(FILE *stream, int base, element_ptr a) {
     }
 }
 
+/* return 1 if $y^2 = x^3 - x + 1$, 0 otherwise. */
+static int point_is_valid(point_ptr p) {
+    element_t t, t2;
+    element_init(t, FIELD(p->x));
+    element_init(t2, FIELD(p->x));
+    element_cubic(t, p->x); // t == x^3
+    element_sub(t, t, p->x); // t == x^3 - x
+    element_set1(t2);
+    element_add(t, t, t2); // t == x^3 - x + 1
+    element_mul(t2, p->y, p->y); // t2 == y^2
+    int valid = !element_cmp(t, t2);
+    element_clear(t);
+    element_clear(t2);
+    return valid;
+}
+
+/* x then y; (0, 0) is not on the curve and stands for the point at infinity. */
+static int point_to_bytes(unsigned char *d, element_ptr e) {
+    point_ptr p = DATA(e);
+    int len = BASE(e)->fixed_length_in_bytes;
+    if (p->isinf)
+        memset(d, 0, 2 * len);
+    else {
+        element_to_bytes(d, p->x);
+        element_to_bytes(d + len, p->y);
+    }
+    return 2 * len;
+}
+
+static int point_from_bytes(element_ptr e, unsigned char *d) {
+    point_ptr p = DATA(e);
+    int len = BASE(e)->fixed_length_in_bytes;
+    element_from_bytes(p->x, d);
+    element_from_bytes(p->y, d + len);
+    // points off the curve, including the (0, 0) encoding, become O
+    p->isinf = !point_is_valid(p);
+    return 2 * len;
+}
+
 static void point_field_clear(field_ptr f) {
     UNUSED_VAR(f);
 }
@@ -215,6 +255,9 @@ void field_init_eta_T_3(field_t f, field_t base) {
     f->is1 = f->is0 = point_is0;
     f->mul_mpz = f->pow_mpz;
     f->out_str = point_out_str;
+    f->to_bytes = point_to_bytes;
+    f->from_bytes = point_from_bytes;
+    f->fixed_length_in_bytes = 2 * base->fixed_length_in_bytes;
     f->field_clear = point_field_clear;
     f->name = "eta_T_3 point group";
 }
@@ -748,6 +791,7 @@ static void param_init(pbc_param_ptr p) {
       (void (*)(void *))eta_T_3_clear,
       (void (*)(pairing_t, void *))eta_T_3_init_pairing,
       (void (*)(FILE *, void *))eta_T_3_out_str,
+      NULL,
     }};
     p->api = interface;
     params *param = p->data = pbc_malloc(sizeof(*param));
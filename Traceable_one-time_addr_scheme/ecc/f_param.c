@@ -26,6 +26,9 @@ struct f_param_s {
         //is irreducible over F_q^2[x], so
         //we can extend F_q^2 to F_q^12 using the
         //sixth root of -(alpha0 + alpha1 sqrt(beta))
+    // Derived constants from a binary param file, see pbc_param_out_bin().
+    param_blob_t gen1, gen2; // generators of E(F_q) and the twist
+    param_blob_t xpowq2, xpowq6, xpowq8; // as in f_pairing_data_s
 };
 typedef struct f_param_s f_param_t[1];
 typedef struct f_param_s *f_param_ptr;
@@ -42,6 +45,19 @@ struct f_pairing_data_s {
   //for tate exponentiation speedup:
   //x^{q^k} for various k
   element_t xpowq2, xpowq6, xpowq8;
+
+  // Optimal ate pairing, when q and r are those of a BN curve of
+  // parameter u; otherwise the Tate pairing.
+  int ate;
+  int u_neg;        // u < 0
+  mpz_t u_abs;      // |u|
+  mpz_t ate_loop;   // |6u + 2|
+  // frob[k - 1][i] = gamma_k^i, where w^(q^k) = gamma_k w, for the
+  // Frobenius maps of F_q^12, and the same maps on the twist:
+  // pi(X, Y) = (conj(X) twistx1, conj(Y) twisty1),
+  // pi^2(X, Y) = (X twistx2, Y twisty2).
+  element_t frob[3][6];
+  element_t twistx1, twisty1, twistx2, twisty2;
 };
 typedef struct f_pairing_data_s f_pairing_data_t[1];
 typedef struct f_pairing_data_s *f_pairing_data_ptr;
@@ -54,6 +70,11 @@ static void f_clear(void *data) {
   mpz_clear(fp->beta);
   mpz_clear(fp->alpha0);
   mpz_clear(fp->alpha1);
+  param_blob_clear(fp->gen1);
+  param_blob_clear(fp->gen2);
+  param_blob_clear(fp->xpowq2);
+  param_blob_clear(fp->xpowq6);
+  param_blob_clear(fp->xpowq8);
   pbc_free(data);
 }
 
@@ -94,6 +115,30 @@ static void tryplusx(mpz_ptr q, mpz_ptr x) {
   mpz_add_ui(q, q, 1);
 }
 
+// Sets u to the BN parameter of q and r, with q = 36u^4 + 36u^3 + 24u^2 +
+// 6u + 1 and trace 6u^2 + 1, and returns 1, or returns 0 if there is none.
+static int f_bn_param(mpz_ptr u, mpz_ptr q, mpz_ptr r) {
+  mpz_t z;
+  int found = 0;
+  mpz_init(z);
+  // 6u^2 = t - 1 = q - r.
+  mpz_sub(z, q, r);
+  if (mpz_sgn(z) > 0 && mpz_divisible_ui_p(z, 6)) {
+    mpz_divexact_ui(z, z, 6);
+    if (mpz_perfect_square_p(z)) {
+      mpz_sqrt(u, z);
+      tryplusx(z, u);
+      if (!mpz_cmp(z, q)) found = 1;
+      else {
+        tryminusx(z, u);
+        if (!mpz_cmp(z, q)) found = 1, mpz_neg(u, u);
+      }
+    }
+  }
+  mpz_clear(z);
+  return found;
+}
+
 static void cc_miller_no_denom(element_t res, mpz_t q, element_t P,
     element_ptr Qx, element_ptr Qy, element_t negalpha) {
   int m;
@@ -246,9 +291,427 @@ static void cc_miller_no_denom(element_t res, mpz_t q, element_t P,
   #undef do_line
 }
 
+// Miller loops of several pairings at once, sharing the squarings of the
+// accumulator. The points double and add together, with one inversion per
+// step for all of them.
+static void cc_millers_no_denom(element_t res, mpz_t q, element_t P[],
+    element_t Qx[], element_t Qy[], int n_prod, element_t negalpha) {
+  int m, i;
+  element_t v;
+  element_t *Z = pbc_malloc(sizeof(element_t) * n_prod);
+  element_t a, b, c;
+  element_t t0;
+  element_t e0, e1;
+  element_ptr Zx, Zy, Px, Py;
+
+  // As in cc_miller_no_denom(), for the i-th point.
+  #define do_term(j, k, l, flag) {                                \
+    element_ptr e2;                                               \
+    e2 = element_item(e0, j);                                     \
+    element_mul(e1, element_item(v, k), Qx[i]);                   \
+    if (flag == 1) element_mul(e1, e1, negalpha);                 \
+    element_mul(element_x(e1), element_x(e1), a);                 \
+    element_mul(element_y(e1), element_y(e1), a);                 \
+    element_mul(e2, element_item(v, l), Qy[i]);                   \
+    element_mul(element_x(e2), element_x(e2), b);                 \
+    element_mul(element_y(e2), element_y(e2), b);                 \
+    element_add(e2, e2, e1);                                      \
+    if (flag == 2) element_mul(e2, e2, negalpha);                 \
+    element_mul(element_x(e1), element_x(element_item(v, j)), c); \
+    element_mul(element_y(e1), element_y(element_item(v, j)), c); \
+    element_add(e2, e2, e1);                                      \
+  }
+
+  #define f_miller_evalfn() { \
+    do_term(0, 2, 3, 2);      \
+    do_term(1, 3, 4, 2);      \
+    do_term(2, 4, 5, 2);      \
+    do_term(3, 5, 0, 1);      \
+    do_term(4, 0, 1, 0);      \
+    do_term(5, 1, 2, 0);      \
+    element_set(v, e0);       \
+  }
+
+  #define do_tangents() {          \
+    for (i = 0; i < n_prod; i++) { \
+      Zx = curve_x_coord(Z[i]);    \
+      Zy = curve_y_coord(Z[i]);    \
+      element_square(a, Zx);       \
+      element_mul_si(a, a, 3);     \
+      element_neg(a, a);           \
+                                   \
+      element_add(b, Zy, Zy);      \
+                                   \
+      element_mul(t0, b, Zy);      \
+      element_mul(c, a, Zx);       \
+      element_add(c, c, t0);       \
+      element_neg(c, c);           \
+                                   \
+      f_miller_evalfn();           \
+    }                              \
+  }
+
+  #define do_lines() {             \
+    for (i = 0; i < n_prod; i++) { \
+      Px = curve_x_coord(P[i]);    \
+      Py = curve_y_coord(P[i]);    \
+      Zx = curve_x_coord(Z[i]);    \
+      Zy = curve_y_coord(Z[i]);    \
+      element_sub(b, Px, Zx);      \
+      element_sub(a, Zy, Py);      \
+      element_mul(t0, b, Zy);      \
+      element_mul(c, a, Zx);       \
+      element_add(c, c, t0);       \
+      element_neg(c, c);           \
+                                   \
+      f_miller_evalfn();           \
+    }                              \
+  }
+
+  Px = curve_x_coord(P[0]);
+  element_init(a, Px->field);
+  element_init(b, a->field);
+  element_init(c, a->field);
+  element_init(t0, a->field);
+  element_init(e0, res->field);
+  element_init(e1, Qx[0]->field);
+
+  element_init(v, res->field);
+  for (i = 0; i < n_prod; i++) {
+    element_init(Z[i], P[i]->field);
+    element_set(Z[i], P[i]);
+  }
+
+  element_set1(v);
+  m = mpz_sizeinbase(q, 2) - 2;
+
+  for(;;) {
+    do_tangents();
+
+    if (!m) break;
+
+    element_multi_double(Z, Z, n_prod);
+    if (mpz_tstbit(q, m)) {
+      do_lines();
+      element_multi_add(Z, Z, P, n_prod);
+    }
+    m--;
+    element_square(v, v);
+  }
+
+  element_set(res, v);
+
+  element_clear(v);
+  for (i = 0; i < n_prod; i++) element_clear(Z[i]);
+  pbc_free(Z);
+  element_clear(a);
+  element_clear(b);
+  element_clear(c);
+  element_clear(t0);
+  element_clear(e0);
+  element_clear(e1);
+  #undef do_term
+  #undef f_miller_evalfn
+  #undef do_tangents
+  #undef do_lines
+}
+
+// Optimal ate pairing of BN curves (Vercauteren): with u the BN parameter
+// and s = 6u + 2, e(P, Q) = (f_{s,Q}(P) l_{[s]Q, pi(Q)}(P)
+// l_{[s]Q + pi(Q), -pi^2(Q)}(P))^((q^12 - 1) / r), where pi is the q-power
+// Frobenius. The Miller loop runs over Q on the twist and is about a
+// quarter as long as the one over r.
+//
+// Q = (X, Y) on the twist maps to (X w^-2, Y w^-3) on E(F_q^12), where w is
+// the root of x^6 + alpha. On a line of slope lambda through (X, Y) of the
+// twist, the line function at P = (x, y), times w^3, is
+//   (lambda X - Y) - lambda x w^2 + y w^3.
+// Only lambda and c = lambda X - Y depend on Q, so the lines of a fixed Q
+// are kept in a table and evaluated at any number of points P.
+struct f_lines_s {
+  int n;
+  element_t *lambda, *c;
+};
+
+// Adds the line through (X, Y) and (X2, Y2), the tangent if X2 is NULL,
+// as line k of l, and sets (X, Y) to the sum of the points.
+static void f_line_step(struct f_lines_s *l, int k, element_ptr X,
+    element_ptr Y, element_ptr X2, element_ptr Y2, element_ptr t) {
+  element_ptr lambda = l->lambda[k], c = l->c[k];
+  if (X2) {
+    element_sub(t, X2, X);
+    element_invert(t, t);
+    element_sub(lambda, Y2, Y);
+    element_mul(lambda, lambda, t);
+  } else {
+    element_double(t, Y);
+    element_invert(t, t);
+    element_square(lambda, X);
+    element_mul_si(lambda, lambda, 3);
+    element_mul(lambda, lambda, t);
+  }
+  element_mul(c, lambda, X);
+  element_sub(c, c, Y);
+  // X3 = lambda^2 - X - X2, Y3 = lambda (X - X3) - Y = c - lambda X3.
+  element_square(t, lambda);
+  element_sub(t, t, X);
+  element_sub(X, t, X2 ? X2 : X);
+  element_mul(t, lambda, X);
+  element_sub(Y, c, t);
+}
+
+static void f_lines_init(struct f_lines_s *l, element_ptr Q,
+    f_pairing_data_ptr p) {
+  mpz_ptr s = p->ate_loop;
+  int m = mpz_sizeinbase(s, 2) - 1;
+  int i, k = 0;
+  element_t X, Y, X2, Y2, t;
+
+  l->n = m + mpz_popcount(s) - 1 + 2;
+  l->lambda = pbc_malloc(sizeof(element_t) * l->n);
+  l->c = pbc_malloc(sizeof(element_t) * l->n);
+  for (i = 0; i < l->n; i++) {
+    element_init(l->lambda[i], p->Fq2);
+    element_init(l->c[i], p->Fq2);
+  }
+  element_init(X, p->Fq2);
+  element_init(Y, p->Fq2);
+  element_init(X2, p->Fq2);
+  element_init(Y2, p->Fq2);
+  element_init(t, p->Fq2);
+  element_set(X, curve_x_coord(Q));
+  element_set(Y, curve_y_coord(Q));
+  for (i = m - 1; i >= 0; i--) {
+    f_line_step(l, k++, X, Y, NULL, NULL, t);
+    if (mpz_tstbit(s, i)) {
+      f_line_step(l, k++, X, Y, curve_x_coord(Q), curve_y_coord(Q), t);
+    }
+  }
+  if (p->u_neg) element_neg(Y, Y);
+  // pi(Q) = (conj(X) gamma^-2, conj(Y) gamma^-3), where w^q = gamma w.
+  element_set(X2, curve_x_coord(Q));
+  element_neg(element_y(X2), element_y(X2));
+  element_mul(X2, X2, p->twistx1);
+  element_set(Y2, curve_y_coord(Q));
+  element_neg(element_y(Y2), element_y(Y2));
+  element_mul(Y2, Y2, p->twisty1);
+  f_line_step(l, k++, X, Y, X2, Y2, t);
+  // -pi^2(Q), where gamma_2 lies in F_q.
+  element_mul(X2, curve_x_coord(Q), p->twistx2);
+  element_mul(Y2, curve_y_coord(Q), p->twisty2);
+  element_neg(Y2, Y2);
+  f_line_step(l, k++, X, Y, X2, Y2, t);
+
+  element_clear(X);
+  element_clear(Y);
+  element_clear(X2);
+  element_clear(Y2);
+  element_clear(t);
+}
+
+static void f_lines_clear(struct f_lines_s *l) {
+  int i;
+  for (i = 0; i < l->n; i++) {
+    element_clear(l->lambda[i]);
+    element_clear(l->c[i]);
+  }
+  pbc_free(l->lambda);
+  pbc_free(l->c);
+}
+
+// Temporaries of f_mul_line().
+struct f_line_tmp_s {
+  element_t r;           // in F_q^12
+  element_t c2, t, n[3]; // in F_q^2
+};
+
+static void f_line_tmp_init(struct f_line_tmp_s *t, f_pairing_data_ptr p) {
+  int i;
+  element_init(t->r, p->Fq12);
+  element_init(t->c2, p->Fq2);
+  element_init(t->t, p->Fq2);
+  for (i = 0; i < 3; i++) element_init(t->n[i], p->Fq2);
+}
+
+static void f_line_tmp_clear(struct f_line_tmp_s *t) {
+  int i;
+  element_clear(t->r);
+  element_clear(t->c2);
+  element_clear(t->t);
+  for (i = 0; i < 3; i++) element_clear(t->n[i]);
+}
+
+// v *= c - lambda x w^2 + y w^3 for line k of l, where negx = -x. The
+// product has 18 multiplications in F_q^2 rather than 36.
+static void f_mul_line(element_ptr v, struct f_lines_s *l, int k,
+    element_ptr negx, element_ptr y, struct f_line_tmp_s *t,
+    f_pairing_data_ptr p) {
+  element_ptr c = l->c[k];
+  int i;
+
+  element_mul(element_x(t->c2), element_x(l->lambda[k]), negx);
+  element_mul(element_y(t->c2), element_y(l->lambda[k]), negx);
+  // Coefficients 3 to 5 wrap around times w^6 = -alpha.
+  for (i = 0; i < 3; i++) {
+    element_mul(t->n[i], element_item(v, i + 3), p->negalpha);
+  }
+  for (i = 0; i < 6; i++) {
+    element_ptr ri = element_item(t->r, i);
+    element_ptr v2 = i >= 2 ? element_item(v, i - 2) : t->n[i + 1];
+    element_ptr v3 = i >= 3 ? element_item(v, i - 3) : t->n[i];
+    element_mul(ri, c, element_item(v, i));
+    element_mul(t->t, t->c2, v2);
+    element_add(ri, ri, t->t);
+    element_mul(element_x(t->t), element_x(v3), y);
+    element_mul(element_y(t->t), element_y(v3), y);
+    element_add(ri, ri, t->t);
+  }
+  element_set(v, t->r);
+}
+
+// The value of an element of F_q^12 to the power q^6: w^(q^6) = -w, so
+// the odd coefficients change sign. Inverts elements of norm 1.
+static void f_conj(element_ptr out, element_ptr in) {
+  int i;
+  for (i = 0; i < 6; i++) {
+    if (i & 1) element_neg(element_item(out, i), element_item(in, i));
+    else element_set(element_item(out, i), element_item(in, i));
+  }
+}
+
+// out = in^(q^k) for k = 1, 2, 3: the coefficients are conjugated k times
+// and coefficient i is multiplied by gamma_k^i, where w^(q^k) = gamma_k w.
+static void f_frobenius(element_ptr out, element_ptr in, int k,
+    f_pairing_data_ptr p) {
+  int i;
+  for (i = 0; i < 6; i++) {
+    element_ptr o = element_item(out, i);
+    element_set(o, element_item(in, i));
+    if (k & 1) element_neg(element_y(o), element_y(o));
+    if (i) element_mul(o, o, p->frob[k - 1][i]);
+  }
+}
+
+// The Miller loops of n pairings on the lines of their second inputs,
+// sharing the squarings of the accumulator.
+static void f_ate_miller(element_ptr v, struct f_lines_s *l[],
+    element_ptr P[], int n, f_pairing_data_ptr p) {
+  mpz_ptr s = p->ate_loop;
+  int m = mpz_sizeinbase(s, 2) - 1;
+  int i, j, k = 0;
+  element_t *negx = pbc_malloc(sizeof(element_t) * n);
+  struct f_line_tmp_s t;
+
+  f_line_tmp_init(&t, p);
+  for (j = 0; j < n; j++) {
+    element_init(negx[j], p->Fq);
+    element_neg(negx[j], curve_x_coord(P[j]));
+  }
+  #define mul_lines() {                                              \
+    for (j = 0; j < n; j++) {                                        \
+      f_mul_line(v, l[j], k, negx[j], curve_y_coord(P[j]), &t, p);   \
+    }                                                                \
+    k++;                                                             \
+  }
+  element_set1(v);
+  for (i = m - 1; i >= 0; i--) {
+    if (i < m - 1) element_square(v, v);
+    mul_lines();
+    if (mpz_tstbit(s, i)) mul_lines();
+  }
+  // f_{-s} is 1 / f_s up to a vertical line, and the inverse up to
+  // factors the final exponentiation removes.
+  if (p->u_neg) f_conj(v, v);
+  mul_lines();
+  mul_lines();
+  #undef mul_lines
+
+  for (j = 0; j < n; j++) element_clear(negx[j]);
+  pbc_free(negx);
+  f_line_tmp_clear(&t);
+}
+
+// out = in^u, in of norm 1.
+static void f_pow_u(element_ptr out, element_ptr in, f_pairing_data_ptr p) {
+  element_pow_mpz(out, in, p->u_abs);
+  if (p->u_neg) f_conj(out, out);
+}
+
+// Raises out to (q^12 - 1) / r = (q^6 - 1)(q^2 + 1)(q^4 - q^2 + 1) / r. The
+// last factor is lambda_3 q^3 + lambda_2 q^2 + lambda_1 q + lambda_0 with
+// the lambda_i polynomials in u, computed with three powers to u,
+// Frobenius maps and an addition chain (Scott et al., "On the final
+// exponentiation for calculating pairings on ordinary elliptic curves").
+static void f_ate_finalexp(element_ptr out, f_pairing_data_ptr p) {
+  element_t fu, fu2, fu3, y[7], t0, t1;
+  int i;
+
+  element_init(fu, p->Fq12);
+  element_init(fu2, p->Fq12);
+  element_init(fu3, p->Fq12);
+  for (i = 0; i < 7; i++) element_init(y[i], p->Fq12);
+  element_init(t0, p->Fq12);
+  element_init(t1, p->Fq12);
+
+  // out^((q^6 - 1)(q^2 + 1)), after which out has norm 1.
+  element_invert(t0, out);
+  f_conj(out, out);
+  element_mul(out, out, t0);
+  f_frobenius(t0, out, 2, p);
+  element_mul(out, out, t0);
+
+  f_pow_u(fu, out, p);
+  f_pow_u(fu2, fu, p);
+  f_pow_u(fu3, fu2, p);
+  // y0 = f^q f^(q^2) f^(q^3), y1 = 1 / f, y2 = (f^(u^2))^(q^2),
+  // y3 = 1 / (f^u)^q, y4 = 1 / (f^u (f^(u^2))^q), y5 = 1 / f^(u^2),
+  // y6 = 1 / (f^(u^3) (f^(u^3))^q)
+  f_frobenius(y[0], out, 1, p);
+  f_frobenius(t0, out, 2, p);
+  element_mul(y[0], y[0], t0);
+  f_frobenius(t0, out, 3, p);
+  element_mul(y[0], y[0], t0);
+  f_conj(y[1], out);
+  f_frobenius(y[2], fu2, 2, p);
+  f_frobenius(y[3], fu, 1, p);
+  f_conj(y[3], y[3]);
+  f_frobenius(y[4], fu2, 1, p);
+  element_mul(y[4], y[4], fu);
+  f_conj(y[4], y[4]);
+  f_conj(y[5], fu2);
+  f_frobenius(y[6], fu3, 1, p);
+  element_mul(y[6], y[6], fu3);
+  f_conj(y[6], y[6]);
+  // y0 y1^2 y2^6 y3^12 y4^18 y5^30 y6^36
+  element_square(t0, y[6]);
+  element_mul(t0, t0, y[4]);
+  element_mul(t0, t0, y[5]);
+  element_mul(t1, y[3], y[5]);
+  element_mul(t1, t1, t0);
+  element_mul(t0, t0, y[2]);
+  element_square(t1, t1);
+  element_mul(t1, t1, t0);
+  element_square(t1, t1);
+  element_mul(t0, t1, y[1]);
+  element_mul(t1, t1, y[0]);
+  element_square(t0, t0);
+  element_mul(out, t0, t1);
+
+  element_clear(fu);
+  element_clear(fu2);
+  element_clear(fu3);
+  for (i = 0; i < 7; i++) element_clear(y[i]);
+  element_clear(t0);
+  element_clear(t1);
+}
+
 static void f_tateexp(element_t out) {
   element_t x, y, epow;
   f_pairing_data_ptr p = out->field->pairing->data;
+  if (p->ate) {
+    f_ate_finalexp(out, p);
+    return;
+  }
   element_init(x, p->Fq12);
   element_init(y, p->Fq12);
   element_init(epow, p->Fq2);
@@ -291,6 +754,14 @@ static void f_pairing(element_ptr out, element_ptr in1, element_ptr in2,
   element_t x, y;
   f_pairing_data_ptr p = pairing->data;
 
+  if (p->ate) {
+    struct f_lines_s l, *lp = &l;
+    f_lines_init(&l, in2, p);
+    f_ate_miller(out, &lp, &in1, 1, p);
+    f_lines_clear(&l);
+    f_tateexp(out);
+    return;
+  }
   element_init(x, p->Fq2);
   element_init(y, p->Fq2);
   //map from twist: (x, y) --> (v^-2 x, v^-3 y)
@@ -309,6 +780,70 @@ static void f_pairing(element_ptr out, element_ptr in1, element_ptr in2,
   f_tateexp(out);
 }
 
+// Product of pairings with one Miller loop and one final exponentiation.
+static void f_pairings(element_ptr out, element_t in1[], element_t in2[],
+    int n_prod, pairing_t pairing) {
+  element_t *x, *y;
+  f_pairing_data_ptr p = pairing->data;
+  int i;
+
+  if (p->ate) {
+    struct f_lines_s *l = pbc_malloc(sizeof(*l) * n_prod);
+    struct f_lines_s **lp = pbc_malloc(sizeof(*lp) * n_prod);
+    element_ptr *P = pbc_malloc(sizeof(*P) * n_prod);
+    for (i = 0; i < n_prod; i++) {
+      f_lines_init(l + i, in2[i], p);
+      lp[i] = l + i;
+      P[i] = in1[i];
+    }
+    f_ate_miller(out, lp, P, n_prod, p);
+    for (i = 0; i < n_prod; i++) f_lines_clear(l + i);
+    pbc_free(l);
+    pbc_free(lp);
+    pbc_free(P);
+    f_tateexp(out);
+    return;
+  }
+  x = pbc_malloc(sizeof(element_t) * n_prod);
+  y = pbc_malloc(sizeof(element_t) * n_prod);
+  for (i = 0; i < n_prod; i++) {
+    element_init(x[i], p->Fq2);
+    element_init(y[i], p->Fq2);
+    //map from twist, as in f_pairing()
+    element_mul(x[i], curve_x_coord(in2[i]), p->negalphainv);
+    element_mul(y[i], curve_y_coord(in2[i]), p->negalphainv);
+  }
+  cc_millers_no_denom(out, pairing->r, in1, x, y, n_prod, p->negalpha);
+  for (i = 0; i < n_prod; i++) {
+    element_clear(x[i]);
+    element_clear(y[i]);
+  }
+  pbc_free(x);
+  pbc_free(y);
+
+  f_tateexp(out);
+}
+
+// Pairings whose second inputs repeat, such as those of one key with many
+// points, share the lines of each run of equal second inputs: these are
+// the precomputation of a fixed argument under the ate pairing.
+static void f_map_batch(element_ptr out[], element_ptr in1[],
+    element_ptr in2[], int n, pairing_t pairing) {
+  f_pairing_data_ptr p = pairing->data;
+  struct f_lines_s l, *lp = &l;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (!i || element_cmp(in2[i], in2[i - 1])) {
+      if (i) f_lines_clear(&l);
+      f_lines_init(&l, in2[i], p);
+    }
+    f_ate_miller(out[i], &lp, in1 + i, 1, p);
+    f_tateexp(out[i]);
+  }
+  f_lines_clear(&l);
+}
+
 static void f_pairing_clear(pairing_t pairing) {
   field_clear(pairing->GT);
   f_pairing_data_ptr p = pairing->data;
@@ -318,6 +853,18 @@ static void f_pairing_clear(pairing_t pairing) {
   element_clear(p->xpowq2);
   element_clear(p->xpowq6);
   element_clear(p->xpowq8);
+  if (p->ate) {
+    int k, i;
+    for (k = 0; k < 3; k++) {
+      for (i = 0; i < 6; i++) element_clear(p->frob[k][i]);
+    }
+    element_clear(p->twistx1);
+    element_clear(p->twisty1);
+    element_clear(p->twistx2);
+    element_clear(p->twisty2);
+  }
+  mpz_clear(p->u_abs);
+  mpz_clear(p->ate_loop);
   field_clear(p->Etwist);
   field_clear(p->Eq);
 
@@ -368,7 +915,8 @@ static void f_init_pairing(pairing_t pairing, void *data) {
 
   // Initialize the curve Y^2 = X^3 + b.
   element_set_mpz(e1, param->b);
-  field_init_curve_ab(p->Eq, e0, e1, pairing->r, NULL);
+  field_init_curve_ab_gen(p->Eq, e0, e1, pairing->r, NULL,
+      param->gen1->data, param->gen1->len);
 
   // Initialize the curve Y^2 = X^3 - alpha0 b - alpha1 sqrt(beta) b.
   element_set_mpz(e0, param->alpha0);
@@ -379,7 +927,24 @@ static void f_init_pairing(pairing_t pairing, void *data) {
   element_mul(element_y(e2), e0, e1);
   element_clear(e0);
   element_init(e0, p->Fq2);
-  field_init_curve_ab(p->Etwist, e0, e2, pairing->r, NULL);
+  // The ate pairing needs its second argument in the order r subgroup, not
+  // just a coset representative as for the Tate pairing, so on BN curves
+  // points of G2 are cleared of the cofactor #E'(F_q^2) / r = 2q - r.
+  mpz_init(p->u_abs);
+  mpz_init(p->ate_loop);
+  p->ate = f_bn_param(p->u_abs, param->q, param->r);
+  if (p->ate) {
+    mpz_t cofac;
+    mpz_init(cofac);
+    mpz_mul_2exp(cofac, param->q, 1);
+    mpz_sub(cofac, cofac, param->r);
+    field_init_curve_ab_gen(p->Etwist, e0, e2, pairing->r, cofac,
+        param->gen2->data, param->gen2->len);
+    mpz_clear(cofac);
+  } else {
+    field_init_curve_ab_gen(p->Etwist, e0, e2, pairing->r, NULL,
+        param->gen2->data, param->gen2->len);
+  }
   element_clear(e0);
   element_clear(e1);
   element_clear(e2);
@@ -402,6 +967,7 @@ static void f_init_pairing(pairing_t pairing, void *data) {
   pairing_GT_init(pairing, p->Fq12);
   pairing->finalpow = f_finalpow;
   pairing->map = f_pairing;
+  pairing->prod_pairings = f_pairings;
   pairing->clear_func = f_pairing_clear;
 
   mpz_init(p->tateexp);
@@ -421,28 +987,89 @@ static void f_init_pairing(pairing_t pairing, void *data) {
   element_init(p->xpowq2, p->Fq2);
   element_init(p->xpowq6, p->Fq2);
   element_init(p->xpowq8, p->Fq2);
-  element_t xpowq;
-  element_init(xpowq, p->Fq12);
-
-  //there are smarter ways since we know q = 1 mod 6
-  //and that x^6 = -alpha
-  //but this is fast enough
-  element_set1(element_item(xpowq, 1));
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_set(p->xpowq2, element_item(xpowq, 1));
-
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_set(p->xpowq6, element_item(xpowq, 1));
-
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_pow_mpz(xpowq, xpowq, param->q);
-  element_set(p->xpowq8, element_item(xpowq, 1));
-
-  element_clear(xpowq);
+  if (!param_blob_to_element(p->xpowq2, param->xpowq2)
+      || !param_blob_to_element(p->xpowq6, param->xpowq6)
+      || !param_blob_to_element(p->xpowq8, param->xpowq8)) {
+    element_t xpowq;
+    element_init(xpowq, p->Fq12);
+
+    //there are smarter ways since we know q = 1 mod 6
+    //and that x^6 = -alpha
+    //but this is fast enough
+    element_set1(element_item(xpowq, 1));
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_set(p->xpowq2, element_item(xpowq, 1));
+
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_set(p->xpowq6, element_item(xpowq, 1));
+
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_pow_mpz(xpowq, xpowq, param->q);
+    element_set(p->xpowq8, element_item(xpowq, 1));
+
+    element_clear(xpowq);
+  }
+
+  if (p->ate) {
+    mpz_t e;
+    int k, i;
+    p->u_neg = mpz_sgn(p->u_abs) < 0;
+    mpz_mul_ui(p->ate_loop, p->u_abs, 6);
+    mpz_add_ui(p->ate_loop, p->ate_loop, 2);
+    mpz_abs(p->ate_loop, p->ate_loop);
+    mpz_abs(p->u_abs, p->u_abs);
+
+    // gamma_1 = (w^6)^((q - 1) / 6) and gamma_(k+1) = conj(gamma_k) gamma_1.
+    mpz_init(e);
+    mpz_sub_ui(e, param->q, 1);
+    mpz_divexact_ui(e, e, 6);
+    for (k = 0; k < 3; k++) {
+      for (i = 0; i < 6; i++) element_init(p->frob[k][i], p->Fq2);
+      element_set1(p->frob[k][0]);
+    }
+    element_pow_mpz(p->frob[0][1], p->negalpha, e);
+    for (k = 1; k < 3; k++) {
+      element_set(p->frob[k][1], p->frob[k - 1][1]);
+      element_neg(element_y(p->frob[k][1]), element_y(p->frob[k][1]));
+      element_mul(p->frob[k][1], p->frob[k][1], p->frob[0][1]);
+    }
+    for (k = 0; k < 3; k++) {
+      for (i = 2; i < 6; i++) {
+        element_mul(p->frob[k][i], p->frob[k][i - 1], p->frob[k][1]);
+      }
+    }
+    mpz_clear(e);
+
+    element_init(p->twistx1, p->Fq2);
+    element_init(p->twisty1, p->Fq2);
+    element_init(p->twistx2, p->Fq2);
+    element_init(p->twisty2, p->Fq2);
+    element_invert(p->twistx1, p->frob[0][2]);
+    element_invert(p->twisty1, p->frob[0][3]);
+    element_invert(p->twistx2, p->frob[1][2]);
+    element_invert(p->twisty2, p->frob[1][3]);
+    pairing->map_batch = f_map_batch;
+  }
+}
+
+static void f_out_precomp(FILE *stream, pairing_ptr pairing) {
+  f_pairing_data_ptr p = pairing->data;
+  element_t e;
+  element_init(e, p->Eq);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen1", e);
+  element_clear(e);
+  element_init(e, p->Etwist);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen2", e);
+  element_clear(e);
+  param_out_bin_element(stream, "xpowq2", p->xpowq2);
+  param_out_bin_element(stream, "xpowq6", p->xpowq6);
+  param_out_bin_element(stream, "xpowq8", p->xpowq8);
 }
 
 static void f_init(pbc_param_ptr p) {
@@ -450,6 +1077,7 @@ static void f_init(pbc_param_ptr p) {
     f_clear,
     f_init_pairing,
     f_out_str,
+    f_out_precomp,
   }};
   p->api = interface;
   f_param_ptr fp = p->data = pbc_malloc(sizeof(*fp));
@@ -459,6 +1087,11 @@ static void f_init(pbc_param_ptr p) {
   mpz_init(fp->beta);
   mpz_init(fp->alpha0);
   mpz_init(fp->alpha1);
+  param_blob_init(fp->gen1);
+  param_blob_init(fp->gen2);
+  param_blob_init(fp->xpowq2);
+  param_blob_init(fp->xpowq6);
+  param_blob_init(fp->xpowq8);
 }
 
 // Public interface:
@@ -474,6 +1107,11 @@ int pbc_param_init_f(pbc_param_ptr par, struct symtab_s *tab) {
   err += lookup_mpz(p->beta, tab, "beta");
   err += lookup_mpz(p->alpha0, tab, "alpha0");
   err += lookup_mpz(p->alpha1, tab, "alpha1");
+  lookup_blob(p->gen1, tab, "gen1");
+  lookup_blob(p->gen2, tab, "gen2");
+  lookup_blob(p->xpowq2, tab, "xpowq2");
+  lookup_blob(p->xpowq6, tab, "xpowq6");
+  lookup_blob(p->xpowq8, tab, "xpowq8");
   return err;
 }
 
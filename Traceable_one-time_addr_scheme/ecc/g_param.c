@@ -30,6 +30,10 @@ struct g_param_s {
   mpz_t hk;      // hk * r^2 = nk
   mpz_t *coeff;  //Coefficients of polynomial used to extend F_q by k/2
   mpz_t nqr;     // Quadratic nonresidue in F_q^d that lies in F_q.
+  // Derived constants from a binary param file, see pbc_param_out_bin().
+  param_blob_t gen1, gen2;  // Generators of E(F_q) and the twist.
+  param_blob_t xpowq;       // x^q in F_q^d.
+  param_blob_t fqnqr;       // Quadratic nonresidue of F_q.
 };
 
 typedef struct g_param_s g_param_t[1];
@@ -40,6 +44,8 @@ struct mnt_pairing_data_s {
   field_t Eq, Etwist;
   element_t nqrinv, nqrinv2;
   element_t xpowq, xpowq2, xpowq3, xpowq4;
+  // phikonr = hard[0] + hard[1] q + ... + hard[3] q^3, balanced digits.
+  mpz_t hard[4];
 };
 typedef struct mnt_pairing_data_s mnt_pairing_data_t[1];
 typedef struct mnt_pairing_data_s *mnt_pairing_data_ptr;
@@ -60,6 +66,10 @@ static void g_clear(void *data) {
     mpz_clear(param->coeff[i]);
   }
   pbc_free(param->coeff);
+  param_blob_clear(param->gen1);
+  param_blob_clear(param->gen2);
+  param_blob_clear(param->xpowq);
+  param_blob_clear(param->fqnqr);
   pbc_free(data);
 }
 
@@ -269,7 +279,7 @@ static void cc_miller_no_denom_proj(element_t res, mpz_t q, element_t P,
 
   element_set(Z, P);
   Zx = curve_x_coord(Z);
-  Zy = curve_x_coord(Z);
+  Zy = curve_y_coord(Z);
 
   element_set1(v);
   m = mpz_sizeinbase(q, 2) - 2;
@@ -466,6 +476,76 @@ static void lucas_even(element_ptr out, element_ptr in, mpz_t cofactor) {
   element_clear(temp);
 }
 
+// out = in^q. The Frobenius map of F_q^d takes x^i to (x^q)^i, and that of
+// F_q^k negates sqrt(v), as v is a nonresidue in F_q. Requires in != out.
+static void g_frobenius(element_ptr out, element_ptr in,
+    mnt_pairing_data_ptr p) {
+  element_t e2;
+  int i;
+  element_init(e2, p->Fqd);
+  for (i = 0; i < 2; i++) {
+    element_t *c = element_item(in, i)->data;
+    element_ptr o = element_item(out, i);
+    polymod_const_mul(o, c[1], p->xpowq);
+    polymod_const_mul(e2, c[2], p->xpowq2);
+    element_add(o, o, e2);
+    polymod_const_mul(e2, c[3], p->xpowq3);
+    element_add(o, o, e2);
+    polymod_const_mul(e2, c[4], p->xpowq4);
+    element_add(o, o, e2);
+    element_add(((element_t *) o->data)[0], ((element_t *) o->data)[0], c[0]);
+  }
+  element_neg(element_y(out), element_y(out));
+  element_clear(e2);
+}
+
+// out = in^n for an in of norm 1 and any n: lucas_even() takes odd powers,
+// and the inverse is the conjugate. Requires in != out.
+static void g_lucas(element_ptr out, element_ptr in, mpz_t n) {
+  element_t e0;
+  mpz_t m;
+  if (!mpz_sgn(n)) {
+    element_set1(out);
+    return;
+  }
+  element_init_same_as(e0, in);
+  element_set(e0, in);
+  mpz_init(m);
+  mpz_abs(m, n);
+  if (mpz_odd_p(m)) {
+    lucas_even(out, e0, m);
+  } else {
+    mpz_sub_ui(m, m, 1);
+    lucas_even(out, e0, m);
+    element_mul(out, out, in);
+  }
+  if (mpz_sgn(n) < 0) element_neg(element_y(out), element_y(out));
+  mpz_clear(m);
+  element_clear(e0);
+}
+
+// out = in^phikonr for an in of norm 1, as left by the first step of the
+// final powering, by Horner's rule in q over the Frobenius. On Freeman
+// curves the digits of phikonr are polynomials of degree at most 3 in the
+// curve parameter, about 3/4 and 1/2 the length of q, so the Lucas
+// sequences run over 265 bits instead of 446 on g149.
+static void g_hard_power(element_ptr out, element_ptr in,
+    mnt_pairing_data_ptr p) {
+  element_t e0, e1;
+  int i;
+  element_init(e0, p->Fqk);
+  element_init(e1, p->Fqk);
+  g_lucas(e0, in, p->hard[3]);
+  for (i = 2; i >= 0; i--) {
+    g_frobenius(e1, e0, p);
+    g_lucas(e0, in, p->hard[i]);
+    element_mul(e0, e0, e1);
+  }
+  element_set(out, e0);
+  element_clear(e0);
+  element_clear(e1);
+}
+
 static void tatepower10(element_ptr out, element_ptr in, pairing_t pairing) {
   mnt_pairing_data_ptr p = pairing->data;
   element_t e0, e1, e2, e3;
@@ -523,8 +603,7 @@ static void tatepower10(element_ptr out, element_ptr in, pairing_t pairing) {
   element_invert(e0, e0);
   element_mul(in, e3, e0);
 
-  element_set(e0, in);
-  lucas_even(out, e0, pairing->phikonr);
+  g_hard_power(out, in, p);
 
   element_clear(e0);
   element_clear(e1);
@@ -555,6 +634,142 @@ static void cc_pairing(element_ptr out, element_ptr in1, element_ptr in2,
   element_clear(Qy);
 }
 
+// Miller loops of several pairings at once, in affine coordinates, sharing
+// the squarings of the accumulator. The points double and add together,
+// with one inversion per step for all of them.
+static void cc_millers_no_denom_affine(element_t res, mpz_t q, element_t P[],
+    element_t Qx[], element_t Qy[], int n_prod) {
+  int m, i;
+  element_t v;
+  element_t a, b, c;
+  element_t t0;
+  element_t e0;
+  const element_ptr cca = curve_a_coeff(P[0]);
+  element_ptr Px, Py;
+  element_t *Z = pbc_malloc(sizeof(element_t) * n_prod);
+  element_ptr Zx, Zy;
+
+  //a = -(3 Zx^2 + cc->a)
+  //b = 2 * Zy
+  //c = -(2 Zy^2 + a Zx);
+  #define do_tangents() {                         \
+    for (i = 0; i < n_prod; i++) {                \
+      Zx = curve_x_coord(Z[i]);                   \
+      Zy = curve_y_coord(Z[i]);                   \
+                                                  \
+      element_square(a, Zx);                      \
+      element_mul_si(a, a, 3);                    \
+      element_add(a, a, cca);                     \
+      element_neg(a, a);                          \
+                                                  \
+      element_add(b, Zy, Zy);                     \
+                                                  \
+      element_mul(t0, b, Zy);                     \
+      element_mul(c, a, Zx);                      \
+      element_add(c, c, t0);                      \
+      element_neg(c, c);                          \
+                                                  \
+      d_miller_evalfn(e0, a, b, c, Qx[i], Qy[i]); \
+      element_mul(v, v, e0);                      \
+    }                                             \
+  }
+
+  //a = -(B.y - A.y) / (B.x - A.x);
+  //b = 1;
+  //c = -(A.y + a * A.x);
+  //but we'll multiply by B.x - A.x to avoid division
+  #define do_lines() {                            \
+    for (i = 0; i < n_prod; i++) {                \
+      Px = curve_x_coord(P[i]);                   \
+      Py = curve_y_coord(P[i]);                   \
+      Zx = curve_x_coord(Z[i]);                   \
+      Zy = curve_y_coord(Z[i]);                   \
+                                                  \
+      element_sub(b, Px, Zx);                     \
+      element_sub(a, Zy, Py);                     \
+      element_mul(t0, b, Zy);                     \
+      element_mul(c, a, Zx);                      \
+      element_add(c, c, t0);                      \
+      element_neg(c, c);                          \
+                                                  \
+      d_miller_evalfn(e0, a, b, c, Qx[i], Qy[i]); \
+      element_mul(v, v, e0);                      \
+    }                                             \
+  }
+
+  element_init(a, cca->field);
+  element_init(b, a->field);
+  element_init(c, a->field);
+  element_init(t0, a->field);
+  element_init(e0, res->field);
+
+  element_init(v, res->field);
+  for (i = 0; i < n_prod; i++) {
+    element_init(Z[i], P[i]->field);
+    element_set(Z[i], P[i]);
+  }
+
+  element_set1(v);
+  m = mpz_sizeinbase(q, 2) - 2;
+
+  for (;;) {
+    do_tangents();
+
+    if (!m) break;
+
+    element_multi_double(Z, Z, n_prod);
+    if (mpz_tstbit(q, m)) {
+      do_lines();
+      element_multi_add(Z, Z, P, n_prod);
+    }
+    m--;
+    element_square(v, v);
+  }
+
+  element_set(res, v);
+
+  element_clear(v);
+  for (i = 0; i < n_prod; i++) {
+    element_clear(Z[i]);
+  }
+  pbc_free(Z);
+  element_clear(a);
+  element_clear(b);
+  element_clear(c);
+  element_clear(t0);
+  element_clear(e0);
+  #undef do_tangents
+  #undef do_lines
+}
+
+// Product of pairings with one Miller loop and one final exponentiation.
+static void cc_pairings_affine(element_ptr out, element_t in1[], element_t in2[],
+    int n_prod, pairing_t pairing) {
+  element_t *Qx = pbc_malloc(sizeof(element_t) * n_prod);
+  element_t *Qy = pbc_malloc(sizeof(element_t) * n_prod);
+  mnt_pairing_data_ptr p = pairing->data;
+  int i;
+
+  for (i = 0; i < n_prod; i++) {
+    element_init(Qx[i], p->Fqd);
+    element_init(Qy[i], p->Fqd);
+    //map from twist: (x, y) --> (v^-1 x, v^-(3/2) y)
+    //where v is the quadratic nonresidue used to construct the twist
+    element_mul(Qx[i], curve_x_coord(in2[i]), p->nqrinv);
+    //v^-3/2 = v^-2 * v^1/2
+    element_mul(Qy[i], curve_y_coord(in2[i]), p->nqrinv2);
+  }
+  cc_millers_no_denom_affine(out, pairing->r, in1, Qx, Qy, n_prod);
+  tatepower10(out, out, pairing);
+
+  for (i = 0; i < n_prod; i++) {
+    element_clear(Qx[i]);
+    element_clear(Qy[i]);
+  }
+  pbc_free(Qx);
+  pbc_free(Qy);
+}
+
 static int cc_is_almost_coddh(element_ptr a, element_ptr b,
     element_ptr c, element_ptr d,
     pairing_t pairing) {
@@ -1120,11 +1335,13 @@ static void g_pairing_ellnet(element_ptr out, element_ptr in1, element_ptr in2,
 static void g_pairing_clear(pairing_t pairing) {
   field_clear(pairing->GT);
   mnt_pairing_data_ptr p = pairing->data;
+  int i;
 
   element_clear(p->xpowq);
   element_clear(p->xpowq2);
   element_clear(p->xpowq3);
   element_clear(p->xpowq4);
+  for (i = 0; i < 4; i++) mpz_clear(p->hard[i]);
   mpz_clear(pairing->phikonr);
 
   field_clear(p->Etwist);
@@ -1144,8 +1361,10 @@ static void g_pairing_option_set(pairing_t pairing, char *key, char *value) {
   UNUSED_VAR(pairing);
   if (!strcmp(key, "method")) {
     if (!strcmp(value, "miller")) {
+      pairing->map = cc_pairing;
       cc_miller_no_denom_fn = cc_miller_no_denom_proj;
     } else if (!strcmp(value, "miller-affine")) {
+      pairing->map = cc_pairing;
       cc_miller_no_denom_fn = cc_miller_no_denom_affine;
     } else if (!strcmp(value, "shipsey-stange")) {
       pairing->map = g_pairing_ellnet;
@@ -1250,15 +1469,18 @@ static void g_init_pairing(pairing_t pairing, void *data) {
   mpz_set(pairing->r, param->r);
   field_init_fp(pairing->Zr, pairing->r);
   pairing->map = cc_pairing;
+  pairing->prod_pairings = cc_pairings_affine;
   pairing->is_almost_coddh = cc_is_almost_coddh;
 
   p = pairing->data = pbc_malloc(sizeof(mnt_pairing_data_t));
   field_init_fp(p->Fq, param->q);
+  param_blob_to_nqr(p->Fq, param->fqnqr);
   element_init(a, p->Fq);
   element_init(b, p->Fq);
   element_set_mpz(a, param->a);
   element_set_mpz(b, param->b);
-  field_init_curve_ab(p->Eq, a, b, pairing->r, param->h);
+  field_init_curve_ab_gen(p->Eq, a, b, pairing->r, param->h,
+      param->gen1->data, param->gen1->len);
 
   field_init_poly(p->Fqx, p->Fq);
   element_init(irred, p->Fqx);
@@ -1282,11 +1504,12 @@ static void g_init_pairing(pairing_t pairing, void *data) {
   // Compute phi(k)/r = (q^4 - q^3 + ... + 1)/r.
   {
     element_ptr e = p->xpowq;
-    mpz_t z0;
+    mpz_t z0, z1;
     mpz_ptr q = param->q;
     mpz_ptr z = pairing->phikonr;
     mpz_init(z);
     mpz_init(z0);
+    mpz_init(z1);
     mpz_set_ui(z, 1);
     mpz_sub(z, z, q);
     mpz_mul(z0, q, q);
@@ -1295,23 +1518,39 @@ static void g_init_pairing(pairing_t pairing, void *data) {
     mpz_sub(z, z, z0);
     mpz_mul(z0, z0, q);
     mpz_add(z, z, z0);
-    mpz_clear(z0);
     mpz_divexact(z, z, pairing->r);
 
+    // Its balanced base q digits.
+    mpz_set(z0, z);
+    for (i = 0; i < 3; i++) {
+      mpz_init(p->hard[i]);
+      mpz_fdiv_qr(z0, p->hard[i], z0, q);
+      mpz_sub(z1, q, p->hard[i]);
+      if (mpz_cmp(p->hard[i], z1) > 0) {
+        mpz_neg(p->hard[i], z1);
+        mpz_add_ui(z0, z0, 1);
+      }
+    }
+    mpz_init_set(p->hard[3], z0);
+    mpz_clear(z0);
+    mpz_clear(z1);
+
     element_init(e, p->Fqd);
     element_init(p->xpowq2, p->Fqd);
     element_init(p->xpowq3, p->Fqd);
     element_init(p->xpowq4, p->Fqd);
-    element_set1(((element_t *) e->data)[1]);
-    element_pow_mpz(e, e, q);
+    if (!param_blob_to_element(e, param->xpowq)) {
+      element_set1(((element_t *) e->data)[1]);
+      element_pow_mpz(e, e, q);
+    }
 
     element_square(p->xpowq2, p->xpowq);
     element_square(p->xpowq4, p->xpowq2);
     element_mul(p->xpowq3, p->xpowq2, p->xpowq);
   }
 
-  field_init_curve_ab_map(p->Etwist, p->Eq, element_field_to_polymod, p->Fqd, pairing->r, NULL);
-  field_reinit_curve_twist(p->Etwist);
+  field_init_curve_ab_map_twist(p->Etwist, p->Eq, element_field_to_polymod, p->Fqd,
+      pairing->r, param->gen2->data, param->gen2->len);
 
   element_init(p->nqrinv, p->Fqd);
   element_invert(p->nqrinv, field_get_nqr(p->Fqd));
@@ -1347,11 +1586,27 @@ static void g_init_pairing(pairing_t pairing, void *data) {
   element_clear(b);
 }
 
+static void g_out_precomp(FILE *stream, pairing_ptr pairing) {
+  mnt_pairing_data_ptr p = pairing->data;
+  element_t e;
+  element_init(e, p->Eq);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen1", e);
+  element_clear(e);
+  element_init(e, p->Etwist);
+  curve_set_gen_no_cofac(e);
+  param_out_bin_element(stream, "gen2", e);
+  element_clear(e);
+  param_out_bin_element(stream, "xpowq", p->xpowq);
+  param_out_bin_element(stream, "fqnqr", field_get_nqr(p->Fq));
+}
+
 static void g_init(pbc_param_ptr p) {
   static pbc_param_interface_t interface = {{
     g_clear,
     g_init_pairing,
     g_out_str,
+    g_out_precomp,
   }};
   p->api = interface;
   g_param_ptr param = p->data = pbc_malloc(sizeof(*param));
@@ -1365,6 +1620,10 @@ static void g_init(pbc_param_ptr p) {
   mpz_init(param->hk);
   param->coeff = NULL;
   mpz_init(param->nqr);
+  param_blob_init(param->gen1);
+  param_blob_init(param->gen2);
+  param_blob_init(param->xpowq);
+  param_blob_init(param->fqnqr);
 }
 
 // Public interface:
@@ -1392,6 +1651,10 @@ int pbc_param_init_g(pbc_param_ptr par, struct symtab_s *tab) {
     mpz_init(p->coeff[i]);
     err += lookup_mpz(p->coeff[i], tab, s);
   }
+  lookup_blob(p->gen1, tab, "gen1");
+  lookup_blob(p->gen2, tab, "gen2");
+  lookup_blob(p->xpowq, tab, "xpowq");
+  lookup_blob(p->fqnqr, tab, "fqnqr");
   return err;
 }
 
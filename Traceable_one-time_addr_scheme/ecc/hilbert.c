@@ -4,6 +4,8 @@
 #include <stdlib.h> //for pbc_malloc, pbc_free
 #include <gmp.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>  // for sysconf
 #include "pbc_utils.h"
 #include "pbc_field.h"
 #include "pbc_poly.h"
@@ -13,16 +15,28 @@
 #include "misc/darray.h"
 #include "mpc.h"
 
-static mpf_t pi, eulere, recipeulere, epsilon, negepsilon;
+#if defined(__GNUC__)
+#define PBC_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define PBC_THREAD_LOCAL __declspec(thread)
+#else
+#define PBC_THREAD_LOCAL _Thread_local
+#endif
+
+// The working precision and the constants below are per thread, and every
+// mpf_t is initialized at that precision instead of GMP's global default,
+// so that several threads may compute Hilbert polynomials at once.
+static PBC_THREAD_LOCAL mp_bitcnt_t working_prec;
+static PBC_THREAD_LOCAL mpf_t pi, eulere, recipeulere, epsilon, negepsilon;
 
 static void mpf_exp(mpf_t res, mpf_t pwr) {
   mpf_t a;
   mpf_t f0;
   int i;
 
-  mpf_init(a); mpf_set(a, pwr);
+  mpf_init2(a, working_prec); mpf_set(a, pwr);
 
-  mpf_init(f0);
+  mpf_init2(f0, working_prec);
 
   mpf_set(f0, a);
   mpf_add_ui(res, a, 1);
@@ -45,7 +59,7 @@ static void mpf_exp(mpf_t res, mpf_t pwr) {
 static void mpc_cis(mpc_t res, mpf_t theta) {
   mpf_t a;
 
-  mpf_init(a); mpf_set(a, theta);
+  mpf_init2(a, working_prec); mpf_set(a, theta);
   //res = exp(i a)
   //  = cos a + i sin a
   //converges quickly near the origin
@@ -54,7 +68,7 @@ static void mpc_cis(mpc_t res, mpf_t theta) {
   int i;
   int toggle = 1;
 
-  mpf_init(f0);
+  mpf_init2(f0, working_prec);
 
   mpf_set(f0, a);
   mpf_set_ui(rx, 1);
@@ -99,9 +113,9 @@ static void compute_q(mpc_t q, mpc_t tau) {
   mpf_ptr fp0;
   unsigned long pwr;
 
-  mpc_init(z0);
-  mpf_init(f0);
-  mpf_init(f1);
+  mpc_init2(z0, working_prec);
+  mpf_init2(f0, working_prec);
+  mpf_init2(f1, working_prec);
 
   //compute z0 = 2 pi i tau
   mpc_set(z0, tau);
@@ -140,32 +154,46 @@ static void compute_q(mpc_t q, mpc_t tau) {
   mpf_clear(f1);
 }
 
+// Returns 1 if both parts of z are below the working precision.
+static int mpc_negligible(mpc_t z) {
+  return mpf_cmp(mpc_re(z), epsilon) < 0 && mpf_cmp(mpc_re(z), negepsilon) > 0
+      && mpf_cmp(mpc_im(z), epsilon) < 0 && mpf_cmp(mpc_im(z), negepsilon) > 0;
+}
+
 // Computes z = Delta(q) (see Cohen).
+// The series 1 + sum (-1)^n (q^(n(3n-1)/2) + q^(n(3n+1)/2)) is summed only
+// until its terms vanish at the working precision, and each power of q
+// comes from the previous one: q^(n(3n-1)/2) grows by q^(3n+1) each step.
 static void compute_Delta(mpc_t z, mpc_t q) {
-  int d;
   int n;
-  int power;
-  mpc_t z0, z1, z2;
+  mpc_t z0, z1, z2, qn, q3, step;
 
-  mpc_init(z0);
-  mpc_init(z1);
-  mpc_init(z2);
+  mpc_init2(z0, working_prec);
+  mpc_init2(z1, working_prec);
+  mpc_init2(z2, working_prec);
+  mpc_init2(qn, working_prec);
+  mpc_init2(q3, working_prec);
+  mpc_init2(step, working_prec);
 
   mpc_set_ui(z0, 1);
-  d = -1;
+  mpc_set(z1, q);
+  mpc_set(qn, q);
+  mpc_mul(q3, q, q);
+  mpc_mul(q3, q3, q);
+  mpc_mul(step, q3, q);
   for(n=1; n<100; n++) {
-    power = n *(3 * n - 1) / 2;
-    mpc_pow_ui(z1, q, power);
-    mpc_pow_ui(z2, q, n);
-    mpc_mul(z2, z2, z1);
-    mpc_add(z1, z1, z2);
-    if (d) {
-      mpc_sub(z0, z0, z1);
-      d = 0;
+    // z1 = q^(n(3n-1)/2), qn = q^n, step = q^(3n+1)
+    mpc_mul(z2, z1, qn);
+    mpc_add(z2, z2, z1);
+    if (n & 1) {
+      mpc_sub(z0, z0, z2);
     } else {
-      mpc_add(z0, z0, z1);
-      d = 1;
+      mpc_add(z0, z0, z2);
     }
+    if (mpc_negligible(z1)) break;
+    mpc_mul(z1, z1, step);
+    mpc_mul(step, step, q3);
+    mpc_mul(qn, qn, q);
   }
 
   mpc_pow_ui(z0, z0, 24);
@@ -174,15 +202,18 @@ static void compute_Delta(mpc_t z, mpc_t q) {
   mpc_clear(z0);
   mpc_clear(z1);
   mpc_clear(z2);
+  mpc_clear(qn);
+  mpc_clear(q3);
+  mpc_clear(step);
 }
 
 // Computes z = h(tau)
 // (called h() by Blake et al, f() by Cohen.)
 static void compute_h(mpc_t z, mpc_t tau) {
   mpc_t z0, z1, q;
-  mpc_init(q);
-  mpc_init(z0);
-  mpc_init(z1);
+  mpc_init2(q, working_prec);
+  mpc_init2(z0, working_prec);
+  mpc_init2(z1, working_prec);
   compute_q(q, tau);
   mpc_mul(z0, q, q);
   compute_Delta(z0, z0);
@@ -197,8 +228,8 @@ static void compute_h(mpc_t z, mpc_t tau) {
 static void compute_j(mpc_t j, mpc_t tau) {
   mpc_t h;
   mpc_t z0;
-  mpc_init(h);
-  mpc_init(z0);
+  mpc_init2(h, working_prec);
+  mpc_init2(z0, working_prec);
   compute_h(h, tau);
   //mpc_mul_ui(z0, h, 256);
   mpc_mul_2exp(z0, h, 8);
@@ -233,7 +264,7 @@ static void compute_pi(int prec) {
   mpz_init(z2);
   mpq_init(q);
   mpq_init(p);
-  mpf_init(f1);
+  mpf_init2(f1, working_prec);
 
   mpz_set_str(k1, "545140134", 10);
   mpz_set_str(k2, "13591409", 10);
@@ -293,18 +324,18 @@ static void precision_init(int prec) {
   int i;
   mpf_t f0;
 
-  mpf_set_default_prec(prec);
+  working_prec = prec;
   mpf_init2(epsilon, 2);
   mpf_init2(negepsilon, 2);
-  mpf_init(recipeulere);
-  mpf_init(pi);
-  mpf_init(eulere);
+  mpf_init2(recipeulere, working_prec);
+  mpf_init2(pi, working_prec);
+  mpf_init2(eulere, working_prec);
 
   mpf_set_ui(epsilon, 1);
   mpf_div_2exp(epsilon, epsilon, prec);
   mpf_neg(negepsilon, epsilon);
 
-  mpf_init(f0);
+  mpf_init2(f0, working_prec);
   mpf_set_ui(eulere, 1);
   mpf_set_ui(f0, 1);
   for (i=1;; i++) {
@@ -329,68 +360,263 @@ static void precision_clear(void) {
   mpf_clear(negepsilon);
 }
 
-// See Cohen; my D is -D in his notation.
-size_t pbc_hilbert(mpz_t **arr, int D) {
-  int a, b;
-  int t;
-  int B = floor(sqrt((double) D / 3.0));
-  mpc_t alpha;
-  mpc_t j;
-  mpf_t sqrtD;
+// A primitive reduced positive definite form (a, b, c). j is real for the
+// ambiguous forms; the rest pair up with their conjugates (a, -b, c).
+typedef struct {
+  int a, b, c;
+  int real;
+} form_t;
+
+// The factor of H_D(X) belonging to one form, and then the product of a
+// range of forms: coefficients from X^0 up, monic.
+typedef struct {
+  mpf_t *coeff;
+  int degree;
+} fpoly_t;
+
+static mpf_t *fvec_new(int n) {
+  mpf_t *v = pbc_malloc(sizeof(mpf_t) * n);
+  int i;
+  for (i = 0; i < n; i++) mpf_init2(v[i], working_prec);
+  return v;
+}
+
+static void fvec_free(mpf_t *v, int n) {
+  int i;
+  for (i = 0; i < n; i++) mpf_clear(v[i]);
+  pbc_free(v);
+}
+
+#define HILBERT_KARATSUBA_THRESHOLD 8
+
+// r = a * b, where r holds na + nb - 1 coefficients and aliases neither.
+static void fvec_mul(mpf_t *r, mpf_t *a, int na, mpf_t *b, int nb) {
+  int i, j, m;
+  mpf_t *t;
+
+  if (na < nb) {
+    mpf_t *tp = a; a = b; b = tp;
+    i = na; na = nb; nb = i;
+  }
+  if (nb < HILBERT_KARATSUBA_THRESHOLD) {
+    mpf_t f0;
+    mpf_init2(f0, working_prec);
+    for (i = 0; i < na + nb - 1; i++) mpf_set_ui(r[i], 0);
+    for (i = 0; i < na; i++) {
+      for (j = 0; j < nb; j++) {
+        mpf_mul(f0, a[i], b[j]);
+        mpf_add(r[i + j], r[i + j], f0);
+      }
+    }
+    mpf_clear(f0);
+    return;
+  }
+  m = (na + 1) / 2;
+  if (nb <= m) {
+    // Unbalanced: split a only.
+    fvec_mul(r, a, m, b, nb);
+    for (i = m + nb - 1; i < na + nb - 1; i++) mpf_set_ui(r[i], 0);
+    t = fvec_new(na - m + nb - 1);
+    fvec_mul(t, a + m, na - m, b, nb);
+    for (i = 0; i < na - m + nb - 1; i++) mpf_add(r[m + i], r[m + i], t[i]);
+    fvec_free(t, na - m + nb - 1);
+    return;
+  }
+  // (a0 + a1 X^m)(b0 + b1 X^m)
+  //   = a0 b0 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) X^m + a1 b1 X^2m
+  {
+    mpf_t *sa = fvec_new(m), *sb = fvec_new(m), *mid = fvec_new(2 * m - 1);
+    int n2 = na + nb - 2 * m - 1;
+    fvec_mul(r, a, m, b, m);
+    mpf_set_ui(r[2 * m - 1], 0);
+    fvec_mul(r + 2 * m, a + m, na - m, b + m, nb - m);
+    for (i = 0; i < m; i++) {
+      mpf_set(sa[i], a[i]);
+      mpf_set(sb[i], b[i]);
+    }
+    for (i = 0; i < na - m; i++) mpf_add(sa[i], sa[i], a[m + i]);
+    for (i = 0; i < nb - m; i++) mpf_add(sb[i], sb[i], b[m + i]);
+    fvec_mul(mid, sa, m, sb, m);
+    for (i = 0; i < 2 * m - 1; i++) mpf_sub(mid[i], mid[i], r[i]);
+    for (i = 0; i < n2; i++) mpf_sub(mid[i], mid[i], r[2 * m + i]);
+    for (i = 0; i < 2 * m - 1; i++) mpf_add(r[m + i], r[m + i], mid[i]);
+    fvec_free(sa, m);
+    fvec_free(sb, m);
+    fvec_free(mid, 2 * m - 1);
+  }
+}
+
+// Sets p to the factor of H_D(X) for the form f: X - j, or
+// X^2 - 2 Re(j) X + |j|^2 for a form and its conjugate.
+static void form_factor(fpoly_t p, const form_t *f, mpf_t sqrtD) {
+  mpc_t alpha, j;
   mpf_t f0;
-  darray_t Pz;
-  mpc_t z0, z1, z2;
-  double d = 1.0;
-  int h = 1;
-  int jcount = 1;
 
-  // Compute required precision.
-  b = D % 2;
+  mpc_init2(alpha, working_prec);
+  mpc_init2(j, working_prec);
+  mpf_init2(f0, working_prec);
+
+  // Compute j((-b + sqrt{-D})/(2a)).
+  mpf_set_ui(f0, 1);
+  mpf_div_ui(f0, f0, 2 * f->a);
+  mpf_mul(mpc_im(alpha), sqrtD, f0);
+  mpf_mul_ui(f0, f0, f->b);
+  mpf_neg(mpc_re(alpha), f0);
+  compute_j(j, alpha);
+
+  if (f->real) {
+    mpf_neg(p.coeff[0], mpc_re(j));
+    mpf_set_ui(p.coeff[1], 1);
+  } else {
+    mpf_mul(f0, mpc_re(j), mpc_re(j));
+    mpf_mul(p.coeff[0], mpc_im(j), mpc_im(j));
+    mpf_add(p.coeff[0], p.coeff[0], f0);
+    mpf_mul_ui(p.coeff[1], mpc_re(j), 2);
+    mpf_neg(p.coeff[1], p.coeff[1]);
+    mpf_set_ui(p.coeff[2], 1);
+  }
+
+  mpf_clear(f0);
+  mpc_clear(alpha);
+  mpc_clear(j);
+}
+
+// The forms shared out among the threads computing their factors.
+struct hilbert_job_s {
+  int D;
+  mp_bitcnt_t prec;
+  form_t *form;
+  fpoly_t *factor;
+  int count, next;
+  pthread_mutex_t lock;
+};
+
+static void *hilbert_worker(void *data) {
+  struct hilbert_job_s *job = data;
+  // Threads other than the caller's set up their own constants.
+  int own = !working_prec;
+  mpf_t sqrtD;
+
+  if (own) precision_init(job->prec);
+  mpf_init2(sqrtD, working_prec);
+  mpf_sqrt_ui(sqrtD, job->D);
   for (;;) {
-    t = (b*b + D) / 4;
-    a = b;
-    if (a <= 1) {
-      a = 1;
-      goto step535_4;
-    }
-step535_3:
-    if (!(t % a)) {
-      jcount++;
-      if ((a == b) || (a*a == t) || !b) {
-        d += 1.0 / ((double) a);
-        h++;
-      } else {
-        d += 2.0 / ((double) a);
-        h+=2;
-      }
+    int i;
+    pthread_mutex_lock(&job->lock);
+    i = job->next++;
+    pthread_mutex_unlock(&job->lock);
+    if (i >= job->count) break;
+    pbc_info("[%d/%d] a b c = %d %d %d", i + 1, job->count,
+        job->form[i].a, job->form[i].b, job->form[i].c);
+    form_factor(job->factor[i], &job->form[i], sqrtD);
+  }
+  mpf_clear(sqrtD);
+  if (own) {
+    precision_clear();
+    working_prec = 0;
+  }
+  return NULL;
+}
+
+static int hilbert_threads;
+
+void pbc_hilbert_set_threads(int n) {
+  hilbert_threads = n;
+}
+
+static int hilbert_thread_count(void) {
+  if (hilbert_threads > 0) return hilbert_threads;
+#ifdef _SC_NPROCESSORS_ONLN
+  {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return n;
+  }
+#endif
+  return 1;
+}
+
+// The last few polynomials computed, since generating several parameter
+// sets for one D asks for the same polynomial again.
+#define HILBERT_CACHE_SIZE 4
+
+static struct {
+  int D;
+  size_t n;
+  mpz_t *coeff;
+} hilbert_cache[HILBERT_CACHE_SIZE];
+static int hilbert_cache_next;
+static pthread_mutex_t hilbert_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static mpz_t *coeff_dup(mpz_t *src, size_t n) {
+  mpz_t *dst = pbc_malloc(sizeof(mpz_t) * n);
+  size_t i;
+  for (i = 0; i < n; i++) mpz_init_set(dst[i], src[i]);
+  return dst;
+}
+
+static size_t cache_lookup(mpz_t **arr, int D) {
+  size_t n = 0;
+  int i;
+  pthread_mutex_lock(&hilbert_cache_lock);
+  for (i = 0; i < HILBERT_CACHE_SIZE; i++) {
+    if (hilbert_cache[i].coeff && hilbert_cache[i].D == D) {
+      n = hilbert_cache[i].n;
+      *arr = coeff_dup(hilbert_cache[i].coeff, n);
+      break;
     }
-step535_4:
-    a++;
-    if (a * a <= t) {
-      goto step535_3;
-    } else {
-      b += 2;
-      if (b > B) break;
+  }
+  pthread_mutex_unlock(&hilbert_cache_lock);
+  return n;
+}
+
+static void cache_store(mpz_t *arr, size_t n, int D) {
+  int i;
+  pthread_mutex_lock(&hilbert_cache_lock);
+  i = hilbert_cache_next;
+  hilbert_cache_next = (i + 1) % HILBERT_CACHE_SIZE;
+  if (hilbert_cache[i].coeff) {
+    pbc_hilbert_free(hilbert_cache[i].coeff, hilbert_cache[i].n);
+  }
+  hilbert_cache[i].D = D;
+  hilbert_cache[i].n = n;
+  hilbert_cache[i].coeff = coeff_dup(arr, n);
+  pthread_mutex_unlock(&hilbert_cache_lock);
+}
+
+void pbc_hilbert_cache_clear(void) {
+  int i;
+  pthread_mutex_lock(&hilbert_cache_lock);
+  for (i = 0; i < HILBERT_CACHE_SIZE; i++) {
+    if (hilbert_cache[i].coeff) {
+      pbc_hilbert_free(hilbert_cache[i].coeff, hilbert_cache[i].n);
+      hilbert_cache[i].coeff = NULL;
     }
   }
+  pthread_mutex_unlock(&hilbert_cache_lock);
+}
 
-  //printf("modulus: %f\n", exp(3.14159265358979 * sqrt(D)) * d * 0.5);
-  d *= sqrt(D) * 3.14159265358979 / log(2);
-  precision_init(d + 34);
-  pbc_info("class number %d, %d bit precision", h, (int) d + 34);
+// See Cohen; my D is -D in his notation.
+// The j-invariants of the forms are computed on several threads, and their
+// factors multiplied together pairwise, so the last products are of halves
+// of H_D and can use Karatsuba.
+size_t pbc_hilbert(mpz_t **arr, int D) {
+  int a, b;
+  int t;
+  int B = floor(sqrt((double) D / 3.0));
+  double d = 0.0;
+  int h = 0;
+  int i, k, count, threads;
+  darray_t forms;
+  form_t *form;
+  fpoly_t *factor;
+  struct hilbert_job_s job;
+  mpf_t f0;
 
-  darray_init(Pz);
-  mpc_init(alpha);
-  mpc_init(j);
-  mpc_init(z0);
-  mpc_init(z1);
-  mpc_init(z2);
-  mpf_init(sqrtD);
-  mpf_init(f0);
+  if ((k = cache_lookup(arr, D))) return k;
 
-  mpf_sqrt_ui(sqrtD, D);
+  // Find the forms, and from them the required precision.
+  darray_init(forms);
   b = D % 2;
-  h = 0;
   for (;;) {
     t = (b*b + D) / 4;
     if (b > 1) {
@@ -406,128 +632,101 @@ step4:
     } else {
       // a, b, t/a are coeffs of an appropriate primitive reduced positive
       // definite form.
-      // Compute j((-b + sqrt{-D})/(2a)).
-      h++;
-      pbc_info("[%d/%d] a b c = %d %d %d", h, jcount, a, b, t/a);
-      mpf_set_ui(f0, 1);
-      mpf_div_ui(f0, f0, 2 * a);
-      mpf_mul(mpc_im(alpha), sqrtD, f0);
-      mpf_mul_ui(f0, f0, b);
-      mpf_neg(mpc_re(alpha), f0);
-
-      compute_j(j, alpha);
-if (0) {
-  int i;
-  for (i=Pz->count - 1; i>=0; i--) {
-    printf("P %d = ", i);
-    mpc_out_str(stdout, 10, 4, Pz->item[i]);
-    printf("\n");
-  }
-}
-      if (a == b || a * a == t || !b) {
-        // P *= X - j
-        int i, n;
-        mpc_ptr p0;
-        p0 = (mpc_ptr) pbc_malloc(sizeof(mpc_t));
-        mpc_init(p0);
-        mpc_neg(p0, j);
-        n = Pz->count;
-        if (n) {
-          mpc_set(z1, Pz->item[0]);
-          mpc_add(Pz->item[0], z1, p0);
-          for (i=1; i<n; i++) {
-            mpc_mul(z0, z1, p0);
-            mpc_set(z1, Pz->item[i]);
-            mpc_add(Pz->item[i], z1, z0);
-          }
-          mpc_mul(p0, p0, z1);
-        }
-        darray_append(Pz, p0);
+      form_t *f = pbc_malloc(sizeof(form_t));
+      f->a = a;
+      f->b = b;
+      f->c = t / a;
+      f->real = a == b || a * a == t || !b;
+      if (f->real) {
+        d += 1.0 / ((double) a);
+        h++;
       } else {
-        // P *= X^2 - 2 Re(j) X + |j|^2
-        int i, n;
-        mpc_ptr p0, p1;
-        p0 = (mpc_ptr) pbc_malloc(sizeof(mpc_t));
-        p1 = (mpc_ptr) pbc_malloc(sizeof(mpc_t));
-        mpc_init(p0);
-        mpc_init(p1);
-        // p1 = - 2 Re(j)
-        mpf_mul_ui(f0, mpc_re(j), 2);
-        mpf_neg(f0, f0);
-        mpf_set(mpc_re(p1), f0);
-        // p0 = |j|^2
-        mpf_mul(f0, mpc_re(j), mpc_re(j));
-        mpf_mul(mpc_re(p0), mpc_im(j), mpc_im(j));
-        mpf_add(mpc_re(p0), mpc_re(p0), f0);
-        n = Pz->count;
-        if (!n) {
-        } else if (n == 1) {
-          mpc_set(z1, Pz->item[0]);
-          mpc_add(Pz->item[0], z1, p1);
-          mpc_mul(p1, z1, p1);
-          mpc_add(p1, p1, p0);
-          mpc_mul(p0, p0, z1);
-        } else {
-          mpc_set(z2, Pz->item[0]);
-          mpc_set(z1, Pz->item[1]);
-          mpc_add(Pz->item[0], z2, p1);
-          mpc_mul(z0, z2, p1);
-          mpc_add(Pz->item[1], z1, z0);
-          mpc_add(Pz->item[1], Pz->item[1], p0);
-          for (i=2; i<n; i++) {
-            mpc_mul(z0, z1, p1);
-            mpc_mul(alpha, z2, p0);
-            mpc_set(z2, z1);
-            mpc_set(z1, Pz->item[i]);
-            mpc_add(alpha, alpha, z0);
-            mpc_add(Pz->item[i], z1, alpha);
-          }
-          mpc_mul(z0, z2, p0);
-          mpc_mul(p1, p1, z1);
-          mpc_add(p1, p1, z0);
-          mpc_mul(p0, p0, z1);
-        }
-        darray_append(Pz, p1);
-        darray_append(Pz, p0);
+        d += 2.0 / ((double) a);
+        h += 2;
       }
+      darray_append(forms, f);
       goto step4;
     }
     b+=2;
     if (b > B) break;
   }
 
-  // Round polynomial and assign.
-  int k = 0;
+  //printf("modulus: %f\n", exp(3.14159265358979 * sqrt(D)) * d * 0.5);
+  d *= sqrt(D) * 3.14159265358979 / log(2);
+  precision_init(d + 34);
+  pbc_info("class number %d, %d bit precision", h, (int) d + 34);
+
+  count = forms->count;
+  form = pbc_malloc(sizeof(form_t) * count);
+  factor = pbc_malloc(sizeof(fpoly_t) * count);
+  for (i = 0; i < count; i++) {
+    form[i] = *(form_t *) forms->item[i];
+    pbc_free(forms->item[i]);
+    factor[i].degree = form[i].real ? 1 : 2;
+    factor[i].coeff = fvec_new(factor[i].degree + 1);
+  }
+  darray_clear(forms);
+
+  job.D = D;
+  job.prec = working_prec;
+  job.form = form;
+  job.factor = factor;
+  job.count = count;
+  job.next = 0;
+  pthread_mutex_init(&job.lock, NULL);
+  threads = hilbert_thread_count();
+  if (threads > count) threads = count;
   {
-    *arr = pbc_malloc(sizeof(mpz_t) * (Pz->count + 1));
-    int i;
-    for (i=Pz->count - 1; i>=0; i--) {
-      if (mpf_sgn(mpc_re(Pz->item[i])) < 0) {
-        mpf_set_d(f0, -0.5);
-      } else {
-        mpf_set_d(f0, 0.5);
-      }
-      mpf_add(f0, f0, mpc_re(Pz->item[i]));
-      mpz_init((*arr)[k]);
-      mpz_set_f((*arr)[k], f0);
-      k++;
-      mpc_clear(Pz->item[i]);
-      pbc_free(Pz->item[i]);
+    pthread_t *tid = pbc_malloc(sizeof(pthread_t) * threads);
+    int started;
+    // Workers beyond the first that fail to start are simply not needed.
+    for (started = 0; started < threads - 1; started++) {
+      if (pthread_create(&tid[started], NULL, hilbert_worker, &job)) break;
     }
-    mpz_init((*arr)[k]);
-    mpz_set_ui((*arr)[k], 1);
-    k++;
+    hilbert_worker(&job);
+    for (i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    pbc_free(tid);
+  }
+  pthread_mutex_destroy(&job.lock);
+  pbc_free(form);
+
+  // Multiply adjacent factors until one is left.
+  while (count > 1) {
+    for (i = 0; i + 1 < count; i += 2) {
+      fpoly_t *p = &factor[i], *q = &factor[i + 1];
+      fpoly_t r;
+      r.degree = p->degree + q->degree;
+      r.coeff = fvec_new(r.degree + 1);
+      fvec_mul(r.coeff, p->coeff, p->degree + 1, q->coeff, q->degree + 1);
+      fvec_free(p->coeff, p->degree + 1);
+      fvec_free(q->coeff, q->degree + 1);
+      factor[i / 2] = r;
+    }
+    if (count & 1) factor[count / 2] = factor[count - 1];
+    count = (count + 1) / 2;
+  }
+
+  // Round polynomial and assign.
+  mpf_init2(f0, working_prec);
+  k = factor[0].degree + 1;
+  *arr = pbc_malloc(sizeof(mpz_t) * k);
+  for (i = 0; i < k; i++) {
+    if (mpf_sgn(factor[0].coeff[i]) < 0) {
+      mpf_set_d(f0, -0.5);
+    } else {
+      mpf_set_d(f0, 0.5);
+    }
+    mpf_add(f0, f0, factor[0].coeff[i]);
+    mpz_init((*arr)[i]);
+    mpz_set_f((*arr)[i], f0);
   }
-  darray_clear(Pz);
-  mpc_clear(z0);
-  mpc_clear(z1);
-  mpc_clear(z2);
   mpf_clear(f0);
-  mpf_clear(sqrtD);
-  mpc_clear(alpha);
-  mpc_clear(j);
+  fvec_free(factor[0].coeff, k);
+  pbc_free(factor);
 
   precision_clear();
+  working_prec = 0;
+  cache_store(*arr, k, D);
   return k;
 }
 
@@ -1,4 +1,5 @@
 //GMP based complex floats
+//Temporaries take the precision of the result, not GMP's global default
 #include <stdio.h>
 #include <gmp.h>
 #include "mpc.h"
@@ -7,9 +8,9 @@
 void mpc_mul(mpc_t res, mpc_t z0, mpc_t z1)
 {
     mpf_t ac, bd, f0;
-    mpf_init(ac);
-    mpf_init(bd);
-    mpf_init(f0);
+    mpf_init2(ac, mpf_get_prec(res->a));
+    mpf_init2(bd, mpf_get_prec(res->a));
+    mpf_init2(f0, mpf_get_prec(res->a));
     mpf_mul(ac, z0->a, z1->a);
     mpf_mul(bd, z0->b, z1->b);
     mpf_add(f0, z0->a, z0->b);
@@ -33,8 +34,8 @@ void mpc_mul_2exp(mpc_t res, mpc_t z, unsigned long int e)
 void mpc_sqr(mpc_t res, mpc_t z)
 {
     mpf_t f0, f1;
-    mpf_init(f0);
-    mpf_init(f1);
+    mpf_init2(f0, mpf_get_prec(res->a));
+    mpf_init2(f1, mpf_get_prec(res->a));
     mpf_add(f0, z->a, z->b);
     mpf_sub(f1, z->a, z->b);
     mpf_mul(f0, f0, f1);
@@ -50,8 +51,8 @@ void mpc_sqr(mpc_t res, mpc_t z)
 void mpc_inv(mpc_t res, mpc_t z)
 {
     mpf_t f0, f1;
-    mpf_init(f0);
-    mpf_init(f1);
+    mpf_init2(f0, mpf_get_prec(res->a));
+    mpf_init2(f1, mpf_get_prec(res->a));
     mpf_mul(f0, z->a, z->a);
     mpf_mul(f1, z->b, z->b);
     mpf_add(f0, f0, f1);
@@ -66,7 +67,7 @@ void mpc_inv(mpc_t res, mpc_t z)
 void mpc_div(mpc_t res, mpc_t z0, mpc_t z1)
 {
     mpc_t c0;
-    mpc_init(c0);
+    mpc_init2(c0, mpf_get_prec(res->a));
     mpc_inv(c0, z1);
     mpc_mul(res, z0, c0);
     mpc_clear(c0);
@@ -91,7 +92,7 @@ void mpc_pow_ui(mpc_t res, mpc_t z, unsigned int n)
 {
     unsigned int m;
     mpc_t z0;
-    mpc_init(z0);
+    mpc_init2(z0, mpf_get_prec(res->a));
 
     //set m to biggest power of 2 less than n
     for (m = 1; m <= n; m <<= 1);
@@ -114,7 +115,7 @@ void mpc_muli(mpc_t res, mpc_t z)
 {
     //i(a+bi) = -b + ai
     mpf_t f0;
-    mpf_init(f0);
+    mpf_init2(f0, mpf_get_prec(res->a));
     mpf_neg(f0, z->b);
     mpf_set(res->b, z->a);
     mpf_set(res->a, f0);
@@ -22,6 +22,11 @@ static inline void mpc_init(mpc_ptr c) {
   mpf_init(c->b);
 }
 
+static inline void mpc_init2(mpc_ptr c, mp_bitcnt_t prec) {
+  mpf_init2(c->a, prec);
+  mpf_init2(c->b, prec);
+}
+
 static inline void mpc_clear(mpc_ptr c) {
   mpf_clear(c->a);
   mpf_clear(c->b);
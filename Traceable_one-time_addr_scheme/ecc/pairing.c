@@ -45,6 +45,62 @@ static void generic_prod_pairings(element_ptr out, element_t in1[],
   element_clear(tmp);
 }
 
+static void generic_map_batch(element_ptr out[], element_ptr in1[],
+    element_ptr in2[], int n, pairing_t pairing) {
+  int i;
+  for (i = 0; i < n; i++) pairing->map(out[i], in1[i], in2[i], pairing);
+}
+
+void pairing_apply_batch(element_t out[], element_t in1[], element_t in2[],
+    int n, pairing_t pairing) {
+  size_t size = sizeof(element_ptr) * n;
+  element_ptr *o = pbc_malloc(size);
+  element_ptr *p = pbc_malloc(size);
+  element_ptr *q = pbc_malloc(size);
+  int i, m = 0;
+
+  for (i = 0; i < n; i++) {
+    PBC_ASSERT(pairing->GT == out[i]->field, "pairing output mismatch");
+    PBC_ASSERT(pairing->G1 == in1[i]->field, "pairing 1st input mismatch");
+    PBC_ASSERT(pairing->G2 == in2[i]->field, "pairing 2nd input mismatch");
+    if (element_is0(in1[i]) || element_is0(in2[i])) {
+      element_set0(out[i]);
+      continue;
+    }
+    o[m] = pairing_gt_out(out[i]);
+    p[m] = in1[i];
+    q[m] = in2[i];
+    m++;
+  }
+  if (m) pairing->map_batch(o, p, q, m, pairing);
+  pbc_free(o);
+  pbc_free(p);
+  pbc_free(q);
+}
+
+void element_prod_pairing(
+    element_t out, element_t in1[], element_t in2[], int n) {
+  pairing_ptr pairing = out->field->pairing;
+  // Shallow copies of the pairs that are kept.
+  element_t *p = pbc_malloc(sizeof(element_t) * n);
+  element_t *q = pbc_malloc(sizeof(element_t) * n);
+  int i, m = 0;
+
+  PBC_ASSERT(pairing->GT == out->field, "pairing output mismatch");
+  for (i = 0; i < n; i++) {
+    PBC_ASSERT(pairing->G1 == in1[i]->field, "pairing 1st input mismatch");
+    PBC_ASSERT(pairing->G2 == in2[i]->field, "pairing 2nd input mismatch");
+    if (element_is0(in1[i]) || element_is0(in2[i])) continue;
+    *p[m] = *in1[i];
+    *q[m] = *in2[i];
+    m++;
+  }
+  if (m) pairing->prod_pairings(pairing_gt_out(out), p, q, m, pairing);
+  else element_set1(out);
+  pbc_free(p);
+  pbc_free(q);
+}
+
 static void phi_warning(element_ptr out, element_ptr in, pairing_ptr pairing) {
   UNUSED_VAR(out);
   UNUSED_VAR(in);
@@ -71,6 +127,8 @@ static void default_pp_clear(pairing_pp_t p) {
   UNUSED_VAR(p);
 }
 
+static void mulg_pow_mpz_ct(element_t x, element_t a, mpz_t n);
+
 void pairing_init_pbc_param(pairing_t pairing, pbc_param_ptr p) {
   pairing->option_set = default_option_set;
   pairing->pp_init = default_pp_init;
@@ -79,7 +137,19 @@ void pairing_init_pbc_param(pairing_t pairing, pbc_param_ptr p) {
   pairing->is_almost_coddh = generic_is_almost_coddh;
   pairing->phi = phi_warning;
   pairing->prod_pairings = generic_prod_pairings;
+  pairing->map_batch = generic_map_batch;
+  pairing->miller = NULL;
+  pairing->pp_miller = NULL;
+  pairing->subgroup_map = NULL;
+  pairing->subgroup_count = 0;
+  pairing->finalpow_batch = NULL;
+  pairing->gt_pow_mpz = NULL;
+  pairing->pp_length_in_bytes = NULL;
+  pairing->pp_to_bytes = NULL;
+  pairing->pp_from_bytes = NULL;
+  pairing->gt_pow_mpz_ct = NULL;
   p->api->init_pairing(pairing, p->data);
+  if (pairing->gt_pow_mpz_ct) pairing->GT->pow_mpz_ct = mulg_pow_mpz_ct;
   pairing->G1->pairing = pairing;
   pairing->G2->pairing = pairing;
   pairing->GT->pairing = pairing;
@@ -102,9 +172,108 @@ int pairing_init_set_str(pairing_t pairing, const char *s) {
 }
 
 void pairing_clear(pairing_t pairing) {
+  pairing_set_subgroups(pairing, NULL, 0);
   pairing->clear_func(pairing);
 }
 
+int pairing_set_subgroups(pairing_t pairing, mpz_t order[], int n) {
+  mpz_t prod, cof;
+  int i, ok = 1;
+
+  for (i = 0; i < n; i++) {
+    if (mpz_cmp_ui(order[i], 1) <= 0) return 1;
+  }
+  mpz_init_set_ui(prod, 1);
+  mpz_init(cof);
+  for (i = 0; i < n && ok; i++) {
+    mpz_gcd(cof, prod, order[i]);
+    ok = !mpz_cmp_ui(cof, 1);
+    mpz_mul(prod, prod, order[i]);
+  }
+  if (n && (!ok || mpz_cmp(prod, pairing->r))) {
+    mpz_clear(prod);
+    mpz_clear(cof);
+    return 1;
+  }
+
+  for (i = 0; i < pairing->subgroup_count; i++) {
+    mpz_clear(pairing->subgroup[i]);
+    mpz_clear(pairing->subgroup_crt[i]);
+  }
+  if (pairing->subgroup_count) {
+    pbc_free(pairing->subgroup);
+    pbc_free(pairing->subgroup_crt);
+  }
+  pairing->subgroup_count = n;
+  if (n) {
+    pairing->subgroup = pbc_malloc(sizeof(mpz_t) * n);
+    pairing->subgroup_crt = pbc_malloc(sizeof(mpz_t) * n);
+  }
+  // The CRT coefficient of subgroup i is 1 modulo its order and 0 modulo
+  // the others: (r/order) times the inverse of r/order modulo the order.
+  for (i = 0; i < n; i++) {
+    mpz_init_set(pairing->subgroup[i], order[i]);
+    mpz_init(pairing->subgroup_crt[i]);
+    mpz_divexact(cof, pairing->r, order[i]);
+    mpz_invert(prod, cof, order[i]);
+    mpz_mul(pairing->subgroup_crt[i], prod, cof);
+  }
+  mpz_clear(prod);
+  mpz_clear(cof);
+  return 0;
+}
+
+void pairing_subgroup_project(element_t out, element_t in, int i,
+    pairing_t pairing) {
+  PBC_ASSERT(i >= 0 && i < pairing->subgroup_count, "no such subgroup");
+  element_pow_mpz(out, in, pairing->subgroup_crt[i]);
+}
+
+void pairing_apply_subgroup(element_t out, element_t in1, element_t in2,
+    int i, pairing_t pairing) {
+  PBC_ASSERT(i >= 0 && i < pairing->subgroup_count, "no such subgroup");
+  if (!pairing->subgroup_map || element_is0(in1) || element_is0(in2)) {
+    pairing_apply(out, in1, in2, pairing);
+    return;
+  }
+  PBC_ASSERT(pairing->GT == out->field, "pairing output mismatch");
+  PBC_ASSERT(pairing->G1 == in1->field, "pairing 1st input mismatch");
+  PBC_ASSERT(pairing->G2 == in2->field, "pairing 2nd input mismatch");
+  pairing->subgroup_map(pairing_gt_out(out), in1, in2,
+      pairing->subgroup[i], pairing);
+}
+
+void pairing_apply_crt(element_t out, element_t in1[], element_t in2,
+    pairing_t pairing) {
+  element_t t;
+  int i;
+  element_set1(out);
+  element_init_same_as(t, out);
+  for (i = 0; i < pairing->subgroup_count; i++) {
+    if (element_is0(in1[i])) continue;
+    pairing_apply_subgroup(t, in1[i], in2, i, pairing);
+    element_mul(out, out, t);
+  }
+  element_clear(t);
+}
+
+void pairing_subgroup_pp_init(element_pp_t p, element_t in, int i,
+    pairing_t pairing) {
+  PBC_ASSERT(i >= 0 && i < pairing->subgroup_count, "no such subgroup");
+  element_pp_init_bits(p, in, mpz_sizeinbase(pairing->subgroup[i], 2), 5,
+      PBC_PP_WINDOW);
+}
+
+void pairing_subgroup_pp_pow(element_t out, mpz_t power, element_pp_t p,
+    int i, pairing_t pairing) {
+  mpz_t n;
+  PBC_ASSERT(i >= 0 && i < pairing->subgroup_count, "no such subgroup");
+  mpz_init(n);
+  mpz_mod(n, power, pairing->subgroup[i]);
+  element_pp_pow(out, n, p);
+  mpz_clear(n);
+}
+
 // TODO: it's most likely better to add extra stuff to field_t
 // so no new data structures are needed to create mulitplicative subgroups.
 // Additionally the same code could be used with curve_t
@@ -115,15 +284,52 @@ static void gt_out_info(FILE *out, field_ptr f) {
   field_out_info(out, f->data);
 }
 
+// Runs the final exponentiation pending on e, if any.
+static void gt_reduce(element_ptr e) {
+  struct pairing_gt_s *d = e->data;
+  if (d->unreduced) {
+    d->unreduced = 0;
+    e->field->pairing->finalpow(e);
+  }
+}
+
+// The value of e, reduced.
+static element_ptr gt_value(element_ptr e) {
+  gt_reduce(e);
+  return ((struct pairing_gt_s *) e->data)->value;
+}
+
+// The raw value of e, reduced or not.
+static inline element_ptr gt_raw(element_ptr e) {
+  return ((struct pairing_gt_s *) e->data)->value;
+}
+
+static inline int gt_unreduced(element_ptr e) {
+  return ((struct pairing_gt_s *) e->data)->unreduced;
+}
+
+static inline void gt_set_unreduced(element_ptr e, int unreduced) {
+  ((struct pairing_gt_s *) e->data)->unreduced = unreduced;
+}
+
+// Reduces a or b if only one of them is, and returns whether the result
+// of combining them is unreduced.
+static int gt_match(element_ptr a, element_ptr b) {
+  if (gt_unreduced(a) == gt_unreduced(b)) return gt_unreduced(a);
+  gt_reduce(a);
+  gt_reduce(b);
+  return 0;
+}
+
 static void gt_from_hash(element_ptr e, void *data, int len) {
   pairing_ptr pairing = e->field->pairing;
-  element_from_hash(e->data, data, len);
+  element_from_hash(pairing_gt_out(e), data, len);
   pairing->finalpow(e);
 }
 
 static void gt_random(element_ptr e) {
   pairing_ptr pairing = e->field->pairing;
-  element_random(e->data);
+  element_random(pairing_gt_out(e));
   pairing->finalpow(e);
 }
 
@@ -133,92 +339,150 @@ static void mulg_field_clear(field_t f) {
 }
 
 static void mulg_init(element_ptr e) {
-  e->data = pbc_malloc(sizeof(element_t));
+  struct pairing_gt_s *d = e->data = pbc_malloc(sizeof(*d));
   field_ptr f = e->field->data;
-  element_init(e->data, f);
-  element_set1(e->data);
+  element_init(d->value, f);
+  element_set1(d->value);
+  d->unreduced = 0;
 }
 
 static void mulg_clear(element_ptr e) {
-  element_clear(e->data);
+  element_clear(gt_raw(e));
   pbc_free(e->data);
 }
 
+static void mulg_init_packed(element_ptr e, void *mem) {
+  struct pairing_gt_s *d = e->data = mem;
+  field_ptr f = e->field->data;
+  element_init_packed(d->value, f, d + 1);
+  element_set1(d->value);
+  d->unreduced = 0;
+}
+
 static void mulg_set(element_ptr x, element_t a) {
-  element_set(x->data, a->data);
+  element_set(gt_raw(x), gt_raw(a));
+  gt_set_unreduced(x, gt_unreduced(a));
+}
+
+static void mulg_cmov(element_ptr x, element_t a, int bit) {
+  gt_match(x, a);
+  element_cmov(gt_raw(x), gt_raw(a), bit);
 }
 
 static int mulg_cmp(element_ptr x, element_t a) {
-  return element_cmp(x->data, a->data);
+  return element_cmp(gt_value(x), gt_value(a));
 }
 
 static size_t mulg_out_str(FILE *stream, int base, element_ptr e) {
-  return element_out_str(stream, base, e->data);
+  return element_out_str(stream, base, gt_value(e));
 }
 
 static void mulg_set_multiz(element_ptr e, multiz m) {
-  return element_set_multiz(e->data, m);
+  return element_set_multiz(pairing_gt_out(e), m);
 }
 
 static int mulg_set_str(element_ptr e, const char *s, int base) {
-  return element_set_str(e->data, s, base);
+  return element_set_str(pairing_gt_out(e), s, base);
 }
 
 static int mulg_item_count(element_ptr e) {
-  return element_item_count(e->data);
+  return element_item_count(gt_raw(e));
 }
 
 static element_ptr mulg_item(element_ptr e, int i) {
-  return element_item(e->data, i);
+  return element_item(gt_value(e), i);
 }
 
 static int mulg_to_bytes(unsigned char *data, element_ptr e) {
-  return element_to_bytes(data, e->data);
+  return element_to_bytes(data, gt_value(e));
 }
 
 static int mulg_from_bytes(element_ptr e, unsigned char *data) {
-  return element_from_bytes(e->data, data);
+  return element_from_bytes(pairing_gt_out(e), data);
 }
 
 static int mulg_length_in_bytes(element_ptr e) {
-  return element_length_in_bytes(e->data);
+  return element_length_in_bytes(gt_raw(e));
 }
 
 static int mulg_snprint(char *s, size_t n, element_ptr e) {
-  return element_snprint(s, n, e->data);
+  return element_snprint(s, n, gt_value(e));
 }
 
 static void mulg_to_mpz(mpz_ptr z, element_ptr e) {
-  element_to_mpz(z, e->data);
+  element_to_mpz(z, gt_value(e));
 }
 
 static void mulg_set1(element_t e) {
-  element_set1(e->data);
+  element_set1(pairing_gt_out(e));
 }
 
+// The final exponentiation is a homomorphism, so products, quotients,
+// inverses and powers of unreduced values reduce to those of the reduced
+// ones.
 static void mulg_mul(element_ptr x, element_t a, element_t b) {
-  element_mul(x->data, a->data, b->data);
+  int unreduced = gt_match(a, b);
+  element_mul(gt_raw(x), gt_raw(a), gt_raw(b));
+  gt_set_unreduced(x, unreduced);
 }
 
 static void mulg_div(element_ptr x, element_t a, element_t b) {
-  element_div(x->data, a->data, b->data);
+  int unreduced = gt_match(a, b);
+  element_div(gt_raw(x), gt_raw(a), gt_raw(b));
+  gt_set_unreduced(x, unreduced);
 }
 
 static void mulg_invert(element_ptr x, element_t a) {
-  element_invert(x->data, a->data);
+  element_invert(gt_raw(x), gt_raw(a));
+  gt_set_unreduced(x, gt_unreduced(a));
 }
 
 static int mulg_is1(element_ptr x) {
-  return element_is1(x->data);
+  return element_is1(gt_value(x));
 }
 
 static void mulg_pow_mpz(element_t x, element_t a, mpz_t n) {
-  element_pow_mpz(x->data, a->data, n);
+  pairing_ptr pairing = x->field->pairing;
+  if (pairing->gt_pow_mpz && !gt_unreduced(a)) {
+    pairing->gt_pow_mpz(pairing_gt_out(x), gt_raw(a), n);
+    return;
+  }
+  element_pow_mpz(gt_raw(x), gt_raw(a), n);
+  gt_set_unreduced(x, gt_unreduced(a));
+}
+
+// Values read from bytes may be any unit of the field: raise them to the
+// order of GT in the field itself, as gt_pow_mpz() may assume the subgroup.
+static int mulg_in_subgroup(element_ptr e) {
+  element_ptr v = gt_value(e);
+  element_t t;
+  int result;
+  if (element_is0(v)) return 0;
+  element_init_same_as(t, v);
+  element_pow_mpz(t, v, e->field->order);
+  result = element_is1(t);
+  element_clear(t);
+  return result;
+}
+
+// Only installed for pairings with a gt_pow_mpz_ct(), which takes reduced
+// values.
+static void mulg_pow_mpz_ct(element_t x, element_t a, mpz_t n) {
+  element_ptr v = gt_value(a);
+  x->field->pairing->gt_pow_mpz_ct(pairing_gt_out(x), v, n, x->field->order);
+}
+
+// Tables for exponents below the order of GT, which is much smaller than
+// that of the field holding the values.
+static void mulg_pp_init_ex(element_pp_t p, element_t in, int bits, int k,
+    int strategy) {
+  p->data = pbc_malloc(sizeof(element_pp_t));
+  element_pp_init_bits(p->data, gt_value(in), bits, k, strategy);
 }
 
 static void mulg_pp_init(element_pp_t p, element_t in) {
-  p->data = pbc_malloc(sizeof(element_pp_t));
-  element_pp_init(p->data, in->data);
+  mulg_pp_init_ex(p, in, mpz_sizeinbase(in->field->order, 2), 5,
+      PBC_PP_WINDOW);
 }
 
 static void mulg_pp_clear(element_pp_t p) {
@@ -227,7 +491,93 @@ static void mulg_pp_clear(element_pp_t p) {
 }
 
 static void mulg_pp_pow(element_t out, mpz_ptr power, element_pp_t p) {
-  element_pp_pow(out->data, power, p->data);
+  mpz_t n;
+  mpz_init(n);
+  mpz_mod(n, power, out->field->order);
+  element_pp_pow(pairing_gt_out(out), n, p->data);
+  mpz_clear(n);
+}
+
+void pairing_apply_unreduced(element_t out, element_t in1, element_t in2,
+    pairing_t pairing) {
+  PBC_ASSERT(pairing->GT == out->field, "pairing output mismatch");
+  PBC_ASSERT(pairing->G1 == in1->field, "pairing 1st input mismatch");
+  PBC_ASSERT(pairing->G2 == in2->field, "pairing 2nd input mismatch");
+  if (!pairing->miller || element_is0(in1) || element_is0(in2)) {
+    pairing_apply(out, in1, in2, pairing);
+    return;
+  }
+  pairing->miller(gt_raw(out), in1, in2, pairing);
+  gt_set_unreduced(out, 1);
+}
+
+void pairing_pp_apply_unreduced(element_t out, element_t in2, pairing_pp_t p) {
+  if (!p->pairing || !p->pairing->pp_miller || element_is0(in2)) {
+    pairing_pp_apply(out, in2, p);
+    return;
+  }
+  p->pairing->pp_miller(gt_raw(out), in2, p);
+  gt_set_unreduced(out, 1);
+}
+
+// A byte tells the tables of the identity, which are empty, from others.
+int pairing_pp_is_precomputed(pairing_t pairing) {
+  return pairing->pp_init != default_pp_init;
+}
+
+int pairing_pp_length_in_bytes(pairing_t pairing) {
+  if (!pairing->pp_length_in_bytes) return 0;
+  return 1 + pairing->pp_length_in_bytes(pairing);
+}
+
+int pairing_pp_to_bytes(unsigned char *data, pairing_pp_t p,
+    pairing_t pairing) {
+  int len = pairing_pp_length_in_bytes(pairing);
+  if (!len) return 0;
+  if (!p->pairing) {
+    memset(data, 0, len);
+    return len;
+  }
+  data[0] = 1;
+  pairing->pp_to_bytes(data + 1, p);
+  return len;
+}
+
+int pairing_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing) {
+  int len = pairing_pp_length_in_bytes(pairing);
+  if (!len || data[0] > 1) return 0;
+  if (!data[0]) {
+    p->pairing = NULL;
+    return len;
+  }
+  p->pairing = pairing;
+  return pairing->pp_from_bytes(p, data + 1, pairing) ? len : 0;
+}
+
+void element_gt_reduce(element_t e) {
+  gt_reduce(e);
+}
+
+void element_gt_reduce_batch(element_t e[], int n) {
+  element_ptr *v;
+  pairing_ptr pairing;
+  int i, m = 0;
+
+  if (n <= 0) return;
+  pairing = e[0]->field->pairing;
+  if (!pairing->finalpow_batch) {
+    for (i = 0; i < n; i++) gt_reduce(e[i]);
+    return;
+  }
+  v = pbc_malloc(sizeof(element_ptr) * n);
+  for (i = 0; i < n; i++) {
+    if (!gt_unreduced(e[i])) continue;
+    gt_set_unreduced(e[i], 0);
+    v[m++] = gt_raw(e[i]);
+  }
+  if (m) pairing->finalpow_batch(v, m);
+  pbc_free(v);
 }
 
 void pairing_GT_init(pairing_ptr pairing, field_t f) {
@@ -241,7 +591,12 @@ void pairing_GT_init(pairing_ptr pairing, field_t f) {
 
   gt->init = mulg_init;
   gt->clear = mulg_clear;
+  if (f->packed_size) {
+    gt->packed_size = sizeof(struct pairing_gt_s) + f->packed_size;
+    gt->init_packed = mulg_init_packed;
+  }
   gt->set = mulg_set;
+  gt->cmov = mulg_cmov;
   gt->cmp = mulg_cmp;
 
   gt->out_str = mulg_out_str;
@@ -274,8 +629,11 @@ void pairing_GT_init(pairing_ptr pairing, field_t f) {
   gt->pow_mpz = mulg_pow_mpz;
   gt->invert = mulg_invert;
   gt->is1 = mulg_is1;
+  gt->in_subgroup = mulg_in_subgroup;
   gt->pp_init = mulg_pp_init;
+  gt->pp_init_ex = mulg_pp_init_ex;
   gt->pp_clear = mulg_pp_clear;
+  gt->pp_is_base_table = 0;
   gt->pp_pow = mulg_pp_pow;
 
   gt->random = gt_random;
@@ -5,7 +5,9 @@
 #include <gmp.h>
 #include "pbc_utils.h"
 #include "pbc_memory.h"
+#include "pbc_field.h"
 #include "pbc_param.h"
+#include "pbc_pairing.h"
 #include "pbc_a_param.h"
 #include "pbc_mnt.h"
 #include "pbc_d_param.h"
@@ -110,6 +112,96 @@ static void read_symtab(symtab_t tab, const char *input, size_t limit) {
   token_clear(tok);
 }
 
+// Binary format (pbc_param_out_bin): BIN_MAGIC, then records of
+//   key length (1 byte), key, kind (1 byte), value length (4 bytes,
+//   big-endian), value.
+// Kinds: 's' text (the type), 'z' integer as a sign byte followed by the
+// big-endian magnitude, 'e' derived constant as element_to_bytes output.
+#define BIN_MAGIC "PBCbin01"
+#define BIN_MAGIC_LEN 8
+
+// Symbol table values read from binary records other than 's' start with
+// BIN_TAG, the kind and the length, so they cannot be mistaken for text.
+#define BIN_TAG 1
+
+static int read_symtab_bin(symtab_t tab, const char *input, size_t limit) {
+  const unsigned char *in = (const unsigned char *) input + BIN_MAGIC_LEN;
+  const unsigned char *end = (const unsigned char *) input + limit;
+  while (in < end) {
+    size_t keylen = *in++;
+    if ((size_t) (end - in) < keylen + 5) return 1;
+    char *key = pbc_malloc(keylen + 1);
+    memcpy(key, in, keylen);
+    key[keylen] = 0;
+    in += keylen;
+    int kind = *in++;
+    size_t n = (size_t) in[0] << 24 | (size_t) in[1] << 16 | in[2] << 8 | in[3];
+    in += 4;
+    if ((size_t) (end - in) < n) {
+      pbc_free(key);
+      return 1;
+    }
+    char *value;
+    if (kind == 's') {
+      value = pbc_malloc(n + 1);
+      memcpy(value, in, n);
+      value[n] = 0;
+    } else {
+      int len = n;
+      value = pbc_malloc(2 + sizeof(int) + n);
+      value[0] = BIN_TAG;
+      value[1] = kind;
+      memcpy(value + 2, &len, sizeof(int));
+      memcpy(value + 2 + sizeof(int), in, n);
+    }
+    in += n;
+    symtab_put(tab, value, key);
+    pbc_free(key);
+  }
+  return 0;
+}
+
+// Returns the bytes of a binary value of the given kind, NULL otherwise.
+static const unsigned char *bin_value(const char *data, int kind, int *len) {
+  if (data[0] != BIN_TAG || data[1] != kind) return NULL;
+  memcpy(len, data + 2, sizeof(int));
+  return (const unsigned char *) data + 2 + sizeof(int);
+}
+
+static void set_mpz(mpz_t z, const char *data) {
+  int len;
+  const unsigned char *v = bin_value(data, 'z', &len);
+  if (!v) {
+    mpz_set_str(z, data, 0);
+    return;
+  }
+  if (len < 1) {
+    mpz_set_ui(z, 0);
+    return;
+  }
+  mpz_import(z, len - 1, 1, 1, 1, 0, v + 1);
+  if (v[0]) mpz_neg(z, z);
+}
+
+static void out_bin_record(FILE *stream, const char *key, int kind,
+    const void *data, size_t len) {
+  unsigned char n[4] = { len >> 24, len >> 16, len >> 8, len };
+  fputc(strlen(key), stream);
+  fputs(key, stream);
+  fputc(kind, stream);
+  fwrite(n, 1, 4, stream);
+  fwrite(data, 1, len, stream);
+}
+
+static void out_bin_mpz(FILE *stream, const char *key, mpz_t z) {
+  size_t n = (mpz_sizeinbase(z, 2) + 7) / 8;
+  unsigned char *buf = pbc_malloc(n + 1);
+  buf[0] = mpz_sgn(z) < 0;
+  mpz_export(buf + 1, &n, 1, 1, 1, 0, z);
+  out_bin_record(stream, key, 'z', buf, n + 1);
+  pbc_free(buf);
+}
+
 // These functions have hidden visibility (see header).
 
 void param_out_type(FILE *stream, char *s) {
@@ -145,7 +237,7 @@ int lookup_mpz(mpz_t z, symtab_t tab, const char *key) {
     pbc_error("missing param: `%s'", key);
     return 1;
   }
-  mpz_set_str(z, data, 0);
+  set_mpz(z, data);
   return 0;
 }
 
@@ -158,13 +250,56 @@ int lookup_int(int *n, symtab_t tab, const char *key) {
   }
   mpz_init(z);
 
-  mpz_set_str(z, data, 0);
+  set_mpz(z, data);
   *n = mpz_get_si(z);
   mpz_clear(z);
 
   return 0;
 }
 
+void param_blob_init(param_blob_ptr b) {
+  b->data = NULL;
+  b->len = 0;
+}
+
+void param_blob_clear(param_blob_ptr b) {
+  pbc_free(b->data);
+  param_blob_init(b);
+}
+
+void lookup_blob(param_blob_ptr b, symtab_t tab, const char *key) {
+  const unsigned char *v;
+  int len;
+  if (!symtab_has(tab, key)) return;
+  v = bin_value(symtab_at(tab, key), 'e', &len);
+  if (!v) return;
+  pbc_free(b->data);
+  b->data = pbc_malloc(len);
+  memcpy(b->data, v, len);
+  b->len = len;
+}
+
+int param_blob_to_element(element_ptr e, param_blob_ptr b) {
+  if (!b->data || b->len != element_length_in_bytes(e)) return 0;
+  element_from_bytes(e, b->data);
+  return 1;
+}
+
+void param_blob_to_nqr(field_ptr f, param_blob_ptr b) {
+  element_t nqr;
+  element_init(nqr, f);
+  if (param_blob_to_element(nqr, b)) field_set_nqr(f, nqr);
+  element_clear(nqr);
+}
+
+void param_out_bin_element(FILE *stream, const char *key, element_ptr e) {
+  int n = element_length_in_bytes(e);
+  unsigned char *buf = pbc_malloc(n);
+  element_to_bytes(buf, e);
+  out_bin_record(stream, key, 'e', buf, n);
+  pbc_free(buf);
+}
+
 static int param_set_tab(pbc_param_t par, symtab_t tab) {
   const char *s = lookup(tab, "type");
 
@@ -211,10 +346,70 @@ int pbc_param_init_set_str(pbc_param_t par, const char *input) {
 
 int pbc_param_init_set_buf(pbc_param_t par, const char *input, size_t len) {
   symtab_t tab;
+  int res;
   symtab_init(tab);
-  read_symtab(tab, input, len);
-  int res = param_set_tab(par, tab);
+  if (len >= BIN_MAGIC_LEN && !memcmp(input, BIN_MAGIC, BIN_MAGIC_LEN)) {
+    res = read_symtab_bin(tab, input, len);
+    if (res) pbc_error("truncated binary param");
+    else res = param_set_tab(par, tab);
+  } else {
+    read_symtab(tab, input, len);
+    res = param_set_tab(par, tab);
+  }
   symtab_forall_data(tab, pbc_free);
   symtab_clear(tab);
   return res;
 }
+
+int pbc_param_out_bin(FILE *stream, pbc_param_ptr p) {
+  // The base parameters go through the text writer so every type gets the
+  // binary format; only the derived constants need per-type code.
+  FILE *tmp = tmpfile();
+  if (!tmp) return 1;
+  p->api->out_str(tmp, p->data);
+  long n = ftell(tmp);
+  if (n < 0) {
+    fclose(tmp);
+    return 1;
+  }
+  char *text = pbc_malloc(n + 1);
+  rewind(tmp);
+  size_t got = fread(text, 1, n, tmp);
+  fclose(tmp);
+  text[got] = 0;
+
+  fwrite(BIN_MAGIC, 1, BIN_MAGIC_LEN, stream);
+  token_t tok;
+  mpz_t z;
+  const char *input = text;
+  token_init(tok);
+  mpz_init(z);
+  for (;;) {
+    input = token_get(tok, input, NULL);
+    if (tok->type != token_word) break;
+    char *key = pbc_strdup(tok->s);
+    input = token_get(tok, input, NULL);
+    if (tok->type != token_word) {
+      pbc_free(key);
+      break;
+    }
+    if (!strcmp(key, "type")) {
+      out_bin_record(stream, key, 's', tok->s, strlen(tok->s));
+    } else {
+      mpz_set_str(z, tok->s, 0);
+      out_bin_mpz(stream, key, z);
+    }
+    pbc_free(key);
+  }
+  mpz_clear(z);
+  token_clear(tok);
+  pbc_free(text);
+
+  if (p->api->out_precomp) {
+    pairing_t pairing;
+    pairing_init_pbc_param(pairing, p);
+    p->api->out_precomp(stream, pairing);
+    pairing_clear(pairing);
+  }
+  return ferror(stream) ? 1 : 0;
+}
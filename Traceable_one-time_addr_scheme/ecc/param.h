@@ -4,9 +4,12 @@
 // * param.h
 // * stdio.h
 // * gmp.h
+// * pbc_field.h
 #ifndef __PARAM_UTILS_H__
 #define __PARAM_UTILS_H__
 
+#include "misc/symtab.h"
+
 #pragma GCC visibility push(hidden)
 
 void param_out_type(FILE *stream, char *s);
@@ -18,6 +21,27 @@ struct symtab_s; // let "include/pbc.h" not include "misc/symtab.h"
 int lookup_int(int *n, struct symtab_s *tab, const char *key);
 int lookup_mpz(mpz_t z, struct symtab_s *tab, const char *key);
 
+// Derived constant carried by a binary parameter file (pbc_param_out_bin),
+// stored as element_to_bytes output. data is NULL when the file had none,
+// in which case init_pairing computes the constant as usual.
+struct param_blob_s {
+  unsigned char *data;
+  int len;
+};
+typedef struct param_blob_s param_blob_t[1];
+typedef struct param_blob_s *param_blob_ptr;
+
+void param_blob_init(param_blob_ptr b);
+void param_blob_clear(param_blob_ptr b);
+// Optional: a missing or textual entry leaves 'b' empty without an error.
+void lookup_blob(param_blob_ptr b, symtab_t tab, const char *key);
+// Returns 1 and sets 'e' if 'b' holds an element of the right size.
+int param_blob_to_element(element_ptr e, param_blob_ptr b);
+// Makes the element in 'b' the quadratic nonresidue of 'f', if it fits.
+void param_blob_to_nqr(field_ptr f, param_blob_ptr b);
+// Writes 'e' as a derived-constant record, from an out_precomp hook.
+void param_out_bin_element(FILE *stream, const char *key, element_ptr e);
+
 #pragma GCC visibility pop
 
 #endif //__PARAM_UTILS_H__
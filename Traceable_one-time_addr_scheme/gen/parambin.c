@@ -0,0 +1,35 @@
+// Convert pairing parameters to the binary format of pbc_param_out_bin().
+// Usage:
+//   parambin [FILE] > out.bin
+//
+// FILE
+//   Parameters in the text format, read from standard input if omitted.
+//   The binary format loads faster since it also holds derived constants.
+
+#include "pbc.h"
+
+int main(int argc, char **argv) {
+  FILE *fp = stdin;
+  if (argc > 1) {
+    fp = fopen(argv[1], "r");
+    if (!fp) pbc_die("error opening %s", argv[1]);
+  }
+  size_t n = 0, count;
+  size_t size = 1024;
+  char *s = pbc_malloc(size);
+  while ((count = fread(s + n, 1, size - n, fp)) > 0) {
+    n += count;
+    if (n == size) {
+      size *= 2;
+      s = pbc_realloc(s, size);
+    }
+  }
+  if (fp != stdin) fclose(fp);
+
+  pbc_param_t par;
+  if (!n || pbc_param_init_set_buf(par, s, n)) pbc_die("invalid parameters");
+  pbc_free(s);
+  if (pbc_param_out_bin(stdout, par)) pbc_die("error writing parameters");
+  pbc_param_clear(par);
+  return 0;
+}
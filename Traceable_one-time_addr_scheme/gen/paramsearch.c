@@ -0,0 +1,285 @@
+// Search for pairing parameters on several threads.
+// Usage:
+//   paramsearch [OPTIONS] d DMIN DMAX
+//   paramsearch [OPTIONS] f BITS COUNT
+//   paramsearch [OPTIONS] a RBITS QBITS COUNT
+//
+// d
+//   Type D (MNT) parameters for every discriminant D in [DMIN, DMAX) whose
+//   curves fit the bit limits below: what listmnt followed by
+//   genalldparams finds, with the D values spread over the threads.
+// f, a
+//   COUNT independent type F or type A parameter sets; each thread runs
+//   its own search for primes of the given size.
+//
+// Options:
+//   -t THREADS  Number of worker threads. Default: one per online CPU.
+//   -o DIR      Write every parameter set to its own file in DIR, named
+//               d<D>-<qbits>-<rbits>.param as genalldparams does,
+//               f<BITS>-<i>.param or a<RBITS>-<QBITS>-<i>.param, and print
+//               one line per file. Default: print the sets to stdout,
+//               separated by blank lines.
+//   -c FILE     Checkpoint file. Each finished D, or each finished set of
+//               type F or A, is appended to FILE once its output is
+//               written, and a restarted search skips the work FILE
+//               already lists.
+//   -q BITS     d only: least bits in q. Default: 80.
+//   -Q BITS     d only: most bits in q. Default: 300.
+//   -r BITS     d only: least bits in r. Default: 80.
+//   -v          Show the library's progress messages.
+//
+// Parameter sets are output as soon as each is found, so their order
+// varies from run to run.
+//
+// e.g. $ paramsearch -t 8 -o params -c params/done d 7 1000000
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>  // For getopt, sysconf.
+#include "pbc.h"
+#include "pbc_hilbert.h"
+
+// Library messages are off unless -v is given, but errors are always shown.
+#define die(...) (pbc_set_msg_to_stderr(1), pbc_die(__VA_ARGS__))
+
+// Work items are numbered 0, ..., n - 1: item i is D = dmin + i for type
+// D, and the i-th parameter set for types F and A.
+struct search_s {
+  char kind;            // 'd', 'f' or 'a'.
+  unsigned int dmin;    // d: first D, and the bit limits.
+  int qmin, qmax, rmin;
+  int bits, qbits;      // f, a: sizes.
+  unsigned int n, next; // Items, and the first not yet handed out.
+  unsigned char *done;  // done[i] once the checkpoint lists item i.
+  const char *dir;
+  FILE *checkpoint;
+  pthread_mutex_t lock; // For the fields above and for stdout.
+  int found;
+};
+typedef struct search_s search_t[1];
+typedef struct search_s *search_ptr;
+
+// Write param to its file, or to stdout; name is the file name.
+static void output(search_ptr s, pbc_param_t param, const char *name) {
+  if (s->dir) {
+    char path[1024], tmp[1040];
+    FILE *fp;
+    snprintf(path, sizeof(path), "%s/%s", s->dir, name);
+    // Renamed into place only once complete, so a file that exists holds
+    // a whole parameter set even if the search is interrupted.
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    fp = fopen(tmp, "w");
+    if (!fp) die("cannot write %s: %s", tmp, strerror(errno));
+    pbc_param_out_str(fp, param);
+    if (fclose(fp) || rename(tmp, path)) {
+      die("cannot write %s: %s", path, strerror(errno));
+    }
+  }
+  pthread_mutex_lock(&s->lock);
+  if (s->dir) printf("%s\n", name);
+  else {
+    if (s->found) printf("\n");
+    pbc_param_out_str(stdout, param);
+  }
+  s->found++;
+  fflush(stdout);
+  pthread_mutex_unlock(&s->lock);
+}
+
+// Record a finished work item.
+static void mark_done(search_ptr s, unsigned int i) {
+  if (!s->checkpoint) return;
+  pthread_mutex_lock(&s->lock);
+  fprintf(s->checkpoint, "%c %u\n", s->kind, i);
+  fflush(s->checkpoint);
+  pthread_mutex_unlock(&s->lock);
+}
+
+static int consider_d(pbc_cm_t cm, void *data) {
+  search_ptr s = data;
+  int qbits = mpz_sizeinbase(cm->q, 2);
+  int rbits = mpz_sizeinbase(cm->r, 2);
+  pbc_param_t param;
+  char name[64];
+
+  if (qbits < s->qmin || qbits > s->qmax || rbits < s->rmin) return 0;
+  pbc_info("paramsearch: D = %u, computing Hilbert polynomial...", cm->D);
+  pbc_param_init_d_gen(param, cm);
+  snprintf(name, sizeof(name), "d%u-%d-%d.param", cm->D, qbits, rbits);
+  output(s, param, name);
+  pbc_param_clear(param);
+  // Keep going: larger solutions of the Pell equation may fit too.
+  return 0;
+}
+
+// The next item to work on, or -1 when there are none left. Only D that
+// are 0 or 3 mod 4 are discriminants.
+static long take(search_ptr s) {
+  long i = -1;
+  pthread_mutex_lock(&s->lock);
+  while (s->next < s->n) {
+    unsigned int j = s->next++;
+    int m = (s->dmin + j) % 4;
+    if (s->done[j] || (s->kind == 'd' && m != 0 && m != 3)) continue;
+    i = j;
+    break;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return i;
+}
+
+static void *worker(void *data) {
+  search_ptr s = data;
+  pbc_random_ctx_t rnd;
+
+  // The default random source is shared; give each thread its own.
+  if (pbc_random_ctx_init_os(rnd)) die("no random source");
+  pbc_random_ctx_bind(rnd);
+  for (;;) {
+    long i = take(s);
+    if (i < 0) break;
+    if (s->kind == 'd') {
+      pbc_cm_search_d(consider_d, s, s->dmin + i, s->qmax);
+    } else {
+      pbc_param_t param;
+      char name[64];
+      if (s->kind == 'f') {
+        pbc_param_init_f_gen(param, s->bits);
+        snprintf(name, sizeof(name), "f%d-%ld.param", s->bits, i);
+      } else {
+        pbc_param_init_a_gen(param, s->bits, s->qbits);
+        snprintf(name, sizeof(name), "a%d-%d-%ld.param", s->bits, s->qbits, i);
+      }
+      output(s, param, name);
+      pbc_param_clear(param);
+    }
+    mark_done(s, i);
+  }
+  pbc_random_ctx_bind(NULL);
+  pbc_random_ctx_clear(rnd);
+  return NULL;
+}
+
+// Mark the work a previous run finished, then reopen the file to append.
+static void load_checkpoint(search_ptr s, const char *filename) {
+  FILE *fp = fopen(filename, "r");
+  if (fp) {
+    char kind;
+    unsigned int i;
+    while (fscanf(fp, " %c %u", &kind, &i) == 2) {
+      if (kind != s->kind) {
+        die("%s is a checkpoint of a type %c search", filename, kind);
+      }
+      if (i < s->n) s->done[i] = 1;
+    }
+    fclose(fp);
+  }
+  s->checkpoint = fopen(filename, "a");
+  if (!s->checkpoint) {
+    die("cannot write %s: %s", filename, strerror(errno));
+  }
+}
+
+static void usage(const char *prog) {
+  die("Usage: %s [-t THREADS] [-o DIR] [-c FILE] [-q BITS] [-Q BITS] "
+      "[-r BITS] [-v] d DMIN DMAX | f BITS COUNT | a RBITS QBITS COUNT",
+      prog);
+}
+
+int main(int argc, char **argv) {
+  search_t s;
+  const char *checkpoint = NULL;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int verbose = 0;
+  int c, i, nargs;
+  pthread_t *tid;
+
+  memset(s, 0, sizeof(s));
+  s->qmin = 80;
+  s->qmax = 300;
+  s->rmin = 80;
+  for (;;) {
+    c = getopt(argc, argv, "t:o:c:q:Q:r:v");
+    if (c == -1) break;
+    switch (c) {
+      case 't':
+        threads = atoi(optarg);
+        break;
+      case 'o':
+        s->dir = optarg;
+        break;
+      case 'c':
+        checkpoint = optarg;
+        break;
+      case 'q':
+        s->qmin = atoi(optarg);
+        break;
+      case 'Q':
+        s->qmax = atoi(optarg);
+        break;
+      case 'r':
+        s->rmin = atoi(optarg);
+        break;
+      case 'v':
+        verbose = 1;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind >= argc || strlen(argv[optind]) != 1) usage(argv[0]);
+  s->kind = argv[optind++][0];
+  nargs = argc - optind;
+  switch (s->kind) {
+    case 'd': {
+      int dmin, dmax;
+      if (nargs != 2) usage(argv[0]);
+      dmin = atoi(argv[optind]);
+      dmax = atoi(argv[optind + 1]);
+      if (dmin < 1 || dmax <= dmin) die("need 0 < DMIN < DMAX");
+      s->dmin = dmin;
+      s->n = dmax - dmin;
+      break;
+    }
+    case 'f':
+      if (nargs != 2) usage(argv[0]);
+      s->bits = atoi(argv[optind]);
+      s->n = atoi(argv[optind + 1]);
+      break;
+    case 'a':
+      if (nargs != 3) usage(argv[0]);
+      s->bits = atoi(argv[optind]);
+      s->qbits = atoi(argv[optind + 1]);
+      s->n = atoi(argv[optind + 2]);
+      break;
+    default:
+      usage(argv[0]);
+  }
+  if (s->kind != 'd' && (s->bits < 1 || (int) s->n < 1)) usage(argv[0]);
+  if (threads < 1) threads = 1;
+  s->done = pbc_malloc(s->n);
+  memset(s->done, 0, s->n);
+
+  pbc_set_msg_to_stderr(verbose);
+  // The D values are already spread over the threads.
+  if (threads > 1) pbc_hilbert_set_threads(1);
+  pthread_mutex_init(&s->lock, NULL);
+  if (checkpoint) load_checkpoint(s, checkpoint);
+
+  tid = pbc_malloc(sizeof(*tid) * threads);
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&tid[i], NULL, worker, s)) {
+      die("cannot start thread %d", i);
+    }
+  }
+  for (i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+  pbc_free(tid);
+
+  if (s->checkpoint) fclose(s->checkpoint);
+  pthread_mutex_destroy(&s->lock);
+  pbc_free(s->done);
+  return 0;
+}
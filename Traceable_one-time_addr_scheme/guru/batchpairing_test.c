@@ -0,0 +1,333 @@
+// Test pairing_apply_batch(), pairing_apply_unreduced() and
+// element_gt_reduce_batch() against pairing_apply(), and
+// element_multi_invert() against element_invert().
+
+#include <string.h>
+#include "pbc.h"
+#include "pbc_fp.h"
+#include "pbc_fieldquadratic.h"
+#include "pbc_test.h"
+
+#define BATCH 9
+
+static void check_invert(field_ptr f) {
+  element_t a[BATCH], x[BATCH], y;
+  int i;
+
+  element_init(y, f);
+  for (i = 0; i < BATCH; i++) {
+    element_init(a[i], f);
+    element_init(x[i], f);
+    element_random(a[i]);
+  }
+  // Zeros at either end and in the middle are left zero.
+  element_set0(a[0]);
+  element_set0(a[4]);
+  element_set0(a[BATCH - 1]);
+  element_multi_invert(x, a, BATCH);
+  for (i = 0; i < BATCH; i++) {
+    if (element_is0(a[i])) {
+      EXPECT(element_is0(x[i]));
+    } else {
+      element_invert(y, a[i]);
+      EXPECT(!element_cmp(x[i], y));
+    }
+  }
+  // In place, and a single element.
+  element_multi_invert(a, a, BATCH);
+  for (i = 0; i < BATCH; i++) EXPECT(!element_cmp(a[i], x[i]));
+  element_random(a[0]);
+  element_multi_invert(x, a, 1);
+  element_mul(y, x[0], a[0]);
+  EXPECT(element_is1(y));
+  for (i = 0; i < BATCH; i++) {
+    element_clear(a[i]);
+    element_clear(x[i]);
+  }
+  element_clear(y);
+}
+
+static void check_batch(pairing_t pairing) {
+  element_t p[BATCH], q[BATCH], out[BATCH], e;
+  int i;
+
+  element_init_GT(e, pairing);
+  for (i = 0; i < BATCH; i++) {
+    element_init_G1(p[i], pairing);
+    element_init_G2(q[i], pairing);
+    element_init_GT(out[i], pairing);
+    element_random(p[i]);
+    element_random(q[i]);
+  }
+  // The identity in either input, and repeated inputs.
+  element_set0(p[2]);
+  element_set0(q[5]);
+  element_set(p[7], p[6]);
+  element_set(q[7], q[6]);
+
+  pairing_apply_batch(out, p, q, BATCH, pairing);
+  for (i = 0; i < BATCH; i++) {
+    pairing_apply(e, p[i], q[i], pairing);
+    EXPECT(!element_cmp(out[i], e));
+  }
+  EXPECT(element_is1(out[2]));
+  EXPECT(element_is1(out[5]));
+  pairing_apply_batch(out, p + 3, q + 3, 1, pairing);
+  pairing_apply(e, p[3], q[3], pairing);
+  EXPECT(!element_cmp(out[0], e));
+
+  check_invert(pairing->GT);
+  for (i = 0; i < BATCH; i++) {
+    element_clear(p[i]);
+    element_clear(q[i]);
+    element_clear(out[i]);
+  }
+  element_clear(e);
+}
+
+// Runs of equal second inputs, which may share their precomputation, and
+// bilinearity in either input.
+static void check_shared(pairing_t pairing) {
+  element_t p[BATCH], q[BATCH], out[BATCH], e, f;
+  mpz_t a;
+  int i;
+
+  element_init_GT(e, pairing);
+  element_init_GT(f, pairing);
+  mpz_init(a);
+  for (i = 0; i < BATCH; i++) {
+    element_init_G1(p[i], pairing);
+    element_init_G2(q[i], pairing);
+    element_init_GT(out[i], pairing);
+    element_random(p[i]);
+  }
+  element_random(q[0]);
+  for (i = 1; i < BATCH; i++) element_set(q[i], q[0]);
+  element_random(q[4]);
+  element_set0(p[1]);
+  element_set0(q[BATCH - 1]);
+  pairing_apply_batch(out, p, q, BATCH, pairing);
+  for (i = 0; i < BATCH; i++) {
+    pairing_apply(e, p[i], q[i], pairing);
+    EXPECT(!element_cmp(out[i], e));
+  }
+
+  pbc_mpz_random(a, pairing->r);
+  pairing_apply(e, p[0], q[0], pairing);
+  EXPECT(!element_is1(e));
+  element_pow_mpz(f, e, pairing->r);
+  EXPECT(element_is1(f));
+  element_pow_mpz(e, e, a);
+  element_mul_mpz(p[2], p[0], a);
+  pairing_apply(f, p[2], q[0], pairing);
+  EXPECT(!element_cmp(e, f));
+  element_mul_mpz(q[2], q[0], a);
+  pairing_apply(f, p[0], q[2], pairing);
+  EXPECT(!element_cmp(e, f));
+
+  for (i = 0; i < BATCH; i++) {
+    element_clear(p[i]);
+    element_clear(q[i]);
+    element_clear(out[i]);
+  }
+  element_clear(e);
+  element_clear(f);
+  mpz_clear(a);
+}
+
+// Unreduced values combined among themselves and with reduced ones.
+static void check_unreduced(pairing_t pairing) {
+  element_t p, q, r, s, x, y, u, v;
+  unsigned char *b0, *b1;
+  pairing_pp_t pp;
+  mpz_t n;
+
+  element_init_G1(p, pairing);
+  element_init_G2(q, pairing);
+  element_init_G1(r, pairing);
+  element_init_G2(s, pairing);
+  element_init_GT(x, pairing);
+  element_init_GT(y, pairing);
+  element_init_GT(u, pairing);
+  element_init_GT(v, pairing);
+  mpz_init(n);
+  element_random(p);
+  element_random(q);
+  element_random(r);
+  element_random(s);
+
+  // e(p, q) e(r, q)^-1 both ways, and compared in either order.
+  pairing_apply_unreduced(u, p, q, pairing);
+  pairing_apply_unreduced(v, r, q, pairing);
+  element_div(u, u, v);
+  pairing_apply(x, p, q, pairing);
+  pairing_apply(y, r, q, pairing);
+  element_div(x, x, y);
+  EXPECT(!element_cmp(u, x));
+  pairing_apply_unreduced(u, p, q, pairing);
+  element_invert(v, v);
+  element_mul(u, u, v);
+  EXPECT(!element_cmp(x, u));
+
+  // Powers, copies, and a mix with a reduced factor.
+  pbc_mpz_random(n, pairing->r);
+  pairing_apply_unreduced(u, p, q, pairing);
+  element_pow_mpz(u, u, n);
+  element_set(v, u);
+  element_mul(v, v, y);
+  pairing_apply(x, p, q, pairing);
+  element_pow_mpz(x, x, n);
+  EXPECT(!element_cmp(u, x));
+  element_mul(x, x, y);
+  EXPECT(!element_cmp(v, x));
+  pairing_apply_unreduced(u, p, q, pairing);
+  element_pow_mpz_ct(u, u, n);
+  pairing_apply(x, p, q, pairing);
+  element_pow_mpz(x, x, n);
+  EXPECT(!element_cmp(u, x));
+
+  // Serialization, and a reduced value written over an unreduced one.
+  b0 = pbc_malloc(element_length_in_bytes(x));
+  b1 = pbc_malloc(element_length_in_bytes(x));
+  pairing_apply_unreduced(u, p, q, pairing);
+  pairing_apply(x, p, q, pairing);
+  element_to_bytes(b0, x);
+  element_to_bytes(b1, u);
+  EXPECT(!memcmp(b0, b1, element_length_in_bytes(x)));
+  pairing_apply_unreduced(u, r, q, pairing);
+  pairing_apply(u, p, q, pairing);
+  element_gt_reduce(u);
+  EXPECT(!element_cmp(u, x));
+  pbc_free(b0);
+  pbc_free(b1);
+
+  // Precomputed pairings, and the identity.
+  pairing_pp_init(pp, p, pairing);
+  pairing_pp_apply_unreduced(u, q, pp);
+  pairing_pp_apply_unreduced(v, s, pp);
+  element_mul(u, u, v);
+  pairing_apply(y, p, s, pairing);
+  element_mul(y, x, y);
+  EXPECT(!element_cmp(u, y));
+  pairing_pp_clear(pp);
+  element_set0(r);
+  pairing_apply_unreduced(u, r, q, pairing);
+  EXPECT(element_is1(u));
+
+  element_clear(p);
+  element_clear(q);
+  element_clear(r);
+  element_clear(s);
+  element_clear(x);
+  element_clear(y);
+  element_clear(u);
+  element_clear(v);
+  mpz_clear(n);
+}
+
+// Precomputed pairings reduced together, some of them raised to a power
+// first and some already reduced.
+static void check_reduce_batch(pairing_t pairing) {
+  element_t p, q[BATCH], w[BATCH], e;
+  pairing_pp_t pp;
+  mpz_t n;
+  int i;
+
+  element_init_G1(p, pairing);
+  element_init_GT(e, pairing);
+  mpz_init(n);
+  element_random(p);
+  pbc_mpz_random(n, pairing->r);
+  pairing_pp_init(pp, p, pairing);
+  for (i = 0; i < BATCH; i++) {
+    element_init_G2(q[i], pairing);
+    element_init_GT(w[i], pairing);
+    element_random(q[i]);
+    if (i % 3 == 1) pairing_pp_apply(w[i], q[i], pp);
+    else pairing_pp_apply_unreduced(w[i], q[i], pp);
+    if (i % 3 == 2) element_pow_mpz(w[i], w[i], n);
+  }
+  element_gt_reduce_batch(w, BATCH);
+  for (i = 0; i < BATCH; i++) {
+    pairing_apply(e, p, q[i], pairing);
+    if (i % 3 == 2) element_pow_mpz(e, e, n);
+    EXPECT(!element_cmp(w[i], e));
+  }
+  // A single value, and one reduced twice.
+  pairing_pp_apply_unreduced(w[0], q[0], pp);
+  element_gt_reduce_batch(w, 1);
+  element_gt_reduce_batch(w, 1);
+  pairing_apply(e, p, q[0], pairing);
+  EXPECT(!element_cmp(w[0], e));
+
+  pairing_pp_clear(pp);
+  for (i = 0; i < BATCH; i++) {
+    element_clear(q[i]);
+    element_clear(w[i]);
+  }
+  element_clear(p);
+  element_clear(e);
+  mpz_clear(n);
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  field_t fp, fi, fq;
+  mpz_t n, t;
+
+  // Both kinds of quadratic extension over a prime 3 mod 4.
+  mpz_init(n);
+  mpz_setbit(n, 256);
+  do {
+    mpz_nextprime(n, n);
+  } while (mpz_fdiv_ui(n, 4) != 3);
+  field_init_fp(fp, n);
+  field_init_fi(fi, fp);
+  field_init_quadratic(fq, fp);
+  check_invert(fp);
+  check_invert(fi);
+  check_invert(fq);
+  field_clear(fq);
+  field_clear(fi);
+  field_clear(fp);
+
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+  check_batch(pairing);
+  check_unreduced(pairing);
+  check_reduce_batch(pairing);
+  pairing_option_set(pairing, "method", "shipsey-stange");
+  check_unreduced(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  mpz_init(t);
+  mpz_set_ui(n, 0);
+  mpz_setbit(n, 80);
+  mpz_nextprime(n, n);
+  mpz_setbit(t, 90);
+  mpz_nextprime(t, t);
+  mpz_mul(n, n, t);
+  pbc_param_init_a1_gen(param, n);
+  pairing_init_pbc_param(pairing, param);
+  check_batch(pairing);
+  check_unreduced(pairing);
+  check_reduce_batch(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  mpz_clear(n);
+  mpz_clear(t);
+
+  // Type F pairs with the optimal ate pairing, reusing the lines of a
+  // repeated second input.
+  pbc_param_init_f_gen(param, 160);
+  pairing_init_pbc_param(pairing, param);
+  check_batch(pairing);
+  check_shared(pairing);
+  check_unreduced(pairing);
+  check_reduce_batch(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
@@ -0,0 +1,57 @@
+// Check batched point decompression against the single-point routine.
+#include "pbc.h"
+#include "pbc_test.h"
+
+#define N 16
+
+static void check(pairing_t pairing) {
+  element_t P[N], Q[N];
+  unsigned char *buf;
+  int i, len, total;
+
+  element_init_G1(P[0], pairing);
+  len = element_length_in_bytes_compressed(P[0]);
+  buf = pbc_malloc(len * N);
+  for (i = 0; i < N; i++) {
+    if (i) element_init_G1(P[i], pairing);
+    element_init_G1(Q[i], pairing);
+    element_random(P[i]);
+    element_to_bytes_compressed(buf + i * len, P[i]);
+  }
+
+  total = element_from_bytes_compressed_batch(Q, buf, N);
+  EXPECT(total == len * N);
+  for (i = 0; i < N; i++) {
+    EXPECT(!element_cmp(P[i], Q[i]));
+    element_from_bytes_compressed(Q[i], buf + i * len);
+    EXPECT(!element_cmp(P[i], Q[i]));
+  }
+  EXPECT(element_from_bytes_compressed_batch(Q, buf, 0) == 0);
+
+  for (i = 0; i < N; i++) {
+    element_clear(P[i]);
+    element_clear(Q[i]);
+  }
+  pbc_free(buf);
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+
+  // Type A: q = 3 mod 4, exercises the direct square root.
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+  check(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  // Type F: G1 over a prime field whose order need not be 3 mod 4.
+  pbc_param_init_f_gen(param, 160);
+  pairing_init_pbc_param(pairing, param);
+  check(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  return pbc_err_count;
+}
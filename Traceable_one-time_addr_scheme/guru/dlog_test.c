@@ -0,0 +1,75 @@
+// Test element_dlog_pollard_rho() on one and several threads, in groups
+// of prime order and of composite order, where the collisions that do not
+// give the log are skipped.
+#include "pbc.h"
+#include "pbc_test.h"
+
+static void check_rho(pairing_t pairing, int threads, int times) {
+  element_t g, h, x, y, h1;
+  int i;
+
+  element_init_G1(g, pairing);
+  element_init_G1(h, pairing);
+  element_init_G1(h1, pairing);
+  element_init_Zr(x, pairing);
+  element_init_Zr(y, pairing);
+  element_dlog_set_threads(threads);
+  for (i = 0; i < times; i++) {
+    element_random(g);
+    element_random(x);
+    element_pow_zn(h, g, x);
+    element_dlog_pollard_rho(y, g, h);
+    // With a composite order, g may not generate G1 and y is only
+    // determined modulo the order of g.
+    element_pow_zn(h1, g, y);
+    EXPECT(!element_cmp(h, h1));
+  }
+  // The log of 1 and of g itself.
+  element_set1(h);
+  element_dlog_pollard_rho(y, g, h);
+  element_pow_zn(h1, g, y);
+  EXPECT(!element_cmp(h, h1));
+  element_dlog_pollard_rho(y, g, g);
+  element_pow_zn(h1, g, y);
+  EXPECT(!element_cmp(g, h1));
+  element_clear(g);
+  element_clear(h);
+  element_clear(h1);
+  element_clear(x);
+  element_clear(y);
+}
+
+int main(void) {
+  pbc_param_t par;
+  pairing_t pairing;
+  mpz_t n, p;
+
+  // A 32-bit prime order: about 2^16 steps, spread over 2^6 distinguished
+  // points.
+  pbc_param_init_a_gen(par, 32, 64);
+  pairing_init_pbc_param(pairing, par);
+  check_rho(pairing, 1, 4);
+  check_rho(pairing, 4, 4);
+  pairing_clear(pairing);
+  pbc_param_clear(par);
+
+  // A composite order of two 14-bit primes, small enough that every
+  // point is distinguished.
+  mpz_init(n);
+  mpz_init(p);
+  mpz_set_ui(p, 1 << 13);
+  mpz_nextprime(p, p);
+  mpz_set(n, p);
+  mpz_nextprime(p, p);
+  mpz_mul(n, n, p);
+  pbc_param_init_a1_gen(par, n);
+  pairing_init_pbc_param(pairing, par);
+  check_rho(pairing, 1, 4);
+  check_rho(pairing, 3, 4);
+  pairing_clear(pairing);
+  pbc_param_clear(par);
+  mpz_clear(n);
+  mpz_clear(p);
+
+  return pbc_err_count;
+}
@@ -87,6 +87,29 @@ static void test_bilinear(void) {
     EXPECT(element_is0(c1));
 }
 
+static void test_to_bytes(void) {
+    unsigned char buf[512];
+    int len = pairing_length_in_bytes_G1(pairing);
+    EXPECT(len > 0 && len <= (int) sizeof(buf));
+    element_random(a1);
+    EXPECT(element_to_bytes(buf, a1) == len);
+    EXPECT(element_from_bytes(a2, buf) == len);
+    EXPECT(element_cmp(a1, a2) == 0);
+    element_set0(a1);
+    element_to_bytes(buf, a1);
+    element_random(a2);
+    element_from_bytes(a2, buf);
+    EXPECT(element_is0(a2));
+    element_random(a1);
+    element_random(b1);
+    element_pairing(c1, a1, b1);
+    len = pairing_length_in_bytes_GT(pairing);
+    EXPECT(len > 0 && len <= (int) sizeof(buf));
+    EXPECT(element_to_bytes(buf, c1) == len);
+    EXPECT(element_from_bytes(c2, buf) == len);
+    EXPECT(element_cmp(c1, c2) == 0);
+}
+
 static void test_gen_param(void) {
     typedef struct {
         unsigned int len;
@@ -124,6 +147,7 @@ int main(void) {
     test_order();
     test_bilinear_with_zero();
     test_bilinear();
+    test_to_bytes();
     test_gen_param();
     tear_down();
     return 0;
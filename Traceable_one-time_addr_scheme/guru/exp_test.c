@@ -72,6 +72,35 @@ int main(int argc, char **argv) {
     printf("Oops 2!\n");
   }
 
+  // 32 bases at once, against 32 exponentiations.
+  element_t base[32];
+  mpz_t e[32];
+  for (i = 0; i < 32; i++) {
+    element_init(base[i], pairing->G1);
+    element_random(base[i]);
+    mpz_init(e[i]);
+    pbc_mpz_random(e[i], pairing->r);
+  }
+  t0 = pbc_get_time();
+  element_set1(u1);
+  for (i = 0; i < 32; i++) {
+    element_pow_mpz(up1, base[i], e[i]);
+    element_mul(u1, u1, up1);
+  }
+  t1 = pbc_get_time();
+  printf("G1 32 exps:\t%fs\n", t1 - t0);
+  t0 = pbc_get_time();
+  element_multi_pow_mpz(up1, base, e, 32);
+  t1 = pbc_get_time();
+  printf("G1 32-multiexp:\t%fs\n", t1 - t0);
+  if (element_cmp(u1, up1)) {
+    printf("Oops 3!\n");
+  }
+  for (i = 0; i < 32; i++) {
+    element_clear(base[i]);
+    mpz_clear(e[i]);
+  }
+
   mpz_clear(r_mpz);
   element_clear(g1);
   element_clear(u1);
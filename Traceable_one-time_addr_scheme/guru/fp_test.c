@@ -1,9 +1,145 @@
 // Test F_p.
 
+#include <stdlib.h>
+#include <string.h>
 #include "pbc.h"
 #include "pbc_fp.h"
 #include "pbc_test.h"
 
+// Compares Montgomery arithmetic, including the fixed-width routines for
+// small limb counts, with the naive implementation, and batched products
+// with single ones.
+static void check_mont(mpz_t prime) {
+  enum { BATCH = 19 };
+  field_t fm, fn;
+  element_t a, b, c, d, x, y, z;
+  element_t u[BATCH], v[BATCH], w[BATCH];
+  mpz_t m, n;
+  int i, j;
+
+  mpz_init(m);
+  mpz_init(n);
+  field_init_mont_fp(fm, prime);
+  field_init_naive_fp(fn, prime);
+  element_init(a, fm);
+  element_init(b, fm);
+  element_init(c, fm);
+  element_init(d, fm);
+  element_init(x, fn);
+  element_init(y, fn);
+  element_init(z, fn);
+
+// Comparing in Montgomery form also catches results left unreduced.
+#define MONT_EXPECT(mont, naive) \
+  mont; naive; \
+  element_to_mpz(n, z); \
+  element_set_mpz(d, n); \
+  EXPECT(!element_cmp(c, d) && element_is0(c) == element_is0(z))
+
+  for (i = 0; i < 100; i++) {
+    element_random(a);
+    // Zero, negations and equal operands hit the edge cases.
+    switch (i % 5) {
+      case 0: element_set0(b); break;
+      case 1: element_neg(b, a); break;
+      case 2: element_set(b, a); break;
+      case 3: element_set_si(b, -1); break;
+      default: element_random(b);
+    }
+    element_to_mpz(m, a);
+    element_set_mpz(x, m);
+    element_to_mpz(m, b);
+    element_set_mpz(y, m);
+    MONT_EXPECT(element_add(c, a, b), element_add(z, x, y));
+    MONT_EXPECT(element_sub(c, a, b), element_sub(z, x, y));
+    MONT_EXPECT(element_sub(c, b, a), element_sub(z, y, x));
+    MONT_EXPECT(element_mul(c, a, b), element_mul(z, x, y));
+    MONT_EXPECT(element_double(c, b), element_double(z, y));
+    MONT_EXPECT(element_neg(c, b), element_neg(z, y));
+    MONT_EXPECT(element_mul(c, c, a), element_mul(z, z, x));
+    MONT_EXPECT(element_square(c, b), element_mul(z, y, y));
+    MONT_EXPECT(element_square(c, c), element_mul(z, z, z));
+    // Inversion, including of 1 and -1, in variable and constant time.
+    if (i < 2) {
+      element_set1(b);
+      element_set1(y);
+    }
+    if (!element_is0(b)) {
+      MONT_EXPECT(element_invert(c, b), element_invert(z, y));
+      MONT_EXPECT(element_invert_ct(c, b), element_invert(z, y));
+    }
+  }
+#undef MONT_EXPECT
+
+  // Conversions reduce inputs of up to twice the limbs without division;
+  // all ones reaches the largest such input, and longer ones go through
+  // mpz. Multiples of the modulus must come out as zero.
+  {
+    size_t k, bytes = mpz_size(prime) * sizeof(mp_limb_t);
+    unsigned char buf[2 * bytes + 9];
+    for (i = 0; i < 60; i++) {
+      int len = i % 3 == 0 ? (int) (2 * bytes) : i % (int) (2 * bytes + 9);
+      for (k = 0; k < (size_t) len; k++) buf[k] = i % 5 == 1 ? 0xff : rand();
+      mpz_import(m, len, 1, 1, 1, 0, buf);
+      if (i % 5 == 2) {
+        mpz_set_ui(n, i);
+        mpz_mul(m, prime, n);
+        len = (int) ((mpz_sizeinbase(m, 2) + 7) / 8);
+        memset(buf, 0, sizeof(buf));
+        mpz_export(buf + sizeof(buf) - len, NULL, 1, 1, 1, 0, m);
+        memmove(buf, buf + sizeof(buf) - len, len);
+      }
+      element_from_bytes_mod(c, buf, len);
+      element_set_mpz(a, m);
+      mpz_mod(n, m, prime);
+      element_set_mpz(z, n);
+      element_to_mpz(n, c);
+      element_set_mpz(x, n);
+      EXPECT(!element_cmp(x, z) && !element_cmp(a, c));
+      EXPECT(element_is0(c) == !mpz_sgn(n));
+    }
+  }
+
+  // Batches of 1, 8 and 19 cover a partial group of lanes, a full one,
+  // and both together; some factors are zero.
+  for (i = 0; i < BATCH; i++) {
+    element_init(u[i], fm);
+    element_init(v[i], fm);
+    element_init(w[i], fm);
+    element_random(u[i]);
+    if (i % 7 == 3) element_set0(v[i]);
+    else element_random(v[i]);
+  }
+  element_set_si(v[5], -1);
+  for (j = 1; j <= BATCH; j += j < 8 ? 7 : 11) {
+    element_multi_mul(w, u, v, j);
+    for (i = 0; i < j; i++) {
+      element_mul(c, u[i], v[i]);
+      EXPECT(!element_cmp(c, w[i]));
+    }
+  }
+  // In place.
+  element_multi_mul(u, u, v, BATCH);
+  for (i = 0; i < BATCH; i++) EXPECT(!element_cmp(u[i], w[i]));
+  for (i = 0; i < BATCH; i++) {
+    element_clear(u[i]);
+    element_clear(v[i]);
+    element_clear(w[i]);
+  }
+
+  element_clear(a);
+  element_clear(b);
+  element_clear(c);
+  element_clear(d);
+  element_clear(x);
+  element_clear(y);
+  element_clear(z);
+  field_clear(fm);
+  field_clear(fn);
+  mpz_clear(m);
+  mpz_clear(n);
+}
+
 int main(void) {
   field_t fp;
   mpz_t prime;
@@ -88,6 +224,33 @@ int main(void) {
   element_clear(y);
   element_clear(z);
   field_clear(fp);
+
+  // For 2 to 17 limbs: primes just below a limb boundary, where sums
+  // carry out of the top limb, with a full top limb, where products often
+  // need the final subtraction, and with a short top limb. The second pass
+  // masks off the CPU extensions to reach the portable routines.
+  int limbs, bits, pass;
+  for (pass = 0; pass < 2; pass++) {
+    if (pass) {
+      pbc_tweak_cpu_features(0);
+      EXPECT(!pbc_cpu_features());
+    }
+    for (limbs = 2; limbs <= 17; limbs++) {
+      mpz_set_ui(prime, 0);
+      mpz_setbit(prime, limbs * GMP_LIMB_BITS);
+      mpz_sub_ui(prime, prime, 1000);
+      mpz_nextprime(prime, prime);
+      check_mont(prime);
+      for (bits = 0; bits <= 40; bits += 40) {
+        pbc_mpz_randomb(prime, limbs * GMP_LIMB_BITS - bits);
+        mpz_setbit(prime, limbs * GMP_LIMB_BITS - bits - 1);
+        mpz_nextprime(prime, prime);
+        check_mont(prime);
+      }
+    }
+  }
+  pbc_tweak_cpu_features(~0U);
+
   mpz_clear(prime);
   mpz_clear(m);
   mpz_clear(n);
@@ -0,0 +1,63 @@
+// Test pbc_hilbert(): known polynomials, and the same answer however many
+// threads compute it and whether or not it comes from the cache.
+#include <gmp.h>
+#include "pbc.h"
+#include "pbc_hilbert.h"
+#include "pbc_test.h"
+
+// Compare with the coefficients in want, from X^0 up, in base 10.
+static void check_known(int D, int n, const char **want) {
+  mpz_t *coeff;
+  int i;
+
+  EXPECT(pbc_hilbert(&coeff, D) == (size_t) n);
+  for (i = 0; i < n; i++) {
+    mpz_t z;
+    mpz_init_set_str(z, want[i], 10);
+    EXPECT(!mpz_cmp(coeff[i], z));
+    mpz_clear(z);
+  }
+  pbc_hilbert_free(coeff, n);
+}
+
+static int same(mpz_t *a, size_t na, mpz_t *b, size_t nb) {
+  size_t i;
+  if (na != nb) return 0;
+  for (i = 0; i < na; i++) if (mpz_cmp(a[i], b[i])) return 0;
+  return 1;
+}
+
+int main(void) {
+  const char *h3[] = { "0", "1" };
+  const char *h4[] = { "-1728", "1" };
+  const char *h7[] = { "3375", "1" };
+  const char *h15[] = { "-121287375", "191025", "1" };
+  const char *h23[] = { "12771880859375", "-5151296875", "3491750", "1" };
+  mpz_t *a, *b;
+  size_t na, nb;
+
+  pbc_set_msg_to_stderr(0);
+  check_known(3, 2, h3);
+  check_known(4, 2, h4);
+  check_known(7, 2, h7);
+  check_known(15, 3, h15);
+  check_known(23, 4, h23);
+
+  // Class number 18: enough forms to share between threads and for the
+  // products of factors to use Karatsuba.
+  pbc_hilbert_set_threads(1);
+  na = pbc_hilbert(&a, 9563);
+  EXPECT(na == 19);
+  pbc_hilbert_cache_clear();
+  pbc_hilbert_set_threads(4);
+  nb = pbc_hilbert(&b, 9563);
+  EXPECT(same(a, na, b, nb));
+  pbc_hilbert_free(b, nb);
+  nb = pbc_hilbert(&b, 9563);
+  EXPECT(same(a, na, b, nb));
+  pbc_hilbert_free(b, nb);
+  pbc_hilbert_free(a, na);
+
+  pbc_hilbert_cache_clear();
+  return pbc_err_count;
+}
@@ -3,9 +3,12 @@
 #include <stdint.h> // for intptr_t
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>  // for sysconf
 #include <gmp.h>
 #include "pbc.h"
 #include "pbc_utils.h"
+#include "misc/darray.h"
 
 struct cell_s {
   int ind;
@@ -88,299 +91,414 @@ static void CRT(mpz_t x, mpz_ptr *v, mpz_ptr *m, int t) {
   mpz_clear(u);
 }
 
-//TODO: http://www.cecm.sfu.ca/CAG/abstracts/aaron27Jan06.pdf
-//TODO: don't need to store last element of list in row[i]
-//TODO: linked lists might be better than dynamic arrays (avoids memmove())
-//TODO: allow holes in the table
-//(if drought lasts too long)
-void index_calculus_step1(mpz_t *ind, int r, mpz_t g, mpz_t q,
-    darray_ptr fac, darray_ptr mul) {
-  int count = 0;
-  int i, j;
-  mpz_t z, z0, z1;
-  int relcount;
-  unsigned int *prime = pbc_malloc(sizeof(unsigned int) * r);
-  int bundlecount = (r - 10 + 19) / 20;
-  mpz_t *bundle = pbc_malloc(sizeof(mpz_t) * bundlecount);
-  int faci;
-  mpz_t k, km;
-
-  cell_ptr *rel = pbc_malloc(sizeof(cell_ptr) * r);
-  cell_ptr *relm = pbc_malloc(sizeof(cell_ptr) * r);
+// State shared by the threads collecting relations for step 1.
+struct ic_s {
+  int r;
+  mpz_ptr g, q;
+  darray_ptr fac;
+  unsigned int *prime;
+  int bundlecount;
+  mpz_t *bundle;
+  int threads;
+  // The rest is only touched under lock.
   //''matrix'' is actually a list of matrices
   //(we solve over different moduli and combine using CRT)
-  //darray_t **matrix = pbc_malloc(sizeof(darray_t *) * fac->count);
-  darray_t *matrix[fac->count];
-  int minfound[fac->count];
+  darray_t **matrix;
+  int *minfound;
+  cell_ptr *relm;
+  mpz_t km, z0, z1;
+  int count;
+  int done;
+  pthread_mutex_t lock;
+};
 
-  for (i=0; i<r; i++) {
-    rel[i] = newcell();
-    relm[i] = newcell();
-  }
-  for (i=0; i<fac->count; i++) {
-    //similarly ''row'' refers to a list of rows
-    darray_t *row = pbc_malloc(sizeof(darray_t) * r);
-    for (j=0; j<r; j++) {
-      darray_init(row[j]);
-    }
-    matrix[i] = row;
-    minfound[i] = 0;
-  }
+struct ic_worker_s {
+  struct ic_s *ic;
+  unsigned int start;
+};
 
-  mpz_init(k);
-  mpz_init(km);
-  mpz_init(z);
-  mpz_init(z1);
-  mpz_init(z0);
+static int ic_threads;
 
-  printf("building prime table...\n");
-  prime[0] = 2;
-  mpz_set_ui(z, 2);
-  for (i=1; i<r; i++) {
-    mpz_nextprime(z, z);
-    prime[i] = mpz_get_ui(z);
-  }
+void pbc_mpz_index_calculus_set_threads(int n) {
+  ic_threads = n;
+}
 
-  for (i=0; i<bundlecount; i++) {
-    mpz_init(bundle[i]);
-    mpz_set_ui(bundle[i], 1);
-    for (j=0; j<20; j++) {
-      int jj = 10 + 20 * i + j;
-      if (jj >= r) break;
-      mpz_mul_ui(bundle[i], bundle[i], prime[jj]);
-    }
-    element_printf("bundle %d: %Zd\n", i, bundle[i]);
+static int ic_thread_count(void) {
+  if (ic_threads > 0) return ic_threads;
+#ifdef _SC_NPROCESSORS_ONLN
+  {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return n;
   }
-  printf("searching for r-smooth numbers\n");
-
-  mpz_set_ui(z, 1);
-  mpz_init(k);
-  int try = 0;
-  do {
-    mpz_mul(z, z, g);
-    mpz_mod(z, z, q);
-    mpz_add_ui(k, k, 1);
-
-    /*
-    pbc_mpz_random(k, q);
-    mpz_powm(z, g, k, q);
-    */
+#endif
+  return 1;
+}
 
-    try++;
+// Factors z over the first r primes into rel, by trial division by the
+// first 10 and then by bundles of 20 whose product shares a factor with
+// what is left. Returns the number of primes in rel, or 0 if z is not
+// r-smooth.
+static int smooth_relation(struct ic_s *ic, cell_ptr *rel, mpz_t z,
+    mpz_t z0, mpz_t z1) {
+  int r = ic->r;
+  unsigned int *prime = ic->prime;
+  int relcount = 0;
+  int i, j;
 
-    mpz_set(z1, z);
-    relcount = 0;
-    for (i=0; i<10; i++) {
-      if (i >= r) break;
-      j = 0;
-      while (mpz_divisible_ui_p(z1, prime[i])) {
-        mpz_divexact_ui(z1, z1, prime[i]);
-        j++;
-      }
-      if (j) {
-        rel[relcount]->ind = i;
-        mpz_set_ui(rel[relcount]->data, j);
-        relcount++;
-        if (!mpz_cmp_ui(z1, 1)) goto found;
-      }
+  mpz_set(z1, z);
+  for (i=0; i<10; i++) {
+    if (i >= r) break;
+    j = 0;
+    while (mpz_divisible_ui_p(z1, prime[i])) {
+      mpz_divexact_ui(z1, z1, prime[i]);
+      j++;
     }
-    for (i=0; i<bundlecount; i++) {
-      mpz_gcd(z0, bundle[i], z1);
-      if (mpz_cmp_ui(z0, 1)) {
-        int ii;
-        for (ii = 0; ii < 20; ii++) {
-          int jj = 10 + i * 20 + ii;
-          if (jj >= r) break;
-          j = 0;
-          while (mpz_divisible_ui_p(z1, prime[jj])) {
-            mpz_divexact_ui(z1, z1, prime[jj]);
-            j++;
-          }
-          if (j) {
-            rel[relcount]->ind = jj;
-            mpz_set_ui(rel[relcount]->data, j);
-            relcount++;
-            if (!mpz_cmp_ui(z1, 1)) goto found;
-          }
+    if (j) {
+      rel[relcount]->ind = i;
+      mpz_set_ui(rel[relcount]->data, j);
+      relcount++;
+      if (!mpz_cmp_ui(z1, 1)) return relcount;
+    }
+  }
+  for (i=0; i<ic->bundlecount; i++) {
+    mpz_gcd(z0, ic->bundle[i], z1);
+    if (mpz_cmp_ui(z0, 1)) {
+      int ii;
+      for (ii = 0; ii < 20; ii++) {
+        int jj = 10 + i * 20 + ii;
+        if (jj >= r) break;
+        j = 0;
+        while (mpz_divisible_ui_p(z1, prime[jj])) {
+          mpz_divexact_ui(z1, z1, prime[jj]);
+          j++;
+        }
+        if (j) {
+          rel[relcount]->ind = jj;
+          mpz_set_ui(rel[relcount]->data, j);
+          relcount++;
+          if (!mpz_cmp_ui(z1, 1)) return relcount;
         }
       }
     }
-    continue;
-found:
-
-/*
-    printf("found r-smooth number after %d tries\n", try);
+  }
+  return 0;
+}
 
-    gmp_printf("g^%Zd = %Zd:", k, z);
-    for (i=0; i<relcount; i++) {
-      gmp_printf(" %u:%Zd", rel[i]->ind, rel[i]->data);
-    }
-    printf("\n");
-*/
-    try = 0;
+// Reduces the relation g^k = prod prime[rel[i]->ind]^rel[i]->data modulo
+// each factor of q - 1 against the rows found so far, and keeps what is
+// left as a new row. Called under ic->lock.
+static void add_relation(struct ic_s *ic, cell_ptr *rel, int relcount,
+    mpz_t k) {
+  int r = ic->r;
+  darray_ptr fac = ic->fac;
+  darray_t **matrix = ic->matrix;
+  int *minfound = ic->minfound;
+  cell_ptr *relm = ic->relm;
+  mpz_ptr km = ic->km, z0 = ic->z0, z1 = ic->z1;
+  int i, j, faci;
 
-    for (faci=0; faci<fac->count; faci++) {
-      darray_t *row = matrix[faci];
-      mpz_ptr order = fac->item[faci];
-      int relmcount = 0;
-      mpz_mod(km, k, order);
+  for (faci=0; faci<fac->count; faci++) {
+    darray_t *row = matrix[faci];
+    mpz_ptr order = fac->item[faci];
+    int relmcount = 0;
+    mpz_mod(km, k, order);
 
-      //gmp_printf("mod %Zd\n", order);
-      for (i=0; i<relcount; i++) {
-        mpz_mod(z0, rel[i]->data, order);
-        if (mpz_sgn(z0)) {
-          mpz_set(relm[relmcount]->data, z0);
-          relm[relmcount]->ind = rel[i]->ind;
-          relmcount++;
-        }
+    //gmp_printf("mod %Zd\n", order);
+    for (i=0; i<relcount; i++) {
+      mpz_mod(z0, rel[i]->data, order);
+      if (mpz_sgn(z0)) {
+        mpz_set(relm[relmcount]->data, z0);
+        relm[relmcount]->ind = rel[i]->ind;
+        relmcount++;
       }
+    }
 
-      while (relmcount) {
-        //start from the sparse end
-        int rind = relm[relmcount - 1]->ind;
-        darray_ptr rp = row[rind];
-
-        if (rind < minfound[faci]) break;
-
-        mpz_set(z0, relm[relmcount - 1]->data);
-        if (!rp->count) {
-          mpz_invert(z0, z0, order);
-          cell_ptr cnew = newcell();
-          cnew->ind = -1;
-          mpz_mul(z1, km, z0);
+    while (relmcount) {
+      //start from the sparse end
+      int rind = relm[relmcount - 1]->ind;
+      darray_ptr rp = row[rind];
+
+      if (rind < minfound[faci]) break;
+
+      mpz_set(z0, relm[relmcount - 1]->data);
+      if (!rp->count) {
+        mpz_invert(z0, z0, order);
+        cell_ptr cnew = newcell();
+        cnew->ind = -1;
+        mpz_mul(z1, km, z0);
+        mpz_mod(cnew->data, z1, order);
+        darray_append(rp, cnew);
+        for (j=0; j<relmcount; j++) {
+          cnew = newcell();
+          cnew->ind = relm[j]->ind;
+          mpz_mul(z1, relm[j]->data, z0);
           mpz_mod(cnew->data, z1, order);
           darray_append(rp, cnew);
-          for (j=0; j<relmcount; j++) {
-            cnew = newcell();
-            cnew->ind = relm[j]->ind;
-            mpz_mul(z1, relm[j]->data, z0);
-            mpz_mod(cnew->data, z1, order);
-            darray_append(rp, cnew);
-          }
-          count++;
-printf("%d / %d\n", count, r * fac->count);
+        }
+        ic->count++;
+printf("%d / %d\n", ic->count, r * fac->count);
 /*
 for (i=1; i<rp->count; i++) {
-  cnew = rp->item[i];
-  gmp_printf(" %u:%Zd", cnew->ind, cnew->data);
+cnew = rp->item[i];
+gmp_printf(" %u:%Zd", cnew->ind, cnew->data);
 }
 cnew = rp->item[0];
 gmp_printf(" %Zd\n", cnew->data);
 */
 
-          if (rind == minfound[faci]) {
-            do {
-              if (!minfound[faci]) {
-              printf("found log p_%d\n", minfound[faci]);
-              cnew = rp->item[0];
-              gmp_printf("km = %Zd mod %Zd\n", cnew->data, order);
-              }
-              minfound[faci]++;
-              if (minfound[faci] >= r) break;
-              rp = row[minfound[faci]];
-            } while (rp->count);
-          }
-          break;
-
+        if (rind == minfound[faci]) {
+          do {
+            if (!minfound[faci]) {
+            printf("found log p_%d\n", minfound[faci]);
+            cnew = rp->item[0];
+            gmp_printf("km = %Zd mod %Zd\n", cnew->data, order);
+            }
+            minfound[faci]++;
+            if (minfound[faci] >= r) break;
+            rp = row[minfound[faci]];
+          } while (rp->count);
         }
+        break;
+
+      }
 
 /*
 {
 //gmp_printf("mod = %Zd\n", order);
 printf("before:");
 for (i=0; i<relmcount; i++) {
-  gmp_printf(" %u:%Zd", relm[i]->ind, relm[i]->data);
+gmp_printf(" %u:%Zd", relm[i]->ind, relm[i]->data);
 }
 gmp_printf(" %Zd\n", km);
 cell_ptr cp;
 printf("sub %d:", rind);
 for (i=1; i<rp->count; i++) {
-  cp = rp->item[i];
-  gmp_printf(" %u:%Zd", cp->ind, cp->data);
+cp = rp->item[i];
+gmp_printf(" %u:%Zd", cp->ind, cp->data);
 }
 cp = rp->item[0];
 gmp_printf(" %Zd\n", cp->data);
 }
 */
-        cell_ptr cpi, cpj;
-        relmcount--;
-        i=0; j=1;
-        while (i<relmcount && j<rp->count - 1) {
-          cpi = relm[i];
-          cpj = rp->item[j];
-          if (cpi->ind == cpj->ind) {
-            mpz_mul(z1, z0, cpj->data);
-            mpz_mod(z1, z1, order);
-            int res = mpz_cmp(z1, cpi->data);
-            if (!res) {
-              memmove(&relm[i], &relm[i + 1], (relmcount - i - 1) * sizeof(cell_ptr));
-              relm[relmcount - 1] = cpi;
-              relmcount--;
-              j++;
-            } else if (res > 0) {
-              mpz_sub(z1, order, z1);
-              mpz_add(cpi->data, cpi->data, z1);
-              i++;
-              j++;
-            } else {
-              mpz_sub(cpi->data, cpi->data, z1);
-              i++;
-              j++;
-            }
-          } else if (cpi->ind > cpj->ind) {
-            cpi = relm[relmcount];
-            memmove(&relm[i + 1], &relm[i], (relmcount - i) * sizeof(cell_ptr));
-            relm[i] = cpi;
-            relmcount++;
-
-            cpi->ind = cpj->ind;
-            mpz_mul(z1, z0, cpj->data);
-            mpz_mod(z1, z1, order);
-            mpz_sub(cpi->data, order, z1);
-            //cpi->data = order - ((u0 * cpj->data) % order);
+      cell_ptr cpi, cpj;
+      relmcount--;
+      i=0; j=1;
+      while (i<relmcount && j<rp->count - 1) {
+        cpi = relm[i];
+        cpj = rp->item[j];
+        if (cpi->ind == cpj->ind) {
+          mpz_mul(z1, z0, cpj->data);
+          mpz_mod(z1, z1, order);
+          int res = mpz_cmp(z1, cpi->data);
+          if (!res) {
+            memmove(&relm[i], &relm[i + 1], (relmcount - i - 1) * sizeof(cell_ptr));
+            relm[relmcount - 1] = cpi;
+            relmcount--;
+            j++;
+          } else if (res > 0) {
+            mpz_sub(z1, order, z1);
+            mpz_add(cpi->data, cpi->data, z1);
             i++;
             j++;
           } else {
+            mpz_sub(cpi->data, cpi->data, z1);
             i++;
-          }
-        }
-
-        if (i == relmcount) {
-          while (j < rp->count - 1) {
-            cpi = relm[relmcount];
-            cpj = rp->item[j];
-            cpi->ind = cpj->ind;
-            mpz_mul(z1, z0, cpj->data);
-            mpz_mod(z1, z1, order);
-            mpz_sub(cpi->data, order, z1);
-            //cpi->data = order - ((u0 * cpj->data) % order);
-            relmcount++;
             j++;
           }
-        }
+        } else if (cpi->ind > cpj->ind) {
+          cpi = relm[relmcount];
+          memmove(&relm[i + 1], &relm[i], (relmcount - i) * sizeof(cell_ptr));
+          relm[i] = cpi;
+          relmcount++;
 
-        cpj = rp->item[0];
-        mpz_mul(z1, z0, cpj->data);
-        mpz_mod(z1, z1, order);
-        //u1 = (u0 * cpj->data) % order;
-        if (mpz_cmp(km, z1) >= 0) {
-          mpz_sub(km, km, z1);
+          cpi->ind = cpj->ind;
+          mpz_mul(z1, z0, cpj->data);
+          mpz_mod(z1, z1, order);
+          mpz_sub(cpi->data, order, z1);
+          //cpi->data = order - ((u0 * cpj->data) % order);
+          i++;
+          j++;
         } else {
-          mpz_sub(z1, order, z1);
-          mpz_add(km, km, z1);
+          i++;
+        }
+      }
+
+      if (i == relmcount) {
+        while (j < rp->count - 1) {
+          cpi = relm[relmcount];
+          cpj = rp->item[j];
+          cpi->ind = cpj->ind;
+          mpz_mul(z1, z0, cpj->data);
+          mpz_mod(z1, z1, order);
+          mpz_sub(cpi->data, order, z1);
+          //cpi->data = order - ((u0 * cpj->data) % order);
+          relmcount++;
+          j++;
         }
+      }
+
+      cpj = rp->item[0];
+      mpz_mul(z1, z0, cpj->data);
+      mpz_mod(z1, z1, order);
+      //u1 = (u0 * cpj->data) % order;
+      if (mpz_cmp(km, z1) >= 0) {
+        mpz_sub(km, km, z1);
+      } else {
+        mpz_sub(z1, order, z1);
+        mpz_add(km, km, z1);
+      }
 
 /*
 printf("after:");
 for (i=0; i<relmcount; i++) {
-  gmp_printf(" %u:%Zd", relm[i]->ind, relm[i]->data);
+gmp_printf(" %u:%Zd", relm[i]->ind, relm[i]->data);
 }
 gmp_printf(" %Zd\n", km);
 */
+    }
+  }
+}
+
+// Each thread tries g^k for k = start, start + threads, ..., so together
+// they try the same exponents as a single thread walking k = 1, 2, ...
+static void *relation_worker(void *data) {
+  struct ic_worker_s *w = data;
+  struct ic_s *ic = w->ic;
+  int r = ic->r;
+  cell_ptr *rel = pbc_malloc(sizeof(cell_ptr) * r);
+  mpz_t k, z, z0, z1, step;
+  int i;
+
+  for (i=0; i<r; i++) rel[i] = newcell();
+  mpz_init(z0);
+  mpz_init(z1);
+  mpz_init(step);
+  mpz_init_set_ui(k, w->start);
+  mpz_init(z);
+  mpz_powm(z, ic->g, k, ic->q);
+  mpz_powm_ui(step, ic->g, ic->threads, ic->q);
+
+  while (!__atomic_load_n(&ic->done, __ATOMIC_ACQUIRE)) {
+    int relcount = smooth_relation(ic, rel, z, z0, z1);
+    if (relcount) {
+      pthread_mutex_lock(&ic->lock);
+      if (!ic->done) {
+        add_relation(ic, rel, relcount, k);
+        if (ic->count >= r * ic->fac->count) {
+          __atomic_store_n(&ic->done, 1, __ATOMIC_RELEASE);
+        }
       }
+      pthread_mutex_unlock(&ic->lock);
     }
+    mpz_mul(z, z, step);
+    mpz_mod(z, z, ic->q);
+    mpz_add_ui(k, k, ic->threads);
+  }
 
-  } while (count < r * fac->count);
+  for (i=0; i<r; i++) delcell(rel[i]);
+  pbc_free(rel);
+  mpz_clear(k);
+  mpz_clear(z);
+  mpz_clear(z0);
+  mpz_clear(z1);
+  mpz_clear(step);
+  return NULL;
+}
+
+//TODO: http://www.cecm.sfu.ca/CAG/abstracts/aaron27Jan06.pdf
+//TODO: don't need to store last element of list in row[i]
+//TODO: linked lists might be better than dynamic arrays (avoids memmove())
+//TODO: allow holes in the table
+//(if drought lasts too long)
+void index_calculus_step1(mpz_t *ind, int r, mpz_t g, mpz_t q,
+    darray_ptr fac, darray_ptr mul) {
+  struct ic_s ic;
+  struct ic_worker_s *w;
+  pthread_t *tid;
+  int i, j, started;
+  mpz_t z, z0;
+  unsigned int *prime = pbc_malloc(sizeof(unsigned int) * r);
+  int bundlecount = (r - 10 + 19) / 20;
+  mpz_t *bundle = pbc_malloc(sizeof(mpz_t) * bundlecount);
+  int faci;
+
+  cell_ptr *relm = pbc_malloc(sizeof(cell_ptr) * r);
+  darray_t *matrix[fac->count];
+  int minfound[fac->count];
+
+  for (i=0; i<r; i++) {
+    relm[i] = newcell();
+  }
+  for (i=0; i<fac->count; i++) {
+    //similarly ''row'' refers to a list of rows
+    darray_t *row = pbc_malloc(sizeof(darray_t) * r);
+    for (j=0; j<r; j++) {
+      darray_init(row[j]);
+    }
+    matrix[i] = row;
+    minfound[i] = 0;
+  }
+
+  mpz_init(z);
+  mpz_init(z0);
+
+  printf("building prime table...\n");
+  prime[0] = 2;
+  mpz_set_ui(z, 2);
+  for (i=1; i<r; i++) {
+    mpz_nextprime(z, z);
+    prime[i] = mpz_get_ui(z);
+  }
+
+  for (i=0; i<bundlecount; i++) {
+    mpz_init(bundle[i]);
+    mpz_set_ui(bundle[i], 1);
+    for (j=0; j<20; j++) {
+      int jj = 10 + 20 * i + j;
+      if (jj >= r) break;
+      mpz_mul_ui(bundle[i], bundle[i], prime[jj]);
+    }
+    element_printf("bundle %d: %Zd\n", i, bundle[i]);
+  }
+
+  ic.r = r;
+  ic.g = g;
+  ic.q = q;
+  ic.fac = fac;
+  ic.prime = prime;
+  ic.bundlecount = bundlecount;
+  ic.bundle = bundle;
+  ic.threads = ic_thread_count();
+  ic.matrix = matrix;
+  ic.minfound = minfound;
+  ic.relm = relm;
+  mpz_init(ic.km);
+  mpz_init(ic.z0);
+  mpz_init(ic.z1);
+  ic.count = 0;
+  ic.done = r * fac->count == 0;
+  pthread_mutex_init(&ic.lock, NULL);
+
+  printf("searching for r-smooth numbers on %d threads\n", ic.threads);
+  w = pbc_malloc(sizeof(struct ic_worker_s) * ic.threads);
+  for (i=0; i<ic.threads; i++) {
+    w[i].ic = &ic;
+    w[i].start = i + 1;
+  }
+  tid = pbc_malloc(sizeof(pthread_t) * ic.threads);
+  // The exponents of threads that fail to start are not tried, which
+  // only costs more tries on the others.
+  for (started = 0; started < ic.threads - 1; started++) {
+    if (pthread_create(&tid[started], NULL, relation_worker, &w[started + 1])) break;
+  }
+  relation_worker(&w[0]);
+  for (i=0; i<started; i++) pthread_join(tid[i], NULL);
+  pbc_free(tid);
+  pbc_free(w);
+  pthread_mutex_destroy(&ic.lock);
+  mpz_clear(ic.km);
+  mpz_clear(ic.z0);
+  mpz_clear(ic.z1);
 
   for (faci=0; faci<fac->count; faci++) {
     darray_t *row = matrix[faci];
@@ -420,7 +538,7 @@ gmp_printf(" %Zd\n", km);
   }
   pbc_free(tmp);
 
-  for (faci=0; i<fac->count; faci++) {
+  for (faci=0; faci<fac->count; faci++) {
     //similarly ''row'' refers to a list of rows
     darray_t *row = matrix[faci];
     for (j=0; j<r; j++) {
@@ -431,18 +549,15 @@ gmp_printf(" %Zd\n", km);
   }
 
   for (i=0; i<r; i++) {
-    delcell(rel[i]);
     delcell(relm[i]);
   }
+  for (i=0; i<bundlecount; i++) mpz_clear(bundle[i]);
 
+  pbc_free(bundle);
   pbc_free(prime);
-  pbc_free(rel);
   pbc_free(relm);
-  mpz_clear(k);
-  mpz_clear(km);
   mpz_clear(z);
   mpz_clear(z0);
-  mpz_clear(z1);
 }
 
 // Brute-force: does not use the fact that matrices are sparse.
@@ -771,7 +886,10 @@ struct addfm_scope_var {
 };
 
 static int addfm(mpz_t f, unsigned int m, struct addfm_scope_var *v) {
-  darray_append(v->fac, f);
+  // f is reused for the next factor: keep a copy.
+  mpz_ptr z = pbc_malloc(sizeof(mpz_t));
+  mpz_init_set(z, f);
+  darray_append(v->fac, z);
   darray_append(v->mul, int_to_voidp(m));
   return 0;
 }
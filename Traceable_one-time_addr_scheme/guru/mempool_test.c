@@ -0,0 +1,106 @@
+// Test the pool allocator.
+
+#include <string.h>
+#include <pthread.h>
+#include "pbc.h"
+#include "pbc_test.h"
+
+#define THREADS 4
+#define BLOCKS 1000
+
+static mpz_t expect;
+static void *handoff[THREADS][BLOCKS];
+
+// Allocates and frees in a pattern that overflows the thread lists, and
+// leaves blocks for the main thread to free.
+static void *churn(void *arg) {
+  void **mine = arg;
+  mpz_t z;
+  int i, j;
+
+  for (j = 0; j < 10; j++) {
+    for (i = 0; i < BLOCKS; i++) {
+      mine[i] = pbc_malloc(1 + (i * 37) % 1500);
+      memset(mine[i], i & 0xff, 1 + (i * 37) % 1500);
+    }
+    if (j < 9) for (i = 0; i < BLOCKS; i++) pbc_free(mine[i]);
+  }
+  mpz_init(z);
+  mpz_ui_pow_ui(z, 3, 1000);
+  EXPECT(!mpz_cmp(z, expect));
+  mpz_clear(z);
+  return NULL;
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  element_t x, y, r0, r1;
+  pthread_t t[THREADS];
+  unsigned char *p;
+  mpz_t early;
+  int i, j;
+
+  EXPECT(!pbc_pool_enabled());
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+  element_init_G1(x, pairing);
+  element_init_G2(y, pairing);
+  element_init_GT(r0, pairing);
+  element_random(x);
+  element_random(y);
+  element_pairing(r0, x, y);
+  mpz_init(expect);
+  mpz_ui_pow_ui(expect, 3, 1000);
+  mpz_init_set_ui(early, 1);
+
+  EXPECT(!pbc_pool_enable());
+  EXPECT(pbc_pool_enable() == 1);
+  EXPECT(pbc_pool_enabled());
+
+  // Results match, and memory from before the pool can still grow and go.
+  element_init_GT(r1, pairing);
+  element_pairing(r1, x, y);
+  EXPECT(!element_cmp(r0, r1));
+  mpz_mul_2exp(early, early, 20000);
+  mpz_clear(early);
+  element_clear(r0);
+
+  // Contents survive growth within the pool, past it, and shrinking.
+  p = pbc_malloc(10);
+  for (i = 0; i < 10; i++) p[i] = i;
+  p = pbc_realloc(p, 100);
+  for (i = 10; i < 100; i++) p[i] = i;
+  p = pbc_realloc(p, 5000);
+  for (i = 0; i < 100; i++) EXPECT(p[i] == i);
+  p = pbc_realloc(p, 20);
+  for (i = 0; i < 20; i++) EXPECT(p[i] == i);
+  pbc_free(p);
+
+  for (i = 0; i < THREADS; i++) {
+    pthread_create(&t[i], NULL, churn, handoff[i]);
+  }
+  for (i = 0; i < THREADS; i++) pthread_join(t[i], NULL);
+  // Blocks of exited threads are intact and can be freed here.
+  for (i = 0; i < THREADS; i++) {
+    for (j = 0; j < BLOCKS; j++) {
+      p = handoff[i][j];
+      EXPECT(p[(j * 37) % 1500] == (j & 0xff));
+      pbc_free(p);
+    }
+  }
+  EXPECT(pbc_pool_bytes() > 0);
+
+  element_init_GT(r0, pairing);
+  element_pairing(r0, x, y);
+  EXPECT(!element_cmp(r0, r1));
+
+  element_clear(x);
+  element_clear(y);
+  element_clear(r0);
+  element_clear(r1);
+  mpz_clear(expect);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
@@ -0,0 +1,151 @@
+// Check that every pairing method, under every F_p implementation, gives
+// the same pairings as the defaults, so that a caller may pick whichever
+// runs fastest.
+#include <string.h>
+#include "pbc.h"
+#include "pbc_fp.h"
+#include "pbc_test.h"
+
+static const char d159[] =
+"type d\n"
+"q 625852803282871856053922297323874661378036491717\n"
+"n 625852803282871856053923088432465995634661283063\n"
+"h 3\n"
+"r 208617601094290618684641029477488665211553761021\n"
+"a 581595782028432961150765424293919699975513269268\n"
+"b 517921465817243828776542439081147840953753552322\n"
+"k 6\n"
+"nk 60094290356408407130984161127310078516360031868417968262992864809623507269833854678414046779817844853757026858774966331434198257512457993293271849043664655146443229029069463392046837830267994222789160047337432075266619082657640364986415435746294498140589844832666082434658532589211525696\n"
+"hk 1380801711862212484403205699005242141541629761433899149236405232528956996854655261075303661691995273080620762287276051361446528504633283152278831183711301329765591450680250000592437612973269056\n"
+"coeff0 472731500571015189154958232321864199355792223347\n"
+"coeff1 352243926696145937581894994871017455453604730246\n"
+"coeff2 289113341693870057212775990719504267185772707305\n"
+"nqr 431211441436589568382088865288592347194866189652\n";
+
+static const char g149[] =
+"type g\n"
+"q 503189899097385532598615948567975432740967203\n"
+"n 503189899097385532598571084778608176410973351\n"
+"h 1\n"
+"r 503189899097385532598571084778608176410973351\n"
+"a 465197998498440909244782433627180757481058321\n"
+"b 463074517126110479409374670871346701448503064\n"
+"k 10\n"
+"nk 1040684643531490707494989587381629956832530311976146077888095795458709511789670022388326295177424065807612879371896982185473788988016190582073591316127396374860265835641044035656044524481121528846249501655527462202999638159773731830375673076317719519977183373353791119388388468745670818193868532404392452816602538968163226713846951514831917487400267590451867746120591750902040267826351982737642689423713163967384383105678367875981348397359466338807\n"
+"hk 4110127713690841149713310614420858884651261781185442551927080083178682965171097172366598236129731931693425629387502221804555636704708008882811353539555915064049685663790355716130262332064327767695339422323460458479884756000782939428852120522712008037615051139080628734566850259704397643028017435446110322024094259858170303605703280329322675124728639532674407\n"
+"coeff0 67343110967802947677845897216565803152319250\n"
+"coeff1 115936772834120270862756636148166314916823221\n"
+"coeff2 87387877425076080433559927080662339215696505\n"
+"coeff3 433223145899090928132052677121692683015058909\n"
+"coeff4 405367866213598664862417230702935310328613596\n"
+"nqr 22204504160560785687198080413579021865783099\n";
+
+static char *fps[] = { "mont", "fast", "faster", "naive" };
+static char *methods[] = { "miller", "miller-affine", "shipsey-stange" };
+
+// Points pass between pairings as bytes, which do not depend on the F_p
+// implementation.
+static void check(pbc_param_t param) {
+  pairing_t pairing, other;
+  element_t g, h, e, g1, h1, e1;
+  pairing_pp_t pp;
+  unsigned char *gb, *hb, *eb, *eb1;
+  int i, j, len;
+
+  pairing_init_pbc_param(pairing, param);
+  element_init_G1(g, pairing);
+  element_init_G2(h, pairing);
+  element_init_GT(e, pairing);
+  element_random(g);
+  element_random(h);
+  element_pairing(e, g, h);
+  // The final powering leaves it in the subgroup of order r.
+  element_init_GT(e1, pairing);
+  element_pow_mpz(e1, e, pairing->r);
+  EXPECT(element_is1(e1) && !element_is1(e));
+  element_clear(e1);
+  gb = pbc_malloc(element_length_in_bytes(g));
+  hb = pbc_malloc(element_length_in_bytes(h));
+  len = element_length_in_bytes(e);
+  eb = pbc_malloc(len);
+  eb1 = pbc_malloc(len);
+  element_to_bytes(gb, g);
+  element_to_bytes(hb, h);
+  element_to_bytes(eb, e);
+
+  for (i = 0; i < (int) (sizeof(fps) / sizeof(*fps)); i++) {
+    pbc_tweak_use_fp(fps[i]);
+    pairing_init_pbc_param(other, param);
+    element_init_G1(g1, other);
+    element_init_G2(h1, other);
+    element_init_GT(e1, other);
+    element_from_bytes(g1, gb);
+    element_from_bytes(h1, hb);
+    for (j = 0; j < (int) (sizeof(methods) / sizeof(*methods)); j++) {
+      pairing_option_set(other, "method", methods[j]);
+      element_pairing(e1, g1, h1);
+      EXPECT(element_length_in_bytes(e1) == len);
+      element_to_bytes(eb1, e1);
+      EXPECT(!memcmp(eb, eb1, len));
+      pairing_pp_init(pp, g1, other);
+      pairing_pp_apply(e1, h1, pp);
+      element_to_bytes(eb1, e1);
+      EXPECT(!memcmp(eb, eb1, len));
+      pairing_pp_clear(pp);
+    }
+    element_clear(g1);
+    element_clear(h1);
+    element_clear(e1);
+    pairing_clear(other);
+  }
+  pbc_tweak_use_fp("mont");
+
+  pbc_free(gb);
+  pbc_free(hb);
+  pbc_free(eb);
+  pbc_free(eb1);
+  element_clear(g);
+  element_clear(h);
+  element_clear(e);
+  pairing_clear(pairing);
+}
+
+int main(void) {
+  pbc_param_t param;
+  mpz_t n, t;
+
+  pbc_param_init_a_gen(param, 160, 512);
+  check(param);
+  pbc_param_clear(param);
+
+  mpz_init(n);
+  mpz_init(t);
+  mpz_setbit(n, 80);
+  mpz_nextprime(n, n);
+  mpz_setbit(t, 90);
+  mpz_nextprime(t, t);
+  mpz_mul(n, n, t);
+  pbc_param_init_a1_gen(param, n);
+  check(param);
+  pbc_param_clear(param);
+  mpz_clear(n);
+  mpz_clear(t);
+
+  // The Miller loops of types D and G in projective coordinates.
+  EXPECT(!pbc_param_init_set_str(param, d159));
+  check(param);
+  pbc_param_clear(param);
+  EXPECT(!pbc_param_init_set_str(param, g149));
+  check(param);
+  pbc_param_clear(param);
+
+  // Type E tables of pairing_pp_init() against each Miller loop.
+  pbc_param_init_e_gen(param, 160, 512);
+  check(param);
+  pbc_param_clear(param);
+
+  pbc_param_init_f_gen(param, 160);
+  check(param);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
@@ -0,0 +1,105 @@
+// Test element_multi_pow_mpz() against separate exponentiations.
+
+#include "pbc.h"
+#include "pbc_test.h"
+
+#define MAX_BASES 150
+
+// Compares the product of a[i]^n[i] for the first m bases both ways.
+static void check(element_t a[], mpz_t n[], int m) {
+  element_t x, y, t;
+  int i;
+  element_init_same_as(x, a[0]);
+  element_init_same_as(y, a[0]);
+  element_init_same_as(t, a[0]);
+  element_set1(y);
+  for (i = 0; i < m; i++) {
+    element_pow_mpz(t, a[i], n[i]);
+    element_mul(y, y, t);
+  }
+  element_multi_pow_mpz(x, a, n, m);
+  EXPECT(!element_cmp(x, y));
+  element_clear(x);
+  element_clear(y);
+  element_clear(t);
+}
+
+// Straus and Pippenger sizes, with the cases a batched addition handles
+// without a slope: the identity, equal bases, which make buckets double,
+// and inverse bases, which make them cancel.
+static void check_group(field_ptr f, mpz_ptr order) {
+  element_t a[MAX_BASES];
+  mpz_t n[MAX_BASES];
+  int sizes[] = { 1, 2, 5, 31, 32, 40, MAX_BASES };
+  int i, j;
+
+  for (i = 0; i < MAX_BASES; i++) {
+    element_init(a[i], f);
+    element_random(a[i]);
+    mpz_init(n[i]);
+    pbc_mpz_random(n[i], order);
+  }
+  for (j = 0; j < (int) (sizeof(sizes) / sizeof(*sizes)); j++) {
+    check(a, n, sizes[j]);
+  }
+
+  element_set1(a[1]);
+  element_set(a[3], a[2]);
+  element_invert(a[4], a[2]);
+  mpz_set(n[3], n[2]);
+  mpz_set(n[4], n[2]);
+  mpz_set_ui(n[6], 0);
+  mpz_set_ui(n[7], 1);
+  for (i = 40; i < MAX_BASES; i++) {
+    element_set(a[i], a[i % 10]);
+    if (i % 3) mpz_set(n[i], n[i % 10]);
+  }
+  for (j = 0; j < (int) (sizeof(sizes) / sizeof(*sizes)); j++) {
+    check(a, n, sizes[j]);
+  }
+
+  // All exponents zero.
+  for (i = 0; i < 5; i++) mpz_set_ui(n[i], 0);
+  check(a, n, 5);
+
+  for (i = 0; i < MAX_BASES; i++) {
+    element_clear(a[i]);
+    mpz_clear(n[i]);
+  }
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  element_t x, y, a[3], n[3];
+  int i;
+
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+
+  check_group(pairing->G1, pairing->r);
+  check_group(pairing->GT, pairing->r);
+
+  // The Zr version agrees with element_pow3_zn().
+  element_init_G1(x, pairing);
+  element_init_G1(y, pairing);
+  for (i = 0; i < 3; i++) {
+    element_init_G1(a[i], pairing);
+    element_init_Zr(n[i], pairing);
+    element_random(a[i]);
+    element_random(n[i]);
+  }
+  element_multi_pow_zn(x, a, n, 3);
+  element_pow3_zn(y, a[0], n[0], a[1], n[1], a[2], n[2]);
+  EXPECT(!element_cmp(x, y));
+  for (i = 0; i < 3; i++) {
+    element_clear(a[i]);
+    element_clear(n[i]);
+  }
+  element_clear(x);
+  element_clear(y);
+
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
@@ -0,0 +1,124 @@
+// Test multinomials: lists nest and print as expected, arithmetic pads the
+// shorter operand with zeros, and other fields read them through
+// element_set_multiz().
+#include <stdarg.h>
+#include <string.h>
+#include "pbc.h"
+#include "pbc_fp.h"
+#include "pbc_multiz.h"
+#include "pbc_fieldquadratic.h"
+#include "pbc_test.h"
+
+static field_t M;
+
+static element_ptr z(long n) {
+  element_ptr e = element_new(M);
+  element_set_si(e, n);
+  return e;
+}
+
+// List of the given count of items, which it takes over.
+static element_ptr list(int count, ...) {
+  va_list ap;
+  element_ptr x = NULL;
+  int i;
+  va_start(ap, count);
+  for (i = 0; i < count; i++) {
+    element_ptr e = va_arg(ap, element_ptr);
+    if (!i) x = multiz_new_list(e);
+    else multiz_append(x, e);
+    pbc_free(e);
+  }
+  va_end(ap);
+  return x;
+}
+
+static int prints_as(element_ptr e, const char *s) {
+  char *buf;
+  size_t len;
+  FILE *fp = open_memstream(&buf, &len);
+  element_out_str(fp, 10, e);
+  fclose(fp);
+  int result = !strcmp(buf, s);
+  if (!result) fprintf(stderr, "got %s, want %s\n", buf, s);
+  free(buf);
+  return result;
+}
+
+int main(void) {
+  element_t x, y;
+  element_ptr a, b, c, d, t;
+  field_t fp, fq;
+  mpz_t p;
+
+  field_init_multiz(M);
+  element_init(x, M);
+  element_init(y, M);
+
+  a = list(3, list(2, z(1), z(2)), z(3), list(2, z(4), list(2, z(5), z(6))));
+  EXPECT(prints_as(a, "[[1, 2], 3, [4, [5, 6]]]"));
+  EXPECT(3 == element_item_count(a));
+  EXPECT(prints_as(element_item(a, 2), "[4, [5, 6]]"));
+  element_set(x, element_item(a, 2));
+  EXPECT(prints_as(x, "[4, [5, 6]]"));
+  element_set(x, a);
+  EXPECT(!element_cmp(x, a));
+
+  b = list(2, z(1), z(2));
+  c = list(3, z(10), z(20), z(30));
+  element_add(x, b, c);
+  EXPECT(prints_as(x, "[11, 22, 30]"));
+  element_sub(x, b, c);
+  EXPECT(prints_as(x, "[-9, -18, -30]"));
+  element_set_si(y, 5);
+  element_sub(x, y, b);
+  EXPECT(prints_as(x, "[4, -2]"));
+  element_sub(x, b, y);
+  EXPECT(prints_as(x, "[-4, 2]"));
+  element_add(x, y, a);
+  EXPECT(prints_as(x, "[[6, 2], 3, [4, [5, 6]]]"));
+  EXPECT(element_cmp(c, b) > 0);
+  EXPECT(element_cmp(b, c) < 0);
+
+  t = list(2, z(3), z(4));
+  element_mul(x, b, t);
+  EXPECT(prints_as(x, "[3, 10, 8]"));
+  d = list(2, list(2, z(1), z(1)), z(1));
+  element_mul(x, d, d);
+  EXPECT(prints_as(x, "[[1, 2, 1], [2, 2], 1]"));
+  element_mul_si(x, a, -2);
+  EXPECT(prints_as(x, "[[-2, -4], -6, [-8, [-10, -12]]]"));
+  element_neg(x, x);
+  element_set_si(y, 2);
+  element_div(x, x, y);
+  EXPECT(!element_cmp(x, a));
+
+  mpz_init_set_ui(p, 1000003);
+  field_init_fp(fp, p);
+  field_init_fi(fq, fp);
+  element_t e;
+  element_init(e, fq);
+  element_set_multiz(e, t->data);
+  element_to_mpz(p, element_x(e));
+  EXPECT(!mpz_cmp_ui(p, 3));
+  element_to_mpz(p, element_y(e));
+  EXPECT(!mpz_cmp_ui(p, 4));
+  element_set_multiz(e, y->data);
+  EXPECT(element_is0(element_y(e)));
+  element_to_mpz(p, element_x(e));
+  EXPECT(!mpz_cmp_ui(p, 2));
+
+  element_clear(e);
+  field_clear(fq);
+  field_clear(fp);
+  mpz_clear(p);
+  element_free(a);
+  element_free(b);
+  element_free(c);
+  element_free(d);
+  element_free(t);
+  element_clear(x);
+  element_clear(y);
+  field_clear(M);
+  return pbc_err_count;
+}
@@ -0,0 +1,111 @@
+// Check that pairings loaded from the binary parameter format agree with
+// the ones loaded from text.
+#include "pbc.h"
+#include "pbc_test.h"
+
+static const char d159[] =
+"type d\n"
+"q 625852803282871856053922297323874661378036491717\n"
+"n 625852803282871856053923088432465995634661283063\n"
+"h 3\n"
+"r 208617601094290618684641029477488665211553761021\n"
+"a 581595782028432961150765424293919699975513269268\n"
+"b 517921465817243828776542439081147840953753552322\n"
+"k 6\n"
+"nk 60094290356408407130984161127310078516360031868417968262992864809623507269833854678414046779817844853757026858774966331434198257512457993293271849043664655146443229029069463392046837830267994222789160047337432075266619082657640364986415435746294498140589844832666082434658532589211525696\n"
+"hk 1380801711862212484403205699005242141541629761433899149236405232528956996854655261075303661691995273080620762287276051361446528504633283152278831183711301329765591450680250000592437612973269056\n"
+"coeff0 472731500571015189154958232321864199355792223347\n"
+"coeff1 352243926696145937581894994871017455453604730246\n"
+"coeff2 289113341693870057212775990719504267185772707305\n"
+"nqr 431211441436589568382088865288592347194866189652\n";
+
+// Returns the binary form of 'param' in a buffer owned by the caller.
+static char *to_bin(pbc_param_t param, size_t *len) {
+  FILE *tmp = tmpfile();
+  EXPECT(!pbc_param_out_bin(tmp, param));
+  *len = ftell(tmp);
+  char *buf = pbc_malloc(*len);
+  rewind(tmp);
+  EXPECT(fread(buf, 1, *len, tmp) == *len);
+  fclose(tmp);
+  return buf;
+}
+
+static void check(pbc_param_t param) {
+  pairing_t text, bin;
+  pbc_param_t param2;
+  element_t P, Q, P2, Q2, a, e0, e1, e2;
+  unsigned char buf[4096];
+  size_t len;
+  char *s = to_bin(param, &len);
+
+  EXPECT(pbc_param_init_set_buf(param2, s, len - 1));
+  EXPECT(!pbc_param_init_set_buf(param2, s, len));
+  pairing_init_pbc_param(text, param);
+  pairing_init_pbc_param(bin, param2);
+  pbc_param_clear(param2);
+  pbc_free(s);
+
+  element_init_G1(P, text);
+  element_init_G2(Q, text);
+  element_init_GT(e0, text);
+  element_init_G1(P2, bin);
+  element_init_G2(Q2, bin);
+  element_init_Zr(a, bin);
+  element_init_GT(e1, bin);
+  element_init_GT(e2, bin);
+
+  // Elements move between the two pairings and pair to the same value.
+  element_random(P);
+  element_random(Q);
+  element_to_bytes(buf, P);
+  element_from_bytes(P2, buf);
+  element_to_bytes(buf, Q);
+  element_from_bytes(Q2, buf);
+  pairing_apply(e0, P, Q, text);
+  pairing_apply(e1, P2, Q2, bin);
+  element_to_bytes(buf, e0);
+  element_from_bytes(e2, buf);
+  EXPECT(!element_cmp(e1, e2));
+
+  // Random elements from the saved generators are usable.
+  element_random(P2);
+  element_random(Q2);
+  element_random(a);
+  pairing_apply(e1, P2, Q2, bin);
+  element_pow_zn(e1, e1, a);
+  element_pow_zn(P2, P2, a);
+  pairing_apply(e2, P2, Q2, bin);
+  EXPECT(!element_cmp(e1, e2));
+  EXPECT(!element_is1(e2));
+
+  element_clear(P);
+  element_clear(Q);
+  element_clear(e0);
+  element_clear(P2);
+  element_clear(Q2);
+  element_clear(a);
+  element_clear(e1);
+  element_clear(e2);
+  pairing_clear(text);
+  pairing_clear(bin);
+}
+
+int main(void) {
+  pbc_param_t param;
+
+  // Type A has no derived constants, only the base parameters.
+  pbc_param_init_a_gen(param, 160, 512);
+  check(param);
+  pbc_param_clear(param);
+
+  EXPECT(!pbc_param_init_set_str(param, d159));
+  check(param);
+  pbc_param_clear(param);
+
+  pbc_param_init_f_gen(param, 160);
+  check(param);
+  pbc_param_clear(param);
+
+  return pbc_err_count;
+}
@@ -31,6 +31,88 @@ int isf(void *data, element_ptr f) {
   return !element_cmp(f, f1);
 }
 
+// Compare products modulo a random monic polynomial of degree n, and
+// products in the polynomial ring, against schoolbook multiplication and
+// long division. Small products are schoolbook already; large ones take
+// the Karatsuba and reduction-by-multiplication paths.
+static void check_mul(field_t fp, field_t fx, int n) {
+  field_t fm;
+  element_t m, a, b, r, e0, e1, f, g, h;
+  element_t c[2 * n - 1];
+  int i, j, fn, gn;
+
+  element_init(m, fx);
+  poly_random_monic(m, n);
+  field_init_polymod(fm, m);
+  element_init(a, fm);
+  element_init(b, fm);
+  element_init(r, fm);
+  element_init(e0, fp);
+  element_init(e1, fp);
+  for (i = 0; i < 2 * n - 1; i++) element_init(c[i], fp);
+  element_random(a);
+  element_random(b);
+
+  for (i = 0; i < 2 * n - 1; i++) element_set0(c[i]);
+  for (i = 0; i < n; i++) for (j = 0; j < n; j++) {
+    element_mul(e0, element_item(a, i), element_item(b, j));
+    element_add(c[i + j], c[i + j], e0);
+  }
+  for (i = 2 * n - 2; i >= n; i--) for (j = 0; j <= n; j++) {
+    element_mul(e0, c[i], element_item(m, j));
+    element_sub(c[i - n + j], c[i - n + j], e0);
+  }
+  element_mul(r, a, b);
+  for (i = 0; i < n; i++) EXPECT(!element_cmp(c[i], element_item(r, i)));
+  element_mul(a, a, b);
+  EXPECT(!element_cmp(a, r));
+
+  // Squares.
+  for (i = 0; i < 2 * n - 1; i++) element_set0(c[i]);
+  for (i = 0; i < n; i++) for (j = 0; j < n; j++) {
+    element_mul(e0, element_item(a, i), element_item(a, j));
+    element_add(c[i + j], c[i + j], e0);
+  }
+  for (i = 2 * n - 2; i >= n; i--) for (j = 0; j <= n; j++) {
+    element_mul(e0, c[i], element_item(m, j));
+    element_sub(c[i - n + j], c[i - n + j], e0);
+  }
+  element_square(r, a);
+  for (i = 0; i < n; i++) EXPECT(!element_cmp(c[i], element_item(r, i)));
+
+  // Unbalanced factors in F_p[x].
+  element_init(f, fx);
+  element_init(g, fx);
+  element_init(h, fx);
+  fn = 2 * n + 1;
+  gn = n / 2 + 1;
+  poly_random_monic(f, fn - 1);
+  poly_random_monic(g, gn - 1);
+  element_mul(h, f, g);
+  EXPECT(poly_degree(h) == fn + gn - 2);
+  for (i = 0; i < fn + gn - 1; i++) {
+    element_set0(e0);
+    for (j = 0; j < gn; j++) {
+      if (i - j < 0 || i - j >= fn) continue;
+      element_mul(e1, element_item(f, i - j), element_item(g, j));
+      element_add(e0, e0, e1);
+    }
+    EXPECT(!element_cmp(e0, element_item(h, i)));
+  }
+
+  element_clear(f);
+  element_clear(g);
+  element_clear(h);
+  for (i = 0; i < 2 * n - 1; i++) element_clear(c[i]);
+  element_clear(a);
+  element_clear(b);
+  element_clear(r);
+  element_clear(e0);
+  element_clear(e1);
+  field_clear(fm);
+  element_clear(m);
+}
+
 int main(void) {
   field_t fp, fx;
   mpz_t prime;
@@ -123,6 +205,9 @@ break2: ;
   }
 break3: ;
 
+  int n;
+  for (n = 2; n <= 40; n++) check_mul(fp, fx, n);
+
   darray_forall(list, elfree);
   darray_forall(prodlist, elfree);
   darray_clear(prodlist);
@@ -0,0 +1,635 @@
+// Test exponentiation of curve points, which runs in Jacobian coordinates,
+// and on curves of type F through an endomorphism, against the affine group
+// operations. Also test the constant-time exponentiations against the
+// plain ones, the exponentiations in GT of types A and A1 against
+// the generic multiplication, and element_pow2_mpz(), element_pow3_mpz()
+// and element_pow_mpz_batch() against separate exponentiations.
+
+#include "pbc.h"
+#include "pbc_fp.h"
+#include "pbc_test.h"
+
+// Square and multiply with the plain group operations, for n >= 0.
+static void naive_pow(element_ptr x, element_ptr a, mpz_t n) {
+  element_t t;
+  int i;
+
+  element_init_same_as(t, a);
+  element_set1(t);
+  for (i = mpz_sizeinbase(n, 2) - 1; i >= 0; i--) {
+    element_square(t, t);
+    if (mpz_tstbit(n, i)) element_mul(t, t, a);
+  }
+  element_set(x, t);
+  element_clear(t);
+}
+
+// a^n for an n of either sign, as the generic element_pow_mpz() takes no
+// negative exponents.
+static void signed_pow(element_ptr x, element_ptr a, mpz_t n) {
+  mpz_t m;
+
+  mpz_init(m);
+  mpz_abs(m, n);
+  element_pow_mpz(x, a, m);
+  if (mpz_sgn(n) < 0) element_invert(x, x);
+  mpz_clear(m);
+}
+
+// element_pow2_mpz() and element_pow3_mpz() against separate
+// exponentiations, with exponents of mixed signs and sizes, zero
+// exponents, the identity as a base, and the result aliasing a base.
+static void check_multi(field_ptr f, mpz_t order) {
+  element_t a[3], x, y, t;
+  mpz_t n[3];
+  int i, j;
+
+  for (j = 0; j < 3; j++) {
+    element_init(a[j], f);
+    element_random(a[j]);
+    mpz_init(n[j]);
+  }
+  element_init(x, f);
+  element_init(y, f);
+  element_init(t, f);
+  for (i = 0; i < 16; i++) {
+    for (j = 0; j < 3; j++) {
+      pbc_mpz_random(n[j], order);
+      if (i & 1 << j) mpz_neg(n[j], n[j]);
+    }
+    if (i == 8) mpz_set_ui(n[1], 0);
+    if (i == 9) mpz_set_ui(n[0], 5);
+    if (i == 10) mpz_mul(n[2], order, order);
+    if (i == 11) element_set1(a[1]);
+    if (i == 12) element_set(a[2], a[0]);
+
+    signed_pow(y, a[0], n[0]);
+    signed_pow(t, a[1], n[1]);
+    element_mul(y, y, t);
+    element_pow2_mpz(x, a[0], n[0], a[1], n[1]);
+    EXPECT(!element_cmp(x, y));
+    signed_pow(t, a[2], n[2]);
+    element_mul(y, y, t);
+    element_pow3_mpz(x, a[0], n[0], a[1], n[1], a[2], n[2]);
+    EXPECT(!element_cmp(x, y));
+    element_set(x, a[1]);
+    element_pow3_mpz(x, a[0], n[0], x, n[1], a[2], n[2]);
+    EXPECT(!element_cmp(x, y));
+    if (i == 11) element_random(a[1]);
+  }
+  for (j = 0; j < 3; j++) {
+    mpz_set_ui(n[j], 0);
+  }
+  element_pow3_mpz(x, a[0], n[0], a[1], n[1], a[2], n[2]);
+  EXPECT(element_is1(x));
+
+  for (j = 0; j < 3; j++) {
+    element_clear(a[j]);
+    mpz_clear(n[j]);
+  }
+  element_clear(x);
+  element_clear(y);
+  element_clear(t);
+}
+
+// element_pow_mpz_batch() against separate exponentiations, for counts
+// below the batching threshold and across chunks, with the identity as a
+// base, repeated bases, zero, small and order-sized exponents, and results
+// overwriting the bases.
+static void check_batch(field_ptr f, mpz_t order) {
+  static const int count[] = { 3, 20, 300 };
+  element_t *a, *x, y;
+  mpz_t *n;
+  int i, j, m;
+
+  element_init(y, f);
+  for (j = 0; j < 3; j++) {
+    m = count[j];
+    a = pbc_malloc(sizeof(element_t) * m);
+    x = pbc_malloc(sizeof(element_t) * m);
+    n = pbc_malloc(sizeof(mpz_t) * m);
+    for (i = 0; i < m; i++) {
+      element_init(a[i], f);
+      element_init(x[i], f);
+      mpz_init(n[i]);
+      element_random(a[i]);
+      pbc_mpz_random(n[i], order);
+    }
+    element_set1(a[1]);
+    element_set(a[2], a[0]);
+    mpz_set_ui(n[0], 0);
+    if (m > 3) {
+      mpz_set_ui(n[3], 1);
+      mpz_set_ui(n[4], 17);
+      mpz_set(n[5], order);
+      mpz_sub_ui(n[6], order, 1);
+      element_set(a[7], a[8]);
+      mpz_set(n[7], n[8]);
+    }
+    element_pow_mpz_batch(x, a, n, m);
+    for (i = 0; i < m; i++) {
+      element_pow_mpz(y, a[i], n[i]);
+      EXPECT(!element_cmp(x[i], y));
+    }
+    element_pow_mpz_batch(a, a, n, m);
+    for (i = 0; i < m; i++) EXPECT(!element_cmp(x[i], a[i]));
+    for (i = 0; i < m; i++) {
+      element_clear(a[i]);
+      element_clear(x[i]);
+      mpz_clear(n[i]);
+    }
+    pbc_free(a);
+    pbc_free(x);
+    pbc_free(n);
+  }
+  element_clear(y);
+}
+
+// One exponent for all the bases, including the identity and repeats:
+// small ones whose recoding is a single digit, and some around the order.
+static void check_same(field_ptr f, mpz_t order) {
+  static const int count[] = { 3, 20, 300 };
+  element_t *a, *x, y;
+  mpz_t n;
+  int i, j, k, m;
+
+  element_init(y, f);
+  mpz_init(n);
+  for (j = 0; j < 3; j++) {
+    m = count[j];
+    a = pbc_malloc(sizeof(element_t) * m);
+    x = pbc_malloc(sizeof(element_t) * m);
+    for (i = 0; i < m; i++) {
+      element_init(a[i], f);
+      element_init(x[i], f);
+      element_random(a[i]);
+    }
+    element_set1(a[1]);
+    element_set(a[2], a[0]);
+    for (k = 0; k < 7; k++) {
+      switch (k) {
+        case 0: mpz_set_ui(n, 0); break;
+        case 1: mpz_set_ui(n, 1); break;
+        case 2: mpz_set_ui(n, 2); break;
+        case 3: mpz_set_ui(n, 17); break;
+        case 4: mpz_set(n, order); break;
+        case 5: mpz_sub_ui(n, order, 1); break;
+        default: pbc_mpz_random(n, order);
+      }
+      element_pow_mpz_same(x, a, n, m);
+      for (i = 0; i < m; i++) {
+        element_pow_mpz(y, a[i], n);
+        EXPECT(!element_cmp(x[i], y));
+      }
+    }
+    element_pow_mpz_same(a, a, n, m);
+    for (i = 0; i < m; i++) EXPECT(!element_cmp(x[i], a[i]));
+    for (i = 0; i < m; i++) {
+      element_clear(a[i]);
+      element_clear(x[i]);
+    }
+    pbc_free(a);
+    pbc_free(x);
+  }
+  mpz_clear(n);
+  element_clear(y);
+}
+
+// Fixed-base tables of each layout and size against plain exponentiation,
+// for exponents around the order and, unless it only bounds the group
+// order ('exact' = 0), beyond it and negative, and the identity as base.
+// Tables are wiped before they are cleared, and the base with them.
+static void check_pp(field_ptr f, mpz_t order, int exact) {
+  static const int strategy[] = { PBC_PP_WINDOW, PBC_PP_COMB, PBC_PP_COMB2 };
+  element_t g, x, y;
+  element_pp_t pp;
+  mpz_t n;
+  int i, k, s;
+
+  element_init(g, f);
+  element_init(x, f);
+  element_init(y, f);
+  mpz_init(n);
+  for (s = 0; s < 3; s++) {
+    for (k = 1; k <= 8; k++) {
+      element_random(g);
+      if (k == 3) element_set1(g);
+      element_pp_init_ex(pp, g, k, strategy[s]);
+      for (i = 0; i < 8; i++) {
+        pbc_mpz_random(n, order);
+        if (i == 0) mpz_set_ui(n, 1);
+        if (i == 1) mpz_set_ui(n, 0);
+        if (i == 2) mpz_sub_ui(n, order, 1);
+        if (i == 3) mpz_set(n, order);
+        if (i == 4) mpz_mul_ui(n, order, 3);
+        if (i == 5) mpz_neg(n, n);
+        if (i == 6) mpz_add_ui(n, n, 1);
+        if (!exact && i >= 4 && i <= 6) continue;
+        element_pp_pow(x, n, pp);
+        signed_pow(y, g, n);
+        EXPECT(!element_cmp(x, y));
+      }
+      element_pp_wipe(pp);
+      element_pp_clear(pp);
+      element_wipe(g);
+      EXPECT(element_is0(g));
+    }
+  }
+  element_clear(g);
+  element_clear(x);
+  element_clear(y);
+  mpz_clear(n);
+}
+
+static void check_curve(field_ptr f) {
+  element_t p, q, r, s;
+  element_pp_t pp;
+  mpz_t n, zero;
+  int i;
+
+  element_init(p, f);
+  element_init(q, f);
+  element_init(r, f);
+  element_init(s, f);
+  mpz_init(n);
+  element_random(p);
+
+  // Small exponents, including those with narrow windows, against
+  // repeated addition.
+  element_set1(r);
+  for (i = 0; i < 80; i++) {
+    mpz_set_ui(n, i);
+    element_pow_mpz(q, p, n);
+    EXPECT(!element_cmp(q, r));
+    element_pow_mpz_ct(q, p, n);
+    EXPECT(!element_cmp(q, r));
+    element_mul(r, r, p);
+  }
+
+  // Large exponents against affine square and multiply, and against
+  // element_pow2_mpz() with the identity as second base.
+  mpz_init(zero);
+  element_set0(s);
+  for (i = 0; i < 10; i++) {
+    pbc_mpz_random(n, f->order);
+    if (i == 0) mpz_set(n, f->order);
+    if (i == 1) mpz_sub_ui(n, f->order, 1);
+    element_pow_mpz(q, p, n);
+    naive_pow(r, p, n);
+    EXPECT(!element_cmp(q, r));
+    element_pow2_mpz(r, p, n, s, zero);
+    EXPECT(!element_cmp(q, r));
+    // In place, and negative exponents.
+    element_set(r, p);
+    element_pow_mpz(r, r, n);
+    EXPECT(!element_cmp(q, r));
+    element_pow_mpz_ct(r, p, n);
+    EXPECT(!element_cmp(q, r));
+    mpz_neg(n, n);
+    element_pow_mpz(r, p, n);
+    element_mul(r, r, q);
+    EXPECT(element_is0(r));
+    element_pow_mpz_ct(r, p, n);
+    element_mul(r, r, q);
+    EXPECT(element_is0(r));
+  }
+  // Exponents longer than the order.
+  mpz_mul(n, f->order, f->order);
+  mpz_add_ui(n, n, 12345);
+  element_pow_mpz(q, p, n);
+  element_pow_mpz_ct(r, p, n);
+  EXPECT(!element_cmp(q, r));
+  mpz_clear(zero);
+
+  // The identity as base.
+  element_set0(r);
+  pbc_mpz_random(n, f->order);
+  element_pow_mpz(q, r, n);
+  EXPECT(element_is0(q));
+  element_pp_init(pp, r);
+  element_pp_pow(q, n, pp);
+  EXPECT(element_is0(q));
+  element_pp_clear(pp);
+
+  check_multi(f, f->order);
+  check_batch(f, f->order);
+  check_same(f, f->order);
+
+  element_clear(p);
+  element_clear(q);
+  element_clear(r);
+  element_clear(s);
+  mpz_clear(n);
+}
+
+// n a by plain double-and-add, which trusts nothing about a.
+static void naive_mul(element_t x, element_t a, mpz_t n) {
+  int i;
+  element_set0(x);
+  for (i = mpz_sizeinbase(n, 2) - 1; i >= 0; i--) {
+    element_double(x, x);
+    if (mpz_tstbit(n, i)) element_add(x, x, a);
+  }
+}
+
+// Random elements of G1, G2 and GT pass, and so does the identity.
+// Elements read from random bytes pass exactly when the order kills
+// them: points of G1 decompressed from random x-coordinates, off the
+// curve for about half of them, and units of the field holding GT.
+static void check_subgroup(pairing_t pairing) {
+  enum { N = 24 };
+  field_ptr g[3] = { pairing->G1, pairing->G2, pairing->GT };
+  element_t a[N], t;
+  char ok[N];
+  unsigned char *buf;
+  int i, j, k, len, expect;
+
+  for (j = 0; j < 3; j++) {
+    for (i = 0; i < N; i++) {
+      element_init(a[i], g[j]);
+      element_random(a[i]);
+    }
+    element_set0(a[1]);
+    EXPECT(element_is_in_subgroup(a[0]));
+    EXPECT(element_is_in_subgroup(a[1]));
+    EXPECT(element_is_in_subgroup_batch(ok, a, N) == N);
+    for (i = 0; i < N; i++) EXPECT(ok[i]);
+    for (i = 0; i < N; i++) element_clear(a[i]);
+  }
+
+  for (j = 0; j < 3; j += 2) {
+    element_init(t, g[j]);
+    len = j ? element_length_in_bytes(t) : element_length_in_bytes_compressed(t);
+    buf = pbc_malloc(len);
+    expect = 0;
+    for (i = 0; i < N; i++) {
+      element_init(a[i], g[j]);
+      for (k = 0; k < len; k++) buf[k] = rand();
+      if (j) {
+        element_from_bytes(a[i], buf);
+      } else {
+        buf[0] = 0;  // x below q
+        element_from_bytes_compressed(a[i], buf);
+      }
+      // The naive product trusts the representation, so only points that
+      // survive a round trip through the checked decoder get one.
+      if (j) {
+        naive_mul(t, a[i], g[j]->order);
+        k = element_is0(t);
+      } else {
+        unsigned char *raw = pbc_malloc(element_length_in_bytes(t));
+        element_to_bytes(raw, a[i]);
+        element_from_bytes(t, raw);
+        k = !element_is0(t);
+        pbc_free(raw);
+        if (k) {
+          naive_mul(t, a[i], g[j]->order);
+          k = element_is0(t);
+        }
+      }
+      EXPECT(element_is_in_subgroup(a[i]) == k);
+      expect += k;
+    }
+    EXPECT(element_is_in_subgroup_batch(ok, a, N) == expect);
+    for (i = 0; i < N; i++) {
+      EXPECT(ok[i] == element_is_in_subgroup(a[i]));
+      element_clear(a[i]);
+    }
+    pbc_free(buf);
+    element_clear(t);
+  }
+}
+
+// Exponents around multiples of the order, which an endomorphism splits
+// into halves that cancel. Only for groups whose order is known.
+static void check_order(field_ptr f) {
+  element_t p, q;
+  mpz_t n;
+  int i;
+
+  element_init(p, f);
+  element_init(q, f);
+  mpz_init(n);
+  element_random(p);
+  for (i = 0; i < 3; i++) {
+    mpz_mul_ui(n, f->order, i + 1);
+    element_pow_mpz(q, p, n);
+    EXPECT(element_is0(q));
+    mpz_add_ui(n, n, 1);
+    element_pow_mpz(q, p, n);
+    EXPECT(!element_cmp(q, p));
+    mpz_sub_ui(n, n, 2);
+    element_pow_mpz(q, p, n);
+    element_mul(q, q, p);
+    EXPECT(element_is0(q));
+  }
+  element_clear(p);
+  element_clear(q);
+  mpz_clear(n);
+}
+
+// The generic constant-time exponentiation, in a field with masked moves.
+static void check_generic_ct(field_ptr f) {
+  element_t a, x, y;
+  mpz_t n;
+  int i;
+
+  element_init(a, f);
+  element_init(x, f);
+  element_init(y, f);
+  mpz_init(n);
+  element_random(a);
+  for (i = 0; i < 20; i++) {
+    pbc_mpz_random(n, f->order);
+    if (i < 4) mpz_set_ui(n, i);
+    if (i == 4) mpz_set(n, f->order);
+    element_pow_mpz(x, a, n);
+    element_pow_mpz_ct(y, a, n);
+    EXPECT(!element_cmp(x, y));
+  }
+  // The generic element_pow_mpz() takes no negative exponents.
+  mpz_neg(n, n);
+  element_pow_mpz_ct(y, a, n);
+  element_mul(y, y, x);
+  EXPECT(element_is1(y));
+  mpz_neg(n, n);
+  // In place, and the masked move both ways.
+  element_set(y, a);
+  element_pow_mpz_ct(y, y, n);
+  EXPECT(!element_cmp(x, y));
+  element_cmov(y, a, 0);
+  EXPECT(!element_cmp(x, y));
+  element_cmov(y, a, 1);
+  EXPECT(!element_cmp(a, y));
+  element_clear(a);
+  element_clear(x);
+  element_clear(y);
+  mpz_clear(n);
+}
+
+// Exponentiations in GT, which for types A and A1 run in the subgroup of
+// norm 1 of F_q^2.
+static void check_gt(pairing_t pairing) {
+  element_t g, h, a, x, y, z;
+  mpz_t n, one;
+  int i;
+
+  element_init_G1(g, pairing);
+  element_init_G2(h, pairing);
+  element_init_GT(a, pairing);
+  element_init_GT(x, pairing);
+  element_init_GT(y, pairing);
+  element_init_GT(z, pairing);
+  mpz_init(n);
+  mpz_init_set_ui(one, 1);
+  element_random(g);
+  element_random(h);
+  element_pairing(a, g, h);
+
+  element_set1(y);
+  for (i = 0; i < 70; i++) {
+    mpz_set_ui(n, i);
+    element_pow_mpz(x, a, n);
+    EXPECT(!element_cmp(x, y));
+    element_pow_mpz_ct(x, a, n);
+    EXPECT(!element_cmp(x, y));
+    element_mul(y, y, a);
+  }
+
+  // Against generic square and multiply, and element_pow2_mpz() with 1
+  // as second base.
+  element_set1(z);
+  for (i = 0; i < 10; i++) {
+    pbc_mpz_random(n, pairing->r);
+    if (i == 0) mpz_set(n, pairing->r);
+    if (i == 1) mpz_sub_ui(n, pairing->r, 1);
+    if (i == 2) mpz_mul(n, pairing->r, pairing->r);
+    element_pow_mpz(x, a, n);
+    naive_pow(y, a, n);
+    EXPECT(!element_cmp(x, y));
+    element_pow2_mpz(y, a, n, z, one);
+    EXPECT(!element_cmp(x, y));
+    element_pow_mpz_ct(y, a, n);
+    EXPECT(!element_cmp(x, y));
+    // In place, and negative exponents.
+    element_set(y, a);
+    element_pow_mpz(y, y, n);
+    EXPECT(!element_cmp(x, y));
+    element_set(y, a);
+    element_pow_mpz_ct(y, y, n);
+    EXPECT(!element_cmp(x, y));
+    mpz_neg(n, n);
+    element_pow_mpz(y, a, n);
+    element_mul(y, y, x);
+    EXPECT(element_is1(y));
+    element_pow_mpz_ct(y, a, n);
+    element_mul(y, y, x);
+    EXPECT(element_is1(y));
+    mpz_neg(n, n);
+  }
+
+  // Bases awaiting the final exponentiation.
+  pairing_apply_unreduced(y, g, h, pairing);
+  element_pow_mpz(z, y, n);
+  EXPECT(!element_cmp(x, z));
+  pairing_apply_unreduced(y, g, h, pairing);
+  element_pow_mpz_ct(z, y, n);
+  EXPECT(!element_cmp(x, z));
+
+  check_pp(pairing->GT, pairing->r, 1);
+  check_multi(pairing->GT, pairing->r);
+  check_batch(pairing->GT, pairing->r);
+  check_same(pairing->GT, pairing->r);
+
+  element_clear(g);
+  element_clear(h);
+  element_clear(a);
+  element_clear(x);
+  element_clear(y);
+  element_clear(z);
+  mpz_clear(n);
+  mpz_clear(one);
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  field_t fp, curve;
+  element_t a, b;
+  mpz_t prime, order;
+  int i;
+
+  mpz_init(prime);
+  mpz_init(order);
+  // a = 1.
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+  check_curve(pairing->G1);
+  check_order(pairing->G1);
+  check_pp(pairing->G1, pairing->r, 1);
+  check_gt(pairing);
+  check_subgroup(pairing);
+  check_multi(pairing->Zr, pairing->r);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  // The composite order of A1, a product of two primes.
+  mpz_setbit(prime, 80);
+  mpz_nextprime(prime, prime);
+  mpz_setbit(order, 90);
+  mpz_nextprime(order, order);
+  mpz_mul(order, order, prime);
+  pbc_param_init_a1_gen(param, order);
+  pairing_init_pbc_param(pairing, param);
+  check_gt(pairing);
+  check_subgroup(pairing);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  // a = 0, with an endomorphism on G1, and a curve over F_q^2. Curve
+  // sizes vary how the exponents split.
+  for (i = 0; i < 3; i++) {
+    pbc_param_init_f_gen(param, 160 + 48 * i);
+    pairing_init_pbc_param(pairing, param);
+    check_curve(pairing->G1);
+    check_order(pairing->G1);
+    if (!i) {
+      check_pp(pairing->G1, pairing->r, 1);
+      check_curve(pairing->G2);
+      check_generic_ct(pairing->GT);
+      check_pp(pairing->GT, pairing->r, 1);
+      check_multi(pairing->GT, pairing->r);
+      check_subgroup(pairing);
+    }
+    pairing_clear(pairing);
+    pbc_param_clear(param);
+  }
+
+  // A general a, on a curve of unknown order. The 511-bit prime takes
+  // the direct path of arith/montfp.h, as type A does.
+  for (i = 0; i < 2; i++) {
+    mpz_set_ui(prime, 0);
+    mpz_setbit(prime, i ? 510 : 255);
+    mpz_nextprime(prime, prime);
+    mpz_set(order, prime);
+    field_init_fp(fp, prime);
+    element_init(a, fp);
+    element_init(b, fp);
+    element_set_si(a, -3);
+    element_random(b);
+    field_init_curve_ab(curve, a, b, order, NULL);
+    check_curve(curve);
+    check_pp(curve, order, 0);
+    element_random(a);
+    field_clear(curve);
+    field_init_curve_ab(curve, a, b, order, NULL);
+    check_curve(curve);
+    field_clear(curve);
+    element_clear(a);
+    element_clear(b);
+    field_clear(fp);
+  }
+  mpz_clear(prime);
+  mpz_clear(order);
+  return pbc_err_count;
+}
@@ -0,0 +1,185 @@
+// Test pairing_pp_to_bytes() and pairing_pp_from_bytes(), and the same for
+// element_pp_t: tables read back give the same pairings or powers and bytes
+// as those they were written from.
+
+#include <string.h>
+#include "pbc.h"
+#include "pbc_test.h"
+
+// Tables written under 'method' are refused under 'other'.
+static void check_pp_bytes(pairing_t pairing, char *method, char *other) {
+  element_t g, h, x, y;
+  pairing_pp_t p, q;
+  unsigned char *data, *copy;
+  int len, i;
+
+  pairing_option_set(pairing, "method", method);
+  len = pairing_pp_length_in_bytes(pairing);
+  EXPECT(len > 0);
+  element_init_G1(g, pairing);
+  element_init_G2(h, pairing);
+  element_init_GT(x, pairing);
+  element_init_GT(y, pairing);
+  data = pbc_malloc(len);
+  copy = pbc_malloc(len);
+
+  element_random(g);
+  pairing_pp_init(p, g, pairing);
+  EXPECT(pairing_pp_to_bytes(data, p, pairing) == len);
+  EXPECT(pairing_pp_from_bytes(q, data, pairing) == len);
+  for (i = 0; i < 3; i++) {
+    element_random(h);
+    pairing_apply(x, g, h, pairing);
+    pairing_pp_apply(y, h, q);
+    EXPECT(!element_cmp(x, y));
+    pairing_pp_apply_unreduced(y, h, q);
+    EXPECT(!element_cmp(x, y));
+  }
+  EXPECT(pairing_pp_to_bytes(copy, q, pairing) == len);
+  EXPECT(!memcmp(data, copy, len));
+  pairing_pp_clear(q);
+
+  // Damaged headers are refused.
+  data[0] = 2;
+  EXPECT(!pairing_pp_from_bytes(q, data, pairing));
+  data[0] = 1;
+  data[1]++;
+  EXPECT(!pairing_pp_from_bytes(q, data, pairing));
+  data[1]--;
+  data[5] ^= 1;
+  EXPECT(!pairing_pp_from_bytes(q, data, pairing));
+  data[5] ^= 1;
+
+  // The identity.
+  element_set0(g);
+  pairing_pp_clear(p);
+  pairing_pp_init(p, g, pairing);
+  EXPECT(pairing_pp_to_bytes(copy, p, pairing) == len);
+  EXPECT(pairing_pp_from_bytes(q, copy, pairing) == len);
+  pairing_pp_apply(y, h, q);
+  EXPECT(element_is1(y));
+  pairing_pp_clear(q);
+  pairing_pp_clear(p);
+
+  pairing_option_set(pairing, "method", other);
+  EXPECT(!pairing_pp_from_bytes(q, data, pairing));
+  pairing_option_set(pairing, "method", method);
+  EXPECT(pairing_pp_from_bytes(q, data, pairing) == len);
+  pairing_pp_clear(q);
+
+  pbc_free(data);
+  pbc_free(copy);
+  element_clear(g);
+  element_clear(h);
+  element_clear(x);
+  element_clear(y);
+}
+
+// Fixed-base tables of every layout, of a curve and of a generic field.
+static void check_element_pp_bytes(field_ptr f) {
+  static const int strategy[] = { PBC_PP_WINDOW, PBC_PP_COMB, PBC_PP_COMB2 };
+  element_t a, x, y;
+  element_pp_t p, q;
+  unsigned char *data, *copy;
+  mpz_t n;
+  int len, i, j;
+
+  element_init(a, f);
+  element_init(x, f);
+  element_init(y, f);
+  mpz_init(n);
+  element_random(a);
+  for (i = 0; i < 3; i++) {
+    element_pp_init_ex(p, a, 4, strategy[i]);
+    len = element_pp_length_in_bytes(p);
+    EXPECT(len > 0);
+    data = pbc_malloc(len);
+    copy = pbc_malloc(len);
+    EXPECT(element_pp_to_bytes(data, p) == len);
+    EXPECT(element_pp_from_bytes(q, a, data) == len);
+    for (j = 0; j < 3; j++) {
+      pbc_mpz_random(n, f->order);
+      element_pp_pow(x, n, p);
+      element_pp_pow(y, n, q);
+      EXPECT(!element_cmp(x, y));
+      element_pow_mpz(y, a, n);
+      EXPECT(!element_cmp(x, y));
+    }
+    EXPECT(element_pp_to_bytes(copy, q) == len);
+    EXPECT(!memcmp(data, copy, len));
+    element_pp_clear(q);
+
+    // Damaged headers are refused.
+    data[0] = 2;
+    EXPECT(!element_pp_from_bytes(q, a, data));
+    data[0] = 1;
+    data[2] = 7;
+    EXPECT(!element_pp_from_bytes(q, a, data));
+    data[2] = strategy[i];
+    data[3] = 0;
+    EXPECT(!element_pp_from_bytes(q, a, data));
+
+    // So are tables of another base.
+    element_random(y);
+    EXPECT(!element_pp_from_bytes(q, y, copy));
+    pbc_free(data);
+    pbc_free(copy);
+    element_pp_clear(p);
+  }
+  mpz_clear(n);
+  element_clear(a);
+  element_clear(x);
+  element_clear(y);
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  mpz_t n, t;
+
+  pbc_param_init_a_gen(param, 160, 512);
+  pairing_init_pbc_param(pairing, param);
+  EXPECT(pairing_pp_is_precomputed(pairing));
+  check_pp_bytes(pairing, "miller", "shipsey-stange");
+  check_pp_bytes(pairing, "shipsey-stange", "miller");
+  check_element_pp_bytes(pairing->G1);
+  check_element_pp_bytes(pairing->Zr);
+  {
+    // GT keeps its tables in another form.
+    element_t x;
+    element_pp_t p;
+    element_init_GT(x, pairing);
+    element_random(x);
+    element_pp_init(p, x);
+    EXPECT(!element_pp_length_in_bytes(p));
+    element_pp_clear(p);
+    element_clear(x);
+  }
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  mpz_init(n);
+  mpz_init(t);
+  mpz_setbit(n, 80);
+  mpz_nextprime(n, n);
+  mpz_setbit(t, 90);
+  mpz_nextprime(t, t);
+  mpz_mul(n, n, t);
+  pbc_param_init_a1_gen(param, n);
+  pairing_init_pbc_param(pairing, param);
+  check_pp_bytes(pairing, "miller", "shipsey-stange");
+  check_pp_bytes(pairing, "shipsey-stange", "miller");
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  mpz_clear(n);
+  mpz_clear(t);
+
+  // Other types keep their tables in memory only; type F has none.
+  pbc_param_init_f_gen(param, 160);
+  pairing_init_pbc_param(pairing, param);
+  EXPECT(!pairing_pp_length_in_bytes(pairing));
+  EXPECT(!pairing_pp_is_precomputed(pairing));
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
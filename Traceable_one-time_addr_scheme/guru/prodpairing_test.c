@@ -1,44 +1,127 @@
-// Check product of pairings works for F pairings when initialized via
-// pairing_init_pbc_param().
+// Check product of pairings agrees with the product of single pairings
+// for each pairing type, including when some inputs are the identity.
 //
 // By Michael Adjedj, Ben Lynn.
 #include "pbc.h"
 #include "pbc_test.h"
 
-int main(void) {
-  pbc_param_t param;
+static const char d159[] =
+"type d\n"
+"q 625852803282871856053922297323874661378036491717\n"
+"n 625852803282871856053923088432465995634661283063\n"
+"h 3\n"
+"r 208617601094290618684641029477488665211553761021\n"
+"a 581595782028432961150765424293919699975513269268\n"
+"b 517921465817243828776542439081147840953753552322\n"
+"k 6\n"
+"nk 60094290356408407130984161127310078516360031868417968262992864809623507269833854678414046779817844853757026858774966331434198257512457993293271849043664655146443229029069463392046837830267994222789160047337432075266619082657640364986415435746294498140589844832666082434658532589211525696\n"
+"hk 1380801711862212484403205699005242141541629761433899149236405232528956996854655261075303661691995273080620762287276051361446528504633283152278831183711301329765591450680250000592437612973269056\n"
+"coeff0 472731500571015189154958232321864199355792223347\n"
+"coeff1 352243926696145937581894994871017455453604730246\n"
+"coeff2 289113341693870057212775990719504267185772707305\n"
+"nqr 431211441436589568382088865288592347194866189652\n";
 
-  pbc_param_init_f_gen(param, 200);
-  pairing_t pairing;
-  pairing_init_pbc_param(pairing, param);
-
-  element_t P[2], Q[2], res, tmp, tmp2;
+static const char g149[] =
+"type g\n"
+"q 503189899097385532598615948567975432740967203\n"
+"n 503189899097385532598571084778608176410973351\n"
+"h 1\n"
+"r 503189899097385532598571084778608176410973351\n"
+"a 465197998498440909244782433627180757481058321\n"
+"b 463074517126110479409374670871346701448503064\n"
+"k 10\n"
+"nk 1040684643531490707494989587381629956832530311976146077888095795458709511789670022388326295177424065807612879371896982185473788988016190582073591316127396374860265835641044035656044524481121528846249501655527462202999638159773731830375673076317719519977183373353791119388388468745670818193868532404392452816602538968163226713846951514831917487400267590451867746120591750902040267826351982737642689423713163967384383105678367875981348397359466338807\n"
+"hk 4110127713690841149713310614420858884651261781185442551927080083178682965171097172366598236129731931693425629387502221804555636704708008882811353539555915064049685663790355716130262332064327767695339422323460458479884756000782939428852120522712008037615051139080628734566850259704397643028017435446110322024094259858170303605703280329322675124728639532674407\n"
+"coeff0 67343110967802947677845897216565803152319250\n"
+"coeff1 115936772834120270862756636148166314916823221\n"
+"coeff2 87387877425076080433559927080662339215696505\n"
+"coeff3 433223145899090928132052677121692683015058909\n"
+"coeff4 405367866213598664862417230702935310328613596\n"
+"nqr 22204504160560785687198080413579021865783099\n";
 
-  element_init_G1(P[0], pairing);  element_random(P[0]);
-  element_init_G1(P[1], pairing);  element_random(P[1]);
+enum { N = 3 };
 
-  element_init_G2(Q[0], pairing);  element_random(Q[0]);
-  element_init_G2(Q[1], pairing);  element_random(Q[1]);
+static void check(pbc_param_t param) {
+  pairing_t pairing;
+  element_t P[N], Q[N], res, tmp, tmp2;
+  int i, n;
 
+  pairing_init_pbc_param(pairing, param);
+  for (i = 0; i < N; i++) {
+    element_init_G1(P[i], pairing);
+    element_init_G2(Q[i], pairing);
+    element_random(P[i]);
+    element_random(Q[i]);
+  }
   element_init_GT(res, pairing);
   element_init_GT(tmp, pairing);
   element_init_GT(tmp2, pairing);
 
-  element_prod_pairing(res, P, Q, 2);
-  element_pairing(tmp, P[0], Q[0]);
-  element_pairing(tmp2, P[1], Q[1]);
-  element_mul(tmp, tmp, tmp2);
+  for (n = 1; n <= N; n++) {
+    element_prod_pairing(res, P, Q, n);
+    element_set1(tmp);
+    for (i = 0; i < n; i++) {
+      element_pairing(tmp2, P[i], Q[i]);
+      element_mul(tmp, tmp, tmp2);
+    }
+    EXPECT(!element_cmp(res, tmp));
+  }
+
+  // Pairs with an identity input drop out of the product.
+  element_pairing(tmp, P[1], Q[1]);
+  element_set0(P[0]);
+  element_set0(Q[2]);
+  element_prod_pairing(res, P, Q, N);
   EXPECT(!element_cmp(res, tmp));
+  element_set0(P[1]);
+  element_prod_pairing(res, P, Q, N);
+  EXPECT(element_is1(res));
 
-  element_clear(P[0]);
-  element_clear(P[1]);
-  element_clear(Q[0]);
-  element_clear(Q[1]);
+  for (i = 0; i < N; i++) {
+    element_clear(P[i]);
+    element_clear(Q[i]);
+  }
   element_clear(res);
   element_clear(tmp);
   element_clear(tmp2);
-
   pairing_clear(pairing);
+}
+
+int main(void) {
+  pbc_param_t param;
+  mpz_t n, t;
+
+  pbc_param_init_a_gen(param, 160, 512);
+  check(param);
+  pbc_param_clear(param);
+
+  mpz_init(n);
+  mpz_init(t);
+  mpz_setbit(n, 80);
+  mpz_nextprime(n, n);
+  mpz_setbit(t, 90);
+  mpz_nextprime(t, t);
+  mpz_mul(n, n, t);
+  pbc_param_init_a1_gen(param, n);
+  check(param);
+  pbc_param_clear(param);
+  mpz_clear(n);
+  mpz_clear(t);
+
+  EXPECT(!pbc_param_init_set_str(param, d159));
+  check(param);
+  pbc_param_clear(param);
+
+  pbc_param_init_e_gen(param, 160, 1024);
+  check(param);
+  pbc_param_clear(param);
+
+  pbc_param_init_f_gen(param, 200);
+  check(param);
+  pbc_param_clear(param);
+
+  EXPECT(!pbc_param_init_set_str(param, g149));
+  check(param);
   pbc_param_clear(param);
-  return 0;
+  return pbc_err_count;
 }
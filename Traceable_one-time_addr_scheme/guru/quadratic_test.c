@@ -5,8 +5,73 @@
 #include "pbc_fieldquadratic.h"
 #include "pbc_test.h"
 
+// Compares products, squares and inverses in f = K[sqrt(nqr)] with the
+// schoolbook formulas evaluated in K. Over a 512-bit Montgomery field
+// these run on the limbs, with lazy reduction.
+static void check_arith(field_ptr f, element_ptr nqr) {
+  element_t a, b, c, d, t0, t1;
+  int i;
+
+  element_init(a, f);
+  element_init(b, f);
+  element_init(c, f);
+  element_init(d, f);
+  element_init(t0, nqr->field);
+  element_init(t1, nqr->field);
+  for (i = 0; i < 200; i++) {
+    element_random(a);
+    // Zero, negations, equal operands and coefficients of -1 hit the edge
+    // cases of the unreduced sums.
+    switch (i % 6) {
+      case 0: element_set0(b); break;
+      case 1: element_neg(b, a); break;
+      case 2: element_set(b, a); break;
+      case 3:
+        element_set_si(element_x(a), -1);
+        element_set_si(element_y(a), -1);
+        element_set(b, a);
+        break;
+      case 4:
+        element_set_si(element_x(b), -1);
+        element_set_si(element_y(b), -1);
+        break;
+      default: element_random(b);
+    }
+    element_mul(t0, element_x(a), element_x(b));
+    element_mul(t1, element_y(a), element_y(b));
+    element_mul(t1, t1, nqr);
+    element_add(element_x(d), t0, t1);
+    element_mul(t0, element_x(a), element_y(b));
+    element_mul(t1, element_y(a), element_x(b));
+    element_add(element_y(d), t0, t1);
+
+    element_mul(c, a, b);
+    EXPECT(!element_cmp(c, d));
+    element_set(c, a);
+    element_mul(c, c, b);
+    EXPECT(!element_cmp(c, d));
+
+    element_mul(d, a, a);
+    element_square(c, a);
+    EXPECT(!element_cmp(c, d));
+
+    if (!element_is0(a)) {
+      element_invert(c, a);
+      element_mul(c, c, a);
+      EXPECT(element_is1(c));
+    }
+  }
+  element_clear(a);
+  element_clear(b);
+  element_clear(c);
+  element_clear(d);
+  element_clear(t0);
+  element_clear(t1);
+}
+
 int main(void) {
-  field_t fp, fp2;
+  field_t fp, fp2, fm, fq, fn;
+  element_t minus1;
   mpz_t prime;
   element_t a, b, c;
 
@@ -55,8 +120,45 @@ int main(void) {
   element_clear(a);
   element_clear(b);
   element_clear(c);
+
+  element_init(minus1, fp);
+  element_set_si(minus1, -1);
+  check_arith(fp2, minus1);
+  element_clear(minus1);
+  field_clear(fp2);
   field_clear(fp);
+
+  // Base fields that do not pack their elements.
+  field_init_naive_fp(fn, prime);
+  field_init_fi(fp2, fn);
+  element_init(minus1, fn);
+  element_set_si(minus1, -1);
+  check_arith(fp2, minus1);
+  element_clear(minus1);
+  field_clear(fp2);
+  field_clear(fn);
+
+  // A 512-bit prime just below 2^512 leaves the least room for unreduced
+  // sums, as 2p exceeds the Montgomery radix.
+  mpz_set_ui(prime, 0);
+  mpz_setbit(prime, 512);
+  mpz_sub_ui(prime, prime, 1);
+  mpz_clrbit(prime, 300);
+  do {
+    mpz_nextprime(prime, prime);
+  } while (mpz_fdiv_ui(prime, 4) != 3);
+  field_init_mont_fp(fm, prime);
+  field_init_fi(fp2, fm);
+  field_init_quadratic(fq, fm);
+  element_init(minus1, fm);
+  element_set_si(minus1, -1);
+  check_arith(fp2, minus1);
+  check_arith(fq, field_get_nqr(fm));
+  element_clear(minus1);
+  field_clear(fq);
   field_clear(fp2);
+  field_clear(fm);
+
   mpz_clear(prime);
-  return 0;
+  return pbc_err_count;
 }
@@ -0,0 +1,129 @@
+// Test per-context random sources.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "pbc.h"
+#include "pbc_test.h"
+
+static mpz_t limit;
+
+// Draws from a thread-bound deterministic context.
+static void *draw_in_thread(void *arg) {
+  mpz_ptr out = arg;
+  pbc_random_ctx_t ctx;
+  pbc_random_ctx_init_deterministic(ctx, 7);
+  pbc_random_ctx_bind(ctx);
+  pbc_mpz_random(out, limit);
+  pbc_random_ctx_clear(ctx);
+  return NULL;
+}
+
+enum { SHARED_DRAWS = 200000 };
+
+// Draws 64-bit values from the global source, shared with other threads.
+static void *draw_shared(void *arg) {
+  unsigned long *out = arg;
+  mpz_t z;
+  int i;
+  mpz_init(z);
+  for (i = 0; i < SHARED_DRAWS; i++) {
+    pbc_mpz_randomb(z, 64);
+    out[i] = mpz_get_ui(z);
+  }
+  mpz_clear(z);
+  return NULL;
+}
+
+static int cmp_ulong(const void *a, const void *b) {
+  unsigned long x = *(const unsigned long *) a, y = *(const unsigned long *) b;
+  return x < y ? -1 : x > y;
+}
+
+int main(void) {
+  pbc_random_ctx_t c1, c2, cf;
+  mpz_t x, y, w;
+  pthread_t t;
+  int i;
+
+  mpz_init(x);
+  mpz_init(y);
+  mpz_init(w);
+  mpz_init(limit);
+  mpz_set_ui(limit, 1);
+  mpz_mul_2exp(limit, limit, 160);
+  mpz_sub_ui(limit, limit, 47);
+
+  // Same seed, same stream.
+  pbc_random_ctx_init_deterministic(c1, 7);
+  pbc_random_ctx_init_deterministic(c2, 7);
+  for (i = 0; i < 10; i++) {
+    pbc_random_ctx_mpz_random(c1, x, limit);
+    pbc_random_ctx_mpz_random(c2, y, limit);
+    EXPECT(!mpz_cmp(x, y));
+    EXPECT(mpz_cmp(x, limit) < 0);
+  }
+
+  // Binding redirects pbc_mpz_random in this thread only.
+  pbc_random_ctx_clear(c1);
+  pbc_random_ctx_init_deterministic(c1, 7);
+  pbc_random_ctx_clear(c2);
+  pbc_random_ctx_init_deterministic(c2, 7);
+  EXPECT(pbc_random_ctx_bind(c1) == NULL);
+  pbc_mpz_random(x, limit);
+  pbc_random_ctx_mpz_random(c2, y, limit);
+  EXPECT(!mpz_cmp(x, y));
+  pthread_create(&t, NULL, draw_in_thread, w);
+  pthread_join(t, NULL);
+  pbc_random_ctx_mpz_random(c2, y, limit);
+  EXPECT(!mpz_cmp(w, x));
+  pbc_mpz_random(x, limit);
+  EXPECT(!mpz_cmp(x, y));
+  EXPECT(pbc_random_ctx_bind(NULL) == c1);
+
+  // Buffered file source stays in range.
+  if (!pbc_random_ctx_init_file(cf, "/dev/urandom")) {
+    for (i = 0; i < 1000; i++) {
+      pbc_random_ctx_mpz_random(cf, x, limit);
+      EXPECT(mpz_cmp(x, limit) < 0);
+    }
+    pbc_random_ctx_clear(cf);
+  }
+  EXPECT(pbc_random_ctx_init_file(cf, "/nonexistent/random") == -1);
+
+  // Operating system source, per context and as the global source.
+  EXPECT(!pbc_random_ctx_init_os(cf));
+  for (i = 0; i < 1000; i++) {
+    pbc_random_ctx_mpz_random(cf, x, limit);
+    EXPECT(mpz_cmp(x, limit) < 0);
+  }
+  pbc_random_ctx_clear(cf);
+  EXPECT(!pbc_random_set_os());
+  EXPECT(!pbc_random_set_os());
+  for (i = 0; i < 1000; i++) {
+    pbc_mpz_random(x, limit);
+    EXPECT(mpz_cmp(x, limit) < 0);
+  }
+  pbc_mpz_random(y, limit);
+  EXPECT(mpz_cmp(x, y));
+
+  // Threads sharing the global source never get the same bytes.
+  {
+    unsigned long *v = malloc(2 * SHARED_DRAWS * sizeof(*v));
+    pthread_t t2;
+    pthread_create(&t, NULL, draw_shared, v);
+    pthread_create(&t2, NULL, draw_shared, v + SHARED_DRAWS);
+    pthread_join(t, NULL);
+    pthread_join(t2, NULL);
+    qsort(v, 2 * SHARED_DRAWS, sizeof(*v), cmp_ulong);
+    for (i = 1; i < 2 * SHARED_DRAWS; i++) EXPECT(v[i - 1] != v[i]);
+    free(v);
+  }
+
+  pbc_random_ctx_clear(c1);
+  pbc_random_ctx_clear(c2);
+  mpz_clear(x);
+  mpz_clear(y);
+  mpz_clear(w);
+  mpz_clear(limit);
+  return pbc_err_count;
+}
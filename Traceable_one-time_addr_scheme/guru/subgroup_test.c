@@ -0,0 +1,113 @@
+// Test pairing_set_subgroups() and the functions using the factorization:
+// subgroup pairings, their CRT recombination and subgroup fixed-base
+// tables agree with the pairings and powers over the whole group.
+
+#include "pbc.h"
+#include "pbc_test.h"
+
+static void check_subgroups(pairing_t pairing, mpz_t order[], int n) {
+  element_t g, h, x, y, t, c[3];
+  element_pp_t p;
+  mpz_t e, bad[2];
+  int i, j;
+
+  EXPECT(!pairing_set_subgroups(pairing, order, n));
+  element_init_G1(g, pairing);
+  element_init_G2(h, pairing);
+  element_init_GT(x, pairing);
+  element_init_GT(y, pairing);
+  element_init_G1(t, pairing);
+  for (i = 0; i < n; i++) element_init_G1(c[i], pairing);
+  mpz_init(e);
+
+  for (j = 0; j < 3; j++) {
+    element_random(g);
+    element_random(h);
+
+    // The components multiply back to the element.
+    element_set0(t);
+    for (i = 0; i < n; i++) {
+      pairing_subgroup_project(c[i], g, i, pairing);
+      element_pow_mpz(t, c[i], order[i]);
+      EXPECT(element_is0(t));
+    }
+    element_set0(t);
+    for (i = 0; i < n; i++) element_add(t, t, c[i]);
+    EXPECT(!element_cmp(t, g));
+
+    for (i = 0; i < n; i++) {
+      pairing_apply(x, c[i], h, pairing);
+      pairing_apply_subgroup(y, c[i], h, i, pairing);
+      EXPECT(!element_cmp(x, y));
+    }
+    pairing_apply(x, g, h, pairing);
+    pairing_apply_crt(y, c, h, pairing);
+    EXPECT(!element_cmp(x, y));
+
+    pairing_subgroup_pp_init(p, c[0], 0, pairing);
+    pbc_mpz_random(e, pairing->r);
+    element_pow_mpz(t, c[0], e);
+    pairing_subgroup_pp_pow(g, e, p, 0, pairing);
+    EXPECT(!element_cmp(t, g));
+    element_pp_clear(p);
+  }
+
+  // An identity component contributes nothing.
+  element_set0(c[0]);
+  element_set0(t);
+  for (i = 1; i < n; i++) element_add(t, t, c[i]);
+  pairing_apply(x, t, h, pairing);
+  pairing_apply_crt(y, c, h, pairing);
+  EXPECT(!element_cmp(x, y));
+
+  // Orders that do not factor r are refused and leave the last ones set.
+  mpz_init_set(bad[0], order[0]);
+  mpz_init_set(bad[1], order[0]);
+  EXPECT(pairing_set_subgroups(pairing, bad, 2));
+  mpz_set_ui(bad[1], 1);
+  EXPECT(pairing_set_subgroups(pairing, bad, 2));
+  EXPECT(pairing->subgroup_count == n);
+  mpz_clear(bad[0]);
+  mpz_clear(bad[1]);
+
+  mpz_clear(e);
+  for (i = 0; i < n; i++) element_clear(c[i]);
+  element_clear(t);
+  element_clear(g);
+  element_clear(h);
+  element_clear(x);
+  element_clear(y);
+}
+
+int main(void) {
+  pbc_param_t param;
+  pairing_t pairing;
+  mpz_t n, order[3];
+  int i;
+
+  // Random primes, as a real factorization has: the Miller loop over r
+  // breaks down on inputs of a subgroup of order mpz_nextprime(2^k), which
+  // would fail the comparisons below.
+  mpz_init(n);
+  for (i = 0; i < 3; i++) {
+    mpz_init(order[i]);
+    pbc_mpz_randomb(order[i], 60 + 10 * i);
+    mpz_setbit(order[i], 60 + 10 * i);
+    mpz_nextprime(order[i], order[i]);
+  }
+  mpz_mul(n, order[0], order[1]);
+  mpz_mul(n, n, order[2]);
+  pbc_param_init_a1_gen(param, n);
+  pairing_init_pbc_param(pairing, param);
+  check_subgroups(pairing, order, 3);
+
+  // A coarser split, into a prime and a composite factor.
+  mpz_mul(order[1], order[1], order[2]);
+  check_subgroups(pairing, order, 2);
+  pairing_clear(pairing);
+  pbc_param_clear(param);
+
+  for (i = 0; i < 3; i++) mpz_clear(order[i]);
+  mpz_clear(n);
+  return pbc_err_count;
+}
@@ -105,6 +105,84 @@ static void test_gf3m_cubic2(void) {
     EXPECT(!element_cmp(a, b));
 }
 
+/* multiplication and cubing against known answers, for trinomials of
+   various degrees and middle terms, with the result in place */
+static void test_gf3m_kat(unsigned m, unsigned t, const unsigned long *x,
+        const unsigned long *y, const unsigned long *xy, const unsigned long *x3) {
+    field_t f;
+    element_t c, d, e;
+    field_init_gf3m(f, m, t);
+    element_init(c, f);
+    element_init(d, f);
+    element_init(e, f);
+    size_t size = params(c)->len * 2 * sizeof(unsigned long);
+    memcpy(c->data, x, size);
+    memcpy(d->data, y, size);
+    element_mul(e, c, d);
+    EXPECT(!memcmp(e->data, xy, size));
+    element_mul(d, c, d);
+    EXPECT(!memcmp(d->data, xy, size));
+    element_cubic(e, c);
+    EXPECT(!memcmp(e->data, x3, size));
+    element_cubic(c, c);
+    EXPECT(!memcmp(c->data, x3, size));
+    element_clear(c);
+    element_clear(d);
+    element_clear(e);
+    field_clear(f);
+}
+
+static void test_gf3m_kats(void) {
+    {
+        unsigned long x[] = {8748534153485358512ul, 659725008ul,
+                149307090641403915ul, 1076363557ul};
+        unsigned long y[] = {8204724074003728306ul, 5555471217ul,
+                9656476419133341709ul, 2428910726ul};
+        unsigned long xy[] = {4887261653886010528ul, 2150192168ul,
+                11541688362484637779ul, 6275107777ul};
+        unsigned long x3[] = {2010858458964363313ul, 8182239015ul,
+                14124051495192118798ul, 272953552ul};
+        test_gf3m_kat(97, 12, x, y, xy, x3);
+    }
+    {
+        unsigned long x[] = {16679961579883806606ul, 9105697808930900101ul,
+                613835695191244913ul, 45036065933771600ul};
+        unsigned long y[] = {11790494076670778435ul, 3788889066198051230ul,
+                2044282490192978616ul, 90917746661070401ul};
+        unsigned long xy[] = {909790970024855432ul, 4350918384731358306ul,
+                11608662503315482678ul, 4652234636461006981ul};
+        unsigned long x3[] = {6112512804039814229ul, 3464394419373482180ul,
+                2459044634664632448ul, 5424596202216001288ul};
+        test_gf3m_kat(127, 63, x, y, xy, x3);
+    }
+    {
+        unsigned long x[] = {82085083252550259ul, 3346005955498067979ul, 0ul,
+                10000348530659791876ul, 15100737829540606288ul, 0ul};
+        unsigned long y[] = {16382624797941316017ul, 10038162386273626841ul, 0ul,
+                1729725865133327362ul, 1477533004682236164ul, 0ul};
+        unsigned long xy[] = {9319647628844996144ul, 8070759568101130240ul, 0ul,
+                8937833612529731980ul, 9441451830932221847ul, 0ul};
+        unsigned long x3[] = {5504855395845305344ul, 11535974037182480389ul, 0ul,
+                41114205308258920ul, 4838387873106946922ul, 0ul};
+        test_gf3m_kat(128, 7, x, y, xy, x3);
+    }
+    {
+        unsigned long x[] = {7525289743350745479ul, 7988579067530865019ul,
+                12621637696230707895ul, 1ul, 473102639339411024ul,
+                1234782350772241920ul, 5823264420486776896ul, 0ul};
+        unsigned long y[] = {16870897452278831099ul, 7860358872777883003ul,
+                15155074583971470217ul, 1ul, 1445664302829707268ul,
+                207733206956638208ul, 3171126731222549622ul, 0ul};
+        unsigned long xy[] = {653656442042387590ul, 11693877942145943821ul,
+                13908393696007117600ul, 1ul, 7406515847518912529ul,
+                5584637149276804256ul, 3486366714124599310ul, 0ul};
+        unsigned long x3[] = {7988723981433308233ul, 4975360456769803852ul,
+                14619135466709245974ul, 0ul, 9223382007286149250ul,
+                3495488229840527363ul, 1519406449523491297ul, 0ul};
+        test_gf3m_kat(193, 64, x, y, xy, x3);
+    }
+}
+
 static void test_gf3m_inverse(void) {
     element_set1(a);
     element_invert(b, a);
@@ -228,6 +306,7 @@ int main(void) {
     test_gf3m_mult();
     test_gf3m_cubic();
     test_gf3m_cubic2();
+    test_gf3m_kats();
     test_gf3m_inverse();
     test_gf3m_sqrt();
     test_gf32m_cubic();
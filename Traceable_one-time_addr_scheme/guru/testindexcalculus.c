@@ -2,6 +2,10 @@
 #include <gmp.h>
 #include "pbc.h"
 
+// From guru/indexcalculus.c.
+void pbc_mpz_index_calculus(mpz_t x, mpz_t g, mpz_t h, mpz_t q);
+void pbc_mpz_index_calculus_set_threads(int n);
+
 int main(int argc, char **argv)
 {
     mpz_t x;
@@ -12,9 +16,12 @@ int main(int argc, char **argv)
     mpz_init(q);
     int bits = 40;
 
-    if (argc == 2) {
+    if (argc >= 2) {
         bits = atoi(argv[1]);
     }
+    if (argc >= 3) {
+        pbc_mpz_index_calculus_set_threads(atoi(argv[2]));
+    }
     mpz_setbit(q, bits);
     pbc_mpz_random(q, q);
     mpz_nextprime(q, q);
@@ -22,7 +29,7 @@ int main(int argc, char **argv)
     pbc_mpz_random(h, q);
     mpz_powm(h, g, h, q);
 
-    element_dlog_index_calculus(x, g, h, q);
+    pbc_mpz_index_calculus(x, g, h, q);
     element_printf("%Zd^%Zd %% %Zd = %Zd\n", g, x, q, h);
 
     return 0;
@@ -1,98 +1,285 @@
+// Microbenchmarks for the F_p backends, F_p^2, curve groups and pairings.
+//
+// Usage: timefp [-s samples] [-m ms] [-q bits] [-c baseline.csv]
+//               [param_file ...]
+//
+// Each operation is timed over several samples. A sample repeats the
+// operation until it takes at least the given number of milliseconds, so
+// timer resolution and loop overhead drop out. The output is CSV, one
+// line per operation:
+//
+//   suite,target,op,samples,mean_ns,sd_ns,ci95_ns
+//
+// ci95_ns is the half-width of the 95% confidence interval of the mean,
+// from Student's t. The field suites run on a fixed prime of the given
+// size; tinyfp, which only takes word-sized primes, runs against naivefp
+// on a 63-bit prime. Each param file adds a curve and pairing suite.
+//
+// With -c, each result is compared with the same line of an earlier run.
+// An operation counts as a regression when its interval lies wholly above
+// the baseline's and its mean is more than 5% slower. Regressions are
+// listed on stderr and make the exit status nonzero.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>  // For getopt.
 #include "pbc.h"
 #include "pbc_fp.h"
+#include "pbc_fieldquadratic.h"
 #include "pbc_test.h"
 
-static void timefield(field_t fp) {
-  int i, n;
-  double t0, t1;
+enum { MAX_SAMPLES = 100 };
+
+static int samples = 10;
+static double min_time = 0.01;
 
+// Operands of the operation under test.
+typedef struct {
   element_t x, y, z;
-  element_init(x, fp);
-  element_init(y, fp);
-  element_init(z, fp);
-
-  element_random(x);
-  element_random(y);
-
-  n = 20000;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_mul(z, x, y);
-    element_mul(x, y, z);
-    element_mul(y, z, x);
-  }
-  t1 = pbc_get_time();
-  printf("mul %fs\n", t1 - t0);
+  element_t n;             // Exponent.
+  pairing_pp_t pp;
+} bench_t[1], *bench_ptr;
+
+typedef void (*bench_fn)(bench_ptr);
+
+static void op_add(bench_ptr b) { element_add(b->z, b->x, b->y); }
+static void op_mul(bench_ptr b) { element_mul(b->z, b->x, b->y); }
+static void op_double(bench_ptr b) { element_double(b->z, b->x); }
+static void op_square(bench_ptr b) { element_square(b->z, b->x); }
+static void op_invert(bench_ptr b) { element_invert(b->z, b->x); }
+static void op_pow(bench_ptr b) { element_pow_zn(b->z, b->x, b->n); }
+static void op_pairing(bench_ptr b) { element_pairing(b->z, b->x, b->y); }
+static void op_pp_pairing(bench_ptr b) { pairing_pp_apply(b->z, b->y, b->pp); }
 
-  n = 20000;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_square(x, x);
+// One line of a baseline run.
+typedef struct {
+  char key[192];
+  double mean, ci;
+} baseline_t;
+
+static baseline_t *baseline;
+static int baseline_count;
+static int regressions;
+
+static void read_baseline(const char *path) {
+  char line[512];
+  FILE *fp = fopen(path, "r");
+  if (!fp) pbc_die("error opening %s", path);
+  while (fgets(line, sizeof(line), fp)) {
+    char suite[64], target[64], op[64];
+    int n;
+    double mean, sd, ci;
+    if (7 != sscanf(line, "%63[^,],%63[^,],%63[^,],%d,%lf,%lf,%lf",
+                    suite, target, op, &n, &mean, &sd, &ci)) {
+      continue;  // Header, or not ours.
+    }
+    baseline = pbc_realloc(baseline, sizeof(*baseline) * (baseline_count + 1));
+    baseline_t *p = &baseline[baseline_count++];
+    snprintf(p->key, sizeof(p->key), "%s,%s,%s", suite, target, op);
+    p->mean = mean;
+    p->ci = ci;
   }
-  t1 = pbc_get_time();
-  printf("square %fs\n", t1 - t0);
-
-  n = 1000;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_invert(z, x);
-    element_invert(z, y);
+  fclose(fp);
+}
+
+static void compare(const char *key, double mean, double ci) {
+  int i;
+  for (i = 0; i < baseline_count; i++) {
+    baseline_t *p = &baseline[i];
+    if (strcmp(p->key, key)) continue;
+    if (mean - ci > p->mean + p->ci && mean > p->mean * 1.05) {
+      fprintf(stderr, "regression: %s %.1f -> %.1f ns (+%.1f%%)\n",
+              key, p->mean, mean, 100.0 * (mean / p->mean - 1));
+      regressions++;
+    }
+    return;
   }
-  t1 = pbc_get_time();
-  printf("invert %fs\n", t1 - t0);
+}
+
+// Two-sided 95% quantiles of Student's t for 1 to 30 degrees of freedom.
+static double student_t95(int df) {
+  static const double t[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+  };
+  if (df < 1) return 0;
+  return df <= 30 ? t[df - 1] : 1.96;
+}
+
+static double time_loop(bench_fn fn, bench_ptr b, long iters) {
+  long i;
+  double t0 = pbc_get_time();
+  for (i = 0; i < iters; i++) fn(b);
+  return pbc_get_time() - t0;
+}
 
-  n = 40000;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_set0(z);
+static void run(const char *suite, const char *target, const char *op,
+                bench_fn fn, bench_ptr b) {
+  double v[MAX_SAMPLES], mean = 0, var = 0, sd, ci;
+  char key[192];
+  long iters = 1;
+  int i;
+
+  // Calibration doubles as warm-up.
+  for (;;) {
+    double t = time_loop(fn, b, iters);
+    if (t >= min_time) break;
+    iters = t > min_time / 100 ? (long) (iters * 1.2 * min_time / t) + 1
+                               : iters * 10;
   }
-  t1 = pbc_get_time();
-  printf("set0 %fs\n", t1 - t0);
-
-  n = 40000;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_set(z, x);
-    element_set(z, y);
+  for (i = 0; i < samples; i++) {
+    v[i] = time_loop(fn, b, iters) / iters * 1e9;
+    mean += v[i];
   }
-  t1 = pbc_get_time();
-  printf("set %fs\n", t1 - t0);
+  mean /= samples;
+  for (i = 0; i < samples; i++) var += (v[i] - mean) * (v[i] - mean);
+  sd = samples > 1 ? sqrt(var / (samples - 1)) : 0;
+  ci = student_t95(samples - 1) * sd / sqrt(samples);
 
-  n = 400;
-  t0 = pbc_get_time();
-  for (i=0; i<n; i++) {
-    element_pow_zn(x, y, z);
-  }
-  t1 = pbc_get_time();
-  printf("pow_zn %fs\n", t1 - t0);
+  snprintf(key, sizeof(key), "%s,%s,%s", suite, target, op);
+  printf("%s,%d,%.1f,%.1f,%.1f\n", key, samples, mean, sd, ci);
+  fflush(stdout);
+  compare(key, mean, ci);
+}
+
+static void time_field(const char *suite, const char *target, field_ptr f) {
+  bench_t b;
+  element_init(b->x, f);
+  element_init(b->y, f);
+  element_init(b->z, f);
+  element_init(b->n, f);
+  element_random(b->x);
+  element_random(b->y);
+  element_random(b->n);
 
-  element_clear(x);
-  element_clear(y);
-  element_clear(z);
+  run(suite, target, "add", op_add, b);
+  run(suite, target, "mul", op_mul, b);
+  run(suite, target, "square", op_square, b);
+  run(suite, target, "invert", op_invert, b);
+  run(suite, target, "pow", op_pow, b);
+
+  element_clear(b->x);
+  element_clear(b->y);
+  element_clear(b->z);
+  element_clear(b->n);
+}
+
+static void time_fp(const char *suite, void (*init)(field_ptr, mpz_t),
+                    mpz_t prime, const char *target) {
+  field_t f;
+  init(f, prime);
+  time_field(suite, target, f);
+  field_clear(f);
+}
+
+// Group operations in G1, exponentiation in G1 and GT, and the pairing
+// with and without preprocessing.
+static void time_pairing(const char *path, char *argv0) {
+  char *av[2] = { argv0, (char *) path };
+  const char *target = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  pairing_t pairing;
+  bench_t b;
+
+  pbc_demo_pairing_init(pairing, 2, av);
+  element_init_G1(b->x, pairing);
+  element_init_G1(b->y, pairing);
+  element_init_G1(b->z, pairing);
+  element_init_Zr(b->n, pairing);
+  element_random(b->x);
+  element_random(b->y);
+  element_random(b->n);
+  run("G1", target, "add", op_mul, b);
+  run("G1", target, "double", op_double, b);
+  run("G1", target, "pow", op_pow, b);
+
+  element_clear(b->y);
+  element_clear(b->z);
+  element_init_G2(b->y, pairing);
+  element_init_GT(b->z, pairing);
+  element_random(b->y);
+  run("pairing", target, "apply", op_pairing, b);
+  pairing_pp_init(b->pp, b->x, pairing);
+  run("pairing", target, "pp_apply", op_pp_pairing, b);
+  pairing_pp_clear(b->pp);
+
+  element_clear(b->x);
+  element_init_GT(b->x, pairing);
+  element_set(b->x, b->z);
+  element_random(b->n);
+  run("GT", target, "pow", op_pow, b);
+
+  element_clear(b->x);
+  element_clear(b->y);
+  element_clear(b->z);
+  element_clear(b->n);
+  pairing_clear(pairing);
 }
 
 int main(int argc, char **argv) {
-  field_t f1, f2;
+  int bits = 201, c, i;
+  char target[32];
+  field_t fp, fi;
   mpz_t prime;
 
-  mpz_init(prime);
-  if (argc > 1) {
-    mpz_setbit(prime, atoi(argv[1]));
-  } else {
-    mpz_setbit(prime, 201);
+  while ((c = getopt(argc, argv, "s:m:q:c:")) != -1) {
+    switch (c) {
+      case 's':
+        samples = atoi(optarg);
+        if (samples < 2 || samples > MAX_SAMPLES) {
+          pbc_die("samples must lie between 2 and %d", MAX_SAMPLES);
+        }
+        break;
+      case 'm':
+        min_time = atof(optarg) / 1000;
+        break;
+      case 'q':
+        bits = atoi(optarg);
+        if (bits <= 64) pbc_die("prime must have more than 64 bits");
+        break;
+      case 'c':
+        read_baseline(optarg);
+        break;
+      default:
+        fprintf(stderr,
+            "usage: %s [-s samples] [-m ms] [-q bits] [-c baseline.csv] "
+            "[param_file ...]\n", argv[0]);
+        return 1;
+    }
   }
-  mpz_setbit(prime, 70);
-  mpz_nextprime(prime, prime);
-  field_init_mont_fp(f1, prime);
-  field_init_faster_fp(f2, prime);
+  pbc_get_time();
+
+  printf("suite,target,op,samples,mean_ns,sd_ns,ci95_ns\n");
+
+  // A fixed prime keeps runs comparable: the smallest above 2^(bits-1)
+  // that is 3 mod 4, so F_p[i] is a field.
+  mpz_init(prime);
+  mpz_setbit(prime, bits - 1);
+  do mpz_nextprime(prime, prime); while (mpz_fdiv_ui(prime, 4) != 3);
+  snprintf(target, sizeof(target), "p%d", bits);
+  time_fp("naivefp", field_init_naive_fp, prime, target);
+  time_fp("fastfp", field_init_fast_fp, prime, target);
+  time_fp("fasterfp", field_init_faster_fp, prime, target);
+  time_fp("montfp", field_init_mont_fp, prime, target);
 
-  printf("montfp.c\n");
-  timefield(f1);
-  printf("fasterfp.c\n");
-  timefield(f2);
+  field_init_mont_fp(fp, prime);
+  field_init_fi(fi, fp);
+  time_field("fieldquadratic", target, fi);
+  field_clear(fi);
+  field_clear(fp);
 
+  // tinyfp only takes word-sized primes.
+  mpz_set_ui(prime, 0);
+  mpz_setbit(prime, 62);
+  mpz_nextprime(prime, prime);
+  time_fp("naivefp", field_init_naive_fp, prime, "p63");
+  time_fp("tinyfp", field_init_tiny_fp, prime, "p63");
   mpz_clear(prime);
-  field_clear(f1);
-  field_clear(f2);
-  return 0;
+
+  for (i = optind; i < argc; i++) time_pairing(argv[i], argv[0]);
+
+  pbc_free(baseline);
+  return regressions != 0;
 }
@@ -0,0 +1,122 @@
+// Test element_vec_t: bulk operations agree with element-by-element ones,
+// whether or not the field packs its elements into the vector's block.
+// Also element_inline_t, which packs an element into itself.
+#include <string.h>
+#include "pbc.h"
+#include "pbc_fp.h"
+#include "pbc_test.h"
+
+static void check_field(field_ptr f, field_ptr zr, int n) {
+  element_vec_t a, b, c, z;
+  element_t x, g;
+  element_inline_t y;
+  element_pp_t p;
+  unsigned char *data;
+  int i, len;
+
+  element_vec_init(a, f, n);
+  element_vec_init(b, f, n);
+  element_vec_init(c, f, n);
+  element_vec_init(z, zr, n);
+  element_init(x, f);
+  element_init(g, f);
+  for (i = 0; i < n; i++) EXPECT(element_is0(element_vec_item(a, i)));
+
+  element_vec_random(a);
+  element_vec_random(b);
+  element_vec_random(z);
+  element_vec_mul(c, a, b);
+  for (i = 0; i < n; i++) {
+    element_mul(x, element_vec_item(a, i), element_vec_item(b, i));
+    EXPECT(!element_cmp(x, element_vec_item(c, i)));
+  }
+  // In place.
+  element_vec_mul(a, a, b);
+  for (i = 0; i < n; i++) {
+    EXPECT(!element_cmp(element_vec_item(a, i), element_vec_item(c, i)));
+  }
+
+  element_init_inline(y, f);
+  EXPECT(y->packed == (f->packed_size &&
+                       f->packed_size <= ELEMENT_INLINE_BYTES));
+  EXPECT(element_is0(y->e));
+  element_set(y->e, element_vec_item(b, 0));
+  element_mul(y->e, y->e, y->e);
+  element_mul(x, element_vec_item(b, 0), element_vec_item(b, 0));
+  EXPECT(!element_cmp(x, y->e));
+  element_clear_inline(y);
+
+  element_vec_pow_zn(c, b, z);
+  for (i = 0; i < n; i++) {
+    element_pow_zn(x, element_vec_item(b, i), element_vec_item(z, i));
+    EXPECT(!element_cmp(x, element_vec_item(c, i)));
+  }
+
+  element_random(g);
+  element_pp_init(p, g);
+  element_vec_pp_pow_zn(c, p, z);
+  for (i = 0; i < n; i++) {
+    element_pow_zn(x, g, element_vec_item(z, i));
+    EXPECT(!element_cmp(x, element_vec_item(c, i)));
+  }
+  element_pp_clear(p);
+
+  len = element_vec_length_in_bytes(c);
+  data = pbc_malloc(len);
+  EXPECT(element_vec_to_bytes(data, c) == len);
+  EXPECT(element_vec_from_bytes(b, data) == len);
+  for (i = 0; i < n; i++) {
+    EXPECT(!element_cmp(element_vec_item(b, i), element_vec_item(c, i)));
+  }
+  pbc_free(data);
+
+  element_clear(x);
+  element_clear(g);
+  element_vec_clear(a);
+  element_vec_clear(b);
+  element_vec_clear(c);
+  element_vec_clear(z);
+}
+
+static void check(pbc_param_t param, int g1_packed, int gt_packed) {
+  pairing_t pairing;
+  element_vec_t v;
+
+  pairing_init_pbc_param(pairing, param);
+  EXPECT(!pairing->G1->packed_size == !g1_packed);
+  EXPECT(!pairing->GT->packed_size == !gt_packed);
+  EXPECT(!g1_packed ||
+         pairing->G1->packed_size <= ELEMENT_INLINE_BYTES);
+  check_field(pairing->G1, pairing->Zr, 5);
+  check_field(pairing->G2, pairing->Zr, 3);
+  check_field(pairing->GT, pairing->Zr, 4);
+  check_field(pairing->Zr, pairing->Zr, 6);
+  // Empty vectors.
+  element_vec_init(v, pairing->G1, 0);
+  element_vec_random(v);
+  element_vec_mul(v, v, v);
+  EXPECT(!element_vec_length_in_bytes(v));
+  element_vec_clear(v);
+  pairing_clear(pairing);
+}
+
+int main(void) {
+  pbc_param_t param;
+
+  pbc_param_init_a_gen(param, 160, 512);
+  check(param, 1, 1);
+  pbc_tweak_use_fp("faster");
+  check(param, 1, 1);
+  // Naive F_p elements own their data.
+  pbc_tweak_use_fp("naive");
+  check(param, 0, 0);
+  pbc_tweak_use_fp("mont");
+  pbc_param_clear(param);
+
+  // Points over F_p are packed, but not extension fields built from
+  // polynomials.
+  pbc_param_init_f_gen(param, 160);
+  check(param, 1, 0);
+  pbc_param_clear(param);
+  return pbc_err_count;
+}
@@ -73,6 +73,16 @@ element_ptr curve_field_b_coeff(field_t f);
 void curve_from_x(element_ptr e, element_t x);
 void curve_set_si(element_t R, long int x, long int y);
 void curve_set_gen_no_cofac(element_ptr a);
+// field_init_curve_ab() with the generator (before the cofactor) taken from
+// 'gen', element_to_bytes output of length 'gen_len', instead of a random
+// search. Falls back to the search if 'gen' is NULL or not a curve point.
+void field_init_curve_ab_gen(field_ptr f, element_ptr a, element_ptr b,
+    mpz_t order, mpz_t cofac, const unsigned char *gen, int gen_len);
+// field_init_curve_ab_map() followed by field_reinit_curve_twist(), with
+// the twist generator taken from 'gen' as above.
+void field_init_curve_ab_map_twist(field_t cnew, field_t c,
+    fieldmap map, field_ptr mapdest, mpz_t ordernew,
+    const unsigned char *gen, int gen_len);
 
 #pragma GCC visibility pop
 
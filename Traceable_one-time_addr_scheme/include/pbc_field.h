@@ -46,6 +46,8 @@ struct field_s {
   void (*set)(element_ptr, element_ptr);
   void (*set0)(element_ptr);
   void (*set1)(element_ptr);
+  // set0 that also overwrites the representation, see element_wipe().
+  void (*wipe)(element_ptr);
   int (*set_str)(element_ptr e, const char *s, int base);
   size_t(*out_str)(FILE *stream, int base, element_ptr);
   void (*add)(element_ptr, element_ptr, element_ptr);
@@ -68,19 +70,48 @@ struct field_s {
   void (*doub)(element_ptr, element_ptr);  // Can't call it "double"!
   void (*multi_doub)(element_ptr*, element_ptr*, int n);
   void (*multi_add)(element_ptr*, element_ptr*, element_ptr*, int n);
+  void (*multi_mul)(element_ptr*, element_ptr*, element_ptr*, int n);
+  void (*multi_invert)(element_ptr*, element_ptr*, int n);
   void (*halve)(element_ptr, element_ptr);
   void (*square)(element_ptr, element_ptr);
 
   void (*cubic) (element_ptr, element_ptr);
   void (*pow_mpz)(element_ptr, element_ptr, mpz_ptr);
+  // For secret exponents: cmov(x, a, bit) sets x = a when bit is 1,
+  // without branching on bit where the representation allows it.
+  void (*cmov)(element_ptr, element_ptr, int bit);
+  void (*pow_mpz_ct)(element_ptr, element_ptr, mpz_ptr);
+  // invert, for a secret element, in time independent of its value where
+  // the representation allows it.
+  void (*invert_ct)(element_ptr, element_ptr);
+  // x = a[0]^n[0] ... a[m-1]^n[m-1] for a few bases, one chain of squarings
+  // for all of them. n[i] may be negative. Behind element_pow2_mpz() and
+  // element_pow3_mpz().
+  void (*multi_pow_mpz)(element_ptr x, element_ptr a[], mpz_ptr n[], int m);
+  // Optional: x[i] = a[i]^n[i] for all i, n[i] >= 0, behind
+  // element_pow_mpz_batch(). NULL runs them one by one.
+  void (*pow_mpz_batch)(element_ptr x[], element_ptr a[], mpz_ptr n[], int m);
+  // Optional: x[i] = a[i]^n for all i, n >= 0, behind
+  // element_pow_mpz_same(). NULL runs them one by one.
+  void (*pow_mpz_same)(element_ptr x[], element_ptr a[], mpz_ptr n, int m);
   void (*invert)(element_ptr, element_ptr);
   void (*neg)(element_ptr, element_ptr);
   void (*random)(element_ptr);
   void (*from_hash)(element_ptr, void *data, int len);
+  // The big-endian integer in data reduced modulo the order, behind
+  // element_from_bytes_mod().
+  void (*from_bytes_mod)(element_ptr, unsigned char *data, int len);
   int (*is1)(element_ptr);
   int (*is0)(element_ptr);
   int (*sign)(element_ptr);  // satisfies sign(x) = -sign(-x)
   int (*cmp)(element_ptr, element_ptr);
+  // Whether an element read from outside lies in the group of order
+  // 'order' the field stands for, see element_is_in_subgroup(). The
+  // default accepts everything, as for the fields themselves.
+  int (*in_subgroup)(element_ptr);
+  // Optional: in_subgroup for m elements at once, setting ok[i] and
+  // returning how many pass. NULL checks them one by one.
+  int (*in_subgroup_batch)(char ok[], element_ptr a[], int m);
   int (*to_bytes)(unsigned char *data, element_ptr);
   int (*from_bytes)(element_ptr, unsigned char *data);
   int (*length_in_bytes)(element_ptr);
@@ -91,6 +122,20 @@ struct field_s {
   void (*pp_init)(element_pp_t p, element_t in);
   void (*pp_clear)(element_pp_t p);
   void (*pp_pow)(element_t out, mpz_ptr power, element_pp_t p);
+  // Optional: pp_init for exponents of up to 'bits' bits, with a table
+  // size and layout, see element_pp_init_ex().
+  void (*pp_init_ex)(element_pp_t p, element_t in, int bits, int k,
+      int strategy);
+  // Optional: overwrite the table of pp_init / pp_init_ex with zeros, see
+  // element_pp_wipe(). Needed by fields with their own pp_clear.
+  void (*pp_wipe)(element_pp_t p);
+  // Whether pp_init and pp_init_ex leave a struct element_base_table in
+  // p->data, as the default ones do, which element_pp_to_bytes() writes.
+  int pp_is_base_table;
+  // Optional: init_packed places an element in packed_size bytes of
+  // caller memory; packed_size is 0 when elements own their data.
+  size_t packed_size;
+  void (*init_packed)(element_ptr e, void *mem);
 
   struct pairing_s *pairing;
 
@@ -116,6 +161,17 @@ static inline void element_init(element_t e, field_ptr f) {
   f->init(e);
 }
 
+/*@manual internal
+Initialize 'e' to be an element of 'f' held in 'mem', which has room for
+'f'->packed_size bytes, is aligned for a pointer and outlives 'e'. Such
+elements are not cleared: releasing 'mem' releases them. Lets tables of
+many elements share one block. Requires 'f'->packed_size > 0.
+*/
+static inline void element_init_packed(element_t e, field_ptr f, void *mem) {
+  e->field = f;
+  f->init_packed(e, mem);
+}
+
 element_ptr element_new(field_ptr f);
 void element_free(element_ptr e);
 
@@ -135,6 +191,45 @@ static inline void element_clear(element_t e) {
   e->field->clear(e);
 }
 
+/*@manual internal
+An element with room for its data in the struct itself, so that a
+temporary on the stack or inside another struct needs no allocation and
+keeps its limbs next to it. ELEMENT_INLINE_BYTES fits F_p up to 1920
+bits, and quadratic extensions and points over F_p up to 512 bits;
+elements of fields that do not pack them, or that need more room, are
+initialized as usual. Operate on the element_t 'e->e'.
+*/
+#define ELEMENT_INLINE_BYTES 256
+
+struct element_inline_s {
+  element_t e;
+  int packed;
+  union {
+    void *align;
+    unsigned char b[ELEMENT_INLINE_BYTES];
+  } mem;
+};
+typedef struct element_inline_s element_inline_t[1];
+
+/*@manual internal
+Initialize the inline element 'e' to be an element of 'f', set to zero.
+Returns 'e->e'.
+*/
+static inline element_ptr element_init_inline(element_inline_t e,
+                                              field_ptr f) {
+  e->packed = f->packed_size && f->packed_size <= ELEMENT_INLINE_BYTES;
+  if (e->packed) element_init_packed(e->e, f, e->mem.b);
+  else element_init(e->e, f);
+  return e->e;
+}
+
+/*@manual internal
+Free the space, if any, that 'e' occupies outside itself.
+*/
+static inline void element_clear_inline(element_inline_t e) {
+  if (!e->packed) element_clear(e->e);
+}
+
 /*@manual eio
 Output 'e' on 'stream' in base 'base'. The base must be between
 2 and 36.
@@ -206,6 +301,15 @@ static inline void element_set1(element_t e) {
   e->field->set1(e);
 }
 
+/*@manual eassign
+Set 'e' to zero, overwriting the memory that held its value, coordinates
+and coefficients included. For an element that held a secret, before it
+is cleared or handed on.
+*/
+static inline void element_wipe(element_t e) {
+  e->field->wipe(e);
+}
+
 /*@manual eassign
 Set 'e' to 'i'.
 */
@@ -258,6 +362,17 @@ static inline void element_from_hash(element_t e, void *data, int len) {
   e->field->from_hash(e, data, len);
 }
 
+/*@manual econvert
+Set 'e' to the big-endian integer held in the 'len' bytes of 'data',
+reduced modulo the order of the field, e.g. to turn a digest into an
+element of *Z*~r~. Unlike *element_from_hash()*, every input is reduced
+the same way as *element_set_mpz()* would.
+*/
+static inline void element_from_bytes_mod(element_t e, unsigned char *data,
+                                          int len) {
+  e->field->from_bytes_mod(e, data, len);
+}
+
 /*@manual earith
 Set 'n' to 'a' + 'b'.
 */
@@ -342,6 +457,15 @@ void element_multi_double(element_t n[], element_t a[], int m);
 // Uses multi_add(), which only elliptic curves have at the moment.
 void element_multi_add(element_t n[], element_t a[],element_t b[], int m);
 
+// Set n_i = a_i b_i for all i at one time.
+// Fields without a batched multi_mul() fall back to element_mul().
+void element_multi_mul(element_t n[], element_t a[], element_t b[], int m);
+
+// Set n_i = 1/a_i for all i at one time, with one inversion in the field
+// (or in its base field, for quadratic extensions) and about 3m
+// multiplications. Zero elements are left zero.
+void element_multi_invert(element_t n[], element_t a[], int m);
+
 /*@manual earith
 Set 'n' = 'a/2'
 */
@@ -380,6 +504,42 @@ static inline void element_pow_zn(element_t x, element_t a, element_t n) {
   mpz_clear(z);
 }
 
+/*@manual epow
+Same as element_pow_mpz(), for a secret exponent 'n'. The sequence of
+group operations and the table entries read depend on the bit lengths of
+'n' and of the order of the group, but not on the bits of 'n' themselves.
+A negative 'n' still costs an inversion. The field arithmetic underneath
+is not itself hardened, except that points on curves over F_p return to
+affine coordinates by element_invert_ct().
+*/
+static inline void element_pow_mpz_ct(element_t x, element_t a, mpz_t n) {
+  PBC_ASSERT_MATCH2(x, a);
+  x->field->pow_mpz_ct(x, a, n);
+}
+
+/*@manual epow
+Same as element_pow_zn(), for a secret exponent 'n', as in
+element_pow_mpz_ct().
+*/
+static inline void element_pow_zn_ct(element_t x, element_t a, element_t n) {
+  mpz_t z;
+  PBC_ASSERT_MATCH2(x, a);
+  mpz_init(z);
+  element_to_mpz(z, n);
+  element_pow_mpz_ct(x, a, z);
+  mpz_clear(z);
+}
+
+/*@manual eassign
+Set 'x' = 'a' if 'bit' is 1 and leave 'x' unchanged if 'bit' is 0. In
+fields of type F_p, their extensions and curves over them, the time taken
+does not depend on 'bit'.
+*/
+static inline void element_cmov(element_t x, element_t a, int bit) {
+  PBC_ASSERT_MATCH2(x, a);
+  x->field->cmov(x, a, bit);
+}
+
 /*@manual earith
 Set 'n' = -'a'.
 */
@@ -396,6 +556,15 @@ static inline void element_invert(element_t n, element_t a) {
   n->field->invert(n, a);
 }
 
+/*@manual earith
+Same as element_invert(), for a secret 'a'. In the Montgomery F_p the
+time taken does not depend on its value; other fields invert as usual.
+*/
+static inline void element_invert_ct(element_t n, element_t a) {
+  PBC_ASSERT_MATCH2(n, a);
+  n->field->invert_ct(n, a);
+}
+
 /*@manual erandom
 If the 'e' lies in a finite algebraic structure,
 assigns a uniformly random element to 'e'.
@@ -451,6 +620,26 @@ static inline int element_sign(element_t a) {
   return a->field->sign(a);
 }
 
+/*@manual ecmp
+Returns nonzero if 'a' lies in the group of prime order its algebraic
+structure stands for, such as G1, G2 or GT of a pairing, zero otherwise.
+Deserialization only checks that points lie on the curve and leaves
+elements of GT unchecked, so input from untrusted parties should pass
+this test first. Points on curves whose group of points has prime order
+cost nothing more; others cost about one exponentiation.
+*/
+static inline int element_is_in_subgroup(element_t a) {
+  return a->field->in_subgroup(a);
+}
+
+/*@manual ecmp
+Runs element_is_in_subgroup() on 'a[i]' for 0 <= i < 'm' and returns how
+many pass. If 'ok' is not NULL, 'ok[i]' is set to whether 'a[i]' passes.
+On elliptic curves the exponentiations run in lockstep as in
+element_pow_mpz_same(). The 'a[i]' must belong to one field.
+*/
+int element_is_in_subgroup_batch(char ok[], element_t a[], int m);
+
 static inline void element_sqrt(element_t a, element_t b) {
   PBC_ASSERT_MATCH2(a, b);
   a->field->sqrt(a, b);
@@ -532,6 +721,50 @@ static inline void element_pow3_zn(element_t x, element_t a1, element_t n1,
   mpz_clear(z3);
 }
 
+/*@manual epow
+Sets 'x' = 'a[0]'^'n[0]'^ ... 'a[m-1]'^'n[m-1]'^ for nonnegative 'n[i]'.
+Much faster than separate exponentiations when there are many bases,
+especially on elliptic curves, where the group operations are batched.
+*/
+void element_multi_pow_mpz(element_t x, element_t a[], mpz_t n[], int m);
+
+/*@manual epow
+Also sets 'x' = 'a[0]'^'n[0]'^ ... 'a[m-1]'^'n[m-1]'^,
+but the 'n[i]' must be elements of a ring *Z*~n~ for some integer n.
+*/
+void element_multi_pow_zn(element_t x, element_t a[], element_t n[], int m);
+
+/*@manual epow
+Sets 'x[i]' = 'a[i]'^'n[i]'^ for 0 <= i < 'm', for nonnegative 'n[i]'.
+On elliptic curves without an endomorphism the exponentiations run in
+lockstep in affine coordinates, so each doubling or addition step shares
+one inversion among all of them; this pays off from about eight
+exponentiations. Other groups perform them one by one. 'x[i]' may be
+'a[i]'.
+*/
+void element_pow_mpz_batch(element_t x[], element_t a[], mpz_t n[], int m);
+
+/*@manual epow
+Also sets 'x[i]' = 'a[i]'^'n[i]'^ for 0 <= i < 'm',
+but the 'n[i]' must be elements of a ring *Z*~n~ for some integer n.
+*/
+void element_pow_zn_batch(element_t x[], element_t a[], element_t n[], int m);
+
+/*@manual epow
+Sets 'x[i]' = 'a[i]'^'n'^ for 0 <= i < 'm', for a nonnegative 'n' shared
+by all the bases, as when one secret key meets many points. The exponent
+is recoded once, and on elliptic curves without an endomorphism the
+exponentiations share inversions as in element_pow_mpz_batch(). 'x[i]'
+may be 'a[i]'.
+*/
+void element_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m);
+
+/*@manual epow
+Also sets 'x[i]' = 'a[i]'^'n'^ for 0 <= i < 'm',
+but 'n' must be an element of a ring *Z*~n~ for some integer n.
+*/
+void element_pow_zn_same(element_t x[], element_t a[], element_t n, int m);
+
 void field_clear(field_ptr f);
 
 element_ptr field_get_nqr(field_ptr f);
@@ -578,6 +811,14 @@ Currently only implemented for points on an elliptic curve.
 */
 int element_from_bytes_compressed(element_t e, unsigned char *data);
 
+/*@manual etrade
+Sets the 'n' elements of 'e' to the points stored back to back in
+compressed form in 'data', sharing scratch space across the batch.
+All elements must lie on the same elliptic curve.
+Returns the number of bytes read.
+*/
+int element_from_bytes_compressed_batch(element_t e[], unsigned char *data, int n);
+
 /*@manual etrade
 Returns the number of bytes needed to hold 'e' in compressed form.
 Currently only implemented for points on an elliptic curve.
@@ -593,6 +834,41 @@ static inline void element_pp_init(element_pp_t p, element_t in) {
   in->field->pp_init(p, in);
 }
 
+// Layouts of the fixed-base table built by element_pp_init_ex(), for an
+// exponent of l bits.
+enum {
+  // One row of 2^k^ - 1 powers per k-bit window: about (l/k) 2^k^
+  // elements, l/k multiplications and no squarings.
+  PBC_PP_WINDOW = 0,
+  // Lim-Lee comb with k teeth: one table of 2^k^ - 1 elements, l/k
+  // squarings and as many multiplications.
+  PBC_PP_COMB,
+  // Comb with two tables, 2 (2^k^ - 1) elements: half the squarings.
+  PBC_PP_COMB2,
+};
+
+/*@manual epow
+Same as *element_pp_init* but builds a table of the given 'strategy'
+(PBC_PP_WINDOW, PBC_PP_COMB or PBC_PP_COMB2) and size 'k'. The windowed
+table is the fastest and largest: with k = 5, the default, it holds about
+6 l elements for an l-bit order. A comb table of k teeth holds 2^k^ - 1,
+so it suits many bases, each exponentiated a few times. Fields with no
+such tables ignore 'k' and 'strategy'.
+*/
+void element_pp_init_ex(element_pp_t p, element_t in, int k, int strategy);
+
+// Same for exponents of up to 'bits' bits, for an 'in' whose order is far
+// below that of its field.
+void element_pp_init_bits(element_pp_t p, element_t in, int bits, int k,
+    int strategy);
+
+/*@manual epow
+Same as *element_pp_init* but builds the fixed-base table with a 'k'-bit
+window. Larger 'k' trades memory (2^k^ elements per window) for fewer
+multiplications per exponentiation; the default is 5.
+*/
+void element_pp_init_k(element_pp_t p, element_t in, int k);
+
 /*@manual epow
 Clear 'p'. Should be called after 'p' is no longer needed.
 */
@@ -600,6 +876,37 @@ static inline void element_pp_clear(element_pp_t p) {
   p->field->pp_clear(p);
 }
 
+/*@manual epow
+Overwrite the table of 'p' with zeros, for a table of a secret base; call
+before *element_pp_clear*. 'p' is then of no further use but to be cleared.
+Fields whose preprocessing keeps no table of powers leave it as it is.
+*/
+void element_pp_wipe(element_pp_t p);
+
+/*@manual epow
+Returns the length in bytes of the table of 'p' as *element_pp_to_bytes*
+writes it, or 0 for a field that keeps its preprocessing in another form,
+such as GT of a pairing, whose tables cannot be written.
+*/
+int element_pp_length_in_bytes(element_pp_t p);
+
+/*@manual epow
+Write the table of 'p' to 'data', with its size and layout, so that
+*element_pp_from_bytes* reads it back in place of building it again.
+Returns the number of bytes written, 0 if the table cannot be written.
+*/
+int element_pp_to_bytes(unsigned char *data, element_pp_t p);
+
+/*@manual epow
+Initialize 'p' for the base 'in' from a table *element_pp_to_bytes* wrote
+for it. 'data' may lie in a read-only mapping of a file. The table is
+trusted to be that of 'in' beyond its header, checked against the field of
+'in', and its first entry, which is 'in' itself. Returns the number of
+bytes read, or 0 when 'data' holds no table for 'in', leaving 'p'
+uninitialized.
+*/
+int element_pp_from_bytes(element_pp_t p, element_t in, unsigned char *data);
+
 /*@manual epow
 Raise 'in' to 'power' and store the result in 'out', where 'in'
 is a previously preprocessed element, that is, the second argument
@@ -678,9 +985,73 @@ void element_dlog_brute_force(element_t x, element_t g, element_t h);
 /*@manual epow
 Computes 'x' such that 'g^x^ = h' using Pollard rho method, where
 'x' lies in a field where `element_set_mpz()` makes sense.
+Walks run in parallel and meet at distinguished points kept in a
+shared table; see `element_dlog_set_threads()`.
 */
 void element_dlog_pollard_rho(element_t x, element_t g, element_t h);
 
+/*@manual epow
+Sets the number of threads `element_dlog_pollard_rho()` walks on.
+0, the default, means one per online CPU.
+*/
+void element_dlog_set_threads(int n);
+
+// A vector of n elements of one field in a single allocation: the
+// element_t headers, an array of pointers to them for the multi_ routines
+// and, when the field supports element_init_packed(), the data of every
+// element, back to back. Other fields fall back to element_init() for the
+// data, so any field may be used.
+struct element_vec_s {
+  field_ptr field;
+  int n;
+  element_t *item;
+  element_ptr *ptr;
+};
+typedef struct element_vec_s *element_vec_ptr;
+typedef struct element_vec_s element_vec_t[1];
+
+// Fixed-base table of element_pp_init_ex(), for exponents of up to 'bits'
+// bits, its 'rows' rows or tables of 2^k - 1 elements lying in one vector.
+// PBC_PP_WINDOW: row i holds a^(d 2^(ki)) for 0 < d < 2^k.
+// PBC_PP_COMB, PBC_PP_COMB2: the k teeth of the comb lie 'spacing' bits
+// apart and each table covers 'span' columns of them. Entry j of table s is
+// the product of a^(2^(i spacing + s span)) over the set bits i of j.
+// Fields with pp_is_base_table set keep their tables in this form.
+struct element_base_table {
+  int k, strategy;
+  int rows;
+  int spacing, span;
+  element_vec_t table;
+};
+
+// Initialize 'v' to hold 'n' elements of 'f', each set to zero.
+void element_vec_init(element_vec_t v, field_ptr f, int n);
+void element_vec_clear(element_vec_t v);
+
+// The i-th element of 'v'. It may be passed to any element_ routine;
+// 'v'->item may be passed wherever an array of element_t is expected.
+static inline element_ptr element_vec_item(element_vec_t v, int i) {
+  return v->item[i];
+}
+
+void element_vec_random(element_vec_t v);
+
+// Set out_i = a_i b_i with one call to the field's multi_mul().
+// The vectors must have the same field and length, and may coincide.
+void element_vec_mul(element_vec_t out, element_vec_t a, element_vec_t b);
+
+// Set out_i = a_i^n_i, where the n_i lie in Z_r.
+void element_vec_pow_zn(element_vec_t out, element_vec_t a, element_vec_t n);
+
+// Set out_i = g^n_i, where 'p' holds the preprocessed g.
+void element_vec_pp_pow_zn(element_vec_t out, element_pp_t p, element_vec_t n);
+
+// Bytes of the elements of 'v' back to back, in order.
+int element_vec_length_in_bytes(element_vec_t v);
+int element_vec_to_bytes(unsigned char *data, element_vec_t v);
+// Returns the number of bytes read.
+int element_vec_from_bytes(element_vec_t v, unsigned char *data);
+
 // Trial division up to a given limit. If limit == NULL, then there is no limit.
 // Call the callback for each factor found, abort and return 1 if the callback
 // returns nonzero, otherwise return 0.
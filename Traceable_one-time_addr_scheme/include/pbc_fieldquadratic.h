@@ -20,4 +20,15 @@ void field_init_fi(field_ptr L, field_ptr K);
 void element_field_to_quadratic(element_ptr out, element_ptr in);
 void element_field_to_fi(element_ptr a, element_ptr b);
 
+// x = a^n for a in K[i] of norm 1, such as the elements of GT for pairings
+// of types A and A1. n may be negative. Faster than element_pow_mpz(), as
+// squarings are cheaper and inverses are conjugates.
+void element_fi_unitary_pow_mpz(element_ptr x, element_ptr a, mpz_ptr n);
+
+// The same for a secret n: the sequence of operations depends only on the
+// sizes of n and of 'order', the order of the subgroup a lies in, and
+// uses masked moves in K.
+void element_fi_unitary_pow_mpz_ct(element_ptr x, element_ptr a, mpz_ptr n,
+    mpz_ptr order);
+
 #endif //__PBC_FIELDQUADRATIC_H__
@@ -5,9 +5,18 @@
 
 // Allocate an array of mpz_t and fill it with the coefficients of the Hilbert
 // polynomial H_D(x). Returns the size of array.
+// The last few polynomials computed are kept, and asking for one of them
+// again returns a copy.
 size_t pbc_hilbert(mpz_t **arr, int D);
 
 // Free an array allocated by `pbc_hilbert()`.
 void pbc_hilbert_free(mpz_t *arr, size_t n);
 
+// Set the number of threads `pbc_hilbert()` evaluates j-invariants on.
+// 0, the default, means one per online CPU.
+void pbc_hilbert_set_threads(int n);
+
+// Free the polynomials `pbc_hilbert()` keeps.
+void pbc_hilbert_cache_clear(void);
+
 #endif //__PBC_HILBERT_H__
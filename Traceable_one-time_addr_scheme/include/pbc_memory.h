@@ -21,4 +21,27 @@ void pbc_set_memory_functions(void *(*malloc_fn)(size_t),
 
 char *pbc_strdup(const char *s);
 
+/*@manual alloc
+Install the built-in pool allocator for PBC and GMP memory, through
+*pbc_set_memory_functions* and GMP's +mp_set_memory_functions+.
+Small blocks come from fixed-size classes carved out of large slabs, with
+a free list per thread, so element and limb storage is recycled without
+calling +malloc+ in steady state. Larger blocks, and blocks allocated
+before the pool was installed, are passed on to the previous allocators,
+so the pool can be installed at any point, e.g. right before a pairing is
+initialized. It stays installed for the rest of the process.
+Returns 0 on success, 1 if the pool was already installed.
+*/
+int pbc_pool_enable(void);
+
+/*@manual alloc
+Returns 1 if the pool allocator is installed, 0 otherwise.
+*/
+int pbc_pool_enabled(void);
+
+/*@manual alloc
+Returns the number of bytes the pool allocator has reserved in slabs.
+*/
+size_t pbc_pool_bytes(void);
+
 #endif //__PBC_MEMORY_H__
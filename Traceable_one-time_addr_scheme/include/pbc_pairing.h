@@ -29,6 +29,20 @@ struct pairing_s {
       struct pairing_s *p);
   void (*prod_pairings)(element_ptr out, element_t in1[], element_t in2[], int n_prod,
             struct pairing_s *p);  //calculate a product of pairings at one time.
+  void (*map_batch)(element_ptr out[], element_ptr in1[], element_ptr in2[],
+      int n, struct pairing_s *p);  //n pairings, none with the identity.
+  // map() and pp_apply() without the final exponentiation, or NULL.
+  void (*miller)(element_ptr out, element_ptr in1, element_ptr in2,
+      struct pairing_s *p);
+  void (*pp_miller)(element_ptr out, element_ptr in2, pairing_pp_t p);
+  // map() for an in1 whose order divides 'order', a factor of r, or NULL.
+  void (*subgroup_map)(element_ptr out, element_ptr in1, element_ptr in2,
+      mpz_ptr order, struct pairing_s *p);
+  // pow_mpz() and pow_mpz_ct() on the values of reduced elements of GT,
+  // whose order is 'order', or NULL for the generic ones.
+  void (*gt_pow_mpz)(element_ptr out, element_ptr in, mpz_ptr n);
+  void (*gt_pow_mpz_ct)(element_ptr out, element_ptr in, mpz_ptr n,
+      mpz_ptr order);
   // is_almost coddh returns true given (g, g^x, h, h^x) or (g, g^x, h, h^-x)
   // order is important: a, b are from G1, c, d are from G2
   int (*is_almost_coddh)(element_ptr a, element_ptr b,
@@ -38,14 +52,42 @@ struct pairing_s {
   void (*pp_init)(pairing_pp_t p, element_t in1, struct pairing_s *);
   void (*pp_clear)(pairing_pp_t p);
   void (*pp_apply)(element_t out, element_t in2, pairing_pp_t p);
+  // Serialization of pp_init() tables, or NULL: pp_from_bytes() returns 0
+  // if the data holds no table of this pairing and method.
+  int (*pp_length_in_bytes)(struct pairing_s *);
+  void (*pp_to_bytes)(unsigned char *data, pairing_pp_t p);
+  int (*pp_from_bytes)(pairing_pp_t p, unsigned char *data,
+      struct pairing_s *);
   void (*finalpow)(element_t e);
+  // finalpow() on the values of n elements of GT at once, or NULL.
+  void (*finalpow_batch)(element_ptr v[], int n);
   void (*option_set)(struct pairing_s *, char *key, char *value);
+  // The factorization of r from pairing_set_subgroups(): the orders of the
+  // subgroups and the CRT coefficients projecting onto them.
+  int subgroup_count;
+  mpz_t *subgroup;
+  mpz_t *subgroup_crt;
   void *data;
 };
 
 typedef struct pairing_s pairing_t[1];
 typedef struct pairing_s *pairing_ptr;
 
+// The data of a GT element: its value in the field containing GT, and
+// whether that value still awaits the final exponentiation (see
+// pairing_apply_unreduced()).
+struct pairing_gt_s {
+  element_t value;
+  int unreduced;
+};
+
+// For pairing routines writing a reduced value to a GT element.
+static inline element_ptr pairing_gt_out(element_t out) {
+  struct pairing_gt_s *d = out->data;
+  d->unreduced = 0;
+  return d->value;
+}
+
 // TODO: The 'pairing' argument is redundant.
 /*@manual pairing_apply
 Get ready to perform a pairing whose first input is 'in1',
@@ -85,9 +127,50 @@ static inline void pairing_pp_apply(element_t out, element_t in2, pairing_pp_t p
     element_set0(out);
     return;
   }
-  p->pairing->pp_apply((element_ptr) out->data, in2, p);
+  p->pairing->pp_apply(pairing_gt_out(out), in2, p);
 }
 
+/*@manual pairing_apply
+Returns 1 if pairing_pp_init() precomputes for 'pairing', 0 if the pairing
+type has no preprocessing: 'p' then only points to the first input, which
+must outlive it, and pairing_pp_apply() costs a full pairing.
+*/
+int pairing_pp_is_precomputed(pairing_t pairing);
+
+/*@manual pairing_apply
+Returns the length in bytes of the precomputed tables of 'pairing' as
+pairing_pp_to_bytes() writes them, the same for every first input, or 0
+if the pairing type cannot serialize them (currently only types A and A1
+can). The length also depends on the pairing method.
+*/
+int pairing_pp_length_in_bytes(pairing_t pairing);
+
+/*@manual pairing_apply
+Writes the precomputed tables 'p' of 'pairing' to the buffer 'data',
+which must hold pairing_pp_length_in_bytes() bytes. Returns the number of
+bytes written, 0 if the pairing type cannot serialize them.
+*/
+int pairing_pp_to_bytes(unsigned char *data, pairing_pp_t p,
+    pairing_t pairing);
+
+/*@manual pairing_apply
+Initializes 'p' from tables pairing_pp_to_bytes() wrote for the same
+pairing and method, instead of pairing_pp_init(), which saves rebuilding
+them for long-lived first inputs. 'data' may point into a memory-mapped
+file. Returns the number of bytes read, or 0, leaving 'p' uninitialized,
+if the data holds no such tables. Tables of another pairing whose sizes
+match are not always detected.
+*/
+int pairing_pp_from_bytes(pairing_pp_t p, unsigned char *data,
+    pairing_t pairing);
+
+/*@manual pairing_apply
+Same as pairing_pp_apply(), but for pairings with a Miller loop
+separate from the final exponentiation (currently type A) leaves
+'out' unreduced: see pairing_apply_unreduced().
+*/
+void pairing_pp_apply_unreduced(element_t out, element_t in2, pairing_pp_t p);
+
 /*@manual pairing_init
 Initialize pairing from parameters in a ASCIIZ string 'str'
 Returns 0 on success, 1 on failure.
@@ -131,9 +214,36 @@ static inline void pairing_apply(element_t out, element_t in1, element_t in2,
   // TODO: 'out' is an element of a multiplicative subgroup, but the
   // pairing routine expects it to be an element of the full group, hence
   // the 'out->data'. I should make this clearer.
-  pairing->map((element_ptr) out->data, in1, in2, pairing);
+  pairing->map(pairing_gt_out(out), in1, in2, pairing);
 }
 
+/*@manual pairing_apply
+Computes 'out' = 'e'('in1', 'in2') as pairing_apply() does, but for
+types A and A1 stops after the Miller loop. The final exponentiation then
+runs once, when the value is first needed: by element_cmp(),
+element_to_bytes() and the other functions reading it, or when it meets
+a reduced element in element_mul(). Products, quotients, inverses and
+powers of unreduced elements stay unreduced, so a product of several
+pairings costs a single final exponentiation. Other types and identity
+inputs give a reduced 'out'.
+*/
+void pairing_apply_unreduced(element_t out, element_t in1, element_t in2,
+    pairing_t pairing);
+
+/*@manual pairing_apply
+Runs the pending final exponentiation of 'e', if any. Only needed before
+reading the value of 'e' directly, without the element functions.
+*/
+void element_gt_reduce(element_t e);
+
+/*@manual pairing_apply
+Runs the pending final exponentiations of 'e'[0], ..., 'e'['n'-1], as 'n'
+calls to element_gt_reduce() would. For types A and A1 they run together
+and share their inversions, as in pairing_apply_batch(), so a batch of
+pairing_pp_apply_unreduced() results costs less than reducing each.
+*/
+void element_gt_reduce_batch(element_t e[], int n);
+
 /*@manual pairing_apply
 Computes a pairing: 'out' = 'e'('in1', 'in2'),
 where 'in1', 'in2', 'out' must be in the groups G1, G2, GT.
@@ -149,26 +259,73 @@ Computes the product of pairings, that is
 'out' = 'e'('in1'[0], 'in2'[0]) ... 'e'('in1'[n-1], 'in2'[n-1]).
 The arrays 'in1', 'in2' must have at least 'n' elements belonging to
 the groups G1, G2 respectively, and 'out' must belong to the group GT.
+Pairs with an identity input contribute 1 and are skipped. Types A, A1,
+D, E, F and G run all the Miller loops together, sharing their squarings
+and a single final exponentiation.
 */
-static inline void element_prod_pairing(
-    element_t out, element_t in1[], element_t in2[], int n) {
-  pairing_ptr pairing = out->field->pairing;
-  int i;
-  PBC_ASSERT(pairing->GT == out->field, "pairing output mismatch");
-  for(i = 0; i < n; i++) {
-    PBC_ASSERT(pairing->G1 == in1[i]->field, "pairing 1st input mismatch");
-    PBC_ASSERT(pairing->G2 == in2[i]->field, "pairing 2nd input mismatch");
-    if (element_is0(in1[i])) {
-      element_set0(out);
-      return;
-    }
-    if (element_is0(in2[i])) {
-      element_set0(out);
-      return;
-    }
-  }
-  pairing->prod_pairings((element_ptr) out->data, in1, in2, n, pairing);
-}
+void element_prod_pairing(
+    element_t out, element_t in1[], element_t in2[], int n);
+
+/*@manual pairing_apply
+Computes 'n' pairings: 'out'[i] = 'e'('in1'[i], 'in2'[i]) for each i,
+as 'n' calls to pairing_apply() would. Where the pairing type supports it
+(currently A and A1), the Miller loops run first and the final
+exponentiations then share their inversions, which saves time when
+many pairings are needed at once.
+*/
+void pairing_apply_batch(element_t out[], element_t in1[], element_t in2[],
+    int n, pairing_t pairing);
+
+/*@manual pairing_subgroup
+For composite-order pairings (type A1), whose order r the application
+knows the factorization of: sets 'order'[0], ..., 'order'['n'-1] as the
+subgroup orders, which must be pairwise coprime, greater than 1 and
+multiply to r. Prime factors give the most speed. 'n' = 0 forgets them.
+Returns 0 on success, 1 if the orders do not factor r.
+*/
+int pairing_set_subgroups(pairing_t pairing, mpz_t order[], int n);
+
+/*@manual pairing_subgroup
+Sets 'out' to the component of 'in', an element of G1, G2 or GT, in
+subgroup 'i': 'in' is the product of its components over all subgroups.
+*/
+void pairing_subgroup_project(element_t out, element_t in, int i,
+    pairing_t pairing);
+
+/*@manual pairing_subgroup
+Computes 'out' = 'e'('in1', 'in2') as pairing_apply() does, for an 'in1'
+lying in subgroup 'i'. Type A1 then runs the Miller loop over the order
+of the subgroup rather than r; other types compute the full pairing. The
+result is wrong if 'in1' lies outside the subgroup.
+*/
+void pairing_apply_subgroup(element_t out, element_t in1, element_t in2,
+    int i, pairing_t pairing);
+
+/*@manual pairing_subgroup
+Computes 'out' = 'e'('in1'[0] + ... + 'in1'[n-1], 'in2'), where 'in1'[i]
+is the component of the first input in subgroup i (the identity if it
+has none) and n the number of subgroups: the subgroup pairings of the
+components, recombined. Schemes that build their elements from subgroup
+generators hold these components anyway; projecting an arbitrary
+element costs more than the pairing it saves.
+*/
+void pairing_apply_crt(element_t out, element_t in1[], element_t in2,
+    pairing_t pairing);
+
+/*@manual pairing_subgroup
+Same as *element_pp_init* for an 'in' lying in subgroup 'i' (of G1, G2
+or GT), with a table sized to the order of the subgroup rather than r.
+Exponentiate with pairing_subgroup_pp_pow().
+*/
+void pairing_subgroup_pp_init(element_pp_t p, element_t in, int i,
+    pairing_t pairing);
+
+/*@manual pairing_subgroup
+Same as *element_pp_pow* for a table of pairing_subgroup_pp_init(),
+reducing 'power' modulo the order of subgroup 'i'.
+*/
+void pairing_subgroup_pp_pow(element_t out, mpz_t power, element_pp_t p,
+    int i, pairing_t pairing);
 
 /*@manual pairing_op
 Returns true if G1 and G2 are the same group.
@@ -8,6 +8,9 @@ struct pbc_param_interface_s {
   void (*clear)(void *);
   void (*init_pairing)(struct pairing_s *, void *);
   void (*out_str)(FILE *stream, void *data);
+  // Writes the derived constants of 'pairing' for pbc_param_out_bin().
+  // NULL if the type has none worth storing.
+  void (*out_precomp)(FILE *stream, struct pairing_s *pairing);
 };
 typedef struct pbc_param_interface_s pbc_param_interface_t[1];
 typedef struct pbc_param_interface_s *pbc_param_interface_ptr;
@@ -28,10 +31,21 @@ int pbc_param_init_set_str(pbc_param_t par, const char *s);
 /*@manual param
 Same, but read at most 'len' bytes.
 If 'len' is 0, it behaves as the previous function.
+The buffer may also hold the binary format written by *pbc_param_out_bin*,
+which needs the exact 'len'.
 Returns 0 if successful, 1 otherwise.
 */
 int pbc_param_init_set_buf(pbc_param_t par, const char *s, size_t len);
 
+/*@manual param
+Write pairing parameters to ''stream'' in a binary format that also holds
+constants derived at pairing initialization (for type D, F and G: the curve
+generators, Frobenius coefficients and the base field nonresidue), so
+*pairing_init_set_buf* on the result skips recomputing them.
+Returns 0 if successful, 1 otherwise.
+*/
+int pbc_param_out_bin(FILE *stream, pbc_param_ptr p);
+
 /*@manual param
 Write pairing parameters to ''stream'' in a text format.
 */
@@ -9,6 +9,15 @@ on Linux one might use `/dev/random`.
 */
 void pbc_random_set_file(char *filename);
 
+/*@manual pbcrandom
+Uses the operating system generator: `getrandom()` where available,
+otherwise `/dev/urandom` kept open. Bytes are fetched in large chunks
+and buffered, so most calls make no system call at all. The buffer is
+locked, so threads drawing at once never share bytes.
+This is the default source. Returns 0 on success, -1 on failure.
+*/
+int pbc_random_set_os(void);
+
 /*@manual pbcrandom
 Uses a determinstic random number generator, seeded with 'seed'.
 */
@@ -29,4 +38,58 @@ Selects a random 'bits'-bit integer 'z'.
 */
 void pbc_mpz_randomb(mpz_t z, unsigned int bits);
 
+/*@manual pbcrandom
+A source of random numbers that can be owned by one thread or one
+object, independently of the global source set by the functions above.
+*/
+struct pbc_random_ctx_s {
+  void (*fun)(mpz_t, mpz_t, void *);
+  void *data;
+  void (*clear)(void *);
+};
+typedef struct pbc_random_ctx_s pbc_random_ctx_t[1];
+typedef struct pbc_random_ctx_s *pbc_random_ctx_ptr;
+
+/*@manual pbcrandom
+Initializes 'ctx' to call 'fun' with 'data'. 'data' is not freed by
+*pbc_random_ctx_clear*.
+*/
+void pbc_random_ctx_init_function(pbc_random_ctx_t ctx,
+    void (*fun)(mpz_t, mpz_t, void *), void *data);
+
+/*@manual pbcrandom
+Initializes 'ctx' with its own deterministic generator seeded with 'seed'.
+*/
+void pbc_random_ctx_init_deterministic(pbc_random_ctx_t ctx, unsigned int seed);
+
+/*@manual pbcrandom
+Initializes 'ctx' to read random bytes from 'filename', for example
+`/dev/urandom`. The file is kept open and read in large chunks.
+Returns 0 on success, -1 if the file cannot be opened.
+*/
+int pbc_random_ctx_init_file(pbc_random_ctx_t ctx, const char *filename);
+
+/*@manual pbcrandom
+Initializes 'ctx' with the buffered operating system generator used by
+*pbc_random_set_os*. Returns 0 on success, -1 on failure.
+*/
+int pbc_random_ctx_init_os(pbc_random_ctx_t ctx);
+
+/*@manual pbcrandom
+Frees resources held by 'ctx', unbinding it from the calling thread if bound.
+*/
+void pbc_random_ctx_clear(pbc_random_ctx_t ctx);
+
+/*@manual pbcrandom
+Selects a random 'z' that is less than 'limit' using 'ctx'.
+*/
+void pbc_random_ctx_mpz_random(pbc_random_ctx_t ctx, mpz_t z, mpz_t limit);
+
+/*@manual pbcrandom
+Makes 'ctx' the source for *pbc_mpz_random*, and so for *element_random*,
+in the calling thread only. Pass NULL to return to the global source.
+Returns the previously bound context.
+*/
+pbc_random_ctx_ptr pbc_random_ctx_bind(pbc_random_ctx_ptr ctx);
+
 #endif //__PBC_RANDOM_H__
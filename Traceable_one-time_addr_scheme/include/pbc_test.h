@@ -5,21 +5,27 @@
 
 /*@manual test
 Initializes pairing from file specified as first argument, or from standard
-input if there is no first argument.
+input if there is no first argument. The whole input is read, whatever its
+size; it may be text or binary parameters.
 */
 static inline void pbc_demo_pairing_init(pairing_t pairing, int argc, char **argv) {
-  char s[16384];
+  size_t cap = 16384, count = 0, got;
+  char *s = pbc_malloc(cap);
   FILE *fp = stdin;
 
   if (argc > 1) {
-    fp = fopen(argv[1], "r");
+    fp = fopen(argv[1], "rb");
     if (!fp) pbc_die("error opening %s", argv[1]);
   }
-  size_t count = fread(s, 1, 16384, fp);
-  if (!count) pbc_die("input error");
+  while ((got = fread(s + count, 1, cap - count, fp)) > 0) {
+    count += got;
+    if (count == cap) s = pbc_realloc(s, cap *= 2);
+  }
+  if (ferror(fp) || !count) pbc_die("input error");
   fclose(fp);
 
   if (pairing_init_set_buf(pairing, s, count)) pbc_die("pairing init failed");
+  pbc_free(s);
 }
 
 /*@manual test
@@ -76,6 +76,34 @@ void pbc_error(const char *err, ...)
 #endif
 #endif
 
+// Instruction set extensions the arithmetic can use, see pbc_cpu_features().
+#define PBC_CPU_BMI2        1
+#define PBC_CPU_ADX         2
+#define PBC_CPU_AVX2        4
+#define PBC_CPU_AVX512F     8
+#define PBC_CPU_AVX512IFMA 16
+
+/*@manual utils
+Returns the PBC_CPU_* extensions that both the running CPU and the OS
+support, less any turned off with *pbc_tweak_cpu_features()*. Fields pick
+their routines from these when they are initialized, so one build runs
+the fastest code each machine allows.
+*/
+unsigned pbc_cpu_features(void);
+
+/*@manual utils
+Restricts fields initialized from now on to the extensions in 'mask',
+e.g. 0 for the portable code. Fields already initialized keep their
+routines.
+*/
+void pbc_tweak_cpu_features(unsigned mask);
+
+// Returns 1 if a == b and 0 otherwise, without branching on either.
+static inline int pbc_ct_eq(unsigned int a, unsigned int b) {
+  unsigned int x = a ^ b;
+  return (int) (1 ^ ((x | (0U - x)) >> (sizeof(x) * 8 - 1)));
+}
+
 // For storing small integers in void *
 // C99 standard introduced the intptr_t and uintptr_t types,
 // guaranteed to be able to hold pointers
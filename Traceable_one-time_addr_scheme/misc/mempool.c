@@ -0,0 +1,275 @@
+// Pool allocator for PBC and GMP memory.
+//
+// Blocks up to POOL_MAX_BLOCK bytes come from slabs of POOL_SLAB_SIZE
+// bytes, each slab cut into blocks of one size class. Freed blocks go on
+// a free list of the calling thread, so steady-state allocation takes no
+// lock. A thread that runs out refills from a shared depot, which also
+// receives the lists of exiting threads and the excess of threads that
+// free more than they allocate.
+//
+// Slabs are aligned to their size and recorded in a table, so any pointer
+// can be checked for pool ownership. Pointers the pool does not own, such
+// as large blocks or memory allocated before the pool was installed, go
+// to the allocator that was installed before it.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "pbc_utils.h"
+#include "pbc_memory.h"
+
+#if defined(__GNUC__)
+#define POOL_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define POOL_THREAD_LOCAL __declspec(thread)
+#else
+#define POOL_THREAD_LOCAL _Thread_local
+#endif
+
+#define POOL_SLAB_BITS 16
+#define POOL_SLAB_SIZE ((size_t) 1 << POOL_SLAB_BITS)
+#define POOL_MAX_BLOCK 1024
+// Classes: multiples of 16 bytes up to 256, then of 64 up to 1024.
+#define POOL_CLASSES (16 + 12)
+// Slab table capacity, kept at most 3/4 full: 12288 slabs, 768 MiB.
+#define POOL_TABLE_BITS 14
+#define POOL_TABLE_SIZE (1 << POOL_TABLE_BITS)
+// A thread list longer than this gives half of it back to the depot.
+#define POOL_THREAD_MAX 256
+
+typedef struct block_s {
+  struct block_s *next;
+} block_t;
+
+typedef struct {
+  block_t *head[POOL_CLASSES];
+  int count[POOL_CLASSES];
+  int registered;
+} arena_t;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t arena_key;
+static int pool_installed = 0;
+
+// Slab base | size class, 0 for an empty entry. Entries are never removed.
+static uintptr_t slab_table[POOL_TABLE_SIZE];
+static int slab_count;
+
+static block_t *depot[POOL_CLASSES];
+static POOL_THREAD_LOCAL arena_t arena;
+
+// Allocators installed before the pool, used for what it does not own.
+static void *(*prev_malloc)(size_t);
+static void *(*prev_realloc)(void *, size_t);
+static void (*prev_free)(void *);
+static void *(*prev_gmp_malloc)(size_t);
+static void *(*prev_gmp_realloc)(void *, size_t, size_t);
+static void (*prev_gmp_free)(void *, size_t);
+
+static int size_class(size_t size) {
+  if (size <= 256) return size ? (int) ((size - 1) >> 4) : 0;
+  return 16 + (int) ((size - 257) >> 6);
+}
+
+static size_t class_size(int c) {
+  return c < 16 ? (size_t) (c + 1) << 4 : 256 + ((size_t) (c - 15) << 6);
+}
+
+static unsigned slab_hash(uintptr_t base) {
+  return (unsigned) (((uint64_t) (base >> POOL_SLAB_BITS) * 0x9E3779B97F4A7C15ULL)
+      >> (64 - POOL_TABLE_BITS));
+}
+
+// Size class of the slab holding p, -1 if p is not pool memory.
+static int owner_class(void *p) {
+  uintptr_t base = (uintptr_t) p & ~(uintptr_t) (POOL_SLAB_SIZE - 1);
+  unsigned i = slab_hash(base);
+  for (;;) {
+    uintptr_t e = __atomic_load_n(&slab_table[i], __ATOMIC_ACQUIRE);
+    if (!e) return -1;
+    if ((e & ~(uintptr_t) (POOL_SLAB_SIZE - 1)) == base) {
+      return (int) (e & (POOL_SLAB_SIZE - 1));
+    }
+    i = (i + 1) & (POOL_TABLE_SIZE - 1);
+  }
+}
+
+// Called with pool_lock held. Returns the blocks of a new slab as a list.
+static block_t *slab_new(int c) {
+  void *mem;
+  if (slab_count >= POOL_TABLE_SIZE / 4 * 3) return NULL;
+  if (posix_memalign(&mem, POOL_SLAB_SIZE, POOL_SLAB_SIZE)) return NULL;
+
+  uintptr_t base = (uintptr_t) mem;
+  unsigned i = slab_hash(base);
+  while (slab_table[i]) i = (i + 1) & (POOL_TABLE_SIZE - 1);
+  __atomic_store_n(&slab_table[i], base | (uintptr_t) c, __ATOMIC_RELEASE);
+  slab_count++;
+
+  size_t size = class_size(c);
+  size_t n = POOL_SLAB_SIZE / size;
+  block_t *head = NULL;
+  while (n--) {
+    block_t *b = (block_t *) (void *) ((char *) mem + n * size);
+    b->next = head;
+    head = b;
+  }
+  return head;
+}
+
+// Gives the lists of an exiting thread back to the depot.
+static void arena_release(void *data) {
+  arena_t *a = data;
+  int c;
+  pthread_mutex_lock(&pool_lock);
+  for (c = 0; c < POOL_CLASSES; c++) {
+    block_t *b = a->head[c];
+    while (b) {
+      block_t *next = b->next;
+      b->next = depot[c];
+      depot[c] = b;
+      b = next;
+    }
+    a->head[c] = NULL;
+    a->count[c] = 0;
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
+
+static void pool_key_init(void) {
+  pthread_key_create(&arena_key, arena_release);
+}
+
+static void *pool_alloc(size_t size) {
+  int c = size_class(size);
+  arena_t *a = &arena;
+  block_t *b = a->head[c];
+  if (!b) {
+    if (!a->registered) {
+      pthread_setspecific(arena_key, a);
+      a->registered = 1;
+    }
+    pthread_mutex_lock(&pool_lock);
+    b = depot[c];
+    depot[c] = NULL;
+    if (!b) b = slab_new(c);
+    pthread_mutex_unlock(&pool_lock);
+    if (!b) return NULL;
+    block_t *t;
+    a->count[c] = 0;
+    for (t = b; t; t = t->next) a->count[c]++;
+  }
+  a->head[c] = b->next;
+  a->count[c]--;
+  return b;
+}
+
+static void pool_release(void *p, int c) {
+  arena_t *a = &arena;
+  block_t *b = p;
+#ifdef SAFE_CLEAN
+  memset(p, 0, class_size(c));
+#endif
+  b->next = a->head[c];
+  a->head[c] = b;
+  if (++a->count[c] <= POOL_THREAD_MAX) return;
+
+  // Keep half, hand the rest to the depot.
+  block_t *keep = b;
+  int n;
+  for (n = 1; n < POOL_THREAD_MAX / 2; n++) keep = keep->next;
+  block_t *extra = keep->next;
+  keep->next = NULL;
+  a->count[c] = POOL_THREAD_MAX / 2;
+  pthread_mutex_lock(&pool_lock);
+  while (extra) {
+    block_t *next = extra->next;
+    extra->next = depot[c];
+    depot[c] = extra;
+    extra = next;
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
+
+static void *pool_pbc_malloc(size_t size) {
+  if (size > POOL_MAX_BLOCK) return prev_malloc(size);
+  void *p = pool_alloc(size);
+  return p ? p : prev_malloc(size);
+}
+
+static void pool_pbc_free(void *p) {
+  if (!p) return;
+  int c = owner_class(p);
+  if (c < 0) prev_free(p);
+  else pool_release(p, c);
+}
+
+static void *pool_pbc_realloc(void *p, size_t size) {
+  if (!p) return pool_pbc_malloc(size);
+  int c = owner_class(p);
+  if (c < 0) return prev_realloc(p, size);
+  size_t old = class_size(c);
+  if (size <= old) return p;
+  void *q = pool_pbc_malloc(size);
+  if (!q) return NULL;
+  memcpy(q, p, old < size ? old : size);
+  pool_release(p, c);
+  return q;
+}
+
+static void *pool_gmp_malloc(size_t size) {
+  if (size > POOL_MAX_BLOCK) return prev_gmp_malloc(size);
+  void *p = pool_alloc(size);
+  return p ? p : prev_gmp_malloc(size);
+}
+
+static void pool_gmp_free(void *p, size_t size) {
+  if (!p) return;
+  int c = owner_class(p);
+  if (c < 0) prev_gmp_free(p, size);
+  else pool_release(p, c);
+}
+
+static void *pool_gmp_realloc(void *p, size_t old_size, size_t new_size) {
+  if (!p) return pool_gmp_malloc(new_size);
+  int c = owner_class(p);
+  if (c < 0) return prev_gmp_realloc(p, old_size, new_size);
+  if (new_size <= class_size(c)) return p;
+  void *q = pool_gmp_malloc(new_size);
+  if (!q) pbc_die("realloc() error");
+  memcpy(q, p, old_size < new_size ? old_size : new_size);
+  pool_release(p, c);
+  return q;
+}
+
+int pbc_pool_enable(void) {
+  pthread_once(&pool_once, pool_key_init);
+  pthread_mutex_lock(&pool_lock);
+  if (pool_installed) {
+    pthread_mutex_unlock(&pool_lock);
+    return 1;
+  }
+  prev_malloc = pbc_malloc;
+  prev_realloc = pbc_realloc;
+  prev_free = pbc_free;
+  mp_get_memory_functions(&prev_gmp_malloc, &prev_gmp_realloc, &prev_gmp_free);
+  pbc_set_memory_functions(pool_pbc_malloc, pool_pbc_realloc, pool_pbc_free);
+  mp_set_memory_functions(pool_gmp_malloc, pool_gmp_realloc, pool_gmp_free);
+  pool_installed = 1;
+  pthread_mutex_unlock(&pool_lock);
+  return 0;
+}
+
+int pbc_pool_enabled(void) {
+  return __atomic_load_n(&pool_installed, __ATOMIC_ACQUIRE);
+}
+
+size_t pbc_pool_bytes(void) {
+  pthread_mutex_lock(&pool_lock);
+  size_t bytes = (size_t) slab_count * POOL_SLAB_SIZE;
+  pthread_mutex_unlock(&pool_lock);
+  return bytes;
+}
@@ -1,3 +1,4 @@
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "pbc_memory.h"
@@ -7,12 +8,30 @@
 struct entry_s {
   char *key;
   void *data;
+  uint32_t hash;
 };
 typedef struct entry_s *entry_ptr;
 typedef struct entry_s entry_t[1];
 
+// FNV-1a.
+static uint32_t hash(const char *key) {
+  uint32_t h = 2166136261u;
+  while (*key) {
+    h ^= (unsigned char) *key++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void alloc_slots(symtab_t t, int n) {
+  t->slot = pbc_malloc(sizeof(int) * n);
+  memset(t->slot, 0, sizeof(int) * n);
+  t->mask = n - 1;
+}
+
 void symtab_init(symtab_t t) {
   darray_init(t->list);
+  alloc_slots(t, 16);
 }
 
 static void clear(void *data) {
@@ -24,38 +43,61 @@ static void clear(void *data) {
 void symtab_clear(symtab_t t) {
   darray_forall(t->list, clear);
   darray_clear(t->list);
+  pbc_free(t->slot);
 }
 
-void symtab_put(symtab_t t, void *data, const char *key) {
+// Returns the slot holding 'key', or the empty slot where it would go.
+static int *find(symtab_t t, const char *key, uint32_t h) {
+  int i = h & t->mask;
+  for (;;) {
+    int *s = t->slot + i;
+    if (!*s) return s;
+    entry_ptr e = t->list->item[*s - 1];
+    if (e->hash == h && !strcmp(e->key, key)) return s;
+    i = (i + 1) & t->mask;
+  }
+}
+
+// Doubles the table and reinserts every entry.
+static void grow(symtab_t t) {
   int i, n = t->list->count;
+  pbc_free(t->slot);
+  alloc_slots(t, 2 * (t->mask + 1));
+  for (i = 0; i < n; i++) {
+    entry_ptr e = t->list->item[i];
+    int j = e->hash & t->mask;
+    while (t->slot[j]) j = (j + 1) & t->mask;
+    t->slot[j] = i + 1;
+  }
+}
+
+void symtab_put(symtab_t t, void *data, const char *key) {
+  uint32_t h = hash(key);
+  int *s = find(t, key, h);
   entry_ptr e;
-  for (i=0; i<n; i++) {
-    e = t->list->item[i];
-    if (!strcmp(e->key, key)) goto doit;
+  if (*s) {
+    e = t->list->item[*s - 1];
+    e->data = data;
+    return;
   }
   e = pbc_malloc(sizeof(entry_t));
   e->key = pbc_strdup(key);
-  darray_append(t->list, e);
-doit:
   e->data = data;
+  e->hash = h;
+  darray_append(t->list, e);
+  *s = t->list->count;
+  // Keep the load factor at most 1/2.
+  if (2 * t->list->count > t->mask + 1) grow(t);
 }
 
 int symtab_has(symtab_t t, const char *key) {
-  int i, n = t->list->count;
-  for (i = 0; i < n; i++) {
-    entry_ptr e = t->list->item[i];
-    if (!strcmp(e->key, key)) return 1;
-  }
-  return 0;
+  return *find(t, key, hash(key)) != 0;
 }
 
 void *symtab_at(symtab_t t, const char *key) {
-  int i, n = t->list->count;
-  for (i=0; i<n; i++) {
-    entry_ptr e = t->list->item[i];
-    if (!strcmp(e->key, key)) return e->data;
-  }
-  return NULL;
+  int *s = find(t, key, hash(key));
+  if (!*s) return NULL;
+  return ((entry_ptr) t->list->item[*s - 1])->data;
 }
 
 void symtab_forall_data(symtab_t t, void (*func)(void *)) {
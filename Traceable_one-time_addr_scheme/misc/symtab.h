@@ -5,8 +5,13 @@
 
 #pragma GCC visibility push(hidden)
 
+// Entries are kept in insertion order in 'list', and found through an
+// open-addressing hash table with linear probing whose slots hold an index
+// into 'list' plus one, or 0 if empty.
 struct symtab_s {
     darray_t list;
+    int *slot;
+    int mask;
 };
 typedef struct symtab_s symtab_t[1];
 typedef struct symtab_s *symtab_ptr;
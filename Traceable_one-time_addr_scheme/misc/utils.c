@@ -7,6 +7,11 @@
 #include "pbc_utils.h"
 #include "pbc_field.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PBC_CPUID
+#include <cpuid.h>
+#endif
+
 static int pbc_msg_to_stderr = 1;
 
 int pbc_set_msg_to_stderr(int i) {
@@ -99,3 +104,47 @@ void pbc_error(const char *err, ...) {
   report("error: ", err, params);
   va_end(params);
 }
+
+static unsigned cpu_mask = ~0U;
+
+#ifdef PBC_CPUID
+static unsigned cpu_detect(void) {
+  unsigned int a, b, c, d, xcr0 = 0, f = 0;
+  if (!__get_cpuid(1, &a, &b, &c, &d)) return 0;
+  // Wide registers are only usable once the OS saves them.
+  if (c & bit_OSXSAVE) {
+    unsigned int hi;
+    __asm__("xgetbv" : "=a" (xcr0), "=d" (hi) : "c" (0));
+    UNUSED_VAR(hi);
+  }
+  if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return 0;
+  if (b & bit_BMI2) f |= PBC_CPU_BMI2;
+  if (b & bit_ADX) f |= PBC_CPU_ADX;
+  if ((xcr0 & 0x6) == 0x6 && (b & bit_AVX2)) f |= PBC_CPU_AVX2;
+  // Opmask and all of the zmm registers.
+  if ((xcr0 & 0xe6) == 0xe6 && (b & bit_AVX512F)) {
+    f |= PBC_CPU_AVX512F;
+    if (b & bit_AVX512IFMA) f |= PBC_CPU_AVX512IFMA;
+  }
+  return f;
+}
+#else
+static unsigned cpu_detect(void) {
+  return 0;
+}
+#endif
+
+unsigned pbc_cpu_features(void) {
+  // Racing first calls store the same value.
+  static volatile int done;
+  static volatile unsigned detected;
+  if (!done) {
+    detected = cpu_detect();
+    done = 1;
+  }
+  return detected & cpu_mask;
+}
+
+void pbc_tweak_cpu_features(unsigned mask) {
+  cpu_mask = mask;
+}
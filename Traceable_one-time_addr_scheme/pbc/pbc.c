@@ -1,15 +1,21 @@
 // Pairing-Based Calculator.
+//
+// Each statement is compiled to bytecode for a small register machine and
+// then run. Values are reference counted and freed with their last
+// reference. A register whose element dies keeps it for the next result of
+// the same field, so a statement run over and over, such as the body of a
+// recursive function, reuses its temporaries instead of allocating them.
 
-// TODO: Garbage collection.
 // TODO: Recursion (stack frames), anonymous functions.
 
-#include <unistd.h>  // For getopt.
+#include <getopt.h>  // For getopt_long.
 
 #include "pbc.h"
 #include "pbc_fp.h"
 #include "pbc_z.h"
 #include "pbc_multiz.h"
 #include "pbc_poly.h"
+#include "pbc_test.h"  // For pbc_get_time.
 
 #include "misc/darray.h"
 #include "misc/symtab.h"
@@ -21,6 +27,7 @@
 
 int option_easy = 0;
 const char *option_prompt;
+static int option_time = 0;
 
 char *pbc_getline(const char *prompt);
 
@@ -34,7 +41,7 @@ static symtab_t tab;
 
 static field_t M;
 static field_t Z;
-static pairing_t pairing;
+static pairing_ptr pairing;
 
 struct val_s;
 typedef struct val_s *val_ptr;
@@ -42,10 +49,27 @@ typedef struct val_s *val_ptr;
 struct fun_s;
 typedef struct fun_s *fun_ptr;
 
+struct code_s;
+typedef struct code_s *code_ptr;
+
+enum {
+  T_ELEM,
+  T_ID,
+  T_FUN,
+  T_LIST,
+  T_TERNARY,
+  T_FUNCALL,
+  T_ASSIGN,
+  T_DEFINE,
+  // Statement and parameter lists.
+  T_LIST_OF_TREES,
+};
+
 // Syntax tree node.
 struct tree_s {
-  // Evaluates this node.
-  val_ptr (*eval)(tree_ptr);
+  int kind;
+  // Input line the node was read on.
+  int line;
   union {
     const char *id;
     element_ptr elem;
@@ -67,10 +91,11 @@ struct val_type_s {
   char *name;
   // Print out current value.
   void (*out_str)(FILE *, val_ptr);
-  // Called when a variable is evaluated, e.g. "foo;".
-  val_ptr (*eval)(val_ptr);
-  // Called when a variable is used as a function, e.g. "foo();".
-  val_ptr (*funcall)(val_ptr, tree_ptr);
+  // Called when a variable is used as a function, e.g. "foo();", with the
+  // values of the arguments. Returns a new reference.
+  val_ptr (*funcall)(val_ptr, val_ptr[], int);
+  // Frees what the value holds when its last reference goes.
+  void (*clear)(val_ptr);
 };
 
 // Functions plus type checking data.
@@ -82,14 +107,23 @@ struct fun_s {
 };
 typedef struct fun_s fun_t[1];
 
-// When interpreting, each node of the syntax tree recursively evaluates
-// its children then returns a val_ptr.
+// User-defined function.
+struct def_s {
+  char *name;
+  int parmcount;
+  char **parm;
+  int stmtcount;
+  code_ptr *stmt;
+};
+typedef struct def_s *def_ptr;
+
 struct val_s {
   struct val_type_s *type;
+  int refs;
   union {
     element_ptr elem;
     // User-defined function.
-    tree_ptr def;
+    def_ptr def;
     // Built-in function.
     fun_ptr fun;
     field_ptr field;
@@ -97,24 +131,101 @@ struct val_s {
   };
 };
 
+// Instructions. The registers of a statement are numbered from 0, and an
+// expression compiled into register r only uses r and those above it.
+enum {
+  // r[dst] = the value p.
+  OP_CONST,
+  // r[dst] = the variable named p.
+  OP_LOAD,
+  // r[dst] = r[dst + n](r[dst], ..., r[dst + n - 1]).
+  OP_CALL,
+  // r[dst] = [r[dst], ..., r[dst + n - 1]].
+  OP_LIST,
+  // Falls through if r[dst] is a nonzero element, goes to a if it is
+  // zero, otherwise makes it an error and goes to n.
+  OP_BRANCH,
+  // Goes to a.
+  OP_JUMP,
+  // The variable named p = r[dst].
+  OP_ASSIGN,
+  // Defines the function p, r[dst] = p.
+  OP_DEFINE,
+};
+
+struct insn_s {
+  int op, dst, a, n;
+  void *p;
+};
+
+// A register holds a value, and an element left by an earlier value
+// for the next result of the same field.
+struct reg_s {
+  val_ptr val;
+  element_ptr spare;
+};
+
+// Running time of a statement, for --time.
+struct stat_s {
+  int line;
+  long calls;
+  double time;
+};
+
+// A compiled statement.
+struct code_s {
+  struct insn_s *insn;
+  int len, max;
+  int regcount;
+  // Registers, used by all runs but one that starts while another is
+  // still going, which gets its own.
+  struct reg_s *reg;
+  int running;
+  // Set if the statement is an assignment, whose value is not printed.
+  int assign;
+  struct stat_s *stat;
+};
+
+// Statistics of every statement compiled, for --time.
+static darray_t stats;
+
+static struct val_type_s v_elem[1], v_field[1], v_fun[1], v_def[1], v_error[1];
+
 static val_ptr val_new_element(element_ptr e);
 static val_ptr val_new_field(field_ptr e);
 static val_ptr val_new_error(const char *msg, ...);
+static val_ptr code_run(code_ptr c);
+static void code_free(code_ptr c);
 
-// Evaluates syntax tree node.
-static val_ptr tree_eval(tree_ptr t) {
-  return t->eval(t);
+static val_ptr val_ref(val_ptr v) {
+  if (v) v->refs++;
+  return v;
+}
+
+static void val_unref(val_ptr v) {
+  if (!v || --v->refs) return;
+  if (v->type->clear) v->type->clear(v);
+  pbc_free(v);
+}
+
+static void val_unref_void(void *v) {
+  val_unref(v);
+}
+
+// Sets variable id to v, taking over the reference.
+static void put_var(const char *id, val_ptr v) {
+  val_ptr old = symtab_at(tab, id);
+  symtab_put(tab, v, id);
+  val_unref(old);
 }
 
 static void v_elem_out(FILE* stream, val_ptr v) {
   element_out_str(stream, 0, v->elem);
 }
 
-static val_ptr v_elem_eval(val_ptr v) {
-  element_ptr e = pbc_malloc(sizeof(*e));
-  element_init_same_as(e, v->elem);
-  element_set(e, v->elem);
-  return val_new_element(e);
+static void v_elem_clear(val_ptr v) {
+  // A list may have taken over the element.
+  if (v->elem) element_free(v->elem);
 }
 
 static void v_builtin_out(FILE* stream, val_ptr v) {
@@ -124,57 +235,64 @@ static void v_builtin_out(FILE* stream, val_ptr v) {
 }
 
 static void v_define_out(FILE* stream, val_ptr v) {
-  fprintf(stream, "user-defined function %s",
-      ((tree_ptr) darray_at(v->def->child, 0))->id);
+  fprintf(stream, "user-defined function %s", v->def->name);
+}
+
+static void v_define_clear(val_ptr v) {
+  def_ptr def = v->def;
+  int i;
+  for (i = 0; i < def->parmcount; i++) pbc_free(def->parm[i]);
+  for (i = 0; i < def->stmtcount; i++) code_free(def->stmt[i]);
+  pbc_free(def->parm);
+  pbc_free(def->stmt);
+  pbc_free(def->name);
+  pbc_free(def);
 }
 
-static val_ptr v_builtin(val_ptr v, tree_ptr t) {
+static val_ptr v_builtin(val_ptr v, val_ptr arg[], int n) {
   fun_ptr fun = v->fun;
-  int n = fun->arity;
-  if (1 + n != darray_count(t->child)) {
+  val_ptr res;
+  int i;
+  if (n != fun->arity) {
     return val_new_error("%s: wrong number of arguments", fun->name);
   }
-  val_ptr arg[n];
-  int i;
   for(i = 0; i < n; i++) {
-    arg[i] = tree_eval(darray_at(t->child, i));
-    if (fun->sig[i] && arg[i]->type != fun->sig[i]) {
+    if (!arg[i] || (fun->sig[i] && arg[i]->type != fun->sig[i])) {
       return val_new_error("%s: argument %d type mismatch", fun->name, i + 1);
     }
   }
-  return fun->run(arg);
-}
-
-static void eval_stmt(void *ptr) {
-  tree_eval(ptr);
+  // Built-ins either return their first argument, modified in place,
+  // or a new value.
+  res = fun->run(arg);
+  if (n && res == arg[0]) val_ref(res);
+  return res;
 }
 
-static val_ptr v_def_call(val_ptr v, tree_ptr t) {
+static val_ptr v_def_call(val_ptr v, val_ptr arg[], int n) {
+  def_ptr def = v->def;
   int i;
-  const char* name = ((tree_ptr) darray_at(v->def->child, 0))->id;
-  darray_ptr parm = ((tree_ptr) darray_at(v->def->child, 1))->child;
-  int n = darray_count(parm);
-  if (1 + n != darray_count(t->child)) {
-    return val_new_error("%s: wrong number of arguments", name);
+  if (n != def->parmcount) {
+    return val_new_error("%s: wrong number of arguments", def->name);
   }
   for(i = 0; i < n; i++) {
-    const char *id = ((tree_ptr) darray_at(parm, i))->id;
-    val_ptr v1 = tree_eval(darray_at(t->child, i));
     // TODO: Stack frames for recursion.
-    symtab_put(tab, v1, id);
+    put_var(def->parm[i], val_ref(arg[i]));
   }
   // Evaluate function body.
-  darray_ptr a = ((tree_ptr) darray_at(v->def->child, 2))->child;
-  darray_forall(a, eval_stmt);
+  for(i = 0; i < def->stmtcount; i++) {
+    val_unref(code_run(def->stmt[i]));
+  }
   return NULL;
 }
 
-static val_ptr v_field_cast(val_ptr v, tree_ptr t) {
-  // TODO: Check args, x is an element.
-  val_ptr x = tree_eval(darray_at(t->child, 0));
+static val_ptr v_field_cast(val_ptr v, val_ptr arg[], int n) {
+  if (n != 1 || !arg[0]) return val_new_error("cast: one element expected");
+  val_ptr x = arg[0];
+  if (x->type == v_error) return val_ref(x);
+  if (x->type != v_elem) return val_new_error("cast: element expected");
   element_ptr e = x->elem;
   if (e->field == M) {
-    if (v->field == M) return x;
+    if (v->field == M) return val_ref(x);
     element_ptr e2 = element_new(v->field);
     if (element_is0(e)) // if 'set0' is not 'set1' in base field of GT, but we hope 'GT(0)' calls 'set1', we may directly call 'element_set0' here
       element_set0(e2);
@@ -182,8 +300,9 @@ static val_ptr v_field_cast(val_ptr v, tree_ptr t) {
       element_set1(e2);
     else
       element_set_multiz(e2, e->data);
+    element_free(e);
     x->elem = e2;
-    return x;
+    return val_ref(x);
   }
   if (v->field == M) {
     // Map to/from integer. TODO: Map to/from multiz instead.
@@ -195,33 +314,36 @@ static val_ptr v_field_cast(val_ptr v, tree_ptr t) {
     element_set_mpz(e, z);
     mpz_clear(z);
   }
-  return x;
+  return val_ref(x);
 }
 
 static void v_field_out(FILE* stream, val_ptr v) {
   field_out_info(stream, v->field);
 }
 
-static val_ptr v_self(val_ptr v) {
-  return v;
-}
-
 static void v_err_out(FILE* stream, val_ptr v) {
   fprintf(stream, "%s", v->msg);
 }
 
-static val_ptr v_errcall(val_ptr v, tree_ptr t) {
-  UNUSED_VAR(t);
-  return v;
+static void v_err_clear(val_ptr v) {
+  pbc_free((char *) v->msg);
+}
+
+static val_ptr v_errcall(val_ptr v, val_ptr arg[], int n) {
+  UNUSED_VAR(arg);
+  UNUSED_VAR(n);
+  return val_ref(v);
 }
 
+// Fields live as long as the program, as elements of them may outlive
+// the values that made them.
 static struct val_type_s
   // TODO: Replace NULL with get_coeff.
-  v_elem[1]  = {{  "element",    v_elem_out, v_elem_eval, NULL }},
-  v_field[1] = {{    "field",   v_field_out,      v_self, v_field_cast }},
-  v_fun[1]   = {{  "builtin", v_builtin_out,      v_self, v_builtin }},
-  v_def[1]   = {{ "function",  v_define_out,      v_self, v_def_call }},
-  v_error[1] = {{    "error",     v_err_out,      v_self, v_errcall }};
+  v_elem[1]  = {{  "element",    v_elem_out,         NULL, v_elem_clear }},
+  v_field[1] = {{    "field",   v_field_out, v_field_cast, NULL }},
+  v_fun[1]   = {{  "builtin", v_builtin_out,    v_builtin, NULL }},
+  v_def[1]   = {{ "function",  v_define_out,   v_def_call, v_define_clear }},
+  v_error[1] = {{    "error",     v_err_out,    v_errcall, v_err_clear }};
 
 // Function signature constants for type checking.
 const struct val_type_s *sig_field[] = { v_field };
@@ -230,16 +352,21 @@ const struct val_type_s *sig_any[] = { NULL };
 const struct val_type_s *sig_elem_elem[] = { v_elem, v_elem };
 const struct val_type_s *sig_field_elem[] = { v_field, v_elem };
 
-static val_ptr val_new_element(element_ptr e) {
+static val_ptr val_new(struct val_type_s *type) {
   val_ptr v = pbc_malloc(sizeof(*v));
-  v->type = v_elem;
+  v->type = type;
+  v->refs = 1;
+  return v;
+}
+
+static val_ptr val_new_element(element_ptr e) {
+  val_ptr v = val_new(v_elem);
   v->elem = e;
   return v;
 }
 
 static val_ptr val_new_field(field_ptr f) {
-  val_ptr v = pbc_malloc(sizeof(*v));
-  v->type = v_field;
+  val_ptr v = val_new(v_field);
   v->field = f;
   return v;
 }
@@ -252,15 +379,13 @@ static val_ptr val_new_error(const char *msg, ...) {
   vsnprintf(buf, 80, msg, params);
   va_end(params);
 
-  val_ptr v = pbc_malloc(sizeof(*v));
-  v->type = v_error;
+  val_ptr v = val_new(v_error);
   v->msg = pbc_strdup(buf);
   return v;
 }
 
 static val_ptr val_new_fun(fun_ptr fun) {
-  val_ptr v = pbc_malloc(sizeof(*v));
-  v->type = v_fun;
+  val_ptr v = val_new(v_fun);
   v->fun = fun;
   return v;
 }
@@ -289,6 +414,7 @@ static val_ptr fun_cmp(val_ptr v[], int (*fun)(int)) {
   element_ptr e = pbc_malloc(sizeof(*e));
   element_init(e, M);
   element_set_si(e, fun(i));
+  element_free(v[0]->elem);
   v[0]->elem = e;
   return v[0];
 }
@@ -346,88 +472,374 @@ static fun_t fun_ge = {{ ">=", run_ge, 2, sig_elem_elem }};
 static fun_t fun_lt = {{ "<", run_lt, 2, sig_elem_elem }};
 static fun_t fun_gt = {{ ">", run_gt, 2, sig_elem_elem }};
 
-static val_ptr eval_elem(tree_ptr t) {
-  // TODO: Write element_clone(), or at least element_new().
+static val_ptr run_neg(val_ptr v[]) {
+  element_neg(v[0]->elem, v[0]->elem);
+  return v[0];
+}
+static fun_t fun_neg = {{ "neg", run_neg, 1, sig_elem }};
+
+static val_ptr run_item(val_ptr v[]) {
+  mpz_t z;
+  mpz_init(z);
+  element_to_mpz(z, v[1]->elem);
+  int i = mpz_get_si(z);
+  mpz_clear(z);
+  element_ptr a = element_item(v[0]->elem, i);
   element_ptr e = pbc_malloc(sizeof(*e));
-  element_init_same_as(e, t->elem);
-  element_set(e, t->elem);
+  element_init_same_as(e, a);
+  element_set(e, a);
   return val_new_element(e);
 }
+static fun_t fun_item = {{ "item", run_item, 2, sig_elem_elem }};
+
+// Puts v in register r, keeping the element of the value this drops if
+// nothing else holds it.
+static void reg_set(struct reg_s *r, val_ptr v) {
+  val_ptr old = r->val;
+  r->val = v;
+  if (!old) return;
+  if (old->refs == 1 && old->type == v_elem && old->elem) {
+    if (r->spare) element_free(r->spare);
+    r->spare = old->elem;
+    pbc_free(old);
+    return;
+  }
+  val_unref(old);
+}
+
+// Makes sure no variable or other register shares the element in r,
+// so that a built-in may overwrite it.
+static void reg_own(struct reg_s *r) {
+  val_ptr v = r->val;
+  element_ptr e;
+  if (!v || v->refs == 1 || v->type != v_elem) return;
+  e = r->spare;
+  if (e && e->field == v->elem->field) {
+    r->spare = NULL;
+  } else {
+    e = element_new(v->elem->field);
+  }
+  element_set(e, v->elem);
+  val_unref(v);
+  r->val = val_new_element(e);
+}
+
+static struct reg_s *regs_new(int n) {
+  struct reg_s *reg = pbc_malloc(sizeof(*reg) * n);
+  int i;
+  for (i = 0; i < n; i++) {
+    reg[i].val = NULL;
+    reg[i].spare = NULL;
+  }
+  return reg;
+}
 
-static val_ptr eval_list(tree_ptr t) {
+static void regs_free(struct reg_s *reg, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    val_unref(reg[i].val);
+    if (reg[i].spare) element_free(reg[i].spare);
+  }
+  pbc_free(reg);
+}
+
+static val_ptr run_call(struct reg_s *r, int n) {
+  val_ptr f = r[n].val;
+  val_ptr arg[n + 1];
+  int i;
+  if (!f) return val_new_error("no function to call");
+  if (!f->type->funcall) {
+    return val_new_error("%s is not a function", f->type->name);
+  }
+  // Built-ins and casts work on their first argument in place.
+  if (n && (f->type == v_fun || f->type == v_field)) reg_own(r);
+  for (i = 0; i < n; i++) arg[i] = r[i].val;
+  return f->type->funcall(f, arg, n);
+}
+
+static val_ptr run_list(struct reg_s *r, int n) {
   element_ptr e = NULL;
-  int n = darray_count(t->child);
   int i;
-  for(i = 0; i < n; i++) {
-    val_ptr x = tree_eval(darray_at(t->child, i));
+  for (i = 0; i < n; i++) {
+    val_ptr x = r[i].val;
     // TODO: Also check x is a multiz.
-    if (v_error == x->type) {
-      return x;
+    if (x && v_error == x->type) {
+      return val_ref(x);
     }
-    if (v_elem != x->type) {
+    if (!x || v_elem != x->type) {
       return val_new_error("element expected in list");
     }
+  }
+  for (i = 0; i < n; i++) {
+    val_ptr x;
+    // The list takes over the data of the items.
+    reg_own(&r[i]);
+    x = r[i].val;
     if (!i) e = multiz_new_list(x->elem);
     else multiz_append(e, x->elem);
+    pbc_free(x->elem);
+    x->elem = NULL;
   }
   return val_new_element(e);
 }
 
-static val_ptr eval_ternary(tree_ptr t) {
-  val_ptr x = tree_eval(darray_at(t->child, 0));
-  if (v_error == x->type) {
-    return x;
+static val_ptr code_run(code_ptr c) {
+  struct reg_s *reg = c->reg;
+  val_ptr res;
+  double t0 = 0;
+  int pc, i;
+
+  if (c->running) reg = regs_new(c->regcount);
+  c->running++;
+  if (c->stat) t0 = pbc_get_time();
+  for (pc = 0; pc < c->len; pc++) {
+    struct insn_s *in = &c->insn[pc];
+    struct reg_s *r = &reg[in->dst];
+    switch (in->op) {
+      case OP_CONST:
+        reg_set(r, val_ref(in->p));
+        break;
+      case OP_LOAD: {
+        val_ptr x = symtab_at(reserved, in->p);
+        if (!x) x = symtab_at(tab, in->p);
+        reg_set(r, x ? val_ref(x) :
+            val_new_error("undefined variable %s", (char *) in->p));
+        break;
+      }
+      case OP_CALL:
+      case OP_LIST: {
+        int top = in->op == OP_CALL ? in->n : in->n - 1;
+        val_ptr x = in->op == OP_CALL ?
+            run_call(r, in->n) : run_list(r, in->n);
+        for (i = 1; i <= top; i++) reg_set(&r[i], NULL);
+        reg_set(r, x);
+        break;
+      }
+      case OP_BRANCH: {
+        val_ptr x = r->val;
+        if (x && v_error == x->type) {
+          pc = in->n - 1;
+        } else if (!x || v_elem != x->type) {
+          reg_set(r, val_new_error("element expected in ternary operator"));
+          pc = in->n - 1;
+        } else if (element_is0(x->elem)) {
+          pc = in->a - 1;
+        }
+        break;
+      }
+      case OP_JUMP:
+        pc = in->a - 1;
+        break;
+      case OP_ASSIGN:
+        if (symtab_at(reserved, in->p)) {
+          reg_set(r, val_new_error("%s is reserved", (char *) in->p));
+        } else {
+          put_var(in->p, val_ref(r->val));
+        }
+        break;
+      case OP_DEFINE: {
+        val_ptr x = in->p;
+        put_var(x->def->name, val_ref(x));
+        reg_set(r, val_ref(x));
+        break;
+      }
+    }
   }
-  if (x->type != v_elem) {
-    return val_new_error("element expected in ternary operator");
+  if (c->stat) {
+    c->stat->calls++;
+    c->stat->time += pbc_get_time() - t0;
   }
-  if (!element_is0(x->elem)) {
-    return tree_eval(darray_at(t->child, 1));
+  c->running--;
+
+  res = reg[0].val;
+  reg[0].val = NULL;
+  if (reg != c->reg) {
+    regs_free(reg, c->regcount);
+  } else {
+    for (i = 1; i < c->regcount; i++) reg_set(&reg[i], NULL);
   }
-  return tree_eval(darray_at(t->child, 2));
+  return res;
 }
 
-static val_ptr eval_id(tree_ptr t) {
-  val_ptr x = symtab_at(reserved, t->id);
-  if (!x) x = symtab_at(tab, t->id);
-  if (!x) {
-    return val_new_error("undefined variable %s", t->id);
+// The first line of the input t was read from; the lookahead may have
+// moved past it by the time t itself is built.
+static int tree_line(tree_ptr t) {
+  int line = t->line;
+  int i;
+  switch (t->kind) {
+    case T_ELEM:
+    case T_ID:
+    case T_FUN:
+      break;
+    default:
+      for (i = 0; i < darray_count(t->child); i++) {
+        int l = tree_line(darray_at(t->child, i));
+        if (l < line) line = l;
+      }
+      break;
   }
-  return x->type->eval(x);
+  return line;
 }
 
-static val_ptr eval_funcall(tree_ptr t) {
-  val_ptr x = tree_eval(darray_last(t->child));
-  return x->type->funcall(x, t);
+static int emit(code_ptr c, int op, int dst, int n, void *p) {
+  struct insn_s *in;
+  if (c->len == c->max) {
+    c->max = c->max ? 2 * c->max : 8;
+    c->insn = pbc_realloc(c->insn, sizeof(*c->insn) * c->max);
+  }
+  in = &c->insn[c->len];
+  in->op = op;
+  in->dst = dst;
+  in->a = 0;
+  in->n = n;
+  in->p = p;
+  return c->len++;
+}
+
+static code_ptr code_compile(tree_ptr t);
+
+static val_ptr def_new(tree_ptr t) {
+  darray_ptr parm = ((tree_ptr) darray_at(t->child, 1))->child;
+  darray_ptr body = ((tree_ptr) darray_at(t->child, 2))->child;
+  def_ptr def = pbc_malloc(sizeof(*def));
+  val_ptr v = val_new(v_def);
+  int i;
+
+  def->name = pbc_strdup(((tree_ptr) darray_at(t->child, 0))->id);
+  def->parmcount = darray_count(parm);
+  def->parm = pbc_malloc(sizeof(char *) * def->parmcount);
+  for (i = 0; i < def->parmcount; i++) {
+    def->parm[i] = pbc_strdup(((tree_ptr) darray_at(parm, i))->id);
+  }
+  def->stmtcount = darray_count(body);
+  def->stmt = pbc_malloc(sizeof(code_ptr) * def->stmtcount);
+  for (i = 0; i < def->stmtcount; i++) {
+    def->stmt[i] = code_compile(darray_at(body, i));
+  }
+  v->def = def;
+  return v;
 }
 
-static val_ptr eval_fun(tree_ptr t) {
-  return val_new_fun(t->fun);
+// Compiles t to leave its value in register r.
+static void compile(code_ptr c, tree_ptr t, int r) {
+  int i, n;
+  if (c->regcount <= r) c->regcount = r + 1;
+  switch (t->kind) {
+    case T_ELEM:
+      // The constant takes over the element of the tree.
+      emit(c, OP_CONST, r, 0, val_new_element(t->elem));
+      t->elem = NULL;
+      break;
+    case T_ID:
+      emit(c, OP_LOAD, r, 0, pbc_strdup(t->id));
+      break;
+    case T_FUN:
+      emit(c, OP_CONST, r, 0, val_new_fun(t->fun));
+      break;
+    case T_FUNCALL:
+      // Arguments, then the function.
+      n = darray_count(t->child) - 1;
+      for (i = 0; i <= n; i++) compile(c, darray_at(t->child, i), r + i);
+      emit(c, OP_CALL, r, n, NULL);
+      break;
+    case T_LIST:
+      n = darray_count(t->child);
+      for (i = 0; i < n; i++) compile(c, darray_at(t->child, i), r + i);
+      emit(c, OP_LIST, r, n, NULL);
+      break;
+    case T_TERNARY: {
+      int branch, jump;
+      compile(c, darray_at(t->child, 0), r);
+      branch = emit(c, OP_BRANCH, r, 0, NULL);
+      compile(c, darray_at(t->child, 1), r);
+      jump = emit(c, OP_JUMP, r, 0, NULL);
+      c->insn[branch].a = c->len;
+      compile(c, darray_at(t->child, 2), r);
+      c->insn[jump].a = c->len;
+      c->insn[branch].n = c->len;
+      break;
+    }
+    case T_ASSIGN:
+      compile(c, darray_at(t->child, 1), r);
+      emit(c, OP_ASSIGN, r, 0,
+          pbc_strdup(((tree_ptr) darray_at(t->child, 0))->id));
+      break;
+    case T_DEFINE:
+      emit(c, OP_DEFINE, r, 0, def_new(t));
+      break;
+    default:
+      pbc_die("BUG: shouldn't reach here!");
+  }
 }
 
-static val_ptr run_neg(val_ptr v[]) {
-  element_neg(v[0]->elem, v[0]->elem);
-  return v[0];
+static code_ptr code_compile(tree_ptr t) {
+  code_ptr c = pbc_malloc(sizeof(*c));
+  c->insn = NULL;
+  c->len = c->max = 0;
+  c->regcount = 1;
+  c->running = 0;
+  c->assign = t->kind == T_ASSIGN;
+  c->stat = NULL;
+  compile(c, t, 0);
+  c->reg = regs_new(c->regcount);
+  if (option_time) {
+    c->stat = pbc_malloc(sizeof(*c->stat));
+    c->stat->line = tree_line(t);
+    c->stat->calls = 0;
+    c->stat->time = 0;
+    darray_append(stats, c->stat);
+  }
+  return c;
 }
-static fun_t fun_neg = {{ "neg", run_neg, 1, sig_elem }};
 
-static val_ptr eval_assign(tree_ptr t) {
-  tree_ptr tid = darray_at(t->child, 0);
-  val_ptr v = tree_eval(darray_at(t->child, 1));
-  if (symtab_at(reserved, tid->id)) {
-    return val_new_error("%s is reserved", tid->id);
+// The statistics outlive the statement.
+static void code_free(code_ptr c) {
+  int i;
+  for (i = 0; i < c->len; i++) {
+    struct insn_s *in = &c->insn[i];
+    switch (in->op) {
+      case OP_CONST:
+      case OP_DEFINE:
+        val_unref(in->p);
+        break;
+      case OP_LOAD:
+      case OP_ASSIGN:
+        pbc_free(in->p);
+        break;
+    }
   }
-  symtab_put(tab, v, tid->id);
-  return v;
+  pbc_free(c->insn);
+  regs_free(c->reg, c->regcount);
+  pbc_free(c);
+}
+
+static void tree_free(void *p) {
+  tree_ptr t = p;
+  switch (t->kind) {
+    case T_ELEM:
+      if (t->elem) element_free(t->elem);
+      break;
+    case T_ID:
+      pbc_free((char *) t->id);
+      break;
+    case T_FUN:
+      break;
+    default:
+      darray_forall(t->child, tree_free);
+      darray_free(t->child);
+      break;
+  }
+  pbc_free(t);
 }
 
 static void assign_field(field_ptr f, const char* s) {
-  symtab_put(tab, val_new_field(f), s);
+  put_var(s, val_new_field(f));
 }
 
-tree_ptr tree_new(val_ptr (*eval)(tree_ptr)) {
+static tree_ptr tree_new(int kind) {
   tree_ptr res = pbc_malloc(sizeof(*res));
-  res->eval = eval;
+  res->kind = kind;
+  res->line = yylineno;
   return res;
 }
 
@@ -435,38 +847,25 @@ tree_ptr tree_new_z(const char* s) {
   element_ptr e = pbc_malloc(sizeof(*e));
   element_init(e, M);
   element_set_str(e, s, 0);
-  tree_ptr t = tree_new(eval_elem);
+  tree_ptr t = tree_new(T_ELEM);
   t->elem = e;
   return t;
 }
 
-static val_ptr eval_err(tree_ptr t) {
-  UNUSED_VAR(t);
-  pbc_die("BUG: shouldn't reach here!");
-}
-
 tree_ptr tree_new_empty_stmt_list() {
-  tree_ptr t = tree_new(eval_err);
+  tree_ptr t = tree_new(T_LIST_OF_TREES);
   t->child = darray_new();
   return t;
 }
 
 tree_ptr tree_new_empty_parms() {
-  tree_ptr t = tree_new(eval_err);
+  tree_ptr t = tree_new(T_LIST_OF_TREES);
   t->child = darray_new();
   return t;
 }
 
-static val_ptr eval_define(tree_ptr t) {
-  val_ptr v = pbc_malloc(sizeof(*v));
-  v->type = v_def;
-  v->def = t;
-  symtab_put(tab, v, ((tree_ptr) darray_at(t->child, 0))->id);
-  return v;
-}
-
 tree_ptr tree_new_define(tree_ptr id, tree_ptr parm, tree_ptr body) {
-  tree_ptr t = tree_new(eval_define);
+  tree_ptr t = tree_new(T_DEFINE);
   t->child = darray_new();
   darray_append(t->child, id);
   darray_append(t->child, parm);
@@ -475,14 +874,14 @@ tree_ptr tree_new_define(tree_ptr id, tree_ptr parm, tree_ptr body) {
 }
 
 tree_ptr tree_new_list(tree_ptr first) {
-  tree_ptr t = tree_new(eval_list);
+  tree_ptr t = tree_new(T_LIST);
   t->child = darray_new();
   darray_append(t->child, first);
   return t;
 }
 
 tree_ptr tree_new_ternary(tree_ptr cond, tree_ptr t1, tree_ptr t2) {
-  tree_ptr t = tree_new(eval_ternary);
+  tree_ptr t = tree_new(T_TERNARY);
   t->child = darray_new();
   darray_append(t->child, cond);
   darray_append(t->child, t1);
@@ -491,19 +890,19 @@ tree_ptr tree_new_ternary(tree_ptr cond, tree_ptr t1, tree_ptr t2) {
 }
 
 tree_ptr tree_new_id(const char* s) {
-  tree_ptr t = tree_new(eval_id);
+  tree_ptr t = tree_new(T_ID);
   t->id = pbc_strdup(s);
   return t;
 }
 
 tree_ptr tree_new_funcall(void) {
-  tree_ptr t = tree_new(eval_funcall);
+  tree_ptr t = tree_new(T_FUNCALL);
   t->child = darray_new();
   return t;
 }
 
 static tree_ptr tree_new_fun(fun_ptr fun) {
-  tree_ptr t = tree_new(eval_fun);
+  tree_ptr t = tree_new(T_FUN);
   t->fun = fun;
   return t;
 }
@@ -530,7 +929,6 @@ static tree_ptr tree_new_unary(fun_ptr fun, tree_ptr x) {
   tree_set_fun(t, tree_new_fun(fun));
   return t;
 }
-
 tree_ptr tree_new_neg(tree_ptr t) {
   return tree_new_unary(fun_neg, t);
 }
@@ -568,26 +966,13 @@ tree_ptr tree_new_gt(tree_ptr x, tree_ptr y) {
   return tree_new_binary(fun_gt, x, y);
 }
 
-static val_ptr run_item(val_ptr v[]) {
-  mpz_t z;
-  mpz_init(z);
-  element_to_mpz(z, v[1]->elem);
-  int i = mpz_get_si(z);
-  mpz_clear(z);
-  element_ptr a = element_item(v[0]->elem, i);
-  element_ptr e = pbc_malloc(sizeof(*e));
-  element_init_same_as(e, a);
-  element_set(e, a);
-  return val_new_element(e);
-}
-static fun_t fun_item = {{ "item", run_item, 2, sig_elem_elem }};
 tree_ptr tree_new_item(tree_ptr x, tree_ptr y) {
   return tree_new_binary(fun_item, x, y);
 }
 
 tree_ptr tree_new_assign(tree_ptr l, tree_ptr r) {
   // TODO: Check l's type.
-  tree_ptr t = tree_new(eval_assign);
+  tree_ptr t = tree_new(T_ASSIGN);
   t->child = darray_new();
   darray_append(t->child, l);
   darray_append(t->child, r);
@@ -596,14 +981,41 @@ tree_ptr tree_new_assign(tree_ptr l, tree_ptr r) {
 
 // Evaluate statement.
 void tree_eval_stmt(tree_ptr stmt) {
-  val_ptr v = tree_eval(stmt);
+  code_ptr c = code_compile(stmt);
+  val_ptr v;
+  tree_free(stmt);
+  v = code_run(c);
   if (v && v_error == v->type) {
     v->type->out_str(stdout, v);
     putchar('\n');
-  } else if (stmt->eval != eval_assign && v) {
+  } else if (!c->assign && v) {
     v->type->out_str(stdout, v);
     putchar('\n');
   }
+  val_unref(v);
+  code_free(c);
+}
+
+static int stat_cmp(const void *a, const void *b) {
+  const struct stat_s *x = *(struct stat_s * const *) a;
+  const struct stat_s *y = *(struct stat_s * const *) b;
+  return x->line - y->line;
+}
+
+// Prints the time spent in each statement, including those in function
+// bodies, by input line.
+static void print_stats(void) {
+  int i;
+  fflush(stdout);
+  qsort(stats->item, stats->count, sizeof(void *), stat_cmp);
+  fprintf(stderr, "%6s %10s %12s %12s\n",
+      "line", "calls", "total ms", "per-call ms");
+  for (i = 0; i < stats->count; i++) {
+    struct stat_s *s = stats->item[i];
+    if (!s->calls) continue;
+    fprintf(stderr, "%6d %10ld %12.3f %12.6f\n", s->line, s->calls,
+        s->time * 1e3, s->time * 1e3 / s->calls);
+  }
 }
 
 static val_ptr run_nextprime(val_ptr v[]) {
@@ -704,7 +1116,9 @@ static val_ptr run_extend(val_ptr v[]) {
 }
 static fun_t fun_extend = {{ "extend", run_extend, 1, sig_field_elem }};
 
+// Elements of the last pairing may still be about, so it is not cleared.
 static void init_pairing(const char *s) {
+  pairing = pbc_malloc(sizeof(*pairing));
   pairing_init_set_str(pairing, s);
   assign_field(pairing->G1, "G1");
   assign_field(pairing->G2, "G2");
@@ -887,14 +1301,21 @@ int yywrap(void) {
 }
 
 int main(int argc, char **argv) {
+  static struct option longopts[] = {
+    {"time", no_argument, 0, 't'},
+    {0, 0, 0, 0},
+  };
   for (;;) {
-    int c = getopt(argc, argv, "y");
+    int c = getopt_long(argc, argv, "yt", longopts, NULL);
     if (c == -1) break;
     switch (c) {
       case 'y':
         option_easy = 1;
         option_prompt = "> ";
         break;
+      case 't':
+        option_time = 1;
+        break;
       default:
         fprintf(stderr, "unrecognized option: %c\n", c);
         break;
@@ -903,7 +1324,11 @@ int main(int argc, char **argv) {
 
   field_init_z(Z);
   field_init_multiz(M);
+  symtab_init(reserved);
   symtab_init(tab);
+  darray_init(stats);
+  // Also reports scripts that call exit().
+  if (option_time) atexit(print_stats);
 
   builtin(fun_rnd);
   builtin(fun_random);
@@ -947,6 +1372,7 @@ int main(int argc, char **argv) {
     putchar('\n');
   }
 
+  symtab_forall_data(tab, val_unref_void);
   symtab_clear(tab);
   field_clear(M);
   return 0;
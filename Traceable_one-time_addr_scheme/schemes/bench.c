@@ -0,0 +1,419 @@
+/****************************************************************************
+ * File: bench.c
+ * Desc: Driver for the scheme benchmarks (see bench.h): warmup plus N
+ *       timed iterations of every operation, per param file, reported
+ *       as JSON (default) or CSV on stdout.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "bench.h"
+
+#define DEFAULT_ITERATIONS 100
+#define DEFAULT_WARMUP     10
+#define DEFAULT_PARAM_DIR  "../param"
+
+static const char *op_names[BENCH_OP_COUNT] = {
+    "keygen", "addr_gen", "recognize", "recognize_fast", "recognize_batch",
+    "skgen", "sign", "verify", "trace"
+};
+
+//----------------------------------------------
+// Counters read around each operation under -p
+//----------------------------------------------
+typedef enum {
+    CTR_CYCLES,
+    CTR_INSTRUCTIONS,
+    CTR_L1D_MISSES,
+    CTR_LLC_MISSES,
+    CTR_BRANCH_MISSES,
+    CTR_ALLOCS,
+    CTR_COUNT
+} ctr_kind_t;
+
+// The ones before CTR_ALLOCS come from perf_event
+#define CTR_EVENTS CTR_ALLOCS
+
+static const char *ctr_names[CTR_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "allocs"
+};
+
+typedef struct {
+    double min, median, p99, mean;
+    int failures;
+    double ctr[CTR_COUNT];       // means per operation under -p
+} op_stats_t;
+
+//----------------------------------------------
+// Timer helper: monotonic clock in ms
+//----------------------------------------------
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+//----------------------------------------------
+// Heap allocation count: malloc / calloc / realloc are wrapped over glibc's
+// own, so the calls of PBC, GMP and OpenSSL are all counted
+//----------------------------------------------
+static unsigned long alloc_count;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) {
+    alloc_count++;
+    return __libc_realloc(p, size);
+}
+#endif
+
+//----------------------------------------------
+// perf_event counters of this process, read as one group led by the
+// first event that opens; events that do not open are left out
+//----------------------------------------------
+static int ctr_leader = -1;
+static int ctr_order[CTR_EVENTS];     // group members in read order
+static int ctr_members;
+static int ctr_available[CTR_COUNT];
+
+#ifdef __linux__
+static int ctr_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, ctr_leader, 0);
+}
+#endif
+
+static void ctr_init(void) {
+#ifdef __linux__
+    static const struct { uint32_t type; uint64_t config; } events[CTR_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    for (int i = 0; i < CTR_EVENTS; i++) {
+        int fd = ctr_open(events[i].type, events[i].config);
+        if (fd < 0) continue;
+        if (ctr_leader < 0) ctr_leader = fd;
+        ctr_order[ctr_members++] = i;
+        ctr_available[i] = 1;
+    }
+#endif
+#ifdef __GLIBC__
+    ctr_available[CTR_ALLOCS] = 1;
+#endif
+}
+
+// Running totals, scaled up when the kernel multiplexed the group
+static void ctr_read(double v[CTR_COUNT]) {
+    memset(v, 0, CTR_COUNT * sizeof(double));
+    v[CTR_ALLOCS] = (double)alloc_count;
+#ifdef __linux__
+    uint64_t buf[3 + CTR_EVENTS];
+    if (ctr_members == 0) return;
+    if (read(ctr_leader, buf, sizeof(buf)) < (ssize_t)((3 + ctr_members) * sizeof(uint64_t)) ||
+        buf[2] == 0)
+        return;
+    double scale = (double)buf[1] / (double)buf[2];
+    for (int i = 0; i < ctr_members; i++) v[ctr_order[i]] = (double)buf[3 + i] * scale;
+#endif
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// Sorts samples in place
+static void compute_stats(op_stats_t *st, double *samples, int n) {
+    double sum = 0;
+    qsort(samples, n, sizeof(double), cmp_double);
+    for (int i = 0; i < n; i++) sum += samples[i];
+    st->min = samples[0];
+    st->median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    // Nearest-rank percentile
+    int rank = (99 * n + 99) / 100;
+    st->p99 = samples[rank - 1];
+    st->mean = sum / n;
+}
+
+//----------------------------------------------
+// Param list: files as given, directories expanded to their *.param
+//----------------------------------------------
+static int add_param(char ***list, int *count, const char *path) {
+    char **grown = realloc(*list, (*count + 1) * sizeof(char *));
+    if (!grown) return 0;
+    *list = grown;
+    (*list)[(*count)++] = strdup(path);
+    return 1;
+}
+
+static int add_param_arg(char ***list, int *count, const char *arg) {
+    struct stat sb;
+    if (stat(arg, &sb) != 0) {
+        fprintf(stderr, "Cannot access %s\n", arg);
+        return 0;
+    }
+    if (!S_ISDIR(sb.st_mode)) return add_param(list, count, arg);
+
+    DIR *dir = opendir(arg);
+    if (!dir) {
+        fprintf(stderr, "Cannot open directory %s\n", arg);
+        return 0;
+    }
+    int first = *count;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (len <= 6 || strcmp(ent->d_name + len - 6, ".param") != 0) continue;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", arg, ent->d_name);
+        if (!add_param(list, count, path)) break;
+    }
+    closedir(dir);
+    qsort(*list + first, *count - first, sizeof(char *), cmp_str);
+    return 1;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+//----------------------------------------------
+// Run one param set; returns 0 if the scheme skipped it
+//----------------------------------------------
+static int run_param(const char *param_file, int iterations, int warmup,
+                     const unsigned int *seed, int counters, op_stats_t stats[BENCH_OP_COUNT],
+                     bench_sizes_t *sizes, double *samples) {
+    if (seed && bench_scheme.seed) bench_scheme.seed(*seed);
+    if (!bench_scheme.setup(param_file)) return 0;
+
+    memset(sizes, 0, sizeof(*sizes));
+    if (bench_scheme.sizes) bench_scheme.sizes(sizes);
+
+    memset(stats, 0, BENCH_OP_COUNT * sizeof(op_stats_t));
+    for (int i = 0; i < warmup + iterations; i++) {
+        for (int op = 0; op < BENCH_OP_COUNT; op++) {
+            bench_fn fn = bench_scheme.op[op];
+            if (!fn) continue;
+            double c1[CTR_COUNT], c2[CTR_COUNT];
+            if (counters) ctr_read(c1);
+            double t1 = now_ms();
+            int ok = fn();
+            double t2 = now_ms();
+            if (counters) ctr_read(c2);
+            if (i < warmup) continue;
+            int per = op == BENCH_RECOGNIZE_BATCH ? BENCH_BATCH : 1;
+            samples[op * iterations + i - warmup] = (t2 - t1) / per;
+            for (int c = 0; counters && c < CTR_COUNT; c++)
+                stats[op].ctr[c] += (c2[c] - c1[c]) / per;
+            if (!ok) stats[op].failures++;
+        }
+    }
+    for (int op = 0; op < BENCH_OP_COUNT; op++) {
+        if (!bench_scheme.op[op]) continue;
+        compute_stats(&stats[op], samples + op * iterations, iterations);
+        for (int c = 0; c < CTR_COUNT; c++) stats[op].ctr[c] /= iterations;
+    }
+
+    bench_scheme.teardown();
+    return 1;
+}
+
+// Counter columns / fields of one operation under -p: the means, IPC after
+// instructions, empty / null where the counter is not available
+static void print_counters(int csv, const op_stats_t *st) {
+    for (int c = 0; c < CTR_COUNT; c++) {
+        if (csv) printf(",");
+        else printf(", \"%s_per_op\": ", ctr_names[c]);
+        if (ctr_available[c]) printf("%.1f", st->ctr[c]);
+        else if (!csv) printf("null");
+
+        if (c != CTR_INSTRUCTIONS) continue;
+        if (csv) printf(",");
+        else printf(", \"ipc\": ");
+        if (ctr_available[CTR_CYCLES] && ctr_available[CTR_INSTRUCTIONS] && st->ctr[CTR_CYCLES] > 0)
+            printf("%.3f", st->ctr[CTR_INSTRUCTIONS] / st->ctr[CTR_CYCLES]);
+        else if (!csv) printf("null");
+    }
+}
+
+static void print_results(int csv, int counters, int *first, const char *param, int iterations,
+                          const op_stats_t stats[BENCH_OP_COUNT], const bench_sizes_t *sz) {
+    for (int op = 0; op < BENCH_OP_COUNT; op++) {
+        if (!bench_scheme.op[op]) continue;
+        const op_stats_t *st = &stats[op];
+        double ops_per_sec = st->mean > 0 ? 1000.0 / st->mean : 0;
+        if (csv) {
+            printf("%s,%s,%s,%d,%.6f,%.6f,%.6f,%.6f,%.2f,%d,%d,%d,%d,%d,%d",
+                   bench_scheme.name, param, op_names[op], iterations,
+                   st->min, st->median, st->p99, st->mean, ops_per_sec, st->failures,
+                   sz->g1, sz->g1_compressed, sz->gt, sz->zr, sz->r_bits);
+            if (counters) print_counters(csv, st);
+            printf("\n");
+        } else {
+            printf("%s    {\"param\": \"%s\", \"op\": \"%s\", \"min_ms\": %.6f, "
+                   "\"median_ms\": %.6f, \"p99_ms\": %.6f, \"mean_ms\": %.6f, "
+                   "\"ops_per_sec\": %.2f, \"failures\": %d, \"g1_bytes\": %d, "
+                   "\"g1_compressed_bytes\": %d, \"gt_bytes\": %d, \"zr_bytes\": %d, "
+                   "\"r_bits\": %d",
+                   *first ? "" : ",\n", param, op_names[op],
+                   st->min, st->median, st->p99, st->mean, ops_per_sec, st->failures,
+                   sz->g1, sz->g1_compressed, sz->gt, sz->zr, sz->r_bits);
+            if (counters) print_counters(csv, st);
+            printf("}");
+            *first = 0;
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n iterations] [-w warmup] [-f json|csv] [-s seed] [-p] "
+                    "[param_file | param_dir ...]\n", prog);
+}
+
+//----------------------------------------------
+// main
+//----------------------------------------------
+int main(int argc, char **argv) {
+    int iterations = DEFAULT_ITERATIONS, warmup = DEFAULT_WARMUP, csv = 0, counters = 0;
+    unsigned int seed_value = 0;
+    const unsigned int *seed = NULL;
+    int argi = 1;
+
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (!strcmp(argv[argi], "-p")) {
+            counters = 1;
+            continue;
+        }
+        if (argi + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *val = argv[++argi];
+        if (!strcmp(argv[argi - 1], "-n")) iterations = atoi(val);
+        else if (!strcmp(argv[argi - 1], "-w")) warmup = atoi(val);
+        else if (!strcmp(argv[argi - 1], "-f") && !strcmp(val, "json")) csv = 0;
+        else if (!strcmp(argv[argi - 1], "-f") && !strcmp(val, "csv")) csv = 1;
+        else if (!strcmp(argv[argi - 1], "-s")) {
+            seed_value = (unsigned int)strtoul(val, NULL, 0);
+            seed = &seed_value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1 || warmup < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (seed && !bench_scheme.seed)
+        fprintf(stderr, "%s cannot be seeded, ignoring -s\n", bench_scheme.name);
+    if (counters) {
+        ctr_init();
+        if (!ctr_available[CTR_CYCLES])
+            fprintf(stderr, "%s: no CPU counters on this host (perf_event_open), "
+                            "reporting them as unavailable\n", bench_scheme.name);
+    }
+
+    char **params = NULL;
+    int param_count = 0;
+    if (bench_scheme.builtin_param) {
+        if (argi < argc)
+            fprintf(stderr, "%s uses %s, ignoring param files\n",
+                    bench_scheme.name, bench_scheme.builtin_param);
+    } else if (argi == argc) {
+        if (!add_param_arg(&params, &param_count, DEFAULT_PARAM_DIR)) return 1;
+    } else {
+        for (; argi < argc; argi++)
+            if (!add_param_arg(&params, &param_count, argv[argi])) return 1;
+    }
+    if (!bench_scheme.builtin_param && param_count == 0) {
+        fprintf(stderr, "No param files to run\n");
+        return 1;
+    }
+
+    double *samples = malloc((size_t)BENCH_OP_COUNT * iterations * sizeof(double));
+    if (!samples) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    op_stats_t stats[BENCH_OP_COUNT];
+    bench_sizes_t sizes;
+    int first = 1, status = 0;
+    if (csv) {
+        printf("scheme,param,op,iterations,min_ms,median_ms,p99_ms,mean_ms,ops_per_sec,failures,"
+               "g1_bytes,g1_compressed_bytes,gt_bytes,zr_bytes,r_bits");
+        if (counters) {
+            printf(",cycles_per_op,instructions_per_op,ipc,l1d_misses_per_op,llc_misses_per_op,"
+                   "branch_misses_per_op,allocs_per_op");
+        }
+        printf("\n");
+    } else {
+        printf("{\n  \"scheme\": \"%s\",\n  \"iterations\": %d,\n  \"warmup\": %d,\n",
+               bench_scheme.name, iterations, warmup);
+        if (seed && bench_scheme.seed) printf("  \"seed\": %u,\n", *seed);
+        printf("  \"results\": [\n");
+    }
+
+    int runs = bench_scheme.builtin_param ? 1 : param_count;
+    for (int p = 0; p < runs; p++) {
+        const char *file = bench_scheme.builtin_param ? NULL : params[p];
+        const char *label = file ? base_name(file) : bench_scheme.builtin_param;
+        fprintf(stderr, "%s: %s\n", bench_scheme.name, label);
+        if (!run_param(file, iterations, warmup, seed, counters, stats, &sizes, samples)) {
+            fprintf(stderr, "%s: skipping %s\n", bench_scheme.name, label);
+            continue;
+        }
+        print_results(csv, counters, &first, label, iterations, stats, &sizes);
+        for (int op = 0; op < BENCH_OP_COUNT; op++)
+            if (stats[op].failures) status = 1;
+        fflush(stdout);
+    }
+
+    if (!csv) printf("\n  ]\n}\n");
+
+    free(samples);
+    for (int p = 0; p < param_count; p++) free(params[p]);
+    free(params);
+    return status;
+}
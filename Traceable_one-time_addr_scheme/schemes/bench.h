@@ -0,0 +1,89 @@
+/****************************************************************************
+ * File: bench.h
+ * Desc: Scheme-agnostic benchmark harness shared by the scheme programs.
+ *       Each scheme file fills in one bench_scheme_t named bench_scheme;
+ *       bench.c owns main(), times every operation with a monotonic clock
+ *       and reports min / median / p99 / ops per second as JSON or CSV.
+ *
+ *       Build one program per scheme, e.g.
+ *         gcc -O2 my_stealth.c bench.c -o my_stealth -lpbc -lgmp -lcrypto
+ *         gcc -O2 zhao.c ec_openssl.c bench.c -o zhao -lcrypto
+ *
+ *       Usage: <scheme> [-n iterations] [-w warmup] [-f json|csv]
+ *                       [-s seed] [-p] [param_file | param_dir ...]
+ *       -s makes every run draw the same random numbers (keys,
+ *       nonces, exponents), so that results of different builds time
+ *       identical work; for benchmarking only.
+ *       -p also reads Linux perf_event counters around every operation
+ *       and reports cycles, IPC, L1D / LLC / branch misses and heap
+ *       allocations (malloc, calloc, realloc calls) per operation.
+ *       Counters the kernel or the CPU does not offer (e.g. in most VMs)
+ *       are reported as null / empty.
+ *       Every result also carries the element sizes of its group, and
+ *       bench_matrix.sh runs all the scheme programs over the same param
+ *       files into one comparison table.
+ *       PBC schemes run once per param file (directories are expanded to
+ *       their *.param files, default ../param) and skip asymmetric
+ *       pairings, since they pair G1 with G1; the ECC schemes run once on
+ *       the group of the backend they are linked with (see ec_backend.h).
+ ****************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+//----------------------------------------------
+// Common operations, run in this order every iteration so that each one
+// sees the outputs of the previous ones (verify checks the fresh
+// signature, trace the fresh address, ...).
+//----------------------------------------------
+typedef enum {
+    BENCH_KEYGEN,
+    BENCH_ADDR_GEN,
+    BENCH_RECOGNIZE,
+    BENCH_RECOGNIZE_FAST,
+    BENCH_RECOGNIZE_BATCH,
+    BENCH_SKGEN,
+    BENCH_SIGN,
+    BENCH_VERIFY,
+    BENCH_TRACE,
+    BENCH_OP_COUNT
+} bench_op_t;
+
+// Outputs per call of BENCH_RECOGNIZE_BATCH: the fresh address and
+// BENCH_BATCH - 1 sent to someone else. Its times are reported per
+// output, so they compare with BENCH_RECOGNIZE.
+#define BENCH_BATCH 64
+
+// Serialized sizes in bytes of one element of each group a scheme uses,
+// 0 for groups it does not have, and the bit length of the group order
+typedef struct {
+    int g1, g1_compressed, gt, zr;
+    int r_bits;
+} bench_sizes_t;
+
+// An operation returns 1 on success, 0 if its result is wrong (e.g. the
+// address is not recognized or the traced key does not match).
+typedef int (*bench_fn)(void);
+
+typedef struct {
+    const char *name;
+    // Label of the scheme's built-in group, NULL if it takes PBC param files
+    const char *builtin_param;
+    // Set up the group and long-lived keys; param_file is NULL for
+    // builtin_param schemes. Returns 0 if the scheme cannot run on this
+    // param set, leaving nothing to tear down.
+    int (*setup)(const char *param_file);
+    void (*teardown)(void);
+    // Called after a successful setup; NULL leaves every size 0
+    void (*sizes)(bench_sizes_t *sz);
+    // Makes the scheme's random numbers a fixed sequence from seed; called
+    // before each setup under -s. NULL if the scheme cannot be seeded.
+    void (*seed)(unsigned int seed);
+    // NULL entries are operations the scheme does not have
+    bench_fn op[BENCH_OP_COUNT];
+} bench_scheme_t;
+
+// Defined by the scheme file linked with bench.c
+extern const bench_scheme_t bench_scheme;
+
+#endif // BENCH_H
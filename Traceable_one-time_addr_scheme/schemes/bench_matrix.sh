@@ -0,0 +1,87 @@
+#!/bin/sh
+# Runs every scheme benchmark built in this directory over the same param
+# files and prints one comparison table: a row per scheme and param set
+# with the order size, the element sizes in bytes and the median time of
+# each operation in ms ("-" where the scheme has no such operation). Param
+# sets a scheme cannot run on (the PBC schemes need a symmetric pairing)
+# are listed as skipped.
+#
+# Usage: ./bench_matrix.sh [-n iterations] [-w warmup] [-s seed] [-p] [-c csv_file]
+#                          [param_file | param_dir ...]
+#   -s  seed every scheme's random numbers, for comparisons between builds
+#   -p  also read hardware counters per operation (cycles, IPC, cache and
+#       branch misses, allocations); they go to the CSV, not the table
+#   -c  also keep the merged CSV of every scheme in csv_file
+#
+# The ECC baselines use the group of their backend and ignore param files.
+
+SCHEMES="my_stealth sitaiba hdwsa zhao cryptonote2"
+
+dir=$(dirname "$0")
+opts=
+csv_out=
+header=
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -n|-w|-s) opts="$opts $1 $2"; shift 2 ;;
+        -p) opts="$opts -p"; shift ;;
+        -c) csv_out=$2; shift 2 ;;
+        *) break ;;
+    esac
+done
+[ $# -eq 0 ] && set -- "$dir/../param"
+
+tmp=$(mktemp) || exit 1
+trap 'rm -f "$tmp" "$tmp.csv" "$tmp.err"' EXIT
+status=0
+for s in $SCHEMES; do
+    if [ ! -x "$dir/$s" ]; then
+        echo "bench_matrix: $s is not built, leaving it out" >&2
+        continue
+    fi
+    # shellcheck disable=SC2086
+    "$dir/$s" $opts -f csv "$@" >"$tmp.csv" 2>"$tmp.err" || status=1
+    cat "$tmp.err" >&2
+    [ -z "$header" ] && header=$(grep '^scheme,' "$tmp.csv")
+    grep -v '^scheme,' "$tmp.csv" >>"$tmp"
+    # The harness names each param set it skips on stderr
+    sed -n "s/^$s: skipping \(.*\)/$s,\1,skipped/p" "$tmp.err" >>"$tmp"
+done
+
+if [ -n "$csv_out" ]; then
+    echo "$header" >"$csv_out"
+    grep -v ',skipped$' "$tmp" >>"$csv_out"
+fi
+
+awk -F, '
+BEGIN {
+    nops = split("keygen addr_gen recognize recognize_fast recognize_batch skgen sign verify trace", ops, " ")
+    for (i = 1; i <= nops; i++) w[i] = length(ops[i]) > 10 ? length(ops[i]) : 10
+    printf "%-12s %-24s %6s %5s %5s %5s %4s", "scheme", "param", "r_bits", "G1", "G1c", "GT", "Zr"
+    for (i = 1; i <= nops; i++) printf " %*s", w[i], ops[i]
+    printf "\n"
+}
+{
+    key = $1 SUBSEP $2
+    if (!(key in seen)) { seen[key] = 1; order[++rows] = key; name[key] = $1; param[key] = $2 }
+    if ($3 == "skipped") { skipped[key] = 1; next }
+    median[key, $3] = $6
+    if ($10 > 0) failed[key] = 1
+    sizes[key] = sprintf("%6d %5d %5d %5d %4d", $15, $11, $12, $13, $14)
+}
+END {
+    for (r = 1; r <= rows; r++) {
+        key = order[r]
+        printf "%-12s %-24s", name[key], param[key]
+        if (key in skipped) { printf " skipped\n"; continue }
+        printf " %s", sizes[key]
+        for (i = 1; i <= nops; i++) {
+            if ((key, ops[i]) in median) printf " %*.4f", w[i], median[key, ops[i]]
+            else printf " %*s", w[i], "-"
+        }
+        if (key in failed) printf "  FAILURES"
+        printf "\n"
+    }
+}' "$tmp"
+
+exit $status
@@ -1,243 +1,253 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-#include <openssl/ec.h>
-#include <openssl/ecdsa.h>
-#include <openssl/obj_mac.h>
-#include <openssl/sha.h>
-#include <openssl/bn.h>
-#include <openssl/rand.h>
 #include <openssl/evp.h>
+#include "ec_backend.h"
+#include "bench.h"
 
-#define LOOP 100
+// Per-thread working state: the backend context, the digest context and
+// the temporary points, so that the operations below allocate nothing.
+// Every thread needs its own.
+typedef struct {
+    ec_ctx_t *ec;
+    EVP_MD_CTX *md;
+    ec_point_t t;
+    ec_point_t *batch; // batch_len points for ReceiverStatisticsBatch
+    int batch_len;
+} scratch_t;
 
-// Global variables
-EC_GROUP *group;
-EC_POINT *G;
-BIGNUM *order;
+void ScratchFree(scratch_t *s) {
+    if (!s) return;
+    for (int i = 0; i < s->batch_len; i++) ec_point_clear(&s->batch[i]);
+    free(s->batch);
+    ec_point_clear(&s->t);
+    EVP_MD_CTX_free(s->md);
+    ec_ctx_free(s->ec);
+    free(s);
+}
 
-double timer_diff(clock_t start, clock_t end) {
-    return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0;
+scratch_t *ScratchNew(void) {
+    scratch_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->ec = ec_ctx_new();
+    s->md = EVP_MD_CTX_new();
+    ec_point_init(&s->t);
+    if (!s->ec || !s->md) {
+        ScratchFree(s);
+        return NULL;
+    }
+    return s;
 }
 
-double sumH1 = 0;
-double sumGen = 0, sumStat = 0, sumSK = 0;
+// Grows s->batch to at least n points; returns 0 if out of memory
+static int scratch_reserve(scratch_t *s, int n) {
+    if (n <= s->batch_len) return 1;
+    ec_point_t *grown = realloc(s->batch, n * sizeof(*grown));
+    if (!grown) return 0;
+    s->batch = grown;
+    for (; s->batch_len < n; s->batch_len++) ec_point_init(&s->batch[s->batch_len]);
+    return 1;
+}
 
-// H1: hash(EC_POINT) -> BIGNUM (Zr)
-void H1(BIGNUM *outZr, EC_POINT *inG1, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-    const EVP_MD *md = EVP_sha256();
+// H1: hash(EC_POINT) -> Zr
+void H1(ec_scalar_t *outZr, const ec_point_t *inG1, scratch_t *s) {
+    unsigned char buf[EC_POINT_MAX_BYTES];
     unsigned char hash[EVP_MAX_MD_SIZE];
     unsigned int hash_len;
-    
-    EVP_DigestInit_ex(mdctx, md, NULL);
-    
-    // Convert EC_POINT to bytes
-    size_t point_len = EC_POINT_point2oct(group, inG1, POINT_CONVERSION_COMPRESSED, NULL, 0, ctx);
-    unsigned char *point_buf = OPENSSL_malloc(point_len);
-    EC_POINT_point2oct(group, inG1, POINT_CONVERSION_COMPRESSED, point_buf, point_len, ctx);
-    
+
+    // Convert the point to bytes
+    size_t point_len = ec_point_bytes(s->ec, buf, inG1);
+
     // Hash the point
-    EVP_DigestUpdate(mdctx, point_buf, point_len);
-    EVP_DigestFinal_ex(mdctx, hash, &hash_len);
-    
-    // Convert hash to BIGNUM and reduce modulo order
-    BN_bin2bn(hash, hash_len, outZr);
-    BN_mod(outZr, outZr, order, ctx);
-    
-    // Cleanup
-    OPENSSL_free(point_buf);
-    EVP_MD_CTX_free(mdctx);
-    
-    clock_t t2 = clock();
-    sumH1 += timer_diff(t1, t2);
+    EVP_DigestInit_ex(s->md, EVP_sha256(), NULL);
+    EVP_DigestUpdate(s->md, buf, point_len);
+    EVP_DigestFinal_ex(s->md, hash, &hash_len);
+
+    // Reduce modulo the order
+    ec_scalar_from_hash(s->ec, outZr, hash);
 }
 
 void Setup() {
-    // Initialize curve (using secp256r1)
-    group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
-    if (!group) {
-        fprintf(stderr, "Failed to create EC group\n");
-        exit(1);
-    }
-    
-    // Get generator point
-    const EC_POINT *generator = EC_GROUP_get0_generator(group);
-    if (!generator) {
-        fprintf(stderr, "Failed to get generator\n");
-        exit(1);
-    }
-    G = EC_POINT_new(group);
-    EC_POINT_copy(G, generator);
-    
-    // Get order of the group
-    order = BN_new();
-    if (!EC_GROUP_get_order(group, order, NULL)) {
-        fprintf(stderr, "Failed to get group order\n");
+    // The group of the backend linked in (see ec_backend.h)
+    if (!ec_setup()) {
+        fprintf(stderr, "Failed to set up %s\n", ec_group_name);
         exit(1);
     }
 }
 
-void KeyGen(EC_POINT *A, EC_POINT *B, BIGNUM *a, BIGNUM *b, BN_CTX *ctx) {
+void KeyGen(ec_point_t *A, ec_point_t *B, ec_scalar_t *a, ec_scalar_t *b, scratch_t *s) {
     // Generate random private keys
-    BN_rand_range(a, order);
-    BN_rand_range(b, order);
-    
+    ec_scalar_random(s->ec, a);
+    ec_scalar_random(s->ec, b);
+
     // Compute public keys: A = a*G, B = b*G
-    EC_POINT_mul(group, A, NULL, G, a, ctx);
-    EC_POINT_mul(group, B, NULL, G, b, ctx);
-}
-
-void OnetimeAddrGen(EC_POINT *PK_one, EC_POINT *R, EC_POINT *A, EC_POINT *B, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r = BN_new();
-    BIGNUM *r_out = BN_new();
-    EC_POINT *temp = EC_POINT_new(group);
-    EC_POINT *r_out_G = EC_POINT_new(group);
-    
+    ec_mul_gen(s->ec, A, a);
+    ec_mul_gen(s->ec, B, b);
+}
+
+void OnetimeAddrGen(ec_point_t *PK_one, ec_point_t *R, const ec_point_t *A,
+                    const ec_point_t *B, scratch_t *s) {
+    ec_scalar_t r, r_out;
+
     // Generate random r
-    BN_rand_range(r, order);
-    
+    ec_scalar_random(s->ec, &r);
+
     // R = r * G
-    EC_POINT_mul(group, R, NULL, G, r, ctx);
-    
-    // temp = r * A
-    EC_POINT_mul(group, temp, NULL, A, r, ctx);
-    
+    ec_mul_gen(s->ec, R, &r);
+
     // r_out = hash(r*A)
-    H1(r_out, temp, ctx);
-    
+    ec_mul(s->ec, &s->t, &r, A);
+    H1(&r_out, &s->t, s);
+
     // PK_one = r_out*G + B
-    EC_POINT_mul(group, r_out_G, NULL, G, r_out, ctx);
-    EC_POINT_add(group, PK_one, r_out_G, B, ctx);
-    
-    // Cleanup
-    BN_free(r);
-    BN_free(r_out);
-    EC_POINT_free(temp);
-    EC_POINT_free(r_out_G);
-    
-    clock_t t2 = clock();
-    sumGen += timer_diff(t1, t2);
-}
-
-int ReceiverStatistics(EC_POINT *PK_one, EC_POINT *R, BIGNUM *a, EC_POINT *B, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r_out = BN_new();
-    EC_POINT *temp = EC_POINT_new(group);
-    EC_POINT *r_out_G = EC_POINT_new(group);
-    EC_POINT *check_PK = EC_POINT_new(group);
-    
-    // temp = a * R
-    EC_POINT_mul(group, temp, NULL, R, a, ctx);
-    
-    // r_out = hash(a*R)
-    H1(r_out, temp, ctx);
-    
-    // check_PK = r_out*G + B
-    EC_POINT_mul(group, r_out_G, NULL, G, r_out, ctx);
-    EC_POINT_add(group, check_PK, r_out_G, B, ctx);
-    
-    // Check if PK_one == check_PK
-    int ok = (EC_POINT_cmp(group, PK_one, check_PK, ctx) == 0);
-    
-    // Cleanup
-    BN_free(r_out);
-    EC_POINT_free(temp);
-    EC_POINT_free(r_out_G);
-    EC_POINT_free(check_PK);
-    
-    clock_t t2 = clock();
-    sumStat += timer_diff(t1, t2);
-    
-    return ok;
-}
-
-void OnetimeSKGen(BIGNUM *sk_ot, EC_POINT *R, BIGNUM *a, BIGNUM *b, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r_out = BN_new();
-    EC_POINT *temp = EC_POINT_new(group);
-    
-    // temp = a * R
-    EC_POINT_mul(group, temp, NULL, R, a, ctx);
-    
+    ec_mul_gen(s->ec, &s->t, &r_out);
+    ec_add(s->ec, PK_one, &s->t, B);
+}
+
+// PK_one == r_out*G + B, r_out = hash(a*R) given as aR
+static int check_output(const ec_point_t *PK_one, const ec_point_t *aR, const ec_point_t *B,
+                        scratch_t *s) {
+    ec_scalar_t r_out;
+
+    H1(&r_out, aR, s);
+    return ec_mul_gen(s->ec, &s->t, &r_out)
+           && ec_add(s->ec, &s->t, &s->t, B)
+           && ec_eq(s->ec, PK_one, &s->t);
+}
+
+// ReceiverStatistics for the n outputs (PK_one[i], R[i]); ok[i] receives
+// each result. The points a*R[i] come from one ec_mul_many, which leaves
+// them ready to hash. Returns the number of outputs that are ours, or -1
+// if out of memory.
+int ReceiverStatisticsBatch(int ok[], const ec_point_t PK_one[], const ec_point_t R[], int n,
+                            const ec_scalar_t *a, const ec_point_t *B, scratch_t *s) {
+    int found = 0;
+
+    if (n <= 0) return 0;
+    if (!scratch_reserve(s, n)) return -1;
+
+    if (!ec_mul_many(s->ec, s->batch, a, R, n)) {
+        memset(ok, 0, n * sizeof(*ok));
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        ok[i] = check_output(&PK_one[i], &s->batch[i], B, s);
+        found += ok[i];
+    }
+    return found;
+}
+
+int ReceiverStatistics(const ec_point_t *PK_one, const ec_point_t *R, const ec_scalar_t *a,
+                       const ec_point_t *B, scratch_t *s) {
+    int ok;
+    return ReceiverStatisticsBatch(&ok, PK_one, R, 1, a, B, s) == 1;
+}
+
+void OnetimeSKGen(ec_scalar_t *sk_ot, const ec_point_t *R, const ec_scalar_t *a,
+                  const ec_scalar_t *b, scratch_t *s) {
+    ec_scalar_t r_out;
+
     // r_out = hash(a*R)
-    H1(r_out, temp, ctx);
-    
+    ec_mul(s->ec, &s->t, a, R);
+    H1(&r_out, &s->t, s);
+
     // sk_ot = r_out + b
-    BN_mod_add(sk_ot, r_out, b, order, ctx);
-    
-    // Cleanup
-    BN_free(r_out);
-    EC_POINT_free(temp);
-    
-    clock_t t2 = clock();
-    sumSK += timer_diff(t1, t2);
+    ec_scalar_add(s->ec, sk_ot, &r_out, b);
 }
 
 void cleanup() {
-    EC_POINT_free(G);
-    EC_GROUP_free(group);
-    BN_free(order);
+    ec_cleanup();
 }
 
-int main() {
+// Benchmark registration (see bench.h)
+static scratch_t *scratch;
+static ec_point_t A, B, PK_one, R;
+static ec_scalar_t a, b, sk_ot;
+// The batch scan sees the fresh output first, then BENCH_BATCH - 1
+// outputs sent to someone else. Slot 0 is a copy of PK_one and R and is
+// not cleared itself.
+static ec_point_t batch_PK[BENCH_BATCH], batch_R[BENCH_BATCH];
+
+static int bench_setup(const char *param_file) {
+    (void)param_file;
     Setup();
-    
-    BN_CTX *ctx = BN_CTX_new();
-    
-    // Initialize keys
-    EC_POINT *A = EC_POINT_new(group);
-    EC_POINT *B = EC_POINT_new(group);
-    BIGNUM *a = BN_new();
-    BIGNUM *b = BN_new();
-    
-    // Generate keys
-    KeyGen(A, B, a, b, ctx);
-    
-    printf("Running %d iterations...\n", LOOP);
-    
-    for (int i = 0; i < LOOP; i++) {
-        EC_POINT *PK_one = EC_POINT_new(group);
-        EC_POINT *R = EC_POINT_new(group);
-        BIGNUM *sk_ot = BN_new();
-        
-        // Run algorithms
-        OnetimeAddrGen(PK_one, R, A, B, ctx);
-        int result = ReceiverStatistics(PK_one, R, a, B, ctx);
-        OnetimeSKGen(sk_ot, R, a, b, ctx);
-        
-        // Check correctness
-        if (!result) {
-            printf("FAIL at round %d\n", i);
-        }
-        
-        // Cleanup round
-        EC_POINT_free(PK_one);
-        EC_POINT_free(R);
-        BN_free(sk_ot);
+    scratch = ScratchNew();
+
+    ec_point_init(&A);
+    ec_point_init(&B);
+    ec_point_init(&PK_one);
+    ec_point_init(&R);
+
+    // Outputs to a receiver other than the benchmarked one
+    KeyGen(&A, &B, &a, &b, scratch);
+    for (int i = 1; i < BENCH_BATCH; i++) {
+        ec_point_init(&batch_PK[i]);
+        ec_point_init(&batch_R[i]);
+        OnetimeAddrGen(&batch_PK[i], &batch_R[i], &A, &B, scratch);
     }
-    
-    // Print timing results
-    printf("\n=== Performance Results ===\n");
-    printf("Avg AddrGen Time     : %.3f ms\n", sumGen / LOOP);
-    printf("Avg ReceiverStat Time: %.3f ms\n", sumStat / LOOP);
-    printf("Avg OnetimeSKGen Time: %.3f ms\n", sumSK / LOOP);
-    printf("Avg H1 Time: %.3f ms\n", sumH1 / (3*LOOP));
-    
-    // Cleanup
-    EC_POINT_free(A);
-    EC_POINT_free(B);
-    BN_free(a);
-    BN_free(b);
-    BN_CTX_free(ctx);
+    return 1;
+}
+
+static void bench_teardown(void) {
+    for (int i = 1; i < BENCH_BATCH; i++) {
+        ec_point_clear(&batch_PK[i]);
+        ec_point_clear(&batch_R[i]);
+    }
+    ec_point_clear(&A);
+    ec_point_clear(&B);
+    ec_point_clear(&PK_one);
+    ec_point_clear(&R);
+    ScratchFree(scratch);
     cleanup();
-    
-    return 0;
-}
\ No newline at end of file
+}
+
+static int bench_keygen(void) {
+    KeyGen(&A, &B, &a, &b, scratch);
+    return 1;
+}
+
+static int bench_addr_gen(void) {
+    OnetimeAddrGen(&PK_one, &R, &A, &B, scratch);
+    batch_PK[0] = PK_one;
+    batch_R[0] = R;
+    return 1;
+}
+
+static int bench_recognize(void) {
+    return ReceiverStatistics(&PK_one, &R, &a, &B, scratch);
+}
+
+static int bench_recognize_batch(void) {
+    int ok[BENCH_BATCH];
+    return ReceiverStatisticsBatch(ok, batch_PK, batch_R, BENCH_BATCH, &a, &B, scratch) == 1
+           && ok[0];
+}
+
+static int bench_skgen(void) {
+    OnetimeSKGen(&sk_ot, &R, &a, &b, scratch);
+    return 1;
+}
+
+static void bench_sizes(bench_sizes_t *sz) {
+    unsigned char buf[EC_POINT_MAX_BYTES];
+    sz->g1 = sz->g1_compressed = ec_point_bytes(scratch->ec, buf, &A);
+    sz->zr = EC_SCALAR_BYTES;
+    sz->r_bits = ec_order_bits();
+}
+
+const bench_scheme_t bench_scheme = {
+    .name = "cryptonote2",
+    .builtin_param = ec_group_name,
+    .setup = bench_setup,
+    .teardown = bench_teardown,
+    .sizes = bench_sizes,
+    .seed = ec_seed,
+    .op = {
+        [BENCH_KEYGEN] = bench_keygen,
+        [BENCH_ADDR_GEN] = bench_addr_gen,
+        [BENCH_RECOGNIZE] = bench_recognize,
+        [BENCH_RECOGNIZE_BATCH] = bench_recognize_batch,
+        [BENCH_SKGEN] = bench_skgen,
+    },
+};
@@ -0,0 +1,94 @@
+/****************************************************************************
+ * File: ec_backend.h
+ * Desc: Prime-order group operations for the non-pairing baselines
+ *       (zhao.c, cryptonote2.c), with the implementation picked at build
+ *       time by linking one backend file:
+ *         ec_openssl.c    OpenSSL EC (default), on EC_OPENSSL_CURVE,
+ *                         prime256v1 unless e.g.
+ *                         -DEC_OPENSSL_CURVE='"secp256k1"'
+ *         ec_secp256k1.c  libsecp256k1 (0.2 or later),
+ *                         -DEC_BACKEND_SECP256K1 ... -lsecp256k1
+ *         ec_ed25519.c    libsodium's ed25519 group,
+ *                         -DEC_BACKEND_ED25519 ... -lsodium
+ *       e.g.
+ *         gcc -O2 -DEC_BACKEND_SECP256K1 zhao.c ec_secp256k1.c bench.c \
+ *             -o zhao -lsecp256k1 -lcrypto
+ *
+ *       Scalars are 32 bytes in the backend's own byte order; points are
+ *       values the caller keeps, set up by ec_point_init. Everything that
+ *       works on them takes a per-thread ec_ctx_t. Functions returning int
+ *       return 1 on success and 0 on failure (e.g. a result at infinity,
+ *       which not every backend can hold).
+ ****************************************************************************/
+
+#ifndef EC_BACKEND_H
+#define EC_BACKEND_H
+
+#include <stddef.h>
+
+#define EC_SCALAR_BYTES 32
+// Longest ec_point_bytes output
+#define EC_POINT_MAX_BYTES 33
+
+typedef struct {
+    unsigned char b[EC_SCALAR_BYTES];
+} ec_scalar_t;
+
+#if defined(EC_BACKEND_SECP256K1)
+#include <secp256k1.h>
+typedef secp256k1_pubkey ec_point_t;
+#elif defined(EC_BACKEND_ED25519)
+// Compressed encoding, the form libsodium computes on
+typedef struct {
+    unsigned char b[32];
+} ec_point_t;
+#else
+struct ec_point_st;
+typedef struct {
+    struct ec_point_st *p;
+} ec_point_t;
+#endif
+
+typedef struct ec_ctx ec_ctx_t;
+
+// Label of the group, for bench_scheme_t.builtin_param
+extern const char ec_group_name[];
+
+// Global state; ec_setup returns 0 if the backend cannot start
+int ec_setup(void);
+void ec_cleanup(void);
+// Bit length of the group order, once set up
+int ec_order_bits(void);
+
+// Per-thread context, NULL if out of memory
+ec_ctx_t *ec_ctx_new(void);
+void ec_ctx_free(ec_ctx_t *c);
+
+void ec_point_init(ec_point_t *P);
+void ec_point_clear(ec_point_t *P);
+
+void ec_scalar_random(ec_ctx_t *c, ec_scalar_t *k);
+// Makes ec_scalar_random return hashes of (seed, call number) modulo the
+// order, the same sequence every run; for benchmarking only
+void ec_seed(unsigned int seed);
+// k = the 32-byte big-endian hash modulo the group order
+void ec_scalar_from_hash(ec_ctx_t *c, ec_scalar_t *k, const unsigned char hash[32]);
+int ec_scalar_add(ec_ctx_t *c, ec_scalar_t *r, const ec_scalar_t *a, const ec_scalar_t *b);
+
+// R = k*G through the backend's fixed-base tables
+int ec_mul_gen(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k);
+// R = k*P
+int ec_mul(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k, const ec_point_t *P);
+// R[i] = k*P[i] for i < n, left in the form ec_point_bytes encodes
+// fastest (OpenSSL makes them affine together)
+int ec_mul_many(ec_ctx_t *c, ec_point_t R[], const ec_scalar_t *k, const ec_point_t P[], int n);
+int ec_add(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q);
+// R = P - Q
+int ec_sub(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q);
+// 1 if P == Q
+int ec_eq(ec_ctx_t *c, const ec_point_t *P, const ec_point_t *Q);
+// Canonical compressed encoding of P into buf (EC_POINT_MAX_BYTES);
+// returns its length
+size_t ec_point_bytes(ec_ctx_t *c, unsigned char *buf, const ec_point_t *P);
+
+#endif // EC_BACKEND_H
@@ -0,0 +1,135 @@
+/****************************************************************************
+ * File: ec_ed25519.c
+ * Desc: ec_backend.h on the prime-order subgroup of ed25519, through
+ *       libsodium's group API (1.0.18 or later); build with
+ *       -DEC_BACKEND_ED25519 and link -lsodium. Scalars are little-endian
+ *       and unclamped; points are libsodium's compressed encodings.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <sodium.h>
+#include "ec_backend.h"
+
+// libsodium needs no per-thread state
+struct ec_ctx {
+    int unused;
+};
+
+const char ec_group_name[] = "ed25519";
+
+int ec_setup(void) {
+    return sodium_init() >= 0;
+}
+
+void ec_cleanup(void) {
+}
+
+// The order is 2^252 plus a 125-bit term
+int ec_order_bits(void) {
+    return 253;
+}
+
+ec_ctx_t *ec_ctx_new(void) {
+    return calloc(1, sizeof(ec_ctx_t));
+}
+
+void ec_ctx_free(ec_ctx_t *c) {
+    free(c);
+}
+
+void ec_point_init(ec_point_t *P) {
+    memset(P, 0, sizeof(*P));
+}
+
+void ec_point_clear(ec_point_t *P) {
+    (void)P;
+}
+
+// ec_seed: scalars are then hashes of (seed, calls so far)
+static int seeded;
+static unsigned int seed_value;
+static unsigned long seed_calls;
+
+void ec_seed(unsigned int seed) {
+    seeded = 1;
+    seed_value = seed;
+    seed_calls = 0;
+}
+
+static void seeded_input(unsigned char in[12]) {
+    unsigned long n = seed_calls++;
+    for (int i = 0; i < 4; i++) in[i] = (unsigned char)(seed_value >> (8 * i));
+    for (int i = 0; i < 8; i++) in[4 + i] = (unsigned char)(n >> (8 * i));
+}
+
+void ec_scalar_random(ec_ctx_t *c, ec_scalar_t *k) {
+    if (seeded) {
+        unsigned char in[12], hash[crypto_hash_sha256_BYTES];
+        seeded_input(in);
+        crypto_hash_sha256(hash, in, sizeof(in));
+        ec_scalar_from_hash(c, k, hash);
+        return;
+    }
+    crypto_core_ed25519_scalar_random(k->b);
+}
+
+void ec_scalar_from_hash(ec_ctx_t *c, ec_scalar_t *k, const unsigned char hash[32]) {
+    unsigned char wide[crypto_core_ed25519_NONREDUCEDSCALARBYTES] = { 0 };
+    (void)c;
+    for (int i = 0; i < 32; i++) wide[i] = hash[31 - i];
+    crypto_core_ed25519_scalar_reduce(k->b, wide);
+}
+
+int ec_scalar_add(ec_ctx_t *c, ec_scalar_t *r, const ec_scalar_t *a, const ec_scalar_t *b) {
+    (void)c;
+    crypto_core_ed25519_scalar_add(r->b, a->b, b->b);
+    return 1;
+}
+
+int ec_mul_gen(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k) {
+    (void)c;
+    return crypto_scalarmult_ed25519_base_noclamp(R->b, k->b) == 0;
+}
+
+int ec_mul(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k, const ec_point_t *P) {
+    ec_point_t out;
+    (void)c;
+    if (crypto_scalarmult_ed25519_noclamp(out.b, k->b, P->b) != 0) return 0;
+    *R = out;
+    return 1;
+}
+
+int ec_mul_many(ec_ctx_t *c, ec_point_t R[], const ec_scalar_t *k, const ec_point_t P[], int n) {
+    for (int i = 0; i < n; i++) {
+        if (!ec_mul(c, &R[i], k, &P[i])) return 0;
+    }
+    return 1;
+}
+
+int ec_add(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    ec_point_t out;
+    (void)c;
+    if (crypto_core_ed25519_add(out.b, P->b, Q->b) != 0) return 0;
+    *R = out;
+    return 1;
+}
+
+int ec_sub(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    ec_point_t out;
+    (void)c;
+    if (crypto_core_ed25519_sub(out.b, P->b, Q->b) != 0) return 0;
+    *R = out;
+    return 1;
+}
+
+int ec_eq(ec_ctx_t *c, const ec_point_t *P, const ec_point_t *Q) {
+    (void)c;
+    return memcmp(P->b, Q->b, sizeof(P->b)) == 0;
+}
+
+size_t ec_point_bytes(ec_ctx_t *c, unsigned char *buf, const ec_point_t *P) {
+    (void)c;
+    memcpy(buf, P->b, sizeof(P->b));
+    return sizeof(P->b);
+}
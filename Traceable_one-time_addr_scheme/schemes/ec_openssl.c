@@ -0,0 +1,196 @@
+/****************************************************************************
+ * File: ec_openssl.c
+ * Desc: ec_backend.h on OpenSSL's EC code. Scalars are big-endian.
+ ****************************************************************************/
+
+// EC_GROUP_precompute_mult and EC_POINTs_make_affine are deprecated since
+// OpenSSL 3.0 but still provided
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <stdio.h>
+#include <openssl/ec.h>
+#include <openssl/bn.h>
+#include <openssl/objects.h>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include "ec_backend.h"
+
+// Short name of a curve OpenSSL knows
+#ifndef EC_OPENSSL_CURVE
+#define EC_OPENSSL_CURVE "prime256v1"
+#endif
+
+struct ec_ctx {
+    BN_CTX *bn;
+    EC_POINT **many; // many_len slots for ec_mul_many
+    int many_len;
+};
+
+static EC_GROUP *group;
+static BIGNUM *order;
+const char ec_group_name[] = EC_OPENSSL_CURVE;
+
+int ec_setup(void) {
+    group = EC_GROUP_new_by_curve_name(OBJ_sn2nid(EC_OPENSSL_CURVE));
+    order = BN_new();
+    if (!group || !order || !EC_GROUP_get_order(group, order, NULL)) {
+        fprintf(stderr, "Failed to create EC group\n");
+        ec_cleanup();
+        return 0;
+    }
+    // Table of multiples of the generator, read whenever EC_POINT_mul gets
+    // its scalar as the generator term
+    if (!EC_GROUP_precompute_mult(group, NULL)) {
+        fprintf(stderr, "Failed to precompute generator multiples\n");
+        ec_cleanup();
+        return 0;
+    }
+    return 1;
+}
+
+void ec_cleanup(void) {
+    EC_GROUP_free(group);
+    BN_free(order);
+    group = NULL;
+    order = NULL;
+}
+
+int ec_order_bits(void) {
+    return BN_num_bits(order);
+}
+
+ec_ctx_t *ec_ctx_new(void) {
+    ec_ctx_t *c = OPENSSL_zalloc(sizeof(*c));
+    if (!c) return NULL;
+    if (!(c->bn = BN_CTX_new())) {
+        OPENSSL_free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void ec_ctx_free(ec_ctx_t *c) {
+    if (!c) return;
+    OPENSSL_free(c->many);
+    BN_CTX_free(c->bn);
+    OPENSSL_free(c);
+}
+
+void ec_point_init(ec_point_t *P) {
+    P->p = EC_POINT_new(group);
+}
+
+void ec_point_clear(ec_point_t *P) {
+    EC_POINT_free(P->p);
+    P->p = NULL;
+}
+
+// ec_seed: scalars are then hashes of (seed, calls so far)
+static int seeded;
+static unsigned int seed_value;
+static unsigned long seed_calls;
+
+void ec_seed(unsigned int seed) {
+    seeded = 1;
+    seed_value = seed;
+    seed_calls = 0;
+}
+
+static void seeded_input(unsigned char in[12]) {
+    unsigned long n = seed_calls++;
+    for (int i = 0; i < 4; i++) in[i] = (unsigned char)(seed_value >> (8 * i));
+    for (int i = 0; i < 8; i++) in[4 + i] = (unsigned char)(n >> (8 * i));
+}
+
+void ec_scalar_random(ec_ctx_t *c, ec_scalar_t *k) {
+    if (seeded) {
+        unsigned char in[12], hash[32];
+        seeded_input(in);
+        SHA256(in, sizeof(in), hash);
+        ec_scalar_from_hash(c, k, hash);
+        return;
+    }
+    BN_CTX_start(c->bn);
+    BIGNUM *x = BN_CTX_get(c->bn);
+    BN_rand_range(x, order);
+    BN_bn2binpad(x, k->b, EC_SCALAR_BYTES);
+    BN_CTX_end(c->bn);
+}
+
+void ec_scalar_from_hash(ec_ctx_t *c, ec_scalar_t *k, const unsigned char hash[32]) {
+    BN_CTX_start(c->bn);
+    BIGNUM *x = BN_CTX_get(c->bn);
+    BN_bin2bn(hash, 32, x);
+    BN_mod(x, x, order, c->bn);
+    BN_bn2binpad(x, k->b, EC_SCALAR_BYTES);
+    BN_CTX_end(c->bn);
+}
+
+int ec_scalar_add(ec_ctx_t *c, ec_scalar_t *r, const ec_scalar_t *a, const ec_scalar_t *b) {
+    BN_CTX_start(c->bn);
+    BIGNUM *x = BN_CTX_get(c->bn);
+    BIGNUM *y = BN_CTX_get(c->bn);
+    int ok = y && BN_bin2bn(a->b, EC_SCALAR_BYTES, x) && BN_bin2bn(b->b, EC_SCALAR_BYTES, y)
+             && BN_mod_add(x, x, y, order, c->bn)
+             && BN_bn2binpad(x, r->b, EC_SCALAR_BYTES) == EC_SCALAR_BYTES;
+    BN_CTX_end(c->bn);
+    return ok;
+}
+
+// n*G + m*P, either term may be NULL
+static int mul(ec_ctx_t *c, EC_POINT *R, const ec_scalar_t *n, const EC_POINT *P,
+               const ec_scalar_t *m) {
+    BN_CTX_start(c->bn);
+    BIGNUM *x = BN_CTX_get(c->bn);
+    int ok = x && BN_bin2bn((n ? n : m)->b, EC_SCALAR_BYTES, x)
+             && EC_POINT_mul(group, R, n ? x : NULL, P, n ? NULL : x, c->bn);
+    BN_CTX_end(c->bn);
+    return ok;
+}
+
+int ec_mul_gen(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k) {
+    return mul(c, R->p, k, NULL, NULL);
+}
+
+int ec_mul(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k, const ec_point_t *P) {
+    return mul(c, R->p, NULL, P->p, k);
+}
+
+int ec_mul_many(ec_ctx_t *c, ec_point_t R[], const ec_scalar_t *k, const ec_point_t P[], int n) {
+    if (n <= 0) return 1;
+    if (n > c->many_len) {
+        EC_POINT **grown = OPENSSL_realloc(c->many, n * sizeof(*grown));
+        if (!grown) return 0;
+        c->many = grown;
+        c->many_len = n;
+    }
+    for (int i = 0; i < n; i++) {
+        if (!mul(c, R[i].p, NULL, P[i].p, k)) return 0;
+        c->many[i] = R[i].p;
+    }
+    // One field inversion for the lot instead of one per encoding
+    return EC_POINTs_make_affine(group, n, c->many, c->bn);
+}
+
+int ec_add(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    return EC_POINT_add(group, R->p, P->p, Q->p, c->bn);
+}
+
+// R may be P or Q
+int ec_sub(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    if (R->p == P->p) {
+        // -(Q - P)
+        return EC_POINT_invert(group, R->p, c->bn) && EC_POINT_add(group, R->p, R->p, Q->p, c->bn)
+               && EC_POINT_invert(group, R->p, c->bn);
+    }
+    return EC_POINT_copy(R->p, Q->p) && EC_POINT_invert(group, R->p, c->bn)
+           && EC_POINT_add(group, R->p, P->p, R->p, c->bn);
+}
+
+int ec_eq(ec_ctx_t *c, const ec_point_t *P, const ec_point_t *Q) {
+    return EC_POINT_cmp(group, P->p, Q->p, c->bn) == 0;
+}
+
+size_t ec_point_bytes(ec_ctx_t *c, unsigned char *buf, const ec_point_t *P) {
+    return EC_POINT_point2oct(group, P->p, POINT_CONVERSION_COMPRESSED, buf,
+                              EC_POINT_MAX_BYTES, c->bn);
+}
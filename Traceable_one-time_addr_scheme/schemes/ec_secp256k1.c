@@ -0,0 +1,151 @@
+/****************************************************************************
+ * File: ec_secp256k1.c
+ * Desc: ec_backend.h on libsecp256k1's public API (0.2 or later); build
+ *       with -DEC_BACKEND_SECP256K1 and link -lsecp256k1. Scalars are
+ *       big-endian, as libsecp256k1 takes them; random ones come from
+ *       OpenSSL's RAND_bytes, which the schemes link for hashing anyway.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include "ec_backend.h"
+
+struct ec_ctx {
+    secp256k1_context *ctx;
+};
+
+const char ec_group_name[] = "secp256k1";
+
+// Group order, big-endian
+static const unsigned char order[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+    0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b,
+    0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x41,
+};
+
+int ec_setup(void) {
+    return 1;
+}
+
+void ec_cleanup(void) {
+}
+
+int ec_order_bits(void) {
+    return 256;
+}
+
+ec_ctx_t *ec_ctx_new(void) {
+    ec_ctx_t *c = malloc(sizeof(*c));
+    if (!c) return NULL;
+    // The generator tables are static in 0.2 and later, so a context is
+    // cheap and needs no flags
+    if (!(c->ctx = secp256k1_context_create(SECP256K1_CONTEXT_NONE))) {
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void ec_ctx_free(ec_ctx_t *c) {
+    if (!c) return;
+    secp256k1_context_destroy(c->ctx);
+    free(c);
+}
+
+void ec_point_init(ec_point_t *P) {
+    memset(P, 0, sizeof(*P));
+}
+
+void ec_point_clear(ec_point_t *P) {
+    (void)P;
+}
+
+// ec_seed: scalars are then hashes of (seed, calls so far)
+static int seeded;
+static unsigned int seed_value;
+static unsigned long seed_calls;
+
+void ec_seed(unsigned int seed) {
+    seeded = 1;
+    seed_value = seed;
+    seed_calls = 0;
+}
+
+static void seeded_input(unsigned char in[12]) {
+    unsigned long n = seed_calls++;
+    for (int i = 0; i < 4; i++) in[i] = (unsigned char)(seed_value >> (8 * i));
+    for (int i = 0; i < 8; i++) in[4 + i] = (unsigned char)(n >> (8 * i));
+}
+
+void ec_scalar_random(ec_ctx_t *c, ec_scalar_t *k) {
+    do {
+        if (seeded) {
+            unsigned char in[12], hash[32];
+            seeded_input(in);
+            SHA256(in, sizeof(in), hash);
+            ec_scalar_from_hash(c, k, hash);
+        } else {
+            RAND_bytes(k->b, EC_SCALAR_BYTES);
+        }
+    } while (!secp256k1_ec_seckey_verify(c->ctx, k->b));
+}
+
+void ec_scalar_from_hash(ec_ctx_t *c, ec_scalar_t *k, const unsigned char hash[32]) {
+    (void)c;
+    memcpy(k->b, hash, EC_SCALAR_BYTES);
+    if (memcmp(k->b, order, EC_SCALAR_BYTES) < 0) return;
+    // order > 2^255, so one subtraction reduces any 256-bit value
+    int borrow = 0;
+    for (int i = EC_SCALAR_BYTES - 1; i >= 0; i--) {
+        int d = k->b[i] - order[i] - borrow;
+        borrow = d < 0;
+        k->b[i] = (unsigned char)(d + (borrow << 8));
+    }
+}
+
+int ec_scalar_add(ec_ctx_t *c, ec_scalar_t *r, const ec_scalar_t *a, const ec_scalar_t *b) {
+    if (r != a) memcpy(r->b, a->b, EC_SCALAR_BYTES);
+    return secp256k1_ec_seckey_tweak_add(c->ctx, r->b, b->b);
+}
+
+int ec_mul_gen(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k) {
+    return secp256k1_ec_pubkey_create(c->ctx, R, k->b);
+}
+
+int ec_mul(ec_ctx_t *c, ec_point_t *R, const ec_scalar_t *k, const ec_point_t *P) {
+    if (R != P) *R = *P;
+    return secp256k1_ec_pubkey_tweak_mul(c->ctx, R, k->b);
+}
+
+int ec_mul_many(ec_ctx_t *c, ec_point_t R[], const ec_scalar_t *k, const ec_point_t P[], int n) {
+    for (int i = 0; i < n; i++) {
+        if (!ec_mul(c, &R[i], k, &P[i])) return 0;
+    }
+    return 1;
+}
+
+int ec_add(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    const secp256k1_pubkey *terms[2] = { P, Q };
+    secp256k1_pubkey sum;
+    if (!secp256k1_ec_pubkey_combine(c->ctx, &sum, terms, 2)) return 0;
+    *R = sum;
+    return 1;
+}
+
+int ec_sub(ec_ctx_t *c, ec_point_t *R, const ec_point_t *P, const ec_point_t *Q) {
+    secp256k1_pubkey neg = *Q;
+    return secp256k1_ec_pubkey_negate(c->ctx, &neg) && ec_add(c, R, P, &neg);
+}
+
+int ec_eq(ec_ctx_t *c, const ec_point_t *P, const ec_point_t *Q) {
+    return secp256k1_ec_pubkey_cmp(c->ctx, P, Q) == 0;
+}
+
+size_t ec_point_bytes(ec_ctx_t *c, unsigned char *buf, const ec_point_t *P) {
+    size_t len = EC_POINT_MAX_BYTES;
+    secp256k1_ec_pubkey_serialize(c->ctx, buf, &len, P, SECP256K1_EC_COMPRESSED);
+    return len;
+}
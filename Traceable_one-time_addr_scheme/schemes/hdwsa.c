@@ -1,36 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <pbc/pbc.h>
 #include <pbc/pbc_test.h>
 #include <openssl/sha.h>
-#include <time.h>
-
-#define RUN_COUNT 100
+#include "bench.h"
 
 pairing_t pairing;
 element_t P; // generator in G1
-
-double timer_diff(clock_t start, clock_t end) {
-    return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0;
-}
-
-static double sumDelegate = 0, sumVerifyKey = 0, sumCheck = 0, sumSignKey = 0, sumSign = 0, sumVerify = 0, sumH0 = 0, sumH1 = 0, sumH2 = 0, sumH3 = 0, sumH4 = 0;
-
-void PrintAverageTimes() {
-    printf("\n=== Average runtime over %d runs (ms) ===\n", RUN_COUNT);
-    printf("WalletKeyDelegate:  %.3f ms\n", sumDelegate / RUN_COUNT);
-    printf("VerifyKeyDerive:    %.3f ms\n", sumVerifyKey / RUN_COUNT);
-    printf("VerifyKeyCheck:      %.3f ms\n", sumCheck / RUN_COUNT);
-    printf("SignKeyDerive:      %.3f ms\n", sumSignKey / RUN_COUNT);
-    printf("Sign:               %.3f ms\n", sumSign / RUN_COUNT);
-    printf("Verify:             %.3f ms\n", sumVerify / RUN_COUNT);
-    printf("H0:                 %.3f ms\n", sumH0 / RUN_COUNT);
-    printf("H1:                 %.3f ms\n", sumH1 / (RUN_COUNT * 2));
-    printf("H2:                 %.3f ms\n", sumH2 / RUN_COUNT);
-    printf("H3:                 %.3f ms\n", sumH3 / (RUN_COUNT * 3));
-    printf("H4:                 %.3f ms\n", sumH4 / (RUN_COUNT * 2));
-}
+element_pp_t P_pp; // fixed-base table for multiples of P
+pairing_pp_t P_pairing_pp; // Miller-loop lines for e(P, .), used by Verify
+element_t ePP; // e(P, P), so that Sign needs no pairing
+element_pp_t ePP_pp;
 
 void hash_to_mpz(mpz_t out, const unsigned char *data, size_t len, mpz_t mod) {
     unsigned char hash[SHA256_DIGEST_LENGTH];
@@ -41,23 +23,19 @@ void hash_to_mpz(mpz_t out, const unsigned char *data, size_t len, mpz_t mod) {
 
 // H0: S_ID -> G1* (maps identity to G1)
 void H0(element_t out, const char *id) {
-    clock_t t1 = clock();
     mpz_t tmp;
     mpz_init(tmp);
     hash_to_mpz(tmp, (const unsigned char *)id, strlen(id), pairing->r);
     element_t zr;
     element_init_Zr(zr, pairing);
     element_set_mpz(zr, tmp);
-    element_mul_zn(out, P, zr);
+    element_pp_pow_zn(out, zr, P_pp);
     element_clear(zr);
     mpz_clear(tmp);
-    clock_t t2 = clock();
-    sumH0 += timer_diff(t1, t2);
 }
 
 // H1: G1 × G1 -> Zp* (maps two G1 elements to Zp)
 void H1(element_t out, element_t in1, element_t in2) {
-    clock_t t1 = clock();
     unsigned char buf[2048];
     int len1 = element_length_in_bytes(in1);
     int len2 = element_length_in_bytes(in2);
@@ -69,13 +47,10 @@ void H1(element_t out, element_t in1, element_t in2) {
     hash_to_mpz(tmp, buf, len1 + len2, pairing->r);
     element_set_mpz(out, tmp);
     mpz_clear(tmp);
-    clock_t t2 = clock();
-    sumH1 += timer_diff(t1, t2);
 }
 
 // H2: G1 × G1 -> Zp* (different from H1 by adding prefix)
 void H2(element_t out, element_t in1, element_t in2) {
-    clock_t t1 = clock();
     unsigned char buf[2048];
     // Add prefix to differentiate from H1
     buf[0] = 0x02; // H2 prefix
@@ -89,13 +64,10 @@ void H2(element_t out, element_t in1, element_t in2) {
     hash_to_mpz(tmp, buf, 1 + len1 + len2, pairing->r);
     element_set_mpz(out, tmp);
     mpz_clear(tmp);
-    clock_t t2 = clock();
-    sumH2 += timer_diff(t1, t2);
 }
 
 // H3: G1 × G1 × G1 -> G1* (maps three G1 elements to G1)
 void H3(element_t out, element_t in1, element_t in2, element_t in3) {
-    clock_t t1 = clock();
     unsigned char buf[3072];
     buf[0] = 0x03; // H3 prefix
     int len1 = element_length_in_bytes(in1);
@@ -111,16 +83,13 @@ void H3(element_t out, element_t in1, element_t in2, element_t in3) {
     element_t z;
     element_init_Zr(z, pairing);
     element_set_mpz(z, tmp);
-    element_mul_zn(out, P, z);
+    element_pp_pow_zn(out, z, P_pp);
     element_clear(z);
     mpz_clear(tmp);
-    clock_t t2 = clock();
-    sumH3 += timer_diff(t1, t2);
 }
 
 // H4: (G1 × G2) × M × G2 -> Zp* (for signature)
 void H4(element_t out, element_t dvk_qr, element_t dvk_qvk, const char *msg) {
-    clock_t t1 = clock();
     unsigned char buf[4096];
     buf[0] = 0x04; // H4 prefix
     int len1 = element_length_in_bytes(dvk_qr);
@@ -136,8 +105,6 @@ void H4(element_t out, element_t dvk_qr, element_t dvk_qvk, const char *msg) {
     hash_to_mpz(tmp, buf, 1 + len1 + len2 + lenm, pairing->r);
     element_set_mpz(out, tmp);
     mpz_clear(tmp);
-    clock_t t2 = clock();
-    sumH4 += timer_diff(t1, t2);
 }
 
 void Setup(const char* param_file) {
@@ -148,13 +115,20 @@ void Setup(const char* param_file) {
 
     element_init_G1(P, pairing);
     element_random(P);
+    element_pp_init(P_pp, P);
+    pairing_pp_init(P_pairing_pp, P, pairing);
+    if (pairing_is_symmetric(pairing)) {
+        element_init_GT(ePP, pairing);
+        pairing_apply(ePP, P, P, pairing);
+        element_pp_init(ePP_pp, ePP);
+    }
 }
 
 void RootWalletKeyGen(element_t A, element_t B, element_t alpha, element_t beta) {
     element_random(alpha);
     element_random(beta);
-    element_mul_zn(A, P, alpha);
-    element_mul_zn(B, P, beta);
+    element_pp_pow_zn(A, alpha, P_pp);
+    element_pp_pow_zn(B, beta, P_pp);
 }
 
 void WalletKeyDelegate(
@@ -166,38 +140,232 @@ void WalletKeyDelegate(
     element_t beta1, 
     const char *id
 ) {
-    clock_t t1 = clock();
     element_t QID, temp;
     element_init_G1(QID, pairing);
     element_init_G1(temp, pairing);
-    clock_t t2 = clock();
     
     // Step 1: Compute Q_ID = H0(ID)
     H0(QID, id);
     
-    clock_t t3 = clock();
     // Step 2: Compute α_ID = H1(Q_ID, α_{ID_(t-1)} * Q_ID)
     element_mul_zn(temp, QID, alpha1);
-    clock_t t4 = clock();
     H1(alpha2, QID, temp);
-    clock_t t5 = clock();
     
     // Step 3: Compute β_ID = H2(Q_ID, β_{ID_(t-1)} * Q_ID)
     element_mul_zn(temp, QID, beta1);
-    clock_t t6 = clock();
     H2(beta2, QID, temp);
-    clock_t t7 = clock();
     
     // Step 4: Compute public key components
-    element_mul_zn(A2, P, alpha2);
-    element_mul_zn(B2, P, beta2);
+    element_pp_pow_zn(A2, alpha2, P_pp);
+    element_pp_pow_zn(B2, beta2, P_pp);
     
     element_clear(QID);
     element_clear(temp);
-    clock_t t8 = clock();
-    
-    // Only count non-hash operations
-    sumDelegate += timer_diff(t1, t2) + timer_diff(t3, t4) + timer_diff(t5, t6) + timer_diff(t7, t8);
+}
+
+//----------------------------------------------
+// Delegation tree: wallet keys memoized by identity path, so that each
+// shared prefix of a deep hierarchy is delegated once. A path joins IDs
+// with '/', e.g. "tenant_3/acct_7/0"; the empty path is the root key.
+//----------------------------------------------
+typedef struct wallet_node_s {
+    char *id;                       // last element of the path
+    struct wallet_node_s *parent;
+    struct wallet_node_s *next;     // next node of the same hash bucket
+    element_t QID;                  // H0(id)
+    element_t A, B, alpha, beta;
+} wallet_node_t;
+
+typedef struct {
+    wallet_node_t root;
+    wallet_node_t **bucket;         // nodes by (parent, id)
+    size_t nbuckets, count;
+} wallet_tree_t;
+
+static size_t node_hash(const wallet_node_t *parent, const char *id, size_t len) {
+    uint64_t h = 14695981039346656037ULL ^ (uint64_t)(uintptr_t)parent;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)id[i];
+        h *= 1099511628211ULL;
+    }
+    return (size_t)h;
+}
+
+static wallet_node_t *tree_find(wallet_tree_t *t, wallet_node_t *parent, const char *id, size_t len) {
+    wallet_node_t *n = t->bucket[node_hash(parent, id, len) % t->nbuckets];
+    for (; n; n = n->next)
+        if (n->parent == parent && !strncmp(n->id, id, len) && !n->id[len]) return n;
+    return NULL;
+}
+
+static void node_init(wallet_node_t *n) {
+    element_init_G1(n->QID, pairing);
+    element_init_G1(n->A, pairing);
+    element_init_G1(n->B, pairing);
+    element_init_Zr(n->alpha, pairing);
+    element_init_Zr(n->beta, pairing);
+}
+
+static void node_clear(wallet_node_t *n) {
+    element_clear(n->QID);
+    element_clear(n->A);
+    element_clear(n->B);
+    element_clear(n->alpha);
+    element_clear(n->beta);
+    free(n->id);
+}
+
+// Empty node for id under parent, or NULL if out of memory
+static wallet_node_t *tree_add(wallet_tree_t *t, wallet_node_t *parent, const char *id, size_t len) {
+    if (t->count >= 2 * t->nbuckets) {
+        size_t nb = 2 * t->nbuckets;
+        wallet_node_t **bucket = calloc(nb, sizeof(*bucket));
+        if (!bucket) return NULL;
+        for (size_t i = 0; i < t->nbuckets; i++) {
+            while (t->bucket[i]) {
+                wallet_node_t *n = t->bucket[i];
+                t->bucket[i] = n->next;
+                size_t j = node_hash(n->parent, n->id, strlen(n->id)) % nb;
+                n->next = bucket[j];
+                bucket[j] = n;
+            }
+        }
+        free(t->bucket);
+        t->bucket = bucket;
+        t->nbuckets = nb;
+    }
+
+    wallet_node_t *n = malloc(sizeof(*n));
+    char *copy = malloc(len + 1);
+    if (!n || !copy) {
+        free(n);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, id, len);
+    copy[len] = '\0';
+    n->id = copy;
+    n->parent = parent;
+    node_init(n);
+    size_t j = node_hash(parent, id, len) % t->nbuckets;
+    n->next = t->bucket[j];
+    t->bucket[j] = n;
+    t->count++;
+    return n;
+}
+
+// WalletKeyDelegate from n->parent to n
+static void node_delegate(wallet_node_t *n, element_t temp, mpz_t z) {
+    wallet_node_t *parent = n->parent;
+
+    // Q_ID = H0(ID)
+    hash_to_mpz(z, (const unsigned char *)n->id, strlen(n->id), pairing->r);
+    element_pp_pow(n->QID, z, P_pp);
+
+    element_mul_zn(temp, n->QID, parent->alpha);
+    H1(n->alpha, n->QID, temp);
+    element_mul_zn(temp, n->QID, parent->beta);
+    H2(n->beta, n->QID, temp);
+
+    element_pp_pow_zn(n->A, n->alpha, P_pp);
+    element_pp_pow_zn(n->B, n->beta, P_pp);
+}
+
+void WalletTreeInit(wallet_tree_t *t, element_t A, element_t B, element_t alpha, element_t beta) {
+    t->nbuckets = 64;
+    t->bucket = calloc(t->nbuckets, sizeof(*t->bucket));
+    t->count = 0;
+    t->root.id = NULL;
+    t->root.parent = t->root.next = NULL;
+    node_init(&t->root);
+    element_set(t->root.A, A);
+    element_set(t->root.B, B);
+    element_set(t->root.alpha, alpha);
+    element_set(t->root.beta, beta);
+}
+
+void WalletTreeClear(wallet_tree_t *t) {
+    for (size_t i = 0; i < t->nbuckets; i++) {
+        while (t->bucket[i]) {
+            wallet_node_t *n = t->bucket[i];
+            t->bucket[i] = n->next;
+            node_clear(n);
+            free(n);
+        }
+    }
+    free(t->bucket);
+    node_clear(&t->root);
+}
+
+// Wallet key at path, delegating and memoizing every missing prefix.
+// Returns NULL for an empty path element or when out of memory.
+wallet_node_t *WalletTreeDerive(wallet_tree_t *t, const char *path) {
+    wallet_node_t *node = &t->root;
+    element_t temp;
+    mpz_t z;
+    element_init_G1(temp, pairing);
+    mpz_init(z);
+
+    while (node && *path) {
+        const char *end = strchr(path, '/');
+        size_t len = end ? (size_t)(end - path) : strlen(path);
+        wallet_node_t *child = len ? tree_find(t, node, path, len) : NULL;
+        if (!child && len) {
+            child = tree_add(t, node, path, len);
+            if (child) node_delegate(child, temp, z);
+        }
+        node = child;
+        path += len + (end ? 1 : 0);
+        if (end && !*path) node = NULL;   // trailing '/'
+    }
+
+    element_clear(temp);
+    mpz_clear(z);
+    return node;
+}
+
+// The children ids[0..n) of parent in one pass, every missing one
+// delegated once however often its ID repeats. out[i] receives the node
+// of ids[i]. Returns n, or -1 when out of memory or an ID is empty or
+// contains '/'.
+int WalletKeyDelegateBatch(wallet_node_t *out[], wallet_tree_t *t, wallet_node_t *parent,
+                           const char *ids[], int n) {
+    wallet_node_t **fresh = malloc((n > 0 ? n : 1) * sizeof(*fresh));
+    if (!fresh) return -1;
+
+    // Look up every ID first; a repeated ID maps to the same new node
+    int missing = 0;
+    for (int i = 0; i < n; i++) {
+        size_t len = strlen(ids[i]);
+        if (!len || strchr(ids[i], '/')) {
+            n = -1;
+            break;
+        }
+        out[i] = tree_find(t, parent, ids[i], len);
+        if (!out[i]) {
+            out[i] = tree_add(t, parent, ids[i], len);
+            if (!out[i]) {
+                n = -1;
+                break;
+            }
+            fresh[missing++] = out[i];
+        }
+    }
+
+    // Nodes added before a failure are still delegated, so that the
+    // tree holds no half-made keys
+    if (missing) {
+        element_t temp;
+        mpz_t z;
+        element_init_G1(temp, pairing);
+        mpz_init(z);
+        for (int i = 0; i < missing; i++) node_delegate(fresh[i], temp, z);
+        element_clear(temp);
+        mpz_clear(z);
+    }
+
+    free(fresh);
+    return n;
 }
 
 void VerifyKeyDerive(
@@ -206,7 +374,6 @@ void VerifyKeyDerive(
     element_t A, 
     element_t B
 ) {
-    clock_t t1 = clock();
     element_t r, rP, betaRp, h3, negA;
     element_init_Zr(r, pairing);
     element_init_G1(rP, pairing);
@@ -218,17 +385,15 @@ void VerifyKeyDerive(
     element_random(r);
     
     // Step 2: Compute Qr = r*P
-    element_mul_zn(Qr, P, r);
+    element_pp_pow_zn(Qr, r, P_pp);
     
     // For H3 computation, we need β_ID * r * P
     // Since we don't have β_ID directly, we compute r * B_ID (which equals β_ID * r * P)
     element_mul_zn(betaRp, B, r);
-    clock_t t2 = clock();
     
     // Step 3: Compute H3(B_ID, Qr, β_ID * r * P)
     H3(h3, B, Qr, betaRp);
     
-    clock_t t3 = clock();
     // Step 4: Compute Qvk = ê(H3(...), -A_ID)
     element_neg(negA, A);
     pairing_apply(Qvk, h3, negA, pairing);
@@ -238,10 +403,6 @@ void VerifyKeyDerive(
     element_clear(betaRp);
     element_clear(h3);
     element_clear(negA);
-    clock_t t4 = clock();
-    
-    // Only count non-hash operations
-    sumVerifyKey += timer_diff(t1, t2) + timer_diff(t3, t4);
 }
 
 int VerifyKeyCheck(
@@ -251,7 +412,6 @@ int VerifyKeyCheck(
     element_t B, 
     element_t beta
 ){
-    clock_t t1 = clock();
     element_t betaQr, h3, echeck, negA;
     element_init_G1(betaQr, pairing);
     element_init_G1(h3, pairing);
@@ -260,12 +420,10 @@ int VerifyKeyCheck(
     
     // Compute β_ID * Qr
     element_mul_zn(betaQr, Qr, beta);
-    clock_t t2 = clock();
     
     // Compute H3(B_ID, Qr, β_ID * Qr)
     H3(h3, B, Qr, betaQr);
     
-    clock_t t3 = clock();
     // Compute ê(H3(...), -A_ID)
     element_neg(negA, A);
     pairing_apply(echeck, h3, negA, pairing);
@@ -277,10 +435,7 @@ int VerifyKeyCheck(
     element_clear(h3);
     element_clear(echeck);
     element_clear(negA);
-    clock_t t4 = clock();
     
-    // Only count non-hash operations
-    sumCheck += timer_diff(t1, t2) + timer_diff(t3, t4);
     return valid;
 }
 
@@ -291,28 +446,21 @@ void SignKeyDerive(
     element_t alpha, 
     element_t beta
 ) {
-    clock_t t1 = clock();
     element_t betaQr, h3;
     element_init_G1(betaQr, pairing);
     element_init_G1(h3, pairing);
     
     // Compute β_ID * Qr
     element_mul_zn(betaQr, Qr, beta);
-    clock_t t2 = clock();
     
     // Compute H3(B_ID, Qr, β_ID * Qr)
     H3(h3, B, Qr, betaQr);
     
-    clock_t t3 = clock();
     // Compute dsk = α_ID * H3(...)
     element_mul_zn(dsk, h3, alpha);
     
     element_clear(betaQr);
     element_clear(h3);
-    clock_t t4 = clock();
-    
-    // Only count non-hash operations
-    sumSignKey += timer_diff(t1, t2) + timer_diff(t3, t4);
 }
 
 void Sign(
@@ -323,7 +471,6 @@ void Sign(
     element_t Qvk, 
     const char *msg
 ) {
-    clock_t t1 = clock();
     element_t x, xP, eXP;
     element_init_Zr(x, pairing);
     element_init_G1(xP, pairing);
@@ -333,17 +480,15 @@ void Sign(
     element_random(x);
     
     // Step 2: Compute X = x*P
-    element_mul_zn(xP, P, x);
+    element_pp_pow_zn(xP, x, P_pp);
     
-    // Step 3: Compute ê(X, P) = ê(x*P, P)
-    pairing_apply(eXP, xP, P, pairing);
-    clock_t t2 = clock();
+    // Step 3: Compute ê(X, P) = ê(x*P, P) = ê(P, P)^x
+    element_pp_pow_zn(eXP, x, ePP_pp);
     
     // Step 4: Compute h = H4(dvk, m, ê(x*P, P))
     // Note: dvk = (Qr, Qvk), so we need to hash both components
     H4(h, Qr, Qvk, msg);
     
-    clock_t t3 = clock();
     // Step 5: Compute Q_σ = h * dsk + x*P
     element_t hdsk;
     element_init_G1(hdsk, pairing);
@@ -354,10 +499,6 @@ void Sign(
     element_clear(xP);
     element_clear(eXP);
     element_clear(hdsk);
-    clock_t t4 = clock();
-    
-    // Only count non-hash operations
-    sumSign += timer_diff(t1, t2) + timer_diff(t3, t4);
 }
 
 int Verify(
@@ -366,7 +507,6 @@ int Verify(
     element_t Qr, 
     element_t Qvk, 
     const char *msg) {
-    clock_t t1 = clock();
     element_t e1, e2, prod, hcheck;
     element_init_GT(e1, pairing);
     element_init_GT(e2, pairing);
@@ -374,19 +514,17 @@ int Verify(
     element_init_Zr(hcheck, pairing);
     
     // Step 1: Compute ê(Q_σ, P)
-    pairing_apply(e1, Q_sigma, P, pairing);
+    pairing_pp_apply(e1, Q_sigma, P_pairing_pp);
     
     // Step 2: Compute (Q_vk)^h
     element_pow_zn(e2, Qvk, h);
     
     // Step 3: Compute ê(Q_σ, P) * (Q_vk)^h
     element_mul(prod, e1, e2);
-    clock_t t2 = clock();
     
     // Step 4: Compute h' = H4(dvk, m, ê(Q_σ, P) * (Q_vk)^h)
     H4(hcheck, Qr, Qvk, msg);
     
-    clock_t t3 = clock();
     // Step 5: Check if h = h'
     int valid = (element_cmp(h, hcheck) == 0);
     
@@ -394,85 +532,126 @@ int Verify(
     element_clear(e2);
     element_clear(prod);
     element_clear(hcheck);
-    clock_t t4 = clock();
     
-    // Only count non-hash operations
-    sumVerify += timer_diff(t1, t2) + timer_diff(t3, t4);
     return valid;
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <param_file>\n", argv[0]);
-        return 1;
+//----------------------------------------------
+// Benchmark registration (see bench.h)
+//----------------------------------------------
+static element_t A, B, alpha, beta;
+static element_t A2, B2, alpha2, beta2, Qr, Qvk, dsk, h, Q_sigma;
+static const char *msg = "hello world";
+static int run_id;
+
+static int bench_setup(const char *param_file) {
+    Setup(param_file);
+    if (!pairing_is_symmetric(pairing)) {
+        pairing_pp_clear(P_pairing_pp);
+        element_pp_clear(P_pp);
+        element_clear(P);
+        pairing_clear(pairing);
+        return 0;
     }
-    
-    // 1) Setup once
-    Setup(argv[1]);
-    
-    // 2) KeyGen once
-    element_t A, B, alpha, beta;
-    element_init_G1(A, pairing); 
+
+    // Root wallet key, fixed for the whole run
+    element_init_G1(A, pairing);
     element_init_G1(B, pairing);
-    element_init_Zr(alpha, pairing); 
+    element_init_Zr(alpha, pairing);
     element_init_Zr(beta, pairing);
-       
-    RootWalletKeyGen(A, B, alpha, beta); 
-
-    const char *msg = "hello world";
-    
-    for (int i = 0; i < RUN_COUNT; i++) {
-        element_t A2, B2, alpha2, beta2, Qr, Qvk, dsk, h, Q_sigma;
-        element_init_G1(A2, pairing);
-        element_init_G1(B2, pairing);
-        element_init_Zr(alpha2, pairing);
-        element_init_Zr(beta2, pairing);
-        element_init_G1(Qr, pairing);
-        element_init_GT(Qvk, pairing);
-        element_init_G1(dsk, pairing);
-        element_init_Zr(h, pairing);
-        element_init_G1(Q_sigma, pairing);
-
-        char id_buf[64];
-        sprintf(id_buf, "user_%d", i);
-
-        // Execute the protocol
-        WalletKeyDelegate(A2, B2, alpha2, beta2, alpha, beta, id_buf);
-        VerifyKeyDerive(Qr, Qvk, A2, B2);
-
-        int valid = VerifyKeyCheck(Qvk, Qr, A2, B2, beta2);
-        if (!valid) {
-            printf("[!] KeyCheck failed on run %d\n", i);
-            continue;
-        }
+    RootWalletKeyGen(A, B, alpha, beta);
 
-        SignKeyDerive(dsk, Qr, B2, alpha2, beta2);
-        Sign(h, Q_sigma, dsk, Qr, Qvk, msg);
-        int verify = Verify(h, Q_sigma, Qr, Qvk, msg);
-
-        if (!verify) {
-            printf("[!] Signature verification failed on run %d\n", i);
-        }
-
-        element_clear(A2);
-        element_clear(B2);
-        element_clear(alpha2);
-        element_clear(beta2);
-        element_clear(Qr);
-        element_clear(Qvk);
-        element_clear(dsk);
-        element_clear(h);
-        element_clear(Q_sigma);
-    }
-
-    PrintAverageTimes();
+    element_init_G1(A2, pairing);
+    element_init_G1(B2, pairing);
+    element_init_Zr(alpha2, pairing);
+    element_init_Zr(beta2, pairing);
+    element_init_G1(Qr, pairing);
+    element_init_GT(Qvk, pairing);
+    element_init_G1(dsk, pairing);
+    element_init_Zr(h, pairing);
+    element_init_G1(Q_sigma, pairing);
+    run_id = 0;
+    return 1;
+}
 
+static void bench_teardown(void) {
     element_clear(A);
     element_clear(B);
     element_clear(alpha);
     element_clear(beta);
+    element_clear(A2);
+    element_clear(B2);
+    element_clear(alpha2);
+    element_clear(beta2);
+    element_clear(Qr);
+    element_clear(Qvk);
+    element_clear(dsk);
+    element_clear(h);
+    element_clear(Q_sigma);
+    element_pp_clear(ePP_pp);
+    element_clear(ePP);
+    pairing_pp_clear(P_pairing_pp);
+    element_pp_clear(P_pp);
     element_clear(P);
     pairing_clear(pairing);
+}
+
+// Delegates a fresh child wallet key of the root for every run
+static int bench_keygen(void) {
+    char id_buf[64];
+    sprintf(id_buf, "user_%d", run_id++);
+    WalletKeyDelegate(A2, B2, alpha2, beta2, alpha, beta, id_buf);
+    return 1;
+}
+
+static int bench_addr_gen(void) {
+    VerifyKeyDerive(Qr, Qvk, A2, B2);
+    return 1;
+}
+
+static int bench_recognize(void) {
+    return VerifyKeyCheck(Qvk, Qr, A2, B2, beta2);
+}
+
+static int bench_skgen(void) {
+    SignKeyDerive(dsk, Qr, B2, alpha2, beta2);
+    return 1;
+}
+
+static int bench_sign(void) {
+    Sign(h, Q_sigma, dsk, Qr, Qvk, msg);
+    return 1;
+}
+
+static int bench_verify(void) {
+    return Verify(h, Q_sigma, Qr, Qvk, msg);
+}
+
+static void bench_seed(unsigned int seed) {
+    pbc_random_set_deterministic(seed);
+}
+
+static void bench_sizes(bench_sizes_t *sz) {
+    sz->g1 = pairing_length_in_bytes_G1(pairing);
+    sz->g1_compressed = pairing_length_in_bytes_compressed_G1(pairing);
+    sz->gt = pairing_length_in_bytes_GT(pairing);
+    sz->zr = pairing_length_in_bytes_Zr(pairing);
+    sz->r_bits = mpz_sizeinbase(pairing->r, 2);
+}
 
-    return 0;
-}
\ No newline at end of file
+const bench_scheme_t bench_scheme = {
+    .name = "hdwsa",
+    .builtin_param = NULL,
+    .setup = bench_setup,
+    .teardown = bench_teardown,
+    .sizes = bench_sizes,
+    .seed = bench_seed,
+    .op = {
+        [BENCH_KEYGEN] = bench_keygen,
+        [BENCH_ADDR_GEN] = bench_addr_gen,
+        [BENCH_RECOGNIZE] = bench_recognize,
+        [BENCH_SKGEN] = bench_skgen,
+        [BENCH_SIGN] = bench_sign,
+        [BENCH_VERIFY] = bench_verify,
+    },
+};
@@ -1,8 +1,7 @@
 /****************************************************************************
  * File: traceable_transaction.c
  * Desc: Traceable Anonymous Transaction Scheme using PBC + SHA256,
- *       now measuring OnetimeAddrGen / AddressVerify / OnetimeSKGen /
- *       Sign / Verify / IdentityTracing over 100 runs in ms.
+ *       benchmarked through the shared harness in bench.c.
  ****************************************************************************/
 
  #include <stdio.h>
@@ -11,24 +10,13 @@
  #include <pbc/pbc.h>
  #include <pbc/pbc_test.h>
  #include <openssl/sha.h>
- #include <time.h>
+ #include "bench.h"
  
  // Global variable
  pairing_t pairing;
  element_t g;
- 
- // We only record times for these 6 functions:
-    static double sumAddrGen=0, sumAddrVerify=0, sumFastAddrVerify=0, sumOnetimeSK=0,
-                sumSign=0, sumVerify=0, sumTrace=0,sumH1=0,sumH2=0,sumH3=0,sumH4=0;
-    
- static const int RUN_COUNT = 100;
- 
- //----------------------------------------------
- // Timer helper
- //----------------------------------------------
- double timer_diff(clock_t start, clock_t end) {
-     return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0; // in ms
- }
+ element_t egg;        // e(g, g), so that Sign needs no pairing
+ element_pp_t egg_pp;
  
  //----------------------------------------------
  // hash_to_mpz: do sha256 -> mpz mod r
@@ -44,7 +32,6 @@
  // H1, H2, H3 => produce element in G1 or Zr
  //----------------------------------------------
  void H1(element_t outZr, element_t inG1) {
-     clock_t t1 = clock();
      unsigned char buf[1024];
      size_t len = element_length_in_bytes(inG1);
      element_to_bytes(buf, inG1);
@@ -54,13 +41,10 @@
  
      element_set_mpz(outZr, tmpz);
      mpz_clear(tmpz);
-     clock_t t2 = clock();
-     sumH1 += timer_diff(t1, t2);
 
  }
  
  void H2(element_t outG1, element_t inAny) {
-     clock_t t1 = clock();
      unsigned char buf[1024];
      size_t len = element_length_in_bytes(inAny);
      element_to_bytes(buf, inAny);
@@ -75,12 +59,9 @@
  
      mpz_clear(tmpz);
      element_clear(z);
-     clock_t t2 = clock();
-     sumH2 += timer_diff(t1, t2);
  }
  
  void H3(element_t outG1, element_t inG1) {
-     clock_t t1 = clock();
      unsigned char buf[1024];
      size_t len = element_length_in_bytes(inG1);
      element_to_bytes(buf, inG1);
@@ -95,15 +76,12 @@
  
      mpz_clear(tmpz);
      element_clear(z);
-     clock_t t2 = clock();
-     sumH3 += timer_diff(t1, t2);
  }
  
  //----------------------------------------------
  // H4: (G1, msg, G2) -> Zr
  //----------------------------------------------
  void H4(element_t outZr, element_t addr, const char* msg, element_t X) {
-     clock_t t1 = clock();
      unsigned char buf[2048];
      unsigned char g1buf[512];
      unsigned char g2buf[512];
@@ -126,12 +104,10 @@
      element_set_mpz(outZr, tmpz);
  
      mpz_clear(tmpz);
-     clock_t t2 = clock();
-     sumH4 += timer_diff(t1, t2);
  }
  
  //----------------------------------------------
- // Setup: do once, no measure
+ // Setup
  //----------------------------------------------
  void Setup(const char* param_file) {
      // Use pbc_demo_pairing_init => param_file
@@ -142,10 +118,15 @@
  
      element_init_G1(g, pairing);
      element_random(g);
+     if (pairing_is_symmetric(pairing)) {
+         element_init_GT(egg, pairing);
+         pairing_apply(egg, g, g, pairing);
+         element_pp_init(egg_pp, egg);
+     }
  }
  
  //----------------------------------------------
- // KeyGen: do once, no measure
+ // KeyGen
  //----------------------------------------------
  void KeyGen(element_t A, element_t B, element_t aZ, element_t bZ) {
      element_random(aZ);
@@ -155,7 +136,7 @@
  }
  
  //----------------------------------------------
- // TraceKeyGen: do once, no measure
+ // TraceKeyGen
  //----------------------------------------------
  void TraceKeyGen(element_t TK, element_t kZ) {
      element_random(kZ);
@@ -163,7 +144,7 @@
  }
  
  //----------------------------------------------
- // OnetimeAddrGen (time measured, sum in sumAddrGen)
+ // OnetimeAddrGen
  //----------------------------------------------
  void OnetimeAddrGen(
      element_t Addr,
@@ -174,8 +155,6 @@
      element_t B_r,
      element_t TK
  ) {
-     clock_t t1 = clock();
- 
      element_t rZ, r2Z; 
      element_init_Zr(rZ, pairing);
      element_init_Zr(r2Z, pairing);
@@ -200,11 +179,8 @@
  
      pairing_apply(pairing_res, R2, TK, pairing);
      element_pow_zn(pairing_res_powr, pairing_res, rZ);
-     clock_t t2 = clock();
-     sumAddrGen += timer_diff(t1, t2);
  
      H2(R3, pairing_res_powr);
-     clock_t t3 = clock();
     
      // Addr = R3 * B_r * C
      element_mul(Addr, R3, B_r);
@@ -216,9 +192,6 @@
      element_clear(Ar_pow_r);
      element_clear(pairing_res);
      element_clear(pairing_res_powr);
- 
-     clock_t t4 = clock();
-     sumAddrGen += timer_diff(t3, t4);
  }
  
  //----------------------------------------------
@@ -226,8 +199,6 @@
  //----------------------------------------------
  int AddressVerify(element_t Addr, element_t R1, element_t B_r,
                    element_t A_r, element_t C, element_t aZ, element_t TK) {
-     clock_t t1 = clock();
- 
      element_t R1_pow_a, C_prime, R3_prime, Addr_prime;
      element_init_G1(R1_pow_a, pairing);
      element_init_G1(C_prime, pairing);
@@ -249,12 +220,8 @@
      pairing_apply(pairing_res, R1, TK, pairing);
      element_pow_zn(pairing_res_r2Z, pairing_res, r2Z_prime);
 
-     clock_t t2 = clock();
-     sumAddrVerify += timer_diff(t1, t2);
-
      H2(R3_prime, pairing_res_r2Z);
  
-     clock_t t3 = clock();
      element_mul(Addr_prime, R3_prime, B_r);
      element_mul(Addr_prime, Addr_prime, C_prime);
  
@@ -268,9 +235,6 @@
      element_clear(pairing_res);
      element_clear(pairing_res_r2Z);
  
-     clock_t t4 = clock();
-     sumAddrVerify += timer_diff(t3, t4);
- 
      return eq;
  }
 
@@ -281,8 +245,6 @@
     element_t C,        // input
     element_t aZ        // input (svk in Zr)
 ) {
-    clock_t t1 = clock();
-
     // 1) r2' = H1( (R1)^aZ )
     element_t R1_pow_a;
     element_init_G1(R1_pow_a, pairing);
@@ -305,9 +267,6 @@
     element_clear(r2Z_prime);
     element_clear(C_prime);
 
-    clock_t t2 = clock();    
-    sumFastAddrVerify += timer_diff(t1, t2);
-
     return eq; // 1 if pass, 0 if fail
 }
  //----------------------------------------------
@@ -315,8 +274,6 @@
  //----------------------------------------------
  void OnetimeSKGen(element_t dsk, element_t Addr, element_t R1,
                    element_t aZ, element_t bZ) {
-     clock_t t1 = clock();
- 
      element_t R1_pow_a; element_init_G1(R1_pow_a, pairing);
      element_pow_zn(R1_pow_a, R1, aZ);
  
@@ -327,11 +284,8 @@
      element_mul(exp, bZ, r2Z);
  
      element_t h3_addr; element_init_G1(h3_addr, pairing);
-     clock_t t2 = clock();
-     sumOnetimeSK += timer_diff(t1, t2);
 
      H3(h3_addr, Addr);
-     clock_t t3 = clock();
  
      element_pow_zn(dsk, h3_addr, exp);
  
@@ -339,25 +293,21 @@
      element_clear(r2Z);
      element_clear(exp);
      element_clear(h3_addr);
- 
-     clock_t t4 = clock();
-     sumOnetimeSK += timer_diff(t3, t4);
  }
  
  //----------------------------------------------
  // Sign
  //----------------------------------------------
  void Sign(element_t Q_sigma, element_t hZ, element_t Addr, element_t dsk, const char* msg) {
-     clock_t t1 = clock();
- 
      element_t xZ; element_init_Zr(xZ, pairing);
      element_random(xZ);
  
      element_t gx; element_init_G1(gx, pairing);
      element_pow_zn(gx, g, xZ);
  
+     // e(g, g)^x = e(g^x, g)
      element_t XGT; element_init_GT(XGT, pairing);
-     pairing_apply(XGT, gx, g, pairing);
+     element_pp_pow_zn(XGT, xZ, egg_pp);
  
      H4(hZ, Addr, msg, XGT);
  
@@ -374,9 +324,6 @@
      element_clear(XGT);
      element_clear(neg_hZ);
      element_clear(dsk_inv_h);
- 
-     clock_t t2 = clock();
-     sumSign += timer_diff(t1, t2);
  }
  
  //----------------------------------------------
@@ -384,14 +331,9 @@
  //----------------------------------------------
  int Verify(element_t Addr, element_t R2, element_t C,
             const char* msg, element_t hZ, element_t Q_sigma) {
-     clock_t t1 = clock();
- 
      element_t h3_addr; element_init_G1(h3_addr, pairing);
-     clock_t t2 = clock();
-     sumVerify += timer_diff(t1, t2);
  
      H3(h3_addr, Addr);
-     clock_t t3 = clock();
  
      element_t pairing1, pairing2, pairing2_exp, prod;
      element_init_GT(pairing1, pairing);
@@ -416,9 +358,6 @@
      element_clear(prod);
      element_clear(hZ_prime);
  
-     clock_t t4 = clock();
-     sumVerify += timer_diff(t3, t4);
- 
      return valid;
  }
  
@@ -426,8 +365,6 @@
  // IdentityTracing
  //----------------------------------------------
  void IdentityTracing(element_t B_r, element_t Addr, element_t R1, element_t R2, element_t C, element_t kZ) {
-     clock_t t1 = clock();
- 
      element_t pairing_res, pairing_powk, R3;
      element_init_GT(pairing_res, pairing);
      element_init_GT(pairing_powk, pairing);
@@ -435,10 +372,7 @@
  
      pairing_apply(pairing_res, R1, R2, pairing);
      element_pow_zn(pairing_powk, pairing_res, kZ);
-     clock_t t2 = clock();
-     sumTrace += timer_diff(t1, t2);
      H2(R3, pairing_powk);
-     clock_t t3 = clock();
  
      element_t R3_inv, C_inv;
      element_init_G1(R3_inv, pairing);
@@ -455,108 +389,120 @@
      element_clear(R3);
      element_clear(R3_inv);
      element_clear(C_inv);
- 
-     clock_t t4 = clock();
-     sumTrace += timer_diff(t3, t4);
- }
- 
- //----------------------------------------------
- // Print average times (for the 6 funcs) in ms
- //----------------------------------------------
- void PrintAverageTimes() {
-     printf("\n=== Average runtime over %d runs (ms) ===\n", RUN_COUNT);
-     printf("OnetimeAddrGen:  %.3f ms\n", sumAddrGen   / RUN_COUNT);
-     printf("AddressVerify:   %.3f ms\n", sumAddrVerify/ RUN_COUNT);
-     printf("FastAddressVerify:   %.3f ms\n", sumFastAddrVerify/ RUN_COUNT);
-     printf("OnetimeSKGen:    %.3f ms\n", sumOnetimeSK / RUN_COUNT);
-     printf("Sign:            %.3f ms\n", sumSign      / RUN_COUNT);
-     printf("Verify:          %.3f ms\n", sumVerify    / RUN_COUNT);
-     printf("IdentityTracing: %.3f ms\n", sumTrace     / RUN_COUNT);
-     printf("H1: %.3f ms\n", sumH1     / (4*RUN_COUNT));
-     printf("H2: %.3f ms\n", sumH2     / (3*RUN_COUNT));
-     printf("H3: %.3f ms\n", sumH3     / (2*RUN_COUNT));
-     printf("H4: %.3f ms\n", sumH4     / (2*RUN_COUNT));
-
  }
  
  //----------------------------------------------
- // main
+ // Benchmark registration (see bench.h)
  //----------------------------------------------
- int main(int argc, char **argv) {
-     if (argc < 2) {
-         fprintf(stderr, "Usage: %s <param_file>\n", argv[0]);
-         return 1;
+ static element_t A, B, a, b, TK, k;
+ static element_t Addr, R1, R2, C, dsk, Q_sigma, hZ, B_recovered;
+ static const char *msg = "Test message";
+ 
+ static int bench_setup(const char *param_file) {
+     Setup(param_file);
+     if (!pairing_is_symmetric(pairing)) {
+         element_clear(g);
+         pairing_clear(pairing);
+         return 0;
      }
  
-     // 1) Setup once
-     Setup(argv[1]);
- 
-     // 2) KeyGen once
-     element_t A, B, a, b;
      element_init_G1(A, pairing);
      element_init_G1(B, pairing);
      element_init_Zr(a, pairing);
      element_init_Zr(b, pairing);
-     KeyGen(A, B, a, b);
- 
-     // 3) TraceKeyGen once
-     element_t TK, k;
      element_init_G1(TK, pairing);
      element_init_Zr(k, pairing);
      TraceKeyGen(TK, k);
  
-     // 4) Now do a loop for 100 times
-     for(int i=0; i<RUN_COUNT; i++){
-         // We create ephemeral R1,R2,C,Addr etc
-         element_t Addr, R1, R2, C;
-         element_init_G1(Addr, pairing);
-         element_init_G1(R1, pairing);
-         element_init_G1(R2, pairing);
-         element_init_G1(C, pairing);
- 
-         // (A, B, TK, a, b, k) are from KeyGen / TraceKeyGen
-         OnetimeAddrGen(Addr, R1, R2, C, A, B, TK);
- 
-         int ok = AddressVerify(Addr, R1, B, A, C, a, TK);
-         int ok2= accelerateAddrVerify( R1, B, A, C, a);
-         element_t dsk;
-         element_init_G1(dsk, pairing);
-         OnetimeSKGen(dsk, Addr, R1, a, b);
- 
-         const char* msg = "Test message";
-         element_t Q_sigma, hZ;
-         element_init_G1(Q_sigma, pairing);
-         element_init_Zr(hZ, pairing);
- 
-         Sign(Q_sigma, hZ, Addr, dsk, msg);
- 
-         int valid = Verify(Addr, R2, C, msg, hZ, Q_sigma);
- 
-         element_t B_recovered;
-         element_init_G1(B_recovered, pairing);
-         IdentityTracing(B_recovered, Addr, R1, R2, C, k);
- 
-         // free ephemeral
-         element_clear(Addr);
-         element_clear(R1);
-         element_clear(R2);
-         element_clear(C);
-         element_clear(dsk);
-         element_clear(Q_sigma);
-         element_clear(hZ);
-         element_clear(B_recovered);
-     }
- 
-     // show average times
-     PrintAverageTimes();
+     element_init_G1(Addr, pairing);
+     element_init_G1(R1, pairing);
+     element_init_G1(R2, pairing);
+     element_init_G1(C, pairing);
+     element_init_G1(dsk, pairing);
+     element_init_G1(Q_sigma, pairing);
+     element_init_Zr(hZ, pairing);
+     element_init_G1(B_recovered, pairing);
+     return 1;
+ }
  
-     // final cleanup
+ static void bench_teardown(void) {
      element_clear(A); element_clear(B);
      element_clear(a); element_clear(b);
      element_clear(TK); element_clear(k);
+     element_clear(Addr); element_clear(R1);
+     element_clear(R2); element_clear(C);
+     element_clear(dsk); element_clear(Q_sigma);
+     element_clear(hZ); element_clear(B_recovered);
+     element_pp_clear(egg_pp);
+     element_clear(egg);
      element_clear(g);
      pairing_clear(pairing);
+ }
+ 
+ static int bench_keygen(void) {
+     KeyGen(A, B, a, b);
+     return 1;
+ }
+ 
+ static int bench_addr_gen(void) {
+     OnetimeAddrGen(Addr, R1, R2, C, A, B, TK);
+     return 1;
+ }
+ 
+ static int bench_recognize(void) {
+     return AddressVerify(Addr, R1, B, A, C, a, TK);
+ }
  
-     return 0;
+ static int bench_recognize_fast(void) {
+     return accelerateAddrVerify(R1, B, A, C, a);
  }
- 
\ No newline at end of file
+ 
+ static int bench_skgen(void) {
+     OnetimeSKGen(dsk, Addr, R1, a, b);
+     return 1;
+ }
+ 
+ static int bench_sign(void) {
+     Sign(Q_sigma, hZ, Addr, dsk, msg);
+     return 1;
+ }
+ 
+ static int bench_verify(void) {
+     return Verify(Addr, R2, C, msg, hZ, Q_sigma);
+ }
+ 
+ static int bench_trace(void) {
+     IdentityTracing(B_recovered, Addr, R1, R2, C, k);
+     return element_cmp(B_recovered, B) == 0;
+ }
+ 
+ static void bench_seed(unsigned int seed) {
+     pbc_random_set_deterministic(seed);
+ }
+
+ static void bench_sizes(bench_sizes_t *sz) {
+     sz->g1 = pairing_length_in_bytes_G1(pairing);
+     sz->g1_compressed = pairing_length_in_bytes_compressed_G1(pairing);
+     sz->gt = pairing_length_in_bytes_GT(pairing);
+     sz->zr = pairing_length_in_bytes_Zr(pairing);
+     sz->r_bits = mpz_sizeinbase(pairing->r, 2);
+ }
+ 
+ const bench_scheme_t bench_scheme = {
+     .name = "my_stealth",
+     .builtin_param = NULL,
+     .setup = bench_setup,
+     .teardown = bench_teardown,
+     .sizes = bench_sizes,
+     .seed = bench_seed,
+     .op = {
+         [BENCH_KEYGEN] = bench_keygen,
+         [BENCH_ADDR_GEN] = bench_addr_gen,
+         [BENCH_RECOGNIZE] = bench_recognize,
+         [BENCH_RECOGNIZE_FAST] = bench_recognize_fast,
+         [BENCH_SKGEN] = bench_skgen,
+         [BENCH_SIGN] = bench_sign,
+         [BENCH_VERIFY] = bench_verify,
+         [BENCH_TRACE] = bench_trace,
+     },
+ };
@@ -4,23 +4,13 @@
  #include <pbc/pbc.h>
  #include <pbc/pbc_test.h>
  #include <openssl/sha.h>
- #include <time.h>
+ #include "bench.h"
 
 
  // Global variable
  pairing_t pairing;
  element_t g;
  
- // We only record times for these 6 functions:
-    static double sumAddrGen=0, sumAddrVerify=0, sumFastAddrVerify=0, sumOnetimeSK=0,
-                sumTrace=0,sumH1=0,sumH2=0;
-    
- static const int RUN_COUNT = 100;
-
- double timer_diff(clock_t start, clock_t end) {
-     return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0; // in ms
- }
- 
  //----------------------------------------------
  // hash_to_mpz: do sha256 -> mpz mod r
  //----------------------------------------------
@@ -31,9 +21,8 @@
      mpz_mod(out, out, mod);
  }
  
-// hash_to_mpz() 與 timer_diff() 與 traceable_transaction.c 相同
+// hash_to_mpz() 與 traceable_transaction.c 相同
 void H1(element_t outZr, element_t inG1) {
-    clock_t t1 = clock();
     unsigned char buf[1024];
     size_t len = element_length_in_bytes(inG1);
     element_to_bytes(buf, inG1);
@@ -42,12 +31,9 @@ void H1(element_t outZr, element_t inG1) {
     hash_to_mpz(tmpz, buf, len, pairing->r);
     element_set_mpz(outZr, tmpz);
     mpz_clear(tmpz);
-    clock_t t2 = clock();
-    sumH1 += timer_diff(t1, t2);
 }
 
 void H2(element_t outZr, element_t inGT) {
-    clock_t t1 = clock();
     unsigned char buf[2048];
     size_t len = element_length_in_bytes(inGT);
     element_to_bytes(buf, inGT);
@@ -56,8 +42,6 @@ void H2(element_t outZr, element_t inGT) {
     hash_to_mpz(tmpz, buf, len, pairing->r);
     element_set_mpz(outZr, tmpz);
     mpz_clear(tmpz);
-    clock_t t2 = clock();
-    sumH2 += timer_diff(t1, t2);
 }
 
 void Setup(const char* param_file) {
@@ -72,7 +56,7 @@ void Setup(const char* param_file) {
  }
  
  //----------------------------------------------
- // KeyGen: do once, no measure
+ // KeyGen
  //----------------------------------------------
  void KeyGen(element_t A, element_t B, element_t aZ, element_t bZ) {
      element_random(aZ);
@@ -85,7 +69,6 @@ void Setup(const char* param_file) {
 
 void OnetimeAddrGen(element_t Addr, element_t R1, element_t R2,
                     element_t A_r, element_t B_r, element_t A_m) {
-    clock_t t1 = clock();
     element_t r1, r2, r3, tmp;
     element_init_Zr(r1, pairing);
     element_init_Zr(r2, pairing);
@@ -120,15 +103,10 @@ void OnetimeAddrGen(element_t Addr, element_t R1, element_t R2,
     element_clear(r1); element_clear(r2); element_clear(r3);
     element_clear(tmp); element_clear(Ar_pow_r1); element_clear(eR2Am);
     element_clear(r3G); element_clear(sum);
-
-    clock_t t2 = clock();
-    sumAddrGen += timer_diff(t1, t2);
 }
 
 int AddressVerify(element_t Addr, element_t R1,element_t R2, element_t A_r, element_t B_r,
                   element_t A_m, element_t a_r) {
-    clock_t t1 = clock();
-
     // Step 1: r2 = h1(a_r * R1)
     element_t R1_pow_a, r2Z;
     element_init_G1(R1_pow_a, pairing);
@@ -170,15 +148,11 @@ int AddressVerify(element_t Addr, element_t R1,element_t R2, element_t A_r, elem
     element_clear(r3Z); element_clear(r3G);
     element_clear(sum); element_clear(Addr_reconstructed);element_clear(tmp);
 
-    clock_t t2 = clock();
-    sumAddrVerify += timer_diff(t1, t2);
     return eq1&&eq2;
 }
 
 int accelerateAddrVerify(element_t R1, element_t R2,
                          element_t A_r, element_t a_r) {
-    clock_t t1 = clock();
-
     // Step 1: r2 = h1(a_r * R1)
     element_t R1_pow_a, r2Z;
     element_init_G1(R1_pow_a, pairing);
@@ -196,15 +170,12 @@ int accelerateAddrVerify(element_t R1, element_t R2,
     // cleanup
     element_clear(R1_pow_a); element_clear(r2Z); element_clear(R2_prime);
 
-    clock_t t2 = clock();
-    sumFastAddrVerify += timer_diff(t1, t2);
     return eq;
 }
 
 
 void OnetimeSKGen(element_t dsk, element_t R1, element_t a_r, element_t b_r,
                   element_t A_m) {
-    clock_t t1 = clock();
     element_t r2, r3, eR1Am;
     element_init_Zr(r2, pairing);
     element_init_Zr(r3, pairing);
@@ -227,13 +198,10 @@ void OnetimeSKGen(element_t dsk, element_t R1, element_t a_r, element_t b_r,
 
     element_clear(r2); element_clear(r3); element_clear(eR1Am);
     element_clear(R1_a); element_clear(r2a); 
-    clock_t t2 = clock();
-    sumOnetimeSK += timer_diff(t1, t2);
 }
 
 void IdentityTracing(element_t Br, element_t Addr, element_t R1,
                      element_t R2, element_t a_m) {
-    clock_t t1 = clock();
     element_t eR1R2, powed, r3;
     element_init_GT(eR1R2, pairing);
     element_init_GT(powed, pairing);
@@ -263,93 +231,105 @@ void IdentityTracing(element_t Br, element_t Addr, element_t R1,
 
     element_clear(eR1R2); element_clear(powed); element_clear(r3);
     element_clear(r3G); 
-
-    clock_t t2 = clock();
-    sumTrace += timer_diff(t1, t2);
-}
-
-void PrintAverageTimes() {
-    printf("\n=== Average runtime over %d runs (ms) ===\n", RUN_COUNT);
-    printf("OnetimeAddrGen:       %.3f ms\n", sumAddrGen        / RUN_COUNT);
-    printf("AddressVerify:        %.3f ms\n", sumAddrVerify     / RUN_COUNT);
-    printf("FastAddressVerify:    %.3f ms\n", sumFastAddrVerify / RUN_COUNT);
-    printf("OnetimeSKGen:         %.3f ms\n", sumOnetimeSK      / RUN_COUNT);
-    printf("IdentityTracing:      %.3f ms\n", sumTrace          / RUN_COUNT);
-    printf("H1: %.3f ms\n", sumH1 / (4.0 * RUN_COUNT)); // 每次使用2次
-    printf("H2: %.3f ms\n", sumH2 / (4.0 * RUN_COUNT)); // 每次使用2次
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <param_file>\n", argv[0]);
-        return 1;
+//----------------------------------------------
+// Benchmark registration (see bench.h)
+//----------------------------------------------
+static element_t A_r, B_r, a_r, b_r;
+static element_t A_m, B_m, a_m, b_dummy;
+static element_t Addr, R1, R2, dsk, Br_recovered;
+
+static int bench_setup(const char *param_file) {
+    Setup(param_file);
+    if (!pairing_is_symmetric(pairing)) {
+        element_clear(g);
+        pairing_clear(pairing);
+        return 0;
     }
 
-     // Setup once
-     Setup(argv[1]);
- 
-    // KeyGen for receiver
-    element_t A_r, B_r, a_r, b_r;
     element_init_G1(A_r, pairing);
     element_init_G1(B_r, pairing);
     element_init_Zr(a_r, pairing);
     element_init_Zr(b_r, pairing);
-    KeyGen(A_r, B_r, a_r, b_r);
 
-    // KeyGen for manager
-    element_t A_m, B_m, a_m, b_dummy;
+    // Manager key, fixed for the whole run
     element_init_G1(A_m, pairing);
     element_init_G1(B_m, pairing);
     element_init_Zr(a_m, pairing);
     element_init_Zr(b_dummy, pairing);
-    KeyGen(A_m, B_m, a_m, b_dummy); 
-
-    for (int i = 0; i < RUN_COUNT; i++) {
-        // ephemeral elements
-        element_t Addr, R1, R2;
-        element_init_G1(Addr, pairing);
-        element_init_G1(R1, pairing);
-        element_init_G1(R2, pairing);
-
-        // === 1. Generate Addr ===
-        OnetimeAddrGen(Addr, R1, R2, A_r, B_r, A_m);
-
-        // === 2. Verify Full ===
-        int ok1 = AddressVerify(Addr, R1, R2,A_r, B_r, A_m, a_r);
-        if (!ok1) printf("Full Verify FAILED at %d\n", i);
-
-        // === 3. Accelerated Verify ===
-        int ok2 = accelerateAddrVerify(R1, R2, A_r, a_r);
-        if (!ok2) printf("Fast Verify FAILED at %d\n", i);
-
-        // === 4. Generate dsk ===
-        element_t dsk;
-        element_init_G1(dsk, pairing);
-        OnetimeSKGen(dsk, R1, a_r, b_r, A_m);
-
-        // === 5. Tracing ===
-        element_t Br_recovered;
-        element_init_G1(Br_recovered, pairing);
-        IdentityTracing(Br_recovered, Addr, R1, R2, a_m);
-
-        if (element_cmp(Br_recovered, B_r) != 0)
-            printf("Tracing FAILED at %d\n", i);
-
-        // cleanup
-        element_clear(Addr);
-        element_clear(R1);
-        element_clear(R2);
-        element_clear(dsk);
-        element_clear(Br_recovered);
-    }
-
-    // output avg timing
-    PrintAverageTimes();
+    KeyGen(A_m, B_m, a_m, b_dummy);
+
+    element_init_G1(Addr, pairing);
+    element_init_G1(R1, pairing);
+    element_init_G1(R2, pairing);
+    element_init_G1(dsk, pairing);
+    element_init_G1(Br_recovered, pairing);
+    return 1;
+}
 
-    // cleanup
+static void bench_teardown(void) {
     element_clear(A_r); element_clear(B_r); element_clear(a_r); element_clear(b_r);
     element_clear(A_m); element_clear(B_m); element_clear(a_m); element_clear(b_dummy);
+    element_clear(Addr); element_clear(R1); element_clear(R2);
+    element_clear(dsk); element_clear(Br_recovered);
     element_clear(g);
     pairing_clear(pairing);
-    return 0;
 }
+
+static int bench_keygen(void) {
+    KeyGen(A_r, B_r, a_r, b_r);
+    return 1;
+}
+
+static int bench_addr_gen(void) {
+    OnetimeAddrGen(Addr, R1, R2, A_r, B_r, A_m);
+    return 1;
+}
+
+static int bench_recognize(void) {
+    return AddressVerify(Addr, R1, R2, A_r, B_r, A_m, a_r);
+}
+
+static int bench_recognize_fast(void) {
+    return accelerateAddrVerify(R1, R2, A_r, a_r);
+}
+
+static int bench_skgen(void) {
+    OnetimeSKGen(dsk, R1, a_r, b_r, A_m);
+    return 1;
+}
+
+static int bench_trace(void) {
+    IdentityTracing(Br_recovered, Addr, R1, R2, a_m);
+    return element_cmp(Br_recovered, B_r) == 0;
+}
+
+static void bench_seed(unsigned int seed) {
+    pbc_random_set_deterministic(seed);
+}
+
+static void bench_sizes(bench_sizes_t *sz) {
+    sz->g1 = pairing_length_in_bytes_G1(pairing);
+    sz->g1_compressed = pairing_length_in_bytes_compressed_G1(pairing);
+    sz->gt = pairing_length_in_bytes_GT(pairing);
+    sz->zr = pairing_length_in_bytes_Zr(pairing);
+    sz->r_bits = mpz_sizeinbase(pairing->r, 2);
+}
+
+const bench_scheme_t bench_scheme = {
+    .name = "sitaiba",
+    .builtin_param = NULL,
+    .setup = bench_setup,
+    .teardown = bench_teardown,
+    .sizes = bench_sizes,
+    .seed = bench_seed,
+    .op = {
+        [BENCH_KEYGEN] = bench_keygen,
+        [BENCH_ADDR_GEN] = bench_addr_gen,
+        [BENCH_RECOGNIZE] = bench_recognize,
+        [BENCH_RECOGNIZE_FAST] = bench_recognize_fast,
+        [BENCH_SKGEN] = bench_skgen,
+        [BENCH_TRACE] = bench_trace,
+    },
+};
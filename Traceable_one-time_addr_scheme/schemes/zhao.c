@@ -1,388 +1,330 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-#include <openssl/ec.h>
-#include <openssl/ecdsa.h>
-#include <openssl/obj_mac.h>
-#include <openssl/sha.h>
-#include <openssl/bn.h>
-#include <openssl/rand.h>
 #include <openssl/evp.h>
+#include "ec_backend.h"
+#include "bench.h"
 
-#define LOOP 100
+// Per-thread working state: the backend context, the digest context and
+// the temporary points, so that the operations below allocate nothing.
+// Every thread needs its own.
+typedef struct {
+    ec_ctx_t *ec;
+    EVP_MD_CTX *md;
+    ec_point_t t;
+    ec_point_t *batch; // batch_len points for ReceiverStatisticsBatch
+    int batch_len;
+} scratch_t;
 
-// Global variables
-EC_GROUP *group;
-EC_POINT *G;
-BIGNUM *order;
+void ScratchFree(scratch_t *s) {
+    if (!s) return;
+    for (int i = 0; i < s->batch_len; i++) ec_point_clear(&s->batch[i]);
+    free(s->batch);
+    ec_point_clear(&s->t);
+    EVP_MD_CTX_free(s->md);
+    ec_ctx_free(s->ec);
+    free(s);
+}
 
-double timer_diff(clock_t start, clock_t end) {
-    return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0;
+scratch_t *ScratchNew(void) {
+    scratch_t *s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->ec = ec_ctx_new();
+    s->md = EVP_MD_CTX_new();
+    ec_point_init(&s->t);
+    if (!s->ec || !s->md) {
+        ScratchFree(s);
+        return NULL;
+    }
+    return s;
 }
 
-double sumH1 = 0, sumH2 = 0;
-double sumGen = 0, sumStat = 0, sumSK = 0, sumTrace = 0;
+// Grows s->batch to at least n points; returns 0 if out of memory
+static int scratch_reserve(scratch_t *s, int n) {
+    if (n <= s->batch_len) return 1;
+    ec_point_t *grown = realloc(s->batch, n * sizeof(*grown));
+    if (!grown) return 0;
+    s->batch = grown;
+    for (; s->batch_len < n; s->batch_len++) ec_point_init(&s->batch[s->batch_len]);
+    return 1;
+}
 
-// H1: hash1(r1, a1*A2) -> Zp  
-void H1(BIGNUM *result, BIGNUM *r1, EC_POINT *a1A2, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-    const EVP_MD *md = EVP_sha256();
+// SHA-256 of buf, reduced into Zp
+static void hash_to_scalar(ec_scalar_t *result, const unsigned char *buf, size_t len,
+                           scratch_t *s) {
     unsigned char hash[EVP_MAX_MD_SIZE];
     unsigned int hash_len;
-    
-    EVP_DigestInit_ex(mdctx, md, NULL);
-    
-    // Add r1 to hash
-    unsigned char *r1_buf = OPENSSL_malloc(BN_num_bytes(r1));
-    int r1_len = BN_bn2bin(r1, r1_buf);
-    EVP_DigestUpdate(mdctx, r1_buf, r1_len);
-    
-    // Add a1*A2 to hash
-    size_t point_len = EC_POINT_point2oct(group, a1A2, POINT_CONVERSION_COMPRESSED, NULL, 0, ctx);
-    unsigned char *point_buf = OPENSSL_malloc(point_len);
-    EC_POINT_point2oct(group, a1A2, POINT_CONVERSION_COMPRESSED, point_buf, point_len, ctx);
-    EVP_DigestUpdate(mdctx, point_buf, point_len);
-    
-    EVP_DigestFinal_ex(mdctx, hash, &hash_len);
-    
-    // Convert hash to BIGNUM and reduce modulo order
-    BN_bin2bn(hash, hash_len, result);
-    BN_mod(result, result, order, ctx);
-    
-    // Cleanup
-    OPENSSL_free(r1_buf);
-    OPENSSL_free(point_buf);
-    EVP_MD_CTX_free(mdctx);
-    
-    clock_t t2 = clock();
-    sumH1 += timer_diff(t1, t2);
+
+    EVP_DigestInit_ex(s->md, EVP_sha256(), NULL);
+    EVP_DigestUpdate(s->md, buf, len);
+    EVP_DigestFinal_ex(s->md, hash, &hash_len);
+    ec_scalar_from_hash(s->ec, result, hash);
+}
+
+// H1: hash1(r1, a1*A2) -> Zp
+void H1(ec_scalar_t *result, const ec_scalar_t *r1, const ec_point_t *a1A2, scratch_t *s) {
+    unsigned char buf[EC_SCALAR_BYTES + EC_POINT_MAX_BYTES];
+
+    // r1 || a1*A2
+    memcpy(buf, r1->b, EC_SCALAR_BYTES);
+    size_t point_len = ec_point_bytes(s->ec, buf + EC_SCALAR_BYTES, a1A2);
+    hash_to_scalar(result, buf, EC_SCALAR_BYTES + point_len, s);
 }
 
 // H2: hash2(r2*A3) -> Zp
-void H2(BIGNUM *result, EC_POINT *r2A3, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-    const EVP_MD *md = EVP_sha256();
-    unsigned char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len;
-    
-    EVP_DigestInit_ex(mdctx, md, NULL);
-    
-    // Add r2*A3 to hash
-    size_t point_len = EC_POINT_point2oct(group, r2A3, POINT_CONVERSION_COMPRESSED, NULL, 0, ctx);
-    unsigned char *point_buf = OPENSSL_malloc(point_len);
-    EC_POINT_point2oct(group, r2A3, POINT_CONVERSION_COMPRESSED, point_buf, point_len, ctx);
-    EVP_DigestUpdate(mdctx, point_buf, point_len);
-    
-    EVP_DigestFinal_ex(mdctx, hash, &hash_len);
-    
-    // Convert hash to BIGNUM and reduce modulo order
-    BN_bin2bn(hash, hash_len, result);
-    BN_mod(result, result, order, ctx);
-    
-    // Cleanup
-    OPENSSL_free(point_buf);
-    EVP_MD_CTX_free(mdctx);
-    
-    clock_t t2 = clock();
-    sumH2 += timer_diff(t1, t2);
+void H2(ec_scalar_t *result, const ec_point_t *r2A3, scratch_t *s) {
+    unsigned char buf[EC_POINT_MAX_BYTES];
+
+    size_t point_len = ec_point_bytes(s->ec, buf, r2A3);
+    hash_to_scalar(result, buf, point_len, s);
 }
 
 void Setup() {
-    // Initialize curve (using secp256r1)
-    group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
-    if (!group) {
-        fprintf(stderr, "Failed to create EC group\n");
-        exit(1);
-    }
-    
-    // Get generator point
-    const EC_POINT *generator = EC_GROUP_get0_generator(group);
-    if (!generator) {
-        fprintf(stderr, "Failed to get generator\n");
-        exit(1);
-    }
-    G = EC_POINT_new(group);
-    EC_POINT_copy(G, generator);
-    
-    // Get order of the group
-    order = BN_new();
-    if (!EC_GROUP_get_order(group, order, NULL)) {
-        fprintf(stderr, "Failed to get group order\n");
+    // The group of the backend linked in (see ec_backend.h)
+    if (!ec_setup()) {
+        fprintf(stderr, "Failed to set up %s\n", ec_group_name);
         exit(1);
     }
 }
 
-void KeyGen(EC_POINT *A, EC_POINT *B, BIGNUM *a, BIGNUM *b, BN_CTX *ctx) {
+void KeyGen(ec_point_t *A, ec_point_t *B, ec_scalar_t *a, ec_scalar_t *b, scratch_t *s) {
     // Generate random private keys
-    BN_rand_range(a, order);
-    BN_rand_range(b, order);
-    
+    ec_scalar_random(s->ec, a);
+    ec_scalar_random(s->ec, b);
+
     // Compute public keys: A = a*G, B = b*G
-    EC_POINT_mul(group, A, NULL, G, a, ctx);
-    EC_POINT_mul(group, B, NULL, G, b, ctx);
+    ec_mul_gen(s->ec, A, a);
+    ec_mul_gen(s->ec, B, b);
 }
 
-void OnetimeAddrGen(EC_POINT *PK_one, EC_POINT *R, BIGNUM *r1,
-                    BIGNUM *a1, EC_POINT *A2, EC_POINT *A3, EC_POINT *B2,
-                    BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r2 = BN_new();
-    BIGNUM *r3 = BN_new();
-    EC_POINT *temp1 = EC_POINT_new(group);
-    EC_POINT *temp2 = EC_POINT_new(group);
-    EC_POINT *a1A2 = EC_POINT_new(group);
-    EC_POINT *r2A3 = EC_POINT_new(group);
-    
-    // a1*A2
-    EC_POINT_mul(group, a1A2, NULL, A2, a1, ctx);
-    
+void OnetimeAddrGen(ec_point_t *PK_one, ec_point_t *R, const ec_scalar_t *r1,
+                    const ec_scalar_t *a1, const ec_point_t *A2, const ec_point_t *A3,
+                    const ec_point_t *B2, scratch_t *s) {
+    ec_scalar_t r2, r3;
+
     // r2 = hash1(r1, a1*A2)
-    H1(r2, r1, a1A2, ctx);
-    
+    ec_mul(s->ec, &s->t, a1, A2);
+    H1(&r2, r1, &s->t, s);
+
     // R = r2 * G
-    EC_POINT_mul(group, R, NULL, G, r2, ctx);
-    
-    // r2*A3
-    EC_POINT_mul(group, r2A3, NULL, A3, r2, ctx);
-    
+    ec_mul_gen(s->ec, R, &r2);
+
     // r3 = hash2(r2*A3)
-    H2(r3, r2A3, ctx);
-    
+    ec_mul(s->ec, &s->t, &r2, A3);
+    H2(&r3, &s->t, s);
+
     // PK_one = r3*G + R + B2
-    EC_POINT_mul(group, temp1, NULL, G, r3, ctx);  // r3*G
-    EC_POINT_add(group, temp2, temp1, R, ctx);     // r3*G + R
-    EC_POINT_add(group, PK_one, temp2, B2, ctx);   // r3*G + R + B2
-    
-    // Cleanup
-    BN_free(r2);
-    BN_free(r3);
-    EC_POINT_free(temp1);
-    EC_POINT_free(temp2);
-    EC_POINT_free(a1A2);
-    EC_POINT_free(r2A3);
-    
-    clock_t t2 = clock();
-    sumGen += timer_diff(t1, t2);
+    ec_mul_gen(s->ec, &s->t, &r3);      // r3*G
+    ec_add(s->ec, PK_one, &s->t, R);    // r3*G + R
+    ec_add(s->ec, PK_one, PK_one, B2);  // r3*G + R + B2
 }
 
-int ReceiverStatistics(EC_POINT *PK_one, EC_POINT *R, BIGNUM *r1,
-                       BIGNUM *a2, EC_POINT *A1, EC_POINT *A3, EC_POINT *B2,
-                       BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r2 = BN_new();
-    BIGNUM *r3 = BN_new();
-    EC_POINT *temp1 = EC_POINT_new(group);
-    EC_POINT *temp2 = EC_POINT_new(group);
-    EC_POINT *check_R = EC_POINT_new(group);
-    EC_POINT *check_PK = EC_POINT_new(group);
-    EC_POINT *a2A1 = EC_POINT_new(group);
-    EC_POINT *r2A3 = EC_POINT_new(group);
-    
-    // a2*A1
-    EC_POINT_mul(group, a2A1, NULL, A1, a2, ctx);
-    
-    // r2 = hash1(r1, a2*A1)
-    H1(r2, r1, a2A1, ctx);
-    
-    // r2*A3
-    EC_POINT_mul(group, r2A3, NULL, A3, r2, ctx);
-    
-    // r3 = hash2(r2*A3)
-    H2(r3, r2A3, ctx);
-    
+// The checks of ReceiverStatistics once r2 = hash1(r1, a2*A1) is known;
+// the cheap one, R == r2*G, comes first so that an output that is not
+// ours costs no r2*A3
+static int check_output(const ec_point_t *PK_one, const ec_point_t *R, const ec_scalar_t *r2,
+                        const ec_point_t *A3, const ec_point_t *B2, scratch_t *s) {
+    ec_scalar_t r3;
+
     // Check 1: R == r2 * G
-    EC_POINT_mul(group, check_R, NULL, G, r2, ctx);
-    int ok1 = (EC_POINT_cmp(group, R, check_R, ctx) == 0);
-    
+    if (!ec_mul_gen(s->ec, &s->t, r2) || !ec_eq(s->ec, R, &s->t)) return 0;
+
+    // r3 = hash2(r2*A3)
+    ec_mul(s->ec, &s->t, r2, A3);
+    H2(&r3, &s->t, s);
+
     // Check 2: PK_one == r3*G + R + B2
-    EC_POINT_mul(group, temp1, NULL, G, r3, ctx);  // r3*G
-    EC_POINT_add(group, temp2, temp1, R, ctx);     // r3*G + R
-    EC_POINT_add(group, check_PK, temp2, B2, ctx); // r3*G + R + B2
-    int ok2 = (EC_POINT_cmp(group, PK_one, check_PK, ctx) == 0);
-    
-    // Cleanup
-    BN_free(r2);
-    BN_free(r3);
-    EC_POINT_free(temp1);
-    EC_POINT_free(temp2);
-    EC_POINT_free(check_R);
-    EC_POINT_free(check_PK);
-    EC_POINT_free(a2A1);
-    EC_POINT_free(r2A3);
-    
-    clock_t t2 = clock();
-    sumStat += timer_diff(t1, t2);
-    
-    return ok1 && ok2;
+    return ec_mul_gen(s->ec, &s->t, &r3)      // r3*G
+           && ec_add(s->ec, &s->t, &s->t, R)  // r3*G + R
+           && ec_add(s->ec, &s->t, &s->t, B2) // r3*G + R + B2
+           && ec_eq(s->ec, PK_one, &s->t);
+}
+
+int ReceiverStatistics(const ec_point_t *PK_one, const ec_point_t *R, const ec_scalar_t *r1,
+                       const ec_scalar_t *a2, const ec_point_t *A1, const ec_point_t *A3,
+                       const ec_point_t *B2, scratch_t *s) {
+    ec_scalar_t r2;
+
+    // r2 = hash1(r1, a2*A1)
+    if (!ec_mul(s->ec, &s->t, a2, A1)) return 0;
+    H1(&r2, r1, &s->t, s);
+
+    return check_output(PK_one, R, &r2, A3, B2, s);
+}
+
+// ReceiverStatistics for n outputs (PK_one[i], R[i], r1[i]) from the
+// senders A1[i]; ok[i] receives each result. The points a2*A1[i] come
+// from one ec_mul_many, which leaves them ready to hash. Returns the
+// number of outputs that are ours, or -1 if out of memory.
+int ReceiverStatisticsBatch(int ok[], const ec_point_t PK_one[], const ec_point_t R[],
+                            const ec_scalar_t r1[], const ec_point_t A1[], int n,
+                            const ec_scalar_t *a2, const ec_point_t *A3, const ec_point_t *B2,
+                            scratch_t *s) {
+    ec_scalar_t r2;
+    int found = 0;
+
+    if (n <= 0) return 0;
+    if (!scratch_reserve(s, n)) return -1;
+
+    // a2*A1[i]
+    if (!ec_mul_many(s->ec, s->batch, a2, A1, n)) {
+        memset(ok, 0, n * sizeof(*ok));
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        H1(&r2, &r1[i], &s->batch[i], s);
+        ok[i] = check_output(&PK_one[i], &R[i], &r2, A3, B2, s);
+        found += ok[i];
+    }
+    return found;
 }
 
-void OnetimeSKGen(BIGNUM *sk_ot, BIGNUM *r1, BIGNUM *a2, EC_POINT *A1,
-                  EC_POINT *A3, BIGNUM *b2, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r2 = BN_new();
-    BIGNUM *r3 = BN_new();
-    EC_POINT *a2A1 = EC_POINT_new(group);
-    EC_POINT *r2A3 = EC_POINT_new(group);
-    
-    // a2*A1
-    EC_POINT_mul(group, a2A1, NULL, A1, a2, ctx);
-    
+void OnetimeSKGen(ec_scalar_t *sk_ot, const ec_scalar_t *r1, const ec_scalar_t *a2,
+                  const ec_point_t *A1, const ec_point_t *A3, const ec_scalar_t *b2,
+                  scratch_t *s) {
+    ec_scalar_t r2, r3;
+
     // r2 = hash1(r1, a2*A1)
-    H1(r2, r1, a2A1, ctx);
-    
-    // r2*A3
-    EC_POINT_mul(group, r2A3, NULL, A3, r2, ctx);
-    
+    ec_mul(s->ec, &s->t, a2, A1);
+    H1(&r2, r1, &s->t, s);
+
     // r3 = hash2(r2*A3)
-    H2(r3, r2A3, ctx);
-    
+    ec_mul(s->ec, &s->t, &r2, A3);
+    H2(&r3, &s->t, s);
+
     // sk_ot = r3 + r2 + b2
-    BN_add(sk_ot, r3, r2);
-    BN_mod_add(sk_ot, sk_ot, b2, order, ctx);
-    
-    // Cleanup
-    BN_free(r2);
-    BN_free(r3);
-    EC_POINT_free(a2A1);
-    EC_POINT_free(r2A3);
-    
-    clock_t t2 = clock();
-    sumSK += timer_diff(t1, t2);
+    ec_scalar_add(s->ec, sk_ot, &r3, &r2);
+    ec_scalar_add(s->ec, sk_ot, sk_ot, b2);
 }
 
-void IdentityTracing(EC_POINT *B2_out, EC_POINT *PK_one, EC_POINT *R,
-                     BIGNUM *a3, BN_CTX *ctx) {
-    clock_t t1 = clock();
-    
-    BIGNUM *r3 = BN_new();
-    EC_POINT *temp = EC_POINT_new(group);
-    EC_POINT *r3G = EC_POINT_new(group);
-    EC_POINT *a3R = EC_POINT_new(group);
-    
-    // a3*R
-    EC_POINT_mul(group, a3R, NULL, R, a3, ctx);
-    
+void IdentityTracing(ec_point_t *B2_out, const ec_point_t *PK_one, const ec_point_t *R,
+                     const ec_scalar_t *a3, scratch_t *s) {
+    ec_scalar_t r3;
+
     // r3 = hash2(a3*R)
-    H2(r3, a3R, ctx);
-    
-    // B2 = PK_one - R - r3*G
-    EC_POINT_mul(group, r3G, NULL, G, r3, ctx);    // r3*G
-    
-    // PK_one - R (using inversion: A - B = A + (-B))
-    EC_POINT *neg_R = EC_POINT_new(group);
-    EC_POINT_copy(neg_R, R);
-    EC_POINT_invert(group, neg_R, ctx);
-    EC_POINT_add(group, temp, PK_one, neg_R, ctx); // PK_one - R
-    
-    // temp - r3*G
-    EC_POINT *neg_r3G = EC_POINT_new(group);
-    EC_POINT_copy(neg_r3G, r3G);
-    EC_POINT_invert(group, neg_r3G, ctx);
-    EC_POINT_add(group, B2_out, temp, neg_r3G, ctx); // PK_one - R - r3*G
-    
-    // Cleanup
-    BN_free(r3);
-    EC_POINT_free(temp);
-    EC_POINT_free(r3G);
-    EC_POINT_free(neg_R);
-    EC_POINT_free(neg_r3G);
-    EC_POINT_free(a3R);
-    
-    clock_t t2 = clock();
-    sumTrace += timer_diff(t1, t2);
+    ec_mul(s->ec, &s->t, a3, R);
+    H2(&r3, &s->t, s);
+
+    // B2 = PK_one - (r3*G + R)
+    ec_mul_gen(s->ec, &s->t, &r3);     // r3*G
+    ec_add(s->ec, &s->t, &s->t, R);    // r3*G + R
+    ec_sub(s->ec, B2_out, PK_one, &s->t);
 }
 
 void cleanup() {
-    EC_POINT_free(G);
-    EC_GROUP_free(group);
-    BN_free(order);
+    ec_cleanup();
 }
 
-int main() {
+// Benchmark registration (see bench.h)
+// User 1 is the sender, user 2 the receiver and user 3 the tracer
+static scratch_t *scratch;
+static ec_point_t A1, B1, A2, B2, A3, B3;
+static ec_scalar_t a1, b1, a2, b2, a3, b3;
+static ec_point_t PK_one, R, B2_traced;
+static ec_scalar_t r1, sk_ot;
+// The batch scan sees the fresh output first, then BENCH_BATCH - 1
+// outputs sent to someone else, all from user 1. Slot 0 and batch_A1[]
+// are copies of PK_one, R and A1 and are not cleared themselves.
+static ec_point_t batch_PK[BENCH_BATCH], batch_R[BENCH_BATCH], batch_A1[BENCH_BATCH];
+static ec_scalar_t batch_r1[BENCH_BATCH];
+
+static int bench_setup(const char *param_file) {
+    (void)param_file;
     Setup();
-    
-    BN_CTX *ctx = BN_CTX_new();
-    
-    // Initialize keys for three users
-    EC_POINT *A1 = EC_POINT_new(group);
-    EC_POINT *B1 = EC_POINT_new(group);
-    EC_POINT *A2 = EC_POINT_new(group);
-    EC_POINT *B2 = EC_POINT_new(group);
-    EC_POINT *A3 = EC_POINT_new(group);
-    EC_POINT *B3 = EC_POINT_new(group);
-    
-    BIGNUM *a1 = BN_new();
-    BIGNUM *b1 = BN_new();
-    BIGNUM *a2 = BN_new();
-    BIGNUM *b2 = BN_new();
-    BIGNUM *a3 = BN_new();
-    BIGNUM *b3 = BN_new();
-    
-    // Generate keys
-    KeyGen(A1, B1, a1, b1, ctx);
-    KeyGen(A2, B2, a2, b2, ctx);
-    KeyGen(A3, B3, a3, b3, ctx);
-    
-    printf("Running %d iterations...\n", LOOP);
-    
-    for (int i = 0; i < LOOP; i++) {
-        EC_POINT *PK_one = EC_POINT_new(group);
-        EC_POINT *R = EC_POINT_new(group);
-        EC_POINT *B2_traced = EC_POINT_new(group);
-        BIGNUM *r1 = BN_new();
-        BIGNUM *sk_ot = BN_new();
-        
-        // Generate random r1
-        BN_rand_range(r1, order);
-        
-        // Run algorithms
-        OnetimeAddrGen(PK_one, R, r1, a1, A2, A3, B2, ctx);
-        int result = ReceiverStatistics(PK_one, R, r1, a2, A1, A3, B2, ctx);
-        OnetimeSKGen(sk_ot, r1, a2, A1, A3, b2, ctx);
-        IdentityTracing(B2_traced, PK_one, R, a3, ctx);
-        
-        // Verify correctness
-        if (EC_POINT_cmp(group, B2_traced, B2, ctx) != 0) {
-            printf("FAIL: Identity tracing failed at round %d\n", i);
-        }
-        if (!result) {
-            printf("FAIL: Receiver statistics failed at round %d\n", i);
-        }
-        
-        // Cleanup round
-        EC_POINT_free(PK_one);
-        EC_POINT_free(R);
-        EC_POINT_free(B2_traced);
-        BN_free(r1);
-        BN_free(sk_ot);
+    scratch = ScratchNew();
+
+    ec_point_init(&A1); ec_point_init(&B1);
+    ec_point_init(&A2); ec_point_init(&B2);
+    ec_point_init(&A3); ec_point_init(&B3);
+    ec_point_init(&PK_one);
+    ec_point_init(&R);
+    ec_point_init(&B2_traced);
+    KeyGen(&A1, &B1, &a1, &b1, scratch);
+    KeyGen(&A3, &B3, &a3, &b3, scratch);
+
+    // Outputs from user 1 to a receiver other than user 2
+    KeyGen(&A2, &B2, &a2, &b2, scratch);
+    for (int i = 0; i < BENCH_BATCH; i++) {
+        batch_A1[i] = A1;
+        if (i == 0) continue;
+        ec_point_init(&batch_PK[i]);
+        ec_point_init(&batch_R[i]);
+        ec_scalar_random(scratch->ec, &batch_r1[i]);
+        OnetimeAddrGen(&batch_PK[i], &batch_R[i], &batch_r1[i], &a1, &A2, &A3, &B2, scratch);
+    }
+    return 1;
+}
+
+static void bench_teardown(void) {
+    for (int i = 1; i < BENCH_BATCH; i++) {
+        ec_point_clear(&batch_PK[i]);
+        ec_point_clear(&batch_R[i]);
     }
-    
-    // Print timing results
-    printf("\n=== Performance Results ===\n");
-    printf("Avg AddrGen Time     : %.3f ms\n", sumGen / LOOP);
-    printf("Avg ReceiverStat Time: %.3f ms\n", sumStat / LOOP);
-    printf("Avg OnetimeSKGen Time: %.3f ms\n", sumSK / LOOP);
-    printf("Avg IdentityTrace Time: %.3f ms\n", sumTrace / LOOP);
-    printf("Avg H1 Time: %.3f ms\n", sumH1 / (3*LOOP));
-    printf("Avg H2 Time: %.3f ms\n", sumH2 / (4*LOOP));
-    
-    // Cleanup
-    EC_POINT_free(A1); EC_POINT_free(B1);
-    EC_POINT_free(A2); EC_POINT_free(B2);
-    EC_POINT_free(A3); EC_POINT_free(B3);
-    BN_free(a1); BN_free(b1);
-    BN_free(a2); BN_free(b2);
-    BN_free(a3); BN_free(b3);
-    BN_CTX_free(ctx);
+    ec_point_clear(&A1); ec_point_clear(&B1);
+    ec_point_clear(&A2); ec_point_clear(&B2);
+    ec_point_clear(&A3); ec_point_clear(&B3);
+    ec_point_clear(&PK_one);
+    ec_point_clear(&R);
+    ec_point_clear(&B2_traced);
+    ScratchFree(scratch);
     cleanup();
-    
-    return 0;
-}
\ No newline at end of file
+}
+
+static int bench_keygen(void) {
+    KeyGen(&A2, &B2, &a2, &b2, scratch);
+    return 1;
+}
+
+static int bench_addr_gen(void) {
+    ec_scalar_random(scratch->ec, &r1);
+    OnetimeAddrGen(&PK_one, &R, &r1, &a1, &A2, &A3, &B2, scratch);
+    batch_PK[0] = PK_one;
+    batch_R[0] = R;
+    batch_r1[0] = r1;
+    return 1;
+}
+
+static int bench_recognize(void) {
+    return ReceiverStatistics(&PK_one, &R, &r1, &a2, &A1, &A3, &B2, scratch);
+}
+
+static int bench_recognize_batch(void) {
+    int ok[BENCH_BATCH];
+    return ReceiverStatisticsBatch(ok, batch_PK, batch_R, batch_r1, batch_A1, BENCH_BATCH,
+                                   &a2, &A3, &B2, scratch) == 1 && ok[0];
+}
+
+static int bench_skgen(void) {
+    OnetimeSKGen(&sk_ot, &r1, &a2, &A1, &A3, &b2, scratch);
+    return 1;
+}
+
+static int bench_trace(void) {
+    IdentityTracing(&B2_traced, &PK_one, &R, &a3, scratch);
+    return ec_eq(scratch->ec, &B2_traced, &B2);
+}
+
+static void bench_sizes(bench_sizes_t *sz) {
+    unsigned char buf[EC_POINT_MAX_BYTES];
+    sz->g1 = sz->g1_compressed = ec_point_bytes(scratch->ec, buf, &A1);
+    sz->zr = EC_SCALAR_BYTES;
+    sz->r_bits = ec_order_bits();
+}
+
+const bench_scheme_t bench_scheme = {
+    .name = "zhao",
+    .builtin_param = ec_group_name,
+    .setup = bench_setup,
+    .teardown = bench_teardown,
+    .sizes = bench_sizes,
+    .seed = ec_seed,
+    .op = {
+        [BENCH_KEYGEN] = bench_keygen,
+        [BENCH_ADDR_GEN] = bench_addr_gen,
+        [BENCH_RECOGNIZE] = bench_recognize,
+        [BENCH_RECOGNIZE_BATCH] = bench_recognize_batch,
+        [BENCH_SKGEN] = bench_skgen,
+        [BENCH_TRACE] = bench_trace,
+    },
+};
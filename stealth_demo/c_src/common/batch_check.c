@@ -0,0 +1,73 @@
+/****************************************************************************
+ * File: batch_check.c
+ * Desc: Randomized batch checks of exponent equations, see batch_check.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "batch_check.h"
+#include "perf_prim.h"
+
+typedef struct {
+    element_t* lhs;
+    element_ptr base;
+    element_t* e;
+    mpz_t* d;                    // NULL if out of memory: every equation on its own
+    element_t sum, term;         // Zr
+    element_t left, right;       // the group of base
+    unsigned char* results;
+} batch_check_t;
+
+static int check_one(batch_check_t* b, int i) {
+    prim_pow_zn(b->right, b->base, b->e[i]);
+    int ok = element_cmp(b->lhs[i], b->right) == 0;
+    if (!ok) b->results[i] = 0;
+    return ok;
+}
+
+// Fresh scalars on every level, so a bisected half is not checked with
+// the ones that its false equations were just combined with
+static int check_range(batch_check_t* b, int lo, int hi) {
+    int m = hi - lo;
+    if (m == 1 || !b->d) {
+        int holds = 0;
+        for (int i = lo; i < hi; i++) holds += check_one(b, i);
+        return holds;
+    }
+
+    element_set0(b->sum);
+    for (int i = lo; i < hi; i++) {
+        pbc_mpz_randomb(b->d[i], BATCH_CHECK_BITS);
+        element_mul_mpz(b->term, b->e[i], b->d[i]);
+        element_add(b->sum, b->sum, b->term);
+    }
+    prim_multi_pow_mpz(b->left, b->lhs + lo, b->d + lo, m);
+    prim_pow_zn(b->right, b->base, b->sum);
+    if (element_cmp(b->left, b->right) == 0) return m;
+
+    int mid = lo + m / 2;
+    return check_range(b, lo, mid) + check_range(b, mid, hi);
+}
+
+int batch_check_pow(element_t lhs[], element_t base, element_t e[], int n,
+                    unsigned char* results) {
+    if (n <= 0) return 0;
+    batch_check_t b = { .lhs = lhs, .base = base, .e = e, .results = results };
+    b.d = malloc((size_t)n * sizeof(mpz_t));
+    if (b.d) for (int i = 0; i < n; i++) mpz_init(b.d[i]);
+    element_init_same_as(b.sum, e[0]);
+    element_init_same_as(b.term, e[0]);
+    element_init_same_as(b.left, base);
+    element_init_same_as(b.right, base);
+
+    int holds = check_range(&b, 0, n);
+
+    element_clear(b.sum);
+    element_clear(b.term);
+    element_clear(b.left);
+    element_clear(b.right);
+    if (b.d) {
+        for (int i = 0; i < n; i++) mpz_clear(b.d[i]);
+        free(b.d);
+    }
+    return holds;
+}
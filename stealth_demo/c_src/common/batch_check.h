@@ -0,0 +1,31 @@
+/****************************************************************************
+ * File: batch_check.h
+ * Desc: Randomized batch checks of exponent equations for the scheme cores
+ *       Checks lhs_i == base^e_i for many i at once: with random small
+ *       scalars d_i, prod lhs_i^d_i == base^(sum d_i*e_i) is one
+ *       multi-exponentiation by short exponents plus one power, instead
+ *       of a full power per equation. A false equation passes with
+ *       probability about 2^-BATCH_CHECK_BITS, provided every lhs_i lies
+ *       in the prime-order group (see the subgroup validation of the
+ *       cores). A failing batch is bisected down to the false equations.
+ ****************************************************************************/
+
+#ifndef BATCH_CHECK_H
+#define BATCH_CHECK_H
+
+#include <pbc/pbc.h>
+
+// Bits of the random scalars
+#define BATCH_CHECK_BITS 64
+
+/**
+ * Check lhs[i] == base^e[i] for every i in [0, n), clearing results[i]
+ * where it does not hold and leaving the other bytes as they are. The
+ * scalars are drawn from the PBC random source.
+ * @param e Exponents, elements of Zr
+ * @return Number of equations that hold
+ */
+int batch_check_pow(element_t lhs[], element_t base, element_t e[], int n,
+                    unsigned char* results);
+
+#endif /* BATCH_CHECK_H */
@@ -0,0 +1,246 @@
+/****************************************************************************
+ * File: completion_queue.c
+ * Desc: Non-blocking submission of operations to a thread pool, see
+ *       completion_queue.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "completion_queue.h"
+#include "seeded_random.h"
+#include "cpu_topo.h"
+
+typedef struct cq_job_s {
+    long ticket;
+    cq_work_fn work;
+    void* arg;
+    cq_done_fn done;
+    void* user;
+    int result;
+    struct cq_job_s* next;
+} cq_job_t;
+
+typedef struct {
+    pthread_t tid;
+    completion_queue_t* q;
+    seeded_random_job_t random;
+} cq_thread_t;
+
+struct completion_queue_s {
+    pthread_mutex_t lock;        // guards everything below but the threads
+    pthread_cond_t work_cv;      // a job was submitted, or stop
+    pthread_cond_t done_cv;      // a completion was queued
+    cq_job_t *head, *tail;       // submitted, not started
+    cq_job_t *done_head, *done_tail;  // finished, not reaped
+    int pending;                 // submitted and not reaped
+    int capacity;
+    long next_ticket;
+    int stop;
+    int efd;
+    int num_threads;
+    cq_thread_t* threads;
+};
+
+// Both with the lock held: the eventfd is set exactly while done_head is not NULL
+static void efd_set(completion_queue_t* q) {
+    uint64_t one = 1;
+    ssize_t rc = write(q->efd, &one, sizeof(one));
+    (void)rc;
+}
+
+static void efd_reset(completion_queue_t* q) {
+    uint64_t count;
+    ssize_t rc = read(q->efd, &count, sizeof(count));
+    (void)rc;
+}
+
+static void* cq_thread(void* arg) {
+    cq_thread_t* t = (cq_thread_t*)arg;
+    completion_queue_t* q = t->q;
+
+    seeded_random_bind_t rnd;
+    int bound = seeded_random_bind(&rnd, &t->random) == 0;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        cq_job_t* job = q->head;
+        if (!job) {
+            if (q->stop) break;
+            pthread_cond_wait(&q->work_cv, &q->lock);
+            continue;
+        }
+        q->head = job->next;
+        if (!q->head) q->tail = NULL;
+        pthread_mutex_unlock(&q->lock);
+
+        job->result = job->work(job->arg);
+        if (job->done) job->done(job->ticket, job->result, job->user);
+
+        pthread_mutex_lock(&q->lock);
+        if (job->done) {
+            q->pending--;
+            free(job);
+            continue;
+        }
+        job->next = NULL;
+        if (q->done_tail) q->done_tail->next = job;
+        else {
+            q->done_head = job;
+            efd_set(q);
+        }
+        q->done_tail = job;
+        pthread_cond_broadcast(&q->done_cv);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    if (bound) seeded_random_unbind(&rnd);
+    return NULL;
+}
+
+completion_queue_t* cq_new(int num_threads, int capacity) {
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    completion_queue_t* q = calloc(1, sizeof(completion_queue_t));
+    if (!q) return NULL;
+    q->threads = calloc(num_threads, sizeof(cq_thread_t));
+    q->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!q->threads || q->efd < 0) {
+        if (q->efd >= 0) close(q->efd);
+        free(q->threads);
+        free(q);
+        return NULL;
+    }
+    q->capacity = capacity > 0 ? capacity : 1024;
+    q->next_ticket = 1;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->work_cv, NULL);
+    pthread_cond_init(&q->done_cv, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        cq_thread_t* t = &q->threads[i];
+        t->q = q;
+        seeded_random_job(&t->random);
+        if (cpu_topo_create(&t->tid, i, num_threads, cq_thread, t) != 0) break;
+        q->num_threads++;
+    }
+    if (q->num_threads == 0) {
+        cq_free(q);
+        return NULL;
+    }
+    return q;
+}
+
+void cq_free(completion_queue_t* q) {
+    if (!q) return;
+
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_broadcast(&q->work_cv);
+    pthread_mutex_unlock(&q->lock);
+    for (int i = 0; i < q->num_threads; i++) pthread_join(q->threads[i].tid, NULL);
+
+    while (q->done_head) {
+        cq_job_t* job = q->done_head;
+        q->done_head = job->next;
+        free(job);
+    }
+    close(q->efd);
+    pthread_cond_destroy(&q->done_cv);
+    pthread_cond_destroy(&q->work_cv);
+    pthread_mutex_destroy(&q->lock);
+    free(q->threads);
+    free(q);
+}
+
+int cq_fd(const completion_queue_t* q) {
+    return q ? q->efd : -1;
+}
+
+long cq_submit(completion_queue_t* q, cq_work_fn work, void* arg, cq_done_fn done, void* user) {
+    if (!q || !work) return -1;
+    cq_job_t* job = malloc(sizeof(cq_job_t));
+    if (!job) return -1;
+    job->work = work;
+    job->arg = arg;
+    job->done = done;
+    job->user = user;
+    job->next = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->stop || q->pending >= q->capacity) {
+        pthread_mutex_unlock(&q->lock);
+        free(job);
+        return -1;
+    }
+    long ticket = job->ticket = q->next_ticket++;
+    if (q->tail) q->tail->next = job;
+    else q->head = job;
+    q->tail = job;
+    q->pending++;
+    pthread_cond_signal(&q->work_cv);
+    pthread_mutex_unlock(&q->lock);
+    return ticket;                // job may be run and freed by now
+}
+
+// With the lock held
+static int take(completion_queue_t* q, long* tickets, int* results, int max) {
+    int n = 0;
+    if (!q->done_head) return 0;
+    efd_reset(q);
+    while (n < max && q->done_head) {
+        cq_job_t* job = q->done_head;
+        q->done_head = job->next;
+        tickets[n] = job->ticket;
+        results[n] = job->result;
+        n++;
+        q->pending--;
+        free(job);
+    }
+    if (q->done_head) efd_set(q);
+    else q->done_tail = NULL;
+    return n;
+}
+
+int cq_poll(completion_queue_t* q, long* tickets, int* results, int max) {
+    if (!q || !tickets || !results || max <= 0) return 0;
+    pthread_mutex_lock(&q->lock);
+    int n = take(q, tickets, results, max);
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+int cq_wait(completion_queue_t* q, long* tickets, int* results, int max, int timeout_ms) {
+    if (!q || !tickets || !results || max <= 0) return 0;
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    pthread_mutex_lock(&q->lock);
+    while (!q->done_head) {
+        if (timeout_ms < 0) pthread_cond_wait(&q->done_cv, &q->lock);
+        else if (pthread_cond_timedwait(&q->done_cv, &q->lock, &deadline) == ETIMEDOUT) break;
+    }
+    int n = take(q, tickets, results, max);
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+int cq_pending(completion_queue_t* q) {
+    if (!q) return 0;
+    pthread_mutex_lock(&q->lock);
+    int n = q->pending;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+ * File: completion_queue.h
+ * Desc: Non-blocking submission of operations to a thread pool
+ *       A caller submits a job and gets a ticket back at once; pool
+ *       threads run the jobs and post their results to a completion queue
+ *       behind an eventfd, which an event loop (epoll, asyncio, Go / Rust
+ *       runtimes) watches alongside its sockets, then reaps without
+ *       blocking. A job can instead name a callback, run on the pool
+ *       thread when it finishes.
+ ****************************************************************************/
+
+#ifndef COMPLETION_QUEUE_H
+#define COMPLETION_QUEUE_H
+
+#include <pthread.h>
+
+typedef struct completion_queue_s completion_queue_t;
+
+/**
+ * The work of one job, on a pool thread; owns arg and releases it
+ * @return Result reported with the ticket
+ */
+typedef int (*cq_work_fn)(void* arg);
+
+/**
+ * Completion callback, on the pool thread that ran the job
+ */
+typedef void (*cq_done_fn)(long ticket, int result, void* user);
+
+/**
+ * Start a queue and its pool. Every pool thread draws from its own random
+ * source, seeded from the caller's in seeded random mode (seeded_random.h),
+ * and is pinned while pinning is on (cpu_topo.h).
+ * @param num_threads Pool threads, <= 0 for one per online CPU
+ * @param capacity Most jobs submitted and not yet reaped, <= 0 for 1024
+ * @return New queue, NULL if out of memory or no eventfd or thread
+ */
+completion_queue_t* cq_new(int num_threads, int capacity);
+
+/**
+ * Run every job already submitted, stop the pool and release the queue;
+ * completions not reaped are dropped. No submit may race with it.
+ */
+void cq_free(completion_queue_t* q);
+
+/**
+ * eventfd that is readable while completions wait to be reaped; owned by
+ * the queue, only to be watched (cq_poll resets it)
+ */
+int cq_fd(const completion_queue_t* q);
+
+/**
+ * Queue work(arg) without waiting. Buffers the job reads or writes must
+ * stay valid until it completes.
+ * @param done Callback instead of a queued completion, NULL to queue it
+ * @param user Passed to done
+ * @return Ticket (> 0), -1 if the queue is full or stopping (work is not
+ *         called then, so arg is still the caller's)
+ */
+long cq_submit(completion_queue_t* q, cq_work_fn work, void* arg, cq_done_fn done, void* user);
+
+/**
+ * Take up to max completions in the order the jobs finished, without waiting
+ * @param tickets Tickets of the finished jobs (output)
+ * @param results What their work returned (output)
+ * @return Number taken
+ */
+int cq_poll(completion_queue_t* q, long* tickets, int* results, int max);
+
+/**
+ * cq_poll that waits up to timeout_ms (< 0 without limit) for a first
+ * completion, for callers without an event loop
+ * @return Number taken, 0 on timeout
+ */
+int cq_wait(completion_queue_t* q, long* tickets, int* results, int max, int timeout_ms);
+
+/**
+ * Jobs submitted and not yet reaped (or called back)
+ */
+int cq_pending(completion_queue_t* q);
+
+#endif /* COMPLETION_QUEUE_H */
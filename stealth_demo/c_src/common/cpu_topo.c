@@ -0,0 +1,128 @@
+/****************************************************************************
+ * File: cpu_topo.c
+ * Desc: CPU and NUMA node layout for the worker pools, see cpu_topo.h
+ ****************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sched.h>
+#include "cpu_topo.h"
+
+static pthread_once_t topo_once = PTHREAD_ONCE_INIT;
+static int topo_nodes = 1;
+static int topo_len;                         // usable CPUs, 0 if unknown
+static int topo_order[CPU_SETSIZE];          // usable CPUs, node by node
+static unsigned char topo_node_of[CPU_SETSIZE];
+static volatile int topo_pin;
+
+// Mark the CPUs of a sysfs cpulist ("0-3,8,10-11") in set
+static void read_cpulist(const char* path, cpu_set_t* set) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return;
+    int lo, hi;
+    char sep;
+    while (fscanf(fp, "%d", &lo) == 1) {
+        hi = lo;
+        if (fscanf(fp, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(fp, "%d", &hi) != 1) break;
+            if (fscanf(fp, "%c", &sep) != 1) sep = '\n';
+        }
+        for (int c = lo; c <= hi && c < CPU_SETSIZE; c++)
+            if (c >= 0) CPU_SET(c, set);
+        if (sep != ',') break;
+    }
+    fclose(fp);
+}
+
+static void topo_load(void) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    // sysfs node id of every usable CPU, -1 where no node lists it
+    static int node_id[CPU_SETSIZE];
+    for (int c = 0; c < CPU_SETSIZE; c++) node_id[c] = -1;
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (dir) {
+        struct dirent* de;
+        while ((de = readdir(dir))) {
+            int id;
+            char path[96];
+            if (sscanf(de->d_name, "node%d", &id) != 1 || id < 0) continue;
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+            read_cpulist(path, &cpus);
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &cpus) && CPU_ISSET(c, &allowed)) node_id[c] = id;
+        }
+        closedir(dir);
+    }
+
+    // Nodes are numbered by ascending sysfs id, skipping nodes without
+    // usable CPUs; past the cap they share the last number
+    int k = -1, prev = -1;
+    for (;;) {
+        int next = INT_MAX;
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (node_id[c] > prev && node_id[c] < next) next = node_id[c];
+        if (next == INT_MAX) break;
+        if (k < CPU_TOPO_MAX_NODES - 1) k++;
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (node_id[c] == next) {
+                topo_node_of[c] = (unsigned char)k;
+                topo_order[topo_len++] = c;
+            }
+        prev = next;
+    }
+    topo_nodes = k < 0 ? 1 : k + 1;
+    // CPUs no node lists (all of them without sysfs) count as node 0
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &allowed) && node_id[c] < 0) topo_order[topo_len++] = c;
+}
+
+int cpu_topo_nodes(void) {
+    pthread_once(&topo_once, topo_load);
+    return topo_nodes;
+}
+
+int cpu_topo_current_node(void) {
+    pthread_once(&topo_once, topo_load);
+    if (topo_nodes == 1) return 0;
+    int cpu = sched_getcpu();
+    return cpu >= 0 && cpu < CPU_SETSIZE ? topo_node_of[cpu] : 0;
+}
+
+int cpu_topo_worker_cpu(int i, int n) {
+    pthread_once(&topo_once, topo_load);
+    if (topo_len == 0 || n <= 0 || i < 0) return -1;
+    // Thread i of n takes CPU i * len / n: evenly spread, in node order,
+    // several threads to a CPU when n exceeds the CPUs
+    return topo_order[(long)(i % n) * topo_len / n];
+}
+
+void cpu_topo_set_pinning(int enabled) {
+    topo_pin = enabled != 0;
+}
+
+int cpu_topo_pinning(void) {
+    return topo_pin;
+}
+
+int cpu_topo_create(pthread_t* tid, int i, int n, void* (*fn)(void*), void* arg) {
+    int cpu = topo_pin ? cpu_topo_worker_cpu(i, n) : -1;
+    if (cpu < 0) return pthread_create(tid, NULL, fn, arg);
+
+    pthread_attr_t attr;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_attr_init(&attr);
+    pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    int rc = pthread_create(tid, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+ * File: cpu_topo.h
+ * Desc: CPU and NUMA node layout for the worker pools
+ *       Reads the nodes from sysfs, orders the CPUs the process may run on
+ *       node by node, and optionally pins pool threads to them, so that a
+ *       pool of n threads fills the nodes evenly and neighbouring threads
+ *       (which get neighbouring input ranges) share a node. Memory a pinned
+ *       thread touches first is then placed on its own node by the kernel.
+ ****************************************************************************/
+
+#ifndef CPU_TOPO_H
+#define CPU_TOPO_H
+
+#include <pthread.h>
+
+// Nodes told apart; CPUs of higher nodes count as the last one
+#define CPU_TOPO_MAX_NODES 8
+
+/**
+ * Number of NUMA nodes with usable CPUs, 1 without sysfs
+ */
+int cpu_topo_nodes(void);
+
+/**
+ * Node the calling thread runs on right now, 0 if unknown
+ */
+int cpu_topo_current_node(void);
+
+/**
+ * CPU for thread i of a pool of n: CPUs in node order, spread evenly
+ * @return CPU number, -1 if the layout is unknown
+ */
+int cpu_topo_worker_cpu(int i, int n);
+
+/**
+ * Pin the pool threads started through cpu_topo_create, off by default
+ * @param enabled 1 to pin, 0 to let the scheduler place them
+ */
+void cpu_topo_set_pinning(int enabled);
+
+int cpu_topo_pinning(void);
+
+/**
+ * pthread_create for thread i of a pool of n; while pinning is on the
+ * thread starts bound to cpu_topo_worker_cpu(i, n)
+ * @return As pthread_create
+ */
+int cpu_topo_create(pthread_t* tid, int i, int n, void* (*fn)(void*), void* arg);
+
+#endif /* CPU_TOPO_H */
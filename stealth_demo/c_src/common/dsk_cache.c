@@ -0,0 +1,230 @@
+/****************************************************************************
+ * File: dsk_cache.c
+ * Desc: Bounded cache of one-time secret keys, see dsk_cache.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dsk_cache.h"
+#include "perf_prim.h"
+#include "perf_timer.h"
+
+// Not optimized away, unlike a memset of memory about to be freed
+static void wipe_bytes(unsigned char* p, size_t n) {
+    volatile unsigned char* v = p;
+    while (n--) *v++ = 0;
+}
+
+// Keys hold secrets: compared without an early exit
+static int key_equal(const unsigned char* a, const unsigned char* b, int n) {
+    unsigned char diff = 0;
+    for (int i = 0; i < n; i++) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+static void entry_wipe(dsk_cache_t* c, dsk_cache_entry_t* e) {
+    if (!e->key) return;
+    if (e->table) {
+        element_pp_wipe(e->pp);
+        element_pp_clear(e->pp);
+        e->table = 0;
+    }
+    element_wipe(e->dsk);
+    wipe_bytes(e->key, c->key_len);
+    e->key = NULL;
+}
+
+static void drop_entries(dsk_cache_t* c) {
+    for (int i = 0; i < c->capacity; i++) {
+        entry_wipe(c, &c->entries[i]);
+        element_clear(c->entries[i].dsk);
+    }
+    free(c->entries);
+    free(c->keys);
+    c->entries = NULL;
+    c->keys = NULL;
+    c->capacity = 0;
+}
+
+static int alloc_entries(dsk_cache_t* c, int capacity) {
+    if (capacity <= 0 || c->key_len > DSK_CACHE_MAX_KEY) return 0;
+    c->entries = calloc(capacity, sizeof(dsk_cache_entry_t));
+    c->keys = malloc((size_t)capacity * c->key_len);
+    if (!c->entries || !c->keys) {
+        free(c->entries);
+        free(c->keys);
+        c->entries = NULL;
+        c->keys = NULL;
+        return -1;
+    }
+    for (int i = 0; i < capacity; i++) element_init(c->entries[i].dsk, c->field);
+    c->capacity = capacity;
+    return 0;
+}
+
+int dsk_cache_init(dsk_cache_t* c, field_ptr field, int key_len, int capacity,
+                   double ttl_ms, int teeth) {
+    pthread_mutex_init(&c->lock, NULL);
+    c->field = field;
+    c->capacity = 0;
+    c->key_len = key_len;
+    c->teeth = teeth;
+    c->ttl_ms = ttl_ms;
+    c->entries = NULL;
+    c->keys = NULL;
+    c->clock = 0;
+    c->hits = c->misses = c->evictions = 0;
+    return alloc_entries(c, capacity);
+}
+
+void dsk_cache_clear(dsk_cache_t* c) {
+    drop_entries(c);
+    pthread_mutex_destroy(&c->lock);
+    c->field = NULL;
+}
+
+int dsk_cache_configure(dsk_cache_t* c, int capacity, double ttl_ms) {
+    pthread_mutex_lock(&c->lock);
+    drop_entries(c);
+    c->ttl_ms = ttl_ms;
+    c->hits = c->misses = c->evictions = 0;
+    int rc = alloc_entries(c, capacity);
+    pthread_mutex_unlock(&c->lock);
+    return rc;
+}
+
+void dsk_cache_flush(dsk_cache_t* c) {
+    pthread_mutex_lock(&c->lock);
+    for (int i = 0; i < c->capacity; i++) entry_wipe(c, &c->entries[i]);
+    pthread_mutex_unlock(&c->lock);
+}
+
+int dsk_cache_get(dsk_cache_t* c, long id, const unsigned char* key, dsk_cache_lease_t* l) {
+    l->entry = NULL;
+    l->table = 0;
+    if (c->capacity == 0) return 0;
+    double now = perf_now_ms();
+
+    pthread_mutex_lock(&c->lock);
+    dsk_cache_entry_t* e = NULL;
+    for (int i = 0; i < c->capacity && !e; i++) {
+        dsk_cache_entry_t* x = &c->entries[i];
+        if (!x->key || x->id != id || !key_equal(x->key, key, c->key_len)) continue;
+        if (now <= x->expires_ms) {
+            e = x;
+        } else if (x->refs == 0) {
+            entry_wipe(c, x);
+            c->evictions++;
+        }
+    }
+    if (!e) {
+        c->misses++;
+        pthread_mutex_unlock(&c->lock);
+        return 0;
+    }
+    c->hits++;
+    e->refs++;
+    e->uses++;
+    e->last_used = ++c->clock;
+    int build = c->teeth > 0 && !e->table && !e->building && e->uses >= DSK_CACHE_TABLE_USES;
+    if (build) e->building = 1;
+    l->entry = e;
+    l->table = e->table;
+    pthread_mutex_unlock(&c->lock);
+
+    // Built outside the lock; the lease keeps the entry in place meanwhile
+    if (build) {
+        element_pp_t pp;
+        element_pp_init_ex(pp, e->dsk, c->teeth, PBC_PP_COMB2);
+        pthread_mutex_lock(&c->lock);
+        *e->pp = *pp;
+        e->table = 1;
+        e->building = 0;
+        pthread_mutex_unlock(&c->lock);
+        l->table = 1;
+    }
+    return 1;
+}
+
+void dsk_cache_pow_zn(element_t out, element_t n, const dsk_cache_lease_t* l) {
+    if (l->table) prim_pp_pow_zn(out, n, l->entry->pp);
+    else prim_pow_zn(out, l->entry->dsk, n);
+}
+
+void dsk_cache_copy(element_t out, const dsk_cache_lease_t* l) {
+    element_set(out, l->entry->dsk);
+}
+
+void dsk_cache_put(dsk_cache_t* c, dsk_cache_lease_t* l) {
+    if (!l->entry) return;
+    pthread_mutex_lock(&c->lock);
+    l->entry->refs--;
+    pthread_mutex_unlock(&c->lock);
+    l->entry = NULL;
+}
+
+void dsk_cache_insert(dsk_cache_t* c, long id, const unsigned char* key, element_t dsk) {
+    if (c->capacity == 0) return;
+    double now = perf_now_ms();
+
+    pthread_mutex_lock(&c->lock);
+    // The entry of id, else a free one, an expired one, the least recently used
+    dsk_cache_entry_t *same = NULL, *free_e = NULL, *expired = NULL, *lru = NULL;
+    for (int i = 0; i < c->capacity; i++) {
+        dsk_cache_entry_t* e = &c->entries[i];
+        if (!e->key) {
+            if (!free_e) free_e = e;
+            continue;
+        }
+        if (e->id == id) {
+            // Another thread cached it meanwhile
+            if (e->refs > 0 && key_equal(e->key, key, c->key_len)) {
+                pthread_mutex_unlock(&c->lock);
+                return;
+            }
+            if (e->refs == 0) same = e;
+            continue;
+        }
+        if (e->refs > 0) continue;
+        if (now > e->expires_ms) {
+            if (!expired) expired = e;
+        } else if (!lru || e->last_used < lru->last_used) {
+            lru = e;
+        }
+    }
+    dsk_cache_entry_t* victim = same ? same : free_e ? free_e : expired ? expired : lru;
+    if (!victim) {
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+    if (victim->key) {
+        entry_wipe(c, victim);
+        if (victim != same) c->evictions++;
+    }
+    victim->key = &c->keys[(victim - c->entries) * (size_t)c->key_len];
+    memcpy(victim->key, key, c->key_len);
+    victim->id = id;
+    element_set(victim->dsk, dsk);
+    victim->table = 0;
+    victim->building = 0;
+    victim->uses = 1;
+    victim->expires_ms = now + c->ttl_ms;
+    victim->last_used = ++c->clock;
+    victim->refs = 0;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void dsk_cache_stats(dsk_cache_t* c, unsigned long* hits, unsigned long* misses,
+                     unsigned long* evictions) {
+    pthread_mutex_lock(&c->lock);
+    if (hits) *hits = c->hits;
+    if (misses) *misses = c->misses;
+    if (evictions) *evictions = c->evictions;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void dsk_cache_reset_stats(dsk_cache_t* c) {
+    pthread_mutex_lock(&c->lock);
+    c->hits = c->misses = c->evictions = 0;
+    pthread_mutex_unlock(&c->lock);
+}
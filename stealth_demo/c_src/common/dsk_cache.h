@@ -0,0 +1,124 @@
+/****************************************************************************
+ * File: dsk_cache.h
+ * Desc: Bounded cache of one-time secret keys for the scheme cores
+ *       Keeps the DSK of addresses that sign repeatedly, under the
+ *       caller's id for the address and checked against key bytes that
+ *       tie it to the address and its key pair. From its second use an
+ *       entry also holds a fixed-base comb table of its DSK, so the power
+ *       of each further signature is a table lookup. Entries live at most
+ *       a fixed time from their insertion; an entry that expires, is
+ *       evicted or is dropped has its DSK, table and key bytes zeroed.
+ ****************************************************************************/
+
+#ifndef DSK_CACHE_H
+#define DSK_CACHE_H
+
+#include <pthread.h>
+#include <pbc/pbc.h>
+
+// Longest key; larger keys are signed for without the cache
+#define DSK_CACHE_MAX_KEY 512
+
+// Uses of an entry, its insertion included, at which its table is built
+#define DSK_CACHE_TABLE_USES 2
+
+typedef struct {
+    unsigned char* key;          // NULL while the entry is free
+    long id;
+    element_t dsk;
+    element_pp_t pp;
+    int table;                   // pp is built
+    int building;                // a thread builds pp outside the lock
+    unsigned long uses;
+    double expires_ms;           // perf_now_ms time past which it is not handed out
+    unsigned long last_used;
+    int refs;                    // leases running on dsk and pp, evicted only at 0
+} dsk_cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;        // guards everything below
+    field_ptr field;             // of the DSKs
+    int capacity;                // 0 disables the cache
+    int key_len;
+    int teeth;                   // of the PBC_PP_COMB2 tables, 0 for none
+    double ttl_ms;
+    dsk_cache_entry_t* entries;
+    unsigned char* keys;         // capacity * key_len, entry i at keys[i * key_len]
+    unsigned long clock;
+    unsigned long hits, misses, evictions;
+} dsk_cache_t;
+
+// An entry held by one signature, from dsk_cache_get to dsk_cache_put
+typedef struct {
+    dsk_cache_entry_t* entry;
+    int table;                   // entry->pp may be used
+} dsk_cache_lease_t;
+
+/**
+ * Bind an empty cache to the field of the DSKs
+ * @param key_len Bytes of every key
+ * @param capacity Most DSKs kept; 0 signs every time from a fresh DSK
+ * @param ttl_ms Lifetime of an entry from its insertion, in ms
+ * @param teeth Teeth of the tables, 0 to never build one
+ * @return 0 on success, -1 if out of memory
+ */
+int dsk_cache_init(dsk_cache_t* c, field_ptr field, int key_len, int capacity,
+                   double ttl_ms, int teeth);
+
+/**
+ * Wipe and release every entry; call while no lease is held
+ */
+void dsk_cache_clear(dsk_cache_t* c);
+
+/**
+ * Wipe every entry, reset the counters and keep at most capacity entries
+ * of ttl_ms from now on; call while no lease is held
+ * @return 0 on success, -1 if out of memory (the cache is then disabled)
+ */
+int dsk_cache_configure(dsk_cache_t* c, int capacity, double ttl_ms);
+
+/**
+ * Wipe every entry, keeping the configuration; call while no lease is held
+ */
+void dsk_cache_flush(dsk_cache_t* c);
+
+/**
+ * Lease the live entry of id whose key matches, building its table when
+ * this use reaches DSK_CACHE_TABLE_USES. An expired entry is wiped if no
+ * lease holds it. Safe to call from several threads at once.
+ * @return 1 with l filled in on a hit, 0 on a miss
+ */
+int dsk_cache_get(dsk_cache_t* c, long id, const unsigned char* key, dsk_cache_lease_t* l);
+
+/**
+ * out = dsk^n for the leased entry
+ */
+void dsk_cache_pow_zn(element_t out, element_t n, const dsk_cache_lease_t* l);
+
+/**
+ * Copy the leased DSK into out
+ */
+void dsk_cache_copy(element_t out, const dsk_cache_lease_t* l);
+
+/**
+ * End a lease from dsk_cache_get
+ */
+void dsk_cache_put(dsk_cache_t* c, dsk_cache_lease_t* l);
+
+/**
+ * Keep dsk under id and key, in place of the entry of id if there is one,
+ * else in a free or expired entry, else over the least recently used one
+ * no lease holds. Nothing is kept when every entry is leased.
+ */
+void dsk_cache_insert(dsk_cache_t* c, long id, const unsigned char* key, element_t dsk);
+
+/**
+ * Counters since init or the last reset
+ * @param evictions Live entries wiped to make room or on expiry (may be NULL)
+ */
+void dsk_cache_stats(dsk_cache_t* c, unsigned long* hits, unsigned long* misses,
+                     unsigned long* evictions);
+
+void dsk_cache_reset_stats(dsk_cache_t* c);
+
+#endif /* DSK_CACHE_H */
@@ -0,0 +1,148 @@
+/****************************************************************************
+ * File: eph_pool.c
+ * Desc: Pool of precomputed ephemerals, see eph_pool.h
+ ****************************************************************************/
+
+#define _GNU_SOURCE             // SCHED_IDLE
+#include <stdlib.h>
+#include <sched.h>
+#include "eph_pool.h"
+#include "seeded_random.h"
+
+static void entry_wipe(element_t* e, int width) {
+    for (int j = 0; j < width; j++) element_wipe(e[j]);
+}
+
+static void entry_init(element_t* e, field_ptr fields[], int width) {
+    for (int j = 0; j < width; j++) element_init(e[j], fields[j]);
+}
+
+static void entry_clear(element_t* e, int width) {
+    entry_wipe(e, width);
+    for (int j = 0; j < width; j++) element_clear(e[j]);
+}
+
+static void release_entries(eph_pool_t* p) {
+    for (int i = 0; i < p->capacity; i++) entry_clear(&p->entries[i * p->width], p->width);
+    free(p->entries);
+    p->entries = NULL;
+    p->capacity = 0;
+    p->head = p->count = 0;
+}
+
+// Computes outside the lock into its own entry and copies it into the ring
+static void* filler(void* arg) {
+    eph_pool_t* p = (eph_pool_t*)arg;
+
+#ifdef SCHED_IDLE
+    // Only spare CPU time; the foreground operations keep theirs
+    struct sched_param param = { 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+    seeded_random_job_t job = { 0, 0 };
+    seeded_random_bind_t rnd;
+    int bound = seeded_random_bind(&rnd, &job) == 0;
+
+    element_t fresh[EPH_POOL_MAX_WIDTH];
+    element_ptr fresh_ptr[EPH_POOL_MAX_WIDTH];
+    entry_init(fresh, p->fields, p->width);
+    for (int j = 0; j < p->width; j++) fresh_ptr[j] = fresh[j];
+
+    pthread_mutex_lock(&p->lock);
+    while (bound && !p->stop) {
+        if (p->count == p->capacity) {
+            pthread_cond_wait(&p->space, &p->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&p->lock);
+        p->fill(fresh_ptr, p->ctx);
+        pthread_mutex_lock(&p->lock);
+        if (p->stop) break;
+
+        element_t* e = &p->entries[((p->head + p->count) % p->capacity) * p->width];
+        for (int j = 0; j < p->width; j++) element_set(e[j], fresh[j]);
+        p->count++;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    entry_clear(fresh, p->width);
+    if (bound) seeded_random_unbind(&rnd);
+    return NULL;
+}
+
+int eph_pool_init(eph_pool_t* p, field_ptr fields[], int width, int capacity,
+                  eph_pool_fill_fn fill, void* ctx) {
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->space, NULL);
+    p->width = width;
+    p->capacity = 0;
+    p->head = p->count = 0;
+    p->entries = NULL;
+    p->fill = fill;
+    p->ctx = ctx;
+    p->stop = 0;
+    p->running = 0;
+    p->hits = p->misses = 0;
+    for (int j = 0; j < width; j++) p->fields[j] = fields[j];
+    if (capacity <= 0) return 0;
+
+    p->entries = malloc((size_t)capacity * width * sizeof(element_t));
+    if (!p->entries) return -1;
+    for (int i = 0; i < capacity; i++) entry_init(&p->entries[i * width], fields, width);
+    p->capacity = capacity;
+
+    if (pthread_create(&p->thread, NULL, filler, p) != 0) {
+        release_entries(p);
+        return -1;
+    }
+    p->running = 1;
+    return 0;
+}
+
+void eph_pool_clear(eph_pool_t* p) {
+    if (p->running) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = 1;
+        pthread_cond_signal(&p->space);
+        pthread_mutex_unlock(&p->lock);
+        pthread_join(p->thread, NULL);
+        p->running = 0;
+    }
+    release_entries(p);
+    pthread_cond_destroy(&p->space);
+    pthread_mutex_destroy(&p->lock);
+}
+
+int eph_pool_pop(eph_pool_t* p, element_ptr out[]) {
+    if (p->capacity == 0) return 0;
+
+    pthread_mutex_lock(&p->lock);
+    if (p->count == 0) {
+        p->misses++;
+        pthread_mutex_unlock(&p->lock);
+        return 0;
+    }
+    element_t* e = &p->entries[p->head * p->width];
+    for (int j = 0; j < p->width; j++) element_set(out[j], e[j]);
+    entry_wipe(e, p->width);
+    p->head = (p->head + 1) % p->capacity;
+    p->count--;
+    p->hits++;
+    pthread_cond_signal(&p->space);
+    pthread_mutex_unlock(&p->lock);
+    return 1;
+}
+
+void eph_pool_stats(eph_pool_t* p, unsigned long* hits, unsigned long* misses) {
+    pthread_mutex_lock(&p->lock);
+    if (hits) *hits = p->hits;
+    if (misses) *misses = p->misses;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void eph_pool_reset_stats(eph_pool_t* p) {
+    pthread_mutex_lock(&p->lock);
+    p->hits = p->misses = 0;
+    pthread_mutex_unlock(&p->lock);
+}
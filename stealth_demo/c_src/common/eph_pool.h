@@ -0,0 +1,73 @@
+/****************************************************************************
+ * File: eph_pool.h
+ * Desc: Pool of precomputed ephemerals for the scheme cores
+ *       A ring of entries of a few elements each, such as (r, g^r), that
+ *       do not depend on the recipient. A background thread at idle
+ *       priority keeps the ring full, so the online part of address
+ *       generation and signing starts from a ready nonce. Entries hold
+ *       secret exponents: each is handed out once and zeroed when taken.
+ ****************************************************************************/
+
+#ifndef EPH_POOL_H
+#define EPH_POOL_H
+
+#include <pthread.h>
+#include <pbc/pbc.h>
+
+// Most elements in one entry
+#define EPH_POOL_MAX_WIDTH 4
+
+/**
+ * Compute one fresh entry into e[0..width), on the filler thread
+ */
+typedef void (*eph_pool_fill_fn)(element_ptr e[], void* ctx);
+
+typedef struct {
+    pthread_mutex_t lock;        // guards everything below but the thread
+    pthread_cond_t space;        // signalled when an entry is taken or on stop
+    int width;
+    int capacity;                // 0 while the pool is off
+    int head, count;
+    element_t* entries;          // capacity * width, entry i at entries[i * width]
+    field_ptr fields[EPH_POOL_MAX_WIDTH];
+    eph_pool_fill_fn fill;
+    void* ctx;
+    int stop;
+    int running;
+    pthread_t thread;
+    unsigned long hits, misses;
+} eph_pool_t;
+
+/**
+ * Start a pool of capacity entries, element j of each in fields[j], and
+ * its filler thread. The fill callback and what it reads must stay valid
+ * until eph_pool_clear.
+ * @param capacity Entries kept ready; 0 leaves the pool off (every pop misses)
+ * @return 0 on success, -1 if out of memory or no thread could be started
+ *         (the pool is then off, and still to be cleared)
+ */
+int eph_pool_init(eph_pool_t* p, field_ptr fields[], int width, int capacity,
+                  eph_pool_fill_fn fill, void* ctx);
+
+/**
+ * Stop the filler, waiting for an entry in progress, and wipe and release
+ * the entries. The pool may be initialized again afterwards.
+ */
+void eph_pool_clear(eph_pool_t* p);
+
+/**
+ * Take the oldest ready entry into out[0..width) and zero it in the ring.
+ * Does not wait for the filler to compute one. Safe to call from several threads at once.
+ * @return 1 if an entry was taken, 0 if the pool is empty or off
+ */
+int eph_pool_pop(eph_pool_t* p, element_ptr out[]);
+
+/**
+ * Pops that found an entry and that found none, since eph_pool_init or
+ * eph_pool_reset_stats
+ */
+void eph_pool_stats(eph_pool_t* p, unsigned long* hits, unsigned long* misses);
+
+void eph_pool_reset_stats(eph_pool_t* p);
+
+#endif /* EPH_POOL_H */
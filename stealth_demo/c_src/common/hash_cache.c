@@ -0,0 +1,133 @@
+/****************************************************************************
+ * File: hash_cache.c
+ * Desc: Bounded LRU cache of hashes onto a group, see hash_cache.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hash_cache.h"
+
+static uint64_t key_tag(const unsigned char* key, int len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < len; i++) {
+        h ^= key[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void drop_entries(hash_cache_t* c) {
+    for (int i = 0; i < c->capacity; i++) element_clear(c->entries[i].value);
+    free(c->entries);
+    free(c->keys);
+    c->entries = NULL;
+    c->keys = NULL;
+    c->capacity = 0;
+}
+
+static int alloc_entries(hash_cache_t* c, int capacity) {
+    if (capacity <= 0 || c->key_len > HASH_CACHE_MAX_KEY) return 0;
+    c->entries = calloc(capacity, sizeof(hash_cache_entry_t));
+    c->keys = malloc((size_t)capacity * c->key_len);
+    if (!c->entries || !c->keys) {
+        free(c->entries);
+        free(c->keys);
+        c->entries = NULL;
+        c->keys = NULL;
+        return -1;
+    }
+    for (int i = 0; i < capacity; i++) element_init(c->entries[i].value, c->field);
+    c->capacity = capacity;
+    return 0;
+}
+
+int hash_cache_init(hash_cache_t* c, field_ptr field, int key_len, int capacity) {
+    pthread_mutex_init(&c->lock, NULL);
+    c->field = field;
+    c->capacity = 0;
+    c->key_len = key_len;
+    c->entries = NULL;
+    c->keys = NULL;
+    c->clock = 0;
+    c->hits = c->misses = 0;
+    return alloc_entries(c, capacity);
+}
+
+void hash_cache_clear(hash_cache_t* c) {
+    drop_entries(c);
+    pthread_mutex_destroy(&c->lock);
+    c->field = NULL;
+}
+
+int hash_cache_set_capacity(hash_cache_t* c, int capacity) {
+    pthread_mutex_lock(&c->lock);
+    drop_entries(c);
+    c->hits = c->misses = 0;
+    int rc = alloc_entries(c, capacity);
+    pthread_mutex_unlock(&c->lock);
+    return rc;
+}
+
+static hash_cache_entry_t* find(hash_cache_t* c, const unsigned char* key, uint64_t tag) {
+    for (int i = 0; i < c->capacity; i++) {
+        hash_cache_entry_t* e = &c->entries[i];
+        if (e->key && e->tag == tag && memcmp(e->key, key, c->key_len) == 0) return e;
+    }
+    return NULL;
+}
+
+int hash_cache_get(hash_cache_t* c, element_t out, const unsigned char* key) {
+    if (c->capacity == 0) return 0;
+    uint64_t tag = key_tag(key, c->key_len);
+
+    pthread_mutex_lock(&c->lock);
+    hash_cache_entry_t* e = find(c, key, tag);
+    if (e) {
+        element_set(out, e->value);
+        e->last_used = ++c->clock;
+        c->hits++;
+    } else {
+        c->misses++;
+    }
+    pthread_mutex_unlock(&c->lock);
+    return e != NULL;
+}
+
+void hash_cache_put(hash_cache_t* c, const unsigned char* key, element_t value) {
+    if (c->capacity == 0) return;
+    uint64_t tag = key_tag(key, c->key_len);
+
+    pthread_mutex_lock(&c->lock);
+    hash_cache_entry_t* victim = NULL;
+    if (!find(c, key, tag)) {
+        for (int i = 0; i < c->capacity; i++) {
+            hash_cache_entry_t* e = &c->entries[i];
+            if (!e->key) {
+                victim = e;
+                break;
+            }
+            if (!victim || e->last_used < victim->last_used) victim = e;
+        }
+    }
+    if (victim) {
+        victim->key = &c->keys[(victim - c->entries) * (size_t)c->key_len];
+        memcpy(victim->key, key, c->key_len);
+        victim->tag = tag;
+        element_set(victim->value, value);
+        victim->last_used = ++c->clock;
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+void hash_cache_stats(hash_cache_t* c, unsigned long* hits, unsigned long* misses) {
+    pthread_mutex_lock(&c->lock);
+    if (hits) *hits = c->hits;
+    if (misses) *misses = c->misses;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void hash_cache_reset_stats(hash_cache_t* c) {
+    pthread_mutex_lock(&c->lock);
+    c->hits = c->misses = 0;
+    pthread_mutex_unlock(&c->lock);
+}
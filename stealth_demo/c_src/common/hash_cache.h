@@ -0,0 +1,78 @@
+/****************************************************************************
+ * File: hash_cache.h
+ * Desc: Bounded LRU cache of hashes onto a group for the scheme cores
+ *       Keeps the value a public input hashed to, keyed by the input's
+ *       serialized bytes, for hashes that cost a map onto the curve, such
+ *       as H3(Addr) under STEALTH_HASH_G1_MAP for every signature
+ *       verified and every key derived on one address
+ ****************************************************************************/
+
+#ifndef HASH_CACHE_H
+#define HASH_CACHE_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+
+// Longest key; larger inputs are hashed without the cache
+#define HASH_CACHE_MAX_KEY 512
+
+typedef struct {
+    unsigned char* key;          // NULL while the entry is free
+    uint64_t tag;                // FNV-1a of key, compared first
+    element_t value;
+    unsigned long last_used;
+} hash_cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;        // guards everything below
+    field_ptr field;             // of the values
+    int capacity;                // 0 disables the cache
+    int key_len;
+    hash_cache_entry_t* entries;
+    unsigned char* keys;         // capacity * key_len, entry i at keys[i * key_len]
+    unsigned long clock;
+    unsigned long hits, misses;
+} hash_cache_t;
+
+/**
+ * Bind an empty cache to the field of the values
+ * @param key_len Bytes of every key
+ * @param capacity Most values kept; 0 hashes every input afresh
+ * @return 0 on success, -1 if out of memory
+ */
+int hash_cache_init(hash_cache_t* c, field_ptr field, int key_len, int capacity);
+
+/**
+ * Release every entry; call while no lookup is running
+ */
+void hash_cache_clear(hash_cache_t* c);
+
+/**
+ * Drop every entry and the counters and keep at most capacity from now
+ * on, e.g. when the hash changes
+ * @return 0 on success, -1 if out of memory (the cache is then disabled)
+ */
+int hash_cache_set_capacity(hash_cache_t* c, int capacity);
+
+/**
+ * Copy the value cached for key into out. Safe to call from several
+ * threads at once.
+ * @return 1 on a hit, 0 on a miss (or with the cache disabled)
+ */
+int hash_cache_get(hash_cache_t* c, element_t out, const unsigned char* key);
+
+/**
+ * Keep value for key in a free entry or over the least recently used one;
+ * nothing happens if another thread kept key meanwhile
+ */
+void hash_cache_put(hash_cache_t* c, const unsigned char* key, element_t value);
+
+/**
+ * Lookup counters since init or the last reset
+ */
+void hash_cache_stats(hash_cache_t* c, unsigned long* hits, unsigned long* misses);
+
+void hash_cache_reset_stats(hash_cache_t* c);
+
+#endif /* HASH_CACHE_H */
@@ -0,0 +1,61 @@
+/****************************************************************************
+ * File: hash_stream.c
+ * Desc: Streaming SHA-256 for the scheme cores, see hash_stream.h
+ ****************************************************************************/
+
+// SHA256_Init / _Update / _Final are deprecated since OpenSSL 3.0 but kept
+// for their speed
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <string.h>
+#include "hash_stream.h"
+
+void hash_stream_begin(hash_stream_t* h) {
+    SHA256_Init(&h->sha);
+    memset(&h->cost, 0, sizeof(h->cost));
+}
+
+void hash_stream_bytes(hash_stream_t* h, const void* data, size_t len) {
+    prim_mark_t m;
+    prim_begin(&m);
+    SHA256_Update(&h->sha, data, len);
+    prim_cost_add(&h->cost, &m);
+}
+
+size_t hash_stream_element(hash_stream_t* h, element_t e) {
+    unsigned char buf[element_length_in_bytes(e)];
+    size_t len = prim_to_bytes(buf, e);
+    hash_stream_bytes(h, buf, len);
+    return len;
+}
+
+void hash_stream_end(hash_stream_t* h, unsigned char digest[SHA256_DIGEST_LENGTH]) {
+    SHA256_Final(digest, &h->sha);
+}
+
+void hash_stream_end_mpz(hash_stream_t* h, mpz_t out, mpz_t mod) {
+    prim_mark_t m;
+    prim_begin(&m);
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256_Final(digest, &h->sha);
+    mpz_import(out, SHA256_DIGEST_LENGTH, 1, 1, 0, 0, digest);
+    mpz_mod(out, out, mod);
+    prim_cost_add(&h->cost, &m);
+    prim_record_cost(PRIM_HASH_ZR, &h->cost, 1);
+}
+
+void hash_stream_end_zr(hash_stream_t* h, element_t out) {
+    prim_mark_t m;
+    prim_begin(&m);
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256_Final(digest, &h->sha);
+    element_from_bytes_mod(out, digest, SHA256_DIGEST_LENGTH);
+    prim_cost_add(&h->cost, &m);
+    prim_record_cost(PRIM_HASH_ZR, &h->cost, 1);
+}
+
+void hash_stream_to_mpz(mpz_t out, const unsigned char* data, size_t len, mpz_t mod) {
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_bytes(&h, data, len);
+    hash_stream_end_mpz(&h, out, mod);
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+ * File: hash_stream.h
+ * Desc: Streaming SHA-256 for the scheme cores
+ *       Inputs made of several parts (elements, tags, messages) are fed to
+ *       one digest in turn instead of being copied into a concatenation
+ *       buffer, and digests reduce into an mpz the caller keeps
+ *       initialized. Uses OpenSSL's low-level SHA-256, which skips the
+ *       per-call provider lookup of the one-shot SHA256()
+ ****************************************************************************/
+
+#ifndef HASH_STREAM_H
+#define HASH_STREAM_H
+
+#include <stddef.h>
+#include <pbc/pbc.h>
+#include <openssl/sha.h>
+#include "perf_prim.h"
+
+typedef struct {
+    SHA256_CTX sha;
+    prim_cost_t cost;            // spent hashing, for PRIM_HASH_ZR
+} hash_stream_t;
+
+void hash_stream_begin(hash_stream_t* h);
+
+void hash_stream_bytes(hash_stream_t* h, const void* data, size_t len);
+
+/**
+ * Feed the uncompressed encoding of e, serialized on the stack
+ * @return Bytes fed
+ */
+size_t hash_stream_element(hash_stream_t* h, element_t e);
+
+void hash_stream_end(hash_stream_t* h, unsigned char digest[SHA256_DIGEST_LENGTH]);
+
+/**
+ * Finish into out = digest mod mod, the digest read big-endian; out must
+ * be initialized, so once it has grown to size no call allocates
+ */
+void hash_stream_end_mpz(hash_stream_t* h, mpz_t out, mpz_t mod);
+
+/**
+ * Finish into the Zr element out = digest mod r, reduced straight from
+ * the digest bytes (element_from_bytes_mod) without an mpz in between
+ */
+void hash_stream_end_zr(hash_stream_t* h, element_t out);
+
+/**
+ * SHA256(data) mod mod in one call
+ */
+void hash_stream_to_mpz(mpz_t out, const unsigned char* data, size_t len, mpz_t mod);
+
+#endif /* HASH_STREAM_H */
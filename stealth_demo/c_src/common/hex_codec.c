@@ -0,0 +1,192 @@
+/****************************************************************************
+ * File: hex_codec.c
+ * Desc: Hex encoding and decoding of element bytes, see hex_codec.h
+ ****************************************************************************/
+
+#include <string.h>
+#include "hex_codec.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const char hex_digits[] = "0123456789abcdef";
+
+// Value of one hex character, -1 if it is none
+static int nibble(unsigned char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+#if defined(__AVX2__)
+// Characters of 32 nibbles: n + '0', plus 'a' - '0' - 10 past 9
+static inline __m256i nibble_chars256(__m256i n) {
+    __m256i past9 = _mm256_cmpgt_epi8(n, _mm256_set1_epi8(9));
+    return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')),
+                           _mm256_and_si256(past9, _mm256_set1_epi8('a' - '0' - 10)));
+}
+
+// Values of 32 hex characters; sets *bad if any is none
+static inline __m256i char_nibbles256(__m256i c, __m256i* bad) {
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+    __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    *bad = _mm256_or_si256(*bad, _mm256_andnot_si256(_mm256_or_si256(digit, alpha),
+                                                     _mm256_set1_epi8(-1)));
+    return _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+                           _mm256_and_si256(alpha, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+}
+
+// 16 bytes from 32 nibbles, the high nibble first: (even << 4) | odd per 16-bit lane
+static inline __m256i join_nibbles256(__m256i v) {
+    __m256i hi = _mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x00ff)), 4);
+    return _mm256_or_si256(hi, _mm256_srli_epi16(v, 8));
+}
+#elif defined(__SSE2__)
+static inline __m128i nibble_chars128(__m128i n) {
+    __m128i past9 = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')),
+                        _mm_and_si128(past9, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+static inline __m128i char_nibbles128(__m128i c, __m128i* bad) {
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                  _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    *bad = _mm_or_si128(*bad, _mm_andnot_si128(_mm_or_si128(digit, alpha), _mm_set1_epi8(-1)));
+    return _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                        _mm_and_si128(alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+static inline __m128i join_nibbles128(__m128i v) {
+    __m128i hi = _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), 4);
+    return _mm_or_si128(hi, _mm_srli_epi16(v, 8));
+}
+#endif
+
+int hex_encode(char* out, const unsigned char* in, size_t n) {
+    size_t i = 0;
+    unsigned char any = 0;
+#if defined(__AVX2__)
+    __m256i seen = _mm256_setzero_si256();
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+        seen = _mm256_or_si256(seen, x);
+        __m256i hi = nibble_chars256(_mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+        __m256i lo = nibble_chars256(_mm256_and_si256(x, low));
+        // Interleaving works per 128-bit lane: bytes 0-7 | 16-23 and 8-15 | 24-31
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)(out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    any = !_mm256_testz_si256(seen, seen);
+#elif defined(__SSE2__)
+    __m128i seen = _mm_setzero_si128();
+    const __m128i low = _mm_set1_epi8(0x0f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+        seen = _mm_or_si128(seen, x);
+        __m128i hi = nibble_chars128(_mm_and_si128(_mm_srli_epi16(x, 4), low));
+        __m128i lo = nibble_chars128(_mm_and_si128(x, low));
+        _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    any = _mm_movemask_epi8(_mm_cmpeq_epi8(seen, _mm_setzero_si128())) != 0xffff;
+#endif
+    for (; i < n; i++) {
+        any |= in[i];
+        out[2 * i] = hex_digits[in[i] >> 4];
+        out[2 * i + 1] = hex_digits[in[i] & 0x0f];
+    }
+    return !any;
+}
+
+// n bytes from the 2n characters at in; -1 on a non-hex character
+static int decode_pairs(unsigned char* out, const char* in, size_t n) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i bad = _mm256_setzero_si256();
+    for (; i + 32 <= n; i += 32) {
+        __m256i v0 = char_nibbles256(_mm256_loadu_si256((const __m256i*)(in + 2 * i)), &bad);
+        __m256i v1 = char_nibbles256(_mm256_loadu_si256((const __m256i*)(in + 2 * i + 32)), &bad);
+        // Packing is per lane too: v0 0-7, v1 0-7 | v0 8-15, v1 8-15
+        __m256i b = _mm256_packus_epi16(join_nibbles256(v0), join_nibbles256(v1));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(b, 0xd8));
+    }
+    if (!_mm256_testz_si256(bad, bad)) return -1;
+#elif defined(__SSE2__)
+    __m128i bad = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i v0 = char_nibbles128(_mm_loadu_si128((const __m128i*)(in + 2 * i)), &bad);
+        __m128i v1 = char_nibbles128(_mm_loadu_si128((const __m128i*)(in + 2 * i + 16)), &bad);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(join_nibbles128(v0), join_nibbles128(v1)));
+    }
+    if (_mm_movemask_epi8(bad)) return -1;
+#endif
+    for (; i < n; i++) {
+        int hi = nibble((unsigned char)in[2 * i]);
+        int lo = nibble((unsigned char)in[2 * i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[i] = (unsigned char)(hi << 4 | lo);
+    }
+    return 0;
+}
+
+long hex_decode(unsigned char* out, size_t out_size, const char* in, size_t len) {
+    size_t need = (len + 1) / 2;
+    size_t take = need < out_size ? need : out_size;
+    if (take == 0) {
+        for (size_t i = 0; i < len; i++)
+            if (nibble((unsigned char)in[i]) < 0) return -1;
+        return (long)need;
+    }
+    if (len & 1) {
+        int lo = nibble((unsigned char)in[0]);
+        if (lo < 0) return -1;
+        out[0] = (unsigned char)lo;
+        if (decode_pairs(out + 1, in + 1, take - 1) < 0) return -1;
+    } else if (decode_pairs(out, in, take) < 0) {
+        return -1;
+    }
+    // Characters past out_size are still checked
+    for (size_t i = 2 * take - (len & 1); i < len; i++)
+        if (nibble((unsigned char)in[i]) < 0) return -1;
+    return (long)need;
+}
+
+long hex_encode_rows(char* out, const unsigned char* in, long n, size_t size, char sep,
+                     unsigned char* zero_out) {
+    long zeros = 0;
+    for (long i = 0; i < n; i++) {
+        char* row = out + (2 * size + 1) * i;
+        int zero = hex_encode(row, in + size * i, size);
+        if (i + 1 < n) row[2 * size] = sep;
+        if (zero_out) zero_out[i] = (unsigned char)zero;
+        zeros += zero;
+    }
+    return zeros;
+}
+
+long hex_decode_rows(unsigned char* out, long n, size_t size, const char* text, size_t len, char sep) {
+    const char* p = text;
+    const char* end = text + len;
+    for (long i = 0; i < n; i++) {
+        const char* stop = i + 1 < n ? memchr(p, sep, (size_t)(end - p)) : end;
+        if (!stop) return -1;
+        long got = stop > p ? hex_decode(out + size * i, size, p, (size_t)(stop - p)) : -1;
+        if (got < 0) return 1 + i;
+        if ((size_t)got < size) memset(out + size * i + got, 0, size - got);
+        p = stop + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+/****************************************************************************
+ * File: hex_codec.h
+ * Desc: Hex encoding and decoding of element bytes for the Python API
+ *       Converts 32 (AVX2) or 16 (SSE2) bytes per step, nibbles to
+ *       characters in vector registers, so that responses listing
+ *       thousands of elements are not converted one byte at a time
+ ****************************************************************************/
+
+#ifndef HEX_CODEC_H
+#define HEX_CODEC_H
+
+#include <stddef.h>
+
+/**
+ * Write the lowercase hex of n bytes to out (2n characters, no NUL)
+ * @return 1 if every byte was zero, else 0
+ */
+int hex_encode(char* out, const unsigned char* in, size_t n);
+
+/**
+ * Decode len hex characters, either case, into out. An odd length reads
+ * as if prefixed by '0'. Bytes beyond out_size are checked but dropped.
+ * @return Bytes the text decodes to, or -1 on a non-hex character
+ */
+long hex_decode(unsigned char* out, size_t out_size, const char* in, size_t len);
+
+/**
+ * Encode n rows of size bytes, row i at in + i * size, into out as n
+ * strings separated by sep (n * (2 * size + 1) - 1 characters)
+ * @param zero_out One byte per row, 1 if the row is all zero (output), NULL to skip
+ * @return Number of all-zero rows
+ */
+long hex_encode_rows(char* out, const unsigned char* in, long n, size_t size, char sep,
+                     unsigned char* zero_out);
+
+/**
+ * Decode n hex strings separated by sep in text into n rows of size
+ * bytes, each decoded as hex_decode and zero padded on the right
+ * @return 0 on success, 1 + i if string i is empty or not hex (the last one
+ *         takes in any surplus separators), -1 if text holds fewer than n
+ */
+long hex_decode_rows(unsigned char* out, long n, size_t size, const char* text, size_t len, char sep);
+
+#endif // HEX_CODEC_H
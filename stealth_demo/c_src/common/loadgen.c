@@ -0,0 +1,708 @@
+// Load generator for the demo server's REST API: end-to-end latency of
+// the scheme operations through Flask, the wrappers and the C core under
+// sustained, mixed load (see lto.mk).
+//
+// Usage: loadgen [-u url] [-c connections] [-d seconds] [-w seconds]
+//                [-r rate] [-m mix] [-k keys] [-a addresses] [-s signatures]
+//                [-p param_file] [-S seed] [-C]
+//
+//   -u  server base URL (default http://127.0.0.1:5000)
+//   -c  connections, one thread each, kept alive (default 8)
+//   -d  measured seconds (default 10), after -w seconds of warm-up (default 2)
+//   -r  open loop at rate requests/s in total, Poisson arrivals; 0 (the
+//       default) for closed loop, each connection sending back to back
+//   -m  operation mix as name=weight,... over addrgen, recognize_addr,
+//       dskgen, sign, verify_signature and trace (default
+//       addrgen=15,recognize_addr=40,dskgen=10,sign=10,verify_signature=15,trace=10)
+//   -k, -a, -s  key pairs, addresses and signatures created before the run
+//       for the requests to use (default 8, 64, 32)
+//   -p  POST /setup with this parameter file first
+//   -C  print CSV instead of a table
+//
+// The setup creates its own keys and addresses, so the server only needs
+// its current scheme set up. Requests pick addresses and signatures at
+// random from those; recognize_addr tries a random key, dskgen and sign
+// use the address's owner. On a scheme without signing, sign and
+// verify_signature are dropped from the mix.
+//
+// Latency runs from when a request was due to its last response byte: in
+// open loop a request waiting for a free connection counts its wait, so
+// an overloaded server shows in the percentiles instead of slowing the
+// arrivals. Histograms are log-bucketed, 2% wide.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+enum { OP_ADDRGEN, OP_RECOGNIZE, OP_DSKGEN, OP_SIGN, OP_VERIFY, OP_TRACE, OP_COUNT };
+
+static const char* OP_NAMES[OP_COUNT] = {
+    "addrgen", "recognize_addr", "dskgen", "sign", "verify_signature", "trace"
+};
+
+static const int DEFAULT_MIX[OP_COUNT] = { 15, 40, 10, 10, 15, 10 };
+
+// Histogram buckets: bucket i holds latencies up to LAT_STEP^i microseconds
+#define LAT_STEP 1.02
+#define LAT_BUCKETS 1200
+
+#define HEX_MAX 1024
+#define BODY_MAX (3 * HEX_MAX)
+
+typedef struct {
+    char host[256];
+    char port[16];
+    char prefix[256];
+    int connections;
+    double duration, warmup, rate;
+    int mix[OP_COUNT];
+    int keys, addresses, signatures;
+    const char* param_file;
+    unsigned seed;
+    int csv;
+} options_t;
+
+typedef struct {
+    int index, owner;
+} address_t;
+
+typedef struct {
+    char message[64];
+    char q_sigma_hex[HEX_MAX];
+    char h_hex[HEX_MAX];
+    int address;
+} signature_t;
+
+typedef struct {
+    unsigned long count, errors;
+    double sum_ms, max_ms;
+    unsigned buckets[LAT_BUCKETS];
+} op_stats_t;
+
+typedef struct {
+    int fd;
+    char* buf;              // response being read
+    size_t cap, len;
+    char* body;             // body within buf, or decoded when chunked
+    size_t body_len;
+    char* dechunked;
+    size_t dechunked_cap;
+} conn_t;
+
+typedef struct {
+    pthread_t thread;
+    int id;
+    unsigned long long rng;
+    op_stats_t stats[OP_COUNT];
+    unsigned long sent;
+} worker_t;
+
+static options_t opt;
+static address_t* addresses;
+static int address_count;
+static int key_base;
+static signature_t* signatures;
+static int signature_count;
+static int mix_total;
+static struct timespec t0;
+
+// Open loop: the next request due, in seconds from t0
+static pthread_mutex_t schedule_lock = PTHREAD_MUTEX_INITIALIZER;
+static double next_due;
+static unsigned long long schedule_rng;
+
+static double now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec - t0.tv_sec) + (t.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+static void sleep_until(double at) {
+    double s = floor(at);
+    struct timespec t = { t0.tv_sec + (time_t)s, t0.tv_nsec + (long)((at - s) * 1e9) };
+    if (t.tv_nsec >= 1000000000L) {
+        t.tv_sec++;
+        t.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR) {}
+}
+
+// splitmix64
+static unsigned long long rng_next(unsigned long long* s) {
+    unsigned long long z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double rng_unit(unsigned long long* s) {
+    return (rng_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int rng_below(unsigned long long* s, int n) {
+    return (int)(rng_next(s) % (unsigned long long)n);
+}
+
+//----------------------------------------------
+// HTTP/1.1 over one kept-alive connection
+//----------------------------------------------
+
+static int conn_open(conn_t* c) {
+    struct addrinfo hints = { 0 }, *res, *ai;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(opt.host, opt.port, &hints, &res) != 0) return -1;
+    c->fd = -1;
+    for (ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            c->fd = fd;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+    return c->fd >= 0 ? 0 : -1;
+}
+
+static void conn_close(conn_t* c) {
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+}
+
+static void conn_free(conn_t* c) {
+    conn_close(c);
+    free(c->buf);
+    free(c->dechunked);
+}
+
+static int write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= w;
+    }
+    return 0;
+}
+
+// Read more of the response into buf; 0 at end of stream, -1 on error
+static ssize_t conn_fill(conn_t* c) {
+    if (c->cap - c->len < 4096) {
+        size_t cap = c->cap ? c->cap * 2 : 16384;
+        char* grown = realloc(c->buf, cap + 1);
+        if (!grown) return -1;
+        c->buf = grown;
+        c->cap = cap;
+    }
+    for (;;) {
+        ssize_t r = recv(c->fd, c->buf + c->len, c->cap - c->len, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r > 0) c->len += r;
+        return r;
+    }
+}
+
+static const char* header_value(const char* headers, const char* end, const char* name) {
+    size_t n = strlen(name);
+    for (const char* line = headers; line && line < end; ) {
+        if (strncasecmp(line, name, n) == 0 && line[n] == ':') {
+            line += n + 1;
+            while (*line == ' ' || *line == '\t') line++;
+            return line;
+        }
+        line = strstr(line, "\r\n");
+        if (line) line += 2;
+    }
+    return NULL;
+}
+
+// Decode the chunked body starting at offset start of buf, reading more as needed
+static int read_chunked(conn_t* c, size_t start) {
+    size_t pos = start, out = 0;
+    for (;;) {
+        char* eol;
+        while (!(eol = memmem(c->buf + pos, c->len - pos, "\r\n", 2)))
+            if (conn_fill(c) <= 0) return -1;
+        size_t size = strtoul(c->buf + pos, NULL, 16);
+        pos = eol - c->buf + 2;
+        while (c->len - pos < size + 2)
+            if (conn_fill(c) <= 0) return -1;
+        if (size == 0) break;
+        if (out + size + 1 > c->dechunked_cap) {
+            size_t cap = (out + size + 1) * 2;
+            char* grown = realloc(c->dechunked, cap);
+            if (!grown) return -1;
+            c->dechunked = grown;
+            c->dechunked_cap = cap;
+        }
+        memcpy(c->dechunked + out, c->buf + pos, size);
+        out += size;
+        pos += size + 2;
+    }
+    if (!c->dechunked && !(c->dechunked = malloc(c->dechunked_cap = 1))) return -1;
+    c->dechunked[out] = '\0';
+    c->body = c->dechunked;
+    c->body_len = out;
+    return 0;
+}
+
+/**
+ * Send one request and read the whole response into c->body
+ * @return the HTTP status, or -1 if the connection failed (it is closed)
+ */
+static int http_request(conn_t* c, const char* method, const char* path, const char* body) {
+    // Head and body go out in one write, so no segment waits on a delayed ACK
+    char req[1024 + BODY_MAX];
+    size_t body_len = body ? strlen(body) : 0;
+    int head_len = snprintf(req, sizeof(req),
+                            "%s %s%s HTTP/1.1\r\nHost: %s:%s\r\nAccept: application/json\r\n"
+                            "Content-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                            method, opt.prefix, path, opt.host, opt.port, body_len);
+    if (head_len < 0 || head_len + body_len >= sizeof(req)) return -1;
+    memcpy(req + head_len, body ? body : "", body_len);
+
+    // A kept-alive connection the server has since closed fails on first use
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (c->fd < 0 && conn_open(c) != 0) return -1;
+        c->len = 0;
+        if (write_all(c->fd, req, head_len + body_len) != 0) {
+            conn_close(c);
+            continue;
+        }
+        char* end;
+        ssize_t r = 1;
+        while (!(c->buf && (end = memmem(c->buf, c->len, "\r\n\r\n", 4))) && (r = conn_fill(c)) > 0) {}
+        if (r <= 0) {
+            int fresh = c->len == 0;
+            conn_close(c);
+            if (fresh) continue;
+            return -1;
+        }
+        c->buf[c->len] = '\0';
+        int minor = 1, status = 0;
+        if (sscanf(c->buf, "HTTP/1.%d %d", &minor, &status) != 2) {
+            conn_close(c);
+            return -1;
+        }
+        const char* headers = strstr(c->buf, "\r\n") + 2;
+        size_t start = end - c->buf + 4;
+        const char* te = header_value(headers, end, "Transfer-Encoding");
+        const char* cl = header_value(headers, end, "Content-Length");
+        const char* connection = header_value(headers, end, "Connection");
+        int keep = minor >= 1 ? !(connection && strncasecmp(connection, "close", 5) == 0)
+                              : (connection && strncasecmp(connection, "keep-alive", 10) == 0);
+        size_t length = cl ? strtoul(cl, NULL, 10) : 0;
+
+        if (te && strncasecmp(te, "chunked", 7) == 0) {
+            if (read_chunked(c, start) != 0) {
+                conn_close(c);
+                return -1;
+            }
+        } else {
+            while ((cl ? c->len - start < length : 1) && (r = conn_fill(c)) > 0) {}
+            if (cl && c->len - start < length) {
+                conn_close(c);
+                return -1;
+            }
+            if (!cl) keep = 0;  // delimited by the end of the stream
+            c->body = c->buf + start;
+            c->body_len = cl ? length : c->len - start;
+            c->body[c->body_len] = '\0';
+        }
+        if (!keep) conn_close(c);
+        return status;
+    }
+    return -1;
+}
+
+//----------------------------------------------
+// JSON fields of the flat responses
+//----------------------------------------------
+
+static const char* json_field(const char* json, const char* key) {
+    char quoted[64];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    const char* p = strstr(json, quoted);
+    if (!p) return NULL;
+    p += strlen(quoted);
+    while (*p == ' ') p++;
+    if (*p != ':') return NULL;
+    p++;
+    while (*p == ' ') p++;
+    return p;
+}
+
+static int json_int(const char* json, const char* key, int* out) {
+    const char* p = json_field(json, key);
+    if (!p || !(*p == '-' || (*p >= '0' && *p <= '9'))) return -1;
+    *out = atoi(p);
+    return 0;
+}
+
+static int json_str(const char* json, const char* key, char* out, size_t size) {
+    const char* p = json_field(json, key);
+    if (!p || *p != '"') return -1;
+    const char* q = strchr(++p, '"');
+    if (!q || (size_t)(q - p) >= size) return -1;
+    memcpy(out, p, q - p);
+    out[q - p] = '\0';
+    return 0;
+}
+
+//----------------------------------------------
+// Setup and requests
+//----------------------------------------------
+
+static int setup(void) {
+    conn_t c = { .fd = -1 };
+    char body[BODY_MAX];
+    int status, failed = 0;
+
+    if (opt.param_file) {
+        snprintf(body, sizeof(body), "{\"param_file\":\"%s\"}", opt.param_file);
+        if ((status = http_request(&c, "POST", "/setup", body)) != 200) {
+            fprintf(stderr, "loadgen: /setup failed (%d): %s\n", status, status > 0 ? c.body : "");
+            failed = 1;
+        }
+    }
+
+    for (int k = 0; k < opt.keys && !failed; k++) {
+        int index;
+        status = http_request(&c, "GET", "/keygen", NULL);
+        if (status != 200 || json_int(c.body, "index", &index) != 0) {
+            fprintf(stderr, "loadgen: /keygen failed (%d): %s\n", status, status > 0 ? c.body : "");
+            failed = 1;
+        } else if (k == 0) {
+            key_base = index;
+        }
+    }
+
+    addresses = calloc(opt.addresses, sizeof(address_t));
+    for (int i = 0; i < opt.addresses && !failed; i++) {
+        int owner = key_base + i % opt.keys;
+        snprintf(body, sizeof(body), "{\"key_index\":%d}", owner);
+        status = http_request(&c, "POST", "/addrgen", body);
+        if (status != 200 || json_int(c.body, "index", &addresses[i].index) != 0) {
+            fprintf(stderr, "loadgen: /addrgen failed (%d): %s\n", status, status > 0 ? c.body : "");
+            failed = 1;
+        } else {
+            addresses[i].owner = owner;
+            address_count++;
+        }
+    }
+
+    if (!failed && (opt.mix[OP_SIGN] || opt.mix[OP_VERIFY])) {
+        signatures = calloc(opt.signatures, sizeof(signature_t));
+        for (int i = 0; i < opt.signatures; i++) {
+            signature_t* s = &signatures[i];
+            address_t* a = &addresses[i % address_count];
+            snprintf(s->message, sizeof(s->message), "loadgen %d", i);
+            snprintf(body, sizeof(body), "{\"message\":\"%s\",\"address_index\":%d,\"key_index\":%d}",
+                     s->message, a->index, a->owner);
+            status = http_request(&c, "POST", "/sign", body);
+            if (status != 200 || json_str(c.body, "q_sigma_hex", s->q_sigma_hex, HEX_MAX) != 0 ||
+                json_str(c.body, "h_hex", s->h_hex, HEX_MAX) != 0) {
+                fprintf(stderr, "loadgen: no signing on this scheme (%d), dropping sign and verify_signature\n",
+                        status);
+                opt.mix[OP_SIGN] = opt.mix[OP_VERIFY] = 0;
+                break;
+            }
+            s->address = a->index;
+            signature_count++;
+        }
+    }
+
+    conn_free(&c);
+    return failed ? -1 : 0;
+}
+
+static int pick_op(unsigned long long* rng) {
+    int r = rng_below(rng, mix_total);
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (r < opt.mix[op]) return op;
+        r -= opt.mix[op];
+    }
+    return OP_COUNT - 1;
+}
+
+static void build_request(int op, worker_t* w, const char** path, char* body) {
+    address_t* a = &addresses[rng_below(&w->rng, address_count)];
+    *path = NULL;
+    switch (op) {
+    case OP_ADDRGEN:
+        *path = "/addrgen";
+        sprintf(body, "{\"key_index\":%d}", key_base + rng_below(&w->rng, opt.keys));
+        break;
+    case OP_RECOGNIZE:
+        *path = "/recognize_addr";
+        sprintf(body, "{\"address_index\":%d,\"key_index\":%d}",
+                a->index, key_base + rng_below(&w->rng, opt.keys));
+        break;
+    case OP_DSKGEN:
+        *path = "/dskgen";
+        sprintf(body, "{\"address_index\":%d,\"key_index\":%d}", a->index, a->owner);
+        break;
+    case OP_SIGN:
+        *path = "/sign";
+        sprintf(body, "{\"message\":\"loadgen %d.%lu\",\"address_index\":%d,\"key_index\":%d}",
+                w->id, w->sent, a->index, a->owner);
+        break;
+    case OP_VERIFY: {
+        signature_t* s = &signatures[rng_below(&w->rng, signature_count)];
+        *path = "/verify_signature";
+        sprintf(body, "{\"message\":\"%s\",\"q_sigma_hex\":\"%s\",\"h_hex\":\"%s\",\"address_index\":%d}",
+                s->message, s->q_sigma_hex, s->h_hex, s->address);
+        break;
+    }
+    case OP_TRACE:
+        *path = "/trace";
+        sprintf(body, "{\"address_index\":%d}", a->index);
+        break;
+    }
+}
+
+static void record(op_stats_t* s, double ms, int ok) {
+    if (!ok) {
+        s->errors++;
+        return;
+    }
+    double us = ms * 1000.0;
+    int b = us <= 1.0 ? 0 : (int)ceil(log(us) / log(LAT_STEP));
+    if (b >= LAT_BUCKETS) b = LAT_BUCKETS - 1;
+    s->buckets[b]++;
+    s->count++;
+    s->sum_ms += ms;
+    if (ms > s->max_ms) s->max_ms = ms;
+}
+
+static void* worker_main(void* arg) {
+    worker_t* w = arg;
+    conn_t c = { .fd = -1 };
+    char body[BODY_MAX];
+    double end = opt.warmup + opt.duration;
+
+    for (;;) {
+        double due;
+        if (opt.rate > 0) {
+            pthread_mutex_lock(&schedule_lock);
+            due = next_due;
+            next_due += -log(1.0 - rng_unit(&schedule_rng)) / opt.rate;
+            pthread_mutex_unlock(&schedule_lock);
+            if (due >= end) break;
+            sleep_until(due);
+        } else {
+            due = now_s();
+            if (due >= end) break;
+        }
+
+        const char* path;
+        int op = pick_op(&w->rng);
+        build_request(op, w, &path, body);
+        int status = http_request(&c, "POST", path, body);
+        double done = now_s();
+        w->sent++;
+        if (due >= opt.warmup)
+            record(&w->stats[op], (done - due) * 1000.0, status >= 200 && status < 300);
+    }
+    conn_free(&c);
+    return NULL;
+}
+
+//----------------------------------------------
+// Report
+//----------------------------------------------
+
+static void merge(op_stats_t* into, const op_stats_t* s) {
+    into->count += s->count;
+    into->errors += s->errors;
+    into->sum_ms += s->sum_ms;
+    if (s->max_ms > into->max_ms) into->max_ms = s->max_ms;
+    for (int b = 0; b < LAT_BUCKETS; b++) into->buckets[b] += s->buckets[b];
+}
+
+// Upper bound of the bucket holding the sample of rank ceil(q * count), capped at the max
+static double percentile(const op_stats_t* s, double q) {
+    if (s->count == 0) return 0.0;
+    unsigned long rank = (unsigned long)ceil(q * s->count), seen = 0;
+    if (rank < 1) rank = 1;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        seen += s->buckets[b];
+        if (seen >= rank) {
+            double ms = pow(LAT_STEP, b) / 1000.0;
+            return ms < s->max_ms ? ms : s->max_ms;
+        }
+    }
+    return s->max_ms;
+}
+
+static void report_row(const char* name, const op_stats_t* s) {
+    double mean = s->count ? s->sum_ms / s->count : 0.0;
+    const char* fmt = opt.csv ? "%s,%lu,%lu,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"
+                              : "%-18s %9lu %7lu %9.1f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n";
+    printf(fmt, name, s->count, s->errors, s->count / opt.duration, mean, percentile(s, 0.5),
+           percentile(s, 0.9), percentile(s, 0.99), percentile(s, 0.999), s->max_ms);
+}
+
+static void report(worker_t* workers) {
+    static op_stats_t total, per_op[OP_COUNT];
+    for (int i = 0; i < opt.connections; i++)
+        for (int op = 0; op < OP_COUNT; op++) merge(&per_op[op], &workers[i].stats[op]);
+
+    if (opt.csv) {
+        printf("operation,requests,errors,rps,mean_ms,p50_ms,p90_ms,p99_ms,p999_ms,max_ms\n");
+    } else {
+        printf("# %s:%s%s, %d connections, ", opt.host, opt.port, opt.prefix, opt.connections);
+        if (opt.rate > 0) printf("open loop at %.1f req/s", opt.rate);
+        else printf("closed loop");
+        printf(", %.1f s after %.1f s warm-up\n", opt.duration, opt.warmup);
+        printf("%-18s %9s %7s %9s %9s %9s %9s %9s %9s %9s\n", "operation", "requests", "errors", "req/s",
+               "mean_ms", "p50_ms", "p90_ms", "p99_ms", "p999_ms", "max_ms");
+    }
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (!opt.mix[op]) continue;
+        report_row(OP_NAMES[op], &per_op[op]);
+        merge(&total, &per_op[op]);
+    }
+    report_row("all", &total);
+}
+
+//----------------------------------------------
+// Options
+//----------------------------------------------
+
+static int parse_url(const char* url) {
+    const char* p = url;
+    if (strncmp(p, "http://", 7) == 0) p += 7;
+    else if (strstr(p, "://")) return -1;
+    const char* slash = strchr(p, '/');
+    size_t hostport = slash ? (size_t)(slash - p) : strlen(p);
+    const char* colon = memchr(p, ':', hostport);
+    size_t host_len = colon ? (size_t)(colon - p) : hostport;
+    if (host_len == 0 || host_len >= sizeof(opt.host)) return -1;
+    memcpy(opt.host, p, host_len);
+    opt.host[host_len] = '\0';
+    if (colon) {
+        size_t port_len = hostport - host_len - 1;
+        if (port_len == 0 || port_len >= sizeof(opt.port)) return -1;
+        memcpy(opt.port, colon + 1, port_len);
+        opt.port[port_len] = '\0';
+    } else {
+        strcpy(opt.port, "80");
+    }
+    snprintf(opt.prefix, sizeof(opt.prefix), "%s", slash ? slash : "");
+    size_t n = strlen(opt.prefix);
+    if (n > 0 && opt.prefix[n - 1] == '/') opt.prefix[n - 1] = '\0';
+    return 0;
+}
+
+static int parse_mix(const char* spec) {
+    char* copy = strdup(spec);
+    int ok = 1;
+    memset(opt.mix, 0, sizeof(opt.mix));
+    for (char* item = strtok(copy, ","); item && ok; item = strtok(NULL, ",")) {
+        char* eq = strchr(item, '=');
+        ok = 0;
+        if (!eq) break;
+        *eq = '\0';
+        for (int op = 0; op < OP_COUNT; op++) {
+            if (strcmp(item, OP_NAMES[op]) == 0) {
+                opt.mix[op] = atoi(eq + 1);
+                ok = opt.mix[op] >= 0;
+            }
+        }
+    }
+    free(copy);
+    return ok ? 0 : -1;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: loadgen [-u url] [-c connections] [-d seconds] [-w seconds] [-r rate]\n"
+            "               [-m op=weight,...] [-k keys] [-a addresses] [-s signatures]\n"
+            "               [-p param_file] [-S seed] [-C]\n"
+            "Operations: addrgen recognize_addr dskgen sign verify_signature trace\n");
+}
+
+int main(int argc, char** argv) {
+    int ch;
+    parse_url("http://127.0.0.1:5000");
+    opt.connections = 8;
+    opt.duration = 10;
+    opt.warmup = 2;
+    memcpy(opt.mix, DEFAULT_MIX, sizeof(opt.mix));
+    opt.keys = 8;
+    opt.addresses = 64;
+    opt.signatures = 32;
+    opt.seed = 1;
+
+    while ((ch = getopt(argc, argv, "u:c:d:w:r:m:k:a:s:p:S:Ch")) != -1) {
+        switch (ch) {
+        case 'u': if (parse_url(optarg) != 0) { fprintf(stderr, "loadgen: bad url %s\n", optarg); return 2; } break;
+        case 'c': opt.connections = atoi(optarg); break;
+        case 'd': opt.duration = atof(optarg); break;
+        case 'w': opt.warmup = atof(optarg); break;
+        case 'r': opt.rate = atof(optarg); break;
+        case 'm': if (parse_mix(optarg) != 0) { fprintf(stderr, "loadgen: bad mix %s\n", optarg); return 2; } break;
+        case 'k': opt.keys = atoi(optarg); break;
+        case 'a': opt.addresses = atoi(optarg); break;
+        case 's': opt.signatures = atoi(optarg); break;
+        case 'p': opt.param_file = optarg; break;
+        case 'S': opt.seed = strtoul(optarg, NULL, 10); break;
+        case 'C': opt.csv = 1; break;
+        default: usage(); return 2;
+        }
+    }
+    if (opt.connections < 1 || opt.duration <= 0 || opt.warmup < 0 || opt.rate < 0 ||
+        opt.keys < 1 || opt.addresses < 1 || opt.signatures < 1) {
+        usage();
+        return 2;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (setup() != 0) return 1;
+    for (int op = 0; op < OP_COUNT; op++) mix_total += opt.mix[op];
+    if (mix_total == 0) {
+        fprintf(stderr, "loadgen: nothing left in the mix\n");
+        return 1;
+    }
+    fprintf(stderr, "loadgen: %d keys, %d addresses, %d signatures ready\n",
+            opt.keys, address_count, signature_count);
+
+    worker_t* workers = calloc(opt.connections, sizeof(worker_t));
+    unsigned long long seeder = opt.seed;
+    schedule_rng = rng_next(&seeder);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    next_due = 0.0;
+    for (int i = 0; i < opt.connections; i++) {
+        workers[i].id = i;
+        workers[i].rng = rng_next(&seeder);
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "loadgen: cannot start connection %d\n", i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < opt.connections; i++) pthread_join(workers[i].thread, NULL);
+
+    report(workers);
+    free(workers);
+    free(addresses);
+    free(signatures);
+    return 0;
+}
@@ -0,0 +1,204 @@
+/****************************************************************************
+ * File: pairing_tune.c
+ * Desc: Pairing autotuning for the scheme cores, see pairing_tune.h
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include <pbc/pbc_fp.h>   // after pbc.h, which it requires
+#include "pairing_tune.h"
+#include "perf_timer.h"
+
+// Candidates; the first backend is PBC's default
+static const char* tune_fps[] = { "mont", "fast", "faster", "naive" };
+static const char* tune_methods[] = { "miller", "miller-affine", "shipsey-stange" };
+
+#define TUNE_COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+typedef struct {
+    int used;
+    uint64_t hash;
+    pairing_tune_t tune;
+} tune_entry_t;
+
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+static tune_entry_t tune_cache[PAIRING_TUNE_CACHE_SIZE];
+static int tune_next = 0;
+static int tune_on = 0;
+static char* tune_file = NULL;
+
+static uint64_t fnv1a(const char* data, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+int pairing_tune_enable(int on, const char* cache_file) {
+    char* path = NULL;
+    if (cache_file && !(path = strdup(cache_file))) return -1;
+    pthread_mutex_lock(&tune_lock);
+    free(tune_file);
+    tune_file = path;
+    tune_on = on != 0;
+    pthread_mutex_unlock(&tune_lock);
+    return 0;
+}
+
+int pairing_tune_enabled(void) {
+    return tune_on;
+}
+
+//----------------------------------------------
+// Caches (call with tune_lock held)
+//----------------------------------------------
+
+// Known names only, so a damaged file cannot select anything else
+static const char* tune_name(const char* s, const char** names, int n) {
+    for (int i = 0; i < n; i++) {
+        if (!strcmp(s, names[i])) return names[i];
+    }
+    return NULL;
+}
+
+static int cache_lookup(uint64_t hash, pairing_tune_t* tune) {
+    for (int i = 0; i < PAIRING_TUNE_CACHE_SIZE; i++) {
+        if (tune_cache[i].used && tune_cache[i].hash == hash) {
+            *tune = tune_cache[i].tune;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void cache_store(uint64_t hash, const pairing_tune_t* tune) {
+    tune_entry_t* e = &tune_cache[tune_next];
+    tune_next = (tune_next + 1) % PAIRING_TUNE_CACHE_SIZE;
+    e->used = 1;
+    e->hash = hash;
+    e->tune = *tune;
+}
+
+// One line per parameter set: hash in hex, backend, method
+static int file_lookup(uint64_t hash, pairing_tune_t* tune) {
+    FILE* fp = tune_file ? fopen(tune_file, "r") : NULL;
+    if (!fp) return 0;
+    unsigned long long h;
+    char fpname[32], method[32];
+    int found = 0;
+    while (!found && fscanf(fp, "%llx %31s %31s", &h, fpname, method) == 3) {
+        const char* f = tune_name(fpname, tune_fps, TUNE_COUNT(tune_fps));
+        const char* m = tune_name(method, tune_methods, TUNE_COUNT(tune_methods));
+        if (h != hash || !f || !m) continue;
+        strcpy(tune->fp, f);
+        strcpy(tune->method, m);
+        found = 1;
+    }
+    fclose(fp);
+    return found;
+}
+
+static void file_store(uint64_t hash, const pairing_tune_t* tune) {
+    FILE* fp = tune_file ? fopen(tune_file, "a") : NULL;
+    if (!fp) return;
+    fprintf(fp, "%016llx %s %s\n", (unsigned long long)hash, tune->fp, tune->method);
+    fclose(fp);
+}
+
+//----------------------------------------------
+// Measurement
+//----------------------------------------------
+
+/**
+ * Fastest round of the workload every scheme operation draws on: a
+ * pairing, a pairing against a precomputed table, exponentiations in G1
+ * and GT. Rounds stop once one takes twice the best time so far (limit,
+ * < 0 for none), as the candidate cannot win from there.
+ */
+static double tune_workload(pairing_t pairing, double limit) {
+    element_t P, Q, x, z;
+    pairing_pp_t pp;
+    element_init_G1(P, pairing);
+    element_init_G2(Q, pairing);
+    element_init_GT(x, pairing);
+    element_init_Zr(z, pairing);
+    element_random(P);
+    element_random(Q);
+    element_random(z);
+    pairing_pp_init(pp, P, pairing);
+
+    double best = -1;
+    for (int i = 0; i < PAIRING_TUNE_ROUNDS; i++) {
+        double t = perf_now_ms();
+        pairing_apply(x, P, Q, pairing);
+        pairing_pp_apply(x, Q, pp);
+        element_pow_zn(x, x, z);
+        element_pow_zn(Q, Q, z);
+        element_pow_zn(P, P, z);
+        t = perf_now_ms() - t;
+        if (best < 0 || t < best) best = t;
+        if (limit >= 0 && t > 2 * limit) break;
+    }
+
+    pairing_pp_clear(pp);
+    element_clear(P);
+    element_clear(Q);
+    element_clear(x);
+    element_clear(z);
+    return best;
+}
+
+static int tune_measure(pairing_tune_t* tune, const char* buf, size_t len) {
+    double best = -1;
+    for (int i = 0; i < TUNE_COUNT(tune_fps); i++) {
+        pairing_t pairing;
+        pbc_tweak_use_fp((char*)tune_fps[i]);
+        if (pairing_init_set_buf(pairing, buf, len)) break;
+        for (int j = 0; j < TUNE_COUNT(tune_methods); j++) {
+            pairing_option_set(pairing, "method", (char*)tune_methods[j]);
+            double t = tune_workload(pairing, best);
+            if (best < 0 || t < best) {
+                best = t;
+                strcpy(tune->fp, tune_fps[i]);
+                strcpy(tune->method, tune_methods[j]);
+            }
+        }
+        pairing_clear(pairing);
+    }
+    pbc_tweak_use_fp((char*)tune_fps[0]);
+    return best < 0 ? -1 : 0;
+}
+
+int pairing_tune_find(pairing_tune_t* tune, const char* buf, size_t len) {
+    uint64_t hash = fnv1a(buf, len);
+    int rc = 0;
+    pthread_mutex_lock(&tune_lock);
+    if (!cache_lookup(hash, tune)) {
+        if (file_lookup(hash, tune)) {
+            cache_store(hash, tune);
+        } else if ((rc = tune_measure(tune, buf, len)) == 0) {
+            cache_store(hash, tune);
+            file_store(hash, tune);
+        }
+    }
+    pthread_mutex_unlock(&tune_lock);
+    return rc;
+}
+
+int pairing_init_tuned(pairing_t pairing, const char* buf, size_t len, pairing_tune_t* tune) {
+    pairing_tune_t t = { "", "" };
+    int tuned = tune_on && pairing_tune_find(&t, buf, len) == 0;
+    if (tuned) pbc_tweak_use_fp(t.fp);
+    int rc = pairing_init_set_buf(pairing, buf, len);
+    if (tuned) {
+        pbc_tweak_use_fp((char*)tune_fps[0]);
+        if (!rc) pairing_option_set(pairing, "method", t.method);
+    }
+    if (!rc && tune) *tune = t;
+    return rc;
+}
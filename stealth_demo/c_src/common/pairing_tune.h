@@ -0,0 +1,64 @@
+/****************************************************************************
+ * File: pairing_tune.h
+ * Desc: Pairing autotuning for the scheme cores
+ *       Times every Fp backend and pairing method on the host against a
+ *       scheme-shaped workload and initializes pairings with the fastest;
+ *       results are kept per parameter set in memory and, optionally, in a
+ *       cache file shared by later processes
+ ****************************************************************************/
+
+#ifndef PAIRING_TUNE_H
+#define PAIRING_TUNE_H
+
+#include <stddef.h>
+#include <pbc/pbc.h>
+
+// Parameter sets whose results stay in memory
+#define PAIRING_TUNE_CACHE_SIZE 8
+
+// Timed rounds per candidate; the fastest round counts
+#define PAIRING_TUNE_ROUNDS 3
+
+typedef struct {
+    char fp[8];          // pbc_tweak_use_fp name: "mont", "fast", "faster", "naive"
+    char method[16];     // pairing_option_set "method" value
+} pairing_tune_t;
+
+/**
+ * Turn autotuning on or off for the pairings initialized from now on
+ * @param on Nonzero to tune
+ * @param cache_file Results of earlier processes, appended to with new
+ *        ones; NULL keeps them in memory only
+ * @return 0 on success, -1 if out of memory
+ */
+int pairing_tune_enable(int on, const char* cache_file);
+
+/**
+ * Whether autotuning is on
+ */
+int pairing_tune_enabled(void);
+
+/**
+ * Fastest configuration of a parameter set, from the caches or measured
+ * (each backend parses the parameters once, each method runs the workload
+ * PAIRING_TUNE_ROUNDS times)
+ * @param tune Configuration (output)
+ * @param buf Parameter file contents
+ * @param len Length of buf
+ * @return 0 on success, -1 if the parameters do not parse
+ */
+int pairing_tune_find(pairing_tune_t* tune, const char* buf, size_t len);
+
+/**
+ * pairing_init_set_buf, under the fastest configuration when autotuning
+ * is on. The default Fp backend is restored afterwards.
+ * @param pairing Pairing to initialize
+ * @param buf Parameter file contents
+ * @param len Length of buf
+ * @param tune Configuration used (output, may be NULL); fp and method are
+ *        empty when autotuning is off
+ * @return 0 on success, nonzero as pairing_init_set_buf
+ */
+int pairing_init_tuned(pairing_t pairing, const char* buf, size_t len, pairing_tune_t* tune);
+
+#endif /* PAIRING_TUNE_H */
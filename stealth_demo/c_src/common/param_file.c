@@ -0,0 +1,157 @@
+/****************************************************************************
+ * File: param_file.c
+ * Desc: Memory-mapped pairing parameter files, see param_file.h
+ ****************************************************************************/
+
+#define _GNU_SOURCE             // st_mtim, O_CLOEXEC
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "param_file.h"
+
+static param_file_t files[PARAM_FILE_CACHE_SIZE];
+static unsigned long clock_ = 0;
+static unsigned long hits = 0, loads = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t fnv1a(const char* data, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void entry_release(param_file_t* f) {
+    if (!f->path) return;
+    if (f->mapped) munmap((void*)f->data, f->len);
+    else free((void*)f->data);
+    free(f->path);
+    memset(f, 0, sizeof(*f));
+}
+
+static int same_file(const param_file_t* f, const struct stat* st) {
+    return f->mapped && f->dev == st->st_dev && f->ino == st->st_ino && f->size == st->st_size &&
+           f->mtime.tv_sec == st->st_mtim.tv_sec && f->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+// Whole stream into a malloc'd buffer, for what mmap refuses
+static char* read_all(int fd, size_t* len) {
+    size_t cap = 4096, n = 0;
+    char* buf = malloc(cap);
+    while (buf) {
+        ssize_t got = read(fd, buf + n, cap - n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            free(buf);
+            return NULL;
+        }
+        if (got == 0) break;
+        n += got;
+        if (n == cap) {
+            char* grown = realloc(buf, cap *= 2);
+            if (!grown) free(buf);
+            buf = grown;
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+// Fill f from the open file, mapped when it is a regular file
+static int entry_load(param_file_t* f, int fd, const struct stat* st) {
+    if (S_ISREG(st->st_mode) && st->st_size > 0) {
+        void* p = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            f->data = p;
+            f->len = st->st_size;
+            f->mapped = 1;
+        }
+    }
+    if (!f->mapped) {
+        size_t len;
+        char* buf = read_all(fd, &len);
+        if (!buf) return -1;
+        f->data = buf;
+        f->len = len;
+    }
+    f->dev = st->st_dev;
+    f->ino = st->st_ino;
+    f->size = st->st_size;
+    f->mtime = st->st_mtim;
+    f->hash = fnv1a(f->data, f->len);
+    return 0;
+}
+
+const param_file_t* param_file_get(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open parameter file %s\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Error: Cannot stat parameter file %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lock);
+    param_file_t* victim = &files[0];
+    for (int i = 0; i < PARAM_FILE_CACHE_SIZE; i++) {
+        param_file_t* f = &files[i];
+        if (f->path && strcmp(f->path, path) == 0) {
+            if (same_file(f, &st)) {
+                f->last_used = ++clock_;
+                hits++;
+                pthread_mutex_unlock(&lock);
+                close(fd);
+                return f;
+            }
+            victim = f;
+            break;
+        }
+        if (victim->path && (!f->path || f->last_used < victim->last_used)) victim = f;
+    }
+
+    entry_release(victim);
+    param_file_t* f = NULL;
+    if (entry_load(victim, fd, &st) != 0) {
+        fprintf(stderr, "Error: Cannot read parameter file %s\n", path);
+    } else if (victim->len == 0) {
+        fprintf(stderr, "Error: Empty parameter file %s\n", path);
+    } else if ((victim->path = strdup(path)) != NULL) {
+        victim->last_used = ++clock_;
+        loads++;
+        f = victim;
+    }
+    if (!f && victim->data) {
+        // Not an entry yet: release by hand
+        if (victim->mapped) munmap((void*)victim->data, victim->len);
+        else free((void*)victim->data);
+        memset(victim, 0, sizeof(*victim));
+    }
+    pthread_mutex_unlock(&lock);
+    close(fd);
+    return f;
+}
+
+void param_file_drop(void) {
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < PARAM_FILE_CACHE_SIZE; i++) entry_release(&files[i]);
+    pthread_mutex_unlock(&lock);
+}
+
+void param_file_stats(unsigned long* hits_out, unsigned long* loads_out) {
+    pthread_mutex_lock(&lock);
+    if (hits_out) *hits_out = hits;
+    if (loads_out) *loads_out = loads;
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,55 @@
+/****************************************************************************
+ * File: param_file.h
+ * Desc: Memory-mapped pairing parameter files for the scheme cores
+ *       Maps a parameter file (text, or binary from PBC's parambin)
+ *       read-only and shared, whole whatever its size, and keeps the
+ *       mapping and the hash of its contents until the file changes on
+ *       disk. Workers forked after a load share its pages; the cores key
+ *       their parsed pairings by the hash, so a file is parsed once.
+ *       Files that cannot be mapped, such as pipes, are read into memory.
+ ****************************************************************************/
+
+#ifndef PARAM_FILE_H
+#define PARAM_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+// Files kept mapped at once
+#define PARAM_FILE_CACHE_SIZE 8
+
+typedef struct {
+    char* path;                  // NULL while the entry is free
+    const char* data;            // contents, not NUL-terminated
+    size_t len;
+    uint64_t hash;               // FNV-1a of data
+    int mapped;                  // data is a mapping, else malloc'd
+    dev_t dev;                   // identity of the file when loaded
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    unsigned long last_used;
+} param_file_t;
+
+/**
+ * The contents of path, from the cache if the file is unchanged since it
+ * was mapped, else mapped afresh in place of the least recently used entry
+ * @return the entry, valid until a later param_file_get evicts or reloads
+ *         it or param_file_drop; NULL if the file is missing or empty
+ *         (with a message on stderr)
+ */
+const param_file_t* param_file_get(const char* path);
+
+/**
+ * Unmap every file
+ */
+void param_file_drop(void);
+
+/**
+ * param_file_get lookups served from the cache and files loaded
+ */
+void param_file_stats(unsigned long* hits, unsigned long* loads);
+
+#endif /* PARAM_FILE_H */
@@ -0,0 +1,425 @@
+/****************************************************************************
+ * File: pbc_native.c
+ * Desc: CPython extension _pbc_native: direct calls into a scheme library
+ *       The ctypes wrappers convert every argument through its argtypes
+ *       on each call. This module binds a function of a library the
+ *       wrapper already loaded, by its dlopen handle, so both share the
+ *       library and its state, and calls it with the bytes of its
+ *       arguments as they are: bytes objects pass their NUL-terminated
+ *       storage, other buffer-protocol objects their contiguous memory,
+ *       None passes NULL. The GIL is released for the call.
+ *
+ *       Functions returning int, of up to PBC_NATIVE_MAX_ARGS arguments
+ *       given as a signature, one letter per argument:
+ *         p  const pointer: bytes, a read-only or writable buffer, None
+ *         w  pointer written to: a writable buffer, None
+ *         i  int
+ *       A count n stands for n p's. Only the prototypes in the callers
+ *       table below can be bound. The checks of argument lengths stay
+ *       with the library and the wrapper, as with ctypes.
+ *
+ *   import _pbc_native
+ *   verify = _pbc_native.bind(lib._handle, "stealth_verify_simple", 6)
+ *   ok = verify(addr, r2, c, msg, h, q_sigma)
+ *   scan = _pbc_native.bind(lib._handle, "stealth_addr_recognize_fast_batch", "ppippw")
+ *   scan(r1s, cs, n, B, a, results)
+ *
+ *       bind_hex binds the hex codec of a library, <prefix>_to_hex_simple
+ *       and <prefix>_from_hex_simple, to convert whole element lists:
+ *       each string is written in place into its str object, and hex
+ *       strings are read without joining or copying them.
+ *
+ *   codec = _pbc_native.bind_hex(lib._handle, "stealth")
+ *   hexes = codec.encode(packed, size, empty_if_zero)
+ *   packed = codec.decode(hexes, size)
+ ****************************************************************************/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <dlfcn.h>
+
+#define PBC_NATIVE_MAX_ARGS 9
+
+typedef union {
+    const void* p;
+    int i;
+} native_arg_t;
+
+typedef int (*native_caller_t)(void* fn, const native_arg_t* a);
+
+#define P(k) a[k].p
+#define I(k) a[k].i
+typedef const void* ptr_t;
+
+static int call_0(void* fn, const native_arg_t* a) {
+    (void)a;
+    return ((int (*)(void))fn)();
+}
+static int call_1(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t))fn)(P(0));
+}
+static int call_2(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t))fn)(P(0), P(1));
+}
+static int call_3(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2));
+}
+static int call_4(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3));
+}
+static int call_5(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3), P(4));
+}
+static int call_6(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3), P(4), P(5));
+}
+static int call_7(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3),
+                                                                          P(4), P(5), P(6));
+}
+static int call_8(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3),
+                                                                                 P(4), P(5), P(6), P(7));
+}
+
+// The packed batch functions: elements, count, keys, outputs
+static int call_ppippp(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, int, ptr_t, ptr_t, ptr_t))fn)(P(0), P(1), I(2), P(3), P(4), P(5));
+}
+static int call_ppppipp(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, int, ptr_t, ptr_t))fn)(P(0), P(1), P(2), P(3),
+                                                                        I(4), P(5), P(6));
+}
+static int call_pppippip(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, int, ptr_t, ptr_t, int, ptr_t))fn)(P(0), P(1), P(2), I(3),
+                                                                             P(4), P(5), I(6), P(7));
+}
+static int call_pppppppip(void* fn, const native_arg_t* a) {
+    return ((int (*)(ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, ptr_t, int, ptr_t))fn)(
+        P(0), P(1), P(2), P(3), P(4), P(5), P(6), I(7), P(8));
+}
+
+#undef P
+#undef I
+
+// By signature, w written as p
+static const struct {
+    const char* sig;
+    native_caller_t call;
+} callers[] = {
+    { "", call_0 }, { "p", call_1 }, { "pp", call_2 }, { "ppp", call_3 }, { "pppp", call_4 },
+    { "ppppp", call_5 }, { "pppppp", call_6 }, { "ppppppp", call_7 }, { "pppppppp", call_8 },
+    { "ppippp", call_ppippp }, { "ppppipp", call_ppppipp }, { "pppippip", call_pppippip },
+    { "pppppppip", call_pppppppip },
+};
+
+typedef struct {
+    PyObject_HEAD
+    void* fn;
+    native_caller_t call;
+    int nargs;
+    char sig[PBC_NATIVE_MAX_ARGS + 1];
+    PyObject* name;
+} native_fn_t;
+
+static PyObject* native_fn_call(PyObject* self, PyObject* args, PyObject* kwargs) {
+    native_fn_t* f = (native_fn_t*)self;
+    if (kwargs && PyDict_GET_SIZE(kwargs) > 0) {
+        PyErr_SetString(PyExc_TypeError, "keyword arguments are not supported");
+        return NULL;
+    }
+    Py_ssize_t n = PyTuple_GET_SIZE(args);
+    if (n != f->nargs) {
+        PyErr_Format(PyExc_TypeError, "%U takes %d arguments (%zd given)", f->name, f->nargs, n);
+        return NULL;
+    }
+
+    native_arg_t arg[PBC_NATIVE_MAX_ARGS] = { { 0 } };
+    Py_buffer view[PBC_NATIVE_MAX_ARGS];
+    int held[PBC_NATIVE_MAX_ARGS] = { 0 };
+    int ok = 1;
+    for (Py_ssize_t i = 0; i < n && ok; i++) {
+        PyObject* obj = PyTuple_GET_ITEM(args, i);
+        char kind = f->sig[i];
+        if (kind == 'i') {
+            long v = PyLong_AsLong(obj);
+            if (v == -1 && PyErr_Occurred()) {
+                ok = 0;
+            } else if (v < INT_MIN || v > INT_MAX) {
+                PyErr_SetString(PyExc_OverflowError, "int argument out of range");
+                ok = 0;
+            }
+            arg[i].i = (int)v;
+        } else if (obj == Py_None) {
+            arg[i].p = NULL;
+        } else if (kind == 'p' && PyBytes_Check(obj)) {
+            // Immutable and owned by the argument tuple for the whole call
+            arg[i].p = PyBytes_AS_STRING(obj);
+        } else if (PyObject_GetBuffer(obj, &view[i],
+                                      kind == 'w' ? PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE
+                                                  : PyBUF_C_CONTIGUOUS) == 0) {
+            held[i] = 1;
+            arg[i].p = view[i].buf;
+        } else {
+            ok = 0;
+        }
+    }
+
+    int rc = 0;
+    if (ok) {
+        Py_BEGIN_ALLOW_THREADS
+        rc = f->call(f->fn, arg);
+        Py_END_ALLOW_THREADS
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (held[i]) PyBuffer_Release(&view[i]);
+    }
+    return ok ? PyLong_FromLong(rc) : NULL;
+}
+
+static void native_fn_dealloc(PyObject* self) {
+    Py_XDECREF(((native_fn_t*)self)->name);
+    Py_TYPE(self)->tp_free(self);
+}
+
+static PyObject* native_fn_repr(PyObject* self) {
+    native_fn_t* f = (native_fn_t*)self;
+    return PyUnicode_FromFormat("<native %U(%s)>", f->name, f->sig);
+}
+
+static PyTypeObject native_fn_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_pbc_native.Function",
+    .tp_basicsize = sizeof(native_fn_t),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "int function of a scheme library taking pointer arguments",
+    .tp_call = native_fn_call,
+    .tp_dealloc = native_fn_dealloc,
+    .tp_repr = native_fn_repr,
+};
+
+// The caller of a signature of p, w and i, NULL if none fits
+static native_caller_t find_caller(const char* sig) {
+    char key[PBC_NATIVE_MAX_ARGS + 1];
+    size_t len = strlen(sig);
+    if (len > PBC_NATIVE_MAX_ARGS) return NULL;
+    for (size_t i = 0; i <= len; i++) {
+        if (sig[i] && !strchr("pwi", sig[i])) return NULL;
+        key[i] = sig[i] == 'w' ? 'p' : sig[i];
+    }
+    for (size_t i = 0; i < sizeof(callers) / sizeof(callers[0]); i++) {
+        if (strcmp(callers[i].sig, key) == 0) return callers[i].call;
+    }
+    return NULL;
+}
+
+static PyObject* native_bind(PyObject* module, PyObject* args) {
+    (void)module;
+    unsigned long long handle;
+    PyObject* name;
+    PyObject* spec;
+    if (!PyArg_ParseTuple(args, "KUO", &handle, &name, &spec)) return NULL;
+
+    char sig[PBC_NATIVE_MAX_ARGS + 1];
+    if (PyLong_Check(spec)) {
+        long nargs = PyLong_AsLong(spec);
+        if (nargs < 0 || nargs > PBC_NATIVE_MAX_ARGS) {
+            if (!PyErr_Occurred()) PyErr_Format(PyExc_ValueError, "at most %d arguments", PBC_NATIVE_MAX_ARGS);
+            return NULL;
+        }
+        memset(sig, 'p', nargs);
+        sig[nargs] = '\0';
+    } else if (PyUnicode_Check(spec)) {
+        Py_ssize_t len;
+        const char* s = PyUnicode_AsUTF8AndSize(spec, &len);
+        if (!s) return NULL;
+        if (len > PBC_NATIVE_MAX_ARGS) {
+            PyErr_Format(PyExc_ValueError, "at most %d arguments", PBC_NATIVE_MAX_ARGS);
+            return NULL;
+        }
+        memcpy(sig, s, len + 1);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "signature must be an argument count or a string of p, w and i");
+        return NULL;
+    }
+    native_caller_t call = find_caller(sig);
+    if (!call) {
+        PyErr_Format(PyExc_ValueError, "unsupported signature '%s'", sig);
+        return NULL;
+    }
+
+    const char* symbol = PyUnicode_AsUTF8(name);
+    if (!symbol) return NULL;
+
+    dlerror();
+    void* fn = dlsym((void*)(uintptr_t)handle, symbol);
+    if (!fn) {
+        const char* err = dlerror();
+        PyErr_Format(PyExc_AttributeError, "%s", err ? err : symbol);
+        return NULL;
+    }
+
+    native_fn_t* f = PyObject_New(native_fn_t, &native_fn_type);
+    if (!f) return NULL;
+    f->fn = fn;
+    f->call = call;
+    f->nargs = (int)strlen(sig);
+    memcpy(f->sig, sig, sizeof(sig));
+    Py_INCREF(name);
+    f->name = name;
+    return (PyObject*)f;
+}
+
+typedef int (*to_hex_fn_t)(const unsigned char* in, int n, char* out);
+typedef long (*from_hex_fn_t)(const char* hex, long len, unsigned char* out, int buf_size);
+
+typedef struct {
+    PyObject_HEAD
+    to_hex_fn_t to_hex;
+    from_hex_fn_t from_hex;
+} native_hex_t;
+
+static int check_element_size(Py_ssize_t size) {
+    if (size > 0 && size <= INT_MAX / 2) return 0;
+    PyErr_SetString(PyExc_ValueError, "element size out of range");
+    return -1;
+}
+
+static PyObject* native_hex_encode(PyObject* self, PyObject* args) {
+    native_hex_t* h = (native_hex_t*)self;
+    Py_buffer in;
+    Py_ssize_t size;
+    int empty_if_zero = 0;
+    if (!PyArg_ParseTuple(args, "y*n|p", &in, &size, &empty_if_zero)) return NULL;
+    if (check_element_size(size) < 0 || in.len % size) {
+        if (!PyErr_Occurred()) PyErr_SetString(PyExc_ValueError, "not a whole number of elements");
+        PyBuffer_Release(&in);
+        return NULL;
+    }
+    Py_ssize_t n = in.len / size;
+    PyObject* list = PyList_New(n);
+    for (Py_ssize_t i = 0; list && i < n; i++) {
+        // A compact ASCII str keeps room for the NUL that to_hex appends
+        PyObject* s = PyUnicode_New(2 * size, 127);
+        if (s && h->to_hex((const unsigned char*)in.buf + i * size, (int)size,
+                           (char*)PyUnicode_1BYTE_DATA(s)) && empty_if_zero) {
+            Py_DECREF(s);
+            s = PyUnicode_New(0, 0);
+        }
+        if (!s) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, s);
+    }
+    PyBuffer_Release(&in);
+    return list;
+}
+
+static PyObject* native_hex_decode(PyObject* self, PyObject* args) {
+    native_hex_t* h = (native_hex_t*)self;
+    PyObject* seq;
+    Py_ssize_t size;
+    if (!PyArg_ParseTuple(args, "On", &seq, &size)) return NULL;
+    if (check_element_size(size) < 0) return NULL;
+    PyObject* items = PySequence_Fast(seq, "hex strings must be a sequence");
+    if (!items) return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(items);
+    PyObject* out = n <= PY_SSIZE_T_MAX / size ? PyBytes_FromStringAndSize(NULL, n * size)
+                                               : PyErr_NoMemory();
+    for (Py_ssize_t i = 0; out && i < n; i++) {
+        PyObject* item = PySequence_Fast_GET_ITEM(items, i);
+        unsigned char* row = (unsigned char*)PyBytes_AS_STRING(out) + i * size;
+        Py_ssize_t len;
+        const char* s = PyUnicode_Check(item) ? PyUnicode_AsUTF8AndSize(item, &len) : NULL;
+        long got = s && len > 0 ? h->from_hex(s, (long)len, row, (int)size) : -1;
+        if (got < 0) {
+            if (!PyErr_Occurred()) {
+                if (!PyUnicode_Check(item)) {
+                    PyErr_Format(PyExc_TypeError, "hex string expected, got %s", Py_TYPE(item)->tp_name);
+                } else if (len == 0) {
+                    PyErr_SetString(PyExc_ValueError, "Empty hex string");
+                } else {
+                    PyErr_Format(PyExc_ValueError, "Invalid hex string '%U'", item);
+                }
+            }
+            Py_CLEAR(out);
+            break;
+        }
+        if (got < size) memset(row + got, 0, size - got);
+    }
+    Py_DECREF(items);
+    return out;
+}
+
+static PyMethodDef native_hex_methods[] = {
+    { "encode", native_hex_encode, METH_VARARGS,
+      "encode(packed, size, empty_if_zero=False) -> list of str\n"
+      "Hex of each size-byte element of packed; \"\" for all-zero ones if empty_if_zero." },
+    { "decode", native_hex_decode, METH_VARARGS,
+      "decode(hex_strings, size) -> bytes\n"
+      "The elements end to end, each zero padded to size; an odd length takes a leading 0." },
+    { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject native_hex_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_pbc_native.HexCodec",
+    .tp_basicsize = sizeof(native_hex_t),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "hex codec of a scheme library for element lists",
+    .tp_methods = native_hex_methods,
+};
+
+static PyObject* native_bind_hex(PyObject* module, PyObject* args) {
+    (void)module;
+    unsigned long long handle;
+    const char* prefix;
+    if (!PyArg_ParseTuple(args, "Ks", &handle, &prefix)) return NULL;
+
+    char to_name[64], from_name[64];
+    if (snprintf(to_name, sizeof(to_name), "%s_to_hex_simple", prefix) >= (int)sizeof(to_name) ||
+        snprintf(from_name, sizeof(from_name), "%s_from_hex_simple", prefix) >= (int)sizeof(from_name)) {
+        PyErr_SetString(PyExc_ValueError, "prefix too long");
+        return NULL;
+    }
+    void* to_hex = dlsym((void*)(uintptr_t)handle, to_name);
+    void* from_hex = dlsym((void*)(uintptr_t)handle, from_name);
+    if (!to_hex || !from_hex) {
+        PyErr_Format(PyExc_AttributeError, "%s", to_hex ? from_name : to_name);
+        return NULL;
+    }
+
+    native_hex_t* h = PyObject_New(native_hex_t, &native_hex_type);
+    if (!h) return NULL;
+    h->to_hex = (to_hex_fn_t)to_hex;
+    h->from_hex = (from_hex_fn_t)from_hex;
+    return (PyObject*)h;
+}
+
+static PyMethodDef native_methods[] = {
+    { "bind", native_bind, METH_VARARGS,
+      "bind(handle, name, signature) -> Function\n"
+      "Bind int name(...) of the library loaded as handle (CDLL._handle); signature is\n"
+      "an argument count of pointers or a string of p (pointer), w (written) and i (int)." },
+    { "bind_hex", native_bind_hex, METH_VARARGS,
+      "bind_hex(handle, prefix) -> HexCodec\n"
+      "Bind the hex codec <prefix>_to_hex_simple / <prefix>_from_hex_simple of the library." },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef native_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "_pbc_native",
+    .m_doc = "Direct calls into the scheme libraries, without ctypes conversion",
+    .m_size = -1,
+    .m_methods = native_methods,
+};
+
+PyMODINIT_FUNC PyInit__pbc_native(void) {
+    if (PyType_Ready(&native_fn_type) < 0 || PyType_Ready(&native_hex_type) < 0) return NULL;
+    return PyModule_Create(&native_module);
+}
@@ -0,0 +1,197 @@
+/****************************************************************************
+ * File: perf_counters.c
+ * Desc: Hardware counters for the per-primitive instrumentation, see
+ *       perf_counters.h
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "perf_counters.h"
+
+// Counters read from perf_event, the ones before HWC_ALLOCS
+#define HWC_EVENTS HWC_ALLOCS
+
+static const char* hwc_names[HWC_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "allocs"
+};
+
+// Open group of a thread: the members that opened, in group read order
+typedef struct {
+    int leader;
+    int fd[HWC_EVENTS];
+    int order[HWC_EVENTS];
+    int members;
+} hwc_group_t;
+
+static int hwc_on;
+static pthread_mutex_t hwc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t hwc_once = PTHREAD_ONCE_INIT;
+static pthread_key_t hwc_key;
+static __thread hwc_group_t* tls_group;
+static __thread unsigned long tls_allocs;
+
+const char* hwc_name(int kind) {
+    return (kind >= 0 && kind < HWC_COUNT) ? hwc_names[kind] : NULL;
+}
+
+//----------------------------------------------
+// Allocation count, over the allocators installed before it
+//----------------------------------------------
+static int allocs_installed;
+static void* (*prev_malloc)(size_t);
+static void* (*prev_realloc)(void*, size_t);
+static void (*prev_free)(void*);
+static void* (*prev_gmp_malloc)(size_t);
+static void* (*prev_gmp_realloc)(void*, size_t, size_t);
+static void (*prev_gmp_free)(void*, size_t);
+
+static void* count_malloc(size_t size) {
+    tls_allocs++;
+    return prev_malloc(size);
+}
+
+static void* count_realloc(void* p, size_t size) {
+    tls_allocs++;
+    return prev_realloc(p, size);
+}
+
+static void count_free(void* p) {
+    prev_free(p);
+}
+
+static void* count_gmp_malloc(size_t size) {
+    tls_allocs++;
+    return prev_gmp_malloc(size);
+}
+
+static void* count_gmp_realloc(void* p, size_t old_size, size_t new_size) {
+    tls_allocs++;
+    return prev_gmp_realloc(p, old_size, new_size);
+}
+
+static void count_gmp_free(void* p, size_t size) {
+    prev_gmp_free(p, size);
+}
+
+static void install_alloc_count(void) {
+    if (allocs_installed) return;
+    prev_malloc = pbc_malloc;
+    prev_realloc = pbc_realloc;
+    prev_free = pbc_free;
+    mp_get_memory_functions(&prev_gmp_malloc, &prev_gmp_realloc, &prev_gmp_free);
+    pbc_set_memory_functions(count_malloc, count_realloc, count_free);
+    mp_set_memory_functions(count_gmp_malloc, count_gmp_realloc, count_gmp_free);
+    allocs_installed = 1;
+}
+
+//----------------------------------------------
+// perf_event group of a thread
+//----------------------------------------------
+static void group_close(void* arg) {
+    hwc_group_t* g = (hwc_group_t*)arg;
+#ifdef __linux__
+    // Members first, the leader last
+    for (int i = g->members - 1; i >= 0; i--) close(g->fd[g->order[i]]);
+#endif
+    free(g);
+}
+
+static void key_init(void) {
+    pthread_key_create(&hwc_key, group_close);
+}
+
+#ifdef __linux__
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} hwc_events[HWC_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+static int event_open(int kind, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = hwc_events[kind].type;
+    attr.config = hwc_events[kind].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC);
+}
+#endif
+
+// The first event that opens leads the group; events that do not open are left out
+static hwc_group_t* thread_group(void) {
+    if (tls_group) return tls_group;
+
+    hwc_group_t* g = malloc(sizeof(hwc_group_t));
+    if (!g) return NULL;
+    g->leader = -1;
+    g->members = 0;
+    for (int i = 0; i < HWC_EVENTS; i++) {
+        g->fd[i] = -1;
+#ifdef __linux__
+        g->fd[i] = event_open(i, g->leader);
+        if (g->fd[i] < 0) continue;
+        if (g->leader < 0) g->leader = g->fd[i];
+        g->order[g->members++] = i;
+#endif
+    }
+
+    pthread_once(&hwc_once, key_init);
+    pthread_setspecific(hwc_key, g);
+    tls_group = g;
+    return g;
+}
+
+int hwc_set_enabled(int enabled) {
+    if (!enabled) {
+        __atomic_store_n(&hwc_on, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+    pthread_mutex_lock(&hwc_lock);
+    install_alloc_count();
+    pthread_mutex_unlock(&hwc_lock);
+    __atomic_store_n(&hwc_on, 1, __ATOMIC_RELEASE);
+
+    int mask = 1 << HWC_ALLOCS;
+    hwc_group_t* g = thread_group();
+    for (int i = 0; g && i < g->members; i++) mask |= 1 << g->order[i];
+    return mask;
+}
+
+int hwc_enabled(void) {
+    return __atomic_load_n(&hwc_on, __ATOMIC_ACQUIRE);
+}
+
+void hwc_read(hwc_sample_t* s) {
+    memset(s, 0, sizeof(*s));
+    s->v[HWC_ALLOCS] = (double)tls_allocs;
+
+    hwc_group_t* g = thread_group();
+    if (!g || g->members == 0) return;
+#ifdef __linux__
+    // nr, time enabled, time running, then one value per member
+    uint64_t buf[3 + HWC_EVENTS];
+    ssize_t want = (ssize_t)((3 + g->members) * sizeof(uint64_t));
+    if (read(g->leader, buf, sizeof(buf)) < want || buf[2] == 0) return;
+    double scale = (double)buf[1] / (double)buf[2];
+    for (int i = 0; i < g->members; i++) s->v[g->order[i]] = (double)buf[3 + i] * scale;
+#endif
+}
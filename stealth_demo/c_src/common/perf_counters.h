@@ -0,0 +1,54 @@
+/****************************************************************************
+ * File: perf_counters.h
+ * Desc: Hardware counters for the per-primitive instrumentation
+ *       Linux perf_event counters of the calling thread (cycles,
+ *       instructions, L1D / LLC misses, branch misses), user space only,
+ *       read as one group, plus a per-thread count of PBC / GMP allocator
+ *       calls. Off until hwc_set_enabled; counters the kernel or the CPU
+ *       does not offer (e.g. in most VMs) read as 0
+ ****************************************************************************/
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+typedef enum {
+    HWC_CYCLES,
+    HWC_INSTRUCTIONS,
+    HWC_L1D_MISSES,     // L1 data cache read misses
+    HWC_LLC_MISSES,     // last level cache misses
+    HWC_BRANCH_MISSES,
+    HWC_ALLOCS,         // PBC and GMP malloc / realloc calls
+    HWC_COUNT
+} hwc_kind_t;
+
+// Running totals of a thread, scaled up when the kernel multiplexed the group
+typedef struct {
+    double v[HWC_COUNT];
+} hwc_sample_t;
+
+/**
+ * Metric label of a counter ("cycles", "instructions", ...), NULL if out of range
+ */
+const char* hwc_name(int kind);
+
+/**
+ * Switch counting on or off for every thread (call while no operation is
+ * running). The first switch on installs the allocation count over the
+ * PBC and GMP allocators in place, the pool included if it is installed.
+ * @return Mask of 1 << hwc_kind_t of the counters the calling thread
+ *         can read, 0 when switching off
+ */
+int hwc_set_enabled(int enabled);
+
+/**
+ * 1 if counting is on
+ */
+int hwc_enabled(void);
+
+/**
+ * Running totals of the calling thread; its counters are opened on its
+ * first read and closed when it exits
+ */
+void hwc_read(hwc_sample_t* s);
+
+#endif /* PERF_COUNTERS_H */
@@ -0,0 +1,256 @@
+/****************************************************************************
+ * File: perf_prim.c
+ * Desc: Per-primitive instrumentation for the scheme cores, see perf_prim.h
+ ****************************************************************************/
+
+#include "perf_prim.h"
+#include "perf_timer.h"
+
+static perf_set_t prim_stats = PERF_SET_INITIALIZER;
+// One set per counter, a slot per primitive
+static perf_set_t prim_hw[HWC_COUNT] = { [0 ... HWC_COUNT - 1] = PERF_SET_INITIALIZER };
+
+static const char* prim_names[PRIM_COUNT] = {
+    "pairing", "g1_pow", "gt_pow", "hash_zr", "hash_g1", "serialize"
+};
+
+const char* prim_name(int kind) {
+    return (kind >= 0 && kind < PRIM_COUNT) ? prim_names[kind] : NULL;
+}
+
+void prim_record(prim_kind_t kind, double ms) {
+    perf_add(&prim_stats, kind, ms);
+}
+
+void prim_begin(prim_mark_t* m) {
+    m->hw = hwc_enabled();
+    if (m->hw) hwc_read(&m->at);
+    m->ms = perf_now_ms();
+}
+
+void prim_cost_add(prim_cost_t* cost, const prim_mark_t* m) {
+    cost->ms += perf_now_ms() - m->ms;
+    if (!m->hw) return;
+    hwc_sample_t now;
+    hwc_read(&now);
+    for (int c = 0; c < HWC_COUNT; c++) cost->spent.v[c] += now.v[c] - m->at.v[c];
+    cost->hw = 1;
+}
+
+void prim_record_cost(prim_kind_t kind, const prim_cost_t* cost, int n) {
+    if (n <= 0) return;
+    for (int i = 0; i < n; i++) prim_record(kind, cost->ms / n);
+    if (!cost->hw) return;
+    for (int c = 0; c < HWC_COUNT; c++) {
+        for (int i = 0; i < n; i++) perf_add(&prim_hw[c], kind, cost->spent.v[c] / n);
+    }
+}
+
+void prim_end(prim_kind_t kind, const prim_mark_t* m) {
+    prim_cost_t cost = { 0 };
+    prim_cost_add(&cost, m);
+    prim_record_cost(kind, &cost, 1);
+}
+
+void prim_get_stats(prim_stats_t* stats) {
+    if (!stats) return;
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        stats->count[i] = perf_total_count(&prim_stats, i);
+        stats->total_ms[i] = perf_total_ms(&prim_stats, i);
+    }
+}
+
+void prim_get_hw_stats(prim_hw_stats_t* stats) {
+    if (!stats) return;
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        stats->count[i] = perf_total_count(&prim_hw[0], i);
+        for (int c = 0; c < HWC_COUNT; c++) stats->total[i][c] = perf_total_ms(&prim_hw[c], i);
+    }
+}
+
+void prim_reset_stats(void) {
+    perf_reset(&prim_stats);
+    for (int c = 0; c < HWC_COUNT; c++) perf_reset(&prim_hw[c]);
+}
+
+/**
+ * Kind of an exponentiation by the group of its result, -1 for Zr
+ */
+static int pow_kind(field_ptr f) {
+    pairing_ptr p = f->pairing;
+    if (!p) return -1;
+    if (f == p->GT) return PRIM_GT_POW;
+    if (f == p->G1 || f == p->G2) return PRIM_G1_POW;
+    return -1;
+}
+
+//----------------------------------------------
+// Instrumented PBC calls
+//----------------------------------------------
+void prim_pairing_apply(element_t out, element_t in1, element_t in2, pairing_t pairing) {
+    prim_mark_t m;
+    prim_begin(&m);
+    pairing_apply(out, in1, in2, pairing);
+    prim_end(PRIM_PAIRING, &m);
+}
+
+// Counts n pairings, each with an equal share of the cost
+void prim_pairing_apply_batch(element_t out[], element_t in1[], element_t in2[],
+                              int n, pairing_t pairing) {
+    prim_mark_t m;
+    prim_cost_t cost = { 0 };
+    prim_begin(&m);
+    pairing_apply_batch(out, in1, in2, n, pairing);
+    prim_cost_add(&cost, &m);
+    prim_record_cost(PRIM_PAIRING, &cost, n);
+}
+
+void prim_pairing_pp_apply(element_t out, element_t in, pairing_pp_t p) {
+    prim_mark_t m;
+    prim_begin(&m);
+    pairing_pp_apply(out, in, p);
+    prim_end(PRIM_PAIRING, &m);
+}
+
+// The final exponentiation left pending is not part of the recorded cost
+void prim_pairing_apply_unreduced(element_t out, element_t in1, element_t in2,
+                                  pairing_t pairing) {
+    prim_mark_t m;
+    prim_begin(&m);
+    pairing_apply_unreduced(out, in1, in2, pairing);
+    prim_end(PRIM_PAIRING, &m);
+}
+
+void prim_pairing_pp_apply_unreduced(element_t out, element_t in, pairing_pp_t p) {
+    prim_mark_t m;
+    prim_begin(&m);
+    pairing_pp_apply_unreduced(out, in, p);
+    prim_end(PRIM_PAIRING, &m);
+}
+
+// Counts n pairings sharing one final exponentiation, each an equal share
+void prim_prod_pairing(element_t out, element_t in1[], element_t in2[], int n) {
+    if (n <= 0) return;
+    prim_mark_t m;
+    prim_cost_t cost = { 0 };
+    prim_begin(&m);
+    element_prod_pairing(out, in1, in2, n);
+    prim_cost_add(&cost, &m);
+    prim_record_cost(PRIM_PAIRING, &cost, n);
+}
+
+void prim_pow_zn(element_t x, element_t a, element_t n) {
+    int kind = pow_kind(x->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pow_zn(x, a, n);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+void prim_pow_mpz(element_t x, element_t a, mpz_t n) {
+    int kind = pow_kind(x->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pow_mpz(x, a, n);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+// Each base is recorded as one exponentiation taking an equal share
+void prim_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m) {
+    if (m <= 0) return;
+    int kind = pow_kind(x[0]->field);
+    prim_mark_t mark;
+    prim_cost_t cost = { 0 };
+    prim_begin(&mark);
+    element_pow_mpz_same(x, a, n, m);
+    prim_cost_add(&cost, &mark);
+    if (kind >= 0) prim_record_cost(kind, &cost, m);
+}
+
+// Each base is recorded as one exponentiation taking an equal share
+void prim_pow_mpz_batch(element_t x[], element_t a[], mpz_t n[], int m) {
+    if (m <= 0) return;
+    int kind = pow_kind(x[0]->field);
+    prim_mark_t mark;
+    prim_cost_t cost = { 0 };
+    prim_begin(&mark);
+    element_pow_mpz_batch(x, a, n, m);
+    prim_cost_add(&cost, &mark);
+    if (kind >= 0) prim_record_cost(kind, &cost, m);
+}
+
+// One product of m powers, recorded as m exponentiations of equal share
+void prim_multi_pow_mpz(element_t x, element_t a[], mpz_t n[], int m) {
+    if (m <= 0) return;
+    int kind = pow_kind(x->field);
+    prim_mark_t mark;
+    prim_cost_t cost = { 0 };
+    prim_begin(&mark);
+    element_multi_pow_mpz(x, a, n, m);
+    prim_cost_add(&cost, &mark);
+    if (kind >= 0) prim_record_cost(kind, &cost, m);
+}
+
+void prim_pp_pow_zn(element_t out, element_t power, element_pp_t p) {
+    int kind = pow_kind(out->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pp_pow_zn(out, power, p);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+void prim_pp_pow(element_t out, mpz_t power, element_pp_t p) {
+    int kind = pow_kind(out->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pp_pow(out, power, p);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+void prim_pow_zn_ct(element_t x, element_t a, element_t n) {
+    int kind = pow_kind(x->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pow_zn_ct(x, a, n);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+void prim_pow_mpz_ct(element_t x, element_t a, mpz_t n) {
+    int kind = pow_kind(x->field);
+    prim_mark_t m;
+    prim_begin(&m);
+    element_pow_mpz_ct(x, a, n);
+    if (kind >= 0) prim_end(kind, &m);
+}
+
+int prim_to_bytes(unsigned char* data, element_t e) {
+    prim_mark_t m;
+    prim_begin(&m);
+    int n = element_to_bytes(data, e);
+    prim_end(PRIM_SERIALIZE, &m);
+    return n;
+}
+
+int prim_to_bytes_compressed(unsigned char* data, element_t e) {
+    prim_mark_t m;
+    prim_begin(&m);
+    int n = element_to_bytes_compressed(data, e);
+    prim_end(PRIM_SERIALIZE, &m);
+    return n;
+}
+
+int prim_from_bytes(element_t e, unsigned char* data) {
+    prim_mark_t m;
+    prim_begin(&m);
+    int n = element_from_bytes(e, data);
+    prim_end(PRIM_SERIALIZE, &m);
+    return n;
+}
+
+int prim_from_bytes_compressed(element_t e, unsigned char* data) {
+    prim_mark_t m;
+    prim_begin(&m);
+    int n = element_from_bytes_compressed(e, data);
+    prim_end(PRIM_SERIALIZE, &m);
+    return n;
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ * File: perf_prim.h
+ * Desc: Per-primitive instrumentation for the scheme cores
+ *       Counted and timed stand-ins for the PBC calls on the hot paths
+ *       (pairings, G1 / GT exponentiations, serialization) plus hashing,
+ *       accumulated per thread through perf_timer. While hardware counters
+ *       are on (perf_counters.h) each call also adds its counter deltas;
+ *       that takes two counter reads per call, so timings taken meanwhile
+ *       include them
+ ****************************************************************************/
+
+#ifndef PERF_PRIM_H
+#define PERF_PRIM_H
+
+#include <pbc/pbc.h>
+#include "perf_counters.h"
+
+typedef enum {
+    PRIM_PAIRING,       // pairing_apply, pairing_pp_apply
+    PRIM_G1_POW,        // exponentiation in G1 / G2, fixed-base included
+    PRIM_GT_POW,        // exponentiation in GT
+    PRIM_HASH_ZR,       // hash of a byte string onto Zr
+    PRIM_HASH_G1,       // hash of a byte string mapped onto G1
+    PRIM_SERIALIZE,     // element to / from bytes
+    PRIM_COUNT
+} prim_kind_t;
+
+typedef struct {
+    unsigned long count[PRIM_COUNT];
+    double total_ms[PRIM_COUNT];
+} prim_stats_t;
+
+// Counter totals of the calls made while hardware counters were on
+typedef struct {
+    unsigned long count[PRIM_COUNT];
+    double total[PRIM_COUNT][HWC_COUNT];
+} prim_hw_stats_t;
+
+// Start of a measured call
+typedef struct {
+    double ms;
+    int hw;                      // counters were on at the start
+    hwc_sample_t at;
+} prim_mark_t;
+
+// What calls spent, possibly summed over several intervals (a streamed hash)
+typedef struct {
+    double ms;
+    int hw;
+    hwc_sample_t spent;
+} prim_cost_t;
+
+/**
+ * Metric label of a primitive ("pairing", "g1_pow", ...), NULL if out of range
+ */
+const char* prim_name(int kind);
+
+/**
+ * Record one primitive call measured by the caller, time only
+ */
+void prim_record(prim_kind_t kind, double ms);
+
+/**
+ * Mark the start of a measured interval
+ */
+void prim_begin(prim_mark_t* m);
+
+/**
+ * Add what was spent since m to cost (zeroed by the caller first)
+ */
+void prim_cost_add(prim_cost_t* cost, const prim_mark_t* m);
+
+/**
+ * Record n primitive calls sharing cost equally
+ */
+void prim_record_cost(prim_kind_t kind, const prim_cost_t* cost, int n);
+
+/**
+ * Record one primitive call made since m (e.g. a hash)
+ */
+void prim_end(prim_kind_t kind, const prim_mark_t* m);
+
+/**
+ * Totals since load or the last prim_reset_stats, summed over threads
+ */
+void prim_get_stats(prim_stats_t* stats);
+
+/**
+ * Counter totals since load or the last prim_reset_stats, summed over threads
+ */
+void prim_get_hw_stats(prim_hw_stats_t* stats);
+
+/**
+ * Zero every primitive counter
+ */
+void prim_reset_stats(void);
+
+//----------------------------------------------
+// Instrumented PBC calls, same arguments as the originals
+// Exponentiations outside G1 / G2 / GT (Zr) are not recorded
+//----------------------------------------------
+void prim_pairing_apply(element_t out, element_t in1, element_t in2, pairing_t pairing);
+void prim_pairing_pp_apply(element_t out, element_t in, pairing_pp_t p);
+void prim_pairing_apply_batch(element_t out[], element_t in1[], element_t in2[],
+                              int n, pairing_t pairing);
+void prim_pairing_apply_unreduced(element_t out, element_t in1, element_t in2,
+                                  pairing_t pairing);
+void prim_pairing_pp_apply_unreduced(element_t out, element_t in, pairing_pp_t p);
+void prim_prod_pairing(element_t out, element_t in1[], element_t in2[], int n);
+void prim_pow_zn(element_t x, element_t a, element_t n);
+void prim_pow_mpz(element_t x, element_t a, mpz_t n);
+void prim_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m);
+void prim_pow_mpz_batch(element_t x[], element_t a[], mpz_t n[], int m);
+void prim_multi_pow_mpz(element_t x, element_t a[], mpz_t n[], int m);
+void prim_pp_pow_zn(element_t out, element_t power, element_pp_t p);
+void prim_pp_pow(element_t out, mpz_t power, element_pp_t p);
+void prim_pow_zn_ct(element_t x, element_t a, element_t n);
+void prim_pow_mpz_ct(element_t x, element_t a, mpz_t n);
+int prim_to_bytes(unsigned char* data, element_t e);
+int prim_to_bytes_compressed(unsigned char* data, element_t e);
+int prim_from_bytes(element_t e, unsigned char* data);
+int prim_from_bytes_compressed(element_t e, unsigned char* data);
+
+#endif /* PERF_PRIM_H */
@@ -0,0 +1,236 @@
+/****************************************************************************
+ * File: perf_timer.c
+ * Desc: Shared timing for the scheme cores
+ *       Monotonic timestamps, per-thread accumulators and latency
+ *       histograms, see perf_timer.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <time.h>
+#include "perf_timer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PERF_HAVE_TSC 1
+#endif
+
+// Block of the set this thread recorded into last
+static __thread perf_set_t* tls_set;
+static __thread perf_block_t* tls_block;
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+uint64_t perf_cycles(void) {
+#ifdef PERF_HAVE_TSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+#if defined(PERF_TIMER_TSC) && defined(PERF_HAVE_TSC)
+static pthread_once_t tsc_once = PTHREAD_ONCE_INIT;
+static double tsc_base_ms;
+static uint64_t tsc_base;
+static double tsc_per_ms;
+
+// Spin ~10 ms to measure the TSC rate against CLOCK_MONOTONIC
+static void tsc_calibrate(void) {
+    double t0 = monotonic_ms();
+    uint64_t c0 = __rdtsc();
+    double t1;
+    do {
+        t1 = monotonic_ms();
+    } while (t1 - t0 < 10.0);
+    uint64_t c1 = __rdtsc();
+
+    tsc_per_ms = (double)(c1 - c0) / (t1 - t0);
+    tsc_base_ms = t0;
+    tsc_base = c0;
+}
+
+double perf_now_ms(void) {
+    pthread_once(&tsc_once, tsc_calibrate);
+    return tsc_base_ms + (double)(__rdtsc() - tsc_base) / tsc_per_ms;
+}
+#else
+double perf_now_ms(void) {
+    return monotonic_ms();
+}
+#endif
+
+//----------------------------------------------
+// Per-thread accumulators
+//----------------------------------------------
+static perf_block_t* thread_block(perf_set_t* set) {
+    if (tls_set == set) return tls_block;
+
+    pthread_t self = pthread_self();
+    perf_block_t* b;
+    for (b = __atomic_load_n(&set->blocks, __ATOMIC_ACQUIRE); b; b = b->next) {
+        if (pthread_equal(b->owner, self)) break;
+    }
+
+    if (!b) {
+        b = calloc(1, sizeof(perf_block_t));
+        if (!b) return NULL;
+        b->owner = self;
+        pthread_mutex_lock(&set->lock);
+        b->next = set->blocks;
+        __atomic_store_n(&set->blocks, b, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&set->lock);
+    }
+
+    tls_set = set;
+    tls_block = b;
+    return b;
+}
+
+static int hist_bucket(uint64_t ns) {
+    const uint64_t sub = 1u << PERF_HIST_SUB_BITS;
+    if (ns < sub) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    if (e >= PERF_HIST_SUB_BITS + PERF_HIST_MAGNITUDES) return PERF_HIST_BUCKETS - 1;
+    // Magnitude e - SUB_BITS + 1, sub-bucket from the SUB_BITS bits below the top one
+    return (int)(((uint64_t)(e - PERF_HIST_SUB_BITS + 1) << PERF_HIST_SUB_BITS)
+                 + (ns >> (e - PERF_HIST_SUB_BITS)) - sub);
+}
+
+static void hist_record(perf_block_t* b, int slot, double ms) {
+    perf_hist_t* h = b->hist[slot];
+    if (!h) {
+        h = calloc(1, sizeof(perf_hist_t));
+        if (!h) return;
+        __atomic_store_n(&b->hist[slot], h, __ATOMIC_RELEASE);
+    }
+    uint64_t ns = ms > 0 ? (uint64_t)(ms * 1e6 + 0.5) : 0;
+    int i = hist_bucket(ns);
+    __atomic_store_n(&h->count[i], h->count[i] + 1, __ATOMIC_RELAXED);
+    if (ns > h->max_ns) __atomic_store_n(&h->max_ns, ns, __ATOMIC_RELAXED);
+}
+
+void perf_add(perf_set_t* set, int slot, double ms) {
+    if (slot < 0 || slot >= PERF_MAX_SLOTS) return;
+    perf_block_t* b = thread_block(set);
+    if (!b) return;
+
+    // Only the owner writes; relaxed atomics keep concurrent readers tear-free
+    double sum;
+    __atomic_load(&b->ms[slot], &sum, __ATOMIC_RELAXED);
+    sum += ms;
+    __atomic_store(&b->ms[slot], &sum, __ATOMIC_RELAXED);
+    __atomic_store_n(&b->count[slot], b->count[slot] + 1, __ATOMIC_RELAXED);
+    if (set->histograms) hist_record(b, slot, ms);
+}
+
+double perf_total_ms(perf_set_t* set, int slot) {
+    if (slot < 0 || slot >= PERF_MAX_SLOTS) return 0;
+    double total = 0;
+    for (perf_block_t* b = __atomic_load_n(&set->blocks, __ATOMIC_ACQUIRE); b; b = b->next) {
+        double ms;
+        __atomic_load(&b->ms[slot], &ms, __ATOMIC_RELAXED);
+        total += ms;
+    }
+    return total;
+}
+
+unsigned long perf_total_count(perf_set_t* set, int slot) {
+    if (slot < 0 || slot >= PERF_MAX_SLOTS) return 0;
+    unsigned long total = 0;
+    for (perf_block_t* b = __atomic_load_n(&set->blocks, __ATOMIC_ACQUIRE); b; b = b->next) {
+        total += __atomic_load_n(&b->count[slot], __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+void perf_reset(perf_set_t* set) {
+    double zero = 0;
+    for (perf_block_t* b = __atomic_load_n(&set->blocks, __ATOMIC_ACQUIRE); b; b = b->next) {
+        for (int i = 0; i < PERF_MAX_SLOTS; i++) {
+            __atomic_store(&b->ms[i], &zero, __ATOMIC_RELAXED);
+            __atomic_store_n(&b->count[i], 0, __ATOMIC_RELAXED);
+            perf_hist_t* h = __atomic_load_n(&b->hist[i], __ATOMIC_ACQUIRE);
+            if (!h) continue;
+            for (int j = 0; j < PERF_HIST_BUCKETS; j++) {
+                __atomic_store_n(&h->count[j], 0, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&h->max_ns, 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//----------------------------------------------
+// Latency histograms
+//----------------------------------------------
+unsigned long perf_hist_snapshot(perf_set_t* set, int slot, unsigned long* counts, double* max_ms) {
+    if (max_ms) *max_ms = 0;
+    if (!counts) return 0;
+    for (int j = 0; j < PERF_HIST_BUCKETS; j++) counts[j] = 0;
+    if (slot < 0 || slot >= PERF_MAX_SLOTS) return 0;
+
+    unsigned long total = 0;
+    uint64_t max_ns = 0;
+    for (perf_block_t* b = __atomic_load_n(&set->blocks, __ATOMIC_ACQUIRE); b; b = b->next) {
+        perf_hist_t* h = __atomic_load_n(&b->hist[slot], __ATOMIC_ACQUIRE);
+        if (!h) continue;
+        for (int j = 0; j < PERF_HIST_BUCKETS; j++) {
+            uint32_t c = __atomic_load_n(&h->count[j], __ATOMIC_RELAXED);
+            counts[j] += c;
+            total += c;
+        }
+        uint64_t m = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+        if (m > max_ns) max_ns = m;
+    }
+    if (max_ms) *max_ms = max_ns / 1e6;
+    return total;
+}
+
+double perf_hist_bucket_ms(int bucket) {
+    if (bucket < 0) return 0;
+    if (bucket >= PERF_HIST_BUCKETS) bucket = PERF_HIST_BUCKETS - 1;
+    const int sub = 1 << PERF_HIST_SUB_BITS;
+    if (bucket < sub) return bucket / 1e6;
+    int magnitude = bucket >> PERF_HIST_SUB_BITS;
+    uint64_t low = (uint64_t)(sub + (bucket & (sub - 1))) << (magnitude - 1);
+    return (low + ((uint64_t)1 << (magnitude - 1)) - 1) / 1e6;
+}
+
+// Upper bound of the bucket holding the sample of rank ceil(q * total)
+static double hist_percentile(const unsigned long* counts, unsigned long total, double max_ms, double q) {
+    unsigned long rank = (unsigned long)(q * total);
+    if (rank < q * total) rank++;
+    if (rank == 0) rank = 1;
+    unsigned long seen = 0;
+    for (int j = 0; j < PERF_HIST_BUCKETS; j++) {
+        seen += counts[j];
+        if (seen >= rank) {
+            double ms = perf_hist_bucket_ms(j);
+            return ms < max_ms ? ms : max_ms;
+        }
+    }
+    return max_ms;
+}
+
+void perf_latency(perf_set_t* set, int slot, perf_latency_t* out) {
+    if (!out) return;
+    unsigned long counts[PERF_HIST_BUCKETS];
+    double max_ms;
+    unsigned long total = perf_hist_snapshot(set, slot, counts, &max_ms);
+
+    out->count = total;
+    out->mean_ms = out->p50_ms = out->p90_ms = out->p99_ms = out->max_ms = 0;
+    if (total == 0) return;
+
+    unsigned long n = perf_total_count(set, slot);
+    out->mean_ms = n ? perf_total_ms(set, slot) / n : 0;
+    out->p50_ms = hist_percentile(counts, total, max_ms, 0.50);
+    out->p90_ms = hist_percentile(counts, total, max_ms, 0.90);
+    out->p99_ms = hist_percentile(counts, total, max_ms, 0.99);
+    out->max_ms = max_ms;
+}
@@ -0,0 +1,114 @@
+/****************************************************************************
+ * File: perf_timer.h
+ * Desc: Shared timing for the scheme cores
+ *       Monotonic wall-clock timestamps, optional TSC cycle counts,
+ *       per-thread accumulators summed on read and optional HDR-style
+ *       latency histograms merged on read
+ ****************************************************************************/
+
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+// Slots per accumulator set; each core maps its operations onto an enum
+#define PERF_MAX_SLOTS 16
+
+// Log-linear histogram of ns values: exact below 2^PERF_HIST_SUB_BITS, then
+// 2^PERF_HIST_SUB_BITS buckets per power of two (at most ~3% wide) up to
+// 2^(PERF_HIST_SUB_BITS + PERF_HIST_MAGNITUDES) ns (~9.8 h), clamped above
+#define PERF_HIST_SUB_BITS 5
+#define PERF_HIST_MAGNITUDES 40
+#define PERF_HIST_BUCKETS ((PERF_HIST_MAGNITUDES + 1) << PERF_HIST_SUB_BITS)
+
+typedef struct {
+    uint32_t count[PERF_HIST_BUCKETS];
+    uint64_t max_ns;
+} perf_hist_t;
+
+typedef struct perf_block_s {
+    pthread_t owner;
+    double ms[PERF_MAX_SLOTS];
+    unsigned long count[PERF_MAX_SLOTS];
+    perf_hist_t* hist[PERF_MAX_SLOTS];   // allocated on a slot's first sample
+    struct perf_block_s* next;
+} perf_block_t;
+
+// One block per recording thread, so perf_add never contends
+typedef struct {
+    pthread_mutex_t lock;        // guards pushes onto blocks
+    perf_block_t* blocks;
+    int histograms;              // perf_add also records into a histogram
+} perf_set_t;
+
+#define PERF_SET_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }
+#define PERF_HIST_SET_INITIALIZER { PTHREAD_MUTEX_INITIALIZER, NULL, 1 }
+
+// Latency summary of one slot, from its merged histogram
+typedef struct {
+    unsigned long count;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+} perf_latency_t;
+
+/**
+ * Current time in ms from CLOCK_MONOTONIC
+ * Built with -DPERF_TIMER_TSC on x86 it reads the TSC instead, scaled by a
+ * frequency calibrated once against CLOCK_MONOTONIC
+ */
+double perf_now_ms(void);
+
+/**
+ * Raw cycle counter (TSC on x86, monotonic ns elsewhere)
+ */
+uint64_t perf_cycles(void);
+
+/**
+ * Add an elapsed time to a slot of the calling thread's block, and to the
+ * slot's histogram in a PERF_HIST_SET_INITIALIZER set; call it once per
+ * operation so that the histogram holds per-operation latencies
+ * @param set Accumulator set
+ * @param slot Slot index, < PERF_MAX_SLOTS
+ * @param ms Elapsed time in ms
+ */
+void perf_add(perf_set_t* set, int slot, double ms);
+
+/**
+ * Sum of a slot over every thread
+ */
+double perf_total_ms(perf_set_t* set, int slot);
+
+/**
+ * Number of perf_add calls on a slot over every thread
+ */
+unsigned long perf_total_count(perf_set_t* set, int slot);
+
+/**
+ * Zero every slot and histogram of every thread (call while no operation is running)
+ */
+void perf_reset(perf_set_t* set);
+
+/**
+ * Merge a slot's histogram over every thread
+ * @param counts Receives PERF_HIST_BUCKETS bucket counts
+ * @param max_ms Receives the largest sample, may be NULL
+ * @return Number of samples
+ */
+unsigned long perf_hist_snapshot(perf_set_t* set, int slot, unsigned long* counts, double* max_ms);
+
+/**
+ * Largest value in ms that falls into a histogram bucket
+ */
+double perf_hist_bucket_ms(int bucket);
+
+/**
+ * Count, mean, p50, p90, p99 and max of a slot; percentiles are the upper
+ * bound of their bucket, capped at the max
+ */
+void perf_latency(perf_set_t* set, int slot, perf_latency_t* out);
+
+#endif /* PERF_TIMER_H */
@@ -0,0 +1,156 @@
+/****************************************************************************
+ * File: pp_cache.c
+ * Desc: Bounded LRU cache of pairing preprocessing, see pp_cache.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "pp_cache.h"
+#include "perf_prim.h"
+
+static void drop_entries(pp_cache_t* c) {
+    for (int i = 0; i < c->capacity; i++) {
+        pp_cache_entry_t* e = &c->entries[i];
+        if (!e->key) continue;
+        pairing_pp_clear(e->pp);
+        free(e->key);
+    }
+    free(c->entries);
+    c->entries = NULL;
+    c->capacity = 0;
+}
+
+static int alloc_entries(pp_cache_t* c, int capacity) {
+    if (capacity <= 0) return 0;
+    c->entries = calloc(capacity, sizeof(pp_cache_entry_t));
+    if (!c->entries) return -1;
+    c->capacity = capacity;
+    return 0;
+}
+
+int pp_cache_init(pp_cache_t* c, pairing_t pairing, int capacity) {
+    pthread_mutex_init(&c->lock, NULL);
+    c->pairing = pairing;
+    c->capacity = 0;
+    c->key_len = pairing_length_in_bytes_G1(pairing);
+    c->entries = NULL;
+    c->clock = 0;
+    c->hits = c->misses = 0;
+    return alloc_entries(c, capacity);
+}
+
+void pp_cache_clear(pp_cache_t* c) {
+    drop_entries(c);
+    pthread_mutex_destroy(&c->lock);
+    c->pairing = NULL;
+}
+
+int pp_cache_set_capacity(pp_cache_t* c, int capacity) {
+    pthread_mutex_lock(&c->lock);
+    drop_entries(c);
+    c->hits = c->misses = 0;
+    int rc = alloc_entries(c, capacity);
+    pthread_mutex_unlock(&c->lock);
+    return rc;
+}
+
+static pp_cache_entry_t* find(pp_cache_t* c, const unsigned char* key) {
+    for (int i = 0; i < c->capacity; i++) {
+        pp_cache_entry_t* e = &c->entries[i];
+        if (e->key && memcmp(e->key, key, c->key_len) == 0) return e;
+    }
+    return NULL;
+}
+
+// Keep a freshly built table: a free entry, else the least recently used
+// one nobody is applying. The table is cleared when there is no room or
+// another thread cached the same key meanwhile.
+static void insert(pp_cache_t* c, const unsigned char* key, pairing_pp_t pp) {
+    pp_cache_entry_t* victim = NULL;
+    if (!find(c, key)) {
+        for (int i = 0; i < c->capacity; i++) {
+            pp_cache_entry_t* e = &c->entries[i];
+            if (!e->key) {
+                victim = e;
+                break;
+            }
+            if (e->refs == 0 && (!victim || e->last_used < victim->last_used)) victim = e;
+        }
+    }
+    unsigned char* copy = victim ? (victim->key ? victim->key : malloc(c->key_len)) : NULL;
+    if (!copy) {
+        pairing_pp_clear(pp);
+        return;
+    }
+    if (victim->key) pairing_pp_clear(victim->pp);
+    memcpy(copy, key, c->key_len);
+    victim->key = copy;
+    *victim->pp = *pp;
+    victim->last_used = ++c->clock;
+    victim->refs = 0;
+}
+
+// The table of in1 applied to in2, with or without the final exponentiation
+static void pp_apply(element_t out, element_t in2, pairing_pp_t pp, int reduce) {
+    if (reduce) prim_pairing_pp_apply(out, in2, pp);
+    else prim_pairing_pp_apply_unreduced(out, in2, pp);
+}
+
+static void apply(element_t out, element_t in1, element_t in2, pp_cache_t* c, int reduce) {
+    unsigned char key[PP_CACHE_MAX_KEY];
+    // Without preprocessing a table only points to in1, so there is nothing to keep
+    if (c->capacity == 0 || c->key_len > PP_CACHE_MAX_KEY || !pairing_pp_is_precomputed(c->pairing)) {
+        if (reduce) prim_pairing_apply(out, in1, in2, c->pairing);
+        else prim_pairing_apply_unreduced(out, in1, in2, c->pairing);
+        return;
+    }
+    element_to_bytes(key, in1);
+
+    pthread_mutex_lock(&c->lock);
+    pp_cache_entry_t* e = find(c, key);
+    if (e) {
+        e->refs++;
+        e->last_used = ++c->clock;
+        c->hits++;
+    } else {
+        c->misses++;
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    if (e) {
+        pp_apply(out, in2, e->pp, reduce);
+        pthread_mutex_lock(&c->lock);
+        e->refs--;
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+
+    // Built outside the lock; two threads missing on one key both build
+    pairing_pp_t pp;
+    pairing_pp_init(pp, in1, c->pairing);
+    pp_apply(out, in2, pp, reduce);
+    pthread_mutex_lock(&c->lock);
+    insert(c, key, pp);
+    pthread_mutex_unlock(&c->lock);
+}
+
+void pp_cache_apply(element_t out, element_t in1, element_t in2, pp_cache_t* c) {
+    apply(out, in1, in2, c, 1);
+}
+
+void pp_cache_apply_unreduced(element_t out, element_t in1, element_t in2, pp_cache_t* c) {
+    apply(out, in1, in2, c, 0);
+}
+
+void pp_cache_stats(pp_cache_t* c, unsigned long* hits, unsigned long* misses) {
+    pthread_mutex_lock(&c->lock);
+    if (hits) *hits = c->hits;
+    if (misses) *misses = c->misses;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void pp_cache_reset_stats(pp_cache_t* c) {
+    pthread_mutex_lock(&c->lock);
+    c->hits = c->misses = 0;
+    pthread_mutex_unlock(&c->lock);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+ * File: pp_cache.h
+ * Desc: Bounded LRU cache of pairing preprocessing for the scheme cores
+ *       Keeps pairing_pp_t tables of recently paired left arguments, keyed
+ *       by their serialized bytes, so a base paired again (the same R1 in
+ *       several outputs of one transaction) skips the Miller-loop setup
+ ****************************************************************************/
+
+#ifndef PP_CACHE_H
+#define PP_CACHE_H
+
+#include <pthread.h>
+#include <pbc/pbc.h>
+
+// Longest key; larger points are paired without the cache
+#define PP_CACHE_MAX_KEY 512
+
+typedef struct {
+    unsigned char* key;          // NULL while the entry is free
+    pairing_pp_t pp;
+    unsigned long last_used;
+    int refs;                    // applies running on pp, evicted only at 0
+} pp_cache_entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;        // guards everything below
+    pairing_ptr pairing;
+    int capacity;                // 0 disables the cache
+    int key_len;                 // bytes of a serialized G1 point
+    pp_cache_entry_t* entries;
+    unsigned long clock;
+    unsigned long hits, misses;
+} pp_cache_t;
+
+/**
+ * Bind an empty cache to a pairing
+ * @param capacity Most tables kept; 0 pairs every argument afresh
+ * @return 0 on success, -1 if out of memory
+ */
+int pp_cache_init(pp_cache_t* c, pairing_t pairing, int capacity);
+
+/**
+ * Release every table; call before clearing the pairing, while no apply
+ * is running
+ */
+void pp_cache_clear(pp_cache_t* c);
+
+/**
+ * Drop every table and the counters and keep at most capacity from now
+ * on; call while no apply is running
+ * @return 0 on success, -1 if out of memory (the cache is then disabled)
+ */
+int pp_cache_set_capacity(pp_cache_t* c, int capacity);
+
+/**
+ * out = e(in1, in2), through the table of in1, built on a miss. With the
+ * cache disabled, or a pairing type without preprocessing
+ * (pairing_pp_is_precomputed), this is a plain pairing. Safe to call from
+ * several threads at once.
+ */
+void pp_cache_apply(element_t out, element_t in1, element_t in2, pp_cache_t* c);
+
+/**
+ * pp_cache_apply without the final exponentiation, for products of
+ * pairings reduced once (element_gt_reduce)
+ */
+void pp_cache_apply_unreduced(element_t out, element_t in1, element_t in2, pp_cache_t* c);
+
+/**
+ * Lookup counters since init or the last reset
+ */
+void pp_cache_stats(pp_cache_t* c, unsigned long* hits, unsigned long* misses);
+
+void pp_cache_reset_stats(pp_cache_t* c);
+
+#endif /* PP_CACHE_H */
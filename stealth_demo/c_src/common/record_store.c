@@ -0,0 +1,254 @@
+/****************************************************************************
+ * File: record_store.c
+ * Desc: Record store implementation
+ *       The file grows by doubling its record capacity; the count in the
+ *       header is the commit point of an append. Several processes may
+ *       share a file: appends take a write lock on the header, and a
+ *       process that sees more records than its mapping holds remaps
+ ****************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "record_store.h"
+
+//----------------------------------------------
+// File layout
+//----------------------------------------------
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t count;
+} store_header_t;
+
+#define STORE_DATA_OFFSET 64     // records start on a cache line
+#define STORE_MIN_CAPACITY 64
+
+typedef struct {
+    int fd;                      // -1 if the slot is free
+    unsigned char* map;
+    size_t map_size;
+    long capacity;               // records the current file size holds
+} store_t;
+
+static store_t stores[RECORD_STORE_MAX_OPEN];
+static int stores_ready = 0;
+// Record locks are per process, so threads of one process also take this
+static pthread_mutex_t stores_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//----------------------------------------------
+// Helpers
+//----------------------------------------------
+static store_t* store_get(int h) {
+    if (!stores_ready || h < 0 || h >= RECORD_STORE_MAX_OPEN || stores[h].fd < 0) return NULL;
+    return &stores[h];
+}
+
+static store_header_t* store_header(store_t* s) {
+    return (store_header_t*)s->map;
+}
+
+static uint64_t store_count_of(store_t* s) {
+    return __atomic_load_n(&store_header(s)->count, __ATOMIC_ACQUIRE);
+}
+
+// Header write lock, against appends and resets of other processes
+static int store_lock(store_t* s, short type) {
+    struct flock fl = { .l_type = type, .l_whence = SEEK_SET, .l_start = 0, .l_len = STORE_DATA_OFFSET };
+    while (fcntl(s->fd, F_SETLKW, &fl) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+static int store_map(store_t* s, long capacity, uint32_t record_size) {
+    size_t size = STORE_DATA_OFFSET + (size_t)capacity * record_size;
+    struct stat st;
+    if (fstat(s->fd, &st) < 0) return -1;
+    // Never shrink: another process may have grown the file further
+    if ((size_t)st.st_size < size && ftruncate(s->fd, (off_t)size) < 0) return -1;
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (map == MAP_FAILED) return -1;
+    if (s->map) munmap(s->map, s->map_size);
+    s->map = map;
+    s->map_size = size;
+    s->capacity = capacity;
+    return 0;
+}
+
+// Map the whole file if another process appended past this mapping
+static int store_refresh(store_t* s) {
+    if ((long)store_count_of(s) <= s->capacity) return 0;
+    pthread_mutex_lock(&stores_mutex);
+    int rc = 0;
+    struct stat st;
+    uint32_t record_size = store_header(s)->record_size;
+    if ((long)store_count_of(s) > s->capacity) {
+        if (fstat(s->fd, &st) < 0) rc = -1;
+        else rc = store_map(s, (long)((st.st_size - STORE_DATA_OFFSET) / record_size), record_size);
+    }
+    pthread_mutex_unlock(&stores_mutex);
+    return rc;
+}
+
+//----------------------------------------------
+// Store Interface
+//----------------------------------------------
+
+/** Open or create a store file */
+int record_store_open(const char* path, uint32_t kind, uint32_t record_size) {
+    if (!stores_ready) {
+        for (int i = 0; i < RECORD_STORE_MAX_OPEN; i++) stores[i].fd = -1;
+        stores_ready = 1;
+    }
+    if (record_size == 0) return -1;
+
+    int h = 0;
+    while (h < RECORD_STORE_MAX_OPEN && stores[h].fd >= 0) h++;
+    if (h == RECORD_STORE_MAX_OPEN) return -1;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    store_header_t hdr;
+    struct stat st;
+    if (fstat(fd, &st) < 0) { close(fd); return -1; }
+
+    long capacity;
+    if (st.st_size == 0) {
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, RECORD_STORE_MAGIC, sizeof(hdr.magic));
+        hdr.version = RECORD_STORE_VERSION;
+        hdr.kind = kind;
+        hdr.record_size = record_size;
+        capacity = STORE_MIN_CAPACITY;
+    } else {
+        if (st.st_size < STORE_DATA_OFFSET || pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+            memcmp(hdr.magic, RECORD_STORE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != RECORD_STORE_VERSION) {
+            close(fd);
+            return -1;
+        }
+        if (hdr.kind != kind || hdr.record_size != record_size) {
+            close(fd);
+            return -2;
+        }
+        capacity = (long)((st.st_size - STORE_DATA_OFFSET) / record_size);
+        if ((long)hdr.count > capacity) { close(fd); return -1; }
+        if (capacity < STORE_MIN_CAPACITY) capacity = STORE_MIN_CAPACITY;
+    }
+
+    store_t* s = &stores[h];
+    s->fd = fd;
+    s->map = NULL;
+    if (store_map(s, capacity, record_size) < 0) {
+        close(fd);
+        s->fd = -1;
+        return -1;
+    }
+    if (st.st_size == 0) memcpy(store_header(s), &hdr, sizeof(hdr));
+    return h;
+}
+
+/** Append one fixed-width record */
+long record_store_append(int h, const unsigned char* record) {
+    store_t* s = store_get(h);
+    if (!s || !record) return -1;
+
+    pthread_mutex_lock(&stores_mutex);
+    if (store_lock(s, F_WRLCK) < 0) {
+        pthread_mutex_unlock(&stores_mutex);
+        return -1;
+    }
+    store_header_t* hdr = store_header(s);
+    long index = (long)hdr->count;
+    uint32_t record_size = hdr->record_size;
+    long capacity = s->capacity;
+    struct stat st;
+    // The file may have grown in another process since this one mapped it
+    if (fstat(s->fd, &st) == 0 && (long)((st.st_size - STORE_DATA_OFFSET) / record_size) > capacity) {
+        capacity = (long)((st.st_size - STORE_DATA_OFFSET) / record_size);
+    }
+    while (index >= capacity) capacity *= 2;
+    if (capacity != s->capacity && store_map(s, capacity, record_size) < 0) {
+        index = -1;
+    } else {
+        hdr = store_header(s);
+        memcpy(s->map + STORE_DATA_OFFSET + (size_t)index * record_size, record, record_size);
+        __atomic_store_n(&hdr->count, (uint64_t)index + 1, __ATOMIC_RELEASE);
+    }
+    store_lock(s, F_UNLCK);
+    pthread_mutex_unlock(&stores_mutex);
+    return index;
+}
+
+/** Get a record in place */
+const unsigned char* record_store_record(int h, long index) {
+    store_t* s = store_get(h);
+    if (!s) return NULL;
+    if (index < 0 || index >= (long)store_count_of(s)) return NULL;
+    if (index >= s->capacity && store_refresh(s) < 0) return NULL;
+    return s->map + STORE_DATA_OFFSET + (size_t)index * store_header(s)->record_size;
+}
+
+/** Get number of records */
+long record_store_count(int h) {
+    store_t* s = store_get(h);
+    if (!s) return -1;
+    // Records past the mapping cannot be read until a remap succeeds
+    if (store_refresh(s) < 0) return s->capacity;
+    return (long)store_count_of(s);
+}
+
+/** Get the record kind */
+uint32_t record_store_kind(int h) {
+    store_t* s = store_get(h);
+    return s ? store_header(s)->kind : 0;
+}
+
+/** Get the record size */
+uint32_t record_store_record_size(int h) {
+    store_t* s = store_get(h);
+    return s ? store_header(s)->record_size : 0;
+}
+
+/** Drop every record */
+int record_store_reset(int h) {
+    store_t* s = store_get(h);
+    if (!s) return -1;
+    pthread_mutex_lock(&stores_mutex);
+    int rc = store_lock(s, F_WRLCK);
+    if (rc == 0) {
+        __atomic_store_n(&store_header(s)->count, 0, __ATOMIC_RELEASE);
+        store_lock(s, F_UNLCK);
+    }
+    pthread_mutex_unlock(&stores_mutex);
+    return rc;
+}
+
+/** Flush the mapping to disk */
+int record_store_sync(int h) {
+    store_t* s = store_get(h);
+    if (!s) return -1;
+    return msync(s->map, s->map_size, MS_SYNC) == 0 ? 0 : -1;
+}
+
+/** Sync, unmap and close a store */
+void record_store_close(int h) {
+    store_t* s = store_get(h);
+    if (!s) return;
+    msync(s->map, s->map_size, MS_SYNC);
+    munmap(s->map, s->map_size);
+    close(s->fd);
+    s->fd = -1;
+    s->map = NULL;
+    s->map_size = 0;
+    s->capacity = 0;
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ * File: record_store.h
+ * Desc: Append-only, memory-mapped record store shared by the schemes
+ *       A file holds a fixed header followed by fixed-width records;
+ *       records are read in place from the mapping by index. Each
+ *       scheme library links its own copy, behind its own wrappers
+ *       (stealth_store.h, sitaiba_store.h), so handles are per library
+ ****************************************************************************/
+
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <stdint.h>
+
+#define RECORD_STORE_MAGIC "PBCSTOR1"
+#define RECORD_STORE_VERSION 1
+#define RECORD_STORE_MAX_OPEN 16
+
+/**
+ * Open (or create) a store file. An existing file must carry the same
+ * kind and record size; the records already in it are kept.
+ * @param path File path
+ * @param kind Caller-defined record kind, checked on reopen
+ * @param record_size Bytes per record, > 0
+ * @return Store handle (>= 0), -1 on I/O error, -2 if the file holds another kind or record size
+ */
+int record_store_open(const char* path, uint32_t kind, uint32_t record_size);
+
+/**
+ * Append one record. The record is written before the count is bumped,
+ * so a crash never exposes a half-written record. Safe against appends
+ * to the same file from other threads and processes.
+ * @param h Store handle
+ * @param record record_size bytes
+ * @return Index of the new record, -1 on error
+ */
+long record_store_append(int h, const unsigned char* record);
+
+/**
+ * Get a record in place. The pointer is invalidated by the next append
+ * (the mapping may move when the file grows) and by close.
+ * @param h Store handle
+ * @param index Record index
+ * @return Pointer into the mapping, NULL if out of range
+ */
+const unsigned char* record_store_record(int h, long index);
+
+/**
+ * Get number of records, -1 for a bad handle. Counts the records other
+ * processes appended too, remapping the file if they grew it
+ */
+long record_store_count(int h);
+
+/**
+ * Get the record kind of an open store, 0 for a bad handle
+ */
+uint32_t record_store_kind(int h);
+
+/**
+ * Get the record size of an open store, 0 for a bad handle
+ */
+uint32_t record_store_record_size(int h);
+
+/**
+ * Drop every record (the file keeps its header)
+ * @return 0 on success, -1 on error
+ */
+int record_store_reset(int h);
+
+/**
+ * Flush the mapping to disk
+ * @return 0 on success, -1 on error
+ */
+int record_store_sync(int h);
+
+/**
+ * Sync, unmap and close a store; the handle becomes free
+ */
+void record_store_close(int h);
+
+#endif /* RECORD_STORE_H */
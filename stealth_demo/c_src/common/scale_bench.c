@@ -0,0 +1,140 @@
+/****************************************************************************
+ * File: scale_bench.c
+ * Desc: Multi-core scaling harness for the scheme benchmarks
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "scale_bench.h"
+#include "perf_timer.h"
+
+// Per-thread copy buffers, above common last-level cache sizes, within a
+// total of COPY_TOTAL over every thread
+#define COPY_BYTES ((size_t)64 << 20)
+#define COPY_TOTAL ((size_t)1 << 30)
+#define COPY_ROUNDS 4
+
+int scale_thread_counts(int max, int* counts, int n) {
+    if (max <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        max = cpus > 0 ? (int)cpus : 1;
+    }
+    int filled = 0;
+    for (int t = 1; t < max && filled < n - 1; t *= 2) counts[filled++] = t;
+    if (filled < n) counts[filled++] = max;
+    return filled;
+}
+
+typedef struct {
+    pthread_t tid;
+    scale_range_fn fn;
+    void* arg;
+    int begin, end;
+} range_job_t;
+
+static void* range_worker(void* p) {
+    range_job_t* job = (range_job_t*)p;
+    job->fn(job->arg, job->begin, job->end);
+    return NULL;
+}
+
+void scale_run_ranges(scale_range_fn fn, void* arg, int n, int threads) {
+    if (threads < 1) threads = 1;
+    range_job_t* jobs = calloc(threads, sizeof(range_job_t));
+    if (!jobs) {
+        fn(arg, 0, n);
+        return;
+    }
+    int per = (n + threads - 1) / threads;
+    for (int i = 0; i < threads; i++) {
+        jobs[i].fn = fn;
+        jobs[i].arg = arg;
+        jobs[i].begin = i * per < n ? i * per : n;
+        jobs[i].end = (i + 1) * per < n ? (i + 1) * per : n;
+    }
+
+    // Ranges whose thread fails to start run on the calling thread
+    int started = 1;
+    while (started < threads &&
+           pthread_create(&jobs[started].tid, NULL, range_worker, &jobs[started]) == 0)
+        started++;
+    range_worker(&jobs[0]);
+    for (int i = started; i < threads; i++) range_worker(&jobs[i]);
+    for (int i = 1; i < started; i++) pthread_join(jobs[i].tid, NULL);
+    free(jobs);
+}
+
+double scale_time(scale_run_fn fn, void* arg, int n, int threads, int repeats) {
+    double best = 0;
+    fn(arg, n, threads);
+    for (int r = 0; r < repeats; r++) {
+        double t0 = perf_now_ms();
+        fn(arg, n, threads);
+        double ms = perf_now_ms() - t0;
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+typedef struct {
+    unsigned char* src;
+    unsigned char* dst;
+    size_t bytes;
+} copy_buf_t;
+
+static void copy_range(void* arg, int begin, int end) {
+    copy_buf_t* bufs = (copy_buf_t*)arg;
+    for (int i = begin; i < end; i++) {
+        for (int r = 0; r < COPY_ROUNDS; r++) memcpy(bufs[i].dst, bufs[i].src, bufs[i].bytes);
+    }
+}
+
+double scale_copy_bandwidth(int threads) {
+    size_t bytes = COPY_TOTAL / (2 * (size_t)threads);
+    if (bytes > COPY_BYTES) bytes = COPY_BYTES;
+    copy_buf_t* bufs = calloc(threads, sizeof(copy_buf_t));
+    if (!bufs) return 0;
+    int ok = 1;
+    for (int i = 0; i < threads && ok; i++) {
+        bufs[i].bytes = bytes;
+        bufs[i].src = malloc(bytes);
+        bufs[i].dst = malloc(bytes);
+        ok = bufs[i].src && bufs[i].dst;
+        // Touch the pages so that the timed copies do not fault them in
+        if (ok) {
+            memset(bufs[i].src, i + 1, bytes);
+            memset(bufs[i].dst, 0, bytes);
+        }
+    }
+
+    double mbps = 0;
+    if (ok) {
+        double t0 = perf_now_ms();
+        scale_run_ranges(copy_range, bufs, threads, threads);
+        double ms = perf_now_ms() - t0;
+        mbps = 2.0 * bytes * COPY_ROUNDS * threads / (ms * 1000.0);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        free(bufs[i].src);
+        free(bufs[i].dst);
+    }
+    free(bufs);
+    return mbps;
+}
+
+void scale_report_header(void) {
+    printf("scheme,op,threads,outputs,ms,outputs_per_sec,speedup,efficiency,ledger_MBps,copy_MBps\n");
+}
+
+void scale_report(const char* scheme, const char* op, int threads, int n, double ms,
+                  double base_per_sec, size_t bytes_per_output, double copy_mbps) {
+    double per_sec = ms > 0 ? n * 1000.0 / ms : 0;
+    double speedup = base_per_sec > 0 ? per_sec / base_per_sec : 0;
+    printf("%s,%s,%d,%d,%.2f,%.1f,%.2f,%.2f,%.3f,%.0f\n", scheme, op, threads, n, ms, per_sec,
+           speedup, speedup / threads, per_sec * bytes_per_output / 1e6, copy_mbps);
+    fflush(stdout);
+}
@@ -0,0 +1,70 @@
+/****************************************************************************
+ * File: scale_bench.h
+ * Desc: Multi-core scaling harness for the scheme benchmarks
+ *       Thread-count sweeps, range splitting over a ledger, a copy
+ *       bandwidth probe and CSV reporting shared by scale_stealth and
+ *       scale_sitaiba
+ ****************************************************************************/
+
+#ifndef SCALE_BENCH_H
+#define SCALE_BENCH_H
+
+#include <stddef.h>
+
+// Most thread counts in one sweep
+#define SCALE_MAX_COUNTS 32
+
+// Work on outputs [begin, end) of a ledger
+typedef void (*scale_range_fn)(void* arg, int begin, int end);
+
+// Work on a whole ledger of n outputs with the given number of threads
+typedef void (*scale_run_fn)(void* arg, int n, int threads);
+
+/**
+ * Thread counts of a sweep: 1, 2, 4, ... below max, then max itself
+ * @param max Largest count, <= 0 for one per online CPU
+ * @param counts Array for the counts (output)
+ * @param n Size of counts
+ * @return Number of counts filled
+ */
+int scale_thread_counts(int max, int* counts, int n);
+
+/**
+ * Split [0, n) into one contiguous range per thread and run fn on each,
+ * the first range on the calling thread
+ */
+void scale_run_ranges(scale_range_fn fn, void* arg, int n, int threads);
+
+/**
+ * Best wall time in ms of repeats runs of fn, after one untimed run
+ */
+double scale_time(scale_run_fn fn, void* arg, int n, int threads, int repeats);
+
+/**
+ * Copy bandwidth in MB/s (read plus write) of threads threads each
+ * copying a private buffer of up to 64 MB (1 GB over every thread), the
+ * ceiling the ledger traffic is compared against
+ */
+double scale_copy_bandwidth(int threads);
+
+/**
+ * Print the CSV header of scale_report
+ */
+void scale_report_header(void);
+
+/**
+ * Print one CSV line: throughput, speedup and efficiency against the
+ * single-thread rate, and the ledger bytes read per second beside the
+ * copy bandwidth at the same thread count
+ * @param scheme, op Labels
+ * @param threads Thread count
+ * @param n Outputs processed
+ * @param ms Wall time
+ * @param base_per_sec Outputs per second with one thread
+ * @param bytes_per_output Serialized bytes of an output the op reads
+ * @param copy_mbps scale_copy_bandwidth(threads)
+ */
+void scale_report(const char* scheme, const char* op, int threads, int n, double ms,
+                  double base_per_sec, size_t bytes_per_output, double copy_mbps);
+
+#endif /* SCALE_BENCH_H */
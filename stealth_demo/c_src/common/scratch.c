@@ -0,0 +1,94 @@
+/****************************************************************************
+ * File: scratch.c
+ * Desc: Reusable scratch elements for the scheme cores, see scratch.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "scratch.h"
+
+// Bytes an element of f takes in the workspace block, 0 if f does not pack
+static size_t packed_room(field_ptr f) {
+    return (f->packed_size + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+}
+
+static void scratch_init_elem(element_t e, field_ptr f, unsigned char** mem) {
+    if (f->packed_size) {
+        element_init_packed(e, f, *mem);
+        *mem += packed_room(f);
+    } else {
+        element_init(e, f);
+    }
+}
+
+static void scratch_clear_elem(element_t e) {
+    if (!e->field->packed_size) element_clear(e);
+}
+
+/**
+ * One allocation per workspace: elements of fields that pack them keep
+ * their data in a block after the struct, next to each other, instead of
+ * in two or three allocations each
+ */
+static scratch_t* scratch_new(pairing_ptr pairing, int node) {
+    size_t room = SCRATCH_G1 * packed_room(pairing->G1) +
+                  SCRATCH_G2 * packed_room(pairing->G2) +
+                  (SCRATCH_ZR + 1) * packed_room(pairing->Zr) +
+                  SCRATCH_GT * packed_room(pairing->GT);
+    scratch_t* s = malloc(sizeof(scratch_t) + room);
+    if (!s) return NULL;
+    unsigned char* mem = (unsigned char*)(s + 1);
+    for (int i = 0; i < SCRATCH_G1; i++) scratch_init_elem(s->g1[i], pairing->G1, &mem);
+    for (int i = 0; i < SCRATCH_G2; i++) scratch_init_elem(s->g2[i], pairing->G2, &mem);
+    for (int i = 0; i < SCRATCH_ZR; i++) scratch_init_elem(s->zr[i], pairing->Zr, &mem);
+    for (int i = 0; i < SCRATCH_GT; i++) scratch_init_elem(s->gt[i], pairing->GT, &mem);
+    for (int i = 0; i < SCRATCH_MPZ; i++) mpz_init(s->z[i]);
+    scratch_init_elem(s->hash_zr, pairing->Zr, &mem);
+    s->node = node;
+    s->next = NULL;
+    return s;
+}
+
+static void scratch_free(scratch_t* s) {
+    for (int i = 0; i < SCRATCH_G1; i++) scratch_clear_elem(s->g1[i]);
+    for (int i = 0; i < SCRATCH_G2; i++) scratch_clear_elem(s->g2[i]);
+    for (int i = 0; i < SCRATCH_ZR; i++) scratch_clear_elem(s->zr[i]);
+    for (int i = 0; i < SCRATCH_GT; i++) scratch_clear_elem(s->gt[i]);
+    for (int i = 0; i < SCRATCH_MPZ; i++) mpz_clear(s->z[i]);
+    scratch_clear_elem(s->hash_zr);
+    free(s);
+}
+
+void scratch_pool_init(scratch_pool_t* pool, pairing_t pairing) {
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->pairing = pairing;
+    for (int k = 0; k < CPU_TOPO_MAX_NODES; k++) pool->free[k] = NULL;
+}
+
+void scratch_pool_clear(scratch_pool_t* pool) {
+    for (int k = 0; k < CPU_TOPO_MAX_NODES; k++) {
+        while (pool->free[k]) {
+            scratch_t* s = pool->free[k];
+            pool->free[k] = s->next;
+            scratch_free(s);
+        }
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pool->pairing = NULL;
+}
+
+scratch_t* scratch_get(scratch_pool_t* pool) {
+    int node = cpu_topo_current_node();
+    pthread_mutex_lock(&pool->lock);
+    scratch_t* s = pool->free[node];
+    if (s) pool->free[node] = s->next;
+    pthread_mutex_unlock(&pool->lock);
+    return s ? s : scratch_new(pool->pairing, node);
+}
+
+void scratch_put(scratch_pool_t* pool, scratch_t* s) {
+    if (!s) return;
+    pthread_mutex_lock(&pool->lock);
+    s->next = pool->free[s->node];
+    pool->free[s->node] = s;
+    pthread_mutex_unlock(&pool->lock);
+}
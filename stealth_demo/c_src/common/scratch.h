@@ -0,0 +1,66 @@
+/****************************************************************************
+ * File: scratch.h
+ * Desc: Reusable scratch elements for the scheme cores
+ *       A pool per initialized pairing hands out workspaces of elements
+ *       and mpz values that stay initialized between operations, so ops
+ *       borrow their temporaries instead of init / clear on every call.
+ *       Free workspaces are kept per NUMA node and a thread borrows from
+ *       its own node's list, so a workspace stays where it was allocated.
+ ****************************************************************************/
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include "cpu_topo.h"
+
+// Temporaries per workspace, sized for the largest op of either core
+#define SCRATCH_G1  5
+#define SCRATCH_G2  2           // G1 again under a symmetric pairing
+#define SCRATCH_ZR  3
+#define SCRATCH_GT  2
+#define SCRATCH_MPZ 2
+
+typedef struct scratch_s {
+    element_t g1[SCRATCH_G1];
+    element_t g2[SCRATCH_G2];
+    element_t zr[SCRATCH_ZR];
+    element_t gt[SCRATCH_GT];
+    mpz_t z[SCRATCH_MPZ];
+    element_t hash_zr;           // reserved for the hash helpers
+    int node;                    // node of the thread that created it
+    struct scratch_s* next;
+} scratch_t;
+
+// Free workspaces of one pairing; one is in use per running operation
+typedef struct {
+    pthread_mutex_t lock;        // guards free
+    pairing_ptr pairing;
+    scratch_t* free[CPU_TOPO_MAX_NODES];
+} scratch_pool_t;
+
+/**
+ * Bind an empty pool to a pairing
+ */
+void scratch_pool_init(scratch_pool_t* pool, pairing_t pairing);
+
+/**
+ * Release every workspace of the pool; call before clearing its pairing,
+ * while no workspace is borrowed
+ */
+void scratch_pool_clear(scratch_pool_t* pool);
+
+/**
+ * Borrow a workspace, creating one when all of the calling thread's node
+ * are in use
+ * @return Workspace, NULL if out of memory
+ */
+scratch_t* scratch_get(scratch_pool_t* pool);
+
+/**
+ * Return a workspace to the pool it came from
+ */
+void scratch_put(scratch_pool_t* pool, scratch_t* s);
+
+#endif /* SCRATCH_H */
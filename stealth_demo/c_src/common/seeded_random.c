@@ -0,0 +1,59 @@
+/****************************************************************************
+ * File: seeded_random.c
+ * Desc: Seeded random mode for reproducible benchmarks
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "seeded_random.h"
+
+// Whether the source bound to this thread is seeded, and the one
+// seeded_random_set bound
+static __thread int tls_seeded;
+static __thread seeded_random_bind_t* tls_own;
+
+int seeded_random_set(int enabled, unsigned int seed) {
+    if (tls_own) {
+        seeded_random_unbind(tls_own);
+        free(tls_own);
+        tls_own = NULL;
+    }
+    if (!enabled) return 0;
+
+    seeded_random_job_t job = { 1, seed };
+    tls_own = malloc(sizeof(seeded_random_bind_t));
+    if (!tls_own) return -1;
+    seeded_random_bind(tls_own, &job);
+    return 0;
+}
+
+int seeded_random_active(void) {
+    return tls_seeded;
+}
+
+void seeded_random_job(seeded_random_job_t* job) {
+    job->seeded = tls_seeded;
+    job->seed = 0;
+    if (tls_seeded) {
+        mpz_t z;
+        mpz_init(z);
+        pbc_mpz_randomb(z, 32);
+        job->seed = (unsigned int)mpz_get_ui(z);
+        mpz_clear(z);
+    }
+}
+
+int seeded_random_bind(seeded_random_bind_t* b, const seeded_random_job_t* job) {
+    if (job->seeded) pbc_random_ctx_init_deterministic(b->ctx, job->seed);
+    else if (pbc_random_ctx_init_os(b->ctx) != 0) return -1;
+
+    b->prev = pbc_random_ctx_bind(b->ctx);
+    b->prev_seeded = tls_seeded;
+    tls_seeded = job->seeded;
+    return 0;
+}
+
+void seeded_random_unbind(seeded_random_bind_t* b) {
+    pbc_random_ctx_bind(b->prev);
+    tls_seeded = b->prev_seeded;
+    pbc_random_ctx_clear(b->ctx);
+}
@@ -0,0 +1,60 @@
+/****************************************************************************
+ * File: seeded_random.h
+ * Desc: Seeded random mode for reproducible benchmarks
+ *       A thread binds a deterministic PBC random source, and every worker
+ *       thread a core operation starts from it gets its own deterministic
+ *       source seeded from that one, so a run draws the same keys and
+ *       exponents whatever the thread schedule. Other threads keep the OS
+ *       source. Never for real keys.
+ ****************************************************************************/
+
+#ifndef SEEDED_RANDOM_H
+#define SEEDED_RANDOM_H
+
+#include <pbc/pbc.h>
+
+// Source of a worker thread, chosen on the thread that starts it
+typedef struct {
+    int seeded;
+    unsigned int seed;
+} seeded_random_job_t;
+
+// A source bound to a thread and what it replaced
+typedef struct {
+    pbc_random_ctx_t ctx;
+    pbc_random_ctx_ptr prev;
+    int prev_seeded;
+} seeded_random_bind_t;
+
+/**
+ * Bind a deterministic source seeded with seed to the calling thread, or
+ * unbind it and go back to the OS source
+ * @param enabled 1 to bind (replacing a seeded source already bound), 0 to unbind
+ * @return 0 on success, -1 if out of memory
+ */
+int seeded_random_set(int enabled, unsigned int seed);
+
+/**
+ * 1 if the calling thread draws from a seeded source
+ */
+int seeded_random_active(void);
+
+/**
+ * Choose the source of a worker about to be started: seeded from the
+ * calling thread's source if that is seeded, the OS source otherwise.
+ * Call in job order on the starting thread.
+ */
+void seeded_random_job(seeded_random_job_t* job);
+
+/**
+ * Bind the source chosen by seeded_random_job to the calling worker thread
+ * @return 0 on success, -1 if no source could be set up
+ */
+int seeded_random_bind(seeded_random_bind_t* b, const seeded_random_job_t* job);
+
+/**
+ * Restore the source seeded_random_bind replaced and free its own
+ */
+void seeded_random_unbind(seeded_random_bind_t* b);
+
+#endif /* SEEDED_RANDOM_H */
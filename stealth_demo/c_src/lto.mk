@@ -0,0 +1,223 @@
+# Whole-program optimized libstealth.so and libsitaiba.so
+#
+# Each library is compiled from the scheme sources, common/ and the PBC
+# sources of $(PBC_DIR) in one link-time optimized link, at -O3 for
+# -march=$(MARCH), with no separate libpbc to load. Calls from the
+# schemes into PBC then bind inside the library rather than through the
+# PLT, and small PBC functions (element_init, the mpz wrappers, the
+# curve and field helpers reached by direct call) are inlined across
+# file boundaries. -fno-semantic-interposition lets this happen for the
+# exported PBC functions too, which stay visible so that programs using
+# the element API, such as the benchmarks, link against the library
+# alone.
+#
+#   make -f lto.mk            libraries in $(BUILD)/lib
+#   make -f lto.mk PGO=1      same, trained on the benchmarks first
+#   make -f lto.mk install    copy the libraries to $(OUT_DIR)
+#   make -f lto.mk bench      time them against the regular build
+#   make -f lto.mk scale      scan / verify / trace throughput by thread count
+#   make -f lto.mk replay     generate a synthetic ledger and time wallet sync on it
+#   make -f lto.mk load       drive a running server's REST API with an operation mix
+#
+# PGO=1 builds instrumented libraries, runs bench_stealth and
+# bench_sitaiba on $(TRAIN_PARAM), and rebuilds with the profile. The
+# reference build for bench is the scheme sources at the -O2 of their
+# own Makefiles, linked against $(PBC_LIB).
+
+PBC_DIR ?= ../../Traceable_one-time_addr_scheme
+MARCH ?= native
+BUILD ?= build-lto
+OUT_DIR ?= ../lib
+TRAIN_PARAM ?= ../param/a.param
+BENCH_PARAM ?= ../param/a.param
+BENCH_ITERS ?= 200
+TRAIN_ITERS ?= 50
+SCALE_PARAM ?= ../param/a.param
+SCALE_OUTPUTS ?= 1024
+SCALE_THREADS ?= 0
+SCALE_REPEATS ?= 3
+LEDGER_PARAM ?= ../param/a.param
+LEDGER_DIR ?= $(BUILD)/ledger
+LEDGER_OUTPUTS ?= 10000
+LEDGER_RECIPIENTS ?= 64
+LEDGER_OWNED ?= 0.01
+LEDGER_THREADS ?= 0
+LOAD_URL ?= http://127.0.0.1:5000
+LOAD_CONNECTIONS ?= 8
+LOAD_DURATION ?= 10
+LOAD_RATE ?= 0
+LOAD_MIX ?= addrgen=15,recognize_addr=40,dskgen=10,sign=10,verify_signature=15,trace=10
+PBC_LIB ?= -lpbc
+
+CC = gcc
+OPT = -O3 -march=$(MARCH) -flto=auto -fno-semantic-interposition -fPIC
+# PBC keeps the flags of its simple.make.
+PBC_CFLAGS = $(OPT) -ffast-math -fomit-frame-pointer -I$(PBC_DIR)/include -I$(PBC_DIR)
+SCHEME_CFLAGS = $(OPT) -Wall -Icommon -I$(BUILD)/include
+LIBS = -lgmp -lcrypto -lssl -lpthread -lm
+
+PROFILE_DIR = $(abspath $(BUILD)/profile)
+ifeq ($(PGO_PHASE),gen)
+  PGO_FLAGS = -fprofile-generate=$(PROFILE_DIR) -fprofile-update=atomic
+else ifeq ($(PGO_PHASE),use)
+  PGO_FLAGS = -fprofile-use=$(PROFILE_DIR) -fprofile-partial-training \
+              -Wno-missing-profile
+endif
+
+PBC_SRCS = \
+  $(addsuffix .c,$(addprefix arith/, \
+    field fp montfp montfp_ifma naivefp fastfp fasterfp multiz z fieldquadratic poly \
+    ternary_extension_field random dlog recode init_random)) \
+  $(addsuffix .c,$(addprefix ecc/, \
+    curve singular pairing param \
+    a_param d_param e_param f_param g_param eta_T_3 \
+    hilbert mnt mpc)) \
+  $(addsuffix .c,$(addprefix misc/, \
+    utils darray symtab extend_printf memory mempool get_time))
+COMMON_SRCS = $(addsuffix .c,$(addprefix common/, \
+  perf_timer perf_prim perf_counters scratch pairing_tune pp_cache hash_stream seeded_random eph_pool dsk_cache hash_cache batch_check param_file hex_codec cpu_topo completion_queue record_store))
+STEALTH_SRCS = $(addsuffix .c,$(addprefix stealth/, \
+  stealth_core stealth_python_api stealth_ctx stealth_registry stealth_store stealth_bench stealth_async))
+SITAIBA_SRCS = $(addsuffix .c,$(addprefix sitaiba/, \
+  sitaiba_core sitaiba_python_api sitaiba_ctx sitaiba_registry sitaiba_store sitaiba_async))
+
+PBC_OBJS = $(addprefix $(BUILD)/pbc/,$(PBC_SRCS:.c=.o))
+COMMON_OBJS = $(addprefix $(BUILD)/,$(COMMON_SRCS:.c=.o))
+STEALTH_OBJS = $(addprefix $(BUILD)/,$(STEALTH_SRCS:.c=.o))
+SITAIBA_OBJS = $(addprefix $(BUILD)/,$(SITAIBA_SRCS:.c=.o))
+PBC_INCLUDE = $(BUILD)/include/pbc
+
+LIBSTEALTH = $(BUILD)/lib/libstealth.so
+LIBSITAIBA = $(BUILD)/lib/libsitaiba.so
+
+.PHONY: all libs pgo train install bench scale replay load clean clean-objs
+
+ifeq ($(PGO),1)
+all: pgo
+else
+all: libs
+endif
+
+libs: $(LIBSTEALTH) $(LIBSITAIBA)
+
+# The schemes include <pbc/pbc.h>.
+$(PBC_INCLUDE):
+	@mkdir -p $(dir $@)
+	ln -sfn $(abspath $(PBC_DIR)/include) $@
+
+$(BUILD)/pbc/%.o: $(PBC_DIR)/%.c
+	@mkdir -p $(dir $@)
+	$(CC) $(PBC_CFLAGS) $(PGO_FLAGS) -c $< -o $@
+
+$(BUILD)/%.o: %.c | $(PBC_INCLUDE)
+	@mkdir -p $(dir $@)
+	$(CC) $(SCHEME_CFLAGS) $(PGO_FLAGS) -c $< -o $@
+
+$(LIBSTEALTH): $(STEALTH_OBJS) $(COMMON_OBJS) $(PBC_OBJS)
+	@mkdir -p $(dir $@)
+	@echo "📚 Linking whole-program optimized $@..."
+	$(CC) $(OPT) $(PGO_FLAGS) -shared -o $@ $^ $(LIBS)
+
+$(LIBSITAIBA): $(SITAIBA_OBJS) $(COMMON_OBJS) $(PBC_OBJS)
+	@mkdir -p $(dir $@)
+	@echo "📚 Linking whole-program optimized $@..."
+	$(CC) $(OPT) $(PGO_FLAGS) -shared -o $@ $^ $(LIBS)
+
+# Benchmarks against the libraries in $(BUILD)/lib.
+$(BUILD)/bench_stealth: stealth/bench_stealth.c $(LIBSTEALTH)
+	$(CC) -O2 -Wall -Istealth -Icommon -I$(BUILD)/include -o $@ $< \
+	  -L$(BUILD)/lib -lstealth -lgmp -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+$(BUILD)/bench_sitaiba: sitaiba/bench_sitaiba.c $(LIBSITAIBA)
+	$(CC) -O2 -Wall -Isitaiba -Icommon -I$(BUILD)/include -o $@ $< \
+	  -L$(BUILD)/lib -lsitaiba -lgmp -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+# Scaling benchmarks, SCALE_THREADS 0 sweeping up to one thread per CPU
+$(BUILD)/scale_stealth: stealth/scale_stealth.c common/scale_bench.c $(LIBSTEALTH)
+	$(CC) -O2 -Wall -Istealth -Icommon -I$(BUILD)/include -o $@ $(filter %.c,$^) \
+	  -L$(BUILD)/lib -lstealth -lgmp -lpthread -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+$(BUILD)/scale_sitaiba: sitaiba/scale_sitaiba.c common/scale_bench.c $(LIBSITAIBA)
+	$(CC) -O2 -Wall -Isitaiba -Icommon -I$(BUILD)/include -o $@ $(filter %.c,$^) \
+	  -L$(BUILD)/lib -lsitaiba -lgmp -lpthread -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+scale: $(BUILD)/scale_stealth $(BUILD)/scale_sitaiba
+	@echo "🧵 Scaling on $(SCALE_OUTPUTS) outputs of $(SCALE_PARAM):"
+	$(BUILD)/scale_stealth $(SCALE_PARAM) $(SCALE_OUTPUTS) $(SCALE_THREADS) $(SCALE_REPEATS)
+	$(BUILD)/scale_sitaiba $(SCALE_PARAM) $(SCALE_OUTPUTS) $(SCALE_THREADS) $(SCALE_REPEATS)
+
+# Synthetic ledgers in the store format and wallet sync replays over them
+$(BUILD)/ledger_stealth: stealth/ledger_stealth.c common/scale_bench.c $(LIBSTEALTH)
+	$(CC) -O2 -Wall -Istealth -Icommon -I$(BUILD)/include -o $@ $(filter %.c,$^) \
+	  -L$(BUILD)/lib -lstealth -lgmp -lpthread -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+$(BUILD)/ledger_sitaiba: sitaiba/ledger_sitaiba.c common/scale_bench.c $(LIBSITAIBA)
+	$(CC) -O2 -Wall -Isitaiba -Icommon -I$(BUILD)/include -o $@ $(filter %.c,$^) \
+	  -L$(BUILD)/lib -lsitaiba -lgmp -lpthread -Wl,-rpath,$(abspath $(BUILD)/lib)
+
+replay: $(BUILD)/ledger_stealth $(BUILD)/ledger_sitaiba
+	@mkdir -p $(LEDGER_DIR)/stealth $(LEDGER_DIR)/sitaiba
+	@echo "📒 Ledgers of $(LEDGER_OUTPUTS) outputs, $(LEDGER_OWNED) owned, in $(LEDGER_DIR):"
+	$(BUILD)/ledger_stealth gen $(LEDGER_PARAM) $(LEDGER_DIR)/stealth $(LEDGER_OUTPUTS) \
+	  $(LEDGER_RECIPIENTS) $(LEDGER_OWNED) $(LEDGER_THREADS)
+	$(BUILD)/ledger_stealth replay $(LEDGER_PARAM) $(LEDGER_DIR)/stealth $(LEDGER_THREADS)
+	$(BUILD)/ledger_sitaiba gen $(LEDGER_PARAM) $(LEDGER_DIR)/sitaiba $(LEDGER_OUTPUTS) \
+	  $(LEDGER_RECIPIENTS) $(LEDGER_OWNED) $(LEDGER_THREADS)
+	$(BUILD)/ledger_sitaiba replay $(LEDGER_PARAM) $(LEDGER_DIR)/sitaiba $(LEDGER_THREADS)
+
+# REST API load against a server already running at $(LOAD_URL), LOAD_RATE 0
+# for closed loop; standalone, it links none of the libraries
+$(BUILD)/loadgen: common/loadgen.c
+	@mkdir -p $(dir $@)
+	$(CC) -O2 -Wall -o $@ $< -lpthread -lm
+
+load: $(BUILD)/loadgen
+	$(BUILD)/loadgen -u $(LOAD_URL) -c $(LOAD_CONNECTIONS) -d $(LOAD_DURATION) -r $(LOAD_RATE) \
+	  -m $(LOAD_MIX)
+
+# The objects are rebuilt for each phase; only the profile carries over.
+pgo:
+	@echo "🎯 Building instrumented libraries..."
+	rm -rf $(PROFILE_DIR)
+	$(MAKE) -f lto.mk clean-objs
+	$(MAKE) -f lto.mk PGO_PHASE=gen train
+	@echo "🎯 Rebuilding with the collected profile..."
+	$(MAKE) -f lto.mk clean-objs
+	$(MAKE) -f lto.mk PGO_PHASE=use libs
+
+train: $(BUILD)/bench_stealth $(BUILD)/bench_sitaiba
+	$(BUILD)/bench_stealth $(TRAIN_PARAM) $(TRAIN_ITERS) > /dev/null
+	$(BUILD)/bench_sitaiba $(TRAIN_PARAM) $(TRAIN_ITERS) > /dev/null
+
+install: all
+	@mkdir -p $(OUT_DIR)
+	cp $(LIBSTEALTH) $(LIBSITAIBA) $(OUT_DIR)/
+	@echo "✅ Whole-program optimized libraries installed in $(OUT_DIR)"
+
+# Reference build: the schemes as their own Makefiles compile them.
+REF_CFLAGS = -O2 -Wall -Icommon -I$(BUILD)/include
+
+$(BUILD)/ref/bench_stealth: stealth/bench_stealth.c $(STEALTH_SRCS) $(COMMON_SRCS) | $(PBC_INCLUDE)
+	@mkdir -p $(dir $@)
+	$(CC) $(REF_CFLAGS) -Istealth -o $@ $^ $(PBC_LIB) $(LIBS)
+
+$(BUILD)/ref/bench_sitaiba: sitaiba/bench_sitaiba.c $(SITAIBA_SRCS) $(COMMON_SRCS) | $(PBC_INCLUDE)
+	@mkdir -p $(dir $@)
+	$(CC) $(REF_CFLAGS) -Isitaiba -o $@ $^ $(PBC_LIB) $(LIBS)
+
+bench: $(BUILD)/bench_stealth $(BUILD)/bench_sitaiba \
+       $(BUILD)/ref/bench_stealth $(BUILD)/ref/bench_sitaiba
+	@for s in stealth sitaiba; do \
+	  echo "⏱️  $$s on $(BENCH_PARAM), ms per op (reference vs whole-program):"; \
+	  $(BUILD)/ref/bench_$$s $(BENCH_PARAM) $(BENCH_ITERS) > $(BUILD)/ref_$$s.csv || exit 1; \
+	  $(BUILD)/bench_$$s $(BENCH_PARAM) $(BENCH_ITERS) > $(BUILD)/lto_$$s.csv || exit 1; \
+	  awk -F, 'NR == FNR { ref[$$1] = $$3; next } FNR > 1 && ($$1 in ref) { \
+	    printf "  %-16s %10.4f %10.4f  %+6.1f%%\n", $$1, ref[$$1], $$3, 100 * ($$3 / ref[$$1] - 1) }' \
+	    $(BUILD)/ref_$$s.csv $(BUILD)/lto_$$s.csv; \
+	done
+
+clean-objs:
+	rm -rf $(BUILD)/pbc $(BUILD)/common $(BUILD)/stealth $(BUILD)/sitaiba
+
+clean:
+	rm -rf $(BUILD)
@@ -0,0 +1,109 @@
+// Timing of the SITAIBA core operations, used to compare library builds
+// (see lto.mk) and to train the profile-guided one.
+//
+// Usage: bench_sitaiba param_file [iterations]
+//
+// Prints one CSV line per operation: op,iterations,ms_per_op.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sitaiba_core.h"
+#include "perf_timer.h"
+
+enum { SCAN_BATCH = 64 };
+
+static void report(const char* op, int iters, double t0) {
+    printf("%s,%d,%.4f\n", op, iters, (perf_now_ms() - t0) / iters);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 2 ? atoi(argv[2]) : 200;
+    int i, ok = 0, scanned;
+    double t0;
+    int owned[SCAN_BATCH];
+    element_t A, B, aZ, bZ, A_m, a_m, Addr, R1, R2, dsk, B_out;
+    element_t sR1[SCAN_BATCH], sR2[SCAN_BATCH];
+    sitaiba_scan_ctx_t ctx;
+
+    if (argc < 2 || iters <= 0) {
+        fprintf(stderr, "usage: %s param_file [iterations]\n", argv[0]);
+        return 1;
+    }
+    if (sitaiba_init(argv[1]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[1]);
+        return 1;
+    }
+    pairing_t* p = sitaiba_get_pairing();
+
+    element_init_G1(A, *p);
+    element_init_G1(B, *p);
+    element_init_Zr(aZ, *p);
+    element_init_Zr(bZ, *p);
+    element_init_G1(A_m, *p);
+    element_init_Zr(a_m, *p);
+    element_init_G1(Addr, *p);
+    element_init_G1(R1, *p);
+    element_init_G1(R2, *p);
+    element_init_Zr(dsk, *p);
+    element_init_G1(B_out, *p);
+
+    printf("op,iterations,ms_per_op\n");
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) sitaiba_keygen(A, B, aZ, bZ);
+    report("keygen", iters, t0);
+    sitaiba_tracer_keygen(A_m, a_m);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) sitaiba_addr_gen(Addr, R1, R2, A, B, A_m);
+    report("addr_gen", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) ok += sitaiba_addr_recognize_fast(R1, R2, A, aZ);
+    report("recognize_fast", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) sitaiba_onetime_skgen(dsk, R1, aZ, bZ, A_m);
+    report("onetime_skgen", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) sitaiba_trace(B_out, Addr, R1, R2, a_m);
+    report("trace", iters, t0);
+    ok += !element_cmp(B_out, B);
+
+    // One thread, so the figure is per-core work rather than parallelism.
+    for (i = 0; i < SCAN_BATCH; i++) {
+        element_init_G1(sR1[i], *p);
+        element_init_G1(sR2[i], *p);
+        sitaiba_addr_gen(Addr, sR1[i], sR2[i], A, B, A_m);
+    }
+    sitaiba_scan_ctx_init(&ctx, A, aZ);
+    scanned = (iters + SCAN_BATCH - 1) / SCAN_BATCH * SCAN_BATCH;
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i += SCAN_BATCH) {
+        ok += sitaiba_scan_batch(&ctx, sR1, sR2, NULL, SCAN_BATCH, 1, owned);
+    }
+    report("scan_batch", scanned, t0);
+    sitaiba_scan_ctx_clear(&ctx);
+
+    for (i = 0; i < SCAN_BATCH; i++) {
+        element_clear(sR1[i]);
+        element_clear(sR2[i]);
+    }
+    element_clear(A);
+    element_clear(B);
+    element_clear(aZ);
+    element_clear(bZ);
+    element_clear(A_m);
+    element_clear(a_m);
+    element_clear(Addr);
+    element_clear(R1);
+    element_clear(R2);
+    element_clear(dsk);
+    element_clear(B_out);
+    sitaiba_cleanup();
+
+    // Every recognition, the trace and every scanned output above are genuine.
+    return ok == iters + 1 + scanned ? 0 : 1;
+}
@@ -0,0 +1,411 @@
+// Synthetic ledger generator and wallet sync replay for SITAIBA, for
+// benchmarking wallet sync on realistic datasets (see lto.mk).
+//
+// Usage: ledger_sitaiba gen param_file dir outputs [recipients] [owned] [threads]
+//        ledger_sitaiba replay param_file dir [threads]
+//
+// gen writes a ledger into dir in the store format of the Python API
+// (sitaiba_python_api.h): keys.store with recipients key pairs (default
+// 64), system.store with the generator and tracer key pair, and
+// addrs.store with the tagged outputs. A fraction owned (default 0.01)
+// of them, spread evenly, pays key record 0, the wallet; the others go
+// round-robin to the remaining recipients. Each output record carries
+// the key index of its recipient. Outputs are generated GEN_CHUNK at a
+// time by sitaiba_addr_gen_tagged, one range per thread (default: one
+// per online CPU).
+//
+// replay syncs the wallet the way a client would: the ledger is read
+// from the mapping REPLAY_CHUNK outputs at a time, scanned with
+// sitaiba_scan_batch on threads threads, and the one-time key of each
+// owned output is derived and appended to dsks.store. It then traces
+// every output with sitaiba_trace, one range per thread. Prints CSV;
+// found is the number of owned outputs for gen and sync, of outputs
+// traced to their recipient's B for trace. Exits nonzero if sync or
+// trace disagree with the ledger.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sitaiba_core.h"
+#include "sitaiba_store.h"
+#include "sitaiba_python_api.h"
+#include "scale_bench.h"
+#include "perf_timer.h"
+
+// Outputs generated, scanned or traced per call
+#define GEN_CHUNK 4096
+#define REPLAY_CHUNK 1024
+
+typedef struct {
+    char keys[1024], addrs[1024], dsks[1024], system[1024];
+} ledger_paths_t;
+
+static void ledger_paths(ledger_paths_t* p, const char* dir) {
+    snprintf(p->keys, sizeof(p->keys), "%s/keys.store", dir);
+    snprintf(p->addrs, sizeof(p->addrs), "%s/addrs.store", dir);
+    snprintf(p->dsks, sizeof(p->dsks), "%s/dsks.store", dir);
+    snprintf(p->system, sizeof(p->system), "%s/system.store", dir);
+}
+
+static element_t* elems_new(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
+
+static void elems_free(element_t* v, int n) {
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * Recipient of output i: the wallet (0) on an even spread of a fraction
+ * owned of the outputs, the others round-robin
+ */
+static int owner_of(long i, double owned, int recipients) {
+    if ((long)((i + 1) * owned) > (long)(i * owned)) return 0;
+    return 1 + (int)(i % (recipients - 1));
+}
+
+static void report(const char* phase, int threads, long n, long found, double ms) {
+    printf("sitaiba,%s,%d,%ld,%ld,%.1f,%.1f\n", phase, threads, n, found, ms,
+           ms > 0 ? n * 1000.0 / ms : 0);
+    fflush(stdout);
+}
+
+//----------------------------------------------
+// Generation
+//----------------------------------------------
+
+typedef struct {
+    element_t *A, *B, A_m;
+    element_t *Addr, *R1, *R2;
+    unsigned char* tags;
+    int* owner;
+} gen_chunk_t;
+
+static void gen_range(void* arg, int begin, int end) {
+    gen_chunk_t* g = (gen_chunk_t*)arg;
+
+    // A buffer of its own rather than the lock of the shared source
+    pbc_random_ctx_t rnd;
+    int bound = pbc_random_ctx_init_os(rnd) == 0;
+    pbc_random_ctx_ptr prev = bound ? pbc_random_ctx_bind(rnd) : NULL;
+
+    for (int i = begin; i < end; i++) {
+        sitaiba_addr_gen_tagged(g->Addr[i], g->R1[i], g->R2[i], g->tags + i * SITAIBA_VIEW_TAG_LEN,
+                                g->A[g->owner[i]], g->B[g->owner[i]], g->A_m);
+    }
+
+    if (bound) {
+        pbc_random_ctx_bind(prev);
+        pbc_random_ctx_clear(rnd);
+    }
+}
+
+static int generate(const char* dir, long n, int recipients, double owned, int threads) {
+    pairing_ptr p = *sitaiba_get_pairing();
+    ledger_paths_t paths;
+    gen_chunk_t g;
+    ledger_paths(&paths, dir);
+
+    int keys_h = sitaiba_store_open_simple(paths.keys, SITAIBA_STORE_KEYS);
+    int addrs_h = sitaiba_store_open_simple(paths.addrs, SITAIBA_STORE_ADDRS);
+    int system_h = sitaiba_store_open_simple(paths.system, SITAIBA_STORE_SYSTEM);
+    if (keys_h < 0 || addrs_h < 0 || system_h < 0) {
+        fprintf(stderr, "cannot open the stores in %s\n", dir);
+        return 1;
+    }
+    sitaiba_store_reset(keys_h);
+    sitaiba_store_reset(addrs_h);
+
+    element_t a_m;
+    element_init_G1(g.A_m, p);
+    element_init_Zr(a_m, p);
+    sitaiba_tracer_keygen(g.A_m, a_m);
+    unsigned char* A_m_bytes = malloc(sitaiba_wire_length(g.A_m));
+    unsigned char* a_m_bytes = malloc(sitaiba_wire_length(a_m));
+    sitaiba_wire_to_bytes(A_m_bytes, g.A_m);
+    sitaiba_wire_to_bytes(a_m_bytes, a_m);
+    sitaiba_store_save_system_simple(system_h, A_m_bytes, a_m_bytes);
+    free(A_m_bytes);
+    free(a_m_bytes);
+    element_clear(a_m);
+
+    // Key records A, B, a, b in the canonical encoding
+    g.A = elems_new(recipients, p->G1);
+    g.B = elems_new(recipients, p->G1);
+    element_t aZ, bZ;
+    element_init_Zr(aZ, p);
+    element_init_Zr(bZ, p);
+    unsigned char* rec = malloc(sitaiba_store_record_size(addrs_h) + sitaiba_store_record_size(keys_h));
+    for (int k = 0; k < recipients; k++) {
+        sitaiba_keygen(g.A[k], g.B[k], aZ, bZ);
+        int off = element_to_bytes(rec, g.A[k]);
+        off += element_to_bytes(rec + off, g.B[k]);
+        off += element_to_bytes(rec + off, aZ);
+        element_to_bytes(rec + off, bZ);
+        sitaiba_store_append(keys_h, rec);
+    }
+    element_clear(aZ);
+    element_clear(bZ);
+
+    g.Addr = elems_new(GEN_CHUNK, p->G1);
+    g.R1 = elems_new(GEN_CHUNK, p->G1);
+    g.R2 = elems_new(GEN_CHUNK, p->G1);
+    g.tags = malloc(GEN_CHUNK * SITAIBA_VIEW_TAG_LEN);
+    g.owner = malloc(GEN_CHUNK * sizeof(int));
+    long wallet = 0;
+
+    double t0 = perf_now_ms();
+    for (long base = 0; base < n; base += GEN_CHUNK) {
+        int m = (int)(n - base < GEN_CHUNK ? n - base : GEN_CHUNK);
+        for (int i = 0; i < m; i++) {
+            g.owner[i] = owner_of(base + i, owned, recipients);
+            wallet += g.owner[i] == 0;
+        }
+        scale_run_ranges(gen_range, &g, m, threads);
+
+        for (int i = 0; i < m; i++) {
+            // Output records keep their points compact
+            int off = sitaiba_compact_to_bytes(rec, g.Addr[i]);
+            off += sitaiba_compact_to_bytes(rec + off, g.R1[i]);
+            off += sitaiba_compact_to_bytes(rec + off, g.R2[i]);
+            put_u32(rec + off, (uint32_t)g.owner[i]);
+            rec[off + 4] = SITAIBA_STORE_FLAG_TAGGED;
+            memcpy(rec + off + 5, g.tags + i * SITAIBA_VIEW_TAG_LEN, SITAIBA_VIEW_TAG_LEN);
+            if (sitaiba_store_append(addrs_h, rec) < 0) {
+                fprintf(stderr, "cannot append to %s\n", paths.addrs);
+                n = base + i;
+                break;
+            }
+        }
+    }
+    sitaiba_store_sync(addrs_h);
+    report("gen", threads, n, wallet, perf_now_ms() - t0);
+
+    elems_free(g.Addr, GEN_CHUNK); elems_free(g.R1, GEN_CHUNK); elems_free(g.R2, GEN_CHUNK);
+    elems_free(g.A, recipients);
+    elems_free(g.B, recipients);
+    element_clear(g.A_m);
+    free(g.tags);
+    free(g.owner);
+    free(rec);
+    sitaiba_store_close(keys_h);
+    sitaiba_store_close(addrs_h);
+    sitaiba_store_close(system_h);
+    return 0;
+}
+
+//----------------------------------------------
+// Replay
+//----------------------------------------------
+
+typedef struct {
+    int keys_h, addrs_h, dsks_h;
+    int g1, meta;                // compact G1 point and metadata offset within an output record
+    element_t A_m, a_m;
+    long traced;
+    pthread_mutex_t lock;
+} replay_t;
+
+/**
+ * Scan the ledger for key record 0 and store the one-time key of each
+ * owned output
+ * @return Number of owned outputs found, -1 if one is not the wallet's
+ */
+static long sync_wallet(replay_t* r, long n, int threads) {
+    pairing_ptr p = *sitaiba_get_pairing();
+    element_t *R1 = elems_new(REPLAY_CHUNK, p->G1), *R2 = elems_new(REPLAY_CHUNK, p->G1);
+    unsigned char* tags = malloc(REPLAY_CHUNK * SITAIBA_VIEW_TAG_LEN);
+    int* owned = malloc(REPLAY_CHUNK * sizeof(int));
+    unsigned char* dsk_rec = malloc(sitaiba_store_record_size(r->dsks_h));
+    element_t A, B, aZ, bZ, dsk;
+    sitaiba_scan_ctx_t ctx;
+    long found = 0;
+
+    element_init_G1(A, p);
+    element_init_G1(B, p);
+    element_init_Zr(aZ, p);
+    element_init_Zr(bZ, p);
+    element_init_Zr(dsk, p);
+    unsigned char* key = (unsigned char*)sitaiba_store_record(r->keys_h, 0);
+    key += element_from_bytes(A, key);
+    key += element_from_bytes(B, key);
+    key += element_from_bytes(aZ, key);
+    element_from_bytes(bZ, key);
+    sitaiba_scan_ctx_init(&ctx, A, aZ);
+
+    for (long base = 0; base < n && found >= 0; base += REPLAY_CHUNK) {
+        int m = (int)(n - base < REPLAY_CHUNK ? n - base : REPLAY_CHUNK);
+        for (int i = 0; i < m; i++) {
+            unsigned char* rec = (unsigned char*)sitaiba_store_record(r->addrs_h, base + i);
+            sitaiba_compact_from_bytes(R1[i], rec + r->g1);
+            sitaiba_compact_from_bytes(R2[i], rec + 2 * r->g1);
+            memcpy(tags + i * SITAIBA_VIEW_TAG_LEN, rec + r->meta + 5, SITAIBA_VIEW_TAG_LEN);
+        }
+        int hits = sitaiba_scan_batch(&ctx, R1, R2, tags, m, threads, owned);
+        for (int j = 0; j < hits; j++) {
+            long addr = base + owned[j];
+            sitaiba_onetime_skgen(dsk, R1[owned[j]], aZ, bZ, r->A_m);
+            int off = element_to_bytes(dsk_rec, dsk);
+            put_u32(dsk_rec + off, (uint32_t)addr);
+            put_u32(dsk_rec + off + 4, 0);
+            dsk_rec[off + 8] = 0;
+            sitaiba_store_append(r->dsks_h, dsk_rec);
+            if (get_u32(sitaiba_store_record(r->addrs_h, addr) + r->meta) != 0) found = -1;
+        }
+        if (hits < 0) found = -1;
+        else if (found >= 0) found += hits;
+    }
+
+    sitaiba_scan_ctx_clear(&ctx);
+    element_clear(A); element_clear(B); element_clear(aZ); element_clear(bZ);
+    element_clear(dsk);
+    elems_free(R1, REPLAY_CHUNK);
+    elems_free(R2, REPLAY_CHUNK);
+    free(tags);
+    free(owned);
+    free(dsk_rec);
+    return found;
+}
+
+static void trace_range(void* arg, int begin, int end) {
+    replay_t* r = (replay_t*)arg;
+    pairing_ptr p = *sitaiba_get_pairing();
+    element_t Addr, R1, R2, B_out, B;
+    long traced = 0;
+
+    element_init_G1(Addr, p);
+    element_init_G1(R1, p);
+    element_init_G1(R2, p);
+    element_init_G1(B_out, p);
+    element_init_G1(B, p);
+    for (int i = begin; i < end; i++) {
+        unsigned char* rec = (unsigned char*)sitaiba_store_record(r->addrs_h, i);
+        sitaiba_compact_from_bytes(Addr, rec);
+        sitaiba_compact_from_bytes(R1, rec + r->g1);
+        sitaiba_compact_from_bytes(R2, rec + 2 * r->g1);
+        sitaiba_trace(B_out, Addr, R1, R2, r->a_m);
+
+        unsigned char* key = (unsigned char*)sitaiba_store_record(r->keys_h, get_u32(rec + r->meta));
+        if (!key) continue;
+        element_from_bytes(B, key + element_length_in_bytes(B));
+        traced += !element_cmp(B, B_out);
+    }
+    element_clear(Addr); element_clear(R1); element_clear(R2);
+    element_clear(B_out); element_clear(B);
+
+    pthread_mutex_lock(&r->lock);
+    r->traced += traced;
+    pthread_mutex_unlock(&r->lock);
+}
+
+static int replay(const char* dir, int threads) {
+    pairing_ptr p = *sitaiba_get_pairing();
+    ledger_paths_t paths;
+    replay_t r;
+    ledger_paths(&paths, dir);
+    memset(&r, 0, sizeof(r));
+
+    int system_h = sitaiba_store_open_simple(paths.system, SITAIBA_STORE_SYSTEM);
+    r.keys_h = sitaiba_store_open_simple(paths.keys, SITAIBA_STORE_KEYS);
+    r.addrs_h = sitaiba_store_open_simple(paths.addrs, SITAIBA_STORE_ADDRS);
+    r.dsks_h = sitaiba_store_open_simple(paths.dsks, SITAIBA_STORE_DSKS);
+    if (system_h < 0 || r.keys_h < 0 || r.addrs_h < 0 || r.dsks_h < 0 ||
+        sitaiba_store_count(r.keys_h) == 0) {
+        fprintf(stderr, "no ledger in %s (run gen first, with the same parameters)\n", dir);
+        return 1;
+    }
+    sitaiba_store_reset(r.dsks_h);
+
+    // The keys were made under the saved generator
+    int buf = pairing_length_in_bytes_G1(p) + pairing_length_in_bytes_Zr(p);
+    unsigned char *A_m_bytes = malloc(buf), *a_m_bytes = malloc(buf);
+    sitaiba_store_load_system_simple(system_h, A_m_bytes, a_m_bytes, buf);
+    element_init_G1(r.A_m, p);
+    element_init_Zr(r.a_m, p);
+    sitaiba_wire_from_bytes(r.A_m, A_m_bytes);
+    sitaiba_wire_from_bytes(r.a_m, a_m_bytes);
+    free(A_m_bytes);
+    free(a_m_bytes);
+    sitaiba_store_close(system_h);
+
+    r.g1 = pairing_length_in_bytes_compressed_G1(p);
+    r.meta = 3 * r.g1;
+    pthread_mutex_init(&r.lock, NULL);
+
+    long n = sitaiba_store_count(r.addrs_h), expected = 0;
+    for (long i = 0; i < n; i++) {
+        expected += get_u32(sitaiba_store_record(r.addrs_h, i) + r.meta) == 0;
+    }
+
+    double t0 = perf_now_ms();
+    long found = sync_wallet(&r, n, threads);
+    sitaiba_store_sync(r.dsks_h);
+    report("sync", threads, n, found, perf_now_ms() - t0);
+
+    t0 = perf_now_ms();
+    scale_run_ranges(trace_range, &r, (int)n, threads);
+    report("trace", threads, n, r.traced, perf_now_ms() - t0);
+
+    int failed = found != expected || sitaiba_store_count(r.dsks_h) != expected || r.traced != n;
+    if (failed) {
+        fprintf(stderr, "wrong results: %ld of %ld owned outputs found, %ld of %ld traced\n",
+                found, expected, r.traced, n);
+    }
+
+    element_clear(r.A_m);
+    element_clear(r.a_m);
+    pthread_mutex_destroy(&r.lock);
+    sitaiba_store_close(r.keys_h);
+    sitaiba_store_close(r.addrs_h);
+    sitaiba_store_close(r.dsks_h);
+    return failed;
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "usage: %s gen param_file dir outputs [recipients] [owned] [threads]\n"
+                    "       %s replay param_file dir [threads]\n", prog, prog);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int gen = argc > 1 && !strcmp(argv[1], "gen");
+    if (argc < 4 || (!gen && strcmp(argv[1], "replay")) || (gen && argc < 5)) return usage(argv[0]);
+
+    long n = gen ? atol(argv[4]) : 0;
+    int recipients = gen && argc > 5 ? atoi(argv[5]) : 64;
+    double owned = gen && argc > 6 ? atof(argv[6]) : 0.01;
+    int threads = argc > (gen ? 7 : 4) ? atoi(argv[gen ? 7 : 4]) : 0;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    if (gen && (n <= 0 || n > 0x7fffffff || recipients < 1 || owned < 0 || owned > 1 ||
+                (recipients == 1 && owned < 1))) {
+        fprintf(stderr, "outputs must be positive, owned in [0, 1], and recipients > 1 "
+                        "unless every output is owned\n");
+        return 1;
+    }
+    if (sitaiba_init(argv[2]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("scheme,phase,threads,outputs,found,ms,outputs_per_sec\n");
+    int rc = gen ? generate(argv[3], n, recipients, owned, threads) : replay(argv[3], threads);
+    sitaiba_cleanup();
+    return rc;
+}
@@ -0,0 +1,156 @@
+// Multi-core scaling of SITAIBA scanning and tracing on a fixed synthetic
+// ledger, for sizing scanning hosts (see lto.mk).
+//
+// Usage: scale_sitaiba param_file [outputs] [max_threads] [repeats]
+//
+// The ledger holds outputs paid round-robin to SCALE_RECIPIENTS key
+// pairs. Each operation runs over the whole ledger at 1, 2, 4, ...
+// max_threads threads (default: one per online CPU), best of repeats
+// runs:
+//
+//   scan    sitaiba_scan_batch for the first key pair
+//   trace   sitaiba_trace on one contiguous range per thread
+//
+// SITAIBA has no signatures, so there is no verify line. Prints CSV, see
+// scale_report. ledger_MBps counts the serialized output components an
+// operation reads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sitaiba_core.h"
+#include "scale_bench.h"
+
+enum { SCALE_RECIPIENTS = 8 };
+
+typedef struct {
+    int n;
+    element_t *Addr, *R1, *R2, *B_out;
+    element_t A[SCALE_RECIPIENTS], B[SCALE_RECIPIENTS];
+    element_t aZ[SCALE_RECIPIENTS], bZ[SCALE_RECIPIENTS];
+    element_t A_m, a_m;
+    sitaiba_scan_ctx_t ctx;
+    int* owned;
+    int matches;
+} ledger_t;
+
+static element_t* elems_new(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
+
+static void elems_free(element_t* v, int n) {
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+static void ledger_init(ledger_t* l, int n) {
+    pairing_ptr p = *sitaiba_get_pairing();
+
+    l->n = n;
+    l->Addr = elems_new(n, p->G1);
+    l->R1 = elems_new(n, p->G1);
+    l->R2 = elems_new(n, p->G1);
+    l->B_out = elems_new(n, p->G1);
+    l->owned = malloc((size_t)n * sizeof(int));
+
+    for (int k = 0; k < SCALE_RECIPIENTS; k++) {
+        element_init_G1(l->A[k], p);
+        element_init_G1(l->B[k], p);
+        element_init_Zr(l->aZ[k], p);
+        element_init_Zr(l->bZ[k], p);
+        sitaiba_keygen(l->A[k], l->B[k], l->aZ[k], l->bZ[k]);
+    }
+    element_init_G1(l->A_m, p);
+    element_init_Zr(l->a_m, p);
+    sitaiba_tracer_keygen(l->A_m, l->a_m);
+
+    for (int i = 0; i < n; i++) {
+        int k = i % SCALE_RECIPIENTS;
+        sitaiba_addr_gen(l->Addr[i], l->R1[i], l->R2[i], l->A[k], l->B[k], l->A_m);
+    }
+    sitaiba_scan_ctx_init(&l->ctx, l->A[0], l->aZ[0]);
+}
+
+static void ledger_clear(ledger_t* l) {
+    sitaiba_scan_ctx_clear(&l->ctx);
+    elems_free(l->Addr, l->n);
+    elems_free(l->R1, l->n);
+    elems_free(l->R2, l->n);
+    elems_free(l->B_out, l->n);
+    for (int k = 0; k < SCALE_RECIPIENTS; k++) {
+        element_clear(l->A[k]);
+        element_clear(l->B[k]);
+        element_clear(l->aZ[k]);
+        element_clear(l->bZ[k]);
+    }
+    element_clear(l->A_m);
+    element_clear(l->a_m);
+    free(l->owned);
+}
+
+static void run_scan(void* arg, int n, int threads) {
+    ledger_t* l = (ledger_t*)arg;
+    l->matches = sitaiba_scan_batch(&l->ctx, l->R1, l->R2, NULL, n, threads, l->owned);
+}
+
+static void trace_range(void* arg, int begin, int end) {
+    ledger_t* l = (ledger_t*)arg;
+    for (int i = begin; i < end; i++) {
+        sitaiba_trace(l->B_out[i], l->Addr[i], l->R1[i], l->R2[i], l->a_m);
+    }
+}
+
+static void run_trace(void* arg, int n, int threads) {
+    ledger_t* l = (ledger_t*)arg;
+    scale_run_ranges(trace_range, l, n, threads);
+    l->matches = 0;
+    for (int i = 0; i < n; i++) {
+        l->matches += !element_cmp(l->B_out[i], l->B[i % SCALE_RECIPIENTS]);
+    }
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 2 ? atoi(argv[2]) : 1024;
+    int max_threads = argc > 3 ? atoi(argv[3]) : 0;
+    int repeats = argc > 4 ? atoi(argv[4]) : 3;
+    int counts[SCALE_MAX_COUNTS], num_counts, failed = 0;
+    double copy_mbps[SCALE_MAX_COUNTS];
+    double base_scan = 0, base_trace = 0;
+    ledger_t l;
+
+    if (argc < 2 || n <= 0 || repeats <= 0) {
+        fprintf(stderr, "usage: %s param_file [outputs] [max_threads] [repeats]\n", argv[0]);
+        return 1;
+    }
+    if (sitaiba_init(argv[1]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "building a ledger of %d outputs...\n", n);
+    ledger_init(&l, n);
+
+    int g1 = sitaiba_element_size_G1();
+    int owned = (n + SCALE_RECIPIENTS - 1) / SCALE_RECIPIENTS;
+    num_counts = scale_thread_counts(max_threads, counts, SCALE_MAX_COUNTS);
+    for (int i = 0; i < num_counts; i++) copy_mbps[i] = scale_copy_bandwidth(counts[i]);
+
+    scale_report_header();
+    for (int i = 0; i < num_counts; i++) {
+        double ms = scale_time(run_scan, &l, n, counts[i], repeats);
+        if (i == 0) base_scan = n * 1000.0 / ms;
+        scale_report("sitaiba", "scan", counts[i], n, ms, base_scan, 2 * g1, copy_mbps[i]);
+        failed |= l.matches != owned;
+    }
+    for (int i = 0; i < num_counts; i++) {
+        double ms = scale_time(run_trace, &l, n, counts[i], repeats);
+        if (i == 0) base_trace = n * 1000.0 / ms;
+        scale_report("sitaiba", "trace", counts[i], n, ms, base_trace, 3 * g1, copy_mbps[i]);
+        failed |= l.matches != n;
+    }
+
+    ledger_clear(&l);
+    sitaiba_cleanup();
+    if (failed) fprintf(stderr, "wrong results: some operation did not check out\n");
+    return failed;
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+ * File: sitaiba_async.c
+ * Desc: Non-blocking submission API, see sitaiba_async.h
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "sitaiba_async.h"
+#include "sitaiba_python_api.h"
+#include "completion_queue.h"
+
+sitaiba_async_t* sitaiba_async_new(int num_threads, int capacity) {
+    return cq_new(num_threads, capacity);
+}
+
+void sitaiba_async_free(sitaiba_async_t* q) {
+    cq_free(q);
+}
+
+int sitaiba_async_fd(const sitaiba_async_t* q) {
+    return cq_fd(q);
+}
+
+int sitaiba_async_poll(sitaiba_async_t* q, long* tickets, int* results, int max) {
+    return cq_poll(q, tickets, results, max);
+}
+
+int sitaiba_async_wait(sitaiba_async_t* q, long* tickets, int* results, int max, int timeout_ms) {
+    return cq_wait(q, tickets, results, max, timeout_ms);
+}
+
+int sitaiba_async_pending(sitaiba_async_t* q) {
+    return cq_pending(q);
+}
+
+typedef struct {
+    const unsigned char *r1, *r2, *tags;
+    int n;
+    unsigned char *A_r, *a_r;
+    int num_threads;
+    int* owned;
+} scan_job_t;
+
+static int scan_work(void* arg) {
+    scan_job_t* j = (scan_job_t*)arg;
+    int rc = sitaiba_scan_batch_simple(j->r1, j->r2, j->tags, j->n, j->A_r, j->a_r,
+                                       j->num_threads, j->owned);
+    free(j);
+    return rc;
+}
+
+long sitaiba_async_scan_batch(sitaiba_async_t* q, const unsigned char* r1_bytes,
+                              const unsigned char* r2_bytes, const unsigned char* tags, int n,
+                              unsigned char* A_r_buf, unsigned char* a_r_buf, int num_threads,
+                              int* owned) {
+    scan_job_t* j = malloc(sizeof(scan_job_t));
+    if (!j) return -1;
+    *j = (scan_job_t){ r1_bytes, r2_bytes, tags, n, A_r_buf, a_r_buf, num_threads, owned };
+    long ticket = cq_submit(q, scan_work, j, NULL, NULL);
+    if (ticket < 0) free(j);
+    return ticket;
+}
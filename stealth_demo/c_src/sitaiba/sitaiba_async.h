@@ -0,0 +1,66 @@
+/****************************************************************************
+ * File: sitaiba_async.h
+ * Desc: Non-blocking submission API for SITAIBA scheme
+ *       Operations are queued to a pool and return a ticket at once;
+ *       results come back through a completion queue whose eventfd plugs
+ *       into an event loop. See completion_queue.h.
+ ****************************************************************************/
+
+#ifndef SITAIBA_ASYNC_H
+#define SITAIBA_ASYNC_H
+
+/**
+ * Opaque queue with its pool of worker threads
+ */
+typedef struct completion_queue_s sitaiba_async_t;
+
+/**
+ * Start a queue and its pool
+ * @param num_threads Pool threads, <= 0 for one per online CPU
+ * @param capacity Most operations submitted and not yet reaped, <= 0 for 1024
+ * @return New queue, NULL on failure
+ */
+sitaiba_async_t* sitaiba_async_new(int num_threads, int capacity);
+
+/**
+ * Finish every submitted operation, stop the pool and release the queue;
+ * completions not reaped are dropped
+ */
+void sitaiba_async_free(sitaiba_async_t* q);
+
+/**
+ * File descriptor that is readable while completions wait to be reaped
+ */
+int sitaiba_async_fd(const sitaiba_async_t* q);
+
+/**
+ * Reap up to max completions without waiting
+ * @param tickets Tickets of the finished operations (output)
+ * @param results Their return values, as from the blocking call (output)
+ * @return Number reaped
+ */
+int sitaiba_async_poll(sitaiba_async_t* q, long* tickets, int* results, int max);
+
+/**
+ * sitaiba_async_poll waiting up to timeout_ms (< 0 without limit) for the
+ * first completion
+ * @return Number reaped, 0 on timeout
+ */
+int sitaiba_async_wait(sitaiba_async_t* q, long* tickets, int* results, int max, int timeout_ms);
+
+/**
+ * Operations submitted and not yet reaped
+ */
+int sitaiba_async_pending(sitaiba_async_t* q);
+
+/**
+ * sitaiba_scan_batch_simple; its arguments must stay valid, and owned
+ * untouched, until the ticket completes with that call's return value
+ * @return Ticket (> 0), -1 if the queue is full
+ */
+long sitaiba_async_scan_batch(sitaiba_async_t* q, const unsigned char* r1_bytes,
+                              const unsigned char* r2_bytes, const unsigned char* tags, int n,
+                              unsigned char* A_r_buf, unsigned char* a_r_buf, int num_threads,
+                              int* owned);
+
+#endif /* SITAIBA_ASYNC_H */
@@ -10,24 +10,70 @@
 #include <stdlib.h>
 #include <string.h>
 #include <openssl/sha.h>
-#include <time.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "perf_timer.h"
+#include "perf_prim.h"
+#include "scratch.h"
+#include "pairing_tune.h"
+#include "pp_cache.h"
+#include "hash_stream.h"
+#include "seeded_random.h"
+#include "eph_pool.h"
+#include "batch_check.h"
+#include "param_file.h"
+#include "cpu_topo.h"
 
 //----------------------------------------------
 // Global Variables
 //----------------------------------------------
-static pairing_t pairing;
-static element_t g;              // Generator
-static element_t A_m, a_m;       // Manager key pair
+typedef struct {
+    char *path;                  // NULL while the slot is free
+    uint64_t hash;               // FNV-1a of the file contents
+    unsigned long last_used;
+    pairing_tune_t tune;         // empty when initialized without autotuning
+    char tuning[32];             // "<fp> <method>" of tune
+    pairing_t pairing;
+    element_t g;
+    element_pp_t g_pp;
+    element_t A_m, a_m;
+    pairing_pp_t A_m_pp;         // Miller-loop lines for e(., A_m)
+    int am_fold;                 // see am_pairing_pow
+    scratch_pool_t scratch;
+    pp_cache_t pp_cache;         // tables of recent R1 values
+} pairing_slot_t;
+
+// Initialized pairings by parameter file (SITAIBA_PAIRING_CACHE_SIZE)
+static pairing_slot_t pairing_cache[SITAIBA_PAIRING_CACHE_SIZE];
+static unsigned long pairing_clock = 0;
+
+// Active slot
+static pairing_ptr pairing;
+static element_ptr g;            // Generator
+static element_pp_ptr g_pp;      // Fixed-base table for g (SITAIBA_G_PP_WINDOW)
+static element_ptr A_m, a_m;     // Manager key pair
+static pairing_pp_ptr A_m_pp;    // Lines of A_m
+static int am_fold;              // Fold GT powers into G1 for A_m pairings
+static scratch_pool_t *scratch;  // Workspaces of the active pairing
+static pp_cache_t *pp_cache;     // R1 tables of the active pairing
+static int pp_cache_size = SITAIBA_PP_CACHE_SIZE;
+static eph_pool_t addr_pool;     // (r1, g^r1) for address generation
+static int eph_pool_size = SITAIBA_EPH_POOL_SIZE;
+static int eph_pool_live = 0;    // addr_pool initialized on the active pairing
+static const char *tuning;       // Configuration of the active pairing (pairing_tune.h)
 static int is_initialized = 0;
-
-// Performance counters (excluding hash time)
-static double sumAddrGen = 0;
-static double sumAddrVerify = 0; 
-static double sumFastAddrVerify = 0;
-static double sumOnetimeSK = 0;
-static double sumTrace = 0;
-static double sumH1 = 0;
-static double sumH2 = 0;
+static int point_format = SITAIBA_POINT_UNCOMPRESSED;
+static int validation = SITAIBA_VALIDATE_NONE;
+static int allocator = SITAIBA_ALLOC_MALLOC;
+
+// Performance counters (wall-clock ms, excluding hash time) and a
+// histogram of the per-call latencies
+enum {
+    PERF_ADDR_GEN, PERF_ADDR_RECOGNIZE, PERF_FAST_RECOGNIZE, PERF_ONETIME_SK,
+    PERF_TRACE, PERF_H1, PERF_H2
+};
+static perf_set_t perf_stats = PERF_HIST_SET_INITIALIZER;
 int perf_counter = 0;
 
 //----------------------------------------------
@@ -37,18 +83,158 @@ int perf_counter = 0;
 /**
  * Timer helper
  */
-static double timer_diff(clock_t start, clock_t end) {
-    return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0; // in ms
+static double timer_diff(double start, double end) {
+    return end - start; // in ms
 }
 
 /**
- * Hash to mpz helper
+ * g^z through the precomputed table when enabled
  */
-static void hash_to_mpz(mpz_t out, const unsigned char *data, size_t len, mpz_t mod) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(data, len, hash);
-    mpz_import(out, SHA256_DIGEST_LENGTH, 1, 1, 0, 0, hash);
-    mpz_mod(out, out, mod);
+static void g_pow_zn(element_t out, element_t z) {
+#if SITAIBA_G_PP_WINDOW > 0
+    prim_pp_pow_zn(out, z, g_pp);
+#else
+    prim_pow_zn(out, g, z);
+#endif
+}
+
+//----------------------------------------------
+// Powers by secret exponents, see SITAIBA_SECRET_CT
+//----------------------------------------------
+static void secret_pow_zn(element_t x, element_t a, element_t n) {
+#if SITAIBA_SECRET_CT
+    prim_pow_zn_ct(x, a, n);
+#else
+    prim_pow_zn(x, a, n);
+#endif
+}
+
+// x[i] = a[i]^n with one exponent for all m bases
+void sitaiba_secret_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m) {
+#if SITAIBA_SECRET_CT
+    for (int i = 0; i < m; i++) prim_pow_mpz_ct(x[i], a[i], n);
+#else
+    prim_pow_mpz_same(x, a, n, m);
+#endif
+}
+
+// x[i] = a[i]^n[i]
+static void secret_pow_mpz_batch(element_t x[], element_t a[], mpz_t n[], int m) {
+#if SITAIBA_SECRET_CT
+    for (int i = 0; i < m; i++) prim_pow_mpz_ct(x[i], a[i], n[i]);
+#else
+    prim_pow_mpz_batch(x, a, n, m);
+#endif
+}
+
+static void g_secret_pow_zn(element_t out, element_t z) {
+#if SITAIBA_SECRET_CT
+    prim_pow_zn_ct(out, g, z);
+#else
+    g_pow_zn(out, z);
+#endif
+}
+
+/**
+ * Precomputed ephemerals, see sitaiba_set_eph_pool
+ */
+static void fill_addr_ephemeral(element_ptr e[], void *ctx) {
+    (void)ctx;
+    element_random(e[0]);
+    g_pow_zn(e[1], e[0]);
+}
+
+static int eph_pool_start(void) {
+    field_ptr fields[] = { pairing->Zr, pairing->G1 };
+    eph_pool_live = 1;
+    return eph_pool_init(&addr_pool, fields, 2, eph_pool_size, fill_addr_ephemeral, NULL);
+}
+
+static void eph_pool_stop(void) {
+    if (!eph_pool_live) return;
+    eph_pool_clear(&addr_pool);
+    eph_pool_live = 0;
+}
+
+/**
+ * out = e(P, A_m_param)^z, through the lines of A_m when A_m_param is the
+ * manager key. With am_fold the power is taken in G1 as e(P^z, A_m),
+ * cheaper where GT powers cost more than G1 ones. Another key is paired
+ * plainly, or through cache when given. A secret z is raised to in
+ * constant time, see SITAIBA_SECRET_CT.
+ */
+static void am_pairing_pow(element_t out, element_t P, element_t z, int secret,
+                           element_t A_m_param, element_t tmp, pp_cache_t *cache) {
+    void (*pow_zn)(element_t, element_t, element_t) = secret ? secret_pow_zn : prim_pow_zn;
+    if (A_m_param != A_m && element_cmp(A_m_param, A_m)) {
+        if (cache) pp_cache_apply(out, P, A_m_param, cache);
+        else prim_pairing_apply(out, P, A_m_param, pairing);
+        pow_zn(out, out, z);
+    } else if (am_fold) {
+        pow_zn(tmp, P, z);
+        prim_pairing_pp_apply(out, tmp, A_m_pp);
+    } else {
+        prim_pairing_pp_apply(out, P, A_m_pp);
+        pow_zn(out, out, z);
+    }
+}
+
+/**
+ * Whether a power in G1 beats one in GT under the pairing of s, timed
+ * once per slot (best of two each)
+ */
+static int g1_pow_faster(pairing_slot_t *s) {
+    element_t p, e, z;
+    double g1_ms = 1e30, gt_ms = 1e30;
+    element_init_G1(p, s->pairing);
+    element_init_GT(e, s->pairing);
+    element_init_Zr(z, s->pairing);
+    element_random(p);
+    element_random(e);
+    element_random(z);
+    for (int i = 0; i < 2; i++) {
+        double t0 = perf_now_ms();
+        element_pow_zn(p, p, z);
+        double t1 = perf_now_ms();
+        element_pow_zn(e, e, z);
+        double t2 = perf_now_ms();
+        if (t1 - t0 < g1_ms) g1_ms = t1 - t0;
+        if (t2 - t1 < gt_ms) gt_ms = t2 - t1;
+    }
+    element_clear(p);
+    element_clear(e);
+    element_clear(z);
+    return g1_ms < gt_ms;
+}
+
+static void slot_clear(pairing_slot_t *s) {
+    if (!s->path) return;
+#if SITAIBA_G_PP_WINDOW > 0
+    element_pp_clear(s->g_pp);
+#endif
+    scratch_pool_clear(&s->scratch);
+    pp_cache_clear(&s->pp_cache);
+    pairing_pp_clear(s->A_m_pp);
+    element_clear(s->g);
+    element_clear(s->A_m);
+    element_clear(s->a_m);
+    pairing_clear(s->pairing);
+    free(s->path);
+    s->path = NULL;
+}
+
+static void slot_activate(pairing_slot_t *s) {
+    s->last_used = ++pairing_clock;
+    pairing = s->pairing;
+    tuning = s->tune.fp[0] ? s->tuning : NULL;
+    g = s->g;
+    g_pp = s->g_pp;
+    A_m = s->A_m;
+    a_m = s->a_m;
+    A_m_pp = s->A_m_pp;
+    am_fold = s->am_fold;
+    scratch = &s->scratch;
+    pp_cache = &s->pp_cache;
 }
 
 //----------------------------------------------
@@ -56,48 +242,64 @@ static void hash_to_mpz(mpz_t out, const unsigned char *data, size_t len, mpz_t
 //----------------------------------------------
 
 int sitaiba_init(const char* param_file) {
-    if (is_initialized) {
-        return 0; // Already initialized
-    }
+    is_initialized = 0;
+    eph_pool_stop();
+    if (allocator == SITAIBA_ALLOC_POOL) pbc_pool_enable();
 
-    // Initialize pairing from parameter file
-    FILE *fp = fopen(param_file, "r");
-    if (!fp) {
+    // Initialize pairing from parameter file, mapped whole and hashed once
+    const param_file_t *file = param_file_get(param_file);
+    if (!file) {
         return -1; // Cannot open parameter file
     }
     
-    // Read the entire file into a string
-    fseek(fp, 0, SEEK_END);
-    long fsize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    
-    char *param_str = malloc(fsize + 1);
-    if (!param_str) {
-        fclose(fp);
-        return -1;
+    // Switch to the cached pairing of this file if there is one
+    uint64_t hash = file->hash;
+    pairing_slot_t *victim = &pairing_cache[0];
+    for (int i = 0; i < SITAIBA_PAIRING_CACHE_SIZE; i++) {
+        pairing_slot_t *s = &pairing_cache[i];
+        if (s->path && s->hash == hash && strcmp(s->path, param_file) == 0 &&
+            (s->tune.fp[0] != '\0') == pairing_tune_enabled()) {
+            slot_activate(s);
+            if (pp_cache->capacity != pp_cache_size) pp_cache_set_capacity(pp_cache, pp_cache_size);
+            sitaiba_reset_performance();
+            eph_pool_start();
+            is_initialized = 1;
+            return 0;
+        }
+        if (victim->path && (!s->path || s->last_used < victim->last_used)) victim = s;
     }
-    
-    fread(param_str, fsize, 1, fp);
-    param_str[fsize] = '\0';
-    fclose(fp);
-    
-    if (pairing_init_set_str(pairing, param_str) != 0) {
-        free(param_str);
+
+    slot_clear(victim);
+    // set_buf rather than set_str: binary param files contain NUL bytes
+    if (pairing_init_tuned(victim->pairing, file->data, file->len, &victim->tune) != 0) {
         return -1;
     }
-    free(param_str);
+    snprintf(victim->tuning, sizeof(victim->tuning), "%s %s",
+             victim->tune.fp, victim->tune.method);
+    slot_activate(victim);
+
+    scratch_pool_init(scratch, pairing);
+    pp_cache_init(pp_cache, pairing, pp_cache_size);
 
     // Initialize generator
     element_init_G1(g, pairing);
     element_random(g);
+#if SITAIBA_G_PP_WINDOW > 0
+    element_pp_init_k(g_pp, g, SITAIBA_G_PP_WINDOW);
+#endif
 
     // Generate tracer key pair
     element_init_G1(A_m, pairing);
     element_init_Zr(a_m, pairing);
     sitaiba_tracer_keygen(A_m, a_m);
+    pairing_pp_init(A_m_pp, A_m, pairing);
+    am_fold = victim->am_fold = g1_pow_faster(victim);
+    victim->path = strdup(param_file);
+    victim->hash = hash;
 
     // Reset performance counters
     sitaiba_reset_performance();
+    eph_pool_start();
 
     is_initialized = 1;
     return 0;
@@ -108,64 +310,78 @@ int sitaiba_is_initialized(void) {
 }
 
 void sitaiba_cleanup(void) {
-    if (is_initialized) {
-        element_clear(g);
-        element_clear(A_m);
-        element_clear(a_m);
-        pairing_clear(pairing);
-        is_initialized = 0;
+    eph_pool_stop();
+    for (int i = 0; i < SITAIBA_PAIRING_CACHE_SIZE; i++) {
+        slot_clear(&pairing_cache[i]);
     }
+    param_file_drop();
+    is_initialized = 0;
 }
 
 void sitaiba_reset_performance(void) {
-    sumAddrGen = 0;
-    sumAddrVerify = 0;
-    sumFastAddrVerify = 0;
-    sumOnetimeSK = 0;
-    sumTrace = 0;
-    sumH1 = 0;
-    sumH2 = 0;
+    perf_reset(&perf_stats);
     perf_counter = 0;
+    if (pp_cache) pp_cache_reset_stats(pp_cache);
+    if (eph_pool_live) eph_pool_reset_stats(&addr_pool);
 }
 
 pairing_t* sitaiba_get_pairing(void) {
-    return is_initialized ? &pairing : NULL;
+    return is_initialized ? (pairing_t*)pairing : NULL;
 }
 
 //----------------------------------------------
 // Hash Functions (from original sitaiba.c)
 //----------------------------------------------
 
-void sitaiba_H1(element_t outZr, element_t inG1) {
-    clock_t t1 = clock();
-    unsigned char buf[1024];
-    size_t len = element_length_in_bytes(inG1);
-    element_to_bytes(buf, inG1);
-
-    mpz_t tmpz; 
-    mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len, pairing->r);
-    element_set_mpz(outZr, tmpz);
-    mpz_clear(tmpz);
+// Bodies of H1 / H2, the mpz temporary comes from the caller's workspace
+static void H1(scratch_t *ws, element_t outZr, element_t inG1) {
+    double t1 = perf_now_ms();
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, inG1);
+
+    hash_stream_end_zr(&h, outZr);
     
-    clock_t t2 = clock();
-    sumH1 += timer_diff(t1, t2);
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_H1, timer_diff(t1, t2));
 }
 
-void sitaiba_H2(element_t outZr, element_t inGT) {
-    clock_t t1 = clock();
-    unsigned char buf[2048];
-    size_t len = element_length_in_bytes(inGT);
-    element_to_bytes(buf, inGT);
-
-    mpz_t tmpz;
-    mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len, pairing->r);
-    element_set_mpz(outZr, tmpz);
-    mpz_clear(tmpz);
+static void H2(scratch_t *ws, element_t outZr, element_t inGT) {
+    double t1 = perf_now_ms();
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, inGT);
+
+    hash_stream_end_zr(&h, outZr);
     
-    clock_t t2 = clock();
-    sumH2 += timer_diff(t1, t2);
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_H2, timer_diff(t1, t2));
+}
+
+void sitaiba_H1(element_t outZr, element_t inG1) {
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return;
+    H1(ws, outZr, inG1);
+    scratch_put(scratch, ws);
+}
+
+void sitaiba_H2(element_t outZr, element_t inGT) {
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return;
+    H2(ws, outZr, inGT);
+    scratch_put(scratch, ws);
+}
+
+// View tag: SHA256("view" || shared point), truncated. Kept apart from
+// H1 so the tag reveals nothing about r2.
+void sitaiba_view_tag(unsigned char* tag, element_t shared) {
+    hash_stream_t h;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    hash_stream_begin(&h);
+    hash_stream_bytes(&h, "view", 4);
+    hash_stream_element(&h, shared);
+    hash_stream_end(&h, hash);
+    memcpy(tag, hash, SITAIBA_VIEW_TAG_LEN);
 }
 
 //----------------------------------------------
@@ -175,111 +391,107 @@ void sitaiba_H2(element_t outZr, element_t inGT) {
 void sitaiba_keygen(element_t A, element_t B, element_t aZ, element_t bZ) {
     element_random(aZ);
     element_random(bZ);
-    element_pow_zn(A, g, aZ);
-    element_pow_zn(B, g, bZ);
+    g_secret_pow_zn(A, aZ);
+    g_secret_pow_zn(B, bZ);
 }
 
 void sitaiba_tracer_keygen(element_t A_m_out, element_t a_m_out) {
     element_random(a_m_out);
-    element_pow_zn(A_m_out, g, a_m_out);
+    g_secret_pow_zn(A_m_out, a_m_out);
 }
 
-void sitaiba_addr_gen(element_t Addr, element_t R1, element_t R2,
-                     element_t A_r, element_t B_r, element_t A_m_param) {
-    clock_t t1 = clock();
+static void addr_gen_impl(element_t Addr, element_t R1, element_t R2, unsigned char* tag,
+                          element_t A_r, element_t B_r, element_t A_m_param) {
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return;
+
+    double t1 = perf_now_ms();
     
-    element_t r1, r2, r3, tmp;
-    element_init_Zr(r1, pairing);
-    element_init_Zr(r2, pairing);
-    element_init_Zr(r3, pairing);
-    element_init_GT(tmp, pairing);
+    element_ptr r1 = ws->zr[0], r2 = ws->zr[1], r3 = ws->zr[2], tmp = ws->gt[0];
 
-    element_random(r1);
-    element_pow_zn(R1, g, r1);
+    // r1 and R1 from the pool; a seeded thread draws its own to stay reproducible
+    element_ptr eph[] = { r1, R1 };
+    if (seeded_random_active() || !eph_pool_pop(&addr_pool, eph)) fill_addr_ephemeral(eph, NULL);
 
-    element_t Ar_pow_r1;
-    element_init_G1(Ar_pow_r1, pairing);
-    element_pow_zn(Ar_pow_r1, A_r, r1);
+    element_ptr Ar_pow_r1 = ws->g1[0];
+    prim_pow_zn(Ar_pow_r1, A_r, r1);
 
     // Measure hash time separately
-    clock_t h1_start = clock();
-    sitaiba_H1(r2, Ar_pow_r1);  // This adds to sumH1 internally
-    clock_t h1_end = clock();
+    double h1_start = perf_now_ms();
+    H1(ws, r2, Ar_pow_r1);  // This adds to PERF_H1 internally
+    if (tag) sitaiba_view_tag(tag, Ar_pow_r1);
+    double h1_end = perf_now_ms();
     double h1_time = timer_diff(h1_start, h1_end);
 
-    element_pow_zn(R2, A_r, r2);
+    prim_pow_zn(R2, A_r, r2);
 
-    element_t eR2Am;
-    element_init_GT(eR2Am, pairing);
-    pairing_apply(eR2Am, R2, A_m_param, pairing);
-    element_pow_zn(tmp, eR2Am, r1);
+    am_pairing_pow(tmp, R2, r1, 0, A_m_param, ws->g1[1], NULL);
     
     // Measure hash time separately  
-    clock_t h2_start = clock();
-    sitaiba_H2(r3, tmp);  // This adds to sumH2 internally
-    clock_t h2_end = clock();
+    double h2_start = perf_now_ms();
+    H2(ws, r3, tmp);  // This adds to PERF_H2 internally
+    double h2_end = perf_now_ms();
     double h2_time = timer_diff(h2_start, h2_end);
 
-    element_t r3G, sum;
-    element_init_G1(r3G, pairing);
-    element_init_G1(sum, pairing);
-    element_pow_zn(r3G, g, r3);
+    element_ptr r3G = ws->g1[1], sum = ws->g1[2];
+    g_pow_zn(r3G, r3);
 
     element_mul(sum, r3G, R2);
     element_mul(Addr, sum, B_r);
 
-    // Cleanup
-    element_clear(r1); element_clear(r2); element_clear(r3);
-    element_clear(tmp); element_clear(Ar_pow_r1); element_clear(eR2Am);
-    element_clear(r3G); element_clear(sum);
-
-    clock_t t2 = clock();
+    double t2 = perf_now_ms();
     // Subtract hash computation time from total
     double total_time = timer_diff(t1, t2);
-    sumAddrGen += (total_time - h1_time - h2_time);
+    perf_add(&perf_stats, PERF_ADDR_GEN, total_time - h1_time - h2_time);
+
+    scratch_put(scratch, ws);
+}
+
+void sitaiba_addr_gen(element_t Addr, element_t R1, element_t R2,
+                     element_t A_r, element_t B_r, element_t A_m_param) {
+    addr_gen_impl(Addr, R1, R2, NULL, A_r, B_r, A_m_param);
+}
+
+void sitaiba_addr_gen_tagged(element_t Addr, element_t R1, element_t R2,
+                             unsigned char* view_tag, element_t A_r, element_t B_r,
+                             element_t A_m_param) {
+    if (!view_tag) return;
+    addr_gen_impl(Addr, R1, R2, view_tag, A_r, B_r, A_m_param);
 }
 
 int sitaiba_addr_recognize(element_t Addr, element_t R1, element_t R2,
                        element_t A_r, element_t B_r, element_t A_m_param, element_t a_r) {
-    clock_t t1 = clock();
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
 
     // Step 1: r2 = H1(a_r * R1)
-    element_t R1_pow_a, r2Z;
-    element_init_G1(R1_pow_a, pairing);
-    element_init_Zr(r2Z, pairing);
-    element_pow_zn(R1_pow_a, R1, a_r);
+    element_ptr R1_pow_a = ws->g1[0], r2Z = ws->zr[0];
+    secret_pow_zn(R1_pow_a, R1, a_r);
     
-    clock_t h1_start = clock();
-    sitaiba_H1(r2Z, R1_pow_a);
-    clock_t h1_end = clock();
+    double h1_start = perf_now_ms();
+    H1(ws, r2Z, R1_pow_a);
+    double h1_end = perf_now_ms();
     double h1_time = timer_diff(h1_start, h1_end);
 
     // Step 2: R2' = r2 * A_r
-    element_t R2_prime, r2a;
-    element_init_G1(R2_prime, pairing);
-    element_init_Zr(r2a, pairing);
-    element_pow_zn(R2_prime, A_r, r2Z);
+    element_ptr R2_prime = ws->g1[1], r2a = ws->zr[1];
+    prim_pow_zn(R2_prime, A_r, r2Z);
     element_mul(r2a, r2Z, a_r);
 
     // Step 3: r3 = H2(e(R1, A_m)^r2a)
-    element_t eR1Am, r3Z, tmp;
-    element_init_GT(eR1Am, pairing);
-    element_init_GT(tmp, pairing);
-    element_init_Zr(r3Z, pairing);
-    pairing_apply(eR1Am, R1, A_m_param, pairing);
-    element_pow_zn(tmp, eR1Am, r2a);
+    element_ptr tmp = ws->gt[0], r3Z = ws->zr[2];
+    am_pairing_pow(tmp, R1, r2a, 1, A_m_param, ws->g1[2], pp_cache);
     
-    clock_t h2_start = clock();
-    sitaiba_H2(r3Z, tmp);
-    clock_t h2_end = clock();
+    double h2_start = perf_now_ms();
+    H2(ws, r3Z, tmp);
+    double h2_end = perf_now_ms();
     double h2_time = timer_diff(h2_start, h2_end);
 
     // Step 4: reconstruct Addr = r3 * G + R2 + B_r
-    element_t r3G, sum, Addr_reconstructed;
-    element_init_G1(r3G, pairing);
-    element_init_G1(sum, pairing);
-    element_init_G1(Addr_reconstructed, pairing);
-    element_pow_zn(r3G, g, r3Z);
+    element_ptr r3G = ws->g1[2], sum = ws->g1[3], Addr_reconstructed = ws->g1[4];
+    g_pow_zn(r3G, r3Z);
     element_mul(sum, r3G, R2);
     element_mul(Addr_reconstructed, sum, B_r);
     
@@ -287,124 +499,517 @@ int sitaiba_addr_recognize(element_t Addr, element_t R1, element_t R2,
     int eq2 = (element_cmp(Addr_reconstructed, Addr) == 0);
     int result = eq1 && eq2;
 
-    // Cleanup
-    element_clear(R1_pow_a); element_clear(r2Z);
-    element_clear(R2_prime); element_clear(r2a);
-    element_clear(eR1Am); element_clear(r3Z); element_clear(tmp);
-    element_clear(r3G); element_clear(sum); element_clear(Addr_reconstructed);
-
-    clock_t t2 = clock();
+    double t2 = perf_now_ms();
     // Subtract hash computation time from total
     double total_time = timer_diff(t1, t2);
-    sumAddrVerify += (total_time - h1_time - h2_time);
+    perf_add(&perf_stats, PERF_ADDR_RECOGNIZE, total_time - h1_time - h2_time);
+
+    scratch_put(scratch, ws);
     
     return result;
 }
 
+int sitaiba_addr_audit_batch(element_t Addr[], element_t R1[], element_t R2[], int n,
+                             element_t A_r, element_t B_r, element_t A_m_param,
+                             element_t a_r, unsigned char *results) {
+    if (!is_initialized || n <= 0 || !results) return -1;
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return -1;
+
+    element_vec_t r2Z, r3Z, D;
+    element_vec_init(r2Z, pairing->Zr, n);
+    element_vec_init(r3Z, pairing->Zr, n);
+    element_vec_init(D, pairing->G1, n);
+
+    double t1 = perf_now_ms();
+    double hash_time = 0;
+    element_ptr R1_pow_a = ws->g1[0], R2B = ws->g1[1], r2a = ws->zr[0], tmp = ws->gt[0];
+
+    // r3 hashes a pairing value, so each address keeps its pairing, on
+    // the lines of A_m; the rest reduces to D = Addr / (R2 * B)
+    for (int i = 0; i < n; i++) {
+        secret_pow_zn(R1_pow_a, R1[i], a_r);
+        double hash_start = perf_now_ms();
+        H1(ws, r2Z->item[i], R1_pow_a);
+        hash_time += timer_diff(hash_start, perf_now_ms());
+
+        element_mul(r2a, r2Z->item[i], a_r);
+        am_pairing_pow(tmp, R1[i], r2a, 1, A_m_param, ws->g1[2], pp_cache);
+        hash_start = perf_now_ms();
+        H2(ws, r3Z->item[i], tmp);
+        hash_time += timer_diff(hash_start, perf_now_ms());
+
+        element_mul(R2B, R2[i], B_r);
+        element_div(D->item[i], Addr[i], R2B);
+        results[i] = 1;
+    }
+
+    // R2 = A^r2 and D = g^r3, batched over the whole set
+    batch_check_pow(R2, A_r, r2Z->item, n, results);
+    batch_check_pow(D->item, g, r3Z->item, n, results);
+
+    int valid = 0;
+    for (int i = 0; i < n; i++) valid += results[i];
+
+    perf_add(&perf_stats, PERF_ADDR_RECOGNIZE, timer_diff(t1, perf_now_ms()) - hash_time);
+    element_vec_clear(r2Z);
+    element_vec_clear(r3Z);
+    element_vec_clear(D);
+    scratch_put(scratch, ws);
+    return valid;
+}
+
 int sitaiba_addr_recognize_fast(element_t R1, element_t R2, element_t A_r, element_t a_r) {
-    clock_t t1 = clock();
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
 
     // Step 1: r2 = H1(a_r * R1)
-    element_t R1_pow_a, r2Z;
-    element_init_G1(R1_pow_a, pairing);
-    element_init_Zr(r2Z, pairing);
-    element_pow_zn(R1_pow_a, R1, a_r);
+    element_ptr R1_pow_a = ws->g1[0], r2Z = ws->zr[0];
+    secret_pow_zn(R1_pow_a, R1, a_r);
     
-    clock_t h1_start = clock();
-    sitaiba_H1(r2Z, R1_pow_a);
-    clock_t h1_end = clock();
+    double h1_start = perf_now_ms();
+    H1(ws, r2Z, R1_pow_a);
+    double h1_end = perf_now_ms();
     double h1_time = timer_diff(h1_start, h1_end);
 
     // Step 2: R2' = r2 * A_r
-    element_t R2_prime;
-    element_init_G1(R2_prime, pairing);
-    element_pow_zn(R2_prime, A_r, r2Z);
+    element_ptr R2_prime = ws->g1[1];
+    prim_pow_zn(R2_prime, A_r, r2Z);
 
     int result = (element_cmp(R2_prime, R2) == 0);
 
-    // Cleanup
-    element_clear(R1_pow_a); element_clear(r2Z); element_clear(R2_prime);
-
-    clock_t t2 = clock();
+    double t2 = perf_now_ms();
     // Subtract hash computation time from total
     double total_time = timer_diff(t1, t2);
-    sumFastAddrVerify += (total_time - h1_time);
+    perf_add(&perf_stats, PERF_FAST_RECOGNIZE, total_time - h1_time);
+
+    scratch_put(scratch, ws);
     
     return result;
 }
 
+int sitaiba_addr_recognize_fast_tagged(element_t R1, element_t R2, element_t A_r,
+                                       const unsigned char* view_tag, element_t a_r) {
+    if (!view_tag) return 0;
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
+
+    element_ptr R1_pow_a = ws->g1[0];
+    secret_pow_zn(R1_pow_a, R1, a_r);
+
+    double h1_start = perf_now_ms();
+    unsigned char tag[SITAIBA_VIEW_TAG_LEN];
+    sitaiba_view_tag(tag, R1_pow_a);
+    int result = memcmp(tag, view_tag, SITAIBA_VIEW_TAG_LEN) == 0;
+
+    element_ptr r2Z = ws->zr[0];
+    if (result) H1(ws, r2Z, R1_pow_a);
+    double h1_end = perf_now_ms();
+    double h1_time = timer_diff(h1_start, h1_end);
+
+    // Only outputs that pass the tag pay for R2' = r2 * A_r
+    if (result) {
+        element_ptr R2_prime = ws->g1[1];
+        prim_pow_zn(R2_prime, A_r, r2Z);
+        result = (element_cmp(R2_prime, R2) == 0);
+    }
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_FAST_RECOGNIZE, timer_diff(t1, t2) - h1_time);
+
+    scratch_put(scratch, ws);
+
+    return result;
+}
+
+int sitaiba_scan_ctx_init(sitaiba_scan_ctx_t *ctx, element_t A_r, element_t a_r) {
+    if (!is_initialized || !ctx) return -1;
+    element_init_G1(ctx->A_r, pairing);
+    element_set(ctx->A_r, A_r);
+    element_pp_init_k(ctx->A_pp, ctx->A_r, SITAIBA_G_PP_WINDOW);
+    mpz_init(ctx->a);
+    element_to_mpz(ctx->a, a_r);
+    return 0;
+}
+
+void sitaiba_scan_ctx_clear(sitaiba_scan_ctx_t *ctx) {
+    if (!ctx) return;
+    element_pp_clear(ctx->A_pp);
+    element_clear(ctx->A_r);
+    mpz_clear(ctx->a);
+}
+
+typedef struct {
+    pthread_t tid;
+    sitaiba_scan_ctx_t *ctx;
+    element_t *R1;
+    element_t *R2;
+    const unsigned char *view_tags;
+    unsigned char *hits;
+    int begin, end;
+    int found;                   // -1 without a workspace
+} scan_batch_job_t;
+
+static void *scan_batch_worker(void *arg) {
+    scan_batch_job_t *job = (scan_batch_job_t *)arg;
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) {
+        job->found = -1;
+        return NULL;
+    }
+
+    element_ptr R2_prime = ws->g1[1], r2Z = ws->zr[0];
+    hash_stream_t h;
+
+    // R1^a_r for a chunk of outputs at a time, one exponent for all
+    element_t R1_pow_a[SITAIBA_SCAN_CHUNK];
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) element_init_G1(R1_pow_a[j], pairing);
+
+    job->found = 0;
+    for (int base = job->begin; base < job->end; base += SITAIBA_SCAN_CHUNK) {
+        int m = job->end - base < SITAIBA_SCAN_CHUNK ? job->end - base : SITAIBA_SCAN_CHUNK;
+        sitaiba_secret_pow_mpz_same(R1_pow_a, job->R1 + base, job->ctx->a, m);
+
+        for (int j = 0; j < m; j++) {
+            int i = base + j;
+            if (job->view_tags) {
+                unsigned char tag[SITAIBA_VIEW_TAG_LEN];
+                sitaiba_view_tag(tag, R1_pow_a[j]);
+                if (memcmp(tag, job->view_tags + (size_t)i * SITAIBA_VIEW_TAG_LEN,
+                           SITAIBA_VIEW_TAG_LEN) != 0)
+                    continue;
+            }
+
+            // r2 = H1(R1^a_r), without the H1 counters
+            hash_stream_begin(&h);
+            hash_stream_element(&h, R1_pow_a[j]);
+            hash_stream_end_zr(&h, r2Z);
+
+            prim_pp_pow_zn(R2_prime, r2Z, job->ctx->A_pp);
+            if (element_cmp(R2_prime, job->R2[i]) == 0) {
+                job->hits[i] = 1;
+                job->found++;
+            }
+        }
+    }
+
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) element_clear(R1_pow_a[j]);
+    scratch_put(scratch, ws);
+    return NULL;
+}
+
+int sitaiba_scan_batch(sitaiba_scan_ctx_t *ctx, element_t R1[], element_t R2[],
+                       const unsigned char *view_tags, int n, int num_threads, int *owned) {
+    if (!is_initialized || !ctx || n < 0 || !owned) return -1;
+    if (n == 0) return 0;
+
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (num_threads > n) num_threads = n;
+
+    scan_batch_job_t *jobs = calloc(num_threads, sizeof(scan_batch_job_t));
+    unsigned char *hits = calloc(n, 1);
+    if (!jobs || !hits) {
+        free(jobs);
+        free(hits);
+        return -1;
+    }
+
+    int per = (n + num_threads - 1) / num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        scan_batch_job_t *job = &jobs[i];
+        job->ctx = ctx;
+        job->R1 = R1;
+        job->R2 = R2;
+        job->view_tags = view_tags;
+        job->hits = hits;
+        job->begin = i * per < n ? i * per : n;
+        job->end = (i + 1) * per < n ? (i + 1) * per : n;
+    }
+
+    // Job 0 runs on the calling thread, as do jobs whose thread failed to start
+    int started = 1;
+    while (started < num_threads &&
+           cpu_topo_create(&jobs[started].tid, started, num_threads, scan_batch_worker,
+                           &jobs[started]) == 0)
+        started++;
+    scan_batch_worker(&jobs[0]);
+    for (int i = started; i < num_threads; i++) scan_batch_worker(&jobs[i]);
+
+    int found = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (i > 0 && i < started) pthread_join(jobs[i].tid, NULL);
+        if (jobs[i].found < 0) found = -1;
+        else if (found >= 0) found += jobs[i].found;
+    }
+    if (found >= 0) {
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+            if (hits[i]) owned[k++] = i;
+        }
+    }
+    free(jobs);
+    free(hits);
+    return found;
+}
+
 void sitaiba_onetime_skgen(element_t dsk, element_t R1, element_t a_r, 
                           element_t b_r, element_t A_m_param) {
-    clock_t t1 = clock();
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return;
+
+    double t1 = perf_now_ms();
     
-    element_t r2, r3, eR1Am;
-    element_init_Zr(r2, pairing);
-    element_init_Zr(r3, pairing);
-    element_init_GT(eR1Am, pairing);
-
-    element_t R1_a, r2a;
-    element_init_G1(R1_a, pairing);
-    element_init_Zr(r2a, pairing);
-    element_pow_zn(R1_a, R1, a_r);
+    element_ptr r2 = ws->zr[0], r3 = ws->zr[1], eR1Am = ws->gt[0];
+
+    element_ptr R1_a = ws->g1[0], r2a = ws->zr[2];
+    secret_pow_zn(R1_a, R1, a_r);
     
-    clock_t h1_start = clock();
-    sitaiba_H1(r2, R1_a);
-    clock_t h1_end = clock();
+    double h1_start = perf_now_ms();
+    H1(ws, r2, R1_a);
+    double h1_end = perf_now_ms();
     double h1_time = timer_diff(h1_start, h1_end);
 
-    pairing_apply(eR1Am, R1, A_m_param, pairing);
     element_mul(r2a, r2, a_r);
-    element_pow_zn(eR1Am, eR1Am, r2a);
+    am_pairing_pow(eR1Am, R1, r2a, 1, A_m_param, ws->g1[1], pp_cache);
 
-    clock_t h2_start = clock();
-    sitaiba_H2(r3, eR1Am);
-    clock_t h2_end = clock();
+    double h2_start = perf_now_ms();
+    H2(ws, r3, eR1Am);
+    double h2_end = perf_now_ms();
     double h2_time = timer_diff(h2_start, h2_end);
 
     // DSK is in Zr: compute r3 + r2*a + b
     element_add(dsk, r3, r2a);
     element_add(dsk, dsk, b_r);
-
-    // Cleanup
-    element_clear(r2); element_clear(r3); element_clear(eR1Am);
-    element_clear(R1_a); element_clear(r2a);
     
-    clock_t t2 = clock();
+    double t2 = perf_now_ms();
     // Subtract hash computation time from total
     double total_time = timer_diff(t1, t2);
-    sumOnetimeSK += (total_time - h1_time - h2_time);
+    perf_add(&perf_stats, PERF_ONETIME_SK, total_time - h1_time - h2_time);
+
+    scratch_put(scratch, ws);
+}
+
+typedef struct {
+    pthread_t tid;
+    element_t *dsk;
+    element_t *R1;
+    element_ptr a_r, b_r, A_m;   // A_m NULL for the key of the active pairing
+    mpz_ptr a;                   // a_r as an integer
+    int begin, end;
+    int status;                  // -1 without a workspace
+} skgen_batch_job_t;
+
+static void *skgen_batch_worker(void *arg) {
+    skgen_batch_job_t *job = (skgen_batch_job_t *)arg;
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) {
+        job->status = -1;
+        return NULL;
+    }
+
+    element_ptr r3 = ws->zr[1];
+    hash_stream_t h;
+
+    // Per chunk: R1^a_r with one exponent, then the e(., A_m) Miller loops
+    // from the lines of A_m, whose final exponentiations run together
+    element_t R1_pow_a[SITAIBA_SCAN_CHUNK], P[SITAIBA_SCAN_CHUNK];
+    element_t e[SITAIBA_SCAN_CHUNK], r2a[SITAIBA_SCAN_CHUNK];
+    mpz_t z[SITAIBA_SCAN_CHUNK];
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) {
+        element_init_G1(R1_pow_a[j], pairing);
+        element_init_G1(P[j], pairing);
+        element_init_GT(e[j], pairing);
+        element_init_Zr(r2a[j], pairing);
+        mpz_init(z[j]);
+    }
+
+    for (int base = job->begin; base < job->end; base += SITAIBA_SCAN_CHUNK) {
+        int m = job->end - base < SITAIBA_SCAN_CHUNK ? job->end - base : SITAIBA_SCAN_CHUNK;
+        element_t *R1 = job->R1 + base;
+        sitaiba_secret_pow_mpz_same(R1_pow_a, R1, job->a, m);
+
+        // r2 a_r with r2 = H1(R1^a_r), without the H1 counters
+        for (int j = 0; j < m; j++) {
+            hash_stream_begin(&h);
+            hash_stream_element(&h, R1_pow_a[j]);
+            hash_stream_end_zr(&h, r2a[j]);
+            element_mul(r2a[j], r2a[j], job->a_r);
+            element_to_mpz(z[j], r2a[j]);
+        }
+
+        if (job->A_m) {
+            for (int j = 0; j < m; j++)
+                am_pairing_pow(e[j], R1[j], r2a[j], 1, job->A_m, ws->g1[1], pp_cache);
+        } else if (am_fold) {
+            secret_pow_mpz_batch(P, R1, z, m);
+            for (int j = 0; j < m; j++) prim_pairing_pp_apply_unreduced(e[j], P[j], A_m_pp);
+            element_gt_reduce_batch(e, m);
+        } else {
+            for (int j = 0; j < m; j++) prim_pairing_pp_apply_unreduced(e[j], R1[j], A_m_pp);
+            element_gt_reduce_batch(e, m);
+            secret_pow_mpz_batch(e, e, z, m);
+        }
+
+        // dsk = H2(e(R1, A_m)^(r2 a_r)) + r2 a_r + b_r, without the H2 counters
+        for (int j = 0; j < m; j++) {
+            element_ptr dsk = job->dsk[base + j];
+            hash_stream_begin(&h);
+            hash_stream_element(&h, e[j]);
+            hash_stream_end_zr(&h, r3);
+            element_add(dsk, r3, r2a[j]);
+            element_add(dsk, dsk, job->b_r);
+        }
+    }
+
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) {
+        element_clear(R1_pow_a[j]);
+        element_clear(P[j]);
+        element_clear(e[j]);
+        element_clear(r2a[j]);
+        mpz_clear(z[j]);
+    }
+    scratch_put(scratch, ws);
+    job->status = 0;
+    return NULL;
+}
+
+int sitaiba_onetime_skgen_batch(element_t dsk[], element_t R1[], int n, element_t a_r,
+                                element_t b_r, element_t A_m_param, int num_threads) {
+    if (!is_initialized || n < 0 || (n > 0 && (!dsk || !R1))) return -1;
+    if (n == 0) return 0;
+
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (num_threads > n) num_threads = n;
+
+    skgen_batch_job_t *jobs = calloc(num_threads, sizeof(skgen_batch_job_t));
+    if (!jobs) return -1;
+
+    mpz_t a;
+    mpz_init(a);
+    element_to_mpz(a, a_r);
+    element_ptr foreign = A_m_param != A_m && element_cmp(A_m_param, A_m) ? A_m_param : NULL;
+
+    int per = (n + num_threads - 1) / num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        skgen_batch_job_t *job = &jobs[i];
+        job->dsk = dsk;
+        job->R1 = R1;
+        job->a_r = a_r;
+        job->b_r = b_r;
+        job->A_m = foreign;
+        job->a = a;
+        job->begin = i * per < n ? i * per : n;
+        job->end = (i + 1) * per < n ? (i + 1) * per : n;
+    }
+
+    // Job 0 runs on the calling thread, as do jobs whose thread failed to start
+    int started = 1;
+    while (started < num_threads &&
+           cpu_topo_create(&jobs[started].tid, started, num_threads, skgen_batch_worker,
+                           &jobs[started]) == 0)
+        started++;
+    skgen_batch_worker(&jobs[0]);
+    for (int i = started; i < num_threads; i++) skgen_batch_worker(&jobs[i]);
+
+    int rc = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (i > 0 && i < started) pthread_join(jobs[i].tid, NULL);
+        if (jobs[i].status < 0) rc = -1;
+    }
+    mpz_clear(a);
+    free(jobs);
+    return rc;
+}
+
+int sitaiba_recognize_and_derive(element_t dsk, element_t R1, element_t R2, element_t A_r,
+                                 const unsigned char* view_tag, element_t a_r,
+                                 element_t b_r, element_t A_m_param) {
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
+
+    element_ptr R1_pow_a = ws->g1[0], r2Z = ws->zr[0];
+    secret_pow_zn(R1_pow_a, R1, a_r);
+
+    double h1_start = perf_now_ms();
+    int result = 1;
+    if (view_tag) {
+        unsigned char tag[SITAIBA_VIEW_TAG_LEN];
+        sitaiba_view_tag(tag, R1_pow_a);
+        result = memcmp(tag, view_tag, SITAIBA_VIEW_TAG_LEN) == 0;
+    }
+    if (result) H1(ws, r2Z, R1_pow_a);
+    double h1_end = perf_now_ms();
+
+    if (result) {
+        element_ptr R2_prime = ws->g1[1];
+        prim_pow_zn(R2_prime, A_r, r2Z);
+        result = (element_cmp(R2_prime, R2) == 0);
+    }
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_FAST_RECOGNIZE, timer_diff(t1, t2) - timer_diff(h1_start, h1_end));
+
+    // The rest of sitaiba_onetime_skgen, from the same r2
+    if (result) {
+        element_ptr r3 = ws->zr[1], r2a = ws->zr[2], eR1Am = ws->gt[0];
+        element_mul(r2a, r2Z, a_r);
+        am_pairing_pow(eR1Am, R1, r2a, 1, A_m_param, ws->g1[1], pp_cache);
+
+        double h2_start = perf_now_ms();
+        H2(ws, r3, eR1Am);
+        double h2_end = perf_now_ms();
+
+        element_add(dsk, r3, r2a);
+        element_add(dsk, dsk, b_r);
+
+        double t3 = perf_now_ms();
+        perf_add(&perf_stats, PERF_ONETIME_SK, timer_diff(t2, t3) - timer_diff(h2_start, h2_end));
+    }
+
+    scratch_put(scratch, ws);
+
+    return result;
 }
 
 void sitaiba_trace(element_t B_r, element_t Addr, element_t R1, 
                   element_t R2, element_t a_m_param) {
-    clock_t t1 = clock();
+    scratch_t *ws = scratch_get(scratch);
+    if (!ws) return;
+
+    double t1 = perf_now_ms();
     
-    element_t eR1R2, powed, r3;
-    element_init_GT(eR1R2, pairing);
-    element_init_GT(powed, pairing);
-    element_init_Zr(r3, pairing);
+    element_ptr eR1R2 = ws->gt[0], powed = ws->gt[1], r3 = ws->zr[0];
 
-    pairing_apply(eR1R2, R1, R2, pairing);
+    pp_cache_apply(eR1R2, R1, R2, pp_cache);
     
     // Use internal tracer private key if a_m_param is NULL
     if (a_m_param == NULL) {
-        element_pow_zn(powed, eR1R2, a_m);
+        secret_pow_zn(powed, eR1R2, a_m);
     } else {
-        element_pow_zn(powed, eR1R2, a_m_param);
+        secret_pow_zn(powed, eR1R2, a_m_param);
     }
     
-    clock_t h2_start = clock();
-    sitaiba_H2(r3, powed);
-    clock_t h2_end = clock();
+    double h2_start = perf_now_ms();
+    H2(ws, r3, powed);
+    double h2_end = perf_now_ms();
     double h2_time = timer_diff(h2_start, h2_end);
 
-    element_t r3G, Addr_tmp, R2_inv;
-    element_init_G1(r3G, pairing);
-    element_init_G1(Addr_tmp, pairing);
-    element_init_G1(R2_inv, pairing);
+    element_ptr r3G = ws->g1[0], Addr_tmp = ws->g1[1], R2_inv = ws->g1[2];
 
     // r3G = r3 * G
-    element_pow_zn(r3G, g, r3);
+    g_pow_zn(r3G, r3);
 
     // Addr_tmp = Addr * (r3G)^-1
     element_invert(Addr_tmp, r3G);
@@ -416,14 +1021,12 @@ void sitaiba_trace(element_t B_r, element_t Addr, element_t R1,
     // B_r = Addr_tmp * R2^-1
     element_mul(B_r, Addr_tmp, R2_inv);
 
-    // Cleanup
-    element_clear(eR1R2); element_clear(powed); element_clear(r3);
-    element_clear(r3G); element_clear(Addr_tmp); element_clear(R2_inv);
-
-    clock_t t2 = clock();
+    double t2 = perf_now_ms();
     // Subtract hash computation time from total
     double total_time = timer_diff(t1, t2);
-    sumTrace += (total_time - h2_time);
+    perf_add(&perf_stats, PERF_TRACE, total_time - h2_time);
+
+    scratch_put(scratch, ws);
 }
 
 //----------------------------------------------
@@ -433,11 +1036,11 @@ void sitaiba_trace(element_t B_r, element_t Addr, element_t R1,
 void sitaiba_get_performance(sitaiba_performance_t* perf) {
     if (!perf || perf_counter == 0) return;
 
-    perf->addr_gen_avg = sumAddrGen / perf_counter;
-    perf->addr_recognize_avg = sumAddrVerify / perf_counter;
-    perf->fast_recognize_avg = sumFastAddrVerify / perf_counter;
-    perf->onetime_sk_avg = sumOnetimeSK / perf_counter;
-    perf->trace_avg = sumTrace / perf_counter;
+    perf->addr_gen_avg = perf_total_ms(&perf_stats, PERF_ADDR_GEN) / perf_counter;
+    perf->addr_recognize_avg = perf_total_ms(&perf_stats, PERF_ADDR_RECOGNIZE) / perf_counter;
+    perf->fast_recognize_avg = perf_total_ms(&perf_stats, PERF_FAST_RECOGNIZE) / perf_counter;
+    perf->onetime_sk_avg = perf_total_ms(&perf_stats, PERF_ONETIME_SK) / perf_counter;
+    perf->trace_avg = perf_total_ms(&perf_stats, PERF_TRACE) / perf_counter;
     perf->operation_count = perf_counter;
 }
 
@@ -448,11 +1051,40 @@ void sitaiba_print_performance(void) {
     }
 
     printf("\n=== SITAIBA Performance (Average over %d runs, excluding hash time) ===\n", perf_counter);
-    printf("Address Generation:    %.3f ms\n", sumAddrGen / perf_counter);
-    printf("Address Recognize:     %.3f ms\n", sumAddrVerify / perf_counter);
-    printf("Fast Address Recog:    %.3f ms\n", sumFastAddrVerify / perf_counter);
-    printf("One-time SK Gen:       %.3f ms\n", sumOnetimeSK / perf_counter);
-    printf("Identity Tracing:      %.3f ms\n", sumTrace / perf_counter);
+    printf("Address Generation:    %.3f ms\n", perf_total_ms(&perf_stats, PERF_ADDR_GEN) / perf_counter);
+    printf("Address Recognize:     %.3f ms\n", perf_total_ms(&perf_stats, PERF_ADDR_RECOGNIZE) / perf_counter);
+    printf("Fast Address Recog:    %.3f ms\n", perf_total_ms(&perf_stats, PERF_FAST_RECOGNIZE) / perf_counter);
+    printf("One-time SK Gen:       %.3f ms\n", perf_total_ms(&perf_stats, PERF_ONETIME_SK) / perf_counter);
+    printf("Identity Tracing:      %.3f ms\n", perf_total_ms(&perf_stats, PERF_TRACE) / perf_counter);
+}
+
+int sitaiba_get_latency(sitaiba_latency_t* lat, int n) {
+    if (!lat) return 0;
+    if (n > SITAIBA_LATENCY_OPS) n = SITAIBA_LATENCY_OPS;
+    for (int op = 0; op < n; op++) {
+        perf_latency_t l;
+        perf_latency(&perf_stats, PERF_ADDR_GEN + op, &l);
+        lat[op].count = l.count;
+        lat[op].mean_ms = l.mean_ms;
+        lat[op].p50_ms = l.p50_ms;
+        lat[op].p90_ms = l.p90_ms;
+        lat[op].p99_ms = l.p99_ms;
+        lat[op].max_ms = l.max_ms;
+    }
+    return n > 0 ? n : 0;
+}
+
+long sitaiba_latency_histogram(int op, unsigned long* counts, int n, double* max_ms) {
+    if (op < 0 || op >= SITAIBA_LATENCY_OPS || !counts || n < PERF_HIST_BUCKETS) return -1;
+    return (long)perf_hist_snapshot(&perf_stats, PERF_ADDR_GEN + op, counts, max_ms);
+}
+
+int sitaiba_latency_buckets(void) {
+    return PERF_HIST_BUCKETS;
+}
+
+double sitaiba_latency_bucket_ms(int bucket) {
+    return perf_hist_bucket_ms(bucket);
 }
 
 //----------------------------------------------
@@ -461,7 +1093,7 @@ void sitaiba_print_performance(void) {
 
 int sitaiba_element_size_G1(void) {
     if (!is_initialized) return 0;
-    return element_length_in_bytes(g);  // Use uncompressed size to match element_to_bytes
+    return sitaiba_wire_length(g);  // Matches sitaiba_wire_to_bytes in the current format
 }
 
 int sitaiba_element_size_Zr(void) {
@@ -474,25 +1106,239 @@ int sitaiba_element_size_Zr(void) {
 }
 
 int sitaiba_element_to_bytes(element_t elem, unsigned char* buf, int buf_size) {
-    int needed_size = element_length_in_bytes(elem);
+    int needed_size = sitaiba_wire_length(elem);
     if (buf_size < needed_size) return -1;
     
-    element_to_bytes(buf, elem);
+    sitaiba_wire_to_bytes(buf, elem);
     return needed_size;
 }
 
 int sitaiba_element_from_bytes_G1(element_t elem, const unsigned char* buf, int len) {
     if (!is_initialized) return -1;
     element_init_G1(elem, pairing);
-    // Cast away const to match PBC library signature
-    return element_from_bytes(elem, (unsigned char*)buf);
+    return sitaiba_wire_from_bytes(elem, buf);
 }
 
 int sitaiba_element_from_bytes_Zr(element_t elem, const unsigned char* buf, int len) {
     if (!is_initialized) return -1;
     element_init_Zr(elem, pairing);
     // Cast away const to match PBC library signature
-    return element_from_bytes(elem, (unsigned char*)buf);
+    return prim_from_bytes(elem, (unsigned char*)buf);
+}
+
+//----------------------------------------------
+// Wire Format
+//----------------------------------------------
+
+// Flag byte value marking the point at infinity, which
+// element_to_bytes_compressed cannot represent
+#define POINT_INFINITY_FLAG 2
+
+static int is_wire_compressed(element_t elem) {
+    return point_format == SITAIBA_POINT_COMPRESSED && is_initialized && elem->field == pairing->G1;
+}
+
+/**
+ * Select the G1 wire format
+ */
+int sitaiba_set_point_format(int format) {
+    if (format != SITAIBA_POINT_UNCOMPRESSED && format != SITAIBA_POINT_COMPRESSED) return -1;
+    point_format = format;
+    return 0;
+}
+
+int sitaiba_get_point_format(void) {
+    return point_format;
+}
+
+int sitaiba_set_validation(int mode) {
+    if (mode != SITAIBA_VALIDATE_NONE && mode != SITAIBA_VALIDATE_SUBGROUP) return -1;
+    validation = mode;
+    return 0;
+}
+
+int sitaiba_get_validation(void) {
+    return validation;
+}
+
+// Zr elements have nothing to check
+static int is_validated(element_t elem) {
+    return validation == SITAIBA_VALIDATE_SUBGROUP && is_initialized && elem->field != pairing->Zr;
+}
+
+int sitaiba_set_allocator(int alloc) {
+    if (alloc != SITAIBA_ALLOC_MALLOC && alloc != SITAIBA_ALLOC_POOL) return -1;
+    if (alloc == SITAIBA_ALLOC_MALLOC && pbc_pool_enabled()) return -1;
+    allocator = alloc;
+    return 0;
+}
+
+int sitaiba_set_autotune(int mode, const char* cache_file) {
+    if (mode != SITAIBA_TUNE_OFF && mode != SITAIBA_TUNE_ON) return -1;
+    return pairing_tune_enable(mode == SITAIBA_TUNE_ON, cache_file);
+}
+
+int sitaiba_get_autotune(void) {
+    return pairing_tune_enabled() ? SITAIBA_TUNE_ON : SITAIBA_TUNE_OFF;
+}
+
+const char* sitaiba_get_tuning(void) {
+    return is_initialized ? tuning : NULL;
+}
+
+int sitaiba_set_pp_cache(int entries) {
+    if (entries < 0) return -1;
+    pp_cache_size = entries;
+    if (is_initialized && pp_cache_set_capacity(pp_cache, entries) != 0) return -1;
+    return 0;
+}
+
+void sitaiba_get_pp_cache_stats(unsigned long* hits, unsigned long* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (is_initialized) pp_cache_stats(pp_cache, hits, misses);
+}
+
+//----------------------------------------------
+// Ephemeral Pool
+//----------------------------------------------
+
+int sitaiba_set_eph_pool(int entries) {
+    if (entries < 0) return -1;
+    eph_pool_size = entries;
+    if (!is_initialized) return 0;
+    eph_pool_stop();
+    return eph_pool_start();
+}
+
+void sitaiba_get_eph_pool_stats(unsigned long* hits, unsigned long* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (eph_pool_live) eph_pool_stats(&addr_pool, hits, misses);
+}
+
+//----------------------------------------------
+// Seeded Random Mode
+//----------------------------------------------
+
+int sitaiba_set_random_seed(int enabled, unsigned int seed) {
+    return seeded_random_set(enabled, seed);
+}
+
+int sitaiba_get_random_seeded(void) {
+    return seeded_random_active();
+}
+
+//----------------------------------------------
+// Hardware Counters
+//----------------------------------------------
+
+int sitaiba_set_hw_counters(int enabled) {
+    return hwc_set_enabled(enabled);
+}
+
+//----------------------------------------------
+// Worker Placement
+//----------------------------------------------
+
+int sitaiba_set_worker_pinning(int enabled) {
+    cpu_topo_set_pinning(enabled);
+    return cpu_topo_nodes();
+}
+
+int sitaiba_compact_length(element_t elem) {
+    return element_length_in_bytes_compressed(elem);
+}
+
+/**
+ * Serialize a point in the compact encoding
+ */
+int sitaiba_compact_to_bytes(unsigned char* buf, element_t elem) {
+    if (element_is0(elem)) {
+        int len = element_length_in_bytes_compressed(elem);
+        memset(buf, 0, len - 1);
+        buf[len - 1] = POINT_INFINITY_FLAG;
+        return len;
+    }
+    return prim_to_bytes_compressed(buf, elem);
+}
+
+/**
+ * Deserialize a point written by sitaiba_compact_to_bytes
+ */
+int sitaiba_compact_from_bytes(element_t elem, const unsigned char* buf) {
+    int len = element_length_in_bytes_compressed(elem);
+    if (buf[len - 1] == POINT_INFINITY_FLAG) {
+        element_set0(elem);
+        return len;
+    }
+    // Cast away const to match PBC library signature
+    return prim_from_bytes_compressed(elem, (unsigned char*)buf);
+}
+
+/**
+ * Deserialize n packed points in the compact encoding
+ */
+int sitaiba_compact_from_bytes_batch(element_t elems[], const unsigned char* buf, int n) {
+    if (n <= 0) return 0;
+    int len = element_length_in_bytes_compressed(elems[0]);
+    // The batch decoder knows nothing of the infinity flag
+    for (int i = 0; i < n; i++)
+        if (buf[(size_t)i * len + len - 1] == POINT_INFINITY_FLAG) {
+            for (int j = 0; j < n; j++) sitaiba_compact_from_bytes(elems[j], buf + (size_t)j * len);
+            return n * len;
+        }
+    element_from_bytes_compressed_batch(elems, (unsigned char*)buf, n);
+    return n * len;
+}
+
+int sitaiba_wire_length(element_t elem) {
+    return is_wire_compressed(elem) ? element_length_in_bytes_compressed(elem)
+                                    : element_length_in_bytes(elem);
+}
+
+/**
+ * Serialize an element in the current wire format
+ */
+int sitaiba_wire_to_bytes(unsigned char* buf, element_t elem) {
+    if (!is_wire_compressed(elem)) return prim_to_bytes(buf, elem);
+    return sitaiba_compact_to_bytes(buf, elem);
+}
+
+/**
+ * Deserialize an element written by sitaiba_wire_to_bytes
+ */
+static int wire_decode(element_t elem, const unsigned char* buf) {
+    if (!is_wire_compressed(elem)) return prim_from_bytes(elem, (unsigned char*)buf);
+    return sitaiba_compact_from_bytes(elem, buf);
+}
+
+int sitaiba_wire_from_bytes(element_t elem, const unsigned char* buf) {
+    int len = wire_decode(elem, buf);
+    if (is_validated(elem) && !element_is_in_subgroup(elem)) {
+        element_set0(elem);
+        return -1;
+    }
+    return len;
+}
+
+/**
+ * Deserialize n packed elements in the current wire format
+ */
+int sitaiba_wire_from_bytes_batch(element_t elems[], const unsigned char* buf, int n) {
+    if (n <= 0) return 0;
+    int len = sitaiba_wire_length(elems[0]);
+    if (is_wire_compressed(elems[0])) sitaiba_compact_from_bytes_batch(elems, buf, n);
+    else for (int i = 0; i < n; i++) wire_decode(elems[i], buf + (size_t)i * len);
+    if (!is_validated(elems[0])) return n * len;
+
+    char* ok = malloc(n);
+    if (!ok) return -1;
+    int valid = element_is_in_subgroup_batch(ok, elems, n);
+    for (int i = 0; valid < n && i < n; i++)
+        if (!ok[i]) element_set0(elems[i]);
+    free(ok);
+    return valid < n ? -1 : n * len;
 }
 
 //----------------------------------------------
@@ -509,4 +1355,19 @@ int sitaiba_get_generator(element_t g_out) {
     if (!is_initialized) return -1;
     element_set(g_out, g);
     return 0;
-}
\ No newline at end of file
+}
+
+int sitaiba_set_generator(element_t new_g) {
+    if (!is_initialized) return -1;
+    eph_pool_stop();
+    element_set(g, new_g);
+#if SITAIBA_G_PP_WINDOW > 0
+    element_pp_clear(g_pp);
+    element_pp_init_k(g_pp, g, SITAIBA_G_PP_WINDOW);
+#endif
+    sitaiba_tracer_keygen(A_m, a_m);
+    pairing_pp_clear(A_m_pp);
+    pairing_pp_init(A_m_pp, A_m, pairing);
+    eph_pool_start();
+    return 0;
+}
\ No newline at end of file
@@ -9,6 +9,81 @@
 
 #include <pbc/pbc.h>
 
+/**
+ * Window size (bits) of the fixed-base table built for the generator g in
+ * sitaiba_init. Every g^x goes through this table; each extra bit doubles
+ * the table size. Set to 0 to fall back to plain element_pow_zn.
+ */
+#ifndef SITAIBA_G_PP_WINDOW
+#define SITAIBA_G_PP_WINDOW 5
+#endif
+
+/**
+ * Number of initialized pairings kept by sitaiba_init, keyed by parameter
+ * file path and content hash, each with its generator, table and tracer
+ * key pair. The least recently used entry is dropped when full.
+ */
+#ifndef SITAIBA_PAIRING_CACHE_SIZE
+#define SITAIBA_PAIRING_CACHE_SIZE 4
+#endif
+
+/**
+ * Length (bytes) of the view tag emitted by sitaiba_addr_gen_tagged.
+ * The tag hashes the shared point A_r^r1 = R1^a_r, letting a scanner
+ * reject most foreign outputs before the A_r^r2 exponentiation.
+ */
+#ifndef SITAIBA_VIEW_TAG_LEN
+#define SITAIBA_VIEW_TAG_LEN 2
+#endif
+
+/**
+ * Exponentiations by secrets (the keys a_r, b_r and a_m, and the one-time
+ * key part r2 a_r) go through element_pow_zn_ct, whose operations do not
+ * depend on the exponent bits. This bypasses the table for g for them.
+ * Set to 0 for the variable-time paths. The sender's ephemerals keep the
+ * fast paths either way.
+ */
+#ifndef SITAIBA_SECRET_CT
+#define SITAIBA_SECRET_CT 1
+#endif
+
+/**
+ * Outputs per element_pow_mpz_same call in each sitaiba_scan_batch and
+ * sitaiba_ctx_scan worker, which raises every R1 to the key a_r in one
+ * pass. Only the variable-time build (SITAIBA_SECRET_CT 0) shares the
+ * recoding of a_r.
+ */
+#ifndef SITAIBA_SCAN_CHUNK
+#define SITAIBA_SCAN_CHUNK 64
+#endif
+
+/**
+ * Outputs from which each worker of an untagged sitaiba_ctx_scan builds
+ * a fixed-base table (SITAIBA_G_PP_WINDOW) for A_r, for the A_r^r2 of
+ * every output.
+ */
+#ifndef SITAIBA_SCAN_PP_MIN
+#define SITAIBA_SCAN_PP_MIN 16
+#endif
+
+/**
+ * Default number of pairing tables kept per pairing for the left
+ * argument R1 of sitaiba_trace, see sitaiba_set_pp_cache. 0 disables the
+ * cache. Pairings against the manager key always go through its own
+ * table, built in sitaiba_init.
+ */
+#ifndef SITAIBA_PP_CACHE_SIZE
+#define SITAIBA_PP_CACHE_SIZE 0
+#endif
+
+/**
+ * Default number of precomputed ephemerals (r1, g^r1) kept ready for
+ * address generation, see sitaiba_set_eph_pool. 0 disables the pool.
+ */
+#ifndef SITAIBA_EPH_POOL_SIZE
+#define SITAIBA_EPH_POOL_SIZE 0
+#endif
+
 //----------------------------------------------
 // Performance Statistics Structure
 //----------------------------------------------
@@ -21,12 +96,26 @@ typedef struct {
     int operation_count;
 } sitaiba_performance_t;
 
+// Operations with a latency histogram, in sitaiba_performance_t order
+#define SITAIBA_LATENCY_OPS 5
+
+// Latency of one operation over every call since the last reset
+typedef struct {
+    unsigned long count;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+} sitaiba_latency_t;
+
 //----------------------------------------------
 // Library Management Functions
 //----------------------------------------------
 
 /**
  * Initialize the SITAIBA library with a parameter file
+ * Switches to the cached pairing when the file was loaded before.
  * @param param_file Path to the PBC parameter file
  * @return 0 on success, -1 on failure
  */
@@ -44,7 +133,7 @@ int sitaiba_is_initialized(void);
 void sitaiba_cleanup(void);
 
 /**
- * Reset performance counters
+ * Reset performance counters and latency histograms
  */
 void sitaiba_reset_performance(void);
 
@@ -100,6 +189,24 @@ void sitaiba_addr_gen(element_t Addr, element_t R1, element_t R2,
 int sitaiba_addr_recognize(element_t Addr, element_t R1, element_t R2,
                           element_t A_r, element_t B_r, element_t A_m, element_t a_r);
 
+/**
+ * Audit n addresses generated for one user: each must pass
+ * sitaiba_addr_recognize. The pairing of each address is hashed into r3,
+ * so it stays one per address, on the lines of A_m. The equations
+ * R2 = A^r2 and Addr / (R2 * B) = g^r3 are checked for the whole set at
+ * once with random small scalars (batch_check.h) and bisected when that
+ * check fails, in place of two exponentiations per address.
+ * @param Addr, R1, R2 Arrays of n address components
+ * @param A_r, B_r User public keys
+ * @param A_m Manager public key
+ * @param a_r User private key a
+ * @param results Per-address result, 1 if well formed, 0 otherwise (output, n bytes)
+ * @return Number of well-formed addresses, -1 on error
+ */
+int sitaiba_addr_audit_batch(element_t Addr[], element_t R1[], element_t R2[], int n,
+                             element_t A_r, element_t B_r, element_t A_m,
+                             element_t a_r, unsigned char* results);
+
 /**
  * Fast address recognition (optimized)
  * @param R1 Random element R1
@@ -110,6 +217,95 @@ int sitaiba_addr_recognize(element_t Addr, element_t R1, element_t R2,
  */
 int sitaiba_addr_recognize_fast(element_t R1, element_t R2, element_t A_r, element_t a_r);
 
+/**
+ * Generate one-time address together with its view tag
+ * @param Addr Generated address (output)
+ * @param R1 Random element R1 (output)
+ * @param R2 Random element R2 (output)
+ * @param view_tag SITAIBA_VIEW_TAG_LEN bytes, stored with the address (output)
+ * @param A_r User public key A
+ * @param B_r User public key B
+ * @param A_m Manager public key
+ */
+void sitaiba_addr_gen_tagged(element_t Addr, element_t R1, element_t R2,
+                             unsigned char* view_tag, element_t A_r, element_t B_r,
+                             element_t A_m);
+
+/**
+ * Fast address recognition with a view tag prefilter.
+ * Outputs whose tag does not match R1^a_r are rejected before H1 and
+ * the A_r^r2 exponentiation.
+ * @param R1 Random element R1
+ * @param R2 Random element R2
+ * @param A_r User public key A
+ * @param view_tag SITAIBA_VIEW_TAG_LEN bytes from sitaiba_addr_gen_tagged
+ * @param a_r User private key a
+ * @return 1 if recognized, 0 otherwise
+ */
+int sitaiba_addr_recognize_fast_tagged(element_t R1, element_t R2, element_t A_r,
+                                       const unsigned char* view_tag, element_t a_r);
+
+/**
+ * Per-wallet precomputation for sitaiba_scan_batch: a fixed-base table
+ * (SITAIBA_G_PP_WINDOW) for A_r, whose power A_r^r2 each output needs,
+ * and the key a_r as an integer. Built by sitaiba_scan_ctx_init for the
+ * pairing active at the time.
+ */
+typedef struct {
+    element_t A_r;
+    element_pp_t A_pp;
+    mpz_t a;
+} sitaiba_scan_ctx_t;
+
+/**
+ * Build a scanning context for one wallet
+ * @param ctx Context to initialize (output)
+ * @param A_r User public key A
+ * @param a_r User private key a
+ * @return 0 on success, -1 if the library is not initialized
+ */
+int sitaiba_scan_ctx_init(sitaiba_scan_ctx_t* ctx, element_t A_r, element_t a_r);
+
+/**
+ * @param ctx Context built by sitaiba_scan_ctx_init
+ */
+void sitaiba_scan_ctx_clear(sitaiba_scan_ctx_t* ctx);
+
+/**
+ * Batch fast recognition for wallet scanning.
+ * Splits the n outputs (R1[i], R2[i]) into contiguous ranges, one per
+ * thread, each running the check of sitaiba_addr_recognize_fast with
+ * A_r^r2 taken from the table of ctx. Performance counters are not
+ * updated.
+ * @param ctx Context of the scanning wallet
+ * @param R1 Array of n R1 components
+ * @param R2 Array of n R2 components
+ * @param view_tags n concatenated tags, SITAIBA_VIEW_TAG_LEN bytes each;
+ *                  NULL scans without the prefilter
+ * @param n Number of outputs
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param owned Indices of the owned outputs in increasing order, room
+ *              for n (output)
+ * @return Number of owned outputs, -1 on error
+ */
+int sitaiba_scan_batch(sitaiba_scan_ctx_t* ctx, element_t R1[], element_t R2[],
+                       const unsigned char* view_tags, int n, int num_threads, int* owned);
+
+/**
+ * Derive the view tag of a shared point (A_r^r1 or R1^a_r).
+ * Pure function, safe to call from any thread.
+ * @param view_tag SITAIBA_VIEW_TAG_LEN bytes (output)
+ * @param shared Shared point
+ */
+void sitaiba_view_tag(unsigned char* view_tag, element_t shared);
+
+/**
+ * x[i] = a[i]^n for m bases and one secret exponent n: one constant-time
+ * exponentiation per base under SITAIBA_SECRET_CT, otherwise a single
+ * shared recoding of n (element_pow_mpz_same). Safe to call from any thread.
+ */
+void sitaiba_secret_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m);
+
 /**
  * Generate one-time secret key
  * @param dsk One-time secret key (output)
@@ -121,6 +317,46 @@ int sitaiba_addr_recognize_fast(element_t R1, element_t R2, element_t A_r, eleme
 void sitaiba_onetime_skgen(element_t dsk, element_t R1, element_t a_r, 
                           element_t b_r, element_t A_m);
 
+/**
+ * One-time secret keys of n owned outputs, as n calls to
+ * sitaiba_onetime_skgen would give. The outputs are split across
+ * num_threads threads, the caller's included, each with one workspace;
+ * R1^a_r runs a chunk of SITAIBA_SCAN_CHUNK outputs at a time with the
+ * exponent recoded once, and for the tracer key of the active pairing the
+ * e(R1, A_m) pairings of a chunk reuse the lines of A_m and share the
+ * inversions of their final exponentiations. Performance counters are
+ * not updated.
+ * @param dsk Array of n one-time secret keys in Zr (output)
+ * @param R1 Array of n R1 components
+ * @param n Number of outputs
+ * @param a_r User private key a
+ * @param b_r User private key b
+ * @param A_m Manager public key
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_onetime_skgen_batch(element_t dsk[], element_t R1[], int n, element_t a_r,
+                                element_t b_r, element_t A_m, int num_threads);
+
+/**
+ * Fast recognition followed, for an owned output, by its one-time key.
+ * The key reuses the r2 = H1(R1^a_r) of recognition, where separate
+ * calls to sitaiba_addr_recognize_fast and sitaiba_onetime_skgen would
+ * compute R1^a_r and H1 twice.
+ * @param dsk One-time secret key, set only if recognized (output)
+ * @param R1 Random element R1
+ * @param R2 Random element R2
+ * @param A_r User public key A
+ * @param view_tag Tag from sitaiba_addr_gen_tagged, NULL if untagged
+ * @param a_r User private key a
+ * @param b_r User private key b
+ * @param A_m Manager public key
+ * @return 1 if recognized, 0 otherwise
+ */
+int sitaiba_recognize_and_derive(element_t dsk, element_t R1, element_t R2, element_t A_r,
+                                 const unsigned char* view_tag, element_t a_r,
+                                 element_t b_r, element_t A_m);
+
 /**
  * Trace identity from address
  * @param B_r Recovered user public key B (output)
@@ -170,12 +406,43 @@ extern int perf_counter;
  */
 void sitaiba_print_performance(void);
 
+/**
+ * Latency percentiles of each operation, from per-call histograms
+ * Every call adds one sample (its time excluding hashing, as in the
+ * averages), independent of perf_counter
+ * @param lat Array to fill, in sitaiba_performance_t order (output)
+ * @param n Size of lat
+ * @return Number of entries filled, at most SITAIBA_LATENCY_OPS
+ */
+int sitaiba_get_latency(sitaiba_latency_t* lat, int n);
+
+/**
+ * Snapshot of an operation's latency histogram, for merging snapshots
+ * taken over several runs
+ * @param op Operation index, < SITAIBA_LATENCY_OPS
+ * @param counts Array for the bucket counts (output)
+ * @param n Size of counts, at least sitaiba_latency_buckets()
+ * @param max_ms Largest sample in ms (output, may be NULL)
+ * @return Number of samples, -1 on a bad op or a short array
+ */
+long sitaiba_latency_histogram(int op, unsigned long* counts, int n, double* max_ms);
+
+/**
+ * Number of histogram buckets
+ */
+int sitaiba_latency_buckets(void);
+
+/**
+ * Largest latency in ms that falls into a histogram bucket
+ */
+double sitaiba_latency_bucket_ms(int bucket);
+
 //----------------------------------------------
 // Element Serialization Helpers
 //----------------------------------------------
 
 /**
- * Get the size needed for serializing a G1 element
+ * Get the size needed for serializing a G1 element in the current wire format
  * @return Size in bytes, 0 if not initialized
  */
 int sitaiba_element_size_G1(void);
@@ -213,6 +480,275 @@ int sitaiba_element_from_bytes_G1(element_t elem, const unsigned char* buf, int
  */
 int sitaiba_element_from_bytes_Zr(element_t elem, const unsigned char* buf, int len);
 
+//----------------------------------------------
+// Wire Format
+//----------------------------------------------
+
+/**
+ * G1 wire formats for the byte-level API. Compressed points carry the
+ * x-coordinate plus one byte for the sign of y (roughly half the size)
+ * and cost a square root to decode. Zr elements and the inputs of the
+ * hash functions are not affected.
+ */
+#define SITAIBA_POINT_UNCOMPRESSED 0
+#define SITAIBA_POINT_COMPRESSED   1
+
+/**
+ * Select the G1 wire format (default uncompressed, kept across re-init)
+ * @param format SITAIBA_POINT_UNCOMPRESSED or SITAIBA_POINT_COMPRESSED
+ * @return 0 on success, -1 on unknown format
+ */
+int sitaiba_set_point_format(int format);
+
+/**
+ * Get the current G1 wire format
+ * @return SITAIBA_POINT_UNCOMPRESSED or SITAIBA_POINT_COMPRESSED
+ */
+int sitaiba_get_point_format(void);
+
+/**
+ * Checks on elements read through the wire format. By default decoded
+ * points are only known to lie on the curve (PBC maps others to the
+ * identity). With SITAIBA_VALIDATE_SUBGROUP, G1 points and GT values
+ * must also lie in the group of order r (element_is_in_subgroup):
+ * others are replaced by the identity and the decoder returns -1.
+ * Batches are checked in one pass (element_is_in_subgroup_batch).
+ */
+#define SITAIBA_VALIDATE_NONE     0
+#define SITAIBA_VALIDATE_SUBGROUP 1
+
+/**
+ * Select the wire validation mode (default none, kept across re-init)
+ * @param mode SITAIBA_VALIDATE_NONE or SITAIBA_VALIDATE_SUBGROUP
+ * @return 0 on success, -1 on unknown mode
+ */
+int sitaiba_set_validation(int mode);
+
+/**
+ * Get the current wire validation mode
+ * @return SITAIBA_VALIDATE_NONE or SITAIBA_VALIDATE_SUBGROUP
+ */
+int sitaiba_get_validation(void);
+
+/**
+ * Memory behind PBC and GMP. The pool keeps freed blocks in per-thread
+ * lists (pbc_pool_enable); it is installed at the next sitaiba_init and
+ * stays for the life of the process.
+ */
+#define SITAIBA_ALLOC_MALLOC 0
+#define SITAIBA_ALLOC_POOL   1
+
+/**
+ * Select the allocator used from the next sitaiba_init on
+ * @param allocator SITAIBA_ALLOC_MALLOC or SITAIBA_ALLOC_POOL
+ * @return 0 on success, -1 on unknown allocator or leaving an installed pool
+ */
+int sitaiba_set_allocator(int allocator);
+
+/**
+ * Pairing configuration picked on the host. With tuning on, the first
+ * sitaiba_init of a parameter set times every Fp backend and pairing
+ * method of PBC and keeps the fastest; a cache file carries the result
+ * to later processes.
+ */
+#define SITAIBA_TUNE_OFF 0
+#define SITAIBA_TUNE_ON  1
+
+/**
+ * Select autotuning for the pairings of the next sitaiba_init on
+ * @param mode SITAIBA_TUNE_OFF (default) or SITAIBA_TUNE_ON
+ * @param cache_file File of tuning results, created if missing; NULL
+ *        keeps them in memory only
+ * @return 0 on success, -1 on unknown mode or out of memory
+ */
+int sitaiba_set_autotune(int mode, const char* cache_file);
+
+/**
+ * Get the autotuning mode
+ */
+int sitaiba_get_autotune(void);
+
+/**
+ * Configuration of the active pairing as "<fp backend> <method>"
+ * @return NULL if it was initialized without autotuning or the library
+ *         is not initialized
+ */
+const char* sitaiba_get_tuning(void);
+
+/**
+ * Keep the pairing tables of the last R1 values paired by sitaiba_trace,
+ * and by sitaiba_addr_recognize and sitaiba_onetime_skgen when given a
+ * manager key other than the library's, least recently used dropped
+ * first. A new R1 pays for building its table, which costs more than a
+ * plain pairing under type A. Applies to the active pairing and those
+ * initialized afterwards; call while no operation runs.
+ * @param entries Tables kept per pairing, 0 to disable (the default is
+ *        SITAIBA_PP_CACHE_SIZE)
+ * @return 0 on success, -1 on a negative size or out of memory
+ */
+int sitaiba_set_pp_cache(int entries);
+
+/**
+ * Lookups of the active pairing's cache since sitaiba_init, the last
+ * sitaiba_reset_performance or sitaiba_set_pp_cache
+ * @param hits Pairings through a cached table (output, may be NULL)
+ * @param misses Pairings that built their table (output, may be NULL)
+ */
+void sitaiba_get_pp_cache_stats(unsigned long* hits, unsigned long* misses);
+
+//----------------------------------------------
+// Ephemeral Pool
+//----------------------------------------------
+
+/**
+ * Keep entries ephemerals (r1, g^r1) precomputed. They do not depend on
+ * the recipient, so a background thread at idle priority refills the
+ * pool between calls and sitaiba_addr_gen and sitaiba_addr_gen_tagged
+ * take one instead of paying for the fixed-base exponentiation. An empty
+ * pool falls back to computing inline; a thread in seeded random mode
+ * never uses it. Each entry is handed out once and zeroed in the pool
+ * when taken. Applies to the active pairing and those initialized
+ * afterwards; call while no operation runs.
+ * @param entries Entries kept, 0 to disable (the default is
+ *        SITAIBA_EPH_POOL_SIZE)
+ * @return 0 on success, -1 on a negative size, out of memory or no filler
+ *         thread (the pool is then off)
+ */
+int sitaiba_set_eph_pool(int entries);
+
+/**
+ * Ephemerals taken from the pool and calls that found it empty, since
+ * sitaiba_init, the last sitaiba_reset_performance or sitaiba_set_eph_pool
+ * @param hits Calls served from the pool (output, may be NULL)
+ * @param misses Calls that computed their own (output, may be NULL)
+ */
+void sitaiba_get_eph_pool_stats(unsigned long* hits, unsigned long* misses);
+
+//----------------------------------------------
+// Seeded Random Mode
+//----------------------------------------------
+
+/**
+ * Make the calling thread draw its random numbers (keys, nonces,
+ * exponents) from a deterministic source seeded with seed, so that a
+ * benchmark does identical work run after run and commit after commit.
+ * Worker threads started from this thread by the block operations get
+ * sources seeded from it. Other threads keep the OS source. For
+ * benchmarks only, never for real keys.
+ * @param enabled 1 to seed (reseeding if already seeded), 0 to go back to the OS source
+ * @param seed Seed
+ * @return 0 on success, -1 if out of memory
+ */
+int sitaiba_set_random_seed(int enabled, unsigned int seed);
+
+/**
+ * 1 if the calling thread draws from a seeded source
+ */
+int sitaiba_get_random_seeded(void);
+
+//----------------------------------------------
+// Hardware Counters
+//----------------------------------------------
+
+/**
+ * Read hardware counters (cycles, instructions, L1D / LLC / branch misses)
+ * and count PBC / GMP allocations around every instrumented primitive,
+ * for cycles, IPC, misses and allocations per pairing, exponentiation and
+ * hash. Each instrumented call then costs two extra counter reads. Call
+ * while no operation is running.
+ * @param enabled 1 to count, 0 to stop
+ * @return Mask of the counters available (1 << hwc_kind_t in
+ *         perf_counters.h), 0 when stopping
+ */
+int sitaiba_set_hw_counters(int enabled);
+
+//----------------------------------------------
+// Worker Placement
+//----------------------------------------------
+
+/**
+ * Pin the threads of sitaiba_scan_batch and of scanning contexts
+ * (sitaiba_ctx_new) created from now on to CPUs, spread over the NUMA
+ * nodes in node order, so that each thread's range of the batch, the
+ * scratch it borrows and its context pairing stay on one node. Off by
+ * default; call while no operation is running.
+ * @param enabled 1 to pin, 0 to let the scheduler place threads
+ * @return Number of NUMA nodes found
+ */
+int sitaiba_set_worker_pinning(int enabled);
+
+/**
+ * Get the wire length of an element in the current format
+ * @param elem Element
+ * @return Size in bytes
+ */
+int sitaiba_wire_length(element_t elem);
+
+/**
+ * Serialize an element in the current wire format
+ * @param buf Buffer of at least sitaiba_wire_length(elem) bytes (output)
+ * @param elem Element to serialize
+ * @return Number of bytes written
+ */
+int sitaiba_wire_to_bytes(unsigned char* buf, element_t elem);
+
+/**
+ * Deserialize an element written by sitaiba_wire_to_bytes
+ * @param elem Initialized element to fill (output)
+ * @param buf Buffer to read from
+ * @return Number of bytes read, -1 if rejected by the validation mode
+ */
+int sitaiba_wire_from_bytes(element_t elem, const unsigned char* buf);
+
+/**
+ * Deserialize n elements packed back to back in the current wire format,
+ * validated in one pass. Compressed G1 points are decompressed with
+ * shared scratch (element_from_bytes_compressed_batch).
+ * @param elems Array of n initialized elements of one field (output)
+ * @param buf Buffer to read from
+ * @param n Number of elements
+ * @return Number of bytes read, -1 if the validation mode rejected any
+ */
+int sitaiba_wire_from_bytes_batch(element_t elems[], const unsigned char* buf, int n);
+
+/**
+ * Compact point encoding of the address records in the stores: the
+ * x-coordinate plus one byte for the sign of y, the same bytes as the
+ * compressed G1 wire format whatever format is selected, for G2 points
+ * too. Decoding recovers y with a square root and does not check the
+ * group; records are written from points that were.
+ * @param elem Point of the group to measure
+ * @return Size in bytes
+ */
+int sitaiba_compact_length(element_t elem);
+
+/**
+ * Serialize a point in the compact encoding
+ * @param buf Buffer of at least sitaiba_compact_length(elem) bytes (output)
+ * @param elem Point to serialize
+ * @return Number of bytes written
+ */
+int sitaiba_compact_to_bytes(unsigned char* buf, element_t elem);
+
+/**
+ * Deserialize a point written by sitaiba_compact_to_bytes
+ * @param elem Initialized point to fill (output)
+ * @param buf Buffer to read from
+ * @return Number of bytes read
+ */
+int sitaiba_compact_from_bytes(element_t elem, const unsigned char* buf);
+
+/**
+ * Deserialize n points of one group packed back to back in the compact
+ * encoding, the square roots with shared scratch
+ * (element_from_bytes_compressed_batch)
+ * @param elems Array of n initialized points of one group (output)
+ * @param buf Buffer to read from
+ * @param n Number of points
+ * @return Number of bytes read
+ */
+int sitaiba_compact_from_bytes_batch(element_t elems[], const unsigned char* buf, int n);
+
 //----------------------------------------------
 // Manager Key Access (for tracing)
 //----------------------------------------------
@@ -231,4 +767,13 @@ int sitaiba_get_tracer_public_key(element_t A_m);
  */
 int sitaiba_get_generator(element_t g_out);
 
-#endif /* SITAIBA_CORE_H */
\ No newline at end of file
+/**
+ * Replace generator g and rebuild its fixed-base table, so keys saved
+ * under an earlier session stay valid after a restart. The internal
+ * tracer key pair is regenerated under the new g.
+ * @param new_g Generator, e.g. read back with sitaiba_get_generator
+ * @return 0 on success, -1 if not initialized
+ */
+int sitaiba_set_generator(element_t new_g);
+
+#endif /* SITAIBA_CORE_H */
\ No newline at end of file
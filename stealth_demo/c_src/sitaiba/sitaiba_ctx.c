@@ -0,0 +1,447 @@
+/****************************************************************************
+ * File: sitaiba_ctx.c
+ * Desc: Thread-safe scanning context and worker pool
+ *       Every worker parses its own pairing, so no PBC state is shared.
+ *       Workers set up their pairing and scratch on their own thread, so
+ *       with pinning on (cpu_topo.h) both sit on the worker's NUMA node.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include "sitaiba_core.h"
+#include "sitaiba_ctx.h"
+#include "perf_timer.h"
+#include "perf_prim.h"
+#include "pairing_tune.h"
+#include "hash_stream.h"
+#include "cpu_topo.h"
+
+//----------------------------------------------
+// Context layout
+//----------------------------------------------
+typedef struct {
+    pthread_t tid;
+    struct sitaiba_ctx_s* ctx;
+    pairing_t pairing;
+    // Per-worker scratch; R1 holds a chunk of outputs, checked together
+    element_t R1[SITAIBA_SCAN_CHUNK], R1_pow_a[SITAIBA_SCAN_CHUNK], A, R2_prime, r2;
+    char ok[SITAIBA_SCAN_CHUNK];
+    mpz_t a_mpz;
+    int begin, end;
+    int matches;
+    int ready;                   // pairing and scratch set up
+} __attribute__((aligned(64))) sitaiba_worker_t;
+
+struct sitaiba_ctx_s {
+    int g1_len;                  // wire size, depends on point_format
+    int point_format;
+    int validation;
+    int zr_len;
+    int num_workers;             // running threads
+    int num_setup;               // workers done setting up, ready or not
+    sitaiba_worker_t* workers;
+    const char* params;          // parameters, while the workers set up
+    size_t param_len;
+
+    // Job hand-off between sitaiba_ctx_scan and the pool
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    pthread_mutex_t scan_lock;   // one batch at a time per context
+    unsigned long generation;
+    int pending;
+    int shutdown;
+
+    const unsigned char* R1_bytes;
+    const unsigned char* R2_bytes;
+    const unsigned char* A_bytes;
+    const unsigned char* a_bytes;
+    const unsigned char* view_tags;  // NULL when scanning without tags
+    unsigned char* bitmap;
+
+    // Statistics
+    double total_ms;
+    long total_outputs;
+};
+
+//----------------------------------------------
+// Helpers
+//----------------------------------------------
+static char* read_param_file(const char* param_file, size_t* len) {
+    FILE *fp = fopen(param_file, "r");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fsize <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buf = malloc(fsize + 1);
+    if (!buf) {
+        fclose(fp);
+        return NULL;
+    }
+    *len = fread(buf, 1, fsize, fp);
+    buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+// The compact encoding is the compressed wire format, infinity included
+static void g1_from_wire(struct sitaiba_ctx_s* ctx, element_t e, const unsigned char* buf) {
+    if (ctx->point_format == SITAIBA_POINT_COMPRESSED) sitaiba_compact_from_bytes(e, buf);
+    else prim_from_bytes(e, (unsigned char*)buf);
+}
+
+static void g1_to_wire(struct sitaiba_ctx_s* ctx, unsigned char* buf, element_t e) {
+    if (ctx->point_format == SITAIBA_POINT_COMPRESSED) sitaiba_compact_to_bytes(buf, e);
+    else prim_to_bytes(buf, e);
+}
+
+//----------------------------------------------
+// Worker
+//----------------------------------------------
+static void worker_scan(sitaiba_worker_t* w) {
+    struct sitaiba_ctx_s* ctx = w->ctx;
+    unsigned char wire[1024];
+    size_t len = ctx->g1_len;
+    hash_stream_t h;
+
+    w->matches = 0;
+    if (w->begin >= w->end) return;
+
+    g1_from_wire(ctx, w->A, ctx->A_bytes);
+    element_t aZ;
+    element_init_Zr(aZ, w->pairing);
+    prim_from_bytes(aZ, (unsigned char*)ctx->a_bytes);
+    element_to_mpz(w->a_mpz, aZ);
+    element_clear(aZ);
+
+    // Every output of an untagged scan pays A_r^r2
+    element_pp_t A_pp;
+    int A_table = !ctx->view_tags && w->end - w->begin >= SITAIBA_SCAN_PP_MIN;
+    if (A_table) element_pp_init_k(A_pp, w->A, SITAIBA_G_PP_WINDOW);
+
+    int validate = ctx->validation == SITAIBA_VALIDATE_SUBGROUP;
+    for (int base = w->begin; base < w->end; base += SITAIBA_SCAN_CHUNK) {
+        int m = w->end - base < SITAIBA_SCAN_CHUNK ? w->end - base : SITAIBA_SCAN_CHUNK;
+        for (int j = 0; j < m; j++)
+            g1_from_wire(ctx, w->R1[j], ctx->R1_bytes + (size_t)(base + j) * len);
+        if (validate) element_is_in_subgroup_batch(w->ok, w->R1, m);
+
+        // R1^a_r for the whole chunk, the key a_r kept constant time
+        sitaiba_secret_pow_mpz_same(w->R1_pow_a, w->R1, w->a_mpz, m);
+
+        for (int j = 0; j < m; j++) {
+            int i = base + j;
+            if (validate && !w->ok[j]) continue;
+
+            if (ctx->view_tags) {
+                unsigned char tag[SITAIBA_VIEW_TAG_LEN];
+                sitaiba_view_tag(tag, w->R1_pow_a[j]);
+                if (memcmp(tag, ctx->view_tags + (size_t)i * SITAIBA_VIEW_TAG_LEN,
+                           SITAIBA_VIEW_TAG_LEN) != 0)
+                    continue;
+            }
+
+            // r2 = H1(R1^a_r), without the H1 counters
+            hash_stream_begin(&h);
+            hash_stream_element(&h, w->R1_pow_a[j]);
+            hash_stream_end_zr(&h, w->r2);
+
+            // R2 is compared in its wire form: encodings are unique, and R2'
+            // lies in the group, so R2 never needs decoding or checking
+            if (A_table) prim_pp_pow_zn(w->R2_prime, w->r2, A_pp);
+            else prim_pow_zn(w->R2_prime, w->A, w->r2);
+            g1_to_wire(ctx, wire, w->R2_prime);
+            if (memcmp(wire, ctx->R2_bytes + (size_t)i * len, len) == 0) {
+                // Chunks start on byte boundaries, so no two workers share a byte
+                ctx->bitmap[i >> 3] |= (unsigned char)(1 << (i & 7));
+                w->matches++;
+            }
+        }
+    }
+
+    if (A_table) element_pp_clear(A_pp);
+}
+
+// Parameter parsing goes through the process-wide PBC tweaks, one at a time
+static pthread_mutex_t setup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int worker_setup(sitaiba_worker_t* w) {
+    struct sitaiba_ctx_s* ctx = w->ctx;
+    pthread_mutex_lock(&setup_lock);
+    int rc = pairing_init_tuned(w->pairing, ctx->params, ctx->param_len, NULL);
+    pthread_mutex_unlock(&setup_lock);
+    if (rc != 0) return -1;
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) {
+        element_init_G1(w->R1[j], w->pairing);
+        element_init_G1(w->R1_pow_a[j], w->pairing);
+    }
+    element_init_G1(w->A, w->pairing);
+    element_init_G1(w->R2_prime, w->pairing);
+    element_init_Zr(w->r2, w->pairing);
+    mpz_init(w->a_mpz);
+    return 0;
+}
+
+static void* worker_main(void* arg) {
+    sitaiba_worker_t* w = (sitaiba_worker_t*)arg;
+    struct sitaiba_ctx_s* ctx = w->ctx;
+    unsigned long seen = 0;
+
+    int ready = worker_setup(w) == 0;
+    pthread_mutex_lock(&ctx->lock);
+    w->ready = ready;
+    ctx->num_setup++;
+    pthread_cond_signal(&ctx->done_cv);
+    pthread_mutex_unlock(&ctx->lock);
+    if (!ready) return NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&ctx->lock);
+        while (!ctx->shutdown && ctx->generation == seen)
+            pthread_cond_wait(&ctx->work_cv, &ctx->lock);
+        if (ctx->shutdown) {
+            pthread_mutex_unlock(&ctx->lock);
+            break;
+        }
+        seen = ctx->generation;
+        pthread_mutex_unlock(&ctx->lock);
+
+        worker_scan(w);
+
+        pthread_mutex_lock(&ctx->lock);
+        if (--ctx->pending == 0)
+            pthread_cond_signal(&ctx->done_cv);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+    return NULL;
+}
+
+static void worker_clear(sitaiba_worker_t* w) {
+    if (!w->ready) return;
+    for (int j = 0; j < SITAIBA_SCAN_CHUNK; j++) {
+        element_clear(w->R1[j]);
+        element_clear(w->R1_pow_a[j]);
+    }
+    element_clear(w->A);
+    element_clear(w->R2_prime);
+    element_clear(w->r2);
+    mpz_clear(w->a_mpz);
+    pairing_clear(w->pairing);
+}
+
+//----------------------------------------------
+// Context management
+//----------------------------------------------
+
+/**
+ * Create a context and start its worker pool
+ */
+sitaiba_ctx_t* sitaiba_ctx_new(const char* param_file, int num_workers) {
+    size_t param_len = 0;
+    char* params = read_param_file(param_file, &param_len);
+    if (!params) {
+        fprintf(stderr, "Error: Cannot open parameter file %s\n", param_file);
+        return NULL;
+    }
+
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 0 ? (int)cpus : 1;
+    }
+
+    sitaiba_ctx_t* ctx = calloc(1, sizeof(sitaiba_ctx_t));
+    if (!ctx) {
+        free(params);
+        return NULL;
+    }
+    // Cache-line aligned, so that no two workers write the same line
+    if (posix_memalign((void**)&ctx->workers, 64, num_workers * sizeof(sitaiba_worker_t)) != 0) {
+        free(ctx);
+        free(params);
+        return NULL;
+    }
+    memset(ctx->workers, 0, num_workers * sizeof(sitaiba_worker_t));
+    ctx->params = params;
+    ctx->param_len = param_len;
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_mutex_init(&ctx->scan_lock, NULL);
+    pthread_cond_init(&ctx->work_cv, NULL);
+    pthread_cond_init(&ctx->done_cv, NULL);
+
+    // Each worker parses a private pairing once started; worker i runs on
+    // CPU i of num_workers in node order when pinning is on, so that the
+    // contiguous ranges of sitaiba_ctx_scan stay node-local
+    for (; ctx->num_workers < num_workers; ctx->num_workers++) {
+        sitaiba_worker_t* w = &ctx->workers[ctx->num_workers];
+        w->ctx = ctx;
+        if (cpu_topo_create(&w->tid, ctx->num_workers, num_workers, worker_main, w) != 0) break;
+    }
+    pthread_mutex_lock(&ctx->lock);
+    while (ctx->num_setup < ctx->num_workers)
+        pthread_cond_wait(&ctx->done_cv, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+    ctx->params = NULL;
+    free(params);
+
+    int ready = ctx->num_workers == num_workers;
+    for (int i = 0; ready && i < num_workers; i++) ready = ctx->workers[i].ready;
+    if (!ready) {
+        sitaiba_ctx_free(ctx);
+        return NULL;
+    }
+
+    ctx->g1_len = pairing_length_in_bytes_G1(ctx->workers[0].pairing);
+    ctx->zr_len = pairing_length_in_bytes_Zr(ctx->workers[0].pairing);
+    return ctx;
+}
+
+/**
+ * Stop the worker pool and release the context
+ */
+void sitaiba_ctx_free(sitaiba_ctx_t* ctx) {
+    if (!ctx) return;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->shutdown = 1;
+    pthread_cond_broadcast(&ctx->work_cv);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for (int i = 0; i < ctx->num_workers; i++)
+        pthread_join(ctx->workers[i].tid, NULL);
+    for (int i = 0; i < ctx->num_workers; i++)
+        worker_clear(&ctx->workers[i]);
+
+    pthread_cond_destroy(&ctx->work_cv);
+    pthread_cond_destroy(&ctx->done_cv);
+    pthread_mutex_destroy(&ctx->scan_lock);
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx->workers);
+    free(ctx);
+}
+
+int sitaiba_ctx_num_workers(const sitaiba_ctx_t* ctx) {
+    return ctx ? ctx->num_workers : 0;
+}
+
+int sitaiba_ctx_element_size_G1(const sitaiba_ctx_t* ctx) {
+    return ctx ? ctx->g1_len : 0;
+}
+
+int sitaiba_ctx_element_size_Zr(const sitaiba_ctx_t* ctx) {
+    return ctx ? ctx->zr_len : 0;
+}
+
+/**
+ * Select the G1 wire format of the scan inputs
+ */
+int sitaiba_ctx_set_point_format(sitaiba_ctx_t* ctx, int format) {
+    if (!ctx) return -1;
+    if (format != SITAIBA_POINT_UNCOMPRESSED && format != SITAIBA_POINT_COMPRESSED) return -1;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    element_t tmp;
+    element_init_G1(tmp, ctx->workers[0].pairing);
+    ctx->g1_len = format == SITAIBA_POINT_COMPRESSED ? sitaiba_compact_length(tmp)
+                                                     : element_length_in_bytes(tmp);
+    element_clear(tmp);
+    ctx->point_format = format;
+    pthread_mutex_unlock(&ctx->scan_lock);
+    return 0;
+}
+
+/**
+ * Select the checks on the scan inputs
+ */
+int sitaiba_ctx_set_validation(sitaiba_ctx_t* ctx, int mode) {
+    if (!ctx) return -1;
+    if (mode != SITAIBA_VALIDATE_NONE && mode != SITAIBA_VALIDATE_SUBGROUP) return -1;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    ctx->validation = mode;
+    pthread_mutex_unlock(&ctx->scan_lock);
+    return 0;
+}
+
+//----------------------------------------------
+// Parallel scan
+//----------------------------------------------
+
+/**
+ * Parallel fast recognition over a block of outputs
+ */
+int sitaiba_ctx_scan(sitaiba_ctx_t* ctx, const unsigned char* R1_bytes,
+                     const unsigned char* R2_bytes, int n,
+                     const unsigned char* A_bytes, const unsigned char* a_bytes,
+                     unsigned char* out_bitmap) {
+    return sitaiba_ctx_scan_tagged(ctx, R1_bytes, R2_bytes, NULL, n, A_bytes, a_bytes,
+                                   out_bitmap);
+}
+
+/**
+ * Parallel fast recognition with view tag prefilter
+ */
+int sitaiba_ctx_scan_tagged(sitaiba_ctx_t* ctx, const unsigned char* R1_bytes,
+                            const unsigned char* R2_bytes, const unsigned char* view_tags,
+                            int n, const unsigned char* A_bytes,
+                            const unsigned char* a_bytes, unsigned char* out_bitmap) {
+    if (!ctx || !R1_bytes || !R2_bytes || !A_bytes || !a_bytes || !out_bitmap || n < 0)
+        return -1;
+    if (n == 0) return 0;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    double t1 = perf_now_ms();
+
+    memset(out_bitmap, 0, (n + 7) / 8);
+
+    // Split on multiples of 8 so every bitmap byte has a single writer
+    int bytes = (n + 7) / 8;
+    int per = (bytes + ctx->num_workers - 1) / ctx->num_workers * 8;
+    for (int i = 0; i < ctx->num_workers; i++) {
+        int begin = i * per;
+        int end = begin + per;
+        ctx->workers[i].begin = begin < n ? begin : n;
+        ctx->workers[i].end = end < n ? end : n;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->R1_bytes = R1_bytes;
+    ctx->R2_bytes = R2_bytes;
+    ctx->A_bytes = A_bytes;
+    ctx->a_bytes = a_bytes;
+    ctx->view_tags = view_tags;
+    ctx->bitmap = out_bitmap;
+    ctx->pending = ctx->num_workers;
+    ctx->generation++;
+    pthread_cond_broadcast(&ctx->work_cv);
+    while (ctx->pending > 0)
+        pthread_cond_wait(&ctx->done_cv, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+
+    int matches = 0;
+    for (int i = 0; i < ctx->num_workers; i++) matches += ctx->workers[i].matches;
+
+    ctx->total_ms += perf_now_ms() - t1;
+    ctx->total_outputs += n;
+    pthread_mutex_unlock(&ctx->scan_lock);
+
+    return matches;
+}
+
+/**
+ * Get accumulated scan statistics for this context
+ */
+void sitaiba_ctx_get_stats(const sitaiba_ctx_t* ctx, double* total_ms, long* outputs) {
+    if (total_ms) *total_ms = ctx ? ctx->total_ms : 0;
+    if (outputs) *outputs = ctx ? ctx->total_outputs : 0;
+}
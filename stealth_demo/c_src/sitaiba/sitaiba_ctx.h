@@ -0,0 +1,128 @@
+/****************************************************************************
+ * File: sitaiba_ctx.h
+ * Desc: Thread-safe scanning context for SITAIBA Scheme. Holds its own
+ *       pairing state (no library globals) and a worker pool that splits
+ *       recognition batches across cores.
+ ****************************************************************************/
+
+#ifndef SITAIBA_CTX_H
+#define SITAIBA_CTX_H
+
+#include <stddef.h>
+
+/**
+ * Opaque scanning context. Each worker owns a private pairing parsed
+ * from the same parameters plus its own scratch elements, so separate
+ * contexts, and workers inside one context, share no mutable state.
+ * Recognition draws no randomness, so workers need no random source.
+ */
+typedef struct sitaiba_ctx_s sitaiba_ctx_t;
+
+/**
+ * Create a context and start its worker pool
+ * @param param_file Path to the PBC parameter file
+ * @param num_workers Number of worker threads, <= 0 for one per online CPU
+ * @return New context, NULL on failure
+ * @note Pinning (sitaiba_set_worker_pinning) is read here: the workers of
+ *       a context created while it is on stay on their CPUs for good
+ */
+sitaiba_ctx_t* sitaiba_ctx_new(const char* param_file, int num_workers);
+
+/**
+ * Stop the worker pool and release the context
+ * @param ctx Context created by sitaiba_ctx_new
+ */
+void sitaiba_ctx_free(sitaiba_ctx_t* ctx);
+
+/**
+ * Get the number of worker threads
+ * @param ctx Context
+ * @return Worker count
+ */
+int sitaiba_ctx_num_workers(const sitaiba_ctx_t* ctx);
+
+/**
+ * Get the serialized size of a G1 element in this context's wire format
+ * @param ctx Context
+ * @return Size in bytes
+ */
+int sitaiba_ctx_element_size_G1(const sitaiba_ctx_t* ctx);
+
+/**
+ * Get the serialized size of a Zr element for this context
+ * @param ctx Context
+ * @return Size in bytes
+ */
+int sitaiba_ctx_element_size_Zr(const sitaiba_ctx_t* ctx);
+
+/**
+ * Select the G1 wire format of the byte buffers passed to sitaiba_ctx_scan
+ * (same values as sitaiba_set_point_format; default uncompressed)
+ * @param ctx Context
+ * @param format 0 for uncompressed, 1 for compressed points
+ * @return 0 on success, -1 on unknown format
+ */
+int sitaiba_ctx_set_point_format(sitaiba_ctx_t* ctx, int format);
+
+/**
+ * Select the checks on the points passed to sitaiba_ctx_scan (same
+ * values as sitaiba_set_validation; default none). With
+ * SITAIBA_VALIDATE_SUBGROUP each worker checks its R1 points in batches
+ * of SITAIBA_SCAN_CHUNK. R2 is compared in its encoded form against the
+ * encoding of A_r^r2, which lies in the group, so an R2 outside the group
+ * never matches whatever the mode; neither do non-canonical encodings.
+ * @param ctx Context
+ * @param mode 0 for none, 1 for subgroup checks
+ * @return 0 on success, -1 on unknown mode
+ */
+int sitaiba_ctx_set_validation(sitaiba_ctx_t* ctx, int mode);
+
+/**
+ * Parallel fast recognition over a block of outputs.
+ * Same test as sitaiba_scan_batch, split across the worker pool.
+ * Calls on one context are serialized; use one context per caller
+ * thread for concurrent scans.
+ * @param ctx Context
+ * @param R1_bytes n concatenated R1 components, G1 wire size each
+ * @param R2_bytes n concatenated R2 components, G1 wire size each
+ * @param n Number of outputs
+ * @param A_bytes Public key A_r as bytes
+ * @param a_bytes Private key a_r as bytes
+ * @param out_bitmap Match bitmap, at least (n+7)/8 bytes (output);
+ *                   bit (i % 8) of byte i/8 is set if output i matches
+ * @return Number of matching outputs, -1 on error
+ */
+int sitaiba_ctx_scan(sitaiba_ctx_t* ctx, const unsigned char* R1_bytes,
+                     const unsigned char* R2_bytes, int n,
+                     const unsigned char* A_bytes, const unsigned char* a_bytes,
+                     unsigned char* out_bitmap);
+
+/**
+ * Parallel fast recognition with view tag prefilter.
+ * Same as sitaiba_ctx_scan; outputs whose tag does not match skip the
+ * A_r^r2 exponentiation.
+ * @param ctx Context
+ * @param R1_bytes n concatenated R1 components, G1 wire size each
+ * @param R2_bytes n concatenated R2 components, G1 wire size each
+ * @param view_tags n concatenated tags, SITAIBA_VIEW_TAG_LEN bytes each
+ *                  (NULL scans without the prefilter)
+ * @param n Number of outputs
+ * @param A_bytes Public key A_r as bytes
+ * @param a_bytes Private key a_r as bytes
+ * @param out_bitmap Match bitmap, at least (n+7)/8 bytes (output)
+ * @return Number of matching outputs, -1 on error
+ */
+int sitaiba_ctx_scan_tagged(sitaiba_ctx_t* ctx, const unsigned char* R1_bytes,
+                            const unsigned char* R2_bytes, const unsigned char* view_tags,
+                            int n, const unsigned char* A_bytes,
+                            const unsigned char* a_bytes, unsigned char* out_bitmap);
+
+/**
+ * Get accumulated scan statistics for this context
+ * @param ctx Context
+ * @param total_ms Wall-clock time spent in sitaiba_ctx_scan (output, may be NULL)
+ * @param outputs Number of outputs scanned (output, may be NULL)
+ */
+void sitaiba_ctx_get_stats(const sitaiba_ctx_t* ctx, double* total_ms, long* outputs);
+
+#endif /* SITAIBA_CTX_H */
@@ -6,6 +6,11 @@
 
 #include "sitaiba_python_api.h"
 #include "sitaiba_core.h"
+#include "sitaiba_registry.h"
+#include "sitaiba_store.h"
+#include "perf_prim.h"
+#include "hex_codec.h"
+#include <stdlib.h>
 #include <string.h>
 
 //----------------------------------------------
@@ -19,7 +24,7 @@ static void buf_to_element_G1(element_t elem, const unsigned char* buf) {
     pairing_t* pairing = sitaiba_get_pairing();
     if (pairing) {
         element_init_G1(elem, *pairing);
-        element_from_bytes(elem, (unsigned char*)buf);
+        sitaiba_wire_from_bytes(elem, buf);
     }
 }
 
@@ -30,11 +35,11 @@ static void buf_to_element_Zr(element_t elem, const unsigned char* buf) {
     pairing_t* pairing = sitaiba_get_pairing();
     if (pairing) {
         element_init_Zr(elem, *pairing);
-        element_from_bytes(elem, (unsigned char*)buf);
+        sitaiba_wire_from_bytes(elem, buf);
     }
 }
 
-// Removed element_to_buf wrapper - using element_to_bytes directly
+// Removed element_to_buf wrapper - using sitaiba_wire_to_bytes directly
 
 //----------------------------------------------
 // Python Simple API Implementation
@@ -64,6 +69,22 @@ int sitaiba_element_size_Zr_simple(void) {
     return sitaiba_element_size_Zr();
 }
 
+int sitaiba_set_point_format_simple(int format) {
+    return sitaiba_set_point_format(format);
+}
+
+int sitaiba_get_point_format_simple(void) {
+    return sitaiba_get_point_format();
+}
+
+int sitaiba_set_validation_simple(int mode) {
+    return sitaiba_set_validation(mode);
+}
+
+int sitaiba_get_validation_simple(void) {
+    return sitaiba_get_validation();
+}
+
 void sitaiba_keygen_simple(unsigned char* A_buf, unsigned char* B_buf,
                           unsigned char* a_buf, unsigned char* b_buf, int buf_size) {
     if (!sitaiba_is_initialized()) return;
@@ -79,10 +100,10 @@ void sitaiba_keygen_simple(unsigned char* A_buf, unsigned char* B_buf,
 
     sitaiba_keygen(A, B, a, b);
 
-    element_to_bytes(A_buf, A);
-    element_to_bytes(B_buf, B);
-    element_to_bytes(a_buf, a);
-    element_to_bytes(b_buf, b);
+    sitaiba_wire_to_bytes(A_buf, A);
+    sitaiba_wire_to_bytes(B_buf, B);
+    sitaiba_wire_to_bytes(a_buf, a);
+    sitaiba_wire_to_bytes(b_buf, b);
 
     element_clear(A); element_clear(B); element_clear(a); element_clear(b);
 }
@@ -99,8 +120,8 @@ void sitaiba_tracer_keygen_simple(unsigned char* A_m_buf, unsigned char* a_m_buf
 
     sitaiba_tracer_keygen(A_m, a_m);
 
-    element_to_bytes(A_m_buf, A_m);
-    element_to_bytes(a_m_buf, a_m);
+    sitaiba_wire_to_bytes(A_m_buf, A_m);
+    sitaiba_wire_to_bytes(a_m_buf, a_m);
 
     element_clear(A_m); element_clear(a_m);
 }
@@ -131,9 +152,9 @@ void sitaiba_addr_gen_simple(unsigned char* A_r_buf, unsigned char* B_r_buf, uns
 
     sitaiba_addr_gen(Addr, R1, R2, A_r, B_r, A_m);
 
-    element_to_bytes(addr_buf, Addr);
-    element_to_bytes(r1_buf, R1);
-    element_to_bytes(r2_buf, R2);
+    sitaiba_wire_to_bytes(addr_buf, Addr);
+    sitaiba_wire_to_bytes(r1_buf, R1);
+    sitaiba_wire_to_bytes(r2_buf, R2);
 
     element_clear(A_r); element_clear(B_r); element_clear(A_m);
     element_clear(Addr); element_clear(R1); element_clear(R2);
@@ -187,6 +208,137 @@ int sitaiba_addr_recognize_fast_simple(unsigned char* r1_buf, unsigned char* r2_
     return result;
 }
 
+int sitaiba_view_tag_length_simple(void) {
+    return SITAIBA_VIEW_TAG_LEN;
+}
+
+void sitaiba_addr_gen_tagged_simple(unsigned char* A_r_buf, unsigned char* B_r_buf, unsigned char* A_m_buf,
+                                    unsigned char* addr_buf, unsigned char* r1_buf, unsigned char* r2_buf,
+                                    unsigned char* tag_buf, int buf_size) {
+    if (!sitaiba_is_initialized() || !tag_buf) return;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    if (!pairing) return;
+
+    element_t A_r, B_r, A_m, Addr, R1, R2;
+    buf_to_element_G1(A_r, A_r_buf);
+    buf_to_element_G1(B_r, B_r_buf);
+
+    if (A_m_buf) {
+        buf_to_element_G1(A_m, A_m_buf);
+    } else {
+        element_init_G1(A_m, *pairing);
+        sitaiba_get_tracer_public_key(A_m);
+    }
+
+    element_init_G1(Addr, *pairing);
+    element_init_G1(R1, *pairing);
+    element_init_G1(R2, *pairing);
+
+    sitaiba_addr_gen_tagged(Addr, R1, R2, tag_buf, A_r, B_r, A_m);
+
+    sitaiba_wire_to_bytes(addr_buf, Addr);
+    sitaiba_wire_to_bytes(r1_buf, R1);
+    sitaiba_wire_to_bytes(r2_buf, R2);
+
+    element_clear(A_r); element_clear(B_r); element_clear(A_m);
+    element_clear(Addr); element_clear(R1); element_clear(R2);
+}
+
+int sitaiba_addr_recognize_fast_tagged_simple(unsigned char* r1_buf, unsigned char* r2_buf,
+                                              unsigned char* A_r_buf, const unsigned char* tag_buf,
+                                              unsigned char* a_r_buf) {
+    if (!sitaiba_is_initialized() || !tag_buf) return 0;
+
+    element_t R1, R2, A_r, a_r;
+    buf_to_element_G1(R1, r1_buf);
+    buf_to_element_G1(R2, r2_buf);
+    buf_to_element_G1(A_r, A_r_buf);
+    buf_to_element_Zr(a_r, a_r_buf);
+
+    int result = sitaiba_addr_recognize_fast_tagged(R1, R2, A_r, tag_buf, a_r);
+
+    element_clear(R1); element_clear(R2); element_clear(A_r); element_clear(a_r);
+
+    return result;
+}
+
+/**
+ * Load n concatenated G1 elements into v
+ */
+static void vec_from_wire(element_vec_t v, const unsigned char* bytes) {
+    sitaiba_wire_from_bytes_batch(v->item, bytes, v->n);
+}
+
+int sitaiba_addr_audit_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                    const unsigned char* r2_bytes, int n,
+                                    unsigned char* A_r_buf, unsigned char* B_r_buf,
+                                    unsigned char* a_r_buf, unsigned char* A_m_buf,
+                                    unsigned char* results) {
+    if (!sitaiba_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r1_bytes || !r2_bytes || !A_r_buf || !B_r_buf || !a_r_buf ||
+        !results) return -1;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    element_vec_t Addr, R1, R2;
+    element_vec_init(Addr, (*pairing)->G1, n);
+    element_vec_init(R1, (*pairing)->G1, n);
+    element_vec_init(R2, (*pairing)->G1, n);
+    vec_from_wire(Addr, addr_bytes);
+    vec_from_wire(R1, r1_bytes);
+    vec_from_wire(R2, r2_bytes);
+
+    element_t A_r, B_r, a_r, A_m;
+    buf_to_element_G1(A_r, A_r_buf);
+    buf_to_element_G1(B_r, B_r_buf);
+    buf_to_element_Zr(a_r, a_r_buf);
+    if (A_m_buf) {
+        buf_to_element_G1(A_m, A_m_buf);
+    } else {
+        element_init_G1(A_m, *pairing);
+        sitaiba_get_tracer_public_key(A_m);
+    }
+
+    int valid = sitaiba_addr_audit_batch(Addr->item, R1->item, R2->item, n,
+                                         A_r, B_r, A_m, a_r, results);
+
+    element_clear(A_r); element_clear(B_r); element_clear(a_r); element_clear(A_m);
+    element_vec_clear(Addr);
+    element_vec_clear(R1);
+    element_vec_clear(R2);
+    return valid;
+}
+
+int sitaiba_scan_batch_simple(const unsigned char* r1_bytes, const unsigned char* r2_bytes,
+                              const unsigned char* tags, int n, unsigned char* A_r_buf,
+                              unsigned char* a_r_buf, int num_threads, int* owned) {
+    if (!sitaiba_is_initialized() || n < 0) return -1;
+    if (!r1_bytes || !r2_bytes || !A_r_buf || !a_r_buf || !owned) return -1;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    element_vec_t R1, R2;
+    element_vec_init(R1, (*pairing)->G1, n);
+    element_vec_init(R2, (*pairing)->G1, n);
+    vec_from_wire(R1, r1_bytes);
+    vec_from_wire(R2, r2_bytes);
+
+    element_t A_r, a_r;
+    buf_to_element_G1(A_r, A_r_buf);
+    buf_to_element_Zr(a_r, a_r_buf);
+
+    int found = -1;
+    sitaiba_scan_ctx_t ctx;
+    if (sitaiba_scan_ctx_init(&ctx, A_r, a_r) == 0) {
+        found = sitaiba_scan_batch(&ctx, R1->item, R2->item, tags, n, num_threads, owned);
+        sitaiba_scan_ctx_clear(&ctx);
+    }
+
+    element_clear(A_r); element_clear(a_r);
+    element_vec_clear(R1);
+    element_vec_clear(R2);
+    return found;
+}
+
 void sitaiba_onetime_skgen_simple(unsigned char* r1_buf, unsigned char* a_r_buf, unsigned char* b_r_buf,
                                  unsigned char* A_m_buf, unsigned char* dsk_buf, int buf_size) {
     if (!sitaiba_is_initialized()) return;
@@ -210,12 +362,81 @@ void sitaiba_onetime_skgen_simple(unsigned char* r1_buf, unsigned char* a_r_buf,
 
     sitaiba_onetime_skgen(dsk, R1, a_r, b_r, A_m);
 
-    element_to_bytes(dsk_buf, dsk);
+    sitaiba_wire_to_bytes(dsk_buf, dsk);
 
     element_clear(R1); element_clear(a_r); element_clear(b_r);
     element_clear(A_m); element_clear(dsk);
 }
 
+int sitaiba_onetime_skgen_batch_simple(const unsigned char* r1_bytes, int n,
+                                       unsigned char* a_r_buf, unsigned char* b_r_buf,
+                                       unsigned char* A_m_buf, int num_threads,
+                                       unsigned char* dsk_out) {
+    if (!sitaiba_is_initialized() || n < 0) return -1;
+    if (!r1_bytes || !a_r_buf || !b_r_buf || !dsk_out) return -1;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    element_vec_t R1, dsk;
+    element_vec_init(R1, (*pairing)->G1, n);
+    element_vec_init(dsk, (*pairing)->Zr, n);
+    vec_from_wire(R1, r1_bytes);
+
+    element_t a_r, b_r, A_m;
+    buf_to_element_Zr(a_r, a_r_buf);
+    buf_to_element_Zr(b_r, b_r_buf);
+    if (A_m_buf) {
+        buf_to_element_G1(A_m, A_m_buf);
+    } else {
+        element_init_G1(A_m, *pairing);
+        sitaiba_get_tracer_public_key(A_m);
+    }
+
+    int rc = sitaiba_onetime_skgen_batch(dsk->item, R1->item, n, a_r, b_r, A_m, num_threads);
+    if (rc == 0) {
+        unsigned char* out = dsk_out;
+        for (int i = 0; i < n; i++) out += sitaiba_wire_to_bytes(out, dsk->item[i]);
+    }
+
+    element_clear(a_r); element_clear(b_r); element_clear(A_m);
+    element_vec_clear(R1);
+    element_vec_clear(dsk);
+    return rc;
+}
+
+int sitaiba_recognize_and_derive_simple(unsigned char* r1_buf, unsigned char* r2_buf,
+                                        unsigned char* A_r_buf, const unsigned char* tag_buf,
+                                        unsigned char* a_r_buf, unsigned char* b_r_buf,
+                                        unsigned char* A_m_buf, unsigned char* dsk_buf, int buf_size) {
+    if (!sitaiba_is_initialized()) return 0;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    if (!pairing) return 0;
+
+    element_t R1, R2, A_r, a_r, b_r, A_m, dsk;
+    buf_to_element_G1(R1, r1_buf);
+    buf_to_element_G1(R2, r2_buf);
+    buf_to_element_G1(A_r, A_r_buf);
+    buf_to_element_Zr(a_r, a_r_buf);
+    buf_to_element_Zr(b_r, b_r_buf);
+
+    if (A_m_buf) {
+        buf_to_element_G1(A_m, A_m_buf);
+    } else {
+        element_init_G1(A_m, *pairing);
+        sitaiba_get_tracer_public_key(A_m);
+    }
+
+    element_init_Zr(dsk, *pairing);
+
+    int result = sitaiba_recognize_and_derive(dsk, R1, R2, A_r, tag_buf, a_r, b_r, A_m);
+    if (result) sitaiba_wire_to_bytes(dsk_buf, dsk);
+
+    element_clear(R1); element_clear(R2); element_clear(A_r); element_clear(a_r);
+    element_clear(b_r); element_clear(A_m); element_clear(dsk);
+
+    return result;
+}
+
 void sitaiba_trace_simple(unsigned char* addr_buf, unsigned char* r1_buf, unsigned char* r2_buf,
                          unsigned char* a_m_buf, unsigned char* B_r_buf, int buf_size) {
     if (!sitaiba_is_initialized()) return;
@@ -241,12 +462,85 @@ void sitaiba_trace_simple(unsigned char* addr_buf, unsigned char* r1_buf, unsign
         sitaiba_trace(B_r, Addr, R1, R2, NULL);
     }
 
-    element_to_bytes(B_r_buf, B_r);
+    sitaiba_wire_to_bytes(B_r_buf, B_r);
 
     element_clear(Addr); element_clear(R1); element_clear(R2);
     element_clear(B_r);
 }
 
+int sitaiba_trace_lookup_simple(unsigned char* addr_buf, unsigned char* r1_buf, unsigned char* r2_buf,
+                                unsigned char* a_m_buf, unsigned char* B_r_buf, int buf_size) {
+    if (!sitaiba_is_initialized()) return -1;
+
+    pairing_t* pairing = sitaiba_get_pairing();
+    if (!pairing) return -1;
+
+    element_t Addr, R1, R2, B_r;
+    buf_to_element_G1(Addr, addr_buf);
+    buf_to_element_G1(R1, r1_buf);
+    buf_to_element_G1(R2, r2_buf);
+
+    element_init_G1(B_r, *pairing);
+
+    if (a_m_buf) {
+        element_t a_m;
+        buf_to_element_Zr(a_m, a_m_buf);
+        sitaiba_trace(B_r, Addr, R1, R2, a_m);
+        element_clear(a_m);
+    } else {
+        sitaiba_trace(B_r, Addr, R1, R2, NULL);
+    }
+
+    int id = sitaiba_registry_find_B(B_r);
+    if (B_r_buf) {
+        memset(B_r_buf, 0, buf_size);
+        sitaiba_wire_to_bytes(B_r_buf, B_r);
+    }
+
+    element_clear(Addr); element_clear(R1); element_clear(R2);
+    element_clear(B_r);
+    return id;
+}
+
+int sitaiba_registry_add_simple(const unsigned char* A_buf, const unsigned char* B_buf, int id) {
+    if (!sitaiba_is_initialized() || !A_buf || !B_buf) return -1;
+
+    element_t A, B;
+    buf_to_element_G1(A, A_buf);
+    buf_to_element_G1(B, B_buf);
+
+    int result = sitaiba_registry_add(A, B, id);
+
+    element_clear(A); element_clear(B);
+    return result;
+}
+
+static int registry_find_simple(const unsigned char* buf, int by_B) {
+    if (!sitaiba_is_initialized() || !buf) return -1;
+
+    element_t e;
+    buf_to_element_G1(e, buf);
+    int id = by_B ? sitaiba_registry_find_B(e) : sitaiba_registry_find_A(e);
+    element_clear(e);
+    return id;
+}
+
+int sitaiba_registry_find_A_simple(const unsigned char* A_buf) {
+    return registry_find_simple(A_buf, 0);
+}
+
+int sitaiba_registry_find_B_simple(const unsigned char* B_buf) {
+    return registry_find_simple(B_buf, 1);
+}
+
+int sitaiba_registry_count_simple(void) {
+    return sitaiba_registry_count();
+}
+
+void sitaiba_registry_clear_simple(void) {
+    sitaiba_registry_clear();
+}
+
 void sitaiba_performance_test_simple(int iterations, double* results) {
     if (!sitaiba_is_initialized() || !results) return;
 
@@ -317,9 +611,342 @@ int sitaiba_get_tracer_public_key_simple(unsigned char* A_m_buf, int buf_size) {
     
     int result = sitaiba_get_tracer_public_key(A_m);
     if (result == 0) {
-        element_to_bytes(A_m_buf, A_m);
+        sitaiba_wire_to_bytes(A_m_buf, A_m);
     }
 
     element_clear(A_m);
     return result;
-}
\ No newline at end of file
+}
+
+//----------------------------------------------
+// Store Interface Implementation
+//----------------------------------------------
+
+typedef struct {
+    const char* types;           // 'G' = G1, 'Z' = Zr, in record order;
+                                 // 'g' = compact G1 point
+    int meta;
+} store_layout_t;
+
+static const store_layout_t store_layouts[] = {
+    [SITAIBA_STORE_KEYS]   = { "GGZZ", 0 },
+    [SITAIBA_STORE_ADDRS]  = { "ggg", SITAIBA_STORE_ADDR_META },
+    [SITAIBA_STORE_DSKS]   = { "Z", SITAIBA_STORE_DSK_META },
+    [SITAIBA_STORE_SYSTEM] = { "GGZ", 0 },
+};
+
+static const store_layout_t* store_layout(int kind) {
+    if (kind < SITAIBA_STORE_KEYS || kind > SITAIBA_STORE_SYSTEM) return NULL;
+    return &store_layouts[kind];
+}
+
+static int store_elem_size(char type) {
+    pairing_t* pairing = sitaiba_get_pairing();
+    switch (type) {
+    case 'G': return pairing_length_in_bytes_G1(*pairing);
+    case 'g': return pairing_length_in_bytes_compressed_G1(*pairing);
+    default:  return pairing_length_in_bytes_Zr(*pairing);
+    }
+}
+
+/**
+ * Offset of element i of a record (i = strlen(types) gives the metadata)
+ */
+static int store_offset(const store_layout_t* l, int i) {
+    int off = 0;
+    for (int j = 0; j < i; j++) off += store_elem_size(l->types[j]);
+    return off;
+}
+
+static void store_elem_init(element_t e, char type) {
+    pairing_t* pairing = sitaiba_get_pairing();
+    if (type == 'G' || type == 'g') element_init_G1(e, *pairing);
+    else element_init_Zr(e, *pairing);
+}
+
+/**
+ * Whether an element of the type is stored in the current wire format,
+ * so that its record bytes serve without decoding
+ */
+static int store_is_wire(char type) {
+    element_t e;
+    store_elem_init(e, type);
+    // Compact and full encodings of a point differ in length
+    int same = sitaiba_wire_length(e) == store_elem_size(type);
+    element_clear(e);
+    return same;
+}
+
+static void store_put(unsigned char* p, element_t e, char type) {
+    if (type == 'g') sitaiba_compact_to_bytes(p, e);
+    else prim_to_bytes(p, e);
+}
+
+static void store_get(element_t e, const unsigned char* p, char type) {
+    if (type == 'g') sitaiba_compact_from_bytes(e, p);
+    else prim_from_bytes(e, (unsigned char*)p);
+}
+
+/**
+ * Record of an open store, NULL if the handle, kind or index is wrong
+ */
+static const unsigned char* store_record_of(int h, int kind, long index) {
+    if (!sitaiba_is_initialized() || (int)sitaiba_store_kind(h) != kind) return NULL;
+    return sitaiba_store_record(h, index);
+}
+
+/**
+ * Load element i of a record
+ */
+static void store_load(element_t e, const unsigned char* rec, int kind, int i) {
+    const store_layout_t* l = store_layout(kind);
+    store_elem_init(e, l->types[i]);
+    store_get(e, rec + store_offset(l, i), l->types[i]);
+}
+
+/**
+ * Fast recognition of one address record with one key record
+ */
+static int store_recognize(const unsigned char* addr, const unsigned char* key) {
+    const unsigned char* meta = addr + store_offset(&store_layouts[SITAIBA_STORE_ADDRS], 3);
+    element_t R1, R2, A_r, a_r;
+    store_load(R1, addr, SITAIBA_STORE_ADDRS, 1);
+    store_load(R2, addr, SITAIBA_STORE_ADDRS, 2);
+    store_load(A_r, key, SITAIBA_STORE_KEYS, 0);
+    store_load(a_r, key, SITAIBA_STORE_KEYS, 2);
+
+    int result;
+    if (meta[4] & SITAIBA_STORE_FLAG_TAGGED)
+        result = sitaiba_addr_recognize_fast_tagged(R1, R2, A_r, meta + 5, a_r);
+    else
+        result = sitaiba_addr_recognize_fast(R1, R2, A_r, a_r);
+
+    element_clear(R1); element_clear(R2); element_clear(A_r); element_clear(a_r);
+    return result;
+}
+
+int sitaiba_store_open_simple(const char* path, int kind) {
+    const store_layout_t* l = store_layout(kind);
+    if (!sitaiba_is_initialized() || !path || !l) return -1;
+    int n = (int)strlen(l->types);
+    return sitaiba_store_open(path, (uint32_t)kind, (uint32_t)(store_offset(l, n) + l->meta));
+}
+
+long sitaiba_store_append_simple(int h, const unsigned char* elems, const unsigned char* meta) {
+    int kind = (int)sitaiba_store_kind(h);
+    const store_layout_t* l = store_layout(kind);
+    if (!sitaiba_is_initialized() || !l || !elems) return -1;
+
+    int n = (int)strlen(l->types);
+    int meta_off = store_offset(l, n);
+    unsigned char* rec = calloc(1, meta_off + l->meta);
+    if (!rec) return -1;
+
+    for (int i = 0; i < n; i++) {
+        element_t e;
+        store_elem_init(e, l->types[i]);
+        int len = sitaiba_wire_from_bytes(e, elems);
+        store_put(rec + store_offset(l, i), e, l->types[i]);
+        element_clear(e);
+        // Records with points outside the group are not stored
+        if (len < 0) {
+            free(rec);
+            return -1;
+        }
+        elems += len;
+    }
+    if (meta) memcpy(rec + meta_off, meta, l->meta);
+
+    long index = sitaiba_store_append(h, rec);
+    free(rec);
+    return index;
+}
+
+int sitaiba_store_get_simple(int h, long index, unsigned char* elems_out, unsigned char* meta_out) {
+    int kind = (int)sitaiba_store_kind(h);
+    const unsigned char* rec = store_record_of(h, kind, index);
+    if (!rec || !elems_out) return -1;
+
+    const store_layout_t* l = store_layout(kind);
+    int n = (int)strlen(l->types);
+    for (int i = 0; i < n; i++) {
+        if (store_is_wire(l->types[i])) {
+            int len = store_elem_size(l->types[i]);
+            memcpy(elems_out, rec + store_offset(l, i), len);
+            elems_out += len;
+            continue;
+        }
+        element_t e;
+        store_load(e, rec, kind, i);
+        elems_out += sitaiba_wire_to_bytes(elems_out, e);
+        element_clear(e);
+    }
+    if (meta_out) memcpy(meta_out, rec + store_offset(l, n), l->meta);
+    return 0;
+}
+
+long sitaiba_store_count_simple(int h) {
+    return sitaiba_store_count(h);
+}
+
+int sitaiba_store_reset_simple(int h) {
+    return sitaiba_store_reset(h);
+}
+
+int sitaiba_store_sync_simple(int h) {
+    return sitaiba_store_sync(h);
+}
+
+void sitaiba_store_close_simple(int h) {
+    sitaiba_store_close(h);
+}
+
+int sitaiba_store_save_system_simple(int h, const unsigned char* A_m_buf, const unsigned char* a_m_buf) {
+    if (!sitaiba_is_initialized() || !A_m_buf || !a_m_buf) return -1;
+    if ((int)sitaiba_store_kind(h) != SITAIBA_STORE_SYSTEM) return -1;
+
+    element_t g, A_m, a_m;
+    store_elem_init(g, 'G');
+    sitaiba_get_generator(g);
+    buf_to_element_G1(A_m, A_m_buf);
+    buf_to_element_Zr(a_m, a_m_buf);
+
+    unsigned char* packed = malloc(sitaiba_wire_length(g) + sitaiba_wire_length(A_m) + sitaiba_wire_length(a_m));
+    long index = -1;
+    if (packed) {
+        int off = sitaiba_wire_to_bytes(packed, g);
+        off += sitaiba_wire_to_bytes(packed + off, A_m);
+        sitaiba_wire_to_bytes(packed + off, a_m);
+        // A store holds one session; saving again replaces it
+        sitaiba_store_reset(h);
+        index = sitaiba_store_append_simple(h, packed, NULL);
+        free(packed);
+    }
+
+    element_clear(g); element_clear(A_m); element_clear(a_m);
+    return index == 0 ? 0 : -1;
+}
+
+int sitaiba_store_load_system_simple(int h, unsigned char* A_m_out, unsigned char* a_m_out, int buf_size) {
+    if (!sitaiba_is_initialized() || !A_m_out || !a_m_out) return -1;
+    if ((int)sitaiba_store_kind(h) != SITAIBA_STORE_SYSTEM) return -1;
+    if (sitaiba_store_count(h) == 0) return 0;
+
+    const unsigned char* rec = store_record_of(h, SITAIBA_STORE_SYSTEM, 0);
+    element_t g, A_m, a_m;
+    store_load(g, rec, SITAIBA_STORE_SYSTEM, 0);
+    store_load(A_m, rec, SITAIBA_STORE_SYSTEM, 1);
+    store_load(a_m, rec, SITAIBA_STORE_SYSTEM, 2);
+
+    sitaiba_set_generator(g);
+    memset(A_m_out, 0, buf_size);
+    memset(a_m_out, 0, buf_size);
+    sitaiba_wire_to_bytes(A_m_out, A_m);
+    sitaiba_wire_to_bytes(a_m_out, a_m);
+
+    element_clear(g); element_clear(A_m); element_clear(a_m);
+    return 1;
+}
+
+int sitaiba_store_recognize_fast_simple(int addr_h, long addr_index, int key_h, long key_index) {
+    const unsigned char* addr = store_record_of(addr_h, SITAIBA_STORE_ADDRS, addr_index);
+    const unsigned char* key = store_record_of(key_h, SITAIBA_STORE_KEYS, key_index);
+    if (!addr || !key) return -1;
+    return store_recognize(addr, key);
+}
+
+long sitaiba_store_scan_simple(int addr_h, long start, long n, int key_h, long key_index,
+                               unsigned char* results) {
+    const unsigned char* key = store_record_of(key_h, SITAIBA_STORE_KEYS, key_index);
+    if (!key || !results || start < 0 || n < 0) return -1;
+    if (sitaiba_store_kind(addr_h) != SITAIBA_STORE_ADDRS || start + n > sitaiba_store_count(addr_h)) return -1;
+
+    long matches = 0;
+    for (long i = 0; i < n; i++) {
+        results[i] = (unsigned char)store_recognize(sitaiba_store_record(addr_h, start + i), key);
+        matches += results[i];
+    }
+    return matches;
+}
+
+long sitaiba_store_registry_load_simple(int key_h) {
+    if (!sitaiba_is_initialized() || sitaiba_store_kind(key_h) != SITAIBA_STORE_KEYS) return -1;
+
+    long n = sitaiba_store_count(key_h);
+    sitaiba_registry_clear();
+    for (long i = 0; i < n; i++) {
+        const unsigned char* rec = sitaiba_store_record(key_h, i);
+        element_t A, B;
+        store_load(A, rec, SITAIBA_STORE_KEYS, 0);
+        store_load(B, rec, SITAIBA_STORE_KEYS, 1);
+        int rc = sitaiba_registry_add(A, B, (int)i);
+        element_clear(A); element_clear(B);
+        if (rc < 0) return -1;
+    }
+    return n;
+}
+
+//----------------------------------------------
+// Primitive Counters
+//----------------------------------------------
+
+void sitaiba_primitive_stats_simple(unsigned long* counts, double* total_ms) {
+    prim_stats_t stats;
+    prim_get_stats(&stats);
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        if (counts) counts[i] = stats.count[i];
+        if (total_ms) total_ms[i] = stats.total_ms[i];
+    }
+}
+
+void sitaiba_reset_primitive_stats_simple(void) {
+    prim_reset_stats();
+}
+
+void sitaiba_primitive_hw_stats_simple(unsigned long* counts, double* totals) {
+    prim_hw_stats_t stats;
+    prim_get_hw_stats(&stats);
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        if (counts) counts[i] = stats.count[i];
+        for (int c = 0; totals && c < HWC_COUNT; c++) totals[i * HWC_COUNT + c] = stats.total[i][c];
+    }
+}
+
+long sitaiba_latency_histogram_simple(int op, unsigned long* counts, int n, double* max_ms) {
+    return sitaiba_latency_histogram(op, counts, n, max_ms);
+}
+
+int sitaiba_latency_bounds_simple(double* upper_ms, int n) {
+    int buckets = sitaiba_latency_buckets();
+    for (int i = 0; upper_ms && i < n && i < buckets; i++) {
+        upper_ms[i] = sitaiba_latency_bucket_ms(i);
+    }
+    return buckets;
+}
+
+//----------------------------------------------
+// Hex Encoding
+//----------------------------------------------
+
+int sitaiba_to_hex_simple(const unsigned char* in, int n, char* out) {
+    int zero = hex_encode(out, in, n > 0 ? n : 0);
+    out[n > 0 ? 2 * n : 0] = '\0';
+    return zero;
+}
+
+long sitaiba_from_hex_simple(const char* hex, long len, unsigned char* out, int buf_size) {
+    if (len < 0 || buf_size < 0) return -1;
+    return hex_decode(out, buf_size, hex, len);
+}
+
+long sitaiba_to_hex_batch_simple(const unsigned char* in, long n, int size, char* out,
+                                 unsigned char* zero_out) {
+    if (n <= 0 || size <= 0) return 0;
+    return hex_encode_rows(out, in, n, size, ',', zero_out);
+}
+
+long sitaiba_from_hex_batch_simple(const char* text, long len, long n, int size, unsigned char* out) {
+    if (n <= 0) return 0;
+    if (len < 0 || size <= 0) return -1;
+    return hex_decode_rows(out, n, size, text, len, ',');
+}
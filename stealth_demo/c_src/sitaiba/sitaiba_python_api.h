@@ -46,6 +46,32 @@ int sitaiba_element_size_G1_simple(void);
  */
 int sitaiba_element_size_Zr_simple(void);
 
+/**
+ * Select the G1 wire format used by every *_simple function
+ * @param format SITAIBA_POINT_UNCOMPRESSED (0) or SITAIBA_POINT_COMPRESSED (1)
+ * @return 0 on success, -1 on unknown format
+ */
+int sitaiba_set_point_format_simple(int format);
+
+/**
+ * Get the current G1 wire format
+ * @return SITAIBA_POINT_UNCOMPRESSED (0) or SITAIBA_POINT_COMPRESSED (1)
+ */
+int sitaiba_get_point_format_simple(void);
+
+/**
+ * Select the wire validation mode used by every *_simple function
+ * @param mode SITAIBA_VALIDATE_NONE (0) or SITAIBA_VALIDATE_SUBGROUP (1)
+ * @return 0 on success, -1 on unknown mode
+ */
+int sitaiba_set_validation_simple(int mode);
+
+/**
+ * Get the current wire validation mode
+ * @return SITAIBA_VALIDATE_NONE (0) or SITAIBA_VALIDATE_SUBGROUP (1)
+ */
+int sitaiba_get_validation_simple(void);
+
 /**
  * Generate user key pair - simplified for Python
  * @param A_buf Buffer for public key A (output)
@@ -105,6 +131,72 @@ int sitaiba_addr_recognize_simple(unsigned char* addr_buf, unsigned char* r1_buf
 int sitaiba_addr_recognize_fast_simple(unsigned char* r1_buf, unsigned char* r2_buf,
                                        unsigned char* A_r_buf, unsigned char* a_r_buf);
 
+/**
+ * Get view tag length in bytes - simplified for Python
+ */
+int sitaiba_view_tag_length_simple(void);
+
+/**
+ * Generate stealth address with view tag - simplified for Python
+ * @param A_r_buf User public key A (input)
+ * @param B_r_buf User public key B (input)
+ * @param A_m_buf Manager public key (input) - can be NULL to use internal
+ * @param addr_buf Generated address (output)
+ * @param r1_buf Random element R1 (output)
+ * @param r2_buf Random element R2 (output)
+ * @param tag_buf View tag, sitaiba_view_tag_length_simple() bytes (output)
+ * @param buf_size Size of each element buffer
+ */
+void sitaiba_addr_gen_tagged_simple(unsigned char* A_r_buf, unsigned char* B_r_buf, unsigned char* A_m_buf,
+                                    unsigned char* addr_buf, unsigned char* r1_buf, unsigned char* r2_buf,
+                                    unsigned char* tag_buf, int buf_size);
+
+/**
+ * Fast recognize with view tag prefilter - simplified for Python
+ * @param r1_buf Random element R1
+ * @param r2_buf Random element R2
+ * @param A_r_buf User public key A
+ * @param tag_buf View tag stored with the address
+ * @param a_r_buf User private key a
+ * @return 1 if recognized, 0 otherwise
+ */
+int sitaiba_addr_recognize_fast_tagged_simple(unsigned char* r1_buf, unsigned char* r2_buf,
+                                              unsigned char* A_r_buf, const unsigned char* tag_buf,
+                                              unsigned char* a_r_buf);
+
+/**
+ * Batch: audit n addresses generated for one user (sitaiba_addr_audit_batch)
+ * - simplified for Python
+ * @param addr_bytes, r1_bytes, r2_bytes n concatenated G1 elements each
+ * @param n Number of addresses
+ * @param A_r_buf, B_r_buf User public keys
+ * @param a_r_buf User private key a
+ * @param A_m_buf Manager public key - can be NULL to use internal
+ * @param results One byte per address, 1 if well formed (output)
+ * @return Number of well-formed addresses, -1 on error
+ */
+int sitaiba_addr_audit_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                    const unsigned char* r2_bytes, int n,
+                                    unsigned char* A_r_buf, unsigned char* B_r_buf,
+                                    unsigned char* a_r_buf, unsigned char* A_m_buf,
+                                    unsigned char* results);
+
+/**
+ * Batch: scan n outputs for one wallet across a worker pool
+ * (sitaiba_scan_batch) - simplified for Python
+ * @param r1_bytes, r2_bytes n concatenated G1 elements each
+ * @param tags n concatenated view tags, NULL to scan without the prefilter
+ * @param n Number of outputs
+ * @param A_r_buf User public key A
+ * @param a_r_buf User private key a
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param owned Indices of the owned outputs, room for n (output)
+ * @return Number of owned outputs, -1 on error
+ */
+int sitaiba_scan_batch_simple(const unsigned char* r1_bytes, const unsigned char* r2_bytes,
+                              const unsigned char* tags, int n, unsigned char* A_r_buf,
+                              unsigned char* a_r_buf, int num_threads, int* owned);
+
 /**
  * Generate one-time secret key - simplified for Python
  * @param r1_buf Random element R1 (input)
@@ -117,6 +209,41 @@ int sitaiba_addr_recognize_fast_simple(unsigned char* r1_buf, unsigned char* r2_
 void sitaiba_onetime_skgen_simple(unsigned char* r1_buf, unsigned char* a_r_buf, unsigned char* b_r_buf,
                                  unsigned char* A_m_buf, unsigned char* dsk_buf, int buf_size);
 
+/**
+ * Batch: one-time secret keys of n owned outputs
+ * (sitaiba_onetime_skgen_batch) - simplified for Python
+ * @param r1_bytes n concatenated G1 elements
+ * @param n Number of outputs
+ * @param a_r_buf User private key a (input)
+ * @param b_r_buf User private key b (input)
+ * @param A_m_buf Manager public key (input) - can be NULL to use internal
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param dsk_out n concatenated Zr elements (output)
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_onetime_skgen_batch_simple(const unsigned char* r1_bytes, int n,
+                                       unsigned char* a_r_buf, unsigned char* b_r_buf,
+                                       unsigned char* A_m_buf, int num_threads,
+                                       unsigned char* dsk_out);
+
+/**
+ * Recognize an output and, if owned, generate its DSK - simplified for Python
+ * @param r1_buf Random element R1 (input)
+ * @param r2_buf Random element R2 (input)
+ * @param A_r_buf User public key A (input)
+ * @param tag_buf View tag (input) - can be NULL if untagged
+ * @param a_r_buf User private key a (input)
+ * @param b_r_buf User private key b (input)
+ * @param A_m_buf Manager public key (input) - can be NULL to use internal
+ * @param dsk_buf One-time secret key, written if recognized (output)
+ * @param buf_size Size of each buffer
+ * @return 1 if recognized, 0 otherwise
+ */
+int sitaiba_recognize_and_derive_simple(unsigned char* r1_buf, unsigned char* r2_buf,
+                                        unsigned char* A_r_buf, const unsigned char* tag_buf,
+                                        unsigned char* a_r_buf, unsigned char* b_r_buf,
+                                        unsigned char* A_m_buf, unsigned char* dsk_buf, int buf_size);
+
 /**
  * Trace identity from address - simplified for Python
  * @param addr_buf Address to trace (input)
@@ -136,6 +263,87 @@ void sitaiba_trace_simple(unsigned char* addr_buf, unsigned char* r1_buf, unsign
  */
 void sitaiba_performance_test_simple(int iterations, double* results);
 
+/**
+ * Python Interface: Per-primitive call counts and times since load
+ * (or the last reset), summed over threads
+ * @param counts Array for call counts [6]
+ * @param total_ms Array for summed times in ms [6]
+ *                 order: pairing, g1_pow, gt_pow, hash_zr, hash_g1, serialize
+ */
+void sitaiba_primitive_stats_simple(unsigned long* counts, double* total_ms);
+
+/**
+ * Python Interface: Zero the per-primitive counters
+ */
+void sitaiba_reset_primitive_stats_simple(void);
+
+/**
+ * Python Interface: Per-primitive hardware counter totals of the calls
+ * made while counters were on (see sitaiba_set_hw_counters), summed over
+ * threads; sitaiba_reset_primitive_stats_simple zeroes them too
+ * @param counts Array for the number of calls measured [6], primitive
+ *               order as in sitaiba_primitive_stats_simple
+ * @param totals Array for the counter totals [6 * 6], one row per
+ *               primitive: cycles, instructions, l1d_misses, llc_misses,
+ *               branch_misses, allocs
+ */
+void sitaiba_primitive_hw_stats_simple(unsigned long* counts, double* totals);
+
+/**
+ * Python Interface: Snapshot of an operation's latency histogram
+ * (see sitaiba_latency_histogram); sitaiba_reset_performance clears it
+ * @param op Operation index, in sitaiba_performance_t order
+ * @param counts Array for the bucket counts
+ * @param n Size of counts
+ * @param max_ms Largest sample in ms (output, may be NULL)
+ * @return Number of samples, -1 on error
+ */
+long sitaiba_latency_histogram_simple(int op, unsigned long* counts, int n, double* max_ms);
+
+/**
+ * Python Interface: Upper bound in ms of each histogram bucket
+ * @param upper_ms Array for the bounds, may be NULL to ask the bucket count
+ * @param n Size of upper_ms
+ * @return Number of buckets
+ */
+int sitaiba_latency_bounds_simple(double* upper_ms, int n);
+
+/**
+ * Trace identity and resolve it in the key registry - simplified for Python
+ * @param addr_buf, r1_buf, r2_buf Address components
+ * @param a_m_buf Manager private key - can be NULL to use internal
+ * @param B_r_buf Recovered B (output, may be NULL)
+ * @param buf_size Size of B_r_buf
+ * @return Registry id of the owner, -1 if B is not registered
+ */
+int sitaiba_trace_lookup_simple(unsigned char* addr_buf, unsigned char* r1_buf, unsigned char* r2_buf,
+                                unsigned char* a_m_buf, unsigned char* B_r_buf, int buf_size);
+
+/**
+ * Register a key pair in the hash index - simplified for Python
+ * @param A_buf, B_buf Public keys
+ * @param id Registry id, >= 0
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_registry_add_simple(const unsigned char* A_buf, const unsigned char* B_buf, int id);
+
+/**
+ * Look up a registered key pair by A or B - simplified for Python
+ * @return Registry id, -1 if unknown
+ */
+int sitaiba_registry_find_A_simple(const unsigned char* A_buf);
+int sitaiba_registry_find_B_simple(const unsigned char* B_buf);
+
+/**
+ * Get number of registered key pairs - simplified for Python
+ */
+int sitaiba_registry_count_simple(void);
+
+/**
+ * Drop every registry entry - simplified for Python
+ */
+void sitaiba_registry_clear_simple(void);
+
 /**
  * Get tracer public key - simplified for Python
  * @param A_m_buf Buffer for tracer public key (output)
@@ -144,4 +352,152 @@ void sitaiba_performance_test_simple(int iterations, double* results);
  */
 int sitaiba_get_tracer_public_key_simple(unsigned char* A_m_buf, int buf_size);
 
+//----------------------------------------------
+// Store Interface
+// Keys, addresses and DSKs persisted in sitaiba_store files. Records hold
+// the canonical (uncompressed) encoding of their elements followed by
+// a little-endian metadata trailer; the byte-level calls below take and
+// return elements packed back to back in the current wire format.
+// Address records, the bulk of a ledger, keep their points in the compact
+// encoding (sitaiba_compact_to_bytes) at about half the size; y is only
+// recovered for points that are computed with, and with the compressed
+// wire format the stored bytes are passed through as they are.
+//   SITAIBA_STORE_KEYS    A, B (G1) | a, b (Zr)
+//   SITAIBA_STORE_ADDRS   Addr, R1, R2 (G1), compact | key index u32, flags u8, view tag
+//   SITAIBA_STORE_DSKS    dsk (Zr) | address index u32, key index u32, flags u8
+//   SITAIBA_STORE_SYSTEM  g, A_m (G1) | a_m (Zr)
+// Record sizes follow the pairing's element sizes, so a file written under
+// a parameter set with other sizes is refused on open.
+//----------------------------------------------
+
+#define SITAIBA_STORE_KEYS 1
+#define SITAIBA_STORE_ADDRS 2
+#define SITAIBA_STORE_DSKS 3
+#define SITAIBA_STORE_SYSTEM 4
+
+#define SITAIBA_STORE_ADDR_META (4 + 1 + SITAIBA_VIEW_TAG_LEN)
+#define SITAIBA_STORE_DSK_META (4 + 4 + 1)
+#define SITAIBA_STORE_FLAG_TAGGED 1     // address record carries a view tag
+
+/**
+ * Open (or create) a store file for one record kind - simplified for Python
+ * @param path File path
+ * @param kind SITAIBA_STORE_KEYS, _ADDRS, _DSKS or _SYSTEM
+ * @return Store handle (>= 0), -1 on error, -2 if the file was written with another layout
+ */
+int sitaiba_store_open_simple(const char* path, int kind);
+
+/**
+ * Append a record - simplified for Python
+ * @param h Store handle
+ * @param elems Record elements packed in the current wire format
+ * @param meta Metadata trailer for the kind (NULL writes zeros)
+ * @return Record index, -1 on error
+ */
+long sitaiba_store_append_simple(int h, const unsigned char* elems, const unsigned char* meta);
+
+/**
+ * Read a record back - simplified for Python
+ * @param h Store handle
+ * @param index Record index
+ * @param elems_out Record elements packed in the current wire format (output)
+ * @param meta_out Metadata trailer (output, may be NULL)
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_store_get_simple(int h, long index, unsigned char* elems_out, unsigned char* meta_out);
+
+/**
+ * Get number of records, -1 for a bad handle - simplified for Python
+ */
+long sitaiba_store_count_simple(int h);
+
+/**
+ * Drop every record of a store - simplified for Python
+ */
+int sitaiba_store_reset_simple(int h);
+
+/**
+ * Flush a store to disk - simplified for Python
+ */
+int sitaiba_store_sync_simple(int h);
+
+/**
+ * Close a store - simplified for Python
+ */
+void sitaiba_store_close_simple(int h);
+
+/**
+ * Save the session generator and tracer key pair (replaces any saved one) - simplified for Python
+ * @param h Handle of a SITAIBA_STORE_SYSTEM store
+ * @param A_m_buf, a_m_buf Tracer key pair
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_store_save_system_simple(int h, const unsigned char* A_m_buf, const unsigned char* a_m_buf);
+
+/**
+ * Restore a saved generator and return the saved tracer key pair - simplified for Python
+ * @param h Handle of a SITAIBA_STORE_SYSTEM store
+ * @param A_m_out, a_m_out Tracer key pair (output)
+ * @param buf_size Size of each buffer
+ * @return 1 if restored, 0 if nothing is saved yet, -1 on error
+ */
+int sitaiba_store_load_system_simple(int h, unsigned char* A_m_out, unsigned char* a_m_out, int buf_size);
+
+/**
+ * Fast recognition of a stored address with a stored key, - simplified for Python
+ * reading both records straight from the mapping
+ * @param addr_h, addr_index Address store and record
+ * @param key_h, key_index Key store and record
+ * @return 1 if recognized, 0 otherwise, -1 on error
+ */
+int sitaiba_store_recognize_fast_simple(int addr_h, long addr_index, int key_h, long key_index);
+
+/**
+ * Scan a range of stored addresses for one stored key - simplified for Python
+ * @param addr_h Address store
+ * @param start, n First record and number of records
+ * @param key_h, key_index Key store and record
+ * @param results One byte per address, 1 if recognized (output)
+ * @return Number of recognized addresses, -1 on error
+ */
+long sitaiba_store_scan_simple(int addr_h, long start, long n, int key_h, long key_index,
+                           unsigned char* results);
+
+/**
+ * Rebuild the key registry from a key store (record index = registry id) - simplified for Python
+ * @param key_h Key store
+ * @return Number of keys registered, -1 on error
+ */
+long sitaiba_store_registry_load_simple(int key_h);
+
+/**
+ * Hex: Lowercase hex of n bytes into out (2n characters and a NUL)
+ * @return 1 if every byte was zero, else 0
+ */
+int sitaiba_to_hex_simple(const unsigned char* in, int n, char* out);
+
+/**
+ * Hex: Decode len hex characters (an odd length takes a leading '0') into
+ * at most buf_size bytes of out
+ * @return Bytes the text decodes to (beyond buf_size dropped), -1 if it is not hex
+ */
+long sitaiba_from_hex_simple(const char* hex, long len, unsigned char* out, int buf_size);
+
+/**
+ * Hex: Encode n elements of size bytes, element i at in + i * size, into
+ * out as n comma-separated strings (n * (2 * size + 1) - 1 characters)
+ * @param zero_out One byte per element, 1 if it is all zero (output), NULL to skip
+ * @return Number of all-zero elements
+ */
+long sitaiba_to_hex_batch_simple(const unsigned char* in, long n, int size, char* out,
+                                 unsigned char* zero_out);
+
+/**
+ * Hex: Decode n comma-separated hex strings into n packed elements of size
+ * bytes each, zero padded on the right, as the batch functions take them
+ * @param text Strings separated by ',' (len characters)
+ * @return 0 on success, 1 + i if string i is empty or not hex, -1 if text holds fewer than n
+ */
+long sitaiba_from_hex_batch_simple(const char* text, long len, long n, int size, unsigned char* out);
+
 #endif /* SITAIBA_PYTHON_API_H */
\ No newline at end of file
@@ -0,0 +1,149 @@
+/****************************************************************************
+ * File: sitaiba_registry.c
+ * Desc: Key registry hash index implementation
+ *       Open addressing with linear probing, keyed by FNV-1a of the
+ *       canonical element encoding
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sitaiba_registry.h"
+
+//----------------------------------------------
+// Index layout
+//----------------------------------------------
+typedef struct {
+    unsigned char* key;          // canonical bytes, NULL if the slot is free
+    int len;
+    int id;
+    uint64_t hash;
+} registry_slot_t;
+
+typedef struct {
+    registry_slot_t* slots;
+    int capacity;                // power of two
+    int count;
+} registry_index_t;
+
+static registry_index_t index_A, index_B;
+
+#define REGISTRY_MIN_CAPACITY 64
+
+//----------------------------------------------
+// Helpers
+//----------------------------------------------
+static uint64_t fnv1a(const unsigned char* data, int len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static registry_slot_t* index_probe(registry_index_t* ix, const unsigned char* key, int len,
+                                    uint64_t hash) {
+    int mask = ix->capacity - 1;
+    for (int i = (int)(hash & mask);; i = (i + 1) & mask) {
+        registry_slot_t* s = &ix->slots[i];
+        if (!s->key) return s;
+        if (s->hash == hash && s->len == len && memcmp(s->key, key, len) == 0) return s;
+    }
+}
+
+static int index_grow(registry_index_t* ix) {
+    int capacity = ix->capacity ? ix->capacity * 2 : REGISTRY_MIN_CAPACITY;
+    registry_slot_t* slots = calloc(capacity, sizeof(registry_slot_t));
+    if (!slots) return -1;
+
+    registry_index_t grown = { slots, capacity, ix->count };
+    for (int i = 0; i < ix->capacity; i++) {
+        registry_slot_t* s = &ix->slots[i];
+        if (s->key) *index_probe(&grown, s->key, s->len, s->hash) = *s;
+    }
+    free(ix->slots);
+    *ix = grown;
+    return 0;
+}
+
+static int index_put(registry_index_t* ix, element_t e, int id) {
+    unsigned char buf[1024];
+    int len = element_length_in_bytes(e);
+    if (len > (int)sizeof(buf)) return -1;
+    element_to_bytes(buf, e);
+
+    // Keep the load factor under 0.7
+    if ((ix->count + 1) * 10 > ix->capacity * 7 && index_grow(ix) < 0) return -1;
+
+    uint64_t hash = fnv1a(buf, len);
+    registry_slot_t* s = index_probe(ix, buf, len, hash);
+    if (!s->key) {
+        s->key = malloc(len);
+        if (!s->key) return -1;
+        memcpy(s->key, buf, len);
+        s->len = len;
+        s->hash = hash;
+        ix->count++;
+    }
+    s->id = id;
+    return 0;
+}
+
+static int index_get(registry_index_t* ix, element_t e) {
+    unsigned char buf[1024];
+    int len = element_length_in_bytes(e);
+    if (!ix->count || len > (int)sizeof(buf)) return -1;
+    element_to_bytes(buf, e);
+
+    registry_slot_t* s = index_probe(ix, buf, len, fnv1a(buf, len));
+    return s->key ? s->id : -1;
+}
+
+static void index_clear(registry_index_t* ix) {
+    for (int i = 0; i < ix->capacity; i++) free(ix->slots[i].key);
+    free(ix->slots);
+    memset(ix, 0, sizeof(*ix));
+}
+
+//----------------------------------------------
+// Registry
+//----------------------------------------------
+
+/**
+ * Register a key pair
+ */
+int sitaiba_registry_add(element_t A, element_t B, int id) {
+    if (id < 0) return -1;
+    if (index_put(&index_A, A, id) < 0 || index_put(&index_B, B, id) < 0) return -1;
+    return 0;
+}
+
+/**
+ * Look up by public key A
+ */
+int sitaiba_registry_find_A(element_t A) {
+    return index_get(&index_A, A);
+}
+
+/**
+ * Look up by public key B
+ */
+int sitaiba_registry_find_B(element_t B) {
+    return index_get(&index_B, B);
+}
+
+/**
+ * Get number of registered key pairs
+ */
+int sitaiba_registry_count(void) {
+    return index_B.count;
+}
+
+/**
+ * Drop every entry
+ */
+void sitaiba_registry_clear(void) {
+    index_clear(&index_A);
+    index_clear(&index_B);
+}
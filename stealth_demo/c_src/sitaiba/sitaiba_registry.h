@@ -0,0 +1,47 @@
+/****************************************************************************
+ * File: sitaiba_registry.h
+ * Desc: Hash index over registered recipient keys for SITAIBA scheme
+ *       Maps the canonical (uncompressed) encoding of A and B to the
+ *       caller's key id, so a traced B resolves to its owner in O(1)
+ ****************************************************************************/
+
+#ifndef SITAIBA_REGISTRY_H
+#define SITAIBA_REGISTRY_H
+
+#include <pbc/pbc.h>
+
+/**
+ * Register a key pair. Re-adding a known A or B moves it to the new id.
+ * Not thread-safe; the registry is shared library state like the pairing.
+ * @param A Public key A
+ * @param B Public key B
+ * @param id Registry id (e.g. index in the caller's key list), >= 0
+ * @return 0 on success, -1 on error
+ */
+int sitaiba_registry_add(element_t A, element_t B, int id);
+
+/**
+ * Look up a key pair by public key A
+ * @param A Public key A
+ * @return Registered id, -1 if unknown
+ */
+int sitaiba_registry_find_A(element_t A);
+
+/**
+ * Look up a key pair by public key B
+ * @param B Public key B (e.g. the output of sitaiba_trace)
+ * @return Registered id, -1 if unknown
+ */
+int sitaiba_registry_find_B(element_t B);
+
+/**
+ * Get number of registered key pairs
+ */
+int sitaiba_registry_count(void);
+
+/**
+ * Drop every entry (call when the keys or the pairing change)
+ */
+void sitaiba_registry_clear(void);
+
+#endif /* SITAIBA_REGISTRY_H */
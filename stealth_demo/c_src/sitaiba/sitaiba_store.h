@@ -0,0 +1,54 @@
+/****************************************************************************
+ * File: sitaiba_store.h
+ * Desc: Append-only, memory-mapped record store for SITAIBA scheme
+ *       Thin wrappers over the shared store (common/record_store.h),
+ *       which documents the file layout and each call
+ ****************************************************************************/
+
+#ifndef SITAIBA_STORE_H
+#define SITAIBA_STORE_H
+
+#include <stdint.h>
+#include "record_store.h"
+
+#define SITAIBA_STORE_MAGIC RECORD_STORE_MAGIC
+#define SITAIBA_STORE_VERSION RECORD_STORE_VERSION
+#define SITAIBA_STORE_MAX_OPEN RECORD_STORE_MAX_OPEN
+
+/**
+ * Open (or create) a store file, see record_store_open
+ * @return Store handle (>= 0), -1 on I/O error, -2 if the file holds another kind or record size
+ */
+int sitaiba_store_open(const char* path, uint32_t kind, uint32_t record_size);
+
+/**
+ * Append one record, see record_store_append
+ * @return Index of the new record, -1 on error
+ */
+long sitaiba_store_append(int h, const unsigned char* record);
+
+/**
+ * Get a record in place, valid until the next append or close
+ * @return Pointer into the mapping, NULL if out of range
+ */
+const unsigned char* sitaiba_store_record(int h, long index);
+
+/** Get number of records, -1 for a bad handle */
+long sitaiba_store_count(int h);
+
+/** Get the record kind of an open store, 0 for a bad handle */
+uint32_t sitaiba_store_kind(int h);
+
+/** Get the record size of an open store, 0 for a bad handle */
+uint32_t sitaiba_store_record_size(int h);
+
+/** Drop every record (the file keeps its header) */
+int sitaiba_store_reset(int h);
+
+/** Flush the mapping to disk */
+int sitaiba_store_sync(int h);
+
+/** Sync, unmap and close a store; the handle becomes free */
+void sitaiba_store_close(int h);
+
+#endif /* SITAIBA_STORE_H */
@@ -0,0 +1,168 @@
+// Timing of the stealth core operations, used to compare library builds
+// (see lto.mk) and to train the profile-guided one.
+//
+// Usage: bench_stealth param_file [iterations]
+//
+// Prints one CSV line per operation: op,iterations,ms_per_op, and to
+// stderr the size of an aggregate against the signatures it replaces.
+// The aggregate keeps one GT commitment per signature, so it saves the
+// h values and all but one Q_sigma, not a constant size block.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "stealth_core.h"
+#include "perf_timer.h"
+
+enum { SCAN_BATCH = 64 };
+
+static void report(const char* op, int iters, double t0) {
+    printf("%s,%d,%.4f\n", op, iters, (perf_now_ms() - t0) / iters);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 2 ? atoi(argv[2]) : 200;
+    int i, ok = 0;
+    int batched = (iters + SCAN_BATCH - 1) / SCAN_BATCH * SCAN_BATCH;
+    double t0;
+    unsigned char bitmap[(SCAN_BATCH + 7) / 8];
+    element_t A, B, aZ, bZ, TK, kZ, Addr, R1, R2, C, dsk, Q, hZ, B_out;
+    element_t sR1[SCAN_BATCH], sC[SCAN_BATCH];
+    element_t bAddr[SCAN_BATCH], bR2[SCAN_BATCH], bC[SCAN_BATCH];
+    element_t bh[SCAN_BATCH], bQ[SCAN_BATCH], bX[SCAN_BATCH], Q_agg;
+    const char* msgs[SCAN_BATCH];
+    unsigned char results[SCAN_BATCH];
+
+    if (argc < 2 || iters <= 0) {
+        fprintf(stderr, "usage: %s param_file [iterations]\n", argv[0]);
+        return 1;
+    }
+    if (stealth_init(argv[1]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[1]);
+        return 1;
+    }
+    pairing_t* p = stealth_get_pairing();
+
+    element_init_G1(A, *p);
+    element_init_G1(B, *p);
+    element_init_Zr(aZ, *p);
+    element_init_Zr(bZ, *p);
+    element_init_G2(TK, *p);
+    element_init_Zr(kZ, *p);
+    element_init_G1(Addr, *p);
+    element_init_G1(R1, *p);
+    element_init_G2(R2, *p);
+    element_init_G1(C, *p);
+    element_init_G2(dsk, *p);
+    element_init_G2(Q, *p);
+    element_init_Zr(hZ, *p);
+    element_init_G1(B_out, *p);
+
+    printf("op,iterations,ms_per_op\n");
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) stealth_keygen(A, B, aZ, bZ);
+    report("keygen", iters, t0);
+    stealth_tracekeygen(TK, kZ);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) stealth_addr_gen(Addr, R1, R2, C, A, B, TK);
+    report("addr_gen", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) ok += stealth_addr_recognize_fast(R1, B, A, C, aZ);
+    report("recognize_fast", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
+    report("onetime_skgen", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) stealth_sign(Q, hZ, Addr, dsk, "bench");
+    report("sign", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) ok += stealth_verify(Addr, R2, C, "bench", hZ, Q);
+    report("verify", iters, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i++) stealth_trace(B_out, Addr, R1, R2, C, kZ);
+    report("trace", iters, t0);
+
+    // A block of SCAN_BATCH signatures by the one-time key above, before
+    // the scan outputs replace the address
+    element_init_G2(Q_agg, *p);
+    for (i = 0; i < SCAN_BATCH; i++) {
+        element_init_same_as(bAddr[i], Addr);
+        element_init_same_as(bR2[i], R2);
+        element_init_same_as(bC[i], C);
+        element_init_Zr(bh[i], *p);
+        element_init_G2(bQ[i], *p);
+        element_init_GT(bX[i], *p);
+        element_set(bAddr[i], Addr);
+        element_set(bR2[i], R2);
+        element_set(bC[i], C);
+        msgs[i] = "bench";
+        stealth_sign(bQ[i], bh[i], Addr, dsk, msgs[i]);
+    }
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i += SCAN_BATCH) {
+        if (stealth_aggregate(bX, Q_agg, bAddr, bC, msgs, bh, bQ, SCAN_BATCH, 0, results) == SCAN_BATCH)
+            ok += SCAN_BATCH;
+    }
+    report("aggregate", batched, t0);
+
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i += SCAN_BATCH) {
+        ok += SCAN_BATCH * stealth_verify_aggregate(bAddr, bR2, bC, msgs, bX, Q_agg, SCAN_BATCH);
+    }
+    report("verify_aggregate", batched, t0);
+
+    fprintf(stderr, "aggregate of %d signatures: %d bytes (%d B commitment each + %d B Q_agg), "
+            "%d bytes as signatures (%d B h + %d B Q_sigma each)\n",
+            SCAN_BATCH, SCAN_BATCH * stealth_element_size_GT() + stealth_element_size_G2(),
+            stealth_element_size_GT(), stealth_element_size_G2(),
+            SCAN_BATCH * (stealth_element_size_Zr() + stealth_element_size_G2()),
+            stealth_element_size_Zr(), stealth_element_size_G2());
+
+    for (i = 0; i < SCAN_BATCH; i++) {
+        element_init_G1(sR1[i], *p);
+        element_init_G1(sC[i], *p);
+        stealth_addr_gen(Addr, sR1[i], R2, sC[i], A, B, TK);
+    }
+    t0 = perf_now_ms();
+    for (i = 0; i < iters; i += SCAN_BATCH) {
+        ok += stealth_scan_batch(sR1, sC, SCAN_BATCH, B, aZ, bitmap);
+    }
+    report("scan_batch", batched, t0);
+
+    for (i = 0; i < SCAN_BATCH; i++) {
+        element_clear(sR1[i]);
+        element_clear(sC[i]);
+        element_clear(bAddr[i]);
+        element_clear(bR2[i]);
+        element_clear(bC[i]);
+        element_clear(bh[i]);
+        element_clear(bQ[i]);
+        element_clear(bX[i]);
+    }
+    element_clear(Q_agg);
+    element_clear(A);
+    element_clear(B);
+    element_clear(aZ);
+    element_clear(bZ);
+    element_clear(TK);
+    element_clear(kZ);
+    element_clear(Addr);
+    element_clear(R1);
+    element_clear(R2);
+    element_clear(C);
+    element_clear(dsk);
+    element_clear(Q);
+    element_clear(hZ);
+    element_clear(B_out);
+    stealth_cleanup();
+
+    // Every recognition, verification, scanned output and aggregate above is genuine.
+    return ok == 2 * iters + 3 * batched ? 0 : 1;
+}
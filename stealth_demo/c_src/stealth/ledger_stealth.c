@@ -0,0 +1,402 @@
+// Synthetic ledger generator and wallet sync replay for the stealth
+// scheme, for benchmarking wallet sync on realistic datasets (see lto.mk).
+//
+// Usage: ledger_stealth gen param_file dir outputs [recipients] [owned] [threads]
+//        ledger_stealth replay param_file dir [threads]
+//
+// gen writes a ledger into dir in the store format of the Python API
+// (stealth_python_api.h): keys.store with recipients key pairs (default
+// 64), system.store with the generator and tracer key pair, and
+// addrs.store with the tagged outputs. A fraction owned (default 0.01)
+// of them, spread evenly, pays key record 0, the wallet; the others go
+// round-robin to the remaining recipients. Each output record carries
+// the key index of its recipient. Outputs are generated GEN_CHUNK at a
+// time by stealth_addr_gen_block on threads threads (default: one per
+// online CPU).
+//
+// replay syncs the wallet the way a client would: one range of the
+// ledger per thread is read from the mapping and streamed through
+// stealth_ingest (recognition, then the one-time key of each owned
+// output), and the keys are appended to dsks.store. It then traces
+// every output with stealth_trace_batch. Prints CSV; found is the number
+// of owned outputs for gen and sync, of outputs traced to their
+// recipient's B for trace. Exits nonzero if sync or trace disagree with
+// the ledger.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "stealth_core.h"
+#include "stealth_store.h"
+#include "stealth_python_api.h"
+#include "scale_bench.h"
+#include "perf_timer.h"
+
+// Outputs generated, ingested or traced per call
+#define GEN_CHUNK 4096
+#define REPLAY_CHUNK 1024
+
+typedef struct {
+    char keys[1024], addrs[1024], dsks[1024], system[1024];
+} ledger_paths_t;
+
+static void ledger_paths(ledger_paths_t* p, const char* dir) {
+    snprintf(p->keys, sizeof(p->keys), "%s/keys.store", dir);
+    snprintf(p->addrs, sizeof(p->addrs), "%s/addrs.store", dir);
+    snprintf(p->dsks, sizeof(p->dsks), "%s/dsks.store", dir);
+    snprintf(p->system, sizeof(p->system), "%s/system.store", dir);
+}
+
+static element_t* elems_new(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
+
+static void elems_free(element_t* v, int n) {
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * Recipient of output i: the wallet (0) on an even spread of a fraction
+ * owned of the outputs, the others round-robin
+ */
+static int owner_of(long i, double owned, int recipients) {
+    if ((long)((i + 1) * owned) > (long)(i * owned)) return 0;
+    return 1 + (int)(i % (recipients - 1));
+}
+
+static void report(const char* phase, int threads, long n, long found, double ms) {
+    printf("stealth,%s,%d,%ld,%ld,%.1f,%.1f\n", phase, threads, n, found, ms,
+           ms > 0 ? n * 1000.0 / ms : 0);
+    fflush(stdout);
+}
+
+//----------------------------------------------
+// Generation
+//----------------------------------------------
+
+static int generate(const char* dir, long n, int recipients, double owned, int threads) {
+    pairing_ptr p = *stealth_get_pairing();
+    ledger_paths_t paths;
+    ledger_paths(&paths, dir);
+
+    int keys_h = stealth_store_open_simple(paths.keys, STEALTH_STORE_KEYS);
+    int addrs_h = stealth_store_open_simple(paths.addrs, STEALTH_STORE_ADDRS);
+    int system_h = stealth_store_open_simple(paths.system, STEALTH_STORE_SYSTEM);
+    if (keys_h < 0 || addrs_h < 0 || system_h < 0) {
+        fprintf(stderr, "cannot open the stores in %s\n", dir);
+        return 1;
+    }
+    stealth_store_reset(keys_h);
+    stealth_store_reset(addrs_h);
+
+    element_t TK, kZ;
+    element_init_G2(TK, p);
+    element_init_Zr(kZ, p);
+    stealth_tracekeygen(TK, kZ);
+    unsigned char* TK_bytes = malloc(stealth_wire_length(TK));
+    unsigned char* k_bytes = malloc(stealth_wire_length(kZ));
+    stealth_wire_to_bytes(TK_bytes, TK);
+    stealth_wire_to_bytes(k_bytes, kZ);
+    stealth_store_save_system_simple(system_h, TK_bytes, k_bytes);
+    free(TK_bytes);
+    free(k_bytes);
+
+    // Key records A, B, a, b in the canonical encoding
+    element_t* A = elems_new(recipients, p->G1);
+    element_t* B = elems_new(recipients, p->G1);
+    element_t aZ, bZ;
+    element_init_Zr(aZ, p);
+    element_init_Zr(bZ, p);
+    unsigned char* rec = malloc(stealth_store_record_size(addrs_h) + stealth_store_record_size(keys_h));
+    for (int k = 0; k < recipients; k++) {
+        stealth_keygen(A[k], B[k], aZ, bZ);
+        int off = element_to_bytes(rec, A[k]);
+        off += element_to_bytes(rec + off, B[k]);
+        off += element_to_bytes(rec + off, aZ);
+        element_to_bytes(rec + off, bZ);
+        stealth_store_append(keys_h, rec);
+    }
+    element_clear(aZ);
+    element_clear(bZ);
+
+    element_t *Addr = elems_new(GEN_CHUNK, p->G1), *R1 = elems_new(GEN_CHUNK, p->G1);
+    element_t *R2 = elems_new(GEN_CHUNK, p->G2), *C = elems_new(GEN_CHUNK, p->G1);
+    element_t *A_of = elems_new(GEN_CHUNK, p->G1), *B_of = elems_new(GEN_CHUNK, p->G1);
+    unsigned char* tags = malloc(GEN_CHUNK * STEALTH_VIEW_TAG_LEN);
+    int* owner = malloc(GEN_CHUNK * sizeof(int));
+    long wallet = 0;
+
+    double t0 = perf_now_ms();
+    for (long base = 0; base < n; base += GEN_CHUNK) {
+        int m = (int)(n - base < GEN_CHUNK ? n - base : GEN_CHUNK);
+        for (int i = 0; i < m; i++) {
+            owner[i] = owner_of(base + i, owned, recipients);
+            wallet += owner[i] == 0;
+            element_set(A_of[i], A[owner[i]]);
+            element_set(B_of[i], B[owner[i]]);
+        }
+        stealth_addr_gen_block(Addr, R1, R2, C, tags, A_of, B_of, TK, m, threads);
+
+        for (int i = 0; i < m; i++) {
+            // Output records keep their points compact
+            int off = stealth_compact_to_bytes(rec, Addr[i]);
+            off += stealth_compact_to_bytes(rec + off, R1[i]);
+            off += stealth_compact_to_bytes(rec + off, R2[i]);
+            off += stealth_compact_to_bytes(rec + off, C[i]);
+            put_u32(rec + off, (uint32_t)owner[i]);
+            rec[off + 4] = STEALTH_STORE_FLAG_TAGGED;
+            memcpy(rec + off + 5, tags + i * STEALTH_VIEW_TAG_LEN, STEALTH_VIEW_TAG_LEN);
+            if (stealth_store_append(addrs_h, rec) < 0) {
+                fprintf(stderr, "cannot append to %s\n", paths.addrs);
+                n = base + i;
+                break;
+            }
+        }
+    }
+    stealth_store_sync(addrs_h);
+    report("gen", threads, n, wallet, perf_now_ms() - t0);
+
+    elems_free(Addr, GEN_CHUNK); elems_free(R1, GEN_CHUNK); elems_free(R2, GEN_CHUNK);
+    elems_free(C, GEN_CHUNK); elems_free(A_of, GEN_CHUNK); elems_free(B_of, GEN_CHUNK);
+    elems_free(A, recipients);
+    elems_free(B, recipients);
+    element_clear(TK);
+    element_clear(kZ);
+    free(tags);
+    free(owner);
+    free(rec);
+    stealth_store_close(keys_h);
+    stealth_store_close(addrs_h);
+    stealth_store_close(system_h);
+    return 0;
+}
+
+//----------------------------------------------
+// Replay
+//----------------------------------------------
+
+typedef struct {
+    int keys_h, addrs_h, dsks_h;
+    int offs[5];                 // Addr, R1, R2, C and metadata within an output record
+    element_t B, aZ, bZ, kZ;
+    int failed;
+    long found, expected, traced;
+    pthread_mutex_t lock;
+} replay_t;
+
+typedef struct {
+    replay_t* r;
+    long base;                   // ledger index of stream position 0
+    unsigned char* dsk_rec;
+} sink_t;
+
+// Append the key of each owned output to the DSK store
+static void sink_dsk(void* arg, int index, element_t dsk) {
+    sink_t* s = (sink_t*)arg;
+    replay_t* r = s->r;
+    long addr = s->base + index;
+    const unsigned char* rec = stealth_store_record(r->addrs_h, addr);
+    int off = element_to_bytes(s->dsk_rec, dsk);
+
+    put_u32(s->dsk_rec + off, (uint32_t)addr);
+    put_u32(s->dsk_rec + off + 4, 0);
+    s->dsk_rec[off + 8] = 0;
+    stealth_store_append(r->dsks_h, s->dsk_rec);
+    if (get_u32(rec + r->offs[4]) != 0) r->failed = 1;
+}
+
+static void sync_range(void* arg, int begin, int end) {
+    replay_t* r = (replay_t*)arg;
+    pairing_ptr p = *stealth_get_pairing();
+    int len = stealth_ingest_record_length(1);
+    unsigned char* records = malloc((size_t)REPLAY_CHUNK * len);
+    sink_t sink = { r, 0, malloc(stealth_store_record_size(r->dsks_h)) };
+    element_t e;
+    long found = 0;
+
+    element_init_G1(e, p);
+    for (long base = begin; base < end; base += REPLAY_CHUNK) {
+        int m = (int)(end - base < REPLAY_CHUNK ? end - base : REPLAY_CHUNK);
+        unsigned char* out = records;
+        for (int i = 0; i < m; i++) {
+            const unsigned char* rec = stealth_store_record(r->addrs_h, base + i);
+            stealth_compact_from_bytes(e, rec + r->offs[0]);
+            out += stealth_wire_to_bytes(out, e);
+            stealth_compact_from_bytes(e, rec + r->offs[1]);
+            out += stealth_wire_to_bytes(out, e);
+            stealth_compact_from_bytes(e, rec + r->offs[3]);
+            out += stealth_wire_to_bytes(out, e);
+            memcpy(out, rec + r->offs[4] + 5, STEALTH_VIEW_TAG_LEN);
+            out += STEALTH_VIEW_TAG_LEN;
+        }
+        sink.base = base;
+        int owned = stealth_ingest(records, m, 1, r->B, r->aZ, r->bZ, sink_dsk, &sink);
+        if (owned < 0) r->failed = 1;
+        else found += owned;
+    }
+    element_clear(e);
+    free(sink.dsk_rec);
+    free(records);
+
+    pthread_mutex_lock(&r->lock);
+    r->found += found;
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void trace_range(void* arg, int begin, int end) {
+    replay_t* r = (replay_t*)arg;
+    pairing_ptr p = *stealth_get_pairing();
+    element_t *Addr = elems_new(REPLAY_CHUNK, p->G1), *R1 = elems_new(REPLAY_CHUNK, p->G1);
+    element_t *R2 = elems_new(REPLAY_CHUNK, p->G2), *C = elems_new(REPLAY_CHUNK, p->G1);
+    element_t *B_out = elems_new(REPLAY_CHUNK, p->G1), B;
+    long traced = 0;
+
+    element_init_G1(B, p);
+    for (long base = begin; base < end; base += REPLAY_CHUNK) {
+        int m = (int)(end - base < REPLAY_CHUNK ? end - base : REPLAY_CHUNK);
+        for (int i = 0; i < m; i++) {
+            unsigned char* rec = (unsigned char*)stealth_store_record(r->addrs_h, base + i);
+            stealth_compact_from_bytes(Addr[i], rec + r->offs[0]);
+            stealth_compact_from_bytes(R1[i], rec + r->offs[1]);
+            stealth_compact_from_bytes(R2[i], rec + r->offs[2]);
+            stealth_compact_from_bytes(C[i], rec + r->offs[3]);
+        }
+        stealth_trace_batch(B_out, Addr, R1, R2, C, m, r->kZ);
+        for (int i = 0; i < m; i++) {
+            const unsigned char* rec = stealth_store_record(r->addrs_h, base + i);
+            unsigned char* key = (unsigned char*)stealth_store_record(r->keys_h,
+                                                                      get_u32(rec + r->offs[4]));
+            if (!key) continue;
+            element_from_bytes(B, key + element_length_in_bytes(B));
+            traced += !element_cmp(B, B_out[i]);
+        }
+    }
+    element_clear(B);
+    elems_free(Addr, REPLAY_CHUNK); elems_free(R1, REPLAY_CHUNK); elems_free(R2, REPLAY_CHUNK);
+    elems_free(C, REPLAY_CHUNK); elems_free(B_out, REPLAY_CHUNK);
+
+    pthread_mutex_lock(&r->lock);
+    r->traced += traced;
+    pthread_mutex_unlock(&r->lock);
+}
+
+static int replay(const char* dir, int threads) {
+    pairing_ptr p = *stealth_get_pairing();
+    ledger_paths_t paths;
+    replay_t r;
+    ledger_paths(&paths, dir);
+    memset(&r, 0, sizeof(r));
+
+    int system_h = stealth_store_open_simple(paths.system, STEALTH_STORE_SYSTEM);
+    r.keys_h = stealth_store_open_simple(paths.keys, STEALTH_STORE_KEYS);
+    r.addrs_h = stealth_store_open_simple(paths.addrs, STEALTH_STORE_ADDRS);
+    r.dsks_h = stealth_store_open_simple(paths.dsks, STEALTH_STORE_DSKS);
+    if (system_h < 0 || r.keys_h < 0 || r.addrs_h < 0 || r.dsks_h < 0 ||
+        stealth_store_count(r.keys_h) == 0) {
+        fprintf(stderr, "no ledger in %s (run gen first, with the same parameters)\n", dir);
+        return 1;
+    }
+    stealth_store_reset(r.dsks_h);
+
+    // The keys were made under the saved generator
+    int buf = pairing_length_in_bytes_G2(p) + pairing_length_in_bytes_Zr(p);
+    unsigned char *TK_bytes = malloc(buf), *k_bytes = malloc(buf);
+    stealth_store_load_system_simple(system_h, TK_bytes, k_bytes, buf);
+    element_init_Zr(r.kZ, p);
+    stealth_wire_from_bytes(r.kZ, k_bytes);
+    free(TK_bytes);
+    free(k_bytes);
+    stealth_store_close(system_h);
+
+    element_init_G1(r.B, p);
+    element_init_Zr(r.aZ, p);
+    element_init_Zr(r.bZ, p);
+    unsigned char* key = (unsigned char*)stealth_store_record(r.keys_h, 0);
+    key += element_length_in_bytes(r.B);
+    key += element_from_bytes(r.B, key);
+    key += element_from_bytes(r.aZ, key);
+    element_from_bytes(r.bZ, key);
+
+    r.offs[1] = pairing_length_in_bytes_compressed_G1(p);
+    r.offs[2] = 2 * r.offs[1];
+    r.offs[3] = r.offs[2] + pairing_length_in_bytes_compressed_G2(p);
+    r.offs[4] = r.offs[3] + r.offs[1];
+    pthread_mutex_init(&r.lock, NULL);
+
+    long n = stealth_store_count(r.addrs_h);
+    for (long i = 0; i < n; i++) {
+        r.expected += get_u32(stealth_store_record(r.addrs_h, i) + r.offs[4]) == 0;
+    }
+
+    double t0 = perf_now_ms();
+    scale_run_ranges(sync_range, &r, (int)n, threads);
+    stealth_store_sync(r.dsks_h);
+    report("sync", threads, n, r.found, perf_now_ms() - t0);
+
+    t0 = perf_now_ms();
+    scale_run_ranges(trace_range, &r, (int)n, threads);
+    report("trace", threads, n, r.traced, perf_now_ms() - t0);
+
+    int failed = r.failed || r.found != r.expected || stealth_store_count(r.dsks_h) != r.expected ||
+                 r.traced != n;
+    if (failed) {
+        fprintf(stderr, "wrong results: %ld of %ld owned outputs found, %ld of %ld traced\n",
+                r.found, r.expected, r.traced, n);
+    }
+
+    element_clear(r.B); element_clear(r.aZ); element_clear(r.bZ); element_clear(r.kZ);
+    pthread_mutex_destroy(&r.lock);
+    stealth_store_close(r.keys_h);
+    stealth_store_close(r.addrs_h);
+    stealth_store_close(r.dsks_h);
+    return failed;
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "usage: %s gen param_file dir outputs [recipients] [owned] [threads]\n"
+                    "       %s replay param_file dir [threads]\n", prog, prog);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int gen = argc > 1 && !strcmp(argv[1], "gen");
+    if (argc < 4 || (!gen && strcmp(argv[1], "replay")) || (gen && argc < 5)) return usage(argv[0]);
+
+    long n = gen ? atol(argv[4]) : 0;
+    int recipients = gen && argc > 5 ? atoi(argv[5]) : 64;
+    double owned = gen && argc > 6 ? atof(argv[6]) : 0.01;
+    int threads = argc > (gen ? 7 : 4) ? atoi(argv[gen ? 7 : 4]) : 0;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    if (gen && (n <= 0 || n > 0x7fffffff || recipients < 1 || owned < 0 || owned > 1 ||
+                (recipients == 1 && owned < 1))) {
+        fprintf(stderr, "outputs must be positive, owned in [0, 1], and recipients > 1 "
+                        "unless every output is owned\n");
+        return 1;
+    }
+    if (stealth_init(argv[2]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("scheme,phase,threads,outputs,found,ms,outputs_per_sec\n");
+    int rc = gen ? generate(argv[3], n, recipients, owned, threads) : replay(argv[3], threads);
+    stealth_cleanup();
+    return rc;
+}
@@ -0,0 +1,224 @@
+// Multi-core scaling of stealth scanning, verification and tracing on a
+// fixed synthetic ledger, for sizing scanning hosts (see lto.mk).
+//
+// Usage: scale_stealth param_file [outputs] [max_threads] [repeats]
+//
+// The ledger holds outputs paid round-robin to SCALE_RECIPIENTS key
+// pairs, each signed by its owner. Each operation runs over the whole
+// ledger at 1, 2, 4, ... max_threads threads (default: one per online
+// CPU), best of repeats runs:
+//
+//   scan    stealth_ctx_scan for the first key pair, a context per count
+//   verify  stealth_verify_block
+//   trace   stealth_trace_batch on one contiguous range per thread
+//
+// Prints CSV, see scale_report. ledger_MBps counts the serialized output
+// components an operation reads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stealth_core.h"
+#include "stealth_ctx.h"
+#include "scale_bench.h"
+
+enum { SCALE_RECIPIENTS = 8 };
+
+#define SCALE_MSG "scale"
+
+typedef struct {
+    int n;
+    element_t *Addr, *R1, *R2, *C, *hZ, *Q, *B_out;
+    element_t A[SCALE_RECIPIENTS], B[SCALE_RECIPIENTS];
+    element_t aZ[SCALE_RECIPIENTS], bZ[SCALE_RECIPIENTS];
+    element_t TK, kZ;
+    const char** msgs;
+    unsigned char *R1_bytes, *C_bytes, *B_bytes, *a_bytes;
+    unsigned char *bitmap, *valid;
+    stealth_ctx_t* ctx;
+    int matches;
+} ledger_t;
+
+static element_t* elems_new(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
+
+static void elems_free(element_t* v, int n) {
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+static void ledger_init(ledger_t* l, int n) {
+    pairing_ptr p = *stealth_get_pairing();
+    int g1 = stealth_element_size_G1();
+    element_t *A_of, *B_of, dsk;
+
+    l->n = n;
+    l->Addr = elems_new(n, p->G1);
+    l->R1 = elems_new(n, p->G1);
+    l->R2 = elems_new(n, p->G2);
+    l->C = elems_new(n, p->G1);
+    l->hZ = elems_new(n, p->Zr);
+    l->Q = elems_new(n, p->G2);
+    l->B_out = elems_new(n, p->G1);
+    l->msgs = malloc((size_t)n * sizeof(char*));
+    l->R1_bytes = malloc((size_t)n * g1);
+    l->C_bytes = malloc((size_t)n * g1);
+    l->B_bytes = malloc(g1);
+    l->a_bytes = malloc(stealth_element_size_Zr());
+    l->bitmap = malloc((n + 7) / 8);
+    l->valid = malloc(n);
+
+    for (int k = 0; k < SCALE_RECIPIENTS; k++) {
+        element_init_G1(l->A[k], p);
+        element_init_G1(l->B[k], p);
+        element_init_Zr(l->aZ[k], p);
+        element_init_Zr(l->bZ[k], p);
+        stealth_keygen(l->A[k], l->B[k], l->aZ[k], l->bZ[k]);
+    }
+    element_init_G2(l->TK, p);
+    element_init_Zr(l->kZ, p);
+    stealth_tracekeygen(l->TK, l->kZ);
+
+    // Outputs in parallel, each with its recipient's keys
+    A_of = elems_new(n, p->G1);
+    B_of = elems_new(n, p->G1);
+    for (int i = 0; i < n; i++) {
+        element_set(A_of[i], l->A[i % SCALE_RECIPIENTS]);
+        element_set(B_of[i], l->B[i % SCALE_RECIPIENTS]);
+    }
+    stealth_addr_gen_block(l->Addr, l->R1, l->R2, l->C, NULL, A_of, B_of, l->TK, n, 0);
+    elems_free(A_of, n);
+    elems_free(B_of, n);
+
+    element_init_G2(dsk, p);
+    for (int i = 0; i < n; i++) {
+        int k = i % SCALE_RECIPIENTS;
+        stealth_onetime_skgen(dsk, l->Addr[i], l->R1[i], l->aZ[k], l->bZ[k]);
+        stealth_sign(l->Q[i], l->hZ[i], l->Addr[i], dsk, SCALE_MSG);
+        l->msgs[i] = SCALE_MSG;
+        stealth_wire_to_bytes(l->R1_bytes + (size_t)i * g1, l->R1[i]);
+        stealth_wire_to_bytes(l->C_bytes + (size_t)i * g1, l->C[i]);
+    }
+    element_clear(dsk);
+    stealth_wire_to_bytes(l->B_bytes, l->B[0]);
+    element_to_bytes(l->a_bytes, l->aZ[0]);
+}
+
+static void ledger_clear(ledger_t* l) {
+    elems_free(l->Addr, l->n);
+    elems_free(l->R1, l->n);
+    elems_free(l->R2, l->n);
+    elems_free(l->C, l->n);
+    elems_free(l->hZ, l->n);
+    elems_free(l->Q, l->n);
+    elems_free(l->B_out, l->n);
+    for (int k = 0; k < SCALE_RECIPIENTS; k++) {
+        element_clear(l->A[k]);
+        element_clear(l->B[k]);
+        element_clear(l->aZ[k]);
+        element_clear(l->bZ[k]);
+    }
+    element_clear(l->TK);
+    element_clear(l->kZ);
+    free(l->msgs);
+    free(l->R1_bytes);
+    free(l->C_bytes);
+    free(l->B_bytes);
+    free(l->a_bytes);
+    free(l->bitmap);
+    free(l->valid);
+}
+
+static void run_scan(void* arg, int n, int threads) {
+    ledger_t* l = (ledger_t*)arg;
+    (void)threads;   // fixed by the context
+    l->matches = stealth_ctx_scan(l->ctx, l->R1_bytes, l->C_bytes, n, l->B_bytes,
+                                  l->a_bytes, l->bitmap);
+}
+
+static void run_verify(void* arg, int n, int threads) {
+    ledger_t* l = (ledger_t*)arg;
+    l->matches = stealth_verify_block(l->Addr, l->R2, l->C, l->msgs, l->hZ, l->Q, n,
+                                      threads, l->valid);
+}
+
+static void trace_range(void* arg, int begin, int end) {
+    ledger_t* l = (ledger_t*)arg;
+    stealth_trace_batch(l->B_out + begin, l->Addr + begin, l->R1 + begin, l->R2 + begin,
+                        l->C + begin, end - begin, l->kZ);
+}
+
+static void run_trace(void* arg, int n, int threads) {
+    ledger_t* l = (ledger_t*)arg;
+    scale_run_ranges(trace_range, l, n, threads);
+    l->matches = 0;
+    for (int i = 0; i < n; i++) {
+        l->matches += !element_cmp(l->B_out[i], l->B[i % SCALE_RECIPIENTS]);
+    }
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 2 ? atoi(argv[2]) : 1024;
+    int max_threads = argc > 3 ? atoi(argv[3]) : 0;
+    int repeats = argc > 4 ? atoi(argv[4]) : 3;
+    int counts[SCALE_MAX_COUNTS], num_counts, failed = 0;
+    double copy_mbps[SCALE_MAX_COUNTS];
+    double base_scan = 0, base_verify = 0, base_trace = 0;
+    ledger_t l;
+
+    if (argc < 2 || n <= 0 || repeats <= 0) {
+        fprintf(stderr, "usage: %s param_file [outputs] [max_threads] [repeats]\n", argv[0]);
+        return 1;
+    }
+    if (stealth_init(argv[1]) != 0) {
+        fprintf(stderr, "cannot initialize from %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "building a ledger of %d outputs...\n", n);
+    ledger_init(&l, n);
+
+    int g1 = stealth_element_size_G1(), g2 = stealth_element_size_G2();
+    int zr = stealth_element_size_Zr();
+    int owned = (n + SCALE_RECIPIENTS - 1) / SCALE_RECIPIENTS;
+    num_counts = scale_thread_counts(max_threads, counts, SCALE_MAX_COUNTS);
+    for (int i = 0; i < num_counts; i++) copy_mbps[i] = scale_copy_bandwidth(counts[i]);
+
+    scale_report_header();
+    for (int i = 0; i < num_counts; i++) {
+        int t = counts[i];
+        double ms;
+
+        l.ctx = stealth_ctx_new(argv[1], t);
+        if (!l.ctx) {
+            fprintf(stderr, "cannot create a scanning context of %d workers\n", t);
+            failed = 1;
+            break;
+        }
+        ms = scale_time(run_scan, &l, n, t, repeats);
+        stealth_ctx_free(l.ctx);
+        if (i == 0) base_scan = n * 1000.0 / ms;
+        scale_report("stealth", "scan", t, n, ms, base_scan, 2 * g1, copy_mbps[i]);
+        failed |= l.matches != owned;
+    }
+    for (int i = 0; i < num_counts; i++) {
+        double ms = scale_time(run_verify, &l, n, counts[i], repeats);
+        if (i == 0) base_verify = n * 1000.0 / ms;
+        scale_report("stealth", "verify", counts[i], n, ms, base_verify, 2 * g1 + 2 * g2 + zr,
+                     copy_mbps[i]);
+        failed |= l.matches != n;
+    }
+    for (int i = 0; i < num_counts; i++) {
+        double ms = scale_time(run_trace, &l, n, counts[i], repeats);
+        if (i == 0) base_trace = n * 1000.0 / ms;
+        scale_report("stealth", "trace", counts[i], n, ms, base_trace, 3 * g1 + g2, copy_mbps[i]);
+        failed |= l.matches != n;
+    }
+
+    ledger_clear(&l);
+    stealth_cleanup();
+    if (failed) fprintf(stderr, "wrong results: some operation did not check out\n");
+    return failed;
+}
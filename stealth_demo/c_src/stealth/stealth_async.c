@@ -0,0 +1,182 @@
+/****************************************************************************
+ * File: stealth_async.c
+ * Desc: Non-blocking submission API, see stealth_async.h
+ *       Every operation is a job that holds the arguments of the blocking
+ *       call and makes that call on a pool thread
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include "stealth_async.h"
+#include "stealth_python_api.h"
+#include "completion_queue.h"
+
+//----------------------------------------------
+// Queue
+//----------------------------------------------
+
+stealth_async_t* stealth_async_new(int num_threads, int capacity) {
+    return cq_new(num_threads, capacity);
+}
+
+void stealth_async_free(stealth_async_t* q) {
+    cq_free(q);
+}
+
+int stealth_async_fd(const stealth_async_t* q) {
+    return cq_fd(q);
+}
+
+int stealth_async_poll(stealth_async_t* q, long* tickets, int* results, int max) {
+    return cq_poll(q, tickets, results, max);
+}
+
+int stealth_async_wait(stealth_async_t* q, long* tickets, int* results, int max, int timeout_ms) {
+    return cq_wait(q, tickets, results, max, timeout_ms);
+}
+
+int stealth_async_pending(stealth_async_t* q) {
+    return cq_pending(q);
+}
+
+long stealth_async_submit(stealth_async_t* q, int (*work)(void* arg), void* arg,
+                          void (*done)(long ticket, int result, void* user), void* user) {
+    return cq_submit(q, work, arg, done, user);
+}
+
+// Queue a job made by one of the operations below, freeing it if refused
+static long submit_job(stealth_async_t* q, cq_work_fn work, void* job) {
+    if (!job) return -1;
+    long ticket = cq_submit(q, work, job, NULL, NULL);
+    if (ticket < 0) free(job);
+    return ticket;
+}
+
+//----------------------------------------------
+// Operations
+//----------------------------------------------
+
+typedef struct {
+    const unsigned char *R1, *C, *tags, *B, *a;
+    int n;
+    unsigned char* results;
+    stealth_ctx_t* ctx;
+} recognize_job_t;
+
+static int recognize_work(void* arg) {
+    recognize_job_t* j = (recognize_job_t*)arg;
+    int rc = j->tags ? stealth_addr_recognize_fast_tagged_batch(j->R1, j->C, j->tags, j->n,
+                                                                j->B, j->a, j->results)
+                     : stealth_addr_recognize_fast_batch(j->R1, j->C, j->n, j->B, j->a,
+                                                         j->results);
+    free(j);
+    return rc;
+}
+
+static int ctx_scan_work(void* arg) {
+    recognize_job_t* j = (recognize_job_t*)arg;
+    int rc = stealth_ctx_scan_tagged(j->ctx, j->R1, j->C, j->tags, j->n, j->B, j->a, j->results);
+    free(j);
+    return rc;
+}
+
+static recognize_job_t* recognize_job(stealth_ctx_t* ctx, const unsigned char* R1_bytes,
+                                      const unsigned char* C_bytes, const unsigned char* tags,
+                                      int n, const unsigned char* B_bytes,
+                                      const unsigned char* a_bytes, unsigned char* results) {
+    recognize_job_t* j = malloc(sizeof(recognize_job_t));
+    if (!j) return NULL;
+    *j = (recognize_job_t){ R1_bytes, C_bytes, tags, B_bytes, a_bytes, n, results, ctx };
+    return j;
+}
+
+long stealth_async_recognize_batch(stealth_async_t* q, const unsigned char* R1_bytes,
+                                   const unsigned char* C_bytes, const unsigned char* tags,
+                                   int n, const unsigned char* B_bytes,
+                                   const unsigned char* a_bytes, unsigned char* results) {
+    return submit_job(q, recognize_work,
+                      recognize_job(NULL, R1_bytes, C_bytes, tags, n, B_bytes, a_bytes, results));
+}
+
+long stealth_async_ctx_scan(stealth_async_t* q, stealth_ctx_t* ctx,
+                            const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                            const unsigned char* tags, int n, const unsigned char* B_bytes,
+                            const unsigned char* a_bytes, unsigned char* out_bitmap) {
+    if (!ctx) return -1;
+    return submit_job(q, ctx_scan_work,
+                      recognize_job(ctx, R1_bytes, C_bytes, tags, n, B_bytes, a_bytes, out_bitmap));
+}
+
+typedef struct {
+    const unsigned char *A, *B, *TK;
+    int n, num_threads;
+    unsigned char *addr, *r1, *r2, *c, *tags;
+} addr_gen_job_t;
+
+static int addr_gen_work(void* arg) {
+    addr_gen_job_t* j = (addr_gen_job_t*)arg;
+    int rc = stealth_addr_gen_block_simple(j->A, j->B, j->TK, j->n, j->num_threads,
+                                           j->addr, j->r1, j->r2, j->c, j->tags);
+    free(j);
+    return rc;
+}
+
+long stealth_async_addr_gen_block(stealth_async_t* q, const unsigned char* A_bytes,
+                                  const unsigned char* B_bytes, const unsigned char* TK_bytes,
+                                  int n, int num_threads, unsigned char* addr_out,
+                                  unsigned char* r1_out, unsigned char* r2_out,
+                                  unsigned char* c_out, unsigned char* tags_out) {
+    addr_gen_job_t* j = malloc(sizeof(addr_gen_job_t));
+    if (j) *j = (addr_gen_job_t){ A_bytes, B_bytes, TK_bytes, n, num_threads,
+                                  addr_out, r1_out, r2_out, c_out, tags_out };
+    return submit_job(q, addr_gen_work, j);
+}
+
+typedef struct {
+    const unsigned char *addr, *r1, *a, *b;
+    int n;
+    unsigned char* dsk;
+} dsk_gen_job_t;
+
+static int dsk_gen_work(void* arg) {
+    dsk_gen_job_t* j = (dsk_gen_job_t*)arg;
+    int rc = stealth_dsk_gen_batch(j->addr, j->r1, j->n, j->a, j->b, j->dsk);
+    free(j);
+    return rc;
+}
+
+long stealth_async_dsk_gen_batch(stealth_async_t* q, const unsigned char* addr_bytes,
+                                 const unsigned char* r1_bytes, int n,
+                                 const unsigned char* a_bytes, const unsigned char* b_bytes,
+                                 unsigned char* dsk_out) {
+    dsk_gen_job_t* j = malloc(sizeof(dsk_gen_job_t));
+    if (j) *j = (dsk_gen_job_t){ addr_bytes, r1_bytes, a_bytes, b_bytes, n, dsk_out };
+    return submit_job(q, dsk_gen_work, j);
+}
+
+typedef struct {
+    const unsigned char *addr, *r2, *c;
+    const char* messages;
+    const int* message_lens;
+    const unsigned char *h, *q_sigma;
+    int n;
+    unsigned char* results;
+} verify_job_t;
+
+static int verify_work(void* arg) {
+    verify_job_t* j = (verify_job_t*)arg;
+    int rc = stealth_verify_batch(j->addr, j->r2, j->c, j->messages, j->message_lens,
+                                  j->h, j->q_sigma, j->n, j->results);
+    free(j);
+    return rc;
+}
+
+long stealth_async_verify_batch(stealth_async_t* q, const unsigned char* addr_bytes,
+                                const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                const char* messages, const int* message_lens,
+                                const unsigned char* h_bytes, const unsigned char* q_sigma_bytes,
+                                int n, unsigned char* results) {
+    verify_job_t* j = malloc(sizeof(verify_job_t));
+    if (j) *j = (verify_job_t){ addr_bytes, r2_bytes, c_bytes, messages, message_lens,
+                                h_bytes, q_sigma_bytes, n, results };
+    return submit_job(q, verify_work, j);
+}
@@ -0,0 +1,124 @@
+/****************************************************************************
+ * File: stealth_async.h
+ * Desc: Non-blocking submission API for Traceable Anonymous Transaction
+ *       Scheme. Operations are queued to a pool and return a ticket at
+ *       once; results come back through a completion queue whose eventfd
+ *       plugs into an event loop (asyncio add_reader, epoll, Go netpoll,
+ *       tokio AsyncFd), so async servers need no blocked thread per
+ *       request. See completion_queue.h.
+ ****************************************************************************/
+
+#ifndef STEALTH_ASYNC_H
+#define STEALTH_ASYNC_H
+
+#include "stealth_ctx.h"
+
+/**
+ * Opaque queue with its pool of worker threads
+ */
+typedef struct completion_queue_s stealth_async_t;
+
+/**
+ * Start a queue and its pool
+ * @param num_threads Pool threads, <= 0 for one per online CPU
+ * @param capacity Most operations submitted and not yet reaped, <= 0 for 1024
+ * @return New queue, NULL on failure
+ */
+stealth_async_t* stealth_async_new(int num_threads, int capacity);
+
+/**
+ * Finish every submitted operation, stop the pool and release the queue;
+ * completions not reaped are dropped
+ */
+void stealth_async_free(stealth_async_t* q);
+
+/**
+ * File descriptor that is readable while completions wait to be reaped;
+ * watch it for reading, then call stealth_async_poll
+ */
+int stealth_async_fd(const stealth_async_t* q);
+
+/**
+ * Reap up to max completions without waiting
+ * @param tickets Tickets of the finished operations (output)
+ * @param results Their return values, as from the blocking call (output)
+ * @return Number reaped
+ */
+int stealth_async_poll(stealth_async_t* q, long* tickets, int* results, int max);
+
+/**
+ * stealth_async_poll waiting up to timeout_ms (< 0 without limit) for the
+ * first completion
+ * @return Number reaped, 0 on timeout
+ */
+int stealth_async_wait(stealth_async_t* q, long* tickets, int* results, int max, int timeout_ms);
+
+/**
+ * Operations submitted and not yet reaped
+ */
+int stealth_async_pending(stealth_async_t* q);
+
+/**
+ * Queue work(arg), which releases arg. With done set, done(ticket, result,
+ * user) runs on the pool thread instead of a completion being queued.
+ * @return Ticket (> 0), -1 if the queue is full (arg is then still the caller's)
+ */
+long stealth_async_submit(stealth_async_t* q, int (*work)(void* arg), void* arg,
+                          void (*done)(long ticket, int result, void* user), void* user);
+
+//----------------------------------------------
+// Operations
+//----------------------------------------------
+// Each takes the arguments of the blocking call named, which must stay
+// valid, and its outputs untouched, until the ticket completes. The
+// completion result is that call's return value.
+
+/**
+ * stealth_addr_recognize_fast_batch, or the tagged batch when tags is set
+ * @return Ticket, -1 if the queue is full
+ */
+long stealth_async_recognize_batch(stealth_async_t* q, const unsigned char* R1_bytes,
+                                   const unsigned char* C_bytes, const unsigned char* tags,
+                                   int n, const unsigned char* B_bytes,
+                                   const unsigned char* a_bytes, unsigned char* results);
+
+/**
+ * stealth_ctx_scan_tagged on a context (tags NULL to scan untagged); the
+ * context runs one scan at a time, so scans on it queue behind each other
+ * @return Ticket, -1 if the queue is full
+ */
+long stealth_async_ctx_scan(stealth_async_t* q, stealth_ctx_t* ctx,
+                            const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                            const unsigned char* tags, int n, const unsigned char* B_bytes,
+                            const unsigned char* a_bytes, unsigned char* out_bitmap);
+
+/**
+ * stealth_addr_gen_block_simple
+ * @return Ticket, -1 if the queue is full
+ */
+long stealth_async_addr_gen_block(stealth_async_t* q, const unsigned char* A_bytes,
+                                  const unsigned char* B_bytes, const unsigned char* TK_bytes,
+                                  int n, int num_threads, unsigned char* addr_out,
+                                  unsigned char* r1_out, unsigned char* r2_out,
+                                  unsigned char* c_out, unsigned char* tags_out);
+
+/**
+ * stealth_dsk_gen_batch
+ * @return Ticket, -1 if the queue is full
+ */
+long stealth_async_dsk_gen_batch(stealth_async_t* q, const unsigned char* addr_bytes,
+                                 const unsigned char* r1_bytes, int n,
+                                 const unsigned char* a_bytes, const unsigned char* b_bytes,
+                                 unsigned char* dsk_out);
+
+/**
+ * stealth_verify_batch
+ * @return Ticket, -1 if the queue is full
+ */
+long stealth_async_verify_batch(stealth_async_t* q, const unsigned char* addr_bytes,
+                                const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                const char* messages, const int* message_lens,
+                                const unsigned char* h_bytes, const unsigned char* q_sigma_bytes,
+                                int n, unsigned char* results);
+
+#endif /* STEALTH_ASYNC_H */
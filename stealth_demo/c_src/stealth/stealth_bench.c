@@ -0,0 +1,283 @@
+/****************************************************************************
+ * File: stealth_bench.c
+ * Desc: Configurable benchmark of the stealth core operations
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include "stealth_core.h"
+#include "stealth_bench.h"
+#include "perf_timer.h"
+#include "seeded_random.h"
+
+#define BENCH_MSG "Benchmark message"
+
+// Per-call latencies of the running benchmark, one slot per operation
+static perf_set_t bench_stats = PERF_HIST_SET_INITIALIZER;
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Key pair, trace key and recipient context, read-only during the calls
+typedef struct {
+    element_t A, B, aZ, bZ, TK, kZ;
+    stealth_recipient_ctx_t ctx;
+    int precompute;
+} bench_keys_t;
+
+// One thread's fixture of n outputs, its outputs and its timings
+typedef struct {
+    pthread_t tid;
+    bench_keys_t* keys;
+    int op, n, iterations, warmup, own_random;
+    seeded_random_job_t random;
+    element_t *Addr, *R1, *R2, *C, *dsk, *Q, *hZ, *B_out;
+    const char** msgs;
+    unsigned char* flags;        // scan bitmap or verification results
+    element_t oAddr, oR1, oR2, oC, odsk, oQ, ohZ;
+    double start_ms, end_ms;
+} bench_job_t;
+
+static element_t* elems_new(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    if (!v) return NULL;
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
+
+static void elems_free(element_t* v, int n) {
+    if (!v) return;
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+/**
+ * Allocate a job and generate its outputs, one-time keys and signatures
+ */
+static int job_init(bench_job_t* job, bench_keys_t* keys, int n, pairing_ptr p) {
+    job->keys = keys;
+    job->n = n;
+    job->Addr = elems_new(n, p->G1);
+    job->R1 = elems_new(n, p->G1);
+    job->R2 = elems_new(n, p->G2);
+    job->C = elems_new(n, p->G1);
+    job->dsk = elems_new(n, p->G2);
+    job->Q = elems_new(n, p->G2);
+    job->hZ = elems_new(n, p->Zr);
+    job->B_out = elems_new(n, p->G1);
+    job->msgs = malloc((size_t)n * sizeof(char*));
+    job->flags = malloc((size_t)n);
+    element_init_G1(job->oAddr, p);
+    element_init_G1(job->oR1, p);
+    element_init_G2(job->oR2, p);
+    element_init_G1(job->oC, p);
+    element_init_G2(job->odsk, p);
+    element_init_G2(job->oQ, p);
+    element_init_Zr(job->ohZ, p);
+    if (!job->Addr || !job->R1 || !job->R2 || !job->C || !job->dsk || !job->Q ||
+        !job->hZ || !job->B_out || !job->msgs || !job->flags) return -1;
+
+    for (int i = 0; i < n; i++) {
+        stealth_addr_gen(job->Addr[i], job->R1[i], job->R2[i], job->C[i],
+                         keys->A, keys->B, keys->TK);
+        stealth_onetime_skgen(job->dsk[i], job->Addr[i], job->R1[i], keys->aZ, keys->bZ);
+        stealth_sign(job->Q[i], job->hZ[i], job->Addr[i], job->dsk[i], BENCH_MSG);
+        job->msgs[i] = BENCH_MSG;
+    }
+    return 0;
+}
+
+static void job_clear(bench_job_t* job) {
+    if (!job->keys) return;
+    elems_free(job->Addr, job->n);
+    elems_free(job->R1, job->n);
+    elems_free(job->R2, job->n);
+    elems_free(job->C, job->n);
+    elems_free(job->dsk, job->n);
+    elems_free(job->Q, job->n);
+    elems_free(job->hZ, job->n);
+    elems_free(job->B_out, job->n);
+    free(job->msgs);
+    free(job->flags);
+    element_clear(job->oAddr); element_clear(job->oR1); element_clear(job->oR2);
+    element_clear(job->oC); element_clear(job->odsk); element_clear(job->oQ);
+    element_clear(job->ohZ);
+}
+
+/**
+ * One call: job->n outputs through job->op
+ */
+static void bench_call(bench_job_t* job) {
+    bench_keys_t* k = job->keys;
+    int n = job->n;
+
+    switch (job->op) {
+    case STEALTH_BENCH_ADDR_GEN:
+        for (int i = 0; i < n; i++) {
+            if (k->precompute) stealth_addr_gen_ctx(job->oAddr, job->oR1, job->oR2, job->oC, &k->ctx);
+            else stealth_addr_gen(job->oAddr, job->oR1, job->oR2, job->oC, k->A, k->B, k->TK);
+        }
+        break;
+    case STEALTH_BENCH_ADDR_RECOGNIZE:
+        for (int i = 0; i < n; i++) {
+            stealth_addr_recognize(job->Addr[i], job->R1[i], k->B, k->A, job->C[i], k->aZ, k->TK);
+        }
+        break;
+    case STEALTH_BENCH_FAST_RECOGNIZE:
+        if (n > 1) stealth_scan_batch(job->R1, job->C, n, k->B, k->aZ, job->flags);
+        else stealth_addr_recognize_fast(job->R1[0], k->B, k->A, job->C[0], k->aZ);
+        break;
+    case STEALTH_BENCH_ONETIME_SK:
+        for (int i = 0; i < n; i++) {
+            stealth_onetime_skgen(job->odsk, job->Addr[i], job->R1[i], k->aZ, k->bZ);
+        }
+        break;
+    case STEALTH_BENCH_SIGN:
+        for (int i = 0; i < n; i++) {
+            stealth_sign(job->oQ, job->ohZ, job->Addr[i], job->dsk[i], BENCH_MSG);
+        }
+        break;
+    case STEALTH_BENCH_VERIFY:
+        if (n > 1) {
+            stealth_verify_block(job->Addr, job->R2, job->C, job->msgs, job->hZ, job->Q,
+                                 n, 1, job->flags);
+        } else {
+            stealth_verify(job->Addr[0], job->R2[0], job->C[0], BENCH_MSG, job->hZ[0], job->Q[0]);
+        }
+        break;
+    case STEALTH_BENCH_TRACE:
+        if (n > 1) stealth_trace_batch(job->B_out, job->Addr, job->R1, job->R2, job->C, n, k->kZ);
+        else stealth_trace(job->B_out[0], job->Addr[0], job->R1[0], job->R2[0], job->C[0], k->kZ);
+        break;
+    }
+}
+
+static void* bench_worker(void* arg) {
+    bench_job_t* job = (bench_job_t*)arg;
+
+    seeded_random_bind_t rnd;
+    int bound = job->own_random && seeded_random_bind(&rnd, &job->random) == 0;
+
+    for (int i = 0; i < job->warmup; i++) bench_call(job);
+
+    job->start_ms = perf_now_ms();
+    for (int i = 0; i < job->iterations; i++) {
+        double t = perf_now_ms();
+        bench_call(job);
+        perf_add(&bench_stats, job->op, perf_now_ms() - t);
+    }
+    job->end_ms = perf_now_ms();
+
+    if (bound) seeded_random_unbind(&rnd);
+    return NULL;
+}
+
+/**
+ * Run one operation on every job at once; job 0 runs on the calling thread
+ * @return Number of jobs that ran
+ */
+static int bench_op(bench_job_t* jobs, int num_threads, int op, const stealth_bench_config_t* cfg) {
+    for (int i = 0; i < num_threads; i++) {
+        jobs[i].op = op;
+        jobs[i].iterations = cfg->iterations;
+        jobs[i].warmup = cfg->warmup;
+        jobs[i].own_random = num_threads > 1;
+        if (jobs[i].own_random) seeded_random_job(&jobs[i].random);
+    }
+
+    // A thread that fails to start is left out rather than run afterwards,
+    // which would stretch the wall time
+    int started = 1;
+    while (started < num_threads &&
+           pthread_create(&jobs[started].tid, NULL, bench_worker, &jobs[started]) == 0)
+        started++;
+    bench_worker(&jobs[0]);
+    for (int i = 1; i < started; i++) pthread_join(jobs[i].tid, NULL);
+    return started;
+}
+
+/**
+ * Benchmark the selected operations
+ */
+int stealth_benchmark(const stealth_bench_config_t* cfg, stealth_bench_result_t* results, int n) {
+    if (!stealth_is_initialized() || !cfg || !results || n <= 0) return -1;
+    if (cfg->iterations <= 0 || cfg->batch_size <= 0 || cfg->warmup < 0) return -1;
+
+    unsigned int ops = cfg->ops ? cfg->ops & STEALTH_BENCH_ALL : STEALTH_BENCH_ALL;
+    int num_threads = cfg->num_threads;
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    pthread_mutex_lock(&bench_lock);
+    pairing_ptr p = *stealth_get_pairing();
+    bench_keys_t keys;
+    element_init_G1(keys.A, p);
+    element_init_G1(keys.B, p);
+    element_init_Zr(keys.aZ, p);
+    element_init_Zr(keys.bZ, p);
+    element_init_G2(keys.TK, p);
+    element_init_Zr(keys.kZ, p);
+    stealth_keygen(keys.A, keys.B, keys.aZ, keys.bZ);
+    stealth_tracekeygen(keys.TK, keys.kZ);
+
+    double setup_ms = 0;
+    keys.precompute = 0;
+    if (cfg->precompute && (ops & (1u << STEALTH_BENCH_ADDR_GEN))) {
+        double t = perf_now_ms();
+        keys.precompute = stealth_recipient_ctx_init(&keys.ctx, keys.A, keys.B, keys.TK) == 0;
+        setup_ms = perf_now_ms() - t;
+    }
+
+    int filled = -1;
+    bench_job_t* jobs = calloc(num_threads, sizeof(bench_job_t));
+    if (!jobs) goto done;
+    for (int i = 0; i < num_threads; i++) {
+        if (job_init(&jobs[i], &keys, cfg->batch_size, p) != 0) goto done;
+    }
+
+    // Counters hold the benchmark calls only
+    stealth_reset_performance();
+    perf_reset(&bench_stats);
+
+    filled = 0;
+    for (int op = 0; op < STEALTH_BENCH_OPS && filled < n; op++) {
+        if (!(ops & (1u << op))) continue;
+
+        int threads = bench_op(jobs, num_threads, op, cfg);
+        double first = jobs[0].start_ms, last = jobs[0].end_ms;
+        for (int i = 1; i < threads; i++) {
+            if (jobs[i].start_ms < first) first = jobs[i].start_ms;
+            if (jobs[i].end_ms > last) last = jobs[i].end_ms;
+        }
+
+        perf_latency_t lat;
+        perf_latency(&bench_stats, op, &lat);
+
+        stealth_bench_result_t* r = &results[filled++];
+        r->op = op;
+        r->threads = threads;
+        r->calls = (unsigned long)threads * cfg->iterations;
+        r->items = r->calls * cfg->batch_size;
+        r->wall_ms = last - first;
+        r->items_per_sec = r->wall_ms > 0 ? r->items * 1000.0 / r->wall_ms : 0;
+        r->setup_ms = op == STEALTH_BENCH_ADDR_GEN ? setup_ms : 0;
+        r->mean_ms = lat.mean_ms;
+        r->p50_ms = lat.p50_ms;
+        r->p90_ms = lat.p90_ms;
+        r->p99_ms = lat.p99_ms;
+        r->max_ms = lat.max_ms;
+    }
+
+done:
+    if (jobs) {
+        for (int i = 0; i < num_threads; i++) job_clear(&jobs[i]);
+        free(jobs);
+    }
+    if (keys.precompute) stealth_recipient_ctx_clear(&keys.ctx);
+    element_clear(keys.A); element_clear(keys.B); element_clear(keys.aZ);
+    element_clear(keys.bZ); element_clear(keys.TK); element_clear(keys.kZ);
+    pthread_mutex_unlock(&bench_lock);
+    return filled;
+}
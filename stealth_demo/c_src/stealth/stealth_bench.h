@@ -0,0 +1,67 @@
+/****************************************************************************
+ * File: stealth_bench.h
+ * Desc: Configurable benchmark of the stealth core operations
+ *       Steady-state throughput and per-call latency percentiles for a
+ *       chosen set of operations, batch size, thread count and
+ *       precomputation mode, after untimed warm-up calls
+ ****************************************************************************/
+
+#ifndef STEALTH_BENCH_H
+#define STEALTH_BENCH_H
+
+// Operations, in stealth_performance_t order
+enum {
+    STEALTH_BENCH_ADDR_GEN,
+    STEALTH_BENCH_ADDR_RECOGNIZE,
+    STEALTH_BENCH_FAST_RECOGNIZE,
+    STEALTH_BENCH_ONETIME_SK,
+    STEALTH_BENCH_SIGN,
+    STEALTH_BENCH_VERIFY,
+    STEALTH_BENCH_TRACE,
+    STEALTH_BENCH_OPS
+};
+
+#define STEALTH_BENCH_ALL ((1u << STEALTH_BENCH_OPS) - 1)
+
+typedef struct {
+    unsigned int ops;    // bit (1 << op) per operation, 0 for all
+    int iterations;      // timed calls per operation and thread
+    int batch_size;      // outputs per call, see stealth_benchmark
+    int num_threads;     // <= 0 for one per online CPU
+    int precompute;      // per-recipient tables for address generation
+    int warmup;          // untimed calls per operation and thread first
+} stealth_bench_config_t;
+
+typedef struct {
+    int op;
+    int threads;             // threads that ran
+    unsigned long calls;     // timed calls over every thread
+    unsigned long items;     // calls * batch_size
+    double wall_ms;          // first timed call to last, over every thread
+    double items_per_sec;    // items / wall time
+    double setup_ms;         // precomputation before the calls, 0 without
+    double mean_ms;          // per call
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+} stealth_bench_result_t;
+
+/**
+ * Run the selected operations one after another, each on every thread at
+ * once, on one key pair and per-thread fixtures of batch_size outputs
+ * built beforehand. A call handles batch_size outputs: fast recognition
+ * goes through stealth_scan_batch, verification through
+ * stealth_verify_block on the calling thread and tracing through
+ * stealth_trace_batch; the other operations loop. With precompute the
+ * threads generate addresses through one stealth_recipient_ctx_t built
+ * beforehand (setup_ms), without it through stealth_addr_gen. Resets
+ * the performance counters.
+ * @param cfg Configuration
+ * @param results Array to fill, in operation order (output)
+ * @param n Size of results
+ * @return Number of entries filled, -1 on error
+ */
+int stealth_benchmark(const stealth_bench_config_t* cfg, stealth_bench_result_t* results, int n);
+
+#endif /* STEALTH_BENCH_H */
@@ -8,148 +8,539 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pbc/pbc.h>
-#include <pbc/pbc_test.h>
 #include <openssl/sha.h>
-#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "stealth_core.h"
-
-// Global state for the library
-static pairing_t pairing;
-static element_t g;
+#include "stealth_store.h"
+#include "perf_timer.h"
+#include "perf_prim.h"
+#include "scratch.h"
+#include "pairing_tune.h"
+#include "pp_cache.h"
+#include "hash_stream.h"
+#include "seeded_random.h"
+#include "eph_pool.h"
+#include "dsk_cache.h"
+#include "hash_cache.h"
+#include "batch_check.h"
+#include "param_file.h"
+#include "cpu_topo.h"
+
+// Initialized pairings by parameter file, see STEALTH_PAIRING_CACHE_SIZE
+typedef struct {
+    char* path;                  // NULL while the slot is free
+    uint64_t hash;               // FNV-1a of the file contents
+    unsigned long last_used;
+    pairing_tune_t tune;         // empty when initialized without autotuning
+    char tuning[32];             // "<fp> <method>" of tune
+    pairing_t pairing;
+    element_t g;
+    element_pp_t g_pp;
+    element_t g2;                // asymmetric pairings only, hashed from g
+    element_pp_t g2_pp;
+    pairing_pp_t g_pairing_pp;
+    element_t egg;               // e(g, g2), so that signing needs no pairing
+    element_pp_t egg_pp;
+    int pp_node;                 // node the tables above were built on
+    // Copies of g_pp, g2_pp and egg_pp for the other nodes, see node_pp
+    element_pp_ptr g_pp_copy[CPU_TOPO_MAX_NODES];
+    element_pp_ptr g2_pp_copy[CPU_TOPO_MAX_NODES];
+    element_pp_ptr egg_pp_copy[CPU_TOPO_MAX_NODES];
+    scratch_pool_t scratch;
+    pp_cache_t pp_cache;         // tables of recent R1 values
+    pp_cache_t verify_pp_cache;  // tables of recently verified C values
+} pairing_slot_t;
+
+static pairing_slot_t pairing_cache[STEALTH_PAIRING_CACHE_SIZE];
+static unsigned long pairing_clock = 0;
+
+// Global state for the library, pointing into the active cache slot
+static pairing_ptr pairing;
+static element_ptr g;
+static element_pp_ptr g_pp;   // fixed-base table for g, see STEALTH_G_PP_WINDOW
+static element_ptr g2;        // generator of G2, g itself when G1 == G2
+static element_pp_ptr g2_pp;
+static int asymmetric = 0;    // G1 != G2, see stealth_init
+static pairing_pp_ptr g_pairing_pp;   // Miller-loop lines for e(g, .), used by verify
+static element_ptr egg;               // e(g, g2)
+static element_pp_ptr egg_pp;
+static pairing_slot_t* active;        // slot the pointers above come from
+static int node_tables = 0;           // per-node table copies, see stealth_set_worker_pinning
+static pthread_mutex_t node_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static scratch_pool_t* scratch;       // workspaces of the active pairing
+static pp_cache_t* pp_cache;          // R1 tables of the active pairing
+static int pp_cache_size = STEALTH_PP_CACHE_SIZE;
+static pp_cache_t* verify_pp_cache;   // C tables of the active pairing
+static int verify_pp_cache_size = STEALTH_VERIFY_PP_CACHE_SIZE;
+static eph_pool_t addr_pool;          // (r, g^r) for address generation
+static eph_pool_t sign_pool;          // (x, g2^x, e(g, g2)^x) for signing
+static int eph_pool_size = STEALTH_EPH_POOL_SIZE;
+static int eph_pools_live = 0;        // both pools initialized on the active pairing
+static dsk_cache_t dsk_cache;         // keys of addresses that sign again
+static int dsk_cache_size = STEALTH_DSK_CACHE_SIZE;
+static double dsk_cache_ttl_ms = STEALTH_DSK_CACHE_TTL_MS;
+static int dsk_cache_live = 0;        // initialized on the active pairing
+static hash_cache_t h3_cache;         // mapped H3(Addr) of recent addresses
+static int h3_cache_size = STEALTH_H3_CACHE_SIZE;
+static int h3_cache_live = 0;         // initialized on the active pairing
 static int library_initialized = 0;
-
-// Performance tracking
-static double sumAddrGen=0, sumAddrRecognize=0, sumFastAddrRecognize=0, sumOnetimeSK=0,
-              sumSign=0, sumVerify=0, sumTrace=0;
+static int point_format = STEALTH_POINT_UNCOMPRESSED;
+static int validation = STEALTH_VALIDATE_NONE;
+static int hash_version = STEALTH_HASH_G1_POW;
+static int allocator = STEALTH_ALLOC_MALLOC;
+static const char* tuning = NULL;     // configuration of the active pairing, see pairing_tune.h
+
+// Performance tracking: wall-clock ms per operation, summed over threads,
+// and a histogram of the per-call latencies
+enum {
+    PERF_ADDR_GEN, PERF_ADDR_RECOGNIZE, PERF_FAST_RECOGNIZE, PERF_ONETIME_SK,
+    PERF_SIGN, PERF_VERIFY, PERF_TRACE
+};
+static perf_set_t perf_stats = PERF_HIST_SET_INITIALIZER;
 int perf_counter = 0;
 
 //----------------------------------------------
 // Timer helper
 //----------------------------------------------
-double timer_diff(clock_t start, clock_t end) {
-    return ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0; // in ms
+double timer_diff(double start, double end) {
+    return end - start; // in ms
+}
+
+//----------------------------------------------
+// Fixed-base tables local to the calling thread's NUMA node
+//----------------------------------------------
+
+/**
+ * The table home, or its copy on the caller's node while node tables are
+ * on. The first thread to need a copy on a node builds it, so the kernel
+ * places it there; copies are read-only once published.
+ */
+#if STEALTH_G_PP_WINDOW > 0
+static element_pp_ptr node_pp(element_pp_ptr copy[], element_pp_ptr home, element_ptr base) {
+    if (!node_tables) return home;
+    int node = cpu_topo_current_node();
+    if (node == active->pp_node) return home;
+    element_pp_ptr t = __atomic_load_n(&copy[node], __ATOMIC_ACQUIRE);
+    if (t) return t;
+    pthread_mutex_lock(&node_tables_lock);
+    t = copy[node];
+    if (!t && (t = malloc(sizeof(*t)))) {
+        element_pp_init_k(t, base, STEALTH_G_PP_WINDOW);
+        __atomic_store_n(&copy[node], t, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&node_tables_lock);
+    return t ? t : home;
+}
+#endif
+
+static void node_pp_clear(element_pp_ptr copy[]) {
+    for (int k = 0; k < CPU_TOPO_MAX_NODES; k++) {
+        if (!copy[k]) continue;
+        element_pp_clear(copy[k]);
+        free(copy[k]);
+        copy[k] = NULL;
+    }
+}
+
+//----------------------------------------------
+// g^z through the precomputed table when enabled
+//----------------------------------------------
+static void g_pow_zn(element_t out, element_t z) {
+#if STEALTH_G_PP_WINDOW > 0
+    prim_pp_pow_zn(out, z, node_pp(active->g_pp_copy, g_pp, g));
+#else
+    prim_pow_zn(out, g, z);
+#endif
+}
+
+//----------------------------------------------
+// Powers by secret exponents, see STEALTH_SECRET_CT
+//----------------------------------------------
+static void secret_pow_zn(element_t x, element_t a, element_t n) {
+#if STEALTH_SECRET_CT
+    prim_pow_zn_ct(x, a, n);
+#else
+    prim_pow_zn(x, a, n);
+#endif
+}
+
+static void secret_pow_mpz(element_t x, element_t a, mpz_t n) {
+#if STEALTH_SECRET_CT
+    prim_pow_mpz_ct(x, a, n);
+#else
+    prim_pow_mpz(x, a, n);
+#endif
+}
+
+void stealth_secret_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m) {
+#if STEALTH_SECRET_CT
+    for (int i = 0; i < m; i++) prim_pow_mpz_ct(x[i], a[i], n);
+#else
+    prim_pow_mpz_same(x, a, n, m);
+#endif
+}
+
+static void g_secret_pow_zn(element_t out, element_t z) {
+#if STEALTH_SECRET_CT
+    prim_pow_zn_ct(out, g, z);
+#else
+    g_pow_zn(out, z);
+#endif
+}
+
+//----------------------------------------------
+// The same for g2
+//----------------------------------------------
+static void g2_pow_zn(element_t out, element_t z) {
+#if STEALTH_G_PP_WINDOW > 0
+    prim_pp_pow_zn(out, z, asymmetric ? node_pp(active->g2_pp_copy, g2_pp, g2)
+                                      : node_pp(active->g_pp_copy, g_pp, g));
+#else
+    prim_pow_zn(out, g2, z);
+#endif
+}
+
+static void g2_secret_pow_zn(element_t out, element_t z) {
+#if STEALTH_SECRET_CT
+    prim_pow_zn_ct(out, g2, z);
+#else
+    g2_pow_zn(out, z);
+#endif
+}
+
+//----------------------------------------------
+// e(g, g2)^z, equal to e(g, g2^z), for secret z
+//----------------------------------------------
+static void egg_secret_pow_zn(element_t out, element_t z) {
+#if STEALTH_SECRET_CT
+    prim_pow_zn_ct(out, egg, z);
+#elif STEALTH_G_PP_WINDOW > 0
+    prim_pp_pow_zn(out, z, node_pp(active->egg_pp_copy, egg_pp, egg));
+#else
+    prim_pow_zn(out, egg, z);
+#endif
 }
 
 //----------------------------------------------
-// hash_to_mpz: do sha256 -> mpz mod r
+// g2 = SHA256(g) mapped onto G2, so g alone fixes both generators
 //----------------------------------------------
-void hash_to_mpz(mpz_t out, const unsigned char *data, size_t len, mpz_t mod) {
+static void derive_g2(element_t out, element_t in) {
+    hash_stream_t h;
     unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(data, len, hash);
-    mpz_import(out, SHA256_DIGEST_LENGTH, 1, 1, 0, 0, hash);
-    mpz_mod(out, out, mod);
+    hash_stream_begin(&h);
+    hash_stream_element(&h, in);
+    hash_stream_end(&h, hash);
+    element_from_hash(out, hash, SHA256_DIGEST_LENGTH);
 }
 
 //----------------------------------------------
-// Hash functions H1, H2, H3, H4
+// Precomputed ephemerals, see stealth_set_eph_pool
 //----------------------------------------------
-void H1(element_t outZr, element_t inG1) {
-    unsigned char buf[1024];
-    size_t len = element_length_in_bytes(inG1);
-    element_to_bytes(buf, inG1);
+static void fill_addr_ephemeral(element_ptr e[], void* ctx) {
+    (void)ctx;
+    element_random(e[0]);
+    g_pow_zn(e[1], e[0]);
+}
+
+static void fill_sign_nonce(element_ptr e[], void* ctx) {
+    (void)ctx;
+    element_random(e[0]);
+    g2_secret_pow_zn(e[1], e[0]);
+    egg_secret_pow_zn(e[2], e[0]);
+}
 
-    mpz_t tmpz; mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len, pairing->r);
+/**
+ * Start the pools on the active pairing, the fillers read its generators
+ */
+static int eph_pools_start(void) {
+    field_ptr addr_fields[] = { pairing->Zr, pairing->G1 };
+    field_ptr sign_fields[] = { pairing->Zr, pairing->G2, pairing->GT };
+    int rc = eph_pool_init(&addr_pool, addr_fields, 2, eph_pool_size, fill_addr_ephemeral, NULL);
+    rc |= eph_pool_init(&sign_pool, sign_fields, 3, eph_pool_size, fill_sign_nonce, NULL);
+    eph_pools_live = 1;
+    return rc ? -1 : 0;
+}
 
-    element_set_mpz(outZr, tmpz);
-    mpz_clear(tmpz);
+/**
+ * Stop the fillers and wipe what is left, before the pairing or its
+ * generators change
+ */
+static void eph_pools_stop(void) {
+    if (!eph_pools_live) return;
+    eph_pool_clear(&addr_pool);
+    eph_pool_clear(&sign_pool);
+    eph_pools_live = 0;
 }
 
-void H2(element_t outG1, element_t inAny) {
-    unsigned char buf[1024];
-    size_t len = element_length_in_bytes(inAny);
-    element_to_bytes(buf, inAny);
+//----------------------------------------------
+// One-time secret keys, see stealth_set_dsk_cache
+//----------------------------------------------
+static int dsk_cache_start(void) {
+    int rc = dsk_cache_init(&dsk_cache, pairing->G2, SHA256_DIGEST_LENGTH, dsk_cache_size,
+                            dsk_cache_ttl_ms, STEALTH_RECIPIENT_PP_TEETH);
+    dsk_cache_live = 1;
+    return rc;
+}
+
+/**
+ * Wipe the keys, before the pairing or its generators change
+ */
+static void dsk_cache_stop(void) {
+    if (!dsk_cache_live) return;
+    dsk_cache_clear(&dsk_cache);
+    dsk_cache_live = 0;
+}
+
+//----------------------------------------------
+// Mapped H3 values, see stealth_set_h3_cache
+//----------------------------------------------
+static int h3_cache_start(void) {
+    int rc = hash_cache_init(&h3_cache, pairing->G2, pairing_length_in_bytes_G1(pairing),
+                             h3_cache_size);
+    h3_cache_live = 1;
+    return rc;
+}
 
-    mpz_t tmpz; mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len, pairing->r);
+static void h3_cache_stop(void) {
+    if (!h3_cache_live) return;
+    hash_cache_clear(&h3_cache);
+    h3_cache_live = 0;
+}
 
-    element_t z; element_init_Zr(z, pairing);
-    element_set_mpz(z, tmpz);
+/**
+ * r and R1 = g^r, from the pool when it has an entry. A seeded thread
+ * computes them itself so that its runs stay reproducible.
+ */
+static void addr_ephemeral(element_t rZ, element_t R1) {
+    element_ptr e[] = { rZ, R1 };
+    if (seeded_random_active() || !eph_pool_pop(&addr_pool, e)) fill_addr_ephemeral(e, NULL);
+}
 
-    element_pow_zn(outG1, g, z);
+//----------------------------------------------
+// Hash functions H1, H2, H3, H4, temporaries from the caller's workspace
+// Elements are streamed into the digest, no concatenation buffers
+//----------------------------------------------
+void H1(scratch_t* ws, element_t outZr, element_t inG1) {
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, inG1);
 
-    mpz_clear(tmpz);
-    element_clear(z);
+    hash_stream_end_zr(&h, outZr);
 }
 
-void H3(element_t outG1, element_t inG1) {
-    unsigned char buf[1024];
-    size_t len = element_length_in_bytes(inG1);
-    element_to_bytes(buf, inG1);
+//----------------------------------------------
+// Map SHA256(tag || in) onto G1 (STEALTH_HASH_G1_MAP)
+// The tag keeps H2 and H3 apart
+//----------------------------------------------
+static void hash_to_G1_map(element_t outG1, unsigned char tag, element_t in) {
+    prim_mark_t m;
+    prim_begin(&m);
+    hash_stream_t h;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    hash_stream_begin(&h);
+    hash_stream_bytes(&h, &tag, 1);
+    hash_stream_element(&h, in);
+    hash_stream_end(&h, hash);
+    element_from_hash(outG1, hash, SHA256_DIGEST_LENGTH);
+    prim_end(PRIM_HASH_G1, &m);
+}
 
-    mpz_t tmpz; mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len, pairing->r);
+void H2(scratch_t* ws, element_t outG1, element_t inAny) {
+    hash_stream_t h;
 
-    element_t z; element_init_Zr(z, pairing);
-    element_set_mpz(z, tmpz);
+    if (hash_version == STEALTH_HASH_G1_MAP) {
+        hash_to_G1_map(outG1, 2, inAny);
+        return;
+    }
+    hash_stream_begin(&h);
+    hash_stream_element(&h, inAny);
 
-    element_pow_zn(outG1, g, z);
+    hash_stream_end_zr(&h, ws->hash_zr);
 
-    mpz_clear(tmpz);
-    element_clear(z);
+    g_pow_zn(outG1, ws->hash_zr);
 }
 
-void H4(element_t outZr, element_t addr, const char* msg, element_t X) {
-    unsigned char buf[2048];
-    unsigned char g1buf[512];
-    unsigned char g2buf[512];
+// The map behind H3, through the H3 cache: Addr is public and the same
+// address is hashed for every key derived and signature verified on it
+static void h3_mapped(element_t outG2, element_t Addr) {
+    unsigned char key[HASH_CACHE_MAX_KEY];
+    int cached = h3_cache_live && h3_cache.capacity > 0 &&
+                 element_length_in_bytes(Addr) == h3_cache.key_len;
+    if (cached) {
+        element_to_bytes(key, Addr);
+        if (hash_cache_get(&h3_cache, outG2, key)) return;
+    }
+    hash_to_G1_map(outG2, 3, Addr);
+    if (cached) hash_cache_put(&h3_cache, key, outG2);
+}
 
-    size_t len1 = element_length_in_bytes(addr);
-    size_t len2 = element_length_in_bytes(X);
-    size_t msglen = strlen(msg);
+// H3 lands in G2, which is G1 under a symmetric pairing
+void H3(scratch_t* ws, element_t outG2, element_t inG1) {
+    hash_stream_t h;
 
-    element_to_bytes(g1buf, addr);
-    element_to_bytes(g2buf, X);
+    if (hash_version == STEALTH_HASH_G1_MAP) {
+        h3_mapped(outG2, inG1);
+        return;
+    }
+    hash_stream_begin(&h);
+    hash_stream_element(&h, inG1);
 
-    memcpy(buf, g1buf, len1);
-    memcpy(buf + len1, msg, msglen);
-    memcpy(buf + len1 + msglen, g2buf, len2);
+    hash_stream_end_zr(&h, ws->hash_zr);
 
-    mpz_t tmpz;
-    mpz_init(tmpz);
-    hash_to_mpz(tmpz, buf, len1 + msglen + len2, pairing->r);
+    g2_pow_zn(outG2, ws->hash_zr);
+}
 
-    element_set_mpz(outZr, tmpz);
+// H4(addr || msg || X)
+void H4(scratch_t* ws, element_t outZr, element_t addr, const char* msg, element_t X) {
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, addr);
+    hash_stream_bytes(&h, msg, strlen(msg));
+    hash_stream_element(&h, X);
 
-    mpz_clear(tmpz);
+    hash_stream_end_zr(&h, outZr);
 }
 
 //----------------------------------------------
 // Library Management Functions
 //----------------------------------------------
 
+static uint64_t fnv1a(const char* data, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void slot_clear(pairing_slot_t* s) {
+    if (!s->path) return;
+    node_pp_clear(s->g_pp_copy);
+    node_pp_clear(s->g2_pp_copy);
+    node_pp_clear(s->egg_pp_copy);
+#if STEALTH_G_PP_WINDOW > 0
+    element_pp_clear(s->g_pp);
+#endif
+    scratch_pool_clear(&s->scratch);
+    pp_cache_clear(&s->pp_cache);
+    pp_cache_clear(&s->verify_pp_cache);
+    pairing_pp_clear(s->g_pairing_pp);
+#if STEALTH_G_PP_WINDOW > 0
+    element_pp_clear(s->egg_pp);
+#endif
+    element_clear(s->egg);
+    if (!pairing_is_symmetric(s->pairing)) {
+#if STEALTH_G_PP_WINDOW > 0
+        element_pp_clear(s->g2_pp);
+#endif
+        element_clear(s->g2);
+    }
+    element_clear(s->g);
+    pairing_clear(s->pairing);
+    free(s->path);
+    s->path = NULL;
+}
+
 /**
  * Initialize the library with a parameter file
  */
 int stealth_init(const char* param_file) {
-    if (library_initialized) {
-        // Clean up previous initialization
-        element_clear(g);
-        pairing_clear(pairing);
+    library_initialized = 0;
+    eph_pools_stop();
+    dsk_cache_stop();
+    h3_cache_stop();
+    if (allocator == STEALTH_ALLOC_POOL) pbc_pool_enable();
+
+    // Mapped whole (text, or binary from PBC's parambin) and hashed once
+    const param_file_t* file = param_file_get(param_file);
+    if (!file) return -1;
+    uint64_t hash = file->hash;
+
+    // Reuse the cached pairing, otherwise take a free or the oldest slot
+    pairing_slot_t* s = NULL;
+    pairing_slot_t* victim = &pairing_cache[0];
+    for (int i = 0; i < STEALTH_PAIRING_CACHE_SIZE; i++) {
+        pairing_slot_t* e = &pairing_cache[i];
+        if (e->path && e->hash == hash && strcmp(e->path, param_file) == 0 &&
+            (e->tune.fp[0] != '\0') == pairing_tune_enabled()) {
+            s = e;
+            break;
+        }
+        if (victim->path && (!e->path || e->last_used < victim->last_used)) victim = e;
     }
-    
-    // Check if file exists
-    FILE *fp = fopen(param_file, "r");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot open parameter file %s\n", param_file);
+
+    if (!s) {
+        s = victim;
+        slot_clear(s);
+        if (pairing_init_tuned(s->pairing, file->data, file->len, &s->tune)) {
+            fprintf(stderr, "Error: Invalid parameter file %s\n", param_file);
+            return -1;
+        }
+        snprintf(s->tuning, sizeof(s->tuning), "%s %s", s->tune.fp, s->tune.method);
+        element_init_G1(s->g, s->pairing);
+        element_random(s->g);
+#if STEALTH_G_PP_WINDOW > 0
+        element_pp_init_k(s->g_pp, s->g, STEALTH_G_PP_WINDOW);
+#endif
+        pairing_pp_init(s->g_pairing_pp, s->g, s->pairing);
+        if (!pairing_is_symmetric(s->pairing)) {
+            element_init_G2(s->g2, s->pairing);
+            derive_g2(s->g2, s->g);
+#if STEALTH_G_PP_WINDOW > 0
+            element_pp_init_k(s->g2_pp, s->g2, STEALTH_G_PP_WINDOW);
+#endif
+        }
+        element_init_GT(s->egg, s->pairing);
+        pairing_pp_apply(s->egg, pairing_is_symmetric(s->pairing) ? s->g : s->g2,
+                         s->g_pairing_pp);
+#if STEALTH_G_PP_WINDOW > 0
+        element_pp_init_k(s->egg_pp, s->egg, STEALTH_G_PP_WINDOW);
+#endif
+        s->pp_node = cpu_topo_current_node();
+        scratch_pool_init(&s->scratch, s->pairing);
+        pp_cache_init(&s->pp_cache, s->pairing, pp_cache_size);
+        pp_cache_init(&s->verify_pp_cache, s->pairing, verify_pp_cache_size);
+        s->path = strdup(param_file);
+        s->hash = hash;
+    }
+    s->last_used = ++pairing_clock;
+
+    pairing = s->pairing;
+    tuning = s->tune.fp[0] ? s->tuning : NULL;
+    g = s->g;
+    g_pp = s->g_pp;
+    g_pairing_pp = s->g_pairing_pp;
+    egg = s->egg;
+    egg_pp = s->egg_pp;
+    active = s;
+    scratch = &s->scratch;
+    pp_cache = &s->pp_cache;
+    if (pp_cache->capacity != pp_cache_size) pp_cache_set_capacity(pp_cache, pp_cache_size);
+    pp_cache_reset_stats(pp_cache);
+    verify_pp_cache = &s->verify_pp_cache;
+    if (verify_pp_cache->capacity != verify_pp_cache_size)
+        pp_cache_set_capacity(verify_pp_cache, verify_pp_cache_size);
+    pp_cache_reset_stats(verify_pp_cache);
+    asymmetric = !pairing_is_symmetric(pairing);
+    g2 = asymmetric ? s->g2 : s->g;
+    g2_pp = asymmetric ? s->g2_pp : s->g_pp;
+
+    if (hash_version == STEALTH_HASH_G1_MAP &&
+        (!pairing->G1->from_hash || (asymmetric && !pairing->G2->from_hash))) {
+        fprintf(stderr, "Error: %s has no hash-to-G1 map, use hash version %d\n",
+                param_file, STEALTH_HASH_G1_POW);
         return -1;
     }
-    fclose(fp);
-    
-    // Use the original pbc_demo_pairing_init (void function)
-    char *fake_argv[2];
-    fake_argv[0] = "stealth_lib";
-    fake_argv[1] = (char*)param_file;
-    
-    pbc_demo_pairing_init(pairing, 2, fake_argv);
-
-    element_init_G1(g, pairing);
-    element_random(g);
     
     // Reset performance counters
-    sumAddrGen = sumAddrRecognize = sumFastAddrRecognize = sumOnetimeSK = 0;
-    sumSign = sumVerify = sumTrace = 0;
+    perf_reset(&perf_stats);
     perf_counter = 0;
+
+    eph_pools_start();
+    dsk_cache_start();
+    h3_cache_start();
     
     library_initialized = 1;
     return 0; // Success
@@ -166,20 +557,32 @@ int stealth_is_initialized(void) {
  * Cleanup library resources
  */
 void stealth_cleanup(void) {
-    if (library_initialized) {
-        element_clear(g);
-        pairing_clear(pairing);
-        library_initialized = 0;
+    eph_pools_stop();
+    dsk_cache_stop();
+    h3_cache_stop();
+    for (int i = 0; i < STEALTH_PAIRING_CACHE_SIZE; i++) {
+        slot_clear(&pairing_cache[i]);
     }
+    param_file_drop();
+    library_initialized = 0;
 }
 
 /**
  * Reset performance counters
  */
 void stealth_reset_performance(void) {
-    sumAddrGen = sumAddrRecognize = sumFastAddrRecognize = sumOnetimeSK = 0;
-    sumSign = sumVerify = sumTrace = 0;
+    perf_reset(&perf_stats);
     perf_counter = 0;
+    if (library_initialized) {
+        pp_cache_reset_stats(pp_cache);
+        pp_cache_reset_stats(verify_pp_cache);
+    }
+    if (eph_pools_live) {
+        eph_pool_reset_stats(&addr_pool);
+        eph_pool_reset_stats(&sign_pool);
+    }
+    if (dsk_cache_live) dsk_cache_reset_stats(&dsk_cache);
+    if (h3_cache_live) hash_cache_reset_stats(&h3_cache);
 }
 
 /**
@@ -187,7 +590,48 @@ void stealth_reset_performance(void) {
  */
 pairing_t* stealth_get_pairing(void) {
     if (!library_initialized) return NULL;
-    return &pairing;
+    return (pairing_t*)pairing;
+}
+
+/**
+ * Copy the generator g
+ */
+void stealth_get_generator(element_t out) {
+    if (library_initialized) element_set(out, g);
+}
+
+/**
+ * Replace the generator g and its precomputed tables
+ */
+int stealth_set_generator(element_t new_g) {
+    if (!library_initialized) return -1;
+    eph_pools_stop();
+    if (dsk_cache_live) dsk_cache_flush(&dsk_cache);
+    element_set(g, new_g);
+    node_pp_clear(active->g_pp_copy);
+    node_pp_clear(active->g2_pp_copy);
+    node_pp_clear(active->egg_pp_copy);
+    active->pp_node = cpu_topo_current_node();
+#if STEALTH_G_PP_WINDOW > 0
+    element_pp_clear(g_pp);
+    element_pp_init_k(g_pp, g, STEALTH_G_PP_WINDOW);
+#endif
+    pairing_pp_clear(g_pairing_pp);
+    pairing_pp_init(g_pairing_pp, g, pairing);
+    if (asymmetric) {
+        derive_g2(g2, g);
+#if STEALTH_G_PP_WINDOW > 0
+        element_pp_clear(g2_pp);
+        element_pp_init_k(g2_pp, g2, STEALTH_G_PP_WINDOW);
+#endif
+    }
+    pairing_pp_apply(egg, g2, g_pairing_pp);
+#if STEALTH_G_PP_WINDOW > 0
+    element_pp_clear(egg_pp);
+    element_pp_init_k(egg_pp, egg, STEALTH_G_PP_WINDOW);
+#endif
+    eph_pools_start();
+    return 0;
 }
 
 //----------------------------------------------
@@ -202,8 +646,8 @@ void stealth_keygen(element_t A, element_t B, element_t aZ, element_t bZ) {
     
     element_random(aZ);
     element_random(bZ);
-    element_pow_zn(A, g, aZ);
-    element_pow_zn(B, g, bZ);
+    g_secret_pow_zn(A, aZ);
+    g_secret_pow_zn(B, bZ);
 }
 
 /**
@@ -213,342 +657,1964 @@ void stealth_tracekeygen(element_t TK, element_t kZ) {
     if (!library_initialized) return;
     
     element_random(kZ);
-    element_pow_zn(TK, g, kZ);
+    g2_secret_pow_zn(TK, kZ);
+}
+
+//----------------------------------------------
+// View tag: SHA256("view" || shared point), truncated
+//----------------------------------------------
+void stealth_view_tag_from_bytes(unsigned char* view_tag, const unsigned char* shared_bytes,
+                                 size_t len) {
+    hash_stream_t h;
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    hash_stream_begin(&h);
+    hash_stream_bytes(&h, "view", 4);
+    hash_stream_bytes(&h, shared_bytes, len);
+    hash_stream_end(&h, hash);
+    memcpy(view_tag, hash, STEALTH_VIEW_TAG_LEN);
+}
+
+static void compute_view_tag(unsigned char* tag, element_t shared) {
+    unsigned char buf[1024];
+    size_t len = prim_to_bytes(buf, shared);
+    stealth_view_tag_from_bytes(tag, buf, len);
 }
 
 /**
- * Generate one-time address
+ * Address generation body, the view tag is written when requested
  */
-void stealth_addr_gen(element_t Addr, element_t R1, element_t R2, element_t C,
-                     element_t A_r, element_t B_r, element_t TK) {
-    if (!library_initialized) return;
+static void addr_gen_impl(element_t Addr, element_t R1, element_t R2, element_t C,
+                          unsigned char* tag, element_t A_r, element_t B_r, element_t TK) {
     
-    clock_t t1 = clock();
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return;
 
-    element_t rZ, r2Z; 
-    element_init_Zr(rZ, pairing);
-    element_init_Zr(r2Z, pairing);
+    double t1 = perf_now_ms();
 
-    element_t R3; element_init_G1(R3, pairing);
+    element_ptr rZ = ws->zr[0], r2Z = ws->zr[1];
+    element_ptr R3 = ws->g1[0], Ar_pow_r = ws->g1[1];
 
-    element_random(rZ);
-    element_pow_zn(R1, g, rZ);
+    addr_ephemeral(rZ, R1);
 
-    element_t Ar_pow_r; element_init_G1(Ar_pow_r, pairing);
-    element_pow_zn(Ar_pow_r, A_r, rZ);
+    prim_pow_zn(Ar_pow_r, A_r, rZ);
 
-    clock_t hash_start = clock();
-    H1(r2Z, Ar_pow_r);
-    clock_t hash_end = clock();
+    double hash_start = perf_now_ms();
+    H1(ws, r2Z, Ar_pow_r);
+    if (tag) compute_view_tag(tag, Ar_pow_r);
+    double hash_end = perf_now_ms();
 
-    element_pow_zn(R2, g, r2Z);
-    element_pow_zn(C, B_r, r2Z);
+    g2_pow_zn(R2, r2Z);
+    prim_pow_zn(C, B_r, r2Z);
 
-    // e(R2, TK)
-    element_t pairing_res, pairing_res_powr;
-    element_init_GT(pairing_res, pairing);
-    element_init_GT(pairing_res_powr, pairing);
+    // e(R2, TK)^r, or e(R1, TK)^r2 when R2 and TK both lie in G2
+    element_ptr pairing_res = ws->gt[0], pairing_res_powr = ws->gt[1];
 
-    pairing_apply(pairing_res, R2, TK, pairing);
-    element_pow_zn(pairing_res_powr, pairing_res, rZ);
+    if (asymmetric) {
+        prim_pairing_apply(pairing_res, R1, TK, pairing);
+        prim_pow_zn(pairing_res_powr, pairing_res, r2Z);
+    } else {
+        prim_pairing_apply(pairing_res, R2, TK, pairing);
+        prim_pow_zn(pairing_res_powr, pairing_res, rZ);
+    }
     
-    clock_t t2 = clock();
-    sumAddrGen += timer_diff(t1, t2) - timer_diff(hash_start, hash_end);
+    double t2 = perf_now_ms();
+    double op_ms = timer_diff(t1, t2) - timer_diff(hash_start, hash_end);
 
-    clock_t hash_start2 = clock();
-    H2(R3, pairing_res_powr);
-    clock_t hash_end2 = clock();
+    H2(ws, R3, pairing_res_powr);
     
-    clock_t t3 = clock();
+    double t3 = perf_now_ms();
    
     // Addr = R3 * B_r * C
     element_mul(Addr, R3, B_r);
     element_mul(Addr, Addr, C);
 
-    element_clear(rZ);
-    element_clear(r2Z);
-    element_clear(R3);
-    element_clear(Ar_pow_r);
-    element_clear(pairing_res);
-    element_clear(pairing_res_powr);
+    double t4 = perf_now_ms();
+    perf_add(&perf_stats, PERF_ADDR_GEN, op_ms + timer_diff(t3, t4));
 
-    clock_t t4 = clock();
-    sumAddrGen += timer_diff(t3, t4) - timer_diff(hash_start2, hash_end2);
+    scratch_put(scratch, ws);
 }
 
 /**
- * Recognize address (full version)
+ * Generate one-time address
  */
-int stealth_addr_recognize(element_t Addr, element_t R1, element_t B_r,
-                          element_t A_r, element_t C, element_t aZ, element_t TK) {
-    if (!library_initialized) return 0;
-    
-    clock_t t1 = clock();
+void stealth_addr_gen(element_t Addr, element_t R1, element_t R2, element_t C,
+                     element_t A_r, element_t B_r, element_t TK) {
+    if (!library_initialized) return;
+    addr_gen_impl(Addr, R1, R2, C, NULL, A_r, B_r, TK);
+}
 
-    element_t R1_pow_a, C_prime, R3_prime, Addr_prime;
-    element_init_G1(R1_pow_a, pairing);
-    element_init_G1(C_prime, pairing);
-    element_init_G1(R3_prime, pairing);
-    element_init_G1(Addr_prime, pairing);
+/**
+ * Generate one-time address together with its view tag
+ */
+void stealth_addr_gen_tagged(element_t Addr, element_t R1, element_t R2, element_t C,
+                             unsigned char* view_tag, element_t A_r, element_t B_r,
+                             element_t TK) {
+    if (!library_initialized || !view_tag) return;
+    addr_gen_impl(Addr, R1, R2, C, view_tag, A_r, B_r, TK);
+}
 
-    element_pow_zn(R1_pow_a, R1, aZ);
+// Common head of the per-thread jobs of the *_block functions
+typedef struct {
+    pthread_t tid;
+    int begin, end;
+} block_range_t;
 
-    element_t r2Z_prime;
-    element_init_Zr(r2Z_prime, pairing);
-    
-    clock_t hash_start = clock();
-    H1(r2Z_prime, R1_pow_a);
-    clock_t hash_end = clock();
+/**
+ * Threads to split n items over, num_threads <= 0 for one per online CPU
+ */
+static int block_threads(int num_threads, int n) {
+    if (num_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    return num_threads < n ? num_threads : (n > 0 ? n : 1);
+}
 
-    element_pow_zn(C_prime, B_r, r2Z_prime);
+/**
+ * Split [0, n) into num_threads ranges and run worker on each job. The
+ * jobs are job_size bytes apart and start with a block_range_t. Job 0 runs
+ * on the calling thread, which also takes over the jobs of a failed spawn;
+ * returns once every job is done.
+ */
+static void run_block(void* jobs, size_t job_size, int num_threads, int n,
+                      void* (*worker)(void*)) {
+#define BLOCK_JOB(i) ((block_range_t*)((char*)jobs + (size_t)(i) * job_size))
+    int per = (n + num_threads - 1) / num_threads;
+    for (int i = 0; i < num_threads; i++) {
+        BLOCK_JOB(i)->begin = i * per < n ? i * per : n;
+        BLOCK_JOB(i)->end = (i + 1) * per < n ? (i + 1) * per : n;
+    }
 
-    element_t pairing_res, pairing_res_r2Z;
-    element_init_GT(pairing_res, pairing);
-    element_init_GT(pairing_res_r2Z, pairing);
+    int started = 1;
+    while (started < num_threads &&
+           cpu_topo_create(&BLOCK_JOB(started)->tid, started, num_threads, worker,
+                           BLOCK_JOB(started)) == 0)
+        started++;
+    worker(BLOCK_JOB(0));
+    for (int i = started; i < num_threads; i++) worker(BLOCK_JOB(i));
+    for (int i = 1; i < started; i++) pthread_join(BLOCK_JOB(i)->tid, NULL);
+#undef BLOCK_JOB
+}
 
-    pairing_apply(pairing_res, R1, TK, pairing);
-    element_pow_zn(pairing_res_r2Z, pairing_res, r2Z_prime);
+// Arrays of n initialized values for the batch operations; free accepts NULL
+static mpz_t* mpz_batch_alloc(int n) {
+    mpz_t* v = malloc((size_t)n * sizeof(mpz_t));
+    if (!v) return NULL;
+    for (int i = 0; i < n; i++) mpz_init(v[i]);
+    return v;
+}
 
-    clock_t hash_start2 = clock();
-    H2(R3_prime, pairing_res_r2Z);
-    clock_t hash_end2 = clock();
-    
-    element_mul(Addr_prime, R3_prime, B_r);
-    element_mul(Addr_prime, Addr_prime, C_prime);
+static void mpz_batch_free(mpz_t* v, int n) {
+    if (!v) return;
+    for (int i = 0; i < n; i++) mpz_clear(v[i]);
+    free(v);
+}
 
-    int eq = (element_cmp(Addr_prime, Addr) == 0);
+static element_t* element_batch_alloc(int n, field_ptr f) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    if (!v) return NULL;
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    return v;
+}
 
-    element_clear(R1_pow_a);
-    element_clear(C_prime);
-    element_clear(R3_prime);
-    element_clear(Addr_prime);
-    element_clear(r2Z_prime);
-    element_clear(pairing_res);
-    element_clear(pairing_res_r2Z);
+static void element_batch_free(element_t* v, int n) {
+    if (!v) return;
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
 
-    clock_t t2 = clock();
-    sumAddrRecognize += timer_diff(t1, t2) - timer_diff(hash_start, hash_end) - timer_diff(hash_start2, hash_end2);
+typedef struct {
+    block_range_t range;
+    element_t* Addr;
+    element_t* R1;
+    element_t* R2;
+    element_t* C;
+    unsigned char* view_tags;
+    element_t* A_r;
+    element_t* B_r;
+    element_ptr TK;
+    int own_random;
+    seeded_random_job_t random;
+} addr_gen_block_job_t;
+
+static void* addr_gen_block_worker(void* arg) {
+    addr_gen_block_job_t* job = (addr_gen_block_job_t*)arg;
+
+    seeded_random_bind_t rnd;
+    int bound = job->own_random && seeded_random_bind(&rnd, &job->random) == 0;
+
+    for (int i = job->range.begin; i < job->range.end; i++) {
+        unsigned char* tag = job->view_tags ? job->view_tags + (size_t)i * STEALTH_VIEW_TAG_LEN : NULL;
+        addr_gen_impl(job->Addr[i], job->R1[i], job->R2[i], job->C[i], tag,
+                      job->A_r[i], job->B_r[i], job->TK);
+    }
 
-    return eq;
+    if (bound) seeded_random_unbind(&rnd);
+    return NULL;
 }
 
 /**
- * Fast address recognition
+ * Generate a block of addresses across worker threads
  */
-int stealth_addr_recognize_fast(element_t R1, element_t B_r, element_t A_r, 
-                               element_t C, element_t aZ) {
-    if (!library_initialized) return 0;
-    
-    clock_t t1 = clock();
-
-    // 1) r2' = H1( (R1)^aZ )
-    element_t R1_pow_a;
-    element_init_G1(R1_pow_a, pairing);
-    element_pow_zn(R1_pow_a, R1, aZ);
+int stealth_addr_gen_block(element_t Addr[], element_t R1[], element_t R2[], element_t C[],
+                           unsigned char* view_tags, element_t A_r[], element_t B_r[],
+                           element_t TK, int n, int num_threads) {
+    if (!library_initialized || n < 0) return -1;
+    if (n == 0) return 0;
+
+    num_threads = block_threads(num_threads, n);
+    addr_gen_block_job_t* jobs = calloc(num_threads, sizeof(addr_gen_block_job_t));
+    if (!jobs) return -1;
+
+    for (int i = 0; i < num_threads; i++) {
+        addr_gen_block_job_t* job = &jobs[i];
+        job->Addr = Addr;
+        job->R1 = R1;
+        job->R2 = R2;
+        job->C = C;
+        job->view_tags = view_tags;
+        job->A_r = A_r;
+        job->B_r = B_r;
+        job->TK = TK;
+        job->own_random = num_threads > 1;
+        if (job->own_random) seeded_random_job(&job->random);
+    }
+    run_block(jobs, sizeof(addr_gen_block_job_t), num_threads, n, addr_gen_block_worker);
+    free(jobs);
 
-    element_t r2Z_prime;
-    element_init_Zr(r2Z_prime, pairing);
-    
-    clock_t hash_start = clock();
-    H1(r2Z_prime, R1_pow_a);
-    clock_t hash_end = clock();
+    return n;
+}
 
-    // 2) C' = B_r^(r2')
-    element_t C_prime;
-    element_init_G1(C_prime, pairing);
-    element_pow_zn(C_prime, B_r, r2Z_prime);
+typedef struct {
+    uint64_t hash;
+    int index;
+} key_hash_t;
 
-    // 3) Compare with C
-    int eq = (element_cmp(C_prime, C) == 0);
+static int key_hash_cmp(const void* x, const void* y) {
+    uint64_t a = ((const key_hash_t*)x)->hash, b = ((const key_hash_t*)y)->hash;
+    return a < b ? -1 : a > b;
+}
 
-    // clear
-    element_clear(R1_pow_a);
-    element_clear(r2Z_prime);
-    element_clear(C_prime);
+/**
+ * 1 if two of the n keys are equal, -1 if out of memory
+ */
+static int has_duplicate(element_t key[], int n) {
+    key_hash_t* h = malloc((size_t)n * sizeof(key_hash_t));
+    unsigned char* buf = malloc(element_length_in_bytes(key[0]));
+    int dup = h && buf ? 0 : -1;
+    for (int i = 0; dup == 0 && i < n; i++) {
+        int len = element_to_bytes(buf, key[i]);
+        h[i].hash = fnv1a((const char*)buf, len);
+        h[i].index = i;
+    }
+    if (dup == 0) qsort(h, n, sizeof(key_hash_t), key_hash_cmp);
+    for (int i = 1; dup == 0 && i < n; i++) {
+        for (int j = i - 1; j >= 0 && h[j].hash == h[i].hash; j--) {
+            if (element_cmp(key[h[i].index], key[h[j].index]) == 0) dup = 1;
+        }
+    }
+    free(buf);
+    free(h);
+    return dup;
+}
 
-    clock_t t2 = clock();    
-    sumFastAddrRecognize += timer_diff(t1, t2) - timer_diff(hash_start, hash_end);
+typedef struct {
+    block_range_t range;
+    element_t* Addr;
+    element_t* R2;
+    element_t* C;
+    unsigned char* view_tags;
+    element_t* A_r;
+    element_t* B_r;
+    mpz_ptr r;                   // the shared ephemeral
+    element_ptr shared;          // e(R1, TK)
+    element_pp_ptr shared_pp;    // its table, NULL if none was built
+    double shared_ms;            // per-output share of the setup
+    int failed;
+} addr_gen_multi_job_t;
+
+static void* addr_gen_multi_worker(void* arg) {
+    addr_gen_multi_job_t* job = (addr_gen_multi_job_t*)arg;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) {
+        job->failed = 1;
+        return NULL;
+    }
+    element_ptr r2Z = ws->zr[0], R3 = ws->g1[0], powr = ws->gt[0];
+
+    for (int base = job->range.begin; base < job->range.end; base += STEALTH_SCAN_CHUNK) {
+        int m = job->range.end - base < STEALTH_SCAN_CHUNK ? job->range.end - base : STEALTH_SCAN_CHUNK;
+
+        // A_r^r for the chunk, one exponent for all, in Addr until the address replaces it
+        double t0 = perf_now_ms();
+        stealth_secret_pow_mpz_same(job->Addr + base, job->A_r + base, job->r, m);
+        double pow_ms = timer_diff(t0, perf_now_ms()) / m;
+
+        for (int i = base; i < base + m; i++) {
+            double t1 = perf_now_ms();
+            H1(ws, r2Z, job->Addr[i]);
+            if (job->view_tags) compute_view_tag(job->view_tags + (size_t)i * STEALTH_VIEW_TAG_LEN, job->Addr[i]);
+            double hash_ms = timer_diff(t1, perf_now_ms());
+
+            g2_pow_zn(job->R2[i], r2Z);
+            prim_pow_zn(job->C[i], job->B_r[i], r2Z);
+
+            // e(R1, TK)^r2, equal to the e(R2, TK)^r of a symmetric pairing
+#if STEALTH_G_PP_WINDOW > 0
+            if (job->shared_pp) prim_pp_pow_zn(powr, r2Z, job->shared_pp);
+            else
+#endif
+                prim_pow_zn(powr, job->shared, r2Z);
+
+            double t2 = perf_now_ms();
+            H2(ws, R3, powr);
+            double t3 = perf_now_ms();
+
+            element_mul(job->Addr[i], R3, job->B_r[i]);
+            element_mul(job->Addr[i], job->Addr[i], job->C[i]);
+
+            double t4 = perf_now_ms();
+            perf_add(&perf_stats, PERF_ADDR_GEN,
+                     job->shared_ms + pow_ms + timer_diff(t1, t2) - hash_ms + timer_diff(t3, t4));
+        }
+    }
 
-    return eq;
+    scratch_put(scratch, ws);
+    return NULL;
 }
 
 /**
- * Generate one-time secret key
+ * Generate the outputs of one transaction on a shared ephemeral
  */
-void stealth_onetime_skgen(element_t dsk, element_t Addr, element_t R1,
-                          element_t aZ, element_t bZ) {
-    if (!library_initialized) return;
-    
-    clock_t t1 = clock();
+int stealth_addr_gen_multi(element_t Addr[], element_t R1, element_t R2[], element_t C[],
+                           unsigned char* view_tags, element_t A_r[], element_t B_r[],
+                           element_t TK, int n, int num_threads) {
+    if (!library_initialized || n < 0) return -1;
+    if (n == 0) return 0;
+    if (has_duplicate(A_r, n) != 0) return -1;
+
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return -1;
+
+    double t1 = perf_now_ms();
+
+    // r and R1 = g^r once, then the one pairing of the transaction
+    element_ptr rZ = ws->zr[0], shared = ws->gt[0];
+    mpz_ptr r = ws->z[0];
+    addr_ephemeral(rZ, R1);
+    element_to_mpz(r, rZ);
+    prim_pairing_apply(shared, R1, TK, pairing);
+
+    element_pp_t shared_pp;
+    int table = STEALTH_G_PP_WINDOW > 0 && n >= STEALTH_ADDR_MULTI_PP_MIN;
+#if STEALTH_G_PP_WINDOW > 0
+    if (table) element_pp_init_k(shared_pp, shared, STEALTH_G_PP_WINDOW);
+#endif
+
+    num_threads = block_threads(num_threads, n);
+    addr_gen_multi_job_t* jobs = calloc(num_threads, sizeof(addr_gen_multi_job_t));
+    int rc = jobs ? n : -1;
+    double shared_ms = timer_diff(t1, perf_now_ms()) / n;
+
+    for (int i = 0; jobs && i < num_threads; i++) {
+        addr_gen_multi_job_t* job = &jobs[i];
+        job->Addr = Addr;
+        job->R2 = R2;
+        job->C = C;
+        job->view_tags = view_tags;
+        job->A_r = A_r;
+        job->B_r = B_r;
+        job->r = r;
+        job->shared = shared;
+        job->shared_pp = table ? shared_pp : NULL;
+        job->shared_ms = shared_ms;
+    }
+    if (jobs) {
+        run_block(jobs, sizeof(addr_gen_multi_job_t), num_threads, n, addr_gen_multi_worker);
+        for (int i = 0; i < num_threads; i++) {
+            if (jobs[i].failed) rc = -1;
+        }
+    }
+    free(jobs);
+
+#if STEALTH_G_PP_WINDOW > 0
+    if (table) element_pp_clear(shared_pp);
+#endif
+    element_set0(rZ);
+    mpz_set_ui(r, 0);
+    scratch_put(scratch, ws);
+    return rc;
+}
 
-    element_t R1_pow_a; element_init_G1(R1_pow_a, pairing);
-    element_pow_zn(R1_pow_a, R1, aZ);
+/**
+ * Copy the keys of a recipient and build the fixed-base tables
+ */
+static void recipient_ctx_set_keys(stealth_recipient_ctx_t* ctx, element_t A_r,
+                                   element_t B_r, element_t TK) {
+    element_init_G1(ctx->A_r, pairing);
+    element_init_G1(ctx->B_r, pairing);
+    element_init_G2(ctx->TK, pairing);
+    element_set(ctx->A_r, A_r);
+    element_set(ctx->B_r, B_r);
+    element_set(ctx->TK, TK);
+
+    element_pp_init_ex(ctx->A_pp, ctx->A_r, STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+    element_pp_init_ex(ctx->B_pp, ctx->B_r, STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+}
 
-    element_t r2Z; element_init_Zr(r2Z, pairing);
-    
-    clock_t hash_start1 = clock();
-    H1(r2Z, R1_pow_a);
-    clock_t hash_end1 = clock();
+/**
+ * Build cached tables for a recipient
+ */
+int stealth_recipient_ctx_init(stealth_recipient_ctx_t* ctx, element_t A_r,
+                               element_t B_r, element_t TK) {
+    if (!library_initialized || !ctx) return -1;
+
+    recipient_ctx_set_keys(ctx, A_r, B_r, TK);
+    ctx->tk_borrowed = 0;
+    if (asymmetric) {
+        element_init_GT(ctx->eg_TK, pairing);
+        prim_pairing_pp_apply(ctx->eg_TK, ctx->TK, g_pairing_pp);
+    } else {
+        pairing_pp_init(ctx->TK_pp, ctx->TK, pairing);
+    }
+    return 0;
+}
 
-    element_t exp; element_init_Zr(exp, pairing);
-    element_mul(exp, bZ, r2Z);
+/**
+ * Length of the written tables of a recipient
+ */
+int stealth_recipient_tables_length(void) {
+    if (!library_initialized) return 0;
+    // Every G1 table of this layout has the same length; measure one on g
+    element_pp_t pp;
+    element_pp_init_ex(pp, g, STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+    int len = element_pp_length_in_bytes(pp);
+    element_pp_clear(pp);
+    return 2 * len;
+}
 
-    element_t h3_addr; element_init_G1(h3_addr, pairing);
-    
-    clock_t t2 = clock();
-    sumOnetimeSK += timer_diff(t1, t2) - timer_diff(hash_start1, hash_end1);
+/**
+ * Build and write the tables for A_r and B_r
+ */
+int stealth_recipient_tables_to_bytes(unsigned char* out, element_t A_r, element_t B_r) {
+    if (!library_initialized || !out) return 0;
+    int len = 0;
+    element_ptr base[2] = { A_r, B_r };
+    for (int i = 0; i < 2; i++) {
+        element_pp_t pp;
+        element_pp_init_ex(pp, base[i], STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+        len += element_pp_to_bytes(out + len, pp);
+        element_pp_clear(pp);
+    }
+    return len;
+}
 
-    clock_t hash_start2 = clock();
-    H3(h3_addr, Addr);
-    clock_t hash_end2 = clock();
-    
-    clock_t t3 = clock();
+/**
+ * Build a recipient context from written tables and a shared TK part
+ */
+int stealth_recipient_ctx_init_tables(stealth_recipient_ctx_t* ctx, element_t A_r,
+                                      element_t B_r, element_t TK,
+                                      const unsigned char* tables,
+                                      stealth_recipient_ctx_t* tk_from) {
+    if (!library_initialized || !ctx) return -1;
+
+    if (!tables) {
+        recipient_ctx_set_keys(ctx, A_r, B_r, TK);
+    } else {
+        element_init_G1(ctx->A_r, pairing);
+        element_init_G1(ctx->B_r, pairing);
+        element_init_G2(ctx->TK, pairing);
+        element_set(ctx->A_r, A_r);
+        element_set(ctx->B_r, B_r);
+        element_set(ctx->TK, TK);
+        int len = element_pp_from_bytes(ctx->A_pp, ctx->A_r, (unsigned char*)tables);
+        if (!len || !element_pp_from_bytes(ctx->B_pp, ctx->B_r, (unsigned char*)tables + len)) {
+            if (len) element_pp_clear(ctx->A_pp);
+            element_clear(ctx->TK);
+            element_clear(ctx->B_r);
+            element_clear(ctx->A_r);
+            return -1;
+        }
+    }
 
-    element_pow_zn(dsk, h3_addr, exp);
+    ctx->tk_borrowed = 0;
+    if (asymmetric) {
+        element_init_GT(ctx->eg_TK, pairing);
+        if (tk_from) element_set(ctx->eg_TK, tk_from->eg_TK);
+        else prim_pairing_pp_apply(ctx->eg_TK, ctx->TK, g_pairing_pp);
+    } else if (tk_from) {
+        // Read-only, so one table serves every context of the trace key
+        *ctx->TK_pp = *tk_from->TK_pp;
+        ctx->tk_borrowed = 1;
+    } else {
+        pairing_pp_init(ctx->TK_pp, ctx->TK, pairing);
+    }
+    return 0;
+}
 
-    element_clear(R1_pow_a);
-    element_clear(r2Z);
-    element_clear(exp);
-    element_clear(h3_addr);
+/**
+ * Record size of a TK table store under the active pairing, 0 if the
+ * pairing keeps its tables in memory only
+ */
+static int tk_table_record_size(void) {
+    // Asymmetric contexts hold e(g, TK) instead of a table
+    if (asymmetric) return 0;
+    int table = pairing_pp_length_in_bytes(pairing);
+    return table ? pairing_length_in_bytes_G1(pairing) + table : 0;
+}
 
-    clock_t t4 = clock();
-    sumOnetimeSK += timer_diff(t3, t4) - timer_diff(hash_start2, hash_end2);
+/**
+ * Open a store of TK pairing tables
+ */
+int stealth_tk_table_store_open(const char* path) {
+    if (!library_initialized || !path) return -1;
+    int size = tk_table_record_size();
+    if (!size) return -1;
+    return stealth_store_open(path, STEALTH_STORE_TK_TABLES, (uint32_t)size);
 }
 
 /**
- * Sign a message
+ * Build a recipient context, reading the TK table from a store
  */
-void stealth_sign(element_t Q_sigma, element_t hZ, element_t Addr, 
-                 element_t dsk, const char* msg) {
-    if (!library_initialized) return;
-    
-    clock_t t1 = clock();
+int stealth_recipient_ctx_init_stored(stealth_recipient_ctx_t* ctx, element_t A_r,
+                                      element_t B_r, element_t TK, int store) {
+    if (!library_initialized || !ctx) return -1;
+
+    int size = tk_table_record_size();
+    if (store < 0 || !size || stealth_store_kind(store) != STEALTH_STORE_TK_TABLES ||
+        stealth_store_record_size(store) != (uint32_t)size) {
+        return stealth_recipient_ctx_init(ctx, A_r, B_r, TK) ? -1 : 1;
+    }
 
-    element_t xZ; element_init_Zr(xZ, pairing);
-    element_random(xZ);
+    unsigned char* rec = malloc(size);
+    if (!rec) return -1;
+    int tk_len = element_to_bytes(rec, TK);
+
+    recipient_ctx_set_keys(ctx, A_r, B_r, TK);
+    ctx->tk_borrowed = 0;
+    long n = stealth_store_count(store);
+    for (long i = 0; i < n; i++) {
+        const unsigned char* stored = stealth_store_record(store, i);
+        if (!stored || memcmp(stored, rec, tk_len) != 0) continue;
+        if (pairing_pp_from_bytes(ctx->TK_pp, (unsigned char*)stored + tk_len, pairing)) {
+            free(rec);
+            return 0;
+        }
+        // Written under another pairing method: build, but keep the record
+        pairing_pp_init(ctx->TK_pp, ctx->TK, pairing);
+        free(rec);
+        return 1;
+    }
 
-    element_t gx; element_init_G1(gx, pairing);
-    element_pow_zn(gx, g, xZ);
+    pairing_pp_init(ctx->TK_pp, ctx->TK, pairing);
+    pairing_pp_to_bytes(rec + tk_len, ctx->TK_pp, pairing);
+    stealth_store_append(store, rec);
+    free(rec);
+    return 1;
+}
 
-    element_t XGT; element_init_GT(XGT, pairing);
-    pairing_apply(XGT, gx, g, pairing);
+/**
+ * Release a recipient context
+ */
+void stealth_recipient_ctx_clear(stealth_recipient_ctx_t* ctx) {
+    if (!ctx) return;
+    if (ctx->TK->field != ctx->A_r->field) element_clear(ctx->eg_TK);
+    else if (!ctx->tk_borrowed) pairing_pp_clear(ctx->TK_pp);
+    element_pp_clear(ctx->B_pp);
+    element_pp_clear(ctx->A_pp);
+    element_clear(ctx->TK);
+    element_clear(ctx->B_r);
+    element_clear(ctx->A_r);
+}
 
-    clock_t hash_start = clock();
-    H4(hZ, Addr, msg, XGT);
-    clock_t hash_end = clock();
+/**
+ * Address generation body for a recipient context, the view tag is
+ * written when requested
+ */
+static void addr_gen_ctx_impl(element_t Addr, element_t R1, element_t R2, element_t C,
+                              unsigned char* tag, stealth_recipient_ctx_t* ctx) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return;
 
-    element_t neg_hZ; element_init_Zr(neg_hZ, pairing);
-    element_neg(neg_hZ, hZ);
+    double t1 = perf_now_ms();
 
-    element_t dsk_inv_h; element_init_G1(dsk_inv_h, pairing);
-    element_pow_zn(dsk_inv_h, dsk, neg_hZ);
+    element_ptr rZ = ws->zr[0], r2Z = ws->zr[1];
+    element_ptr R3 = ws->g1[0], Ar_pow_r = ws->g1[1];
 
-    element_mul(Q_sigma, dsk_inv_h, gx);
+    addr_ephemeral(rZ, R1);
 
-    element_clear(xZ);
-    element_clear(gx);
-    element_clear(XGT);
-    element_clear(neg_hZ);
-    element_clear(dsk_inv_h);
+    prim_pp_pow_zn(Ar_pow_r, rZ, ctx->A_pp);
 
-    clock_t t2 = clock();
-    sumSign += timer_diff(t1, t2) - timer_diff(hash_start, hash_end);
-}
+    double hash_start = perf_now_ms();
+    H1(ws, r2Z, Ar_pow_r);
+    if (tag) compute_view_tag(tag, Ar_pow_r);
+    double hash_end = perf_now_ms();
 
-/**
- * Verify a signature
- */
-int stealth_verify(element_t Addr, element_t R2, element_t C,
-                  const char* msg, element_t hZ, element_t Q_sigma) {
-    if (!library_initialized) return 0;
-    
-    clock_t t1 = clock();
+    g2_pow_zn(R2, r2Z);
+    prim_pp_pow_zn(C, r2Z, ctx->B_pp);
 
-    element_t h3_addr; element_init_G1(h3_addr, pairing);
-    
-    clock_t t2 = clock();
-    sumVerify += timer_diff(t1, t2);
+    element_ptr pairing_res = ws->gt[0], pairing_res_powr = ws->gt[1];
 
-    clock_t hash_start1 = clock();
-    H3(h3_addr, Addr);
-    clock_t hash_end1 = clock();
+    if (asymmetric) {
+        // e(g, TK)^(r * r2): a GT power, no pairing
+        element_ptr rr2Z = ws->zr[2];
+        element_mul(rr2Z, rZ, r2Z);
+        prim_pow_zn(pairing_res_powr, ctx->eg_TK, rr2Z);
+    } else {
+        // e(TK, R2) == e(R2, TK) for the symmetric pairing
+        prim_pairing_pp_apply(pairing_res, R2, ctx->TK_pp);
+        prim_pow_zn(pairing_res_powr, pairing_res, rZ);
+    }
     
-    clock_t t3 = clock();
-
-    element_t pairing1, pairing2, pairing2_exp, prod;
-    element_init_GT(pairing1, pairing);
-    element_init_GT(pairing2, pairing);
-    element_init_GT(pairing2_exp, pairing);
-    element_init_GT(prod, pairing);
+    double t2 = perf_now_ms();
+    double op_ms = timer_diff(t1, t2) - timer_diff(hash_start, hash_end);
 
-    pairing_apply(pairing1, Q_sigma, g, pairing);
-    pairing_apply(pairing2, h3_addr, C, pairing);
-    element_pow_zn(pairing2_exp, pairing2, hZ);
-    element_mul(prod, pairing1, pairing2_exp);
-
-    element_t hZ_prime; element_init_Zr(hZ_prime, pairing);
+    H2(ws, R3, pairing_res_powr);
     
-    clock_t hash_start2 = clock();
-    H4(hZ_prime, Addr, msg, prod);
-    clock_t hash_end2 = clock();
+    double t3 = perf_now_ms();
+   
+    // Addr = R3 * B_r * C
+    element_mul(Addr, R3, ctx->B_r);
+    element_mul(Addr, Addr, C);
 
-    int valid = (element_cmp(hZ, hZ_prime) == 0);
+    double t4 = perf_now_ms();
+    perf_add(&perf_stats, PERF_ADDR_GEN, op_ms + timer_diff(t3, t4));
 
-    element_clear(h3_addr);
-    element_clear(pairing1);
-    element_clear(pairing2);
-    element_clear(pairing2_exp);
-    element_clear(prod);
-    element_clear(hZ_prime);
+    scratch_put(scratch, ws);
+}
 
-    clock_t t4 = clock();
-    sumVerify += timer_diff(t3, t4) - timer_diff(hash_start1, hash_end1) - timer_diff(hash_start2, hash_end2);
+/**
+ * Generate one-time address using a recipient context
+ */
+void stealth_addr_gen_ctx(element_t Addr, element_t R1, element_t R2, element_t C,
+                          stealth_recipient_ctx_t* ctx) {
+    if (!library_initialized || !ctx) return;
+    addr_gen_ctx_impl(Addr, R1, R2, C, NULL, ctx);
+}
 
-    return valid;
+/**
+ * Generate one-time address and view tag using a recipient context
+ */
+void stealth_addr_gen_tagged_ctx(element_t Addr, element_t R1, element_t R2, element_t C,
+                                 unsigned char* view_tag, stealth_recipient_ctx_t* ctx) {
+    if (!library_initialized || !ctx || !view_tag) return;
+    addr_gen_ctx_impl(Addr, R1, R2, C, view_tag, ctx);
 }
 
 /**
- * Trace identity
+ * Recognize address (full version)
  */
-void stealth_trace(element_t B_r, element_t Addr, element_t R1, element_t R2, 
-                  element_t C, element_t kZ) {
-    if (!library_initialized) return;
+int stealth_addr_recognize(element_t Addr, element_t R1, element_t B_r,
+                          element_t A_r, element_t C, element_t aZ, element_t TK) {
+    if (!library_initialized) return 0;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
     
-    clock_t t1 = clock();
+    double t1 = perf_now_ms();
 
-    element_t pairing_res, pairing_powk, R3;
-    element_init_GT(pairing_res, pairing);
-    element_init_GT(pairing_powk, pairing);
-    element_init_G1(R3, pairing);
+    element_ptr R1_pow_a = ws->g1[0], C_prime = ws->g1[1];
+    element_ptr R3_prime = ws->g1[2], Addr_prime = ws->g1[3];
+    element_ptr r2Z_prime = ws->zr[0];
 
-    pairing_apply(pairing_res, R1, R2, pairing);
-    element_pow_zn(pairing_powk, pairing_res, kZ);
-    
-    clock_t t2 = clock();
-    sumTrace += timer_diff(t1, t2);
-    
-    H2(R3, pairing_powk);
+    secret_pow_zn(R1_pow_a, R1, aZ);
     
-    clock_t t3 = clock();
+    double hash_start = perf_now_ms();
+    H1(ws, r2Z_prime, R1_pow_a);
+    double hash_end = perf_now_ms();
 
-    element_t R3_inv, C_inv;
-    element_init_G1(R3_inv, pairing);
-    element_init_G1(C_inv, pairing);
+    prim_pow_zn(C_prime, B_r, r2Z_prime);
 
-    element_invert(R3_inv, R3);
-    element_invert(C_inv, C);
+    element_ptr pairing_res = ws->gt[0], pairing_res_r2Z = ws->gt[1];
 
-    element_mul(B_r, Addr, R3_inv);
-    element_mul(B_r, B_r, C_inv);
+    pp_cache_apply(pairing_res, R1, TK, pp_cache);
+    prim_pow_zn(pairing_res_r2Z, pairing_res, r2Z_prime);
 
-    element_clear(pairing_res);
-    element_clear(pairing_powk);
-    element_clear(R3);
-    element_clear(R3_inv);
-    element_clear(C_inv);
+    double hash_start2 = perf_now_ms();
+    H2(ws, R3_prime, pairing_res_r2Z);
+    double hash_end2 = perf_now_ms();
+    
+    element_mul(Addr_prime, R3_prime, B_r);
+    element_mul(Addr_prime, Addr_prime, C_prime);
+
+    int eq = (element_cmp(Addr_prime, Addr) == 0);
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_ADDR_RECOGNIZE, timer_diff(t1, t2) - timer_diff(hash_start, hash_end) - timer_diff(hash_start2, hash_end2));
+
+    scratch_put(scratch, ws);
+
+    return eq;
+}
+
+/**
+ * Audit a batch of addresses of one key pair
+ */
+int stealth_addr_audit_batch(element_t Addr[], element_t R1[], element_t R2[], element_t C[],
+                             int n, element_t B_r, element_t aZ, element_t TK,
+                             unsigned char* results) {
+    if (!library_initialized || n <= 0 || !results) return -1;
+    scratch_t* ws = scratch_get(scratch);
+    element_t* r2Z = element_batch_alloc(n, pairing->Zr);
+    element_t* res = element_batch_alloc(STEALTH_TRACE_CHUNK, pairing->GT);
+    element_t* tk = element_batch_alloc(STEALTH_TRACE_CHUNK, pairing->G2);
+    if (!ws || !r2Z || !res || !tk) {
+        element_batch_free(r2Z, n);
+        element_batch_free(res, STEALTH_TRACE_CHUNK);
+        element_batch_free(tk, STEALTH_TRACE_CHUNK);
+        if (ws) scratch_put(scratch, ws);
+        return -1;
+    }
+
+    double t1 = perf_now_ms();
+    double hash_time = 0;
+    element_ptr R1_pow_a = ws->g1[0], R3 = ws->g1[1], Addr_prime = ws->g1[2];
+    for (int j = 0; j < STEALTH_TRACE_CHUNK; j++) element_set(tk[j], TK);
+
+    // Addr = H2(e(R1, TK)^r2) * B * C. The pairing values are hashed, so
+    // each address keeps its own: on the lines of TK, the one fixed
+    // argument, when the pairing is symmetric, else with the final
+    // exponentiations of a chunk sharing their inversions
+    pairing_pp_t tk_pp;
+    if (!asymmetric) pairing_pp_init(tk_pp, TK, pairing);
+    for (int i = 0; i < n; i += STEALTH_TRACE_CHUNK) {
+        int m = n - i < STEALTH_TRACE_CHUNK ? n - i : STEALTH_TRACE_CHUNK;
+        if (!asymmetric) {
+            for (int j = 0; j < m; j++) prim_pairing_pp_apply(res[j], R1[i + j], tk_pp);
+        } else {
+            prim_pairing_apply_batch(res, R1 + i, tk, m, pairing);
+        }
+        for (int j = 0; j < m; j++) {
+            secret_pow_zn(R1_pow_a, R1[i + j], aZ);
+            double hash_start = perf_now_ms();
+            H1(ws, r2Z[i + j], R1_pow_a);
+            hash_time += timer_diff(hash_start, perf_now_ms());
+
+            prim_pow_zn(res[j], res[j], r2Z[i + j]);
+            hash_start = perf_now_ms();
+            H2(ws, R3, res[j]);
+            hash_time += timer_diff(hash_start, perf_now_ms());
+
+            element_mul(Addr_prime, R3, B_r);
+            element_mul(Addr_prime, Addr_prime, C[i + j]);
+            results[i + j] = element_cmp(Addr_prime, Addr[i + j]) == 0;
+        }
+    }
+
+    if (!asymmetric) pairing_pp_clear(tk_pp);
+
+    // C = B^r2 and R2 = g2^r2, batched over the whole set
+    batch_check_pow(C, B_r, r2Z, n, results);
+    batch_check_pow(R2, g2, r2Z, n, results);
+
+    int valid = 0;
+    for (int i = 0; i < n; i++) valid += results[i];
+
+    perf_add(&perf_stats, PERF_ADDR_RECOGNIZE, timer_diff(t1, perf_now_ms()) - hash_time);
+    element_batch_free(r2Z, n);
+    element_batch_free(res, STEALTH_TRACE_CHUNK);
+    element_batch_free(tk, STEALTH_TRACE_CHUNK);
+    scratch_put(scratch, ws);
+    return valid;
+}
+
+/**
+ * Whether C' matches C, given as an element or, when C_bytes is set, in
+ * the wire format (compact encoding if compact). Encodings are unique and
+ * C' lies in the group, so the bytes compare without C being decoded or
+ * validated.
+ */
+static int commitment_matches(element_t C_prime, element_t C, const unsigned char* C_bytes,
+                              int compact) {
+    if (!C_bytes) return element_cmp(C_prime, C) == 0;
+    unsigned char buf[1024];
+    int len = compact ? stealth_compact_to_bytes(buf, C_prime) : stealth_wire_to_bytes(buf, C_prime);
+    return memcmp(buf, C_bytes, len) == 0;
+}
+
+/**
+ * Fast recognition body: C' = B_r^(r2') through B_pp when given, and
+ * only for outputs that pass the view tag when one is given. C_bytes,
+ * when set, stands in for C, in the compact encoding if compact.
+ */
+static int recognize_fast_impl(element_t R1, element_t B_r, element_pp_t B_pp,
+                               element_t C, const unsigned char* C_bytes, int compact,
+                               const unsigned char* view_tag, element_t aZ) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
+
+    // 1) r2' = H1( (R1)^aZ )
+    element_ptr R1_pow_a = ws->g1[0];
+    secret_pow_zn(R1_pow_a, R1, aZ);
+
+    element_ptr r2Z_prime = ws->zr[0];
+    int eq = 1;
+
+    double hash_start = perf_now_ms();
+    if (view_tag) {
+        unsigned char tag[STEALTH_VIEW_TAG_LEN];
+        compute_view_tag(tag, R1_pow_a);
+        eq = memcmp(tag, view_tag, STEALTH_VIEW_TAG_LEN) == 0;
+    }
+    if (eq) H1(ws, r2Z_prime, R1_pow_a);
+    double hash_end = perf_now_ms();
+
+    // 2) C' = B_r^(r2'), 3) compare with C
+    if (eq) {
+        element_ptr C_prime = ws->g1[1];
+        if (B_pp) prim_pp_pow_zn(C_prime, r2Z_prime, B_pp);
+        else prim_pow_zn(C_prime, B_r, r2Z_prime);
+        eq = commitment_matches(C_prime, C, C_bytes, compact);
+    }
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_FAST_RECOGNIZE, timer_diff(t1, t2) - timer_diff(hash_start, hash_end));
+
+    scratch_put(scratch, ws);
+
+    return eq;
+}
+
+/**
+ * Fast address recognition
+ */
+int stealth_addr_recognize_fast(element_t R1, element_t B_r, element_t A_r, 
+                               element_t C, element_t aZ) {
+    if (!library_initialized) return 0;
+    return recognize_fast_impl(R1, B_r, NULL, C, NULL, 0, NULL, aZ);
+}
+
+/**
+ * Fast address recognition with view tag prefilter
+ */
+int stealth_addr_recognize_fast_tagged(element_t R1, element_t B_r, element_t C,
+                                       const unsigned char* view_tag, element_t aZ) {
+    if (!library_initialized || !view_tag) return 0;
+    return recognize_fast_impl(R1, B_r, NULL, C, NULL, 0, view_tag, aZ);
+}
+
+/**
+ * Fast address recognition against C in the wire format
+ */
+int stealth_addr_recognize_fast_bytes(element_t R1, element_t B_r, const unsigned char* C_bytes,
+                                      const unsigned char* view_tag, element_t aZ) {
+    if (!library_initialized || !C_bytes) return 0;
+    return recognize_fast_impl(R1, B_r, NULL, NULL, C_bytes, 0, view_tag, aZ);
+}
+
+/**
+ * Fast address recognition through a recipient context
+ */
+int stealth_addr_recognize_fast_ctx(element_t R1, element_t C, const unsigned char* view_tag,
+                                    element_t aZ, stealth_recipient_ctx_t* ctx) {
+    if (!library_initialized || !ctx) return 0;
+    return recognize_fast_impl(R1, ctx->B_r, ctx->B_pp, C, NULL, 0, view_tag, aZ);
+}
+
+/**
+ * Fast address recognition through a recipient context, C in the wire format
+ */
+int stealth_addr_recognize_fast_ctx_bytes(element_t R1, const unsigned char* C_bytes,
+                                          const unsigned char* view_tag, element_t aZ,
+                                          stealth_recipient_ctx_t* ctx) {
+    if (!library_initialized || !ctx || !C_bytes) return 0;
+    return recognize_fast_impl(R1, ctx->B_r, ctx->B_pp, NULL, C_bytes, 0, view_tag, aZ);
+}
+
+/**
+ * Fast address recognition against C in the compact encoding
+ */
+int stealth_addr_recognize_fast_compact(element_t R1, element_t B_r, const unsigned char* C_compact,
+                                        const unsigned char* view_tag, element_t aZ) {
+    if (!library_initialized || !C_compact) return 0;
+    return recognize_fast_impl(R1, B_r, NULL, NULL, C_compact, 1, view_tag, aZ);
+}
+
+/**
+ * Fast address recognition through a recipient context, C in the compact encoding
+ */
+int stealth_addr_recognize_fast_ctx_compact(element_t R1, const unsigned char* C_compact,
+                                            const unsigned char* view_tag, element_t aZ,
+                                            stealth_recipient_ctx_t* ctx) {
+    if (!library_initialized || !ctx || !C_compact) return 0;
+    return recognize_fast_impl(R1, ctx->B_r, ctx->B_pp, NULL, C_compact, 1, view_tag, aZ);
+}
+
+/**
+ * Batch fast address recognition (wallet scanning)
+ */
+int stealth_scan_batch(element_t R1[], element_t C[], int n, element_t B_r,
+                       element_t aZ, unsigned char* out_bitmap) {
+    return stealth_scan_batch_tagged(R1, C, NULL, n, B_r, aZ, out_bitmap);
+}
+
+/**
+ * Batch scan body; C_bytes, when set, stands in for C with the n
+ * commitments in the wire format, or in the compact encoding if compact
+ */
+static int scan_batch_impl(element_t R1[], element_t C[], const unsigned char* C_bytes, int compact,
+                           const unsigned char* view_tags, int n, element_t B_r,
+                           element_t aZ, unsigned char* out_bitmap) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    // Scratch shared by every output in the batch
+    element_ptr C_prime = ws->g1[1];
+    mpz_ptr a_mpz = ws->z[0], r2_mpz = ws->z[1];
+    element_to_mpz(a_mpz, aZ);
+
+    // (R1_i)^aZ for a chunk of outputs at a time, one exponent for all
+    element_t R1_pow_a[STEALTH_SCAN_CHUNK];
+    int chunk = n < STEALTH_SCAN_CHUNK ? n : STEALTH_SCAN_CHUNK;
+    for (int j = 0; j < chunk; j++) element_init_G1(R1_pow_a[j], pairing);
+
+    unsigned char buf[1024];
+    size_t len = element_length_in_bytes(R1_pow_a[0]);
+    size_t c_len = !C_bytes ? 0
+                 : compact ? (size_t)stealth_compact_length(R1_pow_a[0])
+                 : (size_t)stealth_wire_length(R1_pow_a[0]);
+
+    // Every output of an untagged scan pays B^r2
+    element_pp_t B_pp;
+    int B_table = !view_tags && n >= STEALTH_SCAN_PP_MIN;
+    if (B_table) element_pp_init_ex(B_pp, B_r, STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+
+    memset(out_bitmap, 0, (n + 7) / 8);
+    int matches = 0;
+
+    for (int base = 0; base < n; base += chunk) {
+        int m = n - base < chunk ? n - base : chunk;
+        stealth_secret_pow_mpz_same(R1_pow_a, R1 + base, a_mpz, m);
+
+        for (int j = 0; j < m; j++) {
+            int i = base + j;
+            // r2' = H1( (R1_i)^aZ ), kept as an mpz to skip the Zr round trip
+            prim_to_bytes(buf, R1_pow_a[j]);
+            if (view_tags) {
+                unsigned char tag[STEALTH_VIEW_TAG_LEN];
+                stealth_view_tag_from_bytes(tag, buf, len);
+                if (memcmp(tag, view_tags + (size_t)i * STEALTH_VIEW_TAG_LEN, STEALTH_VIEW_TAG_LEN) != 0)
+                    continue;
+            }
+            hash_stream_to_mpz(r2_mpz, buf, len, pairing->r);
+
+            // C' = B_r^(r2'), compare with C_i
+            if (B_table) prim_pp_pow(C_prime, r2_mpz, B_pp);
+            else prim_pow_mpz(C_prime, B_r, r2_mpz);
+            if (commitment_matches(C_prime, C_bytes ? NULL : C[i],
+                                   C_bytes ? C_bytes + (size_t)i * c_len : NULL, compact)) {
+                out_bitmap[i >> 3] |= (unsigned char)(1 << (i & 7));
+                matches++;
+            }
+        }
+    }
+
+    if (B_table) element_pp_clear(B_pp);
+    for (int j = 0; j < chunk; j++) element_clear(R1_pow_a[j]);
+    scratch_put(scratch, ws);
+    return matches;
+}
+
+/**
+ * Batch fast address recognition with view tag prefilter
+ */
+int stealth_scan_batch_tagged(element_t R1[], element_t C[], const unsigned char* view_tags,
+                              int n, element_t B_r, element_t aZ, unsigned char* out_bitmap) {
+    if (!library_initialized || n <= 0 || !out_bitmap) return 0;
+    return scan_batch_impl(R1, C, NULL, 0, view_tags, n, B_r, aZ, out_bitmap);
+}
+
+/**
+ * Batch fast address recognition against commitments in the wire format
+ */
+int stealth_scan_batch_bytes(element_t R1[], const unsigned char* C_bytes,
+                             const unsigned char* view_tags, int n, element_t B_r,
+                             element_t aZ, unsigned char* out_bitmap) {
+    if (!library_initialized || n <= 0 || !out_bitmap || !C_bytes) return 0;
+    return scan_batch_impl(R1, NULL, C_bytes, 0, view_tags, n, B_r, aZ, out_bitmap);
+}
+
+/**
+ * Batch fast address recognition against commitments in the compact encoding
+ */
+int stealth_scan_batch_compact(element_t R1[], const unsigned char* C_compact,
+                               const unsigned char* view_tags, int n, element_t B_r,
+                               element_t aZ, unsigned char* out_bitmap) {
+    if (!library_initialized || n <= 0 || !out_bitmap || !C_compact) return 0;
+    return scan_batch_impl(R1, NULL, C_compact, 1, view_tags, n, B_r, aZ, out_bitmap);
+}
+
+/**
+ * Pick the R1 table window for n keys, 0 when plain exponentiation is
+ * cheaper. Cost in multiplications per exponent bit: building a k-bit
+ * table is about 2^k / k, each lookup-based power 1 / k, while a plain
+ * sliding-window power is about 1.2.
+ */
+static int multi_window(int n) {
+    int best = 0;
+    double best_cost = 1.2 * n;
+    for (int k = 1; k <= STEALTH_MULTI_MAX_WINDOW; k++) {
+        double cost = ((double)(1 << k) + n) / k;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = k;
+        }
+    }
+    return best;
+}
+
+/**
+ * Multi-key recognition of one output
+ */
+int stealth_recognize_multi(element_t R1, element_t C, const unsigned char* view_tag,
+                            element_t aZ[], element_t B_r[], int n) {
+    if (!library_initialized || n <= 0) return -1;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return -1;
+
+    element_ptr R1_pow_a = ws->g1[0], C_prime = ws->g1[1];
+    mpz_ptr r2_mpz = ws->z[0];
+
+    int k = STEALTH_SECRET_CT ? 0 : multi_window(n);
+    element_pp_t R1_pp;
+    if (k) element_pp_init_k(R1_pp, R1, k);
+
+    unsigned char buf[1024];
+    size_t len = element_length_in_bytes(R1_pow_a);
+    int owner = -1;
+
+    for (int i = 0; i < n && owner < 0; i++) {
+        if (k) prim_pp_pow_zn(R1_pow_a, aZ[i], R1_pp);
+        else secret_pow_zn(R1_pow_a, R1, aZ[i]);
+        prim_to_bytes(buf, R1_pow_a);
+        if (view_tag) {
+            unsigned char tag[STEALTH_VIEW_TAG_LEN];
+            stealth_view_tag_from_bytes(tag, buf, len);
+            if (memcmp(tag, view_tag, STEALTH_VIEW_TAG_LEN) != 0) continue;
+        }
+        hash_stream_to_mpz(r2_mpz, buf, len, pairing->r);
+
+        prim_pow_mpz(C_prime, B_r[i], r2_mpz);
+        if (element_cmp(C_prime, C) == 0) owner = i;
+    }
+
+    if (k) element_pp_clear(R1_pp);
+    scratch_put(scratch, ws);
+
+    return owner;
+}
+
+typedef struct {
+    block_range_t range;
+    element_t* R1;
+    element_t* C;
+    const unsigned char* view_tags;
+    const unsigned char* tagged;
+    element_t* aZ;
+    element_t* B_r;
+    int k;
+    int* owners;
+    int owned;
+} multi_block_job_t;
+
+static void* multi_block_worker(void* arg) {
+    multi_block_job_t* job = (multi_block_job_t*)arg;
+    job->owned = 0;
+    for (int i = job->range.begin; i < job->range.end; i++) {
+        const unsigned char* tag = NULL;
+        if (job->view_tags && (!job->tagged || job->tagged[i]))
+            tag = job->view_tags + (size_t)i * STEALTH_VIEW_TAG_LEN;
+        job->owners[i] = stealth_recognize_multi(job->R1[i], job->C[i], tag, job->aZ, job->B_r, job->k);
+        if (job->owners[i] >= 0) job->owned++;
+    }
+    return NULL;
+}
+
+/**
+ * Multi-key recognition of a block of outputs across worker threads
+ */
+int stealth_recognize_multi_block(element_t R1[], element_t C[], const unsigned char* view_tags,
+                                  const unsigned char* tagged, int n, element_t aZ[],
+                                  element_t B_r[], int k, int num_threads, int* owners) {
+    if (!library_initialized || n < 0 || k <= 0 || !owners) return -1;
+    if (n == 0) return 0;
+
+    num_threads = block_threads(num_threads, n);
+    multi_block_job_t* jobs = calloc(num_threads, sizeof(multi_block_job_t));
+    if (!jobs) return -1;
+
+    for (int i = 0; i < num_threads; i++) {
+        multi_block_job_t* job = &jobs[i];
+        job->R1 = R1;
+        job->C = C;
+        job->view_tags = view_tags;
+        job->tagged = tagged;
+        job->aZ = aZ;
+        job->B_r = B_r;
+        job->k = k;
+        job->owners = owners;
+    }
+    run_block(jobs, sizeof(multi_block_job_t), num_threads, n, multi_block_worker);
+
+    int owned = 0;
+    for (int i = 0; i < num_threads; i++) owned += jobs[i].owned;
+    free(jobs);
+
+    return owned;
+}
+
+/**
+ * dsk = H3(Addr)^exp. Under STEALTH_HASH_G1_POW H3(Addr) = g2^t, so this
+ * is g2^(t*exp): one fixed-base power in place of H3's and then a
+ * variable-base one. Under STEALTH_HASH_G1_MAP H3(Addr) comes through
+ * the H3 cache. Uses the workspace's hash scalar and g2[0].
+ */
+static void dsk_from_exp(scratch_t* ws, element_t dsk, element_t Addr, element_t exp) {
+    if (hash_version == STEALTH_HASH_G1_MAP) {
+        element_ptr h3_addr = ws->g2[0];
+        H3(ws, h3_addr, Addr);
+        secret_pow_zn(dsk, h3_addr, exp);
+        return;
+    }
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, Addr);
+    hash_stream_end_zr(&h, ws->hash_zr);
+    element_mul(ws->hash_zr, ws->hash_zr, exp);
+    g2_secret_pow_zn(dsk, ws->hash_zr);
+}
+
+/**
+ * Generate one-time secret key
+ */
+void stealth_onetime_skgen(element_t dsk, element_t Addr, element_t R1,
+                          element_t aZ, element_t bZ) {
+    if (!library_initialized) return;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return;
+    
+    double t1 = perf_now_ms();
+
+    element_ptr R1_pow_a = ws->g1[0];
+    secret_pow_zn(R1_pow_a, R1, aZ);
+
+    element_ptr r2Z = ws->zr[0];
+    
+    double hash_start1 = perf_now_ms();
+    H1(ws, r2Z, R1_pow_a);
+    double hash_end1 = perf_now_ms();
+
+    element_ptr exp = ws->zr[1];
+    element_mul(exp, bZ, r2Z);
+
+    dsk_from_exp(ws, dsk, Addr, exp);
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_ONETIME_SK, timer_diff(t1, t2) - timer_diff(hash_start1, hash_end1));
+
+    scratch_put(scratch, ws);
+}
+
+/**
+ * Fast recognition, then the one-time key from the same r2
+ */
+int stealth_recognize_and_derive(element_t dsk, element_t Addr, element_t R1, element_t B_r,
+                                 element_t C, const unsigned char* view_tag,
+                                 element_t aZ, element_t bZ) {
+    if (!library_initialized) return 0;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
+
+    element_ptr R1_pow_a = ws->g1[0];
+    secret_pow_zn(R1_pow_a, R1, aZ);
+
+    double hash_start = perf_now_ms();
+    int eq = 1;
+    if (view_tag) {
+        unsigned char tag[STEALTH_VIEW_TAG_LEN];
+        compute_view_tag(tag, R1_pow_a);
+        eq = memcmp(tag, view_tag, STEALTH_VIEW_TAG_LEN) == 0;
+    }
+    element_ptr r2Z = ws->zr[0];
+    if (eq) H1(ws, r2Z, R1_pow_a);
+    double hash_end = perf_now_ms();
+
+    if (eq) {
+        element_ptr C_prime = ws->g1[1];
+        prim_pow_zn(C_prime, B_r, r2Z);
+        eq = (element_cmp(C_prime, C) == 0);
+    }
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_FAST_RECOGNIZE, timer_diff(t1, t2) - timer_diff(hash_start, hash_end));
+
+    // dsk = H3(Addr)^(b*r2), r2 still in the workspace
+    if (eq) {
+        element_ptr exp = ws->zr[1];
+        element_mul(exp, bZ, r2Z);
+
+        double t3 = perf_now_ms();
+        dsk_from_exp(ws, dsk, Addr, exp);
+        double t4 = perf_now_ms();
+        perf_add(&perf_stats, PERF_ONETIME_SK, timer_diff(t3, t4));
+    }
+
+    scratch_put(scratch, ws);
+
+    return eq;
+}
+
+//----------------------------------------------
+// Streaming ingest, see stealth_ingest
+//----------------------------------------------
+
+// One output in flight; items cycle free -> parsed -> matched -> free
+typedef struct {
+    int index;
+    element_t Addr, R1, C;
+    unsigned char tag[STEALTH_VIEW_TAG_LEN];
+    mpz_t r2;                    // H1(R1^a), left by the recognize stage
+} ingest_item_t;
+
+// FIFO between two stages; NULL marks the end of the stream. Every item
+// belongs to one queue or stage, so a queue never holds more than the
+// STEALTH_INGEST_QUEUE_LEN items plus that mark.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    ingest_item_t* ring[STEALTH_INGEST_QUEUE_LEN + 1];
+    int head, count;
+} ingest_queue_t;
+
+typedef struct {
+    const unsigned char* records;
+    int n, tagged, g1_len, rec_len;
+    element_ptr B_r, aZ, bZ;
+    stealth_ingest_fn fn;
+    void* arg;
+    ingest_queue_t free_items, parsed, matched;
+    int owned;
+    int failed;                  // a stage had no workspace
+} ingest_t;
+
+static void ingest_queue_init(ingest_queue_t* q) {
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->ready, NULL);
+    q->head = q->count = 0;
+}
+
+static void ingest_queue_clear(ingest_queue_t* q) {
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->ready);
+}
+
+static void ingest_push(ingest_queue_t* q, ingest_item_t* it) {
+    pthread_mutex_lock(&q->lock);
+    q->ring[(q->head + q->count++) % (STEALTH_INGEST_QUEUE_LEN + 1)] = it;
+    pthread_cond_signal(&q->ready);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static ingest_item_t* ingest_pop(ingest_queue_t* q) {
+    pthread_mutex_lock(&q->lock);
+    while (!q->count) pthread_cond_wait(&q->ready, &q->lock);
+    ingest_item_t* it = q->ring[q->head];
+    q->head = (q->head + 1) % (STEALTH_INGEST_QUEUE_LEN + 1);
+    q->count--;
+    pthread_mutex_unlock(&q->lock);
+    return it;
+}
+
+static void ingest_parse_one(ingest_t* in, ingest_item_t* it, int i) {
+    const unsigned char* rec = in->records + (size_t)i * in->rec_len;
+    it->index = i;
+    stealth_wire_from_bytes(it->Addr, rec);
+    stealth_wire_from_bytes(it->R1, rec + in->g1_len);
+    stealth_wire_from_bytes(it->C, rec + 2 * in->g1_len);
+    if (in->tagged) memcpy(it->tag, rec + 3 * in->g1_len, STEALTH_VIEW_TAG_LEN);
+}
+
+// Same test as stealth_scan_batch_tagged; a_mpz holds aZ
+static int ingest_match(ingest_t* in, scratch_t* ws, ingest_item_t* it, mpz_t a_mpz) {
+    element_ptr R1_pow_a = ws->g1[0], C_prime = ws->g1[1];
+    unsigned char buf[1024];
+    size_t len = element_length_in_bytes(R1_pow_a);
+
+    secret_pow_mpz(R1_pow_a, it->R1, a_mpz);
+    prim_to_bytes(buf, R1_pow_a);
+    if (in->tagged) {
+        unsigned char tag[STEALTH_VIEW_TAG_LEN];
+        stealth_view_tag_from_bytes(tag, buf, len);
+        if (memcmp(tag, it->tag, STEALTH_VIEW_TAG_LEN) != 0) return 0;
+    }
+    hash_stream_to_mpz(it->r2, buf, len, pairing->r);
+
+    prim_pow_mpz(C_prime, in->B_r, it->r2);
+    return element_cmp(C_prime, it->C) == 0;
+}
+
+// The tail of stealth_onetime_skgen, from the r2 that recognition found
+static void ingest_derive_one(ingest_t* in, scratch_t* ws, ingest_item_t* it, element_t dsk) {
+    element_ptr exp = ws->zr[1];
+    element_set_mpz(exp, it->r2);
+    element_mul(exp, in->bZ, exp);
+    dsk_from_exp(ws, dsk, it->Addr, exp);
+    in->fn(in->arg, it->index, dsk);
+    in->owned++;
+}
+
+static void* ingest_parse_stage(void* arg) {
+    ingest_t* in = (ingest_t*)arg;
+    for (int i = 0; i < in->n; i++) {
+        ingest_item_t* it = ingest_pop(&in->free_items);
+        ingest_parse_one(in, it, i);
+        ingest_push(&in->parsed, it);
+    }
+    ingest_push(&in->parsed, NULL);
+    return NULL;
+}
+
+static void* ingest_recognize_stage(void* arg) {
+    ingest_t* in = (ingest_t*)arg;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) in->failed = 1;
+    else element_to_mpz(ws->z[0], in->aZ);
+
+    // Without a workspace the stream is still drained, so parse can finish
+    ingest_item_t* it;
+    while ((it = ingest_pop(&in->parsed))) {
+        if (ws && ingest_match(in, ws, it, ws->z[0])) ingest_push(&in->matched, it);
+        else ingest_push(&in->free_items, it);
+    }
+    ingest_push(&in->matched, NULL);
+
+    if (ws) scratch_put(scratch, ws);
+    return NULL;
+}
+
+// Last stage, on the calling thread; also recognizes when that stage has
+// no thread of its own
+static void ingest_derive_stage(ingest_t* in, ingest_queue_t* q, int recognize) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) in->failed = 1;
+    else element_to_mpz(ws->z[0], in->aZ);
+    element_t dsk;
+    element_init_G2(dsk, pairing);
+
+    ingest_item_t* it;
+    while ((it = ingest_pop(q))) {
+        if (ws && (!recognize || ingest_match(in, ws, it, ws->z[0])))
+            ingest_derive_one(in, ws, it, dsk);
+        ingest_push(&in->free_items, it);
+    }
+
+    element_clear(dsk);
+    if (ws) scratch_put(scratch, ws);
+}
+
+/**
+ * Record length of an ingest stream
+ */
+int stealth_ingest_record_length(int tagged) {
+    if (!library_initialized) return 0;
+    element_t t;
+    element_init_G1(t, pairing);
+    int len = 3 * stealth_wire_length(t) + (tagged ? STEALTH_VIEW_TAG_LEN : 0);
+    element_clear(t);
+    return len;
+}
+
+/**
+ * Streaming block ingest: parse, recognize and derive on separate threads
+ */
+int stealth_ingest(const unsigned char* records, int n, int tagged, element_t B_r,
+                   element_t aZ, element_t bZ, stealth_ingest_fn fn, void* arg) {
+    if (!library_initialized || n < 0 || !records || !fn) return -1;
+    if (n == 0) return 0;
+
+    ingest_t in = {
+        .records = records, .n = n, .tagged = tagged,
+        .B_r = B_r, .aZ = aZ, .bZ = bZ, .fn = fn, .arg = arg
+    };
+    in.g1_len = stealth_wire_length(B_r);
+    in.rec_len = 3 * in.g1_len + (tagged ? STEALTH_VIEW_TAG_LEN : 0);
+
+    int pool = n < STEALTH_INGEST_QUEUE_LEN ? n : STEALTH_INGEST_QUEUE_LEN;
+    ingest_item_t* items = calloc(pool, sizeof(ingest_item_t));
+    if (!items) return -1;
+    ingest_queue_init(&in.free_items);
+    ingest_queue_init(&in.parsed);
+    ingest_queue_init(&in.matched);
+    for (int i = 0; i < pool; i++) {
+        element_init_G1(items[i].Addr, pairing);
+        element_init_G1(items[i].R1, pairing);
+        element_init_G1(items[i].C, pairing);
+        mpz_init(items[i].r2);
+        ingest_push(&in.free_items, &items[i]);
+    }
+
+    pthread_t parse_tid, recognize_tid;
+    if (pthread_create(&parse_tid, NULL, ingest_parse_stage, &in) != 0) {
+        // No threads: each output goes through the three stages in turn
+        scratch_t* ws = scratch_get(scratch);
+        if (!ws) {
+            in.failed = 1;
+        } else {
+            element_t dsk;
+            element_init_G2(dsk, pairing);
+            element_to_mpz(ws->z[0], aZ);
+            for (int i = 0; i < n; i++) {
+                ingest_parse_one(&in, &items[0], i);
+                if (ingest_match(&in, ws, &items[0], ws->z[0])) ingest_derive_one(&in, ws, &items[0], dsk);
+            }
+            element_clear(dsk);
+            scratch_put(scratch, ws);
+        }
+    } else {
+        if (pthread_create(&recognize_tid, NULL, ingest_recognize_stage, &in) != 0) {
+            ingest_derive_stage(&in, &in.parsed, 1);
+        } else {
+            ingest_derive_stage(&in, &in.matched, 0);
+            pthread_join(recognize_tid, NULL);
+        }
+        pthread_join(parse_tid, NULL);
+    }
+
+    for (int i = 0; i < pool; i++) {
+        element_clear(items[i].Addr);
+        element_clear(items[i].R1);
+        element_clear(items[i].C);
+        mpz_clear(items[i].r2);
+    }
+    free(items);
+    ingest_queue_clear(&in.free_items);
+    ingest_queue_clear(&in.parsed);
+    ingest_queue_clear(&in.matched);
+
+    return in.failed ? -1 : in.owned;
+}
+
+/**
+ * Sign a message
+ */
+/**
+ * Signature body; dsk^-h through the leased cache entry when there is one
+ */
+static void sign_with(element_t Q_sigma, element_t hZ, element_t Addr, element_t dsk,
+                      const dsk_cache_lease_t* lease, const char* msg) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return;
+    
+    double t1 = perf_now_ms();
+
+    // x, g2^x and e(g, g2)^x, equal to e(g, g2^x) without the pairing
+    element_ptr xZ = ws->zr[0], gx = ws->g2[0], XGT = ws->gt[0];
+    element_ptr nonce[] = { xZ, gx, XGT };
+    if (seeded_random_active() || !eph_pool_pop(&sign_pool, nonce)) fill_sign_nonce(nonce, NULL);
+
+    double hash_start = perf_now_ms();
+    H4(ws, hZ, Addr, msg, XGT);
+    double hash_end = perf_now_ms();
+
+    element_ptr neg_hZ = ws->zr[1];
+    element_neg(neg_hZ, hZ);
+
+    element_ptr dsk_inv_h = ws->g2[1];
+    if (lease) dsk_cache_pow_zn(dsk_inv_h, neg_hZ, lease);
+    else prim_pow_zn(dsk_inv_h, dsk, neg_hZ);
+
+    element_mul(Q_sigma, dsk_inv_h, gx);
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_SIGN, timer_diff(t1, t2) - timer_diff(hash_start, hash_end));
+
+    scratch_put(scratch, ws);
+}
+
+void stealth_sign(element_t Q_sigma, element_t hZ, element_t Addr, 
+                 element_t dsk, const char* msg) {
+    if (!library_initialized) return;
+    sign_with(Q_sigma, hZ, Addr, dsk, NULL, msg);
+}
+
+void stealth_sign_cached(element_t Q_sigma, element_t hZ, element_t dsk, long id,
+                         element_t Addr, element_t R1, element_t aZ, element_t bZ,
+                         const char* msg) {
+    if (!library_initialized) return;
+    if (!dsk_cache_live || dsk_cache.capacity == 0) {
+        stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
+        sign_with(Q_sigma, hZ, Addr, dsk, NULL, msg);
+        return;
+    }
+
+    // Everything the key derives from; the secrets only enter through the digest
+    unsigned char key[SHA256_DIGEST_LENGTH];
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_element(&h, Addr);
+    hash_stream_element(&h, R1);
+    hash_stream_element(&h, aZ);
+    hash_stream_element(&h, bZ);
+    hash_stream_end(&h, key);
+
+    dsk_cache_lease_t lease;
+    if (dsk_cache_get(&dsk_cache, id, key, &lease)) {
+        dsk_cache_copy(dsk, &lease);
+        sign_with(Q_sigma, hZ, Addr, dsk, &lease, msg);
+        dsk_cache_put(&dsk_cache, &lease);
+        return;
+    }
+    stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
+    sign_with(Q_sigma, hZ, Addr, dsk, NULL, msg);
+    dsk_cache_insert(&dsk_cache, id, key, dsk);
+}
+
+// Whether verification pairs C through the verify table cache
+static int verify_pp_on(void) {
+    return verify_pp_cache->capacity > 0 && pairing_pp_is_precomputed(pairing);
+}
+
+/**
+ * Verification body for STEALTH_HASH_G1_MAP, where the discrete log of
+ * H3(Addr) is unknown: e(g, Q_sigma) * e(C^h, H3(Addr)), two Miller loops
+ * and a single final exponentiation on the product. The power falls on
+ * C, which stays in G1 when the pairing is asymmetric. With the verify
+ * table cache on and a symmetric pairing, where both powers cost the
+ * same, the second factor is e(C, H3(Addr)^h) through the cached table
+ * of C instead, so an address verified again skips its Miller lines.
+ */
+static int verify_one_mapped(scratch_t* ws, element_t Addr, element_t C, const char* msg,
+                             element_t hZ, element_t Q_sigma, element_ptr X_out,
+                             double* hash_ms) {
+    element_ptr h3 = ws->g2[0], C_h = ws->g1[0], hZ_prime = ws->zr[0];
+    element_ptr prod = ws->gt[0], e2 = ws->gt[1];
+
+    double hash_start1 = perf_now_ms();
+    H3(ws, h3, Addr);
+    double hash_end1 = perf_now_ms();
+
+    prim_pairing_pp_apply_unreduced(prod, Q_sigma, g_pairing_pp);
+    if (verify_pp_on() && !asymmetric) {
+        prim_pow_zn(h3, h3, hZ);
+        pp_cache_apply_unreduced(e2, C, h3, verify_pp_cache);
+    } else {
+        prim_pow_zn(C_h, C, hZ);
+        prim_pairing_apply_unreduced(e2, C_h, h3, pairing);
+    }
+    element_mul(prod, prod, e2);
+    element_gt_reduce(prod);
+
+    double hash_start2 = perf_now_ms();
+    H4(ws, hZ_prime, Addr, msg, prod);
+    double hash_end2 = perf_now_ms();
+
+    int valid = (element_cmp(hZ, hZ_prime) == 0);
+    if (X_out) element_set(X_out, prod);
+
+    if (hash_ms) *hash_ms = timer_diff(hash_start1, hash_end1) + timer_diff(hash_start2, hash_end2);
+    return valid;
+}
+
+/**
+ * Shared verification body. H3(Addr) = g^t, so with a symmetric pairing
+ * e(Q_sigma, g) * e(H3(Addr), C)^h = e(g, Q_sigma * C^(t*h)): one G1
+ * exponentiation and a single pairing against g through g_pairing_pp,
+ * instead of two pairings and a GT exponentiation. With an asymmetric
+ * pairing H3(Addr) = g2^t and Q_sigma lie in G2, so the product
+ * e(g, Q_sigma) * e(C^(t*h), g2) takes two Miller loops instead; with the
+ * verify table cache on, the second is e(C, g2^(t*h)) through the cached
+ * table of C, the power coming from the fixed-base table of g2.
+ * The recomputed commitment, e(g, g2)^x of a valid signature, goes to
+ * X_out unless it is NULL.
+ * Touches no globals other than the read-only pairing tables and the
+ * workspace pool, so block workers each borrow their own workspace.
+ */
+static int verify_one(element_t Addr, element_t C, const char* msg,
+                      element_t hZ, element_t Q_sigma, element_ptr X_out, double* hash_ms) {
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    if (hash_version == STEALTH_HASH_G1_MAP) {
+        int valid = verify_one_mapped(ws, Addr, C, msg, hZ, Q_sigma, X_out, hash_ms);
+        scratch_put(scratch, ws);
+        return valid;
+    }
+
+    // t*h stays in Zr: the digest reduces without a division and the
+    // product is one Montgomery multiplication
+    element_ptr tZ = ws->zr[1];
+    hash_stream_t hs;
+
+    double hash_start1 = perf_now_ms();
+    hash_stream_begin(&hs);
+    hash_stream_element(&hs, Addr);
+    hash_stream_end_zr(&hs, tZ);
+    double hash_end1 = perf_now_ms();
+
+    element_mul(tZ, tZ, hZ);
+
+    element_ptr X = ws->g1[0], prod = ws->gt[0], hZ_prime = ws->zr[0];
+
+    if (asymmetric) {
+        element_ptr e2 = ws->gt[1];
+        prim_pairing_pp_apply_unreduced(prod, Q_sigma, g_pairing_pp);
+        if (verify_pp_on()) {
+            element_ptr g2_th = ws->g2[0];
+            g2_pow_zn(g2_th, tZ);
+            pp_cache_apply_unreduced(e2, C, g2_th, verify_pp_cache);
+        } else {
+            prim_pow_zn(X, C, tZ);
+            prim_pairing_apply_unreduced(e2, X, g2, pairing);
+        }
+        element_mul(prod, prod, e2);
+        element_gt_reduce(prod);
+    } else {
+        prim_pow_zn(X, C, tZ);
+        element_mul(X, X, Q_sigma);
+        prim_pairing_pp_apply(prod, X, g_pairing_pp);
+    }
+
+    double hash_start2 = perf_now_ms();
+    H4(ws, hZ_prime, Addr, msg, prod);
+    double hash_end2 = perf_now_ms();
+
+    int valid = (element_cmp(hZ, hZ_prime) == 0);
+    if (X_out) element_set(X_out, prod);
+    scratch_put(scratch, ws);
+
+    if (hash_ms) *hash_ms = timer_diff(hash_start1, hash_end1) + timer_diff(hash_start2, hash_end2);
+    return valid;
+}
+
+/**
+ * Verify a signature
+ */
+int stealth_verify(element_t Addr, element_t R2, element_t C,
+                  const char* msg, element_t hZ, element_t Q_sigma) {
+    if (!library_initialized) return 0;
+    
+    double hash_ms = 0;
+    double t1 = perf_now_ms();
+
+    int valid = verify_one(Addr, C, msg, hZ, Q_sigma, NULL, &hash_ms);
+
+    double t2 = perf_now_ms();
+    perf_add(&perf_stats, PERF_VERIFY, timer_diff(t1, t2) - hash_ms);
+
+    return valid;
+}
+
+typedef struct {
+    block_range_t range;
+    element_t* Addr;
+    element_t* C;
+    const char** msgs;
+    element_t* hZ;
+    element_t* Q_sigma;
+    element_t* XGT;              // recomputed commitments, NULL when not wanted
+    unsigned char* results;
+    int valid;
+} verify_block_job_t;
+
+static void* verify_block_worker(void* arg) {
+    verify_block_job_t* job = (verify_block_job_t*)arg;
+    job->valid = 0;
+    for (int i = job->range.begin; i < job->range.end; i++) {
+        element_ptr X = job->XGT ? job->XGT[i] : NULL;
+        job->results[i] = (unsigned char)verify_one(job->Addr[i], job->C[i], job->msgs[i],
+                                                    job->hZ[i], job->Q_sigma[i], X, NULL);
+        job->valid += job->results[i];
+    }
+    return NULL;
+}
+
+// Verify Addr[0..n) across num_threads workers, keeping the commitments in XGT if not NULL
+static int verify_range(element_t Addr[], element_t C[], const char* msgs[], element_t hZ[],
+                        element_t Q_sigma[], element_t XGT[], int n, int num_threads,
+                        unsigned char* results) {
+    num_threads = block_threads(num_threads, n);
+    verify_block_job_t* jobs = calloc(num_threads, sizeof(verify_block_job_t));
+    if (!jobs) return -1;
+
+    for (int i = 0; i < num_threads; i++) {
+        verify_block_job_t* job = &jobs[i];
+        job->Addr = Addr;
+        job->C = C;
+        job->msgs = msgs;
+        job->hZ = hZ;
+        job->Q_sigma = Q_sigma;
+        job->XGT = XGT;
+        job->results = results;
+    }
+    run_block(jobs, sizeof(verify_block_job_t), num_threads, n, verify_block_worker);
+
+    int valid = 0;
+    for (int i = 0; i < num_threads; i++) valid += jobs[i].valid;
+    free(jobs);
+
+    return valid;
+}
+
+/**
+ * Verify a block of signatures across worker threads
+ */
+int stealth_verify_block(element_t Addr[], element_t R2[], element_t C[],
+                         const char* msgs[], element_t hZ[], element_t Q_sigma[],
+                         int n, int num_threads, unsigned char* results) {
+    (void)R2;
+    if (!library_initialized || n < 0 || !results) return -1;
+    if (n == 0) return 0;
+    return verify_range(Addr, C, msgs, hZ, Q_sigma, NULL, n, num_threads, results);
+}
+
+/**
+ * Weights of an aggregate, z_i = SHA-256(D || i) cut to
+ * STEALTH_AGGREGATE_WEIGHT_BITS, where D hashes every address, C,
+ * message and commitment of the block. Fixed by the block itself, so a
+ * producer cannot pick commitments whose errors cancel in the product.
+ */
+static void aggregate_weights(mpz_t z[], element_t Addr[], element_t C[], const char* msgs[],
+                              element_t XGT[], int n) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    unsigned char count[4] = { n >> 24, n >> 16, n >> 8, n };
+    hash_stream_t h;
+    hash_stream_begin(&h);
+    hash_stream_bytes(&h, count, sizeof(count));
+    for (int i = 0; i < n; i++) {
+        size_t len = strlen(msgs[i]);
+        unsigned char len_bytes[4] = { len >> 24, len >> 16, len >> 8, len };
+        hash_stream_element(&h, Addr[i]);
+        hash_stream_element(&h, C[i]);
+        hash_stream_element(&h, XGT[i]);
+        hash_stream_bytes(&h, len_bytes, sizeof(len_bytes));
+        hash_stream_bytes(&h, msgs[i], len);
+    }
+    hash_stream_end(&h, digest);
+
+    unsigned char w[SHA256_DIGEST_LENGTH];
+    for (int i = 0; i < n; i++) {
+        unsigned char index[4] = { i >> 24, i >> 16, i >> 8, i };
+        hash_stream_begin(&h);
+        hash_stream_bytes(&h, digest, sizeof(digest));
+        hash_stream_bytes(&h, index, sizeof(index));
+        hash_stream_end(&h, w);
+        mpz_import(z[i], STEALTH_AGGREGATE_WEIGHT_BITS / 8, 1, 1, 1, 0, w);
+    }
+}
+
+/**
+ * Aggregate a block of signatures
+ */
+int stealth_aggregate(element_t XGT[], element_t Q_agg, element_t Addr[], element_t C[],
+                      const char* msgs[], element_t hZ[], element_t Q_sigma[],
+                      int n, int num_threads, unsigned char* results) {
+    if (!library_initialized || n <= 0 || !results) return -1;
+
+    int valid = verify_range(Addr, C, msgs, hZ, Q_sigma, XGT, n, num_threads, results);
+    if (valid != n) return valid;
+
+    mpz_t* z = mpz_batch_alloc(n);
+    if (!z) return -1;
+    aggregate_weights(z, Addr, C, msgs, XGT, n);
+    prim_multi_pow_mpz(Q_agg, Q_sigma, z, n);
+    mpz_batch_free(z, n);
+    return n;
+}
+
+/**
+ * Left side of an aggregate check under STEALTH_HASH_G1_MAP:
+ * e(g, Q_agg) * prod e(C_i^(h_i*z_i), H3(Addr_i)), n + 1 Miller loops
+ * sharing one final exponentiation
+ */
+static int aggregate_lhs_mapped(scratch_t* ws, element_t lhs, element_t Addr[], element_t C[],
+                                element_t hZ[], mpz_t z[], element_t Q_agg, int n) {
+    element_t* in1 = element_batch_alloc(n + 1, pairing->G1);
+    element_t* in2 = element_batch_alloc(n + 1, pairing->G2);
+    mpz_t* e = mpz_batch_alloc(n);
+    if (!in1 || !in2 || !e) {
+        element_batch_free(in1, n + 1);
+        element_batch_free(in2, n + 1);
+        mpz_batch_free(e, n);
+        return 0;
+    }
+
+    element_set(in1[0], g);
+    element_set(in2[0], Q_agg);
+    for (int i = 0; i < n; i++) {
+        element_to_mpz(e[i], hZ[i]);
+        mpz_mul(e[i], e[i], z[i]);
+        element_set(in1[i + 1], C[i]);
+        H3(ws, in2[i + 1], Addr[i]);
+    }
+    prim_pow_mpz_batch(in1 + 1, in1 + 1, e, n);
+    prim_prod_pairing(lhs, in1, in2, n + 1);
+
+    element_batch_free(in1, n + 1);
+    element_batch_free(in2, n + 1);
+    mpz_batch_free(e, n);
+    return 1;
+}
+
+/**
+ * Left side under STEALTH_HASH_G1_POW: H3(Addr_i) = g2^t_i, so the block
+ * folds into X = prod C_i^(t_i*h_i*z_i), one multi-exponentiation, and
+ * e(g, Q_agg * X) is a single pairing (two Miller loops when asymmetric)
+ */
+static int aggregate_lhs_pow(scratch_t* ws, element_t lhs, element_t Addr[], element_t C[],
+                             element_t hZ[], mpz_t z[], element_t Q_agg, int n) {
+    mpz_t* e = mpz_batch_alloc(n);
+    if (!e) return 0;
+
+    element_ptr tZ = ws->zr[1], X = ws->g1[0];
+    for (int i = 0; i < n; i++) {
+        hash_stream_t hs;
+        hash_stream_begin(&hs);
+        hash_stream_element(&hs, Addr[i]);
+        hash_stream_end_zr(&hs, tZ);
+        element_mul(tZ, tZ, hZ[i]);
+        element_mul_mpz(tZ, tZ, z[i]);
+        element_to_mpz(e[i], tZ);
+    }
+    prim_multi_pow_mpz(X, C, e, n);
+    mpz_batch_free(e, n);
+
+    if (asymmetric) {
+        element_ptr e2 = ws->gt[1];
+        prim_pairing_pp_apply_unreduced(lhs, Q_agg, g_pairing_pp);
+        prim_pairing_apply_unreduced(e2, X, g2, pairing);
+        element_mul(lhs, lhs, e2);
+        element_gt_reduce(lhs);
+    } else {
+        element_mul(X, X, Q_agg);
+        prim_pairing_pp_apply(lhs, X, g_pairing_pp);
+    }
+    return 1;
+}
+
+/**
+ * Verify an aggregate
+ */
+int stealth_verify_aggregate(element_t Addr[], element_t R2[], element_t C[],
+                             const char* msgs[], element_t XGT[], element_t Q_agg, int n) {
+    (void)R2;
+    if (!library_initialized || n <= 0) return 0;
+    scratch_t* ws = scratch_get(scratch);
+    mpz_t* z = mpz_batch_alloc(n);
+    element_t* hZ = element_batch_alloc(n, pairing->Zr);
+    int valid = 0;
+
+    if (ws && z && hZ) {
+        aggregate_weights(z, Addr, C, msgs, XGT, n);
+        for (int i = 0; i < n; i++) H4(ws, hZ[i], Addr[i], msgs[i], XGT[i]);
+
+        element_ptr lhs = ws->gt[0];
+        int done = hash_version == STEALTH_HASH_G1_MAP
+            ? aggregate_lhs_mapped(ws, lhs, Addr, C, hZ, z, Q_agg, n)
+            : aggregate_lhs_pow(ws, lhs, Addr, C, hZ, z, Q_agg, n);
+        if (done) {
+            // The commitments are taken as they come; the product of their
+            // powers must land on the pairing value
+            element_t rhs;
+            element_init_GT(rhs, pairing);
+            prim_multi_pow_mpz(rhs, XGT, z, n);
+            valid = element_cmp(lhs, rhs) == 0;
+            element_clear(rhs);
+        }
+    }
+
+    element_batch_free(hZ, n);
+    mpz_batch_free(z, n);
+    if (ws) scratch_put(scratch, ws);
+    return valid;
+}
+
+/**
+ * Trace identity
+ */
+void stealth_trace(element_t B_r, element_t Addr, element_t R1, element_t R2, 
+                  element_t C, element_t kZ) {
+    if (!library_initialized) return;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return;
+    
+    double t1 = perf_now_ms();
+
+    element_ptr pairing_res = ws->gt[0], pairing_powk = ws->gt[1], R3 = ws->g1[0];
+
+    pp_cache_apply(pairing_res, R1, R2, pp_cache);
+    secret_pow_zn(pairing_powk, pairing_res, kZ);
+    
+    double t2 = perf_now_ms();
+    double op_ms = timer_diff(t1, t2);
+    
+    H2(ws, R3, pairing_powk);
+    
+    double t3 = perf_now_ms();
+
+    element_ptr R3_inv = ws->g1[1], C_inv = ws->g1[2];
+
+    element_invert(R3_inv, R3);
+    element_invert(C_inv, C);
+
+    element_mul(B_r, Addr, R3_inv);
+    element_mul(B_r, B_r, C_inv);
+
+    double t4 = perf_now_ms();
+    perf_add(&perf_stats, PERF_TRACE, op_ms + timer_diff(t3, t4));
+
+    scratch_put(scratch, ws);
+}
+
+/**
+ * Bulk identity tracing
+ */
+int stealth_trace_batch(element_t B_out[], element_t Addr[], element_t R1[],
+                        element_t R2[], element_t C[], int n, element_t kZ) {
+    if (!library_initialized || n <= 0) return 0;
+    scratch_t* ws = scratch_get(scratch);
+    if (!ws) return 0;
+
+    double t1 = perf_now_ms();
+    double hash_time = 0;
+
+    // Scratch shared by every tuple in the batch
+    element_ptr R3 = ws->g1[0], D = ws->g1[1];
+    element_t res[STEALTH_TRACE_CHUNK];
+    int chunk = n < STEALTH_TRACE_CHUNK ? n : STEALTH_TRACE_CHUNK;
+    for (int j = 0; j < chunk; j++) element_init_GT(res[j], pairing);
+
+    // The trace key is fixed for the whole batch
+    mpz_ptr k_mpz = ws->z[0];
+    element_to_mpz(k_mpz, kZ);
+
+    for (int i = 0; i < n; i += chunk) {
+        int m = n - i < chunk ? n - i : chunk;
+        // Cached tables serve repeated R1 values; otherwise batch the pairings
+        if (pp_cache->capacity > 0) {
+            for (int j = 0; j < m; j++) pp_cache_apply(res[j], R1[i + j], R2[i + j], pp_cache);
+        } else {
+            prim_pairing_apply_batch(res, R1 + i, R2 + i, m, pairing);
+        }
+        stealth_secret_pow_mpz_same(res, res, k_mpz, m);
+        for (int j = 0; j < m; j++) {
+            double hash_start = perf_now_ms();
+            H2(ws, R3, res[j]);
+            hash_time += timer_diff(hash_start, perf_now_ms());
+
+            // B = Addr / (R3 * C): one division instead of two inversions
+            element_mul(D, R3, C[i + j]);
+            element_div(B_out[i + j], Addr[i + j], D);
+        }
+    }
+
+    for (int j = 0; j < chunk; j++) element_clear(res[j]);
+    scratch_put(scratch, ws);
 
-    clock_t t4 = clock();
-    sumTrace += timer_diff(t3, t4);
+    perf_add(&perf_stats, PERF_TRACE, timer_diff(t1, perf_now_ms()) - hash_time);
+    return n;
 }
 
 //----------------------------------------------
@@ -561,13 +2627,13 @@ void stealth_trace(element_t B_r, element_t Addr, element_t R1, element_t R2,
 void stealth_get_performance(stealth_performance_t* perf) {
     if (!perf || perf_counter == 0) return;
     
-    perf->addr_gen_avg = sumAddrGen / perf_counter;
-    perf->addr_recognize_avg = sumAddrRecognize / perf_counter;
-    perf->fast_recognize_avg = sumFastAddrRecognize / perf_counter;
-    perf->onetime_sk_avg = sumOnetimeSK / perf_counter;
-    perf->sign_avg = sumSign / perf_counter;
-    perf->verify_avg = sumVerify / perf_counter;
-    perf->trace_avg = sumTrace / perf_counter;
+    perf->addr_gen_avg = perf_total_ms(&perf_stats, PERF_ADDR_GEN) / perf_counter;
+    perf->addr_recognize_avg = perf_total_ms(&perf_stats, PERF_ADDR_RECOGNIZE) / perf_counter;
+    perf->fast_recognize_avg = perf_total_ms(&perf_stats, PERF_FAST_RECOGNIZE) / perf_counter;
+    perf->onetime_sk_avg = perf_total_ms(&perf_stats, PERF_ONETIME_SK) / perf_counter;
+    perf->sign_avg = perf_total_ms(&perf_stats, PERF_SIGN) / perf_counter;
+    perf->verify_avg = perf_total_ms(&perf_stats, PERF_VERIFY) / perf_counter;
+    perf->trace_avg = perf_total_ms(&perf_stats, PERF_TRACE) / perf_counter;
     perf->operation_count = perf_counter;
 }
 
@@ -581,13 +2647,48 @@ void stealth_print_performance(void) {
     }
     
     printf("\n=== Performance Statistics (%d operations) ===\n", perf_counter);
-    printf("Address Generation:  %.3f ms\n", sumAddrGen / perf_counter);
-    printf("Address Recognize:   %.3f ms\n", sumAddrRecognize / perf_counter);
-    printf("Fast Recognize:      %.3f ms\n", sumFastAddrRecognize / perf_counter);
-    printf("One-time SK Gen:     %.3f ms\n", sumOnetimeSK / perf_counter);
-    printf("Sign:                %.3f ms\n", sumSign / perf_counter);
-    printf("Verify:              %.3f ms\n", sumVerify / perf_counter);
-    printf("Trace:               %.3f ms\n", sumTrace / perf_counter);
+    printf("Address Generation:  %.3f ms\n", perf_total_ms(&perf_stats, PERF_ADDR_GEN) / perf_counter);
+    printf("Address Recognize:   %.3f ms\n", perf_total_ms(&perf_stats, PERF_ADDR_RECOGNIZE) / perf_counter);
+    printf("Fast Recognize:      %.3f ms\n", perf_total_ms(&perf_stats, PERF_FAST_RECOGNIZE) / perf_counter);
+    printf("One-time SK Gen:     %.3f ms\n", perf_total_ms(&perf_stats, PERF_ONETIME_SK) / perf_counter);
+    printf("Sign:                %.3f ms\n", perf_total_ms(&perf_stats, PERF_SIGN) / perf_counter);
+    printf("Verify:              %.3f ms\n", perf_total_ms(&perf_stats, PERF_VERIFY) / perf_counter);
+    printf("Trace:               %.3f ms\n", perf_total_ms(&perf_stats, PERF_TRACE) / perf_counter);
+}
+
+/**
+ * Latency percentiles of each operation
+ */
+int stealth_get_latency(stealth_latency_t* lat, int n) {
+    if (!lat) return 0;
+    if (n > STEALTH_LATENCY_OPS) n = STEALTH_LATENCY_OPS;
+    for (int op = 0; op < n; op++) {
+        perf_latency_t l;
+        perf_latency(&perf_stats, PERF_ADDR_GEN + op, &l);
+        lat[op].count = l.count;
+        lat[op].mean_ms = l.mean_ms;
+        lat[op].p50_ms = l.p50_ms;
+        lat[op].p90_ms = l.p90_ms;
+        lat[op].p99_ms = l.p99_ms;
+        lat[op].max_ms = l.max_ms;
+    }
+    return n > 0 ? n : 0;
+}
+
+/**
+ * Snapshot of an operation's latency histogram
+ */
+long stealth_latency_histogram(int op, unsigned long* counts, int n, double* max_ms) {
+    if (op < 0 || op >= STEALTH_LATENCY_OPS || !counts || n < PERF_HIST_BUCKETS) return -1;
+    return (long)perf_hist_snapshot(&perf_stats, PERF_ADDR_GEN + op, counts, max_ms);
+}
+
+int stealth_latency_buckets(void) {
+    return PERF_HIST_BUCKETS;
+}
+
+double stealth_latency_bucket_ms(int bucket) {
+    return perf_hist_bucket_ms(bucket);
 }
 
 //----------------------------------------------
@@ -601,11 +2702,24 @@ int stealth_element_size_G1(void) {
     if (!library_initialized) return 0;
     element_t temp;
     element_init_G1(temp, pairing);
-    int size = element_length_in_bytes(temp);
+    int size = stealth_wire_length(temp);
     element_clear(temp);
     return size;
 }
 
+int stealth_element_size_G2(void) {
+    if (!library_initialized) return 0;
+    element_t temp;
+    element_init_G2(temp, pairing);
+    int size = stealth_wire_length(temp);
+    element_clear(temp);
+    return size;
+}
+
+int stealth_is_asymmetric(void) {
+    return library_initialized && asymmetric;
+}
+
 int stealth_element_size_Zr(void) {
     if (!library_initialized) return 0;
     element_t temp;
@@ -615,14 +2729,23 @@ int stealth_element_size_Zr(void) {
     return size;
 }
 
+int stealth_element_size_GT(void) {
+    if (!library_initialized) return 0;
+    element_t temp;
+    element_init_GT(temp, pairing);
+    int size = stealth_gt_compact_length(temp);
+    element_clear(temp);
+    return size;
+}
+
 /**
  * Serialize element to bytes
  */
 int stealth_element_to_bytes(element_t elem, unsigned char* buf, int buf_size) {
     if (!library_initialized) return -1;
-    int needed = element_length_in_bytes(elem);
+    int needed = stealth_wire_length(elem);
     if (needed > buf_size) return -1;
-    element_to_bytes(buf, elem);
+    stealth_wire_to_bytes(buf, elem);
     return needed;
 }
 
@@ -632,13 +2755,378 @@ int stealth_element_to_bytes(element_t elem, unsigned char* buf, int buf_size) {
 int stealth_element_from_bytes_G1(element_t elem, const unsigned char* buf, int len) {
     if (!library_initialized) return -1;
     element_init_G1(elem, pairing);
-    // Cast away const to match PBC library signature
-    return element_from_bytes(elem, (unsigned char*)buf);
+    return stealth_wire_from_bytes(elem, buf);
+}
+
+int stealth_element_from_bytes_G2(element_t elem, const unsigned char* buf, int len) {
+    if (!library_initialized) return -1;
+    element_init_G2(elem, pairing);
+    return stealth_wire_from_bytes(elem, buf);
 }
 
 int stealth_element_from_bytes_Zr(element_t elem, const unsigned char* buf, int len) {
     if (!library_initialized) return -1;
     element_init_Zr(elem, pairing);
     // Cast away const to match PBC library signature
-    return element_from_bytes(elem, (unsigned char*)buf);
-}
\ No newline at end of file
+    return prim_from_bytes(elem, (unsigned char*)buf);
+}
+
+//----------------------------------------------
+// Wire Format
+//----------------------------------------------
+
+// Flag byte value marking the point at infinity, which
+// element_to_bytes_compressed cannot represent
+#define POINT_INFINITY_FLAG 2
+
+static int is_wire_compressed(element_t elem) {
+    return point_format == STEALTH_POINT_COMPRESSED && library_initialized && elem->field == pairing->G1;
+}
+
+/**
+ * Select the G1 wire format
+ */
+int stealth_set_point_format(int format) {
+    if (format != STEALTH_POINT_UNCOMPRESSED && format != STEALTH_POINT_COMPRESSED) return -1;
+    point_format = format;
+    return 0;
+}
+
+int stealth_get_point_format(void) {
+    return point_format;
+}
+
+int stealth_set_validation(int mode) {
+    if (mode != STEALTH_VALIDATE_NONE && mode != STEALTH_VALIDATE_SUBGROUP) return -1;
+    validation = mode;
+    return 0;
+}
+
+int stealth_get_validation(void) {
+    return validation;
+}
+
+// Zr elements have nothing to check
+static int is_validated(element_t elem) {
+    return validation == STEALTH_VALIDATE_SUBGROUP && library_initialized &&
+           elem->field != pairing->Zr;
+}
+
+//----------------------------------------------
+// Hash Version
+//----------------------------------------------
+
+int stealth_set_hash_version(int version) {
+    if (version != STEALTH_HASH_G1_POW && version != STEALTH_HASH_G1_MAP) return -1;
+    if (version == STEALTH_HASH_G1_MAP && library_initialized &&
+        (!pairing->G1->from_hash || (asymmetric && !pairing->G2->from_hash))) return -1;
+    if (version != hash_version && h3_cache_live) hash_cache_set_capacity(&h3_cache, h3_cache_size);
+    hash_version = version;
+    return 0;
+}
+
+int stealth_get_hash_version(void) {
+    return hash_version;
+}
+
+//----------------------------------------------
+// Allocator
+//----------------------------------------------
+
+int stealth_set_allocator(int alloc) {
+    if (alloc != STEALTH_ALLOC_MALLOC && alloc != STEALTH_ALLOC_POOL) return -1;
+    if (alloc == STEALTH_ALLOC_MALLOC && pbc_pool_enabled()) return -1;
+    allocator = alloc;
+    return 0;
+}
+
+//----------------------------------------------
+// Pairing Autotuning
+//----------------------------------------------
+
+int stealth_set_autotune(int mode, const char* cache_file) {
+    if (mode != STEALTH_TUNE_OFF && mode != STEALTH_TUNE_ON) return -1;
+    return pairing_tune_enable(mode == STEALTH_TUNE_ON, cache_file);
+}
+
+int stealth_get_autotune(void) {
+    return pairing_tune_enabled() ? STEALTH_TUNE_ON : STEALTH_TUNE_OFF;
+}
+
+const char* stealth_get_tuning(void) {
+    return library_initialized ? tuning : NULL;
+}
+
+//----------------------------------------------
+// Pairing Preprocessing Cache
+//----------------------------------------------
+
+int stealth_set_pp_cache(int entries) {
+    if (entries < 0) return -1;
+    pp_cache_size = entries;
+    if (library_initialized && pp_cache_set_capacity(pp_cache, entries) != 0) return -1;
+    return 0;
+}
+
+void stealth_get_pp_cache_stats(unsigned long* hits, unsigned long* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (library_initialized) pp_cache_stats(pp_cache, hits, misses);
+}
+
+int stealth_set_verify_pp_cache(int entries) {
+    if (entries < 0) return -1;
+    verify_pp_cache_size = entries;
+    if (library_initialized && pp_cache_set_capacity(verify_pp_cache, entries) != 0) return -1;
+    return 0;
+}
+
+void stealth_get_verify_pp_cache_stats(unsigned long* hits, unsigned long* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (library_initialized) pp_cache_stats(verify_pp_cache, hits, misses);
+}
+
+//----------------------------------------------
+// Ephemeral Pool
+//----------------------------------------------
+
+int stealth_set_eph_pool(int entries) {
+    if (entries < 0) return -1;
+    eph_pool_size = entries;
+    if (!library_initialized) return 0;
+    eph_pools_stop();
+    return eph_pools_start();
+}
+
+void stealth_get_eph_pool_stats(unsigned long* hits, unsigned long* misses) {
+    unsigned long h[2] = { 0, 0 }, m[2] = { 0, 0 };
+    if (eph_pools_live) {
+        eph_pool_stats(&addr_pool, &h[0], &m[0]);
+        eph_pool_stats(&sign_pool, &h[1], &m[1]);
+    }
+    if (hits) *hits = h[0] + h[1];
+    if (misses) *misses = m[0] + m[1];
+}
+
+//----------------------------------------------
+// DSK Cache
+//----------------------------------------------
+
+int stealth_set_dsk_cache(int entries, double ttl_ms) {
+    if (entries < 0 || ttl_ms < 0) return -1;
+    dsk_cache_size = entries;
+    dsk_cache_ttl_ms = ttl_ms;
+    if (dsk_cache_live && dsk_cache_configure(&dsk_cache, entries, ttl_ms) != 0) return -1;
+    return 0;
+}
+
+void stealth_get_dsk_cache_stats(unsigned long* hits, unsigned long* misses,
+                                 unsigned long* evictions) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (evictions) *evictions = 0;
+    if (dsk_cache_live) dsk_cache_stats(&dsk_cache, hits, misses, evictions);
+}
+
+//----------------------------------------------
+// H3 Cache
+//----------------------------------------------
+
+int stealth_set_h3_cache(int entries) {
+    if (entries < 0) return -1;
+    h3_cache_size = entries;
+    if (h3_cache_live && hash_cache_set_capacity(&h3_cache, entries) != 0) return -1;
+    return 0;
+}
+
+void stealth_get_h3_cache_stats(unsigned long* hits, unsigned long* misses) {
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (h3_cache_live) hash_cache_stats(&h3_cache, hits, misses);
+}
+
+//----------------------------------------------
+// Seeded Random Mode
+//----------------------------------------------
+
+int stealth_set_random_seed(int enabled, unsigned int seed) {
+    return seeded_random_set(enabled, seed);
+}
+
+int stealth_get_random_seeded(void) {
+    return seeded_random_active();
+}
+
+//----------------------------------------------
+// Hardware Counters
+//----------------------------------------------
+
+int stealth_set_hw_counters(int enabled) {
+    return hwc_set_enabled(enabled);
+}
+
+//----------------------------------------------
+// Worker Placement
+//----------------------------------------------
+
+int stealth_set_worker_pinning(int enabled) {
+    cpu_topo_set_pinning(enabled);
+    node_tables = enabled && cpu_topo_nodes() > 1;
+    return cpu_topo_nodes();
+}
+
+int stealth_compact_length(element_t elem) {
+    return element_length_in_bytes_compressed(elem);
+}
+
+/**
+ * Serialize a point in the compact encoding
+ */
+int stealth_compact_to_bytes(unsigned char* buf, element_t elem) {
+    if (element_is0(elem)) {
+        int len = element_length_in_bytes_compressed(elem);
+        memset(buf, 0, len - 1);
+        buf[len - 1] = POINT_INFINITY_FLAG;
+        return len;
+    }
+    return prim_to_bytes_compressed(buf, elem);
+}
+
+/**
+ * Deserialize a point written by stealth_compact_to_bytes
+ */
+int stealth_compact_from_bytes(element_t elem, const unsigned char* buf) {
+    int len = element_length_in_bytes_compressed(elem);
+    if (buf[len - 1] == POINT_INFINITY_FLAG) {
+        element_set0(elem);
+        return len;
+    }
+    // Cast away const to match PBC library signature
+    return prim_from_bytes_compressed(elem, (unsigned char*)buf);
+}
+
+/**
+ * Deserialize n packed points in the compact encoding
+ */
+int stealth_compact_from_bytes_batch(element_t elems[], const unsigned char* buf, int n) {
+    if (n <= 0) return 0;
+    int len = element_length_in_bytes_compressed(elems[0]);
+    // The batch decoder knows nothing of the infinity flag
+    for (int i = 0; i < n; i++)
+        if (buf[(size_t)i * len + len - 1] == POINT_INFINITY_FLAG) {
+            for (int j = 0; j < n; j++) stealth_compact_from_bytes(elems[j], buf + (size_t)j * len);
+            return n * len;
+        }
+    element_from_bytes_compressed_batch(elems, (unsigned char*)buf, n);
+    return n * len;
+}
+
+// GT in F_q^k = F_q^(k/2)[u] for an even embedding degree k, the only
+// case with two coordinates
+static int gt_is_torus(element_t x) {
+    return element_item_count(x) == 2;
+}
+
+int stealth_gt_compact_length(element_t x) {
+    return gt_is_torus(x) ? element_length_in_bytes(element_item(x, 0))
+                          : element_length_in_bytes(x);
+}
+
+/**
+ * Serialize a GT element in the compact encoding: t = (1 + a) / b for
+ * x = a + b*u, 0 for x = 1
+ */
+int stealth_gt_compact_to_bytes(unsigned char* buf, element_t x) {
+    if (!gt_is_torus(x)) return prim_to_bytes(buf, x);
+    element_ptr a = element_item(x, 0);
+    element_ptr b = element_item(x, 1);
+    element_t t;
+    element_init_same_as(t, a);
+    if (!element_is0(b)) {
+        element_set1(t);
+        element_add(t, t, a);
+        element_div(t, t, b);
+    }
+    int len = prim_to_bytes(buf, t);
+    element_clear(t);
+    return len;
+}
+
+/**
+ * Deserialize a GT element written by stealth_gt_compact_to_bytes,
+ * x = (t + u) / (t - u)
+ */
+int stealth_gt_compact_from_bytes(element_t x, const unsigned char* buf) {
+    int len;
+    if (!gt_is_torus(x)) {
+        len = prim_from_bytes(x, (unsigned char*)buf);
+    } else {
+        element_t den;
+        element_init_same_as(den, x);
+        element_set1(x);
+        len = prim_from_bytes(element_item(x, 0), (unsigned char*)buf);
+        if (!element_is0(element_item(x, 0))) {
+            element_set1(element_item(x, 1));
+            element_set(element_item(den, 0), element_item(x, 0));
+            element_set1(element_item(den, 1));
+            element_neg(element_item(den, 1), element_item(den, 1));
+            element_div(x, x, den);
+        }
+        element_clear(den);
+    }
+    if (is_validated(x) && !element_is_in_subgroup(x)) {
+        element_set1(x);
+        return -1;
+    }
+    return len;
+}
+
+int stealth_wire_length(element_t elem) {
+    return is_wire_compressed(elem) ? element_length_in_bytes_compressed(elem)
+                                    : element_length_in_bytes(elem);
+}
+
+/**
+ * Serialize an element in the current wire format
+ */
+int stealth_wire_to_bytes(unsigned char* buf, element_t elem) {
+    if (!is_wire_compressed(elem)) return prim_to_bytes(buf, elem);
+    return stealth_compact_to_bytes(buf, elem);
+}
+
+/**
+ * Deserialize an element written by stealth_wire_to_bytes
+ */
+static int wire_decode(element_t elem, const unsigned char* buf) {
+    if (!is_wire_compressed(elem)) return prim_from_bytes(elem, (unsigned char*)buf);
+    return stealth_compact_from_bytes(elem, buf);
+}
+
+int stealth_wire_from_bytes(element_t elem, const unsigned char* buf) {
+    int len = wire_decode(elem, buf);
+    if (is_validated(elem) && !element_is_in_subgroup(elem)) {
+        element_set0(elem);
+        return -1;
+    }
+    return len;
+}
+
+/**
+ * Deserialize n packed elements in the current wire format
+ */
+int stealth_wire_from_bytes_batch(element_t elems[], const unsigned char* buf, int n) {
+    if (n <= 0) return 0;
+    int len = stealth_wire_length(elems[0]);
+    if (is_wire_compressed(elems[0])) stealth_compact_from_bytes_batch(elems, buf, n);
+    else for (int i = 0; i < n; i++) wire_decode(elems[i], buf + (size_t)i * len);
+    if (!is_validated(elems[0])) return n * len;
+
+    char* ok = malloc(n);
+    if (!ok) return -1;
+    int valid = element_is_in_subgroup_batch(ok, elems, n);
+    for (int i = 0; valid < n && i < n; i++)
+        if (!ok[i]) element_set0(elems[i]);
+    free(ok);
+    return valid < n ? -1 : n * len;
+}
@@ -8,6 +8,159 @@
 
 #include <pbc/pbc.h>
 
+/**
+ * Window size (bits) of the fixed-base table built for the generator g in
+ * stealth_init. Every g^x goes through this table; each extra bit doubles
+ * the table size. Set to 0 to fall back to plain element_pow_zn.
+ */
+#ifndef STEALTH_G_PP_WINDOW
+#define STEALTH_G_PP_WINDOW 5
+#endif
+
+/**
+ * Teeth of the comb tables (PBC_PP_COMB2) built for A_r and B_r in a
+ * recipient context: 2 (2^k - 1) points each, against about a thousand
+ * for the windowed table of g, for a power about 10% slower. Keeps a
+ * sender's cache of many recipients small. Set to 0 for windowed tables.
+ */
+#ifndef STEALTH_RECIPIENT_PP_TEETH
+#define STEALTH_RECIPIENT_PP_TEETH 6
+#endif
+
+/**
+ * Number of initialized pairings kept by stealth_init, keyed by parameter
+ * file path and content hash. Re-initializing with a cached file just
+ * switches to it; the least recently used entry is dropped when full.
+ */
+#ifndef STEALTH_PAIRING_CACHE_SIZE
+#define STEALTH_PAIRING_CACHE_SIZE 4
+#endif
+
+/**
+ * Length (bytes) of the view tag emitted by stealth_addr_gen_tagged.
+ * A tag is a hash of the shared point A^r = R1^a, so a scanner can
+ * reject an output right after R1^a and skip the B^r2 exponentiation;
+ * a foreign output survives the tag check with probability 2^(-8 * len).
+ */
+#ifndef STEALTH_VIEW_TAG_LEN
+#define STEALTH_VIEW_TAG_LEN 2
+#endif
+
+/**
+ * Largest window for the per-output R1 table of stealth_recognize_multi.
+ * The table holds (bits / k) * 2^k elements.
+ */
+#ifndef STEALTH_MULTI_MAX_WINDOW
+#define STEALTH_MULTI_MAX_WINDOW 8
+#endif
+
+/**
+ * Outputs from which stealth_addr_gen_multi builds a table for its
+ * shared pairing value e(R1, TK) instead of raising it to each r2 plainly.
+ */
+#ifndef STEALTH_ADDR_MULTI_PP_MIN
+#define STEALTH_ADDR_MULTI_PP_MIN 32
+#endif
+
+/**
+ * Exponentiations by secrets (the keys aZ, bZ and kZ, the one-time key
+ * exponent and the signing nonce) go through element_pow_zn_ct, whose
+ * operations do not depend on the exponent bits. This bypasses the
+ * tables for g and e(g, g2) and the R1 tables of stealth_recognize_multi
+ * for them. Set to 0 for the variable-time paths.
+ */
+#ifndef STEALTH_SECRET_CT
+#define STEALTH_SECRET_CT 1
+#endif
+
+/**
+ * Pairings per pairing_apply_batch call in stealth_trace_batch, which
+ * share the inversions of their final exponentiations.
+ */
+#ifndef STEALTH_TRACE_CHUNK
+#define STEALTH_TRACE_CHUNK 32
+#endif
+
+/**
+ * Outputs per element_pow_mpz_same call in stealth_scan_batch and the
+ * stealth_ctx_scan workers, which raises every R1 to the view key a in
+ * one pass. Only the variable-time build (STEALTH_SECRET_CT 0) uses it;
+ * by default each R1^a is its own constant-time power, and the chunk
+ * only groups the decoding and the subgroup checks.
+ */
+#ifndef STEALTH_SCAN_CHUNK
+#define STEALTH_SCAN_CHUNK 64
+#endif
+
+/**
+ * Outputs from which a scan without view tags (stealth_scan_batch, and
+ * each worker of stealth_ctx_scan) builds a comb table for B, with
+ * STEALTH_RECIPIENT_PP_TEETH teeth, for the B^r2 of every output.
+ */
+#ifndef STEALTH_SCAN_PP_MIN
+#define STEALTH_SCAN_PP_MIN 16
+#endif
+
+/**
+ * Default number of pairing tables kept per pairing for the left
+ * argument R1 of stealth_trace, stealth_trace_batch and
+ * stealth_addr_recognize, see stealth_set_pp_cache. 0 disables the cache.
+ */
+#ifndef STEALTH_PP_CACHE_SIZE
+#define STEALTH_PP_CACHE_SIZE 0
+#endif
+
+/**
+ * Default number of pairing tables kept per pairing for the commitments C
+ * of verified addresses, see stealth_set_verify_pp_cache. 0 disables the
+ * cache.
+ */
+#ifndef STEALTH_VERIFY_PP_CACHE_SIZE
+#define STEALTH_VERIFY_PP_CACHE_SIZE 0
+#endif
+
+/**
+ * Default number of precomputed ephemerals kept ready for address
+ * generation and for signing, see stealth_set_eph_pool. 0 disables the pools.
+ */
+#ifndef STEALTH_EPH_POOL_SIZE
+#define STEALTH_EPH_POOL_SIZE 0
+#endif
+
+/**
+ * Default number of one-time secret keys kept for stealth_sign_cached, and
+ * their lifetime in ms, see stealth_set_dsk_cache. 0 entries disables the cache.
+ */
+#ifndef STEALTH_DSK_CACHE_SIZE
+#define STEALTH_DSK_CACHE_SIZE 0
+#endif
+#ifndef STEALTH_DSK_CACHE_TTL_MS
+#define STEALTH_DSK_CACHE_TTL_MS 60000
+#endif
+
+/**
+ * Default number of mapped H3(Addr) values kept under STEALTH_HASH_G1_MAP,
+ * see stealth_set_h3_cache. 0 disables the cache.
+ */
+#ifndef STEALTH_H3_CACHE_SIZE
+#define STEALTH_H3_CACHE_SIZE 256
+#endif
+
+/**
+ * Bits of the per-signature weights of an aggregate, see stealth_aggregate.
+ * A multiple of 8 up to 256.
+ */
+#ifndef STEALTH_AGGREGATE_WEIGHT_BITS
+#define STEALTH_AGGREGATE_WEIGHT_BITS 128
+#endif
+
+/**
+ * Outputs in flight in a stealth_ingest pipeline, shared by its queues.
+ */
+#ifndef STEALTH_INGEST_QUEUE_LEN
+#define STEALTH_INGEST_QUEUE_LEN 64
+#endif
+
 //----------------------------------------------
 // Performance Statistics Structure
 //----------------------------------------------
@@ -22,12 +175,57 @@ typedef struct {
     int operation_count;
 } stealth_performance_t;
 
+// Operations with a latency histogram, in stealth_performance_t order
+#define STEALTH_LATENCY_OPS 7
+
+// Latency of one operation over every call since the last reset
+typedef struct {
+    unsigned long count;
+    double mean_ms;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+} stealth_latency_t;
+
+//----------------------------------------------
+// Recipient Context
+//----------------------------------------------
+
+/**
+ * Per-recipient precomputation for senders that pay the same
+ * recipient repeatedly: fixed-base tables for A_r and B_r (see
+ * STEALTH_RECIPIENT_PP_TEETH) and a
+ * pairing table for TK, or the pairing value e(g, TK) itself under an
+ * asymmetric pairing. Built by stealth_recipient_ctx_init.
+ */
+typedef struct {
+    element_t A_r;
+    element_t B_r;
+    element_t TK;
+    element_pp_t A_pp;
+    element_pp_t B_pp;
+    pairing_pp_t TK_pp;          // symmetric pairings
+    element_t eg_TK;             // asymmetric pairings
+    int tk_borrowed;             // TK_pp belongs to another context
+} stealth_recipient_ctx_t;
+
 //----------------------------------------------
 // Library Management Functions
 //----------------------------------------------
 
 /**
  * Initialize the library with a parameter file
+ * A file seen before (same path and contents) reuses its cached pairing,
+ * generator and precomputed tables.
+ *
+ * The parameter set also selects the group layout. Under a symmetric
+ * pairing (types A, A1, E) every element lies in G1. Under an asymmetric
+ * one (types D, F, G, e.g. d224.param or f.param), G1 is the small group
+ * over the base field: keys A and B, R1, C and Addr stay there, so
+ * addresses are shorter and scanning works in G1 alone, while TK, R2,
+ * one-time keys and signatures move to G2, with generator g2 hashed
+ * from g.
  * @param param_file Path to the PBC parameter file
  * @return 0 on success, -1 on failure
  */
@@ -45,7 +243,7 @@ int stealth_is_initialized(void);
 void stealth_cleanup(void);
 
 /**
- * Reset performance counters
+ * Reset performance counters and latency histograms
  */
 void stealth_reset_performance(void);
 
@@ -60,6 +258,20 @@ extern int perf_counter;
  */
 pairing_t* stealth_get_pairing(void);
 
+/**
+ * Copy the generator g chosen by stealth_init
+ * @param out G1 element (output)
+ */
+void stealth_get_generator(element_t out);
+
+/**
+ * Replace the generator g and rebuild its precomputed tables, so keys
+ * saved under an earlier session stay valid after a restart
+ * @param new_g G1 element, e.g. read back with stealth_get_generator
+ * @return 0 on success, -1 if not initialized
+ */
+int stealth_set_generator(element_t new_g);
+
 //----------------------------------------------
 // Core Cryptographic Functions
 //----------------------------------------------
@@ -75,7 +287,7 @@ void stealth_keygen(element_t A, element_t B, element_t aZ, element_t bZ);
 
 /**
  * Generate trace key (TK, k)
- * @param TK Trace public key (output)
+ * @param TK Trace public key, G2 (output)
  * @param kZ Trace private key (output)
  */
 void stealth_tracekeygen(element_t TK, element_t kZ);
@@ -84,7 +296,7 @@ void stealth_tracekeygen(element_t TK, element_t kZ);
  * Generate one-time address
  * @param Addr Generated address (output)
  * @param R1 Random element R1 (output)
- * @param R2 Random element R2 (output)
+ * @param R2 Random element R2, G2 (output)
  * @param C Commitment C (output)
  * @param A_r Public key A
  * @param B_r Public key B
@@ -93,6 +305,188 @@ void stealth_tracekeygen(element_t TK, element_t kZ);
 void stealth_addr_gen(element_t Addr, element_t R1, element_t R2, element_t C,
                      element_t A_r, element_t B_r, element_t TK);
 
+/**
+ * Generate one-time address together with its view tag
+ * @param Addr Generated address (output)
+ * @param R1 Random element R1 (output)
+ * @param R2 Random element R2 (output)
+ * @param C Commitment C (output)
+ * @param view_tag STEALTH_VIEW_TAG_LEN bytes, stored with the address (output)
+ * @param A_r Public key A
+ * @param B_r Public key B
+ * @param TK Trace public key
+ */
+void stealth_addr_gen_tagged(element_t Addr, element_t R1, element_t R2, element_t C,
+                             unsigned char* view_tag, element_t A_r, element_t B_r,
+                             element_t TK);
+
+/**
+ * Generate a block of addresses across worker threads.
+ * Address i goes to the recipient (A_r[i], B_r[i]). With more than one
+ * thread every worker draws from its own operating system random source
+ * (pbc_random_ctx_bind), since the global source is not thread-safe.
+ * @param Addr, R1, R2, C Arrays of n initialized elements (output)
+ * @param view_tags n * STEALTH_VIEW_TAG_LEN bytes of view tags (output),
+ *                  NULL to generate untagged addresses
+ * @param A_r, B_r Arrays of n recipient public keys
+ * @param TK Trace public key
+ * @param n Number of addresses
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @return n on success, -1 on error
+ */
+int stealth_addr_gen_block(element_t Addr[], element_t R1[], element_t R2[], element_t C[],
+                           unsigned char* view_tags, element_t A_r[], element_t B_r[],
+                           element_t TK, int n, int num_threads);
+
+/**
+ * Generate the n outputs of one transaction on a single ephemeral r,
+ * shared by every output like a transaction public key: R1 = g^r is
+ * computed once, the shares A_r[i]^r are taken in chunks of
+ * STEALTH_SCAN_CHUNK on one exponent, and e(R1, TK) is the only pairing,
+ * each output raising it to its own r2 (equal to the e(R2, TK)^r of
+ * stealth_addr_gen). Outputs come out as from stealth_addr_gen and are
+ * recognized, opened, signed and traced the same way; outputs that share
+ * R1 also share their pairing table under stealth_set_pp_cache. The
+ * recipients are split over worker threads after the shared part, which
+ * draws from the calling thread's random source.
+ * Two outputs to the same A_r would share the same r2 and so the same R2;
+ * such a transaction is refused.
+ * @param Addr, R2, C Arrays of n initialized elements (output)
+ * @param R1 The shared R1 (output)
+ * @param view_tags n * STEALTH_VIEW_TAG_LEN bytes of view tags (output),
+ *                  NULL to generate untagged addresses
+ * @param A_r, B_r Arrays of n recipient public keys, no A_r twice
+ * @param TK Trace public key
+ * @param n Number of outputs
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @return n on success, -1 on error or a repeated recipient
+ */
+int stealth_addr_gen_multi(element_t Addr[], element_t R1, element_t R2[], element_t C[],
+                           unsigned char* view_tags, element_t A_r[], element_t B_r[],
+                           element_t TK, int n, int num_threads);
+
+/**
+ * Derive a view tag from the serialized shared point (A^r or R1^a).
+ * Pure function, safe to call from any thread.
+ * @param view_tag STEALTH_VIEW_TAG_LEN bytes (output)
+ * @param shared_bytes element_to_bytes encoding of the shared point
+ * @param len Length of shared_bytes
+ */
+void stealth_view_tag_from_bytes(unsigned char* view_tag, const unsigned char* shared_bytes,
+                                 size_t len);
+
+/**
+ * x[i] = a[i]^n for m bases and one secret exponent n: one constant-time
+ * exponentiation per base under STEALTH_SECRET_CT, otherwise a single
+ * shared recoding of n (element_pow_mpz_same). Safe to call from any thread.
+ */
+void stealth_secret_pow_mpz_same(element_t x[], element_t a[], mpz_t n, int m);
+
+/**
+ * Initialize a recipient context (copies the keys and builds the tables)
+ * @param ctx Context to initialize (output)
+ * @param A_r Public key A
+ * @param B_r Public key B
+ * @param TK Trace public key
+ * @return 0 on success, -1 on failure
+ */
+int stealth_recipient_ctx_init(stealth_recipient_ctx_t* ctx, element_t A_r,
+                               element_t B_r, element_t TK);
+
+/**
+ * Store kind of the files written by stealth_tk_table_store_open
+ */
+#define STEALTH_STORE_TK_TABLES 5
+
+/**
+ * Open (or create) a store of TK pairing tables, one record per trace
+ * key: TK followed by its table as pairing_pp_to_bytes writes it
+ * @param path File path, kept next to the key material
+ * @return Store handle (>= 0), -1 on error or if the pairing cannot
+ *         serialize its tables, -2 if the file was written under other parameters
+ */
+int stealth_tk_table_store_open(const char* path);
+
+/**
+ * Same as stealth_recipient_ctx_init, but the pairing table for TK is read
+ * in place from the store's mapping when the store holds one for TK, and
+ * is built and appended to it otherwise. Cold starts skip rebuilding the
+ * tables of long-lived trace keys.
+ * @param ctx Context to initialize (output)
+ * @param A_r Public key A
+ * @param B_r Public key B
+ * @param TK Trace public key
+ * @param store Handle from stealth_tk_table_store_open, or -1 to build the table
+ * @return 0 if the table was read from the store, 1 if it was built, -1 on failure
+ */
+int stealth_recipient_ctx_init_stored(stealth_recipient_ctx_t* ctx, element_t A_r,
+                                      element_t B_r, element_t TK, int store);
+
+/**
+ * Length in bytes of the fixed-base tables of a recipient, as
+ * stealth_recipient_tables_to_bytes writes them; the same for every key of
+ * the active pairing
+ * @return Length, 0 if the library is not initialized
+ */
+int stealth_recipient_tables_length(void);
+
+/**
+ * Build the fixed-base tables for A_r and B_r of a recipient context and
+ * write them, to be kept with the keys and read back by
+ * stealth_recipient_ctx_init_tables
+ * @param out stealth_recipient_tables_length() bytes (output)
+ * @param A_r Public key A
+ * @param B_r Public key B
+ * @return Bytes written, 0 on failure
+ */
+int stealth_recipient_tables_to_bytes(unsigned char* out, element_t A_r, element_t B_r);
+
+/**
+ * Same as stealth_recipient_ctx_init, but the tables for A_r and B_r are
+ * read from 'tables' instead of built, and the TK part may be shared: a
+ * server holding thousands of keys under one trace key keeps one pairing
+ * table for TK rather than one per key.
+ * @param ctx Context to initialize (output)
+ * @param A_r Public key A
+ * @param B_r Public key B
+ * @param TK Trace public key
+ * @param tables Output of stealth_recipient_tables_to_bytes for A_r and B_r,
+ *               NULL to build the tables
+ * @param tk_from Context for the same TK whose pairing table ctx borrows,
+ *                NULL to build its own; must outlive ctx
+ * @return 0 on success, -1 on failure or if 'tables' holds no tables
+ */
+int stealth_recipient_ctx_init_tables(stealth_recipient_ctx_t* ctx, element_t A_r,
+                                      element_t B_r, element_t TK,
+                                      const unsigned char* tables,
+                                      stealth_recipient_ctx_t* tk_from);
+
+/**
+ * Release a recipient context
+ * @param ctx Context built by stealth_recipient_ctx_init
+ */
+void stealth_recipient_ctx_clear(stealth_recipient_ctx_t* ctx);
+
+/**
+ * Generate one-time address for a cached recipient.
+ * Same output as stealth_addr_gen, using the context tables for
+ * A_r^r, B_r^r2 and e(R2, TK).
+ * @param Addr Generated address (output)
+ * @param R1 Random element R1 (output)
+ * @param R2 Random element R2 (output)
+ * @param C Commitment C (output)
+ * @param ctx Recipient context
+ */
+void stealth_addr_gen_ctx(element_t Addr, element_t R1, element_t R2, element_t C,
+                          stealth_recipient_ctx_t* ctx);
+
+/**
+ * Same as stealth_addr_gen_ctx, with the view tag of stealth_addr_gen_tagged
+ * @param view_tag STEALTH_VIEW_TAG_LEN bytes, stored with the address (output)
+ */
+void stealth_addr_gen_tagged_ctx(element_t Addr, element_t R1, element_t R2, element_t C,
+                                 unsigned char* view_tag, stealth_recipient_ctx_t* ctx);
+
 /**
  * Recognize address (full version)
  * @param Addr Address to recognize
@@ -107,6 +501,25 @@ void stealth_addr_gen(element_t Addr, element_t R1, element_t R2, element_t C,
 int stealth_addr_recognize(element_t Addr, element_t R1, element_t B_r,
                           element_t A_r, element_t C, element_t aZ, element_t TK);
 
+/**
+ * Audit n addresses generated for one key pair: each must pass
+ * stealth_addr_recognize and also carry R2 = g2^r2. The pairing of each
+ * address is hashed, so it stays one per address, but the pairings of a
+ * chunk share their final exponentiations. The equations C = B^r2 and
+ * R2 = g2^r2 are checked for the whole set at once with random small
+ * scalars (batch_check.h) and bisected when that check fails, in place
+ * of two exponentiations per address.
+ * @param Addr, R1, R2, C Arrays of n address components
+ * @param B_r Public key B
+ * @param aZ Private key a
+ * @param TK Trace public key
+ * @param results Per-address result, 1 if well formed, 0 otherwise (output, n bytes)
+ * @return Number of well-formed addresses, -1 on error
+ */
+int stealth_addr_audit_batch(element_t Addr[], element_t R1[], element_t R2[], element_t C[],
+                             int n, element_t B_r, element_t aZ, element_t TK,
+                             unsigned char* results);
+
 /**
  * Fast address recognition
  * @param R1 Random element R1
@@ -119,9 +532,162 @@ int stealth_addr_recognize(element_t Addr, element_t R1, element_t B_r,
 int stealth_addr_recognize_fast(element_t R1, element_t B_r, element_t A_r, 
                                element_t C, element_t aZ);
 
+/**
+ * Fast address recognition with a view tag prefilter.
+ * Outputs whose tag does not match R1^a are rejected without the
+ * B^r2 exponentiation and comparison.
+ * @param R1 Random element R1
+ * @param B_r Public key B
+ * @param C Commitment C
+ * @param view_tag STEALTH_VIEW_TAG_LEN bytes from stealth_addr_gen_tagged
+ * @param aZ Private key a
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_addr_recognize_fast_tagged(element_t R1, element_t B_r, element_t C,
+                                       const unsigned char* view_tag, element_t aZ);
+
+/**
+ * Fast address recognition for a key with a recipient context: B_r^r2'
+ * through its fixed-base table
+ * @param R1 Random element R1
+ * @param C Commitment C
+ * @param view_tag Tag from stealth_addr_gen_tagged, NULL if untagged
+ * @param aZ Private key a
+ * @param ctx Recipient context of the key
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_addr_recognize_fast_ctx(element_t R1, element_t C, const unsigned char* view_tag,
+                                    element_t aZ, stealth_recipient_ctx_t* ctx);
+
+/**
+ * Fast address recognition against C as received, in the wire format.
+ * Only equality matters, so B^r2' is serialized and compared with the
+ * bytes, and C is never decoded or validated: encodings are unique and
+ * B^r2' lies in the group, so a C outside it, or not canonically
+ * encoded, never matches.
+ * @param R1 Random element R1
+ * @param B_r Public key B
+ * @param C_bytes Commitment C, stealth_wire_length bytes of G1
+ * @param view_tag Tag from stealth_addr_gen_tagged, NULL if untagged
+ * @param aZ Private key a
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_addr_recognize_fast_bytes(element_t R1, element_t B_r, const unsigned char* C_bytes,
+                                      const unsigned char* view_tag, element_t aZ);
+
+/**
+ * stealth_addr_recognize_fast_bytes through a recipient context
+ */
+int stealth_addr_recognize_fast_ctx_bytes(element_t R1, const unsigned char* C_bytes,
+                                          const unsigned char* view_tag, element_t aZ,
+                                          stealth_recipient_ctx_t* ctx);
+
+/**
+ * stealth_addr_recognize_fast_bytes against C in the compact encoding
+ * (stealth_compact_to_bytes) whatever the wire format, as address store
+ * records keep it
+ * @param C_compact Commitment C, stealth_compact_length bytes
+ */
+int stealth_addr_recognize_fast_compact(element_t R1, element_t B_r, const unsigned char* C_compact,
+                                        const unsigned char* view_tag, element_t aZ);
+
+/**
+ * stealth_addr_recognize_fast_compact through a recipient context
+ */
+int stealth_addr_recognize_fast_ctx_compact(element_t R1, const unsigned char* C_compact,
+                                            const unsigned char* view_tag, element_t aZ,
+                                            stealth_recipient_ctx_t* ctx);
+
+/**
+ * Batch fast address recognition for wallet scanning.
+ * Checks n outputs (R1[i], C[i]) against one key, reusing the same
+ * scratch elements for H1 and B^r2 across the whole batch; the powers
+ * R1[i]^a are taken STEALTH_SCAN_CHUNK at a time.
+ * @param R1 Array of n R1 components
+ * @param C Array of n C components
+ * @param n Number of outputs
+ * @param B_r Public key B
+ * @param aZ Private key a
+ * @param out_bitmap Match bitmap, at least (n+7)/8 bytes (output);
+ *                   bit (i % 8) of byte i/8 is set if output i matches
+ * @return Number of matching outputs
+ */
+int stealth_scan_batch(element_t R1[], element_t C[], int n, element_t B_r,
+                       element_t aZ, unsigned char* out_bitmap);
+
+/**
+ * Batch fast address recognition with view tag prefilter.
+ * Same as stealth_scan_batch, but outputs whose tag does not match are
+ * rejected before the B^r2 exponentiation.
+ * @param R1 Array of n R1 components
+ * @param C Array of n C components
+ * @param view_tags n concatenated tags, STEALTH_VIEW_TAG_LEN bytes each;
+ *                  NULL scans without the prefilter
+ * @param n Number of outputs
+ * @param B_r Public key B
+ * @param aZ Private key a
+ * @param out_bitmap Match bitmap, at least (n+7)/8 bytes (output)
+ * @return Number of matching outputs
+ */
+int stealth_scan_batch_tagged(element_t R1[], element_t C[], const unsigned char* view_tags,
+                              int n, element_t B_r, element_t aZ, unsigned char* out_bitmap);
+
+/**
+ * Same as stealth_scan_batch_tagged with the commitments compared in the
+ * wire format, as in stealth_addr_recognize_fast_bytes
+ * @param C_bytes n concatenated C components, G1 wire size each
+ */
+int stealth_scan_batch_bytes(element_t R1[], const unsigned char* C_bytes,
+                             const unsigned char* view_tags, int n, element_t B_r,
+                             element_t aZ, unsigned char* out_bitmap);
+
+/**
+ * Same as stealth_scan_batch_bytes with the commitments in the compact
+ * encoding, as in stealth_addr_recognize_fast_compact
+ * @param C_compact n concatenated C components, stealth_compact_length each
+ */
+int stealth_scan_batch_compact(element_t R1[], const unsigned char* C_compact,
+                               const unsigned char* view_tags, int n, element_t B_r,
+                               element_t aZ, unsigned char* out_bitmap);
+
+/**
+ * Multi-key recognition: find which of n wallets owns one output.
+ * R1 is the common base of every R1^(a_i), so once n is large enough a
+ * fixed-base table for R1 is built and shared across the keys; its
+ * window grows with n (capped at STEALTH_MULTI_MAX_WINDOW).
+ * Performance counters are not updated.
+ * @param R1 Random element R1 of the output
+ * @param C Commitment C of the output
+ * @param view_tag Tag from stealth_addr_gen_tagged, NULL if untagged
+ * @param aZ Array of n private keys a_i
+ * @param B_r Array of n public keys B_i
+ * @param n Number of keys
+ * @return Index of the first matching key, -1 if none
+ */
+int stealth_recognize_multi(element_t R1, element_t C, const unsigned char* view_tag,
+                            element_t aZ[], element_t B_r[], int n);
+
+/**
+ * Find the owner among k key pairs of each of n outputs, the outputs split
+ * across worker threads (stealth_recognize_multi per output).
+ * @param R1, C Arrays of n output components
+ * @param view_tags n * STEALTH_VIEW_TAG_LEN bytes of view tags, NULL if untagged
+ * @param tagged One byte per output, nonzero if its view tag is set; NULL
+ *               when view_tags covers every output
+ * @param n Number of outputs
+ * @param aZ, B_r Arrays of k private keys a_i and public keys B_i
+ * @param k Number of key pairs
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param owners Per-output index of the owning key, -1 if none (output, n ints)
+ * @return Number of owned outputs, -1 on error
+ */
+int stealth_recognize_multi_block(element_t R1[], element_t C[], const unsigned char* view_tags,
+                                  const unsigned char* tagged, int n, element_t aZ[],
+                                  element_t B_r[], int k, int num_threads, int* owners);
+
 /**
  * Generate one-time secret key
- * @param dsk One-time secret key (output)
+ * @param dsk One-time secret key, G2 (output)
  * @param Addr Address
  * @param R1 Random element R1
  * @param aZ Private key a
@@ -130,9 +696,65 @@ int stealth_addr_recognize_fast(element_t R1, element_t B_r, element_t A_r,
 void stealth_onetime_skgen(element_t dsk, element_t Addr, element_t R1,
                           element_t aZ, element_t bZ);
 
+/**
+ * Fast recognition followed, for an owned output, by its one-time key.
+ * The key reuses the r2 = H1(R1^a) of recognition, where separate calls
+ * to stealth_addr_recognize_fast and stealth_onetime_skgen would compute
+ * R1^a and H1 twice.
+ * @param dsk One-time secret key, G2, set only if recognized (output)
+ * @param Addr Address
+ * @param R1 Random element R1
+ * @param B_r Public key B
+ * @param C Commitment C
+ * @param view_tag Tag from stealth_addr_gen_tagged, NULL if untagged
+ * @param aZ Private key a
+ * @param bZ Private key b
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_recognize_and_derive(element_t dsk, element_t Addr, element_t R1, element_t B_r,
+                                 element_t C, const unsigned char* view_tag,
+                                 element_t aZ, element_t bZ);
+
+/**
+ * Called by stealth_ingest for each owned output, in stream order
+ * @param arg Argument given to stealth_ingest
+ * @param index Position of the output in the stream
+ * @param dsk One-time secret key of the output, valid during the call
+ */
+typedef void (*stealth_ingest_fn)(void* arg, int index, element_t dsk);
+
+/**
+ * Bytes per record of a stealth_ingest stream: Addr || R1 || C in the
+ * wire format, followed by a STEALTH_VIEW_TAG_LEN byte tag when tagged
+ */
+int stealth_ingest_record_length(int tagged);
+
+/**
+ * Streaming block ingest for a wallet. The outputs pass through three
+ * stages, each on its own thread: parse, recognize, and for matches only
+ * one-time key derivation. The stages are joined by bounded queues
+ * holding at most STEALTH_INGEST_QUEUE_LEN outputs, so they overlap and
+ * memory does not grow with n. Recognition hands r2 = H1(R1^a) on to the
+ * last stage, which derives dsk = H3(Addr)^(b*r2) without repeating
+ * R1^a and H1 as stealth_onetime_skgen would. Runs the stages one after
+ * another if a thread cannot be started. Performance counters are not
+ * updated.
+ * @param records n records of stealth_ingest_record_length(tagged) bytes
+ * @param n Number of outputs
+ * @param tagged Records carry view tags, checked before B^r2
+ * @param B_r Public key B
+ * @param aZ Private key a
+ * @param bZ Private key b
+ * @param fn Receives each owned output and its key
+ * @param arg Passed to fn
+ * @return Number of owned outputs, -1 on error
+ */
+int stealth_ingest(const unsigned char* records, int n, int tagged, element_t B_r,
+                   element_t aZ, element_t bZ, stealth_ingest_fn fn, void* arg);
+
 /**
  * Sign a message
- * @param Q_sigma Signature component (output)
+ * @param Q_sigma Signature component, G2 (output)
  * @param hZ Hash value (output)
  * @param Addr Address
  * @param dsk One-time secret key
@@ -141,6 +763,27 @@ void stealth_onetime_skgen(element_t dsk, element_t Addr, element_t R1,
 void stealth_sign(element_t Q_sigma, element_t hZ, element_t Addr, 
                  element_t dsk, const char* msg);
 
+/**
+ * Sign for an address from its key pair, as stealth_onetime_skgen then
+ * stealth_sign, through the DSK cache (see stealth_set_dsk_cache): an
+ * address signing again within the cache lifetime skips the key
+ * derivation, and from its second signature raises its DSK through a
+ * comb table. Entries are found by id and checked against a digest of
+ * Addr, R1, a and b, so a stale id only misses.
+ * @param Q_sigma Signature component, G2 (output)
+ * @param hZ Hash value (output)
+ * @param dsk One-time secret key signed with (output)
+ * @param id Caller's id of the address, e.g. its index in a store
+ * @param Addr Address
+ * @param R1 Random element R1 of the address
+ * @param aZ Secret key a
+ * @param bZ Secret key b
+ * @param msg Message to sign
+ */
+void stealth_sign_cached(element_t Q_sigma, element_t hZ, element_t dsk, long id,
+                         element_t Addr, element_t R1, element_t aZ, element_t bZ,
+                         const char* msg);
+
 /**
  * Verify a signature
  * @param Addr Address
@@ -154,6 +797,65 @@ void stealth_sign(element_t Q_sigma, element_t hZ, element_t Addr,
 int stealth_verify(element_t Addr, element_t R2, element_t C,
                   const char* msg, element_t hZ, element_t Q_sigma);
 
+/**
+ * Verify a block of signatures, e.g. all spends in a ledger block.
+ * Splits the n signatures into contiguous ranges, one per thread, each
+ * running the same check as stealth_verify. Performance counters are
+ * not updated.
+ * @param Addr Array of n addresses
+ * @param R2 Array of n R2 components
+ * @param C Array of n C components
+ * @param msgs Array of n messages
+ * @param hZ Array of n hash values
+ * @param Q_sigma Array of n signature components
+ * @param n Number of signatures
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param results Per-signature result, 1 if valid, 0 otherwise (output, n bytes)
+ * @return Number of valid signatures, -1 on error
+ */
+int stealth_verify_block(element_t Addr[], element_t R2[], element_t C[],
+                         const char* msgs[], element_t hZ[], element_t Q_sigma[],
+                         int n, int num_threads, unsigned char* results);
+
+/**
+ * Aggregate a block of signatures into one, e.g. by the producer of a
+ * ledger block. h is a hash of the signer's commitment X = e(g, g2)^x, so
+ * the aggregate keeps the commitments in place of the h values, which
+ * the verifier rehashes, and folds the Q_sigma values into
+ * Q_agg = prod Q_sigma_i^z_i, with weights z_i derived from the whole
+ * block (STEALTH_AGGREGATE_WEIGHT_BITS each). Each signature is verified
+ * first, as in stealth_verify_block, which recomputes its commitment.
+ * Nothing is aggregated when one of them fails.
+ * @param XGT Commitment of each signature, GT (output, n elements)
+ * @param Q_agg Aggregate of the Q_sigma values (output)
+ * @param Addr, C, msgs, hZ, Q_sigma Arrays of n addresses, C components,
+ *        messages and signatures
+ * @param num_threads Worker threads for the verification, 0 for one per core
+ * @param results Per-signature result, 1 if valid, 0 otherwise (output, n bytes)
+ * @return n once aggregated, the number of valid signatures if some failed,
+ *         -1 on error
+ */
+int stealth_aggregate(element_t XGT[], element_t Q_agg, element_t Addr[], element_t C[],
+                      const char* msgs[], element_t hZ[], element_t Q_sigma[],
+                      int n, int num_threads, unsigned char* results);
+
+/**
+ * Verify an aggregate from stealth_aggregate against the block it covers:
+ * with h_i = H4(Addr_i, msg_i, X_i), checks
+ * e(g, Q_agg) * prod e(H3(Addr_i), C_i)^(h_i*z_i) == prod X_i^z_i.
+ * Under STEALTH_HASH_G1_POW the left side is one pairing on
+ * Q_agg * prod C_i^(t_i*h_i*z_i); under STEALTH_HASH_G1_MAP it is n + 1
+ * pairings with a single final exponentiation. Either way the rest is
+ * two multi-exponentiations instead of n pairings.
+ * @param Addr, R2, C Arrays of n address components
+ * @param msgs Array of n messages
+ * @param XGT Commitments of the aggregate
+ * @param Q_agg Aggregate signature
+ * @return 1 if every signature of the block is valid, 0 otherwise
+ */
+int stealth_verify_aggregate(element_t Addr[], element_t R2[], element_t C[],
+                             const char* msgs[], element_t XGT[], element_t Q_agg, int n);
+
 /**
  * Trace identity
  * @param B_r Recovered public key B (output)
@@ -166,6 +868,22 @@ int stealth_verify(element_t Addr, element_t R2, element_t C,
 void stealth_trace(element_t B_r, element_t Addr, element_t R1, element_t R2, 
                   element_t C, element_t kZ);
 
+/**
+ * Bulk identity tracing for audits over many addresses.
+ * Traces n tuples (Addr[i], R1[i], R2[i], C[i]) with one trace key,
+ * converting k once and reusing the same scratch elements.
+ * @param B_out Array of n initialized G1 elements, recovered B in order (output)
+ * @param Addr Array of n addresses
+ * @param R1 Array of n R1 components
+ * @param R2 Array of n R2 components
+ * @param C Array of n C components
+ * @param n Number of tuples
+ * @param kZ Trace private key
+ * @return Number of tuples traced
+ */
+int stealth_trace_batch(element_t B_out[], element_t Addr[], element_t R1[],
+                        element_t R2[], element_t C[], int n, element_t kZ);
+
 //----------------------------------------------
 // Performance and Utility Functions
 //----------------------------------------------
@@ -181,22 +899,74 @@ void stealth_get_performance(stealth_performance_t* perf);
  */
 void stealth_print_performance(void);
 
+/**
+ * Latency percentiles of each operation, from per-call histograms
+ * Unlike the averages these do not depend on perf_counter: every call of
+ * an operation adds one sample (its time excluding hashing, as in the
+ * averages), whichever thread made it
+ * @param lat Array to fill, in stealth_performance_t order (output)
+ * @param n Size of lat
+ * @return Number of entries filled, at most STEALTH_LATENCY_OPS
+ */
+int stealth_get_latency(stealth_latency_t* lat, int n);
+
+/**
+ * Snapshot of an operation's latency histogram, for merging snapshots
+ * taken over several runs
+ * @param op Operation index, < STEALTH_LATENCY_OPS
+ * @param counts Array for the bucket counts (output)
+ * @param n Size of counts, at least stealth_latency_buckets()
+ * @param max_ms Largest sample in ms (output, may be NULL)
+ * @return Number of samples, -1 on a bad op or a short array
+ */
+long stealth_latency_histogram(int op, unsigned long* counts, int n, double* max_ms);
+
+/**
+ * Number of histogram buckets
+ */
+int stealth_latency_buckets(void);
+
+/**
+ * Largest latency in ms that falls into a histogram bucket
+ */
+double stealth_latency_bucket_ms(int bucket);
+
 //----------------------------------------------
 // Element Serialization Helpers
 //----------------------------------------------
 
 /**
- * Get the size needed for serializing a G1 element
+ * Get the size needed for serializing a G1 element in the current wire format
  * @return Size in bytes, 0 if not initialized
  */
 int stealth_element_size_G1(void);
 
+/**
+ * Get the size needed for serializing a G2 element (TK, R2, one-time keys
+ * and signatures), the G1 size under a symmetric pairing
+ * @return Size in bytes, 0 if not initialized
+ */
+int stealth_element_size_G2(void);
+
+/**
+ * Check whether the active pairing is asymmetric, see stealth_init
+ * @return 1 if G1 != G2, 0 if symmetric or not initialized
+ */
+int stealth_is_asymmetric(void);
+
 /**
  * Get the size needed for serializing a Zr element
  * @return Size in bytes, 0 if not initialized
  */
 int stealth_element_size_Zr(void);
 
+/**
+ * Get the size needed for serializing a GT element (aggregate commitments),
+ * in the compact encoding of stealth_gt_compact_length
+ * @return Size in bytes, 0 if not initialized
+ */
+int stealth_element_size_GT(void);
+
 /**
  * Serialize element to bytes
  * @param elem Element to serialize
@@ -215,6 +985,15 @@ int stealth_element_to_bytes(element_t elem, unsigned char* buf, int buf_size);
  */
 int stealth_element_from_bytes_G1(element_t elem, const unsigned char* buf, int len);
 
+/**
+ * Deserialize G2 element from bytes
+ * @param elem Element to initialize and fill (output)
+ * @param buf Buffer to read from
+ * @param len Length of data
+ * @return 0 on success, -1 on error
+ */
+int stealth_element_from_bytes_G2(element_t elem, const unsigned char* buf, int len);
+
 /**
  * Deserialize Zr element from bytes
  * @param elem Element to initialize and fill (output)
@@ -224,4 +1003,436 @@ int stealth_element_from_bytes_G1(element_t elem, const unsigned char* buf, int
  */
 int stealth_element_from_bytes_Zr(element_t elem, const unsigned char* buf, int len);
 
-#endif /* STEALTH_CORE_H */
\ No newline at end of file
+//----------------------------------------------
+// Wire Format
+//----------------------------------------------
+
+/**
+ * G1 wire formats for the byte-level API. Compressed points carry the
+ * x-coordinate plus one byte for the sign of y (roughly half the size)
+ * and cost a square root to decode. Zr elements and the inputs of the
+ * hash functions are not affected.
+ */
+#define STEALTH_POINT_UNCOMPRESSED 0
+#define STEALTH_POINT_COMPRESSED   1
+
+/**
+ * Select the G1 wire format (default uncompressed, kept across re-init)
+ * @param format STEALTH_POINT_UNCOMPRESSED or STEALTH_POINT_COMPRESSED
+ * @return 0 on success, -1 on unknown format
+ */
+int stealth_set_point_format(int format);
+
+/**
+ * Get the current G1 wire format
+ * @return STEALTH_POINT_UNCOMPRESSED or STEALTH_POINT_COMPRESSED
+ */
+int stealth_get_point_format(void);
+
+/**
+ * Checks on elements read through the wire format. By default decoded
+ * points are only known to lie on the curve (PBC maps others to the
+ * identity). With STEALTH_VALIDATE_SUBGROUP, G1 and G2 points and GT
+ * values must also lie in the group of order r
+ * (element_is_in_subgroup): others are replaced by the identity and the
+ * decoder returns -1. Batches are checked in one pass
+ * (element_is_in_subgroup_batch). Curves of prime order, such as G1 of
+ * type F, pay nothing extra; elsewhere a check costs about one
+ * exponentiation, less in batches.
+ */
+#define STEALTH_VALIDATE_NONE     0
+#define STEALTH_VALIDATE_SUBGROUP 1
+
+/**
+ * Select the wire validation mode (default none, kept across re-init)
+ * @param mode STEALTH_VALIDATE_NONE or STEALTH_VALIDATE_SUBGROUP
+ * @return 0 on success, -1 on unknown mode
+ */
+int stealth_set_validation(int mode);
+
+/**
+ * Get the current wire validation mode
+ * @return STEALTH_VALIDATE_NONE or STEALTH_VALIDATE_SUBGROUP
+ */
+int stealth_get_validation(void);
+
+/**
+ * Get the wire length of an element in the current format
+ * @param elem Element
+ * @return Size in bytes
+ */
+int stealth_wire_length(element_t elem);
+
+/**
+ * Serialize an element in the current wire format
+ * @param buf Buffer of at least stealth_wire_length(elem) bytes (output)
+ * @param elem Element to serialize
+ * @return Number of bytes written
+ */
+int stealth_wire_to_bytes(unsigned char* buf, element_t elem);
+
+/**
+ * Deserialize an element written by stealth_wire_to_bytes
+ * @param elem Initialized element to fill (output)
+ * @param buf Buffer to read from
+ * @return Number of bytes read, -1 if rejected by the validation mode
+ */
+int stealth_wire_from_bytes(element_t elem, const unsigned char* buf);
+
+/**
+ * Deserialize n elements packed back to back in the current wire format.
+ * Compressed G1 points are decompressed in one pass with shared scratch
+ * (element_from_bytes_compressed_batch).
+ * @param elems Array of n initialized elements of one field (output)
+ * @param buf Buffer to read from
+ * @param n Number of elements
+ * @return Number of bytes read, -1 if the validation mode rejected any
+ */
+int stealth_wire_from_bytes_batch(element_t elems[], const unsigned char* buf, int n);
+
+/**
+ * Compact point encoding of the address records in the stores: the
+ * x-coordinate plus one byte for the sign of y, the same bytes as the
+ * compressed G1 wire format whatever format is selected, for G2 points
+ * too. Decoding recovers y with a square root and does not check the
+ * group; records are written from points that were.
+ * @param elem Point of the group to measure
+ * @return Size in bytes
+ */
+int stealth_compact_length(element_t elem);
+
+/**
+ * Serialize a point in the compact encoding
+ * @param buf Buffer of at least stealth_compact_length(elem) bytes (output)
+ * @param elem Point to serialize
+ * @return Number of bytes written
+ */
+int stealth_compact_to_bytes(unsigned char* buf, element_t elem);
+
+/**
+ * Deserialize a point written by stealth_compact_to_bytes
+ * @param elem Initialized point to fill (output)
+ * @param buf Buffer to read from
+ * @return Number of bytes read
+ */
+int stealth_compact_from_bytes(element_t elem, const unsigned char* buf);
+
+/**
+ * Deserialize n points of one group packed back to back in the compact
+ * encoding, the square roots with shared scratch
+ * (element_from_bytes_compressed_batch)
+ * @param elems Array of n initialized points of one group (output)
+ * @param buf Buffer to read from
+ * @param n Number of points
+ * @return Number of bytes read
+ */
+int stealth_compact_from_bytes_batch(element_t elems[], const unsigned char* buf, int n);
+
+/**
+ * Compact encoding of the GT commitments of an aggregate. Under an even
+ * embedding degree GT lies in the norm 1 subgroup of F_q^k over
+ * F_q^(k/2), where one coordinate t identifies an element (torus
+ * compression), so types A, A1 and D take half of element_length_in_bytes.
+ * Other types keep the full encoding. Encoding and decoding each cost one
+ * inversion; decoding checks the subgroup as the wire format does.
+ * @param x GT element to measure
+ * @return Size in bytes
+ */
+int stealth_gt_compact_length(element_t x);
+
+/**
+ * Serialize a GT element in the compact encoding
+ * @param buf Buffer of at least stealth_gt_compact_length(x) bytes (output)
+ * @param x GT element to serialize
+ * @return Number of bytes written
+ */
+int stealth_gt_compact_to_bytes(unsigned char* buf, element_t x);
+
+/**
+ * Deserialize a GT element written by stealth_gt_compact_to_bytes
+ * @param x Initialized GT element to fill (output)
+ * @param buf Buffer to read from
+ * @return Number of bytes read, -1 if it fails validation
+ */
+int stealth_gt_compact_from_bytes(element_t x, const unsigned char* buf);
+
+//----------------------------------------------
+// Hash Version
+//----------------------------------------------
+
+/**
+ * Hash-to-G1 behind H2 and H3. Addresses, one-time keys and signatures
+ * depend on it, so data must be processed under the version it was
+ * created with; the default keeps the original scheme.
+ * STEALTH_HASH_G1_POW: g^H(x), one exponentiation by a hashed scalar
+ * STEALTH_HASH_G1_MAP: SHA256 digest mapped onto the curve
+ *   (element_from_hash); needs a curve G1 (not type I), and
+ *   verification pairs twice since the log of H3(Addr) is unknown.
+ *   Under an asymmetric pairing H3 maps onto G2 instead
+ */
+#define STEALTH_HASH_G1_POW 1
+#define STEALTH_HASH_G1_MAP 2
+
+/**
+ * Select the hash version (kept across re-init; stealth_init fails if
+ * the pairing cannot map onto G1)
+ * @param version STEALTH_HASH_G1_POW or STEALTH_HASH_G1_MAP
+ * @return 0 on success, -1 on unknown or unsupported version
+ */
+int stealth_set_hash_version(int version);
+
+/**
+ * Get the current hash version
+ */
+int stealth_get_hash_version(void);
+
+//----------------------------------------------
+// Allocator
+//----------------------------------------------
+
+/**
+ * Memory behind PBC and GMP. The pool keeps freed blocks in per-thread
+ * lists (pbc_pool_enable); it is installed at the next stealth_init and
+ * stays for the life of the process.
+ */
+#define STEALTH_ALLOC_MALLOC 0
+#define STEALTH_ALLOC_POOL   1
+
+/**
+ * Select the allocator used from the next stealth_init on
+ * @param allocator STEALTH_ALLOC_MALLOC or STEALTH_ALLOC_POOL
+ * @return 0 on success, -1 on unknown allocator or leaving an installed pool
+ */
+int stealth_set_allocator(int allocator);
+
+//----------------------------------------------
+// Pairing Autotuning
+//----------------------------------------------
+
+/**
+ * Pairing configuration picked on the host. With tuning on, the first
+ * stealth_init of a parameter set times every Fp backend and pairing
+ * method of PBC on a pairing / exponentiation workload and keeps the
+ * fastest; later inits and stealth_ctx_new reuse the result. A cache file
+ * carries results to later processes, which then skip the measurement.
+ */
+#define STEALTH_TUNE_OFF 0
+#define STEALTH_TUNE_ON  1
+
+/**
+ * Select autotuning for the pairings initialized from the next
+ * stealth_init / stealth_ctx_new on
+ * @param mode STEALTH_TUNE_OFF (default) or STEALTH_TUNE_ON
+ * @param cache_file File of tuning results, created if missing; NULL
+ *        keeps them in memory only
+ * @return 0 on success, -1 on unknown mode or out of memory
+ */
+int stealth_set_autotune(int mode, const char* cache_file);
+
+/**
+ * Get the autotuning mode
+ */
+int stealth_get_autotune(void);
+
+/**
+ * Configuration of the active pairing as "<fp backend> <method>",
+ * e.g. "mont miller"
+ * @return NULL if it was initialized without autotuning or the library
+ *         is not initialized
+ */
+const char* stealth_get_tuning(void);
+
+//----------------------------------------------
+// Pairing Preprocessing Cache
+//----------------------------------------------
+
+/**
+ * Keep the pairing tables of the last R1 values paired by stealth_trace,
+ * stealth_trace_batch and stealth_addr_recognize, least recently used
+ * dropped first. A cached R1 skips the Miller-loop setup; a new one pays
+ * for building its table, which costs more than a plain pairing under
+ * type A, so this pays off when outputs share R1. Applies to the active
+ * pairing and those initialized afterwards; call while no operation runs.
+ * @param entries Tables kept per pairing, 0 to disable (the default is
+ *        STEALTH_PP_CACHE_SIZE)
+ * @return 0 on success, -1 on a negative size or out of memory
+ */
+int stealth_set_pp_cache(int entries);
+
+/**
+ * Lookups of the active pairing's cache since stealth_init, the last
+ * stealth_reset_performance or stealth_set_pp_cache
+ * @param hits Pairings through a cached table (output, may be NULL)
+ * @param misses Pairings that built their table (output, may be NULL)
+ */
+void stealth_get_pp_cache_stats(unsigned long* hits, unsigned long* misses);
+
+/**
+ * Keep the pairing tables of the commitments C of the last addresses
+ * verified, least recently used dropped first, so that an address that
+ * signs again (spent, or signing several messages) pairs its C through
+ * the table. Verification under STEALTH_HASH_G1_MAP then pairs C with
+ * H3(Addr)^h, with H3(Addr) from the H3 cache, and with an asymmetric
+ * pairing under STEALTH_HASH_G1_POW it pairs C with g2^(t*h). With a
+ * symmetric pairing under STEALTH_HASH_G1_POW verification pairs only
+ * against g, whose table is always kept, so there is nothing to cache.
+ * Building a table costs more than a plain pairing under type A, so
+ * this pays off when most verifications are on addresses seen before.
+ * Pairing types without preprocessing (type F) verify as without it.
+ * Applies to the active pairing and those initialized afterwards; call
+ * while no operation runs.
+ * @param entries Tables kept per pairing, 0 to disable (the default is
+ *        STEALTH_VERIFY_PP_CACHE_SIZE)
+ * @return 0 on success, -1 on a negative size or out of memory
+ */
+int stealth_set_verify_pp_cache(int entries);
+
+/**
+ * Lookups of the active pairing's verify table cache since stealth_init,
+ * the last stealth_reset_performance or stealth_set_verify_pp_cache
+ * @param hits Verifications through a cached table (output, may be NULL)
+ * @param misses Verifications that built their table (output, may be NULL)
+ */
+void stealth_get_verify_pp_cache_stats(unsigned long* hits, unsigned long* misses);
+
+//----------------------------------------------
+// Ephemeral Pool
+//----------------------------------------------
+
+/**
+ * Keep entries ephemerals (r, g^r) for address generation and as many
+ * signing nonces (x, g2^x, e(g, g2)^x) precomputed. None depends on the
+ * recipient or the message, so a background thread at idle priority
+ * refills the pools between calls, and stealth_addr_gen,
+ * stealth_addr_gen_tagged, stealth_addr_gen_ctx, stealth_addr_gen_block
+ * and stealth_sign take one instead of paying for the fixed-base
+ * exponentiations (three of them for a signature). An empty pool falls
+ * back to computing inline; a thread in seeded random mode never uses
+ * the pools. Each entry is handed out once and zeroed in the pool when
+ * taken. Applies to the active pairing and those initialized afterwards;
+ * call while no operation runs.
+ * @param entries Entries kept per pool, 0 to disable (the default is
+ *        STEALTH_EPH_POOL_SIZE)
+ * @return 0 on success, -1 on a negative size, out of memory or no filler
+ *         thread (the pools are then off)
+ */
+int stealth_set_eph_pool(int entries);
+
+/**
+ * Ephemerals and nonces taken from the pools and calls that found them
+ * empty, since stealth_init, the last stealth_reset_performance or
+ * stealth_set_eph_pool
+ * @param hits Calls served from a pool (output, may be NULL)
+ * @param misses Calls that computed their own (output, may be NULL)
+ */
+void stealth_get_eph_pool_stats(unsigned long* hits, unsigned long* misses);
+
+//----------------------------------------------
+// DSK Cache
+//----------------------------------------------
+
+/**
+ * Keep the one-time secret keys of the last entries addresses signed for
+ * with stealth_sign_cached, each for ttl_ms from its derivation, least
+ * recently used evicted first. Expired, evicted and dropped keys are
+ * zeroed together with their tables, and the cache is dropped whenever
+ * the pairing or the generator changes. Applies to the active pairing and
+ * those initialized afterwards; call while no operation runs.
+ * @param entries Keys kept, 0 to disable (the default is STEALTH_DSK_CACHE_SIZE)
+ * @param ttl_ms Lifetime of a key in ms (the default is STEALTH_DSK_CACHE_TTL_MS)
+ * @return 0 on success, -1 on a negative size or lifetime, or out of memory
+ */
+int stealth_set_dsk_cache(int entries, double ttl_ms);
+
+/**
+ * Lookups of the DSK cache since stealth_init, the last
+ * stealth_reset_performance or stealth_set_dsk_cache
+ * @param hits Signatures from a cached key (output, may be NULL)
+ * @param misses Signatures that derived their key (output, may be NULL)
+ * @param evictions Live keys wiped for room or on expiry (output, may be NULL)
+ */
+void stealth_get_dsk_cache_stats(unsigned long* hits, unsigned long* misses,
+                                 unsigned long* evictions);
+
+//----------------------------------------------
+// H3 Cache
+//----------------------------------------------
+
+/**
+ * Keep the H3(Addr) of the last entries addresses hashed under
+ * STEALTH_HASH_G1_MAP, where H3 maps a digest onto the curve, least
+ * recently used dropped first. Every one-time key derived and every
+ * signature verified on a cached address then skips the map. Under
+ * STEALTH_HASH_G1_POW there is nothing to keep: verification already
+ * folds H3(Addr) = g2^t into its exponent, and key derivation raises g2
+ * to t*b*r2 directly. Dropped when the hash version changes. Applies to
+ * the active pairing and those initialized afterwards; call while no
+ * operation runs.
+ * @param entries Values kept, 0 to disable (the default is STEALTH_H3_CACHE_SIZE)
+ * @return 0 on success, -1 on a negative size or out of memory
+ */
+int stealth_set_h3_cache(int entries);
+
+/**
+ * Lookups of the H3 cache since stealth_init, the last
+ * stealth_reset_performance or stealth_set_h3_cache
+ * @param hits Hashes served from the cache (output, may be NULL)
+ * @param misses Hashes mapped afresh (output, may be NULL)
+ */
+void stealth_get_h3_cache_stats(unsigned long* hits, unsigned long* misses);
+
+//----------------------------------------------
+// Seeded Random Mode
+//----------------------------------------------
+
+/**
+ * Make the calling thread draw its random numbers (keys, nonces,
+ * exponents) from a deterministic source seeded with seed, so that a
+ * benchmark does identical work run after run and commit after commit.
+ * Worker threads started from this thread by the block operations get
+ * sources seeded from it. Other threads keep the OS source. For
+ * benchmarks only, never for real keys.
+ * @param enabled 1 to seed (reseeding if already seeded), 0 to go back to the OS source
+ * @param seed Seed
+ * @return 0 on success, -1 if out of memory
+ */
+int stealth_set_random_seed(int enabled, unsigned int seed);
+
+/**
+ * 1 if the calling thread draws from a seeded source
+ */
+int stealth_get_random_seeded(void);
+
+//----------------------------------------------
+// Hardware Counters
+//----------------------------------------------
+
+/**
+ * Read hardware counters (cycles, instructions, L1D / LLC / branch misses)
+ * and count PBC / GMP allocations around every instrumented primitive,
+ * for cycles, IPC, misses and allocations per pairing, exponentiation and
+ * hash. Each instrumented call then costs two extra counter reads. Call
+ * while no operation is running.
+ * @param enabled 1 to count, 0 to stop
+ * @return Mask of the counters available (1 << hwc_kind_t in
+ *         perf_counters.h), 0 when stopping
+ */
+int stealth_set_hw_counters(int enabled);
+
+//----------------------------------------------
+// Worker Placement
+//----------------------------------------------
+
+/**
+ * Pin the threads of the batch operations and of scanning contexts
+ * created from now on to CPUs, spread over the NUMA nodes in node order,
+ * so that each thread's range of a batch, its scratch and its context
+ * pairing stay on one node. On more than one node, the fixed-base tables
+ * of g, g2 and e(g, g2) are then also copied to each node on first use
+ * there. Off by default; call while no operation is running.
+ * @param enabled 1 to pin, 0 to let the scheduler place threads
+ * @return Number of NUMA nodes found
+ */
+int stealth_set_worker_pinning(int enabled);
+
+#endif /* STEALTH_CORE_H */
\ No newline at end of file
@@ -0,0 +1,456 @@
+/****************************************************************************
+ * File: stealth_ctx.c
+ * Desc: Thread-safe scanning context and worker pool
+ *       Every worker parses its own pairing, so no PBC state is shared.
+ *       Workers set up their pairing and scratch on their own thread, so
+ *       with pinning on (cpu_topo.h) both sit on the worker's NUMA node.
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include <openssl/sha.h>
+#include "stealth_core.h"
+#include "stealth_ctx.h"
+#include "perf_timer.h"
+#include "perf_prim.h"
+#include "pairing_tune.h"
+#include "hash_stream.h"
+#include "cpu_topo.h"
+
+//----------------------------------------------
+// Context layout
+//----------------------------------------------
+typedef struct {
+    pthread_t tid;
+    struct stealth_ctx_s* ctx;
+    pairing_t pairing;
+    // Per-worker scratch; R1 holds a chunk of outputs, checked together
+    element_t R1[STEALTH_SCAN_CHUNK], R1_pow_a[STEALTH_SCAN_CHUNK], B, C_prime;
+    char ok[STEALTH_SCAN_CHUNK];
+    mpz_t a_mpz, r2_mpz;
+    int begin, end;
+    int matches;
+    int ready;                   // pairing and scratch set up
+} __attribute__((aligned(64))) stealth_worker_t;
+
+struct stealth_ctx_s {
+    int g1_len;                  // wire size, depends on point_format
+    int point_format;
+    int validation;
+    int zr_len;
+    int num_workers;             // running threads
+    int num_setup;               // workers done setting up, ready or not
+    stealth_worker_t* workers;
+    const char* params;          // parameters, while the workers set up
+    size_t param_len;
+
+    // Job hand-off between stealth_ctx_scan and the pool
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    pthread_mutex_t scan_lock;   // one batch at a time per context
+    unsigned long generation;
+    int pending;
+    int shutdown;
+
+    const unsigned char* R1_bytes;
+    const unsigned char* C_bytes;
+    const unsigned char* B_bytes;
+    const unsigned char* a_bytes;
+    const unsigned char* view_tags;  // NULL when scanning without tags
+    unsigned char* bitmap;
+
+    // Statistics
+    double total_ms;
+    long total_outputs;
+};
+
+//----------------------------------------------
+// Helpers
+//----------------------------------------------
+static char* read_param_file(const char* param_file, size_t* len) {
+    FILE *fp = fopen(param_file, "r");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long fsize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fsize <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    char *buf = malloc(fsize + 1);
+    if (!buf) {
+        fclose(fp);
+        return NULL;
+    }
+    *len = fread(buf, 1, fsize, fp);
+    buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static void g1_from_wire(struct stealth_ctx_s* ctx, element_t e, const unsigned char* buf) {
+    if (ctx->point_format != STEALTH_POINT_COMPRESSED) {
+        prim_from_bytes(e, (unsigned char*)buf);
+    } else if (buf[ctx->g1_len - 1] == 2) {
+        // Point at infinity, see stealth_wire_to_bytes
+        element_set0(e);
+    } else {
+        prim_from_bytes_compressed(e, (unsigned char*)buf);
+    }
+}
+
+static void g1_to_wire(struct stealth_ctx_s* ctx, unsigned char* buf, element_t e) {
+    if (ctx->point_format != STEALTH_POINT_COMPRESSED) {
+        prim_to_bytes(buf, e);
+    } else if (element_is0(e)) {
+        memset(buf, 0, ctx->g1_len - 1);
+        buf[ctx->g1_len - 1] = 2;
+    } else {
+        prim_to_bytes_compressed(buf, e);
+    }
+}
+
+//----------------------------------------------
+// Worker
+//----------------------------------------------
+static void worker_scan(stealth_worker_t* w) {
+    struct stealth_ctx_s* ctx = w->ctx;
+    unsigned char buf[1024], wire[1024];
+    size_t len = ctx->g1_len;
+
+    w->matches = 0;
+    if (w->begin >= w->end) return;
+
+    g1_from_wire(ctx, w->B, ctx->B_bytes);
+    element_t aZ;
+    element_init_Zr(aZ, w->pairing);
+    prim_from_bytes(aZ, (unsigned char*)ctx->a_bytes);
+    element_to_mpz(w->a_mpz, aZ);
+    element_clear(aZ);
+
+    // Every output of an untagged scan pays B^r2
+    element_pp_t B_pp;
+    int B_table = !ctx->view_tags && w->end - w->begin >= STEALTH_SCAN_PP_MIN;
+    if (B_table) element_pp_init_ex(B_pp, w->B, STEALTH_RECIPIENT_PP_TEETH, PBC_PP_COMB2);
+
+    int validate = ctx->validation == STEALTH_VALIDATE_SUBGROUP;
+    for (int base = w->begin; base < w->end; base += STEALTH_SCAN_CHUNK) {
+        int m = w->end - base < STEALTH_SCAN_CHUNK ? w->end - base : STEALTH_SCAN_CHUNK;
+        for (int j = 0; j < m; j++)
+            g1_from_wire(ctx, w->R1[j], ctx->R1_bytes + (size_t)(base + j) * len);
+        if (validate) element_is_in_subgroup_batch(w->ok, w->R1, m);
+
+        // R1^a for the whole chunk, the view key a kept constant time
+        stealth_secret_pow_mpz_same(w->R1_pow_a, w->R1, w->a_mpz, m);
+
+        for (int j = 0; j < m; j++) {
+            int i = base + j;
+            if (validate && !w->ok[j]) continue;
+
+            // H1 always hashes the uncompressed encoding
+            size_t hlen = prim_to_bytes(buf, w->R1_pow_a[j]);
+            if (ctx->view_tags) {
+                unsigned char tag[STEALTH_VIEW_TAG_LEN];
+                stealth_view_tag_from_bytes(tag, buf, hlen);
+                if (memcmp(tag, ctx->view_tags + (size_t)i * STEALTH_VIEW_TAG_LEN,
+                           STEALTH_VIEW_TAG_LEN) != 0)
+                    continue;
+            }
+            hash_stream_to_mpz(w->r2_mpz, buf, hlen, w->pairing->r);
+
+            // C is compared in its wire form: encodings are unique, and C'
+            // lies in the group, so C never needs decoding or checking
+            if (B_table) prim_pp_pow(w->C_prime, w->r2_mpz, B_pp);
+            else prim_pow_mpz(w->C_prime, w->B, w->r2_mpz);
+            g1_to_wire(ctx, wire, w->C_prime);
+            if (memcmp(wire, ctx->C_bytes + (size_t)i * len, len) == 0) {
+                // Chunks start on byte boundaries, so no two workers share a byte
+                ctx->bitmap[i >> 3] |= (unsigned char)(1 << (i & 7));
+                w->matches++;
+            }
+        }
+    }
+
+    if (B_table) element_pp_clear(B_pp);
+}
+
+// Parameter parsing goes through the process-wide PBC tweaks, one at a time
+static pthread_mutex_t setup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int worker_setup(stealth_worker_t* w) {
+    struct stealth_ctx_s* ctx = w->ctx;
+    pthread_mutex_lock(&setup_lock);
+    int rc = pairing_init_tuned(w->pairing, ctx->params, ctx->param_len, NULL);
+    pthread_mutex_unlock(&setup_lock);
+    if (rc != 0) return -1;
+    for (int j = 0; j < STEALTH_SCAN_CHUNK; j++) {
+        element_init_G1(w->R1[j], w->pairing);
+        element_init_G1(w->R1_pow_a[j], w->pairing);
+    }
+    element_init_G1(w->B, w->pairing);
+    element_init_G1(w->C_prime, w->pairing);
+    mpz_init(w->a_mpz);
+    mpz_init(w->r2_mpz);
+    return 0;
+}
+
+static void* worker_main(void* arg) {
+    stealth_worker_t* w = (stealth_worker_t*)arg;
+    struct stealth_ctx_s* ctx = w->ctx;
+    unsigned long seen = 0;
+
+    int ready = worker_setup(w) == 0;
+    pthread_mutex_lock(&ctx->lock);
+    w->ready = ready;
+    ctx->num_setup++;
+    pthread_cond_signal(&ctx->done_cv);
+    pthread_mutex_unlock(&ctx->lock);
+    if (!ready) return NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&ctx->lock);
+        while (!ctx->shutdown && ctx->generation == seen)
+            pthread_cond_wait(&ctx->work_cv, &ctx->lock);
+        if (ctx->shutdown) {
+            pthread_mutex_unlock(&ctx->lock);
+            break;
+        }
+        seen = ctx->generation;
+        pthread_mutex_unlock(&ctx->lock);
+
+        worker_scan(w);
+
+        pthread_mutex_lock(&ctx->lock);
+        if (--ctx->pending == 0)
+            pthread_cond_signal(&ctx->done_cv);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+    return NULL;
+}
+
+static void worker_clear(stealth_worker_t* w) {
+    if (!w->ready) return;
+    for (int j = 0; j < STEALTH_SCAN_CHUNK; j++) {
+        element_clear(w->R1[j]);
+        element_clear(w->R1_pow_a[j]);
+    }
+    element_clear(w->B);
+    element_clear(w->C_prime);
+    mpz_clear(w->a_mpz);
+    mpz_clear(w->r2_mpz);
+    pairing_clear(w->pairing);
+}
+
+//----------------------------------------------
+// Context management
+//----------------------------------------------
+
+/**
+ * Create a context and start its worker pool
+ */
+stealth_ctx_t* stealth_ctx_new(const char* param_file, int num_workers) {
+    size_t param_len = 0;
+    char* params = read_param_file(param_file, &param_len);
+    if (!params) {
+        fprintf(stderr, "Error: Cannot open parameter file %s\n", param_file);
+        return NULL;
+    }
+
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 0 ? (int)cpus : 1;
+    }
+
+    stealth_ctx_t* ctx = calloc(1, sizeof(stealth_ctx_t));
+    if (!ctx) {
+        free(params);
+        return NULL;
+    }
+    // Cache-line aligned, so that no two workers write the same line
+    if (posix_memalign((void**)&ctx->workers, 64, num_workers * sizeof(stealth_worker_t)) != 0) {
+        free(ctx);
+        free(params);
+        return NULL;
+    }
+    memset(ctx->workers, 0, num_workers * sizeof(stealth_worker_t));
+    ctx->params = params;
+    ctx->param_len = param_len;
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_mutex_init(&ctx->scan_lock, NULL);
+    pthread_cond_init(&ctx->work_cv, NULL);
+    pthread_cond_init(&ctx->done_cv, NULL);
+
+    // Each worker parses a private pairing once started; worker i runs on
+    // CPU i of num_workers in node order when pinning is on, so that the
+    // contiguous ranges of stealth_ctx_scan stay node-local
+    for (; ctx->num_workers < num_workers; ctx->num_workers++) {
+        stealth_worker_t* w = &ctx->workers[ctx->num_workers];
+        w->ctx = ctx;
+        if (cpu_topo_create(&w->tid, ctx->num_workers, num_workers, worker_main, w) != 0) break;
+    }
+    pthread_mutex_lock(&ctx->lock);
+    while (ctx->num_setup < ctx->num_workers)
+        pthread_cond_wait(&ctx->done_cv, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+    ctx->params = NULL;
+    free(params);
+
+    int ready = ctx->num_workers == num_workers;
+    for (int i = 0; ready && i < num_workers; i++) ready = ctx->workers[i].ready;
+    if (!ready) {
+        stealth_ctx_free(ctx);
+        return NULL;
+    }
+
+    ctx->g1_len = pairing_length_in_bytes_G1(ctx->workers[0].pairing);
+    ctx->zr_len = pairing_length_in_bytes_Zr(ctx->workers[0].pairing);
+    return ctx;
+}
+
+/**
+ * Stop the worker pool and release the context
+ */
+void stealth_ctx_free(stealth_ctx_t* ctx) {
+    if (!ctx) return;
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->shutdown = 1;
+    pthread_cond_broadcast(&ctx->work_cv);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for (int i = 0; i < ctx->num_workers; i++)
+        pthread_join(ctx->workers[i].tid, NULL);
+    for (int i = 0; i < ctx->num_workers; i++)
+        worker_clear(&ctx->workers[i]);
+
+    pthread_cond_destroy(&ctx->work_cv);
+    pthread_cond_destroy(&ctx->done_cv);
+    pthread_mutex_destroy(&ctx->scan_lock);
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx->workers);
+    free(ctx);
+}
+
+int stealth_ctx_num_workers(const stealth_ctx_t* ctx) {
+    return ctx ? ctx->num_workers : 0;
+}
+
+int stealth_ctx_element_size_G1(const stealth_ctx_t* ctx) {
+    return ctx ? ctx->g1_len : 0;
+}
+
+int stealth_ctx_element_size_Zr(const stealth_ctx_t* ctx) {
+    return ctx ? ctx->zr_len : 0;
+}
+
+/**
+ * Select the G1 wire format of the scan inputs
+ */
+int stealth_ctx_set_point_format(stealth_ctx_t* ctx, int format) {
+    if (!ctx) return -1;
+    if (format != STEALTH_POINT_UNCOMPRESSED && format != STEALTH_POINT_COMPRESSED) return -1;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    element_t tmp;
+    element_init_G1(tmp, ctx->workers[0].pairing);
+    ctx->g1_len = format == STEALTH_POINT_COMPRESSED ? element_length_in_bytes_compressed(tmp)
+                                                     : element_length_in_bytes(tmp);
+    element_clear(tmp);
+    ctx->point_format = format;
+    pthread_mutex_unlock(&ctx->scan_lock);
+    return 0;
+}
+
+/**
+ * Select the checks on the scan inputs
+ */
+int stealth_ctx_set_validation(stealth_ctx_t* ctx, int mode) {
+    if (!ctx) return -1;
+    if (mode != STEALTH_VALIDATE_NONE && mode != STEALTH_VALIDATE_SUBGROUP) return -1;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    ctx->validation = mode;
+    pthread_mutex_unlock(&ctx->scan_lock);
+    return 0;
+}
+
+//----------------------------------------------
+// Parallel scan
+//----------------------------------------------
+
+/**
+ * Parallel fast recognition over a block of outputs
+ */
+int stealth_ctx_scan(stealth_ctx_t* ctx, const unsigned char* R1_bytes,
+                     const unsigned char* C_bytes, int n,
+                     const unsigned char* B_bytes, const unsigned char* a_bytes,
+                     unsigned char* out_bitmap) {
+    return stealth_ctx_scan_tagged(ctx, R1_bytes, C_bytes, NULL, n, B_bytes, a_bytes,
+                                   out_bitmap);
+}
+
+/**
+ * Parallel fast recognition with view tag prefilter
+ */
+int stealth_ctx_scan_tagged(stealth_ctx_t* ctx, const unsigned char* R1_bytes,
+                            const unsigned char* C_bytes, const unsigned char* view_tags,
+                            int n, const unsigned char* B_bytes,
+                            const unsigned char* a_bytes, unsigned char* out_bitmap) {
+    if (!ctx || !R1_bytes || !C_bytes || !B_bytes || !a_bytes || !out_bitmap || n < 0)
+        return -1;
+    if (n == 0) return 0;
+
+    pthread_mutex_lock(&ctx->scan_lock);
+    double t1 = perf_now_ms();
+
+    memset(out_bitmap, 0, (n + 7) / 8);
+
+    // Split on multiples of 8 so every bitmap byte has a single writer
+    int bytes = (n + 7) / 8;
+    int per = (bytes + ctx->num_workers - 1) / ctx->num_workers * 8;
+    for (int i = 0; i < ctx->num_workers; i++) {
+        int begin = i * per;
+        int end = begin + per;
+        ctx->workers[i].begin = begin < n ? begin : n;
+        ctx->workers[i].end = end < n ? end : n;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->R1_bytes = R1_bytes;
+    ctx->C_bytes = C_bytes;
+    ctx->B_bytes = B_bytes;
+    ctx->a_bytes = a_bytes;
+    ctx->view_tags = view_tags;
+    ctx->bitmap = out_bitmap;
+    ctx->pending = ctx->num_workers;
+    ctx->generation++;
+    pthread_cond_broadcast(&ctx->work_cv);
+    while (ctx->pending > 0)
+        pthread_cond_wait(&ctx->done_cv, &ctx->lock);
+    pthread_mutex_unlock(&ctx->lock);
+
+    int matches = 0;
+    for (int i = 0; i < ctx->num_workers; i++) matches += ctx->workers[i].matches;
+
+    ctx->total_ms += perf_now_ms() - t1;
+    ctx->total_outputs += n;
+    pthread_mutex_unlock(&ctx->scan_lock);
+
+    return matches;
+}
+
+/**
+ * Get accumulated scan statistics for this context
+ */
+void stealth_ctx_get_stats(const stealth_ctx_t* ctx, double* total_ms, long* outputs) {
+    if (total_ms) *total_ms = ctx ? ctx->total_ms : 0;
+    if (outputs) *outputs = ctx ? ctx->total_outputs : 0;
+}
@@ -7,8 +7,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "stealth_core.h"
 #include "stealth_python_api.h"
+#include "stealth_registry.h"
+#include "stealth_store.h"
+#include "stealth_bench.h"
+#include "perf_prim.h"
+#include "hex_codec.h"
 
 // Macro to simplify pairing access
 #define PAIRING (*stealth_get_pairing())
@@ -40,10 +46,10 @@ void stealth_keygen_simple(unsigned char* A_out, unsigned char* B_out,
     memset(b_out, 0, buf_size);
     
     // Serialize to buffers
-    element_to_bytes(A_out, A);
-    element_to_bytes(B_out, B);
-    element_to_bytes(a_out, aZ);
-    element_to_bytes(b_out, bZ);
+    stealth_wire_to_bytes(A_out, A);
+    stealth_wire_to_bytes(B_out, B);
+    stealth_wire_to_bytes(a_out, aZ);
+    stealth_wire_to_bytes(b_out, bZ);
     
     element_clear(A); element_clear(B);
     element_clear(aZ); element_clear(bZ);
@@ -56,7 +62,7 @@ void stealth_tracekeygen_simple(unsigned char* TK_out, unsigned char* k_out, int
     if (!stealth_is_initialized()) return;
     
     element_t TK, kZ;
-    element_init_G1(TK, PAIRING);
+    element_init_G2(TK, PAIRING);
     element_init_Zr(kZ, PAIRING);
     
     // Call core function
@@ -67,8 +73,8 @@ void stealth_tracekeygen_simple(unsigned char* TK_out, unsigned char* k_out, int
     memset(k_out, 0, buf_size);
     
     // Serialize to buffers
-    element_to_bytes(TK_out, TK);
-    element_to_bytes(k_out, kZ);
+    stealth_wire_to_bytes(TK_out, TK);
+    stealth_wire_to_bytes(k_out, kZ);
     
     element_clear(TK); element_clear(kZ);
 }
@@ -85,16 +91,16 @@ void stealth_addr_gen_simple(const unsigned char* A_bytes, const unsigned char*
     element_t A, B, TK, Addr, R1, R2, C;
     element_init_G1(A, PAIRING);
     element_init_G1(B, PAIRING);
-    element_init_G1(TK, PAIRING);
+    element_init_G2(TK, PAIRING);
     element_init_G1(Addr, PAIRING);
     element_init_G1(R1, PAIRING);
-    element_init_G1(R2, PAIRING);
+    element_init_G2(R2, PAIRING);
     element_init_G1(C, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(A, (unsigned char*)A_bytes);
-    element_from_bytes(B, (unsigned char*)B_bytes);
-    element_from_bytes(TK, (unsigned char*)TK_bytes);
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(TK, TK_bytes);
     
     // Call core function
     stealth_addr_gen(Addr, R1, R2, C, A, B, TK);
@@ -106,10 +112,10 @@ void stealth_addr_gen_simple(const unsigned char* A_bytes, const unsigned char*
     memset(c_out, 0, buf_size);
     
     // Serialize outputs
-    element_to_bytes(addr_out, Addr);
-    element_to_bytes(r1_out, R1);
-    element_to_bytes(r2_out, R2);
-    element_to_bytes(c_out, C);
+    stealth_wire_to_bytes(addr_out, Addr);
+    stealth_wire_to_bytes(r1_out, R1);
+    stealth_wire_to_bytes(r2_out, R2);
+    stealth_wire_to_bytes(c_out, C);
     
     element_clear(A); element_clear(B); element_clear(TK);
     element_clear(Addr); element_clear(R1); element_clear(R2); element_clear(C);
@@ -123,25 +129,21 @@ int stealth_addr_recognize_fast_simple(const unsigned char* R1_bytes, const unsi
                                       const unsigned char* a_bytes) {
     if (!stealth_is_initialized()) return 0;
     
-    element_t R1, B, A, C, aZ;
+    element_t R1, B, aZ;
     element_init_G1(R1, PAIRING);
     element_init_G1(B, PAIRING);
-    element_init_G1(A, PAIRING);
-    element_init_G1(C, PAIRING);
     element_init_Zr(aZ, PAIRING);
     
-    // Deserialize inputs
-    element_from_bytes(R1, (unsigned char*)R1_bytes);
-    element_from_bytes(B, (unsigned char*)B_bytes);
-    element_from_bytes(A, (unsigned char*)A_bytes);
-    element_from_bytes(C, (unsigned char*)C_bytes);
-    element_from_bytes(aZ, (unsigned char*)a_bytes);
+    // Deserialize inputs; A plays no part, and C is compared as bytes
+    (void)A_bytes;
+    stealth_wire_from_bytes(R1, R1_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
     
     // Call core function
-    int result = stealth_addr_recognize_fast(R1, B, A, C, aZ);
+    int result = stealth_addr_recognize_fast_bytes(R1, B, C_bytes, NULL, aZ);
     
-    element_clear(R1); element_clear(B); element_clear(A);
-    element_clear(C); element_clear(aZ);
+    element_clear(R1); element_clear(B); element_clear(aZ);
     
     return result;
 }
@@ -162,16 +164,16 @@ int stealth_addr_recognize_simple(const unsigned char* addr_bytes, const unsigne
     element_init_G1(A, PAIRING);
     element_init_G1(C, PAIRING);
     element_init_Zr(aZ, PAIRING);
-    element_init_G1(TK, PAIRING);
+    element_init_G2(TK, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(R1, (unsigned char*)R1_bytes);
-    element_from_bytes(B, (unsigned char*)B_bytes);
-    element_from_bytes(A, (unsigned char*)A_bytes);
-    element_from_bytes(C, (unsigned char*)C_bytes);
-    element_from_bytes(aZ, (unsigned char*)a_bytes);
-    element_from_bytes(TK, (unsigned char*)TK_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, R1_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(C, C_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(TK, TK_bytes);
     
     // Call core function
     int result = stealth_addr_recognize(Addr, R1, B, A, C, aZ, TK);
@@ -195,13 +197,13 @@ void stealth_dsk_gen_simple(const unsigned char* addr_bytes, const unsigned char
     element_init_G1(R1, PAIRING);
     element_init_Zr(aZ, PAIRING);
     element_init_Zr(bZ, PAIRING);
-    element_init_G1(dsk, PAIRING);
+    element_init_G2(dsk, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(R1, (unsigned char*)r1_bytes);
-    element_from_bytes(aZ, (unsigned char*)a_bytes);
-    element_from_bytes(bZ, (unsigned char*)b_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
     
     // Call core function
     stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
@@ -210,12 +212,49 @@ void stealth_dsk_gen_simple(const unsigned char* addr_bytes, const unsigned char
     memset(dsk_out, 0, buf_size);
     
     // Serialize output
-    element_to_bytes(dsk_out, dsk);
+    stealth_wire_to_bytes(dsk_out, dsk);
     
     element_clear(Addr); element_clear(R1); element_clear(aZ); element_clear(bZ);
     element_clear(dsk);
 }
 
+/**
+ * Python Interface: Recognize an output and generate its DSK in one call
+ */
+int stealth_recognize_and_derive_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                        const unsigned char* B_bytes, const unsigned char* c_bytes,
+                                        const unsigned char* tag, const unsigned char* a_bytes,
+                                        const unsigned char* b_bytes, unsigned char* dsk_out,
+                                        int buf_size) {
+    if (!stealth_is_initialized()) return 0;
+
+    element_t Addr, R1, B, C, aZ, bZ, dsk;
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_G1(C, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+    element_init_Zr(bZ, PAIRING);
+    element_init_G2(dsk, PAIRING);
+
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(C, c_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
+
+    int result = stealth_recognize_and_derive(dsk, Addr, R1, B, C, tag, aZ, bZ);
+    if (result) {
+        memset(dsk_out, 0, buf_size);
+        stealth_wire_to_bytes(dsk_out, dsk);
+    }
+
+    element_clear(Addr); element_clear(R1); element_clear(B); element_clear(C);
+    element_clear(aZ); element_clear(bZ); element_clear(dsk);
+    return result;
+}
+
 /**
  * Python Interface: Sign message with DSK
  */
@@ -226,13 +265,13 @@ void stealth_sign_with_dsk_simple(const unsigned char* addr_bytes, const unsigne
     
     element_t Addr, dsk, Q_sigma, hZ;
     element_init_G1(Addr, PAIRING);
-    element_init_G1(dsk, PAIRING);
-    element_init_G1(Q_sigma, PAIRING);
+    element_init_G2(dsk, PAIRING);
+    element_init_G2(Q_sigma, PAIRING);
     element_init_Zr(hZ, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(dsk, (unsigned char*)dsk_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(dsk, dsk_bytes);
     
     // Call core function
     stealth_sign(Q_sigma, hZ, Addr, dsk, message);
@@ -242,8 +281,8 @@ void stealth_sign_with_dsk_simple(const unsigned char* addr_bytes, const unsigne
     memset(h_out, 0, buf_size);
     
     // Serialize outputs
-    element_to_bytes(q_sigma_out, Q_sigma);
-    element_to_bytes(h_out, hZ);
+    stealth_wire_to_bytes(q_sigma_out, Q_sigma);
+    stealth_wire_to_bytes(h_out, hZ);
     
     element_clear(Addr); element_clear(dsk);
     element_clear(Q_sigma); element_clear(hZ);
@@ -264,15 +303,15 @@ void stealth_sign_simple(const unsigned char* addr_bytes, const unsigned char* r
     element_init_G1(R1, PAIRING);
     element_init_Zr(aZ, PAIRING);
     element_init_Zr(bZ, PAIRING);
-    element_init_G1(dsk, PAIRING);
-    element_init_G1(Q_sigma, PAIRING);
+    element_init_G2(dsk, PAIRING);
+    element_init_G2(Q_sigma, PAIRING);
     element_init_Zr(hZ, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(R1, (unsigned char*)r1_bytes);
-    element_from_bytes(aZ, (unsigned char*)a_bytes);
-    element_from_bytes(bZ, (unsigned char*)b_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
     
     // Generate one-time secret key
     stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
@@ -286,14 +325,53 @@ void stealth_sign_simple(const unsigned char* addr_bytes, const unsigned char* r
     memset(dsk_out, 0, buf_size);
     
     // Serialize outputs
-    element_to_bytes(q_sigma_out, Q_sigma);
-    element_to_bytes(h_out, hZ);
-    element_to_bytes(dsk_out, dsk);
+    stealth_wire_to_bytes(q_sigma_out, Q_sigma);
+    stealth_wire_to_bytes(h_out, hZ);
+    stealth_wire_to_bytes(dsk_out, dsk);
     
     element_clear(Addr); element_clear(R1); element_clear(aZ); element_clear(bZ);
     element_clear(dsk); element_clear(Q_sigma); element_clear(hZ);
 }
 
+/**
+ * Python Interface: Sign message through the DSK cache
+ */
+void stealth_sign_cached_simple(long addr_id, const unsigned char* addr_bytes,
+                                const unsigned char* r1_bytes,
+                                const unsigned char* a_bytes, const unsigned char* b_bytes,
+                                const char* message,
+                                unsigned char* q_sigma_out, unsigned char* h_out,
+                                unsigned char* dsk_out, int buf_size) {
+    if (!stealth_is_initialized()) return;
+
+    element_t Addr, R1, aZ, bZ, dsk, Q_sigma, hZ;
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+    element_init_Zr(bZ, PAIRING);
+    element_init_G2(dsk, PAIRING);
+    element_init_G2(Q_sigma, PAIRING);
+    element_init_Zr(hZ, PAIRING);
+
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
+
+    stealth_sign_cached(Q_sigma, hZ, dsk, addr_id, Addr, R1, aZ, bZ, message);
+
+    memset(q_sigma_out, 0, buf_size);
+    memset(h_out, 0, buf_size);
+    memset(dsk_out, 0, buf_size);
+    stealth_wire_to_bytes(q_sigma_out, Q_sigma);
+    stealth_wire_to_bytes(h_out, hZ);
+    stealth_wire_to_bytes(dsk_out, dsk);
+
+    element_wipe(aZ); element_wipe(bZ); element_wipe(dsk);
+    element_clear(Addr); element_clear(R1); element_clear(aZ); element_clear(bZ);
+    element_clear(dsk); element_clear(Q_sigma); element_clear(hZ);
+}
+
 /**
  * Python Interface: Verify signature
  */
@@ -304,17 +382,17 @@ int stealth_verify_simple(const unsigned char* addr_bytes, const unsigned char*
     
     element_t Addr, R2, C, hZ, Q_sigma;
     element_init_G1(Addr, PAIRING);
-    element_init_G1(R2, PAIRING);
+    element_init_G2(R2, PAIRING);
     element_init_G1(C, PAIRING);
     element_init_Zr(hZ, PAIRING);
-    element_init_G1(Q_sigma, PAIRING);
+    element_init_G2(Q_sigma, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(R2, (unsigned char*)r2_bytes);
-    element_from_bytes(C, (unsigned char*)c_bytes);
-    element_from_bytes(hZ, (unsigned char*)h_bytes);
-    element_from_bytes(Q_sigma, (unsigned char*)q_sigma_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R2, r2_bytes);
+    stealth_wire_from_bytes(C, c_bytes);
+    stealth_wire_from_bytes(hZ, h_bytes);
+    stealth_wire_from_bytes(Q_sigma, q_sigma_bytes);
     
     // Call core function
     int result = stealth_verify(Addr, R2, C, message, hZ, Q_sigma);
@@ -337,17 +415,17 @@ void stealth_trace_simple(const unsigned char* addr_bytes, const unsigned char*
     element_t Addr, R1, R2, C, kZ, B_recovered;
     element_init_G1(Addr, PAIRING);
     element_init_G1(R1, PAIRING);
-    element_init_G1(R2, PAIRING);
+    element_init_G2(R2, PAIRING);
     element_init_G1(C, PAIRING);
     element_init_Zr(kZ, PAIRING);
     element_init_G1(B_recovered, PAIRING);
     
     // Deserialize inputs
-    element_from_bytes(Addr, (unsigned char*)addr_bytes);
-    element_from_bytes(R1, (unsigned char*)r1_bytes);
-    element_from_bytes(R2, (unsigned char*)r2_bytes);
-    element_from_bytes(C, (unsigned char*)c_bytes);
-    element_from_bytes(kZ, (unsigned char*)k_bytes);
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(R2, r2_bytes);
+    stealth_wire_from_bytes(C, c_bytes);
+    stealth_wire_from_bytes(kZ, k_bytes);
     
     // Call core function
     stealth_trace(B_recovered, Addr, R1, R2, C, kZ);
@@ -356,12 +434,137 @@ void stealth_trace_simple(const unsigned char* addr_bytes, const unsigned char*
     memset(b_recovered_out, 0, buf_size);
     
     // Serialize output
-    element_to_bytes(b_recovered_out, B_recovered);
+    stealth_wire_to_bytes(b_recovered_out, B_recovered);
     
     element_clear(Addr); element_clear(R1); element_clear(R2);
     element_clear(C); element_clear(kZ); element_clear(B_recovered);
 }
 
+/**
+ * Python Interface: Trace identity and resolve the owner
+ */
+int stealth_trace_lookup_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                const unsigned char* k_bytes,
+                                unsigned char* b_recovered_out, int buf_size) {
+    if (!stealth_is_initialized()) return -1;
+
+    element_t Addr, R1, R2, C, kZ, B_recovered;
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_G2(R2, PAIRING);
+    element_init_G1(C, PAIRING);
+    element_init_Zr(kZ, PAIRING);
+    element_init_G1(B_recovered, PAIRING);
+
+    stealth_wire_from_bytes(Addr, addr_bytes);
+    stealth_wire_from_bytes(R1, r1_bytes);
+    stealth_wire_from_bytes(R2, r2_bytes);
+    stealth_wire_from_bytes(C, c_bytes);
+    stealth_wire_from_bytes(kZ, k_bytes);
+
+    stealth_trace(B_recovered, Addr, R1, R2, C, kZ);
+    int id = stealth_registry_find_B(B_recovered);
+
+    if (b_recovered_out) {
+        memset(b_recovered_out, 0, buf_size);
+        stealth_wire_to_bytes(b_recovered_out, B_recovered);
+    }
+
+    element_clear(Addr); element_clear(R1); element_clear(R2);
+    element_clear(C); element_clear(kZ); element_clear(B_recovered);
+    return id;
+}
+
+/**
+ * Python Interface: Register a key pair
+ */
+int stealth_registry_add_simple(const unsigned char* A_bytes, const unsigned char* B_bytes, int id) {
+    if (!stealth_is_initialized() || !A_bytes || !B_bytes) return -1;
+
+    element_t A, B;
+    element_init_G1(A, PAIRING);
+    element_init_G1(B, PAIRING);
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+
+    int result = stealth_registry_add(A, B, id);
+
+    element_clear(A); element_clear(B);
+    return result;
+}
+
+static int registry_find_simple(const unsigned char* bytes, int by_B) {
+    if (!stealth_is_initialized() || !bytes) return -1;
+
+    element_t e;
+    element_init_G1(e, PAIRING);
+    stealth_wire_from_bytes(e, bytes);
+    int id = by_B ? stealth_registry_find_B(e) : stealth_registry_find_A(e);
+    element_clear(e);
+    return id;
+}
+
+int stealth_registry_find_A_simple(const unsigned char* A_bytes) {
+    return registry_find_simple(A_bytes, 0);
+}
+
+int stealth_registry_find_B_simple(const unsigned char* B_bytes) {
+    return registry_find_simple(B_bytes, 1);
+}
+
+int stealth_registry_count_simple(void) {
+    return stealth_registry_count();
+}
+
+void stealth_registry_clear_simple(void) {
+    stealth_registry_clear();
+}
+
+int stealth_registry_add_addr_simple(const unsigned char* addr_bytes, int id, int owner) {
+    if (!stealth_is_initialized() || !addr_bytes) return -1;
+
+    element_t Addr;
+    element_init_G1(Addr, PAIRING);
+    int result = stealth_wire_from_bytes(Addr, addr_bytes) < 0 ? -1 : stealth_registry_add_addr(Addr, id, owner);
+    element_clear(Addr);
+    return result;
+}
+
+int stealth_registry_find_addr_simple(const unsigned char* addr_bytes, int* owner_out) {
+    int id, owner;
+    if (stealth_registry_find_addr_batch_simple(addr_bytes, 1, &id, &owner) < 0) return -1;
+    if (owner_out) *owner_out = owner;
+    return id;
+}
+
+int stealth_registry_find_addr_batch_simple(const unsigned char* addrs_bytes, int n, int* ids, int* owners) {
+    if (!stealth_is_initialized() || !addrs_bytes || !ids || n < 0) return -1;
+
+    element_t Addr;
+    element_init_G1(Addr, PAIRING);
+    int stride = stealth_wire_length(Addr);
+    int known = 0;
+    for (int i = 0; i < n; i++) {
+        int owner = -1;
+        // Bytes that do not decode to a point cannot be a known address
+        ids[i] = stealth_wire_from_bytes(Addr, addrs_bytes + (size_t)i * stride) < 0 ? -1 :
+                 stealth_registry_find_addr(Addr, &owner);
+        if (owners) owners[i] = ids[i] >= 0 ? owner : -1;
+        known += ids[i] >= 0;
+    }
+    element_clear(Addr);
+    return known;
+}
+
+int stealth_registry_addr_count_simple(void) {
+    return stealth_registry_addr_count();
+}
+
+void stealth_registry_clear_addrs_simple(void) {
+    stealth_registry_clear_addrs();
+}
+
 /**
  * Python Interface: Performance test
  */
@@ -376,7 +579,7 @@ void stealth_performance_test_simple(int iterations, double* results) {
     element_init_G1(B, PAIRING);
     element_init_Zr(a, PAIRING);
     element_init_Zr(b, PAIRING);
-    element_init_G1(TK, PAIRING);
+    element_init_G2(TK, PAIRING);
     element_init_Zr(k, PAIRING);
     
     stealth_keygen(A, B, a, b);
@@ -387,10 +590,10 @@ void stealth_performance_test_simple(int iterations, double* results) {
         element_t Addr, R1, R2, C, dsk, Q_sigma, hZ;
         element_init_G1(Addr, PAIRING);
         element_init_G1(R1, PAIRING);
-        element_init_G1(R2, PAIRING);
+        element_init_G2(R2, PAIRING);
         element_init_G1(C, PAIRING);
-        element_init_G1(dsk, PAIRING);
-        element_init_G1(Q_sigma, PAIRING);
+        element_init_G2(dsk, PAIRING);
+        element_init_G2(Q_sigma, PAIRING);
         element_init_Zr(hZ, PAIRING);
         
         // Test all operations
@@ -429,4 +632,1876 @@ void stealth_performance_test_simple(int iterations, double* results) {
     
     element_clear(A); element_clear(B); element_clear(a); element_clear(b);
     element_clear(TK); element_clear(k);
-}
\ No newline at end of file
+}
+
+/**
+ * Python Interface: Configurable benchmark
+ */
+int stealth_benchmark_simple(int ops, int iterations, int batch_size, int num_threads,
+                             int precompute, int warmup, double* results, int n) {
+    if (!results || n <= 0) return -1;
+    if (n > STEALTH_BENCH_OPS) n = STEALTH_BENCH_OPS;
+
+    stealth_bench_config_t cfg = {
+        (unsigned int)ops, iterations, batch_size, num_threads, precompute, warmup
+    };
+    stealth_bench_result_t r[STEALTH_BENCH_OPS];
+    int filled = stealth_benchmark(&cfg, r, n);
+
+    for (int i = 0; i < filled; i++) {
+        double* out = results + (size_t)i * STEALTH_BENCH_FIELDS;
+        out[0] = r[i].op;
+        out[1] = r[i].threads;
+        out[2] = (double)r[i].items;
+        out[3] = r[i].wall_ms;
+        out[4] = r[i].items_per_sec;
+        out[5] = r[i].setup_ms;
+        out[6] = r[i].mean_ms;
+        out[7] = r[i].p50_ms;
+        out[8] = r[i].p90_ms;
+        out[9] = r[i].p99_ms;
+        out[10] = r[i].max_ms;
+    }
+    return filled;
+}
+
+//----------------------------------------------
+// Batch Interface Implementation
+//----------------------------------------------
+
+/**
+ * Allocate n elements of field f, filled from a packed buffer if given
+ */
+static element_t* batch_alloc(int n, field_ptr f, const unsigned char* packed) {
+    element_t* v = malloc((size_t)n * sizeof(element_t));
+    if (!v) return NULL;
+    for (int i = 0; i < n; i++) element_init(v[i], f);
+    if (packed) stealth_wire_from_bytes_batch(v, packed, n);
+    return v;
+}
+
+static void batch_free(element_t* v, int n) {
+    if (!v) return;
+    for (int i = 0; i < n; i++) element_clear(v[i]);
+    free(v);
+}
+
+static void batch_store(element_t* v, int n, unsigned char* packed) {
+    int stride = stealth_wire_length(v[0]);
+    for (int i = 0; i < n; i++) stealth_wire_to_bytes(packed + (size_t)i * stride, v[i]);
+}
+
+int stealth_addr_gen_batch(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                           const unsigned char* TK_bytes, int n,
+                           unsigned char* addr_out, unsigned char* r1_out,
+                           unsigned char* r2_out, unsigned char* c_out) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!A_bytes || !B_bytes || !TK_bytes || !addr_out || !r1_out || !r2_out || !c_out) return -1;
+
+    int g1 = stealth_element_size_G1(), g2 = stealth_element_size_G2();
+    element_t TK, A, B, Addr, R1, R2, C;
+    element_init_G2(TK, PAIRING);
+    element_init_G1(A, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_G2(R2, PAIRING);
+    element_init_G1(C, PAIRING);
+    stealth_wire_from_bytes(TK, TK_bytes);
+
+    for (int i = 0; i < n; i++) {
+        size_t off = (size_t)i * g1;
+        stealth_wire_from_bytes(A, A_bytes + off);
+        stealth_wire_from_bytes(B, B_bytes + off);
+        stealth_addr_gen(Addr, R1, R2, C, A, B, TK);
+        stealth_wire_to_bytes(addr_out + off, Addr);
+        stealth_wire_to_bytes(r1_out + off, R1);
+        stealth_wire_to_bytes(r2_out + (size_t)i * g2, R2);
+        stealth_wire_to_bytes(c_out + off, C);
+    }
+
+    element_clear(TK); element_clear(A); element_clear(B);
+    element_clear(Addr); element_clear(R1); element_clear(R2); element_clear(C);
+    return n;
+}
+
+int stealth_addr_gen_block_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                  const unsigned char* TK_bytes, int n, int num_threads,
+                                  unsigned char* addr_out, unsigned char* r1_out,
+                                  unsigned char* r2_out, unsigned char* c_out,
+                                  unsigned char* tags_out) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!A_bytes || !B_bytes || !TK_bytes || !addr_out || !r1_out || !r2_out || !c_out) return -1;
+
+    element_t* A = batch_alloc(n, PAIRING->G1, A_bytes);
+    element_t* B = batch_alloc(n, PAIRING->G1, B_bytes);
+    element_t* Addr = batch_alloc(n, PAIRING->G1, NULL);
+    element_t* R1 = batch_alloc(n, PAIRING->G1, NULL);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, NULL);
+    element_t* C = batch_alloc(n, PAIRING->G1, NULL);
+    int generated = -1;
+
+    if (A && B && Addr && R1 && R2 && C) {
+        element_t TK;
+        element_init_G2(TK, PAIRING);
+        stealth_wire_from_bytes(TK, TK_bytes);
+
+        generated = stealth_addr_gen_block(Addr, R1, R2, C, tags_out, A, B, TK, n, num_threads);
+        if (generated == n) {
+            batch_store(Addr, n, addr_out);
+            batch_store(R1, n, r1_out);
+            batch_store(R2, n, r2_out);
+            batch_store(C, n, c_out);
+        }
+
+        element_clear(TK);
+    }
+
+    batch_free(A, n);
+    batch_free(B, n);
+    batch_free(Addr, n);
+    batch_free(R1, n);
+    batch_free(R2, n);
+    batch_free(C, n);
+    return generated;
+}
+
+int stealth_addr_gen_multi_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                  const unsigned char* TK_bytes, int n, int num_threads,
+                                  unsigned char* addr_out, unsigned char* r1_out,
+                                  unsigned char* r2_out, unsigned char* c_out,
+                                  unsigned char* tags_out) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!A_bytes || !B_bytes || !TK_bytes || !addr_out || !r1_out || !r2_out || !c_out) return -1;
+
+    element_t* A = batch_alloc(n, PAIRING->G1, A_bytes);
+    element_t* B = batch_alloc(n, PAIRING->G1, B_bytes);
+    element_t* Addr = batch_alloc(n, PAIRING->G1, NULL);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, NULL);
+    element_t* C = batch_alloc(n, PAIRING->G1, NULL);
+    int generated = -1;
+
+    if (A && B && Addr && R2 && C) {
+        element_t TK, R1;
+        element_init_G2(TK, PAIRING);
+        element_init_G1(R1, PAIRING);
+        stealth_wire_from_bytes(TK, TK_bytes);
+
+        generated = stealth_addr_gen_multi(Addr, R1, R2, C, tags_out, A, B, TK, n, num_threads);
+        if (generated == n) {
+            batch_store(Addr, n, addr_out);
+            stealth_wire_to_bytes(r1_out, R1);
+            batch_store(R2, n, r2_out);
+            batch_store(C, n, c_out);
+        }
+
+        element_clear(TK);
+        element_clear(R1);
+    }
+
+    batch_free(A, n);
+    batch_free(B, n);
+    batch_free(Addr, n);
+    batch_free(R2, n);
+    batch_free(C, n);
+    return generated;
+}
+
+int stealth_addr_recognize_fast_batch(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                      int n, const unsigned char* B_bytes,
+                                      const unsigned char* a_bytes, unsigned char* results) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!R1_bytes || !C_bytes || !B_bytes || !a_bytes || !results) return -1;
+
+    // C stays in its wire form, see stealth_scan_batch_bytes
+    element_t* R1 = batch_alloc(n, PAIRING->G1, R1_bytes);
+    unsigned char* bitmap = malloc((n + 7) / 8);
+    int matches = -1;
+
+    if (R1 && bitmap) {
+        element_t B, aZ;
+        element_init_G1(B, PAIRING);
+        element_init_Zr(aZ, PAIRING);
+        stealth_wire_from_bytes(B, B_bytes);
+        stealth_wire_from_bytes(aZ, a_bytes);
+
+        matches = stealth_scan_batch_bytes(R1, C_bytes, NULL, n, B, aZ, bitmap);
+        for (int i = 0; i < n; i++) results[i] = (bitmap[i >> 3] >> (i & 7)) & 1;
+
+        element_clear(B); element_clear(aZ);
+    }
+
+    free(bitmap);
+    batch_free(R1, n);
+    return matches;
+}
+
+int stealth_addr_audit_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                    const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                    int n, const unsigned char* B_bytes,
+                                    const unsigned char* a_bytes, const unsigned char* TK_bytes,
+                                    unsigned char* results) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r1_bytes || !r2_bytes || !c_bytes || !B_bytes || !a_bytes ||
+        !TK_bytes || !results) return -1;
+
+    element_t* Addr = batch_alloc(n, PAIRING->G1, addr_bytes);
+    element_t* R1 = batch_alloc(n, PAIRING->G1, r1_bytes);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, r2_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, c_bytes);
+    int valid = -1;
+
+    if (Addr && R1 && R2 && C) {
+        element_t B, aZ, TK;
+        element_init_G1(B, PAIRING);
+        element_init_Zr(aZ, PAIRING);
+        element_init_G2(TK, PAIRING);
+        stealth_wire_from_bytes(B, B_bytes);
+        stealth_wire_from_bytes(aZ, a_bytes);
+        stealth_wire_from_bytes(TK, TK_bytes);
+
+        valid = stealth_addr_audit_batch(Addr, R1, R2, C, n, B, aZ, TK, results);
+
+        element_clear(B); element_clear(aZ); element_clear(TK);
+    }
+
+    batch_free(Addr, n);
+    batch_free(R1, n);
+    batch_free(R2, n);
+    batch_free(C, n);
+    return valid;
+}
+
+int stealth_recognize_multi_simple(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                   const unsigned char* tag, const unsigned char* a_bytes,
+                                   const unsigned char* B_bytes, int n) {
+    if (!stealth_is_initialized() || n <= 0) return -2;
+    if (!R1_bytes || !C_bytes || !a_bytes || !B_bytes) return -2;
+
+    element_t* a = batch_alloc(n, PAIRING->Zr, a_bytes);
+    element_t* B = batch_alloc(n, PAIRING->G1, B_bytes);
+    int owner = -2;
+
+    if (a && B) {
+        element_t R1, C;
+        element_init_G1(R1, PAIRING);
+        element_init_G1(C, PAIRING);
+        stealth_wire_from_bytes(R1, R1_bytes);
+        stealth_wire_from_bytes(C, C_bytes);
+
+        owner = stealth_recognize_multi(R1, C, tag, a, B, n);
+
+        element_clear(R1); element_clear(C);
+    }
+
+    batch_free(a, n);
+    batch_free(B, n);
+    return owner;
+}
+
+int stealth_recognize_multi_block_simple(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                         const unsigned char* tags, const unsigned char* tagged,
+                                         int n, const unsigned char* a_bytes,
+                                         const unsigned char* B_bytes, int k, int num_threads,
+                                         int* owners) {
+    if (!stealth_is_initialized() || n <= 0 || k <= 0) return -1;
+    if (!R1_bytes || !C_bytes || !a_bytes || !B_bytes || !owners) return -1;
+
+    element_t* R1 = batch_alloc(n, PAIRING->G1, R1_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, C_bytes);
+    element_t* a = batch_alloc(k, PAIRING->Zr, a_bytes);
+    element_t* B = batch_alloc(k, PAIRING->G1, B_bytes);
+    int owned = -1;
+
+    if (R1 && C && a && B)
+        owned = stealth_recognize_multi_block(R1, C, tags, tagged, n, a, B, k, num_threads, owners);
+
+    batch_free(R1, n);
+    batch_free(C, n);
+    batch_free(a, k);
+    batch_free(B, k);
+    return owned;
+}
+
+int stealth_dsk_gen_batch(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                          int n, const unsigned char* a_bytes, const unsigned char* b_bytes,
+                          unsigned char* dsk_out) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r1_bytes || !a_bytes || !b_bytes || !dsk_out) return -1;
+
+    int g1 = stealth_element_size_G1(), g2 = stealth_element_size_G2();
+    element_t Addr, R1, aZ, bZ, dsk;
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+    element_init_Zr(bZ, PAIRING);
+    element_init_G2(dsk, PAIRING);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
+
+    for (int i = 0; i < n; i++) {
+        size_t off = (size_t)i * g1;
+        stealth_wire_from_bytes(Addr, addr_bytes + off);
+        stealth_wire_from_bytes(R1, r1_bytes + off);
+        stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
+        stealth_wire_to_bytes(dsk_out + (size_t)i * g2, dsk);
+    }
+
+    element_clear(Addr); element_clear(R1); element_clear(aZ); element_clear(bZ);
+    element_clear(dsk);
+    return n;
+}
+
+// The core takes C strings, so concatenated messages are copied out and
+// terminated; msgs[i] points into *text, both freed by the caller
+static const char** batch_messages(const char* messages, const int* message_lens, int n,
+                                   char** text) {
+    size_t total = 0;
+    for (int i = 0; i < n; i++) total += message_lens[i] > 0 ? (size_t)message_lens[i] : 0;
+    *text = malloc(total + n);
+    const char** msgs = malloc((size_t)n * sizeof(char*));
+    if (!*text || !msgs) {
+        free(*text);
+        free(msgs);
+        *text = NULL;
+        return NULL;
+    }
+
+    const char* next = messages;
+    char* out = *text;
+    for (int i = 0; i < n; i++) {
+        size_t len = message_lens[i] > 0 ? (size_t)message_lens[i] : 0;
+        memcpy(out, next, len);
+        out[len] = '\0';
+        msgs[i] = out;
+        next += len;
+        out += len + 1;
+    }
+    return msgs;
+}
+
+int stealth_verify_batch(const unsigned char* addr_bytes, const unsigned char* r2_bytes,
+                         const unsigned char* c_bytes, const char* messages,
+                         const int* message_lens, const unsigned char* h_bytes,
+                         const unsigned char* q_sigma_bytes, int n, unsigned char* results) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r2_bytes || !c_bytes || !messages || !message_lens ||
+        !h_bytes || !q_sigma_bytes || !results) return -1;
+
+    char* text;
+    const char** msgs = batch_messages(messages, message_lens, n, &text);
+
+    element_t* Addr = batch_alloc(n, PAIRING->G1, addr_bytes);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, r2_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, c_bytes);
+    element_t* hZ = batch_alloc(n, PAIRING->Zr, h_bytes);
+    element_t* Q_sigma = batch_alloc(n, PAIRING->G2, q_sigma_bytes);
+    int valid = -1;
+
+    if (msgs && Addr && R2 && C && hZ && Q_sigma) {
+        valid = stealth_verify_block(Addr, R2, C, msgs, hZ, Q_sigma, n, 0, results);
+    }
+
+    free(text);
+    free(msgs);
+    batch_free(Addr, n);
+    batch_free(R2, n);
+    batch_free(C, n);
+    batch_free(hZ, n);
+    batch_free(Q_sigma, n);
+    return valid;
+}
+
+int stealth_aggregate_batch(const unsigned char* addr_bytes, const unsigned char* c_bytes,
+                            const char* messages, const int* message_lens,
+                            const unsigned char* h_bytes, const unsigned char* q_sigma_bytes,
+                            int n, unsigned char* x_out, unsigned char* q_agg_out,
+                            unsigned char* results) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !c_bytes || !messages || !message_lens || !h_bytes ||
+        !q_sigma_bytes || !x_out || !q_agg_out || !results) return -1;
+
+    char* text;
+    const char** msgs = batch_messages(messages, message_lens, n, &text);
+
+    element_t* Addr = batch_alloc(n, PAIRING->G1, addr_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, c_bytes);
+    element_t* hZ = batch_alloc(n, PAIRING->Zr, h_bytes);
+    element_t* Q_sigma = batch_alloc(n, PAIRING->G2, q_sigma_bytes);
+    element_t* XGT = batch_alloc(n, PAIRING->GT, NULL);
+    int aggregated = -1;
+
+    if (msgs && Addr && C && hZ && Q_sigma && XGT) {
+        element_t Q_agg;
+        element_init_G2(Q_agg, PAIRING);
+        aggregated = stealth_aggregate(XGT, Q_agg, Addr, C, msgs, hZ, Q_sigma, n, 0, results);
+        if (aggregated == n) {
+            int stride = stealth_gt_compact_length(XGT[0]);
+            for (int i = 0; i < n; i++) stealth_gt_compact_to_bytes(x_out + (size_t)i * stride, XGT[i]);
+            stealth_wire_to_bytes(q_agg_out, Q_agg);
+        }
+        element_clear(Q_agg);
+    }
+
+    free(text);
+    free(msgs);
+    batch_free(Addr, n);
+    batch_free(C, n);
+    batch_free(hZ, n);
+    batch_free(Q_sigma, n);
+    batch_free(XGT, n);
+    return aggregated;
+}
+
+int stealth_verify_aggregate_batch(const unsigned char* addr_bytes, const unsigned char* r2_bytes,
+                                   const unsigned char* c_bytes, const char* messages,
+                                   const int* message_lens, const unsigned char* x_bytes,
+                                   const unsigned char* q_agg_bytes, int n) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r2_bytes || !c_bytes || !messages || !message_lens ||
+        !x_bytes || !q_agg_bytes) return -1;
+
+    char* text;
+    const char** msgs = batch_messages(messages, message_lens, n, &text);
+
+    element_t* Addr = batch_alloc(n, PAIRING->G1, addr_bytes);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, r2_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, c_bytes);
+    element_t* XGT = batch_alloc(n, PAIRING->GT, NULL);
+    int valid = -1;
+
+    if (msgs && Addr && R2 && C && XGT) {
+        int stride = stealth_gt_compact_length(XGT[0]);
+        for (int i = 0; i < n; i++) stealth_gt_compact_from_bytes(XGT[i], x_bytes + (size_t)i * stride);
+        element_t Q_agg;
+        element_init_G2(Q_agg, PAIRING);
+        stealth_wire_from_bytes(Q_agg, q_agg_bytes);
+        valid = stealth_verify_aggregate(Addr, R2, C, msgs, XGT, Q_agg, n);
+        element_clear(Q_agg);
+    }
+
+    free(text);
+    free(msgs);
+    batch_free(Addr, n);
+    batch_free(R2, n);
+    batch_free(C, n);
+    batch_free(XGT, n);
+    return valid;
+}
+
+int stealth_trace_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                               const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                               int n, const unsigned char* k_bytes,
+                               unsigned char* b_recovered_out) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!addr_bytes || !r1_bytes || !r2_bytes || !c_bytes || !k_bytes || !b_recovered_out) return -1;
+
+    element_t* Addr = batch_alloc(n, PAIRING->G1, addr_bytes);
+    element_t* R1 = batch_alloc(n, PAIRING->G1, r1_bytes);
+    element_t* R2 = batch_alloc(n, PAIRING->G2, r2_bytes);
+    element_t* C = batch_alloc(n, PAIRING->G1, c_bytes);
+    element_t* B = batch_alloc(n, PAIRING->G1, NULL);
+    int traced = -1;
+
+    if (Addr && R1 && R2 && C && B) {
+        element_t kZ;
+        element_init_Zr(kZ, PAIRING);
+        stealth_wire_from_bytes(kZ, k_bytes);
+
+        traced = stealth_trace_batch(B, Addr, R1, R2, C, n, kZ);
+        batch_store(B, n, b_recovered_out);
+
+        element_clear(kZ);
+    }
+
+    batch_free(Addr, n); batch_free(R1, n); batch_free(R2, n);
+    batch_free(C, n); batch_free(B, n);
+    return traced;
+}
+
+typedef struct {
+    int* owned;
+    unsigned char* dsk_out;
+    int count, g2;
+} ingest_out_t;
+
+static void ingest_collect(void* arg, int index, element_t dsk) {
+    ingest_out_t* out = (ingest_out_t*)arg;
+    out->owned[out->count] = index;
+    stealth_wire_to_bytes(out->dsk_out + (size_t)out->count * out->g2, dsk);
+    out->count++;
+}
+
+int stealth_ingest_simple(const unsigned char* records, int n, int tagged,
+                          const unsigned char* B_bytes, const unsigned char* a_bytes,
+                          const unsigned char* b_bytes, int* owned, unsigned char* dsk_out) {
+    if (!stealth_is_initialized() || n < 0) return -1;
+    if (!records || !B_bytes || !a_bytes || !b_bytes || !owned || !dsk_out) return -1;
+
+    element_t B, aZ, bZ;
+    element_init_G1(B, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+    element_init_Zr(bZ, PAIRING);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+    stealth_wire_from_bytes(bZ, b_bytes);
+
+    ingest_out_t out = { owned, dsk_out, 0, stealth_element_size_G2() };
+    int matches = stealth_ingest(records, n, tagged, B, aZ, bZ, ingest_collect, &out);
+
+    element_clear(B); element_clear(aZ); element_clear(bZ);
+    return matches;
+}
+
+//----------------------------------------------
+// Handle-based Interface Implementation
+//----------------------------------------------
+
+typedef struct {
+    int type;          // 0 when the slot is free
+    int next_free;     // Next free handle while free, 0 for none
+    element_t e;
+} stealth_handle_slot_t;
+
+// Slots are allocated one by one and never move, so the element of a live
+// handle stays in place while the table grows under other threads; the
+// lock covers the table and the free list, not the elements.
+static pthread_mutex_t handle_lock = PTHREAD_MUTEX_INITIALIZER;
+static stealth_handle_slot_t** handle_slots = NULL;
+static int handle_capacity = 0;
+static int handle_used = 0;        // Slots allocated, live or free
+static int handle_free_head = 0;   // First free handle, 0 for none
+static int handle_live = 0;
+
+/**
+ * Handle type of an element group: G2 is G1 under a symmetric pairing
+ */
+static int handle_type(int type) {
+    return type == STEALTH_HANDLE_G2 && !stealth_is_asymmetric() ? STEALTH_HANDLE_G1 : type;
+}
+
+/**
+ * Take a slot off the free list, or allocate one; returns the handle or -1.
+ * Called with handle_lock held.
+ */
+static int handle_take(void) {
+    if (handle_free_head) {
+        int h = handle_free_head;
+        handle_free_head = handle_slots[h - 1]->next_free;
+        return h;
+    }
+    if (handle_used == handle_capacity) {
+        int new_cap = handle_capacity ? handle_capacity * 2 : 64;
+        stealth_handle_slot_t** grown = realloc(handle_slots, new_cap * sizeof(*grown));
+        if (!grown) return -1;
+        handle_slots = grown;
+        handle_capacity = new_cap;
+    }
+    stealth_handle_slot_t* slot = calloc(1, sizeof(*slot));
+    if (!slot) return -1;
+    handle_slots[handle_used++] = slot;
+    return handle_used;
+}
+
+/**
+ * Allocate a slot and initialize its element; returns the handle or -1
+ */
+static int handle_new(int type) {
+    if (!stealth_is_initialized()) return -1;
+    type = handle_type(type);
+    if (type != STEALTH_HANDLE_G1 && type != STEALTH_HANDLE_G2 && type != STEALTH_HANDLE_ZR) return -1;
+
+    pthread_mutex_lock(&handle_lock);
+    int h = handle_take();
+    if (h > 0) {
+        stealth_handle_slot_t* slot = handle_slots[h - 1];
+        if (type == STEALTH_HANDLE_G1) element_init_G1(slot->e, PAIRING);
+        else if (type == STEALTH_HANDLE_G2) element_init_G2(slot->e, PAIRING);
+        else element_init_Zr(slot->e, PAIRING);
+        slot->type = type;
+        handle_live++;
+    }
+    pthread_mutex_unlock(&handle_lock);
+    return h;
+}
+
+/**
+ * Look up the slot of a live handle, of any type if type is 0; NULL if invalid
+ */
+static stealth_handle_slot_t* handle_slot(int h, int type) {
+    stealth_handle_slot_t* slot = NULL;
+    pthread_mutex_lock(&handle_lock);
+    if (h >= 1 && h <= handle_used && handle_slots[h - 1]->type &&
+        (!type || handle_slots[h - 1]->type == handle_type(type)))
+        slot = handle_slots[h - 1];
+    pthread_mutex_unlock(&handle_lock);
+    return slot;
+}
+
+/**
+ * Look up a live handle of the given type; returns NULL if invalid
+ */
+static element_ptr handle_get(int h, int type) {
+    stealth_handle_slot_t* slot = handle_slot(h, type);
+    return slot ? slot->e : NULL;
+}
+
+/**
+ * Allocate several handles at once; on failure none are kept
+ */
+static int handle_new_n(int type, int n, int* out[]) {
+    for (int i = 0; i < n; i++) {
+        *out[i] = handle_new(type);
+        if (*out[i] < 0) {
+            while (i-- > 0) stealth_handle_free(*out[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int stealth_handle_import(int type, const unsigned char* bytes, int len) {
+    if (!bytes) return -1;
+    int need = type == STEALTH_HANDLE_G1 ? stealth_element_size_G1() :
+               type == STEALTH_HANDLE_G2 ? stealth_element_size_G2() : stealth_element_size_Zr();
+    if (need <= 0 || len < need) return -1;
+
+    int h = handle_new(type);
+    if (h < 0) return -1;
+    if (stealth_wire_from_bytes(handle_get(h, type), bytes) < 0) {
+        stealth_handle_free(h);
+        return -1;
+    }
+    return h;
+}
+
+int stealth_handle_export(int h, unsigned char* out, int buf_size) {
+    stealth_handle_slot_t* slot = handle_slot(h, 0);
+    if (!slot || !out) return -1;
+    return stealth_element_to_bytes(slot->e, out, buf_size);
+}
+
+int stealth_handle_free(int h) {
+    int result = -1;
+    pthread_mutex_lock(&handle_lock);
+    if (h >= 1 && h <= handle_used && handle_slots[h - 1]->type) {
+        stealth_handle_slot_t* slot = handle_slots[h - 1];
+        element_clear(slot->e);
+        slot->type = 0;
+        slot->next_free = handle_free_head;
+        handle_free_head = h;
+        handle_live--;
+        result = 0;
+    }
+    pthread_mutex_unlock(&handle_lock);
+    return result;
+}
+
+void stealth_handle_free_all(void) {
+    pthread_mutex_lock(&handle_lock);
+    for (int i = 0; i < handle_used; i++) {
+        if (handle_slots[i]->type) element_clear(handle_slots[i]->e);
+        free(handle_slots[i]);
+    }
+    free(handle_slots);
+    handle_slots = NULL;
+    handle_capacity = 0;
+    handle_used = 0;
+    handle_free_head = 0;
+    handle_live = 0;
+    pthread_mutex_unlock(&handle_lock);
+}
+
+int stealth_handle_count(void) {
+    return handle_live;
+}
+
+int stealth_keygen_h(int* A_out, int* B_out, int* a_out, int* b_out) {
+    if (!A_out || !B_out || !a_out || !b_out) return -1;
+    int* g1[] = { A_out, B_out };
+    int* zr[] = { a_out, b_out };
+    if (handle_new_n(STEALTH_HANDLE_G1, 2, g1) < 0) return -1;
+    if (handle_new_n(STEALTH_HANDLE_ZR, 2, zr) < 0) {
+        stealth_handle_free(*A_out); stealth_handle_free(*B_out);
+        return -1;
+    }
+
+    stealth_keygen(handle_get(*A_out, STEALTH_HANDLE_G1), handle_get(*B_out, STEALTH_HANDLE_G1),
+                   handle_get(*a_out, STEALTH_HANDLE_ZR), handle_get(*b_out, STEALTH_HANDLE_ZR));
+    return 0;
+}
+
+int stealth_tracekeygen_h(int* TK_out, int* k_out) {
+    if (!TK_out || !k_out) return -1;
+    *TK_out = handle_new(STEALTH_HANDLE_G2);
+    if (*TK_out < 0) return -1;
+    *k_out = handle_new(STEALTH_HANDLE_ZR);
+    if (*k_out < 0) {
+        stealth_handle_free(*TK_out);
+        return -1;
+    }
+
+    stealth_tracekeygen(handle_get(*TK_out, STEALTH_HANDLE_G2), handle_get(*k_out, STEALTH_HANDLE_ZR));
+    return 0;
+}
+
+int stealth_addr_gen_h(int A, int B, int TK,
+                       int* addr_out, int* r1_out, int* r2_out, int* c_out) {
+    element_ptr eA = handle_get(A, STEALTH_HANDLE_G1);
+    element_ptr eB = handle_get(B, STEALTH_HANDLE_G1);
+    element_ptr eTK = handle_get(TK, STEALTH_HANDLE_G2);
+    if (!eA || !eB || !eTK || !addr_out || !r1_out || !r2_out || !c_out) return -1;
+
+    int* outs[] = { addr_out, r1_out, c_out };
+    if (handle_new_n(STEALTH_HANDLE_G1, 3, outs) < 0) return -1;
+    *r2_out = handle_new(STEALTH_HANDLE_G2);
+    if (*r2_out < 0) {
+        stealth_handle_free(*addr_out); stealth_handle_free(*r1_out); stealth_handle_free(*c_out);
+        return -1;
+    }
+
+    // Slots may have moved while allocating
+    stealth_addr_gen(handle_get(*addr_out, STEALTH_HANDLE_G1), handle_get(*r1_out, STEALTH_HANDLE_G1),
+                     handle_get(*r2_out, STEALTH_HANDLE_G2), handle_get(*c_out, STEALTH_HANDLE_G1),
+                     handle_get(A, STEALTH_HANDLE_G1), handle_get(B, STEALTH_HANDLE_G1),
+                     handle_get(TK, STEALTH_HANDLE_G2));
+    return 0;
+}
+
+int stealth_addr_recognize_fast_h(int R1, int B, int A, int C, int a) {
+    element_ptr eR1 = handle_get(R1, STEALTH_HANDLE_G1);
+    element_ptr eB = handle_get(B, STEALTH_HANDLE_G1);
+    element_ptr eA = handle_get(A, STEALTH_HANDLE_G1);
+    element_ptr eC = handle_get(C, STEALTH_HANDLE_G1);
+    element_ptr ea = handle_get(a, STEALTH_HANDLE_ZR);
+    if (!eR1 || !eB || !eA || !eC || !ea) return -1;
+
+    return stealth_addr_recognize_fast(eR1, eB, eA, eC, ea);
+}
+
+int stealth_dsk_gen_h(int Addr, int R1, int a, int b, int* dsk_out) {
+    if (!handle_get(Addr, STEALTH_HANDLE_G1) || !handle_get(R1, STEALTH_HANDLE_G1) ||
+        !handle_get(a, STEALTH_HANDLE_ZR) || !handle_get(b, STEALTH_HANDLE_ZR) || !dsk_out)
+        return -1;
+
+    *dsk_out = handle_new(STEALTH_HANDLE_G2);
+    if (*dsk_out < 0) return -1;
+
+    stealth_onetime_skgen(handle_get(*dsk_out, STEALTH_HANDLE_G2),
+                          handle_get(Addr, STEALTH_HANDLE_G1), handle_get(R1, STEALTH_HANDLE_G1),
+                          handle_get(a, STEALTH_HANDLE_ZR), handle_get(b, STEALTH_HANDLE_ZR));
+    return 0;
+}
+
+int stealth_sign_with_dsk_h(int Addr, int dsk, const char* message,
+                            int* q_sigma_out, int* h_out) {
+    if (!handle_get(Addr, STEALTH_HANDLE_G1) || !handle_get(dsk, STEALTH_HANDLE_G2) ||
+        !message || !q_sigma_out || !h_out)
+        return -1;
+
+    *q_sigma_out = handle_new(STEALTH_HANDLE_G2);
+    if (*q_sigma_out < 0) return -1;
+    *h_out = handle_new(STEALTH_HANDLE_ZR);
+    if (*h_out < 0) {
+        stealth_handle_free(*q_sigma_out);
+        return -1;
+    }
+
+    stealth_sign(handle_get(*q_sigma_out, STEALTH_HANDLE_G2), handle_get(*h_out, STEALTH_HANDLE_ZR),
+                 handle_get(Addr, STEALTH_HANDLE_G1), handle_get(dsk, STEALTH_HANDLE_G2), message);
+    return 0;
+}
+
+int stealth_verify_h(int Addr, int R2, int C, const char* message, int h, int q_sigma) {
+    element_ptr eAddr = handle_get(Addr, STEALTH_HANDLE_G1);
+    element_ptr eR2 = handle_get(R2, STEALTH_HANDLE_G2);
+    element_ptr eC = handle_get(C, STEALTH_HANDLE_G1);
+    element_ptr eh = handle_get(h, STEALTH_HANDLE_ZR);
+    element_ptr eQ = handle_get(q_sigma, STEALTH_HANDLE_G2);
+    if (!eAddr || !eR2 || !eC || !eh || !eQ || !message) return -1;
+
+    return stealth_verify(eAddr, eR2, eC, message, eh, eQ);
+}
+
+int stealth_trace_h(int Addr, int R1, int R2, int C, int k, int* b_out) {
+    if (!handle_get(Addr, STEALTH_HANDLE_G1) || !handle_get(R1, STEALTH_HANDLE_G1) ||
+        !handle_get(R2, STEALTH_HANDLE_G2) || !handle_get(C, STEALTH_HANDLE_G1) ||
+        !handle_get(k, STEALTH_HANDLE_ZR) || !b_out)
+        return -1;
+
+    *b_out = handle_new(STEALTH_HANDLE_G1);
+    if (*b_out < 0) return -1;
+
+    stealth_trace(handle_get(*b_out, STEALTH_HANDLE_G1), handle_get(Addr, STEALTH_HANDLE_G1),
+                  handle_get(R1, STEALTH_HANDLE_G1), handle_get(R2, STEALTH_HANDLE_G2),
+                  handle_get(C, STEALTH_HANDLE_G1), handle_get(k, STEALTH_HANDLE_ZR));
+    return 0;
+}
+
+//----------------------------------------------
+// View Tag Interface
+//----------------------------------------------
+
+int stealth_view_tag_length(void) {
+    return STEALTH_VIEW_TAG_LEN;
+}
+
+void stealth_addr_gen_tagged_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                    const unsigned char* TK_bytes,
+                                    unsigned char* addr_out, unsigned char* r1_out,
+                                    unsigned char* r2_out, unsigned char* c_out,
+                                    unsigned char* tag_out, int buf_size) {
+    if (!stealth_is_initialized() || !tag_out) return;
+
+    element_t A, B, TK, Addr, R1, R2, C;
+    element_init_G1(A, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_G2(TK, PAIRING);
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_G2(R2, PAIRING);
+    element_init_G1(C, PAIRING);
+
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(TK, TK_bytes);
+
+    stealth_addr_gen_tagged(Addr, R1, R2, C, tag_out, A, B, TK);
+
+    memset(addr_out, 0, buf_size);
+    memset(r1_out, 0, buf_size);
+    memset(r2_out, 0, buf_size);
+    memset(c_out, 0, buf_size);
+
+    stealth_wire_to_bytes(addr_out, Addr);
+    stealth_wire_to_bytes(r1_out, R1);
+    stealth_wire_to_bytes(r2_out, R2);
+    stealth_wire_to_bytes(c_out, C);
+
+    element_clear(A); element_clear(B); element_clear(TK);
+    element_clear(Addr); element_clear(R1); element_clear(R2); element_clear(C);
+}
+
+int stealth_addr_recognize_fast_tagged_simple(const unsigned char* R1_bytes,
+                                              const unsigned char* B_bytes,
+                                              const unsigned char* C_bytes,
+                                              const unsigned char* tag,
+                                              const unsigned char* a_bytes) {
+    if (!stealth_is_initialized() || !tag) return 0;
+
+    element_t R1, B, aZ;
+    element_init_G1(R1, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+
+    stealth_wire_from_bytes(R1, R1_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+
+    int result = stealth_addr_recognize_fast_bytes(R1, B, C_bytes, tag, aZ);
+
+    element_clear(R1); element_clear(B); element_clear(aZ);
+    return result;
+}
+
+int stealth_addr_recognize_fast_tagged_batch(const unsigned char* R1_bytes,
+                                             const unsigned char* C_bytes,
+                                             const unsigned char* tags, int n,
+                                             const unsigned char* B_bytes,
+                                             const unsigned char* a_bytes,
+                                             unsigned char* results) {
+    if (!stealth_is_initialized() || n <= 0) return -1;
+    if (!R1_bytes || !C_bytes || !tags || !B_bytes || !a_bytes || !results) return -1;
+
+    element_t* R1 = batch_alloc(n, PAIRING->G1, R1_bytes);
+    unsigned char* bitmap = malloc((n + 7) / 8);
+    int matches = -1;
+
+    if (R1 && bitmap) {
+        element_t B, aZ;
+        element_init_G1(B, PAIRING);
+        element_init_Zr(aZ, PAIRING);
+        stealth_wire_from_bytes(B, B_bytes);
+        stealth_wire_from_bytes(aZ, a_bytes);
+
+        matches = stealth_scan_batch_bytes(R1, C_bytes, tags, n, B, aZ, bitmap);
+        for (int i = 0; i < n; i++) results[i] = (bitmap[i >> 3] >> (i & 7)) & 1;
+
+        element_clear(B); element_clear(aZ);
+    }
+
+    free(bitmap);
+    batch_free(R1, n);
+    return matches;
+}
+
+int stealth_addr_gen_tagged_h(int A, int B, int TK,
+                              int* addr_out, int* r1_out, int* r2_out, int* c_out,
+                              unsigned char* tag_out) {
+    if (!handle_get(A, STEALTH_HANDLE_G1) || !handle_get(B, STEALTH_HANDLE_G1) ||
+        !handle_get(TK, STEALTH_HANDLE_G2) || !tag_out)
+        return -1;
+    if (!addr_out || !r1_out || !r2_out || !c_out) return -1;
+
+    int* outs[] = { addr_out, r1_out, c_out };
+    if (handle_new_n(STEALTH_HANDLE_G1, 3, outs) < 0) return -1;
+    *r2_out = handle_new(STEALTH_HANDLE_G2);
+    if (*r2_out < 0) {
+        stealth_handle_free(*addr_out); stealth_handle_free(*r1_out); stealth_handle_free(*c_out);
+        return -1;
+    }
+
+    stealth_addr_gen_tagged(handle_get(*addr_out, STEALTH_HANDLE_G1), handle_get(*r1_out, STEALTH_HANDLE_G1),
+                            handle_get(*r2_out, STEALTH_HANDLE_G2), handle_get(*c_out, STEALTH_HANDLE_G1),
+                            tag_out, handle_get(A, STEALTH_HANDLE_G1), handle_get(B, STEALTH_HANDLE_G1),
+                            handle_get(TK, STEALTH_HANDLE_G2));
+    return 0;
+}
+
+int stealth_addr_recognize_fast_tagged_h(int R1, int B, int C, const unsigned char* tag, int a) {
+    element_ptr eR1 = handle_get(R1, STEALTH_HANDLE_G1);
+    element_ptr eB = handle_get(B, STEALTH_HANDLE_G1);
+    element_ptr eC = handle_get(C, STEALTH_HANDLE_G1);
+    element_ptr ea = handle_get(a, STEALTH_HANDLE_ZR);
+    if (!eR1 || !eB || !eC || !ea || !tag) return -1;
+
+    return stealth_addr_recognize_fast_tagged(eR1, eB, eC, tag, ea);
+}
+
+//----------------------------------------------
+// Store Interface Implementation
+//----------------------------------------------
+
+typedef struct {
+    const char* types;           // 'G' = G1, 'H' = G2, 'Z' = Zr, in record order;
+                                 // 'g', 'h' = compact G1, G2 points
+    int meta;
+} store_layout_t;
+
+static const store_layout_t store_layouts[] = {
+    [STEALTH_STORE_KEYS]   = { "GGZZ", 0 },
+    [STEALTH_STORE_ADDRS]  = { "gghg", STEALTH_STORE_ADDR_META },
+    [STEALTH_STORE_DSKS]   = { "H", STEALTH_STORE_DSK_META },
+    [STEALTH_STORE_SYSTEM] = { "GHZ", 0 },
+    [STEALTH_STORE_CURSORS] = { "", STEALTH_STORE_CURSOR_META },
+    [STEALTH_STORE_TRACES] = { "G", STEALTH_STORE_TRACE_META },
+};
+
+#define STORE_SCAN_CHUNK 256
+// Trace store whose chains the registry heads
+static int trace_index_h = -1;
+// Outputs per worker pool run of stealth_store_scan_owners_simple
+#define STORE_OWNER_CHUNK 4096
+
+static const store_layout_t* store_layout(int kind) {
+    if (kind < STEALTH_STORE_KEYS || kind > STEALTH_STORE_TRACES) return NULL;
+    return &store_layouts[kind];
+}
+
+static int store_elem_size(char type) {
+    switch (type) {
+    case 'G': return pairing_length_in_bytes_G1(PAIRING);
+    case 'H': return pairing_length_in_bytes_G2(PAIRING);
+    case 'g': return pairing_length_in_bytes_compressed_G1(PAIRING);
+    case 'h': return pairing_length_in_bytes_compressed_G2(PAIRING);
+    default:  return pairing_length_in_bytes_Zr(PAIRING);
+    }
+}
+
+static int store_compact(char type) {
+    return type == 'g' || type == 'h';
+}
+
+/**
+ * Offset of element i of a record (i = strlen(types) gives the metadata)
+ */
+static int store_offset(const store_layout_t* l, int i) {
+    int off = 0;
+    for (int j = 0; j < i; j++) off += store_elem_size(l->types[j]);
+    return off;
+}
+
+static void store_elem_init(element_t e, char type) {
+    if (type == 'G' || type == 'g') element_init_G1(e, PAIRING);
+    else if (type == 'H' || type == 'h') element_init_G2(e, PAIRING);
+    else element_init_Zr(e, PAIRING);
+}
+
+/**
+ * Whether an element of the type is stored in the current wire format,
+ * so that its record bytes serve without decoding
+ */
+static int store_is_wire(char type) {
+    element_t e;
+    store_elem_init(e, type);
+    // Compact and full encodings of a point differ in length
+    int same = stealth_wire_length(e) == store_elem_size(type);
+    element_clear(e);
+    return same;
+}
+
+static void store_put(unsigned char* p, element_t e, char type) {
+    if (store_compact(type)) stealth_compact_to_bytes(p, e);
+    else prim_to_bytes(p, e);
+}
+
+static void store_get(element_t e, const unsigned char* p, char type) {
+    if (store_compact(type)) stealth_compact_from_bytes(e, p);
+    else prim_from_bytes(e, (unsigned char*)p);
+}
+
+/**
+ * Record of an open store, NULL if the handle, kind or index is wrong
+ */
+static const unsigned char* store_record_of(int h, int kind, long index) {
+    if (!stealth_is_initialized() || (int)stealth_store_kind(h) != kind) return NULL;
+    return stealth_store_record(h, index);
+}
+
+/**
+ * Load element i of a record
+ */
+static void store_load(element_t e, const unsigned char* rec, int kind, int i) {
+    const store_layout_t* l = store_layout(kind);
+    store_elem_init(e, l->types[i]);
+    store_get(e, rec + store_offset(l, i), l->types[i]);
+}
+
+/**
+ * Copy element i of records start..start+m-1 of a store back to back into buf
+ */
+static void store_gather(unsigned char* buf, int h, long start, int m, int kind, int i) {
+    const store_layout_t* l = store_layout(kind);
+    int off = store_offset(l, i), len = store_elem_size(l->types[i]);
+    for (int j = 0; j < m; j++)
+        memcpy(buf + (size_t)j * len, stealth_store_record(h, start + j) + off, len);
+}
+
+/**
+ * Load element i of records start..start+m-1 into the initialized e[],
+ * compact points through one batch decompression; buf is scratch for m
+ * compact points
+ */
+static void store_load_column(element_t e[], int h, long start, int m, int kind, int i,
+                              unsigned char* buf) {
+    const store_layout_t* l = store_layout(kind);
+    if (!store_compact(l->types[i])) {
+        for (int j = 0; j < m; j++) store_get(e[j], stealth_store_record(h, start + j) + store_offset(l, i),
+                                              l->types[i]);
+        return;
+    }
+    store_gather(buf, h, start, m, kind, i);
+    stealth_compact_from_bytes_batch(e, buf, m);
+}
+
+int stealth_store_open_simple(const char* path, int kind) {
+    const store_layout_t* l = store_layout(kind);
+    if (!stealth_is_initialized() || !path || !l) return -1;
+    int n = (int)strlen(l->types);
+    return stealth_store_open(path, (uint32_t)kind, (uint32_t)(store_offset(l, n) + l->meta));
+}
+
+long stealth_store_append_simple(int h, const unsigned char* elems, const unsigned char* meta) {
+    int kind = (int)stealth_store_kind(h);
+    const store_layout_t* l = store_layout(kind);
+    if (!stealth_is_initialized() || !l || !elems) return -1;
+
+    int n = (int)strlen(l->types);
+    int meta_off = store_offset(l, n);
+    unsigned char* rec = calloc(1, meta_off + l->meta);
+    if (!rec) return -1;
+
+    for (int i = 0; i < n; i++) {
+        element_t e;
+        store_elem_init(e, l->types[i]);
+        int len = stealth_wire_from_bytes(e, elems);
+        store_put(rec + store_offset(l, i), e, l->types[i]);
+        element_clear(e);
+        // Records with points outside the group are not stored
+        if (len < 0) {
+            free(rec);
+            return -1;
+        }
+        elems += len;
+    }
+    if (meta) memcpy(rec + meta_off, meta, l->meta);
+
+    long index = stealth_store_append(h, rec);
+    free(rec);
+    return index;
+}
+
+int stealth_store_get_simple(int h, long index, unsigned char* elems_out, unsigned char* meta_out) {
+    int kind = (int)stealth_store_kind(h);
+    const unsigned char* rec = store_record_of(h, kind, index);
+    if (!rec || !elems_out) return -1;
+
+    const store_layout_t* l = store_layout(kind);
+    int n = (int)strlen(l->types);
+    for (int i = 0; i < n; i++) {
+        if (store_is_wire(l->types[i])) {
+            int len = store_elem_size(l->types[i]);
+            memcpy(elems_out, rec + store_offset(l, i), len);
+            elems_out += len;
+            continue;
+        }
+        element_t e;
+        store_load(e, rec, kind, i);
+        elems_out += stealth_wire_to_bytes(elems_out, e);
+        element_clear(e);
+    }
+    if (meta_out) memcpy(meta_out, rec + store_offset(l, n), l->meta);
+    return 0;
+}
+
+long stealth_store_count_simple(int h) {
+    return stealth_store_count(h);
+}
+
+int stealth_store_reset_simple(int h) {
+    return stealth_store_reset(h);
+}
+
+int stealth_store_sync_simple(int h) {
+    return stealth_store_sync(h);
+}
+
+void stealth_store_close_simple(int h) {
+    // The handle may come back for another file
+    if (h == trace_index_h) trace_index_h = -1;
+    stealth_store_close(h);
+}
+
+int stealth_store_save_system_simple(int h, const unsigned char* TK_bytes, const unsigned char* k_bytes) {
+    if (!stealth_is_initialized() || !TK_bytes || !k_bytes) return -1;
+    if ((int)stealth_store_kind(h) != STEALTH_STORE_SYSTEM) return -1;
+
+    element_t g, TK, kZ;
+    element_init_G1(g, PAIRING);
+    element_init_G2(TK, PAIRING);
+    element_init_Zr(kZ, PAIRING);
+    stealth_get_generator(g);
+    stealth_wire_from_bytes(TK, TK_bytes);
+    stealth_wire_from_bytes(kZ, k_bytes);
+
+    unsigned char* packed = malloc(stealth_wire_length(g) + stealth_wire_length(TK) + stealth_wire_length(kZ));
+    long index = -1;
+    if (packed) {
+        int off = stealth_wire_to_bytes(packed, g);
+        off += stealth_wire_to_bytes(packed + off, TK);
+        stealth_wire_to_bytes(packed + off, kZ);
+        // A store holds one session; saving again replaces it
+        stealth_store_reset(h);
+        index = stealth_store_append_simple(h, packed, NULL);
+        free(packed);
+    }
+
+    element_clear(g); element_clear(TK); element_clear(kZ);
+    return index == 0 ? 0 : -1;
+}
+
+int stealth_store_load_system_simple(int h, unsigned char* TK_out, unsigned char* k_out, int buf_size) {
+    if (!stealth_is_initialized() || !TK_out || !k_out) return -1;
+    if ((int)stealth_store_kind(h) != STEALTH_STORE_SYSTEM) return -1;
+    if (stealth_store_count(h) == 0) return 0;
+
+    const unsigned char* rec = store_record_of(h, STEALTH_STORE_SYSTEM, 0);
+    element_t g, TK, kZ;
+    store_load(g, rec, STEALTH_STORE_SYSTEM, 0);
+    store_load(TK, rec, STEALTH_STORE_SYSTEM, 1);
+    store_load(kZ, rec, STEALTH_STORE_SYSTEM, 2);
+
+    stealth_set_generator(g);
+    memset(TK_out, 0, buf_size);
+    memset(k_out, 0, buf_size);
+    stealth_wire_to_bytes(TK_out, TK);
+    stealth_wire_to_bytes(k_out, kZ);
+
+    element_clear(g); element_clear(TK); element_clear(kZ);
+    return 1;
+}
+
+static stealth_recipient_ctx_t* key_ctx_get(long index, element_t A, element_t B);
+
+int stealth_store_recognize_fast_simple(int addr_h, long addr_index, int key_h, long key_index) {
+    const unsigned char* addr = store_record_of(addr_h, STEALTH_STORE_ADDRS, addr_index);
+    const unsigned char* key = store_record_of(key_h, STEALTH_STORE_KEYS, key_index);
+    if (!addr || !key) return -1;
+
+    const store_layout_t* l = &store_layouts[STEALTH_STORE_ADDRS];
+    const unsigned char* meta = addr + store_offset(l, 4);
+    const unsigned char* tag = meta[4] & STEALTH_STORE_FLAG_TAGGED ? meta + 5 : NULL;
+    // C is only compared, so it is never decompressed
+    const unsigned char* C_compact = addr + store_offset(l, 3);
+    element_t R1, A, B, aZ;
+    store_load(R1, addr, STEALTH_STORE_ADDRS, 1);
+    store_load(A, key, STEALTH_STORE_KEYS, 0);
+    store_load(B, key, STEALTH_STORE_KEYS, 1);
+    store_load(aZ, key, STEALTH_STORE_KEYS, 2);
+
+    int result;
+    stealth_recipient_ctx_t* ctx = key_ctx_get(key_index, A, B);
+    if (ctx) result = stealth_addr_recognize_fast_ctx_compact(R1, C_compact, tag, aZ, ctx);
+    else result = stealth_addr_recognize_fast_compact(R1, B, C_compact, tag, aZ);
+
+    element_clear(R1); element_clear(A); element_clear(B); element_clear(aZ);
+    return result;
+}
+
+long stealth_store_scan_simple(int addr_h, long start, long n, int key_h, long key_index,
+                               unsigned char* results) {
+    const unsigned char* key = store_record_of(key_h, STEALTH_STORE_KEYS, key_index);
+    if (!key || !results || start < 0 || n < 0) return -1;
+    if (stealth_store_kind(addr_h) != STEALTH_STORE_ADDRS || start + n > stealth_store_count(addr_h)) return -1;
+
+    const store_layout_t* l = &store_layouts[STEALTH_STORE_ADDRS];
+    int meta_off = store_offset(l, 4);
+    element_t* R1 = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G1, NULL);
+    unsigned char* col = malloc((size_t)STORE_SCAN_CHUNK * store_elem_size('g'));
+    // C is only compared, so it is never decompressed
+    unsigned char* C_compact = malloc((size_t)STORE_SCAN_CHUNK * store_elem_size('g'));
+    unsigned char tags[STORE_SCAN_CHUNK * STEALTH_VIEW_TAG_LEN];
+    unsigned char bitmap[STORE_SCAN_CHUNK / 8];
+    long matches = -1;
+
+    if (R1 && col && C_compact) {
+        element_t B, aZ;
+        store_load(B, key, STEALTH_STORE_KEYS, 1);
+        store_load(aZ, key, STEALTH_STORE_KEYS, 2);
+
+        matches = 0;
+        for (long base = 0; base < n; base += STORE_SCAN_CHUNK) {
+            int m = (int)(n - base < STORE_SCAN_CHUNK ? n - base : STORE_SCAN_CHUNK);
+            int tagged = 1;
+            store_load_column(R1, addr_h, start + base, m, STEALTH_STORE_ADDRS, 1, col);
+            store_gather(C_compact, addr_h, start + base, m, STEALTH_STORE_ADDRS, 3);
+            for (int i = 0; i < m; i++) {
+                const unsigned char* rec = stealth_store_record(addr_h, start + base + i);
+                tagged &= rec[meta_off + 4] & STEALTH_STORE_FLAG_TAGGED;
+                memcpy(tags + i * STEALTH_VIEW_TAG_LEN, rec + meta_off + 5, STEALTH_VIEW_TAG_LEN);
+            }
+            // The tag prefilter needs a tag on every output of the chunk
+            matches += stealth_scan_batch_compact(R1, C_compact, tagged ? tags : NULL, m, B, aZ, bitmap);
+            for (int i = 0; i < m; i++) results[base + i] = (bitmap[i >> 3] >> (i & 7)) & 1;
+        }
+
+        element_clear(B); element_clear(aZ);
+    }
+
+    batch_free(R1, STORE_SCAN_CHUNK);
+    free(col);
+    free(C_compact);
+    return matches;
+}
+
+long stealth_store_scan_owners_simple(int addr_h, long start, long n, int key_h,
+                                      const long* key_indices, int k, int num_threads,
+                                      int* owners) {
+    if (!stealth_is_initialized() || !owners || start < 0 || n < 0 || k <= 0) return -1;
+    if (stealth_store_kind(key_h) != STEALTH_STORE_KEYS) return -1;
+    if (stealth_store_kind(addr_h) != STEALTH_STORE_ADDRS || start + n > stealth_store_count(addr_h)) return -1;
+
+    element_t* aZ = malloc((size_t)k * sizeof(element_t));
+    element_t* B = malloc((size_t)k * sizeof(element_t));
+    int loaded = 0;
+    for (; aZ && B && loaded < k; loaded++) {
+        const unsigned char* key = store_record_of(key_h, STEALTH_STORE_KEYS,
+                                                   key_indices ? key_indices[loaded] : loaded);
+        if (!key) break;
+        store_load(B[loaded], key, STEALTH_STORE_KEYS, 1);
+        store_load(aZ[loaded], key, STEALTH_STORE_KEYS, 2);
+    }
+
+    long chunk = n < STORE_OWNER_CHUNK ? (n > 0 ? n : 1) : STORE_OWNER_CHUNK;
+    element_t* R1 = batch_alloc((int)chunk, PAIRING->G1, NULL);
+    element_t* C = batch_alloc((int)chunk, PAIRING->G1, NULL);
+    unsigned char* tags = malloc((size_t)chunk * STEALTH_VIEW_TAG_LEN);
+    unsigned char* tagged = malloc((size_t)chunk);
+    unsigned char* col = malloc((size_t)chunk * store_elem_size('g'));
+    long owned = -1;
+
+    if (loaded == k && R1 && C && tags && tagged && col) {
+        int meta_off = store_offset(&store_layouts[STEALTH_STORE_ADDRS], 4);
+        owned = 0;
+        for (long base = 0; base < n && owned >= 0; base += chunk) {
+            int m = (int)(n - base < chunk ? n - base : chunk);
+            store_load_column(R1, addr_h, start + base, m, STEALTH_STORE_ADDRS, 1, col);
+            store_load_column(C, addr_h, start + base, m, STEALTH_STORE_ADDRS, 3, col);
+            for (int i = 0; i < m; i++) {
+                const unsigned char* rec = stealth_store_record(addr_h, start + base + i);
+                tagged[i] = rec[meta_off + 4] & STEALTH_STORE_FLAG_TAGGED;
+                memcpy(tags + (size_t)i * STEALTH_VIEW_TAG_LEN, rec + meta_off + 5, STEALTH_VIEW_TAG_LEN);
+            }
+            int r = stealth_recognize_multi_block(R1, C, tags, tagged, m, aZ, B, k, num_threads,
+                                                  owners + base);
+            if (r < 0) {
+                owned = -1;
+                break;
+            }
+            owned += r;
+        }
+        // Report owners as key store records rather than positions in key_indices
+        for (long i = 0; owned > 0 && key_indices && i < n; i++)
+            if (owners[i] >= 0) owners[i] = (int)key_indices[owners[i]];
+    }
+
+    for (int i = 0; i < loaded; i++) {
+        element_clear(aZ[i]);
+        element_clear(B[i]);
+    }
+    free(aZ);
+    free(B);
+    batch_free(R1, (int)chunk);
+    batch_free(C, (int)chunk);
+    free(tags);
+    free(tagged);
+    free(col);
+    return owned;
+}
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u64(unsigned char* p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_u64(const unsigned char* p) {
+    return get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+/**
+ * Latest checkpoint of a key in a cursor store, NULL if it has none
+ */
+static const unsigned char* store_checkpoint(int cur_h, long key_index) {
+    for (long i = stealth_store_count(cur_h) - 1; i >= 0; i--) {
+        const unsigned char* rec = stealth_store_record(cur_h, i);
+        if (get_u32(rec) == (uint32_t)key_index) return rec;
+    }
+    return NULL;
+}
+
+/**
+ * Whether a DSK record from index from on is for the address and key
+ */
+static int store_has_dsk(int dsk_h, long from, long addr_index, long key_index) {
+    int meta_off = store_offset(&store_layouts[STEALTH_STORE_DSKS], 1);
+    for (long i = from; i < stealth_store_count(dsk_h); i++) {
+        const unsigned char* rec = stealth_store_record(dsk_h, i);
+        if (get_u32(rec + meta_off) == (uint32_t)addr_index &&
+            get_u32(rec + meta_off + 4) == (uint32_t)key_index) return 1;
+    }
+    return 0;
+}
+
+long stealth_store_cursor_simple(int cur_h, long key_index, long* owned_out) {
+    if (!stealth_is_initialized() || stealth_store_kind(cur_h) != STEALTH_STORE_CURSORS || key_index < 0)
+        return -1;
+    const unsigned char* ckpt = store_checkpoint(cur_h, key_index);
+    if (owned_out) *owned_out = ckpt ? (long)get_u64(ckpt + 20) : 0;
+    return ckpt ? (long)get_u64(ckpt + 4) : 0;
+}
+
+long stealth_store_sync_scan_simple(int addr_h, int key_h, long key_index, int cur_h, int dsk_h,
+                                    int dsk_flags, long max_n, long* owned, long owned_cap,
+                                    long* cursor_out) {
+    const unsigned char* key = store_record_of(key_h, STEALTH_STORE_KEYS, key_index);
+    if (!key || !cursor_out || stealth_store_kind(cur_h) != STEALTH_STORE_CURSORS) return -1;
+    if (stealth_store_kind(addr_h) != STEALTH_STORE_ADDRS) return -1;
+    if (dsk_h >= 0 && stealth_store_kind(dsk_h) != STEALTH_STORE_DSKS) return -1;
+
+    const unsigned char* ckpt = store_checkpoint(cur_h, key_index);
+    long start = ckpt ? (long)get_u64(ckpt + 4) : 0;
+    // DSKs past the checkpoint may come from a sync that did not finish
+    long dsks_before = ckpt ? (long)get_u64(ckpt + 12) : 0;
+    long owned_before = ckpt ? (long)get_u64(ckpt + 20) : 0;
+    long n = stealth_store_count(addr_h) - start;
+    // Checkpoint beyond the address records: the address store was reset
+    if (n < 0) return -1;
+    if (max_n > 0 && n > max_n) n = max_n;
+
+    unsigned char* hits = malloc(n > 0 ? (size_t)n : 1);
+    if (!hits) return -1;
+    long found = stealth_store_scan_simple(addr_h, start, n, key_h, key_index, hits);
+
+    if (found > 0 && dsk_h >= 0) {
+        const store_layout_t* l = &store_layouts[STEALTH_STORE_DSKS];
+        int meta_off = store_offset(l, 1);
+        unsigned char* rec = calloc(1, meta_off + l->meta);
+        element_t aZ, bZ, dsk;
+        store_load(aZ, key, STEALTH_STORE_KEYS, 2);
+        store_load(bZ, key, STEALTH_STORE_KEYS, 3);
+        element_init_G2(dsk, PAIRING);
+
+        for (long i = 0; rec && found >= 0 && i < n; i++) {
+            if (!hits[i] || store_has_dsk(dsk_h, dsks_before, start + i, key_index)) continue;
+            const unsigned char* addr = stealth_store_record(addr_h, start + i);
+            element_t Addr, R1;
+            store_load(Addr, addr, STEALTH_STORE_ADDRS, 0);
+            store_load(R1, addr, STEALTH_STORE_ADDRS, 1);
+            stealth_onetime_skgen(dsk, Addr, R1, aZ, bZ);
+            element_clear(Addr); element_clear(R1);
+
+            prim_to_bytes(rec, dsk);
+            put_u32(rec + meta_off, (uint32_t)(start + i));
+            put_u32(rec + meta_off + 4, (uint32_t)key_index);
+            rec[meta_off + 8] = (unsigned char)dsk_flags;
+            if (stealth_store_append(dsk_h, rec) < 0) found = -1;
+        }
+        if (!rec) found = -1;
+
+        element_set0(dsk);
+        element_clear(dsk); element_clear(aZ); element_clear(bZ);
+        if (rec) {
+            memset(rec, 0, meta_off + l->meta);
+            free(rec);
+        }
+    }
+
+    // Only a checkpoint whose DSKs are on disk may move the cursor
+    if (found >= 0 && dsk_h >= 0 && stealth_store_sync(dsk_h) < 0) found = -1;
+    if (found >= 0) {
+        unsigned char ck[STEALTH_STORE_CURSOR_META];
+        put_u32(ck, (uint32_t)key_index);
+        put_u64(ck + 4, (uint64_t)(start + n));
+        put_u64(ck + 12, (uint64_t)(dsk_h >= 0 ? stealth_store_count(dsk_h) : dsks_before));
+        put_u64(ck + 20, (uint64_t)(owned_before + found));
+        if (stealth_store_append(cur_h, ck) < 0 || stealth_store_sync(cur_h) < 0) found = -1;
+    }
+
+    if (found >= 0) {
+        long k = 0;
+        for (long i = 0; owned && i < n && k < owned_cap; i++)
+            if (hits[i]) owned[k++] = start + i;
+        *cursor_out = start + n;
+    }
+    free(hits);
+    return found;
+}
+
+/**
+ * Bring the trace heads up to date with a trace store, from scratch if
+ * they belong to another store or the store was reset
+ */
+static void trace_index_update(int trace_h) {
+    long n = stealth_store_count(trace_h);
+    if (trace_h != trace_index_h || stealth_registry_trace_records() > n) {
+        stealth_registry_clear_traces();
+        trace_index_h = trace_h;
+    }
+    element_t B;
+    element_init_G1(B, PAIRING);
+    for (long i = stealth_registry_trace_records(); i < n; i++) {
+        prim_from_bytes(B, (unsigned char*)stealth_store_record(trace_h, i));
+        stealth_registry_add_trace(B, (int)i);
+    }
+    element_clear(B);
+}
+
+long stealth_store_trace_sync_simple(int addr_h, int trace_h, const unsigned char* k_bytes, long max_n) {
+    if (!stealth_is_initialized() || !k_bytes) return -1;
+    if (stealth_store_kind(addr_h) != STEALTH_STORE_ADDRS || stealth_store_kind(trace_h) != STEALTH_STORE_TRACES)
+        return -1;
+
+    trace_index_update(trace_h);
+    long start = stealth_store_count(trace_h);
+    long n = stealth_store_count(addr_h) - start;
+    if (n < 0) return -1;
+    if (max_n > 0 && n > max_n) n = max_n;
+
+    const store_layout_t* tl = &store_layouts[STEALTH_STORE_TRACES];
+    int meta_off = store_offset(tl, 1);
+    element_t* Addr = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G1, NULL);
+    element_t* R1 = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G1, NULL);
+    element_t* R2 = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G2, NULL);
+    element_t* C = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G1, NULL);
+    element_t* B = batch_alloc(STORE_SCAN_CHUNK, PAIRING->G1, NULL);
+    unsigned char* rec = calloc(1, meta_off + tl->meta);
+    int col_len = store_elem_size('g') > store_elem_size('h') ? store_elem_size('g') : store_elem_size('h');
+    unsigned char* col = malloc((size_t)STORE_SCAN_CHUNK * col_len);
+    long traced = -1;
+
+    if (Addr && R1 && R2 && C && B && rec && col) {
+        element_t kZ;
+        element_init_Zr(kZ, PAIRING);
+        stealth_wire_from_bytes(kZ, k_bytes);
+
+        traced = 0;
+        for (long base = 0; base < n && traced >= 0; base += STORE_SCAN_CHUNK) {
+            int m = (int)(n - base < STORE_SCAN_CHUNK ? n - base : STORE_SCAN_CHUNK);
+            store_load_column(Addr, addr_h, start + base, m, STEALTH_STORE_ADDRS, 0, col);
+            store_load_column(R1, addr_h, start + base, m, STEALTH_STORE_ADDRS, 1, col);
+            store_load_column(R2, addr_h, start + base, m, STEALTH_STORE_ADDRS, 2, col);
+            store_load_column(C, addr_h, start + base, m, STEALTH_STORE_ADDRS, 3, col);
+            stealth_trace_batch(B, Addr, R1, R2, C, m, kZ);
+
+            for (int i = 0; i < m; i++) {
+                int key = stealth_registry_find_B(B[i]);
+                int prev = stealth_registry_find_trace(B[i]);
+                prim_to_bytes(rec, B[i]);
+                put_u32(rec + meta_off, (uint32_t)(start + base + i));
+                put_u32(rec + meta_off + 4, key >= 0 ? (uint32_t)key : STEALTH_STORE_NONE);
+                put_u32(rec + meta_off + 8, prev >= 0 ? (uint32_t)prev : STEALTH_STORE_NONE);
+                long index = stealth_store_append(trace_h, rec);
+                // Record i of the trace store is the trace of address record i
+                if (index != start + base + i || stealth_registry_add_trace(B[i], (int)index) < -1) {
+                    traced = -1;
+                    break;
+                }
+                traced++;
+            }
+        }
+
+        element_set0(kZ);
+        element_clear(kZ);
+        if (traced >= 0 && stealth_store_sync(trace_h) < 0) traced = -1;
+    }
+
+    batch_free(Addr, STORE_SCAN_CHUNK);
+    batch_free(R1, STORE_SCAN_CHUNK);
+    batch_free(R2, STORE_SCAN_CHUNK);
+    batch_free(C, STORE_SCAN_CHUNK);
+    batch_free(B, STORE_SCAN_CHUNK);
+    free(rec);
+    free(col);
+    return traced;
+}
+
+long stealth_store_trace_find_simple(int trace_h, const unsigned char* B_bytes, long* addr_out, long cap) {
+    if (!stealth_is_initialized() || !B_bytes || stealth_store_kind(trace_h) != STEALTH_STORE_TRACES) return -1;
+
+    trace_index_update(trace_h);
+    element_t B;
+    element_init_G1(B, PAIRING);
+    long rec = stealth_wire_from_bytes(B, B_bytes) < 0 ? -1 : stealth_registry_find_trace(B);
+    element_clear(B);
+
+    int meta_off = store_offset(&store_layouts[STEALTH_STORE_TRACES], 1);
+    long found = 0;
+    while (rec >= 0) {
+        const unsigned char* t = stealth_store_record(trace_h, rec);
+        if (addr_out && found < cap) addr_out[found] = (long)get_u32(t + meta_off);
+        found++;
+        uint32_t prev = get_u32(t + meta_off + 8);
+        rec = prev == STEALTH_STORE_NONE ? -1 : (long)prev;
+    }
+    return found;
+}
+
+long stealth_store_registry_load_addrs_simple(int addr_h) {
+    if (!stealth_is_initialized() || stealth_store_kind(addr_h) != STEALTH_STORE_ADDRS) return -1;
+
+    long n = stealth_store_count(addr_h);
+    int meta_off = store_offset(&store_layouts[STEALTH_STORE_ADDRS], 4);
+    int len = store_elem_size(store_layouts[STEALTH_STORE_ADDRS].types[0]);
+    stealth_registry_clear_addrs();
+    // The registry keys addresses by the compact encoding the records hold
+    for (long i = 0; i < n; i++) {
+        const unsigned char* rec = stealth_store_record(addr_h, i);
+        if (stealth_registry_add_addr_compact(rec, len, (int)i, (int)get_u32(rec + meta_off)) < 0)
+            return -1;
+    }
+    return n;
+}
+
+long stealth_store_registry_load_simple(int key_h) {
+    if (!stealth_is_initialized() || stealth_store_kind(key_h) != STEALTH_STORE_KEYS) return -1;
+
+    long n = stealth_store_count(key_h);
+    stealth_registry_clear();
+    for (long i = 0; i < n; i++) {
+        const unsigned char* rec = stealth_store_record(key_h, i);
+        element_t A, B;
+        store_load(A, rec, STEALTH_STORE_KEYS, 0);
+        store_load(B, rec, STEALTH_STORE_KEYS, 1);
+        int rc = stealth_registry_add(A, B, (int)i);
+        element_clear(A); element_clear(B);
+        if (rc < 0) return -1;
+    }
+    return n;
+}
+
+//----------------------------------------------
+// Key Contexts
+//----------------------------------------------
+
+// Contexts by key index. The first one built owns the TK pairing table
+// and the others borrow it. A context replaced because its index now names
+// another key is kept on the retired list: contexts are only released by
+// stealth_key_ctx_clear_simple, so one handed out stays valid while other
+// threads look up keys.
+typedef struct key_ctx_s {
+    stealth_recipient_ctx_t ctx;
+    struct key_ctx_s* retired;
+} key_ctx_t;
+
+static pthread_mutex_t key_ctx_lock = PTHREAD_MUTEX_INITIALIZER;
+static key_ctx_t** key_ctxs;
+static long key_ctx_cap;
+static key_ctx_t* key_ctx_owner;
+static key_ctx_t* key_ctx_retired;
+static element_t key_ctx_TK;
+static int key_ctx_live = 0;          // key_ctx_TK is set
+static int key_tables_h = -1;
+
+int stealth_store_open_key_tables_simple(const char* path) {
+    if (!stealth_is_initialized() || !path) return -1;
+    int size = stealth_recipient_tables_length();
+    if (size <= 0) return -1;
+    return stealth_store_open(path, STEALTH_STORE_KEY_TABLES, (uint32_t)size);
+}
+
+long stealth_store_key_tables_sync_simple(int key_h, int tables_h) {
+    if (!stealth_is_initialized() || stealth_store_kind(key_h) != STEALTH_STORE_KEYS ||
+        stealth_store_kind(tables_h) != STEALTH_STORE_KEY_TABLES) return -1;
+
+    long keys = stealth_store_count(key_h);
+    long have = stealth_store_count(tables_h);
+    if (have > keys) {
+        if (stealth_store_reset(tables_h) != 0) return -1;
+        have = 0;
+    }
+    unsigned char* rec = malloc(stealth_store_record_size(tables_h));
+    if (!rec) return -1;
+
+    long added = 0;
+    for (long i = have; i < keys; i++) {
+        element_t A, B;
+        const unsigned char* key = stealth_store_record(key_h, i);
+        store_load(A, key, STEALTH_STORE_KEYS, 0);
+        store_load(B, key, STEALTH_STORE_KEYS, 1);
+        int ok = stealth_recipient_tables_to_bytes(rec, A, B) > 0;
+        element_clear(A); element_clear(B);
+        // Another process syncing the same files got there first: record i
+        // would land at another index
+        if (!ok || stealth_store_count(tables_h) != i) break;
+        if (stealth_store_append(tables_h, rec) < 0) break;
+        added++;
+    }
+    free(rec);
+    return added;
+}
+
+static void key_ctx_release(key_ctx_t* kc) {
+    stealth_recipient_ctx_clear(&kc->ctx);
+    free(kc);
+}
+
+void stealth_key_ctx_clear_simple(void) {
+    pthread_mutex_lock(&key_ctx_lock);
+    // The owner's TK table goes last, after the contexts borrowing it
+    for (long i = 0; i < key_ctx_cap; i++) {
+        if (key_ctxs[i] && key_ctxs[i] != key_ctx_owner) key_ctx_release(key_ctxs[i]);
+    }
+    while (key_ctx_retired) {
+        key_ctx_t* next = key_ctx_retired->retired;
+        if (key_ctx_retired != key_ctx_owner) key_ctx_release(key_ctx_retired);
+        key_ctx_retired = next;
+    }
+    if (key_ctx_owner) key_ctx_release(key_ctx_owner);
+    free(key_ctxs);
+    key_ctxs = NULL;
+    key_ctx_cap = 0;
+    key_ctx_owner = NULL;
+    if (key_ctx_live) element_clear(key_ctx_TK);
+    key_ctx_live = 0;
+    key_tables_h = -1;
+    pthread_mutex_unlock(&key_ctx_lock);
+}
+
+int stealth_key_ctx_init_simple(const unsigned char* TK_bytes, int tables_h) {
+    if (!stealth_is_initialized() || !TK_bytes) return -1;
+    if (tables_h >= 0 && stealth_store_kind(tables_h) != STEALTH_STORE_KEY_TABLES) return -1;
+
+    stealth_key_ctx_clear_simple();
+    pthread_mutex_lock(&key_ctx_lock);
+    element_init_G2(key_ctx_TK, PAIRING);
+    stealth_wire_from_bytes(key_ctx_TK, TK_bytes);
+    key_ctx_live = 1;
+    key_tables_h = tables_h;
+    pthread_mutex_unlock(&key_ctx_lock);
+    return 0;
+}
+
+/**
+ * Context of key 'index' with public keys A and B: the cached one, else one
+ * built from the key's stored tables, else one built afresh. NULL without
+ * stealth_key_ctx_init_simple.
+ */
+static stealth_recipient_ctx_t* key_ctx_get(long index, element_t A, element_t B) {
+    stealth_recipient_ctx_t* ctx = NULL;
+    key_ctx_t* kc;
+    if (index < 0) return NULL;
+
+    pthread_mutex_lock(&key_ctx_lock);
+    if (!key_ctx_live) goto done;
+    if (index < key_ctx_cap && (kc = key_ctxs[index])) {
+        if (!element_cmp(kc->ctx.A_r, A) && !element_cmp(kc->ctx.B_r, B)) {
+            ctx = &kc->ctx;
+            goto done;
+        }
+        // The key store was reset and the index names a new key
+        kc->retired = key_ctx_retired;
+        key_ctx_retired = kc;
+        key_ctxs[index] = NULL;
+    }
+    if (index >= key_ctx_cap) {
+        long cap = key_ctx_cap ? key_ctx_cap : 64;
+        while (cap <= index) cap *= 2;
+        key_ctx_t** grown = realloc(key_ctxs, cap * sizeof(*grown));
+        if (!grown) goto done;
+        memset(grown + key_ctx_cap, 0, (cap - key_ctx_cap) * sizeof(*grown));
+        key_ctxs = grown;
+        key_ctx_cap = cap;
+    }
+    if (!(kc = malloc(sizeof(*kc)))) goto done;
+
+    // Tables of another key fail the check of their first entry and are rebuilt
+    stealth_recipient_ctx_t* tk_from = key_ctx_owner ? &key_ctx_owner->ctx : NULL;
+    const unsigned char* tables = key_tables_h >= 0 ? stealth_store_record(key_tables_h, index) : NULL;
+    if ((!tables || stealth_recipient_ctx_init_tables(&kc->ctx, A, B, key_ctx_TK, tables, tk_from) != 0) &&
+        stealth_recipient_ctx_init_tables(&kc->ctx, A, B, key_ctx_TK, NULL, tk_from) != 0) {
+        free(kc);
+        goto done;
+    }
+    if (!key_ctx_owner) key_ctx_owner = kc;
+    key_ctxs[index] = kc;
+    ctx = &kc->ctx;
+done:
+    pthread_mutex_unlock(&key_ctx_lock);
+    return ctx;
+}
+
+int stealth_key_addr_gen_simple(long key_index, const unsigned char* A_bytes,
+                                const unsigned char* B_bytes,
+                                unsigned char* addr_out, unsigned char* r1_out,
+                                unsigned char* r2_out, unsigned char* c_out,
+                                unsigned char* tag_out, int buf_size) {
+    if (!stealth_is_initialized()) return -1;
+
+    element_t A, B, Addr, R1, R2, C;
+    element_init_G1(A, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_G1(Addr, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_G2(R2, PAIRING);
+    element_init_G1(C, PAIRING);
+
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+
+    stealth_recipient_ctx_t* ctx = key_ctx_get(key_index, A, B);
+    if (ctx) {
+        if (tag_out) stealth_addr_gen_tagged_ctx(Addr, R1, R2, C, tag_out, ctx);
+        else stealth_addr_gen_ctx(Addr, R1, R2, C, ctx);
+
+        memset(addr_out, 0, buf_size);
+        memset(r1_out, 0, buf_size);
+        memset(r2_out, 0, buf_size);
+        memset(c_out, 0, buf_size);
+
+        stealth_wire_to_bytes(addr_out, Addr);
+        stealth_wire_to_bytes(r1_out, R1);
+        stealth_wire_to_bytes(r2_out, R2);
+        stealth_wire_to_bytes(c_out, C);
+    }
+
+    element_clear(A); element_clear(B);
+    element_clear(Addr); element_clear(R1); element_clear(R2); element_clear(C);
+    return ctx ? 0 : -1;
+}
+
+int stealth_key_recognize_fast_simple(long key_index, const unsigned char* A_bytes,
+                                      const unsigned char* B_bytes,
+                                      const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                      const unsigned char* tag, const unsigned char* a_bytes) {
+    if (!stealth_is_initialized()) return -1;
+
+    element_t A, B, R1, aZ;
+    element_init_G1(A, PAIRING);
+    element_init_G1(B, PAIRING);
+    element_init_G1(R1, PAIRING);
+    element_init_Zr(aZ, PAIRING);
+
+    stealth_wire_from_bytes(A, A_bytes);
+    stealth_wire_from_bytes(B, B_bytes);
+    stealth_wire_from_bytes(R1, R1_bytes);
+    stealth_wire_from_bytes(aZ, a_bytes);
+
+    stealth_recipient_ctx_t* ctx = key_ctx_get(key_index, A, B);
+    int result = ctx ? stealth_addr_recognize_fast_ctx_bytes(R1, C_bytes, tag, aZ, ctx) : -1;
+
+    element_clear(A); element_clear(B); element_clear(R1); element_clear(aZ);
+    return result;
+}
+
+//----------------------------------------------
+// Primitive Counters
+//----------------------------------------------
+
+void stealth_primitive_stats_simple(unsigned long* counts, double* total_ms) {
+    prim_stats_t stats;
+    prim_get_stats(&stats);
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        if (counts) counts[i] = stats.count[i];
+        if (total_ms) total_ms[i] = stats.total_ms[i];
+    }
+}
+
+void stealth_reset_primitive_stats_simple(void) {
+    prim_reset_stats();
+}
+
+void stealth_primitive_hw_stats_simple(unsigned long* counts, double* totals) {
+    prim_hw_stats_t stats;
+    prim_get_hw_stats(&stats);
+    for (int i = 0; i < PRIM_COUNT; i++) {
+        if (counts) counts[i] = stats.count[i];
+        for (int c = 0; totals && c < HWC_COUNT; c++) totals[i * HWC_COUNT + c] = stats.total[i][c];
+    }
+}
+
+long stealth_latency_histogram_simple(int op, unsigned long* counts, int n, double* max_ms) {
+    return stealth_latency_histogram(op, counts, n, max_ms);
+}
+
+int stealth_latency_bounds_simple(double* upper_ms, int n) {
+    int buckets = stealth_latency_buckets();
+    for (int i = 0; upper_ms && i < n && i < buckets; i++) {
+        upper_ms[i] = stealth_latency_bucket_ms(i);
+    }
+    return buckets;
+}
+
+//----------------------------------------------
+// Hex Encoding
+//----------------------------------------------
+
+int stealth_to_hex_simple(const unsigned char* in, int n, char* out) {
+    int zero = hex_encode(out, in, n > 0 ? n : 0);
+    out[n > 0 ? 2 * n : 0] = '\0';
+    return zero;
+}
+
+long stealth_from_hex_simple(const char* hex, long len, unsigned char* out, int buf_size) {
+    if (len < 0 || buf_size < 0) return -1;
+    return hex_decode(out, buf_size, hex, len);
+}
+
+long stealth_to_hex_batch_simple(const unsigned char* in, long n, int size, char* out,
+                                 unsigned char* zero_out) {
+    if (n <= 0 || size <= 0) return 0;
+    return hex_encode_rows(out, in, n, size, ',', zero_out);
+}
+
+long stealth_from_hex_batch_simple(const char* text, long len, long n, int size, unsigned char* out) {
+    if (n <= 0) return 0;
+    if (len < 0 || size <= 0) return -1;
+    return hex_decode_rows(out, n, size, text, len, ',');
+}
@@ -90,6 +90,25 @@ void stealth_dsk_gen_simple(const unsigned char* addr_bytes, const unsigned char
                            const unsigned char* a_bytes, const unsigned char* b_bytes,
                            unsigned char* dsk_out, int buf_size);
 
+/**
+ * Python Interface: Recognize an output and, if owned, generate its DSK
+ * @param addr_bytes Address as bytes
+ * @param r1_bytes R1 component as bytes
+ * @param B_bytes Public key B as bytes
+ * @param c_bytes C component as bytes
+ * @param tag View tag, NULL if untagged
+ * @param a_bytes Private key a as bytes
+ * @param b_bytes Private key b as bytes
+ * @param dsk_out Buffer for one-time secret key, written if recognized (output)
+ * @param buf_size Size of output buffer
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_recognize_and_derive_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                        const unsigned char* B_bytes, const unsigned char* c_bytes,
+                                        const unsigned char* tag, const unsigned char* a_bytes,
+                                        const unsigned char* b_bytes, unsigned char* dsk_out,
+                                        int buf_size);
+
 /**
  * Python Interface: Sign message
  * @param addr_bytes Address as bytes
@@ -121,6 +140,18 @@ void stealth_sign_simple(const unsigned char* addr_bytes, const unsigned char* r
                         unsigned char* q_sigma_out, unsigned char* h_out, 
                         unsigned char* dsk_out, int buf_size);
 
+/**
+ * Python Interface: Sign message through the DSK cache, see stealth_sign_cached
+ * @param addr_id Caller's id of the address, e.g. its index in the address list
+ * Other parameters and outputs as stealth_sign_simple
+ */
+void stealth_sign_cached_simple(long addr_id, const unsigned char* addr_bytes,
+                                const unsigned char* r1_bytes,
+                                const unsigned char* a_bytes, const unsigned char* b_bytes,
+                                const char* message,
+                                unsigned char* q_sigma_out, unsigned char* h_out,
+                                unsigned char* dsk_out, int buf_size);
+
 /**
  * Python Interface: Verify signature
  * @param addr_bytes Address as bytes
@@ -150,6 +181,83 @@ void stealth_trace_simple(const unsigned char* addr_bytes, const unsigned char*
                          const unsigned char* k_bytes,
                          unsigned char* b_recovered_out, int buf_size);
 
+/**
+ * Python Interface: Trace identity and resolve it in the key registry
+ * @param addr_bytes, r1_bytes, r2_bytes, c_bytes Address components
+ * @param k_bytes Trace private key
+ * @param b_recovered_out Recovered B (output, may be NULL)
+ * @param buf_size Size of b_recovered_out
+ * @return Registry id of the owner, -1 if B is not registered
+ */
+int stealth_trace_lookup_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                const unsigned char* k_bytes,
+                                unsigned char* b_recovered_out, int buf_size);
+
+/**
+ * Python Interface: Register a key pair in the hash index (stealth_registry_add)
+ * @param A_bytes, B_bytes Public keys
+ * @param id Registry id, >= 0
+ * @return 0 on success, -1 on error
+ */
+int stealth_registry_add_simple(const unsigned char* A_bytes, const unsigned char* B_bytes, int id);
+
+/**
+ * Python Interface: Look up a registered key pair by A or B
+ * @param bytes Public key A or B
+ * @return Registry id, -1 if unknown
+ */
+int stealth_registry_find_A_simple(const unsigned char* A_bytes);
+int stealth_registry_find_B_simple(const unsigned char* B_bytes);
+
+/**
+ * Python Interface: Get number of registered key pairs
+ */
+int stealth_registry_count_simple(void);
+
+/**
+ * Python Interface: Drop every registry entry
+ */
+void stealth_registry_clear_simple(void);
+
+/**
+ * Python Interface: Register a one-time address in the address index
+ * (stealth_registry_add_addr)
+ * @param addr_bytes One-time address
+ * @param id Address id, >= 0
+ * @param owner Owning key id, -1 if not known
+ * @return 0 on success, -1 on error
+ */
+int stealth_registry_add_addr_simple(const unsigned char* addr_bytes, int id, int owner);
+
+/**
+ * Python Interface: Look up a one-time address
+ * @param addr_bytes One-time address
+ * @param owner_out Owning key id of a known address (output, may be NULL)
+ * @return Address id, -1 if unknown
+ */
+int stealth_registry_find_addr_simple(const unsigned char* addr_bytes, int* owner_out);
+
+/**
+ * Python Interface: Look up n one-time addresses, e.g. to skip the outputs
+ * of a rescan that are already known
+ * @param addrs_bytes n addresses packed in the current wire format
+ * @param ids Address id of each, -1 if unknown (output)
+ * @param owners Owning key id of each, -1 if unknown (output, may be NULL)
+ * @return Number of known addresses, -1 on error
+ */
+int stealth_registry_find_addr_batch_simple(const unsigned char* addrs_bytes, int n, int* ids, int* owners);
+
+/**
+ * Python Interface: Get number of registered addresses
+ */
+int stealth_registry_addr_count_simple(void);
+
+/**
+ * Python Interface: Drop the registered addresses only
+ */
+void stealth_registry_clear_addrs_simple(void);
+
 /**
  * Python Interface: Performance test
  * @param iterations Number of test iterations
@@ -164,4 +272,773 @@ void stealth_trace_simple(const unsigned char* addr_bytes, const unsigned char*
  */
 void stealth_performance_test_simple(int iterations, double* results);
 
+// Doubles per operation filled by stealth_benchmark_simple
+#define STEALTH_BENCH_FIELDS 11
+
+/**
+ * Python Interface: Configurable benchmark (stealth_benchmark)
+ * @param ops Bit (1 << op) per operation, in stealth_performance_t order; 0 for all
+ * @param iterations Timed calls per operation and thread
+ * @param batch_size Outputs per call
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param precompute Generate addresses through a recipient context
+ * @param warmup Untimed calls per operation and thread before timing
+ * @param results STEALTH_BENCH_FIELDS doubles per selected operation (output):
+ *                op, threads, items, wall_ms, items_per_sec, setup_ms,
+ *                mean_ms, p50_ms, p90_ms, p99_ms, max_ms (latencies per call)
+ * @param n Number of operations results has room for
+ * @return Number of operations filled, -1 on error
+ */
+int stealth_benchmark_simple(int ops, int iterations, int batch_size, int num_threads,
+                             int precompute, int warmup, double* results, int n);
+
+/**
+ * Python Interface: Per-primitive call counts and times since load
+ * (or the last reset), summed over threads
+ * @param counts Array for call counts [6]
+ * @param total_ms Array for summed times in ms [6]
+ *                 order: pairing, g1_pow, gt_pow, hash_zr, hash_g1, serialize
+ */
+void stealth_primitive_stats_simple(unsigned long* counts, double* total_ms);
+
+/**
+ * Python Interface: Zero the per-primitive counters
+ */
+void stealth_reset_primitive_stats_simple(void);
+
+/**
+ * Python Interface: Per-primitive hardware counter totals of the calls
+ * made while counters were on (see stealth_set_hw_counters), summed over
+ * threads; stealth_reset_primitive_stats_simple zeroes them too
+ * @param counts Array for the number of calls measured [6], primitive
+ *               order as in stealth_primitive_stats_simple
+ * @param totals Array for the counter totals [6 * 6], one row per
+ *               primitive: cycles, instructions, l1d_misses, llc_misses,
+ *               branch_misses, allocs
+ */
+void stealth_primitive_hw_stats_simple(unsigned long* counts, double* totals);
+
+/**
+ * Python Interface: Snapshot of an operation's latency histogram
+ * (see stealth_latency_histogram); stealth_reset_performance clears it
+ * @param op Operation index, in stealth_performance_t order
+ * @param counts Array for the bucket counts
+ * @param n Size of counts
+ * @param max_ms Largest sample in ms (output, may be NULL)
+ * @return Number of samples, -1 on error
+ */
+long stealth_latency_histogram_simple(int op, unsigned long* counts, int n, double* max_ms);
+
+/**
+ * Python Interface: Upper bound in ms of each histogram bucket
+ * @param upper_ms Array for the bounds, may be NULL to ask the bucket count
+ * @param n Size of upper_ms
+ * @return Number of buckets
+ */
+int stealth_latency_bounds_simple(double* upper_ms, int n);
+
+//----------------------------------------------
+// Batch Interface
+// Packed variants for processing a whole request in one ctypes call.
+// Packed arrays hold n elements back to back, each stealth_element_size_G1()
+// (or _G2() for R2, DSKs and Q_sigma, or _Zr()) bytes long; outputs use the
+// same layout.
+//----------------------------------------------
+
+/**
+ * Batch: Generate n addresses
+ * @param A_bytes, B_bytes Packed recipient keys, n of each
+ * @param TK_bytes Trace public key
+ * @param n Number of addresses
+ * @param addr_out, r1_out, r2_out, c_out Packed outputs, n elements each
+ * @return n on success, -1 on error
+ */
+int stealth_addr_gen_batch(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                           const unsigned char* TK_bytes, int n,
+                           unsigned char* addr_out, unsigned char* r1_out,
+                           unsigned char* r2_out, unsigned char* c_out);
+
+/**
+ * Batch: Generate n addresses across a worker pool (stealth_addr_gen_block)
+ * @param A_bytes, B_bytes Packed recipient keys, n of each
+ * @param TK_bytes Trace public key
+ * @param n Number of addresses
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param addr_out, r1_out, r2_out, c_out Packed outputs, n elements each
+ * @param tags_out n concatenated view tags (output), NULL for untagged addresses
+ * @return n on success, -1 on error
+ */
+int stealth_addr_gen_block_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                  const unsigned char* TK_bytes, int n, int num_threads,
+                                  unsigned char* addr_out, unsigned char* r1_out,
+                                  unsigned char* r2_out, unsigned char* c_out,
+                                  unsigned char* tags_out);
+
+/**
+ * Batch: Generate the n outputs of one transaction on a shared ephemeral
+ * (stealth_addr_gen_multi)
+ * @param A_bytes, B_bytes Packed recipient keys, n of each, no A twice
+ * @param TK_bytes Trace public key
+ * @param n Number of outputs
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param addr_out, r2_out, c_out Packed outputs, n elements each
+ * @param r1_out The shared R1, one element
+ * @param tags_out n concatenated view tags (output), NULL for untagged addresses
+ * @return n on success, -1 on error or a repeated recipient
+ */
+int stealth_addr_gen_multi_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                  const unsigned char* TK_bytes, int n, int num_threads,
+                                  unsigned char* addr_out, unsigned char* r1_out,
+                                  unsigned char* r2_out, unsigned char* c_out,
+                                  unsigned char* tags_out);
+
+/**
+ * Batch: Fast recognition of n outputs against one key
+ * @param R1_bytes, C_bytes Packed R1 and C components
+ * @param n Number of outputs
+ * @param B_bytes Public key B
+ * @param a_bytes Private key a
+ * @param results One byte per output, 1 if recognized (output)
+ * @return Number of recognized outputs, -1 on error
+ */
+int stealth_addr_recognize_fast_batch(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                      int n, const unsigned char* B_bytes,
+                                      const unsigned char* a_bytes, unsigned char* results);
+
+/**
+ * Batch: Audit n addresses generated for one key pair (stealth_addr_audit_batch)
+ * @param addr_bytes, r1_bytes, r2_bytes, c_bytes Packed address components
+ * @param n Number of addresses
+ * @param B_bytes Public key B
+ * @param a_bytes Private key a
+ * @param TK_bytes Trace public key
+ * @param results One byte per address, 1 if well formed (output)
+ * @return Number of well-formed addresses, -1 on error
+ */
+int stealth_addr_audit_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                                    const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                                    int n, const unsigned char* B_bytes,
+                                    const unsigned char* a_bytes, const unsigned char* TK_bytes,
+                                    unsigned char* results);
+
+/**
+ * Batch: Find which of n key pairs owns one output (stealth_recognize_multi)
+ * @param R1_bytes, C_bytes Output components
+ * @param tag View tag of the output, NULL if untagged
+ * @param a_bytes Packed private keys a_i, n Zr elements
+ * @param B_bytes Packed public keys B_i, n G1 elements
+ * @param n Number of key pairs
+ * @return Index of the owning key, -1 if none, -2 on error
+ */
+int stealth_recognize_multi_simple(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                   const unsigned char* tag, const unsigned char* a_bytes,
+                                   const unsigned char* B_bytes, int n);
+
+/**
+ * Batch: Find the owner among k key pairs of each of n outputs across a
+ * worker pool (stealth_recognize_multi_block)
+ * @param R1_bytes, C_bytes Packed R1 and C components
+ * @param tags n concatenated view tags, NULL if untagged
+ * @param tagged One byte per output, nonzero if it carries a tag; NULL if all do
+ * @param n Number of outputs
+ * @param a_bytes, B_bytes Packed private keys a_i and public keys B_i, k of each
+ * @param k Number of key pairs
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param owners Per-output index of the owning key, -1 if none (output, n ints)
+ * @return Number of owned outputs, -1 on error
+ */
+int stealth_recognize_multi_block_simple(const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                         const unsigned char* tags, const unsigned char* tagged,
+                                         int n, const unsigned char* a_bytes,
+                                         const unsigned char* B_bytes, int k, int num_threads,
+                                         int* owners);
+
+/**
+ * Batch: Generate n one-time secret keys for one key pair
+ * @param addr_bytes, r1_bytes Packed addresses and R1 components
+ * @param n Number of addresses
+ * @param a_bytes, b_bytes Private keys a and b
+ * @param dsk_out Packed DSKs (output)
+ * @return n on success, -1 on error
+ */
+int stealth_dsk_gen_batch(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                          int n, const unsigned char* a_bytes, const unsigned char* b_bytes,
+                          unsigned char* dsk_out);
+
+/**
+ * Batch: Verify n signatures across a worker pool (stealth_verify_block)
+ * @param addr_bytes, r2_bytes, c_bytes Packed address components
+ * @param messages Messages concatenated without separators
+ * @param message_lens Length of each message
+ * @param h_bytes Packed h values (Zr)
+ * @param q_sigma_bytes Packed Q_sigma values (G2)
+ * @param n Number of signatures
+ * @param results One byte per signature, 1 if valid (output)
+ * @return Number of valid signatures, -1 on error
+ */
+int stealth_verify_batch(const unsigned char* addr_bytes, const unsigned char* r2_bytes,
+                         const unsigned char* c_bytes, const char* messages,
+                         const int* message_lens, const unsigned char* h_bytes,
+                         const unsigned char* q_sigma_bytes, int n, unsigned char* results);
+
+/**
+ * Batch: Aggregate n signatures into commitments and one Q_agg (stealth_aggregate)
+ * @param addr_bytes, c_bytes Packed address components
+ * @param messages Messages concatenated without separators
+ * @param message_lens Length of each message
+ * @param h_bytes, q_sigma_bytes Packed signatures
+ * @param n Number of signatures
+ * @param x_out Packed commitments, stealth_element_size_GT bytes each
+ *        (output), written only once aggregated
+ * @param q_agg_out Aggregate signature (G2, output), written only once aggregated
+ * @param results One byte per signature, 1 if valid (output)
+ * @return n once aggregated, the number of valid signatures if some failed,
+ *         -1 on error
+ */
+int stealth_aggregate_batch(const unsigned char* addr_bytes, const unsigned char* c_bytes,
+                            const char* messages, const int* message_lens,
+                            const unsigned char* h_bytes, const unsigned char* q_sigma_bytes,
+                            int n, unsigned char* x_out, unsigned char* q_agg_out,
+                            unsigned char* results);
+
+/**
+ * Batch: Verify an aggregate against the n addresses and messages it covers
+ * @param addr_bytes, r2_bytes, c_bytes Packed address components
+ * @param messages Messages concatenated without separators
+ * @param message_lens Length of each message
+ * @param x_bytes Packed commitments, stealth_element_size_GT bytes each
+ * @param q_agg_bytes Aggregate signature (G2)
+ * @param n Number of signatures
+ * @return 1 if valid, 0 if not, -1 on error
+ */
+int stealth_verify_aggregate_batch(const unsigned char* addr_bytes, const unsigned char* r2_bytes,
+                                   const unsigned char* c_bytes, const char* messages,
+                                   const int* message_lens, const unsigned char* x_bytes,
+                                   const unsigned char* q_agg_bytes, int n);
+
+/**
+ * Batch: Trace n addresses with one trace key
+ * @param addr_bytes, r1_bytes, r2_bytes, c_bytes Packed address components
+ * @param n Number of addresses
+ * @param k_bytes Trace private key
+ * @param b_recovered_out Packed recovered B values (output)
+ * @return n on success, -1 on error
+ */
+int stealth_trace_batch_simple(const unsigned char* addr_bytes, const unsigned char* r1_bytes,
+                               const unsigned char* r2_bytes, const unsigned char* c_bytes,
+                               int n, const unsigned char* k_bytes,
+                               unsigned char* b_recovered_out);
+
+/**
+ * Batch: Ingest a stream of serialized outputs (stealth_ingest)
+ * @param records n records of Addr || R1 || C, each followed by its view
+ *                tag when tagged
+ * @param n Number of outputs
+ * @param tagged Records carry view tags
+ * @param B_bytes Public key B
+ * @param a_bytes, b_bytes Private keys a and b
+ * @param owned Indices of owned outputs in stream order (output, up to n)
+ * @param dsk_out Packed DSKs of the owned outputs, in the same order
+ *                (output, up to n G2 elements)
+ * @return Number of owned outputs, -1 on error
+ */
+int stealth_ingest_simple(const unsigned char* records, int n, int tagged,
+                          const unsigned char* B_bytes, const unsigned char* a_bytes,
+                          const unsigned char* b_bytes, int* owned, unsigned char* dsk_out);
+
+//----------------------------------------------
+// Handle-based Interface
+// Keys and address components stay on the C side as elements and are
+// referenced by integer handles (>= 1), so repeated operations on the
+// same keys skip deserialization. The table may be used from several
+// threads; a handle must not be freed while another call still uses it.
+// Call stealth_handle_free_all before stealth_init or stealth_cleanup;
+// handles do not survive a re-init.
+//----------------------------------------------
+
+#define STEALTH_HANDLE_G1 1
+#define STEALTH_HANDLE_ZR 2
+#define STEALTH_HANDLE_G2 3    // TK, R2, DSKs, Q_sigma; same as G1 when symmetric
+
+/**
+ * Import a serialized element
+ * @param type STEALTH_HANDLE_G1, STEALTH_HANDLE_G2 or STEALTH_HANDLE_ZR
+ * @param bytes Serialized element
+ * @param len Length of bytes, at least the element size
+ * @return Handle, -1 on error or if the element fails wire validation
+ */
+int stealth_handle_import(int type, const unsigned char* bytes, int len);
+
+/**
+ * Export the element behind a handle
+ * @param h Handle
+ * @param out Buffer to write to
+ * @param buf_size Size of buffer
+ * @return Number of bytes written, -1 on error
+ */
+int stealth_handle_export(int h, unsigned char* out, int buf_size);
+
+/**
+ * Release a handle
+ * @param h Handle
+ * @return 0 on success, -1 if the handle is not live
+ */
+int stealth_handle_free(int h);
+
+/**
+ * Release every handle
+ */
+void stealth_handle_free_all(void);
+
+/**
+ * Get the number of live handles
+ * @return Live handle count
+ */
+int stealth_handle_count(void);
+
+/**
+ * Handle Interface: Generate key pair
+ * @param A_out, B_out, a_out, b_out New handles for A, B, a, b (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_keygen_h(int* A_out, int* B_out, int* a_out, int* b_out);
+
+/**
+ * Handle Interface: Generate trace key
+ * @param TK_out, k_out New handles for TK, k (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_tracekeygen_h(int* TK_out, int* k_out);
+
+/**
+ * Handle Interface: Generate address
+ * @param A, B, TK Handles of the recipient keys and trace key
+ * @param addr_out, r1_out, r2_out, c_out New handles for Addr, R1, R2, C (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_addr_gen_h(int A, int B, int TK,
+                       int* addr_out, int* r1_out, int* r2_out, int* c_out);
+
+/**
+ * Handle Interface: Recognize address (fast version)
+ * @param R1, B, A, C, a Handles
+ * @return 1 if recognized, 0 otherwise, -1 on invalid handle
+ */
+int stealth_addr_recognize_fast_h(int R1, int B, int A, int C, int a);
+
+/**
+ * Handle Interface: Generate one-time secret key (DSK)
+ * @param Addr, R1, a, b Handles
+ * @param dsk_out New handle for the DSK (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_dsk_gen_h(int Addr, int R1, int a, int b, int* dsk_out);
+
+/**
+ * Handle Interface: Sign message with DSK
+ * @param Addr, dsk Handles
+ * @param message Message to sign
+ * @param q_sigma_out, h_out New handles for Q_sigma, h (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_sign_with_dsk_h(int Addr, int dsk, const char* message,
+                            int* q_sigma_out, int* h_out);
+
+/**
+ * Handle Interface: Verify signature
+ * @param Addr, R2, C Handles of the address components
+ * @param message Message
+ * @param h, q_sigma Handles of the signature
+ * @return 1 if valid, 0 otherwise, -1 on invalid handle
+ */
+int stealth_verify_h(int Addr, int R2, int C, const char* message, int h, int q_sigma);
+
+/**
+ * Handle Interface: Trace identity
+ * @param Addr, R1, R2, C Handles of the address components
+ * @param k Handle of the trace private key
+ * @param b_out New handle for the recovered B (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_trace_h(int Addr, int R1, int R2, int C, int k, int* b_out);
+
+//----------------------------------------------
+// View Tag Interface
+// Tags are STEALTH_VIEW_TAG_LEN bytes, returned next to the address
+// and passed back when scanning.
+//----------------------------------------------
+
+/**
+ * View Tag: Get tag length in bytes
+ */
+int stealth_view_tag_length(void);
+
+/**
+ * View Tag: Generate address together with its view tag
+ * @param A_bytes, B_bytes, TK_bytes Recipient keys and trace key
+ * @param addr_out, r1_out, r2_out, c_out Address components (output)
+ * @param tag_out View tag, stealth_view_tag_length() bytes (output)
+ * @param buf_size Size of each component buffer
+ */
+void stealth_addr_gen_tagged_simple(const unsigned char* A_bytes, const unsigned char* B_bytes,
+                                    const unsigned char* TK_bytes,
+                                    unsigned char* addr_out, unsigned char* r1_out,
+                                    unsigned char* r2_out, unsigned char* c_out,
+                                    unsigned char* tag_out, int buf_size);
+
+/**
+ * View Tag: Fast recognition with tag prefilter
+ * @param R1_bytes, B_bytes, C_bytes Address components and public key B
+ * @param tag View tag stored with the address
+ * @param a_bytes Private key a
+ * @return 1 if recognized, 0 otherwise
+ */
+int stealth_addr_recognize_fast_tagged_simple(const unsigned char* R1_bytes,
+                                              const unsigned char* B_bytes,
+                                              const unsigned char* C_bytes,
+                                              const unsigned char* tag,
+                                              const unsigned char* a_bytes);
+
+/**
+ * View Tag: Batch fast recognition with tag prefilter
+ * @param R1_bytes, C_bytes Packed R1 and C components
+ * @param tags n concatenated view tags
+ * @param n Number of outputs
+ * @param B_bytes Public key B
+ * @param a_bytes Private key a
+ * @param results One byte per output, 1 if recognized (output)
+ * @return Number of recognized outputs, -1 on error
+ */
+int stealth_addr_recognize_fast_tagged_batch(const unsigned char* R1_bytes,
+                                             const unsigned char* C_bytes,
+                                             const unsigned char* tags, int n,
+                                             const unsigned char* B_bytes,
+                                             const unsigned char* a_bytes,
+                                             unsigned char* results);
+
+/**
+ * View Tag: Generate address on handles together with its view tag
+ * @param A, B, TK Handles of the recipient keys and trace key
+ * @param addr_out, r1_out, r2_out, c_out New handles for Addr, R1, R2, C (output)
+ * @param tag_out View tag (output)
+ * @return 0 on success, -1 on error
+ */
+int stealth_addr_gen_tagged_h(int A, int B, int TK,
+                              int* addr_out, int* r1_out, int* r2_out, int* c_out,
+                              unsigned char* tag_out);
+
+/**
+ * View Tag: Fast recognition on handles with tag prefilter
+ * @param R1, B, C, a Handles
+ * @param tag View tag stored with the address
+ * @return 1 if recognized, 0 otherwise, -1 on invalid handle
+ */
+int stealth_addr_recognize_fast_tagged_h(int R1, int B, int C, const unsigned char* tag, int a);
+
+//----------------------------------------------
+// Store Interface
+// Keys, addresses and DSKs persisted in stealth_store files. Records hold
+// the canonical (uncompressed) encoding of their elements followed by
+// a little-endian metadata trailer; the byte-level calls below take and
+// return elements packed back to back in the current wire format.
+// Address records, the bulk of a ledger, keep their points in the compact
+// encoding (stealth_compact_to_bytes) at about half the size; y is only
+// recovered for points that are computed with, and with the compressed
+// wire format the stored bytes are passed through as they are.
+//   STEALTH_STORE_KEYS    A, B (G1) | a, b (Zr)
+//   STEALTH_STORE_ADDRS   Addr, R1 (G1), R2 (G2), C (G1), compact | key index u32, flags u8, view tag
+//   STEALTH_STORE_DSKS    dsk (G2) | address index u32, key index u32, flags u8
+//   STEALTH_STORE_SYSTEM  g (G1), TK (G2) | k (Zr)
+//   STEALTH_STORE_CURSORS | key index u32, next address u64, DSK count u64, owned u64
+//   STEALTH_STORE_TRACES  recovered B (G1) | address index u32, key id u32, previous trace of B u32
+//   STEALTH_STORE_KEY_TABLES  fixed-base tables for A and B of key record i
+//                             (stealth_recipient_tables_to_bytes)
+// Record sizes follow the pairing's element sizes, so a file written under
+// a parameter set with other sizes is refused on open.
+//----------------------------------------------
+
+#define STEALTH_STORE_KEYS 1
+#define STEALTH_STORE_ADDRS 2
+#define STEALTH_STORE_DSKS 3
+#define STEALTH_STORE_SYSTEM 4
+#define STEALTH_STORE_CURSORS 5
+#define STEALTH_STORE_TRACES 6
+#define STEALTH_STORE_KEY_TABLES 7
+
+#define STEALTH_STORE_ADDR_META (4 + 1 + STEALTH_VIEW_TAG_LEN)
+#define STEALTH_STORE_DSK_META (4 + 4 + 1)
+#define STEALTH_STORE_CURSOR_META (4 + 8 + 8 + 8)
+#define STEALTH_STORE_TRACE_META (4 + 4 + 4)
+#define STEALTH_STORE_NONE 0xFFFFFFFFu     // key id or previous trace that is not there
+#define STEALTH_STORE_FLAG_TAGGED 1     // address record carries a view tag
+
+/**
+ * Store: Open (or create) a store file for one record kind
+ * @param path File path
+ * @param kind STEALTH_STORE_KEYS, _ADDRS, _DSKS, _SYSTEM, _CURSORS or _TRACES
+ * @return Store handle (>= 0), -1 on error, -2 if the file was written with another layout
+ */
+int stealth_store_open_simple(const char* path, int kind);
+
+/**
+ * Store: Append a record
+ * @param h Store handle
+ * @param elems Record elements packed in the current wire format
+ * @param meta Metadata trailer for the kind (NULL writes zeros)
+ * @return Record index, -1 on error
+ */
+long stealth_store_append_simple(int h, const unsigned char* elems, const unsigned char* meta);
+
+/**
+ * Store: Read a record back
+ * @param h Store handle
+ * @param index Record index
+ * @param elems_out Record elements packed in the current wire format (output)
+ * @param meta_out Metadata trailer (output, may be NULL)
+ * @return 0 on success, -1 on error
+ */
+int stealth_store_get_simple(int h, long index, unsigned char* elems_out, unsigned char* meta_out);
+
+/**
+ * Store: Get number of records, -1 for a bad handle
+ */
+long stealth_store_count_simple(int h);
+
+/**
+ * Store: Drop every record of a store
+ */
+int stealth_store_reset_simple(int h);
+
+/**
+ * Store: Flush a store to disk
+ */
+int stealth_store_sync_simple(int h);
+
+/**
+ * Store: Close a store
+ */
+void stealth_store_close_simple(int h);
+
+/**
+ * Store: Save the session generator and tracer key pair (replaces any saved one)
+ * @param h Handle of a STEALTH_STORE_SYSTEM store
+ * @param TK_bytes, k_bytes Tracer key pair
+ * @return 0 on success, -1 on error
+ */
+int stealth_store_save_system_simple(int h, const unsigned char* TK_bytes, const unsigned char* k_bytes);
+
+/**
+ * Store: Restore a saved generator and return the saved tracer key pair
+ * @param h Handle of a STEALTH_STORE_SYSTEM store
+ * @param TK_out, k_out Tracer key pair (output)
+ * @param buf_size Size of each buffer
+ * @return 1 if restored, 0 if nothing is saved yet, -1 on error
+ */
+int stealth_store_load_system_simple(int h, unsigned char* TK_out, unsigned char* k_out, int buf_size);
+
+/**
+ * Store: Fast recognition of a stored address with a stored key,
+ * reading both records straight from the mapping, through the key's
+ * context once stealth_key_ctx_init_simple has been called
+ * @param addr_h, addr_index Address store and record
+ * @param key_h, key_index Key store and record
+ * @return 1 if recognized, 0 otherwise, -1 on error
+ */
+int stealth_store_recognize_fast_simple(int addr_h, long addr_index, int key_h, long key_index);
+
+/**
+ * Store: Scan a range of stored addresses for one stored key
+ * @param addr_h Address store
+ * @param start, n First record and number of records
+ * @param key_h, key_index Key store and record
+ * @param results One byte per address, 1 if recognized (output)
+ * @return Number of recognized addresses, -1 on error
+ */
+long stealth_store_scan_simple(int addr_h, long start, long n, int key_h, long key_index,
+                           unsigned char* results);
+
+/**
+ * Store: Find the owner of each address in a range among several stored
+ * keys, across a worker pool (stealth_recognize_multi_block)
+ * @param addr_h Address store
+ * @param start, n First record and number of records
+ * @param key_h Key store
+ * @param key_indices Key records to scan for, k of them; NULL for records 0..k-1
+ * @param k Number of keys
+ * @param num_threads Number of threads, <= 0 for one per online CPU
+ * @param owners Per-address key record of the owner, -1 if none (output, n ints)
+ * @return Number of owned addresses, -1 on error
+ */
+long stealth_store_scan_owners_simple(int addr_h, long start, long n, int key_h,
+                                      const long* key_indices, int k, int num_threads,
+                                      int* owners);
+
+/**
+ * Store: Scan cursor of a key, the first address record its wallet sync
+ * has not scanned yet. Checkpoints are appended, the latest one of a key wins.
+ * @param cur_h Cursor store
+ * @param key_index Key store record
+ * @param owned_out Outputs found for the key before the cursor (output, may be NULL)
+ * @return Cursor, 0 if the key has no checkpoint yet, -1 on error
+ */
+long stealth_store_cursor_simple(int cur_h, long key_index, long* owned_out);
+
+/**
+ * Store: Resumable wallet sync of one key. Scans the address records from
+ * the key's cursor, stores the one-time key of every output it recognizes,
+ * then appends a checkpoint with the new cursor, so a restarted wallet
+ * picks up where it stopped. A sync cut short before its checkpoint is
+ * redone from the previous one without storing a DSK twice.
+ * @param addr_h Address store
+ * @param key_h, key_index Key store and record
+ * @param cur_h Cursor store
+ * @param dsk_h DSK store, -1 to only move the cursor
+ * @param dsk_flags Flags byte of the DSK records written
+ * @param max_n Most address records to scan, <= 0 for all of them
+ * @param owned Address records recognized in this sync (output, up to owned_cap, may be NULL)
+ * @param owned_cap Size of owned
+ * @param cursor_out New cursor (output)
+ * @return Number of outputs recognized in this sync, -1 on error
+ */
+long stealth_store_sync_scan_simple(int addr_h, int key_h, long key_index, int cur_h, int dsk_h,
+                                    int dsk_flags, long max_n, long* owned, long owned_cap,
+                                    long* cursor_out);
+
+/**
+ * Store: Trace the address records not traced yet into a trace store, whose
+ * record i holds the recovered B of address record i, the registered key
+ * of that B at trace time and the previous trace record of the same B.
+ * The chains of a B, headed from the registry, make stealth_store_trace_find_simple
+ * a lookup instead of a trace of every address.
+ * @param addr_h Address store
+ * @param trace_h Trace store
+ * @param k_bytes Trace private key
+ * @param max_n Most address records to trace, <= 0 for all of them
+ * @return Number of address records traced, -1 on error
+ */
+long stealth_store_trace_sync_simple(int addr_h, int trace_h, const unsigned char* k_bytes, long max_n);
+
+/**
+ * Store: Address records traced to a public key B, newest first
+ * @param trace_h Trace store
+ * @param B_bytes Public key B
+ * @param addr_out Address records (output, up to cap, may be NULL)
+ * @param cap Size of addr_out
+ * @return Number of address records traced to B, -1 on error
+ */
+long stealth_store_trace_find_simple(int trace_h, const unsigned char* B_bytes, long* addr_out, long cap);
+
+/**
+ * Store: Rebuild the key registry from a key store (record index = registry id)
+ * @param key_h Key store
+ * @return Number of keys registered, -1 on error
+ */
+long stealth_store_registry_load_simple(int key_h);
+
+/**
+ * Store: Rebuild the address index from an address store (record index =
+ * address id, owner from the record's key index)
+ * @param addr_h Address store
+ * @return Number of addresses registered, -1 on error
+ */
+long stealth_store_registry_load_addrs_simple(int addr_h);
+
+//----------------------------------------------
+// Key Contexts
+// Recipient contexts (stealth_recipient_ctx_t) of the keys a server holds,
+// by key index, so that address generation and recognition for a stored
+// key take A^r, B^r2 and B^r2' from fixed-base tables and e(R2, TK) from
+// one pairing table shared by every key. The tables of each key are built
+// once, at keygen, into a key table store next to the key store, and read
+// from its mapping when the key is first used after a restart.
+//----------------------------------------------
+
+/**
+ * Store: Open (or create) a key table store, record i holding the tables
+ * of key record i
+ * @param path File path
+ * @return Store handle (>= 0), -1 on error, -2 if the file was written with another layout
+ */
+int stealth_store_open_key_tables_simple(const char* path);
+
+/**
+ * Store: Append the tables of the key records that have none yet. A table
+ * store longer than its key store belongs to keys since dropped and is
+ * emptied first.
+ * @param key_h Key store
+ * @param tables_h Key table store
+ * @return Number of tables appended, -1 on error
+ */
+long stealth_store_key_tables_sync_simple(int key_h, int tables_h);
+
+/**
+ * Key contexts: Drop the contexts and start over for a trace key
+ * @param TK_bytes Trace public key
+ * @param tables_h Key table store to read the tables from, -1 to build them
+ * @return 0 on success, -1 on error
+ */
+int stealth_key_ctx_init_simple(const unsigned char* TK_bytes, int tables_h);
+
+/**
+ * Key contexts: Release every context. Call before stealth_init replaces
+ * the pairing they live in.
+ */
+void stealth_key_ctx_clear_simple(void);
+
+/**
+ * Key contexts: Generate an address to key 'key_index' through its
+ * context; same output as stealth_addr_gen_simple (with tag_out, as
+ * stealth_addr_gen_tagged_simple). A key whose index now names other
+ * public keys gets a new context.
+ * @param key_index Key index
+ * @param A_bytes, B_bytes Public keys of the key
+ * @param tag_out STEALTH_VIEW_TAG_LEN bytes (output), NULL for an untagged address
+ * @return 0 on success, -1 without stealth_key_ctx_init_simple
+ */
+int stealth_key_addr_gen_simple(long key_index, const unsigned char* A_bytes,
+                                const unsigned char* B_bytes,
+                                unsigned char* addr_out, unsigned char* r1_out,
+                                unsigned char* r2_out, unsigned char* c_out,
+                                unsigned char* tag_out, int buf_size);
+
+/**
+ * Key contexts: Fast recognition for key 'key_index' through its context
+ * @param tag View tag stored with the address, NULL if untagged
+ * @return 1 if recognized, 0 otherwise, -1 without stealth_key_ctx_init_simple
+ */
+int stealth_key_recognize_fast_simple(long key_index, const unsigned char* A_bytes,
+                                      const unsigned char* B_bytes,
+                                      const unsigned char* R1_bytes, const unsigned char* C_bytes,
+                                      const unsigned char* tag, const unsigned char* a_bytes);
+
+/**
+ * Hex: Lowercase hex of n bytes into out (2n characters and a NUL)
+ * @return 1 if every byte was zero, else 0
+ */
+int stealth_to_hex_simple(const unsigned char* in, int n, char* out);
+
+/**
+ * Hex: Decode len hex characters (an odd length takes a leading '0') into
+ * at most buf_size bytes of out
+ * @return Bytes the text decodes to (beyond buf_size dropped), -1 if it is not hex
+ */
+long stealth_from_hex_simple(const char* hex, long len, unsigned char* out, int buf_size);
+
+/**
+ * Hex: Encode n elements of size bytes, element i at in + i * size, into
+ * out as n comma-separated strings (n * (2 * size + 1) - 1 characters)
+ * @param zero_out One byte per element, 1 if it is all zero (output), NULL to skip
+ * @return Number of all-zero elements
+ */
+long stealth_to_hex_batch_simple(const unsigned char* in, long n, int size, char* out,
+                                 unsigned char* zero_out);
+
+/**
+ * Hex: Decode n comma-separated hex strings into n packed elements of size
+ * bytes each, zero padded on the right, as the batch functions take them
+ * @param text Strings separated by ',' (len characters)
+ * @return 0 on success, 1 + i if string i is empty or not hex, -1 if text holds fewer than n
+ */
+long stealth_from_hex_batch_simple(const char* text, long len, long n, int size, unsigned char* out);
+
 #endif /* PYTHON_API_H */
\ No newline at end of file
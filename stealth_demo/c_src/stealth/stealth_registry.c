@@ -0,0 +1,298 @@
+/****************************************************************************
+ * File: stealth_registry.c
+ * Desc: Key registry hash index implementation
+ *       Open addressing with linear probing, keyed by FNV-1a of the
+ *       canonical element encoding, or of the compact one for addresses so
+ *       that address store records key it as they are. The address index
+ *       also keeps a Bloom
+ *       filter sized with the table, probed by double hashing of the same
+ *       FNV-1a value, so a miss costs a few bit tests instead of a probe
+ *       run through slots and their out-of-line keys
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stealth_registry.h"
+#include "stealth_core.h"
+
+//----------------------------------------------
+// Index layout
+//----------------------------------------------
+typedef struct {
+    unsigned char* key;          // canonical bytes, NULL if the slot is free
+    int len;
+    int id;
+    int owner;                   // owning key id, address index only
+    uint64_t hash;
+} registry_slot_t;
+
+typedef struct {
+    registry_slot_t* slots;
+    int capacity;                // power of two
+    int count;
+    int filtered;                // keeps a Bloom filter
+    int compact;                 // keyed by the compact point encoding
+    uint64_t* bloom;             // capacity * REGISTRY_BLOOM_BITS bits
+} registry_index_t;
+
+static registry_index_t index_A, index_B;
+static registry_index_t index_addr = { .filtered = 1, .compact = 1 };
+static registry_index_t index_trace;
+static long trace_records;
+
+#define REGISTRY_MIN_CAPACITY 64
+// Filter bits per slot; at the 0.7 load bound that is over 22 bits per
+// entry, for a false positive rate near 1e-4 with 6 probes
+#define REGISTRY_BLOOM_BITS 16
+#define REGISTRY_BLOOM_PROBES 6
+
+//----------------------------------------------
+// Helpers
+//----------------------------------------------
+static uint64_t fnv1a(const unsigned char* data, int len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Second hash of the filter probes, odd so that every probe lands on a new bit
+static uint64_t bloom_step(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash | 1;
+}
+
+static void bloom_set(registry_index_t* ix, uint64_t hash) {
+    uint64_t mask = (uint64_t)ix->capacity * REGISTRY_BLOOM_BITS - 1;
+    uint64_t step = bloom_step(hash);
+    for (int i = 0; i < REGISTRY_BLOOM_PROBES; i++, hash += step)
+        ix->bloom[(hash & mask) >> 6] |= 1ULL << (hash & 63);
+}
+
+static int bloom_test(const registry_index_t* ix, uint64_t hash) {
+    uint64_t mask = (uint64_t)ix->capacity * REGISTRY_BLOOM_BITS - 1;
+    uint64_t step = bloom_step(hash);
+    for (int i = 0; i < REGISTRY_BLOOM_PROBES; i++, hash += step)
+        if (!(ix->bloom[(hash & mask) >> 6] & (1ULL << (hash & 63)))) return 0;
+    return 1;
+}
+
+static registry_slot_t* index_probe(registry_index_t* ix, const unsigned char* key, int len,
+                                    uint64_t hash) {
+    int mask = ix->capacity - 1;
+    for (int i = (int)(hash & mask);; i = (i + 1) & mask) {
+        registry_slot_t* s = &ix->slots[i];
+        if (!s->key) return s;
+        if (s->hash == hash && s->len == len && memcmp(s->key, key, len) == 0) return s;
+    }
+}
+
+static int index_grow(registry_index_t* ix) {
+    int capacity = ix->capacity ? ix->capacity * 2 : REGISTRY_MIN_CAPACITY;
+    registry_slot_t* slots = calloc(capacity, sizeof(registry_slot_t));
+    uint64_t* bloom = NULL;
+    if (slots && ix->filtered) bloom = calloc((size_t)capacity * REGISTRY_BLOOM_BITS / 64, sizeof(uint64_t));
+    if (!slots || (ix->filtered && !bloom)) {
+        free(slots);
+        return -1;
+    }
+
+    registry_index_t grown = { slots, capacity, ix->count, ix->filtered, ix->compact, bloom };
+    for (int i = 0; i < ix->capacity; i++) {
+        registry_slot_t* s = &ix->slots[i];
+        if (!s->key) continue;
+        *index_probe(&grown, s->key, s->len, s->hash) = *s;
+        if (bloom) bloom_set(&grown, s->hash);
+    }
+    free(ix->slots);
+    free(ix->bloom);
+    *ix = grown;
+    return 0;
+}
+
+// Key bytes of an element in the index's encoding, -1 if longer than cap
+static int index_key(const registry_index_t* ix, unsigned char* buf, int cap, element_t e) {
+    int len = ix->compact ? stealth_compact_length(e) : element_length_in_bytes(e);
+    if (len > cap) return -1;
+    if (ix->compact) stealth_compact_to_bytes(buf, e);
+    else element_to_bytes(buf, e);
+    return len;
+}
+
+static int index_put_key(registry_index_t* ix, const unsigned char* buf, int len, int id, int owner) {
+    // Keep the load factor under 0.7
+    if ((ix->count + 1) * 10 > ix->capacity * 7 && index_grow(ix) < 0) return -1;
+
+    uint64_t hash = fnv1a(buf, len);
+    registry_slot_t* s = index_probe(ix, buf, len, hash);
+    if (!s->key) {
+        s->key = malloc(len);
+        if (!s->key) return -1;
+        memcpy(s->key, buf, len);
+        s->len = len;
+        s->hash = hash;
+        ix->count++;
+        if (ix->bloom) bloom_set(ix, hash);
+    }
+    s->id = id;
+    s->owner = owner;
+    return 0;
+}
+
+static int index_put(registry_index_t* ix, element_t e, int id, int owner) {
+    unsigned char buf[1024];
+    int len = index_key(ix, buf, sizeof(buf), e);
+    if (len < 0) return -1;
+    return index_put_key(ix, buf, len, id, owner);
+}
+
+static int index_get(registry_index_t* ix, element_t e, int* owner) {
+    unsigned char buf[1024];
+    if (!ix->count) return -1;
+    int len = index_key(ix, buf, sizeof(buf), e);
+    if (len < 0) return -1;
+
+    uint64_t hash = fnv1a(buf, len);
+    if (ix->bloom && !bloom_test(ix, hash)) return -1;
+    registry_slot_t* s = index_probe(ix, buf, len, hash);
+    if (!s->key) return -1;
+    if (owner) *owner = s->owner;
+    return s->id;
+}
+
+static void index_clear(registry_index_t* ix) {
+    int filtered = ix->filtered, compact = ix->compact;
+    for (int i = 0; i < ix->capacity; i++) free(ix->slots[i].key);
+    free(ix->slots);
+    free(ix->bloom);
+    memset(ix, 0, sizeof(*ix));
+    ix->filtered = filtered;
+    ix->compact = compact;
+}
+
+//----------------------------------------------
+// Registry
+//----------------------------------------------
+
+/**
+ * Register a key pair
+ */
+int stealth_registry_add(element_t A, element_t B, int id) {
+    if (id < 0) return -1;
+    if (index_put(&index_A, A, id, -1) < 0 || index_put(&index_B, B, id, -1) < 0) return -1;
+    return 0;
+}
+
+/**
+ * Look up by public key A
+ */
+int stealth_registry_find_A(element_t A) {
+    return index_get(&index_A, A, NULL);
+}
+
+/**
+ * Look up by public key B
+ */
+int stealth_registry_find_B(element_t B) {
+    return index_get(&index_B, B, NULL);
+}
+
+/**
+ * Get number of registered key pairs
+ */
+int stealth_registry_count(void) {
+    return index_B.count;
+}
+
+/**
+ * Drop every entry
+ */
+void stealth_registry_clear(void) {
+    index_clear(&index_A);
+    index_clear(&index_B);
+    index_clear(&index_addr);
+    stealth_registry_clear_traces();
+}
+
+//----------------------------------------------
+// Address index
+//----------------------------------------------
+
+/**
+ * Register a one-time address
+ */
+int stealth_registry_add_addr(element_t Addr, int id, int owner) {
+    if (id < 0) return -1;
+    return index_put(&index_addr, Addr, id, owner);
+}
+
+/**
+ * Register a one-time address by its compact encoding
+ */
+int stealth_registry_add_addr_compact(const unsigned char* key, int len, int id, int owner) {
+    if (id < 0 || !key || len <= 0) return -1;
+    return index_put_key(&index_addr, key, len, id, owner);
+}
+
+/**
+ * Look up a one-time address
+ */
+int stealth_registry_find_addr(element_t Addr, int* owner) {
+    return index_get(&index_addr, Addr, owner);
+}
+
+/**
+ * Get number of registered addresses
+ */
+int stealth_registry_addr_count(void) {
+    return index_addr.count;
+}
+
+/**
+ * Drop the addresses only
+ */
+void stealth_registry_clear_addrs(void) {
+    index_clear(&index_addr);
+}
+
+//----------------------------------------------
+// Trace heads
+//----------------------------------------------
+
+/**
+ * Make a trace record the latest one of its B
+ */
+int stealth_registry_add_trace(element_t B, int rec) {
+    if (rec < 0) return -2;
+    int prev = index_get(&index_trace, B, NULL);
+    if (index_put(&index_trace, B, rec, -1) < 0) return -2;
+    trace_records++;
+    return prev;
+}
+
+/**
+ * Latest trace record of a B
+ */
+int stealth_registry_find_trace(element_t B) {
+    return index_get(&index_trace, B, NULL);
+}
+
+/**
+ * Get number of trace records added since the last clear
+ */
+long stealth_registry_trace_records(void) {
+    return trace_records;
+}
+
+/**
+ * Drop the trace heads only
+ */
+void stealth_registry_clear_traces(void) {
+    index_clear(&index_trace);
+    trace_records = 0;
+}
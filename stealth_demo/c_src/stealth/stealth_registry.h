@@ -0,0 +1,113 @@
+/****************************************************************************
+ * File: stealth_registry.h
+ * Desc: Hash index over registered recipient keys for Traceable Anonymous Transaction Scheme
+ *       Maps the canonical (uncompressed) encoding of A and B to the
+ *       caller's key id, so a traced B resolves to its owner in O(1).
+ *       A second index maps known one-time addresses, by their compact
+ *       encoding (stealth_compact_to_bytes), to their id and
+ *       owning key, behind a Bloom filter that turns most lookups of
+ *       unknown addresses away without touching the table. A third index
+ *       keeps the latest trace record of each recovered B, the head of
+ *       that B's chain in a trace store
+ ****************************************************************************/
+
+#ifndef STEALTH_REGISTRY_H
+#define STEALTH_REGISTRY_H
+
+#include <pbc/pbc.h>
+
+/**
+ * Register a key pair. Re-adding a known A or B moves it to the new id.
+ * Not thread-safe; the registry is shared library state like the pairing.
+ * @param A Public key A
+ * @param B Public key B
+ * @param id Registry id (e.g. index in the caller's key list), >= 0
+ * @return 0 on success, -1 on error
+ */
+int stealth_registry_add(element_t A, element_t B, int id);
+
+/**
+ * Look up a key pair by public key A
+ * @param A Public key A
+ * @return Registered id, -1 if unknown
+ */
+int stealth_registry_find_A(element_t A);
+
+/**
+ * Look up a key pair by public key B
+ * @param B Public key B (e.g. the output of stealth_trace)
+ * @return Registered id, -1 if unknown
+ */
+int stealth_registry_find_B(element_t B);
+
+/**
+ * Get number of registered key pairs
+ */
+int stealth_registry_count(void);
+
+/**
+ * Drop every entry, keys and addresses (call when the pairing changes)
+ */
+void stealth_registry_clear(void);
+
+/**
+ * Register a one-time address. Re-adding a known Addr moves it to the new id.
+ * @param Addr One-time address
+ * @param id Address id (e.g. index in the caller's address list), >= 0
+ * @param owner Id of the owning key, -1 if not known
+ * @return 0 on success, -1 on error
+ */
+int stealth_registry_add_addr(element_t Addr, int id, int owner);
+
+/**
+ * stealth_registry_add_addr from the compact encoding of Addr, as kept in
+ * address store records, without decoding the point
+ * @param key stealth_compact_to_bytes of Addr
+ * @param len Its length, stealth_compact_length
+ * @return 0 on success, -1 on error
+ */
+int stealth_registry_add_addr_compact(const unsigned char* key, int len, int id, int owner);
+
+/**
+ * Look up a one-time address
+ * @param Addr One-time address
+ * @param owner Owning key id of a known address (output, may be NULL)
+ * @return Registered id, -1 if unknown
+ */
+int stealth_registry_find_addr(element_t Addr, int* owner);
+
+/**
+ * Get number of registered addresses
+ */
+int stealth_registry_addr_count(void);
+
+/**
+ * Drop the addresses only (call when the address list is replaced)
+ */
+void stealth_registry_clear_addrs(void);
+
+/**
+ * Make a trace record the latest one of its recovered B
+ * @param B Recovered public key B
+ * @param rec Trace record, >= 0
+ * @return Previous latest record of B, -1 if none, -2 on error
+ */
+int stealth_registry_add_trace(element_t B, int rec);
+
+/**
+ * Latest trace record of a recovered B
+ * @return Trace record, -1 if B was never traced
+ */
+int stealth_registry_find_trace(element_t B);
+
+/**
+ * Get number of trace records added since the last clear
+ */
+long stealth_registry_trace_records(void);
+
+/**
+ * Drop the trace heads only (call when the trace store is replaced)
+ */
+void stealth_registry_clear_traces(void);
+
+#endif /* STEALTH_REGISTRY_H */
@@ -0,0 +1,42 @@
+/****************************************************************************
+ * File: stealth_store.c
+ * Desc: Record store wrappers, see common/record_store.c
+ ****************************************************************************/
+
+#include "stealth_store.h"
+
+int stealth_store_open(const char* path, uint32_t kind, uint32_t record_size) {
+    return record_store_open(path, kind, record_size);
+}
+
+long stealth_store_append(int h, const unsigned char* record) {
+    return record_store_append(h, record);
+}
+
+const unsigned char* stealth_store_record(int h, long index) {
+    return record_store_record(h, index);
+}
+
+long stealth_store_count(int h) {
+    return record_store_count(h);
+}
+
+uint32_t stealth_store_kind(int h) {
+    return record_store_kind(h);
+}
+
+uint32_t stealth_store_record_size(int h) {
+    return record_store_record_size(h);
+}
+
+int stealth_store_reset(int h) {
+    return record_store_reset(h);
+}
+
+int stealth_store_sync(int h) {
+    return record_store_sync(h);
+}
+
+void stealth_store_close(int h) {
+    record_store_close(h);
+}
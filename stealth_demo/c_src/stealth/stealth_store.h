@@ -0,0 +1,54 @@
+/****************************************************************************
+ * File: stealth_store.h
+ * Desc: Append-only, memory-mapped record store for Traceable Anonymous Transaction Scheme
+ *       Thin wrappers over the shared store (common/record_store.h),
+ *       which documents the file layout and each call
+ ****************************************************************************/
+
+#ifndef STEALTH_STORE_H
+#define STEALTH_STORE_H
+
+#include <stdint.h>
+#include "record_store.h"
+
+#define STEALTH_STORE_MAGIC RECORD_STORE_MAGIC
+#define STEALTH_STORE_VERSION RECORD_STORE_VERSION
+#define STEALTH_STORE_MAX_OPEN RECORD_STORE_MAX_OPEN
+
+/**
+ * Open (or create) a store file, see record_store_open
+ * @return Store handle (>= 0), -1 on I/O error, -2 if the file holds another kind or record size
+ */
+int stealth_store_open(const char* path, uint32_t kind, uint32_t record_size);
+
+/**
+ * Append one record, see record_store_append
+ * @return Index of the new record, -1 on error
+ */
+long stealth_store_append(int h, const unsigned char* record);
+
+/**
+ * Get a record in place, valid until the next append or close
+ * @return Pointer into the mapping, NULL if out of range
+ */
+const unsigned char* stealth_store_record(int h, long index);
+
+/** Get number of records, -1 for a bad handle */
+long stealth_store_count(int h);
+
+/** Get the record kind of an open store, 0 for a bad handle */
+uint32_t stealth_store_kind(int h);
+
+/** Get the record size of an open store, 0 for a bad handle */
+uint32_t stealth_store_record_size(int h);
+
+/** Drop every record (the file keeps its header) */
+int stealth_store_reset(int h);
+
+/** Flush the mapping to disk */
+int stealth_store_sync(int h);
+
+/** Sync, unmap and close a store; the handle becomes free */
+void stealth_store_close(int h);
+
+#endif /* STEALTH_STORE_H */
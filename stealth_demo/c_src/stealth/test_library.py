@@ -44,8 +44,8 @@ def setup_function_signatures(lib):
         lib.stealth_addr_gen_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_int]
         lib.stealth_addr_gen_simple.restype = None
         
-        lib.stealth_addr_verify_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p]
-        lib.stealth_addr_verify_simple.restype = c_int
+        lib.stealth_addr_recognize_fast_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p]
+        lib.stealth_addr_recognize_fast_simple.restype = c_int
         
         lib.stealth_sign_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_int]
         lib.stealth_sign_simple.restype = None
@@ -59,6 +59,14 @@ def setup_function_signatures(lib):
         lib.stealth_performance_test_simple.argtypes = [c_int, POINTER(c_double)]
         lib.stealth_performance_test_simple.restype = None
         
+        # Context scan
+        lib.stealth_ctx_new.argtypes = [c_char_p, c_int]
+        lib.stealth_ctx_new.restype = c_void_p
+        lib.stealth_ctx_free.argtypes = [c_void_p]
+        lib.stealth_ctx_free.restype = None
+        lib.stealth_ctx_scan.argtypes = [c_void_p, c_char_p, c_char_p, c_int, c_char_p, c_char_p, c_char_p]
+        lib.stealth_ctx_scan.restype = c_int
+        
         print("✅ Function signatures set up successfully")
         return True
         
@@ -119,7 +127,7 @@ def test_initialization(lib):
             print(f"📏 G1 element size: {g1_size} bytes")
             print(f"📏 Zr element size: {zr_size} bytes")
             
-            return True
+            return param_file
         else:
             print(f"❌ Library initialization failed: {result}")
             return False
@@ -246,7 +254,7 @@ def test_address_verification(lib, keys, address_data):
         addr_buf, r1_buf, r2_buf, c_buf = address_data
         
         # Verify address (fast version)
-        result = lib.stealth_addr_verify_simple(
+        result = lib.stealth_addr_recognize_fast_simple(
             r1_buf.raw, B_buf.raw, A_buf.raw, c_buf.raw, a_buf.raw
         )
         
@@ -261,6 +269,53 @@ def test_address_verification(lib, keys, address_data):
         print(f"❌ Error in address verification test: {e}")
         return False
 
+def test_ctx_scan(lib, param_file, keys, trace_keys):
+    """Test that a context scan finds the outputs single-address recognition does"""
+    try:
+        print("\n🔍 Testing Context Scan...")
+        
+        A_buf, B_buf, a_buf, b_buf = keys
+        TK_buf, k_buf = trace_keys
+        
+        buf_size = max(lib.stealth_element_size_G1(), lib.stealth_element_size_Zr(), 512)
+        g1_size = lib.stealth_element_size_G1()
+        A2_buf, B2_buf, a2_buf, b2_buf = [create_string_buffer(buf_size) for _ in range(4)]
+        lib.stealth_keygen_simple(A2_buf, B2_buf, a2_buf, b2_buf, buf_size)
+        
+        # Outputs alternate between the two recipients
+        n = 8
+        R1_all, C_all, expected = b"", b"", []
+        for i in range(n):
+            A, B = (A_buf, B_buf) if i % 2 == 0 else (A2_buf, B2_buf)
+            addr_buf, r1_buf, r2_buf, c_buf = [create_string_buffer(buf_size) for _ in range(4)]
+            lib.stealth_addr_gen_simple(A.raw, B.raw, TK_buf.raw,
+                                        addr_buf, r1_buf, r2_buf, c_buf, buf_size)
+            R1_all += r1_buf.raw[:g1_size]
+            C_all += c_buf.raw[:g1_size]
+            expected.append(lib.stealth_addr_recognize_fast_simple(
+                r1_buf.raw, B_buf.raw, A_buf.raw, c_buf.raw, a_buf.raw))
+        
+        # The workers raise R1 to a as the recognize path does (STEALTH_SECRET_CT)
+        ctx = lib.stealth_ctx_new(param_file.encode(), 2)
+        if not ctx:
+            print("❌ Context creation failed")
+            return False
+        bitmap = create_string_buffer((n + 7) // 8)
+        matches = lib.stealth_ctx_scan(ctx, R1_all, C_all, n, B_buf.raw, a_buf.raw, bitmap)
+        lib.stealth_ctx_free(ctx)
+        found = [(bitmap.raw[i >> 3] >> (i & 7)) & 1 for i in range(n)]
+        
+        if found == expected and matches == sum(expected) == n // 2:
+            print(f"✅ Context scan matches single-address recognition ({matches}/{n})")
+            return True
+        else:
+            print(f"❌ Context scan {found} ({matches}), recognition {expected}")
+            return False
+            
+    except Exception as e:
+        print(f"❌ Error in context scan test: {e}")
+        return False
+
 def test_performance(lib):
     """Test performance measurement"""
     try:
@@ -302,7 +357,8 @@ def main():
         sys.exit(1)
     
     # Test 3: Initialize library
-    if not test_initialization(lib):
+    param_file = test_initialization(lib)
+    if not param_file:
         sys.exit(1)
     
     # Test 4: Key generation
@@ -324,7 +380,11 @@ def main():
     if not test_address_verification(lib, keys, address_data):
         sys.exit(1)
     
-    # Test 8: Performance measurement
+    # Test 8: Context scan against single-address recognition
+    if not test_ctx_scan(lib, param_file, keys, trace_keys):
+        sys.exit(1)
+    
+    # Test 9: Performance measurement
     if not test_performance(lib):
         sys.exit(1)
     
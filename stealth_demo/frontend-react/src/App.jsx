@@ -8,6 +8,7 @@ import MessageSigning from './components/MessageSigning'
 import SignatureVerification from './components/SignatureVerification'
 import IdentityTracing from './components/IdentityTracing'
 import PerformanceTest from './components/PerformanceTest'
+import LiveMetrics from './components/LiveMetrics'
 import SchemeSelector from './components/SchemeSelector'
 import { AppDataProvider } from './hooks/useAppData'
 import { SchemeProvider, useSchemeContext } from './hooks/useSchemeContext'
@@ -70,6 +71,7 @@ function App() {
             
             {/* Performance Test spans full width */}
             <PerformanceTest />
+            <LiveMetrics />
           </div>
         </div>
       </AppDataProvider>
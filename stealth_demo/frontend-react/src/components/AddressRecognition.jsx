@@ -1,17 +1,24 @@
 import React, { useState, useCallback } from 'react';
-import { Section, Button, Select, Output } from './common';
+import { Section, Button, Select, ListPicker, Output } from './common';
 import { apiService } from '../services/apiService';
 import { useAppData } from '../hooks/useAppData';
 import { useSchemeContext } from '../hooks/useSchemeContext';
+import { usePagedList } from '../hooks/usePagedList';
 import { getRecognitionResultDetails } from '../utils/recognitionDisplay';
 import { truncateHex } from '../utils/helpers';
 
 function AddressRecognition() {
   const { currentScheme: scheme } = useSchemeContext();
-  const { keys, addresses, loadAllData, loading: globalLoading, error: globalError, setError } = useAppData();
+  const { loading: globalLoading, error: globalError, setError } = useAppData();
   
-  const [selectedKeyIndex, setSelectedKeyIndex] = useState('');
-  const [selectedAddrIndex, setSelectedAddrIndex] = useState('');
+  const [addrSearch, setAddrSearch] = useState('');
+  const [keySearch, setKeySearch] = useState('');
+  const addressPages = usePagedList('addresses', { query: addrSearch, scheme });
+  const keyPages = usePagedList('keys', { query: keySearch, scheme });
+  const { refresh: refreshAddresses } = addressPages;
+  const { refresh: refreshKeys } = keyPages;
+  const [selectedKey, setSelectedKey] = useState(null);
+  const [selectedAddr, setSelectedAddr] = useState(null);
   const [recognitionMethod, setRecognitionMethod] = useState('fast');
   const [localLoading, setLocalLoading] = useState({});
   const [localError, setLocalError] = useState('');
@@ -21,11 +28,11 @@ function AddressRecognition() {
     setLocalError('');
     setError('');
     setRecognitionResult(null);
-    await loadAllData();
-  }, [loadAllData, setError]);
+    await Promise.all([refreshAddresses(), refreshKeys()]);
+  }, [refreshAddresses, refreshKeys, setError]);
 
   const handleRecognizeAddress = useCallback(async () => {
-    if (selectedAddrIndex === '' || selectedKeyIndex === '') {
+    if (!selectedAddr || !selectedKey) {
       setLocalError('Please select both an address and a key!');
       return;
     }
@@ -36,8 +43,8 @@ function AddressRecognition() {
       setError('');
       
       const result = await apiService.recognizeAddress(
-        parseInt(selectedAddrIndex),
-        parseInt(selectedKeyIndex),
+        selectedAddr.index,
+        selectedKey.index,
         recognitionMethod === 'fast'
       );
       
@@ -48,59 +55,45 @@ function AddressRecognition() {
     } finally {
       setLocalLoading(prev => ({ ...prev, recognizing: false }));
     }
-  }, [selectedAddrIndex, selectedKeyIndex, recognitionMethod, scheme, setError]);
+  }, [selectedAddr, selectedKey, recognitionMethod, scheme, setError]);
 
   const getOutputContent = () => {
-    const error = localError || globalError;
+    const error = localError || globalError || addressPages.error || keyPages.error;
     if (error) {
       return `Error: ${error}`;
     }
     
     if (recognitionResult) {
-      const selectedAddr = addresses[parseInt(selectedAddrIndex)];
-      const selectedKey = keys[parseInt(selectedKeyIndex)];
       return getRecognitionResultDetails(scheme, recognitionResult, selectedAddr, selectedKey);
     }
     
     return 'Select an address, a key, and a method, then click \'Recognize Address\'.';
   };
 
-  const filteredAddresses = addresses.filter(addr => addr.scheme === scheme);
-
   return (
     <Section title={`🔍 Address Recognition (${scheme.toUpperCase()})`}>
       <div className="controls">
         <label>Select Address to Recognize:</label>
-        <Select
-          value={selectedAddrIndex}
-          onChange={(e) => setSelectedAddrIndex(e.target.value)}
-          disabled={globalLoading.all}
-        >
-          <option value="">
-            {globalLoading.all ? 'Loading addresses...' : 'Select address...'}
-          </option>
-          {filteredAddresses.map((addr, index) => (
-            <option key={addr.id} value={addresses.indexOf(addr)}> 
-              {addr.id} - {truncateHex(addr.addr_hex, 12)}
-            </option>
-          ))}
-        </Select>
+        <ListPicker
+          paged={addressPages}
+          search={addrSearch}
+          onSearchChange={setAddrSearch}
+          selected={selectedAddr}
+          onSelect={setSelectedAddr}
+          describe={(addr) => `${addr.id} - ${truncateHex(addr.addr_hex, 12)}`}
+          placeholder="Search addresses by id, owner or hex..."
+        />
         
         <label>Select Key for Recognition:</label>
-        <Select
-          value={selectedKeyIndex}
-          onChange={(e) => setSelectedKeyIndex(e.target.value)}
-          disabled={globalLoading.all}
-        >
-          <option value="">
-            {globalLoading.all ? 'Loading keys...' : 'Select key...'}
-          </option>
-          {keys.map((key, index) => (
-            <option key={key.id} value={index}>
-              {key.id} - A: {truncateHex(key.A_hex, 8)}
-            </option>
-          ))}
-        </Select>
+        <ListPicker
+          paged={keyPages}
+          search={keySearch}
+          onSearchChange={setKeySearch}
+          selected={selectedKey}
+          onSelect={setSelectedKey}
+          describe={(key) => `${key.id} - A: ${truncateHex(key.A_hex, 8)}`}
+          placeholder="Search keys by id or hex..."
+        />
         
         <label>Recognition Method:</label>
         <Select
@@ -116,7 +109,7 @@ function AddressRecognition() {
           <Button
             onClick={handleRecognizeAddress}
             loading={localLoading.recognizing}
-            disabled={selectedAddrIndex === '' || selectedKeyIndex === '' || localLoading.recognizing}
+            disabled={!selectedAddr || !selectedKey || localLoading.recognizing}
           >
             Recognize Address
           </Button>
@@ -124,7 +117,7 @@ function AddressRecognition() {
           <Button
             onClick={handleRefreshData}
             variant="secondary"
-            disabled={globalLoading.all}
+            disabled={addressPages.loading || keyPages.loading}
           >
             Refresh Data
           </Button>
@@ -133,7 +126,7 @@ function AddressRecognition() {
       
       <Output 
         content={getOutputContent()}
-        isError={!!(localError || globalError)}
+        isError={!!(localError || globalError || addressPages.error || keyPages.error)}
       />
     </Section>
   );
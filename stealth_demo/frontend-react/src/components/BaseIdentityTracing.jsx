@@ -1,38 +1,34 @@
 import React from 'react';
-import { Section, Select, DataList, Output } from './common';
+import { Section, ListPicker, DataList, Output } from './common';
 import { truncateHex } from '../utils/helpers';
 
+// addressPages is the current scheme's address list from usePagedList,
+// searched with addressSearch
 function BaseIdentityTracing({
   title,
   children,
-  selectedAddrIndex,
-  onAddressChange,
-  addresses,
+  selectedAddress,
+  onAddressSelect,
+  addressPages,
+  addressSearch,
+  onAddressSearchChange,
   items,
   outputContent,
-  isError,
-  globalLoading
+  isError
 }) {
-  // Filter addresses based on the scheme provided by the parent component
-  const filteredAddresses = addresses.filter(addr => addr.scheme === (title.includes('SITAIBA') ? 'sitaiba' : 'stealth'));
-
   return (
     <Section title={title}>
       <div className="controls">
         <label>Select address to trace:</label>
-        <Select
-          value={selectedAddrIndex}
-          onChange={onAddressChange}
-          disabled={globalLoading.all}
-        >
-          <option value="">Select address...</option>
-          {filteredAddresses.map((addr, index) => (
-            // Important: The value must be the original index in the `addresses` array
-            <option key={addr.id} value={addresses.indexOf(addr)}>
-              {addr.id} - Owner: {addr.key_id} - {truncateHex(addr.addr_hex, 8)}
-            </option>
-          ))}
-        </Select>
+        <ListPicker
+          paged={addressPages}
+          search={addressSearch}
+          onSearchChange={onAddressSearchChange}
+          selected={selectedAddress}
+          onSelect={onAddressSelect}
+          describe={(addr) => `${addr.id} - Owner: ${addr.key_id} - ${truncateHex(addr.addr_hex, 8)}`}
+          placeholder="Search addresses by id, owner or hex..."
+        />
         
         {children}
       </div>
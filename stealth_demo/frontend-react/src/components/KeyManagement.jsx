@@ -1,15 +1,19 @@
 import React, { useState, useCallback } from 'react';
-import { Section, Button, DataList, Output } from './common';
+import { Section, Button, Input, DataItem, VirtualList, Output } from './common';
 import { useAppData } from '../hooks/useAppData';
 import { useSchemeContext } from '../hooks/useSchemeContext';
+import { usePagedList } from '../hooks/usePagedList';
 import { apiService } from '../services/apiService';
 import { truncateHex } from '../utils/helpers';
 import { getKeyDetails, getLatestKeySummary } from '../utils/keyDisplay';
 
 function KeyManagement() {
   const { currentScheme: scheme } = useSchemeContext();
-  const { keys, addKey, loadKeys, loading: globalLoading, error: globalError, setError } = useAppData();
-  const [selectedKeyIndex, setSelectedKeyIndex] = useState(-1);
+  const { keys, addKey, loading: globalLoading, error: globalError, setError } = useAppData();
+  const [search, setSearch] = useState('');
+  const keyPages = usePagedList('keys', { query: search, scheme });
+  const { refresh: refreshKeyPages } = keyPages;
+  const [selectedKey, setSelectedKey] = useState(null);
   const [localLoading, setLocalLoading] = useState({});
   const [localError, setLocalError] = useState('');
 
@@ -21,37 +25,31 @@ function KeyManagement() {
       
       const newKey = await apiService.generateKey();
       addKey(newKey);
+      refreshKeyPages();
       
     } catch (err) {
       setLocalError(`${scheme.toUpperCase()} key generation failed: ${err.message}`);
     } finally {
       setLocalLoading(prev => ({ ...prev, keygen: false }));
     }
-  }, [scheme, addKey, setError]);
+  }, [scheme, addKey, setError, refreshKeyPages]);
 
   const handleRefreshKeys = useCallback(async () => {
     setLocalError('');
     setError('');
-    await loadKeys();
-  }, [loadKeys, setError]);
-
-  const handleKeyClick = (index) => {
-    setSelectedKeyIndex(index);
-  };
+    await refreshKeyPages();
+  }, [refreshKeyPages, setError]);
 
   const getOutputContent = () => {
-    const error = localError || globalError;
+    const error = localError || globalError || keyPages.error;
     if (error) {
       return `Error: ${error}`;
     }
     
     const filteredKeys = keys.filter(key => key.scheme === scheme);
 
-    if (selectedKeyIndex >= 0 && keys[selectedKeyIndex]) {
-      const selectedKey = keys[selectedKeyIndex];
-      if (selectedKey.scheme === scheme) {
-        return getKeyDetails(scheme, selectedKey, selectedKeyIndex);
-      }
+    if (selectedKey && selectedKey.scheme === scheme) {
+      return getKeyDetails(scheme, selectedKey, selectedKey.index);
     }
     
     if (filteredKeys.length > 0) {
@@ -62,18 +60,20 @@ function KeyManagement() {
     return `Click \"Generate Key\" to create the first key for the ${scheme.toUpperCase()} scheme.`;
   };
 
-  const keyItems = keys
-    .filter(key => key.scheme === scheme)
-    .map((key, index) => ({
-      id: key.id,
-      header: `${key.id} (${key.scheme.toUpperCase()})`,
-      details: [
+  // Rows are built only for the keys in view
+  const renderKey = (key, index, style) => (
+    <DataItem
+      key={key.id}
+      style={style}
+      header={`${key.id} (${(key.scheme || scheme).toUpperCase()})`}
+      details={[
         `A: ${truncateHex(key.A_hex, 12)}`,
         `B: ${truncateHex(key.B_hex, 12)}`,
-      ],
-      selected: keys.indexOf(key) === selectedKeyIndex,
-      onClick: () => handleKeyClick(keys.indexOf(key))
-  }));
+      ]}
+      selected={!!selectedKey && selectedKey.id === key.id}
+      onClick={() => setSelectedKey(key)}
+    />
+  );
 
   return (
     <Section title={`🔑 Key Management (${scheme.toUpperCase()})`}>
@@ -92,12 +92,24 @@ function KeyManagement() {
           Refresh Key List
         </Button>
       </div>
+
+      <Input
+        value={search}
+        onChange={(e) => setSearch(e.target.value)}
+        placeholder="Search keys by id or hex..."
+      />
       
-      <DataList items={keyItems} />
+      <VirtualList
+        items={keyPages.items}
+        renderItem={renderKey}
+        rowHeight={72}
+        height={216}
+        onEndReached={keyPages.loadMore}
+      />
       
       <Output 
         content={getOutputContent()}
-        isError={!!(localError || globalError)}
+        isError={!!(localError || globalError || keyPages.error)}
       />
     </Section>
   );
@@ -0,0 +1,190 @@
+import React, { useState, useRef, useEffect, useCallback } from 'react';
+import { Section, Button, Select } from './common';
+import { apiService } from '../services/apiService';
+import { useSchemeContext } from '../hooks/useSchemeContext';
+import { LATENCY_LABELS } from '../utils/performanceDisplay';
+
+// Snapshots kept for the throughput sparkline
+const HISTORY = 60;
+
+const PRIMITIVE_LABELS = {
+  pairing: 'Pairings',
+  g1_pow: 'G1 pow',
+  gt_pow: 'GT pow',
+  hash_zr: 'Hash to Zr',
+  hash_g1: 'Hash to G1',
+  serialize: 'Serialize',
+};
+
+const CACHE_LABELS = {
+  pairing_pp: 'Pairing tables (pairing_pp)',
+  precompute: 'Precomputed ephemerals',
+  dsk: 'DSK cache',
+  h3: 'H3(Addr) cache',
+};
+
+const percent = (rate) => (rate === null || rate === undefined ? '—' : `${(100 * rate).toFixed(1)}%`);
+
+// Total operations per second over the last HISTORY snapshots
+function Sparkline({ values }) {
+  if (values.length < 2) return null;
+  const top = Math.max(...values, 1);
+  const points = values
+    .map((v, i) => `${(100 * i) / (HISTORY - 1)},${30 - (28 * v) / top}`)
+    .join(' ');
+  return (
+    <svg className="live-sparkline" viewBox="0 0 100 30" preserveAspectRatio="none">
+      <polyline points={points} fill="none" stroke="#667eea" strokeWidth="1.5" vectorEffect="non-scaling-stroke" />
+    </svg>
+  );
+}
+
+// Bars scaled to the busiest operation, with the latency percentiles behind them
+function OperationRows({ operations }) {
+  const rows = Object.entries(operations).filter(([, op]) => op.count > 0);
+  if (rows.length === 0) return <div className="progress-text">No operations recorded yet.</div>;
+  const top = Math.max(...rows.map(([, op]) => op.per_s), 1);
+  return (
+    <div className="bench-chart">
+      {rows.map(([key, op]) => (
+        <div className="bench-row" key={key}>
+          <div className="bench-label">{LATENCY_LABELS[key] || key}</div>
+          <div className="bench-bar">
+            <div className="bench-fill" style={{ width: `${(100 * op.per_s) / top}%` }}></div>
+          </div>
+          <div className="bench-value">{op.per_s.toFixed(1)}/s</div>
+          <div className="perf-latency">
+            p50 {op.p50_ms}ms · p99 {op.p99_ms}ms · max {op.max_ms}ms · {op.count} calls since reset
+          </div>
+        </div>
+      ))}
+    </div>
+  );
+}
+
+function LiveMetrics() {
+  const { currentScheme: scheme } = useSchemeContext();
+  const [running, setRunning] = useState(false);
+  const [interval, setIntervalSeconds] = useState(1);
+  const [snapshot, setSnapshot] = useState(null);
+  const [history, setHistory] = useState([]);
+  const [connectionError, setConnectionError] = useState('');
+  const sourceRef = useRef(null);
+
+  const stop = useCallback(() => {
+    if (sourceRef.current) sourceRef.current.close();
+    sourceRef.current = null;
+    setRunning(false);
+  }, []);
+
+  const start = useCallback(() => {
+    if (sourceRef.current) sourceRef.current.close();
+    setHistory([]);
+    setConnectionError('');
+    sourceRef.current = apiService.metricsEvents(
+      (next) => {
+        setConnectionError('');
+        setSnapshot(next);
+        const ops = Object.values(next.schemes[scheme]?.operations || {});
+        const total = ops.reduce((sum, op) => sum + (op.per_s || 0), 0);
+        setHistory(prev => [...prev, total].slice(-HISTORY));
+      },
+      interval,
+      () => setConnectionError('Connection to the metrics stream lost, retrying...')
+    );
+    setRunning(true);
+  }, [interval, scheme]);
+
+  // A new interval or scheme restarts a running stream; leaving closes it
+  useEffect(() => {
+    if (running) start();
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, [interval, scheme]);
+  useEffect(() => () => sourceRef.current && sourceRef.current.close(), []);
+
+  const current = snapshot?.schemes?.[scheme];
+  const pool = snapshot?.pool;
+
+  return (
+    <Section title={`📡 Live Metrics (${scheme.toUpperCase()})`} className="performance-section">
+      <div className="controls">
+        <div className="inline-controls">
+          <label>Update every:</label>
+          <Select value={interval} onChange={(e) => setIntervalSeconds(parseFloat(e.target.value))}>
+            <option value={0.5}>0.5 s</option>
+            <option value={1}>1 s</option>
+            <option value={2}>2 s</option>
+            <option value={5}>5 s</option>
+          </Select>
+          <Button onClick={running ? stop : start} variant={running ? 'secondary' : 'primary'}>
+            {running ? 'Stop' : 'Start Live Metrics'}
+          </Button>
+        </div>
+      </div>
+
+      {connectionError && <div className="progress-text">{connectionError}</div>}
+
+      {snapshot && (
+        <>
+          <div className="performance-grid">
+            <div className="perf-metric">
+              <div className="perf-value">
+                {history.length ? history[history.length - 1].toFixed(1) : '0'}/s
+              </div>
+              <div className="perf-label">Operations</div>
+              <Sparkline values={history} />
+            </div>
+            {pool && (
+              <div className="perf-metric">
+                <div className="perf-value">{pool.busy} / {pool.workers}</div>
+                <div className="perf-label">Job workers busy</div>
+                <div className="perf-latency">{pool.queued} queued · {pool.running} running</div>
+              </div>
+            )}
+            <div className="perf-metric">
+              <div className="perf-value">{snapshot.requests_in_flight}</div>
+              <div className="perf-label">Requests in flight</div>
+            </div>
+            {current && ['pairing', 'g1_pow', 'gt_pow'].filter(p => current.primitives[p]).map(p => (
+              <div className="perf-metric" key={p}>
+                <div className="perf-value">{current.primitives[p].per_s.toFixed(1)}/s</div>
+                <div className="perf-label">{PRIMITIVE_LABELS[p]}</div>
+                <div className="perf-latency">{current.primitives[p].calls} total</div>
+              </div>
+            ))}
+          </div>
+
+          {current ? (
+            <>
+              <OperationRows operations={current.operations} />
+              <div className="performance-grid">
+                {Object.entries(current.caches).map(([cache, c]) => (
+                  <div className="perf-metric" key={cache}>
+                    <div className="perf-value">{percent(c.interval_hit_rate ?? c.hit_rate)}</div>
+                    <div className="perf-label">{CACHE_LABELS[cache] || cache}</div>
+                    <div className="perf-latency">
+                      {percent(c.hit_rate)} overall · {c.hits} hits / {c.misses} misses
+                    </div>
+                  </div>
+                ))}
+                {Object.entries(current.primitives)
+                  .filter(([p]) => !['pairing', 'g1_pow', 'gt_pow'].includes(p))
+                  .map(([p, c]) => (
+                    <div className="perf-metric" key={p}>
+                      <div className="perf-value">{c.per_s.toFixed(1)}/s</div>
+                      <div className="perf-label">{PRIMITIVE_LABELS[p] || p}</div>
+                      <div className="perf-latency">{c.calls} total</div>
+                    </div>
+                  ))}
+              </div>
+            </>
+          ) : (
+            <div className="progress-text">{scheme.toUpperCase()} is not set up on the server yet.</div>
+          )}
+        </>
+      )}
+    </Section>
+  );
+}
+
+export default LiveMetrics;
@@ -1,10 +1,50 @@
-import React, { useState, useCallback } from 'react';
+import React, { useState, useCallback, useRef, useEffect } from 'react';
 import { Section, Button, Input, Output } from './common';
 import { apiService } from '../services/apiService';
 import { useAppData } from '../hooks/useAppData';
 import { useSchemeContext } from '../hooks/useSchemeContext';
 import { getPerformanceTestDetails } from '../utils/performanceDisplay';
 
+// Server jobs report progress, so tests may run far longer than one request
+const MAX_ITERATIONS = 10000;
+
+// Operations of the configurable benchmark, in the server's order
+const BENCH_OPS = [
+  { key: 'addr_gen', label: 'Address Generation' },
+  { key: 'addr_recognize', label: 'Full Recognition' },
+  { key: 'fast_recognize', label: 'Fast Recognition' },
+  { key: 'onetime_sk', label: 'DSK Generation' },
+  { key: 'sign', label: 'Signing' },
+  { key: 'sig_verify', label: 'Signature Verification' },
+  { key: 'trace', label: 'Identity Tracing' },
+];
+
+// Throughput bars scaled to the fastest operation, with per-call percentiles
+function BenchmarkChart({ results }) {
+  const rows = BENCH_OPS.filter(op => results[op.key]);
+  const top = Math.max(...rows.map(op => results[op.key].items_per_sec), 1);
+  return (
+    <div className="bench-chart">
+      {rows.map(op => {
+        const r = results[op.key];
+        return (
+          <div className="bench-row" key={op.key}>
+            <div className="bench-label">{op.label}</div>
+            <div className="bench-bar">
+              <div className="bench-fill" style={{ width: `${(100 * r.items_per_sec) / top}%` }}></div>
+            </div>
+            <div className="bench-value">{Math.round(r.items_per_sec)}/s</div>
+            <div className="perf-latency">
+              p50 {r.p50_ms}ms · p90 {r.p90_ms}ms · p99 {r.p99_ms}ms · max {r.max_ms}ms
+              {r.setup_ms > 0 && ` · setup ${r.setup_ms}ms`}
+            </div>
+          </div>
+        );
+      })}
+    </div>
+  );
+}
+
 function PerformanceTest() {
   const { currentScheme: scheme } = useSchemeContext();
   const { loading: globalLoading, error: globalError, clearError } = useAppData();
@@ -14,42 +54,130 @@ function PerformanceTest() {
   const [selectedResultIndex, setSelectedResultIndex] = useState(-1);
   const [localLoading, setLocalLoading] = useState({});
   const [localError, setLocalError] = useState('');
+  const [job, setJob] = useState(null);
+  const eventsRef = useRef(null);
+  const [benchConfig, setBenchConfig] = useState({
+    ops: BENCH_OPS.map(op => op.key), iterations: 50, batch_size: 1,
+    num_threads: 1, precompute: true, warmup: 5,
+  });
+  const [benchResult, setBenchResult] = useState(null);
+  const [benchJob, setBenchJob] = useState(null);
+
+  useEffect(() => () => eventsRef.current?.close(), []);
 
   const handleRunPerformanceTest = useCallback(async (e) => {
     if (e) {
       e.preventDefault();
       e.stopPropagation();
     }
-    if (iterations < 1 || iterations > 1000) {
-      setLocalError('Iteration count must be between 1 and 1000!');
+    if (iterations < 1 || iterations > MAX_ITERATIONS) {
+      setLocalError(`Iteration count must be between 1 and ${MAX_ITERATIONS}!`);
       return;
     }
+    const finish = () => {
+      eventsRef.current = null;
+      setLocalLoading(prev => ({ ...prev, testing: false }));
+    };
     try {
       setLocalLoading(prev => ({ ...prev, testing: true }));
       setLocalError('');
       clearError();
-      
-      const startTime = Date.now();
-      const result = await apiService.performanceTest(iterations);
-      const endTime = Date.now();
-      
-      const testWithMetadata = {
-        ...result,
-        test_index: testResults.length,
-        timestamp: new Date().toISOString(),
-        total_test_time: endTime - startTime,
-        avg_per_iteration: (endTime - startTime) / iterations
-      };
-      
-      setTestResults(prev => [...prev, testWithMetadata]);
-      setSelectedResultIndex(testResults.length);
-      
+
+      // Runs as a server job so long tests neither block the server nor
+      // time out the request; progress arrives as server-sent events
+      const submitted = await apiService.performanceTestJob(iterations);
+      setJob(submitted);
+      eventsRef.current = apiService.jobEvents(submitted.job_id, (update) => {
+        setJob(update);
+        if (update.status === 'done') {
+          const totalTime = Math.round((update.finished - update.started) * 1000);
+          setTestResults(prev => {
+            setSelectedResultIndex(prev.length);
+            return [...prev, {
+              ...update.result,
+              test_index: prev.length,
+              timestamp: new Date().toISOString(),
+              total_test_time: totalTime,
+              avg_per_iteration: totalTime / iterations
+            }];
+          });
+          finish();
+        } else if (update.status === 'failed') {
+          setLocalError(`${scheme.toUpperCase()} performance test failed: ${update.error}`);
+          finish();
+        } else if (update.status === 'cancelled') {
+          setLocalError(`${scheme.toUpperCase()} performance test cancelled after ${update.done} iterations`);
+          finish();
+        }
+      }, () => {
+        setLocalError(`${scheme.toUpperCase()} performance test: lost connection to the job`);
+        finish();
+      });
     } catch (err) {
       setLocalError(`${scheme.toUpperCase()} performance test failed: ${err.message}`);
-    } finally {
-      setLocalLoading(prev => ({ ...prev, testing: false }));
+      finish();
     }
-  }, [iterations, testResults.length, clearError, scheme]);
+  }, [iterations, clearError, scheme]);
+
+  const handleBenchField = useCallback((field, value) => {
+    setBenchConfig(prev => ({ ...prev, [field]: value }));
+  }, []);
+
+  const handleBenchOp = useCallback((key) => {
+    setBenchConfig(prev => ({
+      ...prev,
+      ops: prev.ops.includes(key) ? prev.ops.filter(op => op !== key) : [...prev.ops, key],
+    }));
+  }, []);
+
+  const handleRunBenchmark = useCallback(async (e) => {
+    if (e) e.preventDefault();
+    if (benchConfig.ops.length === 0) {
+      setLocalError('Select at least one operation to benchmark!');
+      return;
+    }
+    const finish = () => {
+      eventsRef.current = null;
+      setLocalLoading(prev => ({ ...prev, benchmark: false }));
+    };
+    try {
+      setLocalLoading(prev => ({ ...prev, benchmark: true }));
+      setLocalError('');
+      clearError();
+
+      const submitted = await apiService.benchmarkJob(benchConfig);
+      setBenchJob(submitted);
+      eventsRef.current = apiService.jobEvents(submitted.job_id, (update) => {
+        setBenchJob(update);
+        if (update.status === 'done') {
+          setBenchResult(update.result);
+          finish();
+        } else if (update.status === 'failed') {
+          setLocalError(`${scheme.toUpperCase()} benchmark failed: ${update.error}`);
+          finish();
+        } else if (update.status === 'cancelled') {
+          setLocalError(`${scheme.toUpperCase()} benchmark cancelled`);
+          finish();
+        }
+      }, () => {
+        setLocalError(`${scheme.toUpperCase()} benchmark: lost connection to the job`);
+        finish();
+      });
+    } catch (err) {
+      setLocalError(`${scheme.toUpperCase()} benchmark failed: ${err.message}`);
+      finish();
+    }
+  }, [benchConfig, clearError, scheme]);
+
+  const handleCancelTest = useCallback(async (e) => {
+    if (e) e.preventDefault();
+    if (!job) return;
+    try {
+      await apiService.cancelJob(job.job_id);
+    } catch (err) {
+      setLocalError(`Cancel failed: ${err.message}`);
+    }
+  }, [job]);
 
   const handleClearResults = useCallback((e) => {
     if (e) e.preventDefault();
@@ -64,7 +192,7 @@ function PerformanceTest() {
 
   const handleIterationChange = useCallback((e) => {
     const value = parseInt(e.target.value) || 100;
-    setIterations(Math.min(Math.max(value, 1), 1000));
+    setIterations(Math.min(Math.max(value, 1), MAX_ITERATIONS));
   }, []);
 
   const handlePresetClick = useCallback((value, e) => {
@@ -143,13 +271,16 @@ function PerformanceTest() {
       const latestResult = testResults[testResults.length - 1];
       const metrics = getSchemeOperations(scheme, latestResult);
       const summary = Object.entries(metrics).map(([key, value]) => `• ${key}: ${value}ms`).join('\n');
+      const p99 = latestResult.latency
+        ? `\n\np99 per call: ${Object.entries(latestResult.latency).map(([op, l]) => `${op} ${l.p99_ms}ms`).join(', ')}`
+        : '';
       return `✅ ${scheme.toUpperCase()} Performance Test Completed!
 🔄 Iterations: ${latestResult.iterations}
 ⚡ Total Time: ${latestResult.total_test_time}ms
 📊 Average/Iteration: ${latestResult.avg_per_iteration.toFixed(2)}ms
 
 Key Metrics:
-${summary}`;
+${summary}${p99}`;
     }
     
     return `Configure test parameters and run ${scheme.toUpperCase()} scheme performance analysis...`;
@@ -159,16 +290,23 @@ ${summary}`;
     { label: 'Quick (10)', value: 10 },
     { label: 'Standard (100)', value: 100 },
     { label: 'Intensive (500)', value: 500 },
-    { label: 'Stress (1000)', value: 1000 }
+    { label: 'Stress (1000)', value: 1000 },
+    { label: 'Soak (10000)', value: 10000 }
   ];
 
   const metrics = getOperationMetrics(scheme);
 
+  // p50 / p99 line under a metric card, from the per-call histograms (SLOs are on p99)
+  const latencyOf = (result, key) => {
+    const l = result.latency?.[key.replace(/_ms$/, '')];
+    return l ? `p50 ${l.p50_ms}ms · p99 ${l.p99_ms}ms` : null;
+  };
+
   return (
     <Section title={`📊 Performance Test (${scheme.toUpperCase()})`} className="performance-section">
       <div className="controls">
         <label>Iterations:</label>
-        <Input type="number" value={iterations} onChange={handleIterationChange} min="1" max="1000" />
+        <Input type="number" value={iterations} onChange={handleIterationChange} min="1" max={MAX_ITERATIONS} />
         
         <div className="preset-buttons">
           <label>Quick Presets:</label>
@@ -182,9 +320,14 @@ ${summary}`;
         </div>
         
         <div className="test-controls">
-          <Button onClick={handleRunPerformanceTest} loading={localLoading.testing} disabled={localLoading.testing || iterations < 1 || iterations > 1000} className="test-button">
+          <Button onClick={handleRunPerformanceTest} loading={localLoading.testing} disabled={localLoading.testing || localLoading.benchmark || iterations < 1 || iterations > MAX_ITERATIONS} className="test-button">
             {localLoading.testing ? 'Running Test...' : 'Run Performance Test'}
           </Button>
+          {localLoading.testing && (
+            <Button onClick={handleCancelTest} variant="secondary">
+              Cancel
+            </Button>
+          )}
           <Button onClick={handleClearResults} variant="secondary" disabled={testResults.length === 0}>
             Clear Results
           </Button>
@@ -206,8 +349,16 @@ ${summary}`;
         
         {localLoading.testing && (
           <div className="progress-indicator">
-            <div className="progress-bar"><div className="progress-fill"></div></div>
-            <div className="progress-text">Running {iterations} {scheme.toUpperCase()} cryptographic operation iterations...</div>
+            <div className="progress-bar">
+              {job?.status === 'running' && job.total
+                ? <div className="progress-fill determinate" style={{ width: `${(100 * job.done) / job.total}%` }}></div>
+                : <div className="progress-fill"></div>}
+            </div>
+            <div className="progress-text">
+              {job?.status === 'queued'
+                ? 'Waiting for earlier jobs on this scheme...'
+                : `Running ${scheme.toUpperCase()} cryptographic operation iterations: ${job?.done ?? 0} / ${iterations}`}
+            </div>
           </div>
         )}
       </div>
@@ -219,12 +370,63 @@ ${summary}`;
               <div className="perf-metric" key={metric.key}>
                 <div className="perf-value">{metric.value || `${testResults[selectedResultIndex][metric.key]}ms`}</div>
                 <div className="perf-label">{metric.label}</div>
+                {latencyOf(testResults[selectedResultIndex], metric.key) && (
+                  <div className="perf-latency">{latencyOf(testResults[selectedResultIndex], metric.key)}</div>
+                )}
               </div>
             ))
           )}
         </div>
       )}
       
+      {scheme !== 'sitaiba' && (
+        <div className="controls bench-controls">
+          <label>Benchmark (steady state):</label>
+          <div className="inline-controls">
+            {BENCH_OPS.map(op => (
+              <label key={op.key} className="bench-op">
+                <input type="checkbox" checked={benchConfig.ops.includes(op.key)} onChange={() => handleBenchOp(op.key)} />
+                {op.label}
+              </label>
+            ))}
+          </div>
+          <div className="inline-controls">
+            <label>Calls per thread:</label>
+            <Input type="number" value={benchConfig.iterations} min="1" max={MAX_ITERATIONS}
+              onChange={(e) => handleBenchField('iterations', Math.min(Math.max(parseInt(e.target.value) || 1, 1), MAX_ITERATIONS))} />
+            <label>Batch size:</label>
+            <Input type="number" value={benchConfig.batch_size} min="1" max="1024"
+              onChange={(e) => handleBenchField('batch_size', Math.min(Math.max(parseInt(e.target.value) || 1, 1), 1024))} />
+            <label>Threads (0 = all CPUs):</label>
+            <Input type="number" value={benchConfig.num_threads} min="0" max="64"
+              onChange={(e) => handleBenchField('num_threads', Math.min(Math.max(parseInt(e.target.value) || 0, 0), 64))} />
+            <label>Warm-up calls:</label>
+            <Input type="number" value={benchConfig.warmup} min="0" max="1000"
+              onChange={(e) => handleBenchField('warmup', Math.min(Math.max(parseInt(e.target.value) || 0, 0), 1000))} />
+            <label className="bench-op">
+              <input type="checkbox" checked={benchConfig.precompute} onChange={(e) => handleBenchField('precompute', e.target.checked)} />
+              Precomputed recipient tables
+            </label>
+          </div>
+          <div className="test-controls">
+            <Button onClick={handleRunBenchmark} loading={localLoading.benchmark} disabled={localLoading.benchmark || localLoading.testing}>
+              {localLoading.benchmark
+                ? `Benchmarking... ${benchJob?.done ?? 0} / ${benchJob?.total || benchConfig.ops.length}`
+                : 'Run Benchmark'}
+            </Button>
+          </div>
+          {benchResult && (
+            <>
+              <div className="progress-text">
+                {benchResult.config.batch_size} output(s) per call · {benchResult.config.iterations} calls per thread
+                · {benchResult.config.precompute ? 'warm tables' : 'cold'} · throughput in outputs per second over all threads
+              </div>
+              <BenchmarkChart results={benchResult.results} />
+            </>
+          )}
+        </div>
+      )}
+
       <Output content={getOutputContent()} isError={!!(localError || globalError)} />
     </Section>
   );
@@ -1,4 +1,4 @@
-import React from 'react'
+import React, { useState, useEffect } from 'react'
 
 // Section組件
 export function Section({ title, children, statusActive = false, className = '', wide = false }) {
@@ -91,6 +91,24 @@ export function Output({ content, isError = false, className = '' }) {
   )
 }
 
+// DataItem組件
+export function DataItem({ header, details, selected = false, onClick, style }) {
+  return (
+    <div
+      className={`data-item ${selected ? 'selected' : ''}`}
+      onClick={onClick}
+      style={style}
+    >
+      <div className="item-header">{header}</div>
+      {details && details.map((detail, detailIndex) => (
+        <div key={detailIndex} className="item-details">
+          {detail}
+        </div>
+      ))}
+    </div>
+  )
+}
+
 // DataList組件
 export function DataList({ items = [], className = '' }) {
   if (items.length === 0) return null
@@ -98,19 +116,97 @@ export function DataList({ items = [], className = '' }) {
   return (
     <div className={`data-list ${className}`}>
       {items.map((item, index) => (
-        <div
-          key={item.id || index}
-          className={`data-item ${item.selected ? 'selected' : ''}`}
-          onClick={item.onClick}
-        >
-          <div className="item-header">{item.header}</div>
-          {item.details && item.details.map((detail, detailIndex) => (
-            <div key={detailIndex} className="item-details">
-              {detail}
-            </div>
-          ))}
-        </div>
+        <DataItem key={item.id || index} {...item} />
       ))}
     </div>
   )
+}
+
+// VirtualList組件
+// Windowed list of fixed-height rows: only the rows in view, plus overscan
+// on either side, are in the DOM, so its cost does not grow with the list.
+// onEndReached is called while the view is near the last row (to fetch more).
+export function VirtualList({
+  items = [],
+  renderItem,
+  rowHeight = 64,
+  height = 200,
+  overscan = 8,
+  onEndReached,
+  className = ''
+}) {
+  const [scrollTop, setScrollTop] = useState(0)
+  const first = Math.max(0, Math.floor(scrollTop / rowHeight) - overscan)
+  const last = Math.min(items.length, Math.ceil((scrollTop + height) / rowHeight) + overscan)
+
+  useEffect(() => {
+    if (onEndReached && last >= items.length - overscan) onEndReached()
+  }, [last, items.length, overscan, onEndReached])
+
+  if (items.length === 0) return null
+
+  const rows = []
+  for (let index = first; index < last; index++) {
+    rows.push(renderItem(items[index], index, {
+      position: 'absolute', top: index * rowHeight, left: 0, right: 0, height: rowHeight
+    }))
+  }
+
+  return (
+    <div
+      className={`data-list virtual-list ${className}`}
+      style={{ height: Math.min(height, items.length * rowHeight), maxHeight: 'none' }}
+      onScroll={(e) => setScrollTop(e.currentTarget.scrollTop)}
+    >
+      <div style={{ position: 'relative', height: items.length * rowHeight }}>
+        {rows}
+      </div>
+    </div>
+  )
+}
+
+// ListPicker組件
+// Searchable stand-in for a Select over a long server list; paged is the
+// result of usePagedList and describe(record) gives a record's one-line label
+export function ListPicker({
+  paged,
+  search,
+  onSearchChange,
+  selected,
+  onSelect,
+  describe,
+  placeholder = 'Search...',
+  disabled = false
+}) {
+  return (
+    <div className="list-picker">
+      <Input
+        value={search}
+        onChange={(e) => onSearchChange(e.target.value)}
+        placeholder={placeholder}
+        disabled={disabled}
+      />
+      <div className="list-picker-status">
+        {selected ? `Selected: ${describe(selected)}` : 'Nothing selected'}
+        {' · '}
+        {paged.loading ? 'Loading...' : `${paged.items.length}${paged.hasMore ? '+' : ''} shown of ${paged.total}`}
+      </div>
+      <VirtualList
+        items={paged.items}
+        rowHeight={36}
+        height={180}
+        onEndReached={paged.loadMore}
+        renderItem={(record, index, style) => (
+          <div
+            key={record.id || index}
+            className={`data-item list-picker-option ${selected && selected.id === record.id ? 'selected' : ''}`}
+            style={style}
+            onClick={() => !disabled && onSelect(record)}
+          >
+            {describe(record)}
+          </div>
+        )}
+      />
+    </div>
+  )
 }
\ No newline at end of file
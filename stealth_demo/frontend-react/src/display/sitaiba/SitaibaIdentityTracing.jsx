@@ -3,19 +3,20 @@ import { Button } from '../../components/common';
 import BaseIdentityTracing from '../../components/BaseIdentityTracing';
 import { apiService } from '../../services/apiService';
 import { useAppData } from '../../hooks/useAppData';
+import { usePagedList } from '../../hooks/usePagedList';
 import { truncateHex } from '../../utils/helpers';
 
 function SitaibaIdentityTracing() {
   const { 
-    addresses, 
-    loading: globalLoading, 
     error: globalError, 
     clearError,
-    loadKeys,
-    loadAddresses
+    loadKeys
   } = useAppData();
   
-  const [selectedAddrIndex, setSelectedAddrIndex] = useState('');
+  const [addressSearch, setAddressSearch] = useState('');
+  const addressPages = usePagedList('addresses', { query: addressSearch, scheme: 'sitaiba' });
+  const { refresh: refreshAddresses } = addressPages;
+  const [selectedAddress, setSelectedAddress] = useState(null);
   const [selectedTraceIndex, setSelectedTraceIndex] = useState(-1);
   const [traceResults, setTraceResults] = useState([]);
   const [localLoading, setLocalLoading] = useState({});
@@ -24,11 +25,11 @@ function SitaibaIdentityTracing() {
   const handleRefreshData = useCallback(async () => {
     setLocalError('');
     clearError();
-    await Promise.all([loadKeys(), loadAddresses()]);
-  }, [loadKeys, loadAddresses, clearError]);
+    await Promise.all([loadKeys(), refreshAddresses()]);
+  }, [loadKeys, refreshAddresses, clearError]);
 
   const handleTraceIdentity = useCallback(async () => {
-    if (selectedAddrIndex === '') {
+    if (!selectedAddress) {
       setLocalError('Please select an address to trace!');
       return;
     }
@@ -36,14 +37,14 @@ function SitaibaIdentityTracing() {
       setLocalLoading(prev => ({ ...prev, tracing: true }));
       setLocalError('');
       clearError();
-      const result = await apiService.traceIdentity(parseInt(selectedAddrIndex));
+      const result = await apiService.traceIdentity(selectedAddress.index);
       setTraceResults(prev => [...prev, result]);
     } catch (err) {
       setLocalError('SITAIBA identity tracing failed: ' + err.message);
     } finally {
       setLocalLoading(prev => ({ ...prev, tracing: false }));
     }
-  }, [selectedAddrIndex, clearError]);
+  }, [selectedAddress, clearError]);
 
   const handleTraceClick = useCallback((index) => {
     setSelectedTraceIndex(index);
@@ -113,26 +114,27 @@ ${latestTrace.matched_key ? `🔑 Matched Key: ${latestTrace.matched_key.id}` :
   return (
     <BaseIdentityTracing
       title="🔍 Identity Tracing (SITAIBA)"
-      selectedAddrIndex={selectedAddrIndex}
-      onAddressChange={(e) => setSelectedAddrIndex(e.target.value)}
-      addresses={addresses}
+      selectedAddress={selectedAddress}
+      onAddressSelect={setSelectedAddress}
+      addressPages={addressPages}
+      addressSearch={addressSearch}
+      onAddressSearchChange={setAddressSearch}
       items={traceItems}
       outputContent={getOutputContent()}
       isError={!!(localError || globalError)}
-      globalLoading={globalLoading}
     >
       <div className="inline-controls">
         <Button
           onClick={handleTraceIdentity}
           loading={localLoading.tracing}
-          disabled={selectedAddrIndex === '' || localLoading.tracing}
+          disabled={!selectedAddress || localLoading.tracing}
         >
           Execute SITAIBA Identity Tracing
         </Button>
         <Button
           onClick={handleRefreshData}
           variant="secondary"
-          disabled={globalLoading.all}
+          disabled={addressPages.loading}
         >
           Refresh Data
         </Button>
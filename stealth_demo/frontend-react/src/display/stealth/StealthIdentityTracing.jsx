@@ -3,20 +3,21 @@ import { Button } from '../../components/common';
 import BaseIdentityTracing from '../../components/BaseIdentityTracing';
 import { apiService } from '../../services/apiService';
 import { useAppData } from '../../hooks/useAppData';
+import { usePagedList } from '../../hooks/usePagedList';
 import { truncateHex } from '../../utils/helpers';
 
 function StealthIdentityTracing() {
   const { 
     keys,
-    addresses, 
-    loading: globalLoading, 
     error: globalError, 
     clearError,
-    loadKeys,
-    loadAddresses
+    loadKeys
   } = useAppData();
   
-  const [selectedAddrIndex, setSelectedAddrIndex] = useState('');
+  const [addressSearch, setAddressSearch] = useState('');
+  const addressPages = usePagedList('addresses', { query: addressSearch, scheme: 'stealth' });
+  const { refresh: refreshAddresses } = addressPages;
+  const [selectedAddress, setSelectedAddress] = useState(null);
   const [selectedTraceIndex, setSelectedTraceIndex] = useState(-1);
   const [traceResults, setTraceResults] = useState([]);
   const [localLoading, setLocalLoading] = useState({});
@@ -25,11 +26,11 @@ function StealthIdentityTracing() {
   const handleRefreshData = useCallback(async () => {
     setLocalError('');
     clearError();
-    await Promise.all([loadKeys(), loadAddresses()]);
-  }, [loadKeys, loadAddresses, clearError]);
+    await Promise.all([loadKeys(), refreshAddresses()]);
+  }, [loadKeys, refreshAddresses, clearError]);
 
   const handleTraceIdentity = useCallback(async () => {
-    if (selectedAddrIndex === '') {
+    if (!selectedAddress) {
       setLocalError('Please select an address to trace!');
       return;
     }
@@ -37,12 +38,12 @@ function StealthIdentityTracing() {
       setLocalLoading(prev => ({ ...prev, tracing: true }));
       setLocalError('');
       clearError();
-      const result = await apiService.traceIdentity(parseInt(selectedAddrIndex));
+      const result = await apiService.traceIdentity(selectedAddress.index);
       const traceWithIndex = {
         ...result,
         index: traceResults.length,
         timestamp: new Date().toISOString(),
-        input_address: addresses[parseInt(selectedAddrIndex)]
+        input_address: selectedAddress
       };
       setTraceResults(prev => [...prev, traceWithIndex]);
     } catch (err) {
@@ -50,7 +51,7 @@ function StealthIdentityTracing() {
     } finally {
       setLocalLoading(prev => ({ ...prev, tracing: false }));
     }
-  }, [selectedAddrIndex, addresses, traceResults.length, clearError]);
+  }, [selectedAddress, traceResults.length, clearError]);
 
   const handleTraceClick = useCallback((index) => {
     setSelectedTraceIndex(index);
@@ -146,16 +147,17 @@ ${matchedKey ? `
   return (
     <BaseIdentityTracing
       title="🔍 Identity Tracing (Stealth)"
-      selectedAddrIndex={selectedAddrIndex}
-      onAddressChange={(e) => setSelectedAddrIndex(e.target.value)}
-      addresses={addresses}
+      selectedAddress={selectedAddress}
+      onAddressSelect={setSelectedAddress}
+      addressPages={addressPages}
+      addressSearch={addressSearch}
+      onAddressSearchChange={setAddressSearch}
       items={traceItems}
       outputContent={getOutputContent()}
       isError={!!(localError || globalError)}
-      globalLoading={globalLoading}
     >
       <div className="inline-controls">
-        <Button onClick={handleTraceIdentity} loading={localLoading.tracing} disabled={selectedAddrIndex === '' || localLoading.tracing}>
+        <Button onClick={handleTraceIdentity} loading={localLoading.tracing} disabled={!selectedAddress || localLoading.tracing}>
           Trace Identity
         </Button>
         <Button onClick={handleRefreshData} variant="secondary">
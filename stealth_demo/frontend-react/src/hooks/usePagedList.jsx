@@ -0,0 +1,63 @@
+import { useState, useRef, useCallback, useEffect } from 'react'
+import { apiService } from '../services/apiService'
+
+// 分頁載入伺服器清單
+// Records of a server list (keys, addresses, dsks, tx_messages) fetched a page
+// at a time as the view scrolls instead of whole, narrowed by a search the
+// server runs. A new query or scheme starts the listing over.
+export function usePagedList(list, { query = '', scheme = '', pageSize = 200, debounceMs = 250 } = {}) {
+  const [items, setItems] = useState([])
+  const [total, setTotal] = useState(0)
+  const [nextCursor, setNextCursor] = useState(0)
+  const [loading, setLoading] = useState(false)
+  const [error, setError] = useState('')
+  // Bumped when the listing starts over, so pages of the old one are dropped
+  const generation = useRef(0)
+  const inFlight = useRef(false)
+
+  const fetchPage = useCallback(async (cursor, replace) => {
+    const gen = generation.current
+    inFlight.current = true
+    setLoading(true)
+    try {
+      const page = await apiService.getListPage(list, cursor, pageSize, query.trim())
+      if (gen !== generation.current) return
+      const records = Array.isArray(page?.[list]) ? page[list] : []
+      setItems(prev => (replace ? records : [...prev, ...records]))
+      setTotal(page?.count ?? 0)
+      setNextCursor(page?.next_cursor ?? null)
+      setError('')
+    } catch (err) {
+      if (gen === generation.current) setError(`Failed to load ${list}: ${err.message}`)
+    } finally {
+      if (gen === generation.current) {
+        inFlight.current = false
+        setLoading(false)
+      }
+    }
+  }, [list, pageSize, query])
+
+  const refresh = useCallback(() => {
+    generation.current++
+    inFlight.current = false
+    return fetchPage(0, true)
+  }, [fetchPage])
+
+  const loadMore = useCallback(() => {
+    if (inFlight.current || nextCursor === null) return
+    fetchPage(nextCursor, false)
+  }, [fetchPage, nextCursor])
+
+  // Typing a query waits for a pause before asking the server
+  useEffect(() => {
+    const timer = setTimeout(refresh, query ? debounceMs : 0)
+    return () => clearTimeout(timer)
+  }, [refresh, query, scheme, debounceMs])
+
+  useEffect(() => {
+    window.addEventListener('schemeDataCleared', refresh)
+    return () => window.removeEventListener('schemeDataCleared', refresh)
+  }, [refresh])
+
+  return { items, total, hasMore: nextCursor !== null, loading, error, loadMore, refresh }
+}
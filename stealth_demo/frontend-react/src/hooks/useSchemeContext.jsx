@@ -15,6 +15,7 @@ export function SchemeProvider({ children }) {
   const fetchSchemeStatus = async () => {
     try {
       const response = await apiService.get('/schemes')
+      apiService.setScheme(response.current_scheme)
       setCurrentScheme(response.current_scheme)
       setAvailableSchemes(response.available_schemes)
       setCapabilities(response.current_capabilities)
@@ -29,25 +30,22 @@ export function SchemeProvider({ children }) {
   }, [])
 
   // 切換方案
+  // Requests name their scheme, so switching is local: other clients of the
+  // server and its running jobs stay on theirs
   const switchScheme = async (schemeName) => {
     if (schemeName === currentScheme) return
 
     setLoading(true)
     try {
-      const response = await apiService.post('/switch_scheme', { 
-        scheme: schemeName 
-      })
-      
-      if (response.status === 'switched') {
-        setCurrentScheme(schemeName)
-        
-        // 獲取新方案的能力
-        const capResponse = await apiService.get(`/scheme_capabilities?scheme=${schemeName}`)
-        setCapabilities(capResponse)
-        
-        console.log(`✅ Switched to ${schemeName} scheme`)
-        return true
-      }
+      // 獲取新方案的能力
+      const capResponse = await apiService.get(`/scheme_capabilities?scheme=${schemeName}`)
+      // Before the state change, so requests made on the new render carry the new scheme
+      apiService.setScheme(schemeName)
+      setCurrentScheme(schemeName)
+      setCapabilities(capResponse)
+
+      console.log(`✅ Switched to ${schemeName} scheme`)
+      return true
     } catch (error) {
       console.error(`Failed to switch to ${schemeName}:`, error)
       return false
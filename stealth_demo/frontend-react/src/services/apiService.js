@@ -1,26 +1,57 @@
 // API服務層 - 統一管理所有API調用
+import { encodeCbor, decodeCbor, toWire, fromWire } from './cbor'
+
 const API_BASE = '/api'
+const CBOR_TYPE = 'application/cbor'
 
 class ApiService {
+  constructor() {
+    // 'cbor' sends raw element bytes instead of hex strings; 'json' is the fallback
+    this.transport = import.meta.env.VITE_API_TRANSPORT === 'cbor' ? 'cbor' : 'json'
+    // Scheme every request runs on, as a path prefix; null for the server's default
+    this.scheme = null
+  }
+
+  setTransport(transport) {
+    this.transport = transport === 'cbor' ? 'cbor' : 'json'
+  }
+
+  setScheme(scheme) {
+    this.scheme = scheme || null
+  }
+
+  async readBody(response) {
+    if ((response.headers.get('Content-Type') || '').startsWith(CBOR_TYPE)) {
+      return fromWire(decodeCbor(await response.arrayBuffer()))
+    }
+    return response.json()
+  }
+
   async request(endpoint, options = {}) {
-    const url = `${API_BASE}${endpoint}`
+    const url = this.scheme ? `${API_BASE}/${this.scheme}${endpoint}` : `${API_BASE}${endpoint}`
+    const binary = this.transport === 'cbor'
+    const { data, ...fetchOptions } = options
     const config = {
+      ...fetchOptions,
       headers: {
-        'Content-Type': 'application/json',
+        'Content-Type': binary ? CBOR_TYPE : 'application/json',
+        ...(binary ? { Accept: CBOR_TYPE } : {}),
         ...options.headers,
       },
-      ...options,
+    }
+    if (data !== undefined) {
+      config.body = binary ? encodeCbor(toWire(data)) : JSON.stringify(data)
     }
 
     try {
       const response = await fetch(url, config)
       
       if (!response.ok) {
-        const errorData = await response.json().catch(() => ({}))
+        const errorData = await this.readBody(response).catch(() => ({}))
         throw new Error(errorData.error || `HTTP error! status: ${response.status}`)
       }
       
-      return await response.json()
+      return await this.readBody(response)
     } catch (error) {
       console.error(`API request failed: ${endpoint}`, error)
       throw error
@@ -32,10 +63,7 @@ class ApiService {
   }
 
   async post(endpoint, data) {
-    return this.request(endpoint, {
-      method: 'POST',
-      body: JSON.stringify(data),
-    })
+    return this.request(endpoint, { method: 'POST', data })
   }
 
   async getParamFiles() {
@@ -54,10 +82,38 @@ class ApiService {
     return this.get('/keylist')
   }
 
+  // One page of keys, addresses, dsks or tx_messages; next_cursor is null on the last page.
+  // With a query the page holds up to limit records whose ids or hex values contain it,
+  // and next_cursor is where the server's scan stopped
+  async getListPage(list, cursor = 0, limit = 100, query = '') {
+    const endpoints = { keys: '/keylist', addresses: '/addresslist', dsks: '/dsklist', tx_messages: '/tx_messages' }
+    const search = query ? `&q=${encodeURIComponent(query)}` : ''
+    return this.get(`${endpoints[list]}?cursor=${cursor}&limit=${limit}${search}`)
+  }
+
+  // Append exported keys, addresses or dsks, sent as NDJSON
+  async importRecords(list, records) {
+    return this.request(`/import/${list}`, {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/x-ndjson' },
+      body: records.map((record) => JSON.stringify(record)).join('\n'),
+    })
+  }
+
   async generateAddress(keyIndex) {
     return this.post('/addrgen', { key_index: keyIndex })
   }
 
+  // keyIndices defaults to every key; threads 0 = one per server CPU
+  async generateAddressesBulk(count, keyIndices = undefined, threads = 0) {
+    return this.post('/addrgen_bulk', { count, key_indices: keyIndices, threads })
+  }
+
+  // Owners among keyIndices (default: every key) of count addresses from start
+  async scanAddresses({ keyIndices, start = 0, count, threads = 0 } = {}) {
+    return this.post('/scan', { key_indices: keyIndices, start, count, threads })
+  }
+
   async recognizeAddress(addressIndex, keyIndex, fast = undefined) {
     const payload = {
       address_index: addressIndex,
@@ -110,6 +166,55 @@ class ApiService {
     return this.post('/performance_test', { iterations })
   }
 
+  // Background jobs: submitting returns the job, whose progress is then
+  // polled with getJob or followed with jobEvents
+  async performanceTestJob(iterations = 100) {
+    return this.post('/jobs/performance_test', { iterations })
+  }
+
+  // options: ops, iterations, batch_size, num_threads, precompute, warmup
+  async benchmarkJob(options) {
+    return this.post('/jobs/benchmark', options)
+  }
+
+  async getJob(jobId) {
+    return this.get(`/jobs/${jobId}`)
+  }
+
+  async cancelJob(jobId) {
+    return this.request(`/jobs/${jobId}`, { method: 'DELETE' })
+  }
+
+  // Calls onUpdate with the job on every change until it finishes;
+  // returns the EventSource so callers can close it early
+  jobEvents(jobId, onUpdate, onError) {
+    const source = new EventSource(`${API_BASE}/jobs/${jobId}/events`)
+    source.onmessage = (event) => {
+      const job = JSON.parse(event.data)
+      onUpdate(job)
+      if (job.status === 'done' || job.status === 'failed' || job.status === 'cancelled') {
+        source.close()
+      }
+    }
+    source.onerror = (error) => {
+      source.close()
+      if (onError) onError(error)
+    }
+    return source
+  }
+
+  // Calls onSnapshot with the server's live metrics every interval seconds
+  // (see server/common/live_metrics.py); returns the EventSource, which
+  // reconnects by itself until the caller closes it
+  metricsEvents(onSnapshot, interval = 1, onError) {
+    const source = new EventSource(`${API_BASE}/metrics/live?interval=${interval}`)
+    source.onmessage = (event) => onSnapshot(JSON.parse(event.data))
+    source.onerror = (error) => {
+      if (onError) onError(error)
+    }
+    return source
+  }
+
   async getStatus() {
     return this.get('/status')
   }
@@ -0,0 +1,213 @@
+// CBOR (RFC 8949) codec for the binary API transport - covers what the
+// server sends: integers, byte and text strings, arrays, maps, floats,
+// booleans and null, with definite lengths
+const textEncoder = new TextEncoder()
+const textDecoder = new TextDecoder()
+
+// Fields whose value (a hex string, or a list of them) travels as bytes
+const isHexField = (key) => key.endsWith('_hex')
+
+const hexToBytes = (hex) => {
+  if (hex.length % 2 !== 0 || /[^0-9a-fA-F]/.test(hex)) return null
+  const bytes = new Uint8Array(hex.length / 2)
+  for (let i = 0; i < bytes.length; i++) bytes[i] = parseInt(hex.substr(2 * i, 2), 16)
+  return bytes
+}
+
+const bytesToHex = (bytes) => Array.from(bytes, (b) => b.toString(16).padStart(2, '0')).join('')
+
+// Swap the hex strings of *_hex fields for their bytes
+export function toWire(value, hexField = false) {
+  if (Array.isArray(value)) return value.map((v) => toWire(v, hexField))
+  if (value && typeof value === 'object' && !(value instanceof Uint8Array)) {
+    return Object.fromEntries(Object.entries(value).map(([k, v]) => [k, toWire(v, isHexField(k))]))
+  }
+  if (hexField && typeof value === 'string') return hexToBytes(value) ?? value
+  return value
+}
+
+// Turn the bytes of *_hex fields back into hex strings
+export function fromWire(value, hexField = false) {
+  if (value instanceof Uint8Array) return hexField ? bytesToHex(value) : value
+  if (Array.isArray(value)) return value.map((v) => fromWire(v, hexField))
+  if (value && typeof value === 'object') {
+    return Object.fromEntries(Object.entries(value).map(([k, v]) => [k, fromWire(v, isHexField(k))]))
+  }
+  return value
+}
+
+class Writer {
+  constructor() {
+    this.buf = new Uint8Array(256)
+    this.view = new DataView(this.buf.buffer)
+    this.len = 0
+  }
+
+  reserve(n) {
+    if (this.len + n <= this.buf.length) return
+    let size = this.buf.length * 2
+    while (size < this.len + n) size *= 2
+    const buf = new Uint8Array(size)
+    buf.set(this.buf.subarray(0, this.len))
+    this.buf = buf
+    this.view = new DataView(buf.buffer)
+  }
+
+  head(major, value) {
+    this.reserve(9)
+    const m = major << 5
+    if (value < 24) {
+      this.buf[this.len++] = m | value
+    } else if (value < 0x100) {
+      this.buf[this.len++] = m | 24
+      this.buf[this.len++] = value
+    } else if (value < 0x10000) {
+      this.buf[this.len++] = m | 25
+      this.view.setUint16(this.len, value)
+      this.len += 2
+    } else if (value < 0x100000000) {
+      this.buf[this.len++] = m | 26
+      this.view.setUint32(this.len, value)
+      this.len += 4
+    } else {
+      this.buf[this.len++] = m | 27
+      this.view.setBigUint64(this.len, BigInt(value))
+      this.len += 8
+    }
+  }
+
+  bytes(data) {
+    this.reserve(data.length)
+    this.buf.set(data, this.len)
+    this.len += data.length
+  }
+
+  item(value) {
+    if (value === null || value === undefined) {
+      this.reserve(1)
+      this.buf[this.len++] = 0xf6
+    } else if (typeof value === 'boolean') {
+      this.reserve(1)
+      this.buf[this.len++] = value ? 0xf5 : 0xf4
+    } else if (typeof value === 'number') {
+      if (Number.isSafeInteger(value)) {
+        if (value >= 0) this.head(0, value)
+        else this.head(1, -1 - value)
+      } else {
+        this.reserve(9)
+        this.buf[this.len++] = 0xfb
+        this.view.setFloat64(this.len, value)
+        this.len += 8
+      }
+    } else if (value instanceof Uint8Array) {
+      this.head(2, value.length)
+      this.bytes(value)
+    } else if (typeof value === 'string') {
+      const data = textEncoder.encode(value)
+      this.head(3, data.length)
+      this.bytes(data)
+    } else if (Array.isArray(value)) {
+      this.head(4, value.length)
+      value.forEach((v) => this.item(v))
+    } else if (typeof value === 'object') {
+      const entries = Object.entries(value)
+      this.head(5, entries.length)
+      entries.forEach(([k, v]) => {
+        this.item(k)
+        this.item(v)
+      })
+    } else {
+      throw new TypeError(`cannot encode ${typeof value} as CBOR`)
+    }
+  }
+}
+
+export function encodeCbor(value) {
+  const writer = new Writer()
+  writer.item(value)
+  return writer.buf.slice(0, writer.len)
+}
+
+class Reader {
+  constructor(data) {
+    this.buf = data instanceof Uint8Array ? data : new Uint8Array(data)
+    this.view = new DataView(this.buf.buffer, this.buf.byteOffset, this.buf.byteLength)
+    this.pos = 0
+  }
+
+  need(n) {
+    if (this.pos + n > this.buf.length) throw new Error('truncated CBOR data')
+  }
+
+  argument(info) {
+    if (info < 24) return info
+    const size = { 24: 1, 25: 2, 26: 4, 27: 8 }[info]
+    if (!size) throw new Error('indefinite-length CBOR items are not supported')
+    this.need(size)
+    const at = this.pos
+    this.pos += size
+    if (size === 1) return this.view.getUint8(at)
+    if (size === 2) return this.view.getUint16(at)
+    if (size === 4) return this.view.getUint32(at)
+    return Number(this.view.getBigUint64(at))
+  }
+
+  item() {
+    this.need(1)
+    const initial = this.buf[this.pos++]
+    const major = initial >> 5
+    const info = initial & 0x1f
+    if (major === 7) {
+      if (info === 20) return false
+      if (info === 21) return true
+      if (info === 22 || info === 23) return null
+      const size = { 25: 2, 26: 4, 27: 8 }[info]
+      if (!size) throw new Error(`unsupported CBOR simple value ${info}`)
+      this.need(size)
+      const at = this.pos
+      this.pos += size
+      if (size === 2) return halfToNumber(this.view.getUint16(at))
+      return size === 4 ? this.view.getFloat32(at) : this.view.getFloat64(at)
+    }
+    const value = this.argument(info)
+    switch (major) {
+      case 0: return value
+      case 1: return -1 - value
+      case 2:
+      case 3: {
+        this.need(value)
+        const data = this.buf.slice(this.pos, this.pos + value)
+        this.pos += value
+        return major === 2 ? data : textDecoder.decode(data)
+      }
+      case 4: return Array.from({ length: value }, () => this.item())
+      case 5: {
+        const result = {}
+        for (let i = 0; i < value; i++) {
+          const key = this.item()
+          result[key] = this.item()
+        }
+        return result
+      }
+      default:
+        // Tags carry no meaning for this API, keep the tagged item
+        return this.item()
+    }
+  }
+}
+
+function halfToNumber(half) {
+  const exp = (half >> 10) & 0x1f
+  const mant = half & 0x3ff
+  const sign = half & 0x8000 ? -1 : 1
+  if (exp === 0) return sign * mant * 2 ** -24
+  if (exp === 31) return mant ? NaN : sign * Infinity
+  return sign * (1 + mant / 1024) * 2 ** (exp - 15)
+}
+
+export function decodeCbor(data) {
+  const reader = new Reader(data)
+  const value = reader.item()
+  if (reader.pos !== reader.buf.length) throw new Error('trailing bytes after CBOR item')
+  return value
+}
@@ -10,11 +10,16 @@ from .multi_scheme_config import config
 from .scheme_manager import scheme_manager
 # from library_wrapper import stealth_lib  # TODO: Will be managed by scheme_manager
 from .unified_routes import setup_routes
+from .common.shared_session import shared_session
+from .common.binary_transport import enable_binary_transport
+from .prefork import get_worker_count, serve
 
 
 def create_app():
     """Create and configure the Flask application."""
     app = Flask(__name__, static_folder="../frontend")
+    # CBOR for clients that ask for it, JSON otherwise
+    enable_binary_transport(app)
     
     # Setup global error handler
     @app.errorhandler(Exception)
@@ -35,6 +40,12 @@ def create_app():
     def index():
         return send_from_directory("../frontend", "index.html")
     
+    if shared_session.enabled:
+        # Another worker may have set up, reset or switched a scheme
+        @app.before_request
+        def sync_shared_session():
+            scheme_manager.sync_shared_session()
+
     # Setup all API routes
     setup_routes(app)
     
@@ -43,6 +54,11 @@ def create_app():
 
 def main():
     """Main function to run the application."""
+    workers = get_worker_count()
+    if workers > 1:
+        # Workers share their records through the store files
+        shared_session.enable()
+        shared_session.clear()
     app = create_app()
     
     print("🚀 Starting Multi-Scheme Cryptographic Demo Server")
@@ -53,7 +69,11 @@ def main():
     print(f"🔧 Current scheme: {scheme_manager.get_current_scheme_name()}")
     
     try:
-        app.run(debug=True, host='0.0.0.0', port=5000)
+        if workers > 1:
+            # The debug reloader cannot run under forked workers
+            serve(create_app, '0.0.0.0', 5000, workers)
+        else:
+            app.run(debug=True, host='0.0.0.0', port=5000)
     except KeyboardInterrupt:
         print("\n🛑 Server stopped")
         # if config.system_initialized:
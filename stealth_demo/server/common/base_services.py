@@ -3,24 +3,54 @@ Abstract base class for cryptographic scheme services.
 Provides common logic for key generation, address operations, and tracing,
 delegating scheme-specific C library calls to concrete implementations.
 """
+import functools
+import struct
+import time
 from abc import ABC, abstractmethod
-from typing import Dict, Optional
+from contextlib import contextmanager
+from typing import Dict, List, Optional
 from ..multi_scheme_config import config # Corrected import
 from .base_utils import hex_to_bytes_safe, validate_index
+from .latency import merge_snapshot
+from .record_store import SchemeStore, get_store_dir
 from .scheme_utils import get_element_size, create_buffer, create_multiple_buffers, bytes_to_hex_safe_fixed, find_matching_key
 from ctypes import c_double # For performance test results array
 
 
+def scheme_method(method):
+    """Run a service method with the service's scheme bound to the calling
+    thread, so the config lists it reads are its own scheme's whichever
+    scheme the caller is on; the caller's binding is restored after."""
+    @functools.wraps(method)
+    def wrapper(self, *args, **kwargs):
+        with config.scheme_bound(self._scheme_name):
+            return method(self, *args, **kwargs)
+    return wrapper
+
+
 class BaseSchemeService(ABC):
     """
     Abstract base class for cryptographic scheme services.
     Defines the common interface and implements shared logic.
     """
 
+    # Element fields of an address record, in store order; stealth adds C
+    _store_address_fields = ('addr_hex', 'r1_hex', 'r2_hex')
+    # DSK "method" values by store flag, empty if DSK items carry no method
+    _store_dsk_methods = ()
+    # Group of R2; stealth moves it to G2 under an asymmetric pairing
+    _r2_element_type = 'G1'
+    # Rejected records reported in detail by import_records
+    _import_error_limit = 20
+
     def __init__(self):
         # Ensure the scheme name is set in the concrete class
         if not hasattr(self, '_scheme_name'):
             raise NotImplementedError("Concrete service class must define _scheme_name")
+        # Keys of the key list already in the lookup maps and registry
+        self._keys_indexed = 0
+        # Addresses of the address list already in the C address index
+        self._addresses_indexed = 0
 
     @abstractmethod
     def _get_lib(self):
@@ -42,7 +72,8 @@ class BaseSchemeService(ABC):
 
     @abstractmethod
     def _call_c_addr_gen(self, *args):
-        """Calls the scheme-specific C address generation function."""
+        """Calls the scheme-specific C address generation function.
+        May return a dict of extra fields (e.g. view_tag_hex) for the address item."""
         pass
 
     @abstractmethod
@@ -67,13 +98,29 @@ class BaseSchemeService(ABC):
 
     # Common implementations for service methods
 
-    def setup_system(self, param_file: str) -> Dict:
-        """Initialize the cryptographic system for the current scheme."""
-        config.set_current_scheme(self._scheme_name)
+    @scheme_method
+    def setup_system(self, param_file: str, point_format: str = "uncompressed",
+                     hash_version: int = 1) -> Dict:
+        """Initialize the cryptographic system for the current scheme.
+
+        point_format selects the G1 wire encoding ("uncompressed" or
+        "compressed") used by every hex value of this session.
+        hash_version selects the hash-to-G1 of schemes that have one
+        (1: g^H(x), 2: map-to-curve); data of one version is kept in its
+        own store files, since it only verifies under that version.
+        """
         full_path = config.validate_param_file(param_file)
+        # Open store files belong to the pairing being replaced
+        config.detach_store(self._scheme_name)
 
         print(f"🔧 Initializing {self._scheme_name} with {full_path}")
         lib = self._get_lib()
+        # Before init: stealth_init checks the pairing supports the version
+        if not hasattr(lib, 'set_hash_version'):
+            if hash_version != 1:
+                raise Exception(f"{self._scheme_name} library does not support hash version: {hash_version}")
+        elif not lib.set_hash_version(hash_version):
+            raise Exception(f"{self._scheme_name} library does not support hash version: {hash_version}")
         result = lib.init(full_path)
 
         if result != 0:
@@ -82,10 +129,35 @@ class BaseSchemeService(ABC):
         if not lib.is_initialized():
             raise Exception(f"{self._scheme_name} library initialization verification failed")
 
+        if not lib.set_point_format(point_format):
+            raise Exception(f"{self._scheme_name} library does not support point format: {point_format}")
+
         config.reset_scheme(self._scheme_name)
 
-        tracer_key = self._generate_tracer_key_with_param(param_file)
+        store = self._open_store(param_file, hash_version)
+        tracer_key = self._restore_tracer_key(store, param_file) if store else None
+        if tracer_key is None:
+            tracer_key = self._generate_tracer_key_with_param(param_file)
+            if store:
+                store.save_tracer_key(hex_to_bytes_safe(tracer_key['TK_hex']),
+                                      hex_to_bytes_safe(tracer_key['k_hex']))
         config.set_initialized(param_file, tracer_key, self._scheme_name)
+        if store:
+            config.attach_store(store, self._scheme_name)
+            if getattr(lib, 'registry_available', False):
+                lib.store_registry_load(store.handle('key_list'))
+            if getattr(lib, 'addr_index_available', False):
+                lib.store_registry_load_addrs(store.handle('address_list'))
+        if getattr(lib, 'key_tables_available', False):
+            # Keys stored before their tables were kept get them now; the
+            # others are read from the mapping on first use
+            if store:
+                store.sync_key_tables()
+            lib.key_ctx_init(hex_to_bytes_safe(tracer_key['TK_hex']),
+                             store.key_tables if store and store.key_tables is not None else -1)
+        # attach_store indexed the stored keys; init emptied the address index
+        self._keys_indexed = len(config.key_list)
+        self._addresses_indexed = len(config.address_list) if store else 0
 
         g1_size, zr_size = lib.get_element_sizes()
 
@@ -95,9 +167,18 @@ class BaseSchemeService(ABC):
             "param_file": param_file,
             "g1_size": g1_size,
             "zr_size": zr_size,
+            "point_format": lib.get_point_format(),
+            "hash_version": hash_version,
             "scheme": self._scheme_name,
             **tracer_key
         }
+        if store:
+            response['store'] = {
+                "directory": store.directory,
+                "keys": len(config.key_list),
+                "addresses": len(config.address_list),
+                "dsks": len(config.dsk_list)
+            }
         
         # Add DSK functions availability if the library has it
         if hasattr(lib, 'dsk_functions_available'):
@@ -106,9 +187,240 @@ class BaseSchemeService(ABC):
 
         return response
 
+    # Persistent store. Records keep the elements; the other item fields
+    # are rebuilt from the indices on access.
+
+    def _open_store(self, param_file: str, hash_version: int = 1) -> Optional[SchemeStore]:
+        """Open this scheme's store files for param_file, None if persistence is off."""
+        store_dir = get_store_dir()
+        lib = self._get_lib()
+        if store_dir is None or not getattr(lib, 'store_available', False):
+            return None
+        variant = f"h{hash_version}" if hash_version != 1 else ""
+        return SchemeStore(lib, store_dir, self._scheme_name, param_file, variant, {
+            'key_list': (lib.STORE_KEYS, self._encode_key, self._decode_key),
+            'address_list': (lib.STORE_ADDRS, self._encode_address, self._decode_address),
+            'dsk_list': (lib.STORE_DSKS, self._encode_dsk, self._decode_dsk),
+        })
+
+    def _restore_tracer_key(self, store: SchemeStore, param_file: str) -> Optional[Dict]:
+        """Reinstall the generator and tracer key of the stored session, None for a new store."""
+        saved = store.load_tracer_key()
+        if saved is None:
+            # Records without their session generator are unusable
+            store.reset()
+            return None
+        print(f"💾 Restoring {self._scheme_name} session from {store.directory}")
+        return {
+            "TK_hex": saved[0].hex(),
+            "k_hex": saved[1].hex(),
+            "param_file": param_file,
+            "status": "restored"
+        }
+
+    def _encode_key(self, item: Dict):
+        return [hex_to_bytes_safe(item[f]) for f in ('A_hex', 'B_hex', 'a_hex', 'b_hex')], b""
+
+    def _decode_key(self, index: int, elems: List[bytes], meta: bytes) -> Dict:
+        A, B, a, b = (e.hex() for e in elems)
+        return {
+            "index": index,
+            "id": f"key_{index}",
+            "A_hex": A,
+            "B_hex": B,
+            "a_hex": a,
+            "b_hex": b,
+            "param_file": config.get_scheme_data(self._scheme_name)['current_param_file'],
+            "scheme": self._scheme_name,
+            "status": "generated"
+        }
+
+    def _encode_address(self, item: Dict):
+        tag_hex = item.get('view_tag_hex')
+        meta = struct.pack('<IB', item['key_index'], self._get_lib().STORE_FLAG_TAGGED if tag_hex else 0)
+        if tag_hex:
+            meta += bytes.fromhex(tag_hex)
+        return [hex_to_bytes_safe(item[f]) for f in self._store_address_fields], meta
+
+    def _decode_address(self, index: int, elems: List[bytes], meta: bytes) -> Dict:
+        key_index, flags = struct.unpack_from('<IB', meta)
+        owner = config.get_scheme_data(self._scheme_name)['key_list'][key_index]
+        item = {"index": index, "id": f"addr_{index}"}
+        item.update({f: e.hex() for f, e in zip(self._store_address_fields, elems)})
+        item.update({
+            "key_index": key_index,
+            "key_id": owner['id'],
+            "owner_A": owner['A_hex'],
+            "owner_B": owner['B_hex'],
+            "scheme": self._scheme_name,
+            "status": "generated"
+        })
+        if flags & self._get_lib().STORE_FLAG_TAGGED:
+            item["view_tag_hex"] = meta[5:].hex()
+        return item
+
+    def _encode_dsk(self, item: Dict):
+        method = item.get('method')
+        flags = self._store_dsk_methods.index(method) if method in self._store_dsk_methods else 0
+        return [hex_to_bytes_safe(item['dsk_hex'])], struct.pack('<IIB', item['address_index'], item['key_index'], flags)
+
+    def _decode_dsk(self, index: int, elems: List[bytes], meta: bytes) -> Dict:
+        address_index, key_index, flags = struct.unpack_from('<IIB', meta)
+        data = config.get_scheme_data(self._scheme_name)
+        address_data = data['address_list'][address_index]
+        key_data = data['key_list'][key_index]
+        item = {
+            "index": index,
+            "id": f"dsk_{index}",
+            "dsk_hex": elems[0].hex(),
+            "address_index": address_index,
+            "key_index": key_index,
+            "address_id": address_data['id'],
+            "key_id": key_data['id'],
+            "owner_A": key_data['A_hex'],
+            "owner_B": key_data['B_hex'],
+            "for_address": address_data['addr_hex'],
+        }
+        if self._store_dsk_methods:
+            item["method"] = self._store_dsk_methods[flags]
+        item.update({"scheme": self._scheme_name, "status": "generated"})
+        return item
+
+    # Imported records arrive in the export format; index and id are
+    # reassigned on append and the owner fields rebuilt from the key list
+
+    @staticmethod
+    def _import_hex(record: Dict, field: str) -> str:
+        value = record[field]
+        try:
+            if not value or len(value) % 2:
+                raise ValueError
+            bytes.fromhex(value)
+        except (TypeError, ValueError):
+            raise ValueError(f"{field} must be a hex string") from None
+        return value.lower()
+
+    def _import_key(self, record: Dict) -> Dict:
+        index = len(config.key_list)
+        item = {"index": index, "id": f"key_{index}"}
+        item.update({f: self._import_hex(record, f) for f in ('A_hex', 'B_hex', 'a_hex', 'b_hex')})
+        item.update({
+            "param_file": config.current_param_file,
+            "scheme": self._scheme_name,
+            "status": "generated"
+        })
+        return item
+
+    def _import_address(self, record: Dict) -> Dict:
+        key_index = record['key_index']
+        validate_index(key_index, config.key_list, "key_index")
+        owner = config.key_list[key_index]
+        index = len(config.address_list)
+        item = {"index": index, "id": f"addr_{index}"}
+        item.update({f: self._import_hex(record, f) for f in self._store_address_fields})
+        # Duplicates are caught where the address index makes that O(1)
+        if getattr(self._get_lib(), 'addr_index_available', False):
+            known = self._find_address(item['addr_hex'])
+            if known is not None:
+                raise ValueError(f"address is already stored as addr_{known[0]}")
+        item.update({
+            "key_index": key_index,
+            "key_id": owner['id'],
+            "owner_A": owner['A_hex'],
+            "owner_B": owner['B_hex'],
+            "scheme": self._scheme_name,
+            "status": "generated"
+        })
+        if record.get('view_tag_hex'):
+            tag_hex = self._import_hex(record, 'view_tag_hex')
+            if len(tag_hex) != 2 * getattr(self._get_lib(), 'view_tag_length', 0):
+                raise ValueError("view_tag_hex has the wrong length")
+            item["view_tag_hex"] = tag_hex
+        return item
+
+    def _import_dsk(self, record: Dict) -> Dict:
+        address_index, key_index = record['address_index'], record['key_index']
+        validate_index(address_index, config.address_list, "address_index")
+        validate_index(key_index, config.key_list, "key_index")
+        address_data = config.address_list[address_index]
+        key_data = config.key_list[key_index]
+        index = len(config.dsk_list)
+        item = {
+            "index": index,
+            "id": f"dsk_{index}",
+            "dsk_hex": self._import_hex(record, 'dsk_hex'),
+            "address_index": address_index,
+            "key_index": key_index,
+            "address_id": address_data['id'],
+            "key_id": key_data['id'],
+            "owner_A": key_data['A_hex'],
+            "owner_B": key_data['B_hex'],
+            "for_address": address_data['addr_hex'],
+        }
+        if self._store_dsk_methods:
+            method = record.get('method', self._store_dsk_methods[0])
+            if method not in self._store_dsk_methods:
+                raise ValueError(f"method must be one of {', '.join(self._store_dsk_methods)}")
+            item["method"] = method
+        item.update({"scheme": self._scheme_name, "status": "generated"})
+        return item
+
+    @scheme_method
+    def import_records(self, list_name: str, records) -> Dict:
+        """Append records to key_list, address_list or dsk_list one at a time.
+        records yields (position, record) pairs, a record being a dict in the
+        export format or the exception met while reading it; bad records are
+        skipped and reported."""
+        config.ensure_initialized(self._scheme_name)
+        build = {
+            'key_list': self._import_key,
+            'address_list': self._import_address,
+            'dsk_list': self._import_dsk,
+        }[list_name]
+
+        imported, rejected, errors = 0, 0, []
+        first_index = last_index = None
+        for position, record in records:
+            try:
+                if isinstance(record, Exception):
+                    raise record
+                if not isinstance(record, dict):
+                    raise ValueError("record must be an object")
+                item = build(record)
+                getattr(config, list_name).append(item)
+            except KeyError as e:
+                error = f"missing field {e}"
+            except (TypeError, ValueError) as e:
+                error = str(e)
+            else:
+                if list_name == 'key_list':
+                    self.index_new_keys()
+                elif list_name == 'address_list':
+                    self.index_new_addresses()
+                imported += 1
+                if first_index is None:
+                    first_index = item['index']
+                last_index = item['index']
+                continue
+            rejected += 1
+            if len(errors) < self._import_error_limit:
+                errors.append({"position": position, "error": error})
+
+        return {
+            "list": list_name,
+            "imported": imported,
+            "rejected": rejected,
+            "errors": errors,
+            "first_index": first_index,
+            "last_index": last_index,
+            "count": len(getattr(config, list_name)),
+            "scheme": self._scheme_name,
+            "status": "imported"
+        }
+
+    @scheme_method
     def generate_keypair(self) -> Dict:
         """Generate a new key pair for the current scheme."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
 
         buf_size = get_element_size()
@@ -137,11 +449,81 @@ class BaseSchemeService(ABC):
         }
 
         config.key_list.append(item)
+        self.index_new_keys()
         return item
 
+    @scheme_method
+    def index_new_keys(self):
+        """Index the keys appended since the last call, by this or (with a
+        shared store) another server process."""
+        keys = config.key_list
+        count = len(keys)
+        for index in range(self._keys_indexed, count):
+            self._register_key(keys[index])
+        if count > self._keys_indexed and config.store is not None:
+            # The tables of a key are built once, here, for every later start
+            config.store.sync_key_tables()
+        self._keys_indexed = count
+
+    def _register_key(self, item: Dict):
+        """Index a new key so traces and lookups resolve without walking the key list."""
+        config.index_key(item)
+        lib = self._get_lib()
+        if getattr(lib, 'registry_available', False):
+            lib.registry_add(hex_to_bytes_safe(item['A_hex']), hex_to_bytes_safe(item['B_hex']), item['index'])
+
+    @scheme_method
+    def index_new_addresses(self):
+        """Add the addresses appended since the last call to the C address index,
+        by this or (with a shared store) another server process."""
+        lib = self._get_lib()
+        addresses = config.address_list
+        count = len(addresses)
+        if getattr(lib, 'addr_index_available', False):
+            for index in range(self._addresses_indexed, count):
+                item = addresses[index]
+                lib.registry_add_addr(hex_to_bytes_safe(item['addr_hex']), index, item['key_index'])
+        self._addresses_indexed = count
+
+    def _find_address(self, addr_hex: str):
+        """(address index, owning key index) of a known one-time address, None if unknown."""
+        lib = self._get_lib()
+        if getattr(lib, 'addr_index_available', False):
+            self.index_new_addresses()
+            index, owner = lib.registry_find_addr(hex_to_bytes_safe(addr_hex))
+            return (index, owner) if index >= 0 else None
+        for item in config.address_list:
+            if item['addr_hex'] == addr_hex:
+                return item['index'], item['key_index']
+        return None
+
+    @scheme_method
+    def lookup_address(self, addr_hex: str) -> Dict:
+        """Whether a one-time address is already known, and which key it was generated for."""
+        config.ensure_initialized(self._scheme_name)
+        addr_hex = self._import_hex({'addr_hex': addr_hex}, 'addr_hex')
+        found = self._find_address(addr_hex)
+        result = {
+            "addr_hex": addr_hex,
+            "known": found is not None,
+            "address_index": None,
+            "address_id": None,
+            "owner_key_index": None,
+            "owner_key_id": None,
+            "method": "index" if getattr(self._get_lib(), 'addr_index_available', False) else "list",
+            "scheme": self._scheme_name,
+            "status": "known" if found is not None else "unknown"
+        }
+        if found is not None:
+            index, owner = found
+            result.update({"address_index": index, "address_id": f"addr_{index}"})
+            if 0 <= owner < len(config.key_list):
+                result.update({"owner_key_index": owner, "owner_key_id": config.key_list[owner]['id']})
+        return result
+
+    @scheme_method
     def generate_address(self, key_index: int) -> Dict:
         """Generate address with selected key for the current scheme."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
         validate_index(key_index, config.key_list, "key_index")
 
@@ -163,11 +545,11 @@ class BaseSchemeService(ABC):
         addr_buf, r1_buf, r2_buf = create_multiple_buffers(3, buf_size)
         
         # Call scheme-specific C function
-        self._call_c_addr_gen(A_r_bytes, B_r_bytes, A_m_bytes, addr_buf, r1_buf, r2_buf, buf_size)
+        extra = self._call_c_addr_gen(A_r_bytes, B_r_bytes, A_m_bytes, addr_buf, r1_buf, r2_buf, buf_size)
 
         addr_hex = bytes_to_hex_safe_fixed(addr_buf, 'G1')
         r1_hex = bytes_to_hex_safe_fixed(r1_buf, 'G1')
-        r2_hex = bytes_to_hex_safe_fixed(r2_buf, 'G1')
+        r2_hex = bytes_to_hex_safe_fixed(r2_buf, self._r2_element_type)
 
         if not all([addr_hex, r1_hex, r2_hex]):
             raise Exception(f"Failed to generate {self._scheme_name} address")
@@ -185,13 +567,53 @@ class BaseSchemeService(ABC):
             "scheme": self._scheme_name,
             "status": "generated"
         }
+        if extra:
+            address_item.update(extra)
 
         config.address_list.append(address_item) # Corrected from 'item'
+        self.index_new_addresses()
         return address_item # Corrected from 'item'
 
+    def _generate_addresses(self, owners: List[int], num_threads: int):
+        """Generate one address per key index in owners; returns (items, timing_ms, method).
+        Schemes with a threaded C generator override this; the default generates one at a time."""
+        start = time.perf_counter()
+        items = [self.generate_address(key_index) for key_index in owners]
+        return items, {"generate": (time.perf_counter() - start) * 1000}, "loop"
+
+    @scheme_method
+    def generate_addresses_bulk(self, count: int, key_indices: Optional[List[int]] = None,
+                                num_threads: int = 0) -> Dict:
+        """Generate count addresses spread round-robin over key_indices (default: every key)."""
+        config.ensure_initialized(self._scheme_name)
+        if key_indices is None:
+            key_indices = list(range(len(config.key_list)))
+        if not key_indices:
+            raise ValueError("No keys to generate addresses for")
+        for key_index in key_indices:
+            validate_index(key_index, config.key_list, "key_index")
+        if config.trace_key is None:
+            raise Exception("Tracer key not initialized")
+
+        start = time.perf_counter()
+        owners = [key_indices[i % len(key_indices)] for i in range(count)]
+        items, timing, method = self._generate_addresses(owners, num_threads)
+        self.index_new_addresses()
+        timing["total"] = (time.perf_counter() - start) * 1000
+
+        return {
+            "count": len(items),
+            "address_indices": [item['index'] for item in items],
+            "key_indices": key_indices,
+            "timing_ms": timing,
+            "method": method,
+            "scheme": self._scheme_name,
+            "status": "generated"
+        }
+
+    @scheme_method
     def recognize_address(self, address_index: int, key_index: int, fast: bool = True) -> Dict:
         """Recognize address with selected key for the current scheme."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
         validate_index(address_index, config.address_list, "address_index")
         validate_index(key_index, config.key_list, "key_index")
@@ -199,7 +621,13 @@ class BaseSchemeService(ABC):
         address_data = config.address_list[address_index]
         key_data = config.key_list[key_index]
 
-        recognized = self._call_c_recognize_address(address_data, key_data, fast)
+        store = config.store
+        if fast and store is not None:
+            # Both records are read straight from the mapped store files
+            recognized = self._get_lib().store_recognize_fast(store.handle('address_list'), address_index,
+                                                             store.handle('key_list'), key_index)
+        else:
+            recognized = self._call_c_recognize_address(address_data, key_data, fast)
         method = "fast" if fast else "full"
 
         return {
@@ -214,9 +642,170 @@ class BaseSchemeService(ABC):
             "status": "recognized" if recognized else "not_recognized"
         }
 
+    def _call_c_recognize_multi(self, address_data: Dict, keys: List[Dict]) -> int:
+        """Returns the position in keys of the owner of address_data, -1 if none.
+        Schemes with a native multi-key scan override this; the default asks each key in turn."""
+        for i, key_data in enumerate(keys):
+            if self._call_c_recognize_address(address_data, key_data, True):
+                return i
+        return -1
+
+    @scheme_method
+    def recognize_address_multi(self, address_index: int, key_indices: Optional[List[int]] = None) -> Dict:
+        """Find which registered key (or which of key_indices) owns the selected address."""
+        config.ensure_initialized(self._scheme_name)
+        validate_index(address_index, config.address_list, "address_index")
+        if key_indices is None:
+            key_indices = list(range(len(config.key_list)))
+        for key_index in key_indices:
+            validate_index(key_index, config.key_list, "key_index")
+
+        address_data = config.address_list[address_index]
+        keys = [config.key_list[i] for i in key_indices]
+        pos = self._call_c_recognize_multi(address_data, keys) if keys else -1
+        owner = key_indices[pos] if pos >= 0 else None
+
+        return {
+            "recognized": owner is not None,
+            "address_index": address_index,
+            "address_id": address_data['id'],
+            "owner_key_index": owner,
+            "owner_key_id": config.key_list[owner]['id'] if owner is not None else None,
+            "keys_checked": len(keys),
+            "method": "multi",
+            "scheme": self._scheme_name,
+            "status": "recognized" if owner is not None else "not_recognized"
+        }
+
+    @scheme_method
+    def scan_addresses(self, key_index: int) -> Dict:
+        """Find every address owned by the selected key."""
+        config.ensure_initialized(self._scheme_name)
+        validate_index(key_index, config.key_list, "key_index")
+
+        started = time.perf_counter()
+        store = config.store
+        if store is not None:
+            # One C call over the mapped address file
+            hits = self._get_lib().store_scan(store.handle('address_list'), 0, len(config.address_list),
+                                              store.handle('key_list'), key_index)
+        else:
+            key_data = config.key_list[key_index]
+            hits = [self._call_c_recognize_address(a, key_data, True) for a in config.address_list]
+        owned = [i for i, hit in enumerate(hits) if hit]
+
+        return {
+            "key_index": key_index,
+            "key_id": config.key_list[key_index]['id'],
+            "owned_address_indices": owned,
+            "count": len(owned),
+            "addresses_checked": len(hits),
+            "timing_ms": {"total": (time.perf_counter() - started) * 1000},
+            "method": "store" if store is not None else "list",
+            "scheme": self._scheme_name,
+            "status": "scanned"
+        }
+
+    @scheme_method
+    def sync_addresses(self, key_index: int, count: Optional[int] = None) -> Dict:
+        """Resume the wallet scan of the selected key from its checkpoint: scan up to
+        count new addresses (default: all), keep a DSK for each owned one and move the
+        checkpoint past them. The checkpoint lives in the store, so it survives restarts."""
+        config.ensure_initialized(self._scheme_name)
+        validate_index(key_index, config.key_list, "key_index")
+        store = config.store
+        if store is None or store.cursors is None:
+            raise ValueError("Wallet sync needs the persistent store (set PBC_DEMO_STORE_DIR)")
+
+        lib = self._get_lib()
+        began = time.perf_counter()
+        start, owned_before = lib.store_cursor(store.cursors, key_index)
+        methods = self._store_dsk_methods
+        flags = methods.index('recognized') if 'recognized' in methods else 0
+        owned, cursor = lib.store_sync_scan(store.handle('address_list'), store.handle('key_list'), key_index,
+                                            store.cursors, store.handle('dsk_list'), flags, count or 0)
+
+        return {
+            "key_index": key_index,
+            "key_id": config.key_list[key_index]['id'],
+            "owned_address_indices": owned,
+            "count": len(owned),
+            "total_owned": owned_before + len(owned),
+            "start": start,
+            "cursor": cursor,
+            "addresses_checked": cursor - start,
+            "timing_ms": {"total": (time.perf_counter() - began) * 1000},
+            "method": "sync",
+            "scheme": self._scheme_name,
+            "status": "synced"
+        }
+
+    def _scan_owners(self, start: int, count: int, key_indices: List[int], num_threads: int):
+        """Owner among key_indices of each address in [start, start + count), -1 if none.
+        Returns (owners, timing_ms, method). Schemes with a threaded multi-key scanner
+        override this; the default scans the range once per key."""
+        began = time.perf_counter()
+        owners = [-1] * count
+        store = config.store
+        for key_index in key_indices:
+            if store is not None:
+                hits = self._get_lib().store_scan(store.handle('address_list'), start, count,
+                                                  store.handle('key_list'), key_index)
+            else:
+                key_data = config.key_list[key_index]
+                hits = [self._call_c_recognize_address(config.address_list[start + i], key_data, True)
+                        for i in range(count)]
+            for i, hit in enumerate(hits):
+                if hit and owners[i] < 0:
+                    owners[i] = key_index
+        timing = {"scan": (time.perf_counter() - began) * 1000}
+        return owners, timing, "store" if store is not None else "list"
+
+    @scheme_method
+    def scan_addresses_bulk(self, key_indices: Optional[List[int]] = None, start: int = 0,
+                            count: Optional[int] = None, num_threads: int = 0) -> Dict:
+        """Find the owner of every address in a range among key_indices (default: every key)."""
+        config.ensure_initialized(self._scheme_name)
+        if key_indices is None:
+            key_indices = list(range(len(config.key_list)))
+        for key_index in key_indices:
+            validate_index(key_index, config.key_list, "key_index")
+        total = len(config.address_list)
+        if not 0 <= start <= total:
+            raise ValueError(f"start must be from 0 to {total}")
+        count = total - start if count is None else min(count, total - start)
+
+        began = time.perf_counter()
+        if key_indices and count > 0:
+            owners, timing, method = self._scan_owners(start, count, key_indices, num_threads)
+        else:
+            owners, timing, method = [-1] * max(count, 0), {}, "none"
+        owned = {key_index: [] for key_index in key_indices}
+        for i, owner in enumerate(owners):
+            if owner >= 0:
+                owned[owner].append(start + i)
+        timing["total"] = (time.perf_counter() - began) * 1000
+
+        return {
+            "keys": [{
+                "key_index": key_index,
+                "key_id": config.key_list[key_index]['id'],
+                "owned_address_indices": indices,
+                "count": len(indices)
+            } for key_index, indices in owned.items()],
+            "count": sum(len(indices) for indices in owned.values()),
+            "start": start,
+            "addresses_checked": len(owners),
+            "keys_checked": len(owned),
+            "timing_ms": timing,
+            "method": method,
+            "scheme": self._scheme_name,
+            "status": "scanned"
+        }
+
+    @scheme_method
     def generate_dsk(self, address_index: int, key_index: int) -> Dict:
         """Generate one-time secret key for selected address and key."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
         validate_index(address_index, config.address_list, "address_index")
         validate_index(key_index, config.key_list, "key_index")
@@ -229,9 +818,46 @@ class BaseSchemeService(ABC):
         config.dsk_list.append(dsk_item)
         return dsk_item
 
+    def _generate_dsks(self, addresses: List[Dict], key_data: Dict, num_threads: int):
+        """Generate and store the DSK of every address for one key; returns (items, timing_ms, method).
+        Schemes with a batched C derivation override this; the default derives one at a time."""
+        start = time.perf_counter()
+        items = []
+        for address_data in addresses:
+            item = self._call_c_generate_dsk(address_data, key_data)
+            config.dsk_list.append(item)
+            items.append(item)
+        return items, {"generate": (time.perf_counter() - start) * 1000}, "loop"
+
+    @scheme_method
+    def generate_dsks(self, address_indices: List[int], key_index: int, num_threads: int = 0) -> Dict:
+        """Generate one-time secret keys for many addresses owned by one key."""
+        config.ensure_initialized(self._scheme_name)
+        for address_index in address_indices:
+            validate_index(address_index, config.address_list, "address_index")
+        validate_index(key_index, config.key_list, "key_index")
+        if config.trace_key is None:
+            raise Exception("Tracer key not initialized")
+
+        start = time.perf_counter()
+        addresses = [config.address_list[i] for i in address_indices]
+        items, timing, method = self._generate_dsks(addresses, config.key_list[key_index], num_threads)
+        timing["total"] = (time.perf_counter() - start) * 1000
+
+        return {
+            "count": len(items),
+            "dsk_indices": [item['index'] for item in items],
+            "dsks": items,
+            "key_index": key_index,
+            "timing_ms": timing,
+            "method": method,
+            "scheme": self._scheme_name,
+            "status": "generated"
+        }
+
+    @scheme_method
     def trace_identity(self, address_index: int) -> Dict:
         """Trace identity for selected address."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
         validate_index(address_index, config.address_list, "address_index")
 
@@ -257,21 +883,248 @@ class BaseSchemeService(ABC):
             "status": "traced"
         }
 
-    def performance_test(self, iterations: int = 100) -> Dict:
-        """Run performance test for the current scheme."""
-        config.set_current_scheme(self._scheme_name)
+    @scheme_method
+    def trace_owner_addresses(self, key_index: Optional[int] = None, b_hex: Optional[str] = None) -> Dict:
+        """Every address traced to a key (by key_index, or by its public key B for keys
+        not in the key list). Addresses not traced yet are traced into the stored
+        tracing index first, so each address is traced once across queries and restarts."""
         config.ensure_initialized(self._scheme_name)
-        
-        iterations = min(iterations, 1000) # Limit iterations to prevent excessive load
+        if key_index is not None:
+            validate_index(key_index, config.key_list, "key_index")
+            b_hex = config.key_list[key_index]['B_hex']
+        elif b_hex is not None:
+            b_hex = self._import_hex({'B_hex': b_hex}, 'B_hex')
+        else:
+            raise ValueError("Please specify key_index or B_hex")
+        store = config.store
+        if store is None or getattr(store, 'traces', None) is None:
+            raise ValueError("The tracing index needs the persistent store (set PBC_DEMO_STORE_DIR)")
+        if config.trace_key is None:
+            raise Exception("Tracer key not initialized")
 
-        results_dict = self._call_c_performance_test(iterations)
+        lib = self._get_lib()
+        began = time.perf_counter()
+        traced = lib.store_trace_sync(store.handle('address_list'), store.traces,
+                                      hex_to_bytes_safe(config.trace_key['k_hex']))
+        synced = time.perf_counter()
+        addresses = lib.store_trace_find(store.traces, hex_to_bytes_safe(b_hex))
+        done = time.perf_counter()
 
+        if key_index is None:
+            key_index = config.key_by_B.get(b_hex)
         return {
+            "B_hex": b_hex,
+            "key_index": key_index,
+            "key_id": config.key_list[key_index]['id'] if key_index is not None else None,
+            "address_indices": addresses,
+            "count": len(addresses),
+            "newly_traced": traced,
+            "timing_ms": {
+                "trace": (synced - began) * 1000,
+                "lookup": (done - synced) * 1000,
+                "total": (done - began) * 1000
+            },
+            "method": "index",
+            "scheme": self._scheme_name,
+            "status": "traced"
+        }
+
+    # Iterations per C call of a performance test run as a job
+    _perf_job_chunk = 10
+    # Iteration limits of a direct call, which holds its request thread,
+    # and of a job
+    MAX_PERF_ITERATIONS = 1000
+    MAX_PERF_JOB_ITERATIONS = 100000
+
+    @staticmethod
+    def _check_seed(seed: Optional[int]):
+        if seed is not None and not 0 <= seed < 2 ** 32:
+            raise ValueError("seed must be from 0 to 4294967295")
+
+    @contextmanager
+    def _seeded(self, lib, seed: Optional[int]):
+        """Seeded random mode for the calls made inside, on this thread only."""
+        if seed is None:
+            yield
+            return
+        if not lib.set_random_seed(seed):
+            raise NotImplementedError(f"Seeded runs not supported by {self._scheme_name} scheme.")
+        try:
+            yield
+        finally:
+            lib.set_random_seed(None)
+
+    @scheme_method
+    def performance_test(self, iterations: int = 100, progress=None, seed: Optional[int] = None) -> Dict:
+        """Run performance test for the current scheme.
+
+        With progress, a job's progress(done, total), the iterations run in
+        chunks so that progress is reported (and a cancelled job stops)
+        between C calls; the averages are weighted over the chunks.
+        Each C call starts from reset counters, so the latency histograms
+        are snapshot after every chunk and merged, giving percentiles over
+        the whole run. While the library's hardware counters are on, the
+        result also has per-call cycles, IPC, cache misses and allocations
+        of the primitives (pairings, exponentiations, hashes) the run made.
+        With seed, every key, nonce and exponent the run draws comes from a
+        source seeded with it, so two runs with the same seed do the same
+        work; the timings still vary.
+        """
+        config.ensure_initialized(self._scheme_name)
+        self._check_seed(seed)
+        lib = self._get_lib()
+        latency = {}
+        counters_before = self._hw_snapshot(lib)
+        
+        with self._seeded(lib, seed):
+            if progress is None:
+                iterations = min(iterations, self.MAX_PERF_ITERATIONS) # Limit iterations to prevent excessive load
+                results_dict = self._call_c_performance_test(iterations)
+                latency = merge_snapshot(latency, lib)
+            else:
+                iterations = min(iterations, self.MAX_PERF_JOB_ITERATIONS)
+                totals = {}
+                done = 0
+                while done < iterations:
+                    n = min(self._perf_job_chunk, iterations - done)
+                    for key, ms in self._call_c_performance_test(n).items():
+                        totals[key] = totals.get(key, 0.0) + ms * n
+                    latency = merge_snapshot(latency, lib)
+                    done += n
+                    progress(done, iterations)
+                results_dict = {key: round(total / iterations, 3) for key, total in totals.items()}
+
+        result = {
             "iterations": iterations,
+            "seed": seed,
             "scheme": self._scheme_name,
             "status": "completed",
             **results_dict
         }
+        if latency is not None:
+            result["latency"] = {op: histogram.summary() for op, histogram in latency.items()}
+        primitives = self._hw_summary(lib, counters_before, self._hw_snapshot(lib))
+        if primitives:
+            result["primitives"] = primitives
+        return result
+
+    # Limits of a benchmark run, which holds its job for its whole length
+    MAX_BENCH_BATCH = 1024
+    MAX_BENCH_THREADS = 64
+    MAX_BENCH_WARMUP = 1000
+
+    @scheme_method
+    def benchmark(self, ops: Optional[List[str]] = None, iterations: int = 100, batch_size: int = 1,
+                  num_threads: int = 1, precompute: bool = True, warmup: int = 10,
+                  progress=None, seed: Optional[int] = None) -> Dict:
+        """Steady-state benchmark of the scheme's operations.
+
+        Each operation runs iterations timed calls of batch_size outputs on
+        every one of num_threads threads (0 for one per CPU), after warmup
+        untimed calls; precompute selects the per-recipient tables for
+        address generation. Returns per operation the throughput in outputs
+        per second and the per-call latency percentiles. With progress, a
+        job's progress(done, total), the operations run one C call each so
+        that progress is reported between them. seed: see performance_test;
+        worker threads draw from sources seeded from it.
+        """
+        config.ensure_initialized(self._scheme_name)
+        lib = self._get_lib()
+        if not getattr(lib, 'benchmark_available', False):
+            raise NotImplementedError(f"Benchmark not supported by {self._scheme_name} scheme.")
+
+        ops = list(ops) if ops else list(lib.LATENCY_OPS)
+        unknown = [op for op in ops if op not in lib.LATENCY_OPS]
+        if unknown:
+            raise ValueError(f"Unknown operations: {', '.join(unknown)}")
+        if not 1 <= iterations <= self.MAX_PERF_JOB_ITERATIONS:
+            raise ValueError(f"iterations must be from 1 to {self.MAX_PERF_JOB_ITERATIONS}")
+        if not 1 <= batch_size <= self.MAX_BENCH_BATCH:
+            raise ValueError(f"batch_size must be from 1 to {self.MAX_BENCH_BATCH}")
+        if not 0 <= num_threads <= self.MAX_BENCH_THREADS:
+            raise ValueError(f"num_threads must be from 0 to {self.MAX_BENCH_THREADS}")
+        if not 0 <= warmup <= self.MAX_BENCH_WARMUP:
+            raise ValueError(f"warmup must be from 0 to {self.MAX_BENCH_WARMUP}")
+        self._check_seed(seed)
+
+        args = (iterations, batch_size, num_threads, precompute, warmup)
+        with self._seeded(lib, seed):
+            if progress is None:
+                results = lib.benchmark(ops, *args)
+            else:
+                results = {}
+                for done, op in enumerate(ops, 1):
+                    results.update(lib.benchmark([op], *args))
+                    progress(done, len(ops))
+        # Operation order, whichever order they were asked in
+        results = {op: {key: round(value, 4) for key, value in results[op].items()}
+                   for op in lib.LATENCY_OPS if op in results}
+
+        return {
+            "scheme": self._scheme_name,
+            "status": "completed",
+            "config": {"ops": ops, "iterations": iterations, "batch_size": batch_size,
+                       "num_threads": num_threads, "precompute": bool(precompute), "warmup": warmup,
+                       "seed": seed},
+            "results": results,
+        }
+
+    def latency_stats(self) -> Optional[Dict]:
+        """Per-operation latency summary of every call since the last performance
+        reset (library init or a performance test), None if the library has no histograms."""
+        latency = merge_snapshot({}, self._get_lib())
+        if latency is None:
+            return None
+        return {op: histogram.summary() for op, histogram in latency.items()}
+
+    @staticmethod
+    def _hw_snapshot(lib) -> Optional[Dict]:
+        if not getattr(lib, 'hw_counters', ()):
+            return None
+        return lib.primitive_hw_stats()
+
+    @staticmethod
+    def _hw_summary(lib, before: Optional[Dict], after: Optional[Dict]) -> Optional[Dict]:
+        """Per-call counters of the primitives measured between two snapshots,
+        limited to the counters the host can read."""
+        if before is None or after is None:
+            return None
+        summary = {}
+        for primitive, (calls, totals) in after.items():
+            calls -= before[primitive][0]
+            if calls <= 0:
+                continue
+            spent = {name: totals[name] - before[primitive][1][name] for name in lib.hw_counters}
+            row = {"calls": calls}
+            row.update({f"{name}_per_call": round(value / calls, 2) for name, value in spent.items()})
+            if spent.get("cycles", 0) > 0 and "instructions" in spent:
+                row["ipc"] = round(spent["instructions"] / spent["cycles"], 3)
+            summary[primitive] = row
+        return summary
+
+    def primitive_hw_stats(self) -> Optional[Dict]:
+        """Per-primitive (calls measured, counter totals) of the counters the host
+        can read, None if the library's hardware counters are off."""
+        lib = self._get_lib()
+        stats = self._hw_snapshot(lib)
+        if stats is None:
+            return None
+        return {primitive: (calls, {name: totals[name] for name in lib.hw_counters})
+                for primitive, (calls, totals) in stats.items()}
+
+    def primitive_stats(self) -> Optional[Dict]:
+        """Per-primitive (call count, total ms) of the scheme library, None if it has no counters."""
+        lib = self._get_lib()
+        if not lib.metrics_available:
+            return None
+        return lib.primitive_stats()
+
+    def cache_stats(self) -> Optional[Dict]:
+        """Hits and misses of each of the scheme library's caches, None if it has no counters."""
+        lib = self._get_lib()
+        if not lib.cache_stats_available:
+            return None
+        return lib.cache_stats()
 
     # Placeholder for signing/verification methods, to be overridden by schemes that support them
     def sign_message(self, *args, **kwargs) -> Dict:
@@ -0,0 +1,252 @@
+"""
+Binary (CBOR) transport for the REST API.
+A client that sends Accept: application/cbor gets CBOR responses, and a
+request body sent as Content-Type: application/cbor is decoded the same
+way; JSON stays the default. On the CBOR wire every *_hex field carries
+the raw element bytes instead of a hex string, which halves the size of
+element data; the services keep working on hex strings, converting only
+at this boundary.
+
+The codec covers the subset of RFC 8949 the API needs: integers, byte
+and text strings, arrays, maps, floats, booleans and null, all with
+definite lengths.
+"""
+import struct
+from typing import Any
+
+from flask import Request, Response, request
+from flask.json.provider import DefaultJSONProvider
+
+CBOR_MIMETYPE = "application/cbor"
+# RFC 8742: CBOR items back to back, for streamed lists
+CBOR_SEQ_MIMETYPE = "application/cbor-seq"
+
+# Fields whose value (a hex string, or a list of them) travels as bytes
+HEX_SUFFIX = "_hex"
+
+
+def _is_hex_field(key) -> bool:
+    return isinstance(key, str) and key.endswith(HEX_SUFFIX)
+
+
+def to_wire(obj: Any, hex_field: bool = False) -> Any:
+    """Swap the hex strings of *_hex fields for their bytes."""
+    if isinstance(obj, dict):
+        return {k: to_wire(v, _is_hex_field(k)) for k, v in obj.items()}
+    if isinstance(obj, (list, tuple)):
+        return [to_wire(v, hex_field) for v in obj]
+    if hex_field and isinstance(obj, str):
+        try:
+            return bytes.fromhex(obj)
+        except ValueError:
+            return obj
+    return obj
+
+
+def from_wire(obj: Any, hex_field: bool = False) -> Any:
+    """Turn the bytes of *_hex fields back into hex strings."""
+    if isinstance(obj, dict):
+        return {k: from_wire(v, _is_hex_field(k)) for k, v in obj.items()}
+    if isinstance(obj, list):
+        return [from_wire(v, hex_field) for v in obj]
+    if isinstance(obj, (bytes, bytearray)):
+        return obj.hex() if hex_field else bytes(obj)
+    return obj
+
+
+# CBOR encoding
+
+def _head(major: int, value: int, out: bytearray):
+    if value < 24:
+        out.append(major << 5 | value)
+    elif value < 0x100:
+        out += struct.pack(">BB", major << 5 | 24, value)
+    elif value < 0x10000:
+        out += struct.pack(">BH", major << 5 | 25, value)
+    elif value < 0x100000000:
+        out += struct.pack(">BI", major << 5 | 26, value)
+    elif value < 0x10000000000000000:
+        out += struct.pack(">BQ", major << 5 | 27, value)
+    else:
+        raise ValueError(f"integer too large for CBOR: {value}")
+
+
+def _encode(obj: Any, out: bytearray):
+    if obj is None:
+        out.append(0xf6)
+    elif obj is True:
+        out.append(0xf5)
+    elif obj is False:
+        out.append(0xf4)
+    elif isinstance(obj, int):
+        if obj >= 0:
+            _head(0, obj, out)
+        else:
+            _head(1, -1 - obj, out)
+    elif isinstance(obj, float):
+        out += struct.pack(">Bd", 0xfb, obj)
+    elif isinstance(obj, (bytes, bytearray, memoryview)):
+        _head(2, len(obj), out)
+        out += obj
+    elif isinstance(obj, str):
+        data = obj.encode("utf-8")
+        _head(3, len(data), out)
+        out += data
+    elif isinstance(obj, (list, tuple)):
+        _head(4, len(obj), out)
+        for item in obj:
+            _encode(item, out)
+    elif isinstance(obj, dict):
+        _head(5, len(obj), out)
+        for key, value in obj.items():
+            _encode(key, out)
+            _encode(value, out)
+    else:
+        raise TypeError(f"cannot encode {type(obj).__name__} as CBOR")
+
+
+def cbor_dumps(obj: Any) -> bytes:
+    out = bytearray()
+    _encode(obj, out)
+    return bytes(out)
+
+
+def cbor_head(major: int, length: int) -> bytes:
+    """Head of an array (major 4) or map (major 5) of length items, whose
+    items are then streamed one by one."""
+    out = bytearray()
+    _head(major, length, out)
+    return bytes(out)
+
+
+# CBOR decoding
+
+class _Decoder:
+    def __init__(self, data: bytes):
+        self.data = memoryview(data)
+        self.pos = 0
+
+    def take(self, n: int) -> memoryview:
+        if self.pos + n > len(self.data):
+            raise ValueError("truncated CBOR data")
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def argument(self, info: int) -> int:
+        if info < 24:
+            return info
+        if info > 27:
+            raise ValueError("indefinite-length CBOR items are not supported")
+        size = 1 << (info - 24)
+        return int.from_bytes(self.take(size), "big")
+
+    def item(self) -> Any:
+        initial = self.take(1)[0]
+        major, info = initial >> 5, initial & 0x1f
+        if major == 7:
+            if info == 20:
+                return False
+            if info == 21:
+                return True
+            if info in (22, 23):
+                return None
+            if info == 25:
+                return struct.unpack(">e", self.take(2))[0]
+            if info == 26:
+                return struct.unpack(">f", self.take(4))[0]
+            if info == 27:
+                return struct.unpack(">d", self.take(8))[0]
+            raise ValueError(f"unsupported CBOR simple value {info}")
+        value = self.argument(info)
+        if major == 0:
+            return value
+        if major == 1:
+            return -1 - value
+        if major == 2:
+            return bytes(self.take(value))
+        if major == 3:
+            return str(self.take(value), "utf-8")
+        if major == 4:
+            return [self.item() for _ in range(value)]
+        if major == 5:
+            result = {}
+            for _ in range(value):
+                key = self.item()
+                result[key] = self.item()
+            return result
+        # major 6: tags carry no meaning for this API, keep the tagged item
+        return self.item()
+
+
+def cbor_loads(data: bytes) -> Any:
+    decoder = _Decoder(data)
+    obj = decoder.item()
+    if decoder.pos != len(decoder.data):
+        raise ValueError("trailing bytes after CBOR item")
+    return obj
+
+
+class _StreamDecoder(_Decoder):
+    """Decoder reading from a binary file object instead of a buffer."""
+
+    def __init__(self, stream, first: bytes):
+        self.stream = stream
+        self.pending = first
+
+    def take(self, n: int) -> bytes:
+        chunk, self.pending = self.pending[:n], self.pending[n:]
+        while len(chunk) < n:
+            more = self.stream.read(n - len(chunk))
+            if not more:
+                raise ValueError("truncated CBOR data")
+            chunk += more
+        return chunk
+
+
+def cbor_seq_load(stream):
+    """Yield the items of a CBOR sequence read from stream, one at a time."""
+    while True:
+        first = stream.read(1)
+        if not first:
+            return
+        yield _StreamDecoder(stream, first).item()
+
+
+# Flask integration
+
+def wants_cbor() -> bool:
+    """Whether the current request prefers CBOR responses."""
+    accept = request.accept_mimetypes
+    return accept.quality(CBOR_MIMETYPE) > accept.quality("application/json")
+
+
+class BinaryJSONProvider(DefaultJSONProvider):
+    """jsonify() that answers in CBOR when the client asks for it."""
+
+    def response(self, *args, **kwargs) -> Response:
+        if not wants_cbor():
+            return super().response(*args, **kwargs)
+        obj = self._prepare_response_obj(args, kwargs)
+        return self._app.response_class(cbor_dumps(to_wire(obj)), mimetype=CBOR_MIMETYPE)
+
+
+class BinaryRequest(Request):
+    """request.get_json() that also reads CBOR bodies."""
+
+    def get_json(self, force: bool = False, silent: bool = False, cache: bool = True):
+        if self.mimetype != CBOR_MIMETYPE:
+            return super().get_json(force=force, silent=silent, cache=cache)
+        try:
+            return from_wire(cbor_loads(self.get_data(cache=cache)))
+        except ValueError as e:
+            if silent:
+                return None
+            return self.on_json_loading_failed(e)
+
+
+def enable_binary_transport(app):
+    """Let app negotiate CBOR on every jsonify() response and get_json() body."""
+    app.json_provider_class = BinaryJSONProvider
+    app.json = BinaryJSONProvider(app)
+    app.request_class = BinaryRequest
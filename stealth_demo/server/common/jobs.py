@@ -0,0 +1,204 @@
+"""
+Background jobs for long-running scheme operations.
+Submitting a job returns its id at once; the work runs on a worker pool
+and callers poll the job or follow it as a server-sent event stream.
+Jobs on one scheme run one at a time, since they share its C library
+state, but the C calls release the GIL (the wrappers load the libraries
+with CDLL), so request threads keep serving meanwhile.
+"""
+import json
+import os
+import threading
+import time
+import uuid
+from concurrent.futures import ThreadPoolExecutor
+from typing import Callable, Dict, Iterator, List, Optional
+
+QUEUED, RUNNING, DONE, FAILED, CANCELLED = 'queued', 'running', 'done', 'failed', 'cancelled'
+FINISHED = (DONE, FAILED, CANCELLED)
+
+
+class JobCancelled(Exception):
+    """Raised inside a job's work by Job.progress once the job is cancelled."""
+
+
+class Job:
+    """One submitted operation: its state, progress and result."""
+
+    def __init__(self, manager: 'JobManager', kind: str, scheme: str, total: int):
+        self._manager = manager
+        self.id = uuid.uuid4().hex
+        self.kind = kind
+        self.scheme = scheme
+        self.status = QUEUED
+        self.done = 0
+        self.total = total
+        self.result = None
+        self.error = None
+        self.created = time.time()
+        self.started = None
+        self.finished = None
+        self.cancel_requested = False
+        # Bumped on every change, for event streams
+        self.version = 0
+
+    def progress(self, done: int, total: Optional[int] = None):
+        """Report done of total units of work; raises JobCancelled if the job was cancelled."""
+        with self._manager.changed:
+            self.done = done
+            if total is not None:
+                self.total = total
+            self._touch()
+        if self.cancel_requested:
+            raise JobCancelled()
+
+    def _touch(self):
+        # Caller holds manager.changed
+        self.version += 1
+        self._manager.changed.notify_all()
+
+    def to_dict(self) -> Dict:
+        item = {
+            "job_id": self.id,
+            "kind": self.kind,
+            "scheme": self.scheme,
+            "status": self.status,
+            "done": self.done,
+            "total": self.total,
+            "created": self.created,
+            "started": self.started,
+            "finished": self.finished,
+        }
+        if self.status == DONE:
+            item["result"] = self.result
+        elif self.status == FAILED:
+            item["error"] = self.error
+        return item
+
+
+class JobManager:
+    """Worker pool plus the table of recent jobs."""
+
+    # Finished jobs kept for polling, oldest dropped first
+    KEEP_FINISHED = 100
+    # Seconds between keep-alive comments on an idle event stream
+    KEEPALIVE = 15
+
+    def __init__(self, workers: int):
+        self.workers = workers
+        self._pool = ThreadPoolExecutor(max_workers=workers, thread_name_prefix="job")
+        # Workers inside a job, running it or waiting for its scheme
+        self._busy = 0
+        self._jobs: Dict[str, Job] = {}
+        self._scheme_locks: Dict[str, threading.Lock] = {}
+        self.changed = threading.Condition()
+
+    def submit(self, kind: str, scheme: str, work: Callable[[Job], Dict], total: int = 0) -> Job:
+        """Queue work(job) for scheme; its return value becomes the job result."""
+        job = Job(self, kind, scheme, total)
+        with self.changed:
+            self._prune()
+            self._jobs[job.id] = job
+            lock = self._scheme_locks.setdefault(scheme, threading.Lock())
+        self._pool.submit(self._run, job, work, lock)
+        return job
+
+    def _run(self, job: Job, work: Callable[[Job], Dict], lock: threading.Lock):
+        with self.changed:
+            self._busy += 1
+        try:
+            self._run_locked(job, work, lock)
+        finally:
+            with self.changed:
+                self._busy -= 1
+
+    def _run_locked(self, job: Job, work: Callable[[Job], Dict], lock: threading.Lock):
+        with lock:
+            with self.changed:
+                if job.cancel_requested:
+                    self._finish(job, CANCELLED)
+                    return
+                job.status = RUNNING
+                job.started = time.time()
+                job._touch()
+            try:
+                result = work(job)
+            except JobCancelled:
+                with self.changed:
+                    self._finish(job, CANCELLED)
+            except Exception as e:
+                print(f"❌ Job {job.kind} {job.id} failed: {e}")
+                with self.changed:
+                    job.error = str(e)
+                    self._finish(job, FAILED)
+            else:
+                with self.changed:
+                    job.result = result
+                    self._finish(job, DONE)
+
+    def _finish(self, job: Job, status: str):
+        # Caller holds changed
+        job.status = status
+        job.finished = time.time()
+        job._touch()
+
+    def _prune(self):
+        # Caller holds changed
+        finished = [j for j in self._jobs.values() if j.status in FINISHED]
+        for job in sorted(finished, key=lambda j: j.finished)[:max(0, len(finished) - self.KEEP_FINISHED)]:
+            del self._jobs[job.id]
+
+    def get(self, job_id: str) -> Optional[Job]:
+        with self.changed:
+            return self._jobs.get(job_id)
+
+    def list(self) -> List[Dict]:
+        with self.changed:
+            return [j.to_dict() for j in sorted(self._jobs.values(), key=lambda j: j.created)]
+
+    def active(self, scheme: Optional[str] = None) -> int:
+        """Number of queued or running jobs, of scheme if given."""
+        with self.changed:
+            return sum(1 for j in self._jobs.values()
+                       if j.status not in FINISHED and scheme in (None, j.scheme))
+
+    def utilization(self) -> Dict:
+        """Workers in the pool, workers taken by a job, and jobs waiting for one."""
+        with self.changed:
+            queued = sum(1 for j in self._jobs.values() if j.status == QUEUED)
+            running = sum(1 for j in self._jobs.values() if j.status == RUNNING)
+            # A queued job on a busy worker is waiting for its scheme, not for a worker
+            waiting_for_scheme = self._busy - running
+            return {"workers": self.workers, "busy": self._busy, "running": running,
+                    "queued": max(0, queued - waiting_for_scheme)}
+
+    def cancel(self, job_id: str) -> Optional[Job]:
+        """Ask a job to stop; queued jobs never start, running ones stop at their next progress report."""
+        with self.changed:
+            job = self._jobs.get(job_id)
+            if job is not None and job.status not in FINISHED:
+                job.cancel_requested = True
+                job._touch()
+            return job
+
+    def events(self, job: Job) -> Iterator[str]:
+        """Server-sent events: the job as JSON on every change, until it finishes."""
+        seen = -1
+        while True:
+            with self.changed:
+                if job.version == seen:
+                    self.changed.wait_for(lambda: job.version != seen, timeout=self.KEEPALIVE)
+                if job.version == seen:
+                    snapshot = None
+                else:
+                    seen = job.version
+                    snapshot = job.to_dict()
+            if snapshot is None:
+                yield ": keep-alive\n\n"
+                continue
+            yield f"data: {json.dumps(snapshot)}\n\n"
+            if snapshot["status"] in FINISHED:
+                return
+
+
+job_manager = JobManager(int(os.environ.get('STEALTH_JOB_WORKERS', '2')))
@@ -0,0 +1,59 @@
+"""
+Latency percentiles from the scheme libraries' per-operation histograms.
+The C libraries record every operation call into an HDR-style histogram
+(buckets at most ~3% wide); a snapshot is a sparse {bucket: count} map and
+the largest sample. Snapshots merge by adding counts, so the chunks of a
+performance test run as a job combine exactly instead of averaging averages.
+"""
+import math
+from typing import Dict, Optional, Sequence
+
+# Percentiles reported next to count and max
+PERCENTILES = (("p50_ms", 0.50), ("p90_ms", 0.90), ("p99_ms", 0.99))
+
+
+class LatencyHistogram:
+    """Merged histogram of one operation."""
+
+    def __init__(self, bounds: Sequence[float]):
+        self.bounds = bounds
+        self.counts: Dict[int, int] = {}
+        self.max_ms = 0.0
+
+    @property
+    def count(self) -> int:
+        return sum(self.counts.values())
+
+    def add(self, counts: Dict[int, int], max_ms: float):
+        for bucket, n in counts.items():
+            self.counts[bucket] = self.counts.get(bucket, 0) + n
+        self.max_ms = max(self.max_ms, max_ms)
+
+    def percentile(self, q: float) -> float:
+        """Upper bound of the bucket holding the sample of rank ceil(q * count), capped at the max."""
+        total = self.count
+        if total == 0:
+            return 0.0
+        rank = max(1, math.ceil(q * total))
+        seen = 0
+        for bucket in sorted(self.counts):
+            seen += self.counts[bucket]
+            if seen >= rank:
+                return min(self.bounds[bucket], self.max_ms)
+        return self.max_ms
+
+    def summary(self) -> Dict:
+        result = {"count": self.count}
+        for key, q in PERCENTILES:
+            result[key] = round(self.percentile(q), 3)
+        result["max_ms"] = round(self.max_ms, 3)
+        return result
+
+
+def merge_snapshot(histograms: Dict[str, LatencyHistogram], lib) -> Optional[Dict[str, LatencyHistogram]]:
+    """Add lib's current histograms into histograms (by operation); None if lib has none."""
+    if not lib.latency_available:
+        return None
+    for op, (counts, max_ms) in lib.latency_histograms().items():
+        histograms.setdefault(op, LatencyHistogram(lib.latency_bounds)).add(counts, max_ms)
+    return histograms
@@ -0,0 +1,182 @@
+"""
+Paginated, streamed export and streamed import of the record lists.
+A list endpoint answers in one of three ways:
+- ?cursor=N&limit=M returns one page, with next_cursor to fetch the next
+- ?format=ndjson (or Accept: application/x-ndjson) streams one JSON record
+  per line, and ?format=cbor-seq (or Accept: application/cbor-seq) one
+  CBOR item per record; both take cursor and limit too
+- no parameters returns the whole list as before, but streamed record by
+  record instead of built in memory
+With ?q=text a page or stream holds only the records with a text field
+containing text (case-insensitive): ids, owner ids and hex values. A search
+page scans from cursor until it has limit matches, and its next_cursor is
+where the scan stopped, so each page costs one pass over the part scanned.
+With the record store enabled the records are read from the mapped files
+one at a time, so memory use stays flat however long the ledger grows.
+"""
+import json
+from typing import Any, Dict, Iterator, Optional, Tuple
+
+from flask import Response, jsonify, request
+
+from .binary_transport import (CBOR_MIMETYPE, CBOR_SEQ_MIMETYPE, cbor_dumps, cbor_head,
+                               cbor_seq_load, from_wire, to_wire, wants_cbor)
+
+NDJSON_MIMETYPE = "application/x-ndjson"
+
+# Records per page when a cursor comes without a limit, and the most per page
+DEFAULT_PAGE = 100
+MAX_PAGE = 10000
+
+STREAM_FORMATS = {"ndjson": NDJSON_MIMETYPE, "cbor-seq": CBOR_SEQ_MIMETYPE}
+
+
+def _dumps(obj: Any) -> str:
+    # Compact, like jsonify outside debug mode
+    return json.dumps(obj, ensure_ascii=False, separators=(",", ":"))
+
+
+def matches(record, query: str) -> bool:
+    """Whether a text field of record contains query, already lowercased."""
+    return any(isinstance(value, str) and query in value.lower() for value in record.values())
+
+
+def iter_range(records, start: int, stop: int, query: Optional[str] = None) -> Iterator:
+    for i in range(start, stop):
+        record = records[i]
+        if query is None or matches(record, query):
+            yield record
+
+
+def iter_ndjson(records, start: int, stop: int, query: Optional[str] = None) -> Iterator[str]:
+    for record in iter_range(records, start, stop, query):
+        yield _dumps(record) + "\n"
+
+
+def iter_cbor_seq(records, start: int, stop: int, query: Optional[str] = None) -> Iterator[bytes]:
+    for record in iter_range(records, start, stop, query):
+        yield cbor_dumps(to_wire(record))
+
+
+def iter_json_document(name: str, records, count: int, extra: Dict) -> Iterator[str]:
+    """{name: [records...], **extra} as JSON, one record per chunk."""
+    yield "{" + _dumps(name) + ":["
+    for i in range(count):
+        yield ("," if i else "") + _dumps(records[i])
+    yield "]"
+    for key, value in extra.items():
+        yield "," + _dumps(key) + ":" + _dumps(value)
+    yield "}"
+
+
+def iter_cbor_document(name: str, records, count: int, extra: Dict) -> Iterator[bytes]:
+    """{name: [records...], **extra} as CBOR, one record per chunk."""
+    yield cbor_head(5, 1 + len(extra)) + cbor_dumps(name) + cbor_head(4, count)
+    for i in range(count):
+        yield cbor_dumps(to_wire(records[i]))
+    yield b"".join(cbor_dumps(key) + cbor_dumps(to_wire(value)) for key, value in extra.items())
+
+
+def _stream_format() -> Optional[str]:
+    fmt = request.args.get("format")
+    if fmt is not None:
+        if fmt not in STREAM_FORMATS:
+            raise ValueError(f"format must be one of {', '.join(STREAM_FORMATS)}")
+        return fmt
+    accept = request.accept_mimetypes
+    for fmt, mimetype in STREAM_FORMATS.items():
+        if accept.quality(mimetype) > accept.quality("application/json"):
+            return fmt
+    return None
+
+
+def _page_bounds(count: int, streamed: bool) -> Tuple[int, int]:
+    cursor = request.args.get("cursor", 0, type=int)
+    limit = request.args.get("limit", None if streamed else DEFAULT_PAGE, type=int)
+    if cursor < 0 or (limit is not None and limit < 0):
+        raise ValueError("cursor and limit must not be negative")
+    if not streamed and limit > MAX_PAGE:
+        raise ValueError(f"limit must be at most {MAX_PAGE}, stream longer ranges")
+    start = min(cursor, count)
+    stop = count if limit is None else min(count, start + limit)
+    return start, stop
+
+
+def _search_page(records, query: str, start: int, limit: int, count: int) -> Tuple[list, int]:
+    """Up to limit matches from start on, and the index the scan stopped at."""
+    found = []
+    i = start
+    while i < count and len(found) < limit:
+        record = records[i]
+        if matches(record, query):
+            found.append(record)
+        i += 1
+    return found, i
+
+
+def list_response(name: str, records, extra: Dict[str, Any]):
+    """Answer a list endpoint for records (a list or a store-backed RecordList).
+    extra holds the other top-level fields of the response, to which count,
+    the length of the whole list, is added."""
+    # Records appended while streaming are left for the next request
+    count = len(records)
+    extra = dict(extra, count=count)
+    fmt = _stream_format()
+    query = request.args.get("q", "").strip().lower() or None
+    paged = "cursor" in request.args or "limit" in request.args or query is not None
+
+    if fmt is None and not paged:
+        if wants_cbor():
+            return Response(iter_cbor_document(name, records, count, extra), mimetype=CBOR_MIMETYPE)
+        return Response(iter_json_document(name, records, count, extra), mimetype="application/json")
+
+    start, stop = _page_bounds(count, fmt is not None)
+    if fmt is None:
+        # One page is small enough to build and negotiate like any response
+        if query is None:
+            items = [records[i] for i in range(start, stop)]
+        else:
+            items, stop = _search_page(records, query, start, stop - start, count)
+        page = dict(extra)
+        page.update({name: items, "cursor": start, "next_cursor": stop if stop < count else None})
+        if query is not None:
+            page["q"] = query
+        return jsonify(page)
+
+    # A stream filters the range it covers rather than counting matches
+    next_cursor = stop if stop < count else None
+    if fmt == "ndjson":
+        body = iter_ndjson(records, start, stop, query)
+    else:
+        body = iter_cbor_seq(records, start, stop, query)
+    response = Response(body, mimetype=STREAM_FORMATS[fmt])
+    response.headers["X-Total-Count"] = str(count)
+    if next_cursor is not None:
+        response.headers["X-Next-Cursor"] = str(next_cursor)
+    return response
+
+
+def iter_import_body() -> Iterator[Tuple[int, Any]]:
+    """Yield (position, record) from the request body without reading it whole:
+    NDJSON lines, a CBOR sequence, or (read at once) a JSON or CBOR array.
+    A line that is not valid JSON is yielded as its ValueError."""
+    mimetype = request.mimetype
+    if mimetype == CBOR_SEQ_MIMETYPE:
+        for position, item in enumerate(cbor_seq_load(request.stream)):
+            yield position, from_wire(item)
+    elif mimetype in (CBOR_MIMETYPE, "application/json"):
+        items = request.get_json()
+        if not isinstance(items, list):
+            raise ValueError("Import body must be an array of records")
+        yield from enumerate(items)
+    else:
+        position = 0
+        for line in request.stream:
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                yield position, json.loads(line)
+            except ValueError as e:
+                yield position, e
+            position += 1
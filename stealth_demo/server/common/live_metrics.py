@@ -0,0 +1,115 @@
+"""
+Live metrics for the performance dashboard, as a server-sent event stream.
+Every interval the stream sends one snapshot of this server process:
+- per scheme and operation: calls and calls/s over the interval, and the
+  p50 / p99 latency of the calls since the last performance reset
+- per scheme and primitive (pairings, pows, hashes, serialization): calls
+  and calls/s over the interval
+- per scheme and cache (pairing_pp, precompute, DSK, H3, verify_pp): hits, misses and
+  hit rate, over the interval and overall
+- the job worker pool (workers, busy, queued) and the HTTP requests in flight
+Rates are differences of the libraries' counters between snapshots; a
+counter that went down (performance reset, library reload) counts from zero.
+Under prefork workers (STEALTH_SERVER_WORKERS > 1) a stream describes the
+worker that serves it.
+"""
+import json
+import threading
+import time
+from typing import Dict, Iterator, Optional
+
+# Seconds between snapshots: default, and the range a client may ask for
+DEFAULT_INTERVAL = 1.0
+MIN_INTERVAL = 0.2
+MAX_INTERVAL = 10.0
+
+
+class RequestGauge:
+    """HTTP requests being served, counted by before/teardown request hooks."""
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self.in_flight = 0
+
+    def install(self, app):
+        @app.before_request
+        def _request_started():
+            with self._lock:
+                self.in_flight += 1
+
+        @app.teardown_request
+        def _request_finished(_exc):
+            with self._lock:
+                self.in_flight -= 1
+
+
+request_gauge = RequestGauge()
+
+
+def _try(fn):
+    # Schemes that are not set up yet raise; they are left out of the snapshot
+    try:
+        return fn()
+    except Exception:
+        return None
+
+
+def snapshot(schemes: Dict, jobs) -> Dict:
+    """Current counters of every scheme in {scheme name: service}, the job pool and requests."""
+    result = {"time": time.time(), "schemes": {},
+              "pool": jobs.utilization(), "requests_in_flight": request_gauge.in_flight}
+    for name, service in schemes.items():
+        operations = _try(service.latency_stats)
+        primitives = _try(service.primitive_stats)
+        caches = _try(service.cache_stats)
+        if operations is None and primitives is None and caches is None:
+            continue
+        result["schemes"][name] = {
+            "operations": operations or {},
+            "primitives": {p: {"calls": calls, "total_ms": total_ms}
+                           for p, (calls, total_ms) in (primitives or {}).items()},
+            "caches": caches or {},
+        }
+    return result
+
+
+def _delta(now: int, before: Optional[int]) -> int:
+    if before is None or now < before:
+        return now
+    return now - before
+
+
+def add_rates(current: Dict, previous: Optional[Dict]) -> Dict:
+    """Annotate current with per-second rates and hit rates against previous."""
+    elapsed = current["time"] - previous["time"] if previous else 0.0
+    current["interval_s"] = round(elapsed, 3)
+    for name, scheme in current["schemes"].items():
+        before = (previous or {}).get("schemes", {}).get(name, {})
+        for op, summary in scheme["operations"].items():
+            prev = before.get("operations", {}).get(op, {}).get("count")
+            calls = _delta(summary["count"], prev) if previous else 0
+            summary["interval_calls"] = calls
+            summary["per_s"] = round(calls / elapsed, 2) if elapsed > 0 else 0.0
+        for p, counters in scheme["primitives"].items():
+            prev = before.get("primitives", {}).get(p, {}).get("calls")
+            calls = _delta(counters["calls"], prev) if previous else 0
+            counters["interval_calls"] = calls
+            counters["per_s"] = round(calls / elapsed, 2) if elapsed > 0 else 0.0
+        for cache, counters in scheme["caches"].items():
+            prev = before.get("caches", {}).get(cache, {})
+            hits = _delta(counters["hits"], prev.get("hits")) if previous else 0
+            misses = _delta(counters["misses"], prev.get("misses")) if previous else 0
+            total = counters["hits"] + counters["misses"]
+            counters["hit_rate"] = round(counters["hits"] / total, 4) if total else None
+            counters["interval_hit_rate"] = round(hits / (hits + misses), 4) if hits + misses else None
+    return current
+
+
+def events(schemes: Dict, jobs, interval: float) -> Iterator[str]:
+    """Server-sent events: one annotated snapshot every interval seconds, until the client leaves."""
+    previous = None
+    while True:
+        current = add_rates(snapshot(schemes, jobs), previous)
+        yield f"data: {json.dumps(current)}\n\n"
+        previous = current
+        time.sleep(interval)
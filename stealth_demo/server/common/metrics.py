@@ -0,0 +1,115 @@
+"""
+Prometheus text exposition of the scheme libraries' primitive counters.
+Every loaded scheme reports its pairings, G1 / GT exponentiations, hashes
+to Zr / G1 and element serializations as monotonic call and time counters,
+and the latency percentiles of its operations since the last performance
+reset (library init or a performance test). While a library's hardware
+counters are on (STEALTH_HW_COUNTERS=1) its primitives also report cycles,
+instructions, cache and branch misses and allocations. Each library's
+caches report their hits and misses, and the job worker pool its workers,
+busy workers and waiting jobs.
+"""
+from typing import Dict, List, Optional
+
+CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+
+# quantile label of each latency summary field; max is the 1 quantile
+LATENCY_QUANTILES = (("0.5", "p50_ms"), ("0.9", "p90_ms"), ("0.99", "p99_ms"), ("1", "max_ms"))
+
+
+def render_metrics(schemes: Dict, pool: Optional[Dict] = None) -> str:
+    """Render the /metrics page for a {scheme name: service} mapping and
+    the job pool's utilization."""
+    calls: List[str] = []
+    seconds: List[str] = []
+    latency: List[str] = []
+    latency_calls: List[str] = []
+    hw_calls: List[str] = []
+    hw_events: List[str] = []
+    cache_hits: List[str] = []
+    cache_misses: List[str] = []
+    for scheme_name, service in schemes.items():
+        try:
+            caches = service.cache_stats()
+        except Exception as e:
+            print(f"⚠️ No cache counters for {scheme_name}: {e}")
+            caches = None
+        for cache, counters in (caches or {}).items():
+            labels = f'scheme="{scheme_name}",cache="{cache}"'
+            cache_hits.append(f"pbc_cache_hits_total{{{labels}}} {counters['hits']}")
+            cache_misses.append(f"pbc_cache_misses_total{{{labels}}} {counters['misses']}")
+
+        try:
+            stats = service.latency_stats()
+        except Exception as e:
+            print(f"⚠️ No latency histograms for {scheme_name}: {e}")
+            stats = None
+        for operation, summary in (stats or {}).items():
+            labels = f'scheme="{scheme_name}",operation="{operation}"'
+            for quantile, key in LATENCY_QUANTILES:
+                latency.append(f'pbc_operation_latency_seconds{{{labels},quantile="{quantile}"}} '
+                               f'{summary[key] / 1000.0:.9f}')
+            latency_calls.append(f"pbc_operation_latency_calls{{{labels}}} {summary['count']}")
+
+        try:
+            hw_stats = service.primitive_hw_stats()
+        except Exception as e:
+            print(f"⚠️ No hardware counters for {scheme_name}: {e}")
+            hw_stats = None
+        for primitive, (count, totals) in (hw_stats or {}).items():
+            labels = f'scheme="{scheme_name}",primitive="{primitive}"'
+            hw_calls.append(f"pbc_primitive_hw_calls_total{{{labels}}} {count}")
+            for event, total in totals.items():
+                hw_events.append(f'pbc_primitive_hw_events_total{{{labels},event="{event}"}} {total:.0f}')
+
+        try:
+            stats = service.primitive_stats()
+        except Exception as e:
+            print(f"⚠️ No primitive counters for {scheme_name}: {e}")
+            continue
+        if not stats:
+            continue
+        for primitive, (count, total_ms) in stats.items():
+            labels = f'scheme="{scheme_name}",primitive="{primitive}"'
+            calls.append(f"pbc_primitive_calls_total{{{labels}}} {count}")
+            seconds.append(f"pbc_primitive_seconds_total{{{labels}}} {total_ms / 1000.0:.9f}")
+
+    lines = [
+        "# HELP pbc_primitive_calls_total Cryptographic primitive calls by scheme library.",
+        "# TYPE pbc_primitive_calls_total counter",
+        *calls,
+        "# HELP pbc_primitive_seconds_total Wall-clock time spent in cryptographic primitives.",
+        "# TYPE pbc_primitive_seconds_total counter",
+        *seconds,
+        "# HELP pbc_operation_latency_seconds Per-call latency quantiles of scheme operations.",
+        "# TYPE pbc_operation_latency_seconds gauge",
+        *latency,
+        "# HELP pbc_operation_latency_calls Calls behind pbc_operation_latency_seconds.",
+        "# TYPE pbc_operation_latency_calls gauge",
+        *latency_calls,
+        "# HELP pbc_primitive_hw_calls_total Primitive calls measured with hardware counters on.",
+        "# TYPE pbc_primitive_hw_calls_total counter",
+        *hw_calls,
+        "# HELP pbc_primitive_hw_events_total Hardware counter totals of the measured primitive calls.",
+        "# TYPE pbc_primitive_hw_events_total counter",
+        *hw_events,
+        "# HELP pbc_cache_hits_total Lookups served by a scheme library cache.",
+        "# TYPE pbc_cache_hits_total counter",
+        *cache_hits,
+        "# HELP pbc_cache_misses_total Lookups a scheme library cache could not serve.",
+        "# TYPE pbc_cache_misses_total counter",
+        *cache_misses,
+    ]
+    if pool is not None:
+        lines += [
+            "# HELP job_pool_workers Threads of the background job pool.",
+            "# TYPE job_pool_workers gauge",
+            f"job_pool_workers {pool['workers']}",
+            "# HELP job_pool_busy Job pool threads taken by a job.",
+            "# TYPE job_pool_busy gauge",
+            f"job_pool_busy {pool['busy']}",
+            "# HELP job_pool_queued Jobs waiting for a job pool thread.",
+            "# TYPE job_pool_queued gauge",
+            f"job_pool_queued {pool['queued']}",
+        ]
+    return "\n".join(lines) + "\n"
@@ -0,0 +1,168 @@
+"""
+Persistent record storage for the multi-scheme demo.
+Keys, addresses and DSKs can live in memory-mapped C store files (one set
+per scheme and parameter file) instead of in-process Python lists. Set
+PBC_DEMO_STORE_DIR to a directory to enable it; without it every list stays
+in memory as before.
+"""
+import os
+from typing import Callable, Dict, Optional, Tuple
+
+STORE_DIR_ENV = "PBC_DEMO_STORE_DIR"
+
+# File name of each persisted config list
+STORE_FILES = {"key_list": "keys", "address_list": "addresses", "dsk_list": "dsks"}
+
+
+def get_store_dir() -> Optional[str]:
+    """Directory for store files, None if persistence is disabled."""
+    store_dir = os.environ.get(STORE_DIR_ENV)
+    if not store_dir:
+        return None
+    os.makedirs(store_dir, exist_ok=True)
+    return store_dir
+
+
+def store_path(store_dir: str, scheme_name: str, param_file: str, name: str,
+               variant: str = "") -> str:
+    """File of one record kind, e.g. <dir>/stealth-a-keys.pbcs for a.param
+    (<dir>/stealth-a-h2-keys.pbcs for variant "h2")."""
+    stem = os.path.splitext(os.path.basename(param_file))[0]
+    if variant:
+        stem = f"{stem}-{variant}"
+    return os.path.join(store_dir, f"{scheme_name}-{stem}-{name}.pbcs")
+
+
+class RecordList:
+    """
+    List-like view over one store file.
+    Supports the list operations the services use (len, indexing, iteration,
+    append, clear); items are rebuilt from their record on every access.
+    """
+
+    def __init__(self, lib, path: str, kind: int,
+                 encode: Callable[[Dict], Tuple[list, bytes]],
+                 decode: Callable[[int, list, bytes], Dict]):
+        self._lib = lib
+        self._kind = kind
+        self._encode = encode
+        self._decode = decode
+        self.handle = lib.store_open(path, kind)
+
+    def __len__(self) -> int:
+        return self._lib.store_count(self.handle)
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self[i] for i in range(*index.indices(len(self)))]
+        count = len(self)
+        if index < 0:
+            index += count
+        if not 0 <= index < count:
+            raise IndexError("record index out of range")
+        elems, meta = self._lib.store_get(self.handle, self._kind, index)
+        return self._decode(index, elems, meta)
+
+    def __iter__(self):
+        for i in range(len(self)):
+            yield self[i]
+
+    def append(self, item: Dict):
+        elems, meta = self._encode(item)
+        index = self._lib.store_append(self.handle, self._kind, elems, meta)
+        # Other server processes may have appended since the caller took
+        # len() for the item's index
+        if item.get('index') != index:
+            item['index'] = index
+            item['id'] = f"{item['id'].rsplit('_', 1)[0]}_{index}"
+
+    def clear(self):
+        """Drop every record, on disk too."""
+        self._lib.store_reset(self.handle)
+
+    def close(self):
+        if self.handle is not None:
+            self._lib.store_close(self.handle)
+            self.handle = None
+
+
+class SchemeStore:
+    """
+    The store files of one scheme and parameter set: the record lists plus
+    a system record holding the session generator and tracer key pair, the
+    scan cursors of the wallet sync, the tracing index and the precomputed
+    tables of every key.
+    """
+
+    def __init__(self, lib, store_dir: str, scheme_name: str, param_file: str, variant: str,
+                 codecs: Dict[str, Tuple[int, Callable, Callable]]):
+        """codecs maps a config list name (key_list, ...) to (kind, encode, decode);
+        variant separates sessions whose records are not interchangeable."""
+        self._lib = lib
+        self.directory = store_dir
+        self.system = lib.store_open(store_path(store_dir, scheme_name, param_file, "system", variant),
+                                     lib.STORE_SYSTEM)
+        # Per-key scan cursors of the wallet sync, when the library has it
+        self.cursors = None
+        if getattr(lib, 'wallet_sync_available', False):
+            self.cursors = lib.store_open(store_path(store_dir, scheme_name, param_file, "cursors", variant),
+                                          lib.STORE_CURSORS)
+        # Trace of every address, chained per recovered B, when the library has it
+        self.traces = None
+        if getattr(lib, 'trace_index_available', False):
+            self.traces = lib.store_open(store_path(store_dir, scheme_name, param_file, "traces", variant),
+                                         lib.STORE_TRACES)
+        # Fixed-base tables of every stored key, when the library has them
+        self.key_tables = None
+        if getattr(lib, 'key_tables_available', False):
+            self.key_tables = lib.store_open_key_tables(
+                store_path(store_dir, scheme_name, param_file, "key-tables", variant))
+        self.lists = {}
+        for list_name, (kind, encode, decode) in codecs.items():
+            path = store_path(store_dir, scheme_name, param_file, STORE_FILES[list_name], variant)
+            self.lists[list_name] = RecordList(lib, path, kind, encode, decode)
+
+    def load_tracer_key(self) -> Optional[Tuple[bytes, bytes]]:
+        """Restore the saved generator; returns the saved tracer key pair, None for a new store."""
+        return self._lib.store_load_system(self.system)
+
+    def save_tracer_key(self, tk_bytes: bytes, k_bytes: bytes):
+        if not self._lib.store_save_system(self.system, tk_bytes, k_bytes):
+            raise Exception("Failed to save tracer key to store")
+
+    def handle(self, list_name: str) -> int:
+        return self.lists[list_name].handle
+
+    def sync_key_tables(self) -> int:
+        """Build the tables of the keys stored without them yet; returns how many."""
+        if self.key_tables is None:
+            return 0
+        return self._lib.store_key_tables_sync(self.handle('key_list'), self.key_tables)
+
+    def reset(self):
+        """Drop every record of every file."""
+        for records in self.lists.values():
+            records.clear()
+        if self.cursors is not None:
+            self._lib.store_reset(self.cursors)
+        if self.traces is not None:
+            self._lib.store_reset(self.traces)
+        if self.key_tables is not None:
+            self._lib.store_reset(self.key_tables)
+        self._lib.store_reset(self.system)
+
+    def close(self):
+        for records in self.lists.values():
+            records.close()
+        if self.cursors is not None:
+            self._lib.store_close(self.cursors)
+            self.cursors = None
+        if self.traces is not None:
+            self._lib.store_close(self.traces)
+            self.traces = None
+        if self.key_tables is not None:
+            self._lib.store_close(self.key_tables)
+            self.key_tables = None
+        if self.system is not None:
+            self._lib.store_close(self.system)
+            self.system = None
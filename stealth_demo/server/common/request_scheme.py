@@ -0,0 +1,62 @@
+"""
+The scheme a request runs on, so that stealth and SITAIBA clients are
+served side by side instead of taking turns through /switch_scheme.
+A request names its scheme, first match wins:
+- a path prefix: /sitaiba/keygen is /keygen on SITAIBA
+- the query: /keylist?scheme=sitaiba
+- a "scheme" field of its JSON or CBOR payload
+and is bound to it for its whole handling (MultiSchemeConfig.bind_scheme).
+A request that names none runs on the default scheme, which
+/switch_scheme sets.
+"""
+from flask import jsonify, request
+
+from ..multi_scheme_config import config
+
+# WSGI environ key of the scheme taken off the path
+ENVIRON_KEY = "stealth_demo.scheme"
+
+
+class SchemePathPrefix:
+    """WSGI middleware serving /<scheme>/<path> as /<path>, noting <scheme> in the environ."""
+
+    def __init__(self, wsgi_app, schemes):
+        self.wsgi_app = wsgi_app
+        self.schemes = frozenset(schemes)
+
+    def __call__(self, environ, start_response):
+        path = environ.get("PATH_INFO", "")
+        head, sep, rest = path[1:].partition("/")
+        if sep and head in self.schemes:
+            environ["PATH_INFO"] = "/" + rest
+            environ["SCRIPT_NAME"] = environ.get("SCRIPT_NAME", "") + "/" + head
+            environ[ENVIRON_KEY] = head
+        return self.wsgi_app(environ, start_response)
+
+
+def requested_scheme():
+    """The scheme named by the current request, None if it names none."""
+    scheme = request.environ.get(ENVIRON_KEY) or request.args.get("scheme")
+    if scheme:
+        return scheme
+    data = request.get_json(silent=True)
+    if isinstance(data, dict) and isinstance(data.get("scheme"), str):
+        return data["scheme"]
+    return None
+
+
+def install(app):
+    """Route scheme path prefixes and bind every request of app to its scheme."""
+    app.wsgi_app = SchemePathPrefix(app.wsgi_app, config.schemes_data)
+
+    @app.before_request
+    def _bind_request_scheme():
+        scheme = requested_scheme()
+        if scheme is not None and scheme not in config.schemes_data:
+            return jsonify({"error": f"Unknown scheme: {scheme}",
+                            "available_schemes": list(config.schemes_data)}), 400
+        config.bind_scheme(scheme)
+
+    @app.teardown_request
+    def _unbind_request_scheme(_exc):
+        config.bind_scheme(None)
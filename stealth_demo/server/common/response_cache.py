@@ -0,0 +1,121 @@
+"""
+Version-stamped caching of the read-heavy GET endpoints.
+A cached endpoint answers from a version of the state it reads, cheap to
+compute (counters and list lengths, no serialization):
+- a request whose If-None-Match holds the ETag of the current version gets
+  304 Not Modified without the view running at all
+- otherwise the body built for the current version is served again when
+  cached, and rebuilt, cached and served when the version moved on
+The ETag is derived from the version, the scheme the request runs on, the
+path with its query and the Accept header, so schemes, pages, stream
+formats and JSON and CBOR each have their own: /sitaiba/keylist and
+/keylist share a path once the scheme prefix is taken off. Responses
+carry Cache-Control: no-cache, so browsers revalidate every poll with
+If-None-Match and reuse their copy on 304.
+Streamed bodies are cached while they are sent, up to MAX_CACHED_BYTES.
+"""
+import functools
+import hashlib
+import threading
+from collections import OrderedDict
+from typing import Callable, Hashable, Iterable, Optional, Tuple
+
+from flask import Response, make_response, request
+
+from ..multi_scheme_config import config
+
+# Most responses kept, and the largest body kept
+MAX_ENTRIES = 64
+MAX_CACHED_BYTES = 1 << 20
+
+# Headers rebuilt for every response rather than replayed from the cache
+_SKIPPED_HEADERS = {"content-length", "etag", "cache-control", "vary"}
+
+
+class ResponseCache:
+    """Cached bodies by (scheme, endpoint, path, Accept), each for the version it was built at."""
+
+    def __init__(self, max_entries: int = MAX_ENTRIES, max_bytes: int = MAX_CACHED_BYTES):
+        self.max_entries = max_entries
+        self.max_bytes = max_bytes
+        self._entries = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = self.misses = self.not_modified = 0
+
+    def cached(self, version: Callable[[], Hashable]):
+        """Decorate a GET view whose response depends only on the request and version()."""
+        def decorator(view):
+            @functools.wraps(view)
+            def wrapper(*args, **kwargs):
+                key = (config.current_scheme, request.endpoint, request.full_path,
+                       request.headers.get("Accept", ""))
+                etag = hashlib.blake2b(repr((version(), key)).encode(), digest_size=12).hexdigest()
+                if request.if_none_match.contains_weak(etag):
+                    with self._lock:
+                        self.not_modified += 1
+                    return self._finish(Response(status=304), etag)
+
+                with self._lock:
+                    entry = self._entries.get(key)
+                    if entry is not None and entry[0] == etag:
+                        self._entries.move_to_end(key)
+                        self.hits += 1
+                        _, headers, body = entry
+                        return self._finish(Response(body, headers=headers), etag)
+                    self.misses += 1
+
+                response = make_response(view(*args, **kwargs))
+                if response.status_code != 200:
+                    return response
+                headers = [(k, v) for k, v in response.headers.items() if k.lower() not in _SKIPPED_HEADERS]
+                if response.is_streamed:
+                    response.response = self._tee(key, etag, headers, response.iter_encoded())
+                else:
+                    self._store(key, etag, headers, response.get_data())
+                return self._finish(response, etag)
+            return wrapper
+        return decorator
+
+    def clear(self):
+        """Drop every cached body (the ETags of the current versions stay valid)."""
+        with self._lock:
+            self._entries.clear()
+
+    def stats(self) -> dict:
+        with self._lock:
+            return {"entries": len(self._entries), "hits": self.hits, "misses": self.misses,
+                    "not_modified": self.not_modified}
+
+    @staticmethod
+    def _finish(response: Response, etag: str) -> Response:
+        response.set_etag(etag, weak=True)
+        response.headers["Cache-Control"] = "no-cache"
+        response.vary.add("Accept")
+        return response
+
+    def _store(self, key: Tuple, etag: str, headers, body: bytes):
+        if len(body) > self.max_bytes:
+            return
+        with self._lock:
+            self._entries[key] = (etag, headers, body)
+            self._entries.move_to_end(key)
+            while len(self._entries) > self.max_entries:
+                self._entries.popitem(last=False)
+
+    def _tee(self, key: Tuple, etag: str, headers, chunks: Iterable[bytes]):
+        """Yield chunks, keeping the body if it ends within max_bytes."""
+        kept: Optional[list] = []
+        size = 0
+        for chunk in chunks:
+            if kept is not None:
+                size += len(chunk)
+                if size > self.max_bytes:
+                    kept = None
+                else:
+                    kept.append(chunk)
+            yield chunk
+        if kept is not None:
+            self._store(key, etag, headers, b"".join(kept))
+
+
+response_cache = ResponseCache()
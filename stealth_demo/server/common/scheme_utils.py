@@ -32,6 +32,11 @@ class SchemeUtilsBase(ABC):
         """Find key with matching hex value (scheme-specific matching logic)."""
         pass
     
+    @abstractmethod
+    def describe_key(self, index: int) -> Dict[str, Any]:
+        """Describe an exact key match in the scheme's matched_key format."""
+        pass
+    
     def create_buffer_with_scheme_size(self, size: Optional[int] = None):
         """Create buffer using scheme-specific size if not provided."""
         if size is None:
@@ -109,3 +114,8 @@ def bytes_to_hex_safe_fixed(buf, element_type: str = 'G1') -> str:
 def find_matching_key(target_hex: str) -> Optional[Dict[str, Any]]:
     """Find matching key using current scheme logic."""
     return get_current_scheme_utils().find_matching_key(target_hex)
+
+
+def describe_key(index: int) -> Dict[str, Any]:
+    """Describe an exact key match using current scheme logic."""
+    return get_current_scheme_utils().describe_key(index)
@@ -0,0 +1,87 @@
+"""
+Session state shared by the worker processes of a multi-process server.
+Every worker loads its own copy of the C libraries, so a /setup, /reset or
+/switch_scheme served by one worker is published to a small JSON file in
+the store directory, and the other workers replay it before their next
+request. Keys, addresses and DSKs need no replay: they live in the shared
+memory-mapped store files, which every worker reads in place.
+"""
+import fcntl
+import json
+import os
+from typing import Dict, Optional
+
+from .record_store import get_store_dir
+
+SESSION_FILE = "server-session.json"
+LOCK_FILE = "server-session.lock"
+
+
+class SharedSession:
+    """The published session: current scheme and the setup of each scheme."""
+
+    def __init__(self):
+        self.directory = None
+        # generation of the state this process last applied
+        self.applied_generation = 0
+
+    @property
+    def enabled(self) -> bool:
+        return self.directory is not None
+
+    def enable(self):
+        """Share the session through the store directory; needs PBC_DEMO_STORE_DIR."""
+        store_dir = get_store_dir()
+        if store_dir is None:
+            raise RuntimeError("A multi-process server shares its records through the "
+                               "store files: set PBC_DEMO_STORE_DIR")
+        self.directory = store_dir
+
+    def clear(self):
+        """Start from an empty session, as a freshly started server does."""
+        self._update(lambda state: state.clear())
+
+    def publish_setup(self, scheme_name: str, setup: Optional[Dict]):
+        """Record scheme_name's setup arguments, or None once it is reset."""
+        def change(state):
+            state.setdefault('schemes', {})[scheme_name] = setup
+            state['current_scheme'] = scheme_name
+        self._update(change)
+
+    def publish_current(self, scheme_name: str):
+        self._update(lambda state: state.__setitem__('current_scheme', scheme_name))
+
+    def changed(self) -> Optional[Dict]:
+        """The published state if other processes changed it since this one last applied it."""
+        state = self._read()
+        if state.get('generation', 0) == self.applied_generation:
+            return None
+        return state
+
+    def _path(self, name: str) -> str:
+        return os.path.join(self.directory, name)
+
+    def _read(self) -> Dict:
+        try:
+            with open(self._path(SESSION_FILE)) as f:
+                return json.load(f)
+        except FileNotFoundError:
+            return {}
+
+    def _update(self, change):
+        with open(self._path(LOCK_FILE), "a") as lock:
+            fcntl.flock(lock, fcntl.LOCK_EX)
+            state = self._read()
+            generation = state.get('generation', 0) + 1
+            change(state)
+            state['generation'] = generation
+            tmp = self._path(f"{SESSION_FILE}.{os.getpid()}")
+            with open(tmp, "w") as f:
+                json.dump(state, f)
+            os.replace(tmp, self._path(SESSION_FILE))
+            # This process made the change, so it has nothing to replay
+            if self.applied_generation == generation - 1:
+                self.applied_generation = generation
+
+
+shared_session = SharedSession()
@@ -4,6 +4,8 @@ Hangles parameter files, system initialization, and data management for multiple
 """
 import os
 import glob
+import threading
+from contextlib import contextmanager
 from typing import Dict, List, Optional
 
 
@@ -24,25 +26,36 @@ class MultiSchemeConfig:
                 'current_param_file': None,
                 'trace_key': None,
                 'key_list': [],
+                'key_by_A': {},  # A_hex -> key index
+                'key_by_B': {},  # B_hex -> key index, resolves traces
                 'address_list': [],
                 'dsk_list': [],
                 'tx_message_list': [],  # stealth supports signing
-                'dsk_functions_available': False
+                'dsk_functions_available': False,
+                'store': None  # SchemeStore when lists are persisted
             },
             'sitaiba': {
                 'system_initialized': False,
                 'current_param_file': None,
                 'trace_key': None,
                 'key_list': [],
+                'key_by_A': {},  # A_hex -> key index
+                'key_by_B': {},  # B_hex -> key index, resolves traces
                 'address_list': [],
                 'dsk_list': [],
                 # no tx_message_list - sitaiba doesn't support signing
-                'dsk_functions_available': False
+                'dsk_functions_available': False,
+                'store': None  # SchemeStore when lists are persisted
             }
         }
         
-        # Global settings
-        self.current_scheme = 'stealth'  # Default scheme
+        # Scheme of whatever names none, see current_scheme
+        self.default_scheme = 'stealth'
+        # Scheme bound to the calling thread by bind_scheme
+        self._bound = threading.local()
+        
+        # Bumped by every change the list lengths do not show, see state_version
+        self.generation = 0
     
     def get_current_data(self) -> Dict:
         """Get data for the current scheme."""
@@ -54,11 +67,49 @@ class MultiSchemeConfig:
             raise ValueError(f"Unknown scheme: {scheme_name}")
         return self.schemes_data[scheme_name]
     
+    @property
+    def current_scheme(self) -> str:
+        """Scheme of the calling thread: the one bound to it, else the default.
+        Every request binds the scheme it names, so requests on different
+        schemes run side by side, each seeing its own scheme's state."""
+        return getattr(self._bound, 'scheme', None) or self.default_scheme
+    
     def set_current_scheme(self, scheme_name: str):
-        """Set the current active scheme."""
+        """Set the default scheme, used by requests and threads that bind none."""
         if scheme_name not in self.schemes_data:
             raise ValueError(f"Unknown scheme: {scheme_name}")
-        self.current_scheme = scheme_name
+        self.default_scheme = scheme_name
+        self.touch()
+    
+    def bind_scheme(self, scheme_name: Optional[str]):
+        """Make scheme_name current for the calling thread only; None goes back to the default."""
+        if scheme_name is not None and scheme_name not in self.schemes_data:
+            raise ValueError(f"Unknown scheme: {scheme_name}")
+        self._bound.scheme = scheme_name
+    
+    @contextmanager
+    def scheme_bound(self, scheme_name: str):
+        """Bind scheme_name to the calling thread inside the block, then restore the previous binding."""
+        previous = getattr(self._bound, 'scheme', None)
+        self.bind_scheme(scheme_name)
+        try:
+            yield
+        finally:
+            self._bound.scheme = previous
+    
+    def touch(self):
+        """Note a change of state, such as a reset followed by as many new records."""
+        self.generation += 1
+    
+    def state_version(self) -> tuple:
+        """Version of the whole state seen by the calling thread, for cached responses:
+        changes whenever a scheme is set up, reset, switched or persisted, or a
+        record is added to any list."""
+        return (self.generation, self.default_scheme, self.current_scheme) + tuple(
+            (name, data['system_initialized'], data['current_param_file'], data['store'] is not None,
+             len(data['key_list']), len(data['address_list']), len(data['dsk_list']),
+             len(data.get('tx_message_list', ())))
+            for name, data in self.schemes_data.items())
     
     # Parameter file management (shared across schemes)
     def get_param_files(self) -> Dict:
@@ -86,6 +137,13 @@ class MultiSchemeConfig:
             "current_scheme": self.current_scheme
         }
     
+    def param_dir_version(self):
+        """Changes when parameter files are added to or removed from the directory."""
+        try:
+            return os.stat(_param_base_dir).st_mtime_ns
+        except FileNotFoundError:
+            return None
+    
     def validate_param_file(self, param_file: str) -> str:
         """Validate parameter file exists and return full path."""
         # Use the pre-calculated absolute path
@@ -104,6 +162,7 @@ class MultiSchemeConfig:
         scheme_data['system_initialized'] = True
         scheme_data['current_param_file'] = param_file
         scheme_data['trace_key'] = trace_key
+        self.touch()
     
     def ensure_initialized(self, scheme_name: Optional[str] = None):
         """Ensure the system is initialized for current or specified scheme."""
@@ -120,7 +179,13 @@ class MultiSchemeConfig:
             scheme_name = self.current_scheme
         
         scheme_data = self.get_scheme_data(scheme_name)
+        if scheme_data['store'] is not None:
+            # Reset wipes the persisted records as well
+            scheme_data['store'].reset()
+            self.detach_store(scheme_name)
         scheme_data['key_list'].clear()
+        scheme_data['key_by_A'].clear()
+        scheme_data['key_by_B'].clear()
         scheme_data['address_list'].clear()
         scheme_data['dsk_list'].clear()
         
@@ -131,7 +196,40 @@ class MultiSchemeConfig:
         scheme_data['trace_key'] = None
         scheme_data['system_initialized'] = False
         scheme_data['current_param_file'] = None
+        self.touch()
     
+    def attach_store(self, store, scheme_name: Optional[str] = None):
+        """Back a scheme's key, address and DSK lists with a SchemeStore."""
+        if scheme_name is None:
+            scheme_name = self.current_scheme
+
+        scheme_data = self.get_scheme_data(scheme_name)
+        scheme_data['store'] = store
+        scheme_data.update(store.lists)
+        scheme_data['key_by_A'].clear()
+        scheme_data['key_by_B'].clear()
+        for item in scheme_data['key_list']:
+            scheme_data['key_by_A'][item['A_hex']] = item['index']
+            scheme_data['key_by_B'][item['B_hex']] = item['index']
+        self.touch()
+
+    def detach_store(self, scheme_name: Optional[str] = None):
+        """Close a scheme's store files (keeping them on disk) and go back to in-memory lists."""
+        if scheme_name is None:
+            scheme_name = self.current_scheme
+
+        scheme_data = self.get_scheme_data(scheme_name)
+        store = scheme_data['store']
+        if store is None:
+            return
+        store.close()
+        scheme_data['store'] = None
+        for list_name in store.lists:
+            scheme_data[list_name] = []
+        scheme_data['key_by_A'].clear()
+        scheme_data['key_by_B'].clear()
+        self.touch()
+
     def reset_all_schemes(self):
         """Reset all schemes data."""
         for scheme_name in self.schemes_data.keys():
@@ -153,6 +251,7 @@ class MultiSchemeConfig:
             "addresses_count": len(scheme_data['address_list']),
             "dsks_count": len(scheme_data['dsk_list']),
             "dsk_functions_available": scheme_data['dsk_functions_available'],
+            "persistent": scheme_data['store'] is not None,
             "architecture": f"multi_scheme_{scheme_name}"
         }
         
@@ -166,6 +265,7 @@ class MultiSchemeConfig:
         """Get status for all schemes."""
         return {
             "current_scheme": self.current_scheme,
+            "default_scheme": self.default_scheme,
             "schemes": {
                 scheme_name: self.get_status(scheme_name)
                 for scheme_name in self.schemes_data.keys()
@@ -193,6 +293,22 @@ class MultiSchemeConfig:
         """Get current scheme's key list."""
         return self.get_current_data()['key_list']
     
+    @property
+    def key_by_A(self) -> Dict[str, int]:
+        """Get current scheme's A_hex -> key index map."""
+        return self.get_current_data()['key_by_A']
+    
+    @property
+    def key_by_B(self) -> Dict[str, int]:
+        """Get current scheme's B_hex -> key index map."""
+        return self.get_current_data()['key_by_B']
+    
+    def index_key(self, item: Dict):
+        """Add a key list entry to the current scheme's lookup maps."""
+        data = self.get_current_data()
+        data['key_by_A'][item['A_hex']] = item['index']
+        data['key_by_B'][item['B_hex']] = item['index']
+    
     @property
     def address_list(self) -> List[Dict]:
         """Get current scheme's address list."""
@@ -203,6 +319,11 @@ class MultiSchemeConfig:
         """Get current scheme's DSK list."""
         return self.get_current_data()['dsk_list']
     
+    @property
+    def store(self):
+        """Get current scheme's SchemeStore, None if its lists are in memory."""
+        return self.get_current_data()['store']
+    
     @property
     def tx_message_list(self) -> List[Dict]:
         """Get current scheme's transaction message list (if supported)."""
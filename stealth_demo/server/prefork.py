@@ -0,0 +1,78 @@
+"""
+Pre-forked multi-process serving for the demo server.
+The C libraries keep one pairing per process and serialize on it, so a
+single process serves every request on one core. Here the parent binds
+the listening socket once and forks workers that all accept on it, each
+with its own copy of the libraries; they share records through the store
+files and the session through common.shared_session.
+"""
+import os
+import signal
+import socket
+import time
+
+from werkzeug.serving import make_server
+
+WORKERS_ENV = "STEALTH_SERVER_WORKERS"
+
+
+def get_worker_count() -> int:
+    """Worker processes to serve with: STEALTH_SERVER_WORKERS, 0 for one per CPU, default 1."""
+    workers = int(os.environ.get(WORKERS_ENV, "1"))
+    return workers if workers > 0 else os.cpu_count() or 1
+
+
+def _worker(sock: socket.socket, host: str, port: int, app_factory):
+    signal.signal(signal.SIGINT, signal.SIG_IGN)
+    signal.signal(signal.SIGTERM, signal.SIG_DFL)
+    app = app_factory()
+    server = make_server(host, port, app, threaded=True, fd=sock.fileno())
+    server.serve_forever()
+
+
+def serve(app_factory, host: str, port: int, workers: int):
+    """Serve app_factory() from workers processes until SIGINT or SIGTERM."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((host, port))
+    sock.listen(128)
+    sock.set_inheritable(True)
+
+    children = {}
+    stopping = False
+
+    def spawn(slot: int):
+        pid = os.fork()
+        if pid == 0:
+            try:
+                _worker(sock, host, port, app_factory)
+            finally:
+                os._exit(1)
+        children[pid] = slot
+
+    def stop(signum, frame):
+        nonlocal stopping
+        stopping = True
+        for pid in children:
+            os.kill(pid, signal.SIGTERM)
+
+    signal.signal(signal.SIGINT, stop)
+    signal.signal(signal.SIGTERM, stop)
+    for slot in range(workers):
+        spawn(slot)
+    print(f"👷 {workers} worker processes serving http://{host}:{port}")
+
+    while children:
+        try:
+            pid, status = os.wait()
+        except InterruptedError:
+            continue
+        except ChildProcessError:
+            break
+        slot = children.pop(pid, None)
+        if slot is not None and not stopping:
+            print(f"⚠️ Worker {pid} exited with status {status}, restarting")
+            # A worker that dies at once would otherwise respawn in a busy loop
+            time.sleep(1)
+            spawn(slot)
+    sock.close()
@@ -1,6 +1,10 @@
 """
 Scheme manager for handling multiple cryptographic schemes.
 Provides unified interface to switch between stealth and sitaiba schemes.
+Both schemes stay set up side by side; the methods dispatch to the scheme
+of the calling thread (see MultiSchemeConfig.current_scheme), which a
+request binds from its path, query or payload, so requests on different
+schemes run concurrently and switching only moves the default.
 """
 from typing import Dict, Any, Optional
 import traceback
@@ -9,14 +13,18 @@ import traceback
 # Import scheme services directly
 from .schemes.stealth.stealth_services import StealthServices
 from .schemes.sitaiba.sitaiba_services import SitaibaServices
+from .multi_scheme_config import config
+from .common.shared_session import shared_session
 
 
 class SchemeManager:
     """Manager for multiple cryptographic schemes."""
 
     def __init__(self):
-        self.current_scheme = 'stealth'  # Default scheme
         self.schemes = {}
+        # Setup arguments this process applied per scheme, None if not set up;
+        # compared against the shared session of a multi-process server
+        self._applied_setups = {}
         self._initialize_schemes()
 
     def _initialize_schemes(self):
@@ -43,6 +51,11 @@ class SchemeManager:
         """Get list of available schemes."""
         return list(self.schemes.keys())
 
+    @property
+    def current_scheme(self) -> str:
+        """Scheme of the calling thread (see MultiSchemeConfig.current_scheme)."""
+        return config.current_scheme
+
     def get_current_scheme_name(self) -> str:
         """Get current scheme name."""
         return self.current_scheme
@@ -54,13 +67,16 @@ class SchemeManager:
         return self.schemes[self.current_scheme]
 
     def switch_scheme(self, scheme_name: str) -> Dict[str, Any]:
-        """Switch to a different scheme."""
+        """Switch the default scheme, of requests that name none. Requests on
+        other schemes and running jobs go on unaffected."""
         if scheme_name not in self.schemes:
             available = ', '.join(self.get_available_schemes())
             raise ValueError(f"Unknown scheme '{scheme_name}'. Available: {available}")
 
-        old_scheme = self.current_scheme
-        self.current_scheme = scheme_name
+        old_scheme = config.default_scheme
+        config.set_current_scheme(scheme_name)
+        if shared_session.enabled:
+            shared_session.publish_current(scheme_name)
 
         return {
             "status": "switched",
@@ -116,6 +132,7 @@ class SchemeManager:
         """Get overall scheme manager status."""
         return {
             "current_scheme": self.current_scheme,
+            "default_scheme": config.default_scheme,
             "available_schemes": self.get_available_schemes(),
             "current_capabilities": self.get_scheme_capabilities(),
             "schemes_status": {
@@ -125,18 +142,62 @@ class SchemeManager:
         }
 
     # Unified method dispatching
-    def setup_system(self, param_file: str) -> Dict[str, Any]:
+    def setup_system(self, param_file: str, point_format: str = "uncompressed",
+                     hash_version: int = 1) -> Dict[str, Any]:
         """Setup current scheme system."""
         service = self.get_current_service()
-        result = service.setup_system(param_file)
+        result = service.setup_system(param_file, point_format, hash_version)
         result["scheme"] = self.current_scheme
+        if shared_session.enabled:
+            setup = {"param_file": param_file, "point_format": point_format, "hash_version": hash_version}
+            self._applied_setups[self.current_scheme] = setup
+            shared_session.publish_setup(self.current_scheme, setup)
         return result
 
+    def note_reset(self, scheme_names: list):
+        """Publish that scheme_names were reset, for the other server processes."""
+        if shared_session.enabled:
+            for scheme_name in scheme_names:
+                self._applied_setups[scheme_name] = None
+                shared_session.publish_setup(scheme_name, None)
+
+    def sync_shared_session(self):
+        """
+        Catch up with what other server processes did: replay their setups
+        and resets, take over their current scheme, and index the keys
+        they appended to the shared store.
+        """
+        state = shared_session.changed()
+        if state is not None:
+            setups = state.get('schemes', {})
+            for scheme_name, service in self.schemes.items():
+                setup = setups.get(scheme_name)
+                if setup == self._applied_setups.get(scheme_name):
+                    continue
+                if setup is None:
+                    # The records were already wiped by whoever reset
+                    config.detach_store(scheme_name)
+                    config.reset_scheme(scheme_name)
+                else:
+                    service.setup_system(**setup)
+                self._applied_setups[scheme_name] = setup
+            current = state.get('current_scheme', config.default_scheme)
+            if current in self.schemes and current != config.default_scheme:
+                config.set_current_scheme(current)
+            shared_session.applied_generation = state['generation']
+
+        # A request may name either scheme, so both catch up
+        for scheme_name, service in self.schemes.items():
+            if config.get_scheme_data(scheme_name)['system_initialized']:
+                service.index_new_keys()
+                service.index_new_addresses()
+
     def generate_keypair(self) -> Dict[str, Any]:
         """Generate keypair with current scheme."""
         service = self.get_current_service()
         result = service.generate_keypair()
         result["scheme"] = self.current_scheme
+        config.touch()
         return result
 
     def generate_address(self, key_index: int) -> Dict[str, Any]:
@@ -144,6 +205,67 @@ class SchemeManager:
         service = self.get_current_service()
         result = service.generate_address(key_index)
         result["scheme"] = self.current_scheme
+        config.touch()
+        return result
+
+    def generate_addresses_bulk(self, count: int, key_indices: Optional[list] = None,
+                                num_threads: int = 0) -> Dict[str, Any]:
+        """Generate count addresses across keys with current scheme."""
+        service = self.get_current_service()
+        result = service.generate_addresses_bulk(count, key_indices, num_threads)
+        result["scheme"] = self.current_scheme
+        config.touch()
+        return result
+
+    def trace_owner_addresses(self, key_index: Optional[int] = None, b_hex: Optional[str] = None) -> Dict[str, Any]:
+        """Every address traced to a key with current scheme."""
+        service = self.get_current_service()
+        result = service.trace_owner_addresses(key_index, b_hex)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def lookup_address(self, addr_hex: str) -> Dict[str, Any]:
+        """Look up a one-time address among the known ones with current scheme."""
+        service = self.get_current_service()
+        result = service.lookup_address(addr_hex)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def recognize_address_multi(self, address_index: int, key_indices: Optional[list] = None) -> Dict[str, Any]:
+        """Find the owning key of an address with current scheme."""
+        service = self.get_current_service()
+        result = service.recognize_address_multi(address_index, key_indices)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def scan_addresses(self, key_index: int) -> Dict[str, Any]:
+        """Find every address owned by a key with current scheme."""
+        service = self.get_current_service()
+        result = service.scan_addresses(key_index)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def sync_addresses(self, key_index: int, count: Optional[int] = None) -> Dict[str, Any]:
+        """Resume the wallet scan of a key from its checkpoint with current scheme."""
+        service = self.get_current_service()
+        result = service.sync_addresses(key_index, count)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def scan_addresses_bulk(self, key_indices: Optional[list] = None, start: int = 0,
+                            count: Optional[int] = None, num_threads: int = 0) -> Dict[str, Any]:
+        """Find the owners of stored addresses among keys with current scheme."""
+        service = self.get_current_service()
+        result = service.scan_addresses_bulk(key_indices, start, count, num_threads)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def import_records(self, list_name: str, records) -> Dict[str, Any]:
+        """Append imported records to a list of current scheme."""
+        service = self.get_current_service()
+        result = service.import_records(list_name, records)
+        result["scheme"] = self.current_scheme
+        config.touch()
         return result
 
     def generate_dsk(self, address_index: int, key_index: int) -> Dict[str, Any]:
@@ -153,6 +275,13 @@ class SchemeManager:
         result["scheme"] = self.current_scheme
         return result
 
+    def generate_dsks(self, address_indices: list, key_index: int, num_threads: int = 0) -> Dict[str, Any]:
+        """Generate DSKs for many addresses of one key with current scheme."""
+        service = self.get_current_service()
+        result = service.generate_dsks(address_indices, key_index, num_threads)
+        result["scheme"] = self.current_scheme
+        return result
+
     def sign_message(self, *args, **kwargs) -> Dict[str, Any]:
         """Sign message with current scheme (if supported)."""
         service = self.get_current_service()
@@ -176,13 +305,25 @@ class SchemeManager:
         result["scheme"] = self.current_scheme
         return result
 
-    def performance_test(self, iterations: int = 100) -> Dict[str, Any]:
-        """Run performance test with current scheme."""
+    def performance_test(self, iterations: int = 100, progress=None, seed: Optional[int] = None) -> Dict[str, Any]:
+        """Run performance test with current scheme (progress, seed: see BaseSchemeService.performance_test)."""
         service = self.get_current_service()
-        result = service.performance_test(iterations)
+        result = service.performance_test(iterations, progress, seed)
         result["scheme"] = self.current_scheme
         return result
 
+    def benchmark(self, progress=None, **options) -> Dict[str, Any]:
+        """Run the configurable benchmark with current scheme (options: see BaseSchemeService.benchmark)."""
+        service = self.get_current_service()
+        result = service.benchmark(progress=progress, **options)
+        result["scheme"] = self.current_scheme
+        return result
+
+    def latency_stats(self) -> Dict[str, Any]:
+        """Latency percentiles of the current scheme's operations (see BaseSchemeService.latency_stats)."""
+        service = self.get_current_service()
+        return {"scheme": self.current_scheme, "latency": service.latency_stats()}
+
 
 # Global scheme manager instance
 scheme_manager = SchemeManager()
\ No newline at end of file
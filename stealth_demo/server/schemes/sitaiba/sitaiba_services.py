@@ -3,11 +3,12 @@ Cryptographic services module for SITAIBA operations.
 Hangles key generation, address operations, DSK generation, recognition, and tracing.
 Note: SITAIBA scheme does not support message signing/verification.
 """
-from typing import Dict, Optional
+import time
+from typing import Dict, List, Optional
 from .sitaiba_wrapper import get_sitaiba_lib
 from ...multi_scheme_config import config
 from ...common.base_utils import hex_to_bytes_safe, validate_index
-from ...common.scheme_utils import get_element_size, create_buffer, create_multiple_buffers, bytes_to_hex_safe_fixed, find_matching_key
+from ...common.scheme_utils import get_element_size, create_buffer, create_multiple_buffers, bytes_to_hex_safe_fixed, find_matching_key, describe_key
 from ...common.base_services import BaseSchemeService # Import the base class
 from ctypes import c_double # For performance test results array
 
@@ -54,7 +55,11 @@ class SitaibaServices(BaseSchemeService):
 
     def _call_c_addr_gen(self, A_r_bytes, B_r_bytes, A_m_bytes, addr_buf, r1_buf, r2_buf, buf_size: int):
         sitaiba_lib = self._get_lib()
+        if sitaiba_lib.view_tag_available:
+            tag = sitaiba_lib.addr_gen_tagged(A_r_bytes, B_r_bytes, A_m_bytes, addr_buf, r1_buf, r2_buf, buf_size)
+            return {"view_tag_hex": tag.hex()}
         sitaiba_lib.addr_gen(A_r_bytes, B_r_bytes, A_m_bytes, addr_buf, r1_buf, r2_buf, buf_size)
+        return None
 
     def _call_c_recognize_address(self, address_data: Dict, key_data: Dict, fast: bool = True) -> bool:
         r1_bytes = hex_to_bytes_safe(address_data['r1_hex'])
@@ -64,7 +69,11 @@ class SitaibaServices(BaseSchemeService):
 
         sitaiba_lib = self._get_lib()
 
-        if fast:
+        tag_hex = address_data.get('view_tag_hex') if sitaiba_lib.view_tag_available else None
+        if fast and tag_hex:
+            result = sitaiba_lib.addr_recognize_fast_tagged(r1_bytes, r2_bytes, A_r_bytes,
+                                                            bytes.fromhex(tag_hex), a_r_bytes)
+        elif fast:
             result = sitaiba_lib.addr_recognize_fast(r1_bytes, r2_bytes, A_r_bytes, a_r_bytes)
         else:
             addr_bytes = hex_to_bytes_safe(address_data['addr_hex'])
@@ -87,7 +96,12 @@ class SitaibaServices(BaseSchemeService):
         dsk_buf = create_buffer(buf_size)
 
         sitaiba_lib = self._get_lib()
-        sitaiba_lib.onetime_skgen(r1_bytes, a_r_bytes, b_r_bytes, A_m_bytes, dsk_buf, buf_size)
+        tag_hex = address_data.get('view_tag_hex') if sitaiba_lib.view_tag_available else None
+        # An owned output gets its DSK from the R1^a and H1 of recognition
+        if not (sitaiba_lib.recognize_derive_available and sitaiba_lib.recognize_and_derive(
+                r1_bytes, hex_to_bytes_safe(address_data['r2_hex']), hex_to_bytes_safe(key_data['A_hex']),
+                bytes.fromhex(tag_hex) if tag_hex else None, a_r_bytes, b_r_bytes, A_m_bytes, dsk_buf, buf_size)):
+            sitaiba_lib.onetime_skgen(r1_bytes, a_r_bytes, b_r_bytes, A_m_bytes, dsk_buf, buf_size)
 
         dsk_hex = bytes_to_hex_safe_fixed(dsk_buf, 'Zr')
 
@@ -109,6 +123,48 @@ class SitaibaServices(BaseSchemeService):
             "status": "generated"
         }
 
+    def _generate_dsks(self, addresses: List[Dict], key_data: Dict, num_threads: int):
+        sitaiba_lib = self._get_lib()
+        if not sitaiba_lib.skgen_batch_available:
+            return super()._generate_dsks(addresses, key_data, num_threads)
+
+        began = time.perf_counter()
+        r1_list = [address_data['r1_hex'] for address_data in addresses]
+        a_r_bytes = hex_to_bytes_safe(key_data['a_hex'])
+        b_r_bytes = hex_to_bytes_safe(key_data['b_hex'])
+        A_m_bytes = hex_to_bytes_safe(config.trace_key['TK_hex'])
+        generating = time.perf_counter()
+
+        # One C call; the final exponentiations of each block run together
+        dsks = sitaiba_lib.onetime_skgen_batch(r1_list, a_r_bytes, b_r_bytes, A_m_bytes, num_threads)
+        storing = time.perf_counter()
+
+        items = []
+        for address_data, dsk in zip(addresses, dsks):
+            item = {
+                "index": len(config.dsk_list),
+                "id": f"dsk_{len(config.dsk_list)}",
+                "dsk_hex": dsk.hex(),
+                "address_index": address_data['index'],
+                "key_index": key_data['index'],
+                "address_id": address_data['id'],
+                "key_id": key_data['id'],
+                "owner_A": key_data['A_hex'],
+                "owner_B": key_data['B_hex'],
+                "for_address": address_data['addr_hex'],
+                "scheme": self._scheme_name,
+                "status": "generated"
+            }
+            config.dsk_list.append(item)
+            items.append(item)
+        done = time.perf_counter()
+
+        return items, {
+            "load": (generating - began) * 1000,
+            "generate": (storing - generating) * 1000,
+            "store": (done - storing) * 1000
+        }, "batch"
+
     def _call_c_trace_identity(self, address_data: Dict) -> Dict:
         addr_bytes = hex_to_bytes_safe(address_data['addr_hex'])
         r1_bytes = hex_to_bytes_safe(address_data['r1_hex'])
@@ -121,14 +177,22 @@ class SitaibaServices(BaseSchemeService):
         B_r_buf = create_buffer(buf_size)
 
         sitaiba_lib = self._get_lib()
-        sitaiba_lib.trace(addr_bytes, r1_bytes, r2_bytes, a_m_bytes, B_r_buf, buf_size)
+        owner = -1
+        if sitaiba_lib.registry_available:
+            # The C registry resolves the recovered B to its key index directly
+            owner = sitaiba_lib.trace_lookup(addr_bytes, r1_bytes, r2_bytes, a_m_bytes, B_r_buf, buf_size)
+        else:
+            sitaiba_lib.trace(addr_bytes, r1_bytes, r2_bytes, a_m_bytes, B_r_buf, buf_size)
 
         B_recovered_hex = bytes_to_hex_safe_fixed(B_r_buf, 'G1')
 
         if not B_recovered_hex:
             raise Exception("Failed to trace SITAIBA identity")
 
-        matched_key = find_matching_key(B_recovered_hex)
+        if 0 <= owner < len(config.key_list):
+            matched_key = describe_key(owner)
+        else:
+            matched_key = find_matching_key(B_recovered_hex)
 
         return {
             "recovered_b_hex": B_recovered_hex,
@@ -35,9 +35,7 @@ class SitaibaUtils(SchemeUtilsBase):
                 element_size = max(g1_size, zr_size)
 
             # Convert only the relevant bytes to hex string
-            hex_str = buf.raw[:element_size].hex()
-
-            return hex_str
+            return sitaiba_lib.to_hex(buf.raw[:element_size])
         except Exception as e:
             print(f"Error converting buffer to hex: {e}")
             return ""
@@ -47,16 +45,9 @@ class SitaibaUtils(SchemeUtilsBase):
         if not target_hex:
             return None
 
-        # Search through all keys to find matching B_hex
-        for key in config.key_list:
-            if key.get('B_hex') == target_hex:
-                return {
-                    "index": key['index'],
-                    "id": key['id'],
-                    "A_hex": key['A_hex'],
-                    "B_hex": key['B_hex'],
-                    "match_type": "perfect"
-                }
+        index = config.key_by_B.get(target_hex)
+        if index is not None:
+            return self.describe_key(index)
 
         # If no perfect match, try partial matching (first 10 chars)
         target_prefix = target_hex[:10] if len(target_hex) >= 10 else target_hex
@@ -72,3 +63,14 @@ class SitaibaUtils(SchemeUtilsBase):
                 }
 
         return None
+
+    def describe_key(self, index: int) -> Dict[str, Any]:
+        """Describe an exact (perfect) key match."""
+        key = config.key_list[index]
+        return {
+            "index": key['index'],
+            "id": key['id'],
+            "A_hex": key['A_hex'],
+            "B_hex": key['B_hex'],
+            "match_type": "perfect"
+        }
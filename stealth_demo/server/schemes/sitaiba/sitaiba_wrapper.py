@@ -2,8 +2,60 @@
 C Library wrapper module for SITAIBA cryptographic operations.
 Handles library loading, function signature setup, and low-level C function calls.
 """
+import glob
+import importlib.util
+import os
 from ctypes import *
-from typing import Tuple
+from typing import Dict, List, Optional, Tuple
+
+
+# Set to 1 to switch the hardware counters on at every library init
+HW_COUNTERS_ENV = "STEALTH_HW_COUNTERS"
+
+# Hot paths called through the _pbc_native extension when it is built next to
+# the library (make native), by _pbc_native signature (argument count or
+# p/w/i per argument); ctypes otherwise
+NATIVE_FUNCTIONS = (
+    ("sitaiba_addr_recognize_simple", 7),
+    ("sitaiba_addr_recognize_fast_simple", 4),
+    ("sitaiba_addr_recognize_fast_tagged_simple", 5),
+    ("sitaiba_scan_batch_simple", "pppippiw"),
+)
+
+
+def load_native_module(library_path: str):
+    """Import _pbc_native from the directory of the library, else from sys.path; None if not built."""
+    for path in sorted(glob.glob(os.path.join(os.path.dirname(os.path.abspath(library_path)), "_pbc_native*.so"))):
+        spec = importlib.util.spec_from_file_location("_pbc_native", path)
+        try:
+            module = importlib.util.module_from_spec(spec)
+            spec.loader.exec_module(module)
+            return module
+        except ImportError:
+            continue
+    try:
+        import _pbc_native
+        return _pbc_native
+    except ImportError:
+        return None
+
+
+def buffer_rows(buf, size: int, what: str):
+    """Flat byte view of a contiguous (n, size) buffer (bytes, memoryview, NumPy uint8 array) and n."""
+    view = memoryview(buf).cast("B")
+    if size <= 0 or len(view) % size:
+        raise ValueError(f"{what}: {len(view)} bytes is not a whole number of {size}-byte rows")
+    return view, len(view) // size
+
+
+def _hex_element(hex_str: str) -> bytes:
+    """Bytes of one element's hex string, an odd length taking a leading 0."""
+    if not hex_str:
+        raise ValueError("Empty hex string")
+    try:
+        return bytes.fromhex("0" + hex_str if len(hex_str) % 2 else hex_str)
+    except ValueError as e:
+        raise ValueError(f"Invalid hex string '{hex_str}': {e}")
 
 
 class SitaibaLibrary:
@@ -11,6 +63,24 @@ class SitaibaLibrary:
     
     def __init__(self, library_path="/mnt/c/Users/chen1/Desktop/master/thesis/nccu/new/code/stealth_demo/lib/libsitaiba.so"):
         self.lib = None
+        self.point_format_available = False
+        self.view_tag_available = False
+        self.recognize_derive_available = False
+        self.registry_available = False
+        self.store_available = False
+        self.metrics_available = False
+        self.latency_available = False
+        self.seed_available = False
+        self.hw_counters_available = False
+        self.audit_available = False
+        self.cache_stats_available = False
+        self.hex_available = False
+        self.native_available = False
+        self._fn = {}
+        self._native_bound = set()
+        self._hex_codec = None
+        self.hw_counters = ()
+        self.library_path = library_path
         self.load_library(library_path)
         self.setup_function_signatures()
     
@@ -71,10 +141,295 @@ class SitaibaLibrary:
         # Performance testing
         self.lib.sitaiba_performance_test_simple.argtypes = [c_int, POINTER(c_double)]
         self.lib.sitaiba_performance_test_simple.restype = None
+        
+        # Try to load wire format selection
+        self._setup_point_format_functions()
+        
+        # Try to load view tag functions
+        self._setup_view_tag_functions()
+        
+        # Try to load the batch scanner
+        self._setup_batch_functions()
+
+        # Try to load the batch address audit
+        self._setup_audit_functions()
+        
+        # Try to load combined recognition and DSK generation
+        self._setup_recognize_derive_functions()
+        
+        # Try to load the key registry
+        self._setup_registry_functions()
+        
+        # Try to load the record store
+        self._setup_store_functions()
+        
+        # Try to load the primitive counters
+        self._setup_metrics_functions()
+        
+        # Try to load the latency histograms
+        self._setup_latency_functions()
+        
+        # Try to load seeded random mode
+        self._setup_seed_functions()
+        
+        # Try to load the hardware counters
+        self._setup_hw_counter_functions()
+        
+        # Try to load the cache hit counters
+        self._setup_cache_stats_functions()
+        
+        # Try to load the hex codec
+        self._setup_hex_functions()
+        
+        # Try to call the hot paths through the native extension
+        self._setup_native_functions()
+    
+    def _setup_native_functions(self):
+        """Bind the hot paths through _pbc_native on the loaded library, else keep them on ctypes."""
+        self._fn = {name: getattr(self.lib, name) for name, _ in NATIVE_FUNCTIONS if hasattr(self.lib, name)}
+        native = load_native_module(self.library_path)
+        if native is None:
+            print("⚠️ _pbc_native not built - hot paths go through ctypes")
+            self.native_available = False
+            return
+        for name, signature in NATIVE_FUNCTIONS:
+            try:
+                self._fn[name] = native.bind(self.lib._handle, name, signature)
+                self._native_bound.add(name)
+            except AttributeError:
+                pass
+        if self.hex_available:
+            try:
+                self._hex_codec = native.bind_hex(self.lib._handle, "sitaiba")
+            except AttributeError:
+                pass
+        self.native_available = True
+    
+    def _call_buffers(self, name: str, *args):
+        """Call a batch function of NATIVE_FUNCTIONS on buffers, without copies through _pbc_native.
+        On ctypes, writable buffers are passed in place and read-only ones other than bytes copied."""
+        if name not in self._native_bound:
+            signature = dict(NATIVE_FUNCTIONS)[name]
+            args = [self._ctypes_buffer(arg, kind) for arg, kind in zip(args, signature)]
+        return self._fn[name](*args)
+    
+    @staticmethod
+    def _ctypes_buffer(arg, kind: str):
+        if kind == "i" or arg is None or isinstance(arg, bytes) or isinstance(arg, Array):
+            return arg
+        view = memoryview(arg)
+        if view.readonly:
+            if kind == "w":
+                raise TypeError("output buffer is read-only")
+            return view.tobytes()
+        return (c_char * view.nbytes).from_buffer(view)
+    
+    def _setup_hex_functions(self):
+        """Try to setup the vectorized hex codec for whole element lists."""
+        try:
+            self.lib.sitaiba_to_hex_simple.argtypes = [c_char_p, c_int, c_char_p]
+            self.lib.sitaiba_to_hex_simple.restype = c_int
+            self.lib.sitaiba_from_hex_simple.argtypes = [c_char_p, c_long, c_char_p, c_int]
+            self.lib.sitaiba_from_hex_simple.restype = c_long
+            self.lib.sitaiba_to_hex_batch_simple.argtypes = [c_char_p, c_long, c_int, c_char_p, c_char_p]
+            self.lib.sitaiba_to_hex_batch_simple.restype = c_long
+            self.lib.sitaiba_from_hex_batch_simple.argtypes = [c_char_p, c_long, c_long, c_int, c_char_p]
+            self.lib.sitaiba_from_hex_batch_simple.restype = c_long
+            self.hex_available = True
+        except AttributeError:
+            print("⚠️ Hex codec not available - converting elements to and from hex in Python")
+            self.hex_available = False
+    
+    def _setup_cache_stats_functions(self):
+        """Try to setup the hit counters of the pairing table cache and ephemeral pool."""
+        try:
+            for name in ("sitaiba_get_pp_cache_stats", "sitaiba_get_eph_pool_stats"):
+                getattr(self.lib, name).argtypes = [POINTER(c_ulong), POINTER(c_ulong)]
+                getattr(self.lib, name).restype = None
+            self.cache_stats_available = True
+        except AttributeError:
+            print("⚠️ Cache counters not available - live metrics report no cache hit rates")
+            self.cache_stats_available = False
+    
+    def _setup_hw_counter_functions(self):
+        """Try to setup the per-primitive hardware counters (cycles, IPC, misses, allocations)."""
+        try:
+            self.lib.sitaiba_set_hw_counters.argtypes = [c_int]
+            self.lib.sitaiba_set_hw_counters.restype = c_int
+            self.lib.sitaiba_primitive_hw_stats_simple.argtypes = [POINTER(c_ulong), POINTER(c_double)]
+            self.lib.sitaiba_primitive_hw_stats_simple.restype = None
+            self.hw_counters_available = True
+        except AttributeError:
+            print("⚠️ Hardware counters not available - /metrics reports times only")
+            self.hw_counters_available = False
+    
+    def _setup_seed_functions(self):
+        """Try to setup seeded random mode (reproducible benchmark runs)."""
+        try:
+            self.lib.sitaiba_set_random_seed.argtypes = [c_int, c_uint]
+            self.lib.sitaiba_set_random_seed.restype = c_int
+            self.lib.sitaiba_get_random_seeded.restype = c_int
+            self.seed_available = True
+        except AttributeError:
+            print("⚠️ Seeded random mode not available - benchmarks draw fresh randomness")
+            self.seed_available = False
+    
+    def _setup_point_format_functions(self):
+        """Try to setup G1 wire format selection (compressed points)."""
+        try:
+            self.lib.sitaiba_set_point_format_simple.argtypes = [c_int]
+            self.lib.sitaiba_set_point_format_simple.restype = c_int
+            self.lib.sitaiba_get_point_format_simple.restype = c_int
+            self.point_format_available = True
+        except AttributeError:
+            print("⚠️ Point format selection not available - using uncompressed points")
+            self.point_format_available = False
+    
+    def _setup_view_tag_functions(self):
+        """Try to setup view tag functions (prefilter for fast recognition)."""
+        try:
+            self.lib.sitaiba_view_tag_length_simple.restype = c_int
+            self.lib.sitaiba_addr_gen_tagged_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.sitaiba_addr_gen_tagged_simple.restype = None
+            self.lib.sitaiba_addr_recognize_fast_tagged_simple.argtypes = [c_char_p, c_char_p, c_char_p,
+                                                                           c_char_p, c_char_p]
+            self.lib.sitaiba_addr_recognize_fast_tagged_simple.restype = c_int
+            self.view_tag_length = self.lib.sitaiba_view_tag_length_simple()
+            self.view_tag_available = True
+        except AttributeError:
+            print("⚠️ View tag functions not available - scanning without prefilter")
+            self.view_tag_available = False
+    
+    def _setup_batch_functions(self):
+        """Try to setup the batch scanner (one ctypes call per block of outputs)."""
+        try:
+            self.lib.sitaiba_scan_batch_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_int,
+                                                           c_char_p, c_char_p, c_int, POINTER(c_int)]
+            self.lib.sitaiba_scan_batch_simple.restype = c_int
+            self.batch_functions_available = True
+        except AttributeError:
+            print("⚠️ Batch scanner not available - scanning one output at a time")
+            self.batch_functions_available = False
+        try:
+            self.lib.sitaiba_onetime_skgen_batch_simple.argtypes = [c_char_p, c_int, c_char_p, c_char_p,
+                                                                    c_char_p, c_int, c_char_p]
+            self.lib.sitaiba_onetime_skgen_batch_simple.restype = c_int
+            self.skgen_batch_available = True
+        except AttributeError:
+            print("⚠️ Batch DSK generation not available - deriving one key at a time")
+            self.skgen_batch_available = False
+
+    def _setup_audit_functions(self):
+        """Try to setup the batch address audit (randomized checks of a whole set)."""
+        try:
+            self.lib.sitaiba_addr_audit_batch_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_int,
+                                                                 c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                 c_char_p]
+            self.lib.sitaiba_addr_audit_batch_simple.restype = c_int
+            self.audit_available = True
+        except AttributeError:
+            print("⚠️ Batch address audit not available - recognizing one address at a time")
+            self.audit_available = False
+    
+    def _setup_recognize_derive_functions(self):
+        """Try to setup recognize-and-derive (DSK from the recognition intermediates)."""
+        try:
+            self.lib.sitaiba_recognize_and_derive_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                     c_char_p, c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.sitaiba_recognize_and_derive_simple.restype = c_int
+            self.recognize_derive_available = True
+        except AttributeError:
+            print("⚠️ Recognize-and-derive not available - recognizing and generating DSKs separately")
+            self.recognize_derive_available = False
+    
+    def _setup_registry_functions(self):
+        """Try to setup the C key registry (hash index from A / B to key index)."""
+        try:
+            self.lib.sitaiba_registry_add_simple.argtypes = [c_char_p, c_char_p, c_int]
+            self.lib.sitaiba_registry_add_simple.restype = c_int
+            self.lib.sitaiba_registry_find_A_simple.argtypes = [c_char_p]
+            self.lib.sitaiba_registry_find_A_simple.restype = c_int
+            self.lib.sitaiba_registry_find_B_simple.argtypes = [c_char_p]
+            self.lib.sitaiba_registry_find_B_simple.restype = c_int
+            self.lib.sitaiba_registry_count_simple.restype = c_int
+            self.lib.sitaiba_registry_clear_simple.restype = None
+            self.lib.sitaiba_trace_lookup_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.sitaiba_trace_lookup_simple.restype = c_int
+            self.registry_available = True
+        except AttributeError:
+            print("⚠️ Key registry not available - tracing falls back to key list lookup")
+            self.registry_available = False
+    
+    def _setup_store_functions(self):
+        """Try to setup the memory-mapped record store."""
+        try:
+            self.lib.sitaiba_store_open_simple.argtypes = [c_char_p, c_int]
+            self.lib.sitaiba_store_open_simple.restype = c_int
+            self.lib.sitaiba_store_append_simple.argtypes = [c_int, c_char_p, c_char_p]
+            self.lib.sitaiba_store_append_simple.restype = c_long
+            self.lib.sitaiba_store_get_simple.argtypes = [c_int, c_long, c_char_p, c_char_p]
+            self.lib.sitaiba_store_get_simple.restype = c_int
+            self.lib.sitaiba_store_count_simple.argtypes = [c_int]
+            self.lib.sitaiba_store_count_simple.restype = c_long
+            self.lib.sitaiba_store_reset_simple.argtypes = [c_int]
+            self.lib.sitaiba_store_reset_simple.restype = c_int
+            self.lib.sitaiba_store_sync_simple.argtypes = [c_int]
+            self.lib.sitaiba_store_sync_simple.restype = c_int
+            self.lib.sitaiba_store_close_simple.argtypes = [c_int]
+            self.lib.sitaiba_store_close_simple.restype = None
+            self.lib.sitaiba_store_save_system_simple.argtypes = [c_int, c_char_p, c_char_p]
+            self.lib.sitaiba_store_save_system_simple.restype = c_int
+            self.lib.sitaiba_store_load_system_simple.argtypes = [c_int, c_char_p, c_char_p, c_int]
+            self.lib.sitaiba_store_load_system_simple.restype = c_int
+            self.lib.sitaiba_store_recognize_fast_simple.argtypes = [c_int, c_long, c_int, c_long]
+            self.lib.sitaiba_store_recognize_fast_simple.restype = c_int
+            self.lib.sitaiba_store_scan_simple.argtypes = [c_int, c_long, c_long, c_int, c_long, c_char_p]
+            self.lib.sitaiba_store_scan_simple.restype = c_long
+            self.lib.sitaiba_store_registry_load_simple.argtypes = [c_int]
+            self.lib.sitaiba_store_registry_load_simple.restype = c_long
+            self.store_available = True
+        except AttributeError:
+            print("⚠️ Record store not available - data is kept in memory only")
+            self.store_available = False
+    
+    def _setup_metrics_functions(self):
+        """Try to setup the per-primitive counters (pairings, pows, hashes, serialization)."""
+        try:
+            self.lib.sitaiba_primitive_stats_simple.argtypes = [POINTER(c_ulong), POINTER(c_double)]
+            self.lib.sitaiba_primitive_stats_simple.restype = None
+            self.lib.sitaiba_reset_primitive_stats_simple.restype = None
+            self.metrics_available = True
+        except AttributeError:
+            print("⚠️ Primitive counters not available - /metrics reports no primitives")
+            self.metrics_available = False
+    
+    def _setup_latency_functions(self):
+        """Try to setup the per-operation latency histograms."""
+        try:
+            self.lib.sitaiba_latency_histogram_simple.argtypes = [c_int, POINTER(c_ulong), c_int, POINTER(c_double)]
+            self.lib.sitaiba_latency_histogram_simple.restype = c_long
+            self.lib.sitaiba_latency_bounds_simple.argtypes = [POINTER(c_double), c_int]
+            self.lib.sitaiba_latency_bounds_simple.restype = c_int
+            n = self.lib.sitaiba_latency_bounds_simple(None, 0)
+            bounds = (c_double * n)()
+            self.lib.sitaiba_latency_bounds_simple(bounds, n)
+            self._latency_bounds = tuple(bounds)
+            self.latency_available = True
+        except AttributeError:
+            print("⚠️ Latency histograms not available - performance tests report averages only")
+            self.latency_available = False
     
     def init(self, param_file_path: str) -> int:
         """Initialize the library with parameter file."""
-        return self.lib.sitaiba_init_simple(param_file_path.encode())
+        if self.registry_available:
+            # Registry entries belong to the previous pairing
+            self.lib.sitaiba_registry_clear_simple()
+        result = self.lib.sitaiba_init_simple(param_file_path.encode())
+        if result == 0 and self.hw_counters_available and os.environ.get(HW_COUNTERS_ENV) == "1":
+            # After init, so that the allocation count sits over the pool
+            self.set_hw_counters(True)
+        return result
     
     def is_initialized(self) -> bool:
         """Check if library is initialized."""
@@ -88,10 +443,157 @@ class SitaibaLibrary:
         """Reset performance counters."""
         self.lib.sitaiba_reset_performance_simple()
     
+    # Order of the counters in each row filled by sitaiba_primitive_hw_stats_simple
+    HW_COUNTERS = ("cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "allocs")
+    
+    def set_hw_counters(self, enabled: bool) -> Tuple[str, ...]:
+        """Switch the per-primitive hardware counters on or off; returns the
+        counters this host can read (no CPU counters in most VMs), also kept
+        in hw_counters."""
+        if not self.hw_counters_available:
+            return ()
+        mask = self.lib.sitaiba_set_hw_counters(int(enabled))
+        self.hw_counters = tuple(name for i, name in enumerate(self.HW_COUNTERS) if mask & (1 << i))
+        return self.hw_counters
+    
+    # Cache name reported by cache_stats, and its counter function
+    CACHE_STATS = (("pairing_pp", "sitaiba_get_pp_cache_stats"),
+                   ("precompute", "sitaiba_get_eph_pool_stats"))
+    
+    def cache_stats(self) -> Dict[str, Dict[str, int]]:
+        """Hits and misses of every cache since init: pairing tables and the pool of precomputed ephemerals."""
+        stats = {}
+        for cache, name in self.CACHE_STATS:
+            hits, misses = c_ulong(), c_ulong()
+            getattr(self.lib, name)(byref(hits), byref(misses))
+            stats[cache] = {"hits": hits.value, "misses": misses.value}
+        return stats
+    
+    def primitive_hw_stats(self) -> Dict[str, Tuple[int, Dict[str, float]]]:
+        """Per-primitive (calls measured, counter totals) while the counters were on."""
+        n = len(self.PRIMITIVES)
+        width = len(self.HW_COUNTERS)
+        counts = (c_ulong * n)()
+        totals = (c_double * (n * width))()
+        self.lib.sitaiba_primitive_hw_stats_simple(counts, totals)
+        return {name: (counts[i], dict(zip(self.HW_COUNTERS, totals[i * width:(i + 1) * width])))
+                for i, name in enumerate(self.PRIMITIVES)}
+    
+    def set_random_seed(self, seed: Optional[int]) -> bool:
+        """Draw randomness on the calling thread from a source seeded with seed;
+        None goes back to the OS source."""
+        if not self.seed_available:
+            return seed is None
+        if seed is None:
+            return self.lib.sitaiba_set_random_seed(0, 0) == 0
+        return self.lib.sitaiba_set_random_seed(1, seed) == 0
+    
+    # Order of the counter arrays filled by sitaiba_primitive_stats_simple
+    PRIMITIVES = ("pairing", "g1_pow", "gt_pow", "hash_zr", "hash_g1", "serialize")
+    
+    def primitive_stats(self) -> Dict[str, Tuple[int, float]]:
+        """Per-primitive (call count, total ms) since load, summed over threads."""
+        n = len(self.PRIMITIVES)
+        counts = (c_ulong * n)()
+        total_ms = (c_double * n)()
+        self.lib.sitaiba_primitive_stats_simple(counts, total_ms)
+        return {name: (counts[i], total_ms[i]) for i, name in enumerate(self.PRIMITIVES)}
+    
+    def reset_primitive_stats(self):
+        """Zero the per-primitive counters."""
+        self.lib.sitaiba_reset_primitive_stats_simple()
+    
+    # Operations with a latency histogram, in sitaiba_performance_t order
+    LATENCY_OPS = ("addr_gen", "addr_recognize", "fast_recognize", "onetime_sk", "trace")
+    
+    @property
+    def latency_bounds(self) -> Tuple[float, ...]:
+        """Upper bound in ms of each histogram bucket."""
+        return self._latency_bounds
+    
+    def latency_histograms(self) -> Dict[str, Tuple[Dict[int, int], float]]:
+        """Per-operation ({bucket: count}, max ms) since the last performance reset."""
+        n = len(self._latency_bounds)
+        counts = (c_ulong * n)()
+        max_ms = c_double()
+        snapshot = {}
+        for op, name in enumerate(self.LATENCY_OPS):
+            if self.lib.sitaiba_latency_histogram_simple(op, counts, n, byref(max_ms)) < 0:
+                continue
+            snapshot[name] = ({i: c for i, c in enumerate(counts) if c}, max_ms.value)
+        return snapshot
+    
     def get_element_sizes(self) -> Tuple[int, int]:
         """Get element sizes for G1 and Zr groups."""
         return self.lib.sitaiba_element_size_G1_simple(), self.lib.sitaiba_element_size_Zr_simple()
     
+    # Hex of elements, whole lists converted in one call
+    def to_hex(self, data, empty_if_zero: bool = False) -> str:
+        """Lowercase hex of data; "" for all-zero data if empty_if_zero."""
+        if self._hex_codec is not None and len(data):
+            return self._hex_codec.encode(data, len(data), empty_if_zero)[0]
+        # For one element a ctypes call costs more than bytes.hex()
+        data = bytes(data)
+        return "" if empty_if_zero and not any(data) else data.hex()
+    
+    def to_hex_list(self, packed, size: int, empty_if_zero: bool = False) -> List[str]:
+        """Hex of each size-byte element of packed (bytes holding them end to end)."""
+        if self._hex_codec is not None and size > 0:
+            return self._hex_codec.encode(packed, size, empty_if_zero)
+        n = len(packed) // size if size > 0 else 0
+        if not self.hex_available or n == 0:
+            hexes = [packed[i * size:(i + 1) * size].hex() for i in range(n)]
+            return ["" if empty_if_zero and not h.strip("0") else h for h in hexes]
+        # Comma-separated so that one split makes the strings
+        out = bytearray((2 * size + 1) * n - 1)
+        zero = bytearray(n) if empty_if_zero else None
+        zeros = self.lib.sitaiba_to_hex_batch_simple(bytes(packed), n, size, (c_char * len(out)).from_buffer(out),
+                                                     (c_char * n).from_buffer(zero) if zero is not None else None)
+        hexes = out.decode("ascii").split(",")
+        if empty_if_zero and zeros:
+            hexes = ["" if z else h for h, z in zip(hexes, zero)]
+        return hexes
+    
+    def from_hex_list(self, hex_list, size: int) -> bytes:
+        """Packed elements of size bytes from their hex strings (an odd length takes a
+        leading 0, each zero padded to size); raises ValueError on an empty or bad string."""
+        if self._hex_codec is not None:
+            return self._hex_codec.decode(hex_list, size)
+        n = len(hex_list)
+        if not self.hex_available:
+            return b"".join(_hex_element(h)[:size].ljust(size, b"\0") for h in hex_list)
+        text = ",".join(hex_list).encode("ascii", "replace")
+        out = create_string_buffer(n * size)
+        if self.lib.sitaiba_from_hex_batch_simple(text, len(text), n, size, out):
+            # Name the offending string as the Python conversion would
+            for h in hex_list:
+                _hex_element(h)
+            raise ValueError("Invalid hex string in list")
+        return out.raw
+    
+    def _pack(self, items, size: int) -> bytes:
+        """Elements end to end from a list of their bytes or hex strings."""
+        if items and isinstance(items[0], str):
+            return self.from_hex_list(items, size)
+        return b"".join(bytes(x[:size]).ljust(size, b"\0") for x in items)
+    
+    POINT_FORMATS = {"uncompressed": 0, "compressed": 1}
+    
+    def set_point_format(self, name: str) -> bool:
+        """Select the G1 wire format; every G1 buffer and size follows it."""
+        if name not in self.POINT_FORMATS:
+            raise ValueError(f"Unknown point format: {name}")
+        if not self.point_format_available:
+            return name == "uncompressed"
+        return self.lib.sitaiba_set_point_format_simple(self.POINT_FORMATS[name]) == 0
+    
+    def get_point_format(self) -> str:
+        """Get the current G1 wire format name."""
+        if not self.point_format_available:
+            return "uncompressed"
+        code = self.lib.sitaiba_get_point_format_simple()
+        return next(k for k, v in self.POINT_FORMATS.items() if v == code)
+    
     def keygen(self, A_buf, B_buf, a_buf, b_buf, buf_size: int):
         """Generate user key pair (A, B, a, b)."""
         self.lib.sitaiba_keygen_simple(A_buf, B_buf, a_buf, b_buf, buf_size)
@@ -108,22 +610,220 @@ class SitaibaLibrary:
         """Generate SITAIBA address."""
         self.lib.sitaiba_addr_gen_simple(A_r_buf, B_r_buf, A_m_buf, addr_buf, r1_buf, r2_buf, buf_size)
     
+    def addr_gen_tagged(self, A_r_buf, B_r_buf, A_m_buf, addr_buf, r1_buf, r2_buf, buf_size: int) -> bytes:
+        """Generate SITAIBA address; returns its view tag."""
+        tag_buf = create_string_buffer(self.view_tag_length)
+        self.lib.sitaiba_addr_gen_tagged_simple(A_r_buf, B_r_buf, A_m_buf, addr_buf, r1_buf, r2_buf,
+                                                tag_buf, buf_size)
+        return tag_buf.raw
+    
+    def addr_recognize_fast_tagged(self, r1_buf, r2_buf, A_r_buf, tag_bytes, a_r_buf) -> bool:
+        """Recognize SITAIBA address (fast version) with view tag prefilter."""
+        return bool(self._fn["sitaiba_addr_recognize_fast_tagged_simple"](r1_buf, r2_buf, A_r_buf,
+                                                                          tag_bytes, a_r_buf))
+    
+    def scan_batch(self, r1_list, r2_list, A_r_bytes, a_r_bytes, tag_list=None, num_threads: int = 0):
+        """Fast recognition of many outputs for one wallet; returns the indices of owned outputs."""
+        n = len(r1_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        tags = b"".join(bytes(t[:self.view_tag_length]) for t in tag_list) if tag_list is not None else None
+        owned = (c_int * n)()
+        found = self.lib.sitaiba_scan_batch_simple(self._pack(r1_list, g1), self._pack(r2_list, g1), tags, n,
+                                                   A_r_bytes, a_r_bytes, num_threads, owned)
+        if found < 0:
+            raise RuntimeError("sitaiba_scan_batch_simple failed")
+        return list(owned[:found])
+    
+    def scan_buffer(self, r1s, r2s, A_r_bytes, a_r_bytes, tags=None, num_threads: int = 0, out=None):
+        """Fast recognition of n outputs given as contiguous (n, G1 size) buffers, the view
+        tags as an (n, tag length) buffer or None. Writes one 0/1 byte per output into out
+        (a writable buffer of n bytes, new bytearray if None)."""
+        g1, _ = self.get_element_sizes()
+        r1s, n = buffer_rows(r1s, g1, "r1s")
+        r2s, n_r2 = buffer_rows(r2s, g1, "r2s")
+        if n_r2 != n or (tags is not None and buffer_rows(tags, self.view_tag_length, "tags")[1] != n):
+            raise ValueError("r1s, r2s and tags differ in length")
+        out = bytearray(n) if out is None else out
+        if n == 0:
+            return out
+        flags = buffer_rows(out, n, "out")[0]
+        flags[:] = bytes(n)
+        owned = (c_int * n)()
+        found = self._call_buffers("sitaiba_scan_batch_simple", r1s, r2s,
+                                   None if tags is None else memoryview(tags).cast("B"), n,
+                                   A_r_bytes, a_r_bytes, num_threads, owned)
+        if found < 0:
+            raise RuntimeError("sitaiba_scan_batch_simple failed")
+        for i in owned[:found]:
+            flags[i] = 1
+        return out
+    
+    def addr_audit_batch(self, addr_list, r1_list, r2_list, A_r_bytes, B_r_bytes, a_r_bytes,
+                         A_m_bytes=None):
+        """Full recognition of many addresses of one user; returns a list of bools."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        pack = lambda items: b"".join(bytes(x[:g1]).ljust(g1, b"\0") for x in items)
+        results = create_string_buffer(n)
+        if self.lib.sitaiba_addr_audit_batch_simple(pack(addr_list), pack(r1_list), pack(r2_list), n,
+                                                    A_r_bytes, B_r_bytes, a_r_bytes, A_m_bytes,
+                                                    results) < 0:
+            raise RuntimeError("sitaiba_addr_audit_batch_simple failed")
+        return [bool(x) for x in results.raw[:n]]
+    
     def addr_recognize(self, addr_buf, r1_buf, r2_buf, A_r_buf, B_r_buf, a_r_buf, A_m_buf) -> bool:
         """Recognize SITAIBA address (full version)."""
-        return bool(self.lib.sitaiba_addr_recognize_simple(addr_buf, r1_buf, r2_buf, A_r_buf, B_r_buf, a_r_buf, A_m_buf))
+        return bool(self._fn["sitaiba_addr_recognize_simple"](addr_buf, r1_buf, r2_buf, A_r_buf, B_r_buf,
+                                                              a_r_buf, A_m_buf))
     
     def addr_recognize_fast(self, r1_buf, r2_buf, A_r_buf, a_r_buf) -> bool:
         """Recognize SITAIBA address (fast version)."""
-        return bool(self.lib.sitaiba_addr_recognize_fast_simple(r1_buf, r2_buf, A_r_buf, a_r_buf))
+        return bool(self._fn["sitaiba_addr_recognize_fast_simple"](r1_buf, r2_buf, A_r_buf, a_r_buf))
     
     def onetime_skgen(self, r1_buf, a_r_buf, b_r_buf, A_m_buf, dsk_buf, buf_size: int):
         """Generate one-time secret key."""
         self.lib.sitaiba_onetime_skgen_simple(r1_buf, a_r_buf, b_r_buf, A_m_buf, dsk_buf, buf_size)
     
+    def onetime_skgen_batch(self, r1_list, a_r_bytes, b_r_bytes, A_m_bytes=None, num_threads: int = 0):
+        """One-time secret keys of many outputs of one user; returns a list of Zr bytes.
+        A_m_bytes None uses the tracer key."""
+        n = len(r1_list)
+        if n == 0:
+            return []
+        g1, zr = self.get_element_sizes()
+        dsk = create_string_buffer(n * zr)
+        if self.lib.sitaiba_onetime_skgen_batch_simple(self._pack(r1_list, g1), n, a_r_bytes, b_r_bytes,
+                                                       A_m_bytes, num_threads, dsk) < 0:
+            raise RuntimeError("sitaiba_onetime_skgen_batch_simple failed")
+        return [dsk.raw[i * zr:(i + 1) * zr] for i in range(n)]
+    
+    def recognize_and_derive(self, r1_buf, r2_buf, A_r_buf, tag_bytes, a_r_buf, b_r_buf, A_m_buf,
+                             dsk_buf, buf_size: int) -> bool:
+        """Fast recognition; fills dsk_buf with the one-time secret key if the output is owned."""
+        return bool(self.lib.sitaiba_recognize_and_derive_simple(r1_buf, r2_buf, A_r_buf, tag_bytes, a_r_buf,
+                                                                 b_r_buf, A_m_buf, dsk_buf, buf_size))
+    
     def trace(self, addr_buf, r1_buf, r2_buf, a_m_buf, B_r_buf, buf_size: int):
         """Trace identity from SITAIBA address."""
         self.lib.sitaiba_trace_simple(addr_buf, r1_buf, r2_buf, a_m_buf, B_r_buf, buf_size)
     
+    def trace_lookup(self, addr_buf, r1_buf, r2_buf, a_m_buf, B_r_buf, buf_size: int) -> int:
+        """Trace identity; returns the registry id of the owner (-1 if unregistered)."""
+        return self.lib.sitaiba_trace_lookup_simple(addr_buf, r1_buf, r2_buf, a_m_buf, B_r_buf, buf_size)
+    
+    def registry_add(self, A_bytes, B_bytes, key_id: int) -> bool:
+        """Register a key pair in the C hash index."""
+        return self.lib.sitaiba_registry_add_simple(A_bytes, B_bytes, key_id) == 0
+    
+    def registry_find_A(self, A_bytes) -> int:
+        """Look up a key id by public key A (-1 if unknown)."""
+        return self.lib.sitaiba_registry_find_A_simple(A_bytes)
+    
+    def registry_find_B(self, B_bytes) -> int:
+        """Look up a key id by public key B (-1 if unknown)."""
+        return self.lib.sitaiba_registry_find_B_simple(B_bytes)
+    
+    def registry_count(self) -> int:
+        """Number of registered key pairs."""
+        return self.lib.sitaiba_registry_count_simple()
+    
+    # Record store interface. Kinds and element layouts mirror
+    # sitaiba_python_api.h; elements are raw wire bytes.
+    STORE_KEYS, STORE_ADDRS, STORE_DSKS, STORE_SYSTEM = 1, 2, 3, 4
+    STORE_LAYOUTS = {1: "GGZZ", 2: "GGG", 3: "Z", 4: "GGZ"}
+    STORE_FLAG_TAGGED = 1
+    
+    def store_meta_size(self, kind: int) -> int:
+        """Bytes of the metadata trailer of a record kind."""
+        if kind == self.STORE_ADDRS:
+            return 4 + 1 + self.view_tag_length
+        return 4 + 4 + 1 if kind == self.STORE_DSKS else 0
+    
+    def _store_sizes(self, kind: int):
+        g1, zr = self.get_element_sizes()
+        return [g1 if t == "G" else zr for t in self.STORE_LAYOUTS[kind]]
+    
+    def store_open(self, path: str, kind: int) -> int:
+        """Open (or create) a store file; returns its handle."""
+        h = self.lib.sitaiba_store_open_simple(path.encode(), kind)
+        if h == -2:
+            raise ValueError(f"Store {path} was written with another parameter set or record layout")
+        if h < 0:
+            raise RuntimeError(f"Cannot open store {path}")
+        return h
+    
+    def store_append(self, h: int, kind: int, elems, meta: bytes = b"") -> int:
+        """Append one record; returns its index."""
+        packed = b"".join(bytes(e[:n]).ljust(n, b"\0") for e, n in zip(elems, self._store_sizes(kind)))
+        meta = meta.ljust(self.store_meta_size(kind), b"\0")
+        index = self.lib.sitaiba_store_append_simple(h, packed, meta or None)
+        if index < 0:
+            raise RuntimeError("sitaiba_store_append_simple failed")
+        return index
+    
+    def store_get(self, h: int, kind: int, index: int):
+        """Read one record back; returns (elements, metadata bytes)."""
+        sizes = self._store_sizes(kind)
+        elems_buf = create_string_buffer(sum(sizes))
+        meta_buf = create_string_buffer(max(self.store_meta_size(kind), 1))
+        if self.lib.sitaiba_store_get_simple(h, index, elems_buf, meta_buf) != 0:
+            raise IndexError(f"store record {index} out of range")
+        raw, elems, off = elems_buf.raw, [], 0
+        for n in sizes:
+            elems.append(raw[off:off + n])
+            off += n
+        return elems, meta_buf.raw[:self.store_meta_size(kind)]
+    
+    def store_count(self, h: int) -> int:
+        """Number of records in a store."""
+        return self.lib.sitaiba_store_count_simple(h)
+    
+    def store_reset(self, h: int):
+        """Drop every record of a store."""
+        self.lib.sitaiba_store_reset_simple(h)
+    
+    def store_sync(self, h: int):
+        """Flush a store to disk."""
+        self.lib.sitaiba_store_sync_simple(h)
+    
+    def store_close(self, h: int):
+        """Close a store."""
+        self.lib.sitaiba_store_close_simple(h)
+    
+    def store_save_system(self, h: int, A_m_bytes, a_m_bytes) -> bool:
+        """Save the session generator and tracer key pair."""
+        return self.lib.sitaiba_store_save_system_simple(h, A_m_bytes, a_m_bytes) == 0
+    
+    def store_load_system(self, h: int):
+        """Restore a saved generator; returns the saved (A_m, a_m) bytes, None if none is saved."""
+        g1, zr = self.get_element_sizes()
+        A_m_buf, a_m_buf = create_string_buffer(max(g1, zr)), create_string_buffer(max(g1, zr))
+        rc = self.lib.sitaiba_store_load_system_simple(h, A_m_buf, a_m_buf, max(g1, zr))
+        if rc < 0:
+            raise RuntimeError("sitaiba_store_load_system_simple failed")
+        return (A_m_buf.raw[:g1], a_m_buf.raw[:zr]) if rc == 1 else None
+    
+    def store_recognize_fast(self, addr_h: int, addr_index: int, key_h: int, key_index: int) -> bool:
+        """Fast recognition of a stored address with a stored key."""
+        return self.lib.sitaiba_store_recognize_fast_simple(addr_h, addr_index, key_h, key_index) == 1
+    
+    def store_scan(self, addr_h: int, start: int, n: int, key_h: int, key_index: int):
+        """Scan n stored addresses from start for one stored key; returns one bool per address."""
+        if n <= 0:
+            return []
+        results = create_string_buffer(n)
+        if self.lib.sitaiba_store_scan_simple(addr_h, start, n, key_h, key_index, results) < 0:
+            raise RuntimeError("sitaiba_store_scan_simple failed")
+        return [b == 1 for b in results.raw]
+    
+    def store_registry_load(self, key_h: int) -> int:
+        """Rebuild the key registry from a key store; returns the number of keys."""
+        return self.lib.sitaiba_store_registry_load_simple(key_h)
+    
     def performance_test(self, iterations: int, results):
         """Run performance test."""
         self.lib.sitaiba_performance_test_simple(iterations, results)
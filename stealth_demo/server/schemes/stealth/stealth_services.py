@@ -2,12 +2,13 @@
 Cryptographic services module for stealth operations.
 Hangles key generation, address operations, signing, verification, and tracing.
 """
-from typing import Dict, Optional
+import time
+from typing import Dict, List, Optional
 from .stealth_wrapper import get_stealth_lib
 from ...multi_scheme_config import config
 from ...common.base_utils import hex_to_bytes_safe, validate_index
-from ...common.scheme_utils import get_element_size, create_buffer, create_multiple_buffers, bytes_to_hex_safe_fixed, find_matching_key
-from ...common.base_services import BaseSchemeService # Import the base class
+from ...common.scheme_utils import get_element_size, create_buffer, create_multiple_buffers, bytes_to_hex_safe_fixed, find_matching_key, describe_key
+from ...common.base_services import BaseSchemeService, scheme_method # Import the base class
 from ctypes import c_double # For performance test results array
 
 
@@ -19,6 +20,10 @@ def _get_lib():
 class StealthServices(BaseSchemeService):
     """High-level cryptographic operations."""
 
+    _store_address_fields = ('addr_hex', 'r1_hex', 'r2_hex', 'c_hex')
+    _store_dsk_methods = ('dedicated', 'fallback', 'recognized')
+    _r2_element_type = 'G2'
+
     def __init__(self):
         self._scheme_name = 'stealth' # Set it before calling super().__init__()
         super().__init__()
@@ -34,7 +39,7 @@ class StealthServices(BaseSchemeService):
 
         stealth_lib.tracekeygen(TK_buf, k_buf, buf_size)
 
-        tk_hex = bytes_to_hex_safe_fixed(TK_buf, 'G1')
+        tk_hex = bytes_to_hex_safe_fixed(TK_buf, 'G2')
         k_hex = bytes_to_hex_safe_fixed(k_buf, 'Zr')
 
         if not tk_hex or not k_hex:
@@ -56,9 +61,9 @@ class StealthServices(BaseSchemeService):
         stealth_lib.addr_gen(A_bytes, B_bytes, TK_bytes,
                            addr_buf, r1_buf, r2_buf, c_buf, buf_size)
 
+    @scheme_method
     def generate_address(self, key_index: int) -> Dict:
         """Generate stealth address with selected key."""
-        config.set_current_scheme(self._scheme_name)
         config.ensure_initialized(self._scheme_name)
         validate_index(key_index, config.key_list, "key_index")
 
@@ -79,12 +84,22 @@ class StealthServices(BaseSchemeService):
         addr_buf, r1_buf, r2_buf, c_buf = create_multiple_buffers(4, buf_size)
 
         stealth_lib = self._get_lib()
-        stealth_lib.addr_gen(A_bytes, B_bytes, TK_bytes,
-                           addr_buf, r1_buf, r2_buf, c_buf, buf_size)
+        view_tag = None
+        if stealth_lib.key_tables_available:
+            # A^r, B^r2 and e(R2, TK) from the key's precomputed tables
+            view_tag = stealth_lib.key_addr_gen(key_index, A_bytes, B_bytes,
+                                                addr_buf, r1_buf, r2_buf, c_buf, buf_size,
+                                                tagged=stealth_lib.view_tag_available)
+        elif stealth_lib.view_tag_available:
+            view_tag = stealth_lib.addr_gen_tagged(A_bytes, B_bytes, TK_bytes,
+                                                   addr_buf, r1_buf, r2_buf, c_buf, buf_size)
+        else:
+            stealth_lib.addr_gen(A_bytes, B_bytes, TK_bytes,
+                               addr_buf, r1_buf, r2_buf, c_buf, buf_size)
 
         addr_hex = bytes_to_hex_safe_fixed(addr_buf, 'G1')
         r1_hex = bytes_to_hex_safe_fixed(r1_buf, 'G1')
-        r2_hex = bytes_to_hex_safe_fixed(r2_buf, 'G1')
+        r2_hex = bytes_to_hex_safe_fixed(r2_buf, 'G2')
         c_hex = bytes_to_hex_safe_fixed(c_buf, 'G1') # Specific to Stealth
 
         if not all([addr_hex, r1_hex, r2_hex, c_hex]):
@@ -104,22 +119,144 @@ class StealthServices(BaseSchemeService):
             "scheme": self._scheme_name,
             "status": "generated"
         }
+        if view_tag is not None:
+            address_item["view_tag_hex"] = view_tag.hex()
 
         config.address_list.append(address_item)
+        self.index_new_addresses()
         return address_item
 
+    def _generate_addresses(self, owners: List[int], num_threads: int):
+        stealth_lib = self._get_lib()
+        if not stealth_lib.block_functions_available:
+            return super()._generate_addresses(owners, num_threads)
+
+        began = time.perf_counter()
+        keys = {k: config.key_list[k] for k in set(owners)}
+        # Hex strings go to and come back from the C side as whole lists
+        A_list = [keys[k]['A_hex'] for k in owners]
+        B_list = [keys[k]['B_hex'] for k in owners]
+        TK_bytes = hex_to_bytes_safe(config.trace_key['TK_hex'])
+        generating = time.perf_counter()
+
+        # One C call; the worker threads each draw from their own random source
+        addrs, r1s, r2s, cs, tags = stealth_lib.addr_gen_block(A_list, B_list, TK_bytes, num_threads,
+                                                               stealth_lib.view_tag_available, as_hex=True)
+        storing = time.perf_counter()
+
+        items = []
+        for i, key_index in enumerate(owners):
+            key = keys[key_index]
+            item = {
+                "index": len(config.address_list),
+                "id": f"addr_{len(config.address_list)}",
+                "addr_hex": addrs[i],
+                "r1_hex": r1s[i],
+                "r2_hex": r2s[i],
+                "c_hex": cs[i],
+                "key_index": key_index,
+                "key_id": key['id'],
+                "owner_A": key['A_hex'],
+                "owner_B": key['B_hex'],
+                "scheme": self._scheme_name,
+                "status": "generated"
+            }
+            if tags is not None:
+                item["view_tag_hex"] = tags[i]
+            config.address_list.append(item)
+            items.append(item)
+        done = time.perf_counter()
+
+        return items, {
+            "load": (generating - began) * 1000,
+            "generate": (storing - generating) * 1000,
+            "store": (done - storing) * 1000
+        }, "block"
+
     def _call_c_recognize_address(self, address_data: Dict, key_data: Dict, fast: bool = True) -> bool:
+        stealth_lib = self._get_lib()
+        # Tagged outputs let the C side reject foreign addresses after one exponentiation
+        tag_hex = address_data.get('view_tag_hex') if stealth_lib.view_tag_available else None
+        tag_bytes = bytes.fromhex(tag_hex) if tag_hex else None
+        if stealth_lib.key_tables_available and 'index' in key_data:
+            # B^r2' from the key's precomputed table
+            return stealth_lib.key_recognize_fast(key_data['index'],
+                                                  hex_to_bytes_safe(key_data['A_hex']),
+                                                  hex_to_bytes_safe(key_data['B_hex']),
+                                                  hex_to_bytes_safe(address_data['r1_hex']),
+                                                  hex_to_bytes_safe(address_data['c_hex']),
+                                                  tag_bytes,
+                                                  hex_to_bytes_safe(key_data['a_hex']))
+        if stealth_lib.handle_functions_available:
+            # Keys are parsed once and then reused from the C side; the
+            # address components only live for this call
+            G1, ZR = stealth_lib.HANDLE_G1, stealth_lib.HANDLE_ZR
+            components = [(address_data['r1_hex'], G1), (address_data['c_hex'], G1)]
+            if tag_bytes is not None:
+                with stealth_lib.handles([(key_data['B_hex'], G1), (key_data['a_hex'], ZR)],
+                                         components) as (B, a, R1, C):
+                    return stealth_lib.addr_recognize_fast_tagged_h(R1, B, C, tag_bytes, a)
+            with stealth_lib.handles([(key_data['B_hex'], G1), (key_data['A_hex'], G1),
+                                      (key_data['a_hex'], ZR)], components) as (B, A, a, R1, C):
+                return stealth_lib.addr_recognize_fast_h(R1, B, A, C, a)
+
         r1_bytes = hex_to_bytes_safe(address_data['r1_hex'])
         b_bytes = hex_to_bytes_safe(key_data['B_hex'])
         a_bytes = hex_to_bytes_safe(key_data['A_hex'])
         c_bytes = hex_to_bytes_safe(address_data['c_hex'])
         a_priv_bytes = hex_to_bytes_safe(key_data['a_hex'])
 
-        stealth_lib = self._get_lib()
+        if tag_bytes is not None:
+            return stealth_lib.addr_recognize_fast_tagged(r1_bytes, b_bytes, c_bytes, tag_bytes, a_priv_bytes)
+
         # Stealth only has one recognition method (fast) exposed via this API
         result = stealth_lib.addr_recognize_fast(r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes)
         return result
 
+    def _call_c_recognize_multi(self, address_data: Dict, keys: List[Dict]) -> int:
+        stealth_lib = self._get_lib()
+        if not stealth_lib.multi_recognize_available:
+            return super()._call_c_recognize_multi(address_data, keys)
+
+        tag_hex = address_data.get('view_tag_hex') if stealth_lib.view_tag_available else None
+        # One C call; the R1 window table is shared by every key
+        return stealth_lib.recognize_multi(hex_to_bytes_safe(address_data['r1_hex']),
+                                           hex_to_bytes_safe(address_data['c_hex']),
+                                           [k['a_hex'] for k in keys],
+                                           [k['B_hex'] for k in keys],
+                                           bytes.fromhex(tag_hex) if tag_hex else None)
+
+    def _scan_owners(self, start: int, count: int, key_indices: List[int], num_threads: int):
+        stealth_lib = self._get_lib()
+        if not stealth_lib.block_functions_available:
+            return super()._scan_owners(start, count, key_indices, num_threads)
+
+        began = time.perf_counter()
+        store = config.store
+        if store is not None:
+            # Both record files are read in place, the addresses split across the worker pool
+            owners = stealth_lib.store_scan_owners(store.handle('address_list'), start, count,
+                                                   store.handle('key_list'), key_indices, num_threads)
+            return owners, {"scan": (time.perf_counter() - began) * 1000}, "store"
+
+        addresses = [config.address_list[start + i] for i in range(count)]
+        keys = [config.key_list[k] for k in key_indices]
+        use_tags = stealth_lib.view_tag_available
+        tags = [bytes.fromhex(a['view_tag_hex']) if use_tags and a.get('view_tag_hex') else None
+                for a in addresses]
+        # Hex strings are decoded by the C side as whole lists
+        r1s = [a['r1_hex'] for a in addresses]
+        cs = [a['c_hex'] for a in addresses]
+        scanning = time.perf_counter()
+
+        positions = stealth_lib.recognize_multi_block(r1s, cs, [k['a_hex'] for k in keys],
+                                                      [k['B_hex'] for k in keys], tags, num_threads)
+        owners = [key_indices[p] if p >= 0 else -1 for p in positions]
+        return owners, {
+            "load": (scanning - began) * 1000,
+            "scan": (time.perf_counter() - scanning) * 1000
+        }, "list"
+
     def _call_c_generate_dsk(self, address_data: Dict, key_data: Dict) -> Dict:
         addr_bytes = hex_to_bytes_safe(address_data['addr_hex'])
         r1_bytes = hex_to_bytes_safe(address_data['r1_hex'])
@@ -130,7 +267,13 @@ class StealthServices(BaseSchemeService):
         dsk_buf = create_buffer(buf_size)
 
         stealth_lib = self._get_lib()
-        if config.get_scheme_data(self._scheme_name)['dsk_functions_available']:
+        tag_hex = address_data.get('view_tag_hex') if stealth_lib.view_tag_available else None
+        if stealth_lib.recognize_derive_available and stealth_lib.recognize_and_derive(
+                addr_bytes, r1_bytes, hex_to_bytes_safe(key_data['B_hex']), hex_to_bytes_safe(address_data['c_hex']),
+                bytes.fromhex(tag_hex) if tag_hex else None, a_bytes, b_bytes, dsk_buf, buf_size):
+            # Owned: the DSK reuses the R1^a and H1 of recognition
+            method = "recognized"
+        elif config.get_scheme_data(self._scheme_name)['dsk_functions_available']:
             stealth_lib.dsk_gen(addr_bytes, r1_bytes, a_bytes, b_bytes, dsk_buf, buf_size)
             method = "dedicated"
         else:
@@ -140,7 +283,7 @@ class StealthServices(BaseSchemeService):
                            temp_q_buf, temp_h_buf, dsk_buf, buf_size)
             method = "fallback"
 
-        dsk_hex = bytes_to_hex_safe_fixed(dsk_buf, 'G1')
+        dsk_hex = bytes_to_hex_safe_fixed(dsk_buf, 'G2')
 
         if not dsk_hex:
             raise Exception("Failed to generate DSK")
@@ -172,15 +315,24 @@ class StealthServices(BaseSchemeService):
         b_recovered_buf = create_buffer(buf_size)
 
         stealth_lib = self._get_lib()
-        stealth_lib.trace(addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes,
-                        b_recovered_buf, buf_size)
+        owner = -1
+        if stealth_lib.registry_available:
+            # The C registry resolves the recovered B to its key index directly
+            owner = stealth_lib.trace_lookup(addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes,
+                                             b_recovered_buf, buf_size)
+        else:
+            stealth_lib.trace(addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes,
+                            b_recovered_buf, buf_size)
 
         b_recovered_hex = bytes_to_hex_safe_fixed(b_recovered_buf, 'G1')
 
         if not b_recovered_hex:
             raise Exception("Failed to trace identity")
 
-        matched_key = find_matching_key(b_recovered_hex)
+        if 0 <= owner < len(config.key_list):
+            matched_key = describe_key(owner)
+        else:
+            matched_key = find_matching_key(b_recovered_hex)
 
         return {
             "recovered_b_hex": b_recovered_hex,
@@ -203,6 +355,7 @@ class StealthServices(BaseSchemeService):
         }
 
     # Override signing/verification methods as Stealth supports them
+    @scheme_method
     def sign_message(self, message: str, dsk_index: Optional[int] = None,
                     address_index: Optional[int] = None, key_index: Optional[int] = None) -> Dict:
         """Sign message with DSK or key pair."""
@@ -236,7 +389,7 @@ class StealthServices(BaseSchemeService):
         stealth_lib.sign_with_dsk(addr_bytes, dsk_bytes, message_bytes,
                                 q_sigma_buf, h_buf, buf_size)
 
-        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G1')
+        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G2')
         h_hex = bytes_to_hex_safe_fixed(h_buf, 'Zr')
 
         if not q_sigma_hex or not h_hex:
@@ -271,12 +424,17 @@ class StealthServices(BaseSchemeService):
         q_sigma_buf, h_buf, dsk_buf = create_multiple_buffers(3, buf_size)
 
         stealth_lib = self._get_lib()
-        stealth_lib.sign(addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
-                           q_sigma_buf, h_buf, dsk_buf, buf_size)
+        if stealth_lib.dsk_cache_available:
+            # The list index names the address; a reused index only misses
+            stealth_lib.sign_cached(address_index, addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
+                                    q_sigma_buf, h_buf, dsk_buf, buf_size)
+        else:
+            stealth_lib.sign(addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
+                             q_sigma_buf, h_buf, dsk_buf, buf_size)
 
-        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G1')
+        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G2')
         h_hex = bytes_to_hex_safe_fixed(h_buf, 'Zr')
-        dsk_hex = bytes_to_hex_safe_fixed(dsk_buf, 'G1')
+        dsk_hex = bytes_to_hex_safe_fixed(dsk_buf, 'G2')
 
         if not q_sigma_hex or not h_hex:
             raise Exception("Failed to sign message with key")
@@ -294,6 +452,7 @@ class StealthServices(BaseSchemeService):
             "status": "signed"
         }
 
+    @scheme_method
     def sign_with_address_and_dsk(self, message: str, address_index: int, dsk_index: int) -> Dict:
         """Sign message using specific address and DSK - allows testing of correct/incorrect matches."""
         config.ensure_initialized()
@@ -317,7 +476,7 @@ class StealthServices(BaseSchemeService):
         stealth_lib.sign_with_dsk(addr_bytes, dsk_bytes, message_bytes,
                                 q_sigma_buf, h_buf, buf_size)
 
-        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G1')
+        q_sigma_hex = bytes_to_hex_safe_fixed(q_sigma_buf, 'G2')
         h_hex = bytes_to_hex_safe_fixed(h_buf, 'Zr')
 
         if not q_sigma_hex or not h_hex:
@@ -341,6 +500,7 @@ class StealthServices(BaseSchemeService):
             "status": "signed"
         }
 
+    @scheme_method
     def verify_signature(self, message: str, q_sigma_hex: str, h_hex: str, address_index: int) -> Dict:
         """Verify signature."""
         config.ensure_initialized()
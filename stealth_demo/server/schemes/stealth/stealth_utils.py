@@ -25,6 +25,8 @@ class StealthUtils(SchemeUtilsBase):
             stealth_lib = get_stealth_lib()
             if element_type == 'G1':
                 expected_size = stealth_lib.get_element_sizes()[0]
+            elif element_type == 'G2':
+                expected_size = stealth_lib.get_g2_size()
             elif element_type == 'Zr':
                 expected_size = stealth_lib.get_element_sizes()[1]
             else:
@@ -39,18 +41,20 @@ class StealthUtils(SchemeUtilsBase):
         data = buf.raw[:expected_size]
 
         # Stealth-specific: return empty string if all zeros
-        if all(b == 0 for b in data):
-            return ""
-
-        return data.hex()
+        try:
+            return get_stealth_lib().to_hex(data, empty_if_zero=True)
+        except OSError:
+            return "" if not any(data) else data.hex()
 
     def find_matching_key(self, target_b_hex: str) -> Optional[Dict[str, Any]]:
         """Find key with matching B_hex value (stealth-specific simple matching)."""
-        for i, key in enumerate(config.key_list):
-            if key['B_hex'] == target_b_hex:
-                return {
-                    "index": i,
-                    "id": key['id'],
-                    "match": True
-                }
-        return None
+        index = config.key_by_B.get(target_b_hex)
+        return self.describe_key(index) if index is not None else None
+
+    def describe_key(self, index: int) -> Dict[str, Any]:
+        """Describe an exact key match."""
+        return {
+            "index": index,
+            "id": config.key_list[index]['id'],
+            "match": True
+        }
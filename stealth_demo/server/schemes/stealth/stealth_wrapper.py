@@ -2,8 +2,77 @@
 C Library wrapper module for stealth cryptographic operations.
 Handles library loading, function signature setup, and low-level C function calls.
 """
+import glob
+import hashlib
+import importlib.util
+import os
+import threading
+from collections import OrderedDict
+from contextlib import contextmanager
 from ctypes import *
-from typing import Tuple
+from typing import Dict, List, Optional, Tuple
+
+
+# Set to 1 to switch the hardware counters on at every library init
+HW_COUNTERS_ENV = "STEALTH_HW_COUNTERS"
+
+# "<entries>[:<ttl_ms>]" for the DSK cache of repeated signing, "0" to disable
+DSK_CACHE_ENV = "STEALTH_DSK_CACHE"
+DSK_CACHE_DEFAULT = (64, 60000.0)
+
+# Pairing tables kept for the commitments of recently verified addresses, 0 (the default) to disable
+VERIFY_PP_CACHE_ENV = "STEALTH_VERIFY_PP_CACHE"
+
+# Set to 1 to pin the batch and scan threads to CPUs, node by node on NUMA hosts
+WORKER_PINNING_ENV = "STEALTH_WORKER_PINNING"
+
+# Hot paths called through the _pbc_native extension when it is built next to
+# the library (make native), by _pbc_native signature (argument count or
+# p/w/i per argument); ctypes otherwise
+NATIVE_FUNCTIONS = (
+    ("stealth_verify_simple", 6),
+    ("stealth_addr_recognize_simple", 7),
+    ("stealth_addr_recognize_fast_simple", 5),
+    ("stealth_addr_recognize_fast_tagged_simple", 5),
+    ("stealth_addr_recognize_fast_batch", "ppippw"),
+    ("stealth_trace_batch_simple", "ppppipw"),
+    ("stealth_verify_batch", "pppppppiw"),
+)
+
+
+def load_native_module(library_path: str):
+    """Import _pbc_native from the directory of the library, else from sys.path; None if not built."""
+    for path in sorted(glob.glob(os.path.join(os.path.dirname(os.path.abspath(library_path)), "_pbc_native*.so"))):
+        spec = importlib.util.spec_from_file_location("_pbc_native", path)
+        try:
+            module = importlib.util.module_from_spec(spec)
+            spec.loader.exec_module(module)
+            return module
+        except ImportError:
+            continue
+    try:
+        import _pbc_native
+        return _pbc_native
+    except ImportError:
+        return None
+
+
+def buffer_rows(buf, size: int, what: str):
+    """Flat byte view of a contiguous (n, size) buffer (bytes, memoryview, NumPy uint8 array) and n."""
+    view = memoryview(buf).cast("B")
+    if size <= 0 or len(view) % size:
+        raise ValueError(f"{what}: {len(view)} bytes is not a whole number of {size}-byte rows")
+    return view, len(view) // size
+
+
+def _hex_element(hex_str: str) -> bytes:
+    """Bytes of one element's hex string, an odd length taking a leading 0."""
+    if not hex_str:
+        raise ValueError("Empty hex string")
+    try:
+        return bytes.fromhex("0" + hex_str if len(hex_str) % 2 else hex_str)
+    except ValueError as e:
+        raise ValueError(f"Invalid hex string '{hex_str}': {e}")
 
 
 class StealthLibrary:
@@ -12,6 +81,42 @@ class StealthLibrary:
     def __init__(self, library_path="/mnt/c/Users/chen1/Desktop/master/thesis/nccu/new/code/stealth_demo/lib/libstealth.so"):
         self.lib = None
         self.dsk_functions_available = False
+        self.handle_functions_available = False
+        self.batch_functions_available = False
+        self.point_format_available = False
+        self.view_tag_available = False
+        self.multi_recognize_available = False
+        self.ingest_available = False
+        self.recognize_derive_available = False
+        self.registry_available = False
+        self.addr_index_available = False
+        self.store_available = False
+        self.block_functions_available = False
+        self.metrics_available = False
+        self.latency_available = False
+        self.benchmark_available = False
+        self.hash_version_available = False
+        self.seed_available = False
+        self.hw_counters_available = False
+        self.hw_counters = ()
+        self.multi_output_available = False
+        self.wallet_sync_available = False
+        self.trace_index_available = False
+        self.key_tables_available = False
+        self.dsk_cache_available = False
+        self.cache_stats_available = False
+        self.hex_available = False
+        self.native_available = False
+        self._fn = {}
+        self._native_bound = set()
+        self._hex_codec = None
+        # Key handles by salted digest of their hex, so that no private key
+        # is kept as a dict key: [handle, references, generation]
+        self._handle_cache = OrderedDict()
+        self._handle_lock = threading.Lock()
+        self._handle_salt = os.urandom(16)
+        self._handle_generation = 0
+        self.library_path = library_path
         self.load_library(library_path)
         self.setup_function_signatures()
     
@@ -36,6 +141,7 @@ class StealthLibrary:
         
         self.lib.stealth_element_size_G1.restype = c_int
         self.lib.stealth_element_size_Zr.restype = c_int
+        self.lib.stealth_element_size_G2.restype = c_int
         
         self.lib.stealth_get_pairing.restype = c_void_p
         
@@ -72,6 +178,124 @@ class StealthLibrary:
         
         # Try to load DSK functions
         self._setup_dsk_functions()
+        
+        # Try to load handle-based functions
+        self._setup_handle_functions()
+        
+        # Try to load packed batch functions
+        self._setup_batch_functions()
+
+        # Try to load signature aggregation
+        self._setup_aggregate_functions()
+        
+        # Try to load wire format selection
+        self._setup_point_format_functions()
+        
+        # Try to load hash version selection
+        self._setup_hash_version_functions()
+        
+        # Try to load view tag functions
+        self._setup_view_tag_functions()
+        
+        # Try to load multi-key recognition
+        self._setup_multi_functions()
+        
+        # Try to load the ingest pipeline
+        self._setup_ingest_functions()
+        
+        # Try to load combined recognition and DSK generation
+        self._setup_recognize_derive_functions()
+        
+        # Try to load the key registry
+        self._setup_registry_functions()
+        
+        # Try to load the record store
+        self._setup_store_functions()
+        
+        # Try to load the threaded bulk functions
+        self._setup_block_functions()
+        
+        # Try to load the primitive counters
+        self._setup_metrics_functions()
+        
+        # Try to load the latency histograms
+        self._setup_latency_functions()
+        
+        # Try to load the configurable benchmark
+        self._setup_benchmark_functions()
+        
+        # Try to load seeded random mode
+        self._setup_seed_functions()
+        
+        # Try to load the hardware counters
+        self._setup_hw_counter_functions()
+        
+        # Try to load transaction generation on a shared ephemeral
+        self._setup_multi_output_functions()
+        
+        # Try to load the resumable wallet sync
+        self._setup_wallet_sync_functions()
+        
+        # Try to load the tracing index
+        self._setup_trace_index_functions()
+        
+        # Try to load the per-key precomputed contexts
+        self._setup_key_table_functions()
+        
+        # Try to load the DSK cache for repeated signing
+        self._setup_dsk_cache_functions()
+        
+        # Try to load the hit counters of the other caches
+        self._setup_cache_stats_functions()
+        
+        # Try to load the hex codec
+        self._setup_hex_functions()
+        
+        # Try to load the worker placement
+        self._setup_pinning_functions()
+        
+        # Try to call the hot paths through the native extension
+        self._setup_native_functions()
+    
+    def _setup_native_functions(self):
+        """Bind the hot paths through _pbc_native on the loaded library, else keep them on ctypes."""
+        self._fn = {name: getattr(self.lib, name) for name, _ in NATIVE_FUNCTIONS if hasattr(self.lib, name)}
+        native = load_native_module(self.library_path)
+        if native is None:
+            print("⚠️ _pbc_native not built - hot paths go through ctypes")
+            self.native_available = False
+            return
+        for name, signature in NATIVE_FUNCTIONS:
+            try:
+                self._fn[name] = native.bind(self.lib._handle, name, signature)
+                self._native_bound.add(name)
+            except AttributeError:
+                pass
+        if self.hex_available:
+            try:
+                self._hex_codec = native.bind_hex(self.lib._handle, "stealth")
+            except AttributeError:
+                pass
+        self.native_available = True
+    
+    def _call_buffers(self, name: str, *args):
+        """Call a batch function of NATIVE_FUNCTIONS on buffers, without copies through _pbc_native.
+        On ctypes, writable buffers are passed in place and read-only ones other than bytes copied."""
+        if name not in self._native_bound:
+            signature = dict(NATIVE_FUNCTIONS)[name]
+            args = [self._ctypes_buffer(arg, kind) for arg, kind in zip(args, signature)]
+        return self._fn[name](*args)
+    
+    @staticmethod
+    def _ctypes_buffer(arg, kind: str):
+        if kind == "i" or arg is None or isinstance(arg, bytes) or isinstance(arg, Array):
+            return arg
+        view = memoryview(arg)
+        if view.readonly:
+            if kind == "w":
+                raise TypeError("output buffer is read-only")
+            return view.tobytes()
+        return (c_char * view.nbytes).from_buffer(view)
     
     def _setup_dsk_functions(self):
         """Try to setup DSK functions (new functionality)."""
@@ -88,9 +312,448 @@ class StealthLibrary:
             print("⚠️ DSK functions not available - using fallback implementation")
             self.dsk_functions_available = False
     
+    def _setup_handle_functions(self):
+        """Try to setup handle-based functions (elements kept on the C side)."""
+        try:
+            self.lib.stealth_handle_import.argtypes = [c_int, c_char_p, c_int]
+            self.lib.stealth_handle_import.restype = c_int
+            self.lib.stealth_handle_export.argtypes = [c_int, c_char_p, c_int]
+            self.lib.stealth_handle_export.restype = c_int
+            self.lib.stealth_handle_free.argtypes = [c_int]
+            self.lib.stealth_handle_free.restype = c_int
+            self.lib.stealth_handle_free_all.restype = None
+            self.lib.stealth_handle_count.restype = c_int
+            
+            self.lib.stealth_addr_recognize_fast_h.argtypes = [c_int, c_int, c_int, c_int, c_int]
+            self.lib.stealth_addr_recognize_fast_h.restype = c_int
+            self.lib.stealth_dsk_gen_h.argtypes = [c_int, c_int, c_int, c_int, POINTER(c_int)]
+            self.lib.stealth_dsk_gen_h.restype = c_int
+            self.lib.stealth_sign_with_dsk_h.argtypes = [c_int, c_int, c_char_p, POINTER(c_int), POINTER(c_int)]
+            self.lib.stealth_sign_with_dsk_h.restype = c_int
+            self.lib.stealth_verify_h.argtypes = [c_int, c_int, c_int, c_char_p, c_int, c_int]
+            self.lib.stealth_verify_h.restype = c_int
+            self.lib.stealth_trace_h.argtypes = [c_int, c_int, c_int, c_int, c_int, POINTER(c_int)]
+            self.lib.stealth_trace_h.restype = c_int
+            
+            self.handle_functions_available = True
+        except AttributeError:
+            print("⚠️ Handle functions not available - using byte interface only")
+            self.handle_functions_available = False
+    
+    def _setup_batch_functions(self):
+        """Try to setup packed batch functions (one ctypes call per request)."""
+        try:
+            self.lib.stealth_addr_gen_batch.argtypes = [c_char_p, c_char_p, c_char_p, c_int,
+                                                        c_char_p, c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_addr_gen_batch.restype = c_int
+            self.lib.stealth_addr_recognize_fast_batch.argtypes = [c_char_p, c_char_p, c_int,
+                                                                   c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_addr_recognize_fast_batch.restype = c_int
+            self.lib.stealth_dsk_gen_batch.argtypes = [c_char_p, c_char_p, c_int,
+                                                       c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_dsk_gen_batch.restype = c_int
+            self.lib.stealth_verify_batch.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                      POINTER(c_int), c_char_p, c_char_p, c_int, c_char_p]
+            self.lib.stealth_verify_batch.restype = c_int
+            self.lib.stealth_trace_batch_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                            c_int, c_char_p, c_char_p]
+            self.lib.stealth_trace_batch_simple.restype = c_int
+            self.batch_functions_available = True
+        except AttributeError:
+            print("⚠️ Batch functions not available - using per-item calls")
+            self.batch_functions_available = False
+        try:
+            self.lib.stealth_addr_audit_batch_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                 c_int, c_char_p, c_char_p, c_char_p,
+                                                                 c_char_p]
+            self.lib.stealth_addr_audit_batch_simple.restype = c_int
+            self.audit_available = True
+        except AttributeError:
+            print("⚠️ Batch address audit not available - recognizing one address at a time")
+            self.audit_available = False
+
+    def _setup_aggregate_functions(self):
+        """Try to setup block signature aggregation."""
+        try:
+            self.lib.stealth_element_size_GT.restype = c_int
+            self.lib.stealth_aggregate_batch.argtypes = [c_char_p, c_char_p, c_char_p, POINTER(c_int),
+                                                         c_char_p, c_char_p, c_int, c_char_p,
+                                                         c_char_p, c_char_p]
+            self.lib.stealth_aggregate_batch.restype = c_int
+            self.lib.stealth_verify_aggregate_batch.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                POINTER(c_int), c_char_p, c_char_p, c_int]
+            self.lib.stealth_verify_aggregate_batch.restype = c_int
+            self.aggregate_available = True
+        except AttributeError:
+            print("⚠️ Signature aggregation not available")
+            self.aggregate_available = False
+    
+    def _setup_point_format_functions(self):
+        """Try to setup G1 wire format selection (compressed points)."""
+        try:
+            self.lib.stealth_set_point_format.argtypes = [c_int]
+            self.lib.stealth_set_point_format.restype = c_int
+            self.lib.stealth_get_point_format.restype = c_int
+            self.point_format_available = True
+        except AttributeError:
+            print("⚠️ Point format selection not available - using uncompressed points")
+            self.point_format_available = False
+    
+    def _setup_hash_version_functions(self):
+        """Try to setup hash-to-G1 version selection (map-to-curve H2 / H3)."""
+        try:
+            self.lib.stealth_set_hash_version.argtypes = [c_int]
+            self.lib.stealth_set_hash_version.restype = c_int
+            self.lib.stealth_get_hash_version.restype = c_int
+            self.hash_version_available = True
+        except AttributeError:
+            print("⚠️ Hash version selection not available - using g^H(x) hashing")
+            self.hash_version_available = False
+    
+    def _setup_view_tag_functions(self):
+        """Try to setup view tag functions (prefilter for fast recognition)."""
+        try:
+            self.lib.stealth_view_tag_length.restype = c_int
+            self.lib.stealth_addr_gen_tagged_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.stealth_addr_gen_tagged_simple.restype = None
+            self.lib.stealth_addr_recognize_fast_tagged_simple.argtypes = [c_char_p, c_char_p, c_char_p,
+                                                                           c_char_p, c_char_p]
+            self.lib.stealth_addr_recognize_fast_tagged_simple.restype = c_int
+            self.lib.stealth_addr_recognize_fast_tagged_batch.argtypes = [c_char_p, c_char_p, c_char_p, c_int,
+                                                                          c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_addr_recognize_fast_tagged_batch.restype = c_int
+            self.lib.stealth_addr_recognize_fast_tagged_h.argtypes = [c_int, c_int, c_int, c_char_p, c_int]
+            self.lib.stealth_addr_recognize_fast_tagged_h.restype = c_int
+            self.view_tag_length = self.lib.stealth_view_tag_length()
+            self.view_tag_available = True
+        except AttributeError:
+            print("⚠️ View tag functions not available - scanning without prefilter")
+            self.view_tag_available = False
+    
+    def _setup_multi_functions(self):
+        """Try to setup multi-key recognition (one output against many keys)."""
+        try:
+            self.lib.stealth_recognize_multi_simple.argtypes = [c_char_p, c_char_p, c_char_p,
+                                                                c_char_p, c_char_p, c_int]
+            self.lib.stealth_recognize_multi_simple.restype = c_int
+            self.multi_recognize_available = True
+        except AttributeError:
+            print("⚠️ Multi-key recognition not available - checking keys one by one")
+            self.multi_recognize_available = False
+    
+    def _setup_ingest_functions(self):
+        """Try to setup the ingest pipeline (parse, recognize and DSK derivation in one call)."""
+        try:
+            self.lib.stealth_ingest_simple.argtypes = [c_char_p, c_int, c_int, c_char_p, c_char_p,
+                                                       c_char_p, POINTER(c_int), c_char_p]
+            self.lib.stealth_ingest_simple.restype = c_int
+            self.ingest_available = True
+        except AttributeError:
+            print("⚠️ Ingest pipeline not available - recognizing and deriving DSKs separately")
+            self.ingest_available = False
+    
+    def _setup_recognize_derive_functions(self):
+        """Try to setup recognize-and-derive (DSK from the recognition intermediates)."""
+        try:
+            self.lib.stealth_recognize_and_derive_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                     c_char_p, c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.stealth_recognize_and_derive_simple.restype = c_int
+            self.recognize_derive_available = True
+        except AttributeError:
+            print("⚠️ Recognize-and-derive not available - recognizing and generating DSKs separately")
+            self.recognize_derive_available = False
+    
+    def _setup_registry_functions(self):
+        """Try to setup the C key registry (hash index from A / B to key index)."""
+        try:
+            self.lib.stealth_registry_add_simple.argtypes = [c_char_p, c_char_p, c_int]
+            self.lib.stealth_registry_add_simple.restype = c_int
+            self.lib.stealth_registry_find_A_simple.argtypes = [c_char_p]
+            self.lib.stealth_registry_find_A_simple.restype = c_int
+            self.lib.stealth_registry_find_B_simple.argtypes = [c_char_p]
+            self.lib.stealth_registry_find_B_simple.restype = c_int
+            self.lib.stealth_registry_count_simple.restype = c_int
+            self.lib.stealth_registry_clear_simple.restype = None
+            self.lib.stealth_trace_lookup_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p, c_char_p,
+                                                             c_char_p, c_int]
+            self.lib.stealth_trace_lookup_simple.restype = c_int
+            self.registry_available = True
+        except AttributeError:
+            print("⚠️ Key registry not available - tracing falls back to key list lookup")
+            self.registry_available = False
+        try:
+            self.lib.stealth_registry_add_addr_simple.argtypes = [c_char_p, c_int, c_int]
+            self.lib.stealth_registry_add_addr_simple.restype = c_int
+            self.lib.stealth_registry_find_addr_simple.argtypes = [c_char_p, POINTER(c_int)]
+            self.lib.stealth_registry_find_addr_simple.restype = c_int
+            self.lib.stealth_registry_find_addr_batch_simple.argtypes = [c_char_p, c_int, POINTER(c_int),
+                                                                         POINTER(c_int)]
+            self.lib.stealth_registry_find_addr_batch_simple.restype = c_int
+            self.lib.stealth_registry_addr_count_simple.restype = c_int
+            self.lib.stealth_registry_clear_addrs_simple.restype = None
+            self.lib.stealth_store_registry_load_addrs_simple.argtypes = [c_int]
+            self.lib.stealth_store_registry_load_addrs_simple.restype = c_long
+            self.addr_index_available = True
+        except AttributeError:
+            print("⚠️ Address index not available - address lookups walk the address list")
+            self.addr_index_available = False
+    
+    def _setup_store_functions(self):
+        """Try to setup the memory-mapped record store."""
+        try:
+            self.lib.stealth_store_open_simple.argtypes = [c_char_p, c_int]
+            self.lib.stealth_store_open_simple.restype = c_int
+            self.lib.stealth_store_append_simple.argtypes = [c_int, c_char_p, c_char_p]
+            self.lib.stealth_store_append_simple.restype = c_long
+            self.lib.stealth_store_get_simple.argtypes = [c_int, c_long, c_char_p, c_char_p]
+            self.lib.stealth_store_get_simple.restype = c_int
+            self.lib.stealth_store_count_simple.argtypes = [c_int]
+            self.lib.stealth_store_count_simple.restype = c_long
+            self.lib.stealth_store_reset_simple.argtypes = [c_int]
+            self.lib.stealth_store_reset_simple.restype = c_int
+            self.lib.stealth_store_sync_simple.argtypes = [c_int]
+            self.lib.stealth_store_sync_simple.restype = c_int
+            self.lib.stealth_store_close_simple.argtypes = [c_int]
+            self.lib.stealth_store_close_simple.restype = None
+            self.lib.stealth_store_save_system_simple.argtypes = [c_int, c_char_p, c_char_p]
+            self.lib.stealth_store_save_system_simple.restype = c_int
+            self.lib.stealth_store_load_system_simple.argtypes = [c_int, c_char_p, c_char_p, c_int]
+            self.lib.stealth_store_load_system_simple.restype = c_int
+            self.lib.stealth_store_recognize_fast_simple.argtypes = [c_int, c_long, c_int, c_long]
+            self.lib.stealth_store_recognize_fast_simple.restype = c_int
+            self.lib.stealth_store_scan_simple.argtypes = [c_int, c_long, c_long, c_int, c_long, c_char_p]
+            self.lib.stealth_store_scan_simple.restype = c_long
+            self.lib.stealth_store_registry_load_simple.argtypes = [c_int]
+            self.lib.stealth_store_registry_load_simple.restype = c_long
+            self.store_available = True
+        except AttributeError:
+            print("⚠️ Record store not available - data is kept in memory only")
+            self.store_available = False
+    
+    def _setup_block_functions(self):
+        """Try to setup bulk generation and multi-key scanning across a worker pool."""
+        try:
+            self.lib.stealth_addr_gen_block_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_int, c_int,
+                                                               c_char_p, c_char_p, c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_addr_gen_block_simple.restype = c_int
+            self.lib.stealth_recognize_multi_block_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_char_p,
+                                                                      c_int, c_char_p, c_char_p, c_int, c_int,
+                                                                      POINTER(c_int)]
+            self.lib.stealth_recognize_multi_block_simple.restype = c_int
+            self.lib.stealth_store_scan_owners_simple.argtypes = [c_int, c_long, c_long, c_int,
+                                                                  POINTER(c_long), c_int, c_int, POINTER(c_int)]
+            self.lib.stealth_store_scan_owners_simple.restype = c_long
+            self.block_functions_available = True
+        except AttributeError:
+            print("⚠️ Threaded bulk functions not available - generating and scanning one by one")
+            self.block_functions_available = False
+    
+    def _setup_multi_output_functions(self):
+        """Try to setup generation of a transaction's outputs on one shared R1."""
+        try:
+            self.lib.stealth_addr_gen_multi_simple.argtypes = [c_char_p, c_char_p, c_char_p, c_int, c_int,
+                                                               c_char_p, c_char_p, c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_addr_gen_multi_simple.restype = c_int
+            self.multi_output_available = True
+        except AttributeError:
+            print("⚠️ Shared-ephemeral transactions not available - one R1 per output")
+            self.multi_output_available = False
+    
+    def _setup_wallet_sync_functions(self):
+        """Try to setup wallet sync from per-key scan cursors kept in the store."""
+        try:
+            self.lib.stealth_store_cursor_simple.argtypes = [c_int, c_long, POINTER(c_long)]
+            self.lib.stealth_store_cursor_simple.restype = c_long
+            self.lib.stealth_store_sync_scan_simple.argtypes = [c_int, c_int, c_long, c_int, c_int, c_int, c_long,
+                                                                POINTER(c_long), c_long, POINTER(c_long)]
+            self.lib.stealth_store_sync_scan_simple.restype = c_long
+            self.wallet_sync_available = True
+        except AttributeError:
+            print("⚠️ Wallet sync not available - every scan starts from the first address")
+            self.wallet_sync_available = False
+    
+    def _setup_trace_index_functions(self):
+        """Try to setup the tracing index (stored traces chained per recovered B)."""
+        try:
+            self.lib.stealth_store_trace_sync_simple.argtypes = [c_int, c_int, c_char_p, c_long]
+            self.lib.stealth_store_trace_sync_simple.restype = c_long
+            self.lib.stealth_store_trace_find_simple.argtypes = [c_int, c_char_p, POINTER(c_long), c_long]
+            self.lib.stealth_store_trace_find_simple.restype = c_long
+            self.trace_index_available = True
+        except AttributeError:
+            print("⚠️ Tracing index not available - audits trace every address")
+            self.trace_index_available = False
+    
+    def _setup_key_table_functions(self):
+        """Try to setup the per-key contexts and the key table store they load from."""
+        try:
+            self.lib.stealth_store_open_key_tables_simple.argtypes = [c_char_p]
+            self.lib.stealth_store_open_key_tables_simple.restype = c_int
+            self.lib.stealth_store_key_tables_sync_simple.argtypes = [c_int, c_int]
+            self.lib.stealth_store_key_tables_sync_simple.restype = c_long
+            self.lib.stealth_key_ctx_init_simple.argtypes = [c_char_p, c_int]
+            self.lib.stealth_key_ctx_init_simple.restype = c_int
+            self.lib.stealth_key_ctx_clear_simple.restype = None
+            self.lib.stealth_key_addr_gen_simple.argtypes = [c_long, c_char_p, c_char_p,
+                                                             c_char_p, c_char_p, c_char_p, c_char_p,
+                                                             c_char_p, c_int]
+            self.lib.stealth_key_addr_gen_simple.restype = c_int
+            self.lib.stealth_key_recognize_fast_simple.argtypes = [c_long, c_char_p, c_char_p, c_char_p,
+                                                                   c_char_p, c_char_p, c_char_p]
+            self.lib.stealth_key_recognize_fast_simple.restype = c_int
+            self.key_tables_available = True
+        except AttributeError:
+            print("⚠️ Key tables not available - every address generation exponentiates A and B afresh")
+            self.key_tables_available = False
+    
+    def _setup_pinning_functions(self):
+        """Try to setup worker pinning; on when WORKER_PINNING_ENV is 1."""
+        try:
+            self.lib.stealth_set_worker_pinning.argtypes = [c_int]
+            self.lib.stealth_set_worker_pinning.restype = c_int
+        except AttributeError:
+            return
+        if os.environ.get(WORKER_PINNING_ENV) == "1":
+            self.lib.stealth_set_worker_pinning(1)
+    
+    def _setup_hex_functions(self):
+        """Try to setup the vectorized hex codec for whole element lists."""
+        try:
+            self.lib.stealth_to_hex_simple.argtypes = [c_char_p, c_int, c_char_p]
+            self.lib.stealth_to_hex_simple.restype = c_int
+            self.lib.stealth_from_hex_simple.argtypes = [c_char_p, c_long, c_char_p, c_int]
+            self.lib.stealth_from_hex_simple.restype = c_long
+            self.lib.stealth_to_hex_batch_simple.argtypes = [c_char_p, c_long, c_int, c_char_p, c_char_p]
+            self.lib.stealth_to_hex_batch_simple.restype = c_long
+            self.lib.stealth_from_hex_batch_simple.argtypes = [c_char_p, c_long, c_long, c_int, c_char_p]
+            self.lib.stealth_from_hex_batch_simple.restype = c_long
+            self.hex_available = True
+        except AttributeError:
+            print("⚠️ Hex codec not available - converting elements to and from hex in Python")
+            self.hex_available = False
+    
+    def _setup_cache_stats_functions(self):
+        """Try to setup the hit counters of the pairing table, ephemeral pool and H3 caches."""
+        try:
+            for _, name in self.CACHE_STATS:
+                getattr(self.lib, name).argtypes = [POINTER(c_ulong), POINTER(c_ulong)]
+                getattr(self.lib, name).restype = None
+            self.lib.stealth_set_verify_pp_cache.argtypes = [c_int]
+            self.lib.stealth_set_verify_pp_cache.restype = c_int
+            self.cache_stats_available = True
+        except AttributeError:
+            print("⚠️ Cache counters not available - live metrics report no cache hit rates")
+            self.cache_stats_available = False
+            return
+        setting = os.environ.get(VERIFY_PP_CACHE_ENV)
+        if setting:
+            self.set_verify_pp_cache(int(setting))
+    
+    def _setup_dsk_cache_functions(self):
+        """Try to setup signing through the C-side cache of one-time secret keys."""
+        try:
+            self.lib.stealth_sign_cached_simple.argtypes = [c_long, c_char_p, c_char_p, c_char_p, c_char_p, c_char_p,
+                                                            c_char_p, c_char_p, c_char_p, c_int]
+            self.lib.stealth_sign_cached_simple.restype = None
+            self.lib.stealth_set_dsk_cache.argtypes = [c_int, c_double]
+            self.lib.stealth_set_dsk_cache.restype = c_int
+            self.lib.stealth_get_dsk_cache_stats.argtypes = [POINTER(c_ulong), POINTER(c_ulong), POINTER(c_ulong)]
+            self.lib.stealth_get_dsk_cache_stats.restype = None
+            self.dsk_cache_available = True
+        except AttributeError:
+            print("⚠️ DSK cache not available - every signature derives its key")
+            self.dsk_cache_available = False
+            return
+        entries, ttl_ms = DSK_CACHE_DEFAULT
+        setting = os.environ.get(DSK_CACHE_ENV)
+        if setting:
+            count, _, ttl = setting.partition(":")
+            entries, ttl_ms = int(count), float(ttl) if ttl else ttl_ms
+        self.set_dsk_cache(entries, ttl_ms)
+    
+    def _setup_metrics_functions(self):
+        """Try to setup the per-primitive counters (pairings, pows, hashes, serialization)."""
+        try:
+            self.lib.stealth_primitive_stats_simple.argtypes = [POINTER(c_ulong), POINTER(c_double)]
+            self.lib.stealth_primitive_stats_simple.restype = None
+            self.lib.stealth_reset_primitive_stats_simple.restype = None
+            self.metrics_available = True
+        except AttributeError:
+            print("⚠️ Primitive counters not available - /metrics reports no primitives")
+            self.metrics_available = False
+    
+    def _setup_latency_functions(self):
+        """Try to setup the per-operation latency histograms."""
+        try:
+            self.lib.stealth_latency_histogram_simple.argtypes = [c_int, POINTER(c_ulong), c_int, POINTER(c_double)]
+            self.lib.stealth_latency_histogram_simple.restype = c_long
+            self.lib.stealth_latency_bounds_simple.argtypes = [POINTER(c_double), c_int]
+            self.lib.stealth_latency_bounds_simple.restype = c_int
+            n = self.lib.stealth_latency_bounds_simple(None, 0)
+            bounds = (c_double * n)()
+            self.lib.stealth_latency_bounds_simple(bounds, n)
+            self._latency_bounds = tuple(bounds)
+            self.latency_available = True
+        except AttributeError:
+            print("⚠️ Latency histograms not available - performance tests report averages only")
+            self.latency_available = False
+    
+    def _setup_benchmark_functions(self):
+        """Try to setup the configurable benchmark."""
+        try:
+            self.lib.stealth_benchmark_simple.argtypes = [c_int, c_int, c_int, c_int, c_int, c_int,
+                                                          POINTER(c_double), c_int]
+            self.lib.stealth_benchmark_simple.restype = c_int
+            self.benchmark_available = True
+        except AttributeError:
+            print("⚠️ Configurable benchmark not available - performance tests only")
+            self.benchmark_available = False
+    
+    def _setup_hw_counter_functions(self):
+        """Try to setup the per-primitive hardware counters (cycles, IPC, misses, allocations)."""
+        try:
+            self.lib.stealth_set_hw_counters.argtypes = [c_int]
+            self.lib.stealth_set_hw_counters.restype = c_int
+            self.lib.stealth_primitive_hw_stats_simple.argtypes = [POINTER(c_ulong), POINTER(c_double)]
+            self.lib.stealth_primitive_hw_stats_simple.restype = None
+            self.hw_counters_available = True
+        except AttributeError:
+            print("⚠️ Hardware counters not available - /metrics reports times only")
+            self.hw_counters_available = False
+    
+    def _setup_seed_functions(self):
+        """Try to setup seeded random mode (reproducible benchmark runs)."""
+        try:
+            self.lib.stealth_set_random_seed.argtypes = [c_int, c_uint]
+            self.lib.stealth_set_random_seed.restype = c_int
+            self.lib.stealth_get_random_seeded.restype = c_int
+            self.seed_available = True
+        except AttributeError:
+            print("⚠️ Seeded random mode not available - benchmarks draw fresh randomness")
+            self.seed_available = False
+    
+    def _drop_handles(self):
+        """Release every C-side handle; they do not survive a re-init."""
+        with self._handle_lock:
+            if self.handle_functions_available:
+                self.lib.stealth_handle_free_all()
+            self._handle_cache.clear()
+            self._handle_generation += 1
+    
     def init(self, param_file_path: str) -> int:
         """Initialize the library with parameter file."""
-        return self.lib.stealth_init(param_file_path.encode())
+        self._drop_handles()
+        if self.registry_available:
+            # Registry entries belong to the previous pairing
+            self.lib.stealth_registry_clear_simple()
+        if self.key_tables_available:
+            self.lib.stealth_key_ctx_clear_simple()
+        result = self.lib.stealth_init(param_file_path.encode())
+        if result == 0 and self.hw_counters_available and os.environ.get(HW_COUNTERS_ENV) == "1":
+            # After init, so that the allocation count sits over the pool
+            self.set_hw_counters(True)
+        return result
     
     def is_initialized(self) -> bool:
         """Check if library is initialized."""
@@ -98,16 +761,124 @@ class StealthLibrary:
     
     def cleanup(self):
         """Cleanup library resources."""
+        self._drop_handles()
         self.lib.stealth_cleanup()
     
     def reset_performance(self):
         """Reset performance counters."""
         self.lib.stealth_reset_performance()
     
+    # Order of the counters in each row filled by stealth_primitive_hw_stats_simple
+    HW_COUNTERS = ("cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "allocs")
+    
+    def set_hw_counters(self, enabled: bool) -> Tuple[str, ...]:
+        """Switch the per-primitive hardware counters on or off; returns the
+        counters this host can read (no CPU counters in most VMs), also kept
+        in hw_counters."""
+        if not self.hw_counters_available:
+            return ()
+        mask = self.lib.stealth_set_hw_counters(int(enabled))
+        self.hw_counters = tuple(name for i, name in enumerate(self.HW_COUNTERS) if mask & (1 << i))
+        return self.hw_counters
+    
+    def primitive_hw_stats(self) -> Dict[str, Tuple[int, Dict[str, float]]]:
+        """Per-primitive (calls measured, counter totals) while the counters were on."""
+        n = len(self.PRIMITIVES)
+        width = len(self.HW_COUNTERS)
+        counts = (c_ulong * n)()
+        totals = (c_double * (n * width))()
+        self.lib.stealth_primitive_hw_stats_simple(counts, totals)
+        return {name: (counts[i], dict(zip(self.HW_COUNTERS, totals[i * width:(i + 1) * width])))
+                for i, name in enumerate(self.PRIMITIVES)}
+    
+    def set_random_seed(self, seed: Optional[int]) -> bool:
+        """Draw randomness on the calling thread, and the worker threads its calls
+        start, from a source seeded with seed; None goes back to the OS source."""
+        if not self.seed_available:
+            return seed is None
+        if seed is None:
+            return self.lib.stealth_set_random_seed(0, 0) == 0
+        return self.lib.stealth_set_random_seed(1, seed) == 0
+    
+    # Order of the counter arrays filled by stealth_primitive_stats_simple
+    PRIMITIVES = ("pairing", "g1_pow", "gt_pow", "hash_zr", "hash_g1", "serialize")
+    
+    def primitive_stats(self) -> Dict[str, Tuple[int, float]]:
+        """Per-primitive (call count, total ms) since load, summed over threads."""
+        n = len(self.PRIMITIVES)
+        counts = (c_ulong * n)()
+        total_ms = (c_double * n)()
+        self.lib.stealth_primitive_stats_simple(counts, total_ms)
+        return {name: (counts[i], total_ms[i]) for i, name in enumerate(self.PRIMITIVES)}
+    
+    def reset_primitive_stats(self):
+        """Zero the per-primitive counters."""
+        self.lib.stealth_reset_primitive_stats_simple()
+    
+    # Operations with a latency histogram, in stealth_performance_t order
+    LATENCY_OPS = ("addr_gen", "addr_recognize", "fast_recognize", "onetime_sk", "sign", "sig_verify", "trace")
+    
+    @property
+    def latency_bounds(self) -> Tuple[float, ...]:
+        """Upper bound in ms of each histogram bucket."""
+        return self._latency_bounds
+    
+    def latency_histograms(self) -> Dict[str, Tuple[Dict[int, int], float]]:
+        """Per-operation ({bucket: count}, max ms) since the last performance reset."""
+        n = len(self._latency_bounds)
+        counts = (c_ulong * n)()
+        max_ms = c_double()
+        snapshot = {}
+        for op, name in enumerate(self.LATENCY_OPS):
+            if self.lib.stealth_latency_histogram_simple(op, counts, n, byref(max_ms)) < 0:
+                continue
+            snapshot[name] = ({i: c for i, c in enumerate(counts) if c}, max_ms.value)
+        return snapshot
+    
     def get_element_sizes(self) -> Tuple[int, int]:
         """Get element sizes for G1 and Zr groups."""
         return self.lib.stealth_element_size_G1(), self.lib.stealth_element_size_Zr()
     
+    def get_g2_size(self) -> int:
+        """Size of TK, R2, dsk and Q_sigma; the G1 size under a symmetric pairing."""
+        return self.lib.stealth_element_size_G2()
+    
+    POINT_FORMATS = {"uncompressed": 0, "compressed": 1}
+    
+    def set_point_format(self, name: str) -> bool:
+        """Select the G1 wire format; every G1 buffer and size follows it."""
+        if name not in self.POINT_FORMATS:
+            raise ValueError(f"Unknown point format: {name}")
+        if not self.point_format_available:
+            return name == "uncompressed"
+        # Cached handles are keyed by hex in the old encoding
+        self._drop_handles()
+        return self.lib.stealth_set_point_format(self.POINT_FORMATS[name]) == 0
+    
+    def get_point_format(self) -> str:
+        """Get the current G1 wire format name."""
+        if not self.point_format_available:
+            return "uncompressed"
+        code = self.lib.stealth_get_point_format()
+        return next(k for k, v in self.POINT_FORMATS.items() if v == code)
+    
+    # 1: g^H(x) (original scheme), 2: digest mapped onto the curve
+    HASH_VERSIONS = (1, 2)
+    
+    def set_hash_version(self, version: int) -> bool:
+        """Select the hash-to-G1 version used by H2 / H3."""
+        if version not in self.HASH_VERSIONS:
+            return False
+        if not self.hash_version_available:
+            return version == 1
+        return self.lib.stealth_set_hash_version(version) == 0
+    
+    def get_hash_version(self) -> int:
+        """Get the current hash-to-G1 version."""
+        if not self.hash_version_available:
+            return 1
+        return self.lib.stealth_get_hash_version()
+    
     def keygen(self, A_buf, B_buf, a_buf, b_buf, buf_size: int):
         """Generate key pair."""
         self.lib.stealth_keygen_simple(A_buf, B_buf, a_buf, b_buf, buf_size)
@@ -123,11 +894,47 @@ class StealthLibrary:
     
     def addr_recognize_fast(self, r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes) -> bool:
         """Recognize stealth address (fast version)."""
-        return bool(self.lib.stealth_addr_recognize_fast_simple(r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes))
+        return bool(self._fn["stealth_addr_recognize_fast_simple"](r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes))
+    
+    def addr_gen_tagged(self, A_bytes, B_bytes, TK_bytes, addr_buf, r1_buf, r2_buf, c_buf, buf_size: int) -> bytes:
+        """Generate stealth address; returns its view tag."""
+        tag_buf = create_string_buffer(self.view_tag_length)
+        self.lib.stealth_addr_gen_tagged_simple(A_bytes, B_bytes, TK_bytes,
+                                                addr_buf, r1_buf, r2_buf, c_buf, tag_buf, buf_size)
+        return tag_buf.raw
+    
+    def addr_recognize_fast_tagged(self, r1_bytes, b_bytes, c_bytes, tag_bytes, a_priv_bytes) -> bool:
+        """Recognize stealth address (fast version) with view tag prefilter."""
+        return bool(self._fn["stealth_addr_recognize_fast_tagged_simple"](r1_bytes, b_bytes, c_bytes,
+                                                                          tag_bytes, a_priv_bytes))
+    
+    def key_ctx_init(self, TK_bytes, tables_h: int = -1):
+        """Start the per-key contexts over for a trace key, reading tables from tables_h (-1: build them)."""
+        if self.lib.stealth_key_ctx_init_simple(TK_bytes, tables_h) != 0:
+            raise RuntimeError("stealth_key_ctx_init_simple failed")
+    
+    def key_addr_gen(self, key_index: int, A_bytes, B_bytes, addr_buf, r1_buf, r2_buf, c_buf, buf_size: int,
+                     tagged: bool = False) -> Optional[bytes]:
+        """Generate stealth address through the key's context; returns its view tag if tagged."""
+        tag_buf = create_string_buffer(self.view_tag_length) if tagged else None
+        if self.lib.stealth_key_addr_gen_simple(key_index, A_bytes, B_bytes,
+                                                addr_buf, r1_buf, r2_buf, c_buf, tag_buf, buf_size) != 0:
+            raise RuntimeError("stealth_key_addr_gen_simple failed")
+        return tag_buf.raw if tagged else None
+    
+    def key_recognize_fast(self, key_index: int, A_bytes, B_bytes, r1_bytes, c_bytes, tag_bytes,
+                           a_priv_bytes) -> bool:
+        """Recognize stealth address (fast version) through the key's context."""
+        result = self.lib.stealth_key_recognize_fast_simple(key_index, A_bytes, B_bytes, r1_bytes, c_bytes,
+                                                            tag_bytes, a_priv_bytes)
+        if result < 0:
+            raise RuntimeError("stealth_key_recognize_fast_simple failed")
+        return bool(result)
     
     def addr_recognize(self, addr_bytes, r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes, tk_bytes) -> bool:
         """Recognize stealth address (full version)."""
-        return bool(self.lib.stealth_addr_recognize_simple(addr_bytes, r1_bytes, b_bytes, a_bytes, c_bytes, a_priv_bytes, tk_bytes))
+        return bool(self._fn["stealth_addr_recognize_simple"](addr_bytes, r1_bytes, b_bytes, a_bytes, c_bytes,
+                                                              a_priv_bytes, tk_bytes))
     
     def sign(self, addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes, 
              q_sigma_buf, h_buf, dsk_buf, buf_size: int):
@@ -135,16 +942,105 @@ class StealthLibrary:
         self.lib.stealth_sign_simple(addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
                                     q_sigma_buf, h_buf, dsk_buf, buf_size)
     
+    def sign_cached(self, addr_id: int, addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
+                    q_sigma_buf, h_buf, dsk_buf, buf_size: int):
+        """Sign as sign(), keeping the address's DSK in the C cache under addr_id."""
+        self.lib.stealth_sign_cached_simple(addr_id, addr_bytes, r1_bytes, a_bytes, b_bytes, message_bytes,
+                                            q_sigma_buf, h_buf, dsk_buf, buf_size)
+    
+    def set_dsk_cache(self, entries: int, ttl_ms: float) -> bool:
+        """Keep up to entries DSKs for ttl_ms each; 0 entries disables the cache."""
+        return self.lib.stealth_set_dsk_cache(entries, ttl_ms) == 0
+    
+    def dsk_cache_stats(self) -> Dict[str, int]:
+        """Cache hits, misses and wiped live entries since init or the last reset."""
+        hits, misses, evictions = c_ulong(), c_ulong(), c_ulong()
+        self.lib.stealth_get_dsk_cache_stats(byref(hits), byref(misses), byref(evictions))
+        return {"hits": hits.value, "misses": misses.value, "evictions": evictions.value}
+    
+    # Cache name reported by cache_stats, and its counter function
+    CACHE_STATS = (("pairing_pp", "stealth_get_pp_cache_stats"),
+                   ("precompute", "stealth_get_eph_pool_stats"),
+                   ("h3", "stealth_get_h3_cache_stats"),
+                   ("verify_pp", "stealth_get_verify_pp_cache_stats"))
+    
+    def set_verify_pp_cache(self, entries: int) -> bool:
+        """Keep the pairing tables of the commitments of up to entries recently
+        verified addresses; 0 disables the cache."""
+        return self.lib.stealth_set_verify_pp_cache(entries) == 0
+    
+    def cache_stats(self) -> Dict[str, Dict[str, int]]:
+        """Hits and misses of every cache since init: pairing tables, the pool of
+        precomputed ephemerals and nonces, H3(Addr) and (if loaded) the DSK cache."""
+        stats = {}
+        for cache, name in self.CACHE_STATS:
+            hits, misses = c_ulong(), c_ulong()
+            getattr(self.lib, name)(byref(hits), byref(misses))
+            stats[cache] = {"hits": hits.value, "misses": misses.value}
+        if self.dsk_cache_available:
+            stats["dsk"] = self.dsk_cache_stats()
+        return stats
+    
     def verify(self, addr_bytes, r2_bytes, c_bytes, message_bytes, h_bytes, q_sigma_bytes) -> bool:
         """Verify signature."""
-        return bool(self.lib.stealth_verify_simple(addr_bytes, r2_bytes, c_bytes, 
-                                                  message_bytes, h_bytes, q_sigma_bytes))
+        return bool(self._fn["stealth_verify_simple"](addr_bytes, r2_bytes, c_bytes,
+                                                      message_bytes, h_bytes, q_sigma_bytes))
     
     def trace(self, addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes, b_recovered_buf, buf_size: int):
         """Trace identity from stealth address."""
         self.lib.stealth_trace_simple(addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes,
                                      b_recovered_buf, buf_size)
     
+    def trace_lookup(self, addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes, b_recovered_buf, buf_size: int) -> int:
+        """Trace identity; returns the registry id of the owner (-1 if unregistered)."""
+        return self.lib.stealth_trace_lookup_simple(addr_bytes, r1_bytes, r2_bytes, c_bytes, k_bytes,
+                                                    b_recovered_buf, buf_size)
+    
+    def registry_add(self, A_bytes, B_bytes, key_id: int) -> bool:
+        """Register a key pair in the C hash index."""
+        return self.lib.stealth_registry_add_simple(A_bytes, B_bytes, key_id) == 0
+    
+    def registry_find_A(self, A_bytes) -> int:
+        """Look up a key id by public key A (-1 if unknown)."""
+        return self.lib.stealth_registry_find_A_simple(A_bytes)
+    
+    def registry_find_B(self, B_bytes) -> int:
+        """Look up a key id by public key B (-1 if unknown)."""
+        return self.lib.stealth_registry_find_B_simple(B_bytes)
+    
+    def registry_count(self) -> int:
+        """Number of registered key pairs."""
+        return self.lib.stealth_registry_count_simple()
+    
+    def registry_add_addr(self, addr_bytes, addr_id: int, owner: int = -1) -> bool:
+        """Register a one-time address and its owning key id in the C address index."""
+        return self.lib.stealth_registry_add_addr_simple(addr_bytes, addr_id, owner) == 0
+    
+    def registry_find_addr(self, addr_bytes):
+        """Look up a one-time address; returns (address id, owning key id), -1s if unknown."""
+        owner = c_int(-1)
+        addr_id = self.lib.stealth_registry_find_addr_simple(addr_bytes, byref(owner))
+        return addr_id, owner.value if addr_id >= 0 else -1
+    
+    def registry_find_addr_batch(self, addr_list):
+        """Look up many one-time addresses; returns (address ids, owning key ids), -1 if unknown."""
+        n = len(addr_list)
+        if n == 0:
+            return [], []
+        ids, owners = (c_int * n)(), (c_int * n)()
+        if self.lib.stealth_registry_find_addr_batch_simple(self._pack(addr_list, self.get_element_sizes()[0]),
+                                                            n, ids, owners) < 0:
+            raise RuntimeError("stealth_registry_find_addr_batch_simple failed")
+        return list(ids), list(owners)
+    
+    def registry_addr_count(self) -> int:
+        """Number of registered addresses."""
+        return self.lib.stealth_registry_addr_count_simple()
+    
+    def registry_clear_addrs(self):
+        """Drop the registered addresses, keeping the keys."""
+        self.lib.stealth_registry_clear_addrs_simple()
+    
     def dsk_gen(self, addr_bytes, r1_bytes, a_bytes, b_bytes, dsk_buf, buf_size: int):
         """Generate DSK (if available)."""
         if self.dsk_functions_available:
@@ -152,6 +1048,12 @@ class StealthLibrary:
         else:
             raise NotImplementedError("DSK functions not available")
     
+    def recognize_and_derive(self, addr_bytes, r1_bytes, b_bytes, c_bytes, tag_bytes, a_bytes, b_priv_bytes,
+                             dsk_buf, buf_size: int) -> bool:
+        """Fast recognition; fills dsk_buf with the DSK if the output is owned."""
+        return bool(self.lib.stealth_recognize_and_derive_simple(addr_bytes, r1_bytes, b_bytes, c_bytes, tag_bytes,
+                                                                 a_bytes, b_priv_bytes, dsk_buf, buf_size))
+    
     def sign_with_dsk(self, addr_bytes, dsk_bytes, message_bytes, q_sigma_buf, h_buf, buf_size: int):
         """Sign with DSK (if available)."""
         if self.dsk_functions_available:
@@ -160,9 +1062,662 @@ class StealthLibrary:
         else:
             raise NotImplementedError("DSK functions not available")
     
+    # Handle-based interface
+    HANDLE_G1 = 1
+    HANDLE_ZR = 2
+    HANDLE_G2 = 3
+    
+    # Key handles kept between calls, least recently used dropped first
+    KEY_HANDLE_CACHE_SIZE = 256
+    
+    def _import_handle(self, hex_str: str, handle_type: int) -> int:
+        data = bytes.fromhex(hex_str if len(hex_str) % 2 == 0 else '0' + hex_str)
+        handle = self.lib.stealth_handle_import(handle_type, data, len(data))
+        if handle < 0:
+            raise ValueError("Failed to import element into C handle table")
+        return handle
+    
+    def _release_key_handle(self, entry):
+        """Drop a reference to a cached key handle; called with _handle_lock held."""
+        entry[1] -= 1
+        if entry[1] == 0 and entry[2] == self._handle_generation:
+            self.lib.stealth_handle_free(entry[0])
+    
+    def _pin_key_handle(self, hex_str: str, handle_type: int):
+        """Cached entry of a key handle with a reference for the caller, importing it once."""
+        key = (handle_type, hashlib.blake2b(hex_str.encode(), key=self._handle_salt, digest_size=16).digest())
+        with self._handle_lock:
+            entry = self._handle_cache.get(key)
+            if entry is not None:
+                self._handle_cache.move_to_end(key)
+                entry[1] += 1
+                return entry
+        handle = self._import_handle(hex_str, handle_type)
+        with self._handle_lock:
+            entry = self._handle_cache.get(key)
+            if entry is not None:
+                # Imported by another thread meanwhile
+                self.lib.stealth_handle_free(handle)
+                self._handle_cache.move_to_end(key)
+                entry[1] += 1
+                return entry
+            # One reference for the cache, one for the caller
+            entry = [handle, 2, self._handle_generation]
+            self._handle_cache[key] = entry
+            while len(self._handle_cache) > self.KEY_HANDLE_CACHE_SIZE:
+                self._release_key_handle(self._handle_cache.popitem(last=False)[1])
+            return entry
+    
+    @contextmanager
+    def handles(self, keys=(), components=()):
+        """C-side handles for the block, keys then components, each a (hex, type) pair.
+        Key handles come from a bounded cache and cannot be evicted during the
+        block; address components are imported for the block only."""
+        generation = self._handle_generation
+        pinned, owned = [], []
+        try:
+            for hex_str, handle_type in keys:
+                pinned.append(self._pin_key_handle(hex_str, handle_type))
+            for hex_str, handle_type in components:
+                owned.append(self._import_handle(hex_str, handle_type))
+            yield [entry[0] for entry in pinned] + owned
+        finally:
+            with self._handle_lock:
+                if generation == self._handle_generation:
+                    for handle in owned:
+                        self.lib.stealth_handle_free(handle)
+                for entry in pinned:
+                    self._release_key_handle(entry)
+    
+    def handle_export(self, handle: int, buf_size: int) -> bytes:
+        """Serialize the element behind a handle."""
+        buf = create_string_buffer(buf_size)
+        n = self.lib.stealth_handle_export(handle, buf, buf_size)
+        if n < 0:
+            raise ValueError("Invalid handle")
+        return buf.raw[:n]
+    
+    def handle_free(self, handle: int):
+        """Release a handle returned by a *_h call."""
+        self.lib.stealth_handle_free(handle)
+    
+    def addr_recognize_fast_h(self, r1_h: int, b_h: int, a_h: int, c_h: int, a_priv_h: int) -> bool:
+        """Recognize stealth address (fast version) on handles."""
+        result = self.lib.stealth_addr_recognize_fast_h(r1_h, b_h, a_h, c_h, a_priv_h)
+        if result < 0:
+            raise ValueError("Invalid handle")
+        return bool(result)
+    
+    def addr_recognize_fast_tagged_h(self, r1_h: int, b_h: int, c_h: int, tag_bytes, a_priv_h: int) -> bool:
+        """Recognize stealth address on handles with view tag prefilter."""
+        result = self.lib.stealth_addr_recognize_fast_tagged_h(r1_h, b_h, c_h, tag_bytes, a_priv_h)
+        if result < 0:
+            raise ValueError("Invalid handle")
+        return bool(result)
+    
+    def dsk_gen_h(self, addr_h: int, r1_h: int, a_h: int, b_h: int) -> int:
+        """Generate DSK on handles; returns a new handle owned by the caller."""
+        dsk = c_int()
+        if self.lib.stealth_dsk_gen_h(addr_h, r1_h, a_h, b_h, byref(dsk)) < 0:
+            raise ValueError("Invalid handle")
+        return dsk.value
+    
+    def sign_with_dsk_h(self, addr_h: int, dsk_h: int, message_bytes) -> Tuple[int, int]:
+        """Sign with DSK on handles; returns new (Q_sigma, h) handles owned by the caller."""
+        q_sigma, h = c_int(), c_int()
+        if self.lib.stealth_sign_with_dsk_h(addr_h, dsk_h, message_bytes, byref(q_sigma), byref(h)) < 0:
+            raise ValueError("Invalid handle")
+        return q_sigma.value, h.value
+    
+    def verify_h(self, addr_h: int, r2_h: int, c_h: int, message_bytes, h_h: int, q_sigma_h: int) -> bool:
+        """Verify signature on handles."""
+        result = self.lib.stealth_verify_h(addr_h, r2_h, c_h, message_bytes, h_h, q_sigma_h)
+        if result < 0:
+            raise ValueError("Invalid handle")
+        return bool(result)
+    
+    def trace_h(self, addr_h: int, r1_h: int, r2_h: int, c_h: int, k_h: int) -> int:
+        """Trace identity on handles; returns a new handle for B owned by the caller."""
+        b_out = c_int()
+        if self.lib.stealth_trace_h(addr_h, r1_h, r2_h, c_h, k_h, byref(b_out)) < 0:
+            raise ValueError("Invalid handle")
+        return b_out.value
+    
+    # Packed batch interface. Inputs are lists of raw element bytes or of
+    # their hex strings; CDLL releases the GIL for the whole call.
+    def _pack(self, items, size: int) -> bytes:
+        if items and isinstance(items[0], str):
+            return self.from_hex_list(items, size)
+        return b"".join(bytes(x[:size]).ljust(size, b"\0") for x in items)
+    
+    @staticmethod
+    def _unpack(buf, n: int, size: int):
+        raw = buf.raw
+        return [raw[i * size:(i + 1) * size] for i in range(n)]
+    
+    def _unpack_hex(self, buf, n: int, size: int):
+        return self.to_hex_list(buf.raw[:n * size], size)
+    
+    # Hex of elements, whole lists converted in one call
+    def to_hex(self, data, empty_if_zero: bool = False) -> str:
+        """Lowercase hex of data; "" for all-zero data if empty_if_zero."""
+        if self._hex_codec is not None and len(data):
+            return self._hex_codec.encode(data, len(data), empty_if_zero)[0]
+        # For one element a ctypes call costs more than bytes.hex()
+        data = bytes(data)
+        return "" if empty_if_zero and not any(data) else data.hex()
+    
+    def to_hex_list(self, packed, size: int, empty_if_zero: bool = False) -> List[str]:
+        """Hex of each size-byte element of packed (bytes holding them end to end)."""
+        if self._hex_codec is not None and size > 0:
+            return self._hex_codec.encode(packed, size, empty_if_zero)
+        n = len(packed) // size if size > 0 else 0
+        if not self.hex_available or n == 0:
+            hexes = [packed[i * size:(i + 1) * size].hex() for i in range(n)]
+            return ["" if empty_if_zero and not h.strip("0") else h for h in hexes]
+        # Comma-separated so that one split makes the strings
+        out = bytearray((2 * size + 1) * n - 1)
+        zero = bytearray(n) if empty_if_zero else None
+        zeros = self.lib.stealth_to_hex_batch_simple(bytes(packed), n, size, (c_char * len(out)).from_buffer(out),
+                                                     (c_char * n).from_buffer(zero) if zero is not None else None)
+        hexes = out.decode("ascii").split(",")
+        if empty_if_zero and zeros:
+            hexes = ["" if z else h for h, z in zip(hexes, zero)]
+        return hexes
+    
+    def from_hex_list(self, hex_list, size: int) -> bytes:
+        """Packed elements of size bytes from their hex strings (an odd length takes a
+        leading 0, each zero padded to size); raises ValueError on an empty or bad string."""
+        if self._hex_codec is not None:
+            return self._hex_codec.decode(hex_list, size)
+        n = len(hex_list)
+        if not self.hex_available:
+            return b"".join(_hex_element(h)[:size].ljust(size, b"\0") for h in hex_list)
+        text = ",".join(hex_list).encode("ascii", "replace")
+        out = create_string_buffer(n * size)
+        bad = self.lib.stealth_from_hex_batch_simple(text, len(text), n, size, out)
+        if bad:
+            # Name the offending string as the Python conversion would
+            for h in hex_list:
+                _hex_element(h)
+            raise ValueError("Invalid hex string in list")
+        return out.raw
+    
+    def addr_gen_batch(self, A_list, B_list, TK_bytes):
+        """Generate one address per (A, B) pair; returns (addrs, r1s, r2s, cs)."""
+        n = len(A_list)
+        if n == 0:
+            return [], [], [], []
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        outs = [create_string_buffer(n * s) for s in (g1, g1, g2, g1)]
+        if self.lib.stealth_addr_gen_batch(self._pack(A_list, g1), self._pack(B_list, g1),
+                                           TK_bytes, n, *outs) != n:
+            raise RuntimeError("stealth_addr_gen_batch failed")
+        return tuple(self._unpack(o, n, s) for o, s in zip(outs, (g1, g1, g2, g1)))
+    
+    def addr_gen_block(self, A_list, B_list, TK_bytes, num_threads: int = 0, tagged: bool = False,
+                       as_hex: bool = False):
+        """Generate one address per (A, B) pair across a worker pool.
+        Returns (addrs, r1s, r2s, cs, tags), as hex strings if as_hex; tags is None unless tagged."""
+        n = len(A_list)
+        if n == 0:
+            return [], [], [], [], [] if tagged else None
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        outs = [create_string_buffer(n * s) for s in (g1, g1, g2, g1)]
+        tag_buf = create_string_buffer(n * self.view_tag_length) if tagged else None
+        if self.lib.stealth_addr_gen_block_simple(self._pack(A_list, g1), self._pack(B_list, g1),
+                                                  TK_bytes, n, num_threads, *outs, tag_buf) != n:
+            raise RuntimeError("stealth_addr_gen_block_simple failed")
+        unpack = self._unpack_hex if as_hex else self._unpack
+        parts = tuple(unpack(o, n, s) for o, s in zip(outs, (g1, g1, g2, g1)))
+        return parts + (unpack(tag_buf, n, self.view_tag_length) if tagged else None,)
+    
+    def addr_gen_multi(self, A_list, B_list, TK_bytes, num_threads: int = 0, tagged: bool = False):
+        """Generate the outputs of one transaction to distinct recipients on a shared R1.
+        Returns (addrs, r1, r2s, cs, tags); tags is None unless tagged."""
+        n = len(A_list)
+        if n == 0:
+            return [], None, [], [], [] if tagged else None
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        outs = [create_string_buffer(n * s) for s in (g1, g2, g1)]
+        r1_buf = create_string_buffer(g1)
+        tag_buf = create_string_buffer(n * self.view_tag_length) if tagged else None
+        if self.lib.stealth_addr_gen_multi_simple(self._pack(A_list, g1), self._pack(B_list, g1),
+                                                  TK_bytes, n, num_threads, outs[0], r1_buf,
+                                                  outs[1], outs[2], tag_buf) != n:
+            raise RuntimeError("stealth_addr_gen_multi_simple failed (repeated recipient?)")
+        addrs, r2s, cs = (self._unpack(o, n, s) for o, s in zip(outs, (g1, g2, g1)))
+        tags = self._unpack(tag_buf, n, self.view_tag_length) if tagged else None
+        return addrs, r1_buf.raw, r2s, cs, tags
+    
+    def addr_recognize_fast_batch(self, r1_list, c_list, b_bytes, a_priv_bytes):
+        """Fast recognition of many outputs against one key; returns a list of bools."""
+        n = len(r1_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        results = create_string_buffer(n)
+        if self.lib.stealth_addr_recognize_fast_batch(self._pack(r1_list, g1), self._pack(c_list, g1),
+                                                      n, b_bytes, a_priv_bytes, results) < 0:
+            raise RuntimeError("stealth_addr_recognize_fast_batch failed")
+        return [bool(x) for x in results.raw[:n]]
+    
+    def addr_recognize_fast_tagged_batch(self, r1_list, c_list, tag_list, b_bytes, a_priv_bytes):
+        """Fast recognition of many tagged outputs against one key; returns a list of bools."""
+        n = len(r1_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        results = create_string_buffer(n)
+        if self.lib.stealth_addr_recognize_fast_tagged_batch(self._pack(r1_list, g1), self._pack(c_list, g1),
+                                                             self._pack(tag_list, self.view_tag_length), n,
+                                                             b_bytes, a_priv_bytes, results) < 0:
+            raise RuntimeError("stealth_addr_recognize_fast_tagged_batch failed")
+        return [bool(x) for x in results.raw[:n]]
+    
+    def recognize_multi(self, r1_bytes, c_bytes, a_priv_list, b_list, tag_bytes=None) -> int:
+        """Find the owner of one output among many key pairs; returns its list index or -1."""
+        n = len(a_priv_list)
+        if n == 0:
+            return -1
+        g1, zr = self.get_element_sizes()
+        result = self.lib.stealth_recognize_multi_simple(r1_bytes, c_bytes, tag_bytes,
+                                                         self._pack(a_priv_list, zr), self._pack(b_list, g1), n)
+        if result < -1:
+            raise RuntimeError("stealth_recognize_multi_simple failed")
+        return result
+    
+    def recognize_multi_block(self, r1_list, c_list, a_priv_list, b_list, tag_list=None,
+                              num_threads: int = 0):
+        """Find the owner of each output among many key pairs across a worker pool.
+        tag_list holds one view tag or None per output; returns key list indices, -1 if unowned."""
+        n, k = len(r1_list), len(a_priv_list)
+        if n == 0 or k == 0:
+            return [-1] * n
+        g1, zr = self.get_element_sizes()
+        tags = tagged = None
+        if tag_list is not None and any(t is not None for t in tag_list):
+            tags = self._pack([t or b"" for t in tag_list], self.view_tag_length)
+            tagged = bytes(t is not None for t in tag_list)
+        owners = (c_int * n)()
+        if self.lib.stealth_recognize_multi_block_simple(self._pack(r1_list, g1), self._pack(c_list, g1),
+                                                         tags, tagged, n, self._pack(a_priv_list, zr),
+                                                         self._pack(b_list, g1), k, num_threads, owners) < 0:
+            raise RuntimeError("stealth_recognize_multi_block_simple failed")
+        return list(owners)
+    
+    def dsk_gen_batch(self, addr_list, r1_list, a_bytes, b_bytes):
+        """Generate DSKs for many addresses of one key pair."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        dsk_buf = create_string_buffer(n * g2)
+        if self.lib.stealth_dsk_gen_batch(self._pack(addr_list, g1), self._pack(r1_list, g1),
+                                          n, a_bytes, b_bytes, dsk_buf) != n:
+            raise RuntimeError("stealth_dsk_gen_batch failed")
+        return self._unpack(dsk_buf, n, g2)
+    
+    def verify_batch(self, addr_list, r2_list, c_list, message_list, h_list, q_sigma_list):
+        """Verify many signatures; returns a list of bools."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, zr = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        lens = (c_int * n)(*[len(m) for m in message_list])
+        results = create_string_buffer(n)
+        if self.lib.stealth_verify_batch(self._pack(addr_list, g1), self._pack(r2_list, g2),
+                                         self._pack(c_list, g1), b"".join(message_list), lens,
+                                         self._pack(h_list, zr), self._pack(q_sigma_list, g2),
+                                         n, results) < 0:
+            raise RuntimeError("stealth_verify_batch failed")
+        return [bool(x) for x in results.raw[:n]]
+    
+    def aggregate(self, addr_list, c_list, message_list, h_list, q_sigma_list):
+        """Aggregate many signatures into (commitments, q_agg).
+        Returns (None, results) if some signature is invalid, results a list of bools."""
+        n = len(addr_list)
+        if n == 0:
+            raise ValueError("nothing to aggregate")
+        g1, zr = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        gt = self.lib.stealth_element_size_GT()
+        lens = (c_int * n)(*[len(m) for m in message_list])
+        x_buf = create_string_buffer(n * gt)
+        q_buf = create_string_buffer(g2)
+        results = create_string_buffer(n)
+        aggregated = self.lib.stealth_aggregate_batch(self._pack(addr_list, g1), self._pack(c_list, g1),
+                                                      b"".join(message_list), lens,
+                                                      self._pack(h_list, zr), self._pack(q_sigma_list, g2),
+                                                      n, x_buf, q_buf, results)
+        if aggregated < 0:
+            raise RuntimeError("stealth_aggregate_batch failed")
+        valid = [bool(x) for x in results.raw[:n]]
+        if aggregated != n:
+            return None, valid
+        return (self._unpack(x_buf, n, gt), q_buf.raw), valid
+    
+    def verify_aggregate(self, addr_list, r2_list, c_list, message_list, x_list, q_agg) -> bool:
+        """Verify an aggregate from aggregate() against the block it covers."""
+        n = len(addr_list)
+        if n == 0:
+            return False
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        gt = self.lib.stealth_element_size_GT()
+        lens = (c_int * n)(*[len(m) for m in message_list])
+        result = self.lib.stealth_verify_aggregate_batch(self._pack(addr_list, g1), self._pack(r2_list, g2),
+                                                         self._pack(c_list, g1), b"".join(message_list),
+                                                         lens, self._pack(x_list, gt), q_agg, n)
+        if result < 0:
+            raise RuntimeError("stealth_verify_aggregate_batch failed")
+        return result == 1
+    
+    def addr_audit_batch(self, addr_list, r1_list, r2_list, c_list, B_bytes, a_bytes, TK_bytes):
+        """Full recognition of many addresses of one key pair, R2 included; returns a list of bools."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        results = create_string_buffer(n)
+        if self.lib.stealth_addr_audit_batch_simple(self._pack(addr_list, g1), self._pack(r1_list, g1),
+                                                    self._pack(r2_list, g2), self._pack(c_list, g1), n,
+                                                    B_bytes, a_bytes, TK_bytes, results) < 0:
+            raise RuntimeError("stealth_addr_audit_batch_simple failed")
+        return [bool(x) for x in results.raw[:n]]
+    
+    def trace_batch(self, addr_list, r1_list, r2_list, c_list, k_bytes):
+        """Trace many addresses with one trace key; returns recovered B values."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        b_buf = create_string_buffer(n * g1)
+        if self.lib.stealth_trace_batch_simple(self._pack(addr_list, g1), self._pack(r1_list, g1),
+                                               self._pack(r2_list, self.get_g2_size()), self._pack(c_list, g1),
+                                               n, k_bytes, b_buf) != n:
+            raise RuntimeError("stealth_trace_batch_simple failed")
+        return self._unpack(b_buf, n, g1)
+    
+    def addr_recognize_fast_buffer(self, r1s, cs, b_bytes, a_priv_bytes, out=None):
+        """Fast recognition of n outputs given as contiguous (n, G1 size) buffers.
+        Writes one 0/1 byte per output into out (a writable buffer of n bytes, new bytearray if None)."""
+        g1, _ = self.get_element_sizes()
+        r1s, n = buffer_rows(r1s, g1, "r1s")
+        cs, n_c = buffer_rows(cs, g1, "cs")
+        if n_c != n:
+            raise ValueError("r1s and cs differ in length")
+        out = bytearray(n) if out is None else out
+        if n and self._call_buffers("stealth_addr_recognize_fast_batch", r1s, cs, n, b_bytes, a_priv_bytes,
+                                    buffer_rows(out, n, "out")[0]) < 0:
+            raise RuntimeError("stealth_addr_recognize_fast_batch failed")
+        return out
+    
+    def trace_buffer(self, addrs, r1s, r2s, cs, k_bytes, out=None):
+        """Trace n addresses given as contiguous (n, element size) buffers.
+        Writes the recovered B values into out (n * G1 size bytes, new bytearray if None)."""
+        g1, _ = self.get_element_sizes()
+        addrs, n = buffer_rows(addrs, g1, "addrs")
+        rows = [buffer_rows(b, s, w) for b, s, w in ((r1s, g1, "r1s"), (r2s, self.get_g2_size(), "r2s"),
+                                                     (cs, g1, "cs"))]
+        if any(m != n for _, m in rows):
+            raise ValueError("addrs, r1s, r2s and cs differ in length")
+        out = bytearray(n * g1) if out is None else out
+        if n and self._call_buffers("stealth_trace_batch_simple", addrs, *(v for v, _ in rows), n, k_bytes,
+                                    buffer_rows(out, n * g1, "out")[0]) != n:
+            raise RuntimeError("stealth_trace_batch_simple failed")
+        return out
+    
+    def verify_buffer(self, addrs, r2s, cs, messages, message_lens, hs, q_sigmas, out=None):
+        """Verify n signatures given as contiguous (n, element size) buffers, the messages
+        concatenated in one buffer and their lengths in a C int array (array('i'), NumPy int32).
+        Writes one 0/1 byte per signature into out (n bytes, new bytearray if None)."""
+        g1, zr = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        addrs, n = buffer_rows(addrs, g1, "addrs")
+        rows = [buffer_rows(b, s, w) for b, s, w in ((r2s, g2, "r2s"), (cs, g1, "cs"), (hs, zr, "hs"),
+                                                     (q_sigmas, g2, "q_sigmas"))]
+        lens = memoryview(message_lens).cast("B").cast("i")
+        if any(m != n for _, m in rows) or len(lens) != n:
+            raise ValueError("signature buffers differ in length")
+        messages = memoryview(messages).cast("B")
+        if any(x < 0 for x in lens) or sum(lens) > len(messages):
+            raise ValueError("message lengths exceed the message buffer")
+        if "stealth_verify_batch" not in self._native_bound:
+            lens = (c_int * n)(*lens)
+        out = bytearray(n) if out is None else out
+        (r2s, _), (cs, _), (hs, _), (q_sigmas, _) = rows
+        if n and self._call_buffers("stealth_verify_batch", addrs, r2s, cs, messages, lens, hs, q_sigmas, n,
+                                    buffer_rows(out, n, "out")[0]) < 0:
+            raise RuntimeError("stealth_verify_batch failed")
+        return out
+    
+    def ingest(self, addr_list, r1_list, c_list, b_bytes, a_bytes, b_priv_bytes, tag_list=None):
+        """Scan outputs and derive the DSKs of owned ones; returns [(index, dsk)] in stream order."""
+        n = len(addr_list)
+        if n == 0:
+            return []
+        g1, _ = self.get_element_sizes()
+        g2 = self.get_g2_size()
+        tagged = tag_list is not None
+        records = b"".join(self._pack(parts, g1) +
+                           (self._pack([tag_list[i]], self.view_tag_length) if tagged else b"")
+                           for i, parts in enumerate(zip(addr_list, r1_list, c_list)))
+        owned = (c_int * n)()
+        dsk_buf = create_string_buffer(n * g2)
+        count = self.lib.stealth_ingest_simple(records, n, int(tagged), b_bytes, a_bytes,
+                                               b_priv_bytes, owned, dsk_buf)
+        if count < 0:
+            raise RuntimeError("stealth_ingest_simple failed")
+        return list(zip(owned[:count], self._unpack(dsk_buf, count, g2)))
+    
+    # Record store interface. Kinds and element layouts mirror
+    # stealth_python_api.h; elements are raw wire bytes.
+    STORE_KEYS, STORE_ADDRS, STORE_DSKS, STORE_SYSTEM, STORE_CURSORS, STORE_TRACES = 1, 2, 3, 4, 5, 6
+    # 'H' is an element of G2, the same size as 'G' under a symmetric pairing
+    STORE_LAYOUTS = {1: "GGZZ", 2: "GGHG", 3: "H", 4: "GHZ", 5: "", 6: "G"}
+    STORE_FLAG_TAGGED = 1
+    
+    def store_meta_size(self, kind: int) -> int:
+        """Bytes of the metadata trailer of a record kind."""
+        if kind == self.STORE_ADDRS:
+            return 4 + 1 + self.view_tag_length
+        if kind == self.STORE_CURSORS:
+            return 4 + 8 + 8 + 8
+        if kind == self.STORE_TRACES:
+            return 4 + 4 + 4
+        return 4 + 4 + 1 if kind == self.STORE_DSKS else 0
+    
+    def _store_sizes(self, kind: int):
+        g1, zr = self.get_element_sizes()
+        sizes = {"G": g1, "H": self.get_g2_size(), "Z": zr}
+        return [sizes[t] for t in self.STORE_LAYOUTS[kind]]
+    
+    def store_open(self, path: str, kind: int) -> int:
+        """Open (or create) a store file; returns its handle."""
+        h = self.lib.stealth_store_open_simple(path.encode(), kind)
+        if h == -2:
+            raise ValueError(f"Store {path} was written with another parameter set or record layout")
+        if h < 0:
+            raise RuntimeError(f"Cannot open store {path}")
+        return h
+    
+    def store_append(self, h: int, kind: int, elems, meta: bytes = b"") -> int:
+        """Append one record; returns its index."""
+        packed = b"".join(bytes(e[:n]).ljust(n, b"\0") for e, n in zip(elems, self._store_sizes(kind)))
+        meta = meta.ljust(self.store_meta_size(kind), b"\0")
+        index = self.lib.stealth_store_append_simple(h, packed, meta or None)
+        if index < 0:
+            raise RuntimeError("stealth_store_append_simple failed")
+        return index
+    
+    def store_get(self, h: int, kind: int, index: int):
+        """Read one record back; returns (elements, metadata bytes)."""
+        sizes = self._store_sizes(kind)
+        elems_buf = create_string_buffer(sum(sizes))
+        meta_buf = create_string_buffer(max(self.store_meta_size(kind), 1))
+        if self.lib.stealth_store_get_simple(h, index, elems_buf, meta_buf) != 0:
+            raise IndexError(f"store record {index} out of range")
+        raw, elems, off = elems_buf.raw, [], 0
+        for n in sizes:
+            elems.append(raw[off:off + n])
+            off += n
+        return elems, meta_buf.raw[:self.store_meta_size(kind)]
+    
+    def store_count(self, h: int) -> int:
+        """Number of records in a store."""
+        return self.lib.stealth_store_count_simple(h)
+    
+    def store_reset(self, h: int):
+        """Drop every record of a store."""
+        self.lib.stealth_store_reset_simple(h)
+    
+    def store_sync(self, h: int):
+        """Flush a store to disk."""
+        self.lib.stealth_store_sync_simple(h)
+    
+    def store_close(self, h: int):
+        """Close a store."""
+        self.lib.stealth_store_close_simple(h)
+    
+    def store_save_system(self, h: int, TK_bytes, k_bytes) -> bool:
+        """Save the session generator and tracer key pair."""
+        return self.lib.stealth_store_save_system_simple(h, TK_bytes, k_bytes) == 0
+    
+    def store_load_system(self, h: int):
+        """Restore a saved generator; returns the saved (TK, k) bytes, None if none is saved."""
+        g2, zr = self.get_g2_size(), self.get_element_sizes()[1]
+        TK_buf, k_buf = create_string_buffer(max(g2, zr)), create_string_buffer(max(g2, zr))
+        rc = self.lib.stealth_store_load_system_simple(h, TK_buf, k_buf, max(g2, zr))
+        if rc < 0:
+            raise RuntimeError("stealth_store_load_system_simple failed")
+        return (TK_buf.raw[:g2], k_buf.raw[:zr]) if rc == 1 else None
+    
+    def store_recognize_fast(self, addr_h: int, addr_index: int, key_h: int, key_index: int) -> bool:
+        """Fast recognition of a stored address with a stored key."""
+        return self.lib.stealth_store_recognize_fast_simple(addr_h, addr_index, key_h, key_index) == 1
+    
+    def store_scan(self, addr_h: int, start: int, n: int, key_h: int, key_index: int):
+        """Scan n stored addresses from start for one stored key; returns one bool per address."""
+        if n <= 0:
+            return []
+        results = create_string_buffer(n)
+        if self.lib.stealth_store_scan_simple(addr_h, start, n, key_h, key_index, results) < 0:
+            raise RuntimeError("stealth_store_scan_simple failed")
+        return [b == 1 for b in results.raw]
+    
+    def store_scan_owners(self, addr_h: int, start: int, n: int, key_h: int, key_indices,
+                          num_threads: int = 0):
+        """Find the owner of each of n stored addresses from start among the stored keys
+        key_indices, across a worker pool; returns key records, -1 if unowned."""
+        k = len(key_indices)
+        if n <= 0 or k == 0:
+            return [-1] * max(n, 0)
+        owners = (c_int * n)()
+        if self.lib.stealth_store_scan_owners_simple(addr_h, start, n, key_h, (c_long * k)(*key_indices),
+                                                     k, num_threads, owners) < 0:
+            raise RuntimeError("stealth_store_scan_owners_simple failed")
+        return list(owners)
+    
+    def store_cursor(self, cur_h: int, key_index: int):
+        """Scan cursor of a stored key; returns (next address record, outputs found before it)."""
+        owned = c_long(0)
+        cursor = self.lib.stealth_store_cursor_simple(cur_h, key_index, byref(owned))
+        if cursor < 0:
+            raise RuntimeError("stealth_store_cursor_simple failed")
+        return cursor, owned.value
+    
+    def store_sync_scan(self, addr_h: int, key_h: int, key_index: int, cur_h: int, dsk_h: int = -1,
+                        dsk_flags: int = 0, max_n: int = 0):
+        """Scan the stored addresses from the key's cursor, store a DSK for each recognized one
+        in dsk_h (-1 for none) and checkpoint the new cursor; returns (address records found, cursor)."""
+        # Bound the scan so every output found fits the result array, even if
+        # other processes append addresses meanwhile
+        n = max(self.store_count(addr_h), 1)
+        if max_n > 0:
+            n = min(n, max_n)
+        owned, cursor = (c_long * n)(), c_long(0)
+        found = self.lib.stealth_store_sync_scan_simple(addr_h, key_h, key_index, cur_h, dsk_h, dsk_flags, n,
+                                                        owned, n, byref(cursor))
+        if found < 0:
+            raise RuntimeError("stealth_store_sync_scan_simple failed")
+        return list(owned[:found]), cursor.value
+    
+    def store_trace_sync(self, addr_h: int, trace_h: int, k_bytes, max_n: int = 0) -> int:
+        """Trace the stored addresses not traced yet into a trace store; returns how many."""
+        traced = self.lib.stealth_store_trace_sync_simple(addr_h, trace_h, k_bytes, max_n)
+        if traced < 0:
+            raise RuntimeError("stealth_store_trace_sync_simple failed")
+        return traced
+    
+    def store_trace_find(self, trace_h: int, B_bytes):
+        """Address records traced to public key B, in ascending order."""
+        n = self.lib.stealth_store_trace_find_simple(trace_h, B_bytes, None, 0)
+        if n < 0:
+            raise RuntimeError("stealth_store_trace_find_simple failed")
+        if n == 0:
+            return []
+        out = (c_long * n)()
+        n = min(n, self.lib.stealth_store_trace_find_simple(trace_h, B_bytes, out, n))
+        return sorted(out[:n])
+    
+    def store_open_key_tables(self, path: str) -> int:
+        """Open (or create) the key table store kept next to a key store."""
+        h = self.lib.stealth_store_open_key_tables_simple(path.encode())
+        if h == -2:
+            raise RuntimeError(f"{path} was written with another layout")
+        if h < 0:
+            raise RuntimeError(f"Cannot open key table store {path}")
+        return h
+    
+    def store_key_tables_sync(self, key_h: int, tables_h: int) -> int:
+        """Build the tables of the stored keys that have none yet; returns how many were added."""
+        added = self.lib.stealth_store_key_tables_sync_simple(key_h, tables_h)
+        if added < 0:
+            raise RuntimeError("stealth_store_key_tables_sync_simple failed")
+        return added
+    
+    def store_registry_load(self, key_h: int) -> int:
+        """Rebuild the key registry from a key store; returns the number of keys."""
+        return self.lib.stealth_store_registry_load_simple(key_h)
+    
+    def store_registry_load_addrs(self, addr_h: int) -> int:
+        """Rebuild the address index from an address store; returns the number of addresses."""
+        return self.lib.stealth_store_registry_load_addrs_simple(addr_h)
+    
     def performance_test(self, iterations: int, results):
         """Run performance test."""
         self.lib.stealth_performance_test_simple(iterations, results)
+    
+    # Doubles per operation filled by stealth_benchmark_simple (STEALTH_BENCH_FIELDS)
+    BENCH_FIELDS = ("op", "threads", "items", "wall_ms", "items_per_sec", "setup_ms",
+                    "mean_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms")
+    
+    def benchmark(self, ops: List[str], iterations: int, batch_size: int, num_threads: int,
+                  precompute: bool, warmup: int) -> Dict[str, Dict[str, float]]:
+        """Run stealth_benchmark on the named operations (LATENCY_OPS names)."""
+        mask = 0
+        for name in ops:
+            mask |= 1 << self.LATENCY_OPS.index(name)
+        n = len(self.LATENCY_OPS)
+        width = len(self.BENCH_FIELDS)
+        results = (c_double * (n * width))()
+        filled = self.lib.stealth_benchmark_simple(mask, iterations, batch_size, num_threads,
+                                                   int(precompute), warmup, results, n)
+        if filled < 0:
+            raise RuntimeError("stealth_benchmark_simple failed")
+        out = {}
+        for i in range(filled):
+            row = dict(zip(self.BENCH_FIELDS, results[i * width:(i + 1) * width]))
+            row["threads"], row["items"] = int(row["threads"]), int(row["items"])
+            out[self.LATENCY_OPS[int(row.pop("op"))]] = row
+        return out
 
 
 # Global library instance - lazy initialization
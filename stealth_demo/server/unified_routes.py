@@ -1,14 +1,47 @@
 """
 Unified API routes for the multi-scheme cryptographic demo application.
-Routes automatically dispatch to the current active scheme.
+Routes dispatch to the scheme the request names (see common/request_scheme.py),
+else to the default scheme set by /switch_scheme.
 """
-from flask import request, jsonify
+from flask import request, jsonify, Response
 from .multi_scheme_config import config
 from .scheme_manager import scheme_manager
+from .common.metrics import render_metrics, CONTENT_TYPE
+from .common.jobs import job_manager
+from .common.shared_session import shared_session
+from .common.base_utils import validate_index
+from .common.list_stream import list_response, iter_import_body
+from .common.response_cache import response_cache
+from .common import live_metrics, request_scheme
+
+# Most items one bulk job may create or trace
+MAX_BULK_ITEMS = 10000
+
+# Lists accepted by /import/<name>
+IMPORT_LISTS = {"keys": "key_list", "addresses": "address_list", "dsks": "dsk_list"}
+
+# Optional seed of a reproducible performance test or benchmark run
+SEED_ERROR = "seed must be an integer from 0 to 4294967295"
+
+
+def valid_seed(seed):
+    return seed is None or (isinstance(seed, int) and not isinstance(seed, bool)
+                            and 0 <= seed < 2 ** 32)
+
+
+def state_version():
+    """Version of everything the cached GET endpoints report."""
+    return config.state_version(), scheme_manager.current_scheme
+
+
+def param_files_version():
+    return state_version(), config.param_dir_version()
 
 
 def setup_routes(app):
     """Setup all API routes for the Flask app."""
+    live_metrics.request_gauge.install(app)
+    request_scheme.install(app)
     
     # Scheme management routes
     @app.route("/schemes", methods=["GET"])
@@ -21,7 +54,7 @@ def setup_routes(app):
     
     @app.route("/switch_scheme", methods=["POST"])
     def switch_scheme():
-        """Switch to a different cryptographic scheme"""
+        """Switch the default scheme, of requests that name none"""
         try:
             data = request.get_json()
             if not data or 'scheme' not in data:
@@ -29,15 +62,12 @@ def setup_routes(app):
             
             scheme_name = data['scheme']
             result = scheme_manager.switch_scheme(scheme_name)
-            
-            # Update config to track current scheme
-            config.set_current_scheme(scheme_name)
-            
             return jsonify(result)
         except Exception as e:
             raise e
     
     @app.route("/scheme_capabilities", methods=["GET"])
+    @response_cache.cached(state_version)
     def get_scheme_capabilities():
         """Get capabilities of current or specified scheme"""
         try:
@@ -49,6 +79,7 @@ def setup_routes(app):
     
     # Parameter file management (shared across schemes)
     @app.route("/param_files", methods=["GET"])
+    @response_cache.cached(param_files_version)
     def get_param_files():
         """Get list of available parameter files"""
         try:
@@ -66,7 +97,15 @@ def setup_routes(app):
                 return jsonify({"error": "Please specify param_file"}), 400
             
             param_file = data['param_file']
-            result = scheme_manager.setup_system(param_file)
+            point_format = data.get('point_format', 'uncompressed')
+            if point_format not in ('uncompressed', 'compressed'):
+                return jsonify({"error": "point_format must be 'uncompressed' or 'compressed'"}), 400
+
+            hash_version = data.get('hash_version', 1)
+            if hash_version not in (1, 2):
+                return jsonify({"error": "hash_version must be 1 (g^H(x)) or 2 (map-to-curve)"}), 400
+
+            result = scheme_manager.setup_system(param_file, point_format, hash_version)
             return jsonify(result)
             
         except Exception as e:
@@ -84,13 +123,10 @@ def setup_routes(app):
             raise e
 
     @app.route("/keylist", methods=["GET"])
+    @response_cache.cached(state_version)
     def keylist():
-        """Get list of all generated keys for current scheme"""
-        return jsonify({
-            "keys": config.key_list,
-            "scheme": config.current_scheme,
-            "count": len(config.key_list)
-        })
+        """Get the keys of current scheme, whole, paged or streamed"""
+        return list_response("keys", config.key_list, {"scheme": config.current_scheme})
 
     @app.route("/addrgen", methods=["POST"])
     def addrgen():
@@ -107,14 +143,29 @@ def setup_routes(app):
         except Exception as e:
             raise e
 
+    @app.route("/addrgen_bulk", methods=["POST"])
+    def addrgen_bulk():
+        """Generate count addresses spread over key_indices (default: every key)"""
+        try:
+            data = request.get_json() or {}
+            key_indices = data.get('key_indices')
+            if key_indices is not None and not isinstance(key_indices, list):
+                return jsonify({"error": "key_indices must be a list"}), 400
+            threads = data.get('threads', 0)
+            if not isinstance(threads, int):
+                return jsonify({"error": "threads must be an integer"}), 400
+
+            result = scheme_manager.generate_addresses_bulk(bulk_count(data), key_indices, threads)
+            return jsonify(result)
+
+        except Exception as e:
+            raise e
+
     @app.route("/addresslist", methods=["GET"])
+    @response_cache.cached(state_version)
     def addresslist():
-        """Get list of all generated addresses for current scheme"""
-        return jsonify({
-            "addresses": config.address_list,
-            "scheme": config.current_scheme,
-            "count": len(config.address_list)
-        })
+        """Get the addresses of current scheme, whole, paged or streamed"""
+        return list_response("addresses", config.address_list, {"scheme": config.current_scheme})
 
     @app.route("/recognize_addr", methods=["POST"])
     def recognize_addr():
@@ -145,11 +196,86 @@ def setup_routes(app):
         except Exception as e:
             raise e
 
+    @app.route("/lookup_address", methods=["POST"])
+    def lookup_address():
+        """Whether addr_hex is a known one-time address, and the key it was generated for"""
+        try:
+            data = request.get_json()
+            if not data or 'addr_hex' not in data:
+                return jsonify({"error": "Please specify addr_hex"}), 400
+
+            result = scheme_manager.lookup_address(data['addr_hex'])
+            return jsonify(result)
+
+        except Exception as e:
+            raise e
+
+    @app.route("/recognize_multi", methods=["POST"])
+    def recognize_multi():
+        """Find which key owns an address (all keys, or the given key_indices)"""
+        try:
+            data = request.get_json()
+            if not data or 'address_index' not in data:
+                return jsonify({"error": "Please specify address_index"}), 400
+
+            key_indices = data.get('key_indices')
+            if key_indices is not None and not isinstance(key_indices, list):
+                return jsonify({"error": "key_indices must be a list"}), 400
+
+            result = scheme_manager.recognize_address_multi(data['address_index'], key_indices)
+            return jsonify(result)
+
+        except Exception as e:
+            raise e
+
+    @app.route("/scan", methods=["POST"])
+    def scan_addresses():
+        """Find every address owned by key_index, or the owners among key_indices
+        (default: every key) of the addresses from start. With sync, resume the
+        scan of key_index from its stored checkpoint instead (up to count addresses)"""
+        try:
+            data = request.get_json() or {}
+            if data.get('sync'):
+                count = data.get('count')
+                if 'key_index' not in data:
+                    return jsonify({"error": "Please specify key_index"}), 400
+                if count is not None and (not isinstance(count, int) or count < 0):
+                    return jsonify({"error": "count must be a non-negative integer"}), 400
+                result = scheme_manager.sync_addresses(data['key_index'], count)
+                return jsonify(result)
+            if 'key_index' in data:
+                result = scheme_manager.scan_addresses(data['key_index'])
+                return jsonify(result)
+
+            key_indices = data.get('key_indices')
+            if key_indices is not None and not isinstance(key_indices, list):
+                return jsonify({"error": "key_indices must be a list"}), 400
+            start, count, threads = data.get('start', 0), data.get('count'), data.get('threads', 0)
+            if not isinstance(start, int) or start < 0 or not isinstance(threads, int):
+                return jsonify({"error": "start and threads must be integers, start from 0"}), 400
+            if count is not None and (not isinstance(count, int) or count < 0):
+                return jsonify({"error": "count must be a non-negative integer"}), 400
+
+            result = scheme_manager.scan_addresses_bulk(key_indices, start, count, threads)
+            return jsonify(result)
+
+        except Exception as e:
+            raise e
+
     @app.route("/dskgen", methods=["POST"])
     def dskgen():
-        """Generate DSK for selected address and key using current scheme"""
+        """Generate DSK for selected address and key using current scheme; address_indices
+        (a list) instead of address_index derives the DSKs of many addresses of that key at once"""
         try:
             data = request.get_json()
+            if data and 'address_indices' in data and 'key_index' in data:
+                address_indices = data['address_indices']
+                if not isinstance(address_indices, list) or len(address_indices) > MAX_BULK_ITEMS:
+                    return jsonify({"error": f"address_indices must be a list of at most {MAX_BULK_ITEMS}"}), 400
+                threads = data.get('threads', 0)
+                if not isinstance(threads, int):
+                    return jsonify({"error": "threads must be an integer"}), 400
+                return jsonify(scheme_manager.generate_dsks(address_indices, data['key_index'], threads))
             if not data or 'address_index' not in data or 'key_index' not in data:
                 return jsonify({"error": "Please specify address_index and key_index"}), 400
             
@@ -162,13 +288,18 @@ def setup_routes(app):
             raise e
 
     @app.route("/dsklist", methods=["GET"])
+    @response_cache.cached(state_version)
     def dsklist():
-        """Get list of all generated DSKs for current scheme"""
-        return jsonify({
-            "dsks": config.dsk_list,
-            "scheme": config.current_scheme,
-            "count": len(config.dsk_list)
-        })
+        """Get the DSKs of current scheme, whole, paged or streamed"""
+        return list_response("dsks", config.dsk_list, {"scheme": config.current_scheme})
+
+    @app.route("/import/<name>", methods=["POST"])
+    def import_records(name):
+        """Append keys, addresses or DSKs streamed as NDJSON or a CBOR sequence"""
+        if name not in IMPORT_LISTS:
+            return jsonify({"error": f"Unknown list {name}, expected one of {', '.join(IMPORT_LISTS)}"}), 404
+        result = scheme_manager.import_records(IMPORT_LISTS[name], iter_import_body())
+        return jsonify(result)
 
     @app.route("/sign", methods=["POST"])
     def sign_message():
@@ -248,11 +379,15 @@ def setup_routes(app):
 
     @app.route("/trace", methods=["POST"])
     def trace_identity():
-        """Trace identity for selected address using current scheme"""
+        """Trace identity for selected address using current scheme, or with
+        key_index or B_hex instead, list every address traced to that key"""
         try:
             data = request.get_json()
+            if data and ('key_index' in data or 'B_hex' in data):
+                result = scheme_manager.trace_owner_addresses(data.get('key_index'), data.get('B_hex'))
+                return jsonify(result)
             if not data or 'address_index' not in data:
-                return jsonify({"error": "Please specify address_index"}), 400
+                return jsonify({"error": "Please specify address_index, key_index or B_hex"}), 400
             
             addr_index = data['address_index']
             result = scheme_manager.trace_identity(addr_index)
@@ -265,14 +400,162 @@ def setup_routes(app):
     def performance_test():
         """Run performance test using current scheme"""
         try:
-            data = request.get_json()
-            iterations = data.get('iterations', 100) if data else 100
-            result = scheme_manager.performance_test(iterations)
+            data = request.get_json() or {}
+            iterations = data.get('iterations', 100)
+            if not valid_seed(data.get('seed')):
+                return jsonify({"error": SEED_ERROR}), 400
+            result = scheme_manager.performance_test(iterations, seed=data.get('seed'))
             return jsonify(result)
         except Exception as e:
             raise e
 
+    @app.route("/latency", methods=["GET"])
+    def latency():
+        """Latency percentiles of the current scheme's operations since the last performance reset"""
+        config.ensure_initialized()
+        return jsonify(scheme_manager.latency_stats())
+
+    # Background jobs: submit returns 202 with the job, whose state is
+    # then polled at /jobs/<id> or followed at /jobs/<id>/events
+    def submit_job(kind, work, total=0):
+        if shared_session.enabled:
+            # Job state lives in one process, and the next poll may reach another
+            return jsonify({"error": "Jobs need a single-process server (STEALTH_SERVER_WORKERS=1)"}), 409
+        config.ensure_initialized()
+        service = scheme_manager.get_current_service()
+        job = job_manager.submit(kind, scheme_manager.get_current_scheme_name(),
+                                 lambda job: work(service, job), total)
+        return jsonify(job.to_dict()), 202
+
+    def bulk_count(data, field='count'):
+        count = data.get(field, 1)
+        if not isinstance(count, int) or not 1 <= count <= MAX_BULK_ITEMS:
+            raise ValueError(f"{field} must be an integer from 1 to {MAX_BULK_ITEMS}")
+        return count
+
+    @app.route("/jobs/performance_test", methods=["POST"])
+    def job_performance_test():
+        """Run the performance test of the current scheme as a job"""
+        data = request.get_json() or {}
+        iterations = data.get('iterations', 100)
+        if not isinstance(iterations, int) or iterations < 1:
+            return jsonify({"error": "iterations must be a positive integer"}), 400
+        seed = data.get('seed')
+        if not valid_seed(seed):
+            return jsonify({"error": SEED_ERROR}), 400
+
+        def work(service, job):
+            return service.performance_test(iterations, job.progress, seed)
+        return submit_job("performance_test", work, iterations)
+
+    @app.route("/jobs/benchmark", methods=["POST"])
+    def job_benchmark():
+        """Run the configurable benchmark of the current scheme as a job, one step per operation"""
+        data = request.get_json() or {}
+        options = {}
+        for field in ('iterations', 'batch_size', 'num_threads', 'warmup'):
+            if field in data:
+                if not isinstance(data[field], int) or isinstance(data[field], bool):
+                    return jsonify({"error": f"{field} must be an integer"}), 400
+                options[field] = data[field]
+        if 'ops' in data:
+            if not isinstance(data['ops'], list) or not all(isinstance(op, str) for op in data['ops']):
+                return jsonify({"error": "ops must be a list of operation names"}), 400
+            options['ops'] = data['ops']
+        if 'precompute' in data:
+            options['precompute'] = bool(data['precompute'])
+        if 'seed' in data:
+            if not valid_seed(data['seed']):
+                return jsonify({"error": SEED_ERROR}), 400
+            options['seed'] = data['seed']
+
+        def work(service, job):
+            return service.benchmark(progress=job.progress, **options)
+        return submit_job("benchmark", work)
+
+    @app.route("/jobs/keygen", methods=["POST"])
+    def job_keygen():
+        """Generate count key pairs as a job"""
+        count = bulk_count(request.get_json() or {})
+
+        def work(service, job):
+            indices = []
+            for i in range(count):
+                indices.append(service.generate_keypair()["index"])
+                job.progress(i + 1)
+            return {"key_indices": indices, "count": len(indices)}
+        return submit_job("keygen", work, count)
+
+    @app.route("/jobs/addrgen", methods=["POST"])
+    def job_addrgen():
+        """Generate count addresses for key_index as a job"""
+        data = request.get_json() or {}
+        if 'key_index' not in data:
+            return jsonify({"error": "Please specify key_index"}), 400
+        config.ensure_initialized()
+        key_index = data['key_index']
+        validate_index(key_index, config.key_list, "key_index")
+        count = bulk_count(data)
+
+        def work(service, job):
+            indices = []
+            for i in range(count):
+                indices.append(service.generate_address(key_index)["index"])
+                job.progress(i + 1)
+            return {"address_indices": indices, "key_index": key_index, "count": len(indices)}
+        return submit_job("addrgen", work, count)
+
+    @app.route("/jobs/trace", methods=["POST"])
+    def job_trace():
+        """Trace address_indices (default: every address) as a job"""
+        data = request.get_json() or {}
+        config.ensure_initialized()
+        indices = data.get('address_indices')
+        if indices is None:
+            indices = list(range(len(config.address_list)))
+        if not isinstance(indices, list) or len(indices) > MAX_BULK_ITEMS:
+            return jsonify({"error": f"address_indices must be a list of at most {MAX_BULK_ITEMS}"}), 400
+        for address_index in indices:
+            validate_index(address_index, config.address_list, "address_index")
+
+        def work(service, job):
+            traces = []
+            for i, address_index in enumerate(indices):
+                traces.append(service.trace_identity(address_index))
+                job.progress(i + 1)
+            return {"traces": traces, "count": len(traces)}
+        return submit_job("trace", work, len(indices))
+
+    @app.route("/jobs", methods=["GET"])
+    def list_jobs():
+        """Recent jobs, oldest first"""
+        return jsonify({"jobs": job_manager.list(), "active": job_manager.active()})
+
+    @app.route("/jobs/<job_id>", methods=["GET"])
+    def get_job(job_id):
+        job = job_manager.get(job_id)
+        if job is None:
+            return jsonify({"error": f"No job {job_id}"}), 404
+        return jsonify(job.to_dict())
+
+    @app.route("/jobs/<job_id>", methods=["DELETE"])
+    def cancel_job(job_id):
+        job = job_manager.cancel(job_id)
+        if job is None:
+            return jsonify({"error": f"No job {job_id}"}), 404
+        return jsonify(job.to_dict())
+
+    @app.route("/jobs/<job_id>/events", methods=["GET"])
+    def job_events(job_id):
+        """The job as server-sent events, one per change, ending when it finishes"""
+        job = job_manager.get(job_id)
+        if job is None:
+            return jsonify({"error": f"No job {job_id}"}), 404
+        return Response(job_manager.events(job), mimetype="text/event-stream",
+                        headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"})
+
     @app.route("/status", methods=["GET"])
+    @response_cache.cached(state_version)
     def status():
         """Get comprehensive system status"""
         try:
@@ -295,6 +578,24 @@ def setup_routes(app):
         except Exception as e:
             raise e
 
+    @app.route("/metrics", methods=["GET"])
+    def metrics():
+        """Primitive counters of every scheme library, Prometheus text format"""
+        return Response(render_metrics(scheme_manager.schemes, job_manager.utilization()),
+                        content_type=CONTENT_TYPE)
+
+    @app.route("/metrics/live", methods=["GET"])
+    def metrics_live():
+        """Throughput, latency, primitive, cache and pool metrics as server-sent events,
+        one snapshot every ?interval= seconds (default 1)"""
+        interval = request.args.get("interval", live_metrics.DEFAULT_INTERVAL, type=float)
+        if not live_metrics.MIN_INTERVAL <= interval <= live_metrics.MAX_INTERVAL:
+            return jsonify({"error": f"interval must be from {live_metrics.MIN_INTERVAL} "
+                                     f"to {live_metrics.MAX_INTERVAL} seconds"}), 400
+        return Response(live_metrics.events(scheme_manager.schemes, job_manager, interval),
+                        mimetype="text/event-stream",
+                        headers={"Cache-Control": "no-cache", "X-Accel-Buffering": "no"})
+
     @app.route("/reset", methods=["POST"])
     def reset_system():
         """Reset the current scheme or all schemes"""
@@ -304,9 +605,11 @@ def setup_routes(app):
             
             if reset_all:
                 config.reset_all_schemes()
+                scheme_manager.note_reset(list(config.schemes_data))
                 message = "All schemes have been reset"
             else:
                 config.reset_scheme()
+                scheme_manager.note_reset([config.current_scheme])
                 message = f"Scheme '{config.current_scheme}' has been reset"
             
             print(f"🧹 {message}")
@@ -322,12 +625,11 @@ def setup_routes(app):
             raise e
 
     @app.route("/tx_messages", methods=["GET"])
+    @response_cache.cached(state_version)
     def get_tx_messages():
-        """Get list of all transaction messages for current scheme (if supported)"""
+        """Get the transaction messages of current scheme (if supported), whole, paged or streamed"""
         tx_messages = config.tx_message_list
-        return jsonify({
-            "tx_messages": tx_messages,
+        return list_response("tx_messages", tx_messages, {
             "scheme": config.current_scheme,
-            "count": len(tx_messages),
             "supported": len(tx_messages) > 0 or config.current_scheme == 'stealth'
         })